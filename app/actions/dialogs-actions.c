@@ -221,7 +221,13 @@ const GimpStringActionEntry dialogs_dockable_actions[] =
     NC_("dialogs-action", "Error Co_nsole"), NULL,
     NC_("dialogs-action", "Open the error console"),
     "gimp-error-console",
-    GIMP_HELP_ERRORS_DIALOG }
+    GIMP_HELP_ERRORS_DIALOG },
+
+  { "dialogs-memory", GIMP_STOCK_INFO,
+    NC_("dialogs-action", "_Memory Usage"), NULL,
+    NC_("dialogs-action", "Open the memory usage dialog"),
+    "gimp-memory-editor",
+    GIMP_HELP_MEMORY_DIALOG }
 };
 
 gint n_dialogs_dockable_actions = G_N_ELEMENTS (dialogs_dockable_actions);
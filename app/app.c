@@ -73,6 +73,10 @@
 static void       app_init_update_noop       (const gchar        *text1,
                                               const gchar        *text2,
                                               gdouble             percentage);
+static void       app_init_update_profile    (const gchar        *text1,
+                                              const gchar        *text2,
+                                              gdouble             percentage);
+static void       app_profile_phase          (const gchar        *phase);
 static void       app_restore_after_callback (Gimp               *gimp,
                                               GimpInitStatusFunc  status_callback);
 static gboolean   app_exit_after_callback    (Gimp               *gimp,
@@ -85,6 +89,12 @@ static gboolean   app_exit_after_callback    (Gimp               *gimp,
 static GObject *initial_screen  = NULL;
 static gint     initial_monitor = 0;
 
+/*  startup profiling, see app_profile_phase()  */
+static GTimer             *profile_timer       = NULL;
+static gchar              *profile_phase       = NULL;
+static gdouble             profile_phase_start = 0.0;
+static GimpInitStatusFunc  profile_status_func = NULL;
+
 
 /*  public functions  */
 
@@ -145,6 +155,7 @@ app_run (const gchar         *full_prog_name,
          const gchar         *session_name,
          const gchar         *batch_interpreter,
          const gchar        **batch_commands,
+         gint                 batch_jobs,
          gboolean             as_new,
          gboolean             no_interface,
          gboolean             no_data,
@@ -156,6 +167,8 @@ app_run (const gchar         *full_prog_name,
          gboolean             console_messages,
          gboolean             use_debug_handler,
          gboolean             show_playground,
+         gboolean             profile_startup,
+         gboolean             resident,
          GimpStackTraceMode   stack_trace_mode,
          GimpPDBCompatMode    pdb_compat_mode)
 {
@@ -166,6 +179,13 @@ app_run (const gchar         *full_prog_name,
   GFile              *default_folder = NULL;
   GFile              *gimpdir;
 
+  if (profile_startup)
+    {
+      profile_timer = g_timer_new ();
+
+      app_profile_phase ("Creating the core");
+    }
+
   if (filenames && filenames[0] && ! filenames[1] &&
       g_file_test (filenames[0], G_FILE_TEST_IS_DIR))
     {
@@ -206,6 +226,12 @@ app_run (const gchar         *full_prog_name,
   if (default_folder)
     g_object_unref (default_folder);
 
+  /*  a resident instance keeps its windows hidden until it is
+   *  activated by another launch, see gui_show()
+   */
+  if (resident && ! no_interface)
+    gimp_set_show_gui (gimp, FALSE);
+
   gimp_cpu_accel_set_use (use_cpu_accel);
 
   errors_init (gimp, full_prog_name, use_debug_handler, stack_trace_mode);
@@ -235,12 +261,16 @@ app_run (const gchar         *full_prog_name,
 
   g_object_unref (gimpdir);
 
+  app_profile_phase ("Loading gimprc");
+
   gimp_load_config (gimp, alternate_system_gimprc, alternate_gimprc);
 
   /*  change the locale if a language if specified  */
   language_init (gimp->config->language);
 
   /*  initialize lowlevel stuff  */
+  app_profile_phase ("Initializing GEGL");
+
   gimp_gegl_init (gimp);
 
   /*  Connect our restore_after callback before gui_init() connects
@@ -253,15 +283,28 @@ app_run (const gchar         *full_prog_name,
 
 #ifndef GIMP_CONSOLE_COMPILATION
   if (! no_interface)
-    update_status_func = gui_init (gimp, no_splash);
+    {
+      app_profile_phase ("Initializing the user interface");
+
+      update_status_func = gui_init (gimp, no_splash);
+    }
 #endif
 
   if (! update_status_func)
     update_status_func = app_init_update_noop;
 
+  /*  time every step reported to the status callback  */
+  if (profile_timer)
+    {
+      profile_status_func = update_status_func;
+      update_status_func  = app_init_update_profile;
+    }
+
   /*  Create all members of the global Gimp instance which need an already
    *  parsed gimprc, e.g. the data factories
    */
+  app_profile_phase ("Creating the data factories");
+
   gimp_initialize (gimp, update_status_func);
 
   /*  Load all data files
@@ -285,6 +328,8 @@ app_run (const gchar         *full_prog_name,
     {
       gint i;
 
+      app_profile_phase ("Opening images");
+
       for (i = 0; filenames[i] != NULL; i++)
         {
           if (run_loop)
@@ -300,8 +345,22 @@ app_run (const gchar         *full_prog_name,
         }
     }
 
+  if (run_loop && batch_commands)
+    app_profile_phase ("Running batch commands");
+
   if (run_loop)
-    batch_run (gimp, batch_interpreter, batch_commands);
+    batch_run (gimp, batch_interpreter, batch_commands, batch_jobs);
+
+  if (profile_timer)
+    {
+      app_profile_phase (NULL);
+
+      g_print ("startup: %8.3f s  total\n",
+               g_timer_elapsed (profile_timer, NULL));
+
+      g_timer_destroy (profile_timer);
+      profile_timer = NULL;
+    }
 
   if (run_loop)
     {
@@ -312,6 +371,8 @@ app_run (const gchar         *full_prog_name,
 
   g_main_loop_unref (loop);
 
+  gimp_gegl_exit (gimp);
+
   g_object_unref (gimp);
 
   gimp_debug_instances ();
@@ -331,6 +392,41 @@ app_init_update_noop (const gchar *text1,
   /*  deliberately do nothing  */
 }
 
+static void
+app_init_update_profile (const gchar *text1,
+                         const gchar *text2,
+                         gdouble      percentage)
+{
+  /*  a new step starts when the status text changes  */
+  if (text2 || text1)
+    app_profile_phase (text2 ? text2 : text1);
+
+  profile_status_func (text1, text2, percentage);
+}
+
+/*  ends the current startup phase, printing the time it took, and
+ *  starts @phase, or just ends the current one if @phase is NULL
+ */
+static void
+app_profile_phase (const gchar *phase)
+{
+  gdouble now;
+
+  if (! profile_timer)
+    return;
+
+  now = g_timer_elapsed (profile_timer, NULL);
+
+  if (profile_phase)
+    g_print ("startup: %8.3f s  %8.3f s  %s\n",
+             now, now - profile_phase_start, profile_phase);
+
+  g_free (profile_phase);
+
+  profile_phase       = g_strdup (phase);
+  profile_phase_start = now;
+}
+
 static void
 app_restore_after_callback (Gimp               *gimp,
                             GimpInitStatusFunc  status_callback)
@@ -341,6 +437,9 @@ app_restore_after_callback (Gimp               *gimp,
    *  after after restore() the initial monitor gets reset.
    */
   g_free (gimp_get_display_name (gimp, -1, &initial_screen, &initial_monitor));
+
+  /*  the GUI's restore_after callback runs next and shows the windows  */
+  app_profile_phase ("Restoring the session");
 }
 
 static gboolean
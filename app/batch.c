@@ -28,6 +28,7 @@
 #include "core/core-types.h"
 
 #include "core/gimp.h"
+#include "core/gimp-gui.h"
 #include "core/gimpparamspecs.h"
 
 #include "batch.h"
@@ -35,25 +36,73 @@
 #include "pdb/gimppdb.h"
 #include "pdb/gimpprocedure.h"
 
+#include "plug-in/plug-in-types.h"
+
+#include "plug-in/gimpplugin.h"
+#include "plug-in/gimppluginmanager.h"
+
 #include "gimp-intl.h"
 
 
 #define BATCH_DEFAULT_EVAL_PROC   "plug-in-script-fu-eval"
 
 
-static void  batch_exit_after_callback (Gimp          *gimp) G_GNUC_NORETURN;
+/*  A job list is a file given as "-b @<file>", with one batch command
+ *  per line.  Its commands are independent of each other, so when the
+ *  interpreter is a plug-in, up to max_jobs of them are run as
+ *  separate plug-in processes at the same time.
+ */
+typedef struct _BatchQueue BatchQueue;
 
-static void  batch_run_cmd             (Gimp          *gimp,
-                                        const gchar   *proc_name,
-                                        GimpProcedure *procedure,
-                                        GimpRunMode    run_mode,
-                                        const gchar   *cmd);
+struct _BatchQueue
+{
+  Gimp          *gimp;
+  const gchar   *proc_name;
+  GimpProcedure *procedure;
+
+  gchar        **commands;
+  gint           next;
+  gint           max_jobs;
+
+  GList         *running;   /*  plug-ins currently running a command  */
+  gboolean       starting;  /*  set while a command's plug-in is opened  */
+  guint          idle_id;
+  GMainLoop     *loop;
+};
+
+
+static void      batch_exit_after_callback  (Gimp              *gimp) G_GNUC_NORETURN;
+
+static GimpValueArray *
+                 batch_get_arguments        (GimpProcedure     *procedure,
+                                             GimpRunMode        run_mode,
+                                             const gchar       *cmd);
+static void      batch_run_cmd              (Gimp              *gimp,
+                                             const gchar       *proc_name,
+                                             GimpProcedure     *procedure,
+                                             GimpRunMode        run_mode,
+                                             const gchar       *cmd);
+static void      batch_run_job_list         (Gimp              *gimp,
+                                             const gchar       *proc_name,
+                                             GimpProcedure     *procedure,
+                                             const gchar       *filename,
+                                             gint               max_jobs);
+
+static void      batch_queue_fill           (BatchQueue        *queue);
+static gboolean  batch_queue_idle           (BatchQueue        *queue);
+static void      batch_queue_plug_in_opened (GimpPlugInManager *manager,
+                                             GimpPlugIn        *plug_in,
+                                             BatchQueue        *queue);
+static void      batch_queue_plug_in_closed (GimpPlugInManager *manager,
+                                             GimpPlugIn        *plug_in,
+                                             BatchQueue        *queue);
 
 
 void
 batch_run (Gimp         *gimp,
            const gchar  *batch_interpreter,
-           const gchar **batch_commands)
+           const gchar **batch_commands,
+           gint          batch_jobs)
 {
   gulong  exit_id;
 
@@ -104,8 +153,14 @@ batch_run (Gimp         *gimp,
           gint i;
 
           for (i = 0; batch_commands[i]; i++)
-            batch_run_cmd (gimp, batch_interpreter, eval_proc,
-                           GIMP_RUN_NONINTERACTIVE, batch_commands[i]);
+            {
+              if (batch_commands[i][0] == '@')
+                batch_run_job_list (gimp, batch_interpreter, eval_proc,
+                                    batch_commands[i] + 1, batch_jobs);
+              else
+                batch_run_cmd (gimp, batch_interpreter, eval_proc,
+                               GIMP_RUN_NONINTERACTIVE, batch_commands[i]);
+            }
         }
       else
         {
@@ -135,17 +190,13 @@ batch_exit_after_callback (Gimp *gimp)
   exit (EXIT_SUCCESS);
 }
 
-static void
-batch_run_cmd (Gimp          *gimp,
-               const gchar   *proc_name,
-               GimpProcedure *procedure,
-               GimpRunMode    run_mode,
-               const gchar   *cmd)
+static GimpValueArray *
+batch_get_arguments (GimpProcedure *procedure,
+                     GimpRunMode    run_mode,
+                     const gchar   *cmd)
 {
   GimpValueArray *args;
-  GimpValueArray *return_vals;
-  GError         *error = NULL;
-  gint            i     = 0;
+  gint            i = 0;
 
   args = gimp_procedure_get_arguments (procedure);
 
@@ -157,6 +208,22 @@ batch_run_cmd (Gimp          *gimp,
       GIMP_IS_PARAM_SPEC_STRING (procedure->args[i]))
     g_value_set_static_string (gimp_value_array_index (args, i++), cmd);
 
+  return args;
+}
+
+static void
+batch_run_cmd (Gimp          *gimp,
+               const gchar   *proc_name,
+               GimpProcedure *procedure,
+               GimpRunMode    run_mode,
+               const gchar   *cmd)
+{
+  GimpValueArray *args;
+  GimpValueArray *return_vals;
+  GError         *error = NULL;
+
+  args = batch_get_arguments (procedure, run_mode, cmd);
+
   return_vals =
     gimp_pdb_execute_procedure_by_name_args (gimp->pdb,
                                              gimp_get_user_context (gimp),
@@ -202,3 +269,173 @@ batch_run_cmd (Gimp          *gimp,
 
   return;
 }
+
+static void
+batch_run_job_list (Gimp          *gimp,
+                    const gchar   *proc_name,
+                    GimpProcedure *procedure,
+                    const gchar   *filename,
+                    gint           max_jobs)
+{
+  BatchQueue   queue = { 0, };
+  gchar       *contents;
+  gchar      **lines;
+  GError      *error = NULL;
+  gint         n_commands;
+  gint         i;
+
+  if (! g_file_get_contents (filename, &contents, NULL, &error))
+    {
+      g_printerr ("batch job list could not be read:\n"
+                  "%s\n", error->message);
+      g_error_free (error);
+      return;
+    }
+
+  lines = g_strsplit (contents, "\n", -1);
+  g_free (contents);
+
+  /*  drop empty lines, so every remaining line is one command  */
+  for (i = 0, n_commands = 0; lines[i]; i++)
+    {
+      if (*g_strstrip (lines[i]))
+        lines[n_commands++] = lines[i];
+      else
+        g_free (lines[i]);
+    }
+
+  lines[n_commands] = NULL;
+
+  /*  only a plug-in interpreter gets a process of its own per command,
+   *  anything else has to run the commands one after the other
+   */
+  if (max_jobs < 2 || n_commands < 2 || procedure->proc_type != GIMP_PLUGIN)
+    {
+      for (i = 0; i < n_commands; i++)
+        batch_run_cmd (gimp, proc_name, procedure,
+                       GIMP_RUN_NONINTERACTIVE, lines[i]);
+
+      g_strfreev (lines);
+      return;
+    }
+
+  if (gimp->be_verbose)
+    g_print ("Running %d batch commands, %d at a time\n",
+             n_commands, MIN (max_jobs, n_commands));
+
+  queue.gimp      = gimp;
+  queue.proc_name = proc_name;
+  queue.procedure = procedure;
+  queue.commands  = lines;
+  queue.max_jobs  = max_jobs;
+
+  g_signal_connect (gimp->plug_in_manager, "plug-in-opened",
+                    G_CALLBACK (batch_queue_plug_in_opened),
+                    &queue);
+  g_signal_connect (gimp->plug_in_manager, "plug-in-closed",
+                    G_CALLBACK (batch_queue_plug_in_closed),
+                    &queue);
+
+  batch_queue_fill (&queue);
+
+  if (queue.running)
+    {
+      queue.loop = g_main_loop_new (NULL, FALSE);
+
+      gimp_threads_leave (gimp);
+      g_main_loop_run (queue.loop);
+      gimp_threads_enter (gimp);
+
+      g_main_loop_unref (queue.loop);
+    }
+
+  g_signal_handlers_disconnect_by_func (gimp->plug_in_manager,
+                                        batch_queue_plug_in_opened,
+                                        &queue);
+  g_signal_handlers_disconnect_by_func (gimp->plug_in_manager,
+                                        batch_queue_plug_in_closed,
+                                        &queue);
+
+  if (queue.idle_id)
+    g_source_remove (queue.idle_id);
+
+  g_strfreev (lines);
+}
+
+/*  start commands until max_jobs of them are running  */
+static void
+batch_queue_fill (BatchQueue *queue)
+{
+  while (queue->commands[queue->next] &&
+         (gint) g_list_length (queue->running) < queue->max_jobs)
+    {
+      const gchar    *cmd = queue->commands[queue->next++];
+      GimpValueArray *args;
+      GError         *error = NULL;
+
+      args = batch_get_arguments (queue->procedure,
+                                  GIMP_RUN_NONINTERACTIVE, cmd);
+
+      queue->starting = TRUE;
+
+      gimp_procedure_execute_async (queue->procedure, queue->gimp,
+                                    gimp_get_user_context (queue->gimp),
+                                    NULL, args, NULL, &error);
+
+      queue->starting = FALSE;
+
+      gimp_value_array_unref (args);
+
+      if (error)
+        {
+          g_printerr ("batch command experienced an execution error:\n"
+                      "%s\n", error->message);
+          g_error_free (error);
+        }
+    }
+}
+
+static gboolean
+batch_queue_idle (BatchQueue *queue)
+{
+  queue->idle_id = 0;
+
+  batch_queue_fill (queue);
+
+  if (! queue->running)
+    g_main_loop_quit (queue->loop);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+batch_queue_plug_in_opened (GimpPlugInManager *manager,
+                            GimpPlugIn        *plug_in,
+                            BatchQueue        *queue)
+{
+  /*  plug-ins opened later are called by the commands themselves  */
+  if (queue->starting)
+    {
+      queue->running  = g_list_prepend (queue->running, plug_in);
+      queue->starting = FALSE;
+    }
+}
+
+static void
+batch_queue_plug_in_closed (GimpPlugInManager *manager,
+                            GimpPlugIn        *plug_in,
+                            BatchQueue        *queue)
+{
+  if (g_list_find (queue->running, plug_in))
+    {
+      queue->running = g_list_remove (queue->running, plug_in);
+
+      if (queue->gimp->be_verbose)
+        g_print ("batch command finished, %d still running\n",
+                 g_list_length (queue->running));
+
+      /*  don't start a new plug-in from within another one's close  */
+      if (! queue->idle_id)
+        queue->idle_id = g_idle_add ((GSourceFunc) batch_queue_idle, queue);
+    }
+}
@@ -25,7 +25,8 @@
 
 void   batch_run (Gimp         *gimp,
                   const gchar  *batch_interpreter,
-                  const gchar **batch_commands);
+                  const gchar **batch_commands,
+                  gint          batch_jobs);
 
 
 #endif /* __BATCH_H__ */
@@ -80,6 +80,7 @@ struct _GimpCoreConfig
   GimpGrid               *default_grid;
   gint                    levels_of_undo;
   guint64                 undo_size;
+  guint64                 undo_swap_size;
   GimpViewSize            undo_preview_size;
   gint                    plug_in_history_size;
   gchar                  *plug_in_rc_path;
@@ -90,6 +91,7 @@ struct _GimpCoreConfig
   GimpColorConfig        *color_management;
   GimpColorProfilePolicy  color_profile_policy;
   gboolean                save_document_history;
+  gboolean                xcf_lazy_load;
   GimpRGB                 quick_mask_color;
 };
 
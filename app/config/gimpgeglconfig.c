@@ -48,6 +48,7 @@ enum
   PROP_SWAP_PATH,
   PROP_NUM_PROCESSORS,
   PROP_TILE_CACHE_SIZE,
+  PROP_TILE_CACHE_ADAPTIVE,
   PROP_USE_OPENCL,
 
   /* ignored, only for backward compatibility: */
@@ -156,6 +157,12 @@ gimp_gegl_config_class_init (GimpGeglConfigClass *klass)
                                     GIMP_PARAM_STATIC_STRINGS |
                                     GIMP_CONFIG_PARAM_CONFIRM);
 
+  GIMP_CONFIG_INSTALL_PROP_BOOLEAN (object_class, PROP_TILE_CACHE_ADAPTIVE,
+                                    "tile-cache-adaptive",
+                                    TILE_CACHE_ADAPTIVE_BLURB,
+                                    TRUE,
+                                    GIMP_PARAM_STATIC_STRINGS);
+
   GIMP_CONFIG_INSTALL_PROP_BOOLEAN (object_class, PROP_USE_OPENCL,
                                     "use-opencl", USE_OPENCL_BLURB,
                                     TRUE,
@@ -212,6 +219,9 @@ gimp_gegl_config_set_property (GObject      *object,
     case PROP_TILE_CACHE_SIZE:
       gegl_config->tile_cache_size = g_value_get_uint64 (value);
       break;
+    case PROP_TILE_CACHE_ADAPTIVE:
+      gegl_config->tile_cache_adaptive = g_value_get_boolean (value);
+      break;
     case PROP_USE_OPENCL:
       gegl_config->use_opencl = g_value_get_boolean (value);
       break;
@@ -248,6 +258,9 @@ gimp_gegl_config_get_property (GObject    *object,
     case PROP_TILE_CACHE_SIZE:
       g_value_set_uint64 (value, gegl_config->tile_cache_size);
       break;
+    case PROP_TILE_CACHE_ADAPTIVE:
+      g_value_set_boolean (value, gegl_config->tile_cache_adaptive);
+      break;
     case PROP_USE_OPENCL:
       g_value_set_boolean (value, gegl_config->use_opencl);
       break;
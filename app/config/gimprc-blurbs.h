@@ -441,6 +441,11 @@ _("When the amount of pixel data exceeds this limit, GIMP will start to " \
   "work on images that wouldn't fit into memory otherwise.  If you have a " \
   "lot of RAM, you may want to set this to a higher value.")
 
+#define TILE_CACHE_ADAPTIVE_BLURB \
+_("When enabled, GIMP lowers the tile cache size while the system runs " \
+  "short of memory, and gives the pixel data of the active image " \
+  "priority over the caches of other open images.")
+
 #define TOOLBOX_COLOR_AREA_BLURB \
 _("Show the current foreground and background colors in the toolbox.")
 
@@ -472,6 +477,12 @@ _("Sets an upper limit to the memory that is used per image to keep " \
   "operations on the undo stack. Regardless of this setting, at least " \
   "as many undo-levels as configured can be undone.")
 
+#define UNDO_SWAP_SIZE_BLURB \
+_("Sets an upper limit to the disk space that is used per image to keep " \
+  "undo steps that were compressed and moved out of memory once the " \
+  "undo-size limit is reached. Set it to 0 to only keep undo steps in " \
+  "memory.")
+
 #define UNDO_PREVIEW_SIZE_BLURB \
 _("Sets the size of the previews in the Undo History.")
 
@@ -489,6 +500,12 @@ _("When enabled, uses OpenCL for some operations.")
 "The location of the online user manual. This is used if " \
 "'user-manual-online' is enabled."
 
+#define XCF_LAZY_LOAD_BLURB \
+_("When enabled, the pixels of XCF files are only read when they are " \
+  "first needed, instead of all of them when the file is opened.  Large " \
+  "files open faster, but must not be changed by other programs while " \
+  "they are open in GIMP.")
+
 #define ZOOM_QUALITY_BLURB \
 "There's a tradeoff between speed and quality of the zoomed-out display."
 
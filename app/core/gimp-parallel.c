@@ -0,0 +1,434 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimp-parallel.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <gio/gio.h>
+#include <gegl.h>
+
+#include "core-types.h"
+
+#include "config/gimpgeglconfig.h"
+
+#include "gimp.h"
+#include "gimp-parallel.h"
+
+
+typedef struct _GimpParallelTask GimpParallelTask;
+typedef struct _GimpParallelJob  GimpParallelJob;
+
+struct _GimpParallelTask
+{
+  GimpParallelDistributeFunc  func;
+  gint                        n;
+  gpointer                    user_data;
+
+  GMutex                      mutex;
+  GCond                       cond;
+  gint                        n_pending;
+};
+
+struct _GimpParallelJob
+{
+  GimpParallelTask *task;
+  gint              i;
+};
+
+typedef struct
+{
+  GimpParallelDistributeRangeFunc  func;
+  gsize                            size;
+  gpointer                         user_data;
+} GimpParallelRangeData;
+
+typedef struct
+{
+  GimpParallelDistributeAreaFunc  func;
+  const GeglRectangle            *area;
+  gboolean                        vertical;
+  gpointer                        user_data;
+} GimpParallelAreaData;
+
+
+/*  local function prototypes  */
+
+static void   gimp_parallel_notify_num_processors (GimpGeglConfig        *config);
+static void   gimp_parallel_set_n_threads         (gint                   n_threads);
+static void   gimp_parallel_run_job               (GimpParallelJob       *job,
+                                                   gpointer               data);
+static void   gimp_parallel_range_func            (gint                   i,
+                                                   gint                   n,
+                                                   GimpParallelRangeData *data);
+static gint   gimp_parallel_area_boundary         (gint                   start,
+                                                   gint                   size,
+                                                   gint                   i,
+                                                   gint                   n);
+static void   gimp_parallel_area_func             (gint                   i,
+                                                   gint                   n,
+                                                   GimpParallelAreaData  *data);
+
+
+/*  local variables  */
+
+static GThreadPool *gimp_parallel_pool      = NULL;
+static gint         gimp_parallel_n_threads = 1;
+
+/*  set while a thread runs part of a distributed task, nested calls
+ *  to gimp_parallel_distribute() are then executed serially
+ */
+static GPrivate     gimp_parallel_busy;
+
+
+/*  public functions  */
+
+void
+gimp_parallel_init (Gimp *gimp)
+{
+  GimpGeglConfig *config;
+
+  g_return_if_fail (GIMP_IS_GIMP (gimp));
+
+  config = GIMP_GEGL_CONFIG (gimp->config);
+
+  g_signal_connect (config, "notify::num-processors",
+                    G_CALLBACK (gimp_parallel_notify_num_processors),
+                    NULL);
+
+  gimp_parallel_notify_num_processors (config);
+}
+
+void
+gimp_parallel_exit (Gimp *gimp)
+{
+  g_return_if_fail (GIMP_IS_GIMP (gimp));
+
+  g_signal_handlers_disconnect_by_func (gimp->config,
+                                        gimp_parallel_notify_num_processors,
+                                        NULL);
+
+  if (gimp_parallel_pool)
+    {
+      g_thread_pool_free (gimp_parallel_pool, FALSE, TRUE);
+      gimp_parallel_pool = NULL;
+    }
+
+  gimp_parallel_n_threads = 1;
+}
+
+/**
+ * gimp_parallel_get_n_threads:
+ *
+ * Return value: the number of threads, including the calling thread,
+ *               that gimp_parallel_distribute() spreads work over.
+ **/
+gint
+gimp_parallel_get_n_threads (void)
+{
+  return gimp_parallel_n_threads;
+}
+
+/**
+ * gimp_parallel_distribute:
+ * @max_n:     the maximal number of parts, or -1 for no limit
+ * @func:      the function to call for each part
+ * @user_data: user data passed to @func
+ *
+ * Calls @func @n times, with @i ranging from 0 to @n - 1, where @n is
+ * the number of threads (limited by @max_n). The calls run
+ * concurrently; the calling thread runs part 0 itself. The function
+ * returns once all parts are done.
+ *
+ * When called from within a distributed function, @func is called
+ * once, with @n being 1, in the calling thread.
+ **/
+void
+gimp_parallel_distribute (gint                       max_n,
+                          GimpParallelDistributeFunc func,
+                          gpointer                   user_data)
+{
+  GimpParallelTask task;
+  GimpParallelJob  jobs[GIMP_PARALLEL_MAX_THREADS];
+  gint             n;
+  gint             i;
+
+  g_return_if_fail (func != NULL);
+
+  if (max_n == 0)
+    return;
+
+  n = gimp_parallel_n_threads;
+
+  if (max_n > 0)
+    n = MIN (n, max_n);
+
+  if (n == 1 || ! gimp_parallel_pool || g_private_get (&gimp_parallel_busy))
+    {
+      func (0, 1, user_data);
+
+      return;
+    }
+
+  task.func      = func;
+  task.n         = n;
+  task.user_data = user_data;
+  task.n_pending = n - 1;
+
+  g_mutex_init (&task.mutex);
+  g_cond_init (&task.cond);
+
+  for (i = 1; i < n; i++)
+    {
+      jobs[i].task = &task;
+      jobs[i].i    = i;
+
+      g_thread_pool_push (gimp_parallel_pool, &jobs[i], NULL);
+    }
+
+  g_private_set (&gimp_parallel_busy, GINT_TO_POINTER (TRUE));
+
+  func (0, n, user_data);
+
+  g_private_set (&gimp_parallel_busy, GINT_TO_POINTER (FALSE));
+
+  g_mutex_lock (&task.mutex);
+
+  while (task.n_pending > 0)
+    g_cond_wait (&task.cond, &task.mutex);
+
+  g_mutex_unlock (&task.mutex);
+
+  g_cond_clear (&task.cond);
+  g_mutex_clear (&task.mutex);
+}
+
+/**
+ * gimp_parallel_distribute_range:
+ * @size:         the size of the range
+ * @min_sub_size: the minimal size of each sub-range, or 0
+ * @func:         the function to call for each sub-range
+ * @user_data:    user data passed to @func
+ *
+ * Splits the range [0, @size) into consecutive sub-ranges of at
+ * least @min_sub_size elements and processes them in parallel, see
+ * gimp_parallel_distribute().
+ **/
+void
+gimp_parallel_distribute_range (gsize                           size,
+                                gsize                           min_sub_size,
+                                GimpParallelDistributeRangeFunc func,
+                                gpointer                        user_data)
+{
+  GimpParallelRangeData data;
+  gsize                 max_n;
+
+  g_return_if_fail (func != NULL);
+
+  if (size == 0)
+    return;
+
+  max_n = min_sub_size ? size / min_sub_size : size;
+  max_n = CLAMP (max_n, 1, GIMP_PARALLEL_MAX_THREADS);
+
+  if (max_n == 1)
+    {
+      func (0, size, user_data);
+
+      return;
+    }
+
+  data.func      = func;
+  data.size      = size;
+  data.user_data = user_data;
+
+  gimp_parallel_distribute (max_n,
+                            (GimpParallelDistributeFunc) gimp_parallel_range_func,
+                            &data);
+}
+
+/**
+ * gimp_parallel_distribute_area:
+ * @area:         the area to process
+ * @min_sub_area: the minimal number of pixels of each sub-area, or 0
+ * @func:         the function to call for each sub-area
+ * @user_data:    user data passed to @func
+ *
+ * Splits @area into strips of at least @min_sub_area pixels, along
+ * its longer side, and processes them in parallel, see
+ * gimp_parallel_distribute(). The strip boundaries are aligned to
+ * multiples of %GIMP_PARALLEL_AREA_ALIGNMENT, so that, for buffers
+ * with the default tile grid, no tile is shared by two strips.
+ **/
+void
+gimp_parallel_distribute_area (const GeglRectangle            *area,
+                               gsize                           min_sub_area,
+                               GimpParallelDistributeAreaFunc  func,
+                               gpointer                        user_data)
+{
+  GimpParallelAreaData data;
+  gsize                area_size;
+  gsize                max_n;
+
+  g_return_if_fail (area != NULL);
+  g_return_if_fail (func != NULL);
+
+  if (area->width <= 0 || area->height <= 0)
+    return;
+
+  area_size = (gsize) area->width * (gsize) area->height;
+
+  max_n = min_sub_area ? area_size / min_sub_area : area_size;
+  max_n = MIN (max_n, (MAX (area->width, area->height) +
+                       GIMP_PARALLEL_AREA_ALIGNMENT - 1) /
+                      GIMP_PARALLEL_AREA_ALIGNMENT);
+  max_n = CLAMP (max_n, 1, GIMP_PARALLEL_MAX_THREADS);
+
+  if (max_n == 1)
+    {
+      func (area, user_data);
+
+      return;
+    }
+
+  data.func      = func;
+  data.area      = area;
+  data.vertical  = area->height >= area->width;
+  data.user_data = user_data;
+
+  gimp_parallel_distribute (max_n,
+                            (GimpParallelDistributeFunc) gimp_parallel_area_func,
+                            &data);
+}
+
+
+/*  private functions  */
+
+static void
+gimp_parallel_notify_num_processors (GimpGeglConfig *config)
+{
+  gimp_parallel_set_n_threads (config->num_processors);
+}
+
+static void
+gimp_parallel_set_n_threads (gint n_threads)
+{
+  n_threads = CLAMP (n_threads, 1, GIMP_PARALLEL_MAX_THREADS);
+
+  gimp_parallel_n_threads = n_threads;
+
+  if (n_threads == 1)
+    return;
+
+  /*  the calling thread always runs one part itself  */
+  if (! gimp_parallel_pool)
+    {
+      gimp_parallel_pool =
+        g_thread_pool_new ((GFunc) gimp_parallel_run_job, NULL,
+                           n_threads - 1, FALSE, NULL);
+    }
+  else
+    {
+      g_thread_pool_set_max_threads (gimp_parallel_pool, n_threads - 1,
+                                     NULL);
+    }
+}
+
+static void
+gimp_parallel_run_job (GimpParallelJob *job,
+                       gpointer         data)
+{
+  GimpParallelTask *task = job->task;
+
+  g_private_set (&gimp_parallel_busy, GINT_TO_POINTER (TRUE));
+
+  task->func (job->i, task->n, task->user_data);
+
+  g_private_set (&gimp_parallel_busy, GINT_TO_POINTER (FALSE));
+
+  /*  don't touch the task after unlocking, the caller frees it  */
+  g_mutex_lock (&task->mutex);
+
+  if (--task->n_pending == 0)
+    g_cond_signal (&task->cond);
+
+  g_mutex_unlock (&task->mutex);
+}
+
+static void
+gimp_parallel_range_func (gint                   i,
+                          gint                   n,
+                          GimpParallelRangeData *data)
+{
+  gsize offset = data->size * i / n;
+  gsize end    = data->size * (i + 1) / n;
+
+  data->func (offset, end - offset, data->user_data);
+}
+
+static gint
+gimp_parallel_area_boundary (gint start,
+                             gint size,
+                             gint i,
+                             gint n)
+{
+  gint boundary;
+
+  if (i <= 0)
+    return start;
+  else if (i >= n)
+    return start + size;
+
+  boundary = start + (gint) ((gint64) size * i / n);
+
+  /*  round to the nearest alignment multiple, in absolute coordinates  */
+  boundary += GIMP_PARALLEL_AREA_ALIGNMENT / 2;
+  boundary -= ((boundary % GIMP_PARALLEL_AREA_ALIGNMENT) +
+               GIMP_PARALLEL_AREA_ALIGNMENT) % GIMP_PARALLEL_AREA_ALIGNMENT;
+
+  return CLAMP (boundary, start, start + size);
+}
+
+static void
+gimp_parallel_area_func (gint                  i,
+                         gint                  n,
+                         GimpParallelAreaData *data)
+{
+  GeglRectangle sub_area = *data->area;
+
+  if (data->vertical)
+    {
+      sub_area.y      = gimp_parallel_area_boundary (data->area->y,
+                                                     data->area->height,
+                                                     i, n);
+      sub_area.height = gimp_parallel_area_boundary (data->area->y,
+                                                     data->area->height,
+                                                     i + 1, n) - sub_area.y;
+    }
+  else
+    {
+      sub_area.x     = gimp_parallel_area_boundary (data->area->x,
+                                                    data->area->width,
+                                                    i, n);
+      sub_area.width = gimp_parallel_area_boundary (data->area->x,
+                                                    data->area->width,
+                                                    i + 1, n) - sub_area.x;
+    }
+
+  if (sub_area.width > 0 && sub_area.height > 0)
+    data->func (&sub_area, data->user_data);
+}
@@ -0,0 +1,233 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimp-tile-cache.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <gio/gio.h>
+#include <gegl.h>
+
+#include "core-types.h"
+
+#include "config/gimpgeglconfig.h"
+
+#include "gimp.h"
+#include "gimp-tile-cache.h"
+#include "gimp-utils.h"
+#include "gimpcontext.h"
+#include "gimpimage.h"
+#include "gimpimage-cache.h"
+
+
+#define GIMP_TILE_CACHE_INTERVAL 5000       /* milliseconds */
+#define GIMP_TILE_CACHE_MIN_SIZE (64 << 20) /* never go below this */
+
+
+static void       gimp_tile_cache_notify        (GimpGeglConfig *config,
+                                                 GParamSpec     *pspec,
+                                                 Gimp           *gimp);
+static gboolean   gimp_tile_cache_adapt         (Gimp           *gimp);
+static void       gimp_tile_cache_set_size      (guint64         size);
+static void       gimp_tile_cache_apply_quotas  (Gimp           *gimp,
+                                                 guint64         limit);
+
+
+static guint   gimp_tile_cache_adapt_id = 0;
+static guint64 gimp_tile_cache_size     = 0;
+
+
+/*  public functions  */
+
+void
+gimp_tile_cache_init (Gimp *gimp)
+{
+  GimpGeglConfig *config;
+
+  g_return_if_fail (GIMP_IS_GIMP (gimp));
+
+  config = GIMP_GEGL_CONFIG (gimp->config);
+
+  g_signal_connect (config, "notify::tile-cache-size",
+                    G_CALLBACK (gimp_tile_cache_notify),
+                    gimp);
+  g_signal_connect (config, "notify::tile-cache-adaptive",
+                    G_CALLBACK (gimp_tile_cache_notify),
+                    gimp);
+
+  gimp_tile_cache_notify (config, NULL, gimp);
+}
+
+void
+gimp_tile_cache_exit (Gimp *gimp)
+{
+  g_return_if_fail (GIMP_IS_GIMP (gimp));
+
+  g_signal_handlers_disconnect_by_func (gimp->config,
+                                        gimp_tile_cache_notify,
+                                        gimp);
+
+  if (gimp_tile_cache_adapt_id)
+    {
+      g_source_remove (gimp_tile_cache_adapt_id);
+      gimp_tile_cache_adapt_id = 0;
+    }
+}
+
+/**
+ * gimp_tile_cache_get_size:
+ *
+ * Return value: the tile cache size currently set on GEGL, which is
+ *               below the configured size while memory is short.
+ **/
+guint64
+gimp_tile_cache_get_size (void)
+{
+  return gimp_tile_cache_size;
+}
+
+
+/*  private functions  */
+
+static void
+gimp_tile_cache_notify (GimpGeglConfig *config,
+                        GParamSpec     *pspec,
+                        Gimp           *gimp)
+{
+  if (config->tile_cache_adaptive)
+    {
+      if (! gimp_tile_cache_adapt_id)
+        gimp_tile_cache_adapt_id =
+          g_timeout_add_full (G_PRIORITY_LOW, GIMP_TILE_CACHE_INTERVAL,
+                              (GSourceFunc) gimp_tile_cache_adapt, gimp,
+                              NULL);
+
+      gimp_tile_cache_adapt (gimp);
+    }
+  else
+    {
+      if (gimp_tile_cache_adapt_id)
+        {
+          g_source_remove (gimp_tile_cache_adapt_id);
+          gimp_tile_cache_adapt_id = 0;
+        }
+
+      gimp_tile_cache_set_size (config->tile_cache_size);
+    }
+}
+
+static gboolean
+gimp_tile_cache_adapt (Gimp *gimp)
+{
+  GimpGeglConfig *config    = GIMP_GEGL_CONFIG (gimp->config);
+  guint64         limit     = config->tile_cache_size;
+  guint64         physical  = gimp_get_physical_memory_size ();
+  guint64         available = gimp_get_available_memory_size ();
+  guint64         in_use    = 0;
+  GList          *list;
+
+  for (list = gimp_get_image_iter (gimp); list; list = g_list_next (list))
+    in_use += gimp_image_cache_get_usage (list->data);
+
+  if (physical > 0 && available > 0)
+    {
+      guint64 reserve = physical / 8;
+      guint64 budget;
+
+      /*  GEGL can't tell how much of the cache is filled; the tiles it
+       *  holds are no longer counted as available, so add back what
+       *  the images can at most keep in there
+       */
+      in_use = MIN (in_use, gimp_tile_cache_size);
+      budget = in_use + available;
+
+      budget = budget > reserve ? budget - reserve : 0;
+      budget = MAX (budget, GIMP_TILE_CACHE_MIN_SIZE);
+
+      limit = MIN (limit, budget);
+    }
+
+  /*  don't flush GEGL's cache over small fluctuations  */
+  if (limit == config->tile_cache_size ||
+      limit < gimp_tile_cache_size - gimp_tile_cache_size / 16 ||
+      limit > gimp_tile_cache_size + gimp_tile_cache_size / 16)
+    {
+      gimp_tile_cache_set_size (limit);
+    }
+
+  gimp_tile_cache_apply_quotas (gimp, gimp_tile_cache_size);
+
+  return G_SOURCE_CONTINUE;
+}
+
+static void
+gimp_tile_cache_set_size (guint64 size)
+{
+  if (size != gimp_tile_cache_size)
+    {
+      gimp_tile_cache_size = size;
+
+      g_object_set (gegl_config (),
+                    "tile-cache-size", size,
+                    NULL);
+    }
+}
+
+/*  The active image may use as much of the cache as it likes, the
+ *  other images share what is left. An image over its share loses
+ *  its projection and previews, which leaves the cache to the pixels
+ *  being worked on.
+ */
+static void
+gimp_tile_cache_apply_quotas (Gimp    *gimp,
+                              guint64  limit)
+{
+  GimpImage *active;
+  GList     *list;
+  guint64    total       = 0;
+  guint64    active_size = 0;
+  guint64    quota;
+  gint       n_others    = 0;
+
+  active = gimp_context_get_image (gimp_get_user_context (gimp));
+
+  for (list = gimp_get_image_iter (gimp); list; list = g_list_next (list))
+    {
+      GimpImage *image = list->data;
+      guint64    size  = gimp_image_cache_get_usage (image);
+
+      total += size;
+
+      if (image == active)
+        active_size = size;
+      else
+        n_others++;
+    }
+
+  if (total <= limit || n_others == 0)
+    return;
+
+  quota = limit > active_size ? (limit - active_size) / n_others : 0;
+
+  for (list = gimp_get_image_iter (gimp); list; list = g_list_next (list))
+    {
+      GimpImage *image = list->data;
+
+      if (image != active && gimp_image_cache_get_usage (image) > quota)
+        gimp_image_cache_release (image);
+    }
+}
@@ -103,6 +103,62 @@ gimp_get_physical_memory_size (void)
   return 0;
 }
 
+/**
+ * gimp_get_available_memory_size:
+ *
+ * Returns: The amount of physical memory which is available to
+ * applications without swapping, including memory the system only
+ * uses for caches, or 0 if it can't be determined.
+ **/
+guint64
+gimp_get_available_memory_size (void)
+{
+#ifdef G_OS_UNIX
+  gchar *contents;
+
+  /*  MemAvailable includes reclaimable page cache, unlike
+   *  _SC_AVPHYS_PAGES which only counts completely unused pages
+   */
+  if (g_file_get_contents ("/proc/meminfo", &contents, NULL, NULL))
+    {
+      const gchar *line    = strstr (contents, "MemAvailable:");
+      guint64      size_kb = 0;
+
+      if (line)
+        size_kb = g_ascii_strtoull (line + strlen ("MemAvailable:"),
+                                    NULL, 10);
+
+      g_free (contents);
+
+      if (size_kb > 0)
+        return size_kb * 1024;
+    }
+
+#if defined(HAVE_UNISTD_H) && defined(_SC_AVPHYS_PAGES) && defined (_SC_PAGE_SIZE)
+  return (guint64) sysconf (_SC_AVPHYS_PAGES) * sysconf (_SC_PAGE_SIZE);
+#endif
+#endif
+
+#ifdef G_OS_WIN32
+# if defined(_MSC_VER) && (_MSC_VER <= 1200)
+  MEMORYSTATUS memory_status;
+  memory_status.dwLength = sizeof (memory_status);
+
+  GlobalMemoryStatus (&memory_status);
+  return memory_status.dwAvailPhys;
+# else
+  MEMORYSTATUSEX memory_status;
+
+  memory_status.dwLength = sizeof (memory_status);
+
+  if (GlobalMemoryStatusEx (&memory_status))
+    return memory_status.ullAvailPhys;
+# endif
+#endif
+
+  return 0;
+}
+
 /**
  * gimp_get_backtrace:
  *
@@ -70,6 +70,7 @@
 #include "gimpimagefile.h"
 #include "gimplist.h"
 #include "gimpmarshal.h"
+#include "gimpmemorymonitor.h"
 #include "gimppalette-load.h"
 #include "gimppalette.h"
 #include "gimpparasitelist.h"
@@ -77,6 +78,7 @@
 #include "gimppattern.h"
 #include "gimppatternclipboard.h"
 #include "gimptagcache.h"
+#include "gimptempbuf.h"
 #include "gimptemplate.h"
 #include "gimptoolinfo.h"
 #include "gimptoolpreset.h"
@@ -275,6 +277,8 @@ gimp_constructed (GObject *object)
   xcf_init (gimp);
 
   gimp->documents = gimp_document_list_new (gimp);
+
+  gimp->memory_monitor = gimp_memory_monitor_new (gimp);
 }
 
 static void
@@ -482,6 +486,12 @@ gimp_finalize (GObject *object)
       gimp->image_table = NULL;
     }
 
+  if (gimp->memory_monitor)
+    {
+      g_object_unref (gimp->memory_monitor);
+      gimp->memory_monitor = NULL;
+    }
+
   if (gimp->images)
     {
       g_object_unref (gimp->images);
@@ -499,6 +509,8 @@ gimp_finalize (GObject *object)
 
   gimp_paint_exit (gimp);
 
+  gimp_temp_buf_clear_pool ();
+
   if (gimp->parasites)
     {
       g_object_unref (gimp->parasites);
@@ -551,9 +563,14 @@ gimp_get_memsize (GimpObject *object,
 {
   Gimp   *gimp    = GIMP (object);
   gint64  memsize = 0;
+  gsize   pool_size;
 
   memsize += gimp_g_list_get_memsize (gimp->user_units, 0 /* FIXME */);
 
+  /*  live temp bufs are accounted by their owners  */
+  gimp_temp_buf_get_pool_stats (NULL, &pool_size);
+  memsize += pool_size;
+
   memsize += gimp_object_get_memsize (GIMP_OBJECT (gimp->parasites),
                                       gui_size);
 
@@ -622,39 +639,40 @@ gimp_real_initialize (Gimp               *gimp,
 {
   static const GimpDataFactoryLoaderEntry brush_loader_entries[] =
   {
-    { gimp_brush_load,           GIMP_BRUSH_FILE_EXTENSION,           FALSE },
-    { gimp_brush_load,           GIMP_BRUSH_PIXMAP_FILE_EXTENSION,    FALSE },
-    { gimp_brush_load_abr,       GIMP_BRUSH_PS_FILE_EXTENSION,        FALSE },
-    { gimp_brush_load_abr,       GIMP_BRUSH_PSP_FILE_EXTENSION,       FALSE },
-    { gimp_brush_generated_load, GIMP_BRUSH_GENERATED_FILE_EXTENSION, TRUE  },
-    { gimp_brush_pipe_load,      GIMP_BRUSH_PIPE_FILE_EXTENSION,      FALSE }
+    { gimp_brush_load,           GIMP_BRUSH_FILE_EXTENSION,           FALSE, TRUE  },
+    { gimp_brush_load,           GIMP_BRUSH_PIXMAP_FILE_EXTENSION,    FALSE, TRUE  },
+    { gimp_brush_load_abr,       GIMP_BRUSH_PS_FILE_EXTENSION,        FALSE, TRUE  },
+    { gimp_brush_load_abr,       GIMP_BRUSH_PSP_FILE_EXTENSION,       FALSE, TRUE  },
+    { gimp_brush_generated_load, GIMP_BRUSH_GENERATED_FILE_EXTENSION, TRUE,  TRUE  },
+    { gimp_brush_pipe_load,      GIMP_BRUSH_PIPE_FILE_EXTENSION,      FALSE, TRUE  }
   };
 
   static const GimpDataFactoryLoaderEntry dynamics_loader_entries[] =
   {
-    { gimp_dynamics_load,        GIMP_DYNAMICS_FILE_EXTENSION,        TRUE  }
+    { gimp_dynamics_load,        GIMP_DYNAMICS_FILE_EXTENSION,        TRUE,  FALSE }
   };
 
   static const GimpDataFactoryLoaderEntry pattern_loader_entries[] =
   {
-    { gimp_pattern_load,         GIMP_PATTERN_FILE_EXTENSION,         FALSE },
-    { gimp_pattern_load_pixbuf,  NULL /* fallback loader */,          FALSE }
+    { gimp_pattern_load,         GIMP_PATTERN_FILE_EXTENSION,         FALSE, TRUE  },
+    { gimp_pattern_load_pixbuf,  NULL /* fallback loader */,          FALSE, TRUE  }
   };
 
   static const GimpDataFactoryLoaderEntry gradient_loader_entries[] =
   {
-    { gimp_gradient_load,        GIMP_GRADIENT_FILE_EXTENSION,        TRUE  },
-    { gimp_gradient_load_svg,    GIMP_GRADIENT_SVG_FILE_EXTENSION,    FALSE }
+    { gimp_gradient_load,        GIMP_GRADIENT_FILE_EXTENSION,        TRUE,  TRUE  },
+    { gimp_gradient_load_svg,    GIMP_GRADIENT_SVG_FILE_EXTENSION,    FALSE, TRUE  }
   };
 
   static const GimpDataFactoryLoaderEntry palette_loader_entries[] =
   {
-    { gimp_palette_load,         GIMP_PALETTE_FILE_EXTENSION,         TRUE  }
+    { gimp_palette_load,         GIMP_PALETTE_FILE_EXTENSION,         TRUE,  TRUE  }
   };
 
+  /*  tool presets create tool options, which is not threadsafe  */
   static const GimpDataFactoryLoaderEntry tool_preset_loader_entries[] =
   {
-    { gimp_tool_preset_load,     GIMP_TOOL_PRESET_FILE_EXTENSION,     TRUE  }
+    { gimp_tool_preset_load,     GIMP_TOOL_PRESET_FILE_EXTENSION,     TRUE,  FALSE }
   };
 
   GimpData *clipboard_brush;
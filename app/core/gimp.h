@@ -77,6 +77,7 @@ struct _Gimp
   GimpPlugInManager      *plug_in_manager;
 
   GimpContainer          *images;
+  GimpMemoryMonitor      *memory_monitor;
   guint32                 next_guide_ID;
   guint32                 next_sample_point_ID;
   GimpIdTable            *image_table;
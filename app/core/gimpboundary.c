@@ -26,12 +26,16 @@
 
 #include "core-types.h"
 
+#include "gimp-parallel.h"
 #include "gimpboundary.h"
 
 
 /* GimpBoundSeg array growth parameter */
 #define MAX_SEGS_INC  2048
 
+/* minimal number of scanlines traced by one thread */
+#define MIN_PARALLEL_SUB_SIZE  64
+
 
 typedef struct _GimpBoundary GimpBoundary;
 
@@ -44,14 +48,41 @@ struct _GimpBoundary
 
   /*  The array of vertical segments  */
   gint         *vert_segs;
+  gint          max_vert_segs;
 
   /*  The empty segment arrays */
   gint         *empty_segs_n;
   gint         *empty_segs_c;
   gint         *empty_segs_l;
   gint          max_empty_segs;
+
+  /*  When tracing a band of scanlines, the vertical segments which
+   *  are still open at the band's top, the (x, segment index) pairs
+   *  of the segments closing them, and the (x, y1) pairs of the
+   *  vertical segments left open at the band's bottom, with y1 == -1
+   *  for segments open at both ends
+   */
+  gboolean     *carried;
+  GArray       *carried_segs;
+  GArray       *dangling_segs;
 };
 
+typedef struct
+{
+  GeglBuffer          *buffer;
+  const GeglRectangle *region;
+  const Babl          *format;
+  GimpBoundaryType     type;
+  gint                 x1;
+  gint                 y1;
+  gint                 x2;
+  gint                 y2;
+  gfloat               threshold;
+  gint                 start;
+  gint                 end;
+  GimpBoundary        *bands[GIMP_PARALLEL_MAX_THREADS];
+} BoundaryData;
+
 
 /*  local function prototypes  */
 
@@ -91,6 +122,15 @@ static void           make_horiz_segs          (GimpBoundary        *boundary,
                                                 gint                 empty[],
                                                 gint                 num_empty,
                                                 gint                 top);
+static void           carry_vert_segs          (GimpBoundary        *boundary,
+                                                gint                 scanline,
+                                                const gint          *empty_l,
+                                                gint                 num_empty_l,
+                                                const gint          *empty_c,
+                                                gint                 num_empty_c);
+static void           generate_boundary_band   (gint                 i,
+                                                gint                 n,
+                                                BoundaryData        *data);
 static GimpBoundary * generate_boundary        (GeglBuffer          *buffer,
                                                 const GeglRectangle *region,
                                                 const Babl          *format,
@@ -423,9 +463,10 @@ gimp_boundary_new (const GeglRectangle *region)
       /*  array for determining the vertical line segments
        *  which must be drawn
        */
-      boundary->vert_segs = g_new (gint, region->width + region->x + 1);
+      boundary->max_vert_segs = region->width + region->x + 1;
+      boundary->vert_segs     = g_new (gint, boundary->max_vert_segs);
 
-      for (i = 0; i <= (region->width + region->x); i++)
+      for (i = 0; i < boundary->max_vert_segs; i++)
         boundary->vert_segs[i] = -1;
 
       /*  find the maximum possible number of empty segments
@@ -456,6 +497,13 @@ gimp_boundary_free (GimpBoundary *boundary,
   g_free (boundary->empty_segs_n);
   g_free (boundary->empty_segs_c);
   g_free (boundary->empty_segs_l);
+  g_free (boundary->carried);
+
+  if (boundary->carried_segs)
+    g_array_free (boundary->carried_segs, TRUE);
+
+  if (boundary->dangling_segs)
+    g_array_free (boundary->dangling_segs, TRUE);
 
   g_slice_free (GimpBoundary, boundary);
 
@@ -614,6 +662,14 @@ process_horiz_seg (GimpBoundary *boundary,
 
   if (boundary->vert_segs[x1] >= 0)
     {
+      if (boundary->carried && boundary->carried[x1])
+        {
+          gint carried_seg[2] = { x1, boundary->num_segs };
+
+          g_array_append_vals (boundary->carried_segs, carried_seg, 2);
+          boundary->carried[x1] = FALSE;
+        }
+
       gimp_boundary_add_seg (boundary, x1, boundary->vert_segs[x1], x1, y1, !open);
       boundary->vert_segs[x1] = -1;
     }
@@ -622,6 +678,14 @@ process_horiz_seg (GimpBoundary *boundary,
 
   if (boundary->vert_segs[x2] >= 0)
     {
+      if (boundary->carried && boundary->carried[x2])
+        {
+          gint carried_seg[2] = { x2, boundary->num_segs };
+
+          g_array_append_vals (boundary->carried_segs, carried_seg, 2);
+          boundary->carried[x2] = FALSE;
+        }
+
       gimp_boundary_add_seg (boundary, x2, boundary->vert_segs[x2], x2, y2, open);
       boundary->vert_segs[x2] = -1;
     }
@@ -663,22 +727,70 @@ make_horiz_segs (GimpBoundary *boundary,
     }
 }
 
-static GimpBoundary *
-generate_boundary (GeglBuffer          *buffer,
-                   const GeglRectangle *region,
-                   const Babl          *format,
-                   GimpBoundaryType     type,
-                   gint                 x1,
-                   gint                 y1,
-                   gint                 x2,
-                   gint                 y2,
-                   gfloat               threshold)
+static void
+carry_vert_segs (GimpBoundary *boundary,
+                 gint          scanline,
+                 const gint   *empty_l,
+                 gint          num_empty_l,
+                 const gint   *empty_c,
+                 gint          num_empty_c)
+{
+  /*  A band starting at @scanline has to begin with the vertical
+   *  segments that tracing the scanlines above would leave open.
+   *  These are the ones along the pixel edges of the previous
+   *  scanline, toggled by the endpoints of the horizontal segments
+   *  below the previous scanline, which are traced by the band above.
+   */
+  gint i;
+  gint j;
+
+  boundary->carried       = g_new0 (gboolean, boundary->max_vert_segs);
+  boundary->carried_segs  = g_array_new (FALSE, FALSE, sizeof (gint));
+  boundary->dangling_segs = g_array_new (FALSE, FALSE, sizeof (gint));
+
+  for (i = 1; i < num_empty_l - 1; i++)
+    boundary->carried[empty_l[i]] = ! boundary->carried[empty_l[i]];
+
+  for (i = 1; i < num_empty_l - 1; i += 2)
+    {
+      gint start = empty_l[i];
+      gint end   = empty_l[i + 1];
+
+      for (j = 0; j < num_empty_c; j += 2)
+        {
+          gint e_s = empty_c[j];
+          gint e_e = empty_c[j + 1];
+
+          if ((e_s <= start && e_e >= end) ||
+              (e_s > start && e_s < end)   ||
+              (e_e < end && e_e > start))
+            {
+              gint x1 = MAX (e_s, start);
+              gint x2 = MIN (e_e, end);
+
+              boundary->carried[x1] = ! boundary->carried[x1];
+              boundary->carried[x2] = ! boundary->carried[x2];
+            }
+        }
+    }
+
+  for (i = 0; i < boundary->max_vert_segs; i++)
+    {
+      if (boundary->carried[i])
+        boundary->vert_segs[i] = scanline;
+    }
+}
+
+static void
+generate_boundary_band (gint          i,
+                        gint          n,
+                        BoundaryData *data)
 {
   GimpBoundary  *boundary;
   GeglRectangle  line_rect = { 0, };
   gfloat        *line_data;
   gint           scanline;
-  gint           i;
+  gint           j;
   gint           start, end;
   gint          *tmp_segs;
 
@@ -686,73 +798,73 @@ generate_boundary (GeglBuffer          *buffer,
   gint          num_empty_c = 0;
   gint          num_empty_l = 0;
 
-  boundary = gimp_boundary_new (region);
+  boundary = gimp_boundary_new (data->region);
 
-  line_rect.width  = gegl_buffer_get_width (buffer);
+  line_rect.width  = gegl_buffer_get_width (data->buffer);
   line_rect.height = 1;
 
   line_data = g_alloca (sizeof (gfloat) * line_rect.width);
 
-  start = 0;
-  end   = 0;
-
-  if (type == GIMP_BOUNDARY_WITHIN_BOUNDS)
-    {
-      start = y1;
-      end   = y2;
-    }
-  else if (type == GIMP_BOUNDARY_IGNORE_BOUNDS)
-    {
-      start = region->y;
-      end   = region->y + region->height;
-    }
+  start = data->start + (gint64) (data->end - data->start) * i       / n;
+  end   = data->start + (gint64) (data->end - data->start) * (i + 1) / n;
 
   /*  Find the empty segments for the previous and current scanlines  */
-  find_empty_segs (region, NULL,
+  line_rect.y = start - 1;
+  if (i > 0)
+    gegl_buffer_get (data->buffer, &line_rect, 1.0, data->format,
+                     line_data, GEGL_AUTO_ROWSTRIDE,
+                     GEGL_ABYSS_NONE);
+
+  find_empty_segs (data->region, i > 0 ? line_data : NULL,
                    start - 1, boundary->empty_segs_l,
                    boundary->max_empty_segs, &num_empty_l,
-                   type, x1, y1, x2, y2,
-                   threshold);
+                   data->type, data->x1, data->y1, data->x2, data->y2,
+                   data->threshold);
 
   line_rect.y = start;
-  gegl_buffer_get (buffer, &line_rect, 1.0, format,
+  gegl_buffer_get (data->buffer, &line_rect, 1.0, data->format,
                    line_data, GEGL_AUTO_ROWSTRIDE,
                    GEGL_ABYSS_NONE);
 
-  find_empty_segs (region, line_data,
+  find_empty_segs (data->region, line_data,
                    start, boundary->empty_segs_c,
                    boundary->max_empty_segs, &num_empty_c,
-                   type, x1, y1, x2, y2,
-                   threshold);
+                   data->type, data->x1, data->y1, data->x2, data->y2,
+                   data->threshold);
+
+  if (i > 0)
+    carry_vert_segs (boundary, start,
+                     boundary->empty_segs_l, num_empty_l,
+                     boundary->empty_segs_c, num_empty_c);
 
   for (scanline = start; scanline < end; scanline++)
     {
       /*  find the empty segment list for the next scanline  */
       line_rect.y = scanline + 1;
-      if (scanline + 1 == end)
+      if (scanline + 1 == data->end)
         line_data = NULL;
       else
-        gegl_buffer_get (buffer, &line_rect, 1.0, format,
+        gegl_buffer_get (data->buffer, &line_rect, 1.0, data->format,
                          line_data, GEGL_AUTO_ROWSTRIDE,
                          GEGL_ABYSS_NONE);
 
-      find_empty_segs (region, line_data,
+      find_empty_segs (data->region, line_data,
                        scanline + 1, boundary->empty_segs_n,
                        boundary->max_empty_segs, &num_empty_n,
-                       type, x1, y1, x2, y2,
-                       threshold);
+                       data->type, data->x1, data->y1, data->x2, data->y2,
+                       data->threshold);
 
       /*  process the segments on the current scanline  */
-      for (i = 1; i < num_empty_c - 1; i += 2)
+      for (j = 1; j < num_empty_c - 1; j += 2)
         {
           make_horiz_segs (boundary,
-                           boundary->empty_segs_c [i],
-                           boundary->empty_segs_c [i+1],
+                           boundary->empty_segs_c [j],
+                           boundary->empty_segs_c [j+1],
                            scanline,
                            boundary->empty_segs_l, num_empty_l, 1);
           make_horiz_segs (boundary,
-                           boundary->empty_segs_c [i],
-                           boundary->empty_segs_c [i+1],
+                           boundary->empty_segs_c [j],
+                           boundary->empty_segs_c [j+1],
                            scanline + 1,
                            boundary->empty_segs_n, num_empty_n, 0);
         }
@@ -766,6 +878,145 @@ generate_boundary (GeglBuffer          *buffer,
       boundary->empty_segs_n = tmp_segs;
     }
 
+  /*  remember the vertical segments continuing in the band below  */
+  if (i < n - 1)
+    {
+      if (! boundary->dangling_segs)
+        boundary->dangling_segs = g_array_new (FALSE, FALSE, sizeof (gint));
+
+      for (j = 0; j < boundary->max_vert_segs; j++)
+        {
+          if (boundary->vert_segs[j] >= 0)
+            {
+              gint dangling_seg[2] = { j, boundary->vert_segs[j] };
+
+              if (boundary->carried && boundary->carried[j])
+                dangling_seg[1] = -1;
+
+              g_array_append_vals (boundary->dangling_segs, dangling_seg, 2);
+            }
+        }
+    }
+
+  data->bands[i] = boundary;
+}
+
+static GimpBoundary *
+generate_boundary (GeglBuffer          *buffer,
+                   const GeglRectangle *region,
+                   const Babl          *format,
+                   GimpBoundaryType     type,
+                   gint                 x1,
+                   gint                 y1,
+                   gint                 x2,
+                   gint                 y2,
+                   gfloat               threshold)
+{
+  BoundaryData          data = { 0, };
+  GimpBoundary         *boundary;
+  gint                 *carry;
+  gint                  n_bands;
+  gint                  i;
+
+  data.buffer    = buffer;
+  data.region    = region;
+  data.format    = format;
+  data.type      = type;
+  data.x1        = x1;
+  data.y1        = y1;
+  data.x2        = x2;
+  data.y2        = y2;
+  data.threshold = threshold;
+
+  if (type == GIMP_BOUNDARY_WITHIN_BOUNDS)
+    {
+      data.start = y1;
+      data.end   = y2;
+    }
+  else if (type == GIMP_BOUNDARY_IGNORE_BOUNDS)
+    {
+      data.start = region->y;
+      data.end   = region->y + region->height;
+    }
+
+  if (data.end <= data.start)
+    return gimp_boundary_new (region);
+
+  /*  trace bands of scanlines in parallel, and join the vertical
+   *  segments crossing the bands' edges afterwards
+   */
+  gimp_parallel_distribute (MAX ((data.end - data.start) /
+                                 MIN_PARALLEL_SUB_SIZE, 1),
+                            (GimpParallelDistributeFunc)
+                            generate_boundary_band,
+                            &data);
+
+  for (n_bands = 0;
+       n_bands < GIMP_PARALLEL_MAX_THREADS && data.bands[n_bands];
+       n_bands++);
+
+  if (n_bands == 1)
+    return data.bands[0];
+
+  boundary = gimp_boundary_new (NULL);
+
+  carry = g_new (gint, region->width + region->x + 1);
+
+  for (i = 0; i <= region->width + region->x; i++)
+    carry[i] = -1;
+
+  for (i = 0; i < n_bands; i++)
+    {
+      GimpBoundary *band = data.bands[i];
+      gint          j;
+
+      if (band->dangling_segs)
+        {
+          gint *dangling = (gint *) band->dangling_segs->data;
+
+          for (j = 0; j < band->dangling_segs->len; j += 2)
+            {
+              if (dangling[j + 1] < 0)
+                dangling[j + 1] = carry[dangling[j]];
+            }
+        }
+
+      if (band->carried_segs)
+        {
+          const gint *carried = (const gint *) band->carried_segs->data;
+
+          for (j = 0; j < band->carried_segs->len; j += 2)
+            {
+              if (carry[carried[j]] >= 0)
+                band->segs[carried[j + 1]].y1 = carry[carried[j]];
+            }
+        }
+
+      if (band->dangling_segs)
+        {
+          const gint *dangling = (const gint *) band->dangling_segs->data;
+
+          for (j = 0; j < band->dangling_segs->len; j += 2)
+            carry[dangling[j]] = dangling[j + 1];
+        }
+
+      if (band->num_segs > 0)
+        {
+          boundary->max_segs += band->num_segs;
+          boundary->segs      = g_renew (GimpBoundSeg, boundary->segs,
+                                         boundary->max_segs);
+
+          memcpy (boundary->segs + boundary->num_segs, band->segs,
+                  band->num_segs * sizeof (GimpBoundSeg));
+
+          boundary->num_segs += band->num_segs;
+        }
+
+      gimp_boundary_free (band, TRUE);
+    }
+
+  g_free (carry);
+
   return boundary;
 }
 
@@ -68,6 +68,10 @@ struct _AbrSampledBrushHeader
 
 /*  local function prototypes  */
 
+static gboolean    gimp_brush_load_header        (GInputStream      *input,
+                                                  BrushHeader       *header,
+                                                  GError           **error);
+
 static GList     * gimp_brush_load_abr_v12       (GDataInputStream  *input,
                                                   AbrHeader         *abr_hdr,
                                                   GFile             *file,
@@ -148,83 +152,8 @@ gimp_brush_load_brush (GimpContext   *context,
   g_return_val_if_fail (G_IS_INPUT_STREAM (input), NULL);
   g_return_val_if_fail (error == NULL || *error == NULL, NULL);
 
-  /*  read the header  */
-  if (! g_input_stream_read_all (input, &header, sizeof (header),
-                                 &bytes_read, NULL, error) ||
-      bytes_read != sizeof (header))
-    {
-      return NULL;
-    }
-
-  /*  rearrange the bytes in each unsigned int  */
-  header.header_size  = g_ntohl (header.header_size);
-  header.version      = g_ntohl (header.version);
-  header.width        = g_ntohl (header.width);
-  header.height       = g_ntohl (header.height);
-  header.bytes        = g_ntohl (header.bytes);
-  header.magic_number = g_ntohl (header.magic_number);
-  header.spacing      = g_ntohl (header.spacing);
-
-  /*  Check for correct file format */
-
-  if (header.width == 0)
-    {
-      g_set_error (error, GIMP_DATA_ERROR, GIMP_DATA_ERROR_READ,
-                   _("Fatal parse error in brush file: Width = 0."));
-      return NULL;
-    }
-
-  if (header.height == 0)
-    {
-      g_set_error (error, GIMP_DATA_ERROR, GIMP_DATA_ERROR_READ,
-                   _("Fatal parse error in brush file: Height = 0."));
-      return NULL;
-    }
-
-  if (header.bytes == 0)
-    {
-      g_set_error (error, GIMP_DATA_ERROR, GIMP_DATA_ERROR_READ,
-                   _("Fatal parse error in brush file: Bytes = 0."));
-      return NULL;
-    }
-
-  switch (header.version)
-    {
-    case 1:
-      /*  If this is a version 1 brush, set the fp back 8 bytes  */
-      if (! g_seekable_seek (G_SEEKABLE (input), -8, G_SEEK_CUR,
-                             NULL, error))
-        return NULL;
-
-      header.header_size += 8;
-      /*  spacing is not defined in version 1  */
-      header.spacing = 25;
-      break;
-
-    case 3:  /*  cinepaint brush  */
-      if (header.bytes == 18  /* FLOAT16_GRAY_GIMAGE */)
-        {
-          header.bytes = 2;
-        }
-      else
-        {
-          g_set_error (error, GIMP_DATA_ERROR, GIMP_DATA_ERROR_READ,
-                       _("Fatal parse error in brush file: Unknown depth %d."),
-                       header.bytes);
-          return NULL;
-        }
-      /*  fallthrough  */
-
-    case 2:
-      if (header.magic_number == GBRUSH_MAGIC)
-        break;
-
-    default:
-      g_set_error (error, GIMP_DATA_ERROR, GIMP_DATA_ERROR_READ,
-                   _("Fatal parse error in brush file: Unknown version %d."),
-                   header.version);
-      return NULL;
-    }
+  if (! gimp_brush_load_header (input, &header, error))
+    return NULL;
 
   /*  Read in the brush name  */
   if ((bn_size = (header.header_size - sizeof (header))))
@@ -389,6 +318,45 @@ gimp_brush_load_brush (GimpContext   *context,
   return brush;
 }
 
+/**
+ * gimp_brush_load_brush_skip:
+ * @input: a seekable #GInputStream positioned at the start of a brush
+ * @error: return location for an error
+ *
+ * Checks the header of the brush at the current position of @input
+ * and seeks past the brush without reading its pixel data.  This is
+ * used by brush pipes to find their cells without decoding them.
+ *
+ * Return value: %TRUE if the brush header is valid and was skipped.
+ **/
+gboolean
+gimp_brush_load_brush_skip (GInputStream  *input,
+                            GError       **error)
+{
+  BrushHeader header;
+
+  g_return_val_if_fail (G_IS_SEEKABLE (input), FALSE);
+  g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  if (! gimp_brush_load_header (input, &header, error))
+    return FALSE;
+
+  if (header.bytes != 1 && header.bytes != 2 && header.bytes != 4)
+    {
+      g_set_error (error, GIMP_DATA_ERROR, GIMP_DATA_ERROR_READ,
+                   _("Fatal parse error in brush file:\n"
+                     "Unsupported brush depth %d\n"
+                     "GIMP brushes must be GRAY or RGBA."),
+                   header.bytes);
+      return FALSE;
+    }
+
+  return g_seekable_seek (G_SEEKABLE (input),
+                          (goffset) (header.header_size - sizeof (header)) +
+                          (goffset) header.width * header.height * header.bytes,
+                          G_SEEK_CUR, NULL, error);
+}
+
 GList *
 gimp_brush_load_abr (GimpContext   *context,
                      GFile         *file,
@@ -456,6 +424,94 @@ gimp_brush_load_abr (GimpContext   *context,
 
 /*  private functions  */
 
+static gboolean
+gimp_brush_load_header (GInputStream  *input,
+                        BrushHeader   *header,
+                        GError       **error)
+{
+  gsize bytes_read;
+
+  /*  read the header  */
+  if (! g_input_stream_read_all (input, header, sizeof (BrushHeader),
+                                 &bytes_read, NULL, error) ||
+      bytes_read != sizeof (BrushHeader))
+    {
+      return FALSE;
+    }
+
+  /*  rearrange the bytes in each unsigned int  */
+  header->header_size  = g_ntohl (header->header_size);
+  header->version      = g_ntohl (header->version);
+  header->width        = g_ntohl (header->width);
+  header->height       = g_ntohl (header->height);
+  header->bytes        = g_ntohl (header->bytes);
+  header->magic_number = g_ntohl (header->magic_number);
+  header->spacing      = g_ntohl (header->spacing);
+
+  /*  Check for correct file format */
+
+  if (header->width == 0)
+    {
+      g_set_error (error, GIMP_DATA_ERROR, GIMP_DATA_ERROR_READ,
+                   _("Fatal parse error in brush file: Width = 0."));
+      return FALSE;
+    }
+
+  if (header->height == 0)
+    {
+      g_set_error (error, GIMP_DATA_ERROR, GIMP_DATA_ERROR_READ,
+                   _("Fatal parse error in brush file: Height = 0."));
+      return FALSE;
+    }
+
+  if (header->bytes == 0)
+    {
+      g_set_error (error, GIMP_DATA_ERROR, GIMP_DATA_ERROR_READ,
+                   _("Fatal parse error in brush file: Bytes = 0."));
+      return FALSE;
+    }
+
+  switch (header->version)
+    {
+    case 1:
+      /*  If this is a version 1 brush, set the fp back 8 bytes  */
+      if (! g_seekable_seek (G_SEEKABLE (input), -8, G_SEEK_CUR,
+                             NULL, error))
+        return FALSE;
+
+      header->header_size += 8;
+      /*  spacing is not defined in version 1  */
+      header->spacing = 25;
+      break;
+
+    case 3:  /*  cinepaint brush  */
+      if (header->bytes == 18  /* FLOAT16_GRAY_GIMAGE */)
+        {
+          header->bytes = 2;
+        }
+      else
+        {
+          g_set_error (error, GIMP_DATA_ERROR, GIMP_DATA_ERROR_READ,
+                       _("Fatal parse error in brush file: Unknown depth %d."),
+                       header->bytes);
+          return FALSE;
+        }
+      /*  fallthrough  */
+
+    case 2:
+      if (header->magic_number == GBRUSH_MAGIC)
+        break;
+
+    default:
+      g_set_error (error, GIMP_DATA_ERROR, GIMP_DATA_ERROR_READ,
+                   _("Fatal parse error in brush file: Unknown version %d."),
+                   header->version);
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
 static GList *
 gimp_brush_load_abr_v12 (GDataInputStream  *input,
                          AbrHeader         *abr_hdr,
@@ -33,6 +33,9 @@ GimpBrush * gimp_brush_load_brush  (GimpContext   *context,
                                     GFile         *file,
                                     GInputStream  *input,
                                     GError       **error);
+gboolean    gimp_brush_load_brush_skip
+                                   (GInputStream  *input,
+                                    GError       **error);
 
 GList     * gimp_brush_load_abr    (GimpContext   *context,
                                     GFile         *file,
@@ -93,6 +93,12 @@ static gboolean      gimp_brush_real_want_null_motion (GimpBrush            *bru
 
 static gchar       * gimp_brush_get_checksum          (GimpTagged           *tagged);
 
+static void          gimp_brush_quantize_transform    (GimpBrush            *brush,
+                                                       gdouble              *scale,
+                                                       gdouble              *aspect_ratio,
+                                                       gdouble              *angle,
+                                                       gdouble              *hardness);
+
 
 G_DEFINE_TYPE_WITH_CODE (GimpBrush, gimp_brush, GIMP_TYPE_DATA,
                          G_IMPLEMENT_INTERFACE (GIMP_TYPE_TAGGED,
@@ -427,13 +433,19 @@ static void
 gimp_brush_real_begin_use (GimpBrush *brush)
 {
   brush->priv->mask_cache =
-    gimp_brush_cache_new ((GDestroyNotify) gimp_temp_buf_unref, 'M', 'm');
+    gimp_brush_cache_new ((GDestroyNotify) gimp_temp_buf_unref,
+                          (GimpBrushCacheMemsizeFunc) gimp_temp_buf_get_memsize,
+                          'M', 'm');
 
   brush->priv->pixmap_cache =
-    gimp_brush_cache_new ((GDestroyNotify) gimp_temp_buf_unref, 'P', 'p');
+    gimp_brush_cache_new ((GDestroyNotify) gimp_temp_buf_unref,
+                          (GimpBrushCacheMemsizeFunc) gimp_temp_buf_get_memsize,
+                          'P', 'p');
 
   brush->priv->boundary_cache =
-    gimp_brush_cache_new ((GDestroyNotify) gimp_bezier_desc_free, 'B', 'b');
+    gimp_brush_cache_new ((GDestroyNotify) gimp_bezier_desc_free,
+                          (GimpBrushCacheMemsizeFunc) gimp_bezier_desc_get_memsize,
+                          'B', 'b');
 }
 
 static void
@@ -498,6 +510,43 @@ gimp_brush_get_checksum (GimpTagged *tagged)
   return checksum_string;
 }
 
+/*  Generated brushes are rendered from their parameters, which paint
+ *  dynamics change for every dab.  Round the parameters to steps that
+ *  make no visible difference in the rendered mask, so the mask cache
+ *  can hand out the same mask for many dabs.
+ */
+static void
+gimp_brush_quantize_transform (GimpBrush *brush,
+                               gdouble   *scale,
+                               gdouble   *aspect_ratio,
+                               gdouble   *angle,
+                               gdouble   *hardness)
+{
+  if (! GIMP_IS_BRUSH_GENERATED (brush))
+    return;
+
+  if (*scale != 1.0)
+    {
+      gdouble radius;
+
+      radius = gimp_brush_generated_get_radius (GIMP_BRUSH_GENERATED (brush));
+
+      /*  steps of a quarter pixel of the transformed radius  */
+      if (radius > 0.0)
+        *scale = MAX (RINT (*scale * radius * 4.0), 1.0) / (radius * 4.0);
+    }
+
+  *aspect_ratio = RINT (*aspect_ratio * 100.0) / 100.0;
+
+  /*  the angle is in turns, use steps of half a degree  */
+  *angle = RINT (*angle * 720.0) / 720.0;
+
+  /*  the mask is 8 bit  */
+  if (hardness)
+    *hardness = RINT (*hardness * 255.0) / 255.0;
+}
+
+
 /*  public functions  */
 
 GimpData *
@@ -594,6 +643,9 @@ gimp_brush_transform_size (GimpBrush     *brush,
   g_return_if_fail (width != NULL);
   g_return_if_fail (height != NULL);
 
+  gimp_brush_quantize_transform (brush,
+                                 &scale, &aspect_ratio, &angle, NULL);
+
   if (scale        == 1.0 &&
       aspect_ratio == 0.0 &&
       ((angle == 0.0) || (angle == 0.5) || (angle == 1.0)))
@@ -623,6 +675,9 @@ gimp_brush_transform_mask (GimpBrush *brush,
   g_return_val_if_fail (GIMP_IS_BRUSH (brush), NULL);
   g_return_val_if_fail (scale > 0.0, NULL);
 
+  gimp_brush_quantize_transform (brush,
+                                 &scale, &aspect_ratio, &angle, &hardness);
+
   gimp_brush_transform_size (brush,
                              scale, aspect_ratio, angle,
                              &width, &height);
@@ -724,6 +779,9 @@ gimp_brush_transform_boundary (GimpBrush *brush,
   g_return_val_if_fail (width != NULL, NULL);
   g_return_val_if_fail (height != NULL, NULL);
 
+  gimp_brush_quantize_transform (brush,
+                                 &scale, &aspect_ratio, &angle, &hardness);
+
   gimp_brush_transform_size (brush,
                              scale, aspect_ratio, angle,
                              width, height);
@@ -24,6 +24,7 @@
 
 #include "core-types.h"
 
+#include "gimp-memsize.h"
 #include "gimpbrushcache.h"
 
 #include "gimp-log.h"
@@ -37,6 +38,22 @@ enum
 };
 
 
+typedef struct _GimpBrushCacheUnit GimpBrushCacheUnit;
+
+struct _GimpBrushCacheUnit
+{
+  gpointer data;
+  gsize    size;
+
+  gint     width;
+  gint     height;
+  gdouble  scale;
+  gdouble  aspect_ratio;
+  gdouble  angle;
+  gdouble  hardness;
+};
+
+
 static void   gimp_brush_cache_constructed  (GObject      *object);
 static void   gimp_brush_cache_finalize     (GObject      *object);
 static void   gimp_brush_cache_set_property (GObject      *object,
@@ -48,6 +65,12 @@ static void   gimp_brush_cache_get_property (GObject      *object,
                                              GValue       *value,
                                              GParamSpec   *pspec);
 
+static gint64 gimp_brush_cache_get_memsize  (GimpObject   *object,
+                                             gint64       *gui_size);
+
+static void   gimp_brush_cache_remove_unit  (GimpBrushCache *cache,
+                                             GList          *link);
+
 
 G_DEFINE_TYPE (GimpBrushCache, gimp_brush_cache, GIMP_TYPE_OBJECT)
 
@@ -57,12 +80,15 @@ G_DEFINE_TYPE (GimpBrushCache, gimp_brush_cache, GIMP_TYPE_OBJECT)
 static void
 gimp_brush_cache_class_init (GimpBrushCacheClass *klass)
 {
-  GObjectClass  *object_class = G_OBJECT_CLASS (klass);
+  GObjectClass    *object_class      = G_OBJECT_CLASS (klass);
+  GimpObjectClass *gimp_object_class = GIMP_OBJECT_CLASS (klass);
+
+  object_class->constructed      = gimp_brush_cache_constructed;
+  object_class->finalize         = gimp_brush_cache_finalize;
+  object_class->set_property     = gimp_brush_cache_set_property;
+  object_class->get_property     = gimp_brush_cache_get_property;
 
-  object_class->constructed  = gimp_brush_cache_constructed;
-  object_class->finalize     = gimp_brush_cache_finalize;
-  object_class->set_property = gimp_brush_cache_set_property;
-  object_class->get_property = gimp_brush_cache_get_property;
+  gimp_object_class->get_memsize = gimp_brush_cache_get_memsize;
 
   g_object_class_install_property (object_class, PROP_DATA_DESTROY,
                                    g_param_spec_pointer ("data-destroy",
@@ -91,11 +117,7 @@ gimp_brush_cache_finalize (GObject *object)
 {
   GimpBrushCache *cache = GIMP_BRUSH_CACHE (object);
 
-  if (cache->last_data)
-    {
-      cache->data_destroy (cache->last_data);
-      cache->last_data = NULL;
-    }
+  gimp_brush_cache_clear (cache);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
@@ -140,13 +162,29 @@ gimp_brush_cache_get_property (GObject    *object,
     }
 }
 
+static gint64
+gimp_brush_cache_get_memsize (GimpObject *object,
+                              gint64     *gui_size)
+{
+  GimpBrushCache *cache   = GIMP_BRUSH_CACHE (object);
+  gint64          memsize = 0;
+
+  memsize += gimp_g_list_get_memsize (cache->cached_units,
+                                      sizeof (GimpBrushCacheUnit));
+  memsize += cache->cached_size;
+
+  return memsize + GIMP_OBJECT_CLASS (parent_class)->get_memsize (object,
+                                                                  gui_size);
+}
+
 
 /*  public functions  */
 
 GimpBrushCache *
-gimp_brush_cache_new (GDestroyNotify  data_destroy,
-                      gchar           debug_hit,
-                      gchar           debug_miss)
+gimp_brush_cache_new (GDestroyNotify             data_destroy,
+                      GimpBrushCacheMemsizeFunc  data_get_memsize,
+                      gchar                      debug_hit,
+                      gchar                      debug_miss)
 {
   GimpBrushCache *cache;
 
@@ -156,8 +194,9 @@ gimp_brush_cache_new (GDestroyNotify  data_destroy,
                          "data-destroy", data_destroy,
                          NULL);
 
-  cache->debug_hit  = debug_hit;
-  cache->debug_miss = debug_miss;
+  cache->data_get_memsize = data_get_memsize;
+  cache->debug_hit        = debug_hit;
+  cache->debug_miss       = debug_miss;
 
   return cache;
 }
@@ -167,11 +206,8 @@ gimp_brush_cache_clear (GimpBrushCache *cache)
 {
   g_return_if_fail (GIMP_IS_BRUSH_CACHE (cache));
 
-  if (cache->last_data)
-    {
-      cache->data_destroy (cache->last_data);
-      cache->last_data = NULL;
-    }
+  while (cache->cached_units)
+    gimp_brush_cache_remove_unit (cache, cache->cached_units);
 }
 
 gconstpointer
@@ -183,20 +219,34 @@ gimp_brush_cache_get (GimpBrushCache *cache,
                       gdouble         angle,
                       gdouble         hardness)
 {
+  GList *list;
+
   g_return_val_if_fail (GIMP_IS_BRUSH_CACHE (cache), NULL);
 
-  if (cache->last_data                         &&
-      cache->last_width        == width        &&
-      cache->last_height       == height       &&
-      cache->last_scale        == scale        &&
-      cache->last_aspect_ratio == aspect_ratio &&
-      cache->last_angle        == angle        &&
-      cache->last_hardness     == hardness)
+  for (list = cache->cached_units; list; list = g_list_next (list))
     {
-      if (gimp_log_flags & GIMP_LOG_BRUSH_CACHE)
-        g_printerr ("%c", cache->debug_hit);
-
-      return (gconstpointer) cache->last_data;
+      GimpBrushCacheUnit *unit = list->data;
+
+      if (unit->width        == width        &&
+          unit->height       == height       &&
+          unit->scale        == scale        &&
+          unit->aspect_ratio == aspect_ratio &&
+          unit->angle        == angle        &&
+          unit->hardness     == hardness)
+        {
+          if (gimp_log_flags & GIMP_LOG_BRUSH_CACHE)
+            g_printerr ("%c", cache->debug_hit);
+
+          /*  move the unit to the front, for LRU eviction  */
+          if (list != cache->cached_units)
+            {
+              cache->cached_units = g_list_remove_link (cache->cached_units,
+                                                        list);
+              cache->cached_units = g_list_concat (list, cache->cached_units);
+            }
+
+          return (gconstpointer) unit->data;
+        }
     }
 
   if (gimp_log_flags & GIMP_LOG_BRUSH_CACHE)
@@ -215,20 +265,60 @@ gimp_brush_cache_add (GimpBrushCache *cache,
                       gdouble         angle,
                       gdouble         hardness)
 {
+  GimpBrushCacheUnit *unit;
+  GList              *list;
+
   g_return_if_fail (GIMP_IS_BRUSH_CACHE (cache));
   g_return_if_fail (data != NULL);
 
-  if (data == cache->last_data)
-    return;
+  for (list = cache->cached_units; list; list = g_list_next (list))
+    {
+      unit = list->data;
+
+      if (unit->data == data)
+        return;
+    }
+
+  unit = g_slice_new (GimpBrushCacheUnit);
+
+  unit->data         = data;
+  unit->size         = 0;
+  unit->width        = width;
+  unit->height       = height;
+  unit->scale        = scale;
+  unit->aspect_ratio = aspect_ratio;
+  unit->angle        = angle;
+  unit->hardness     = hardness;
+
+  if (cache->data_get_memsize)
+    unit->size = cache->data_get_memsize (data);
+
+  cache->cached_units  = g_list_prepend (cache->cached_units, unit);
+  cache->cached_size  += unit->size;
+
+  /*  evict the least recently used units, but never the one just
+   *  added, the caller is about to use it
+   */
+  while (cache->cached_size > GIMP_BRUSH_CACHE_MAX_MEMSIZE &&
+         cache->cached_units->next)
+    {
+      gimp_brush_cache_remove_unit (cache, g_list_last (cache->cached_units));
+    }
+}
+
+
+/*  private functions  */
+
+static void
+gimp_brush_cache_remove_unit (GimpBrushCache *cache,
+                              GList          *link)
+{
+  GimpBrushCacheUnit *unit = link->data;
+
+  cache->cached_units  = g_list_delete_link (cache->cached_units, link);
+  cache->cached_size  -= unit->size;
 
-  if (cache->last_data)
-    cache->data_destroy (cache->last_data);
+  cache->data_destroy (unit->data);
 
-  cache->last_data         = data;
-  cache->last_width        = width;
-  cache->last_height       = height;
-  cache->last_scale        = scale;
-  cache->last_aspect_ratio = aspect_ratio;
-  cache->last_angle        = angle;
-  cache->last_hardness     = hardness;
+  g_slice_free (GimpBrushCacheUnit, unit);
 }
@@ -443,6 +443,102 @@ gimp_brush_generated_calc_lut (gdouble radius,
   return lookup;
 }
 
+/*  computes the distances of the pixels x_start..x_end of row y from
+ *  the center, for the unspiked shapes.  The loops are kept free of
+ *  branches, so the compiler can vectorize them.
+ */
+static void
+gimp_brush_generated_calc_row (GimpBrushGeneratedShape  shape,
+                               gdouble                  c,
+                               gdouble                  s,
+                               gdouble                  aspect_ratio,
+                               gint                     y,
+                               gint                     x_start,
+                               gint                     x_end,
+                               gdouble                 *dist)
+{
+  gint x;
+
+  switch (shape)
+    {
+    case GIMP_BRUSH_GENERATED_CIRCLE:
+      for (x = x_start; x <= x_end; x++)
+        {
+          gdouble tx = c * x - s * y;
+          gdouble ty = (s * x + c * y) * aspect_ratio;
+
+          dist[x] = sqrt (tx * tx + ty * ty);
+        }
+      break;
+
+    case GIMP_BRUSH_GENERATED_SQUARE:
+      for (x = x_start; x <= x_end; x++)
+        {
+          gdouble tx = fabs (c * x - s * y);
+          gdouble ty = fabs ((s * x + c * y) * aspect_ratio);
+
+          dist[x] = MAX (tx, ty);
+        }
+      break;
+
+    case GIMP_BRUSH_GENERATED_DIAMOND:
+      for (x = x_start; x <= x_end; x++)
+        {
+          gdouble tx = fabs (c * x - s * y);
+          gdouble ty = fabs ((s * x + c * y) * aspect_ratio);
+
+          dist[x] = tx + ty;
+        }
+      break;
+    }
+}
+
+/*  the distance of pixel x, y from the center for a shape with more
+ *  than two spikes
+ */
+static gdouble
+gimp_brush_generated_calc_spiked (GimpBrushGeneratedShape  shape,
+                                  gint                     spikes,
+                                  gdouble                  c,
+                                  gdouble                  s,
+                                  gdouble                  cs,
+                                  gdouble                  ss,
+                                  gdouble                  aspect_ratio,
+                                  gint                     x,
+                                  gint                     y)
+{
+  gdouble tx    = c * x - s * y;
+  gdouble ty    = fabs (s * x + c * y);
+  gdouble angle = atan2 (ty, tx);
+
+  while (angle > G_PI / spikes)
+    {
+      gdouble sx = tx;
+      gdouble sy = ty;
+
+      tx = cs * sx - ss * sy;
+      ty = ss * sx + cs * sy;
+
+      angle -= 2 * G_PI / spikes;
+    }
+
+  ty *= aspect_ratio;
+
+  switch (shape)
+    {
+    case GIMP_BRUSH_GENERATED_CIRCLE:
+      return sqrt (SQR (tx) + SQR (ty));
+
+    case GIMP_BRUSH_GENERATED_SQUARE:
+      return MAX (fabs (tx), fabs (ty));
+
+    case GIMP_BRUSH_GENERATED_DIAMOND:
+      return fabs (tx) + fabs (ty);
+    }
+
+  return 0.0;
+}
+
 static GimpTempBuf *
 gimp_brush_generated_calc (GimpBrushGenerated      *brush,
                            GimpBrushGeneratedShape  shape,
@@ -456,8 +552,11 @@ gimp_brush_generated_calc (GimpBrushGenerated      *brush,
 {
   guchar      *centerp;
   guchar      *lookup;
-  guchar       a;
+  gdouble     *dist;
   gint         x, y;
+  gint         x_start;
+  gint         y_start;
+  gboolean     mirror_axes;
   gdouble      c, s, cs, ss;
   GimpVector2  x_axis;
   GimpVector2  y_axis;
@@ -488,61 +587,70 @@ gimp_brush_generated_calc (GimpBrushGenerated      *brush,
 
   lookup = gimp_brush_generated_calc_lut (radius, hardness);
 
+  /*  indexed from -half_width to half_width  */
+  dist = g_new (gdouble, width) + half_width;
+
   cs = cos (- 2 * G_PI / spikes);
   ss = sin (- 2 * G_PI / spikes);
 
-  /* for an even number of spikes compute one half and mirror it */
-  for (y = ((spikes % 2) ? -half_height : 0); y <= half_height; y++)
-    {
-      for (x = -half_width; x <= half_width; x++)
-        {
-          gdouble d  = 0;
-          gdouble tx = c * x - s * y;
-          gdouble ty = fabs (s * x + c * y);
+  /*  an unspiked shape which is rotated by a multiple of 90 degrees is
+   *  symmetric to both axes, compute one quadrant and mirror it
+   */
+  mirror_axes = (spikes == 2 && (fabs (s) < 1e-10 || fabs (c) < 1e-10));
 
-          if (spikes > 2)
-            {
-              gdouble angle = atan2 (ty, tx);
+  if (mirror_axes)
+    {
+      s = RINT (s);
+      c = RINT (c);
+    }
 
-              while (angle > G_PI / spikes)
-                {
-                  gdouble sx = tx;
-                  gdouble sy = ty;
+  x_start = mirror_axes ? 0 : -half_width;
 
-                  tx = cs * sx - ss * sy;
-                  ty = ss * sx + cs * sy;
+  /* for an even number of spikes compute one half and mirror it */
+  y_start = (spikes % 2) ? -half_height : 0;
 
-                  angle -= 2 * G_PI / spikes;
-                }
-            }
+  for (y = y_start; y <= half_height; y++)
+    {
+      guchar *row        = centerp + y * width;
+      guchar *mirror_row = centerp - y * width;
 
-          ty *= aspect_ratio;
+      if (spikes > 2)
+        {
+          for (x = x_start; x <= half_width; x++)
+            dist[x] = gimp_brush_generated_calc_spiked (shape, spikes,
+                                                        c, s, cs, ss,
+                                                        aspect_ratio,
+                                                        x, y);
+        }
+      else
+        {
+          gimp_brush_generated_calc_row (shape, c, s, aspect_ratio,
+                                         y, x_start, half_width, dist);
+        }
 
-          switch (shape)
-            {
-            case GIMP_BRUSH_GENERATED_CIRCLE:
-              d = sqrt (SQR (tx) + SQR (ty));
-              break;
-            case GIMP_BRUSH_GENERATED_SQUARE:
-              d = MAX (fabs (tx), fabs (ty));
-              break;
-            case GIMP_BRUSH_GENERATED_DIAMOND:
-              d = fabs (tx) + fabs (ty);
-              break;
-            }
+      for (x = x_start; x <= half_width; x++)
+        {
+          guchar a;
 
-          if (d < radius + 1)
-            a = lookup[(gint) RINT (d * OVERSAMPLING)];
+          if (dist[x] < radius + 1)
+            a = lookup[(gint) RINT (dist[x] * OVERSAMPLING)];
           else
             a = 0;
 
-          centerp[y * width + x] = a;
+          row[x] = a;
 
           if (spikes % 2 == 0)
-            centerp[-1 * y * width - x] = a;
+            mirror_row[-x] = a;
+
+          if (mirror_axes)
+            {
+              row[-x]       = a;
+              mirror_row[x] = a;
+            }
         }
     }
 
+  g_free (dist - half_width);
   g_free (lookup);
 
   if (xaxis)
@@ -189,8 +189,33 @@ gimp_brush_pipe_load (GimpContext   *context,
 
   pipe->brushes = g_new0 (GimpBrush *, num_of_brushes);
 
+  /*  if the file can be seeked, only decode the first cell now and
+   *  remember where the others are, they are loaded when painting
+   *  selects them for the first time
+   */
+  if (G_IS_SEEKABLE (input) && g_seekable_can_seek (G_SEEKABLE (input)))
+    {
+      pipe->file    = g_object_ref (file);
+      pipe->offsets = g_new0 (goffset, num_of_brushes);
+    }
+
   while (pipe->n_brushes < num_of_brushes)
     {
+      if (pipe->offsets && pipe->n_brushes > 0)
+        {
+          pipe->offsets[pipe->n_brushes] =
+            g_seekable_tell (G_SEEKABLE (input));
+
+          if (! gimp_brush_load_brush_skip (input, error))
+            {
+              g_object_unref (pipe);
+              return NULL;
+            }
+
+          pipe->n_brushes++;
+          continue;
+        }
+
       pipe->brushes[pipe->n_brushes] = gimp_brush_load_brush (context,
                                                               file, input,
                                                               error);
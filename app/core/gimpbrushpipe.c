@@ -25,6 +25,7 @@
 
 #include "core-types.h"
 
+#include "gimpbrush-load.h"
 #include "gimpbrush-private.h"
 #include "gimpbrushpipe.h"
 #include "gimpbrushpipe-load.h"
@@ -56,6 +57,9 @@ G_DEFINE_TYPE (GimpBrushPipe, gimp_brush_pipe, GIMP_TYPE_BRUSH);
 
 #define parent_class gimp_brush_pipe_parent_class
 
+/*  cells are loaded on demand, possibly from the paint thread  */
+G_LOCK_DEFINE_STATIC (cells);
+
 
 static void
 gimp_brush_pipe_class_init (GimpBrushPipeClass *klass)
@@ -88,6 +92,8 @@ gimp_brush_pipe_init (GimpBrushPipe *pipe)
   pipe->brushes   = NULL;
   pipe->select    = NULL;
   pipe->index     = NULL;
+  pipe->file      = NULL;
+  pipe->offsets   = NULL;
 }
 
 static void
@@ -129,6 +135,14 @@ gimp_brush_pipe_finalize (GObject *object)
       pipe->index = NULL;
     }
 
+  g_clear_object (&pipe->file);
+
+  if (pipe->offsets)
+    {
+      g_free (pipe->offsets);
+      pipe->offsets = NULL;
+    }
+
   GIMP_BRUSH (pipe)->priv->mask   = NULL;
   GIMP_BRUSH (pipe)->priv->pixmap = NULL;
 
@@ -147,9 +161,17 @@ gimp_brush_pipe_get_memsize (GimpObject *object,
                                 sizeof (gint) /* stride */ +
                                 sizeof (PipeSelectModes));
 
+  if (pipe->offsets)
+    memsize += pipe->n_brushes * sizeof (goffset);
+
+  G_LOCK (cells);
+
   for (i = 0; i < pipe->n_brushes; i++)
-    memsize += gimp_object_get_memsize (GIMP_OBJECT (pipe->brushes[i]),
-                                        gui_size);
+    if (pipe->brushes[i])
+      memsize += gimp_object_get_memsize (GIMP_OBJECT (pipe->brushes[i]),
+                                          gui_size);
+
+  G_UNLOCK (cells);
 
   return memsize + GIMP_OBJECT_CLASS (parent_class)->get_memsize (object,
                                                                   gui_size);
@@ -174,9 +196,13 @@ gimp_brush_pipe_begin_use (GimpBrush *brush)
 
   GIMP_BRUSH_CLASS (parent_class)->begin_use (brush);
 
+  G_LOCK (cells);
+
   for (i = 0; i < pipe->n_brushes; i++)
     if (pipe->brushes[i])
       gimp_brush_begin_use (pipe->brushes[i]);
+
+  G_UNLOCK (cells);
 }
 
 static void
@@ -187,9 +213,13 @@ gimp_brush_pipe_end_use (GimpBrush *brush)
 
   GIMP_BRUSH_CLASS (parent_class)->end_use (brush);
 
+  G_LOCK (cells);
+
   for (i = 0; i < pipe->n_brushes; i++)
     if (pipe->brushes[i])
       gimp_brush_end_use (pipe->brushes[i]);
+
+  G_UNLOCK (cells);
 }
 
 static GimpBrush *
@@ -257,7 +287,7 @@ gimp_brush_pipe_select_brush (GimpBrush        *brush,
   /* Make sure is inside bounds */
   brushix = CLAMP (brushix, 0, pipe->n_brushes - 1);
 
-  pipe->current = pipe->brushes[brushix];
+  pipe->current = gimp_brush_pipe_get_brush (pipe, brushix);
 
   return GIMP_BRUSH (pipe->current);
 }
@@ -279,3 +309,73 @@ gimp_brush_pipe_want_null_motion (GimpBrush        *brush,
 
   return TRUE;
 }
+
+
+/*  public functions  */
+
+/**
+ * gimp_brush_pipe_get_brush:
+ * @pipe:  a #GimpBrushPipe
+ * @index: the index of a cell
+ *
+ * Returns the brush of cell @index, loading it from the pipe's file
+ * first if it wasn't used before.  A cell that fails to load is
+ * replaced by the first cell.
+ *
+ * Return value: the cell's #GimpBrush.
+ **/
+GimpBrush *
+gimp_brush_pipe_get_brush (GimpBrushPipe *pipe,
+                           gint           index)
+{
+  GimpBrush *brush;
+
+  g_return_val_if_fail (GIMP_IS_BRUSH_PIPE (pipe), NULL);
+  g_return_val_if_fail (index >= 0 && index < pipe->n_brushes, NULL);
+
+  G_LOCK (cells);
+
+  brush = pipe->brushes[index];
+
+  if (! brush)
+    {
+      GInputStream *input;
+      GError       *error = NULL;
+
+      input = G_INPUT_STREAM (g_file_read (pipe->file, NULL, &error));
+
+      if (input)
+        {
+          if (g_seekable_seek (G_SEEKABLE (input), pipe->offsets[index],
+                               G_SEEK_SET, NULL, &error))
+            {
+              brush = gimp_brush_load_brush (NULL, pipe->file, input, &error);
+            }
+
+          g_object_unref (input);
+        }
+
+      if (brush)
+        {
+          gimp_object_set_name (GIMP_OBJECT (brush), NULL);
+        }
+      else
+        {
+          g_printerr ("Failed to load cell %d of brush pipe '%s': %s\n",
+                      index, gimp_object_get_name (GIMP_OBJECT (pipe)),
+                      error ? error->message : "unknown error");
+          g_clear_error (&error);
+
+          brush = g_object_ref (pipe->brushes[0]);
+        }
+
+      if (GIMP_BRUSH (pipe)->priv->use_count > 0)
+        gimp_brush_begin_use (brush);
+
+      pipe->brushes[index] = brush;
+    }
+
+  G_UNLOCK (cells);
+
+  return brush;
+}
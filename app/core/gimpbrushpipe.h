@@ -59,8 +59,11 @@ struct _GimpBrushPipe
 
   gint              n_brushes;  /* Might be less than the product of the
                                  * ranks in some odd special case */
-  GimpBrush       **brushes;
+  GimpBrush       **brushes;    /* NULL for cells not loaded yet */
   GimpBrush        *current;    /* Currently selected brush */
+
+  GFile            *file;       /* Where to load the missing cells from */
+  goffset          *offsets;    /* File offset of each cell */
 };
 
 struct _GimpBrushPipeClass
@@ -69,7 +72,10 @@ struct _GimpBrushPipeClass
 };
 
 
-GType   gimp_brush_pipe_get_type (void) G_GNUC_CONST;
+GType       gimp_brush_pipe_get_type  (void) G_GNUC_CONST;
+
+GimpBrush * gimp_brush_pipe_get_brush (GimpBrushPipe *pipe,
+                                       gint           index);
 
 
 #endif  /* __GIMP_BRUSH_PIPE_H__ */
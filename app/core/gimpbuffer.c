@@ -26,6 +26,7 @@
 #include "core-types.h"
 
 #include "gegl/gimp-babl.h"
+#include "gegl/gimp-gegl-utils.h"
 
 #include "gimp-memsize.h"
 #include "gimpbuffer.h"
@@ -250,7 +251,7 @@ gimp_buffer_new (GeglBuffer    *buffer,
                               NULL);
 
   if (copy_pixels)
-    gimp_buffer->buffer = gegl_buffer_dup (buffer);
+    gimp_buffer->buffer = gimp_gegl_buffer_dup_area (buffer, NULL);
   else
     gimp_buffer->buffer = g_object_ref (buffer);
 
@@ -27,12 +27,21 @@
 
 #include "core-types.h"
 
+#include "gegl/gimp-gegl-mask.h"
 #include "gegl/gimp-gegl-mask-combine.h"
 
 #include "gimpchannel.h"
 #include "gimpchannel-combine.h"
 
 
+static void   gimp_channel_combine_add_bounds    (GimpChannel *mask,
+                                                  gint         x,
+                                                  gint         y,
+                                                  gint         w,
+                                                  gint         h);
+static void   gimp_channel_combine_shrink_bounds (GimpChannel *mask);
+
+
 void
 gimp_channel_combine_rect (GimpChannel    *mask,
                            GimpChannelOps  op,
@@ -76,6 +85,10 @@ gimp_channel_combine_rect (GimpChannel    *mask,
       mask->x2    = x + w;
       mask->y2    = y + h;
     }
+  else if (mask->bounds_known)
+    {
+      gimp_channel_combine_shrink_bounds (mask);
+    }
   else
     {
       mask->bounds_known = FALSE;
@@ -186,6 +199,10 @@ gimp_channel_combine_ellipse_rect (GimpChannel    *mask,
       mask->x2    = x + w;
       mask->y2    = y + h;
     }
+  else if (mask->bounds_known)
+    {
+      gimp_channel_combine_shrink_bounds (mask);
+    }
   else
     {
       mask->bounds_known = FALSE;
@@ -239,7 +256,73 @@ gimp_channel_combine_buffer (GimpChannel    *mask,
                             gimp_item_get_height (GIMP_ITEM (mask)),
                             &x, &y, &w, &h);
 
-  mask->bounds_known = FALSE;
+  /*  only look at the changed part of the mask, not the whole channel  */
+  if (mask->bounds_known)
+    {
+      if (op == GIMP_CHANNEL_OP_ADD || op == GIMP_CHANNEL_OP_REPLACE)
+        gimp_channel_combine_add_bounds (mask, x, y, w, h);
+      else
+        gimp_channel_combine_shrink_bounds (mask);
+    }
 
   gimp_drawable_update (GIMP_DRAWABLE (mask), x, y, w, h);
 }
+
+
+/*  private functions  */
+
+static void
+gimp_channel_combine_add_bounds (GimpChannel *mask,
+                                 gint         x,
+                                 gint         y,
+                                 gint         w,
+                                 gint         h)
+{
+  GeglBuffer *buffer = gimp_drawable_get_buffer (GIMP_DRAWABLE (mask));
+  gint        x1, y1, x2, y2;
+
+  /*  the mask only gained pixels within the rectangle, so the new
+   *  bounds are the old ones plus the bounds of the rectangle's
+   *  contents
+   */
+  if (! gimp_gegl_mask_bounds_in_area (buffer,
+                                       GEGL_RECTANGLE (x, y, w, h),
+                                       &x1, &y1, &x2, &y2))
+    return;
+
+  if (mask->empty)
+    {
+      mask->empty = FALSE;
+      mask->x1    = x1;
+      mask->y1    = y1;
+      mask->x2    = x2;
+      mask->y2    = y2;
+    }
+  else
+    {
+      mask->x1 = MIN (mask->x1, x1);
+      mask->y1 = MIN (mask->y1, y1);
+      mask->x2 = MAX (mask->x2, x2);
+      mask->y2 = MAX (mask->y2, y2);
+    }
+}
+
+static void
+gimp_channel_combine_shrink_bounds (GimpChannel *mask)
+{
+  GeglBuffer *buffer = gimp_drawable_get_buffer (GIMP_DRAWABLE (mask));
+
+  /*  the mask only lost pixels, so the new bounds are within the old
+   *  ones
+   */
+  if (mask->empty)
+    return;
+
+  mask->empty = ! gimp_gegl_mask_bounds_in_area (buffer,
+                                                 GEGL_RECTANGLE (mask->x1,
+                                                                 mask->y1,
+                                                                 mask->x2 - mask->x1,
+                                                                 mask->y2 - mask->y1),
+                                                 &mask->x1, &mask->y1,
+                                                 &mask->x2, &mask->y2);
+}
@@ -226,6 +226,7 @@ gimp_channel_select_scan_convert (GimpChannel     *channel,
 {
   GimpItem   *item;
   GeglBuffer *add_on;
+  gint        x, y, w, h;
 
   g_return_if_fail (GIMP_IS_CHANNEL (channel));
   g_return_if_fail (gimp_item_is_attached (GIMP_ITEM (channel)));
@@ -241,20 +242,50 @@ gimp_channel_select_scan_convert (GimpChannel     *channel,
 
   item = GIMP_ITEM (channel);
 
-  add_on = gegl_buffer_new (GEGL_RECTANGLE (0, 0,
-                                            gimp_item_get_width  (item),
-                                            gimp_item_get_height (item)),
+  x = 0;
+  y = 0;
+  w = gimp_item_get_width  (item);
+  h = gimp_item_get_height (item);
+
+  /*  unless intersecting, which also clears the channel outside the
+   *  path, only render the area covered by the path, plus room for
+   *  the feathering
+   */
+  if (op != GIMP_CHANNEL_OP_INTERSECT)
+    {
+      gint pad_x = 0;
+      gint pad_y = 0;
+
+      if (feather)
+        {
+          pad_x = 2 * ceil (feather_radius_x);
+          pad_y = 2 * ceil (feather_radius_y);
+        }
+
+      if (! gimp_scan_convert_get_bounds (scan_convert, &x, &y, &w, &h) ||
+          ! gimp_rectangle_intersect (x + offset_x - pad_x,
+                                      y + offset_y - pad_y,
+                                      w + 2 * pad_x,
+                                      h + 2 * pad_y,
+                                      0, 0,
+                                      gimp_item_get_width  (item),
+                                      gimp_item_get_height (item),
+                                      &x, &y, &w, &h))
+        return;
+    }
+
+  add_on = gegl_buffer_new (GEGL_RECTANGLE (0, 0, w, h),
                             babl_format ("Y float"));
 
   gimp_scan_convert_render (scan_convert, add_on,
-                            offset_x, offset_y, antialias);
+                            offset_x - x, offset_y - y, antialias);
 
   if (feather)
     gimp_gegl_apply_feather (add_on, NULL, NULL, add_on, NULL,
                              feather_radius_x,
                              feather_radius_y);
 
-  gimp_channel_combine_buffer (channel, add_on, op, 0, 0);
+  gimp_channel_combine_buffer (channel, add_on, op, x, y);
   g_object_unref (add_on);
 }
 
@@ -32,6 +32,7 @@
 #include "paint/gimppaintoptions.h"
 
 #include "gegl/gimp-gegl-apply-operation.h"
+#include "gegl/gimp-gegl-loops.h"
 #include "gegl/gimp-gegl-mask.h"
 #include "gegl/gimp-gegl-nodes.h"
 
@@ -875,8 +876,8 @@ gimp_channel_convert_type (GimpDrawable      *drawable,
 
   if (mask_dither_type == 0)
     {
-      gegl_buffer_copy (gimp_drawable_get_buffer (drawable), NULL,
-                        dest_buffer, NULL);
+      gimp_gegl_buffer_copy (gimp_drawable_get_buffer (drawable), NULL,
+                             dest_buffer, NULL);
     }
   else
     {
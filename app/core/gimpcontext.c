@@ -1730,9 +1730,13 @@ gimp_context_copy_properties (GimpContext         *src,
   g_return_if_fail (GIMP_IS_CONTEXT (src));
   g_return_if_fail (GIMP_IS_CONTEXT (dest));
 
+  g_object_freeze_notify (G_OBJECT (dest));
+
   for (prop = GIMP_CONTEXT_FIRST_PROP; prop <= GIMP_CONTEXT_LAST_PROP; prop++)
     if ((1 << prop) & prop_mask)
       gimp_context_copy_property (src, dest, prop);
+
+  g_object_thaw_notify (G_OBJECT (dest));
 }
 
 /*  attribute access functions  */
@@ -64,6 +64,7 @@ struct _GimpDataPrivate
   guint   internal  : 1;
   gint    freeze_count;
   gint64  mtime;
+  gint64  file_size;
 
   /* Identifies the GimpData object across sessions. Used when there
    * is not a filename associated with the object.
@@ -559,7 +560,8 @@ gimp_data_save (GimpData  *data,
   if (success)
     {
       GFileInfo *info = g_file_query_info (private->file,
-                                           G_FILE_ATTRIBUTE_TIME_MODIFIED,
+                                           G_FILE_ATTRIBUTE_TIME_MODIFIED ","
+                                           G_FILE_ATTRIBUTE_STANDARD_SIZE,
                                            G_FILE_QUERY_INFO_NONE,
                                            NULL, NULL);
       if (info)
@@ -567,6 +569,7 @@ gimp_data_save (GimpData  *data,
           private->mtime =
             g_file_info_get_attribute_uint64 (info,
                                               G_FILE_ATTRIBUTE_TIME_MODIFIED);
+          private->file_size = g_file_info_get_size (info);
           g_object_unref (info);
         }
 
@@ -1067,6 +1070,31 @@ gimp_data_get_mtime (GimpData *data)
   return private->mtime;
 }
 
+void
+gimp_data_set_file_size (GimpData *data,
+                         gint64    file_size)
+{
+  GimpDataPrivate *private;
+
+  g_return_if_fail (GIMP_IS_DATA (data));
+
+  private = GIMP_DATA_GET_PRIVATE (data);
+
+  private->file_size = file_size;
+}
+
+gint64
+gimp_data_get_file_size (GimpData *data)
+{
+  GimpDataPrivate *private;
+
+  g_return_val_if_fail (GIMP_IS_DATA (data), 0);
+
+  private = GIMP_DATA_GET_PRIVATE (data);
+
+  return private->file_size;
+}
+
 /**
  * gimp_data_duplicate:
  * @data: a #GimpData object
@@ -103,6 +103,9 @@ gboolean      gimp_data_is_deletable     (GimpData     *data);
 void          gimp_data_set_mtime        (GimpData     *data,
                                           gint64        mtime);
 gint64        gimp_data_get_mtime        (GimpData     *data);
+void          gimp_data_set_file_size    (GimpData     *data,
+                                          gint64        file_size);
+gint64        gimp_data_get_file_size    (GimpData     *data);
 
 GimpData    * gimp_data_duplicate        (GimpData     *data);
 
@@ -33,6 +33,7 @@
 #include "core-types.h"
 
 #include "gimp.h"
+#include "gimp-parallel.h"
 #include "gimp-utils.h"
 #include "gimpcontext.h"
 #include "gimpdata.h"
@@ -52,6 +53,29 @@ typedef void (* GimpDataForeachFunc) (GimpDataFactory *factory,
                                       GimpData        *data,
                                       gpointer         user_data);
 
+typedef struct _GimpDataFactoryLoadItem GimpDataFactoryLoadItem;
+typedef struct _GimpDataFactoryLoad     GimpDataFactoryLoad;
+
+struct _GimpDataFactoryLoadItem
+{
+  const GimpDataFactoryLoaderEntry *loader;
+  GFile                            *file;
+  guint64                           mtime;
+  gint64                            size;
+  gboolean                          dir_writable;
+  GFile                            *top_directory;
+
+  GList                            *data_list;
+  GError                           *error;
+};
+
+struct _GimpDataFactoryLoad
+{
+  GimpContext *context;
+  GArray      *items;
+  gint         next_item;  /*  the next item to hand out to a thread  */
+};
+
 
 struct _GimpDataFactoryPriv
 {
@@ -71,36 +95,36 @@ struct _GimpDataFactoryPriv
 };
 
 
-static void    gimp_data_factory_finalize       (GObject             *object);
+static void    gimp_data_factory_finalize       (GObject                 *object);
 
-static gint64  gimp_data_factory_get_memsize    (GimpObject          *object,
-                                                 gint64              *gui_size);
+static gint64  gimp_data_factory_get_memsize    (GimpObject              *object,
+                                                 gint64                  *gui_size);
 
-static void    gimp_data_factory_data_foreach   (GimpDataFactory     *factory,
-                                                 gboolean             skip_internal,
-                                                 GimpDataForeachFunc  callback,
-                                                 gpointer             user_data);
+static void    gimp_data_factory_data_foreach   (GimpDataFactory         *factory,
+                                                 gboolean                 skip_internal,
+                                                 GimpDataForeachFunc      callback,
+                                                 gpointer                 user_data);
 
-static void    gimp_data_factory_data_load      (GimpDataFactory     *factory,
-                                                 GimpContext         *context,
-                                                 GHashTable          *cache);
+static void    gimp_data_factory_data_load      (GimpDataFactory         *factory,
+                                                 GimpContext             *context,
+                                                 GHashTable              *cache);
 
-static GFile * gimp_data_factory_get_save_dir   (GimpDataFactory     *factory,
-                                                 GError             **error);
+static GFile * gimp_data_factory_get_save_dir   (GimpDataFactory         *factory,
+                                                 GError                 **error);
 
-static void    gimp_data_factory_load_directory (GimpDataFactory     *factory,
-                                                 GimpContext         *context,
-                                                 GHashTable          *cache,
-                                                 gboolean             dir_writable,
-                                                 GFile               *directory,
-                                                 GFile               *top_directory);
-static void    gimp_data_factory_load_data      (GimpDataFactory     *factory,
-                                                 GimpContext         *context,
-                                                 GHashTable          *cache,
-                                                 gboolean             dir_writable,
-                                                 GFile               *file,
-                                                 guint64              mtime,
-                                                 GFile               *top_directory);
+static void    gimp_data_factory_load_directory (GimpDataFactory         *factory,
+                                                 GHashTable              *cache,
+                                                 GArray                  *items,
+                                                 gboolean                 dir_writable,
+                                                 GFile                   *directory,
+                                                 GFile                   *top_directory);
+static void    gimp_data_factory_load_item      (GimpContext             *context,
+                                                 GimpDataFactoryLoadItem *item);
+static void    gimp_data_factory_load_func      (gint                     i,
+                                                 gint                     n,
+                                                 GimpDataFactoryLoad     *load);
+static void    gimp_data_factory_load_data      (GimpDataFactory         *factory,
+                                                 GimpDataFactoryLoadItem *item);
 
 
 G_DEFINE_TYPE (GimpDataFactory, gimp_data_factory, GIMP_TYPE_OBJECT)
@@ -288,8 +312,6 @@ gimp_data_factory_refresh_cache_add (GimpDataFactory *factory,
 
       g_object_ref (data);
 
-      gimp_container_remove (factory->priv->container, GIMP_OBJECT (data));
-
       list = g_hash_table_lookup (cache, file);
       list = g_list_prepend (list, data);
 
@@ -297,17 +319,24 @@ gimp_data_factory_refresh_cache_add (GimpDataFactory *factory,
     }
 }
 
+static void
+gimp_data_factory_refresh_cache_free (GList *list)
+{
+  g_list_free_full (list, (GDestroyNotify) g_object_unref);
+}
+
 static gboolean
 gimp_data_factory_refresh_cache_remove (gpointer key,
                                         gpointer value,
                                         gpointer user_data)
 {
-  GList *list;
+  GimpDataFactory *factory = user_data;
+  GList           *list;
 
   for (list = value; list; list = list->next)
-    g_object_unref (list->data);
+    gimp_container_remove (factory->priv->container, list->data);
 
-  g_list_free (value);
+  gimp_data_factory_refresh_cache_free (value);
 
   return TRUE;
 }
@@ -341,11 +370,14 @@ gimp_data_factory_data_load (GimpDataFactory *factory,
                              GimpContext     *context,
                              GHashTable      *cache)
 {
-  gchar *p;
-  gchar *wp;
-  GList *path;
-  GList *writable_path;
-  GList *list;
+  GimpDataFactoryLoad  load;
+  GArray              *items;
+  gchar               *p;
+  gchar               *wp;
+  GList               *path;
+  GList               *writable_path;
+  GList               *list;
+  gint                 i;
 
   g_object_get (factory->priv->gimp->config,
                 factory->priv->path_property_name,     &p,
@@ -358,6 +390,8 @@ gimp_data_factory_data_load (GimpDataFactory *factory,
   g_free (p);
   g_free (wp);
 
+  items = g_array_new (FALSE, FALSE, sizeof (GimpDataFactoryLoadItem));
+
   for (list = path; list; list = g_list_next (list))
     {
       gboolean dir_writable = FALSE;
@@ -366,12 +400,40 @@ gimp_data_factory_data_load (GimpDataFactory *factory,
                               (GCompareFunc) gimp_file_compare))
         dir_writable = TRUE;
 
-      gimp_data_factory_load_directory (factory, context, cache,
+      gimp_data_factory_load_directory (factory, cache, items,
                                         dir_writable,
                                         list->data,
                                         list->data);
     }
 
+  /*  the files are parsed in parallel, by loaders that allow it, and
+   *  then added to the container in the order they were found
+   */
+  load.context   = context;
+  load.items     = items;
+  load.next_item = 0;
+
+  gimp_parallel_distribute (-1,
+                            (GimpParallelDistributeFunc)
+                            gimp_data_factory_load_func,
+                            &load);
+
+  for (i = 0; i < items->len; i++)
+    {
+      GimpDataFactoryLoadItem *item;
+
+      item = &g_array_index (items, GimpDataFactoryLoadItem, i);
+
+      if (! item->loader->threadsafe)
+        gimp_data_factory_load_item (context, item);
+
+      gimp_data_factory_load_data (factory, item);
+
+      g_object_unref (item->file);
+    }
+
+  g_array_free (items, TRUE);
+
   g_list_free_full (path, (GDestroyNotify) g_object_unref);
   g_list_free_full (writable_path, (GDestroyNotify) g_object_unref);
 }
@@ -396,18 +458,20 @@ gimp_data_factory_data_refresh (GimpDataFactory *factory,
                                   gimp_data_factory_refresh_cache_add, cache);
 
   /*  Now the cache contains a GFile => list-of-objects mapping of
-   *  the old objects. So we should now traverse the directory and for
-   *  each file load it only if its mtime is newer.
+   *  the old objects, which stay in the container. So we should now
+   *  traverse the directory and for each file load it only if its
+   *  mtime or size changed.
    *
-   *  Once a file was added, it is removed from the cache, so the only
+   *  Once a file was found, it is removed from the cache, so the only
    *  objects remaining there will be those that are not present on
    *  the disk (that have to be destroyed)
    */
   gimp_data_factory_data_load (factory, context, cache);
 
-  /*  Now all the data is loaded. Free what remains in the cache  */
+  /*  Now all the data is loaded. Remove what remains in the cache  */
   g_hash_table_foreach_remove (cache,
-                               gimp_data_factory_refresh_cache_remove, NULL);
+                               gimp_data_factory_refresh_cache_remove,
+                               factory);
 
   g_hash_table_destroy (cache);
 
@@ -783,8 +847,8 @@ gimp_data_factory_get_save_dir (GimpDataFactory  *factory,
 
 static void
 gimp_data_factory_load_directory (GimpDataFactory *factory,
-                                  GimpContext     *context,
                                   GHashTable      *cache,
+                                  GArray          *items,
                                   gboolean         dir_writable,
                                   GFile           *directory,
                                   GFile           *top_directory)
@@ -795,6 +859,7 @@ gimp_data_factory_load_directory (GimpDataFactory *factory,
                                           G_FILE_ATTRIBUTE_STANDARD_NAME ","
                                           G_FILE_ATTRIBUTE_STANDARD_IS_HIDDEN ","
                                           G_FILE_ATTRIBUTE_STANDARD_TYPE ","
+                                          G_FILE_ATTRIBUTE_STANDARD_SIZE ","
                                           G_FILE_ATTRIBUTE_TIME_MODIFIED,
                                           G_FILE_QUERY_INFO_NONE,
                                           NULL, NULL);
@@ -819,22 +884,86 @@ gimp_data_factory_load_directory (GimpDataFactory *factory,
 
           if (file_type == G_FILE_TYPE_DIRECTORY)
             {
-              gimp_data_factory_load_directory (factory, context, cache,
+              gimp_data_factory_load_directory (factory, cache, items,
                                                 dir_writable,
                                                 child,
                                                 top_directory);
             }
           else if (file_type == G_FILE_TYPE_REGULAR)
             {
-              guint64 mtime;
+              const GimpDataFactoryLoaderEntry *loader = NULL;
+              GimpDataFactoryLoadItem           item   = { 0, };
+              gint                              i;
+
+              for (i = 0; i < factory->priv->n_loader_entries; i++)
+                {
+                  loader = &factory->priv->loader_entries[i];
+
+                  /* a loder matches if its extension matches, or if it
+                   * doesn't have an extension, which is the case for
+                   * the fallback loader, which must be last in the
+                   * loader array
+                   */
+                  if (! loader->extension ||
+                      gimp_file_has_extension (child, loader->extension))
+                    {
+                      break;
+                    }
+
+                  loader = NULL;
+                }
 
-              mtime = g_file_info_get_attribute_uint64 (info,
-                                                        G_FILE_ATTRIBUTE_TIME_MODIFIED);
+              if (loader)
+                {
+                  item.loader        = loader;
+                  item.file          = g_object_ref (child);
+                  item.mtime         = g_file_info_get_attribute_uint64 (info,
+                                                                         G_FILE_ATTRIBUTE_TIME_MODIFIED);
+                  item.size          = g_file_info_get_size (info);
+                  item.dir_writable  = dir_writable;
+                  item.top_directory = top_directory;
+
+                  if (cache)
+                    {
+                      GList *cached_data = g_hash_table_lookup (cache, child);
+
+                      if (cached_data)
+                        {
+                          GimpData *data = cached_data->data;
+
+                          g_hash_table_remove (cache, child);
+
+                          if (gimp_data_get_mtime (data) != 0              &&
+                              gimp_data_get_mtime (data) == item.mtime     &&
+                              gimp_data_get_file_size (data) == item.size)
+                            {
+                              /*  unchanged, keep the objects  */
+                              g_object_unref (item.file);
+                              item.file = NULL;
+                            }
+                          else
+                            {
+                              GList *list;
+
+                              /*  make room for the new objects, the
+                               *  container wants unique names
+                               */
+                              for (list = cached_data;
+                                   list;
+                                   list = g_list_next (list))
+                                {
+                                  gimp_container_remove (factory->priv->container,
+                                                         list->data);
+                                }
+                            }
+
+                          gimp_data_factory_refresh_cache_free (cached_data);
+                        }
+                    }
 
-              gimp_data_factory_load_data (factory, context, cache,
-                                           dir_writable,
-                                           child, mtime,
-                                           top_directory);
+                  if (item.file)
+                    g_array_append_val (items, item);
+                }
             }
 
           g_object_unref (child);
@@ -845,85 +974,70 @@ gimp_data_factory_load_directory (GimpDataFactory *factory,
     }
 }
 
+/*  runs in a worker thread for threadsafe loaders, it must not touch
+ *  anything but the item
+ */
 static void
-gimp_data_factory_load_data (GimpDataFactory *factory,
-                             GimpContext     *context,
-                             GHashTable      *cache,
-                             gboolean         dir_writable,
-                             GFile           *file,
-                             guint64          mtime,
-                             GFile           *top_directory)
-{
-  const GimpDataFactoryLoaderEntry *loader    = NULL;
-  GList                            *data_list = NULL;
-  GInputStream                     *input;
-  gint                              i;
-  GError                           *error = NULL;
-
-  for (i = 0; i < factory->priv->n_loader_entries; i++)
-    {
-      loader = &factory->priv->loader_entries[i];
-
-      /* a loder matches if its extension matches, or if it doesn't
-       * have an extension, which is the case for the fallback loader,
-       * which must be last in the loader array
-       */
-      if (! loader->extension ||
-          gimp_file_has_extension (file, loader->extension))
-        {
-          goto insert;
-        }
-    }
-
-  return;
-
- insert:
-  if (cache)
-    {
-      GList *cached_data = g_hash_table_lookup (cache, file);
-
-      if (cached_data &&
-          gimp_data_get_mtime (cached_data->data) != 0 &&
-          gimp_data_get_mtime (cached_data->data) == mtime)
-        {
-          GList *list;
-
-          for (list = cached_data; list; list = g_list_next (list))
-            gimp_container_add (factory->priv->container, list->data);
-
-          return;
-        }
-    }
+gimp_data_factory_load_item (GimpContext             *context,
+                             GimpDataFactoryLoadItem *item)
+{
+  GInputStream *input;
 
-  input = G_INPUT_STREAM (g_file_read (file, NULL, &error));
+  input = G_INPUT_STREAM (g_file_read (item->file, NULL, &item->error));
 
   if (input)
     {
-      data_list = loader->load_func (context, file, input, &error);
+      item->data_list = item->loader->load_func (context, item->file, input,
+                                                 &item->error);
 
-      if (error)
+      if (item->error)
         {
-          g_prefix_error (&error,
+          g_prefix_error (&item->error,
                           _("Error loading '%s': "),
-                          gimp_file_get_utf8_name (file));
+                          gimp_file_get_utf8_name (item->file));
         }
-      else if (! data_list)
+      else if (! item->data_list)
         {
-          g_set_error (&error, GIMP_DATA_ERROR, GIMP_DATA_ERROR_READ,
+          g_set_error (&item->error, GIMP_DATA_ERROR, GIMP_DATA_ERROR_READ,
                        _("Error loading '%s'"),
-                       gimp_file_get_utf8_name (file));
+                       gimp_file_get_utf8_name (item->file));
         }
 
       g_object_unref (input);
     }
   else
     {
-      g_prefix_error (&error,
+      g_prefix_error (&item->error,
                       _("Could not open '%s' for reading: "),
-                      gimp_file_get_utf8_name (file));
+                      gimp_file_get_utf8_name (item->file));
     }
+}
 
-  if (G_LIKELY (data_list))
+static void
+gimp_data_factory_load_func (gint                 i,
+                             gint                 n,
+                             GimpDataFactoryLoad *load)
+{
+  gint index;
+
+  /*  hand out files one by one, their parsing times differ a lot  */
+  while ((index = g_atomic_int_add (&load->next_item, 1)) <
+         (gint) load->items->len)
+    {
+      GimpDataFactoryLoadItem *item;
+
+      item = &g_array_index (load->items, GimpDataFactoryLoadItem, index);
+
+      if (item->loader->threadsafe)
+        gimp_data_factory_load_item (load->context, item);
+    }
+}
+
+static void
+gimp_data_factory_load_data (GimpDataFactory         *factory,
+                             GimpDataFactoryLoadItem *item)
+{
+  if (G_LIKELY (item->data_list))
     {
       GList    *list;
       gchar    *uri;
@@ -931,7 +1045,7 @@ gimp_data_factory_load_data (GimpDataFactory *factory,
       gboolean  writable  = FALSE;
       gboolean  deletable = FALSE;
 
-      uri = g_file_get_uri (file);
+      uri = g_file_get_uri (item->file);
 
       obsolete = (strstr (uri, GIMP_OBSOLETE_DATA_DIR_NAME) != 0);
 
@@ -940,16 +1054,18 @@ gimp_data_factory_load_data (GimpDataFactory *factory,
       /* obsolete files are immutable, don't check their writability */
       if (! obsolete)
         {
-          deletable = (g_list_length (data_list) == 1 && dir_writable);
-          writable  = (deletable && loader->writable);
+          deletable = (g_list_length (item->data_list) == 1 &&
+                       item->dir_writable);
+          writable  = (deletable && item->loader->writable);
         }
 
-      for (list = data_list; list; list = g_list_next (list))
+      for (list = item->data_list; list; list = g_list_next (list))
         {
           GimpData *data = list->data;
 
-          gimp_data_set_file (data, file, writable, deletable);
-          gimp_data_set_mtime (data, mtime);
+          gimp_data_set_file (data, item->file, writable, deletable);
+          gimp_data_set_mtime (data, item->mtime);
+          gimp_data_set_file_size (data, item->size);
           gimp_data_clean (data);
 
           if (obsolete)
@@ -959,7 +1075,7 @@ gimp_data_factory_load_data (GimpDataFactory *factory,
             }
           else
             {
-              gimp_data_set_folder_tags (data, top_directory);
+              gimp_data_set_folder_tags (data, item->top_directory);
 
               gimp_container_add (factory->priv->container,
                                   GIMP_OBJECT (data));
@@ -968,17 +1084,17 @@ gimp_data_factory_load_data (GimpDataFactory *factory,
           g_object_unref (data);
         }
 
-      g_list_free (data_list);
+      g_list_free (item->data_list);
     }
 
   /*  not else { ... } because loader->load_func() can return a list
    *  of data objects *and* an error message if loading failed after
    *  something was already loaded
    */
-  if (G_UNLIKELY (error))
+  if (G_UNLIKELY (item->error))
     {
       gimp_message (factory->priv->gimp, NULL, GIMP_MESSAGE_ERROR,
-                    _("Failed to load data:\n\n%s"), error->message);
-      g_clear_error (&error);
+                    _("Failed to load data:\n\n%s"), item->error->message);
+      g_clear_error (&item->error);
     }
 }
@@ -34,6 +34,7 @@
 #include "gegl/gimp-gegl-utils.h"
 
 #include "gimp.h"
+#include "gimp-parallel.h"
 #include "gimp-utils.h"
 #include "gimpchannel.h"
 #include "gimpcontext.h"
@@ -45,36 +46,48 @@
 #include "gimp-intl.h"
 
 
-//#define USE_GRADIENT_CACHE 1
+/*  the number of rows rendered between two progress updates  */
+#define PROGRESS_CHUNK_HEIGHT 256
+
+#define MIN_PARALLEL_SUB_SIZE 64
+#define MIN_PARALLEL_SUB_AREA (MIN_PARALLEL_SUB_SIZE * MIN_PARALLEL_SUB_SIZE)
 
 
 typedef struct
 {
-  GimpGradient     *gradient;
-  GimpContext      *context;
+  const GimpRGB    *gradient_lut;
   gboolean          reverse;
-#ifdef USE_GRADIENT_CACHE
-  GimpRGB          *gradient_cache;
-  gint              gradient_cache_size;
-#endif
   gdouble           offset;
   gdouble           sx, sy;
   GimpGradientType  gradient_type;
   gdouble           dist;
   gdouble           vec[2];
   GimpRepeatMode    repeat;
-  GRand            *seed;
-  GeglBuffer       *dist_buffer;
+  gfloat           *dist_data;
+  gint              dist_width;
+  gint              dist_height;
 } RenderBlendData;
 
 typedef struct
 {
   GeglBuffer    *buffer;
   gfloat        *row_data;
+  gint           x;
   gint           width;
   GRand         *dither_rand;
 } PutPixelData;
 
+typedef struct
+{
+  RenderBlendData *rbd;
+  GeglBuffer      *buffer;
+  gboolean         supersample;
+  gint             max_depth;
+  gdouble          threshold;
+  gboolean         dither;
+  guint32          seed;
+} FillRegionData;
+
 
 /*  local function prototypes  */
 
@@ -113,15 +126,18 @@ static gdouble  gradient_calc_spiral_factor       (gdouble   dist,
                                                    gdouble   y,
                                                    gboolean  clockwise);
 
-static gdouble  gradient_calc_shapeburst_angular_factor   (GeglBuffer *dist_buffer,
-                                                           gdouble     x,
-                                                           gdouble     y);
-static gdouble  gradient_calc_shapeburst_spherical_factor (GeglBuffer *dist_buffer,
-                                                           gdouble     x,
-                                                           gdouble     y);
-static gdouble  gradient_calc_shapeburst_dimpled_factor   (GeglBuffer *dist_buffer,
-                                                           gdouble     x,
-                                                           gdouble     y);
+static gfloat   gradient_get_shapeburst_dist              (RenderBlendData *rbd,
+                                                           gdouble          x,
+                                                           gdouble          y);
+static gdouble  gradient_calc_shapeburst_angular_factor   (RenderBlendData *rbd,
+                                                           gdouble          x,
+                                                           gdouble          y);
+static gdouble  gradient_calc_shapeburst_spherical_factor (RenderBlendData *rbd,
+                                                           gdouble          x,
+                                                           gdouble          y);
+static gdouble  gradient_calc_shapeburst_dimpled_factor   (RenderBlendData *rbd,
+                                                           gdouble          x,
+                                                           gdouble          y);
 
 static GeglBuffer * gradient_precalc_shapeburst (GimpImage           *image,
                                                  GimpDrawable        *drawable,
@@ -137,6 +153,8 @@ static void     gradient_put_pixel          (gint                 x,
                                              gint                 y,
                                              GimpRGB             *color,
                                              gpointer             put_pixel_data);
+static void     gradient_fill_area          (const GeglRectangle *area,
+                                             FillRegionData      *data);
 
 static void     gradient_fill_region        (GimpImage           *image,
                                              GimpDrawable        *drawable,
@@ -472,18 +490,23 @@ gradient_calc_spiral_factor (gdouble   dist,
     }
 }
 
-static gdouble
-gradient_calc_shapeburst_angular_factor (GeglBuffer *dist_buffer,
-                                         gdouble     x,
-                                         gdouble     y)
+static gfloat
+gradient_get_shapeburst_dist (RenderBlendData *rbd,
+                              gdouble          x,
+                              gdouble          y)
 {
-  gint   ix = CLAMP (x, 0.0, gegl_buffer_get_width  (dist_buffer) - 0.7);
-  gint   iy = CLAMP (y, 0.0, gegl_buffer_get_height (dist_buffer) - 0.7);
-  gfloat value;
+  gint ix = CLAMP (x, 0.0, rbd->dist_width  - 0.7);
+  gint iy = CLAMP (y, 0.0, rbd->dist_height - 0.7);
 
-  gegl_buffer_get (dist_buffer, GEGL_RECTANGLE (ix, iy, 1, 1), 1.0,
-                   NULL, &value,
-                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+  return rbd->dist_data[iy * rbd->dist_width + ix];
+}
+
+static gdouble
+gradient_calc_shapeburst_angular_factor (RenderBlendData *rbd,
+                                         gdouble          x,
+                                         gdouble          y)
+{
+  gfloat value = gradient_get_shapeburst_dist (rbd, x, y);
 
   value = 1.0 - value;
 
@@ -492,17 +515,11 @@ gradient_calc_shapeburst_angular_factor (GeglBuffer *dist_buffer,
 
 
 static gdouble
-gradient_calc_shapeburst_spherical_factor (GeglBuffer *dist_buffer,
-                                           gdouble     x,
-                                           gdouble     y)
+gradient_calc_shapeburst_spherical_factor (RenderBlendData *rbd,
+                                           gdouble          x,
+                                           gdouble          y)
 {
-  gint   ix = CLAMP (x, 0.0, gegl_buffer_get_width  (dist_buffer) - 0.7);
-  gint   iy = CLAMP (y, 0.0, gegl_buffer_get_height (dist_buffer) - 0.7);
-  gfloat value;
-
-  gegl_buffer_get (dist_buffer, GEGL_RECTANGLE (ix, iy, 1, 1), 1.0,
-                   NULL, &value,
-                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+  gfloat value = gradient_get_shapeburst_dist (rbd, x, y);
 
   value = 1.0 - sin (0.5 * G_PI * value);
 
@@ -511,17 +528,11 @@ gradient_calc_shapeburst_spherical_factor (GeglBuffer *dist_buffer,
 
 
 static gdouble
-gradient_calc_shapeburst_dimpled_factor (GeglBuffer *dist_buffer,
-                                         gdouble     x,
-                                         gdouble     y)
+gradient_calc_shapeburst_dimpled_factor (RenderBlendData *rbd,
+                                         gdouble          x,
+                                         gdouble          y)
 {
-  gint   ix = CLAMP (x, 0.0, gegl_buffer_get_width  (dist_buffer) - 0.7);
-  gint   iy = CLAMP (y, 0.0, gegl_buffer_get_height (dist_buffer) - 0.7);
-  gfloat value;
-
-  gegl_buffer_get (dist_buffer, GEGL_RECTANGLE (ix, iy, 1, 1), 1.0,
-                   NULL, &value,
-                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+  gfloat value = gradient_get_shapeburst_dist (rbd, x, y);
 
   value = cos (0.5 * G_PI * value);
 
@@ -599,7 +610,7 @@ gradient_precalc_shapeburst (GimpImage           *image,
     }
 
   shapeburst = gegl_node_new_child (NULL,
-                                    "operation", "gegl:distance-transform",
+                                    "operation", "gimp:shapeburst",
                                     "normalize", TRUE,
                                     NULL);
 
@@ -666,15 +677,15 @@ gradient_render_pixel (gdouble   x,
       break;
 
     case GIMP_GRADIENT_SHAPEBURST_ANGULAR:
-      factor = gradient_calc_shapeburst_angular_factor (rbd->dist_buffer, x, y);
+      factor = gradient_calc_shapeburst_angular_factor (rbd, x, y);
       break;
 
     case GIMP_GRADIENT_SHAPEBURST_SPHERICAL:
-      factor = gradient_calc_shapeburst_spherical_factor (rbd->dist_buffer, x, y);
+      factor = gradient_calc_shapeburst_spherical_factor (rbd, x, y);
       break;
 
     case GIMP_GRADIENT_SHAPEBURST_DIMPLED:
-      factor = gradient_calc_shapeburst_dimpled_factor (rbd->dist_buffer, x, y);
+      factor = gradient_calc_shapeburst_dimpled_factor (rbd, x, y);
       break;
 
     case GIMP_GRADIENT_SPIRAL_CLOCKWISE:
@@ -733,12 +744,8 @@ gradient_render_pixel (gdouble   x,
     }
   else
     {
-#ifdef USE_GRADIENT_CACHE
-      *color = rbd->gradient_cache[(gint) (factor * (rbd->gradient_cache_size - 1))];
-#else
-      gimp_gradient_get_color_at (rbd->gradient, rbd->context, NULL,
-                                  factor, rbd->reverse, color);
-#endif
+      gimp_gradient_lut_get_color (rbd->gradient_lut, factor, rbd->reverse,
+                                   color);
     }
 }
 
@@ -749,7 +756,7 @@ gradient_put_pixel (gint      x,
                     gpointer  put_pixel_data)
 {
   PutPixelData *ppd  = put_pixel_data;
-  gfloat       *dest = ppd->row_data + 4 * x;
+  gfloat       *dest = ppd->row_data + 4 * (x - ppd->x);
 
   if (ppd->dither_rand)
     {
@@ -770,12 +777,102 @@ gradient_put_pixel (gint      x,
 
   /* Paint whole row if we are on the rightmost pixel */
 
-  if (x == (ppd->width - 1))
-    gegl_buffer_set (ppd->buffer, GEGL_RECTANGLE (0, y, ppd->width, 1),
+  if (x == (ppd->x + ppd->width - 1))
+    gegl_buffer_set (ppd->buffer, GEGL_RECTANGLE (ppd->x, y, ppd->width, 1),
                      0, babl_format ("R'G'B'A float"), ppd->row_data,
                      GEGL_AUTO_ROWSTRIDE);
 }
 
+static void
+gradient_fill_area (const GeglRectangle *area,
+                    FillRegionData      *data)
+{
+  GRand *dither_rand = NULL;
+
+  /*  each area gets its own random sequence, seeded by its position,
+   *  so the result doesn't depend on how the region was split
+   */
+  if (data->dither || data->supersample)
+    dither_rand = g_rand_new_with_seed (data->seed ^
+                                        ((guint32) area->y << 16) ^
+                                        (guint32) area->x);
+
+  if (data->supersample)
+    {
+      PutPixelData ppd;
+
+      ppd.buffer      = data->buffer;
+      ppd.row_data    = g_new (gfloat, 4 * area->width);
+      ppd.x           = area->x;
+      ppd.width       = area->width;
+      ppd.dither_rand = dither_rand;
+
+      gimp_adaptive_supersample_area (area->x,
+                                      area->y,
+                                      area->x + area->width  - 1,
+                                      area->y + area->height - 1,
+                                      data->max_depth, data->threshold,
+                                      gradient_render_pixel, data->rbd,
+                                      gradient_put_pixel, &ppd,
+                                      NULL, NULL);
+
+      g_free (ppd.row_data);
+    }
+  else
+    {
+      GeglBufferIterator *iter;
+      GeglRectangle      *roi;
+
+      iter = gegl_buffer_iterator_new (data->buffer, area, 0,
+                                       babl_format ("R'G'B'A float"),
+                                       GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
+      roi = &iter->roi[0];
+
+      while (gegl_buffer_iterator_next (iter))
+        {
+          gfloat *dest = iter->data[0];
+          gint    endx  = roi->x + roi->width;
+          gint    endy  = roi->y + roi->height;
+          gint    x, y;
+
+          if (dither_rand)
+            {
+              for (y = roi->y; y < endy; y++)
+                for (x = roi->x; x < endx; x++)
+                  {
+                    GimpRGB  color = { 0.0, 0.0, 0.0, 1.0 };
+                    gint     i = g_rand_int (dither_rand);
+
+                    gradient_render_pixel (x, y, &color, data->rbd);
+
+                    *dest++ = color.r + (gdouble) (i & 0xff) / 256.0 / 256.0; i >>= 8;
+                    *dest++ = color.g + (gdouble) (i & 0xff) / 256.0 / 256.0; i >>= 8;
+                    *dest++ = color.b + (gdouble) (i & 0xff) / 256.0 / 256.0; i >>= 8;
+                    *dest++ = color.a + (gdouble) (i & 0xff) / 256.0 / 256.0;
+                  }
+            }
+          else
+            {
+              for (y = roi->y; y < endy; y++)
+                for (x = roi->x; x < endx; x++)
+                  {
+                    GimpRGB  color = { 0.0, 0.0, 0.0, 1.0 };
+
+                    gradient_render_pixel (x, y, &color, data->rbd);
+
+                    *dest++ = color.r;
+                    *dest++ = color.g;
+                    *dest++ = color.b;
+                    *dest++ = color.a;
+                  }
+            }
+        }
+    }
+
+  if (dither_rand)
+    g_rand_free (dither_rand);
+}
+
 static void
 gradient_fill_region (GimpImage           *image,
                       GimpDrawable        *drawable,
@@ -797,36 +894,21 @@ gradient_fill_region (GimpImage           *image,
                       gdouble              ey,
                       GimpProgress        *progress)
 {
-  RenderBlendData rbd = { 0, };
+  RenderBlendData rbd  = { 0, };
+  FillRegionData  data = { 0, };
+  GeglBuffer     *dist_buffer;
+  gint            endy = buffer_region->y + buffer_region->height;
+  gint            y;
 
   GIMP_TIMER_START();
 
-  rbd.gradient = gradient;
-  rbd.context  = context;
-  rbd.reverse  = reverse;
-
-#ifdef USE_GRADIENT_CACHE
-  {
-    gint i;
-
-    rbd.gradient_cache_size = ceil (sqrt (SQR (sx - ex) + SQR (sy - ey)));
-    rbd.gradient_cache      = g_new0 (GimpRGB, rbd.gradient_cache_size);
-
-    for (i = 0; i < rbd.gradient_cache_size; i++)
-      {
-        gdouble factor = (gdouble) i / (gdouble) (rbd.gradient_cache_size - 1);
-
-        gimp_gradient_get_color_at (rbd.gradient, rbd.context, NULL,
-                                    factor, rbd.reverse,
-                                    rbd.gradient_cache + i);
-      }
-  }
-#endif
+  /* The gradient's colors are looked up once, and interpolated per
+   * pixel.  Keep a reference, the table belongs to the gradient.
+   */
+  gradient = g_object_ref (gradient);
 
-  if (gimp_gradient_has_fg_bg_segments (rbd.gradient))
-    rbd.gradient = gimp_gradient_flatten (rbd.gradient, context);
-  else
-    rbd.gradient = g_object_ref (rbd.gradient);
+  rbd.gradient_lut = gimp_gradient_get_lut (gradient, context);
+  rbd.reverse      = reverse;
 
   /* Calculate type-specific parameters */
 
@@ -860,9 +942,22 @@ gradient_fill_region (GimpImage           *image,
     case GIMP_GRADIENT_SHAPEBURST_SPHERICAL:
     case GIMP_GRADIENT_SHAPEBURST_DIMPLED:
       rbd.dist = sqrt (SQR (ex - sx) + SQR (ey - sy));
-      rbd.dist_buffer = gradient_precalc_shapeburst (image, drawable,
-                                                     buffer_region,
-                                                     rbd.dist, progress);
+      dist_buffer = gradient_precalc_shapeburst (image, drawable,
+                                                 buffer_region,
+                                                 rbd.dist, progress);
+
+      /*  the render threads read the distance map directly  */
+      rbd.dist_width  = gegl_buffer_get_width  (dist_buffer);
+      rbd.dist_height = gegl_buffer_get_height (dist_buffer);
+      rbd.dist_data   = g_new (gfloat, rbd.dist_width * rbd.dist_height);
+
+      gegl_buffer_get (dist_buffer,
+                       GEGL_RECTANGLE (0, 0, rbd.dist_width, rbd.dist_height),
+                       1.0, NULL, rbd.dist_data,
+                       GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+      g_object_unref (dist_buffer);
+
       gimp_progress_set_text_literal (progress, _("Blending"));
       break;
 
@@ -879,107 +974,37 @@ gradient_fill_region (GimpImage           *image,
   rbd.gradient_type = gradient_type;
   rbd.repeat        = repeat;
 
-  /* Render the gradient! */
+  data.rbd         = &rbd;
+  data.buffer      = buffer;
+  data.supersample = supersample;
+  data.max_depth   = max_depth;
+  data.threshold   = threshold;
+  data.dither      = dither;
+  data.seed        = g_random_int ();
 
-  if (supersample)
-    {
-      PutPixelData  ppd;
-
-      ppd.buffer      = buffer;
-      ppd.row_data    = g_malloc (sizeof (float) * 4 * buffer_region->width);
-      ppd.width       = buffer_region->width;
-      ppd.dither_rand = g_rand_new ();
-
-      gimp_adaptive_supersample_area (0, 0,
-                                      (buffer_region->width  - 1),
-                                      (buffer_region->height - 1),
-                                      max_depth, threshold,
-                                      gradient_render_pixel, &rbd,
-                                      gradient_put_pixel, &ppd,
-                                      progress ?
-                                      gimp_progress_update_and_flush : NULL,
-                                      progress);
+  /* Render the gradient! */
 
-      g_rand_free (ppd.dither_rand);
-      g_free (ppd.row_data);
-    }
-  else
+  for (y = buffer_region->y; y < endy; y += PROGRESS_CHUNK_HEIGHT)
     {
-      GeglBufferIterator *iter;
-      GeglRectangle      *roi;
-      gint                total = buffer_region->width * buffer_region->height;
-      gint                done  = 0;
-
-      iter = gegl_buffer_iterator_new (buffer, buffer_region, 0,
-                                       babl_format ("R'G'B'A float"),
-                                       GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
-      roi = &iter->roi[0];
-
-      if (dither)
-        rbd.seed = g_rand_new ();
-
-      while (gegl_buffer_iterator_next (iter))
-        {
-          gfloat *dest = iter->data[0];
-          gint    endx  = roi->x + roi->width;
-          gint    endy  = roi->y + roi->height;
-          gint    x, y;
+      GeglRectangle chunk = *buffer_region;
 
-          if (rbd.seed)
-            {
-              GRand *dither_rand = g_rand_new_with_seed (g_rand_int (rbd.seed));
-
-              for (y = roi->y; y < endy; y++)
-                for (x = roi->x; x < endx; x++)
-                  {
-                    GimpRGB  color = { 0.0, 0.0, 0.0, 1.0 };
-                    gint     i = g_rand_int (dither_rand);
-
-                    gradient_render_pixel (x, y, &color, &rbd);
-
-                    *dest++ = color.r + (gdouble) (i & 0xff) / 256.0 / 256.0; i >>= 8;
-                    *dest++ = color.g + (gdouble) (i & 0xff) / 256.0 / 256.0; i >>= 8;
-                    *dest++ = color.b + (gdouble) (i & 0xff) / 256.0 / 256.0; i >>= 8;
-                    *dest++ = color.a + (gdouble) (i & 0xff) / 256.0 / 256.0;
-                  }
-
-              g_rand_free (dither_rand);
-            }
-          else
-            {
-              for (y = roi->y; y < endy; y++)
-                for (x = roi->x; x < endx; x++)
-                  {
-                    GimpRGB  color = { 0.0, 0.0, 0.0, 1.0 };
+      chunk.y      = y;
+      chunk.height = MIN (PROGRESS_CHUNK_HEIGHT, endy - y);
 
-                    gradient_render_pixel (x, y, &color, &rbd);
+      gimp_parallel_distribute_area (&chunk, MIN_PARALLEL_SUB_AREA,
+                                     (GimpParallelDistributeAreaFunc)
+                                     gradient_fill_area,
+                                     &data);
 
-                    *dest++ = color.r;
-                    *dest++ = color.g;
-                    *dest++ = color.b;
-                    *dest++ = color.a;
-                  }
-            }
-
-          done += roi->width * roi->height;
-
-          if (progress)
-            gimp_progress_set_value (progress,
-                                     (gdouble) done / (gdouble) total);
-        }
-
-      if (dither)
-        g_rand_free (rbd.seed);
+      if (progress)
+        gimp_progress_set_value (progress,
+                                 (gdouble) (y + chunk.height -
+                                            buffer_region->y) /
+                                 (gdouble) buffer_region->height);
     }
 
-#ifdef USE_GRADIENT_CACHE
-  g_free (rbd.gradient_cache);
-#endif
-
-  g_object_unref (rbd.gradient);
-
-  if (rbd.dist_buffer)
-    g_object_unref (rbd.dist_buffer);
+  g_object_unref (gradient);
+  g_free (rbd.dist_data);
 
   GIMP_TIMER_END("gradient_fill_region");
 }
@@ -117,8 +117,9 @@ gimp_drawable_bucket_fill_internal (GimpDrawable        *drawable,
 {
   GimpImage    *image;
   GimpPickable *pickable;
-  GeglBuffer   *buffer;
+  GeglBuffer   *buffer = NULL;
   GeglBuffer   *mask_buffer;
+  const Babl   *format;
   gint          x1, y1, x2, y2;
   gint          mask_offset_x = 0;
   gint          mask_offset_y = 0;
@@ -205,8 +206,7 @@ gimp_drawable_bucket_fill_internal (GimpDrawable        *drawable,
       mask_offset_y = y1;
     }
 
-  buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0, x2 - x1, y2 - y1),
-                            gimp_drawable_get_format_with_alpha (drawable));
+  format = gimp_drawable_get_format_with_alpha (drawable);
 
   switch (fill_type)
     {
@@ -217,18 +217,21 @@ gimp_drawable_bucket_fill_internal (GimpDrawable        *drawable,
       {
         GeglColor *gegl_color = gimp_gegl_color_new (color);
 
+        buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0, x2 - x1, y2 - y1),
+                                  format);
+
         gegl_buffer_set_color (buffer, NULL, gegl_color);
         g_object_unref (gegl_color);
       }
       break;
 
     case GIMP_FILL_PATTERN:
-      {
-        GeglBuffer *pattern_buffer = gimp_pattern_create_buffer (pattern);
-
-        gegl_buffer_set_pattern (buffer, NULL, pattern_buffer, -x1, -y1);
-        g_object_unref (pattern_buffer);
-      }
+      /*  the pattern is filled into the buffer's tiles as they are read  */
+      buffer = gimp_pattern_create_tiled_buffer (pattern,
+                                                 GEGL_RECTANGLE (0, 0,
+                                                                 x2 - x1,
+                                                                 y2 - y1),
+                                                 format, -x1, -y1);
       break;
     }
 
@@ -26,6 +26,7 @@
 
 #include "gegl/gimpapplicator.h"
 #include "gegl/gimp-gegl-apply-operation.h"
+#include "gegl/gimp-gegl-utils.h"
 
 #include "gimp-utils.h"
 #include "gimpdrawable.h"
@@ -89,6 +90,21 @@ gimp_drawable_merge_filter (GimpDrawable *drawable,
                             GimpProgress *progress,
                             const gchar  *undo_desc,
                             gboolean      cancellable)
+{
+  return gimp_drawable_merge_filter_area (drawable, filter, NULL,
+                                          progress, undo_desc, cancellable);
+}
+
+/*  like gimp_drawable_merge_filter(), but only merges the part of the
+ *  filter that is inside @area, and only pushes undo for that part
+ */
+gboolean
+gimp_drawable_merge_filter_area (GimpDrawable        *drawable,
+                                 GimpFilter          *filter,
+                                 const GeglRectangle *area,
+                                 GimpProgress        *progress,
+                                 const gchar         *undo_desc,
+                                 gboolean             cancellable)
 {
   GeglRectangle rect;
   gboolean      success = TRUE;
@@ -99,25 +115,27 @@ gimp_drawable_merge_filter (GimpDrawable *drawable,
 
   if (gimp_item_mask_intersect (GIMP_ITEM (drawable),
                                 &rect.x, &rect.y,
-                                &rect.width, &rect.height))
+                                &rect.width, &rect.height) &&
+      (! area || gegl_rectangle_intersect (&rect, &rect, area)))
     {
       GimpImage      *image = gimp_item_get_image (GIMP_ITEM (drawable));
-      GeglBuffer     *undo_buffer;
+      GeglBuffer     *undo_buffer  = NULL;
       GimpApplicator *applicator;
       GeglBuffer     *apply_buffer = NULL;
       GeglBuffer     *cache        = NULL;
       GeglRectangle  *rects        = NULL;
       gint            n_rects      = 0;
+      gboolean        push_undo;
 
-      undo_buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0,
-                                                     rect.width, rect.height),
-                                     gimp_drawable_get_format (drawable));
+      push_undo = gimp_image_undo_is_enabled (image);
 
-      gegl_buffer_copy (gimp_drawable_get_buffer (drawable),
-                        GEGL_RECTANGLE (rect.x, rect.y,
-                                        rect.width, rect.height),
-                        undo_buffer,
-                        GEGL_RECTANGLE (0, 0, 0, 0));
+      /*  without undo, the original pixels are only needed to restore
+       *  them on cancel
+       */
+      if (push_undo || cancellable)
+        undo_buffer =
+          gimp_gegl_buffer_dup_area (gimp_drawable_get_buffer (drawable),
+                                     &rect);
 
       applicator = gimp_filter_get_applicator (filter);
 
@@ -125,9 +143,11 @@ gimp_drawable_merge_filter (GimpDrawable *drawable,
         {
           /*  the apply_buffer will make a copy of the region that is
            *  actually processed in gimp_gegl_apply_cached_operation()
-           *  below.
+           *  below, it is only needed for fading the undo step.
            */
-          apply_buffer = gimp_applicator_dup_apply_buffer (applicator, &rect);
+          if (push_undo)
+            apply_buffer = gimp_applicator_dup_apply_buffer (applicator,
+                                                             &rect);
 
           /*  the cache and its valid rectangles are the region that
            *  has already been processed by this applicator.
@@ -135,7 +155,7 @@ gimp_drawable_merge_filter (GimpDrawable *drawable,
           cache = gimp_applicator_get_cache_buffer (applicator,
                                                     &rects, &n_rects);
 
-          if (cache)
+          if (cache && apply_buffer)
             {
               gint i;
 
@@ -195,15 +215,17 @@ gimp_drawable_merge_filter (GimpDrawable *drawable,
         {
           /*  canceled by the user  */
 
-          gegl_buffer_copy (undo_buffer,
-                            GEGL_RECTANGLE (0, 0, rect.width, rect.height),
-                            gimp_drawable_get_buffer (drawable),
-                            GEGL_RECTANGLE (rect.x, rect.y, 0, 0));
+          if (undo_buffer)
+            gegl_buffer_copy (undo_buffer,
+                              GEGL_RECTANGLE (0, 0, rect.width, rect.height),
+                              gimp_drawable_get_buffer (drawable),
+                              GEGL_RECTANGLE (rect.x, rect.y, 0, 0));
 
           success = FALSE;
         }
 
-      g_object_unref (undo_buffer);
+      if (undo_buffer)
+        g_object_unref (undo_buffer);
 
       if (apply_buffer)
         g_object_unref (apply_buffer);
@@ -21,21 +21,27 @@
 #define __GIMP_DRAWABLE_FILTER_H__
 
 
-GimpContainer * gimp_drawable_get_filters   (GimpDrawable *drawable);
-
-void            gimp_drawable_add_filter    (GimpDrawable *drawable,
-                                             GimpFilter   *filter);
-void            gimp_drawable_remove_filter (GimpDrawable *drawable,
-                                             GimpFilter   *filter);
-
-gboolean        gimp_drawable_has_filter    (GimpDrawable *drawable,
-                                             GimpFilter   *filter);
-
-gboolean        gimp_drawable_merge_filter  (GimpDrawable *drawable,
-                                             GimpFilter   *filter,
-                                             GimpProgress *progress,
-                                             const gchar  *undo_desc,
-                                             gboolean      cancellable);
+GimpContainer * gimp_drawable_get_filters       (GimpDrawable        *drawable);
+
+void            gimp_drawable_add_filter        (GimpDrawable        *drawable,
+                                                 GimpFilter          *filter);
+void            gimp_drawable_remove_filter     (GimpDrawable        *drawable,
+                                                 GimpFilter          *filter);
+
+gboolean        gimp_drawable_has_filter        (GimpDrawable        *drawable,
+                                                 GimpFilter          *filter);
+
+gboolean        gimp_drawable_merge_filter      (GimpDrawable        *drawable,
+                                                 GimpFilter          *filter,
+                                                 GimpProgress        *progress,
+                                                 const gchar         *undo_desc,
+                                                 gboolean             cancellable);
+gboolean        gimp_drawable_merge_filter_area (GimpDrawable        *drawable,
+                                                 GimpFilter          *filter,
+                                                 const GeglRectangle *area,
+                                                 GimpProgress        *progress,
+                                                 const gchar         *undo_desc,
+                                                 gboolean             cancellable);
 
 
 #endif /* __GIMP_DRAWABLE_FILTER_H__ */
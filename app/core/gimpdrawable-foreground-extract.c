@@ -22,6 +22,7 @@
 #include <gdk-pixbuf/gdk-pixbuf.h>
 
 #include "libgimpbase/gimpbase.h"
+#include "libgimpmath/gimpmath.h"
 
 #include "core-types.h"
 
@@ -36,6 +37,20 @@
 #include "gimp-intl.h"
 
 
+/*  the matting engines need some known pixels around the unknown band  */
+#define BAND_MARGIN         32
+
+/*  the preview solves the band at a size of at most this many pixels  */
+#define PREVIEW_MAX_PIXELS  (1024 * 1024)
+
+/*  same thresholds as the matting operations use  */
+#define IS_UNKNOWN(v)       ((v) > 0.01f && (v) < 0.99f)
+
+
+static gboolean   gimp_foreground_extract_band (GeglBuffer    *trimap,
+                                                GeglRectangle *band);
+
+
 /*  public functions  */
 
 GeglBuffer *
@@ -47,24 +62,92 @@ gimp_drawable_foreground_extract (GimpDrawable      *drawable,
                                   GeglBuffer        *trimap,
                                   GimpProgress      *progress)
 {
-  GeglBuffer    *drawable_buffer;
+  GeglBuffer *buffer;
+
+  g_return_val_if_fail (GIMP_IS_DRAWABLE (drawable), NULL);
+  g_return_val_if_fail (GEGL_IS_BUFFER (trimap), NULL);
+  g_return_val_if_fail (progress == NULL || GIMP_IS_PROGRESS (progress), NULL);
+
+  progress = gimp_progress_start (progress, FALSE,
+                                  _("Computing alpha of unknown pixels"));
+
+  buffer = gimp_foreground_extract_buffer (gimp_drawable_get_buffer (drawable),
+                                           engine,
+                                           global_iterations,
+                                           levin_levels,
+                                           levin_active_levels,
+                                           trimap,
+                                           FALSE, NULL, NULL, progress);
+
+  if (progress)
+    gimp_progress_end (progress);
+
+  return buffer;
+}
+
+/*  Computes the matte for @trimap. Only the unknown band of the trimap
+ *  (plus a margin of known pixels) is fed to the matting operation,
+ *  everything else is taken from the trimap as is. With @preview, the
+ *  band is solved at a reduced size and scaled back up, @reduced tells
+ *  whether that was actually necessary.
+ *
+ *  This doesn't touch any GimpObject, so it can be called from a
+ *  worker thread on buffers that aren't changed meanwhile. Returns
+ *  NULL if @cancellable was cancelled.
+ */
+GeglBuffer *
+gimp_foreground_extract_buffer (GeglBuffer        *buffer,
+                                GimpMattingEngine  engine,
+                                gint               global_iterations,
+                                gint               levin_levels,
+                                gint               levin_active_levels,
+                                GeglBuffer        *trimap,
+                                gboolean           preview,
+                                gboolean          *reduced,
+                                GCancellable      *cancellable,
+                                GimpProgress      *progress)
+{
   GeglNode      *gegl;
   GeglNode      *input_node;
   GeglNode      *trimap_node;
   GeglNode      *matting_node;
   GeglNode      *output_node;
-  GeglBuffer    *buffer;
+  GeglBuffer    *result;
   GeglProcessor *processor;
+  GeglRectangle  band;
+  gdouble        scale = 1.0;
   gdouble        value;
 
-  g_return_val_if_fail (GIMP_IS_DRAWABLE (drawable), NULL);
+  g_return_val_if_fail (GEGL_IS_BUFFER (buffer), NULL);
   g_return_val_if_fail (GEGL_IS_BUFFER (trimap), NULL);
+  g_return_val_if_fail (cancellable == NULL ||
+                        G_IS_CANCELLABLE (cancellable), NULL);
   g_return_val_if_fail (progress == NULL || GIMP_IS_PROGRESS (progress), NULL);
 
-  progress = gimp_progress_start (progress, FALSE,
-                                  _("Computing alpha of unknown pixels"));
+  if (reduced)
+    *reduced = FALSE;
+
+  result = gegl_buffer_new (gegl_buffer_get_extent (trimap),
+                            babl_format ("Y float"));
 
-  drawable_buffer = gimp_drawable_get_buffer (drawable);
+  gegl_buffer_copy (trimap, NULL, result, NULL);
+
+  if (! gimp_foreground_extract_band (trimap, &band))
+    return result;
+
+  gegl_rectangle_intersect (&band, &band, gegl_buffer_get_extent (buffer));
+
+  if (gegl_rectangle_is_empty (&band))
+    return result;
+
+  if (preview && band.width * band.height > PREVIEW_MAX_PIXELS)
+    {
+      scale = sqrt ((gdouble) PREVIEW_MAX_PIXELS /
+                    (gdouble) (band.width * band.height));
+
+      if (reduced)
+        *reduced = TRUE;
+    }
 
   gegl = gegl_node_new ();
 
@@ -72,15 +155,49 @@ gimp_drawable_foreground_extract (GimpDrawable      *drawable,
                                      "operation", "gegl:buffer-source",
                                      "buffer",    trimap,
                                      NULL);
+  trimap_node = gegl_node_new_child (gegl,
+                                     "operation", "gegl:crop",
+                                     "x",         (gdouble) band.x,
+                                     "y",         (gdouble) band.y,
+                                     "width",     (gdouble) band.width,
+                                     "height",    (gdouble) band.height,
+                                     "input",     trimap_node,
+                                     NULL);
   input_node = gegl_node_new_child (gegl,
                                     "operation", "gegl:buffer-source",
-                                    "buffer",    drawable_buffer,
+                                    "buffer",    buffer,
                                     NULL);
-  output_node = gegl_node_new_child (gegl,
-                                     "operation", "gegl:buffer-sink",
-                                     "buffer",    &buffer,
-                                     "format",    NULL,
-                                     NULL);
+  input_node = gegl_node_new_child (gegl,
+                                    "operation", "gegl:crop",
+                                    "x",         (gdouble) band.x,
+                                    "y",         (gdouble) band.y,
+                                    "width",     (gdouble) band.width,
+                                    "height",    (gdouble) band.height,
+                                    "input",     input_node,
+                                    NULL);
+
+  if (scale < 1.0)
+    {
+      /*  nearest neighbor keeps the trimap's three levels intact  */
+      trimap_node = gegl_node_new_child (gegl,
+                                         "operation", "gegl:scale-ratio",
+                                         "origin-x",  0.0,
+                                         "origin-y",  0.0,
+                                         "sampler",   GEGL_SAMPLER_NEAREST,
+                                         "x",         scale,
+                                         "y",         scale,
+                                         "input",     trimap_node,
+                                         NULL);
+      input_node = gegl_node_new_child (gegl,
+                                        "operation", "gegl:scale-ratio",
+                                        "origin-x",  0.0,
+                                        "origin-y",  0.0,
+                                        "sampler",   GEGL_SAMPLER_LINEAR,
+                                        "x",         scale,
+                                        "y",         scale,
+                                        "input",     input_node,
+                                        NULL);
+    }
 
   if (engine == GIMP_MATTING_ENGINE_GLOBAL)
     {
@@ -102,23 +219,101 @@ gimp_drawable_foreground_extract (GimpDrawable      *drawable,
                         matting_node, "input");
   gegl_node_connect_to (trimap_node,  "output",
                         matting_node, "aux");
-  gegl_node_connect_to (matting_node, "output",
-                        output_node,  "input");
 
-  processor = gegl_node_new_processor (output_node, NULL);
+  output_node = matting_node;
+
+  if (scale < 1.0)
+    {
+      output_node = gegl_node_new_child (gegl,
+                                         "operation", "gegl:scale-ratio",
+                                         "origin-x",  0.0,
+                                         "origin-y",  0.0,
+                                         "sampler",   GEGL_SAMPLER_LINEAR,
+                                         "x",         1.0 / scale,
+                                         "y",         1.0 / scale,
+                                         "input",     output_node,
+                                         NULL);
+    }
+
+  output_node = gegl_node_new_child (gegl,
+                                     "operation", "gegl:write-buffer",
+                                     "buffer",    result,
+                                     "input",     output_node,
+                                     NULL);
+
+  processor = gegl_node_new_processor (output_node, &band);
 
   while (gegl_processor_work (processor, &value))
     {
+      if (cancellable && g_cancellable_is_cancelled (cancellable))
+        break;
+
       if (progress)
         gimp_progress_set_value (progress, value);
     }
 
-  if (progress)
-    gimp_progress_end (progress);
-
   g_object_unref (processor);
 
   g_object_unref (gegl);
 
-  return buffer;
+  if (cancellable && g_cancellable_is_cancelled (cancellable))
+    {
+      g_object_unref (result);
+
+      return NULL;
+    }
+
+  return result;
+}
+
+
+/*  private functions  */
+
+/*  finds the bounds of the trimap's unknown pixels, grown by the margin  */
+static gboolean
+gimp_foreground_extract_band (GeglBuffer    *trimap,
+                              GeglRectangle *band)
+{
+  const GeglRectangle *extent = gegl_buffer_get_extent (trimap);
+  GeglBufferIterator  *iter;
+  gint                 x1 = G_MAXINT;
+  gint                 y1 = G_MAXINT;
+  gint                 x2 = G_MININT;
+  gint                 y2 = G_MININT;
+
+  iter = gegl_buffer_iterator_new (trimap, NULL, 0, babl_format ("Y float"),
+                                   GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
+
+  while (gegl_buffer_iterator_next (iter))
+    {
+      const GeglRectangle *roi  = &iter->roi[0];
+      const gfloat        *data = iter->data[0];
+      gint                 x, y;
+
+      for (y = roi->y; y < roi->y + roi->height; y++)
+        {
+          for (x = roi->x; x < roi->x + roi->width; x++, data++)
+            {
+              if (IS_UNKNOWN (*data))
+                {
+                  x1 = MIN (x1, x);
+                  x2 = MAX (x2, x + 1);
+                  y1 = MIN (y1, y);
+                  y2 = MAX (y2, y + 1);
+                }
+            }
+        }
+    }
+
+  if (x1 >= x2 || y1 >= y2)
+    return FALSE;
+
+  band->x      = x1 - BAND_MARGIN;
+  band->y      = y1 - BAND_MARGIN;
+  band->width  = x2 - x1 + 2 * BAND_MARGIN;
+  band->height = y2 - y1 + 2 * BAND_MARGIN;
+
+  gegl_rectangle_intersect (band, band, extent);
+
+  return TRUE;
 }
@@ -27,5 +27,16 @@ GeglBuffer * gimp_drawable_foreground_extract (GimpDrawable       *drawable,
                                                GeglBuffer         *trimap,
                                                GimpProgress       *progress);
 
+GeglBuffer * gimp_foreground_extract_buffer   (GeglBuffer         *buffer,
+                                               GimpMattingEngine   engine,
+                                               gint                global_iterations,
+                                               gint                levin_levels,
+                                               gint                levin_active_levels,
+                                               GeglBuffer         *trimap,
+                                               gboolean            preview,
+                                               gboolean           *reduced,
+                                               GCancellable       *cancellable,
+                                               GimpProgress       *progress);
+
 
 #endif  /*  __GIMP_DRAWABLE_FOREGROUND_EXTRACT_H__  */
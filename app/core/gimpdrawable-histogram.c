@@ -121,3 +121,57 @@ gimp_drawable_calculate_histogram (GimpDrawable  *drawable,
         }
     }
 }
+
+/**
+ * gimp_drawable_calculate_histogram_area:
+ * @drawable:  a #GimpDrawable
+ * @histogram: a #GimpHistogram previously calculated from @drawable
+ * @area:      the area of @drawable that changed, in drawable coordinates
+ *
+ * Updates @histogram after @area of @drawable changed. For an
+ * incremental @histogram, only the parts of @area are binned again,
+ * see gimp_histogram_calculate_area().
+ **/
+void
+gimp_drawable_calculate_histogram_area (GimpDrawable        *drawable,
+                                        GimpHistogram       *histogram,
+                                        const GeglRectangle *area)
+{
+  GimpImage   *image;
+  GimpChannel *mask;
+  gint         x, y, width, height;
+
+  g_return_if_fail (GIMP_IS_DRAWABLE (drawable));
+  g_return_if_fail (gimp_item_is_attached (GIMP_ITEM (drawable)));
+  g_return_if_fail (histogram != NULL);
+  g_return_if_fail (area != NULL);
+
+  if (! gimp_item_mask_intersect (GIMP_ITEM (drawable), &x, &y, &width, &height))
+    return;
+
+  image = gimp_item_get_image (GIMP_ITEM (drawable));
+  mask  = gimp_image_get_mask (image);
+
+  if (! gimp_channel_is_empty (mask))
+    {
+      gint off_x, off_y;
+
+      gimp_item_get_offset (GIMP_ITEM (drawable), &off_x, &off_y);
+
+      gimp_histogram_calculate_area (histogram,
+                                     gimp_drawable_get_buffer (drawable),
+                                     GEGL_RECTANGLE (x, y, width, height),
+                                     gimp_drawable_get_buffer (GIMP_DRAWABLE (mask)),
+                                     GEGL_RECTANGLE (x + off_x, y + off_y,
+                                                     width, height),
+                                     area);
+    }
+  else
+    {
+      gimp_histogram_calculate_area (histogram,
+                                     gimp_drawable_get_buffer (drawable),
+                                     GEGL_RECTANGLE (x, y, width, height),
+                                     NULL, NULL,
+                                     area);
+    }
+}
@@ -21,8 +21,11 @@
 #define __GIMP_DRAWABLE_HISTOGRAM_H__
 
 
-void   gimp_drawable_calculate_histogram (GimpDrawable  *drawable,
-                                          GimpHistogram *histogram);
+void   gimp_drawable_calculate_histogram      (GimpDrawable        *drawable,
+                                               GimpHistogram       *histogram);
+void   gimp_drawable_calculate_histogram_area (GimpDrawable        *drawable,
+                                               GimpHistogram       *histogram,
+                                               const GeglRectangle *area);
 
 
 #endif /* __GIMP_HISTOGRAM_H__ */
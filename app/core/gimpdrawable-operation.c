@@ -24,14 +24,18 @@
 
 #include <gdk-pixbuf/gdk-pixbuf.h>
 #include <gegl.h>
+#include <gegl-plugin.h> /* GEGL_IS_OPERATION_POINT_FILTER() */
 
 #include "core-types.h"
 
 #include "gegl/gimp-gegl-apply-operation.h"
 
+#include "gimpchannel.h"
 #include "gimpdrawable.h"
 #include "gimpdrawable-operation.h"
 #include "gimpdrawable-shadow.h"
+#include "gimpimage.h"
+#include "gimpimage-undo.h"
 #include "gimpprogress.h"
 #include "gimpsettings.h"
 
@@ -58,6 +62,25 @@ gimp_drawable_apply_operation (GimpDrawable *drawable,
                                   &rect.width, &rect.height))
     return;
 
+  if (gimp_drawable_can_apply_in_place (drawable, operation))
+    {
+      /*  nothing needs the original pixels, skip the shadow buffer  */
+      gimp_gegl_apply_operation (gimp_drawable_get_buffer (drawable),
+                                 progress, undo_desc,
+                                 operation,
+                                 gimp_drawable_get_buffer (drawable), &rect);
+
+      gimp_drawable_push_undo (drawable, undo_desc, NULL,
+                               rect.x, rect.y, rect.width, rect.height);
+
+      gimp_drawable_update (drawable, rect.x, rect.y, rect.width, rect.height);
+
+      if (progress)
+        gimp_progress_end (progress);
+
+      return;
+    }
+
   dest_buffer = gimp_drawable_get_shadow_buffer (drawable);
 
   gimp_gegl_apply_operation (gimp_drawable_get_buffer (drawable),
@@ -103,3 +126,29 @@ gimp_drawable_apply_operation_by_name (GimpDrawable *drawable,
 
   g_object_unref (node);
 }
+
+/*  Returns whether @operation can be applied to @drawable directly,
+ *  instead of through its shadow buffer: there must be no undo to
+ *  keep the original pixels for, no selection and no locked components
+ *  to combine the result with, and @operation must only look at the
+ *  pixel it writes.
+ */
+gboolean
+gimp_drawable_can_apply_in_place (GimpDrawable *drawable,
+                                  GeglNode     *operation)
+{
+  GimpImage     *image;
+  GeglOperation *op;
+
+  g_return_val_if_fail (GIMP_IS_DRAWABLE (drawable), FALSE);
+  g_return_val_if_fail (GEGL_IS_NODE (operation), FALSE);
+
+  image = gimp_item_get_image (GIMP_ITEM (drawable));
+  op    = gegl_node_get_gegl_operation (operation);
+
+  return (! gimp_image_undo_is_enabled (image)                       &&
+          gimp_channel_is_empty (gimp_image_get_mask (image))        &&
+          gimp_drawable_get_active_mask (drawable) ==
+          GIMP_COMPONENT_MASK_ALL                                    &&
+          op && GEGL_IS_OPERATION_POINT_FILTER (op));
+}
@@ -22,6 +22,7 @@
 #include <gdk-pixbuf/gdk-pixbuf.h>
 #include <gegl.h>
 
+#include "libgimpbase/gimpbase.h"
 #include "libgimpmath/gimpmath.h"
 
 #include "core-types.h"
@@ -29,6 +30,8 @@
 #include "config/gimpcoreconfig.h"
 
 #include "gimp.h"
+#include "gimp-memsize.h"
+#include "gimp-priorities.h"
 #include "gimpchannel.h"
 #include "gimpimage.h"
 #include "gimpdrawable-preview.h"
@@ -37,6 +40,70 @@
 #include "gimptempbuf.h"
 
 
+/*  the preview levels are validated in tiles of this size  */
+#define PREVIEW_TILE_SIZE 64
+
+/*  asynchronous previews are computed by a small pool of threads  */
+#define PREVIEW_MAX_THREADS 4
+
+
+typedef struct _GimpPreviewJob     GimpPreviewJob;
+typedef struct _GimpPreviewJobTask GimpPreviewJobTask;
+
+struct _GimpPreviewJob
+{
+  GimpDrawable  *drawable;
+  GeglRectangle  src_rect;
+  gint           dest_width;
+  gint           dest_height;
+  gint           priority;
+  guint          serial;
+
+  GeglBuffer    *buffer;       /*  a snapshot of the drawable's buffer  */
+  const Babl    *format;
+
+  GList         *tasks;
+  gint           n_tasks;      /*  atomic  */
+  gint           n_cancelled;  /*  atomic  */
+
+  GimpTempBuf   *preview;
+};
+
+struct _GimpPreviewJobTask
+{
+  GTask  *task;
+  gulong  cancelled_id;
+};
+
+
+static GeglBuffer * gimp_drawable_preview_get_level  (GimpDrawable        *drawable,
+                                                      gint                 level,
+                                                      const GeglRectangle *rect);
+static void         gimp_drawable_preview_free_level (GimpDrawable        *drawable,
+                                                      gint                 level);
+
+static guint        gimp_preview_job_hash            (const GimpPreviewJob *job);
+static gboolean     gimp_preview_job_equal           (const GimpPreviewJob *job1,
+                                                      const GimpPreviewJob *job2);
+static void         gimp_preview_job_add_task        (GimpPreviewJob      *job,
+                                                      GTask               *task);
+static void         gimp_preview_job_cancelled       (GCancellable        *cancellable,
+                                                      GimpPreviewJob      *job);
+static void         gimp_preview_job_invalidated     (GimpDrawable        *drawable,
+                                                      GimpPreviewJob      *job);
+static gint         gimp_preview_job_compare         (const GimpPreviewJob *job1,
+                                                      const GimpPreviewJob *job2,
+                                                      gpointer             data);
+static void         gimp_preview_job_func            (GimpPreviewJob      *job,
+                                                      gpointer             data);
+static gboolean     gimp_preview_job_idle            (GimpPreviewJob      *job);
+
+
+static GThreadPool *preview_pool   = NULL;
+static GHashTable  *preview_jobs   = NULL;
+static guint        preview_serial = 0;
+
+
 /*  public functions  */
 
 GimpTempBuf *
@@ -124,6 +191,31 @@ gimp_drawable_get_sub_preview (GimpDrawable *drawable,
   scale = MIN ((gdouble) dest_width  / (gdouble) gegl_buffer_get_width  (buffer),
                (gdouble) dest_height / (gdouble) gegl_buffer_get_height (buffer));
 
+  /*  sample from the smallest mipmap level which is still at least as
+   *  large as the preview, instead of scaling down all of the drawable
+   */
+  if (scale <= 0.5)
+    {
+      GeglRectangle rect;
+      gint          level = 0;
+
+      while (level + 1 < GIMP_DRAWABLE_PREVIEW_LEVELS &&
+             scale * (1 << (level + 2)) <= 1.0)
+        level++;
+
+      scale *= 1 << (level + 1);
+
+      /*  the area the preview is sampled from, in level coordinates,
+       *  with a pixel of slack for the resampling
+       */
+      rect.x      = floor (src_x / scale) - 1;
+      rect.y      = floor (src_y / scale) - 1;
+      rect.width  = ceil ((src_x + dest_width)  / scale) - rect.x + 2;
+      rect.height = ceil ((src_y + dest_height) / scale) - rect.y + 2;
+
+      buffer = gimp_drawable_preview_get_level (drawable, level, &rect);
+    }
+
   gegl_buffer_get (buffer,
                    GEGL_RECTANGLE (src_x, src_y, dest_width, dest_height),
                    scale,
@@ -133,3 +225,512 @@ gimp_drawable_get_sub_preview (GimpDrawable *drawable,
 
   return preview;
 }
+
+/**
+ * gimp_drawable_get_sub_preview_async:
+ * @drawable:    a #GimpDrawable
+ * @src_x:       the area of @drawable to preview
+ * @src_y:
+ * @src_width:
+ * @src_height:
+ * @dest_width:  the size of the preview
+ * @dest_height:
+ * @priority:    the priority of the request, lower values run first
+ * @cancellable: optional #GCancellable object, %NULL to ignore
+ * @callback:    a #GAsyncReadyCallback to call when the preview is ready
+ * @user_data:   the data to pass to callback function
+ *
+ * Like gimp_drawable_get_sub_preview(), but the preview is computed
+ * in a thread, from a snapshot of the drawable's buffer taken now.
+ * Among requests of the same @priority the most recent one runs
+ * first, it is the one most likely still visible.
+ *
+ * A request for a preview which is already pending for the same
+ * area and size shares its result, unless the drawable's preview
+ * was invalidated in between.
+ *
+ * @callback is called in the main thread, call
+ * gimp_drawable_get_sub_preview_finish() from it to get the preview.
+ **/
+void
+gimp_drawable_get_sub_preview_async (GimpDrawable        *drawable,
+                                     gint                 src_x,
+                                     gint                 src_y,
+                                     gint                 src_width,
+                                     gint                 src_height,
+                                     gint                 dest_width,
+                                     gint                 dest_height,
+                                     gint                 priority,
+                                     GCancellable        *cancellable,
+                                     GAsyncReadyCallback  callback,
+                                     gpointer             user_data)
+{
+  GimpItem       *item;
+  GimpImage      *image;
+  GimpPreviewJob  key;
+  GimpPreviewJob *job;
+  GTask          *task;
+
+  g_return_if_fail (GIMP_IS_DRAWABLE (drawable));
+  g_return_if_fail (src_x >= 0);
+  g_return_if_fail (src_y >= 0);
+  g_return_if_fail (src_width  > 0);
+  g_return_if_fail (src_height > 0);
+  g_return_if_fail (dest_width  > 0);
+  g_return_if_fail (dest_height > 0);
+  g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+  item = GIMP_ITEM (drawable);
+
+  g_return_if_fail ((src_x + src_width)  <= gimp_item_get_width  (item));
+  g_return_if_fail ((src_y + src_height) <= gimp_item_get_height (item));
+
+  image = gimp_item_get_image (item);
+
+  task = g_task_new (drawable, cancellable, callback, user_data);
+  g_task_set_source_tag (task, gimp_drawable_get_sub_preview_async);
+  g_task_set_priority (task, priority);
+
+  if (! image->gimp->config->layer_previews)
+    {
+      g_task_return_pointer (task, NULL, NULL);
+      g_object_unref (task);
+      return;
+    }
+
+  if (! preview_pool)
+    {
+      preview_pool = g_thread_pool_new ((GFunc) gimp_preview_job_func, NULL,
+                                        CLAMP (g_get_num_processors (),
+                                               1, PREVIEW_MAX_THREADS),
+                                        FALSE, NULL);
+
+      g_thread_pool_set_sort_function (preview_pool,
+                                       (GCompareDataFunc) gimp_preview_job_compare,
+                                       NULL);
+
+      preview_jobs = g_hash_table_new ((GHashFunc)  gimp_preview_job_hash,
+                                       (GEqualFunc) gimp_preview_job_equal);
+    }
+
+  key.drawable    = drawable;
+  key.src_rect    = *GEGL_RECTANGLE (src_x, src_y, src_width, src_height);
+  key.dest_width  = dest_width;
+  key.dest_height = dest_height;
+
+  job = g_hash_table_lookup (preview_jobs, &key);
+
+  if (job)
+    {
+      gimp_preview_job_add_task (job, task);
+      return;
+    }
+
+  job = g_slice_new0 (GimpPreviewJob);
+
+  job->drawable    = g_object_ref (drawable);
+  job->src_rect    = key.src_rect;
+  job->dest_width  = dest_width;
+  job->dest_height = dest_height;
+  job->priority    = priority;
+  job->serial      = preview_serial++;
+
+  /*  the copy shares the drawable's tiles until either is written  */
+  job->buffer = gegl_buffer_dup (gimp_drawable_get_buffer (drawable));
+  job->format = gimp_drawable_get_preview_format (drawable);
+
+  g_hash_table_add (preview_jobs, job);
+
+  /*  later requests must not get a preview of the old contents  */
+  g_signal_connect (drawable, "invalidate-preview",
+                    G_CALLBACK (gimp_preview_job_invalidated),
+                    job);
+
+  /*  add the first task before the job can be picked up  */
+  gimp_preview_job_add_task (job, task);
+
+  g_thread_pool_push (preview_pool, job, NULL);
+}
+
+/**
+ * gimp_drawable_get_sub_preview_finish:
+ * @drawable: a #GimpDrawable
+ * @result:   a #GAsyncResult
+ * @error:    return location for possible errors
+ *
+ * Finishes an operation started with
+ * gimp_drawable_get_sub_preview_async().
+ *
+ * Return value: the preview, or %NULL if layer previews are disabled
+ **/
+GimpTempBuf *
+gimp_drawable_get_sub_preview_finish (GimpDrawable  *drawable,
+                                      GAsyncResult  *result,
+                                      GError       **error)
+{
+  g_return_val_if_fail (GIMP_IS_DRAWABLE (drawable), NULL);
+  g_return_val_if_fail (g_task_is_valid (result, drawable), NULL);
+  g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+  return g_task_propagate_pointer (G_TASK (result), error);
+}
+
+void
+gimp_drawable_preview_invalidate (GimpDrawable *drawable,
+                                  gint          x,
+                                  gint          y,
+                                  gint          width,
+                                  gint          height)
+{
+  GimpItem *item;
+  gint      level;
+
+  g_return_if_fail (GIMP_IS_DRAWABLE (drawable));
+
+  item = GIMP_ITEM (drawable);
+
+  if (! gimp_rectangle_intersect (x, y, width, height,
+                                  0, 0,
+                                  gimp_item_get_width  (item),
+                                  gimp_item_get_height (item),
+                                  &x, &y, &width, &height))
+    return;
+
+  for (level = 0; level < GIMP_DRAWABLE_PREVIEW_LEVELS; level++)
+    {
+      GeglBuffer *buffer = drawable->private->preview_levels[level];
+      guchar     *valid  = drawable->private->preview_valid[level];
+      gint        shift  = level + 1;
+      gint        n_tiles_x;
+      gint        x1, y1, x2, y2;
+      gint        tx, ty;
+
+      if (! buffer)
+        continue;
+
+      n_tiles_x = (gegl_buffer_get_width (buffer) + PREVIEW_TILE_SIZE - 1) /
+                  PREVIEW_TILE_SIZE;
+
+      x1 = (x >> shift) / PREVIEW_TILE_SIZE;
+      y1 = (y >> shift) / PREVIEW_TILE_SIZE;
+      x2 = (((x + width  - 1) >> shift)) / PREVIEW_TILE_SIZE;
+      y2 = (((y + height - 1) >> shift)) / PREVIEW_TILE_SIZE;
+
+      for (ty = y1; ty <= y2; ty++)
+        for (tx = x1; tx <= x2; tx++)
+          valid[ty * n_tiles_x + tx] = FALSE;
+    }
+}
+
+void
+gimp_drawable_preview_free (GimpDrawable *drawable)
+{
+  gint level;
+
+  g_return_if_fail (GIMP_IS_DRAWABLE (drawable));
+
+  for (level = 0; level < GIMP_DRAWABLE_PREVIEW_LEVELS; level++)
+    gimp_drawable_preview_free_level (drawable, level);
+}
+
+gint64
+gimp_drawable_preview_get_memsize (GimpDrawable *drawable)
+{
+  gint64 memsize = 0;
+  gint   level;
+
+  g_return_val_if_fail (GIMP_IS_DRAWABLE (drawable), 0);
+
+  for (level = 0; level < GIMP_DRAWABLE_PREVIEW_LEVELS; level++)
+    {
+      GeglBuffer *buffer = drawable->private->preview_levels[level];
+
+      memsize += gimp_gegl_buffer_get_memsize (buffer);
+    }
+
+  return memsize;
+}
+
+
+/*  private functions  */
+
+/*  Returns the buffer of mipmap @level, creating it if necessary, and
+ *  makes sure all of its tiles intersecting @rect are valid.  Invalid
+ *  tiles are scaled down from the level above, which is validated too.
+ */
+static GeglBuffer *
+gimp_drawable_preview_get_level (GimpDrawable        *drawable,
+                                 gint                 level,
+                                 const GeglRectangle *rect)
+{
+  GimpItem      *item   = GIMP_ITEM (drawable);
+  const Babl    *format = gimp_drawable_get_preview_format (drawable);
+  GeglBuffer    *buffer;
+  GeglBuffer    *src_buffer;
+  guchar        *valid;
+  GeglRectangle  extent;
+  GeglRectangle  area;
+  gint           shift  = level + 1;
+  gint           n_tiles_x;
+  gint           n_tiles_y;
+  gint           tx, ty;
+  guchar        *data   = NULL;
+
+  extent.x      = 0;
+  extent.y      = 0;
+  extent.width  = (gimp_item_get_width  (item) + (1 << shift) - 1) >> shift;
+  extent.height = (gimp_item_get_height (item) + (1 << shift) - 1) >> shift;
+
+  n_tiles_x = (extent.width  + PREVIEW_TILE_SIZE - 1) / PREVIEW_TILE_SIZE;
+  n_tiles_y = (extent.height + PREVIEW_TILE_SIZE - 1) / PREVIEW_TILE_SIZE;
+
+  buffer = drawable->private->preview_levels[level];
+
+  /*  the drawable changed size or format behind our back  */
+  if (buffer &&
+      (! gegl_rectangle_equal (gegl_buffer_get_extent (buffer), &extent) ||
+       gegl_buffer_get_format (buffer) != format))
+    {
+      gimp_drawable_preview_free_level (drawable, level);
+      buffer = NULL;
+    }
+
+  if (! buffer)
+    {
+      buffer = gegl_buffer_new (&extent, format);
+
+      drawable->private->preview_levels[level] = buffer;
+      drawable->private->preview_valid[level]  = g_new0 (guchar,
+                                                         n_tiles_x * n_tiles_y);
+    }
+
+  valid = drawable->private->preview_valid[level];
+
+  if (! gegl_rectangle_intersect (&area, rect, &extent))
+    return buffer;
+
+  if (level == 0)
+    src_buffer = gimp_drawable_get_buffer (drawable);
+  else
+    src_buffer = NULL;
+
+  for (ty = area.y / PREVIEW_TILE_SIZE;
+       ty <= (area.y + area.height - 1) / PREVIEW_TILE_SIZE;
+       ty++)
+    {
+      for (tx = area.x / PREVIEW_TILE_SIZE;
+           tx <= (area.x + area.width - 1) / PREVIEW_TILE_SIZE;
+           tx++)
+        {
+          GeglRectangle tile;
+
+          if (valid[ty * n_tiles_x + tx])
+            continue;
+
+          gegl_rectangle_intersect (&tile,
+                                    GEGL_RECTANGLE (tx * PREVIEW_TILE_SIZE,
+                                                    ty * PREVIEW_TILE_SIZE,
+                                                    PREVIEW_TILE_SIZE,
+                                                    PREVIEW_TILE_SIZE),
+                                    &extent);
+
+          if (level > 0)
+            {
+              GeglRectangle src_rect = { tile.x     * 2, tile.y      * 2,
+                                         tile.width * 2, tile.height * 2 };
+
+              src_buffer = gimp_drawable_preview_get_level (drawable,
+                                                            level - 1,
+                                                            &src_rect);
+            }
+
+          if (! data)
+            data = g_malloc (PREVIEW_TILE_SIZE * PREVIEW_TILE_SIZE *
+                             babl_format_get_bytes_per_pixel (format));
+
+          gegl_buffer_get (src_buffer, &tile, 0.5,
+                           format, data,
+                           GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_CLAMP);
+          gegl_buffer_set (buffer, &tile, 0,
+                           format, data,
+                           GEGL_AUTO_ROWSTRIDE);
+
+          valid[ty * n_tiles_x + tx] = TRUE;
+        }
+    }
+
+  g_free (data);
+
+  return buffer;
+}
+
+static void
+gimp_drawable_preview_free_level (GimpDrawable *drawable,
+                                  gint          level)
+{
+  if (drawable->private->preview_levels[level])
+    {
+      g_object_unref (drawable->private->preview_levels[level]);
+      drawable->private->preview_levels[level] = NULL;
+    }
+
+  if (drawable->private->preview_valid[level])
+    {
+      g_free (drawable->private->preview_valid[level]);
+      drawable->private->preview_valid[level] = NULL;
+    }
+}
+
+static guint
+gimp_preview_job_hash (const GimpPreviewJob *job)
+{
+  guint hash = g_direct_hash (job->drawable);
+
+  hash = hash * 31 + job->src_rect.x;
+  hash = hash * 31 + job->src_rect.y;
+  hash = hash * 31 + job->src_rect.width;
+  hash = hash * 31 + job->src_rect.height;
+  hash = hash * 31 + job->dest_width;
+  hash = hash * 31 + job->dest_height;
+
+  return hash;
+}
+
+static gboolean
+gimp_preview_job_equal (const GimpPreviewJob *job1,
+                        const GimpPreviewJob *job2)
+{
+  return (job1->drawable    == job2->drawable                          &&
+          gegl_rectangle_equal (&job1->src_rect, &job2->src_rect)      &&
+          job1->dest_width  == job2->dest_width                        &&
+          job1->dest_height == job2->dest_height);
+}
+
+/*  the task is owned by the job from now on  */
+static void
+gimp_preview_job_add_task (GimpPreviewJob *job,
+                           GTask          *task)
+{
+  GimpPreviewJobTask *job_task    = g_slice_new0 (GimpPreviewJobTask);
+  GCancellable       *cancellable = g_task_get_cancellable (task);
+
+  job_task->task = task;
+
+  job->tasks = g_list_prepend (job->tasks, job_task);
+  g_atomic_int_inc (&job->n_tasks);
+
+  if (cancellable)
+    job_task->cancelled_id =
+      g_cancellable_connect (cancellable,
+                             G_CALLBACK (gimp_preview_job_cancelled),
+                             job, NULL);
+}
+
+/*  called from whatever thread cancelled the request  */
+static void
+gimp_preview_job_cancelled (GCancellable   *cancellable,
+                            GimpPreviewJob *job)
+{
+  g_atomic_int_inc (&job->n_cancelled);
+}
+
+static void
+gimp_preview_job_invalidated (GimpDrawable   *drawable,
+                              GimpPreviewJob *job)
+{
+  if (g_hash_table_lookup (preview_jobs, job) == job)
+    g_hash_table_remove (preview_jobs, job);
+
+  g_signal_handlers_disconnect_by_func (drawable,
+                                        gimp_preview_job_invalidated,
+                                        job);
+}
+
+static gint
+gimp_preview_job_compare (const GimpPreviewJob *job1,
+                          const GimpPreviewJob *job2,
+                          gpointer              data)
+{
+  if (job1->priority != job2->priority)
+    return job1->priority < job2->priority ? -1 : 1;
+
+  /*  most recent first, it is most likely still visible  */
+  if (job1->serial != job2->serial)
+    return job1->serial > job2->serial ? -1 : 1;
+
+  return 0;
+}
+
+/*  runs in a thread of the preview pool, only job->buffer may be
+ *  read here
+ */
+static void
+gimp_preview_job_func (GimpPreviewJob *job,
+                       gpointer        data)
+{
+  if (g_atomic_int_get (&job->n_cancelled) <
+      g_atomic_int_get (&job->n_tasks))
+    {
+      gdouble scale;
+
+      scale = MIN ((gdouble) job->dest_width  / (gdouble) job->src_rect.width,
+                   (gdouble) job->dest_height / (gdouble) job->src_rect.height);
+
+      job->preview = gimp_temp_buf_new (job->dest_width, job->dest_height,
+                                        job->format);
+
+      gegl_buffer_get (job->buffer,
+                       GEGL_RECTANGLE (floor (job->src_rect.x * scale),
+                                       floor (job->src_rect.y * scale),
+                                       job->dest_width,
+                                       job->dest_height),
+                       scale,
+                       job->format,
+                       gimp_temp_buf_get_data (job->preview),
+                       GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_CLAMP);
+    }
+
+  g_idle_add_full (GIMP_PRIORITY_VIEWABLE_IDLE,
+                   (GSourceFunc) gimp_preview_job_idle, job,
+                   NULL);
+}
+
+static gboolean
+gimp_preview_job_idle (GimpPreviewJob *job)
+{
+  GList *list;
+
+  if (g_hash_table_lookup (preview_jobs, job) == job)
+    gimp_preview_job_invalidated (job->drawable, job);
+
+  for (list = job->tasks; list; list = g_list_next (list))
+    {
+      GimpPreviewJobTask *job_task = list->data;
+      GTask              *task     = job_task->task;
+
+      if (job_task->cancelled_id)
+        g_cancellable_disconnect (g_task_get_cancellable (task),
+                                  job_task->cancelled_id);
+
+      if (! g_task_return_error_if_cancelled (task))
+        g_task_return_pointer (task,
+                               job->preview ?
+                               gimp_temp_buf_ref (job->preview) : NULL,
+                               (GDestroyNotify) gimp_temp_buf_unref);
+
+      g_object_unref (task);
+      g_slice_free (GimpPreviewJobTask, job_task);
+    }
+
+  g_list_free (job->tasks);
+
+  if (job->preview)
+    gimp_temp_buf_unref (job->preview);
+
+  g_object_unref (job->buffer);
+  g_object_unref (job->drawable);
+
+  g_slice_free (GimpPreviewJob, job);
+
+  return G_SOURCE_REMOVE;
+}
@@ -22,22 +22,45 @@
 /*
  *  virtual function of GimpDrawable -- dont't call directly
  */
-GimpTempBuf * gimp_drawable_get_new_preview    (GimpViewable *viewable,
-                                                GimpContext  *context,
-                                                gint          width,
-                                                gint          height);
+GimpTempBuf * gimp_drawable_get_new_preview     (GimpViewable *viewable,
+                                                 GimpContext  *context,
+                                                 gint          width,
+                                                 gint          height);
 
 /*
  *  normal functions (no virtuals)
  */
-const Babl  * gimp_drawable_get_preview_format (GimpDrawable *drawable);
-GimpTempBuf * gimp_drawable_get_sub_preview    (GimpDrawable *drawable,
-                                                gint          src_x,
-                                                gint          src_y,
-                                                gint          src_width,
-                                                gint          src_height,
-                                                gint          dest_width,
-                                                gint          dest_height);
+const Babl  * gimp_drawable_get_preview_format  (GimpDrawable *drawable);
+GimpTempBuf * gimp_drawable_get_sub_preview     (GimpDrawable *drawable,
+                                                 gint          src_x,
+                                                 gint          src_y,
+                                                 gint          src_width,
+                                                 gint          src_height,
+                                                 gint          dest_width,
+                                                 gint          dest_height);
+
+void          gimp_drawable_get_sub_preview_async  (GimpDrawable        *drawable,
+                                                    gint                 src_x,
+                                                    gint                 src_y,
+                                                    gint                 src_width,
+                                                    gint                 src_height,
+                                                    gint                 dest_width,
+                                                    gint                 dest_height,
+                                                    gint                 priority,
+                                                    GCancellable        *cancellable,
+                                                    GAsyncReadyCallback  callback,
+                                                    gpointer             user_data);
+GimpTempBuf * gimp_drawable_get_sub_preview_finish (GimpDrawable        *drawable,
+                                                    GAsyncResult        *result,
+                                                    GError             **error);
+
+void          gimp_drawable_preview_invalidate  (GimpDrawable *drawable,
+                                                 gint          x,
+                                                 gint          y,
+                                                 gint          width,
+                                                 gint          height);
+void          gimp_drawable_preview_free        (GimpDrawable *drawable);
+gint64        gimp_drawable_preview_get_memsize (GimpDrawable *drawable);
 
 
 #endif /* __GIMP_DRAWABLE__PREVIEW_H__ */
@@ -18,6 +18,11 @@
 #ifndef __GIMP_DRAWABLE_PRIVATE_H__
 #define __GIMP_DRAWABLE_PRIVATE_H__
 
+
+/*  number of preview mipmap levels, level n is 1 / 2^(n + 1) scale  */
+#define GIMP_DRAWABLE_PREVIEW_LEVELS 12
+
+
 struct _GimpDrawablePrivate
 {
   GeglBuffer     *buffer; /* buffer for drawable data */
@@ -27,12 +32,22 @@ struct _GimpDrawablePrivate
   GeglNode       *buffer_source_node;
   GimpContainer  *filter_stack;
 
+  GeglBuffer              *filter_cache; /* cached filter stack output */
+  GimpTileHandlerValidate *filter_cache_handler;
+  GeglNode                *filter_cache_node;
+
   GimpLayer      *floating_selection;
   GimpFilter     *fs_filter;
   GeglNode       *fs_crop_node;
   GimpApplicator *fs_applicator;
 
   GeglNode       *mode_node;
+
+  GeglBuffer     *preview_levels[GIMP_DRAWABLE_PREVIEW_LEVELS];
+  guchar         *preview_valid[GIMP_DRAWABLE_PREVIEW_LEVELS];
+
+  gint            paint_count;
+  GeglRectangle   paint_update_area; /* updates deferred while painting */
 };
 
 #endif /* __GIMP_DRAWABLE_PRIVATE_H__ */
@@ -281,10 +281,11 @@ gimp_drawable_stroke_scan_convert (GimpDrawable    *drawable,
                                    gboolean         do_stroke,
                                    gboolean         push_undo)
 {
-  GimpContext *context = GIMP_CONTEXT (options);
-  GimpImage   *image   = gimp_item_get_image (GIMP_ITEM (drawable));
-  GeglBuffer  *base_buffer;
+  GimpContext *context     = GIMP_CONTEXT (options);
+  GimpImage   *image       = gimp_item_get_image (GIMP_ITEM (drawable));
+  GeglBuffer  *base_buffer = NULL;
   GeglBuffer  *mask_buffer;
+  const Babl  *format;
   gint         x, y, w, h;
   gint         off_x;
   gint         off_y;
@@ -347,8 +348,7 @@ gimp_drawable_stroke_scan_convert (GimpDrawable    *drawable,
                             x + off_x, y + off_y,
                             gimp_fill_options_get_antialias (options));
 
-  base_buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0, w, h),
-                                 gimp_drawable_get_format_with_alpha (drawable));
+  format = gimp_drawable_get_format_with_alpha (drawable);
 
   switch (gimp_fill_options_get_style (options))
     {
@@ -357,6 +357,8 @@ gimp_drawable_stroke_scan_convert (GimpDrawable    *drawable,
         GimpRGB    fg;
         GeglColor *color;
 
+        base_buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0, w, h), format);
+
         gimp_context_get_foreground (context, &fg);
 
         color = gimp_gegl_color_new (&fg);
@@ -368,11 +370,11 @@ gimp_drawable_stroke_scan_convert (GimpDrawable    *drawable,
     case GIMP_FILL_STYLE_PATTERN:
       {
         GimpPattern *pattern = gimp_context_get_pattern (context);
-        GeglBuffer  *pattern_buffer;
 
-        pattern_buffer = gimp_pattern_create_buffer (pattern);
-        gegl_buffer_set_pattern (base_buffer, NULL, pattern_buffer, 0, 0);
-        g_object_unref (pattern_buffer);
+        base_buffer = gimp_pattern_create_tiled_buffer (pattern,
+                                                        GEGL_RECTANGLE (0, 0,
+                                                                        w, h),
+                                                        format, 0, 0);
       }
       break;
     }
@@ -31,6 +31,7 @@
 #include "core-types.h"
 
 #include "gegl/gimp-gegl-apply-operation.h"
+#include "gegl/gimp-gegl-loops.h"
 #include "gegl/gimp-gegl-utils.h"
 
 #include "gimp.h"
@@ -60,6 +61,17 @@
 #error "no FINITE() implementation available?!"
 #endif
 
+#define EPSILON 1e-6
+
+
+/*  local function prototypes  */
+
+static gboolean   gimp_drawable_transform_matrix_is_grid_aligned
+                                                (const GimpMatrix3 *matrix,
+                                                 gint              *quarter_turns,
+                                                 gint              *offset_x,
+                                                 gint              *offset_y);
+
 
 /*  public functions  */
 
@@ -82,6 +94,10 @@ gimp_drawable_transform_buffer_affine (GimpDrawable           *drawable,
   gint         u1, v1, u2, v2;  /* source bounding box */
   gint         x1, y1, x2, y2;  /* target bounding box */
   GimpMatrix3  gegl_matrix;
+  gboolean     grid_aligned;
+  gint         quarter_turns;
+  gint         offset_x;
+  gint         offset_y;
 
   g_return_val_if_fail (GIMP_IS_DRAWABLE (drawable), NULL);
   g_return_val_if_fail (gimp_item_is_attached (GIMP_ITEM (drawable)), NULL);
@@ -110,6 +126,54 @@ gimp_drawable_transform_buffer_affine (GimpDrawable           *drawable,
       ! babl_format_has_alpha (gegl_buffer_get_format (orig_buffer)))
     clip_result = GIMP_TRANSFORM_RESIZE_CLIP;
 
+  /*  Matrices which map the pixel grid onto itself don't need the
+   *  resampler: quarter turns are done by the exact rotate code, and
+   *  whole pixel translations by copying
+   */
+  grid_aligned = gimp_drawable_transform_matrix_is_grid_aligned (&m,
+                                                                 &quarter_turns,
+                                                                 &offset_x,
+                                                                 &offset_y);
+
+  if (grid_aligned && quarter_turns != 0 &&
+      clip_result != GIMP_TRANSFORM_RESIZE_CLIP)
+    {
+      GimpRotationType rotate_type;
+      gdouble          center_x;
+      gdouble          center_y;
+
+      switch (quarter_turns)
+        {
+        case 1:
+          rotate_type = GIMP_ROTATE_90;
+          center_x    = (offset_x - offset_y) / 2.0;
+          center_y    = (offset_x + offset_y) / 2.0;
+          break;
+
+        case 2:
+          rotate_type = GIMP_ROTATE_180;
+          center_x    = offset_x / 2.0;
+          center_y    = offset_y / 2.0;
+          break;
+
+        default:
+          rotate_type = GIMP_ROTATE_270;
+          center_x    = (offset_x + offset_y) / 2.0;
+          center_y    = (offset_y - offset_x) / 2.0;
+          break;
+        }
+
+      return gimp_drawable_transform_buffer_rotate (drawable, context,
+                                                    orig_buffer,
+                                                    orig_offset_x,
+                                                    orig_offset_y,
+                                                    rotate_type,
+                                                    center_x, center_y,
+                                                    FALSE,
+                                                    new_offset_x,
+                                                    new_offset_y);
+    }
+
   /*  Find the bounding coordinates of target */
   gimp_transform_resize_boundary (&m, clip_result,
                                   u1, v1, u2, v2,
@@ -119,15 +183,26 @@ gimp_drawable_transform_buffer_affine (GimpDrawable           *drawable,
   new_buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0, x2 - x1, y2 - y1),
                                 gegl_buffer_get_format (orig_buffer));
 
-  gimp_matrix3_identity (&gegl_matrix);
-  gimp_matrix3_translate (&gegl_matrix, u1, v1);
-  gimp_matrix3_mult (&m, &gegl_matrix);
-  gimp_matrix3_translate (&gegl_matrix, -x1, -y1);
-
-  gimp_gegl_apply_transform (orig_buffer, progress, NULL,
-                             new_buffer,
-                             interpolation_type,
-                             &gegl_matrix);
+  if (grid_aligned && quarter_turns == 0)
+    {
+      gegl_buffer_copy (orig_buffer, NULL,
+                        new_buffer,
+                        GEGL_RECTANGLE (u1 + offset_x - x1,
+                                        v1 + offset_y - y1,
+                                        0, 0));
+    }
+  else
+    {
+      gimp_matrix3_identity (&gegl_matrix);
+      gimp_matrix3_translate (&gegl_matrix, u1, v1);
+      gimp_matrix3_mult (&m, &gegl_matrix);
+      gimp_matrix3_translate (&gegl_matrix, -x1, -y1);
+
+      gimp_gegl_apply_transform (orig_buffer, progress, NULL,
+                                 new_buffer,
+                                 interpolation_type,
+                                 &gegl_matrix);
+    }
 
   *new_offset_x = x1;
   *new_offset_y = y1;
@@ -154,7 +229,6 @@ gimp_drawable_transform_buffer_flip (GimpDrawable        *drawable,
   gint           orig_width, orig_height;
   gint           new_x, new_y;
   gint           new_width, new_height;
-  gint           i;
 
   g_return_val_if_fail (GIMP_IS_DRAWABLE (drawable), NULL);
   g_return_val_if_fail (gimp_item_is_attached (GIMP_ITEM (drawable)), NULL);
@@ -238,48 +312,26 @@ gimp_drawable_transform_buffer_flip (GimpDrawable        *drawable,
   if (new_width == 0 && new_height == 0)
     return new_buffer;
 
+  src_rect.x      = orig_x;
+  src_rect.y      = orig_y;
+  src_rect.width  = orig_width;
+  src_rect.height = orig_height;
+
+  dest_rect.x      = new_x;
+  dest_rect.y      = new_y;
+  dest_rect.width  = new_width;
+  dest_rect.height = new_height;
+
   switch (flip_type)
     {
     case GIMP_ORIENTATION_HORIZONTAL:
-      src_rect.x      = orig_x;
-      src_rect.y      = orig_y;
-      src_rect.width  = 1;
-      src_rect.height = orig_height;
-
-      dest_rect.x      = new_x + new_width - 1;
-      dest_rect.y      = new_y;
-      dest_rect.width  = 1;
-      dest_rect.height = new_height;
-
-      for (i = 0; i < orig_width; i++)
-        {
-          src_rect.x  = i + orig_x;
-          dest_rect.x = new_x + new_width - i - 1;
-
-          gegl_buffer_copy (orig_buffer, &src_rect,
-                            new_buffer, &dest_rect);
-        }
+      gimp_gegl_buffer_remap (orig_buffer, &src_rect, new_buffer, &dest_rect,
+                              FALSE, TRUE, FALSE);
       break;
 
     case GIMP_ORIENTATION_VERTICAL:
-      src_rect.x      = orig_x;
-      src_rect.y      = orig_y;
-      src_rect.width  = orig_width;
-      src_rect.height = 1;
-
-      dest_rect.x      = new_x;
-      dest_rect.y      = new_y + new_height - 1;
-      dest_rect.width  = new_width;
-      dest_rect.height = 1;
-
-      for (i = 0; i < orig_height; i++)
-        {
-          src_rect.y  = i + orig_y;
-          dest_rect.y = new_y + new_height - i - 1;
-
-          gegl_buffer_copy (orig_buffer, &src_rect,
-                            new_buffer, &dest_rect);
-        }
+      gimp_gegl_buffer_remap (orig_buffer, &src_rect, new_buffer, &dest_rect,
+                              FALSE, FALSE, TRUE);
       break;
 
     case GIMP_ORIENTATION_UNKNOWN:
@@ -341,7 +393,6 @@ gimp_drawable_transform_buffer_rotate (GimpDrawable     *drawable,
   GeglRectangle  dest_rect;
   gint           orig_x, orig_y;
   gint           orig_width, orig_height;
-  gint           orig_bpp;
   gint           new_x, new_y;
   gint           new_width, new_height;
 
@@ -354,7 +405,6 @@ gimp_drawable_transform_buffer_rotate (GimpDrawable     *drawable,
   orig_y      = orig_offset_y;
   orig_width  = gegl_buffer_get_width (orig_buffer);
   orig_height = gegl_buffer_get_height (orig_buffer);
-  orig_bpp    = babl_format_get_bytes_per_pixel (gegl_buffer_get_format (orig_buffer));
 
   switch (rotate_type)
     {
@@ -505,101 +555,18 @@ gimp_drawable_transform_buffer_rotate (GimpDrawable     *drawable,
   switch (rotate_type)
     {
     case GIMP_ROTATE_90:
-      {
-        guchar *buf = g_new (guchar, new_height * orig_bpp);
-        gint    i;
-
-        g_assert (new_height == orig_width);
-
-        src_rect.y      = orig_y + orig_height - 1;
-        src_rect.height = 1;
-
-        dest_rect.x     = new_x;
-        dest_rect.width = 1;
-
-        for (i = 0; i < orig_height; i++)
-          {
-            src_rect.y  = orig_y + orig_height - 1 - i;
-            dest_rect.x = new_x + i;
-
-            gegl_buffer_get (orig_buffer, &src_rect, 1.0, NULL, buf,
-                             GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
-            gegl_buffer_set (new_buffer, &dest_rect, 0, NULL, buf,
-                             GEGL_AUTO_ROWSTRIDE);
-          }
-
-        g_free (buf);
-      }
+      gimp_gegl_buffer_remap (orig_buffer, &src_rect, new_buffer, &dest_rect,
+                              TRUE, FALSE, TRUE);
       break;
 
     case GIMP_ROTATE_180:
-      {
-        guchar *buf = g_new (guchar, new_width * orig_bpp);
-        gint    i, j, k;
-
-        g_assert (new_width == orig_width);
-
-        src_rect.y      = orig_y + orig_height - 1;
-        src_rect.height = 1;
-
-        dest_rect.y      = new_y;
-        dest_rect.height = 1;
-
-        for (i = 0; i < orig_height; i++)
-          {
-            src_rect.y  = orig_y + orig_height - 1 - i;
-            dest_rect.y = new_y + i;
-
-            gegl_buffer_get (orig_buffer, &src_rect, 1.0, NULL, buf,
-                             GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
-
-            for (j = 0; j < orig_width / 2; j++)
-              {
-                guchar *left  = buf + j * orig_bpp;
-                guchar *right = buf + (orig_width - 1 - j) * orig_bpp;
-
-                for (k = 0; k < orig_bpp; k++)
-                  {
-                    guchar tmp = left[k];
-                    left[k]    = right[k];
-                    right[k]   = tmp;
-                  }
-              }
-
-            gegl_buffer_set (new_buffer, &dest_rect, 0, NULL, buf,
-                             GEGL_AUTO_ROWSTRIDE);
-          }
-
-        g_free (buf);
-      }
+      gimp_gegl_buffer_remap (orig_buffer, &src_rect, new_buffer, &dest_rect,
+                              FALSE, TRUE, TRUE);
       break;
 
     case GIMP_ROTATE_270:
-      {
-        guchar *buf = g_new (guchar, new_width * orig_bpp);
-        gint    i;
-
-        g_assert (new_width == orig_height);
-
-        src_rect.x     = orig_x + orig_width - 1;
-        src_rect.width = 1;
-
-        dest_rect.y      = new_y;
-        dest_rect.height = 1;
-
-        for (i = 0; i < orig_width; i++)
-          {
-            src_rect.x  = orig_x + orig_width - 1 - i;
-            dest_rect.y = new_y + i;
-
-            gegl_buffer_get (orig_buffer, &src_rect, 1.0, NULL, buf,
-                             GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
-            gegl_buffer_set (new_buffer, &dest_rect, 0, NULL, buf,
-                             GEGL_AUTO_ROWSTRIDE);
-          }
-
-        g_free (buf);
-      }
+      gimp_gegl_buffer_remap (orig_buffer, &src_rect, new_buffer, &dest_rect,
+                              TRUE, TRUE, FALSE);
       break;
     }
 
@@ -980,3 +947,55 @@ gimp_drawable_transform_paste (GimpDrawable *drawable,
 
   return drawable;
 }
+
+
+/*  private functions  */
+
+/*  checks whether @matrix is a rotation by a multiple of 90 degrees,
+ *  followed by a translation by whole pixels, and returns the number
+ *  of clockwise quarter turns and the translation if so
+ */
+static gboolean
+gimp_drawable_transform_matrix_is_grid_aligned (const GimpMatrix3 *matrix,
+                                                gint              *quarter_turns,
+                                                gint              *offset_x,
+                                                gint              *offset_y)
+{
+  static const gint rotations[4][4] =
+  {
+    {  1,  0,  0,  1 },
+    {  0, -1,  1,  0 },
+    { -1,  0,  0, -1 },
+    {  0,  1, -1,  0 }
+  };
+
+  gdouble tx = matrix->coeff[0][2];
+  gdouble ty = matrix->coeff[1][2];
+  gint    i;
+
+  if (fabs (matrix->coeff[2][0])       > EPSILON ||
+      fabs (matrix->coeff[2][1])       > EPSILON ||
+      fabs (matrix->coeff[2][2] - 1.0) > EPSILON)
+    return FALSE;
+
+  if (fabs (tx - RINT (tx)) > EPSILON ||
+      fabs (ty - RINT (ty)) > EPSILON)
+    return FALSE;
+
+  for (i = 0; i < 4; i++)
+    {
+      if (fabs (matrix->coeff[0][0] - rotations[i][0]) <= EPSILON &&
+          fabs (matrix->coeff[0][1] - rotations[i][1]) <= EPSILON &&
+          fabs (matrix->coeff[1][0] - rotations[i][2]) <= EPSILON &&
+          fabs (matrix->coeff[1][1] - rotations[i][3]) <= EPSILON)
+        {
+          *quarter_turns = i;
+          *offset_x      = RINT (tx);
+          *offset_y      = RINT (ty);
+
+          return TRUE;
+        }
+    }
+
+  return FALSE;
+}
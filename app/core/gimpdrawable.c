@@ -30,7 +30,9 @@
 #include "gegl/gimpapplicator.h"
 #include "gegl/gimp-babl.h"
 #include "gegl/gimp-gegl-apply-operation.h"
+#include "gegl/gimp-gegl-loops.h"
 #include "gegl/gimp-gegl-utils.h"
+#include "gegl/gimptilehandlervalidate.h"
 
 #include "gimp-memsize.h"
 #include "gimp-utils.h"
@@ -45,6 +47,7 @@
 #include "gimpfilterstack.h"
 #include "gimpimage.h"
 #include "gimpimage-colormap.h"
+#include "gimpimage-undo.h"
 #include "gimpimage-undo-push.h"
 #include "gimplayer.h"
 #include "gimpmarshal.h"
@@ -193,6 +196,20 @@ static void       gimp_drawable_fs_update          (GimpLayer         *fs,
                                                     gint               height,
                                                     GimpDrawable      *drawable);
 
+static void       gimp_drawable_sync_cache         (GimpDrawable      *drawable);
+static void       gimp_drawable_invalidate_cache   (GimpDrawable      *drawable,
+                                                    const GeglRectangle *rect);
+static void       gimp_drawable_graph_invalidated  (GeglNode          *node,
+                                                    const GeglRectangle *rect,
+                                                    GimpDrawable      *drawable);
+static void       gimp_drawable_filters_changed    (GimpContainer     *container,
+                                                    GimpObject        *filter,
+                                                    GimpDrawable      *drawable);
+static void       gimp_drawable_filters_reordered  (GimpContainer     *container,
+                                                    GimpObject        *filter,
+                                                    gint               index,
+                                                    GimpDrawable      *drawable);
+
 
 G_DEFINE_TYPE_WITH_CODE (GimpDrawable, gimp_drawable, GIMP_TYPE_ITEM,
                          G_IMPLEMENT_INTERFACE (GIMP_TYPE_PICKABLE,
@@ -282,6 +299,16 @@ gimp_drawable_init (GimpDrawable *drawable)
                                                    GimpDrawablePrivate);
 
   drawable->private->filter_stack = gimp_filter_stack_new (GIMP_TYPE_FILTER);
+
+  g_signal_connect_after (drawable->private->filter_stack, "add",
+                          G_CALLBACK (gimp_drawable_filters_changed),
+                          drawable);
+  g_signal_connect_after (drawable->private->filter_stack, "remove",
+                          G_CALLBACK (gimp_drawable_filters_changed),
+                          drawable);
+  g_signal_connect_after (drawable->private->filter_stack, "reorder",
+                          G_CALLBACK (gimp_drawable_filters_reordered),
+                          drawable);
 }
 
 /* sorry for the evil casts */
@@ -319,6 +346,19 @@ gimp_drawable_finalize (GObject *object)
     }
 
   gimp_drawable_free_shadow_buffer (drawable);
+  gimp_drawable_preview_free (drawable);
+
+  if (drawable->private->filter_cache)
+    {
+      gegl_buffer_remove_handler (drawable->private->filter_cache,
+                                  drawable->private->filter_cache_handler);
+
+      g_object_unref (drawable->private->filter_cache);
+      drawable->private->filter_cache = NULL;
+
+      g_object_unref (drawable->private->filter_cache_handler);
+      drawable->private->filter_cache_handler = NULL;
+    }
 
   if (drawable->private->source_node)
     {
@@ -379,6 +419,9 @@ gimp_drawable_get_memsize (GimpObject *object,
 
   memsize += gimp_gegl_buffer_get_memsize (gimp_drawable_get_buffer (drawable));
   memsize += gimp_gegl_buffer_get_memsize (drawable->private->shadow);
+  memsize += gimp_gegl_buffer_get_memsize (drawable->private->filter_cache);
+
+  *gui_size += gimp_drawable_preview_get_memsize (drawable);
 
   return memsize + GIMP_OBJECT_CLASS (parent_class)->get_memsize (object,
                                                                   gui_size);
@@ -500,8 +543,11 @@ gimp_drawable_duplicate (GimpItem *item,
       if (new_drawable->private->buffer)
         g_object_unref (new_drawable->private->buffer);
 
+      /*  shares the tiles copy-on-write, so duplicates are nearly free
+       *  until either drawable is changed
+       */
       new_drawable->private->buffer =
-        gegl_buffer_dup (gimp_drawable_get_buffer (drawable));
+        gimp_gegl_buffer_dup_area (gimp_drawable_get_buffer (drawable), NULL);
     }
 
   return new_item;
@@ -530,7 +576,8 @@ gimp_drawable_scale (GimpItem              *item,
                          ((gdouble) new_width /
                           gimp_item_get_width  (item)),
                          ((gdouble) new_height /
-                          gimp_item_get_height (item)));
+                          gimp_item_get_height (item)),
+                         FALSE);
 
   gimp_drawable_set_buffer_full (drawable, gimp_item_is_attached (item), NULL,
                                  new_buffer,
@@ -756,6 +803,7 @@ gimp_drawable_real_update (GimpDrawable *drawable,
         }
     }
 
+  gimp_drawable_preview_invalidate (drawable, x, y, width, height);
   gimp_viewable_invalidate_preview (GIMP_VIEWABLE (drawable));
 }
 
@@ -805,8 +853,8 @@ gimp_drawable_real_convert_type (GimpDrawable      *drawable,
                                      gimp_item_get_height (GIMP_ITEM (drawable))),
                      format);
 
-  gegl_buffer_copy (gimp_drawable_get_buffer (drawable), NULL,
-                    dest_buffer, NULL);
+  gimp_gegl_buffer_copy (gimp_drawable_get_buffer (drawable), NULL,
+                         dest_buffer, NULL);
 
   gimp_drawable_set_buffer (drawable, push_undo, NULL, dest_buffer);
   g_object_unref (dest_buffer);
@@ -845,6 +893,8 @@ gimp_drawable_real_set_buffer (GimpDrawable *drawable,
 
   drawable->private->buffer = buffer;
 
+  gimp_drawable_preview_free (drawable);
+
   gimp_item_set_offset (item, offset_x, offset_y);
   gimp_item_set_size (item,
                       gegl_buffer_get_width  (buffer),
@@ -858,6 +908,8 @@ gimp_drawable_real_set_buffer (GimpDrawable *drawable,
                    "buffer", gimp_drawable_get_buffer (drawable),
                    NULL);
 
+  gimp_drawable_sync_cache (drawable);
+
   g_object_notify (G_OBJECT (drawable), "buffer");
 }
 
@@ -870,22 +922,28 @@ gimp_drawable_real_push_undo (GimpDrawable *drawable,
                               gint          width,
                               gint          height)
 {
-  if (! buffer)
+  GimpImage *image = gimp_item_get_image (GIMP_ITEM (drawable));
+
+  /*  the undo step would be dropped anyway, don't copy the pixels
+   *  for it, but still dirty the image like pushing it would
+   */
+  if (! gimp_image_undo_is_enabled (image))
     {
-      buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0, width, height),
-                                gimp_drawable_get_format (drawable));
+      gimp_image_dirty (image, GIMP_DIRTY_ITEM | GIMP_DIRTY_DRAWABLE);
+      return;
+    }
 
-      gegl_buffer_copy (gimp_drawable_get_buffer (drawable),
-                        GEGL_RECTANGLE (x, y, width, height),
-                        buffer,
-                        GEGL_RECTANGLE (0, 0, 0, 0));
+  if (! buffer)
+    {
+      buffer = gimp_gegl_buffer_dup_area (gimp_drawable_get_buffer (drawable),
+                                          GEGL_RECTANGLE (x, y, width, height));
     }
   else
     {
       g_object_ref (buffer);
     }
 
-  gimp_image_undo_push_drawable (gimp_item_get_image (GIMP_ITEM (drawable)),
+  gimp_image_undo_push_drawable (image,
                                  undo_desc, drawable,
                                  buffer, x, y);
 
@@ -1142,6 +1200,146 @@ gimp_drawable_fs_update (GimpLayer    *fs,
     }
 }
 
+/*  While the filter stack is not empty, its output is rendered into
+ *  a cache buffer, tile by tile, on demand, and the rest of the graph
+ *  reads from that buffer. Only the tiles the filters' output depends
+ *  on are invalidated, so the filters are not re-run when unrelated
+ *  parts of the image change.
+ */
+static void
+gimp_drawable_sync_cache (GimpDrawable *drawable)
+{
+  GimpDrawablePrivate *private = drawable->private;
+  GeglNode            *filter;
+  GeglNode            *output;
+  gboolean             cache;
+
+  if (! private->source_node)
+    return;
+
+  filter = gimp_filter_stack_get_graph (GIMP_FILTER_STACK (private->filter_stack));
+  output = gegl_node_get_output_proxy (private->source_node, "output");
+
+  cache = ! gimp_container_is_empty (private->filter_stack);
+
+  if (private->filter_cache &&
+      (! cache ||
+       ! gegl_rectangle_equal (gegl_buffer_get_extent (private->filter_cache),
+                               gegl_buffer_get_extent (private->buffer)) ||
+       gegl_buffer_get_format (private->filter_cache) !=
+       gimp_drawable_get_format_with_alpha (drawable)))
+    {
+      gegl_node_connect_to (filter, "output",
+                            output, "input");
+
+      gegl_node_remove_child (private->source_node,
+                              private->filter_cache_node);
+      private->filter_cache_node = NULL;
+
+      gegl_buffer_remove_handler (private->filter_cache,
+                                  private->filter_cache_handler);
+
+      g_object_unref (private->filter_cache);
+      private->filter_cache = NULL;
+
+      g_object_unref (private->filter_cache_handler);
+      private->filter_cache_handler = NULL;
+    }
+
+  if (cache && ! private->filter_cache)
+    {
+      const GeglRectangle *extent = gegl_buffer_get_extent (private->buffer);
+
+      private->filter_cache =
+        gegl_buffer_new (extent, gimp_drawable_get_format_with_alpha (drawable));
+
+      private->filter_cache_handler =
+        GIMP_TILE_HANDLER_VALIDATE (gimp_tile_handler_validate_new (filter));
+
+      gimp_tile_handler_validate_assign (private->filter_cache_handler,
+                                         private->filter_cache);
+
+      gimp_tile_handler_validate_invalidate (private->filter_cache_handler,
+                                             extent->x,
+                                             extent->y,
+                                             extent->width,
+                                             extent->height);
+
+      private->filter_cache_node =
+        gegl_node_new_child (private->source_node,
+                             "operation", "gegl:buffer-source",
+                             "buffer",    private->filter_cache,
+                             NULL);
+
+      gegl_node_connect_to (private->filter_cache_node, "output",
+                            output,                     "input");
+    }
+}
+
+static void
+gimp_drawable_invalidate_cache (GimpDrawable        *drawable,
+                                const GeglRectangle *rect)
+{
+  GimpDrawablePrivate *private   = drawable->private;
+  GObject             *operation = NULL;
+
+  if (! private->filter_cache)
+    return;
+
+  gimp_tile_handler_validate_invalidate (private->filter_cache_handler,
+                                         rect->x,
+                                         rect->y,
+                                         rect->width,
+                                         rect->height);
+
+  /*  the graph downstream of the cache doesn't see the filters'
+   *  invalidation, forward it
+   */
+  g_object_get (private->filter_cache_node,
+                "gegl-operation", &operation,
+                NULL);
+
+  if (operation)
+    {
+      gegl_operation_invalidate (GEGL_OPERATION (operation), rect, FALSE);
+      g_object_unref (operation);
+    }
+}
+
+static void
+gimp_drawable_graph_invalidated (GeglNode            *node,
+                                 const GeglRectangle *rect,
+                                 GimpDrawable        *drawable)
+{
+  /*  GEGL propagates invalidation of the drawable's buffer, and of
+   *  changed filter parameters, through the filter stack, growing
+   *  the area by each filter's dependencies, so this is exactly the
+   *  part of the cache that is stale
+   */
+  gimp_drawable_invalidate_cache (drawable, rect);
+}
+
+static void
+gimp_drawable_filters_changed (GimpContainer *container,
+                               GimpObject    *filter,
+                               GimpDrawable  *drawable)
+{
+  gimp_drawable_sync_cache (drawable);
+
+  if (drawable->private->filter_cache)
+    gimp_drawable_invalidate_cache (drawable,
+                                    gegl_buffer_get_extent (drawable->private->filter_cache));
+}
+
+static void
+gimp_drawable_filters_reordered (GimpContainer *container,
+                                 GimpObject    *filter,
+                                 gint           index,
+                                 GimpDrawable  *drawable)
+{
+  gimp_drawable_filters_changed (container, filter, drawable);
+}
+
 
 /*  public functions  */
 
@@ -1196,6 +1394,22 @@ gimp_drawable_update (GimpDrawable *drawable,
 {
   g_return_if_fail (GIMP_IS_DRAWABLE (drawable));
 
+  if (drawable->private->paint_count > 0)
+    {
+      GeglRectangle *area = &drawable->private->paint_update_area;
+
+      if (width <= 0 || height <= 0)
+        return;
+
+      if (area->width > 0 && area->height > 0)
+        gegl_rectangle_bounding_box (area, area,
+                                     GEGL_RECTANGLE (x, y, width, height));
+      else
+        *area = *GEGL_RECTANGLE (x, y, width, height);
+
+      return;
+    }
+
   g_signal_emit (drawable, gimp_drawable_signals[UPDATE], 0,
                  x, y, width, height);
 }
@@ -1208,6 +1422,80 @@ gimp_drawable_alpha_changed (GimpDrawable *drawable)
   g_signal_emit (drawable, gimp_drawable_signals[ALPHA_CHANGED], 0);
 }
 
+/**
+ * gimp_drawable_start_paint:
+ * @drawable: a #GimpDrawable
+ *
+ * Starts deferring @drawable's updates, until gimp_drawable_flush_paint()
+ * or gimp_drawable_end_paint() is called. While deferred,
+ * gimp_drawable_update() only records the updated area and may be
+ * called from a thread other than the main thread, as long as the
+ * callers serialize their calls and the calls to
+ * gimp_drawable_flush_paint().
+ **/
+void
+gimp_drawable_start_paint (GimpDrawable *drawable)
+{
+  g_return_if_fail (GIMP_IS_DRAWABLE (drawable));
+
+  drawable->private->paint_count++;
+}
+
+/**
+ * gimp_drawable_end_paint:
+ * @drawable: a #GimpDrawable
+ *
+ * Ends a paint started with gimp_drawable_start_paint(), emitting
+ * the deferred update.
+ *
+ * Return value: %TRUE if an update was emitted.
+ **/
+gboolean
+gimp_drawable_end_paint (GimpDrawable *drawable)
+{
+  gboolean update;
+
+  g_return_val_if_fail (GIMP_IS_DRAWABLE (drawable), FALSE);
+  g_return_val_if_fail (drawable->private->paint_count > 0, FALSE);
+
+  update = gimp_drawable_flush_paint (drawable);
+
+  drawable->private->paint_count--;
+
+  return update;
+}
+
+/**
+ * gimp_drawable_flush_paint:
+ * @drawable: a #GimpDrawable
+ *
+ * Emits the update deferred since the paint started, or since the
+ * last flush, on the calling thread, which should be the main thread.
+ *
+ * Return value: %TRUE if an update was emitted.
+ **/
+gboolean
+gimp_drawable_flush_paint (GimpDrawable *drawable)
+{
+  GeglRectangle area;
+
+  g_return_val_if_fail (GIMP_IS_DRAWABLE (drawable), FALSE);
+  g_return_val_if_fail (drawable->private->paint_count > 0, FALSE);
+
+  area = drawable->private->paint_update_area;
+
+  if (area.width <= 0 || area.height <= 0)
+    return FALSE;
+
+  drawable->private->paint_update_area.width  = 0;
+  drawable->private->paint_update_area.height = 0;
+
+  g_signal_emit (drawable, gimp_drawable_signals[UPDATE], 0,
+                 area.x, area.y, area.width, area.height);
+
+  return TRUE;
+}
+
 void
 gimp_drawable_invalidate_boundary (GimpDrawable *drawable)
 {
@@ -1438,7 +1726,13 @@ gimp_drawable_get_source_node (GimpDrawable *drawable)
   gegl_node_connect_to (filter, "output",
                         output, "input");
 
+  g_signal_connect (gegl_node_get_output_proxy (filter, "output"),
+                    "invalidated",
+                    G_CALLBACK (gimp_drawable_graph_invalidated),
+                    drawable);
+
   gimp_drawable_sync_fs_filter (drawable, FALSE);
+  gimp_drawable_sync_cache (drawable);
 
   return drawable->private->source_node;
 }
@@ -49,6 +49,8 @@ static void   gimp_drawable_stack_reorder          (GimpContainer     *container
                                                     GimpObject        *object,
                                                     gint               new_index);
 
+static void   gimp_drawable_stack_thaw             (GimpContainer     *container);
+
 static void   gimp_drawable_stack_update           (GimpDrawableStack *stack,
                                                     gint               x,
                                                     gint               y,
@@ -95,6 +97,7 @@ gimp_drawable_stack_class_init (GimpDrawableStackClass *klass)
   container_class->add      = gimp_drawable_stack_add;
   container_class->remove   = gimp_drawable_stack_remove;
   container_class->reorder  = gimp_drawable_stack_reorder;
+  container_class->thaw     = gimp_drawable_stack_thaw;
 }
 
 static void
@@ -157,6 +160,23 @@ gimp_drawable_stack_reorder (GimpContainer *container,
     gimp_drawable_stack_drawable_visible (GIMP_ITEM (object), stack);
 }
 
+static void
+gimp_drawable_stack_thaw (GimpContainer *container)
+{
+  GimpDrawableStack *stack = GIMP_DRAWABLE_STACK (container);
+  GeglRectangle      rect  = stack->frozen_update;
+
+  if (GIMP_CONTAINER_CLASS (parent_class)->thaw)
+    GIMP_CONTAINER_CLASS (parent_class)->thaw (container);
+
+  stack->frozen_update.width  = 0;
+  stack->frozen_update.height = 0;
+
+  if (! gegl_rectangle_is_empty (&rect))
+    gimp_drawable_stack_update (stack,
+                                rect.x, rect.y, rect.width, rect.height);
+}
+
 
 /*  public functions  */
 
@@ -182,6 +202,25 @@ gimp_drawable_stack_update (GimpDrawableStack *stack,
                             gint               width,
                             gint               height)
 {
+  /*  while frozen, collect all updates into one area which is
+   *  emitted on thaw
+   */
+  if (gimp_container_frozen (GIMP_CONTAINER (stack)))
+    {
+      GeglRectangle rect = { x, y, width, height };
+
+      if (gegl_rectangle_is_empty (&rect))
+        return;
+
+      if (gegl_rectangle_is_empty (&stack->frozen_update))
+        stack->frozen_update = rect;
+      else
+        gegl_rectangle_bounding_box (&stack->frozen_update,
+                                     &stack->frozen_update, &rect);
+
+      return;
+    }
+
   g_signal_emit (stack, stack_signals[UPDATE], 0,
                  x, y, width, height);
 }
@@ -36,6 +36,8 @@ typedef struct _GimpDrawableStackClass GimpDrawableStackClass;
 struct _GimpDrawableStack
 {
   GimpItemStack  parent_instance;
+
+  GeglRectangle  frozen_update;
 };
 
 struct _GimpDrawableStackClass
@@ -17,18 +17,31 @@
 
 #include "config.h"
 
+#include <stdio.h>
+#include <string.h>
+
 #include <gdk-pixbuf/gdk-pixbuf.h>
 #include <gegl.h>
+#include <glib/gstdio.h>
+#include <zlib.h>
 
 #include "libgimpbase/gimpbase.h"
 
 #include "core-types.h"
 
+#include "gimp.h"
 #include "gimp-memsize.h"
+#include "gimp-parallel.h"
 #include "gimpimage.h"
 #include "gimpdrawable.h"
 #include "gimpdrawableundo.h"
 
+#include "gimp-intl.h"
+
+
+/*  the swap file holds the buffer in compressed chunks of this size  */
+#define SWAP_CHUNK_SIZE 128
+
 
 enum
 {
@@ -39,24 +52,43 @@ enum
 };
 
 
-static void     gimp_drawable_undo_constructed  (GObject             *object);
-static void     gimp_drawable_undo_set_property (GObject             *object,
-                                                 guint                property_id,
-                                                 const GValue        *value,
-                                                 GParamSpec          *pspec);
-static void     gimp_drawable_undo_get_property (GObject             *object,
-                                                 guint                property_id,
-                                                 GValue              *value,
-                                                 GParamSpec          *pspec);
-
-static gint64   gimp_drawable_undo_get_memsize  (GimpObject          *object,
-                                                 gint64              *gui_size);
-
-static void     gimp_drawable_undo_pop          (GimpUndo            *undo,
-                                                 GimpUndoMode         undo_mode,
-                                                 GimpUndoAccumulator *accum);
-static void     gimp_drawable_undo_free         (GimpUndo            *undo,
-                                                 GimpUndoMode         undo_mode);
+typedef struct
+{
+  GeglBuffer     *buffer;
+  const Babl     *format;
+  GeglRectangle   rect;
+  gint            n_chunks_x;
+  guchar        **data;
+  gsize          *size;
+  GMutex          mutex;
+  gint            success;  /*  cleared atomically by the chunk threads  */
+} GimpDrawableUndoSwap;
+
+
+static void     gimp_drawable_undo_constructed      (GObject              *object);
+static void     gimp_drawable_undo_set_property     (GObject              *object,
+                                                     guint                 property_id,
+                                                     const GValue         *value,
+                                                     GParamSpec           *pspec);
+static void     gimp_drawable_undo_get_property     (GObject              *object,
+                                                     guint                 property_id,
+                                                     GValue               *value,
+                                                     GParamSpec           *pspec);
+
+static gint64   gimp_drawable_undo_get_memsize      (GimpObject           *object,
+                                                     gint64               *gui_size);
+
+static void     gimp_drawable_undo_pop              (GimpUndo             *undo,
+                                                     GimpUndoMode          undo_mode,
+                                                     GimpUndoAccumulator  *accum);
+static void     gimp_drawable_undo_free             (GimpUndo             *undo,
+                                                     GimpUndoMode          undo_mode);
+static gint64   gimp_drawable_undo_spill            (GimpUndo             *undo,
+                                                     const gchar          *swap_dir);
+static gint64   gimp_drawable_undo_get_spilled_size (GimpUndo             *undo);
+
+static gboolean gimp_drawable_undo_unspill          (GimpDrawableUndo     *drawable_undo,
+                                                     GError              **error);
 
 
 G_DEFINE_TYPE (GimpDrawableUndo, gimp_drawable_undo, GIMP_TYPE_ITEM_UNDO)
@@ -79,6 +111,8 @@ gimp_drawable_undo_class_init (GimpDrawableUndoClass *klass)
 
   undo_class->pop                = gimp_drawable_undo_pop;
   undo_class->free               = gimp_drawable_undo_free;
+  undo_class->spill              = gimp_drawable_undo_spill;
+  undo_class->get_spilled_size   = gimp_drawable_undo_get_spilled_size;
 
   g_object_class_install_property (object_class, PROP_BUFFER,
                                    g_param_spec_object ("buffer", NULL, NULL,
@@ -152,6 +186,7 @@ gimp_drawable_undo_get_property (GObject    *object,
   switch (property_id)
     {
     case PROP_BUFFER:
+      /*  NULL while the buffer is spilled to the swap  */
       g_value_set_object (value, drawable_undo->buffer);
       break;
     case PROP_X:
@@ -175,6 +210,7 @@ gimp_drawable_undo_get_memsize (GimpObject *object,
   gint64            memsize       = 0;
 
   memsize += gimp_gegl_buffer_get_memsize (drawable_undo->buffer);
+  memsize += gimp_string_get_memsize (drawable_undo->swap_file);
 
   return memsize + GIMP_OBJECT_CLASS (parent_class)->get_memsize (object,
                                                                   gui_size);
@@ -189,6 +225,30 @@ gimp_drawable_undo_pop (GimpUndo            *undo,
 
   GIMP_UNDO_CLASS (parent_class)->pop (undo, undo_mode, accum);
 
+  if (drawable_undo->swap_file)
+    {
+      GError *error = NULL;
+
+      /*  without the step's pixels, leave the drawable alone, in both
+       *  directions, instead of swapping anything else into it
+       */
+      if (drawable_undo->swap_failed)
+        return;
+
+      if (! gimp_drawable_undo_unspill (drawable_undo, &error))
+        {
+          gimp_message (undo->image->gimp, NULL, GIMP_MESSAGE_ERROR,
+                        _("Could not read undo data from the swap, "
+                          "'%s' can't be undone or redone: %s"),
+                        gimp_object_get_name (undo), error->message);
+          g_clear_error (&error);
+
+          drawable_undo->swap_failed = TRUE;
+
+          return;
+        }
+    }
+
   gimp_drawable_swap_pixels (GIMP_DRAWABLE (GIMP_ITEM_UNDO (undo)->item),
                              drawable_undo->buffer,
                              drawable_undo->x,
@@ -213,5 +273,310 @@ gimp_drawable_undo_free (GimpUndo     *undo,
       drawable_undo->applied_buffer = NULL;
     }
 
+  if (drawable_undo->swap_file)
+    {
+      g_unlink (drawable_undo->swap_file);
+
+      g_free (drawable_undo->swap_file);
+      drawable_undo->swap_file = NULL;
+      drawable_undo->swap_size = 0;
+    }
+
   GIMP_UNDO_CLASS (parent_class)->free (undo, undo_mode);
 }
+
+static void
+gimp_drawable_undo_get_chunk_rect (GimpDrawableUndoSwap *swap,
+                                   gint                  chunk,
+                                   GeglRectangle        *rect)
+{
+  rect->x      = (chunk % swap->n_chunks_x) * SWAP_CHUNK_SIZE;
+  rect->y      = (chunk / swap->n_chunks_x) * SWAP_CHUNK_SIZE;
+  rect->width  = MIN (SWAP_CHUNK_SIZE, swap->rect.width  - rect->x);
+  rect->height = MIN (SWAP_CHUNK_SIZE, swap->rect.height - rect->y);
+
+  rect->x += swap->rect.x;
+  rect->y += swap->rect.y;
+}
+
+static void
+gimp_drawable_undo_compress_chunks (gsize                 offset,
+                                    gsize                 size,
+                                    GimpDrawableUndoSwap *swap)
+{
+  gint    bpp = babl_format_get_bytes_per_pixel (swap->format);
+  guchar *pixels;
+  gsize   i;
+
+  pixels = g_malloc (SWAP_CHUNK_SIZE * SWAP_CHUNK_SIZE * bpp);
+
+  for (i = offset; i < offset + size; i++)
+    {
+      GeglRectangle rect;
+      uLongf        length;
+      uLong         n_bytes;
+
+      gimp_drawable_undo_get_chunk_rect (swap, i, &rect);
+
+      n_bytes = rect.width * rect.height * bpp;
+
+      gegl_buffer_get (swap->buffer, &rect, 1.0, swap->format, pixels,
+                       GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+      length = compressBound (n_bytes);
+
+      swap->data[i] = g_malloc (length);
+
+      if (compress2 (swap->data[i], &length, pixels, n_bytes,
+                     Z_BEST_SPEED) != Z_OK)
+        {
+          g_atomic_int_set (&swap->success, FALSE);
+          length = 0;
+        }
+
+      swap->size[i] = length;
+    }
+
+  g_free (pixels);
+}
+
+static void
+gimp_drawable_undo_uncompress_chunks (gsize                 offset,
+                                      gsize                 size,
+                                      GimpDrawableUndoSwap *swap)
+{
+  gint    bpp = babl_format_get_bytes_per_pixel (swap->format);
+  guchar *pixels;
+  gsize   i;
+
+  pixels = g_malloc (SWAP_CHUNK_SIZE * SWAP_CHUNK_SIZE * bpp);
+
+  for (i = offset; i < offset + size; i++)
+    {
+      GeglRectangle rect;
+      uLongf        length;
+
+      gimp_drawable_undo_get_chunk_rect (swap, i, &rect);
+
+      length = rect.width * rect.height * bpp;
+
+      if (uncompress (pixels, &length, swap->data[i], swap->size[i]) != Z_OK ||
+          length != rect.width * rect.height * bpp)
+        {
+          g_atomic_int_set (&swap->success, FALSE);
+          continue;
+        }
+
+      g_mutex_lock (&swap->mutex);
+
+      gegl_buffer_set (swap->buffer, &rect, 0, swap->format, pixels,
+                       GEGL_AUTO_ROWSTRIDE);
+
+      g_mutex_unlock (&swap->mutex);
+    }
+
+  g_free (pixels);
+}
+
+static gint64
+gimp_drawable_undo_spill (GimpUndo    *undo,
+                          const gchar *swap_dir)
+{
+  GimpDrawableUndo     *drawable_undo = GIMP_DRAWABLE_UNDO (undo);
+  GimpDrawableUndoSwap  swap;
+  gchar                *filename;
+  FILE                 *file;
+  gint                  fd;
+  gint                  n_chunks;
+  gint64                freed;
+  gint64                swap_size = 0;
+  gint                  i;
+
+  if (! drawable_undo->buffer || drawable_undo->swap_file)
+    return 0;
+
+  filename = g_build_filename (swap_dir, "gimp-undo-XXXXXX", NULL);
+
+  fd = g_mkstemp (filename);
+
+  if (fd == -1 || ! (file = fdopen (fd, "wb")))
+    {
+      if (fd != -1)
+        {
+          g_close (fd, NULL);
+          g_unlink (filename);
+        }
+
+      g_free (filename);
+
+      return 0;
+    }
+
+  swap.buffer     = drawable_undo->buffer;
+  swap.format     = gegl_buffer_get_format (drawable_undo->buffer);
+  swap.rect       = *gegl_buffer_get_extent (drawable_undo->buffer);
+  swap.n_chunks_x = (swap.rect.width + SWAP_CHUNK_SIZE - 1) / SWAP_CHUNK_SIZE;
+  swap.success    = TRUE;
+
+  n_chunks = swap.n_chunks_x *
+             ((swap.rect.height + SWAP_CHUNK_SIZE - 1) / SWAP_CHUNK_SIZE);
+
+  swap.data = g_new0 (guchar *, n_chunks);
+  swap.size = g_new0 (gsize, n_chunks);
+
+  gimp_parallel_distribute_range (n_chunks, 1,
+                                  (GimpParallelDistributeRangeFunc)
+                                  gimp_drawable_undo_compress_chunks,
+                                  &swap);
+
+  for (i = 0; i < n_chunks && swap.success; i++)
+    {
+      guint32 length = swap.size[i];
+
+      if (fwrite (&length, sizeof (length), 1, file) != 1 ||
+          fwrite (swap.data[i], 1, length, file)    != length)
+        {
+          swap.success = FALSE;
+        }
+
+      swap_size += sizeof (length) + length;
+    }
+
+  for (i = 0; i < n_chunks; i++)
+    g_free (swap.data[i]);
+
+  g_free (swap.data);
+  g_free (swap.size);
+
+  if (fclose (file) != 0 || ! swap.success)
+    {
+      g_unlink (filename);
+      g_free (filename);
+
+      return 0;
+    }
+
+  freed = gimp_gegl_buffer_get_memsize (drawable_undo->buffer);
+
+  drawable_undo->swap_file   = filename;
+  drawable_undo->swap_size   = swap_size;
+  drawable_undo->swap_format = swap.format;
+  drawable_undo->swap_rect   = swap.rect;
+
+  g_object_unref (drawable_undo->buffer);
+  drawable_undo->buffer = NULL;
+
+  /*  only the most recent undo step can be faded  */
+  if (drawable_undo->applied_buffer)
+    {
+      g_object_unref (drawable_undo->applied_buffer);
+      drawable_undo->applied_buffer = NULL;
+    }
+
+  return freed;
+}
+
+static gint64
+gimp_drawable_undo_get_spilled_size (GimpUndo *undo)
+{
+  return GIMP_DRAWABLE_UNDO (undo)->swap_size;
+}
+
+/*  Reads the buffer back from the swap.  On failure, the swap file is
+ *  kept and the undo has no buffer.
+ */
+static gboolean
+gimp_drawable_undo_unspill (GimpDrawableUndo  *drawable_undo,
+                            GError           **error)
+{
+  GimpDrawableUndoSwap  swap;
+  GeglBuffer           *buffer;
+  gchar                *contents;
+  gsize                 contents_size;
+  gsize                 pos = 0;
+  gint                  n_chunks;
+  gint                  i;
+
+  swap.format     = drawable_undo->swap_format;
+  swap.rect       = drawable_undo->swap_rect;
+  swap.n_chunks_x = (swap.rect.width + SWAP_CHUNK_SIZE - 1) / SWAP_CHUNK_SIZE;
+  swap.success    = TRUE;
+
+  buffer = gegl_buffer_new (&swap.rect, swap.format);
+
+  swap.buffer = buffer;
+
+  n_chunks = swap.n_chunks_x *
+             ((swap.rect.height + SWAP_CHUNK_SIZE - 1) / SWAP_CHUNK_SIZE);
+
+  if (g_file_get_contents (drawable_undo->swap_file,
+                           &contents, &contents_size, error))
+    {
+      swap.data = g_new0 (guchar *, n_chunks);
+      swap.size = g_new0 (gsize, n_chunks);
+
+      for (i = 0; i < n_chunks; i++)
+        {
+          guint32 length;
+
+          if (contents_size - pos < sizeof (length))
+            break;
+
+          memcpy (&length, contents + pos, sizeof (length));
+          pos += sizeof (length);
+
+          if (contents_size - pos < length)
+            break;
+
+          swap.data[i] = (guchar *) contents + pos;
+          swap.size[i] = length;
+
+          pos += length;
+        }
+
+      if (i == n_chunks)
+        {
+          g_mutex_init (&swap.mutex);
+
+          gimp_parallel_distribute_range (n_chunks, 1,
+                                          (GimpParallelDistributeRangeFunc)
+                                          gimp_drawable_undo_uncompress_chunks,
+                                          &swap);
+
+          g_mutex_clear (&swap.mutex);
+        }
+      else
+        {
+          swap.success = FALSE;
+        }
+
+      if (! swap.success)
+        g_set_error_literal (error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
+                             _("Corrupt undo swap file"));
+
+      g_free (swap.data);
+      g_free (swap.size);
+      g_free (contents);
+    }
+  else
+    {
+      swap.success = FALSE;
+    }
+
+  if (! swap.success)
+    {
+      g_object_unref (buffer);
+
+      return FALSE;
+    }
+
+  drawable_undo->buffer = buffer;
+
+  g_unlink (drawable_undo->swap_file);
+
+  g_free (drawable_undo->swap_file);
+  drawable_undo->swap_file = NULL;
+  drawable_undo->swap_size = 0;
+
+  return TRUE;
+}
@@ -44,6 +44,13 @@ struct _GimpDrawableUndo
   GeglBuffer           *applied_buffer;
   GimpLayerModeEffects  paint_mode;
   gdouble               opacity;
+
+  /* the compressed pixels of buffer, once spilled to the swap */
+  gchar                *swap_file;
+  gint64                swap_size;
+  const Babl           *swap_format;
+  GeglRectangle         swap_rect;
+  gboolean              swap_failed;  /* reading it back failed */
 };
 
 struct _GimpDrawableUndoClass
@@ -88,6 +88,15 @@ struct _GimpDynamicsOutputPrivate
   GimpCurve              *wheel_curve;
   GimpCurve              *random_curve;
   GimpCurve              *fade_curve;
+
+  /*  the curves of the enabled inputs, baked into lookup tables  */
+  gfloat                 *pressure_lut;
+  gfloat                 *velocity_lut;
+  gfloat                 *direction_lut;
+  gfloat                 *tilt_lut;
+  gfloat                 *wheel_lut;
+  gfloat                 *random_lut;
+  gfloat                 *fade_lut;
 };
 
 #define GET_PRIVATE(output) \
@@ -95,6 +104,8 @@ struct _GimpDynamicsOutputPrivate
                                      GIMP_TYPE_DYNAMICS_OUTPUT, \
                                      GimpDynamicsOutputPrivate)
 
+#define LUT_SIZE 1024
+
 
 static void   gimp_dynamics_output_finalize     (GObject           *object);
 static void   gimp_dynamics_output_set_property (GObject           *object,
@@ -113,6 +124,14 @@ static GimpCurve *
                                                  const gchar        *name);
 static void   gimp_dynamics_output_curve_dirty  (GimpCurve          *curve,
                                                  GimpDynamicsOutput *output);
+static void   gimp_dynamics_output_update_lut   (gfloat            **lut,
+                                                 GimpCurve          *curve,
+                                                 gboolean            use);
+static void   gimp_dynamics_output_update_luts  (GimpDynamicsOutput *output);
+
+static inline gdouble
+              gimp_dynamics_output_map          (const gfloat       *lut,
+                                                 gdouble             value);
 
 
 G_DEFINE_TYPE_WITH_CODE (GimpDynamicsOutput, gimp_dynamics_output,
@@ -247,6 +266,14 @@ gimp_dynamics_output_finalize (GObject *object)
   g_object_unref (private->random_curve);
   g_object_unref (private->fade_curve);
 
+  g_free (private->pressure_lut);
+  g_free (private->velocity_lut);
+  g_free (private->direction_lut);
+  g_free (private->tilt_lut);
+  g_free (private->wheel_lut);
+  g_free (private->random_lut);
+  g_free (private->fade_lut);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -331,6 +358,8 @@ gimp_dynamics_output_set_property (GObject      *object,
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
     }
+
+  gimp_dynamics_output_update_luts (GIMP_DYNAMICS_OUTPUT (object));
 }
 
 static void
@@ -451,30 +480,30 @@ gimp_dynamics_output_get_linear_value (GimpDynamicsOutput *output,
 
   if (private->use_pressure)
     {
-      total += gimp_curve_map_value (private->pressure_curve,
-                                     coords->pressure);
+      total += gimp_dynamics_output_map (private->pressure_lut,
+                                         coords->pressure);
       factors++;
     }
 
   if (private->use_velocity)
     {
-      total += gimp_curve_map_value (private->velocity_curve,
-                                    (1.0 - coords->velocity));
+      total += gimp_dynamics_output_map (private->velocity_lut,
+                                        (1.0 - coords->velocity));
       factors++;
     }
 
   if (private->use_direction)
     {
-      total += gimp_curve_map_value (private->direction_curve,
-                                     fmod (coords->direction + 0.5, 1));
+      total += gimp_dynamics_output_map (private->direction_lut,
+                                         fmod (coords->direction + 0.5, 1));
       factors++;
     }
 
   if (private->use_tilt)
     {
-      total += gimp_curve_map_value (private->tilt_curve,
-                                     (1.0 - sqrt (SQR (coords->xtilt) +
-                                      SQR (coords->ytilt))));
+      total += gimp_dynamics_output_map (private->tilt_lut,
+                                         (1.0 - sqrt (SQR (coords->xtilt) +
+                                          SQR (coords->ytilt))));
       factors++;
     }
 
@@ -484,20 +513,20 @@ gimp_dynamics_output_get_linear_value (GimpDynamicsOutput *output,
 
       wheel = coords->wheel;
 
-      total += gimp_curve_map_value (private->wheel_curve, wheel);
+      total += gimp_dynamics_output_map (private->wheel_lut, wheel);
       factors++;
     }
 
   if (private->use_random)
     {
-      total += gimp_curve_map_value (private->random_curve,
-                                     g_random_double_range (0.0, 1.0));
+      total += gimp_dynamics_output_map (private->random_lut,
+                                         g_random_double_range (0.0, 1.0));
       factors++;
     }
 
   if (private->use_fade)
     {
-      total += gimp_curve_map_value (private->fade_curve, fade_point);
+      total += gimp_dynamics_output_map (private->fade_lut, fade_point);
 
       factors++;
     }
@@ -526,22 +555,22 @@ gimp_dynamics_output_get_angular_value (GimpDynamicsOutput *output,
 
   if (private->use_pressure)
     {
-      total += gimp_curve_map_value (private->pressure_curve,
-                                     coords->pressure);
+      total += gimp_dynamics_output_map (private->pressure_lut,
+                                         coords->pressure);
       factors++;
     }
 
   if (private->use_velocity)
     {
-      total += gimp_curve_map_value (private->velocity_curve,
-                                    (1.0 - coords->velocity));
+      total += gimp_dynamics_output_map (private->velocity_lut,
+                                        (1.0 - coords->velocity));
       factors++;
     }
 
   if (private->use_direction)
     {
-      total += gimp_curve_map_value (private->direction_curve,
-                                     coords->direction);
+      total += gimp_dynamics_output_map (private->direction_lut,
+                                         coords->direction);
       factors++;
     }
 
@@ -580,7 +609,7 @@ gimp_dynamics_output_get_angular_value (GimpDynamicsOutput *output,
       while (tilt < 0.0)
         tilt += 1.0;
 
-      total += gimp_curve_map_value (private->tilt_curve, tilt);
+      total += gimp_dynamics_output_map (private->tilt_lut, tilt);
       factors++;
     }
 
@@ -588,20 +617,20 @@ gimp_dynamics_output_get_angular_value (GimpDynamicsOutput *output,
     {
       gdouble angle = 1.0 - fmod(0.5 + coords->wheel, 1);
 
-      total += gimp_curve_map_value (private->wheel_curve, angle);
+      total += gimp_dynamics_output_map (private->wheel_lut, angle);
       factors++;
     }
 
   if (private->use_random)
     {
-      total += gimp_curve_map_value (private->random_curve,
-                                     g_random_double_range (0.0, 1.0));
+      total += gimp_dynamics_output_map (private->random_lut,
+                                         g_random_double_range (0.0, 1.0));
       factors++;
     }
 
   if (private->use_fade)
     {
-      total += gimp_curve_map_value (private->fade_curve, fade_point);
+      total += gimp_dynamics_output_map (private->fade_lut, fade_point);
 
       factors++;
     }
@@ -631,22 +660,22 @@ gimp_dynamics_output_get_aspect_value (GimpDynamicsOutput *output,
 
   if (private->use_pressure)
     {
-      total += gimp_curve_map_value (private->pressure_curve,
-                                     coords->pressure);
+      total += gimp_dynamics_output_map (private->pressure_lut,
+                                         coords->pressure);
       factors++;
     }
 
   if (private->use_velocity)
     {
-      total += gimp_curve_map_value (private->velocity_curve,
-                                     coords->velocity);
+      total += gimp_dynamics_output_map (private->velocity_lut,
+                                         coords->velocity);
       factors++;
     }
 
   if (private->use_direction)
     {
-      gdouble direction = gimp_curve_map_value (private->direction_curve,
-                                                coords->direction);
+      gdouble direction = gimp_dynamics_output_map (private->direction_lut,
+                                                    coords->direction);
 
       if (((direction > 0.875) && (direction <= 1.0)) ||
           ((direction > 0.0) && (direction < 0.125))  ||
@@ -661,8 +690,8 @@ gimp_dynamics_output_get_aspect_value (GimpDynamicsOutput *output,
     {
       gdouble tilt_value =  MAX (fabs (coords->xtilt), fabs (coords->ytilt));
 
-      tilt_value = gimp_curve_map_value (private->tilt_curve,
-                                         tilt_value);
+      tilt_value = gimp_dynamics_output_map (private->tilt_lut,
+                                             tilt_value);
 
       total += tilt_value;
 
@@ -671,8 +700,8 @@ gimp_dynamics_output_get_aspect_value (GimpDynamicsOutput *output,
 
   if (private->use_wheel)
     {
-      gdouble wheel = gimp_curve_map_value (private->wheel_curve,
-                                            coords->wheel);
+      gdouble wheel = gimp_dynamics_output_map (private->wheel_lut,
+                                                coords->wheel);
 
       if (((wheel > 0.875) && (wheel <= 1.0)) ||
           ((wheel > 0.0) && (wheel < 0.125))  ||
@@ -686,8 +715,8 @@ gimp_dynamics_output_get_aspect_value (GimpDynamicsOutput *output,
 
   if (private->use_random)
     {
-      gdouble random = gimp_curve_map_value (private->random_curve,
-                                             g_random_double_range (0.0, 1.0));
+      gdouble random = gimp_dynamics_output_map (private->random_lut,
+                                                 g_random_double_range (0.0, 1.0));
 
       total += random;
       factors++;
@@ -695,7 +724,7 @@ gimp_dynamics_output_get_aspect_value (GimpDynamicsOutput *output,
 
   if (private->use_fade)
     {
-      total += gimp_curve_map_value (private->fade_curve, fade_point);
+      total += gimp_dynamics_output_map (private->fade_lut, fade_point);
 
       factors++;
     }
@@ -742,5 +771,86 @@ static void
 gimp_dynamics_output_curve_dirty (GimpCurve          *curve,
                                   GimpDynamicsOutput *output)
 {
+  gimp_dynamics_output_update_luts (output);
+
   g_object_notify (G_OBJECT (output), gimp_object_get_name (curve));
 }
+
+static void
+gimp_dynamics_output_update_lut (gfloat    **lut,
+                                 GimpCurve  *curve,
+                                 gboolean    use)
+{
+  gint i;
+
+  if (! use || ! curve)
+    {
+      g_free (*lut);
+      *lut = NULL;
+
+      return;
+    }
+
+  if (! *lut)
+    *lut = g_new (gfloat, LUT_SIZE + 1);
+
+  for (i = 0; i <= LUT_SIZE; i++)
+    (*lut)[i] = gimp_curve_map_value (curve, (gdouble) i / LUT_SIZE);
+}
+
+/*  the curves are mapped for every dab, bake the ones that are used
+ *  into tables whenever the inputs or curves change
+ */
+static void
+gimp_dynamics_output_update_luts (GimpDynamicsOutput *output)
+{
+  GimpDynamicsOutputPrivate *private = GET_PRIVATE (output);
+
+  gimp_dynamics_output_update_lut (&private->pressure_lut,
+                                   private->pressure_curve,
+                                   private->use_pressure);
+  gimp_dynamics_output_update_lut (&private->velocity_lut,
+                                   private->velocity_curve,
+                                   private->use_velocity);
+  gimp_dynamics_output_update_lut (&private->direction_lut,
+                                   private->direction_curve,
+                                   private->use_direction);
+  gimp_dynamics_output_update_lut (&private->tilt_lut,
+                                   private->tilt_curve,
+                                   private->use_tilt);
+  gimp_dynamics_output_update_lut (&private->wheel_lut,
+                                   private->wheel_curve,
+                                   private->use_wheel);
+  gimp_dynamics_output_update_lut (&private->random_lut,
+                                   private->random_curve,
+                                   private->use_random);
+  gimp_dynamics_output_update_lut (&private->fade_lut,
+                                   private->fade_curve,
+                                   private->use_fade);
+}
+
+static inline gdouble
+gimp_dynamics_output_map (const gfloat *lut,
+                          gdouble       value)
+{
+  /*  like gimp_curve_map_value(), let NaN fall through to lut[0]  */
+  if (value > 0.0 && value < 1.0)
+    {
+      gint   index;
+      gfloat f;
+
+      value *= LUT_SIZE;
+      index  = (gint) value;
+      f      = value - index;
+
+      return lut[index] + f * (lut[index + 1] - lut[index]);
+    }
+  else if (value >= 1.0)
+    {
+      return lut[LUT_SIZE];
+    }
+  else
+    {
+      return lut[0];
+    }
+}
@@ -41,11 +41,16 @@ static void   gimp_filter_stack_remove      (GimpContainer   *container,
 static void   gimp_filter_stack_reorder     (GimpContainer   *container,
                                              GimpObject      *object,
                                              gint             new_index);
+static void   gimp_filter_stack_thaw        (GimpContainer   *container);
 
+static void   gimp_filter_stack_relink      (GimpFilterStack *stack);
 static void   gimp_filter_stack_add_node    (GimpFilterStack *stack,
                                              GimpFilter      *filter);
 static void   gimp_filter_stack_remove_node (GimpFilterStack *stack,
                                              GimpFilter      *filter);
+static void   gimp_filter_stack_link        (GimpFilterStack *stack,
+                                             GeglNode        *node_below,
+                                             GeglNode        *node_above);
 
 
 G_DEFINE_TYPE (GimpFilterStack, gimp_filter_stack, GIMP_TYPE_LIST);
@@ -65,6 +70,7 @@ gimp_filter_stack_class_init (GimpFilterStackClass *klass)
   container_class->add      = gimp_filter_stack_add;
   container_class->remove   = gimp_filter_stack_remove;
   container_class->reorder  = gimp_filter_stack_reorder;
+  container_class->thaw     = gimp_filter_stack_thaw;
 }
 
 static void
@@ -115,7 +121,12 @@ gimp_filter_stack_add (GimpContainer *container,
   if (stack->graph)
     {
       gegl_node_add_child (stack->graph, gimp_filter_get_node (filter));
-      gimp_filter_stack_add_node (stack, filter);
+
+      /*  while frozen, link the graph once on thaw  */
+      if (gimp_container_frozen (container))
+        stack->relink_graph = TRUE;
+      else
+        gimp_filter_stack_add_node (stack, filter);
     }
 }
 
@@ -127,6 +138,9 @@ gimp_filter_stack_remove (GimpContainer *container,
   GimpFilter      *filter = GIMP_FILTER (object);
   gint             n_children;
 
+  if (filter == stack->cached_filter)
+    gimp_filter_stack_set_cached_filter (stack, NULL);
+
   if (stack->graph)
     {
       gimp_filter_stack_remove_node (stack, filter);
@@ -161,7 +175,10 @@ gimp_filter_stack_reorder (GimpContainer *container,
   n_children = gimp_container_get_n_children (container);
   old_index  = gimp_container_get_child_index (container, object);
 
-  if (stack->graph)
+  if (stack->graph && gimp_container_frozen (container))
+    stack->relink_graph = TRUE;
+
+  if (stack->graph && ! stack->relink_graph)
     gimp_filter_stack_remove_node (stack, filter);
 
   if (old_index == n_children -1)
@@ -190,10 +207,24 @@ gimp_filter_stack_reorder (GimpContainer *container,
       gimp_filter_set_is_last_node (last_node, TRUE);
     }
 
-  if (stack->graph)
+  if (stack->graph && ! stack->relink_graph)
     gimp_filter_stack_add_node (stack, filter);
 }
 
+static void
+gimp_filter_stack_thaw (GimpContainer *container)
+{
+  GimpFilterStack *stack = GIMP_FILTER_STACK (container);
+
+  if (GIMP_CONTAINER_CLASS (parent_class)->thaw)
+    GIMP_CONTAINER_CLASS (parent_class)->thaw (container);
+
+  if (stack->graph && stack->relink_graph)
+    gimp_filter_stack_relink (stack);
+
+  stack->relink_graph = FALSE;
+}
+
 
 /*  public functions  */
 
@@ -235,6 +266,11 @@ gimp_filter_stack_get_graph (GimpFilterStack *stack)
 
   stack->graph = gegl_node_new ();
 
+  if (stack->cached_filter)
+    stack->cache_node = gegl_node_new_child (stack->graph,
+                                             "operation", "gegl:cache",
+                                             NULL);
+
   for (list = reverse_list; list; list = g_list_next (list))
     {
       GimpFilter *filter = list->data;
@@ -246,8 +282,7 @@ gimp_filter_stack_get_graph (GimpFilterStack *stack)
       gegl_node_add_child (stack->graph, node);
 
       if (previous)
-        gegl_node_connect_to (previous, "output",
-                              node,     "input");
+        gimp_filter_stack_link (stack, previous, node);
 
       previous = node;
     }
@@ -259,8 +294,7 @@ gimp_filter_stack_get_graph (GimpFilterStack *stack)
 
   if (first && previous)
     {
-      gegl_node_connect_to (input, "output",
-                            first, "input");
+      gimp_filter_stack_link (stack, input, first);
       gegl_node_connect_to (previous, "output",
                             output,   "input");
     }
@@ -273,9 +307,87 @@ gimp_filter_stack_get_graph (GimpFilterStack *stack)
   return stack->graph;
 }
 
+/*  Puts a gegl:cache between @filter and the filters below it, so
+ *  that as long as only @filter and the filters above it change, the
+ *  composite below @filter is not rendered again. Pass %NULL to drop
+ *  the cache.
+ */
+void
+gimp_filter_stack_set_cached_filter (GimpFilterStack *stack,
+                                     GimpFilter      *filter)
+{
+  g_return_if_fail (GIMP_IS_FILTER_STACK (stack));
+  g_return_if_fail (filter == NULL || GIMP_IS_FILTER (filter));
+
+  if (filter == stack->cached_filter)
+    return;
+
+  if (stack->cache_node)
+    {
+      GeglNode *node       = gimp_filter_get_node (stack->cached_filter);
+      GeglNode *node_below = gegl_node_get_producer (stack->cache_node,
+                                                     "input", NULL);
+
+      if (node_below && ! stack->relink_graph)
+        gegl_node_connect_to (node_below, "output",
+                              node,       "input");
+      else
+        gegl_node_disconnect (node, "input");
+
+      gegl_node_disconnect (stack->cache_node, "input");
+      gegl_node_remove_child (stack->graph, stack->cache_node);
+      stack->cache_node = NULL;
+    }
+
+  stack->cached_filter = filter;
+
+  if (stack->graph && filter)
+    {
+      GeglNode *node = gimp_filter_get_node (filter);
+
+      stack->cache_node = gegl_node_new_child (stack->graph,
+                                               "operation", "gegl:cache",
+                                               NULL);
+
+      /*  while frozen, the cache is linked on thaw  */
+      if (! stack->relink_graph)
+        {
+          GeglNode *node_below = gegl_node_get_producer (node, "input", NULL);
+
+          if (node_below)
+            gimp_filter_stack_link (stack, node_below, node);
+        }
+    }
+}
+
 
 /*  private functions  */
 
+static void
+gimp_filter_stack_relink (GimpFilterStack *stack)
+{
+  GList    *list;
+  GeglNode *previous;
+  GeglNode *output;
+
+  previous = gegl_node_get_input_proxy  (stack->graph, "input");
+  output   = gegl_node_get_output_proxy (stack->graph, "output");
+
+  for (list = g_list_last (GIMP_LIST (stack)->list);
+       list;
+       list = g_list_previous (list))
+    {
+      GeglNode *node = gimp_filter_get_node (list->data);
+
+      gimp_filter_stack_link (stack, previous, node);
+
+      previous = node;
+    }
+
+  gegl_node_connect_to (previous, "output",
+                        output,   "input");
+}
+
 static void
 gimp_filter_stack_add_node (GimpFilterStack *stack,
                             GimpFilter      *filter)
@@ -303,8 +415,7 @@ gimp_filter_stack_add_node (GimpFilterStack *stack,
       node_above = gimp_filter_get_node (filter_above);
     }
 
-  gegl_node_connect_to (node,       "output",
-                        node_above, "input");
+  gimp_filter_stack_link (stack, node, node_above);
 
   filter_below = (GimpFilter *)
     gimp_container_get_child_by_index (GIMP_CONTAINER (stack), index + 1);
@@ -318,8 +429,7 @@ gimp_filter_stack_add_node (GimpFilterStack *stack,
       node_below = gegl_node_get_input_proxy (stack->graph, "input");
     }
 
-  gegl_node_connect_to (node_below, "output",
-                        node,       "input");
+  gimp_filter_stack_link (stack, node_below, node);
 }
 
 static void
@@ -363,6 +473,25 @@ gimp_filter_stack_remove_node (GimpFilterStack *stack,
       node_below = gegl_node_get_input_proxy (stack->graph, "input");
     }
 
-  gegl_node_connect_to (node_below, "output",
-                        node_above, "input");
+  gimp_filter_stack_link (stack, node_below, node_above);
+}
+
+static void
+gimp_filter_stack_link (GimpFilterStack *stack,
+                        GeglNode        *node_below,
+                        GeglNode        *node_above)
+{
+  if (stack->cache_node &&
+      node_above == gimp_filter_get_node (stack->cached_filter))
+    {
+      gegl_node_connect_to (node_below,        "output",
+                            stack->cache_node, "input");
+      gegl_node_connect_to (stack->cache_node, "output",
+                            node_above,        "input");
+    }
+  else
+    {
+      gegl_node_connect_to (node_below, "output",
+                            node_above, "input");
+    }
 }
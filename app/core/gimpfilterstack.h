@@ -35,9 +35,13 @@ typedef struct _GimpFilterStackClass GimpFilterStackClass;
 
 struct _GimpFilterStack
 {
-  GimpList  parent_instance;
+  GimpList    parent_instance;
 
-  GeglNode *graph;
+  GeglNode   *graph;
+  gboolean    relink_graph;
+
+  GimpFilter *cached_filter;
+  GeglNode   *cache_node;
 };
 
 struct _GimpFilterStackClass
@@ -46,10 +50,13 @@ struct _GimpFilterStackClass
 };
 
 
-GType           gimp_filter_stack_get_type  (void) G_GNUC_CONST;
-GimpContainer * gimp_filter_stack_new       (GType            filter_type);
+GType           gimp_filter_stack_get_type          (void) G_GNUC_CONST;
+GimpContainer * gimp_filter_stack_new               (GType            filter_type);
+
+GeglNode *      gimp_filter_stack_get_graph         (GimpFilterStack *stack);
 
-GeglNode *      gimp_filter_stack_get_graph (GimpFilterStack *stack);
+void            gimp_filter_stack_set_cached_filter (GimpFilterStack *stack,
+                                                     GimpFilter      *filter);
 
 
 #endif  /*  __GIMP_FILTER_STACK_H__  */
@@ -42,6 +42,8 @@
 static void          gimp_gradient_tagged_iface_init (GimpTaggedInterface *iface);
 static void          gimp_gradient_finalize          (GObject             *object);
 
+static void          gimp_gradient_dirty             (GimpData            *data);
+
 static gint64        gimp_gradient_get_memsize       (GimpObject          *object,
                                                       gint64              *gui_size);
 
@@ -90,6 +92,8 @@ G_DEFINE_TYPE_WITH_CODE (GimpGradient, gimp_gradient, GIMP_TYPE_DATA,
 
 #define parent_class gimp_gradient_parent_class
 
+G_LOCK_DEFINE_STATIC (lut);
+
 
 static void
 gimp_gradient_class_init (GimpGradientClass *klass)
@@ -108,6 +112,7 @@ gimp_gradient_class_init (GimpGradientClass *klass)
   viewable_class->get_popup_size    = gimp_gradient_get_popup_size;
   viewable_class->get_new_preview   = gimp_gradient_get_new_preview;
 
+  data_class->dirty                 = gimp_gradient_dirty;
   data_class->save                  = gimp_gradient_save;
   data_class->get_extension         = gimp_gradient_get_extension;
   data_class->duplicate             = gimp_gradient_duplicate;
@@ -136,9 +141,33 @@ gimp_gradient_finalize (GObject *object)
       gradient->segments = NULL;
     }
 
+  if (gradient->lut)
+    {
+      g_free (gradient->lut);
+      gradient->lut = NULL;
+    }
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
+static void
+gimp_gradient_dirty (GimpData *data)
+{
+  GimpGradient *gradient = GIMP_GRADIENT (data);
+
+  G_LOCK (lut);
+
+  if (gradient->lut)
+    {
+      g_free (gradient->lut);
+      gradient->lut = NULL;
+    }
+
+  G_UNLOCK (lut);
+
+  GIMP_DATA_CLASS (parent_class)->dirty (data);
+}
+
 static gint64
 gimp_gradient_get_memsize (GimpObject *object,
                            gint64     *gui_size)
@@ -150,6 +179,9 @@ gimp_gradient_get_memsize (GimpObject *object,
   for (segment = gradient->segments; segment; segment = segment->next)
     memsize += sizeof (GimpGradientSegment);
 
+  if (gradient->lut)
+    memsize += GIMP_GRADIENT_LUT_SIZE * sizeof (GimpRGB);
+
   return memsize + GIMP_OBJECT_CLASS (parent_class)->get_memsize (object,
                                                                   gui_size);
 }
@@ -568,6 +600,146 @@ gimp_gradient_get_segment_at (GimpGradient *gradient,
   return gimp_gradient_get_segment_at_internal (gradient, NULL, pos);
 }
 
+/**
+ * gimp_gradient_get_lut:
+ * @gradient: a gradient
+ * @context:  a context
+ *
+ * Returns a table of %GIMP_GRADIENT_LUT_SIZE colors sampled uniformly
+ * from @gradient, for use with gimp_gradient_lut_get_color().  The
+ * table is built on first use and kept until the gradient is dirtied,
+ * or, if the gradient has foreground or background segments, until it
+ * is requested with different context colors.  It may be called from
+ * any thread.
+ *
+ * Return value: the color table, owned by @gradient
+ **/
+const GimpRGB *
+gimp_gradient_get_lut (GimpGradient *gradient,
+                       GimpContext  *context)
+{
+  const GimpRGB *lut;
+  GimpRGB        fg;
+  GimpRGB        bg;
+
+  g_return_val_if_fail (GIMP_IS_GRADIENT (gradient), NULL);
+  g_return_val_if_fail (context == NULL || GIMP_IS_CONTEXT (context), NULL);
+
+  if (context)
+    {
+      gimp_context_get_foreground (context, &fg);
+      gimp_context_get_background (context, &bg);
+    }
+
+  G_LOCK (lut);
+
+  if (gradient->lut && gradient->lut_uses_context &&
+      (! context ||
+       gimp_rgba_distance (&fg, &gradient->lut_fg) > EPSILON ||
+       gimp_rgba_distance (&bg, &gradient->lut_bg) > EPSILON))
+    {
+      g_free (gradient->lut);
+      gradient->lut = NULL;
+    }
+
+  if (! gradient->lut)
+    {
+      GimpGradientSegment *seg = NULL;
+      gint                 i;
+
+      gradient->lut = g_new (GimpRGB, GIMP_GRADIENT_LUT_SIZE);
+
+      for (i = 0; i < GIMP_GRADIENT_LUT_SIZE; i++)
+        {
+          gdouble pos = (gdouble) i / (gdouble) (GIMP_GRADIENT_LUT_SIZE - 1);
+
+          seg = gimp_gradient_get_color_at (gradient, context, seg,
+                                            pos, FALSE, gradient->lut + i);
+        }
+
+      gradient->lut_uses_context = gimp_gradient_has_fg_bg_segments (gradient);
+
+      if (context)
+        {
+          gradient->lut_fg = fg;
+          gradient->lut_bg = bg;
+        }
+    }
+
+  lut = gradient->lut;
+
+  G_UNLOCK (lut);
+
+  return lut;
+}
+
+/**
+ * gimp_gradient_lut_get_color:
+ * @lut:     a table returned by gimp_gradient_get_lut()
+ * @pos:     position in the gradient, between 0.0 and 1.0
+ * @reverse: whether the gradient is reversed
+ * @color:   returns the color
+ *
+ * Looks up the color at @pos, interpolating linearly between the two
+ * nearest colors of @lut.
+ **/
+void
+gimp_gradient_lut_get_color (const GimpRGB *lut,
+                             gdouble        pos,
+                             gboolean       reverse,
+                             GimpRGB       *color)
+{
+  gint i;
+
+  pos = CLAMP (pos, 0.0, 1.0);
+
+  if (reverse)
+    pos = 1.0 - pos;
+
+  pos *= GIMP_GRADIENT_LUT_SIZE - 1;
+  i    = (gint) pos;
+
+  if (i < GIMP_GRADIENT_LUT_SIZE - 1)
+    {
+      const GimpRGB *c0 = &lut[i];
+      const GimpRGB *c1 = &lut[i + 1];
+
+      pos -= i;
+
+      color->r = c0->r + (c1->r - c0->r) * pos;
+      color->g = c0->g + (c1->g - c0->g) * pos;
+      color->b = c0->b + (c1->b - c0->b) * pos;
+      color->a = c0->a + (c1->a - c0->a) * pos;
+    }
+  else
+    {
+      *color = lut[GIMP_GRADIENT_LUT_SIZE - 1];
+    }
+}
+
+/**
+ * gimp_gradient_lut_get_colors:
+ * @lut:      a table returned by gimp_gradient_get_lut()
+ * @pos:      @n_colors positions in the gradient
+ * @n_colors: the number of colors to look up
+ * @reverse:  whether the gradient is reversed
+ * @colors:   returns @n_colors colors
+ *
+ * Like gimp_gradient_lut_get_color(), for an array of positions.
+ **/
+void
+gimp_gradient_lut_get_colors (const GimpRGB *lut,
+                              const gdouble *pos,
+                              gint           n_colors,
+                              gboolean       reverse,
+                              GimpRGB       *colors)
+{
+  gint i;
+
+  for (i = 0; i < n_colors; i++)
+    gimp_gradient_lut_get_color (lut, pos[i], reverse, colors + i);
+}
+
 gboolean
 gimp_gradient_has_fg_bg_segments (GimpGradient *gradient)
 {
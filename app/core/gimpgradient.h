@@ -24,6 +24,9 @@
 
 #define GIMP_GRADIENT_DEFAULT_SAMPLE_SIZE 40
 
+/*  the number of colors in a gradient's lookup table  */
+#define GIMP_GRADIENT_LUT_SIZE            16384
+
 
 struct _GimpGradientSegment
 {
@@ -57,6 +60,12 @@ struct _GimpGradient
   GimpData             parent_instance;
 
   GimpGradientSegment *segments;
+
+  /*  cached colors, see gimp_gradient_get_lut()  */
+  GimpRGB             *lut;
+  gboolean             lut_uses_context;
+  GimpRGB              lut_fg;
+  GimpRGB              lut_bg;
 };
 
 struct _GimpGradientClass
@@ -80,6 +89,18 @@ GimpGradientSegment * gimp_gradient_get_color_at   (GimpGradient        *gradien
 GimpGradientSegment * gimp_gradient_get_segment_at (GimpGradient  *grad,
                                                     gdouble        pos);
 
+const GimpRGB       * gimp_gradient_get_lut        (GimpGradient        *gradient,
+                                                    GimpContext         *context);
+void                  gimp_gradient_lut_get_color  (const GimpRGB       *lut,
+                                                    gdouble              pos,
+                                                    gboolean             reverse,
+                                                    GimpRGB             *color);
+void                  gimp_gradient_lut_get_colors (const GimpRGB       *lut,
+                                                    const gdouble       *pos,
+                                                    gint                 n_colors,
+                                                    gboolean             reverse,
+                                                    GimpRGB             *colors);
+
 gboolean          gimp_gradient_has_fg_bg_segments (GimpGradient  *gradient);
 GimpGradient    * gimp_gradient_flatten            (GimpGradient  *gradient,
                                                     GimpContext   *context);
@@ -36,6 +36,7 @@
 #include "gimpimage.h"
 #include "gimpimage-undo-push.h"
 #include "gimpdrawablestack.h"
+#include "gimpfilterstack.h"
 #include "gimppickable.h"
 #include "gimpprojectable.h"
 #include "gimpprojection.h"
@@ -51,7 +52,9 @@ struct _GimpGroupLayerPrivate
   GimpProjection *projection;
   GeglNode       *graph;
   GeglNode       *offset_node;
+  GHashTable     *child_bounds;   /*  child -> GeglRectangle  */
   gint            suspend_resize;
+  gboolean        flush_pending;
   gboolean        expanded;
 
   /*  hackish temp states to make the projection/tiles stuff work  */
@@ -162,9 +165,22 @@ static void            gimp_group_layer_child_move   (GimpLayer       *child,
                                                       GimpGroupLayer  *group);
 static void            gimp_group_layer_child_resize (GimpLayer       *child,
                                                       GimpGroupLayer  *group);
+static void            gimp_group_layer_child_update (GimpLayer       *child,
+                                                      gint             x,
+                                                      gint             y,
+                                                      gint             width,
+                                                      gint             height,
+                                                      GimpGroupLayer  *group);
 
-static void            gimp_group_layer_update       (GimpGroupLayer  *group);
+static void            gimp_group_layer_update       (GimpGroupLayer  *group,
+                                                      GimpItem        *child,
+                                                      gboolean         removed);
 static void            gimp_group_layer_update_size  (GimpGroupLayer  *group);
+static void            gimp_group_layer_set_bounds   (GimpGroupLayer  *group,
+                                                      gint             x,
+                                                      gint             y,
+                                                      gint             width,
+                                                      gint             height);
 
 static void            gimp_group_layer_stack_update (GimpDrawableStack *stack,
                                                       gint               x,
@@ -259,8 +275,12 @@ gimp_group_layer_init (GimpGroupLayer *group)
 {
   GimpGroupLayerPrivate *private = GET_PRIVATE (group);
 
-  private->children = gimp_drawable_stack_new (GIMP_TYPE_LAYER);
-  private->expanded = TRUE;
+  private->children     = gimp_drawable_stack_new (GIMP_TYPE_LAYER);
+  private->child_bounds = g_hash_table_new_full (g_direct_hash,
+                                                 g_direct_equal,
+                                                 NULL,
+                                                 (GDestroyNotify) g_free);
+  private->expanded     = TRUE;
 
   g_signal_connect (private->children, "add",
                     G_CALLBACK (gimp_group_layer_child_add),
@@ -278,6 +298,9 @@ gimp_group_layer_init (GimpGroupLayer *group)
   gimp_container_add_handler (private->children, "size-changed",
                               G_CALLBACK (gimp_group_layer_child_resize),
                               group);
+  gimp_container_add_handler (private->children, "update",
+                              G_CALLBACK (gimp_group_layer_child_update),
+                              group);
 
   g_signal_connect (private->children, "update",
                     G_CALLBACK (gimp_group_layer_stack_update),
@@ -311,6 +334,12 @@ gimp_group_layer_finalize (GObject *object)
       private->children = NULL;
     }
 
+  if (private->child_bounds)
+    {
+      g_hash_table_unref (private->child_bounds);
+      private->child_bounds = NULL;
+    }
+
   if (private->projection)
     {
       g_object_unref (private->projection);
@@ -1066,6 +1095,13 @@ gimp_group_layer_resume_resize (GimpGroupLayer *group,
   if (private->suspend_resize == 0)
     {
       gimp_group_layer_update_size (group);
+
+      if (private->flush_pending)
+        {
+          private->flush_pending = FALSE;
+
+          gimp_pickable_flush (GIMP_PICKABLE (private->projection));
+        }
     }
 }
 
@@ -1077,7 +1113,7 @@ gimp_group_layer_child_add (GimpContainer  *container,
                             GimpLayer      *child,
                             GimpGroupLayer *group)
 {
-  gimp_group_layer_update (group);
+  gimp_group_layer_update (group, GIMP_ITEM (child), FALSE);
 }
 
 static void
@@ -1085,7 +1121,7 @@ gimp_group_layer_child_remove (GimpContainer  *container,
                                GimpLayer      *child,
                                GimpGroupLayer *group)
 {
-  gimp_group_layer_update (group);
+  gimp_group_layer_update (group, GIMP_ITEM (child), TRUE);
 }
 
 static void
@@ -1093,39 +1129,136 @@ gimp_group_layer_child_move (GimpLayer      *child,
                              GParamSpec     *pspec,
                              GimpGroupLayer *group)
 {
-  gimp_group_layer_update (group);
+  gimp_group_layer_update (group, GIMP_ITEM (child), FALSE);
 }
 
 static void
 gimp_group_layer_child_resize (GimpLayer      *child,
                                GimpGroupLayer *group)
 {
-  gimp_group_layer_update (group);
+  gimp_group_layer_update (group, GIMP_ITEM (child), FALSE);
+}
+
+/*  Caches the composite of the children below the child that is being
+ *  painted on, so e.g. each dab of a stroke only renders that child
+ *  and the ones above it again. There is nothing to cache below the
+ *  bottom child.
+ */
+static void
+gimp_group_layer_child_update (GimpLayer      *child,
+                               gint            x,
+                               gint            y,
+                               gint            width,
+                               gint            height,
+                               GimpGroupLayer *group)
+{
+  GimpGroupLayerPrivate *private  = GET_PRIVATE (group);
+  GimpContainer         *children = private->children;
+  gint                   index;
+
+  index = gimp_container_get_child_index (children, GIMP_OBJECT (child));
+
+  if (index == gimp_container_get_n_children (children) - 1)
+    child = NULL;
+
+  gimp_filter_stack_set_cached_filter (GIMP_FILTER_STACK (children),
+                                       GIMP_FILTER (child));
 }
 
+/*  Keeps the per-child bounds index up to date and, if possible,
+ *  derives the group's new bounds from the one child that changed
+ *  instead of walking all children. The full walk is only needed if
+ *  the child's old bounds touched the group's bounds, because only
+ *  then the group can shrink.
+ */
 static void
-gimp_group_layer_update (GimpGroupLayer *group)
+gimp_group_layer_update (GimpGroupLayer *group,
+                         GimpItem       *child,
+                         gboolean        removed)
 {
-  if (GET_PRIVATE (group)->suspend_resize == 0)
+  GimpGroupLayerPrivate *private = GET_PRIVATE (group);
+  GimpItem              *item    = GIMP_ITEM (group);
+  GeglRectangle         *child_rect;
+  GeglRectangle          old_rect;
+  GeglRectangle          bounds;
+  gboolean               had_old = FALSE;
+  gint                   n_children;
+
+  child_rect = g_hash_table_lookup (private->child_bounds, child);
+
+  if (child_rect)
+    {
+      old_rect = *child_rect;
+      had_old  = TRUE;
+    }
+
+  n_children = g_hash_table_size (private->child_bounds);
+
+  if (removed)
+    {
+      g_hash_table_remove (private->child_bounds, child);
+    }
+  else
+    {
+      if (! child_rect)
+        {
+          child_rect = g_new0 (GeglRectangle, 1);
+          g_hash_table_insert (private->child_bounds, child, child_rect);
+        }
+
+      gimp_item_get_offset (child, &child_rect->x, &child_rect->y);
+      child_rect->width  = gimp_item_get_width  (child);
+      child_rect->height = gimp_item_get_height (child);
+    }
+
+  if (private->suspend_resize > 0)
+    return;
+
+  /*  an empty group's 1x1 bounds don't mean anything  */
+  if (private->reallocate_projection ||
+      n_children == 0                ||
+      (had_old && n_children == 1))
     {
       gimp_group_layer_update_size (group);
+      return;
+    }
+
+  gimp_item_get_offset (item, &bounds.x, &bounds.y);
+  bounds.width  = gimp_item_get_width  (item);
+  bounds.height = gimp_item_get_height (item);
+
+  if (had_old &&
+      (old_rect.x                   <= bounds.x                ||
+       old_rect.y                   <= bounds.y                ||
+       old_rect.x + old_rect.width  >= bounds.x + bounds.width ||
+       old_rect.y + old_rect.height >= bounds.y + bounds.height))
+    {
+      gimp_group_layer_update_size (group);
+      return;
+    }
+
+  if (removed)
+    return;
+
+  if (! gegl_rectangle_contains (&bounds, child_rect))
+    {
+      gegl_rectangle_bounding_box (&bounds, &bounds, child_rect);
+
+      gimp_group_layer_set_bounds (group,
+                                   bounds.x, bounds.y,
+                                   bounds.width, bounds.height);
     }
 }
 
 static void
 gimp_group_layer_update_size (GimpGroupLayer *group)
 {
-  GimpGroupLayerPrivate *private    = GET_PRIVATE (group);
-  GimpItem              *item       = GIMP_ITEM (group);
-  gint                   old_x      = gimp_item_get_offset_x (item);
-  gint                   old_y      = gimp_item_get_offset_y (item);
-  gint                   old_width  = gimp_item_get_width  (item);
-  gint                   old_height = gimp_item_get_height (item);
-  gint                   x          = 0;
-  gint                   y          = 0;
-  gint                   width      = 1;
-  gint                   height     = 1;
-  gboolean               first      = TRUE;
+  GimpGroupLayerPrivate *private = GET_PRIVATE (group);
+  gint                   x       = 0;
+  gint                   y       = 0;
+  gint                   width   = 1;
+  gint                   height  = 1;
+  gboolean               first   = TRUE;
   GList                 *list;
 
   for (list = gimp_item_stack_get_item_iter (GIMP_ITEM_STACK (private->children));
@@ -1154,6 +1287,23 @@ gimp_group_layer_update_size (GimpGroupLayer *group)
         }
     }
 
+  gimp_group_layer_set_bounds (group, x, y, width, height);
+}
+
+static void
+gimp_group_layer_set_bounds (GimpGroupLayer *group,
+                             gint            x,
+                             gint            y,
+                             gint            width,
+                             gint            height)
+{
+  GimpGroupLayerPrivate *private    = GET_PRIVATE (group);
+  GimpItem              *item       = GIMP_ITEM (group);
+  gint                   old_x      = gimp_item_get_offset_x (item);
+  gint                   old_y      = gimp_item_get_offset_y (item);
+  gint                   old_width  = gimp_item_get_width  (item);
+  gint                   old_height = gimp_item_get_height (item);
+
   if (private->reallocate_projection ||
       x      != old_x                ||
       y      != old_y                ||
@@ -1232,6 +1382,17 @@ gimp_group_layer_stack_update (GimpDrawableStack *stack,
   gimp_projectable_invalidate (GIMP_PROJECTABLE (group),
                                x, y, width, height);
 
+  /*  while resizing is suspended, all children are usually touched
+   *  one after the other (think translating the whole group), so
+   *  only collect the invalidated areas and flush them all at once
+   *  when resizing is resumed
+   */
+  if (GET_PRIVATE (group)->suspend_resize > 0)
+    {
+      GET_PRIVATE (group)->flush_pending = TRUE;
+      return;
+    }
+
   /*  flush the pickable not the projectable because flushing the
    *  pickable will finish all invalidation on the projection so it
    *  can be used as source (note that it will still be constructed
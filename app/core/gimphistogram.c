@@ -29,9 +29,16 @@
 
 #include "gegl/gimp-babl.h"
 
+#include "gimp-parallel.h"
 #include "gimphistogram.h"
 
 
+/*  the size of the areas that are binned separately, and kept around
+ *  for incremental updates
+ */
+#define CHUNK_SIZE 256
+
+
 enum
 {
   PROP_0,
@@ -42,31 +49,72 @@ enum
 
 struct _GimpHistogramPrivate
 {
-  gboolean gamma_correct;
-  gint     n_channels;
-  gint     n_bins;
-  gdouble *values;
+  gboolean        gamma_correct;
+  gint            n_channels;
+  gint            n_bins;
+  gdouble        *values;
+
+  gboolean        incremental;
+  gdouble       **chunk_values;
+  gint            n_chunks;
+  GeglRectangle   chunk_buffer;
+  gboolean        chunk_has_mask;
+  GeglRectangle   chunk_mask;
+  const Babl     *chunk_format;
 };
 
+typedef struct
+{
+  GeglBuffer     *buffer;
+  GeglRectangle   buffer_rect;
+  GeglBuffer     *mask;
+  GeglRectangle   mask_rect;
+  const Babl     *format;
+  gint            n_components;
+  gint            n_bins;
+  gint            n_values;
+  gint            n_chunks_x;
+  gint            n_chunks;
+  const gint     *chunks;
+  gdouble       **chunk_values;
+  gdouble        *values;
+  GMutex          mutex;
+} GimpHistogramCalculate;
 
-/*  local function prototypes  */
-
-static void     gimp_histogram_finalize     (GObject       *object);
-static void     gimp_histogram_set_property (GObject       *object,
-                                             guint          property_id,
-                                             const GValue  *value,
-                                             GParamSpec    *pspec);
-static void     gimp_histogram_get_property (GObject       *object,
-                                             guint          property_id,
-                                             GValue        *value,
-                                             GParamSpec    *pspec);
 
-static gint64   gimp_histogram_get_memsize  (GimpObject    *object,
-                                             gint64        *gui_size);
+/*  local function prototypes  */
 
-static void     gimp_histogram_alloc_values (GimpHistogram *histogram,
-                                             gint           n_components,
-                                             gint           n_bins);
+static void          gimp_histogram_finalize        (GObject                *object);
+static void          gimp_histogram_set_property    (GObject                *object,
+                                                     guint                   property_id,
+                                                     const GValue           *value,
+                                                     GParamSpec             *pspec);
+static void          gimp_histogram_get_property    (GObject                *object,
+                                                     guint                   property_id,
+                                                     GValue                 *value,
+                                                     GParamSpec             *pspec);
+
+static gint64        gimp_histogram_get_memsize     (GimpObject             *object,
+                                                     gint64                 *gui_size);
+
+static void          gimp_histogram_alloc_values    (GimpHistogram          *histogram,
+                                                     gint                    n_components,
+                                                     gint                    n_bins);
+
+static const Babl *  gimp_histogram_get_format      (GimpHistogram          *histogram,
+                                                     const Babl             *format);
+static gint          gimp_histogram_get_n_bins      (GeglBuffer             *buffer);
+static void          gimp_histogram_clear_chunks    (GimpHistogram          *histogram);
+static void          gimp_histogram_add_values      (gdouble                *values,
+                                                     const gdouble          *add,
+                                                     gint                    n_values,
+                                                     gdouble                 factor);
+static void          gimp_histogram_calculate_range (gsize                   offset,
+                                                     gsize                   size,
+                                                     GimpHistogramCalculate *calc);
+static void          gimp_histogram_calculate_chunk (GimpHistogramCalculate *calc,
+                                                     const GeglRectangle    *rect,
+                                                     gdouble                *values);
 
 
 G_DEFINE_TYPE (GimpHistogram, gimp_histogram, GIMP_TYPE_OBJECT)
@@ -179,6 +227,12 @@ gimp_histogram_get_memsize (GimpObject *object,
     memsize += (histogram->priv->n_channels *
                 histogram->priv->n_bins * sizeof (gdouble));
 
+  if (histogram->priv->chunk_values)
+    memsize += (histogram->priv->n_chunks *
+                (sizeof (gdouble *) +
+                 histogram->priv->n_channels *
+                 histogram->priv->n_bins * sizeof (gdouble)));
+
   return memsize + GIMP_OBJECT_CLASS (parent_class)->get_memsize (object,
                                                                   gui_size);
 }
@@ -230,11 +284,11 @@ gimp_histogram_calculate (GimpHistogram       *histogram,
                           GeglBuffer          *mask,
                           const GeglRectangle *mask_rect)
 {
-  GimpHistogramPrivate *priv;
-  GeglBufferIterator   *iter;
-  const Babl           *format;
-  gint                  n_components;
-  gint                  n_bins;
+  GimpHistogramPrivate   *priv;
+  GimpHistogramCalculate  calc = { 0, };
+  const Babl             *format;
+  gint                    n_values;
+  gint                    i;
 
   g_return_if_fail (GIMP_IS_HISTOGRAM (histogram));
   g_return_if_fail (GEGL_IS_BUFFER (buffer));
@@ -242,239 +296,215 @@ gimp_histogram_calculate (GimpHistogram       *histogram,
 
   priv = histogram->priv;
 
-  format = gegl_buffer_get_format (buffer);
-
-  if (babl_format_get_type (format, 0) == babl_type ("u8"))
-    n_bins = 256;
-  else
-    n_bins = 1024;
+  format = gimp_histogram_get_format (histogram,
+                                      gegl_buffer_get_format (buffer));
 
-  if (babl_format_is_palette (format))
-    {
-      if (babl_format_has_alpha (format))
-        format = babl_format ("R'G'B'A float");
-      else
-        format = babl_format ("R'G'B' float");
-    }
-  else
-    {
-      const Babl *model = babl_format_get_model (format);
+  if (! format)
+    return;
 
-      if (model == babl_model ("Y"))
-        {
-          if (priv->gamma_correct)
-            format = babl_format ("Y' float");
-          else
-            format = babl_format ("Y float");
-        }
-      else if (model == babl_model ("Y'"))
-        {
-          format = babl_format ("Y' float");
-        }
-      else if (model == babl_model ("YA"))
-        {
-          if (priv->gamma_correct)
-            format = babl_format ("Y'A float");
-          else
-            format = babl_format ("YA float");
-        }
-      else if (model == babl_model ("Y'A"))
-        {
-          format = babl_format ("Y'A float");
-        }
-      else if (model == babl_model ("RGB"))
-        {
-          if (priv->gamma_correct)
-            format = babl_format ("R'G'B' float");
-          else
-            format = babl_format ("RGB float");
-        }
-      else if (model == babl_model ("R'G'B'"))
-        {
-          format = babl_format ("R'G'B' float");
-        }
-      else if (model == babl_model ("RGBA"))
-        {
-          if (priv->gamma_correct)
-            format = babl_format ("R'G'B'A float");
-          else
-            format = babl_format ("RGBA float");
-        }
-      else if (model == babl_model ("R'G'B'A"))
-        {
-          format = babl_format ("R'G'B'A float");
-        }
-      else
-        {
-          g_return_if_reached ();
-        }
-    }
+  g_object_freeze_notify (G_OBJECT (histogram));
 
-  n_components = babl_format_get_n_components (format);
+  gimp_histogram_clear_chunks (histogram);
 
-  g_object_freeze_notify (G_OBJECT (histogram));
+  gimp_histogram_alloc_values (histogram,
+                               babl_format_get_n_components (format),
+                               gimp_histogram_get_n_bins (buffer));
 
-  gimp_histogram_alloc_values (histogram, n_components, n_bins);
+  n_values = priv->n_channels * priv->n_bins;
 
-  iter = gegl_buffer_iterator_new (buffer, buffer_rect, 0, format,
-                                   GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
+  calc.buffer       = buffer;
+  calc.buffer_rect  = *buffer_rect;
+  calc.mask         = mask;
+  calc.format       = format;
+  calc.n_components = babl_format_get_n_components (format);
+  calc.n_bins       = priv->n_bins;
+  calc.n_values     = n_values;
+  calc.n_chunks_x   = (buffer_rect->width  + CHUNK_SIZE - 1) / CHUNK_SIZE;
+  calc.values       = priv->values;
 
   if (mask)
-    gegl_buffer_iterator_add (iter, mask, mask_rect, 0,
-                              babl_format ("Y float"),
-                              GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
-
-#define VALUE(c,i) (priv->values[(c) * priv->n_bins + \
-                                 (gint) (CLAMP ((i), 0.0, 1.0) * \
-                                         (priv->n_bins - 0.0001))])
+    calc.mask_rect = *mask_rect;
 
-  while (gegl_buffer_iterator_next (iter))
-    {
-      const gfloat *data   = iter->data[0];
-      gint          length = iter->length;
-      gfloat        max;
+  g_mutex_init (&calc.mutex);
 
-      if (mask)
-        {
-          const gfloat *mask_data = iter->data[1];
+  calc.n_chunks = calc.n_chunks_x *
+                  ((buffer_rect->height + CHUNK_SIZE - 1) / CHUNK_SIZE);
 
-          switch (n_components)
-            {
-            case 1:
-              while (length--)
-                {
-                  const gdouble masked = *mask_data;
+  if (priv->incremental && calc.n_chunks > 0)
+    {
+      /*  remember the per-chunk values, so gimp_histogram_calculate_area()
+       *  only needs to rebin the chunks that changed
+       */
+      priv->chunk_values   = g_new0 (gdouble *, calc.n_chunks);
+      priv->n_chunks       = calc.n_chunks;
+      priv->chunk_buffer   = *buffer_rect;
+      priv->chunk_has_mask = mask != NULL;
+      priv->chunk_mask     = calc.mask_rect;
+      priv->chunk_format   = format;
+
+      calc.chunk_values = priv->chunk_values;
+    }
 
-                  VALUE (0, data[0]) += masked;
+  gimp_parallel_distribute_range (calc.n_chunks, 1,
+                                  (GimpParallelDistributeRangeFunc)
+                                  gimp_histogram_calculate_range,
+                                  &calc);
 
-                  data += n_components;
-                  mask_data += 1;
-                }
-              break;
-
-            case 2:
-              while (length--)
-                {
-                  const gdouble masked = *mask_data;
-                  const gdouble weight = data[1];
+  if (calc.chunk_values)
+    {
+      for (i = 0; i < calc.n_chunks; i++)
+        gimp_histogram_add_values (priv->values, calc.chunk_values[i],
+                                   n_values, 1.0);
+    }
 
-                  VALUE (0, data[0]) += weight * masked;
-                  VALUE (1, data[1]) += masked;
+  g_mutex_clear (&calc.mutex);
 
-                  data += n_components;
-                  mask_data += 1;
-                }
-              break;
+  g_object_notify (G_OBJECT (histogram), "values");
 
-            case 3: /* calculate separate value values */
-              while (length--)
-                {
-                  const gdouble masked = *mask_data;
+  g_object_thaw_notify (G_OBJECT (histogram));
+}
 
-                  VALUE (1, data[0]) += masked;
-                  VALUE (2, data[1]) += masked;
-                  VALUE (3, data[2]) += masked;
+/**
+ * gimp_histogram_calculate_area:
+ * @histogram:   a %GimpHistogram
+ * @buffer:      the buffer to calculate the histogram of
+ * @buffer_rect: the area of @buffer the histogram covers
+ * @mask:        an optional mask
+ * @mask_rect:   the area of @mask corresponding to @buffer_rect
+ * @area:        the area of @buffer that changed
+ *
+ * Updates @histogram after the pixels in @area changed. If @histogram
+ * is incremental and was last calculated with the same arguments,
+ * only the contributions of the chunks intersecting @area are
+ * recalculated, otherwise this is the same as
+ * gimp_histogram_calculate().
+ **/
+void
+gimp_histogram_calculate_area (GimpHistogram       *histogram,
+                               GeglBuffer          *buffer,
+                               const GeglRectangle *buffer_rect,
+                               GeglBuffer          *mask,
+                               const GeglRectangle *mask_rect,
+                               const GeglRectangle *area)
+{
+  GimpHistogramPrivate   *priv;
+  GimpHistogramCalculate  calc = { 0, };
+  const Babl             *format;
+  GeglRectangle           rect;
+  gint                   *chunks;
+  gint                    x1, y1, x2, y2;
+  gint                    x, y;
+  gint                    i;
 
-                  max = MAX (data[0], data[1]);
-                  max = MAX (data[2], max);
+  g_return_if_fail (GIMP_IS_HISTOGRAM (histogram));
+  g_return_if_fail (GEGL_IS_BUFFER (buffer));
+  g_return_if_fail (buffer_rect != NULL);
+  g_return_if_fail (area != NULL);
 
-                  VALUE (0, max) += masked;
+  priv = histogram->priv;
 
-                  data += n_components;
-                  mask_data += 1;
-                }
-              break;
+  format = gimp_histogram_get_format (histogram,
+                                      gegl_buffer_get_format (buffer));
 
-            case 4: /* calculate separate value values */
-              while (length--)
-                {
-                  const gdouble masked = *mask_data;
-                  const gdouble weight = data[3];
+  if (! priv->chunk_values                                       ||
+      format != priv->chunk_format                               ||
+      ! gegl_rectangle_equal (buffer_rect, &priv->chunk_buffer)  ||
+      (mask != NULL) != priv->chunk_has_mask                     ||
+      (mask && ! gegl_rectangle_equal (mask_rect, &priv->chunk_mask)))
+    {
+      gimp_histogram_calculate (histogram,
+                                buffer, buffer_rect, mask, mask_rect);
+      return;
+    }
 
-                  VALUE (1, data[0]) += weight * masked;
-                  VALUE (2, data[1]) += weight * masked;
-                  VALUE (3, data[2]) += weight * masked;
-                  VALUE (4, data[3]) += masked;
+  if (! gegl_rectangle_intersect (&rect, area, buffer_rect))
+    return;
 
-                  max = MAX (data[0], data[1]);
-                  max = MAX (data[2], max);
+  calc.buffer       = buffer;
+  calc.buffer_rect  = *buffer_rect;
+  calc.mask         = mask;
+  calc.mask_rect    = priv->chunk_mask;
+  calc.format       = format;
+  calc.n_components = babl_format_get_n_components (format);
+  calc.n_bins       = priv->n_bins;
+  calc.n_values     = priv->n_channels * priv->n_bins;
+  calc.n_chunks_x   = (buffer_rect->width + CHUNK_SIZE - 1) / CHUNK_SIZE;
+  calc.values       = priv->values;
+  calc.chunk_values = priv->chunk_values;
 
-                  VALUE (0, max) += weight * masked;
+  x1 = (rect.x - buffer_rect->x) / CHUNK_SIZE;
+  y1 = (rect.y - buffer_rect->y) / CHUNK_SIZE;
+  x2 = (rect.x + rect.width  - 1 - buffer_rect->x) / CHUNK_SIZE;
+  y2 = (rect.y + rect.height - 1 - buffer_rect->y) / CHUNK_SIZE;
 
-                  data += n_components;
-                  mask_data += 1;
-                }
-              break;
-            }
-        }
-      else /* no mask */
-        {
-          switch (n_components)
-            {
-            case 1:
-              while (length--)
-                {
-                  VALUE (0, data[0]) += 1.0;
+  chunks = g_new (gint, (x2 - x1 + 1) * (y2 - y1 + 1));
 
-                  data += n_components;
-                }
-              break;
+  /*  take the damaged chunks' old contributions out of the histogram  */
+  for (y = y1; y <= y2; y++)
+    for (x = x1; x <= x2; x++)
+      {
+        gint chunk = y * calc.n_chunks_x + x;
 
-            case 2:
-              while (length--)
-                {
-                  const gdouble weight = data[1];
+        gimp_histogram_add_values (priv->values, priv->chunk_values[chunk],
+                                   calc.n_values, -1.0);
 
-                  VALUE (0, data[0]) += weight;
-                  VALUE (1, data[1]) += 1.0;
+        g_free (priv->chunk_values[chunk]);
+        priv->chunk_values[chunk] = NULL;
 
-                  data += n_components;
-                }
-              break;
+        chunks[calc.n_chunks++] = chunk;
+      }
 
-            case 3: /* calculate separate value values */
-              while (length--)
-                {
-                  VALUE (1, data[0]) += 1.0;
-                  VALUE (2, data[1]) += 1.0;
-                  VALUE (3, data[2]) += 1.0;
+  calc.chunks = chunks;
 
-                  max = MAX (data[0], data[1]);
-                  max = MAX (data[2], max);
+  g_mutex_init (&calc.mutex);
 
-                  VALUE (0, max) += 1.0;
+  gimp_parallel_distribute_range (calc.n_chunks, 1,
+                                  (GimpParallelDistributeRangeFunc)
+                                  gimp_histogram_calculate_range,
+                                  &calc);
 
-                  data += n_components;
-                }
-              break;
+  g_mutex_clear (&calc.mutex);
 
-            case 4: /* calculate separate value values */
-              while (length--)
-                {
-                  const gdouble weight = data[3];
+  /*  and add their new ones  */
+  for (i = 0; i < calc.n_chunks; i++)
+    gimp_histogram_add_values (priv->values,
+                               priv->chunk_values[chunks[i]],
+                               calc.n_values, 1.0);
 
-                  VALUE (1, data[0]) += weight;
-                  VALUE (2, data[1]) += weight;
-                  VALUE (3, data[2]) += weight;
-                  VALUE (4, data[3]) += 1.0;
+  g_free (chunks);
 
-                  max = MAX (data[0], data[1]);
-                  max = MAX (data[2], max);
+  g_object_notify (G_OBJECT (histogram), "values");
+}
 
-                  VALUE (0, max) += weight;
+/**
+ * gimp_histogram_set_incremental:
+ * @histogram:   a %GimpHistogram
+ * @incremental: whether to keep per-chunk values
+ *
+ * An incremental histogram keeps the values of each chunk of the
+ * buffer it was calculated from, so that gimp_histogram_calculate_area()
+ * can update it for changes of a part of that buffer. This costs
+ * memory, and is meant for long-lived histograms of drawables that
+ * are being edited, like the one shown in the histogram dialog.
+ **/
+void
+gimp_histogram_set_incremental (GimpHistogram *histogram,
+                                gboolean       incremental)
+{
+  g_return_if_fail (GIMP_IS_HISTOGRAM (histogram));
 
-                  data += n_components;
-                }
-              break;
-            }
-        }
-    }
+  histogram->priv->incremental = incremental ? TRUE : FALSE;
 
-  g_object_notify (G_OBJECT (histogram), "values");
+  if (! incremental)
+    gimp_histogram_clear_chunks (histogram);
+}
 
-  g_object_thaw_notify (G_OBJECT (histogram));
+gboolean
+gimp_histogram_get_incremental (GimpHistogram *histogram)
+{
+  g_return_val_if_fail (GIMP_IS_HISTOGRAM (histogram), FALSE);
 
-#undef VALUE
+  return histogram->priv->incremental;
 }
 
 void
@@ -482,6 +512,8 @@ gimp_histogram_clear_values (GimpHistogram *histogram)
 {
   g_return_if_fail (GIMP_IS_HISTOGRAM (histogram));
 
+  gimp_histogram_clear_chunks (histogram);
+
   if (histogram->priv->values)
     {
       g_free (histogram->priv->values);
@@ -949,3 +981,343 @@ gimp_histogram_alloc_values (GimpHistogram *histogram,
               priv->n_channels * priv->n_bins * sizeof (gdouble));
     }
 }
+
+static const Babl *
+gimp_histogram_get_format (GimpHistogram *histogram,
+                           const Babl    *format)
+{
+  if (babl_format_is_palette (format))
+    {
+      if (babl_format_has_alpha (format))
+        format = babl_format ("R'G'B'A float");
+      else
+        format = babl_format ("R'G'B' float");
+    }
+  else
+    {
+      const Babl *model = babl_format_get_model (format);
+
+      if (model == babl_model ("Y"))
+        {
+          if (histogram->priv->gamma_correct)
+            format = babl_format ("Y' float");
+          else
+            format = babl_format ("Y float");
+        }
+      else if (model == babl_model ("Y'"))
+        {
+          format = babl_format ("Y' float");
+        }
+      else if (model == babl_model ("YA"))
+        {
+          if (histogram->priv->gamma_correct)
+            format = babl_format ("Y'A float");
+          else
+            format = babl_format ("YA float");
+        }
+      else if (model == babl_model ("Y'A"))
+        {
+          format = babl_format ("Y'A float");
+        }
+      else if (model == babl_model ("RGB"))
+        {
+          if (histogram->priv->gamma_correct)
+            format = babl_format ("R'G'B' float");
+          else
+            format = babl_format ("RGB float");
+        }
+      else if (model == babl_model ("R'G'B'"))
+        {
+          format = babl_format ("R'G'B' float");
+        }
+      else if (model == babl_model ("RGBA"))
+        {
+          if (histogram->priv->gamma_correct)
+            format = babl_format ("R'G'B'A float");
+          else
+            format = babl_format ("RGBA float");
+        }
+      else if (model == babl_model ("R'G'B'A"))
+        {
+          format = babl_format ("R'G'B'A float");
+        }
+      else
+        {
+          g_return_val_if_reached (NULL);
+        }
+    }
+
+  return format;
+}
+
+static gint
+gimp_histogram_get_n_bins (GeglBuffer *buffer)
+{
+  const Babl *format = gegl_buffer_get_format (buffer);
+
+  if (babl_format_get_type (format, 0) == babl_type ("u8"))
+    return 256;
+
+  return 1024;
+}
+
+static void
+gimp_histogram_clear_chunks (GimpHistogram *histogram)
+{
+  GimpHistogramPrivate *priv = histogram->priv;
+
+  if (priv->chunk_values)
+    {
+      gint i;
+
+      for (i = 0; i < priv->n_chunks; i++)
+        g_free (priv->chunk_values[i]);
+
+      g_free (priv->chunk_values);
+
+      priv->chunk_values = NULL;
+      priv->n_chunks     = 0;
+      priv->chunk_format = NULL;
+    }
+}
+
+static void
+gimp_histogram_add_values (gdouble       *values,
+                           const gdouble *add,
+                           gint           n_values,
+                           gdouble        factor)
+{
+  gint i;
+
+  if (! add)
+    return;
+
+  for (i = 0; i < n_values; i++)
+    values[i] += factor * add[i];
+}
+
+static void
+gimp_histogram_calculate_range (gsize                   offset,
+                                gsize                   size,
+                                GimpHistogramCalculate *calc)
+{
+  gdouble *values = NULL;
+  gsize    i;
+
+  if (! calc->chunk_values)
+    values = g_new0 (gdouble, calc->n_values);
+
+  for (i = offset; i < offset + size; i++)
+    {
+      gint          chunk = calc->chunks ? calc->chunks[i] : i;
+      GeglRectangle rect;
+
+      rect.x      = (chunk % calc->n_chunks_x) * CHUNK_SIZE;
+      rect.y      = (chunk / calc->n_chunks_x) * CHUNK_SIZE;
+      rect.width  = MIN (CHUNK_SIZE, calc->buffer_rect.width  - rect.x);
+      rect.height = MIN (CHUNK_SIZE, calc->buffer_rect.height - rect.y);
+
+      rect.x += calc->buffer_rect.x;
+      rect.y += calc->buffer_rect.y;
+
+      if (calc->chunk_values)
+        {
+          /*  every chunk is only ever touched by one thread  */
+          calc->chunk_values[chunk] = g_new0 (gdouble, calc->n_values);
+
+          gimp_histogram_calculate_chunk (calc, &rect,
+                                          calc->chunk_values[chunk]);
+        }
+      else
+        {
+          gimp_histogram_calculate_chunk (calc, &rect, values);
+        }
+    }
+
+  if (values)
+    {
+      g_mutex_lock (&calc->mutex);
+
+      gimp_histogram_add_values (calc->values, values, calc->n_values, 1.0);
+
+      g_mutex_unlock (&calc->mutex);
+
+      g_free (values);
+    }
+}
+
+static void
+gimp_histogram_calculate_chunk (GimpHistogramCalculate *calc,
+                                const GeglRectangle    *rect,
+                                gdouble                *values)
+{
+  GeglBufferIterator *iter;
+  GeglBuffer         *mask         = calc->mask;
+  gint                n_components = calc->n_components;
+  gint                n_bins       = calc->n_bins;
+
+  iter = gegl_buffer_iterator_new (calc->buffer, rect, 0, calc->format,
+                                   GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
+
+  if (mask)
+    {
+      GeglRectangle mask_rect;
+
+      mask_rect.x      = rect->x + calc->mask_rect.x - calc->buffer_rect.x;
+      mask_rect.y      = rect->y + calc->mask_rect.y - calc->buffer_rect.y;
+      mask_rect.width  = rect->width;
+      mask_rect.height = rect->height;
+
+      gegl_buffer_iterator_add (iter, mask, &mask_rect, 0,
+                                babl_format ("Y float"),
+                                GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
+    }
+
+#define VALUE(c,i) (values[(c) * n_bins + \
+                           (gint) (CLAMP ((i), 0.0, 1.0) * \
+                                   (n_bins - 0.0001))])
+
+  while (gegl_buffer_iterator_next (iter))
+    {
+      const gfloat *data   = iter->data[0];
+      gint          length = iter->length;
+      gfloat        max;
+
+      if (mask)
+        {
+          const gfloat *mask_data = iter->data[1];
+
+          switch (n_components)
+            {
+            case 1:
+              while (length--)
+                {
+                  const gdouble masked = *mask_data;
+
+                  VALUE (0, data[0]) += masked;
+
+                  data += n_components;
+                  mask_data += 1;
+                }
+              break;
+
+            case 2:
+              while (length--)
+                {
+                  const gdouble masked = *mask_data;
+                  const gdouble weight = data[1];
+
+                  VALUE (0, data[0]) += weight * masked;
+                  VALUE (1, data[1]) += masked;
+
+                  data += n_components;
+                  mask_data += 1;
+                }
+              break;
+
+            case 3: /* calculate separate value values */
+              while (length--)
+                {
+                  const gdouble masked = *mask_data;
+
+                  VALUE (1, data[0]) += masked;
+                  VALUE (2, data[1]) += masked;
+                  VALUE (3, data[2]) += masked;
+
+                  max = MAX (data[0], data[1]);
+                  max = MAX (data[2], max);
+
+                  VALUE (0, max) += masked;
+
+                  data += n_components;
+                  mask_data += 1;
+                }
+              break;
+
+            case 4: /* calculate separate value values */
+              while (length--)
+                {
+                  const gdouble masked = *mask_data;
+                  const gdouble weight = data[3];
+
+                  VALUE (1, data[0]) += weight * masked;
+                  VALUE (2, data[1]) += weight * masked;
+                  VALUE (3, data[2]) += weight * masked;
+                  VALUE (4, data[3]) += masked;
+
+                  max = MAX (data[0], data[1]);
+                  max = MAX (data[2], max);
+
+                  VALUE (0, max) += weight * masked;
+
+                  data += n_components;
+                  mask_data += 1;
+                }
+              break;
+            }
+        }
+      else /* no mask */
+        {
+          switch (n_components)
+            {
+            case 1:
+              while (length--)
+                {
+                  VALUE (0, data[0]) += 1.0;
+
+                  data += n_components;
+                }
+              break;
+
+            case 2:
+              while (length--)
+                {
+                  const gdouble weight = data[1];
+
+                  VALUE (0, data[0]) += weight;
+                  VALUE (1, data[1]) += 1.0;
+
+                  data += n_components;
+                }
+              break;
+
+            case 3: /* calculate separate value values */
+              while (length--)
+                {
+                  VALUE (1, data[0]) += 1.0;
+                  VALUE (2, data[1]) += 1.0;
+                  VALUE (3, data[2]) += 1.0;
+
+                  max = MAX (data[0], data[1]);
+                  max = MAX (data[2], max);
+
+                  VALUE (0, max) += 1.0;
+
+                  data += n_components;
+                }
+              break;
+
+            case 4: /* calculate separate value values */
+              while (length--)
+                {
+                  const gdouble weight = data[3];
+
+                  VALUE (1, data[0]) += weight;
+                  VALUE (2, data[1]) += weight;
+                  VALUE (3, data[2]) += weight;
+                  VALUE (4, data[3]) += 1.0;
+
+                  max = MAX (data[0], data[1]);
+                  max = MAX (data[2], max);
+
+                  VALUE (0, max) += weight;
+
+                  data += n_components;
+                }
+              break;
+            }
+        }
+    }
+
+#undef VALUE
+}
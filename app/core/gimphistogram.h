@@ -48,50 +48,60 @@ struct _GimpHistogramClass
 };
 
 
-GType           gimp_histogram_get_type      (void) G_GNUC_CONST;
-
-GimpHistogram * gimp_histogram_new           (gboolean              gamma_correct);
-
-GimpHistogram * gimp_histogram_duplicate     (GimpHistogram        *histogram);
-
-void            gimp_histogram_calculate     (GimpHistogram        *histogram,
-                                              GeglBuffer           *buffer,
-                                              const GeglRectangle  *buffer_rect,
-                                              GeglBuffer           *mask,
-                                              const GeglRectangle  *mask_rect);
-
-void            gimp_histogram_clear_values  (GimpHistogram        *histogram);
-
-gdouble         gimp_histogram_get_maximum   (GimpHistogram        *histogram,
-                                              GimpHistogramChannel  channel);
-gdouble         gimp_histogram_get_count     (GimpHistogram        *histogram,
-                                              GimpHistogramChannel  channel,
-                                              gint                  start,
-                                              gint                  end);
-gdouble         gimp_histogram_get_mean      (GimpHistogram        *histogram,
-                                              GimpHistogramChannel  channel,
-                                              gint                  start,
-                                              gint                  end);
-gdouble         gimp_histogram_get_median    (GimpHistogram        *histogram,
-                                              GimpHistogramChannel  channel,
-                                              gint                  start,
-                                              gint                  end);
-gdouble         gimp_histogram_get_std_dev   (GimpHistogram        *histogram,
-                                              GimpHistogramChannel  channel,
-                                              gint                  start,
-                                              gint                  end);
-gdouble         gimp_histogram_get_threshold (GimpHistogram        *histogram,
-                                              GimpHistogramChannel  channel,
-                                              gint                  start,
-                                              gint                  end);
-gdouble         gimp_histogram_get_value     (GimpHistogram        *histogram,
-                                              GimpHistogramChannel  channel,
-                                              gint                  bin);
-gdouble         gimp_histogram_get_component (GimpHistogram        *histogram,
-                                              gint                  component,
-                                              gint                  bin);
-gint            gimp_histogram_n_channels    (GimpHistogram        *histogram);
-gint            gimp_histogram_n_bins        (GimpHistogram        *histogram);
+GType           gimp_histogram_get_type        (void) G_GNUC_CONST;
+
+GimpHistogram * gimp_histogram_new             (gboolean              gamma_correct);
+
+GimpHistogram * gimp_histogram_duplicate       (GimpHistogram        *histogram);
+
+void            gimp_histogram_calculate       (GimpHistogram        *histogram,
+                                                GeglBuffer           *buffer,
+                                                const GeglRectangle  *buffer_rect,
+                                                GeglBuffer           *mask,
+                                                const GeglRectangle  *mask_rect);
+void            gimp_histogram_calculate_area  (GimpHistogram        *histogram,
+                                                GeglBuffer           *buffer,
+                                                const GeglRectangle  *buffer_rect,
+                                                GeglBuffer           *mask,
+                                                const GeglRectangle  *mask_rect,
+                                                const GeglRectangle  *area);
+
+void            gimp_histogram_set_incremental (GimpHistogram        *histogram,
+                                                gboolean              incremental);
+gboolean        gimp_histogram_get_incremental (GimpHistogram        *histogram);
+
+void            gimp_histogram_clear_values    (GimpHistogram        *histogram);
+
+gdouble         gimp_histogram_get_maximum     (GimpHistogram        *histogram,
+                                                GimpHistogramChannel  channel);
+gdouble         gimp_histogram_get_count       (GimpHistogram        *histogram,
+                                                GimpHistogramChannel  channel,
+                                                gint                  start,
+                                                gint                  end);
+gdouble         gimp_histogram_get_mean        (GimpHistogram        *histogram,
+                                                GimpHistogramChannel  channel,
+                                                gint                  start,
+                                                gint                  end);
+gdouble         gimp_histogram_get_median      (GimpHistogram        *histogram,
+                                                GimpHistogramChannel  channel,
+                                                gint                  start,
+                                                gint                  end);
+gdouble         gimp_histogram_get_std_dev     (GimpHistogram        *histogram,
+                                                GimpHistogramChannel  channel,
+                                                gint                  start,
+                                                gint                  end);
+gdouble         gimp_histogram_get_threshold   (GimpHistogram        *histogram,
+                                                GimpHistogramChannel  channel,
+                                                gint                  start,
+                                                gint                  end);
+gdouble         gimp_histogram_get_value       (GimpHistogram        *histogram,
+                                                GimpHistogramChannel  channel,
+                                                gint                  bin);
+gdouble         gimp_histogram_get_component   (GimpHistogram        *histogram,
+                                                gint                  component,
+                                                gint                  bin);
+gint            gimp_histogram_n_channels      (GimpHistogram        *histogram);
+gint            gimp_histogram_n_bins          (GimpHistogram        *histogram);
 
 
 #endif /* __GIMP_HISTOGRAM_H__ */
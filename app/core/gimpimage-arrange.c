@@ -37,6 +37,16 @@
 
 #include "gimp-intl.h"
 
+
+typedef struct
+{
+  GObject *target;
+  gint     xtranslate;
+  gint     ytranslate;
+  gint     z1;
+} ArrangeMove;
+
+
 static GList * sort_by_offset  (GList             *list);
 static void    compute_offsets (GList             *list,
                                 GimpAlignmentType  alignment);
@@ -142,11 +152,14 @@ gimp_image_arrange_objects (GimpImage         *image,
 
   if (object_list)
     {
-      GList    *lst;
-      gint     n;
-      gint     distr_width  = 0;
-      gint     distr_height = 0;
-      gdouble  fill_offset  = 0;
+      GList       *lst;
+      ArrangeMove *moves;
+      gint         n_moves      = 0;
+      gint         n;
+      gint         i;
+      gint         distr_width  = 0;
+      gint         distr_height = 0;
+      gdouble      fill_offset  = 0;
 
       if (reference_alignment == GIMP_ARRANGE_HFILL)
         {
@@ -163,18 +176,18 @@ gimp_image_arrange_objects (GimpImage         *image,
           fill_offset = (distr_height - 2 * offset) /
                          g_list_length (object_list);
         }
-      /* FIXME: undo group type is wrong */
-      gimp_image_undo_group_start (image, GIMP_UNDO_GROUP_ITEM_DISPLACE,
-                                   C_("undo-type", "Arrange Objects"));
+      moves = g_new (ArrangeMove, g_list_length (object_list));
 
+      /* compute all the moves before moving anything */
       for (lst = object_list, n = 1; lst; lst = g_list_next (lst), n++)
         {
-          GObject *target          = G_OBJECT (lst->data);
-          gint     xtranslate      = 0;
-          gint     ytranslate      = 0;
-          gint     width;
-          gint     height;
-          gint     z1;
+          ArrangeMove *move            = &moves[n_moves];
+          GObject     *target          = G_OBJECT (lst->data);
+          gint         xtranslate      = 0;
+          gint         ytranslate      = 0;
+          gint         width;
+          gint         height;
+          gint         z1;
 
           z1 = GPOINTER_TO_INT (g_object_get_data (target,
                                                     "align-offset"));
@@ -205,33 +218,63 @@ gimp_image_arrange_objects (GimpImage         *image,
                 ytranslate = z0 - z1 + n * offset;
             }
 
-          /* now actually align the target object */
-          if (GIMP_IS_ITEM (target))
-            {
-              gimp_item_translate (GIMP_ITEM (target),
-                                   xtranslate, ytranslate, TRUE);
-            }
-          else if (GIMP_IS_GUIDE (target))
-            {
-              GimpGuide *guide = GIMP_GUIDE (target);
+          /* objects which stay in place need neither undo nor update */
+          if (xtranslate == 0 && ytranslate == 0)
+            continue;
 
-              switch (gimp_guide_get_orientation (guide))
-                {
-                case GIMP_ORIENTATION_VERTICAL:
-                  gimp_image_move_guide (image, guide, z1 + xtranslate, TRUE);
-                  break;
+          move->target     = target;
+          move->xtranslate = xtranslate;
+          move->ytranslate = ytranslate;
+          move->z1         = z1;
 
-                case GIMP_ORIENTATION_HORIZONTAL:
-                  gimp_image_move_guide (image, guide, z1 + ytranslate, TRUE);
-                  break;
+          n_moves++;
+        }
 
-                default:
-                  break;
+      if (n_moves > 0)
+        {
+          /* FIXME: undo group type is wrong */
+          gimp_image_undo_group_start (image, GIMP_UNDO_GROUP_ITEM_DISPLACE,
+                                       C_("undo-type", "Arrange Objects"));
+
+          for (i = 0; i < n_moves; i++)
+            {
+              ArrangeMove *move = &moves[i];
+
+              /* now actually align the target object */
+              if (GIMP_IS_ITEM (move->target))
+                {
+                  gimp_item_translate (GIMP_ITEM (move->target),
+                                       move->xtranslate, move->ytranslate,
+                                       TRUE);
+                }
+              else if (GIMP_IS_GUIDE (move->target))
+                {
+                  GimpGuide *guide = GIMP_GUIDE (move->target);
+
+                  switch (gimp_guide_get_orientation (guide))
+                    {
+                    case GIMP_ORIENTATION_VERTICAL:
+                      gimp_image_move_guide (image, guide,
+                                             move->z1 + move->xtranslate,
+                                             TRUE);
+                      break;
+
+                    case GIMP_ORIENTATION_HORIZONTAL:
+                      gimp_image_move_guide (image, guide,
+                                             move->z1 + move->ytranslate,
+                                             TRUE);
+                      break;
+
+                    default:
+                      break;
+                    }
                 }
             }
+
+          gimp_image_undo_group_end (image);
         }
 
-      gimp_image_undo_group_end (image);
+      g_free (moves);
     }
 
   g_list_free (object_list);
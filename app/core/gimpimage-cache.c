@@ -0,0 +1,83 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <gdk-pixbuf/gdk-pixbuf.h>
+#include <gegl.h>
+
+#include "core-types.h"
+
+#include "gimp.h"
+#include "gimpchannel.h"
+#include "gimpdrawable-preview.h"
+#include "gimpimage.h"
+#include "gimpimage-cache.h"
+#include "gimpmemorymonitor.h"
+#include "gimpprojection.h"
+
+
+/*  public functions  */
+
+/*  Drops everything of the image that can be regenerated from its
+ *  layers and channels: the projection and the drawable previews.
+ *  Nothing visible changes, the image just renders from scratch the
+ *  next time it is looked at.
+ */
+void
+gimp_image_cache_release (GimpImage *image)
+{
+  GList *list;
+  GList *iter;
+
+  g_return_if_fail (GIMP_IS_IMAGE (image));
+
+  gimp_projection_release_buffer (gimp_image_get_projection (image));
+
+  list = gimp_image_get_layer_list (image);
+
+  for (iter = list; iter; iter = g_list_next (iter))
+    gimp_drawable_preview_free (iter->data);
+
+  g_list_free (list);
+
+  list = gimp_image_get_channel_list (image);
+
+  for (iter = list; iter; iter = g_list_next (iter))
+    gimp_drawable_preview_free (iter->data);
+
+  g_list_free (list);
+
+  gimp_drawable_preview_free (GIMP_DRAWABLE (gimp_image_get_mask (image)));
+}
+
+/*  The part of the image that competes for the tile cache: pixel data
+ *  and the projection. Undo has its own limits and is left out.
+ */
+gint64
+gimp_image_cache_get_usage (GimpImage *image)
+{
+  gint64 sizes[GIMP_MEMORY_N_CATEGORIES];
+
+  g_return_val_if_fail (GIMP_IS_IMAGE (image), 0);
+
+  gimp_memory_monitor_get_usage (image->gimp->memory_monitor, image, sizes);
+
+  return (sizes[GIMP_MEMORY_LAYERS]   +
+          sizes[GIMP_MEMORY_CHANNELS] +
+          sizes[GIMP_MEMORY_PROJECTION]);
+}
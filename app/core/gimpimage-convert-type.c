@@ -144,6 +144,7 @@
 #include "gegl/gimp-gegl-utils.h"
 
 #include "gimp.h"
+#include "gimp-parallel.h"
 #include "gimpcontainer.h"
 #include "gimpdrawable.h"
 #include "gimperror.h"
@@ -188,16 +189,26 @@
 #define G_SCALE 24              /*  scale G (a*) distances by this much  */
 #define B_SCALE 26              /*  and B (b*) by this much              */
 
+/*  the number of cells of the RGB histogram  */
+#define HIST_RGB_SIZE (HIST_R_ELEMS * HIST_G_ELEMS * HIST_B_ELEMS)
+
+/*  the minimal number of rows handled by one thread  */
+#define MIN_PARALLEL_SUB_SIZE 64
+
 
 typedef struct _Color Color;
 typedef struct _QuantizeObj QuantizeObj;
+typedef struct _Pass2Data Pass2Data;
 typedef void (* Pass1_Func)   (QuantizeObj *quantize_obj);
 typedef void (* Pass2i_Func)  (QuantizeObj *quantize_obj);
 typedef void (* Pass2_Func)   (QuantizeObj *quantize_obj,
                                GimpLayer   *layer,
                                GeglBuffer  *new_buffer);
 typedef void (* Cleanup_Func) (QuantizeObj *quantize_obj);
-typedef unsigned long ColorFreq;
+typedef void (* Pass2Area_Func) (Pass2Data           *data,
+                                 const GeglRectangle *area,
+                                 gulong              *index_used_count);
+typedef gsize ColorFreq;
 typedef ColorFreq *CFHistogram;
 
 typedef enum {AXIS_UNDEF, AXIS_RED, AXIS_BLUE, AXIS_GREEN} axisType;
@@ -478,6 +489,37 @@ struct _QuantizeObj
   gint          n_layers;
 };
 
+struct _Pass2Data
+{
+  QuantizeObj    *quantobj;
+  Pass2Area_Func  func;
+  GeglBuffer     *src_buffer;
+  GeglBuffer     *dest_buffer;
+  gint            src_bpp;
+  gint            dest_bpp;
+  gboolean        has_alpha;
+  gint            red_pix;
+  gint            green_pix;
+  gint            blue_pix;
+  gint            alpha_pix;
+  gint            offsetx;
+  gint            offsety;
+
+  /*  per thread, see median_cut_pass2_rgb_band ()  */
+  gulong          index_used_count[GIMP_PARALLEL_MAX_THREADS][256];
+};
+
+typedef struct
+{
+  GeglBuffer  *buffer;
+  const Babl  *format;
+  gint         offsetx;
+  gint         offsety;
+  gboolean     alpha_dither;
+  CFHistogram  histograms[GIMP_PARALLEL_MAX_THREADS];
+  gint         n_histograms;
+} HistogramData;
+
 typedef struct
 {
   /*  The bounds of the box (inclusive); expressed as histogram indexes  */
@@ -504,18 +546,27 @@ typedef struct
 } box, *boxptr;
 
 
-static void zero_histogram_gray     (CFHistogram   histogram);
-static void zero_histogram_rgb      (CFHistogram   histogram);
-static void generate_histogram_gray (CFHistogram   hostogram,
-                                     GimpLayer    *layer,
-                                     gboolean      alpha_dither);
-static void generate_histogram_rgb  (CFHistogram   histogram,
-                                     GimpLayer    *layer,
-                                     gint          col_limit,
-                                     gboolean      alpha_dither,
-                                     GimpProgress *progress,
-                                     gint          nth_layer,
-                                     gint          n_layers);
+static void zero_histogram_gray     (CFHistogram    histogram);
+static void zero_histogram_rgb      (CFHistogram    histogram);
+static void generate_histogram_gray (CFHistogram    hostogram,
+                                     GimpLayer     *layer,
+                                     gboolean       alpha_dither);
+static void generate_histogram_rgb  (CFHistogram    histogram,
+                                     GimpLayer     *layer,
+                                     gint           col_limit,
+                                     gboolean       alpha_dither,
+                                     GimpProgress  *progress,
+                                     gint           nth_layer,
+                                     gint           n_layers);
+static void find_colors_rgb         (GimpLayer     *layer,
+                                     gint           col_limit,
+                                     gboolean       alpha_dither);
+static void count_colors_rgb        (gint           i,
+                                     gint           n,
+                                     HistogramData *data);
+static void merge_histograms_rgb    (gsize          offset,
+                                     gsize          size,
+                                     HistogramData *data);
 
 static QuantizeObj * initialize_median_cut (GimpImageBaseType      old_type,
                                             gint                   num_cols,
@@ -1125,8 +1176,7 @@ zero_histogram_gray (CFHistogram histogram)
 static void
 zero_histogram_rgb (CFHistogram histogram)
 {
-  memset (histogram, 0,
-          HIST_R_ELEMS * HIST_G_ELEMS * HIST_B_ELEMS * sizeof (ColorFreq));
+  memset (histogram, 0, HIST_RGB_SIZE * sizeof (ColorFreq));
 }
 
 
@@ -1188,202 +1238,274 @@ generate_histogram_rgb (CFHistogram   histogram,
                         GimpProgress *progress,
                         gint          nth_layer,
                         gint          n_layers)
+{
+  HistogramData data = { 0, };
+  const Babl   *format;
+  glong         layer_size;
+  gint          i;
+
+  format = gimp_drawable_get_format (GIMP_DRAWABLE (layer));
+
+  g_return_if_fail (format == babl_format ("R'G'B' u8") ||
+                    format == babl_format ("R'G'B'A u8"));
+
+  layer_size = (gimp_item_get_width  (GIMP_ITEM (layer)) *
+                gimp_item_get_height (GIMP_ITEM (layer)));
+
+  /*  g_printerr ("col_limit = %d, nfc = %d\n", col_limit, num_found_cols); */
+
+  if (progress)
+    gimp_progress_set_value (progress, 0.0);
+
+  if (! needs_quantize)
+    find_colors_rgb (layer, col_limit, alpha_dither);
+
+  /*  Each thread counts its band of rows into a histogram of its own,
+   *  the first one directly into @histogram.  Adding up the histograms
+   *  costs about as much as counting HIST_RGB_SIZE pixels, so there is
+   *  at most one histogram per that many pixels.
+   */
+  data.buffer        = gimp_drawable_get_buffer (GIMP_DRAWABLE (layer));
+  data.format        = format;
+  data.alpha_dither  = alpha_dither;
+  data.histograms[0] = histogram;
+
+  gimp_item_get_offset (GIMP_ITEM (layer), &data.offsetx, &data.offsety);
+
+  gimp_parallel_distribute (MAX (layer_size / HIST_RGB_SIZE, 1),
+                            (GimpParallelDistributeFunc) count_colors_rgb,
+                            &data);
+
+  if (data.n_histograms > 1)
+    {
+      gimp_parallel_distribute_range (HIST_RGB_SIZE, HIST_RGB_SIZE / 64,
+                                      (GimpParallelDistributeRangeFunc)
+                                      merge_histograms_rgb,
+                                      &data);
+
+      for (i = 1; i < data.n_histograms; i++)
+        g_free (data.histograms[i]);
+    }
+
+  if (progress)
+    gimp_progress_set_value (progress,
+                             (gdouble) (nth_layer + 1) / (gdouble) n_layers);
+
+/*  g_print ("O: col_limit = %d, nfc = %d\n", col_limit, num_found_cols);*/
+}
+
+static void
+find_colors_rgb (GimpLayer *layer,
+                 gint       col_limit,
+                 gboolean   alpha_dither)
 {
   GeglBufferIterator *iter;
   const Babl         *format;
   GeglRectangle      *roi;
-  ColorFreq          *colfreq;
   gint                nfc_iter;
   gint                row, col, coledge;
   gint                offsetx, offsety;
-  glong               layer_size;
-  glong               total_size = 0;
-  gint                count      = 0;
   gint                bpp;
   gboolean            has_alpha;
 
+  /*  Collect the distinct colors of the layer, in scan order, until
+   *  there are more than @col_limit of them
+   */
   format = gimp_drawable_get_format (GIMP_DRAWABLE (layer));
 
-  g_return_if_fail (format == babl_format ("R'G'B' u8") ||
-                    format == babl_format ("R'G'B'A u8"));
-
   bpp       = babl_format_get_bytes_per_pixel (format);
   has_alpha = babl_format_has_alpha (format);
 
   gimp_item_get_offset (GIMP_ITEM (layer), &offsetx, &offsety);
 
-  layer_size = (gimp_item_get_width  (GIMP_ITEM (layer)) *
-                gimp_item_get_height (GIMP_ITEM (layer)));
-
-  /*  g_printerr ("col_limit = %d, nfc = %d\n", col_limit, num_found_cols); */
-
   iter = gegl_buffer_iterator_new (gimp_drawable_get_buffer (GIMP_DRAWABLE (layer)),
                                    NULL, 0, format,
                                    GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
   roi = &iter->roi[0];
 
-  if (progress)
-    gimp_progress_set_value (progress, 0.0);
-
   while (gegl_buffer_iterator_next (iter))
     {
       const guchar *data   = iter->data[0];
       gint          length = iter->length;
 
-      total_size += length;
+      if (needs_quantize)
+        continue;
 
-      /* g_printerr (" [%d,%d - %d,%d]", srcPR.x, src_roi->y, offsetx, offsety); */
+      /* if alpha-dithering, we need to be deterministic w.r.t. offsets */
+      col = roi->x + offsetx;
+      coledge = col + roi->width;
+      row = roi->y + offsety;
 
-      if (needs_quantize)
+      while (length-- && ! needs_quantize)
         {
-          if (alpha_dither)
-            {
-              /* if alpha-dithering,
-                 we need to be deterministic w.r.t. offsets */
-
-              col = roi->x + offsetx;
-              coledge = col + roi->width;
-              row = roi->y + offsety;
+          gboolean transparent = FALSE;
 
-              while (length--)
+          if (has_alpha)
+            {
+              if (alpha_dither)
                 {
-                  gboolean transparent = FALSE;
-
-                  if (has_alpha &&
-                      data[ALPHA] <
+                  if (data[ALPHA] <
                       DM[col & DM_WIDTHMASK][row & DM_HEIGHTMASK])
                     transparent = TRUE;
-
-                  if (! transparent)
-                    {
-                      colfreq = HIST_RGB (histogram,
-                                          data[RED],
-                                          data[GREEN],
-                                          data[BLUE]);
-                      (*colfreq)++;
-                    }
-
-                  col++;
-                  if (col == coledge)
-                    {
-                      col = roi->x + offsetx;
-                      row++;
-                    }
-
-                  data += bpp;
+                }
+              else
+                {
+                  if (data[ALPHA] <= 127)
+                    transparent = TRUE;
                 }
             }
-          else
+
+          if (! transparent)
             {
-              while (length--)
+              for (nfc_iter = 0;
+                   nfc_iter < num_found_cols;
+                   nfc_iter++)
                 {
-                  if ((has_alpha && ((data[ALPHA] > 127)))
-                      || (!has_alpha))
-                    {
-                      colfreq = HIST_RGB (histogram,
-                                          data[RED],
-                                          data[GREEN],
-                                          data[BLUE]);
-                      (*colfreq)++;
-                    }
+                  if ((data[RED]   == found_cols[nfc_iter][0]) &&
+                      (data[GREEN] == found_cols[nfc_iter][1]) &&
+                      (data[BLUE]  == found_cols[nfc_iter][2]))
+                    goto already_found;
+                }
+
+              /* Color was not in the table of
+               * existing colors
+               */
+
+              num_found_cols++;
 
-                  data += bpp;
+              if (num_found_cols > col_limit)
+                {
+                  /* There are more colors in the image
+                   *  than were allowed.  We switch to plain
+                   *  histogram calculation with a view to
+                   *  quantizing at a later stage.
+                   */
+                  needs_quantize = TRUE;
+                  /* g_print ("\nmax colors exceeded - needs quantize.\n");*/
+                }
+              else
+                {
+                  /* Remember the new color we just found.
+                   */
+                  found_cols[num_found_cols-1][0] = data[RED];
+                  found_cols[num_found_cols-1][1] = data[GREEN];
+                  found_cols[num_found_cols-1][2] = data[BLUE];
                 }
             }
-        }
-      else
-        {
-          /* if alpha-dithering, we need to be deterministic w.r.t. offsets */
-          col = roi->x + offsetx;
-          coledge = col + roi->width;
-          row = roi->y + offsety;
+        already_found:
 
-          while (length--)
+          col++;
+          if (col == coledge)
             {
-	      gboolean transparent = FALSE;
-
-	      if (has_alpha)
-	        {
-		  if (alpha_dither)
-		    {
-		      if (data[ALPHA] <
-                          DM[col & DM_WIDTHMASK][row & DM_HEIGHTMASK])
-		  	transparent = TRUE;
-		    }
-		  else
-		    {
-		      if (data[ALPHA] <= 127)
-			transparent = TRUE;
-		    }
-		}
-
-	      if (! transparent)
-                {
-                  colfreq = HIST_RGB (histogram,
-                                      data[RED],
-                                      data[GREEN],
-                                      data[BLUE]);
-                  (*colfreq)++;
+              col = roi->x + offsetx;
+              row++;
+            }
 
-                  if (!needs_quantize)
-                    {
-                      for (nfc_iter = 0;
-                           nfc_iter < num_found_cols;
-                           nfc_iter++)
-                        {
-                          if ((data[RED]   == found_cols[nfc_iter][0]) &&
-                              (data[GREEN] == found_cols[nfc_iter][1]) &&
-                              (data[BLUE]  == found_cols[nfc_iter][2]))
-                            goto already_found;
-                        }
+          data += bpp;
+        }
+    }
+}
+
+static void
+count_colors_rgb (gint           i,
+                  gint           n,
+                  HistogramData *data)
+{
+  GeglBufferIterator *iter;
+  GeglRectangle      *roi;
+  CFHistogram         histogram;
+  ColorFreq          *colfreq;
+  gint                width     = gegl_buffer_get_width  (data->buffer);
+  gint                height    = gegl_buffer_get_height (data->buffer);
+  gint                y1        = (gint64) height * i       / n;
+  gint                y2        = (gint64) height * (i + 1) / n;
+  gint                bpp       = babl_format_get_bytes_per_pixel (data->format);
+  gboolean            has_alpha = babl_format_has_alpha (data->format);
+
+  if (i == 0)
+    {
+      histogram = data->histograms[0];
+
+      data->n_histograms = n;
+    }
+  else
+    {
+      histogram = data->histograms[i] = g_new0 (ColorFreq, HIST_RGB_SIZE);
+    }
 
-                      /* Color was not in the table of
-                       * existing colors
-                       */
+  iter = gegl_buffer_iterator_new (data->buffer,
+                                   GEGL_RECTANGLE (0, y1, width, y2 - y1), 0,
+                                   data->format,
+                                   GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
+  roi = &iter->roi[0];
 
-                      num_found_cols++;
+  while (gegl_buffer_iterator_next (iter))
+    {
+      const guchar *src    = iter->data[0];
+      gint          length = iter->length;
+      gint          col, coledge, row;
 
-                      if (num_found_cols > col_limit)
-                        {
-                          /* There are more colors in the image
-                           *  than were allowed.  We switch to plain
-                           *  histogram calculation with a view to
-                           *  quantizing at a later stage.
-                           */
-                          needs_quantize = TRUE;
-                          /* g_print ("\nmax colors exceeded - needs quantize.\n");*/
-                          goto already_found;
-                        }
-                      else
-                        {
-                          /* Remember the new color we just found.
-                           */
-                          found_cols[num_found_cols-1][0] = data[RED];
-                          found_cols[num_found_cols-1][1] = data[GREEN];
-                          found_cols[num_found_cols-1][2] = data[BLUE];
-                        }
-                    }
-                }
-            already_found:
+      /* if alpha-dithering, we need to be deterministic w.r.t. offsets */
+      col = roi->x + data->offsetx;
+      coledge = col + roi->width;
+      row = roi->y + data->offsety;
 
-              col++;
-              if (col == coledge)
+      while (length--)
+        {
+          gboolean transparent = FALSE;
+
+          if (has_alpha)
+            {
+              if (data->alpha_dither)
                 {
-                  col = roi->x + offsetx;
-                  row++;
+                  if (src[ALPHA] <
+                      DM[col & DM_WIDTHMASK][row & DM_HEIGHTMASK])
+                    transparent = TRUE;
                 }
+              else
+                {
+                  if (src[ALPHA] <= 127)
+                    transparent = TRUE;
+                }
+            }
 
-              data += bpp;
+          if (! transparent)
+            {
+              colfreq = HIST_RGB (histogram,
+                                  src[RED],
+                                  src[GREEN],
+                                  src[BLUE]);
+              (*colfreq)++;
+            }
+
+          col++;
+          if (col == coledge)
+            {
+              col = roi->x + data->offsetx;
+              row++;
             }
-        }
 
-      if (progress && (count % 16 == 0))
-        gimp_progress_set_value (progress,
-                                 (nth_layer + ((gdouble) total_size)/
-                                  layer_size) / (gdouble) n_layers);
+          src += bpp;
+        }
     }
+}
 
-/*  g_print ("O: col_limit = %d, nfc = %d\n", col_limit, num_found_cols);*/
+static void
+merge_histograms_rgb (gsize          offset,
+                      gsize          size,
+                      HistogramData *data)
+{
+  CFHistogram histogram = data->histograms[0];
+  gint        i;
+
+  for (i = 1; i < data->n_histograms; i++)
+    {
+      const ColorFreq *src = data->histograms[i];
+      gsize            j;
+
+      for (j = offset; j < offset + size; j++)
+        histogram[j] += src[j];
+    }
 }
 
 
@@ -2746,7 +2868,9 @@ fill_inverse_cmap_rgb (QuantizeObj *quantobj,
         {
           for (iB = 0; iB < BOX_B_ELEMS; iB++)
             {
-              *HIST_LIN (histogram, R + iR, G + iG, B + iB) = (*cptr++) + 1;
+              g_atomic_pointer_set ((gpointer *)
+                                    HIST_LIN (histogram, R + iR, G + iG, B + iB),
+                                    GSIZE_TO_POINTER ((*cptr++) + 1));
             }
         }
     }
@@ -3092,87 +3216,149 @@ median_cut_pass2_fixed_dither_gray (QuantizeObj *quantobj,
     }
 }
 
+/*  The inverse colormap in quantobj->histogram is filled lazily, by
+ *  all remapping threads at once.  Filling a cell always stores the
+ *  same value, so it's enough to access the cells atomically.
+ */
+static inline gint
+lookup_inverse_cmap_rgb (QuantizeObj *quantobj,
+                         gint         R,
+                         gint         G,
+                         gint         B)
+{
+  ColorFreq *cachep = HIST_LIN (quantobj->histogram, R, G, B);
+  ColorFreq  value;
+
+  value = GPOINTER_TO_SIZE (g_atomic_pointer_get ((gpointer *) cachep));
+
+  if (value == 0)
+    {
+      fill_inverse_cmap_rgb (quantobj, quantobj->histogram, R, G, B);
+
+      value = GPOINTER_TO_SIZE (g_atomic_pointer_get ((gpointer *) cachep));
+    }
+
+  return value - 1;
+}
+
 static void
-median_cut_pass2_no_dither_rgb (QuantizeObj *quantobj,
-                                GimpLayer   *layer,
-                                GeglBuffer  *new_buffer)
+median_cut_pass2_rgb_band (gint       i,
+                           gint       n,
+                           Pass2Data *data)
 {
-  GeglBufferIterator *iter;
-  CFHistogram         histogram = quantobj->histogram;
-  ColorFreq          *cachep;
-  const Babl         *src_format;
-  const Babl         *dest_format;
-  GeglRectangle      *src_roi;
-  gint                src_bpp;
-  gint                dest_bpp;
-  gint                has_alpha;
-  gint                R, G, B;
-  gint                red_pix          = RED;
-  gint                green_pix        = GREEN;
-  gint                blue_pix         = BLUE;
-  gint                alpha_pix        = ALPHA;
-  gboolean            alpha_dither     = quantobj->want_alpha_dither;
-  gint                offsetx, offsety;
-  gulong             *index_used_count = quantobj->index_used_count;
-  glong               total_size       = 0;
-  glong               layer_size;
-  gint                count            = 0;
-  gint                nth_layer        = quantobj->nth_layer;
-  gint                n_layers         = quantobj->n_layers;
+  gint width  = gegl_buffer_get_width  (data->src_buffer);
+  gint height = gegl_buffer_get_height (data->src_buffer);
+  gint y1     = (gint64) height * i       / n;
+  gint y2     = (gint64) height * (i + 1) / n;
 
-  gimp_item_get_offset (GIMP_ITEM (layer), &offsetx, &offsety);
+  data->func (data, GEGL_RECTANGLE (0, y1, width, y2 - y1),
+              data->index_used_count[i]);
+}
+
+/*  Runs @func over bands of rows of @layer in parallel, for the remap
+ *  modes whose result at a pixel doesn't depend on other pixels
+ */
+static void
+median_cut_pass2_rgb_distribute (QuantizeObj    *quantobj,
+                                 GimpLayer      *layer,
+                                 GeglBuffer     *new_buffer,
+                                 Pass2Area_Func  func)
+{
+  Pass2Data  *data;
+  const Babl *src_format;
+  const Babl *dest_format;
+  gint        i, j;
+
+  data = g_new0 (Pass2Data, 1);
 
   src_format  = gimp_drawable_get_format (GIMP_DRAWABLE (layer));
   dest_format = gegl_buffer_get_format (new_buffer);
 
-  src_bpp  = babl_format_get_bytes_per_pixel (src_format);
-  dest_bpp = babl_format_get_bytes_per_pixel (dest_format);
-
-  has_alpha = babl_format_has_alpha (src_format);
+  data->quantobj    = quantobj;
+  data->func        = func;
+  data->src_buffer  = gimp_drawable_get_buffer (GIMP_DRAWABLE (layer));
+  data->dest_buffer = new_buffer;
+  data->src_bpp     = babl_format_get_bytes_per_pixel (src_format);
+  data->dest_bpp    = babl_format_get_bytes_per_pixel (dest_format);
+  data->has_alpha   = babl_format_has_alpha (src_format);
+  data->red_pix     = RED;
+  data->green_pix   = GREEN;
+  data->blue_pix    = BLUE;
+  data->alpha_pix   = ALPHA;
 
   /*  In the case of web/mono palettes, we actually force
    *   grayscale drawables through the rgb pass2 functions
    */
   if (gimp_drawable_is_gray (GIMP_DRAWABLE (layer)))
     {
-      red_pix = green_pix = blue_pix = GRAY;
-      alpha_pix = ALPHA_G;
+      data->red_pix = data->green_pix = data->blue_pix = GRAY;
+      data->alpha_pix = ALPHA_G;
     }
 
-  iter = gegl_buffer_iterator_new (gimp_drawable_get_buffer (GIMP_DRAWABLE (layer)),
-                                   NULL, 0, NULL,
+  gimp_item_get_offset (GIMP_ITEM (layer), &data->offsetx, &data->offsety);
+
+  gimp_parallel_distribute (MAX (gimp_item_get_height (GIMP_ITEM (layer)) /
+                                 MIN_PARALLEL_SUB_SIZE, 1),
+                            (GimpParallelDistributeFunc)
+                            median_cut_pass2_rgb_band,
+                            data);
+
+  for (i = 0; i < GIMP_PARALLEL_MAX_THREADS; i++)
+    for (j = 0; j < 256; j++)
+      quantobj->index_used_count[j] += data->index_used_count[i][j];
+
+  g_free (data);
+
+  if (quantobj->progress)
+    gimp_progress_set_value (quantobj->progress,
+                             (gdouble) (quantobj->nth_layer + 1) /
+                             (gdouble) quantobj->n_layers);
+}
+
+static void
+median_cut_pass2_no_dither_rgb_area (Pass2Data           *data,
+                                     const GeglRectangle *area,
+                                     gulong              *index_used_count)
+{
+  GeglBufferIterator *iter;
+  QuantizeObj        *quantobj     = data->quantobj;
+  GeglRectangle      *src_roi;
+  gint                R, G, B;
+  gint                red_pix      = data->red_pix;
+  gint                green_pix    = data->green_pix;
+  gint                blue_pix     = data->blue_pix;
+  gint                alpha_pix    = data->alpha_pix;
+  gboolean            alpha_dither = quantobj->want_alpha_dither;
+
+  iter = gegl_buffer_iterator_new (data->src_buffer,
+                                   area, 0, NULL,
                                    GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
   src_roi = &iter->roi[0];
 
-  gegl_buffer_iterator_add (iter, new_buffer,
-                            NULL, 0, NULL,
+  gegl_buffer_iterator_add (iter, data->dest_buffer,
+                            area, 0, NULL,
                             GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
 
-  layer_size = (gimp_item_get_width  (GIMP_ITEM (layer)) *
-                gimp_item_get_height (GIMP_ITEM (layer)));
-
   while (gegl_buffer_iterator_next (iter))
     {
       const guchar *src  = iter->data[0];
       guchar       *dest = iter->data[1];
       gint          row;
 
-      total_size += src_roi->height * src_roi->width;
-
       for (row = 0; row < src_roi->height; row++)
         {
           gint col;
 
           for (col = 0; col < src_roi->width; col++)
             {
-              if (has_alpha)
+              if (data->has_alpha)
                 {
                   gboolean transparent = FALSE;
 
                   if (alpha_dither)
                     {
-                      gint dither_x = (col + offsetx + src_roi->x) & DM_WIDTHMASK;
-                      gint dither_y = (row + offsety + src_roi->y) & DM_HEIGHTMASK;
+                      gint dither_x = (col + data->offsetx + src_roi->x) & DM_WIDTHMASK;
+                      gint dither_y = (row + data->offsety + src_roi->y) & DM_HEIGHTMASK;
                       if ((src[alpha_pix]) < DM[dither_x][dither_y])
                         transparent = TRUE;
                     }
@@ -3196,43 +3382,37 @@ median_cut_pass2_no_dither_rgb (QuantizeObj *quantobj,
               /* get pixel value and index into the cache */
               rgb_to_lin (src[red_pix], src[green_pix], src[blue_pix],
                           &R, &G, &B);
-              cachep = HIST_LIN(histogram,R,G,B);
-              /* If we have not seen this color before, find nearest
-                 colormap entry and update the cache */
-              if (*cachep == 0)
-                fill_inverse_cmap_rgb (quantobj, histogram, R, G, B);
 
               /* Now emit the colormap index for this cell, barfbarf */
-              index_used_count[dest[INDEXED] = *cachep - 1]++;
+              index_used_count[dest[INDEXED] =
+                               lookup_inverse_cmap_rgb (quantobj, R, G, B)]++;
 
             next_pixel:
 
-              src  += src_bpp;
-              dest += dest_bpp;
+              src  += data->src_bpp;
+              dest += data->dest_bpp;
             }
         }
-
-      if (quantobj->progress && (count % 16 == 0))
-         gimp_progress_set_value (quantobj->progress,
-                                  (nth_layer + ((gdouble) total_size)/
-                                   layer_size) / (gdouble) n_layers);
     }
 }
 
 static void
-median_cut_pass2_fixed_dither_rgb (QuantizeObj *quantobj,
-                                   GimpLayer   *layer,
-                                   GeglBuffer  *new_buffer)
+median_cut_pass2_no_dither_rgb (QuantizeObj *quantobj,
+                                GimpLayer   *layer,
+                                GeglBuffer  *new_buffer)
+{
+  median_cut_pass2_rgb_distribute (quantobj, layer, new_buffer,
+                                   median_cut_pass2_no_dither_rgb_area);
+}
+
+static void
+median_cut_pass2_fixed_dither_rgb_area (Pass2Data           *data,
+                                        const GeglRectangle *area,
+                                        gulong              *index_used_count)
 {
   GeglBufferIterator *iter;
-  CFHistogram         histogram = quantobj->histogram;
-  ColorFreq          *cachep;
-  const Babl         *src_format;
-  const Babl         *dest_format;
+  QuantizeObj        *quantobj     = data->quantobj;
   GeglRectangle      *src_roi;
-  gint                src_bpp;
-  gint                dest_bpp;
-  gint                has_alpha;
   gint                pixval1 = 0;
   gint                pixval2 = 0;
   Color              *color1;
@@ -3240,58 +3420,27 @@ median_cut_pass2_fixed_dither_rgb (QuantizeObj *quantobj,
   gint                R, G, B;
   gint                err1;
   gint                err2;
-  gint                red_pix          = RED;
-  gint                green_pix        = GREEN;
-  gint                blue_pix         = BLUE;
-  gint                alpha_pix        = ALPHA;
-  gboolean            alpha_dither     = quantobj->want_alpha_dither;
-  gint                offsetx, offsety;
-  gulong             *index_used_count = quantobj->index_used_count;
-  glong               total_size       = 0;
-  glong               layer_size;
-  gint                count            = 0;
-  gint                nth_layer        = quantobj->nth_layer;
-  gint                n_layers         = quantobj->n_layers;
-
-  gimp_item_get_offset (GIMP_ITEM (layer), &offsetx, &offsety);
-
-  src_format  = gimp_drawable_get_format (GIMP_DRAWABLE (layer));
-  dest_format = gegl_buffer_get_format (new_buffer);
-
-  src_bpp  = babl_format_get_bytes_per_pixel (src_format);
-  dest_bpp = babl_format_get_bytes_per_pixel (dest_format);
-
-  has_alpha = babl_format_has_alpha (src_format);
-
-  /*  In the case of web/mono palettes, we actually force
-   *   grayscale drawables through the rgb pass2 functions
-   */
-  if (gimp_drawable_is_gray (GIMP_DRAWABLE (layer)))
-    {
-      red_pix = green_pix = blue_pix = GRAY;
-      alpha_pix = ALPHA_G;
-    }
+  gint                red_pix      = data->red_pix;
+  gint                green_pix    = data->green_pix;
+  gint                blue_pix     = data->blue_pix;
+  gint                alpha_pix    = data->alpha_pix;
+  gboolean            alpha_dither = quantobj->want_alpha_dither;
 
-  iter = gegl_buffer_iterator_new (gimp_drawable_get_buffer (GIMP_DRAWABLE (layer)),
-                                   NULL, 0, NULL,
+  iter = gegl_buffer_iterator_new (data->src_buffer,
+                                   area, 0, NULL,
                                    GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
   src_roi = &iter->roi[0];
 
-  gegl_buffer_iterator_add (iter, new_buffer,
-                            NULL, 0, NULL,
+  gegl_buffer_iterator_add (iter, data->dest_buffer,
+                            area, 0, NULL,
                             GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
 
-  layer_size = (gimp_item_get_width  (GIMP_ITEM (layer)) *
-                gimp_item_get_height (GIMP_ITEM (layer)));
-
   while (gegl_buffer_iterator_next (iter))
     {
       const guchar *src  = iter->data[0];
       guchar       *dest = iter->data[1];
       gint          row;
 
-      total_size += src_roi->height * src_roi->width;
-
       for (row = 0; row < src_roi->height; row++)
         {
           gint col;
@@ -3299,10 +3448,10 @@ median_cut_pass2_fixed_dither_rgb (QuantizeObj *quantobj,
           for (col = 0; col < src_roi->width; col++)
             {
               const int dmval =
-                DM[(col + offsetx + src_roi->x) & DM_WIDTHMASK]
-                [(row + offsety + src_roi->y) & DM_HEIGHTMASK];
+                DM[(col + data->offsetx + src_roi->x) & DM_WIDTHMASK]
+                [(row + data->offsety + src_roi->y) & DM_HEIGHTMASK];
 
-              if (has_alpha)
+              if (data->has_alpha)
                 {
                   gboolean transparent = FALSE;
 
@@ -3331,11 +3480,6 @@ median_cut_pass2_fixed_dither_rgb (QuantizeObj *quantobj,
               /* get pixel value and index into the cache */
               rgb_to_lin(src[red_pix], src[green_pix], src[blue_pix],
                          &R, &G, &B);
-              cachep = HIST_LIN(histogram,R,G,B);
-              /* If we have not seen this color before, find nearest
-                 colormap entry and update the cache */
-              if (*cachep == 0)
-                fill_inverse_cmap_rgb (quantobj, histogram, R, G, B);
 
               /* We now try to find a color which, when mixed in some fashion
                  with the closest match, yields something closer to the
@@ -3344,9 +3488,8 @@ median_cut_pass2_fixed_dither_rgb (QuantizeObj *quantobj,
                  color cell.  Then we assess the distance of both mixer
                  colors from the intended color to determine their relative
                  probabilities of being chosen. */
-              pixval1 = *cachep - 1;
+              pixval1 = lookup_inverse_cmap_rgb (quantobj, R, G, B);
               color1 = &quantobj->cmap[pixval1];
-
               if (quantobj->actual_number_of_colors > 2)
                 {
                   const int re = src[red_pix] - (int)color1->red;
@@ -3362,15 +3505,7 @@ median_cut_pass2_fixed_dither_rgb (QuantizeObj *quantobj,
                                   (CLAMP0255(GV)),
                                   (CLAMP0255(BV)),
                                   &R, &G, &B);
-                      cachep = HIST_LIN(histogram,R,G,B);
-
-                      /* If we have not seen this color before, find nearest
-                         colormap entry and update the cache */
-                      if (*cachep == 0)
-                        {
-                          fill_inverse_cmap_rgb (quantobj, histogram, R, G, B);
-                        }
-                      pixval2 = *cachep - 1;
+                      pixval2 = lookup_inverse_cmap_rgb (quantobj, R, G, B);
                       RV += re;  GV += ge;  BV += be;
                     }
                   while ((pixval1 == pixval2) &&
@@ -3438,18 +3573,22 @@ median_cut_pass2_fixed_dither_rgb (QuantizeObj *quantobj,
 
             next_pixel:
 
-              src  += src_bpp;
-              dest += dest_bpp;
+              src  += data->src_bpp;
+              dest += data->dest_bpp;
             }
         }
-
-      if (quantobj->progress && (count % 16 == 0))
-        gimp_progress_set_value (quantobj->progress,
-                                 (nth_layer + ((gdouble) total_size)/
-                                  layer_size) / (gdouble) n_layers);
     }
 }
 
+static void
+median_cut_pass2_fixed_dither_rgb (QuantizeObj *quantobj,
+                                   GimpLayer   *layer,
+                                   GeglBuffer  *new_buffer)
+{
+  median_cut_pass2_rgb_distribute (quantobj, layer, new_buffer,
+                                   median_cut_pass2_fixed_dither_rgb_area);
+}
+
 static void
 median_cut_pass2_nodestruct_dither_rgb (QuantizeObj *quantobj,
                                         GimpLayer   *layer,
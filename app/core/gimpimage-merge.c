@@ -35,6 +35,7 @@
 #include "vectors/gimpvectors.h"
 
 #include "gimp.h"
+#include "gimp-parallel.h"
 #include "gimpcontext.h"
 #include "gimperror.h"
 #include "gimpgrouplayer.h"
@@ -46,16 +47,45 @@
 #include "gimplayermask.h"
 #include "gimpmarshal.h"
 #include "gimpparasitelist.h"
+#include "gimppickable.h"
+#include "gimpprojection.h"
 #include "gimpundostack.h"
 
 #include "gimp-intl.h"
 
 
-static GimpLayer * gimp_image_merge_layers (GimpImage     *image,
-                                            GimpContainer *container,
-                                            GSList        *merge_list,
-                                            GimpContext   *context,
-                                            GimpMergeType  merge_type);
+/* the smallest area worth a thread of its own */
+#define MIN_PARALLEL_SUB_SIZE 64
+#define MIN_PARALLEL_SUB_AREA (MIN_PARALLEL_SUB_SIZE * MIN_PARALLEL_SUB_SIZE)
+
+
+typedef struct
+{
+  GeglBuffer           *merge_buffer;
+  GeglBuffer           *layer_buffer;
+  GeglBuffer           *mask_buffer;
+  gint                  offset_x;
+  gint                  offset_y;
+  gboolean              linear;
+  gdouble               opacity;
+  GimpLayerModeEffects  mode;
+} GimpImageMergeData;
+
+
+static GimpLayer * gimp_image_merge_layers         (GimpImage           *image,
+                                                    GimpContainer       *container,
+                                                    GSList              *merge_list,
+                                                    GimpContext         *context,
+                                                    GimpMergeType        merge_type);
+static gboolean    gimp_image_merge_use_projection (GimpImage           *image,
+                                                    GimpContainer       *container,
+                                                    GSList              *reverse_list,
+                                                    gint                 x1,
+                                                    gint                 y1,
+                                                    gint                 x2,
+                                                    gint                 y2);
+static void        gimp_image_merge_area           (const GeglRectangle *area,
+                                                    GimpImageMergeData  *data);
 
 
 /*  public functions  */
@@ -423,6 +453,9 @@ gimp_image_merge_layers (GimpImage     *image,
   GSList           *reverse_list = NULL;
   GSList           *layers;
   GimpLayer        *merge_layer;
+  GeglBuffer       *merge_buffer;
+  GeglRectangle     merge_rect;
+  gboolean          use_projection;
   GimpLayer        *layer;
   GimpLayer        *bottom_layer;
   GimpParasiteList *parasites;
@@ -590,65 +623,85 @@ gimp_image_merge_layers (GimpImage     *image,
   gimp_item_set_parasites (GIMP_ITEM (merge_layer), parasites);
   g_object_unref (parasites);
 
-  for (layers = reverse_list; layers; layers = g_slist_next (layers))
-    {
-      GeglBuffer           *merge_buffer;
-      GeglBuffer           *layer_buffer;
-      GimpApplicator       *applicator;
-      GimpLayerModeEffects  mode;
+  merge_buffer = gimp_drawable_get_buffer (GIMP_DRAWABLE (merge_layer));
 
-      layer = layers->data;
+  gegl_rectangle_set (&merge_rect, 0, 0,
+                      gegl_buffer_get_width  (merge_buffer),
+                      gegl_buffer_get_height (merge_buffer));
 
-      gimp_item_get_offset (GIMP_ITEM (layer), &off_x, &off_y);
+  /*  if the projection shows exactly the merged layers, its pixels
+   *  are what we are about to composite, and many of its tiles are
+   *  valid already
+   */
+  use_projection = gimp_image_merge_use_projection (image, container,
+                                                    reverse_list,
+                                                    x1, y1, x2, y2);
 
-      /* DISSOLVE_MODE is special since it is the only mode that does not
-       *  work on the projection with the lower layer, but only locally on
-       *  the layers alpha channel.
-       */
-      mode = gimp_layer_get_mode (layer);
-      if (layer == bottom_layer && mode != GIMP_DISSOLVE_MODE)
-        mode = GIMP_NORMAL_MODE;
-
-      merge_buffer = gimp_drawable_get_buffer (GIMP_DRAWABLE (merge_layer));
-      layer_buffer = gimp_drawable_get_buffer (GIMP_DRAWABLE (layer));
+  if (use_projection)
+    {
+      GimpProjection     *projection = gimp_image_get_projection (image);
+      GimpImageMergeData  data       = { 0, };
+
+      gimp_pickable_flush (GIMP_PICKABLE (projection));
+
+      data.merge_buffer = merge_buffer;
+      data.layer_buffer = gimp_pickable_get_buffer (GIMP_PICKABLE (projection));
+      data.offset_x     = - x1;
+      data.offset_y     = - y1;
+      data.linear       = gimp_drawable_get_linear (GIMP_DRAWABLE (bottom_layer));
+      data.opacity      = GIMP_OPACITY_OPAQUE;
+      data.mode         = GIMP_NORMAL_MODE;
+
+      gimp_parallel_distribute_area (&merge_rect, MIN_PARALLEL_SUB_AREA,
+                                     (GimpParallelDistributeAreaFunc)
+                                     gimp_image_merge_area,
+                                     &data);
+    }
 
-      applicator =
-        gimp_applicator_new (NULL,
-                             gimp_drawable_get_linear (GIMP_DRAWABLE (layer)),
-                             FALSE);
+  for (layers = reverse_list; layers; layers = g_slist_next (layers))
+    {
+      layer = layers->data;
 
-      if (gimp_layer_get_mask (layer) &&
-          gimp_layer_get_apply_mask (layer))
+      if (! use_projection)
         {
-          GeglBuffer *mask_buffer;
+          GimpImageMergeData data = { 0, };
 
-          mask_buffer = gimp_drawable_get_buffer (GIMP_DRAWABLE (layer->mask));
+          gimp_item_get_offset (GIMP_ITEM (layer), &off_x, &off_y);
 
-          gimp_applicator_set_mask_buffer (applicator, mask_buffer);
-          gimp_applicator_set_mask_offset (applicator,
-                                           - (x1 - off_x),
-                                           - (y1 - off_y));
-        }
+          data.merge_buffer = merge_buffer;
+          data.layer_buffer = gimp_drawable_get_buffer (GIMP_DRAWABLE (layer));
+          data.offset_x     = - (x1 - off_x);
+          data.offset_y     = - (y1 - off_y);
+          data.linear       = gimp_drawable_get_linear (GIMP_DRAWABLE (layer));
+          data.opacity      = gimp_layer_get_opacity (layer);
 
-      gimp_applicator_set_src_buffer (applicator, merge_buffer);
-      gimp_applicator_set_dest_buffer (applicator, merge_buffer);
-
-      gimp_applicator_set_apply_buffer (applicator, layer_buffer);
-      gimp_applicator_set_apply_offset (applicator,
-                                        - (x1 - off_x),
-                                        - (y1 - off_y));
-
-      gimp_applicator_set_mode (applicator,
-                                gimp_layer_get_opacity (layer),
-                                mode);
-
-      gimp_applicator_blit (applicator,
-                            GEGL_RECTANGLE (0, 0,
-                                            gegl_buffer_get_width  (merge_buffer),
-                                            gegl_buffer_get_height (merge_buffer)));
+          if (gimp_layer_get_mask (layer) &&
+              gimp_layer_get_apply_mask (layer))
+            {
+              data.mask_buffer =
+                gimp_drawable_get_buffer (GIMP_DRAWABLE (layer->mask));
+            }
 
-      g_object_unref (applicator);
+          /* DISSOLVE_MODE is special since it is the only mode that does not
+           *  work on the projection with the lower layer, but only locally on
+           *  the layers alpha channel.
+           */
+          data.mode = gimp_layer_get_mode (layer);
+          if (layer == bottom_layer && data.mode != GIMP_DISSOLVE_MODE)
+            data.mode = GIMP_NORMAL_MODE;
+
+          /*  each thread composites its part of the merge layer through
+           *  a graph of its own
+           */
+          gimp_parallel_distribute_area (&merge_rect, MIN_PARALLEL_SUB_AREA,
+                                         (GimpParallelDistributeAreaFunc)
+                                         gimp_image_merge_area,
+                                         &data);
+        }
 
+      /*  drop each layer as soon as it is merged, so only the undo
+       *  keeps its pixels
+       */
       gimp_image_remove_layer (image, layer, TRUE, NULL);
     }
 
@@ -689,3 +742,132 @@ gimp_image_merge_layers (GimpImage     *image,
 
   return merge_layer;
 }
+
+/*  Returns whether compositing the image's projection onto the merge
+ *  layer gives the same pixels in the region (x1, y1) - (x2, y2) as
+ *  compositing the merged layers one by one.
+ */
+static gboolean
+gimp_image_merge_use_projection (GimpImage     *image,
+                                 GimpContainer *container,
+                                 GSList        *reverse_list,
+                                 gint           x1,
+                                 gint           y1,
+                                 gint           x2,
+                                 gint           y2)
+{
+  GimpLayer  *bottom_layer = reverse_list->data;
+  GeglBuffer *buffer       = NULL;
+  GList      *list;
+  GSList     *layers;
+  gint        n_visible    = 0;
+  gint        off_x, off_y;
+  gboolean    linear;
+
+  if (container != gimp_image_get_layers (image) ||
+      gimp_image_get_floating_selection (image)  ||
+      gimp_image_get_visible_mask (image) != GIMP_COMPONENT_ALL)
+    return FALSE;
+
+  if (x1 < 0 || y1 < 0 ||
+      x2 > gimp_image_get_width  (image) ||
+      y2 > gimp_image_get_height (image))
+    return FALSE;
+
+  /*  only reuse a projection that is there already, creating one
+   *  costs as much as compositing the layers
+   */
+  g_object_get (gimp_image_get_projection (image),
+                "buffer", &buffer,
+                NULL);
+
+  if (! buffer)
+    return FALSE;
+
+  g_object_unref (buffer);
+
+  for (list = gimp_image_get_channel_iter (image);
+       list;
+       list = g_list_next (list))
+    {
+      if (gimp_item_get_visible (list->data))
+        return FALSE;
+    }
+
+  for (list = gimp_image_get_layer_iter (image);
+       list;
+       list = g_list_next (list))
+    {
+      if (gimp_item_get_visible (list->data))
+        n_visible++;
+    }
+
+  if (n_visible != g_slist_length (reverse_list))
+    return FALSE;
+
+  /*  an opaque bottom layer covering the image makes the projection
+   *  opaque, and the layers above it are composited onto the bottom
+   *  layer, just like the projection composites them
+   */
+  gimp_item_get_offset (GIMP_ITEM (bottom_layer), &off_x, &off_y);
+
+  if (gimp_layer_get_mode (bottom_layer)    == GIMP_NORMAL_MODE    &&
+      gimp_layer_get_opacity (bottom_layer) == GIMP_OPACITY_OPAQUE &&
+      ! gimp_layer_get_mask (bottom_layer)                         &&
+      ! gimp_drawable_has_alpha (GIMP_DRAWABLE (bottom_layer))     &&
+      off_x == 0 && off_y == 0                                     &&
+      gimp_item_get_width  (GIMP_ITEM (bottom_layer)) ==
+      gimp_image_get_width  (image)                                &&
+      gimp_item_get_height (GIMP_ITEM (bottom_layer)) ==
+      gimp_image_get_height (image))
+    {
+      return TRUE;
+    }
+
+  /*  otherwise, compositing the projection onto the merge layer's
+   *  background only gives the same result if "normal" is the only
+   *  mode, in one color space, because only then compositing is
+   *  associative
+   */
+  linear = gimp_drawable_get_linear (GIMP_DRAWABLE (bottom_layer));
+
+  for (layers = reverse_list; layers; layers = g_slist_next (layers))
+    {
+      GimpLayer *layer = layers->data;
+
+      if (gimp_layer_get_mode (layer) != GIMP_NORMAL_MODE ||
+          gimp_drawable_get_linear (GIMP_DRAWABLE (layer)) != linear)
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+static void
+gimp_image_merge_area (const GeglRectangle *area,
+                       GimpImageMergeData  *data)
+{
+  GimpApplicator *applicator;
+
+  applicator = gimp_applicator_new (NULL, data->linear, FALSE);
+
+  if (data->mask_buffer)
+    {
+      gimp_applicator_set_mask_buffer (applicator, data->mask_buffer);
+      gimp_applicator_set_mask_offset (applicator,
+                                       data->offset_x, data->offset_y);
+    }
+
+  gimp_applicator_set_src_buffer (applicator, data->merge_buffer);
+  gimp_applicator_set_dest_buffer (applicator, data->merge_buffer);
+
+  gimp_applicator_set_apply_buffer (applicator, data->layer_buffer);
+  gimp_applicator_set_apply_offset (applicator,
+                                    data->offset_x, data->offset_y);
+
+  gimp_applicator_set_mode (applicator, data->opacity, data->mode);
+
+  gimp_applicator_blit (applicator, area);
+
+  g_object_unref (applicator);
+}
@@ -20,6 +20,8 @@
 #include <gdk-pixbuf/gdk-pixbuf.h>
 #include <gegl.h>
 
+#include "libgimpmath/gimpmath.h"
+
 #include "core-types.h"
 
 #include "gegl/gimp-babl.h"
@@ -33,6 +35,16 @@
 #include "gimptempbuf.h"
 
 
+/*  the most update areas that are remembered separately, see
+ *  gimp_image_preview_add_update_area()
+ */
+#define PREVIEW_MAX_UPDATE_AREAS 64
+
+
+static const Babl * gimp_image_get_preview_format (GimpImage *image);
+static void         gimp_image_preview_update     (GimpImage *image);
+
+
 void
 gimp_image_get_preview_size (GimpViewable *viewable,
                              gint          size,
@@ -95,6 +107,37 @@ gimp_image_get_popup_size (GimpViewable *viewable,
   return FALSE;
 }
 
+GimpTempBuf *
+gimp_image_get_preview (GimpViewable *viewable,
+                        GimpContext  *context,
+                        gint          width,
+                        gint          height)
+{
+  GimpImage        *image   = GIMP_IMAGE (viewable);
+  GimpImagePrivate *private = GIMP_IMAGE_GET_PRIVATE (image);
+
+  if (private->preview                                      &&
+      gimp_temp_buf_get_width  (private->preview) == width  &&
+      gimp_temp_buf_get_height (private->preview) == height &&
+      gimp_temp_buf_get_format (private->preview) ==
+      gimp_image_get_preview_format (image))
+    {
+      gimp_image_preview_update (image);
+    }
+  else
+    {
+      if (private->preview)
+        gimp_temp_buf_unref (private->preview);
+
+      private->preview = gimp_image_get_new_preview (viewable, context,
+                                                     width, height);
+
+      g_array_set_size (private->preview_update_areas, 0);
+    }
+
+  return private->preview;
+}
+
 GimpTempBuf *
 gimp_image_get_new_preview (GimpViewable *viewable,
                             GimpContext  *context,
@@ -102,7 +145,6 @@ gimp_image_get_new_preview (GimpViewable *viewable,
                             gint          height)
 {
   GimpImage   *image = GIMP_IMAGE (viewable);
-  const Babl  *format;
   GimpTempBuf *buf;
   gdouble      scale_x;
   gdouble      scale_y;
@@ -110,12 +152,8 @@ gimp_image_get_new_preview (GimpViewable *viewable,
   scale_x = (gdouble) width  / (gdouble) gimp_image_get_width  (image);
   scale_y = (gdouble) height / (gdouble) gimp_image_get_height (image);
 
-  format = gimp_projectable_get_format (GIMP_PROJECTABLE (image));
-  format = gimp_babl_format (gimp_babl_format_get_base_type (format),
-                             GIMP_PRECISION_U8_GAMMA,
-                             babl_format_has_alpha (format));
-
-  buf = gimp_temp_buf_new (width, height, format);
+  buf = gimp_temp_buf_new (width, height,
+                           gimp_image_get_preview_format (image));
 
   gegl_buffer_get (gimp_pickable_get_buffer (GIMP_PICKABLE (image)),
                    GEGL_RECTANGLE (0, 0, width, height),
@@ -126,3 +164,105 @@ gimp_image_get_new_preview (GimpViewable *viewable,
 
   return buf;
 }
+
+void
+gimp_image_preview_add_update_area (GimpImage *image,
+                                    gint       x,
+                                    gint       y,
+                                    gint       width,
+                                    gint       height)
+{
+  GimpImagePrivate *private;
+  GeglRectangle     rect = { x, y, width, height };
+
+  g_return_if_fail (GIMP_IS_IMAGE (image));
+
+  private = GIMP_IMAGE_GET_PRIVATE (image);
+
+  /*  nothing to keep up to date  */
+  if (! private->preview)
+    return;
+
+  if (private->preview_update_areas->len == PREVIEW_MAX_UPDATE_AREAS)
+    {
+      GeglRectangle *areas = (GeglRectangle *) private->preview_update_areas->data;
+      gint           i;
+
+      /*  don't let a long stroke pile up areas while nobody looks at
+       *  the preview, collapse them into their bounding box
+       */
+      for (i = 1; i < private->preview_update_areas->len; i++)
+        gegl_rectangle_bounding_box (&areas[0], &areas[0], &areas[i]);
+
+      g_array_set_size (private->preview_update_areas, 1);
+    }
+
+  g_array_append_val (private->preview_update_areas, rect);
+}
+
+
+/*  private functions  */
+
+static const Babl *
+gimp_image_get_preview_format (GimpImage *image)
+{
+  const Babl *format = gimp_projectable_get_format (GIMP_PROJECTABLE (image));
+
+  return gimp_babl_format (gimp_babl_format_get_base_type (format),
+                           GIMP_PRECISION_U8_GAMMA,
+                           babl_format_has_alpha (format));
+}
+
+/*  re-read only the parts of the preview that changed since it was
+ *  last requested, from the projection's mipmap level that matches
+ *  the preview's scale
+ */
+static void
+gimp_image_preview_update (GimpImage *image)
+{
+  GimpImagePrivate *private = GIMP_IMAGE_GET_PRIVATE (image);
+  GeglBuffer       *buffer;
+  const Babl       *format;
+  guchar           *data;
+  gint              width;
+  gint              height;
+  gint              bpp;
+  gdouble           scale;
+  gint              i;
+
+  if (private->preview_update_areas->len == 0)
+    return;
+
+  buffer = gimp_pickable_get_buffer (GIMP_PICKABLE (image));
+
+  width  = gimp_temp_buf_get_width  (private->preview);
+  height = gimp_temp_buf_get_height (private->preview);
+  format = gimp_temp_buf_get_format (private->preview);
+  data   = gimp_temp_buf_get_data   (private->preview);
+  bpp    = babl_format_get_bytes_per_pixel (format);
+
+  scale = MIN ((gdouble) width  / (gdouble) gimp_image_get_width  (image),
+               (gdouble) height / (gdouble) gimp_image_get_height (image));
+
+  for (i = 0; i < private->preview_update_areas->len; i++)
+    {
+      const GeglRectangle *area = &g_array_index (private->preview_update_areas,
+                                                  GeglRectangle, i);
+      gint                 x1, y1, x2, y2;
+
+      /*  include the pixels a scaled down edge spills into  */
+      x1 = CLAMP (floor (area->x * scale) - 1,                  0, width);
+      y1 = CLAMP (floor (area->y * scale) - 1,                  0, height);
+      x2 = CLAMP (ceil ((area->x + area->width)  * scale) + 1, 0, width);
+      y2 = CLAMP (ceil ((area->y + area->height) * scale) + 1, 0, height);
+
+      if (x2 > x1 && y2 > y1)
+        gegl_buffer_get (buffer,
+                         GEGL_RECTANGLE (x1, y1, x2 - x1, y2 - y1),
+                         scale, format,
+                         data + (y1 * width + x1) * bpp,
+                         width * bpp, GEGL_ABYSS_CLAMP);
+    }
+
+  g_array_set_size (private->preview_update_areas, 0);
+}
@@ -35,10 +35,21 @@ gboolean      gimp_image_get_popup_size   (GimpViewable *viewable,
                                            gboolean      dot_for_dot,
                                            gint         *popup_width,
                                            gint         *popup_height);
+GimpTempBuf * gimp_image_get_preview      (GimpViewable *viewable,
+                                           GimpContext  *context,
+                                           gint          width,
+                                           gint          height);
 GimpTempBuf * gimp_image_get_new_preview  (GimpViewable *viewable,
                                            GimpContext  *context,
                                            gint          width,
                                            gint          height);
 
 
+void   gimp_image_preview_add_update_area (GimpImage    *image,
+                                           gint          x,
+                                           gint          y,
+                                           gint          width,
+                                           gint          height);
+
+
 #endif /* __GIMP_IMAGE_PREVIEW_H__ */
@@ -80,6 +80,14 @@ struct _GimpImagePrivate
   GimpProjection    *projection;            /*  projection layers & channels */
   GeglNode          *graph;                 /*  GEGL projection graph        */
   GeglNode          *visible_mask;          /*  component visibility node    */
+  GeglNode          *layers_cache;          /*  layer composite below the
+                                             *  visible channels
+                                             */
+
+  GimpTempBuf       *preview;               /*  incrementally updated preview */
+  GArray            *preview_update_areas;  /*  areas changed since, in image
+                                             *  coordinates
+                                             */
 
   GList             *guides;                /*  guides                       */
   GimpGrid          *grid;                  /*  grid                         */
@@ -94,6 +102,7 @@ struct _GimpImagePrivate
   GQuark             layer_alpha_handler;
   GQuark             channel_name_changed_handler;
   GQuark             channel_color_changed_handler;
+  GQuark             channel_visibility_handler;
 
   GimpLayer         *floating_sel;          /*  the FS layer                 */
   GimpChannel       *selection_mask;        /*  the selection mask channel   */
@@ -112,6 +121,7 @@ struct _GimpImagePrivate
   GimpUndoStack     *redo_stack;            /*  stack for redo operations    */
   gint               group_count;           /*  nested undo groups           */
   GimpUndoType       pushing_undo_group;    /*  undo group status flag       */
+  guint              undo_spill_idle_id;    /*  background undo compression  */
 
   /*  Signal emission accumulator  */
   GimpImageFlushAccumulator  flush_accum;
@@ -33,10 +33,16 @@
 
 #include "config/gimpcoreconfig.h"
 
+#include "gegl/gimp-gegl-loops.h"
+
 #include "gimp.h"
+#include "gimpdrawable.h"
 #include "gimperror.h"
 #include "gimpimage.h"
+#include "gimpimage-colormap.h"
 #include "gimpimage-profile.h"
+#include "gimpimage-undo.h"
+#include "gimpprogress.h"
 
 #include "gimp-intl.h"
 
@@ -172,3 +178,177 @@ gimp_image_get_profile (GimpImage  *image,
 
   return profile;
 }
+
+/*  converts all layers (or the colormap) of @image from its current
+ *  color profile to @dest_profile and attaches @dest_profile to the
+ *  image, as one undo step
+ */
+gboolean
+gimp_image_convert_color_profile (GimpImage                *image,
+                                  GimpColorProfile          dest_profile,
+                                  GimpColorRenderingIntent  intent,
+                                  gboolean                  bpc,
+                                  GimpProgress             *progress,
+                                  GError                  **error)
+{
+  GimpColorProfile  src_profile;
+  GimpParasite     *parasite;
+  guint8           *data;
+  gsize             length;
+  gboolean          success = TRUE;
+
+  g_return_val_if_fail (GIMP_IS_IMAGE (image), FALSE);
+  g_return_val_if_fail (dest_profile != NULL, FALSE);
+  g_return_val_if_fail (progress == NULL || GIMP_IS_PROGRESS (progress), FALSE);
+  g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  if (gimp_image_get_base_type (image) == GIMP_GRAY)
+    {
+      g_set_error_literal (error, GIMP_ERROR, GIMP_FAILED,
+                           _("Cannot convert a GRAY image "
+                             "to a different color profile"));
+      return FALSE;
+    }
+
+  if (! gimp_lcms_profile_is_rgb (dest_profile))
+    {
+      g_set_error_literal (error, GIMP_ERROR, GIMP_FAILED,
+                           _("Color profile is not for RGB color space"));
+      return FALSE;
+    }
+
+  src_profile = gimp_image_get_profile (image, error);
+
+  if (! src_profile)
+    {
+      if (error && *error)
+        return FALSE;
+
+      src_profile = gimp_lcms_create_srgb_profile ();
+    }
+
+  data = gimp_lcms_profile_save_to_data (dest_profile, &length, error);
+
+  if (! data)
+    {
+      cmsCloseProfile (src_profile);
+      return FALSE;
+    }
+
+  parasite = gimp_parasite_new (GIMP_ICC_PROFILE_PARASITE_NAME,
+                                GIMP_PARASITE_PERSISTENT |
+                                GIMP_PARASITE_UNDOABLE,
+                                length, data);
+  g_free (data);
+
+  gimp_set_busy (image->gimp);
+
+  gimp_image_undo_group_start (image, GIMP_UNDO_GROUP_PARASITE_ATTACH,
+                               _("Convert to Color Profile"));
+
+  switch (gimp_image_get_base_type (image))
+    {
+    case GIMP_RGB:
+      {
+        GList *layers = gimp_image_get_layer_list (image);
+        GList *list;
+        gint   n_layers;
+        gint   nth_layer;
+
+        n_layers = g_list_length (layers);
+
+        for (list = layers, nth_layer = 0;
+             list && success;
+             list = g_list_next (list), nth_layer++)
+          {
+            GimpDrawable *drawable = list->data;
+            GeglBuffer   *buffer;
+            GeglBuffer   *new_buffer;
+
+            /*  group layers are updated from their children  */
+            if (gimp_viewable_get_children (GIMP_VIEWABLE (drawable)))
+              continue;
+
+            buffer     = gimp_drawable_get_buffer (drawable);
+            new_buffer = gegl_buffer_new (gegl_buffer_get_extent (buffer),
+                                          gegl_buffer_get_format (buffer));
+
+            success = gimp_gegl_convert_color_profile (buffer, NULL,
+                                                       src_profile,
+                                                       new_buffer, NULL,
+                                                       dest_profile,
+                                                       intent, bpc);
+
+            if (success)
+              gimp_drawable_set_buffer (drawable, TRUE, NULL, new_buffer);
+
+            g_object_unref (new_buffer);
+
+            if (progress)
+              gimp_progress_set_value (progress,
+                                       (gdouble) (nth_layer + 1) / n_layers);
+          }
+
+        g_list_free (layers);
+      }
+      break;
+
+    case GIMP_INDEXED:
+      {
+        guchar        *cmap;
+        gint           n_colors;
+        cmsHTRANSFORM  transform;
+
+        n_colors = gimp_image_get_colormap_size (image);
+        cmap     = g_memdup (gimp_image_get_colormap (image), n_colors * 3);
+
+        transform = cmsCreateTransform (src_profile,  TYPE_RGB_8,
+                                        dest_profile, TYPE_RGB_8,
+                                        intent,
+                                        cmsFLAGS_NOOPTIMIZE |
+                                        (bpc ? cmsFLAGS_BLACKPOINTCOMPENSATION : 0));
+
+        if (transform)
+          {
+            cmsDoTransform (transform, cmap, cmap, n_colors);
+            cmsDeleteTransform (transform);
+
+            gimp_image_set_colormap (image, cmap, n_colors, TRUE);
+          }
+        else
+          {
+            success = FALSE;
+          }
+
+        g_free (cmap);
+      }
+      break;
+
+    case GIMP_GRAY:
+      g_return_val_if_reached (FALSE);
+    }
+
+  if (success)
+    {
+      gimp_image_set_icc_profile (image, parasite);
+      gimp_image_parasite_detach (image, "icc-profile-name");
+    }
+  else
+    {
+      g_set_error_literal (error, GIMP_ERROR, GIMP_FAILED,
+                           _("Color profile conversion failed"));
+    }
+
+  gimp_image_undo_group_end (image);
+
+  /*  a partial conversion is worse than none at all  */
+  if (! success)
+    gimp_image_undo (image);
+
+  gimp_unset_busy (image->gimp);
+
+  gimp_parasite_free (parasite);
+  cmsCloseProfile (src_profile);
+
+  return success;
+}
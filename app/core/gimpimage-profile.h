@@ -22,15 +22,22 @@
 #define GIMP_ICC_PROFILE_PARASITE_NAME "icc-profile"
 
 
-gboolean             gimp_image_validate_icc_profile (GimpImage           *image,
-                                                      const GimpParasite  *icc_profile,
-                                                      GError             **error);
-const GimpParasite * gimp_image_get_icc_profile      (GimpImage           *image);
-void                 gimp_image_set_icc_profile      (GimpImage           *image,
-                                                      const GimpParasite  *icc_profile);
-
-GimpColorProfile     gimp_image_get_profile          (GimpImage           *image,
-                                                      GError             **error);
+gboolean             gimp_image_validate_icc_profile  (GimpImage                *image,
+                                                       const GimpParasite       *icc_profile,
+                                                       GError                  **error);
+const GimpParasite * gimp_image_get_icc_profile       (GimpImage                *image);
+void                 gimp_image_set_icc_profile       (GimpImage                *image,
+                                                       const GimpParasite       *icc_profile);
+
+GimpColorProfile     gimp_image_get_profile           (GimpImage                *image,
+                                                       GError                  **error);
+
+gboolean             gimp_image_convert_color_profile (GimpImage                *image,
+                                                       GimpColorProfile          dest_profile,
+                                                       GimpColorRenderingIntent  intent,
+                                                       gboolean                  bpc,
+                                                       GimpProgress             *progress,
+                                                       GError                  **error);
 
 
 #endif /* __GIMP_IMAGE_PROFILE_H__ */
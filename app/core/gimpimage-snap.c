@@ -344,9 +344,12 @@ gimp_image_snap_point (GimpImage *image,
         {
           GimpCoords nearest;
 
-          if (gimp_stroke_nearest_point_get (stroke, &coords, 1.0,
-                                             &nearest,
-                                             NULL, NULL, NULL) >= 0)
+          /*  points farther away than epsilon can't snap anyway  */
+          if (gimp_stroke_nearest_point_within (stroke, &coords, 1.0,
+                                                MAX (epsilon_x, epsilon_y) *
+                                                G_SQRT2,
+                                                &nearest,
+                                                NULL, NULL, NULL) >= 0)
             {
               snapped |= gimp_image_snap_distance (x, nearest.x,
                                                    epsilon_x,
@@ -652,9 +655,11 @@ gimp_image_snap_rectangle (GimpImage *image,
           coords1.x = x_center;
           coords1.y = y_center;
 
-          if (gimp_stroke_nearest_point_get (stroke, &coords1, 1.0,
-                                             &nearest,
-                                             NULL, NULL, NULL) >= 0)
+          if (gimp_stroke_nearest_point_within (stroke, &coords1, 1.0,
+                                                MAX (epsilon_x, epsilon_y) *
+                                                G_SQRT2,
+                                                &nearest,
+                                                NULL, NULL, NULL) >= 0)
             {
               if (gimp_image_snap_distance (x_center, nearest.x,
                                             epsilon_x,
@@ -20,6 +20,8 @@
 #include <gdk-pixbuf/gdk-pixbuf.h>
 #include <gegl.h>
 
+#include "libgimpconfig/gimpconfig.h"
+
 #include "core-types.h"
 
 #include "config/gimpcoreconfig.h"
@@ -42,6 +44,10 @@ static void          gimp_image_undo_pop_stack       (GimpImage     *image,
                                                       GimpUndoStack *redo_stack,
                                                       GimpUndoMode   undo_mode);
 static void          gimp_image_undo_free_space      (GimpImage     *image);
+static gint64        gimp_image_undo_spill           (GimpImage     *image,
+                                                      gint64         memsize,
+                                                      gint64         max_memsize);
+static gboolean      gimp_image_undo_spill_idle      (GimpImage     *image);
 static void          gimp_image_undo_free_redo       (GimpImage     *image);
 
 static GimpDirtyMask gimp_image_undo_dirty_from_type (GimpUndoType   undo_type);
@@ -241,6 +247,12 @@ gimp_image_undo_free (GimpImage *image)
 
   private = GIMP_IMAGE_GET_PRIVATE (image);
 
+  if (private->undo_spill_idle_id)
+    {
+      g_source_remove (private->undo_spill_idle_id);
+      private->undo_spill_idle_id = 0;
+    }
+
   /*  Emit the UNDO_FREE event before actually freeing everything
    *  so the views can properly detach from the undo items
    */
@@ -542,12 +554,33 @@ gimp_image_undo_free_space (GimpImage *image)
   gint              min_undo_levels;
   gint              max_undo_levels;
   gint64            undo_size;
+  gint64            undo_swap_size;
+  gint64            memsize;
 
   container = private->undo_stack->undos;
 
   min_undo_levels = image->gimp->config->levels_of_undo;
   max_undo_levels = 1024; /* FIXME */
   undo_size       = image->gimp->config->undo_size;
+  undo_swap_size  = image->gimp->config->undo_swap_size;
+
+  memsize = gimp_object_get_memsize (GIMP_OBJECT (container), NULL);
+
+  /*  move old steps to the swap instead of losing them  */
+  if (memsize > undo_size)
+    memsize = gimp_image_undo_spill (image, memsize, undo_size);
+
+  /*  and start doing so in the background once half of the budget
+   *  is used, so pushing an undo step rarely has to wait for it
+   */
+  if (memsize > undo_size / 2 && undo_swap_size > 0 &&
+      ! private->undo_spill_idle_id)
+    {
+      private->undo_spill_idle_id =
+        g_idle_add_full (G_PRIORITY_LOW,
+                         (GSourceFunc) gimp_image_undo_spill_idle,
+                         image, NULL);
+    }
 
 #ifdef DEBUG_IMAGE_UNDO
   g_printerr ("undo_steps: %d    undo_bytes: %ld\n",
@@ -560,6 +593,8 @@ gimp_image_undo_free_space (GimpImage *image)
     return;
 
   while ((gimp_object_get_memsize (GIMP_OBJECT (container), NULL) > undo_size) ||
+         (gimp_undo_get_spilled_size (GIMP_UNDO (private->undo_stack)) >
+          undo_swap_size) ||
          (gimp_container_get_n_children (container) > max_undo_levels))
     {
       GimpUndo *freed = gimp_undo_stack_free_bottom (private->undo_stack,
@@ -581,6 +616,70 @@ gimp_image_undo_free_space (GimpImage *image)
     }
 }
 
+/*  spills the oldest undo steps to the swap, until the undo stack uses
+ *  at most max_memsize bytes of memory or the swap budget is used up;
+ *  the most recent step always stays in memory. Returns the new memsize.
+ */
+static gint64
+gimp_image_undo_spill (GimpImage *image,
+                       gint64     memsize,
+                       gint64     max_memsize)
+{
+  GimpImagePrivate *private = GIMP_IMAGE_GET_PRIVATE (image);
+  GimpGeglConfig   *config  = GIMP_GEGL_CONFIG (image->gimp->config);
+  gint64            undo_swap_size;
+  gint64            spilled_size;
+  gchar            *swap_dir;
+  GList            *list;
+
+  undo_swap_size = image->gimp->config->undo_swap_size;
+
+  if (undo_swap_size == 0 || ! config->swap_path)
+    return memsize;
+
+  swap_dir = gimp_config_path_expand (config->swap_path, TRUE, NULL);
+
+  if (! swap_dir)
+    return memsize;
+
+  spilled_size = gimp_undo_get_spilled_size (GIMP_UNDO (private->undo_stack));
+
+  for (list = g_list_last (GIMP_LIST (private->undo_stack->undos)->list);
+       list && list->prev                 &&
+       memsize      >  max_memsize        &&
+       spilled_size <  undo_swap_size;
+       list = list->prev)
+    {
+      GimpUndo *undo = list->data;
+      gint64    size = gimp_undo_get_spilled_size (undo);
+
+      memsize -= gimp_undo_spill (undo, swap_dir);
+
+      spilled_size += gimp_undo_get_spilled_size (undo) - size;
+    }
+
+  g_free (swap_dir);
+
+  return memsize;
+}
+
+static gboolean
+gimp_image_undo_spill_idle (GimpImage *image)
+{
+  GimpImagePrivate *private = GIMP_IMAGE_GET_PRIVATE (image);
+  GimpContainer    *container;
+
+  private->undo_spill_idle_id = 0;
+
+  container = private->undo_stack->undos;
+
+  gimp_image_undo_spill (image,
+                         gimp_object_get_memsize (GIMP_OBJECT (container), NULL),
+                         image->gimp->config->undo_size / 2);
+
+  return FALSE;
+}
+
 static void
 gimp_image_undo_free_redo (GimpImage *image)
 {
@@ -198,6 +198,13 @@ static gdouble      gimp_image_get_opacity_at    (GimpPickable      *pickable,
                                                   gint               x,
                                                   gint               y);
 
+static void     gimp_image_projection_update     (GimpProjection    *projection,
+                                                  gboolean           now,
+                                                  gint               x,
+                                                  gint               y,
+                                                  gint               width,
+                                                  gint               height,
+                                                  GimpImage         *image);
 static void     gimp_image_mask_update           (GimpDrawable      *drawable,
                                                   gint               x,
                                                   gint               y,
@@ -216,6 +223,10 @@ static void     gimp_image_channel_name_changed  (GimpChannel       *channel,
                                                   GimpImage         *image);
 static void     gimp_image_channel_color_changed (GimpChannel       *channel,
                                                   GimpImage         *image);
+static void     gimp_image_channel_visibility_changed
+                                                 (GimpChannel       *channel,
+                                                  GimpImage         *image);
+static void     gimp_image_update_layers_cache   (GimpImage         *image);
 static void     gimp_image_active_layer_notify   (GimpItemTree      *tree,
                                                   const GParamSpec  *pspec,
                                                   GimpImage         *image);
@@ -543,6 +554,7 @@ gimp_image_class_init (GimpImageClass *klass)
   viewable_class->size_changed        = gimp_image_size_changed;
   viewable_class->get_preview_size    = gimp_image_get_preview_size;
   viewable_class->get_popup_size      = gimp_image_get_popup_size;
+  viewable_class->get_preview         = gimp_image_get_preview;
   viewable_class->get_new_preview     = gimp_image_get_new_preview;
   viewable_class->get_description     = gimp_image_get_description;
 
@@ -691,6 +703,10 @@ gimp_image_init (GimpImage *image)
 
   private->projection          = gimp_projection_new (GIMP_PROJECTABLE (image));
 
+  private->preview              = NULL;
+  private->preview_update_areas = g_array_new (FALSE, FALSE,
+                                               sizeof (GeglRectangle));
+
   private->guides              = NULL;
   private->grid                = NULL;
   private->sample_points       = NULL;
@@ -716,6 +732,10 @@ gimp_image_init (GimpImage *image)
                     G_CALLBACK (gimp_image_active_vectors_notify),
                     image);
 
+  g_signal_connect (private->projection, "update",
+                    G_CALLBACK (gimp_image_projection_update),
+                    image);
+
   g_signal_connect_swapped (private->layers->container, "update",
                             G_CALLBACK (gimp_image_invalidate),
                             image);
@@ -737,6 +757,10 @@ gimp_image_init (GimpImage *image)
     gimp_container_add_handler (private->channels->container, "color-changed",
                                 G_CALLBACK (gimp_image_channel_color_changed),
                                 image);
+  private->channel_visibility_handler =
+    gimp_container_add_handler (private->channels->container, "visibility-changed",
+                                G_CALLBACK (gimp_image_channel_visibility_changed),
+                                image);
 
   g_signal_connect (private->channels->container, "add",
                     G_CALLBACK (gimp_image_channel_add),
@@ -923,6 +947,8 @@ gimp_image_dispose (GObject *object)
                                  private->channel_name_changed_handler);
   gimp_container_remove_handler (private->channels->container,
                                  private->channel_color_changed_handler);
+  gimp_container_remove_handler (private->channels->container,
+                                 private->channel_visibility_handler);
 
   g_signal_handlers_disconnect_by_func (private->channels->container,
                                         gimp_image_channel_add,
@@ -953,11 +979,24 @@ gimp_image_finalize (GObject *object)
       private->projection = NULL;
     }
 
+  if (private->preview)
+    {
+      gimp_temp_buf_unref (private->preview);
+      private->preview = NULL;
+    }
+
+  if (private->preview_update_areas)
+    {
+      g_array_free (private->preview_update_areas, TRUE);
+      private->preview_update_areas = NULL;
+    }
+
   if (private->graph)
     {
       g_object_unref (private->graph);
       private->graph = NULL;
       private->visible_mask = NULL;
+      private->layers_cache = NULL;
     }
 
   if (private->colormap)
@@ -1143,6 +1182,8 @@ gimp_image_get_memsize (GimpObject *object,
   memsize += gimp_object_get_memsize (GIMP_OBJECT (private->projection),
                                       gui_size);
 
+  *gui_size += gimp_temp_buf_get_memsize (private->preview);
+
   memsize += gimp_g_list_get_memsize (gimp_image_get_guides (image),
                                       sizeof (GimpGuide));
 
@@ -1510,8 +1551,12 @@ gimp_image_get_graph (GimpProjectable *projectable)
 
   gegl_node_add_child (private->graph, channels_node);
 
-  gegl_node_connect_to (layers_node,   "output",
-                        channels_node, "input");
+  private->layers_cache =
+    gegl_node_new_child (private->graph,
+                         "operation", "gegl:cache",
+                         NULL);
+
+  gimp_image_update_layers_cache (image);
 
   mask = ~gimp_image_get_visible_mask (image) & GIMP_COMPONENT_ALL;
 
@@ -1532,6 +1577,18 @@ gimp_image_get_graph (GimpProjectable *projectable)
   return private->graph;
 }
 
+static void
+gimp_image_projection_update (GimpProjection *projection,
+                              gboolean        now,
+                              gint            x,
+                              gint            y,
+                              gint            width,
+                              gint            height,
+                              GimpImage      *image)
+{
+  gimp_image_preview_add_update_area (image, x, y, width, height);
+}
+
 static void
 gimp_image_mask_update (GimpDrawable *drawable,
                         gint          x,
@@ -1563,6 +1620,8 @@ gimp_image_channel_add (GimpContainer *container,
     {
       gimp_image_set_quick_mask_state (image, TRUE);
     }
+
+  gimp_image_update_layers_cache (image);
 }
 
 static void
@@ -1575,6 +1634,8 @@ gimp_image_channel_remove (GimpContainer *container,
     {
       gimp_image_set_quick_mask_state (image, FALSE);
     }
+
+  gimp_image_update_layers_cache (image);
 }
 
 static void
@@ -1604,6 +1665,72 @@ gimp_image_channel_color_changed (GimpChannel *channel,
     }
 }
 
+static void
+gimp_image_channel_visibility_changed (GimpChannel *channel,
+                                       GimpImage   *image)
+{
+  gimp_image_update_layers_cache (image);
+}
+
+/*  While channels are visible, the layer composite below them is kept
+ *  in a cache, so toggling, recoloring or painting on the channels
+ *  (like the quick mask) only re-renders the channel overlays.  The
+ *  cache is bypassed otherwise, so it doesn't duplicate the projection
+ *  of the usual image without visible channels.
+ */
+static void
+gimp_image_update_layers_cache (GimpImage *image)
+{
+  GimpImagePrivate *private = GIMP_IMAGE_GET_PRIVATE (image);
+  GeglNode         *layers_node;
+  GeglNode         *channels_node;
+  GeglNode         *source;
+  GList            *list;
+  gboolean          use_cache = FALSE;
+
+  if (! private->graph)
+    return;
+
+  for (list = gimp_image_get_channel_iter (image);
+       list;
+       list = g_list_next (list))
+    {
+      if (gimp_item_get_visible (list->data))
+        {
+          use_cache = TRUE;
+          break;
+        }
+    }
+
+  layers_node =
+    gimp_filter_stack_get_graph (GIMP_FILTER_STACK (private->layers->container));
+  channels_node =
+    gimp_filter_stack_get_graph (GIMP_FILTER_STACK (private->channels->container));
+
+  source = gegl_node_get_producer (channels_node, "input", NULL);
+
+  if (use_cache)
+    {
+      if (source != private->layers_cache)
+        {
+          gegl_node_link_many (layers_node,
+                               private->layers_cache,
+                               channels_node,
+                               NULL);
+        }
+    }
+  else
+    {
+      if (source != layers_node)
+        {
+          gegl_node_disconnect (private->layers_cache, "input");
+
+          gegl_node_connect_to (layers_node,   "output",
+                                channels_node, "input");
+        }
+    }
+}
+
 static void
 gimp_image_active_layer_notify (GimpItemTree     *tree,
                                 const GParamSpec *pspec,
@@ -2336,6 +2463,12 @@ gimp_image_get_xcf_version (GimpImage    *image,
   if (zlib_compression)
     version = MAX (8, version);
 
+  /* need version 9 for 64-bit file offsets, use the image's in-memory
+   * size as a very conservative upper bound of the file size
+   */
+  if (gimp_object_get_memsize (GIMP_OBJECT (image), NULL) >= G_MAXUINT32)
+    version = MAX (9, version);
+
   switch (version)
     {
     case 0:
@@ -2355,6 +2488,7 @@ gimp_image_get_xcf_version (GimpImage    *image,
     case 6:
     case 7:
     case 8:
+    case 9:
       if (gimp_version)   *gimp_version   = 210;
       if (version_string) *version_string = "GIMP 2.10";
       break;
@@ -4277,6 +4411,7 @@ gimp_image_add_layers (GimpImage   *image,
   offset_y = y + (height - layers_height) / 2 - layers_y;
 
   gimp_image_undo_group_start (image, GIMP_UNDO_GROUP_LAYER_ADD, undo_desc);
+  gimp_image_freeze_layers (image);
 
   for (list = layers; list; list = g_list_next (list))
     {
@@ -4289,12 +4424,34 @@ gimp_image_add_layers (GimpImage   *image,
       position++;
     }
 
+  gimp_image_thaw_layers (image);
+
   if (layers)
     gimp_image_set_active_layer (image, layers->data);
 
   gimp_image_undo_group_end (image);
 }
 
+/*  Freezes the image's layer stack for adding or removing many layers
+ *  at once: layer views rebuild only once, the layer graph is linked
+ *  once, and all projection updates are merged into one, on thaw.
+ */
+void
+gimp_image_freeze_layers (GimpImage *image)
+{
+  g_return_if_fail (GIMP_IS_IMAGE (image));
+
+  gimp_container_freeze (gimp_image_get_layers (image));
+}
+
+void
+gimp_image_thaw_layers (GimpImage *image)
+{
+  g_return_if_fail (GIMP_IS_IMAGE (image));
+
+  gimp_container_thaw (gimp_image_get_layers (image));
+}
+
 
 /*  channels  */
 
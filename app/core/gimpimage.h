@@ -412,6 +412,9 @@ void            gimp_image_add_layers            (GimpImage          *image,
                                                   gint                height,
                                                   const gchar        *undo_desc);
 
+void            gimp_image_freeze_layers         (GimpImage          *image);
+void            gimp_image_thaw_layers           (GimpImage          *image);
+
 gboolean        gimp_image_add_channel           (GimpImage          *image,
                                                   GimpChannel        *channel,
                                                   GimpChannel        *parent,
@@ -69,6 +69,10 @@ struct _GimpImagefilePrivate
   GIcon         *icon;
   GCancellable  *icon_cancellable;
 
+  GCancellable  *thumb_cancellable;
+  GdkPixbuf     *thumb_pixbuf;
+  gint           thumb_pixbuf_size;
+
   gchar         *description;
   gboolean       static_desc;
 };
@@ -97,6 +101,10 @@ static void        gimp_imagefile_notify_thumbnail (GimpImagefile  *imagefile,
 static void        gimp_imagefile_icon_callback    (GObject        *source_object,
                                                     GAsyncResult   *result,
                                                     gpointer        data);
+static void        gimp_imagefile_thumb_callback   (GObject        *source_object,
+                                                    GAsyncResult   *result,
+                                                    gpointer        data);
+static void        gimp_imagefile_thumb_cancel     (GimpImagefile  *imagefile);
 
 static GdkPixbuf * gimp_imagefile_load_thumb       (GimpImagefile  *imagefile,
                                                     gint            width,
@@ -187,6 +195,8 @@ gimp_imagefile_dispose (GObject *object)
       private->icon_cancellable = NULL;
     }
 
+  gimp_imagefile_thumb_cancel (GIMP_IMAGEFILE (object));
+
   G_OBJECT_CLASS (parent_class)->dispose (object);
 }
 
@@ -232,6 +242,8 @@ gimp_imagefile_name_changed (GimpObject *object)
   if (GIMP_OBJECT_CLASS (parent_class)->name_changed)
     GIMP_OBJECT_CLASS (parent_class)->name_changed (object);
 
+  gimp_imagefile_thumb_cancel (GIMP_IMAGEFILE (object));
+
   gimp_thumbnail_set_uri (private->thumbnail, gimp_object_get_name (object));
 
   if (private->file)
@@ -750,6 +762,69 @@ gimp_imagefile_icon_callback (GObject      *source_object,
     gimp_viewable_invalidate_preview (GIMP_VIEWABLE (imagefile));
 }
 
+static void
+gimp_imagefile_thumb_callback (GObject      *source_object,
+                               GAsyncResult *result,
+                               gpointer      data)
+{
+  GimpImagefile        *imagefile;
+  GimpImagefilePrivate *private;
+  GimpThumbnail        *thumbnail = GIMP_THUMBNAIL (source_object);
+  GError               *error     = NULL;
+  GdkPixbuf            *pixbuf;
+
+  pixbuf = gimp_thumbnail_load_thumb_finish (thumbnail, result, &error);
+
+  if (error)
+    {
+      /* we were cancelled from dispose() or because the file changed,
+       * the imagefile may be long gone, bail out
+       */
+      if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        {
+          g_clear_error (&error);
+          return;
+        }
+
+#ifdef GIMP_UNSTABLE
+      g_printerr ("%s: %s\n", G_STRFUNC, error->message);
+#endif
+
+      g_clear_error (&error);
+    }
+
+  imagefile = GIMP_IMAGEFILE (data);
+  private   = GET_PRIVATE (imagefile);
+
+  if (private->thumb_cancellable)
+    {
+      g_object_unref (private->thumb_cancellable);
+      private->thumb_cancellable = NULL;
+    }
+
+  /*  picked up by gimp_imagefile_load_thumb()  */
+  g_clear_object (&private->thumb_pixbuf);
+  private->thumb_pixbuf = pixbuf;
+
+  if (pixbuf)
+    gimp_viewable_invalidate_preview (GIMP_VIEWABLE (imagefile));
+}
+
+static void
+gimp_imagefile_thumb_cancel (GimpImagefile *imagefile)
+{
+  GimpImagefilePrivate *private = GET_PRIVATE (imagefile);
+
+  if (private->thumb_cancellable)
+    {
+      g_cancellable_cancel (private->thumb_cancellable);
+      g_object_unref (private->thumb_cancellable);
+      private->thumb_cancellable = NULL;
+    }
+
+  g_clear_object (&private->thumb_pixbuf);
+}
+
 const gchar *
 gimp_imagefile_get_desc_string (GimpImagefile *imagefile)
 {
@@ -901,29 +976,46 @@ gimp_imagefile_load_thumb (GimpImagefile *imagefile,
   GimpImagefilePrivate *private   = GET_PRIVATE (imagefile);
   GimpThumbnail        *thumbnail = private->thumbnail;
   GdkPixbuf            *pixbuf    = NULL;
-  GError               *error     = NULL;
   gint                  size      = MAX (width, height);
   gint                  pixbuf_width;
   gint                  pixbuf_height;
   gint                  preview_width;
   gint                  preview_height;
 
-  if (gimp_thumbnail_peek_thumb (thumbnail, size) < GIMP_THUMB_STATE_EXISTS)
-    return NULL;
+  /*  the thumbnail file is read asynchronously, and the preview is
+   *  invalidated when it arrives
+   */
+  if (private->thumb_pixbuf && private->thumb_pixbuf_size == size)
+    {
+      pixbuf = private->thumb_pixbuf;
+      private->thumb_pixbuf = NULL;
+    }
+  else
+    {
+      g_clear_object (&private->thumb_pixbuf);
 
-  if (thumbnail->image_state == GIMP_THUMB_STATE_NOT_FOUND)
-    return NULL;
+      if (gimp_thumbnail_peek_thumb (thumbnail, size) < GIMP_THUMB_STATE_EXISTS)
+        return NULL;
 
-  pixbuf = gimp_thumbnail_load_thumb (thumbnail, size, &error);
+      if (thumbnail->image_state == GIMP_THUMB_STATE_NOT_FOUND)
+        return NULL;
 
-  if (! pixbuf)
-    {
-      if (error)
+      if (private->thumb_cancellable &&
+          private->thumb_pixbuf_size != size)
         {
-          gimp_message (private->gimp, NULL, GIMP_MESSAGE_ERROR,
-                        _("Could not open thumbnail '%s': %s"),
-                        thumbnail->thumb_filename, error->message);
-          g_clear_error (&error);
+          gimp_imagefile_thumb_cancel (imagefile);
+        }
+
+      if (! private->thumb_cancellable)
+        {
+          private->thumb_cancellable = g_cancellable_new ();
+          private->thumb_pixbuf_size = size;
+
+          gimp_thumbnail_load_thumb_async (thumbnail, size,
+                                           G_PRIORITY_DEFAULT,
+                                           private->thumb_cancellable,
+                                           gimp_imagefile_thumb_callback,
+                                           imagefile);
         }
 
       return NULL;
@@ -44,6 +44,12 @@
 #include "gimpmarshal.h"
 #include "gimpprogress.h"
 
+#include "gimp-priorities.h"
+
+
+#define PREVIEW_CHUNK_SIZE 128
+#define PREVIEW_CHUNK_TIME 0.02
+
 
 enum
 {
@@ -74,6 +80,13 @@ struct _GimpImageMap
   GeglNode             *cast_before;
   GeglNode             *cast_after;
   GimpApplicator       *applicator;
+
+  GeglRectangle         preview_rect;
+
+  GArray               *render_chunks;
+  gint                  render_index;
+  gint                  render_n_visible;
+  guint                 render_idle_id;
 };
 
 
@@ -92,6 +105,12 @@ static gboolean   gimp_image_map_remove_filter   (GimpImageMap        *image_map
 static void       gimp_image_map_update_drawable (GimpImageMap        *image_map,
                                                   const GeglRectangle *area);
 
+static void       gimp_image_map_render_start    (GimpImageMap        *image_map,
+                                                  const GeglRectangle *area);
+static void       gimp_image_map_render_cancel   (GimpImageMap        *image_map);
+static void       gimp_image_map_render_schedule (GimpImageMap        *image_map);
+static gboolean   gimp_image_map_render_idle     (GimpImageMap        *image_map);
+
 static void       gimp_image_map_affect_changed  (GimpImage           *image,
                                                   GimpChannelType      channel,
                                                   GimpImageMap        *image_map);
@@ -128,6 +147,8 @@ gimp_image_map_init (GimpImageMap *image_map)
   image_map->region     = GIMP_IMAGE_MAP_REGION_SELECTION;
   image_map->opacity    = GIMP_OPACITY_OPAQUE;
   image_map->paint_mode = GIMP_REPLACE_MODE;
+
+  image_map->render_chunks = g_array_new (FALSE, FALSE, sizeof (GeglRectangle));
 }
 
 static void
@@ -135,6 +156,8 @@ gimp_image_map_dispose (GObject *object)
 {
   GimpImageMap *image_map = GIMP_IMAGE_MAP (object);
 
+  gimp_image_map_render_cancel (image_map);
+
   if (image_map->drawable)
     {
       gimp_image_map_remove_filter (image_map);
@@ -185,6 +208,8 @@ gimp_image_map_finalize (GObject *object)
       image_map->drawable = NULL;
     }
 
+  g_array_free (image_map->render_chunks, TRUE);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -224,6 +249,7 @@ gimp_image_map_set_region (GimpImageMap       *image_map,
     {
       image_map->region = region;
 
+      gimp_image_map_render_cancel (image_map);
       gimp_image_map_sync_region (image_map);
     }
 }
@@ -241,6 +267,7 @@ gimp_image_map_set_mode (GimpImageMap         *image_map,
       image_map->opacity    = opacity;
       image_map->paint_mode = paint_mode;
 
+      gimp_image_map_render_cancel (image_map);
       gimp_image_map_sync_mode (image_map);
     }
 }
@@ -255,10 +282,23 @@ gimp_image_map_set_gamma_hack (GimpImageMap *image_map,
     {
       image_map->gamma_hack = gamma_hack;
 
+      gimp_image_map_render_cancel (image_map);
       gimp_image_map_sync_gamma_hack (image_map);
     }
 }
 
+void
+gimp_image_map_set_preview_rect (GimpImageMap        *image_map,
+                                 const GeglRectangle *rect)
+{
+  g_return_if_fail (GIMP_IS_IMAGE_MAP (image_map));
+
+  if (rect)
+    image_map->preview_rect = *rect;
+  else
+    image_map->preview_rect.width = image_map->preview_rect.height = 0;
+}
+
 void
 gimp_image_map_apply (GimpImageMap        *image_map,
                       const GeglRectangle *area)
@@ -269,6 +309,9 @@ gimp_image_map_apply (GimpImageMap        *image_map,
 
   g_return_if_fail (GIMP_IS_IMAGE_MAP (image_map));
 
+  /*  Whatever is still being rendered is stale now  */
+  gimp_image_map_render_cancel (image_map);
+
   /*  Make sure the drawable is still valid  */
   if (! gimp_item_is_attached (GIMP_ITEM (image_map->drawable)))
     {
@@ -391,7 +434,7 @@ gimp_image_map_apply (GimpImageMap        *image_map,
     }
 
   gimp_image_map_add_filter (image_map);
-  gimp_image_map_update_drawable (image_map, &update_area);
+  gimp_image_map_render_start (image_map, &update_area);
 }
 
 gboolean
@@ -404,6 +447,8 @@ gimp_image_map_commit (GimpImageMap *image_map,
   g_return_val_if_fail (GIMP_IS_IMAGE_MAP (image_map), FALSE);
   g_return_val_if_fail (progress == NULL || GIMP_IS_PROGRESS (progress), FALSE);
 
+  gimp_image_map_render_cancel (image_map);
+
   if (gimp_image_map_is_filtering (image_map))
     {
       success = gimp_drawable_merge_filter (image_map->drawable,
@@ -425,6 +470,8 @@ gimp_image_map_abort (GimpImageMap *image_map)
 {
   g_return_if_fail (GIMP_IS_IMAGE_MAP (image_map));
 
+  gimp_image_map_render_cancel (image_map);
+
   if (gimp_image_map_remove_filter (image_map))
     {
       gimp_image_map_update_drawable (image_map, &image_map->filter_area);
@@ -622,6 +669,129 @@ gimp_image_map_affect_changed (GimpImage       *image,
                                GimpChannelType  channel,
                                GimpImageMap    *image_map)
 {
+  gimp_image_map_render_cancel (image_map);
+
   gimp_image_map_sync_affect (image_map);
-  gimp_image_map_update_drawable (image_map, &image_map->filter_area);
+  gimp_image_map_render_start (image_map, &image_map->filter_area);
+}
+
+/*  The preview is rendered into the applicator's cache in chunks,
+ *  from an idle in the main loop, starting with the ones inside the
+ *  preview rect.  The graph can't be processed from several threads
+ *  at once, and the main loop keeps reconfiguring it and rendering
+ *  the projection from it, so it's only ever touched from there.
+ *  Finished chunks update the drawable, so the projection picks them
+ *  up from the cache.
+ */
+static void
+gimp_image_map_render_start (GimpImageMap        *image_map,
+                             const GeglRectangle *area)
+{
+  GArray   *hidden;
+  gboolean  all_visible;
+  gint      x, y;
+
+  gimp_image_map_render_cancel (image_map);
+
+  hidden = g_array_new (FALSE, FALSE, sizeof (GeglRectangle));
+
+  all_visible = (image_map->preview_rect.width  <= 0 ||
+                 image_map->preview_rect.height <= 0);
+
+  for (y = area->y; y < area->y + area->height; y += PREVIEW_CHUNK_SIZE)
+    for (x = area->x; x < area->x + area->width; x += PREVIEW_CHUNK_SIZE)
+      {
+        GeglRectangle chunk;
+
+        chunk.x      = x;
+        chunk.y      = y;
+        chunk.width  = MIN (PREVIEW_CHUNK_SIZE, area->x + area->width  - x);
+        chunk.height = MIN (PREVIEW_CHUNK_SIZE, area->y + area->height - y);
+
+        if (all_visible ||
+            gegl_rectangle_intersect (NULL, &chunk, &image_map->preview_rect))
+          {
+            g_array_append_val (image_map->render_chunks, chunk);
+          }
+        else
+          {
+            g_array_append_val (hidden, chunk);
+          }
+      }
+
+  image_map->render_n_visible = image_map->render_chunks->len;
+
+  g_array_append_vals (image_map->render_chunks, hidden->data, hidden->len);
+  g_array_free (hidden, TRUE);
+
+  gimp_image_map_render_schedule (image_map);
+}
+
+static void
+gimp_image_map_render_cancel (GimpImageMap *image_map)
+{
+  if (image_map->render_idle_id)
+    {
+      g_source_remove (image_map->render_idle_id);
+      image_map->render_idle_id = 0;
+    }
+
+  g_array_set_size (image_map->render_chunks, 0);
+  image_map->render_index     = 0;
+  image_map->render_n_visible = 0;
+}
+
+static void
+gimp_image_map_render_schedule (GimpImageMap *image_map)
+{
+  gint priority;
+
+  if (image_map->render_index >= image_map->render_chunks->len)
+    {
+      gimp_image_map_render_cancel (image_map);
+      return;
+    }
+
+  if (image_map->render_index < image_map->render_n_visible)
+    priority = GIMP_PRIORITY_IMAGE_MAP_IDLE;
+  else
+    priority = GIMP_PRIORITY_IMAGE_MAP_HIDDEN_IDLE;
+
+  image_map->render_idle_id =
+    g_idle_add_full (priority,
+                     (GSourceFunc) gimp_image_map_render_idle,
+                     image_map, NULL);
+}
+
+static gboolean
+gimp_image_map_render_idle (GimpImageMap *image_map)
+{
+  GTimer   *timer   = g_timer_new ();
+  gboolean  visible = (image_map->render_index < image_map->render_n_visible);
+
+  image_map->render_idle_id = 0;
+
+  do
+    {
+      GeglRectangle *chunk = &g_array_index (image_map->render_chunks,
+                                             GeglRectangle,
+                                             image_map->render_index++);
+
+      gimp_applicator_render_cache (image_map->applicator, chunk);
+
+      gimp_drawable_update (image_map->drawable,
+                            chunk->x, chunk->y, chunk->width, chunk->height);
+    }
+  while (image_map->render_index < image_map->render_chunks->len &&
+         (image_map->render_index < image_map->render_n_visible) == visible &&
+         g_timer_elapsed (timer, NULL) < PREVIEW_CHUNK_TIME);
+
+  g_timer_destroy (timer);
+
+  g_signal_emit (image_map, image_map_signals[FLUSH], 0);
+
+  /*  continue at the other priority once the visible chunks are done  */
+  gimp_image_map_render_schedule (image_map);
+
+  return G_SOURCE_REMOVE;
 }
@@ -63,6 +63,9 @@ void           gimp_image_map_set_mode   (GimpImageMap         *image_map,
 void       gimp_image_map_set_gamma_hack (GimpImageMap         *image_map,
                                           gboolean              gamma_hack);
 
+void     gimp_image_map_set_preview_rect (GimpImageMap         *image_map,
+                                          const GeglRectangle  *rect);
+
 void           gimp_image_map_apply      (GimpImageMap         *image_map,
                                           const GeglRectangle  *area);
 
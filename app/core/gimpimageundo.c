@@ -189,8 +189,12 @@ gimp_image_undo_constructed (GObject *object)
       break;
 
     case GIMP_UNDO_IMAGE_METADATA:
-      image_undo->metadata =
-        gimp_metadata_duplicate (gimp_image_get_metadata (image));
+      /*  gimp_image_set_metadata() replaces the metadata object instead
+       *  of changing it, so keeping a reference is enough
+       */
+      if (gimp_image_get_metadata (image))
+        image_undo->metadata =
+          g_object_ref (gimp_image_get_metadata (image));
       break;
 
     case GIMP_UNDO_PARASITE_ATTACH:
@@ -459,9 +463,11 @@ gimp_image_undo_pop (GimpUndo            *undo,
 
     case GIMP_UNDO_IMAGE_METADATA:
       {
-        GimpMetadata *metadata;
+        GimpMetadata *metadata = gimp_image_get_metadata (image);
 
-        metadata = gimp_metadata_duplicate (gimp_image_get_metadata (image));
+        /*  swap the objects, neither is changed in place afterwards  */
+        if (metadata)
+          g_object_ref (metadata);
 
         gimp_image_set_metadata (image, image_undo->metadata, FALSE);
 
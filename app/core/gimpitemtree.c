@@ -57,6 +57,9 @@ struct _GimpItemTreePrivate
   GimpItem   *active_item;
 
   GHashTable *name_hash;
+
+  /*  base name -> n, where "base #1" to "base #n" are all taken  */
+  GHashTable *number_hash;
 };
 
 #define GIMP_ITEM_TREE_GET_PRIVATE(object) \
@@ -84,6 +87,10 @@ static gint64   gimp_item_tree_get_memsize   (GimpObject   *object,
 static void     gimp_item_tree_uniquefy_name (GimpItemTree *tree,
                                               GimpItem     *item,
                                               const gchar  *new_name);
+static void     gimp_item_tree_remove_name   (GimpItemTree *tree,
+                                              GimpItem     *item);
+static gchar  * gimp_item_tree_split_name    (const gchar  *name,
+                                              gint         *number);
 
 
 G_DEFINE_TYPE (GimpItemTree, gimp_item_tree, GIMP_TYPE_OBJECT)
@@ -139,7 +146,9 @@ gimp_item_tree_init (GimpItemTree *tree)
 {
   GimpItemTreePrivate *private = GIMP_ITEM_TREE_GET_PRIVATE (tree);
 
-  private->name_hash = g_hash_table_new (g_str_hash, g_str_equal);
+  private->name_hash   = g_hash_table_new (g_str_hash, g_str_equal);
+  private->number_hash = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                g_free, NULL);
 }
 
 static void
@@ -174,6 +183,12 @@ gimp_item_tree_finalize (GObject *object)
       private->name_hash = NULL;
     }
 
+  if (private->number_hash)
+    {
+      g_hash_table_unref (private->number_hash);
+      private->number_hash = NULL;
+    }
+
   if (tree->container)
     {
       g_object_unref (tree->container);
@@ -477,8 +492,7 @@ gimp_item_tree_remove_item (GimpItemTree *tree,
 
   g_object_ref (item);
 
-  g_hash_table_remove (private->name_hash,
-                       gimp_object_get_name (item));
+  gimp_item_tree_remove_name (tree, item);
 
   children = gimp_viewable_get_children (GIMP_VIEWABLE (item));
 
@@ -488,8 +502,7 @@ gimp_item_tree_remove_item (GimpItemTree *tree,
 
       while (list)
         {
-          g_hash_table_remove (private->name_hash,
-                               gimp_object_get_name (list->data));
+          gimp_item_tree_remove_name (tree, list->data);
 
           list = g_list_remove (list, list->data);
         }
@@ -640,8 +653,7 @@ gimp_item_tree_uniquefy_name (GimpItemTree *tree,
 
   if (new_name)
     {
-      g_hash_table_remove (private->name_hash,
-                           gimp_object_get_name (item));
+      gimp_item_tree_remove_name (tree, item);
 
       gimp_object_set_name (GIMP_OBJECT (item), new_name);
     }
@@ -649,32 +661,25 @@ gimp_item_tree_uniquefy_name (GimpItemTree *tree,
   if (g_hash_table_lookup (private->name_hash,
                            gimp_object_get_name (item)))
     {
-      gchar *name     = g_strdup (gimp_object_get_name (item));
-      gchar *ext      = strrchr (name, '#');
-      gchar *new_name = NULL;
-      gint   number   = 0;
-
-      if (ext)
-        {
-          gchar ext_str[8];
-
-          number = atoi (ext + 1);
+      gchar    *new_name = NULL;
+      gchar    *name;
+      gint      number;
+      gint      taken;
+      gpointer  value;
 
-          g_snprintf (ext_str, sizeof (ext_str), "%d", number);
+      name = gimp_item_tree_split_name (gimp_object_get_name (item),
+                                        &number);
 
-          /*  check if the extension really is of the form "#<n>"  */
-          if (! strcmp (ext_str, ext + 1))
-            {
-              if (ext > name && *(ext - 1) == ' ')
-                ext--;
+      /*  skip the numbers known to be taken, so adding many items of
+       *  the same name doesn't probe all of their names every time
+       */
+      value = g_hash_table_lookup (private->number_hash, name);
+      taken = GPOINTER_TO_INT (value);
 
-              *ext = '\0';
-            }
-          else
-            {
-              number = 0;
-            }
-        }
+      if (number <= taken)
+        number = taken;
+      else
+        taken = -1;
 
       do
         {
@@ -686,7 +691,14 @@ gimp_item_tree_uniquefy_name (GimpItemTree *tree,
         }
       while (g_hash_table_lookup (private->name_hash, new_name));
 
-      g_free (name);
+      /*  the numbers up to the new one are taken now, if they were
+       *  taken up to where the search started
+       */
+      if (taken >= 0)
+        g_hash_table_insert (private->number_hash,
+                             name, GINT_TO_POINTER (number));
+      else
+        g_free (name);
 
       gimp_object_take_name (GIMP_OBJECT (item), new_name);
     }
@@ -695,3 +707,72 @@ gimp_item_tree_uniquefy_name (GimpItemTree *tree,
                        (gpointer) gimp_object_get_name (item),
                        item);
 }
+
+static void
+gimp_item_tree_remove_name (GimpItemTree *tree,
+                            GimpItem     *item)
+{
+  GimpItemTreePrivate *private = GIMP_ITEM_TREE_GET_PRIVATE (tree);
+  gchar               *name;
+  gint                 number;
+
+  g_hash_table_remove (private->name_hash,
+                       gimp_object_get_name (item));
+
+  name = gimp_item_tree_split_name (gimp_object_get_name (item), &number);
+
+  /*  the removed number is free again  */
+  if (number > 0 &&
+      number <= GPOINTER_TO_INT (g_hash_table_lookup (private->number_hash,
+                                                      name)))
+    {
+      if (number > 1)
+        {
+          g_hash_table_insert (private->number_hash,
+                               name, GINT_TO_POINTER (number - 1));
+
+          return;
+        }
+
+      g_hash_table_remove (private->number_hash, name);
+    }
+
+  g_free (name);
+}
+
+/*  splits @name into its base name, which is returned, and the number
+ *  of a " #<n>" extension, or 0 if there is none
+ */
+static gchar *
+gimp_item_tree_split_name (const gchar *name,
+                           gint        *number)
+{
+  gchar *base = g_strdup (name);
+  gchar *ext  = strrchr (base, '#');
+
+  *number = 0;
+
+  if (ext)
+    {
+      gchar ext_str[8];
+
+      *number = atoi (ext + 1);
+
+      g_snprintf (ext_str, sizeof (ext_str), "%d", *number);
+
+      /*  check if the extension really is of the form "#<n>"  */
+      if (! strcmp (ext_str, ext + 1))
+        {
+          if (ext > base && *(ext - 1) == ' ')
+            ext--;
+
+          *ext = '\0';
+        }
+      else
+        {
+          *number = 0;
+        }
+    }
+
+  return base;
+}
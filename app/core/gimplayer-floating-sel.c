@@ -24,6 +24,8 @@
 
 #include "core-types.h"
 
+#include "gegl/gimp-gegl-loops.h"
+
 #include "gimpboundary.h"
 #include "gimpdrawable-filter.h"
 #include "gimperror.h"
@@ -102,6 +104,7 @@ floating_sel_anchor (GimpLayer *layer)
   GimpImage    *image;
   GimpDrawable *drawable;
   GimpFilter   *filter = NULL;
+  GeglRectangle bounds;
   gint          off_x, off_y;
   gint          dr_off_x, dr_off_y;
 
@@ -121,14 +124,23 @@ floating_sel_anchor (GimpLayer *layer)
   gimp_item_get_offset (GIMP_ITEM (layer), &off_x, &off_y);
   gimp_item_get_offset (GIMP_ITEM (drawable), &dr_off_x, &dr_off_y);
 
+  /*  only merge the part of the drawable that is actually covered by
+   *  the floating selection's non-transparent pixels, so we don't
+   *  composite and push undo for the whole drawable
+   */
   if (gimp_item_get_visible (GIMP_ITEM (layer)) &&
-      gimp_rectangle_intersect (off_x, off_y,
-                                gimp_item_get_width  (GIMP_ITEM (layer)),
-                                gimp_item_get_height (GIMP_ITEM (layer)),
-                                dr_off_x, dr_off_y,
+      gimp_gegl_buffer_get_alpha_bounds (
+        gimp_drawable_get_buffer (GIMP_DRAWABLE (layer)),
+        NULL, &bounds) &&
+      gimp_rectangle_intersect (bounds.x + off_x - dr_off_x,
+                                bounds.y + off_y - dr_off_y,
+                                bounds.width,
+                                bounds.height,
+                                0, 0,
                                 gimp_item_get_width  (GIMP_ITEM (drawable)),
                                 gimp_item_get_height (GIMP_ITEM (drawable)),
-                                NULL, NULL, NULL, NULL))
+                                &bounds.x, &bounds.y,
+                                &bounds.width, &bounds.height))
     {
       filter = gimp_drawable_get_floating_sel_filter (drawable);
       g_object_ref (filter);
@@ -141,7 +153,8 @@ floating_sel_anchor (GimpLayer *layer)
 
   if (filter)
     {
-      gimp_drawable_merge_filter (drawable, filter, NULL, NULL, FALSE);
+      gimp_drawable_merge_filter_area (drawable, filter, &bounds,
+                                       NULL, NULL, FALSE);
       g_object_unref (filter);
     }
 
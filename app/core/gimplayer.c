@@ -31,7 +31,9 @@
 #include "core-types.h"
 
 #include "gegl/gimp-gegl-apply-operation.h"
+#include "gegl/gimp-gegl-loops.h"
 #include "gegl/gimp-gegl-nodes.h"
+#include "gegl/gimp-gegl-utils.h"
 
 #include "gimpboundary.h"
 #include "gimpchannel-select.h"
@@ -1018,8 +1020,8 @@ gimp_layer_convert_type (GimpDrawable      *drawable,
 
   if (layer_dither_type == 0)
     {
-      gegl_buffer_copy (gimp_drawable_get_buffer (drawable), NULL,
-                        dest_buffer, NULL);
+      gimp_gegl_buffer_copy (gimp_drawable_get_buffer (drawable), NULL,
+                             dest_buffer, NULL);
     }
   else
     {
@@ -1258,8 +1260,18 @@ gimp_layer_new_from_buffer (GeglBuffer           *buffer,
                           format,
                           name, opacity, mode);
 
-  dest = gimp_drawable_get_buffer (GIMP_DRAWABLE (layer));
-  gegl_buffer_copy (buffer, NULL, dest, NULL);
+  if (gegl_buffer_get_format (buffer) == format)
+    {
+      /*  share the tiles copy-on-write, e.g. when pasting  */
+      dest = gimp_gegl_buffer_dup_area (buffer, NULL);
+      gimp_drawable_set_buffer (GIMP_DRAWABLE (layer), FALSE, NULL, dest);
+      g_object_unref (dest);
+    }
+  else
+    {
+      dest = gimp_drawable_get_buffer (GIMP_DRAWABLE (layer));
+      gegl_buffer_copy (buffer, NULL, dest, NULL);
+    }
 
   return layer;
 }
@@ -1676,13 +1688,21 @@ gimp_layer_apply_mask (GimpLayer         *layer,
                                  gimp_item_get_width  (item),
                                  gimp_item_get_height (item));
 
-      /*  Combine the current layer's alpha channel and the mask  */
+      /*  Combine the current layer's alpha channel and the mask,
+       *  in place and without going through a graph
+       */
       mask_buffer = gimp_drawable_get_buffer (GIMP_DRAWABLE (mask));
       dest_buffer = gimp_drawable_get_buffer (GIMP_DRAWABLE (layer));
 
-      gimp_gegl_apply_opacity (gimp_drawable_get_buffer (GIMP_DRAWABLE (layer)),
-                               NULL, NULL, dest_buffer,
-                               mask_buffer, 0, 0, 1.0);
+      gimp_gegl_apply_mask (mask_buffer,
+                            GEGL_RECTANGLE (0, 0,
+                                            gimp_item_get_width  (item),
+                                            gimp_item_get_height (item)),
+                            dest_buffer,
+                            GEGL_RECTANGLE (0, 0,
+                                            gimp_item_get_width  (item),
+                                            gimp_item_get_height (item)),
+                            1.0);
     }
 
   g_signal_handlers_disconnect_by_func (mask,
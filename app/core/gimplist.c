@@ -30,6 +30,16 @@
 #include "gimplist.h"
 
 
+typedef struct _GimpListEntry GimpListEntry;
+
+struct _GimpListEntry
+{
+  GList *link;      /*  the object's link in list->list             */
+  gint   position;  /*  index + list->first_position, if valid      */
+  gchar *name;      /*  the object's key in list->names, or NULL    */
+};
+
+
 enum
 {
   PROP_0,
@@ -39,6 +49,7 @@ enum
 };
 
 
+static void         gimp_list_finalize           (GObject             *object);
 static void         gimp_list_set_property       (GObject             *object,
                                                   guint                property_id,
                                                   const GValue        *value,
@@ -71,6 +82,28 @@ static GimpObject * gimp_list_get_child_by_index (const GimpContainer *container
 static gint         gimp_list_get_child_index    (const GimpContainer *container,
                                                   const GimpObject    *object);
 
+static void         gimp_list_entry_free         (GimpListEntry       *entry);
+static void         gimp_list_set_entry_name     (GimpList            *list,
+                                                  GimpListEntry       *entry,
+                                                  GimpObject          *object,
+                                                  const gchar         *name);
+static void         gimp_list_ensure_index       (GimpList            *list);
+static void         gimp_list_ensure_positions   (GimpList            *list);
+static void         gimp_list_invalidate_index   (GimpList            *list);
+static gint         gimp_list_lower_bound        (GimpList            *list,
+                                                  GimpObject          *object,
+                                                  gint                 skip);
+static void         gimp_list_insert_link        (GimpList            *list,
+                                                  GimpListEntry       *entry,
+                                                  GimpObject          *object,
+                                                  gint                 index);
+static void         gimp_list_remove_link        (GimpList            *list,
+                                                  GimpListEntry       *entry,
+                                                  GimpObject          *object);
+
+static gboolean     gimp_list_name_in_use        (GimpList            *list,
+                                                  GimpObject          *object,
+                                                  const gchar         *name);
 static void         gimp_list_uniquefy_name      (GimpList            *gimp_list,
                                                   GimpObject          *object);
 static void         gimp_list_object_renamed     (GimpObject          *object,
@@ -89,6 +122,7 @@ gimp_list_class_init (GimpListClass *klass)
   GimpObjectClass    *gimp_object_class = GIMP_OBJECT_CLASS (klass);
   GimpContainerClass *container_class   = GIMP_CONTAINER_CLASS (klass);
 
+  object_class->finalize              = gimp_list_finalize;
   object_class->set_property          = gimp_list_set_property;
   object_class->get_property          = gimp_list_get_property;
 
@@ -132,6 +166,44 @@ gimp_list_init (GimpList *list)
   list->unique_names = FALSE;
   list->sort_func    = NULL;
   list->append       = FALSE;
+
+  list->entries = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                         NULL,
+                                         (GDestroyNotify) gimp_list_entry_free);
+
+  /*  the keys are owned by the entries  */
+  list->names   = g_hash_table_new (g_str_hash, g_str_equal);
+
+  list->index           = g_ptr_array_new ();
+  list->index_valid     = TRUE;
+  list->first_position  = 0;
+  list->positions_valid = TRUE;
+}
+
+static void
+gimp_list_finalize (GObject *object)
+{
+  GimpList *list = GIMP_LIST (object);
+
+  if (list->names)
+    {
+      g_hash_table_unref (list->names);
+      list->names = NULL;
+    }
+
+  if (list->entries)
+    {
+      g_hash_table_unref (list->entries);
+      list->entries = NULL;
+    }
+
+  if (list->index)
+    {
+      g_ptr_array_free (list->index, TRUE);
+      list->index = NULL;
+    }
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
 static void
@@ -194,7 +266,7 @@ gimp_list_get_memsize (GimpObject *object,
   gint64    memsize = 0;
 
   memsize += (gimp_container_get_n_children (GIMP_CONTAINER (list)) *
-              sizeof (GList));
+              (sizeof (GList) + sizeof (GimpListEntry) + sizeof (gpointer)));
 
   if (gimp_container_get_policy (GIMP_CONTAINER (list)) ==
       GIMP_CONTAINER_POLICY_STRONG)
@@ -213,7 +285,9 @@ static void
 gimp_list_add (GimpContainer *container,
                GimpObject    *object)
 {
-  GimpList *list = GIMP_LIST (container);
+  GimpList      *list = GIMP_LIST (container);
+  GimpListEntry *entry;
+  gint           index;
 
   if (list->unique_names)
     gimp_list_uniquefy_name (list, object);
@@ -223,12 +297,23 @@ gimp_list_add (GimpContainer *container,
                       G_CALLBACK (gimp_list_object_renamed),
                       list);
 
+  entry = g_slice_new0 (GimpListEntry);
+  g_hash_table_insert (list->entries, object, entry);
+
+  gimp_list_ensure_index (list);
+
   if (list->sort_func)
-    list->list = g_list_insert_sorted (list->list, object, list->sort_func);
+    index = gimp_list_lower_bound (list, object, -1);
   else if (list->append)
-    list->list = g_list_append (list->list, object);
+    index = list->index->len;
   else
-    list->list = g_list_prepend (list->list, object);
+    index = 0;
+
+  gimp_list_insert_link (list, entry, object, index);
+
+  if (list->unique_names)
+    gimp_list_set_entry_name (list, entry, object,
+                              gimp_object_get_name (object));
 
   GIMP_CONTAINER_CLASS (parent_class)->add (container, object);
 }
@@ -237,14 +322,19 @@ static void
 gimp_list_remove (GimpContainer *container,
                   GimpObject    *object)
 {
-  GimpList *list = GIMP_LIST (container);
+  GimpList      *list  = GIMP_LIST (container);
+  GimpListEntry *entry = g_hash_table_lookup (list->entries, object);
 
   if (list->unique_names || list->sort_func)
     g_signal_handlers_disconnect_by_func (object,
                                           gimp_list_object_renamed,
                                           list);
 
-  list->list = g_list_remove (list->list, object);
+  gimp_list_ensure_index (list);
+  gimp_list_remove_link (list, entry, object);
+
+  gimp_list_set_entry_name (list, entry, object, NULL);
+  g_hash_table_remove (list->entries, object);
 
   GIMP_CONTAINER_CLASS (parent_class)->remove (container, object);
 }
@@ -254,14 +344,13 @@ gimp_list_reorder (GimpContainer *container,
                    GimpObject    *object,
                    gint           new_index)
 {
-  GimpList *list = GIMP_LIST (container);
+  GimpList      *list  = GIMP_LIST (container);
+  GimpListEntry *entry = g_hash_table_lookup (list->entries, object);
 
-  list->list = g_list_remove (list->list, object);
+  gimp_list_ensure_index (list);
 
-  if (new_index == gimp_container_get_n_children (container) - 1)
-    list->list = g_list_append (list->list, object);
-  else
-    list->list = g_list_insert (list->list, object, new_index);
+  gimp_list_remove_link (list, entry, object);
+  gimp_list_insert_link (list, entry, object, new_index);
 }
 
 static void
@@ -279,7 +368,7 @@ gimp_list_have (const GimpContainer *container,
 {
   GimpList *list = GIMP_LIST (container);
 
-  return g_list_find (list->list, object) ? TRUE : FALSE;
+  return g_hash_table_contains (list->entries, object);
 }
 
 static void
@@ -299,6 +388,10 @@ gimp_list_get_child_by_name (const GimpContainer *container,
   GimpList *list = GIMP_LIST (container);
   GList    *glist;
 
+  /*  with unique names, the name table is exact  */
+  if (list->unique_names)
+    return g_hash_table_lookup (list->names, name);
+
   for (glist = list->list; glist; glist = g_list_next (glist))
     {
       GimpObject *object = glist->data;
@@ -315,12 +408,11 @@ gimp_list_get_child_by_index (const GimpContainer *container,
                               gint                 index)
 {
   GimpList *list = GIMP_LIST (container);
-  GList    *glist;
 
-  glist = g_list_nth (list->list, index);
+  gimp_list_ensure_index (list);
 
-  if (glist)
-    return (GimpObject *) glist->data;
+  if (index >= 0 && index < list->index->len)
+    return g_ptr_array_index (list->index, index);
 
   return NULL;
 }
@@ -329,9 +421,15 @@ static gint
 gimp_list_get_child_index (const GimpContainer *container,
                            const GimpObject    *object)
 {
-  GimpList *list = GIMP_LIST (container);
+  GimpList      *list  = GIMP_LIST (container);
+  GimpListEntry *entry = g_hash_table_lookup (list->entries, object);
 
-  return g_list_index (list->list, (gpointer) object);
+  if (! entry)
+    return -1;
+
+  gimp_list_ensure_positions (list);
+
+  return entry->position - list->first_position;
 }
 
 /**
@@ -417,6 +515,7 @@ gimp_list_reverse (GimpList *list)
     {
       gimp_container_freeze (GIMP_CONTAINER (list));
       list->list = g_list_reverse (list->list);
+      gimp_list_invalidate_index (list);
       gimp_container_thaw (GIMP_CONTAINER (list));
     }
 }
@@ -481,6 +580,7 @@ gimp_list_sort (GimpList     *list,
     {
       gimp_container_freeze (GIMP_CONTAINER (list));
       list->list = g_list_sort (list->list, sort_func);
+      gimp_list_invalidate_index (list);
       gimp_container_thaw (GIMP_CONTAINER (list));
     }
 }
@@ -502,28 +602,219 @@ gimp_list_sort_by_name (GimpList *list)
 
 /*  private functions  */
 
+static void
+gimp_list_entry_free (GimpListEntry *entry)
+{
+  g_free (entry->name);
+
+  g_slice_free (GimpListEntry, entry);
+}
+
+static void
+gimp_list_set_entry_name (GimpList      *list,
+                          GimpListEntry *entry,
+                          GimpObject    *object,
+                          const gchar   *name)
+{
+  if (entry->name)
+    {
+      if (g_hash_table_lookup (list->names, entry->name) == object)
+        g_hash_table_remove (list->names, entry->name);
+
+      g_clear_pointer (&entry->name, g_free);
+    }
+
+  if (name)
+    {
+      entry->name = g_strdup (name);
+
+      g_hash_table_replace (list->names, entry->name, object);
+    }
+}
+
+/*  list->index mirrors list->list as an array, it is rebuilt lazily
+ *  only after the whole list was rearranged by sorting or reversing
+ */
+static void
+gimp_list_ensure_index (GimpList *list)
+{
+  if (! list->index_valid)
+    {
+      GList *glist;
+
+      g_ptr_array_set_size (list->index, 0);
+
+      for (glist = list->list; glist; glist = g_list_next (glist))
+        g_ptr_array_add (list->index, glist->data);
+
+      list->index_valid = TRUE;
+    }
+}
+
+/*  the entries' positions are contiguous and start at
+ *  list->first_position, so prepending, appending and removing at
+ *  either end keep them valid
+ */
+static void
+gimp_list_ensure_positions (GimpList *list)
+{
+  if (! list->positions_valid)
+    {
+      gint i;
+
+      gimp_list_ensure_index (list);
+
+      for (i = 0; i < list->index->len; i++)
+        {
+          GimpListEntry *entry;
+
+          entry = g_hash_table_lookup (list->entries,
+                                       g_ptr_array_index (list->index, i));
+
+          entry->position = i;
+        }
+
+      list->first_position  = 0;
+      list->positions_valid = TRUE;
+    }
+}
+
+static void
+gimp_list_invalidate_index (GimpList *list)
+{
+  list->index_valid     = FALSE;
+  list->positions_valid = FALSE;
+}
+
+/*  returns the index of the first child which does not sort before
+ *  @object, ignoring the child at @skip, which is the same place
+ *  g_list_insert_sorted() would pick
+ */
+static gint
+gimp_list_lower_bound (GimpList   *list,
+                       GimpObject *object,
+                       gint        skip)
+{
+  gint lo = 0;
+  gint hi = list->index->len;
+
+  if (skip >= 0)
+    hi--;
+
+  while (lo < hi)
+    {
+      gint mid = (lo + hi) / 2;
+      gint i   = (skip >= 0 && mid >= skip) ? mid + 1 : mid;
+
+      if (list->sort_func (object, g_ptr_array_index (list->index, i)) > 0)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+
+  return lo;
+}
+
+static void
+gimp_list_insert_link (GimpList      *list,
+                       GimpListEntry *entry,
+                       GimpObject    *object,
+                       gint           index)
+{
+  gint n = list->index->len;
+
+  if (index < n)
+    {
+      GimpListEntry *sibling;
+
+      sibling = g_hash_table_lookup (list->entries,
+                                     g_ptr_array_index (list->index, index));
+
+      list->list  = g_list_insert_before (list->list, sibling->link, object);
+      entry->link = sibling->link->prev;
+    }
+  else if (n > 0)
+    {
+      GimpListEntry *last;
+
+      last = g_hash_table_lookup (list->entries,
+                                  g_ptr_array_index (list->index, n - 1));
+
+      g_list_append (last->link, object);
+      entry->link = last->link->next;
+    }
+  else
+    {
+      list->list  = g_list_prepend (list->list, object);
+      entry->link = list->list;
+    }
+
+  g_ptr_array_insert (list->index, index, object);
+
+  if (list->positions_valid)
+    {
+      if (index == 0)
+        entry->position = --list->first_position;
+      else if (index == n)
+        entry->position = list->first_position + n;
+      else
+        list->positions_valid = FALSE;
+    }
+}
+
+static void
+gimp_list_remove_link (GimpList      *list,
+                       GimpListEntry *entry,
+                       GimpObject    *object)
+{
+  gint n = list->index->len;
+  gint index;
+
+  list->list  = g_list_delete_link (list->list, entry->link);
+  entry->link = NULL;
+
+  if (list->positions_valid)
+    {
+      index = entry->position - list->first_position;
+    }
+  else
+    {
+      for (index = 0; index < n; index++)
+        if (g_ptr_array_index (list->index, index) == object)
+          break;
+    }
+
+  g_ptr_array_remove_index (list->index, index);
+
+  if (list->positions_valid)
+    {
+      if (index == 0)
+        list->first_position++;
+      else if (index != n - 1)
+        list->positions_valid = FALSE;
+    }
+}
+
+static gboolean
+gimp_list_name_in_use (GimpList    *list,
+                       GimpObject  *object,
+                       const gchar *name)
+{
+  GimpObject *object2 = g_hash_table_lookup (list->names, name);
+
+  return object2 && object2 != object;
+}
+
 static void
 gimp_list_uniquefy_name (GimpList   *gimp_list,
                          GimpObject *object)
 {
   gchar *name = (gchar *) gimp_object_get_name (object);
-  GList *list;
 
   if (! name)
     return;
 
-  for (list = gimp_list->list; list; list = g_list_next (list))
-    {
-      GimpObject  *object2 = list->data;
-      const gchar *name2   = gimp_object_get_name (object2);
-
-      if (object != object2 &&
-          name2             &&
-          ! strcmp (name, name2))
-        break;
-    }
-
-  if (list)
+  if (gimp_list_name_in_use (gimp_list, object, name))
     {
       gchar *ext;
       gchar *new_name   = NULL;
@@ -562,19 +853,8 @@ gimp_list_uniquefy_name (GimpList   *gimp_list,
           g_free (new_name);
 
           new_name = g_strdup_printf ("%s #%d", name, unique_ext);
-
-          for (list = gimp_list->list; list; list = g_list_next (list))
-            {
-              GimpObject  *object2 = list->data;
-              const gchar *name2   = gimp_object_get_name (object2);
-
-              if (object != object2 &&
-                  name2             &&
-                  ! strcmp (new_name, name2))
-                break;
-            }
         }
-      while (list);
+      while (gimp_list_name_in_use (gimp_list, object, new_name));
 
       g_free (name);
 
@@ -597,28 +877,22 @@ gimp_list_object_renamed (GimpObject *object,
       g_signal_handlers_unblock_by_func (object,
                                          gimp_list_object_renamed,
                                          list);
+
+      gimp_list_set_entry_name (list,
+                                g_hash_table_lookup (list->entries, object),
+                                object, gimp_object_get_name (object));
     }
 
   if (list->sort_func)
     {
-      GList *glist;
-      gint   old_index;
-      gint   new_index = 0;
-
-      old_index = g_list_index (list->list, object);
+      GimpListEntry *entry = g_hash_table_lookup (list->entries, object);
+      gint           old_index;
+      gint           new_index;
 
-      for (glist = list->list; glist; glist = g_list_next (glist))
-        {
-          GimpObject *object2 = GIMP_OBJECT (glist->data);
-
-          if (object == object2)
-            continue;
+      gimp_list_ensure_positions (list);
 
-          if (list->sort_func (object, object2) > 0)
-            new_index++;
-          else
-            break;
-        }
+      old_index = entry->position - list->first_position;
+      new_index = gimp_list_lower_bound (list, object, old_index);
 
       if (new_index != old_index)
         gimp_container_reorder (GIMP_CONTAINER (list), object, new_index);
@@ -43,6 +43,14 @@ struct _GimpList
   gboolean       unique_names;
   GCompareFunc   sort_func;
   gboolean       append;
+
+  /*  lookup tables, kept in sync with list  */
+  GHashTable    *entries;
+  GHashTable    *names;
+  GPtrArray     *index;
+  gboolean       index_valid;
+  gint           first_position;
+  gboolean       positions_valid;
 };
 
 struct _GimpListClass
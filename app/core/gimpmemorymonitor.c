@@ -0,0 +1,668 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimpmemorymonitor.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <gdk-pixbuf/gdk-pixbuf.h>
+#include <gegl.h>
+
+#include "core-types.h"
+
+#include "gimp.h"
+#include "gimpchannel.h"
+#include "gimpcontainer.h"
+#include "gimpimage.h"
+#include "gimpimage-undo.h"
+#include "gimpitem.h"
+#include "gimplist.h"
+#include "gimpmarshal.h"
+#include "gimpmemorymonitor.h"
+#include "gimpprojection.h"
+#include "gimptempbuf.h"
+#include "gimptreehandler.h"
+#include "gimpundo.h"
+#include "gimpundostack.h"
+
+#include "gimp-intl.h"
+
+
+/*  sizes are not recomputed on every change, but at most once per
+ *  UPDATE_INTERVAL, and only for the parts of an image that changed
+ *  since the last update
+ */
+#define UPDATE_INTERVAL 1000 /* milliseconds */
+
+
+enum
+{
+  CHANGED,
+  LAST_SIGNAL
+};
+
+
+typedef struct _GimpMemoryImage GimpMemoryImage;
+typedef struct _GimpMemoryItem  GimpMemoryItem;
+
+struct _GimpMemoryImage
+{
+  GimpMemoryMonitor *monitor;
+  GimpImage         *image;
+
+  GimpTreeHandler   *layer_handler;
+  GimpTreeHandler   *channel_handler;
+  GimpTreeHandler   *vectors_handler;
+
+  /*  top-level item => GimpMemoryItem; the size of a group layer
+   *  includes its children
+   */
+  GHashTable        *items;
+  gboolean           items_dirty;
+  gboolean           undo_dirty;
+
+  gint64             sizes[GIMP_MEMORY_N_CATEGORIES];
+};
+
+struct _GimpMemoryItem
+{
+  GimpMemoryCategory category;
+  gint64             size;
+  gboolean           dirty;
+};
+
+
+static void     gimp_memory_monitor_finalize       (GObject           *object);
+
+static gint64   gimp_memory_monitor_get_memsize    (GimpObject        *object,
+                                                    gint64            *gui_size);
+
+static void     gimp_memory_monitor_image_add      (GimpContainer     *images,
+                                                    GimpImage         *image,
+                                                    GimpMemoryMonitor *monitor);
+static void     gimp_memory_monitor_image_foreach  (GimpImage         *image,
+                                                    GimpMemoryMonitor *monitor);
+static void     gimp_memory_monitor_image_remove   (GimpContainer     *images,
+                                                    GimpImage         *image,
+                                                    GimpMemoryMonitor *monitor);
+static void     gimp_memory_monitor_image_free     (GimpMemoryImage   *record);
+
+static void     gimp_memory_monitor_item_changed   (GimpItem          *item,
+                                                    GimpMemoryImage   *record);
+static void     gimp_memory_monitor_items_changed  (GimpContainer     *container,
+                                                    GimpObject        *object,
+                                                    GimpMemoryImage   *record);
+static void     gimp_memory_monitor_undo_event     (GimpImage         *image,
+                                                    GimpUndoEvent      event,
+                                                    GimpUndo          *undo,
+                                                    GimpMemoryImage   *record);
+
+static void     gimp_memory_monitor_queue_update   (GimpMemoryMonitor *monitor);
+static gboolean gimp_memory_monitor_update_timeout (GimpMemoryMonitor *monitor);
+
+static void     gimp_memory_monitor_update_items   (GimpMemoryImage   *record,
+                                                    GHashTable        *items,
+                                                    GimpContainer     *container,
+                                                    GimpMemoryCategory category);
+static void     gimp_memory_monitor_update_image   (GimpMemoryImage   *record);
+
+
+G_DEFINE_TYPE (GimpMemoryMonitor, gimp_memory_monitor, GIMP_TYPE_OBJECT)
+
+#define parent_class gimp_memory_monitor_parent_class
+
+static guint monitor_signals[LAST_SIGNAL] = { 0 };
+
+
+static void
+gimp_memory_monitor_class_init (GimpMemoryMonitorClass *klass)
+{
+  GObjectClass    *object_class      = G_OBJECT_CLASS (klass);
+  GimpObjectClass *gimp_object_class = GIMP_OBJECT_CLASS (klass);
+
+  monitor_signals[CHANGED] =
+    g_signal_new ("changed",
+                  G_TYPE_FROM_CLASS (klass),
+                  G_SIGNAL_RUN_FIRST,
+                  G_STRUCT_OFFSET (GimpMemoryMonitorClass, changed),
+                  NULL, NULL,
+                  gimp_marshal_VOID__VOID,
+                  G_TYPE_NONE, 0);
+
+  object_class->finalize         = gimp_memory_monitor_finalize;
+
+  gimp_object_class->get_memsize = gimp_memory_monitor_get_memsize;
+}
+
+static void
+gimp_memory_monitor_init (GimpMemoryMonitor *monitor)
+{
+  monitor->images = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                           NULL,
+                                           (GDestroyNotify) gimp_memory_monitor_image_free);
+}
+
+static void
+gimp_memory_monitor_finalize (GObject *object)
+{
+  GimpMemoryMonitor *monitor = GIMP_MEMORY_MONITOR (object);
+
+  if (monitor->update_id)
+    {
+      g_source_remove (monitor->update_id);
+      monitor->update_id = 0;
+    }
+
+  if (monitor->gimp)
+    {
+      g_signal_handlers_disconnect_by_func (monitor->gimp->images,
+                                            gimp_memory_monitor_image_add,
+                                            monitor);
+      g_signal_handlers_disconnect_by_func (monitor->gimp->images,
+                                            gimp_memory_monitor_image_remove,
+                                            monitor);
+    }
+
+  if (monitor->images)
+    {
+      g_hash_table_unref (monitor->images);
+      monitor->images = NULL;
+    }
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static gint64
+gimp_memory_monitor_get_memsize (GimpObject *object,
+                                 gint64     *gui_size)
+{
+  GimpMemoryMonitor *monitor = GIMP_MEMORY_MONITOR (object);
+  GHashTableIter     iter;
+  gpointer           value;
+  gint64             memsize = 0;
+
+  g_hash_table_iter_init (&iter, monitor->images);
+
+  while (g_hash_table_iter_next (&iter, NULL, &value))
+    {
+      GimpMemoryImage *record = value;
+
+      memsize += (sizeof (GimpMemoryImage) +
+                  g_hash_table_size (record->items) *
+                  (sizeof (GimpMemoryItem) + 2 * sizeof (gpointer)));
+    }
+
+  return memsize + GIMP_OBJECT_CLASS (parent_class)->get_memsize (object,
+                                                                  gui_size);
+}
+
+
+/*  public functions  */
+
+GimpMemoryMonitor *
+gimp_memory_monitor_new (Gimp *gimp)
+{
+  GimpMemoryMonitor *monitor;
+
+  g_return_val_if_fail (GIMP_IS_GIMP (gimp), NULL);
+
+  monitor = g_object_new (GIMP_TYPE_MEMORY_MONITOR,
+                          "name", "memory monitor",
+                          NULL);
+
+  monitor->gimp = gimp;
+
+  gimp_container_foreach (gimp->images,
+                          (GFunc) gimp_memory_monitor_image_foreach,
+                          monitor);
+
+  g_signal_connect (gimp->images, "add",
+                    G_CALLBACK (gimp_memory_monitor_image_add),
+                    monitor);
+  g_signal_connect (gimp->images, "remove",
+                    G_CALLBACK (gimp_memory_monitor_image_remove),
+                    monitor);
+
+  gimp_memory_monitor_queue_update (monitor);
+
+  return monitor;
+}
+
+void
+gimp_memory_monitor_update (GimpMemoryMonitor *monitor)
+{
+  GHashTableIter iter;
+  gpointer       value;
+  gsize          live_size;
+  gsize          cached_size;
+  gint64         sizes[GIMP_MEMORY_N_CATEGORIES] = { 0, };
+  gint           i;
+
+  g_return_if_fail (GIMP_IS_MEMORY_MONITOR (monitor));
+
+  if (monitor->update_id)
+    {
+      g_source_remove (monitor->update_id);
+      monitor->update_id = 0;
+    }
+
+  g_hash_table_iter_init (&iter, monitor->images);
+
+  while (g_hash_table_iter_next (&iter, NULL, &value))
+    {
+      GimpMemoryImage *record = value;
+
+      gimp_memory_monitor_update_image (record);
+
+      for (i = 0; i < GIMP_MEMORY_N_CATEGORIES; i++)
+        sizes[i] += record->sizes[i];
+    }
+
+  gimp_temp_buf_get_pool_stats (&live_size, &cached_size);
+
+  sizes[GIMP_MEMORY_TEMP_BUFS] = live_size + cached_size;
+
+  if (memcmp (sizes, monitor->sizes, sizeof (sizes)) ||
+      monitor->n_history == 0)
+    {
+      GimpMemorySample *sample;
+
+      memcpy (monitor->sizes, sizes, sizeof (sizes));
+
+      if (monitor->n_history < GIMP_MEMORY_MONITOR_HISTORY)
+        {
+          sample = &monitor->history[(monitor->history_start +
+                                      monitor->n_history) %
+                                     GIMP_MEMORY_MONITOR_HISTORY];
+          monitor->n_history++;
+        }
+      else
+        {
+          sample = &monitor->history[monitor->history_start];
+          monitor->history_start = ((monitor->history_start + 1) %
+                                    GIMP_MEMORY_MONITOR_HISTORY);
+        }
+
+      sample->time = g_get_monotonic_time ();
+      memcpy (sample->sizes, sizes, sizeof (sizes));
+
+      g_signal_emit (monitor, monitor_signals[CHANGED], 0);
+    }
+}
+
+void
+gimp_memory_monitor_get_usage (GimpMemoryMonitor *monitor,
+                               GimpImage         *image,
+                               gint64            *sizes)
+{
+  g_return_if_fail (GIMP_IS_MEMORY_MONITOR (monitor));
+  g_return_if_fail (image == NULL || GIMP_IS_IMAGE (image));
+  g_return_if_fail (sizes != NULL);
+
+  if (image)
+    {
+      GimpMemoryImage *record = g_hash_table_lookup (monitor->images, image);
+
+      if (record)
+        memcpy (sizes, record->sizes, sizeof (record->sizes));
+      else
+        memset (sizes, 0, sizeof (record->sizes));
+    }
+  else
+    {
+      memcpy (sizes, monitor->sizes, sizeof (monitor->sizes));
+    }
+}
+
+gint64
+gimp_memory_monitor_get_item_size (GimpMemoryMonitor *monitor,
+                                   GimpItem          *item)
+{
+  GimpMemoryImage *record;
+  GimpMemoryItem  *entry;
+
+  g_return_val_if_fail (GIMP_IS_MEMORY_MONITOR (monitor), 0);
+  g_return_val_if_fail (GIMP_IS_ITEM (item), 0);
+
+  record = g_hash_table_lookup (monitor->images, gimp_item_get_image (item));
+
+  if (! record)
+    return 0;
+
+  entry = g_hash_table_lookup (record->items, item);
+
+  return entry ? entry->size : 0;
+}
+
+const GimpMemorySample *
+gimp_memory_monitor_get_sample (GimpMemoryMonitor *monitor,
+                                gint               index)
+{
+  g_return_val_if_fail (GIMP_IS_MEMORY_MONITOR (monitor), NULL);
+  g_return_val_if_fail (index >= 0 && index < monitor->n_history, NULL);
+
+  return &monitor->history[(monitor->history_start + index) %
+                           GIMP_MEMORY_MONITOR_HISTORY];
+}
+
+gint
+gimp_memory_monitor_get_n_samples (GimpMemoryMonitor *monitor)
+{
+  g_return_val_if_fail (GIMP_IS_MEMORY_MONITOR (monitor), 0);
+
+  return monitor->n_history;
+}
+
+const gchar *
+gimp_memory_category_get_name (GimpMemoryCategory category)
+{
+  switch (category)
+    {
+    case GIMP_MEMORY_LAYERS:     return _("Layers");
+    case GIMP_MEMORY_CHANNELS:   return _("Channels");
+    case GIMP_MEMORY_VECTORS:    return _("Paths");
+    case GIMP_MEMORY_UNDO:       return _("Undo");
+    case GIMP_MEMORY_UNDO_SWAP:  return _("Undo Swap");
+    case GIMP_MEMORY_PROJECTION: return _("Projection");
+    case GIMP_MEMORY_TEMP_BUFS:  return _("Temporary Buffers");
+
+    default:
+      break;
+    }
+
+  return NULL;
+}
+
+
+/*  private functions  */
+
+static void
+gimp_memory_monitor_image_add (GimpContainer     *images,
+                               GimpImage         *image,
+                               GimpMemoryMonitor *monitor)
+{
+  GimpMemoryImage *record = g_slice_new0 (GimpMemoryImage);
+
+  record->monitor     = monitor;
+  record->image       = image;
+  record->items       = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                               NULL,
+                                               (GDestroyNotify) g_free);
+  record->items_dirty = TRUE;
+  record->undo_dirty  = TRUE;
+
+  record->layer_handler =
+    gimp_tree_handler_connect (gimp_image_get_layers (image),
+                               "invalidate-preview",
+                               G_CALLBACK (gimp_memory_monitor_item_changed),
+                               record);
+  record->channel_handler =
+    gimp_tree_handler_connect (gimp_image_get_channels (image),
+                               "invalidate-preview",
+                               G_CALLBACK (gimp_memory_monitor_item_changed),
+                               record);
+  record->vectors_handler =
+    gimp_tree_handler_connect (gimp_image_get_vectors (image),
+                               "invalidate-preview",
+                               G_CALLBACK (gimp_memory_monitor_item_changed),
+                               record);
+
+  g_signal_connect (gimp_image_get_layers (image), "add",
+                    G_CALLBACK (gimp_memory_monitor_items_changed),
+                    record);
+  g_signal_connect (gimp_image_get_layers (image), "remove",
+                    G_CALLBACK (gimp_memory_monitor_items_changed),
+                    record);
+  g_signal_connect (gimp_image_get_channels (image), "add",
+                    G_CALLBACK (gimp_memory_monitor_items_changed),
+                    record);
+  g_signal_connect (gimp_image_get_channels (image), "remove",
+                    G_CALLBACK (gimp_memory_monitor_items_changed),
+                    record);
+  g_signal_connect (gimp_image_get_vectors (image), "add",
+                    G_CALLBACK (gimp_memory_monitor_items_changed),
+                    record);
+  g_signal_connect (gimp_image_get_vectors (image), "remove",
+                    G_CALLBACK (gimp_memory_monitor_items_changed),
+                    record);
+
+  g_signal_connect (image, "undo-event",
+                    G_CALLBACK (gimp_memory_monitor_undo_event),
+                    record);
+
+  g_hash_table_insert (monitor->images, image, record);
+
+  gimp_memory_monitor_queue_update (monitor);
+}
+
+static void
+gimp_memory_monitor_image_foreach (GimpImage         *image,
+                                   GimpMemoryMonitor *monitor)
+{
+  gimp_memory_monitor_image_add (monitor->gimp->images, image, monitor);
+}
+
+static void
+gimp_memory_monitor_image_remove (GimpContainer     *images,
+                                  GimpImage         *image,
+                                  GimpMemoryMonitor *monitor)
+{
+  g_hash_table_remove (monitor->images, image);
+
+  gimp_memory_monitor_queue_update (monitor);
+}
+
+static void
+gimp_memory_monitor_image_free (GimpMemoryImage *record)
+{
+  /*  the image is being disposed and may already have dropped its
+   *  item containers, the tree handlers keep them alive until here
+   */
+  g_signal_handlers_disconnect_by_data (record->layer_handler->container,
+                                        record);
+  g_signal_handlers_disconnect_by_data (record->channel_handler->container,
+                                        record);
+  g_signal_handlers_disconnect_by_data (record->vectors_handler->container,
+                                        record);
+
+  gimp_tree_handler_disconnect (record->layer_handler);
+  gimp_tree_handler_disconnect (record->channel_handler);
+  gimp_tree_handler_disconnect (record->vectors_handler);
+
+  g_signal_handlers_disconnect_by_func (record->image,
+                                        gimp_memory_monitor_undo_event,
+                                        record);
+
+  g_hash_table_unref (record->items);
+
+  g_slice_free (GimpMemoryImage, record);
+}
+
+static void
+gimp_memory_monitor_item_changed (GimpItem        *item,
+                                  GimpMemoryImage *record)
+{
+  GimpViewable   *top = GIMP_VIEWABLE (item);
+  GimpMemoryItem *entry;
+
+  while (gimp_viewable_get_parent (top))
+    top = gimp_viewable_get_parent (top);
+
+  entry = g_hash_table_lookup (record->items, top);
+
+  if (entry)
+    entry->dirty = TRUE;
+  else
+    record->items_dirty = TRUE;
+
+  gimp_memory_monitor_queue_update (record->monitor);
+}
+
+static void
+gimp_memory_monitor_items_changed (GimpContainer   *container,
+                                   GimpObject      *object,
+                                   GimpMemoryImage *record)
+{
+  record->items_dirty = TRUE;
+
+  gimp_memory_monitor_queue_update (record->monitor);
+}
+
+static void
+gimp_memory_monitor_undo_event (GimpImage       *image,
+                                GimpUndoEvent    event,
+                                GimpUndo        *undo,
+                                GimpMemoryImage *record)
+{
+  /*  structural changes inside layer groups are only seen here  */
+  record->items_dirty = TRUE;
+  record->undo_dirty  = TRUE;
+
+  gimp_memory_monitor_queue_update (record->monitor);
+}
+
+static void
+gimp_memory_monitor_queue_update (GimpMemoryMonitor *monitor)
+{
+  if (! monitor->update_id)
+    monitor->update_id =
+      g_timeout_add_full (G_PRIORITY_LOW, UPDATE_INTERVAL,
+                          (GSourceFunc) gimp_memory_monitor_update_timeout,
+                          monitor, NULL);
+}
+
+static gboolean
+gimp_memory_monitor_update_timeout (GimpMemoryMonitor *monitor)
+{
+  monitor->update_id = 0;
+
+  gimp_memory_monitor_update (monitor);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+gimp_memory_monitor_update_items (GimpMemoryImage    *record,
+                                  GHashTable         *items,
+                                  GimpContainer      *container,
+                                  GimpMemoryCategory  category)
+{
+  GList *list;
+
+  for (list = GIMP_LIST (container)->list; list; list = g_list_next (list))
+    {
+      GimpMemoryItem *entry;
+
+      entry = g_hash_table_lookup (record->items, list->data);
+
+      if (entry)
+        {
+          g_hash_table_steal (record->items, list->data);
+        }
+      else
+        {
+          entry = g_new0 (GimpMemoryItem, 1);
+
+          entry->category = category;
+          entry->dirty    = TRUE;
+        }
+
+      g_hash_table_insert (items, list->data, entry);
+    }
+}
+
+static void
+gimp_memory_monitor_update_image (GimpMemoryImage *record)
+{
+  GimpImage      *image = record->image;
+  GHashTableIter  iter;
+  gpointer        key;
+  gpointer        value;
+  gint64          sizes[GIMP_MEMORY_N_CATEGORIES] = { 0, };
+
+  if (record->items_dirty)
+    {
+      GHashTable *items = g_hash_table_new_full (g_direct_hash,
+                                                 g_direct_equal,
+                                                 NULL,
+                                                 (GDestroyNotify) g_free);
+
+      /*  keep the sizes of unchanged items, drop the removed ones  */
+      gimp_memory_monitor_update_items (record, items,
+                                        gimp_image_get_layers (image),
+                                        GIMP_MEMORY_LAYERS);
+      gimp_memory_monitor_update_items (record, items,
+                                        gimp_image_get_channels (image),
+                                        GIMP_MEMORY_CHANNELS);
+      gimp_memory_monitor_update_items (record, items,
+                                        gimp_image_get_vectors (image),
+                                        GIMP_MEMORY_VECTORS);
+
+      g_hash_table_unref (record->items);
+      record->items = items;
+
+      record->items_dirty = FALSE;
+    }
+
+  g_hash_table_iter_init (&iter, record->items);
+
+  while (g_hash_table_iter_next (&iter, &key, &value))
+    {
+      GimpMemoryItem *entry = value;
+
+      if (entry->dirty)
+        {
+          entry->size  = gimp_object_get_memsize (key, NULL);
+          entry->dirty = FALSE;
+        }
+
+      sizes[entry->category] += entry->size;
+    }
+
+  sizes[GIMP_MEMORY_CHANNELS] +=
+    gimp_object_get_memsize (GIMP_OBJECT (gimp_image_get_mask (image)), NULL);
+
+  if (record->undo_dirty)
+    {
+      GimpUndo *undo_stack = GIMP_UNDO (gimp_image_get_undo_stack (image));
+      GimpUndo *redo_stack = GIMP_UNDO (gimp_image_get_redo_stack (image));
+
+      record->sizes[GIMP_MEMORY_UNDO] =
+        (gimp_object_get_memsize (GIMP_OBJECT (undo_stack), NULL) +
+         gimp_object_get_memsize (GIMP_OBJECT (redo_stack), NULL));
+
+      record->sizes[GIMP_MEMORY_UNDO_SWAP] =
+        (gimp_undo_get_spilled_size (undo_stack) +
+         gimp_undo_get_spilled_size (redo_stack));
+
+      record->undo_dirty = FALSE;
+    }
+
+  sizes[GIMP_MEMORY_UNDO]      = record->sizes[GIMP_MEMORY_UNDO];
+  sizes[GIMP_MEMORY_UNDO_SWAP] = record->sizes[GIMP_MEMORY_UNDO_SWAP];
+
+  /*  the projection allocates its tiles while it is rendered, without
+   *  any signal we could track, but its memsize is cheap to compute
+   */
+  sizes[GIMP_MEMORY_PROJECTION] =
+    gimp_object_get_memsize (GIMP_OBJECT (gimp_image_get_projection (image)),
+                             NULL);
+
+  memcpy (record->sizes, sizes, sizeof (sizes));
+}
@@ -0,0 +1,107 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimpmemorymonitor.h
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GIMP_MEMORY_MONITOR_H__
+#define __GIMP_MEMORY_MONITOR_H__
+
+
+#include "gimpobject.h"
+
+
+#define GIMP_MEMORY_MONITOR_HISTORY 120
+
+
+typedef enum
+{
+  GIMP_MEMORY_LAYERS,
+  GIMP_MEMORY_CHANNELS,
+  GIMP_MEMORY_VECTORS,
+  GIMP_MEMORY_UNDO,
+  GIMP_MEMORY_UNDO_SWAP,
+  GIMP_MEMORY_PROJECTION,
+  GIMP_MEMORY_TEMP_BUFS,
+
+  GIMP_MEMORY_N_CATEGORIES
+} GimpMemoryCategory;
+
+
+typedef struct _GimpMemorySample GimpMemorySample;
+
+struct _GimpMemorySample
+{
+  gint64 time;
+  gint64 sizes[GIMP_MEMORY_N_CATEGORIES];
+};
+
+
+#define GIMP_TYPE_MEMORY_MONITOR            (gimp_memory_monitor_get_type ())
+#define GIMP_MEMORY_MONITOR(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), GIMP_TYPE_MEMORY_MONITOR, GimpMemoryMonitor))
+#define GIMP_MEMORY_MONITOR_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass), GIMP_TYPE_MEMORY_MONITOR, GimpMemoryMonitorClass))
+#define GIMP_IS_MEMORY_MONITOR(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GIMP_TYPE_MEMORY_MONITOR))
+#define GIMP_IS_MEMORY_MONITOR_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass), GIMP_TYPE_MEMORY_MONITOR))
+#define GIMP_MEMORY_MONITOR_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj), GIMP_TYPE_MEMORY_MONITOR, GimpMemoryMonitorClass))
+
+
+typedef struct _GimpMemoryMonitorClass GimpMemoryMonitorClass;
+
+struct _GimpMemoryMonitor
+{
+  GimpObject        parent_instance;
+
+  Gimp             *gimp;
+
+  GHashTable       *images;
+  guint             update_id;
+
+  gint64            sizes[GIMP_MEMORY_N_CATEGORIES];
+
+  GimpMemorySample  history[GIMP_MEMORY_MONITOR_HISTORY];
+  gint              history_start;
+  gint              n_history;
+};
+
+struct _GimpMemoryMonitorClass
+{
+  GimpObjectClass  parent_class;
+
+  void (* changed) (GimpMemoryMonitor *monitor);
+};
+
+
+GType               gimp_memory_monitor_get_type      (void) G_GNUC_CONST;
+
+GimpMemoryMonitor * gimp_memory_monitor_new           (Gimp               *gimp);
+
+void                gimp_memory_monitor_update        (GimpMemoryMonitor  *monitor);
+
+void                gimp_memory_monitor_get_usage     (GimpMemoryMonitor  *monitor,
+                                                       GimpImage          *image,
+                                                       gint64             *sizes);
+gint64              gimp_memory_monitor_get_item_size (GimpMemoryMonitor  *monitor,
+                                                       GimpItem           *item);
+
+const GimpMemorySample *
+                    gimp_memory_monitor_get_sample    (GimpMemoryMonitor  *monitor,
+                                                       gint                index);
+gint                gimp_memory_monitor_get_n_samples (GimpMemoryMonitor  *monitor);
+
+const gchar       * gimp_memory_category_get_name     (GimpMemoryCategory  category);
+
+
+#endif  /*  __GIMP_MEMORY_MONITOR_H__  */
@@ -26,6 +26,7 @@
 
 #include "core-types.h"
 
+#include "gimp-parallel.h"
 #include "gimpchannel.h"
 #include "gimpcontainer.h"
 #include "gimpcontext.h"
@@ -42,6 +43,9 @@
 
 #define MAX_IMAGE_COLORS (10000 * 2)
 
+/*  the smallest number of rows worth handing to a thread of its own  */
+#define MIN_PARALLEL_SUB_SIZE 64
+
 
 /*  create a palette from a gradient  ****************************************/
 
@@ -93,7 +97,18 @@ struct _ImgColors
   guchar b;
 };
 
-static gint count_color_entries = 0;
+typedef struct
+{
+  GeglBuffer    *buffer;
+  GeglBuffer    *mask_buffer;
+  gint           mask_off_x;
+  gint           mask_off_y;
+  GeglRectangle  rect;
+  gint           n_colors;
+  gint           threshold;
+  GHashTable    *tables[GIMP_PARALLEL_MAX_THREADS];
+} ExtractData;
+
 
 static GHashTable *
 gimp_palette_import_store_colors (GHashTable *table,
@@ -108,7 +123,6 @@ gimp_palette_import_store_colors (GHashTable *table,
   if (table == NULL)
     {
       table = g_hash_table_new (g_direct_hash, g_direct_equal);
-      count_color_entries = 0;
     }
   else
     {
@@ -117,14 +131,12 @@ gimp_palette_import_store_colors (GHashTable *table,
 
   if (found_color == NULL)
     {
-      if (count_color_entries > MAX_IMAGE_COLORS)
+      if (g_hash_table_size (table) > MAX_IMAGE_COLORS)
         {
           /* Don't add any more new ones */
           return table;
         }
 
-      count_color_entries++;
-
       new_color = g_slice_new (ImgColors);
 
       new_color->count = 1;
@@ -163,6 +175,64 @@ gimp_palette_import_store_colors (GHashTable *table,
   return table;
 }
 
+/*  adds the colors counted in @other to @table and destroys @other  */
+static GHashTable *
+gimp_palette_import_merge_colors (GHashTable *table,
+                                  GHashTable *other)
+{
+  GHashTableIter  iter;
+  gpointer        key;
+  gpointer        value;
+
+  if (! table)
+    return other;
+
+  if (! other)
+    return table;
+
+  g_hash_table_iter_init (&iter, other);
+
+  while (g_hash_table_iter_next (&iter, &key, &value))
+    {
+      ImgColors *color = value;
+      ImgColors *found = g_hash_table_lookup (table, key);
+
+      if (! found)
+        {
+          if (g_hash_table_size (table) > MAX_IMAGE_COLORS)
+            {
+              g_slice_free (ImgColors, color);
+              continue;
+            }
+
+          g_hash_table_insert (table, key, color);
+          continue;
+        }
+
+      found->count  = MIN ((guint64) found->count + color->count,
+                           G_MAXINT - 1);
+      found->r_adj += color->r_adj;
+      found->g_adj += color->g_adj;
+      found->b_adj += color->b_adj;
+
+      /* Boundary conditions */
+      if (found->r_adj > (G_MAXINT - 255))
+        found->r_adj /= found->count;
+
+      if (found->g_adj > (G_MAXINT - 255))
+        found->g_adj /= found->count;
+
+      if (found->b_adj > (G_MAXINT - 255))
+        found->b_adj /= found->count;
+
+      g_slice_free (ImgColors, color);
+    }
+
+  g_hash_table_destroy (other);
+
+  return table;
+}
+
 static void
 gimp_palette_import_create_list (gpointer key,
                                  gpointer value,
@@ -259,88 +329,123 @@ gimp_palette_import_make_palette (GHashTable  *table,
   return palette;
 }
 
-static GHashTable *
-gimp_palette_import_extract (GimpImage     *image,
-                             GimpPickable  *pickable,
-                             gint           pickable_off_x,
-                             gint           pickable_off_y,
-                             gboolean       selection_only,
-                             gint           x,
-                             gint           y,
-                             gint           width,
-                             gint           height,
-                             gint           n_colors,
-                             gint           threshold)
+/*  counts the colors of one horizontal band of the area into a hash
+ *  table of its own, so the bands can be counted in parallel
+ */
+static void
+gimp_palette_import_extract_band (gint         i,
+                                  gint         n,
+                                  ExtractData *data)
 {
-  GeglBuffer         *buffer;
   GeglBufferIterator *iter;
-  GeglRectangle      *mask_roi = NULL;
-  GeglRectangle       rect     = { x, y, width, height };
+  GeglRectangle       rect;
   GHashTable         *colors   = NULL;
   const Babl         *format;
   gint                bpp;
   gint                mask_bpp = 0;
 
-  buffer = gimp_pickable_get_buffer (pickable);
+  rect        = data->rect;
+  rect.y      = data->rect.y + data->rect.height * i / n;
+  rect.height = data->rect.y + data->rect.height * (i + 1) / n - rect.y;
+
   format = babl_format ("R'G'B'A u8");
 
-  iter = gegl_buffer_iterator_new (buffer, &rect, 0, format,
+  iter = gegl_buffer_iterator_new (data->buffer, &rect, 0, format,
                                    GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
   bpp = babl_format_get_bytes_per_pixel (format);
 
-  if (selection_only &&
-      ! gimp_channel_is_empty (gimp_image_get_mask (image)))
+  if (data->mask_buffer)
     {
-      GimpDrawable *mask = GIMP_DRAWABLE (gimp_image_get_mask (image));
+      rect.x += data->mask_off_x;
+      rect.y += data->mask_off_y;
 
-      rect.x = x + pickable_off_x;
-      rect.y = y + pickable_off_y;
-
-      buffer = gimp_drawable_get_buffer (mask);
       format = babl_format ("Y u8");
 
-      gegl_buffer_iterator_add (iter, buffer, &rect, 0, format,
+      gegl_buffer_iterator_add (iter, data->mask_buffer, &rect, 0, format,
                                 GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
-      mask_roi = &iter->roi[1];
       mask_bpp = babl_format_get_bytes_per_pixel (format);
     }
 
   while (gegl_buffer_iterator_next (iter))
     {
-      const guchar *data      = iter->data[0];
-      const guchar *mask_data = NULL;
-      gint          length    = iter->length;
+      const guchar *src      = iter->data[0];
+      const guchar *mask_src = NULL;
+      gint          length   = iter->length;
 
-      if (mask_roi)
-        mask_data = iter->data[1];
+      if (data->mask_buffer)
+        mask_src = iter->data[1];
 
       while (length--)
         {
           /*  ignore unselected, and completely transparent pixels  */
-          if ((! mask_data || *mask_data) && data[ALPHA])
+          if ((! mask_src || *mask_src) && src[ALPHA])
             {
               guchar rgba[MAX_CHANNELS]     = { 0, };
               guchar rgb_real[MAX_CHANNELS] = { 0, };
 
-              memcpy (rgba, data, 4);
+              memcpy (rgba, src, 4);
               memcpy (rgb_real, rgba, 4);
 
-              rgba[0] = (rgba[0] / threshold) * threshold;
-              rgba[1] = (rgba[1] / threshold) * threshold;
-              rgba[2] = (rgba[2] / threshold) * threshold;
+              rgba[0] = (rgba[0] / data->threshold) * data->threshold;
+              rgba[1] = (rgba[1] / data->threshold) * data->threshold;
+              rgba[2] = (rgba[2] / data->threshold) * data->threshold;
 
               colors = gimp_palette_import_store_colors (colors,
                                                          rgba, rgb_real,
-                                                         n_colors);
+                                                         data->n_colors);
             }
 
-          data += bpp;
+          src += bpp;
 
-          if (mask_data)
-            mask_data += mask_bpp;
+          if (mask_src)
+            mask_src += mask_bpp;
         }
     }
 
+  data->tables[i] = colors;
+}
+
+static GHashTable *
+gimp_palette_import_extract (GimpImage     *image,
+                             GimpPickable  *pickable,
+                             gint           pickable_off_x,
+                             gint           pickable_off_y,
+                             gboolean       selection_only,
+                             gint           x,
+                             gint           y,
+                             gint           width,
+                             gint           height,
+                             gint           n_colors,
+                             gint           threshold)
+{
+  ExtractData  data   = { 0, };
+  GHashTable  *colors = NULL;
+  gint         i;
+
+  data.buffer     = gimp_pickable_get_buffer (pickable);
+  data.mask_off_x = pickable_off_x;
+  data.mask_off_y = pickable_off_y;
+  data.n_colors   = n_colors;
+  data.threshold  = threshold;
+
+  if (selection_only &&
+      ! gimp_channel_is_empty (gimp_image_get_mask (image)))
+    {
+      GimpDrawable *mask = GIMP_DRAWABLE (gimp_image_get_mask (image));
+
+      data.mask_buffer = gimp_drawable_get_buffer (mask);
+    }
+
+  gegl_rectangle_set (&data.rect, x, y, width, height);
+
+  gimp_parallel_distribute (MAX (height / MIN_PARALLEL_SUB_SIZE, 1),
+                            (GimpParallelDistributeFunc)
+                            gimp_palette_import_extract_band,
+                            &data);
+
+  for (i = 0; i < G_N_ELEMENTS (data.tables); i++)
+    colors = gimp_palette_import_merge_colors (colors, data.tables[i]);
+
   return colors;
 }
 
@@ -26,6 +26,8 @@
 
 #include "core-types.h"
 
+#include "gegl/gimptilehandlerpattern.h"
+
 #include "gimppattern.h"
 #include "gimppattern-load.h"
 #include "gimptagged.h"
@@ -279,3 +281,41 @@ gimp_pattern_create_buffer (const GimpPattern *pattern)
 
   return gimp_temp_buf_create_buffer (pattern->mask);
 }
+
+/*  Returns a buffer of @format covering @rect which reads as @pattern
+ *  repeated from @offset_x, @offset_y on.  Its tiles are filled from
+ *  the pattern when they are first read, instead of copying the
+ *  pattern into the whole area up front.
+ */
+GeglBuffer *
+gimp_pattern_create_tiled_buffer (const GimpPattern   *pattern,
+                                  const GeglRectangle *rect,
+                                  const Babl          *format,
+                                  gint                 offset_x,
+                                  gint                 offset_y)
+{
+  GeglBuffer      *buffer;
+  GeglBuffer      *pattern_buffer;
+  GeglTileHandler *handler;
+
+  g_return_val_if_fail (GIMP_IS_PATTERN (pattern), NULL);
+  g_return_val_if_fail (rect != NULL, NULL);
+  g_return_val_if_fail (format != NULL, NULL);
+
+  buffer = gegl_buffer_new (rect, format);
+
+  pattern_buffer = gimp_pattern_create_buffer (pattern);
+  handler = gimp_tile_handler_pattern_new (pattern_buffer, offset_x, offset_y);
+  g_object_unref (pattern_buffer);
+
+  gimp_tile_handler_validate_assign (GIMP_TILE_HANDLER_VALIDATE (handler),
+                                     buffer);
+  gimp_tile_handler_validate_invalidate (GIMP_TILE_HANDLER_VALIDATE (handler),
+                                         rect->x, rect->y,
+                                         rect->width, rect->height);
+
+  /*  the buffer keeps the handler alive  */
+  g_object_unref (handler);
+
+  return buffer;
+}
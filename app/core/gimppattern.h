@@ -45,14 +45,19 @@ struct _GimpPatternClass
 };
 
 
-GType         gimp_pattern_get_type      (void) G_GNUC_CONST;
-
-GimpData    * gimp_pattern_new           (GimpContext       *context,
-                                          const gchar       *name);
-GimpData    * gimp_pattern_get_standard  (GimpContext       *context);
-
-GimpTempBuf * gimp_pattern_get_mask      (const GimpPattern *pattern);
-GeglBuffer  * gimp_pattern_create_buffer (const GimpPattern *pattern);
+GType         gimp_pattern_get_type            (void) G_GNUC_CONST;
+
+GimpData    * gimp_pattern_new                 (GimpContext         *context,
+                                                const gchar         *name);
+GimpData    * gimp_pattern_get_standard        (GimpContext         *context);
+
+GimpTempBuf * gimp_pattern_get_mask            (const GimpPattern   *pattern);
+GeglBuffer  * gimp_pattern_create_buffer       (const GimpPattern   *pattern);
+GeglBuffer  * gimp_pattern_create_tiled_buffer (const GimpPattern   *pattern,
+                                                const GeglRectangle *rect,
+                                                const Babl          *format,
+                                                gint                 offset_x,
+                                                gint                 offset_y);
 
 
 #endif /* __GIMP_PATTERN_H__ */
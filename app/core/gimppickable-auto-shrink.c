@@ -38,10 +38,39 @@ typedef enum
 } AutoShrinkType;
 
 
+typedef enum
+{
+  AUTO_SHRINK_TILE_UNKNOWN = 0,
+  AUTO_SHRINK_TILE_UNIFORM = 1,
+  AUTO_SHRINK_TILE_MIXED   = 2
+} AutoShrinkTileState;
+
+
 typedef gboolean (* ColorsEqualFunc) (guchar *col1,
                                       guchar *col2);
 
 
+/*  the uniformity of each buffer tile intersecting the area, computed
+ *  on demand and shared by the scans of all four edges, so whole tiles
+ *  of background can be skipped instead of being read row by row
+ */
+typedef struct
+{
+  GeglBuffer      *buffer;
+  const Babl      *format;
+  ColorsEqualFunc  colors_equal_func;
+  const guchar    *bgcolor;
+  GeglRectangle    area;
+  gint             grid_x;
+  gint             grid_y;
+  gint             tile_width;
+  gint             tile_height;
+  gint             n_cols;
+  guint8          *states;
+  guchar          *buf;
+} AutoShrinkTiles;
+
+
 /*  local function prototypes  */
 
 static AutoShrinkType   gimp_pickable_guess_bgcolor (GimpPickable *pickable,
@@ -55,6 +84,29 @@ static gboolean         gimp_pickable_colors_equal  (guchar       *col1,
 static gboolean         gimp_pickable_colors_alpha  (guchar       *col1,
                                                      guchar       *col2);
 
+static void      auto_shrink_tiles_init        (AutoShrinkTiles     *tiles,
+                                                GeglBuffer          *buffer,
+                                                const Babl          *format,
+                                                ColorsEqualFunc      colors_equal_func,
+                                                const guchar        *bgcolor,
+                                                const GeglRectangle *area);
+static void      auto_shrink_tiles_free        (AutoShrinkTiles     *tiles);
+static gboolean  auto_shrink_tiles_row_uniform (AutoShrinkTiles     *tiles,
+                                                gint                 y,
+                                                gint                 x1,
+                                                gint                 x2,
+                                                gint                *row_y1,
+                                                gint                *row_y2);
+static gboolean  auto_shrink_tiles_col_uniform (AutoShrinkTiles     *tiles,
+                                                gint                 x,
+                                                gint                 y1,
+                                                gint                 y2,
+                                                gint                *col_x1,
+                                                gint                *col_x2);
+static gboolean  auto_shrink_tile_uniform      (AutoShrinkTiles     *tiles,
+                                                gint                 col,
+                                                gint                 row);
+
 
 /*  public functions  */
 
@@ -71,6 +123,7 @@ gimp_pickable_auto_shrink (GimpPickable *pickable,
 {
   GeglBuffer      *buffer;
   GeglRectangle    rect;
+  AutoShrinkTiles  tiles = { 0, };
   ColorsEqualFunc  colors_equal_func;
   guchar           bgcolor[MAX_CHANNELS] = { 0, 0, 0, 0 };
   guchar          *buf = NULL;
@@ -122,6 +175,9 @@ gimp_pickable_auto_shrink (GimpPickable *pickable,
   width  = x2 - x1;
   height = y2 - y1;
 
+  auto_shrink_tiles_init (&tiles, buffer, format, colors_equal_func, bgcolor,
+                          GEGL_RECTANGLE (x1, y1, width, height));
+
   /* The following could be optimized further by processing
    * the smaller side first instead of defaulting to width    --Sven
    */
@@ -134,8 +190,20 @@ gimp_pickable_auto_shrink (GimpPickable *pickable,
   rect.width  = width;
   rect.height = 1;
 
+  y = y1;
+  while (y < y2)
+    {
+      gint row_y1, row_y2;
+
+      if (! auto_shrink_tiles_row_uniform (&tiles, y, x1, x2,
+                                           &row_y1, &row_y2))
+        break;
+
+      y = MIN (row_y2, y2);
+    }
+
   abort = FALSE;
-  for (y = y1; y < y2 && !abort; y++)
+  for (; y < y2 && !abort; y++)
     {
       rect.y = y;
       gegl_buffer_get (buffer, &rect, 1.0, format, buf,
@@ -156,8 +224,20 @@ gimp_pickable_auto_shrink (GimpPickable *pickable,
   rect.width  = width;
   rect.height = 1;
 
+  y = y2;
+  while (y > y1)
+    {
+      gint row_y1, row_y2;
+
+      if (! auto_shrink_tiles_row_uniform (&tiles, y - 1, x1, x2,
+                                           &row_y1, &row_y2))
+        break;
+
+      y = MAX (row_y1, y1);
+    }
+
   abort = FALSE;
-  for (y = y2; y > y1 && !abort; y--)
+  for (; y > y1 && !abort; y--)
     {
       rect.y = y - 1;
       gegl_buffer_get (buffer, &rect, 1.0, format, buf,
@@ -176,8 +256,20 @@ gimp_pickable_auto_shrink (GimpPickable *pickable,
   rect.width  = 1;
   rect.height = height;
 
+  x = x1;
+  while (x < x2)
+    {
+      gint col_x1, col_x2;
+
+      if (! auto_shrink_tiles_col_uniform (&tiles, x, y1, y2,
+                                           &col_x1, &col_x2))
+        break;
+
+      x = MIN (col_x2, x2);
+    }
+
   abort = FALSE;
-  for (x = x1; x < x2 && !abort; x++)
+  for (; x < x2 && !abort; x++)
     {
       rect.x = x;
       gegl_buffer_get (buffer, &rect, 1.0, format, buf,
@@ -193,8 +285,20 @@ gimp_pickable_auto_shrink (GimpPickable *pickable,
   rect.width  = 1;
   rect.height = height;
 
+  x = x2;
+  while (x > x1)
+    {
+      gint col_x1, col_x2;
+
+      if (! auto_shrink_tiles_col_uniform (&tiles, x - 1, y1, y2,
+                                           &col_x1, &col_x2))
+        break;
+
+      x = MAX (col_x1, x1);
+    }
+
   abort = FALSE;
-  for (x = x2; x > x1 && !abort; x--)
+  for (; x > x1 && !abort; x--)
     {
       rect.x = x - 1;
       gegl_buffer_get (buffer, &rect, 1.0, format, buf,
@@ -217,6 +321,7 @@ gimp_pickable_auto_shrink (GimpPickable *pickable,
 
  FINISH:
 
+  auto_shrink_tiles_free (&tiles);
   g_free (buf);
   gimp_unset_busy (gimp_pickable_get_image (pickable)->gimp);
 
@@ -302,3 +407,146 @@ gimp_pickable_colors_alpha (guchar *dummy,
 {
   return (col[ALPHA] == 0);
 }
+
+static void
+auto_shrink_tiles_init (AutoShrinkTiles     *tiles,
+                        GeglBuffer          *buffer,
+                        const Babl          *format,
+                        ColorsEqualFunc      colors_equal_func,
+                        const guchar        *bgcolor,
+                        const GeglRectangle *area)
+{
+  gint shift_x;
+  gint shift_y;
+  gint n_rows;
+
+  g_object_get (buffer,
+                "shift-x",     &shift_x,
+                "shift-y",     &shift_y,
+                "tile-width",  &tiles->tile_width,
+                "tile-height", &tiles->tile_height,
+                NULL);
+
+  tiles->buffer            = buffer;
+  tiles->format            = format;
+  tiles->colors_equal_func = colors_equal_func;
+  tiles->bgcolor           = bgcolor;
+  tiles->area              = *area;
+
+  /*  the origin of the first tile touching the area  */
+  tiles->grid_x = area->x - ((area->x + shift_x) % tiles->tile_width +
+                             tiles->tile_width) % tiles->tile_width;
+  tiles->grid_y = area->y - ((area->y + shift_y) % tiles->tile_height +
+                             tiles->tile_height) % tiles->tile_height;
+
+  tiles->n_cols = (area->x + area->width - tiles->grid_x +
+                   tiles->tile_width - 1) / tiles->tile_width;
+  n_rows        = (area->y + area->height - tiles->grid_y +
+                   tiles->tile_height - 1) / tiles->tile_height;
+
+  tiles->states = g_new0 (guint8, tiles->n_cols * n_rows);
+  tiles->buf    = g_malloc (tiles->tile_width * tiles->tile_height * 4);
+}
+
+static void
+auto_shrink_tiles_free (AutoShrinkTiles *tiles)
+{
+  g_free (tiles->states);
+  g_free (tiles->buf);
+}
+
+/*  returns whether the pixels of the tile row containing @y are all
+ *  background between @x1 and @x2, and the row's extent in @row_y1 and
+ *  @row_y2
+ */
+static gboolean
+auto_shrink_tiles_row_uniform (AutoShrinkTiles *tiles,
+                               gint             y,
+                               gint             x1,
+                               gint             x2,
+                               gint            *row_y1,
+                               gint            *row_y2)
+{
+  gint row = (y - tiles->grid_y) / tiles->tile_height;
+  gint col;
+
+  *row_y1 = tiles->grid_y + row * tiles->tile_height;
+  *row_y2 = *row_y1 + tiles->tile_height;
+
+  for (col = (x1 - tiles->grid_x) / tiles->tile_width;
+       tiles->grid_x + col * tiles->tile_width < x2;
+       col++)
+    {
+      if (! auto_shrink_tile_uniform (tiles, col, row))
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+static gboolean
+auto_shrink_tiles_col_uniform (AutoShrinkTiles *tiles,
+                               gint             x,
+                               gint             y1,
+                               gint             y2,
+                               gint            *col_x1,
+                               gint            *col_x2)
+{
+  gint col = (x - tiles->grid_x) / tiles->tile_width;
+  gint row;
+
+  *col_x1 = tiles->grid_x + col * tiles->tile_width;
+  *col_x2 = *col_x1 + tiles->tile_width;
+
+  for (row = (y1 - tiles->grid_y) / tiles->tile_height;
+       tiles->grid_y + row * tiles->tile_height < y2;
+       row++)
+    {
+      if (! auto_shrink_tile_uniform (tiles, col, row))
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+static gboolean
+auto_shrink_tile_uniform (AutoShrinkTiles *tiles,
+                          gint             col,
+                          gint             row)
+{
+  guint8        *state = &tiles->states[row * tiles->n_cols + col];
+  GeglRectangle  rect;
+  gint           n_pixels;
+  gint           i;
+
+  if (*state != AUTO_SHRINK_TILE_UNKNOWN)
+    return *state == AUTO_SHRINK_TILE_UNIFORM;
+
+  gegl_rectangle_intersect (&rect,
+                            GEGL_RECTANGLE (tiles->grid_x +
+                                            col * tiles->tile_width,
+                                            tiles->grid_y +
+                                            row * tiles->tile_height,
+                                            tiles->tile_width,
+                                            tiles->tile_height),
+                            &tiles->area);
+
+  gegl_buffer_get (tiles->buffer, &rect, 1.0, tiles->format, tiles->buf,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  *state = AUTO_SHRINK_TILE_UNIFORM;
+
+  n_pixels = rect.width * rect.height;
+
+  for (i = 0; i < n_pixels; i++)
+    {
+      if (! tiles->colors_equal_func ((guchar *) tiles->bgcolor,
+                                      tiles->buf + i * 4))
+        {
+          *state = AUTO_SHRINK_TILE_MIXED;
+          break;
+        }
+    }
+
+  return *state == AUTO_SHRINK_TILE_UNIFORM;
+}
@@ -30,53 +30,99 @@
 
 #include "gegl/gimp-babl.h"
 
+#include "gimp-parallel.h"
 #include "gimp-utils.h" /* GIMP_TIMER */
 #include "gimppickable.h"
 #include "gimppickable-contiguous-region.h"
 
 
+/*  the number of pixels fetched and compared at once while scanning
+ *  for a segment
+ */
+#define CHUNK_SIZE 64
+
+/*  the smallest area worth handing to a thread of its own  */
+#define MIN_PARALLEL_SUB_SIZE 64
+#define MIN_PARALLEL_SUB_AREA (MIN_PARALLEL_SUB_SIZE * MIN_PARALLEL_SUB_SIZE)
+
+
+typedef struct
+{
+  GeglBuffer          *src_buffer;
+  GeglBuffer          *mask_buffer;
+  const Babl          *format;
+  gint                 n_components;
+  gboolean             has_alpha;
+  gint                 width;
+  gint                 height;
+  gboolean             select_transparent;
+  GimpSelectCriterion  select_criterion;
+  gboolean             antialias;
+  gfloat               threshold;
+  const gfloat        *col;
+} ContiguousRegion;
+
+/*  the pixels and differences of the part [x1, x2) of row y which
+ *  has been scanned so far
+ */
+typedef struct
+{
+  const ContiguousRegion *region;
+  gint                    y;
+  gint                    x1;
+  gint                    x2;
+  gfloat                 *src;
+  gfloat                 *diff;
+} ContiguousRow;
+
+
 /*  local function prototypes  */
 
-static const Babl * choose_format         (GeglBuffer          *buffer,
-                                           GimpSelectCriterion  select_criterion,
-                                           gint                *n_components,
-                                           gboolean            *has_alpha);
-static gfloat   pixel_difference          (const gfloat        *col1,
-                                           const gfloat        *col2,
-                                           gboolean             antialias,
-                                           gfloat               threshold,
-                                           gint                 n_components,
-                                           gboolean             has_alpha,
-                                           gboolean             select_transparent,
-                                           GimpSelectCriterion  select_criterion);
-static gboolean find_contiguous_segment   (const gfloat        *col,
-                                           GeglBuffer          *src_buffer,
-                                           GeglBuffer          *mask_buffer,
-                                           const Babl          *src_format,
-                                           gint                 n_components,
-                                           gboolean             has_alpha,
-                                           gint                 width,
-                                           gboolean             select_transparent,
-                                           GimpSelectCriterion  select_criterion,
-                                           gboolean             antialias,
-                                           gfloat               threshold,
-                                           gint                 initial_x,
-                                           gint                 initial_y,
-                                           gint                *start,
-                                           gint                *end,
-                                           gfloat              *row);
-static void     find_contiguous_region    (GeglBuffer          *src_buffer,
-                                           GeglBuffer          *mask_buffer,
-                                           const Babl          *format,
-                                           gint                 n_components,
-                                           gboolean             has_alpha,
-                                           gboolean             select_transparent,
-                                           GimpSelectCriterion  select_criterion,
-                                           gboolean             antialias,
-                                           gfloat               threshold,
-                                           gint                 x,
-                                           gint                 y,
-                                           const gfloat        *col);
+static const Babl * choose_format         (GeglBuffer             *buffer,
+                                           GimpSelectCriterion     select_criterion,
+                                           gint                   *n_components,
+                                           gboolean               *has_alpha);
+static gfloat   pixel_difference          (const gfloat           *col1,
+                                           const gfloat           *col2,
+                                           gboolean                antialias,
+                                           gfloat                  threshold,
+                                           gint                    n_components,
+                                           gboolean                has_alpha,
+                                           gboolean                select_transparent,
+                                           GimpSelectCriterion     select_criterion);
+static gfloat   pixel_distance            (const gfloat           *col1,
+                                           const gfloat           *col2,
+                                           gint                    n_components,
+                                           gboolean                has_alpha,
+                                           gboolean                select_transparent,
+                                           GimpSelectCriterion     select_criterion);
+static inline gfloat
+                distance_to_mask          (gfloat                  max,
+                                           gboolean                antialias,
+                                           gfloat                  threshold);
+static void     by_color_init             (ContiguousRegion       *region,
+                                           GimpPickable           *pickable,
+                                           gboolean                select_transparent,
+                                           GimpSelectCriterion     select_criterion,
+                                           const GimpRGB          *color,
+                                           gfloat                 *start_col);
+static void     by_color_area             (const GeglRectangle    *area,
+                                           const ContiguousRegion *region);
+static void     distance_by_color_area    (const GeglRectangle    *area,
+                                           const ContiguousRegion *region);
+static void     by_distance_area          (const GeglRectangle    *area,
+                                           const ContiguousRegion *region);
+static void     contiguous_row_fetch      (ContiguousRow          *row,
+                                           gint                    x);
+static gboolean find_contiguous_segment   (const ContiguousRegion *region,
+                                           ContiguousRow          *row,
+                                           gint                    initial_x,
+                                           gint                    initial_y,
+                                           gint                   *start,
+                                           gint                   *end);
+static void     find_contiguous_region    (const ContiguousRegion *region,
+                                           gint                    x,
+                                           gint                    y);
 
 
 /*  public functions  */
@@ -133,13 +179,24 @@ gimp_pickable_contiguous_region_by_seed (GimpPickable        *pickable,
   if (x >= extent.x && x < (extent.x + extent.width) &&
       y >= extent.y && y < (extent.y + extent.height))
     {
+      ContiguousRegion region;
+
+      region.src_buffer         = src_buffer;
+      region.mask_buffer        = mask_buffer;
+      region.format             = format;
+      region.n_components       = n_components;
+      region.has_alpha          = has_alpha;
+      region.width              = extent.width;
+      region.height             = extent.height;
+      region.select_transparent = select_transparent;
+      region.select_criterion   = select_criterion;
+      region.antialias          = antialias;
+      region.threshold          = threshold;
+      region.col                = start_col;
+
       GIMP_TIMER_START();
 
-      find_contiguous_region (src_buffer, mask_buffer,
-                              format, n_components, has_alpha,
-                              select_transparent, select_criterion,
-                              antialias, threshold,
-                              x, y, start_col);
+      find_contiguous_region (&region, x, y);
 
       GIMP_TIMER_END("foo");
     }
@@ -161,75 +218,99 @@ gimp_pickable_contiguous_region_by_color (GimpPickable        *pickable,
    *  fuzzy_select.  Modify the pickable's mask to reflect the
    *  additional selection
    */
-  GeglBufferIterator *iter;
-  GeglBuffer         *src_buffer;
-  GeglBuffer         *mask_buffer;
-  const Babl         *format;
-  gint                n_components;
-  gboolean            has_alpha;
-  gfloat              start_col[MAX_CHANNELS];
+  ContiguousRegion region;
+  gfloat           start_col[MAX_CHANNELS];
 
   g_return_val_if_fail (GIMP_IS_PICKABLE (pickable), NULL);
   g_return_val_if_fail (color != NULL, NULL);
 
-  gimp_pickable_flush (pickable);
+  by_color_init (&region, pickable, select_transparent, select_criterion,
+                 color, start_col);
 
-  src_buffer = gimp_pickable_get_buffer (pickable);
+  region.antialias = antialias;
+  region.threshold = threshold;
 
-  format = choose_format (src_buffer, select_criterion,
-                          &n_components, &has_alpha);
+  gimp_parallel_distribute_area (gegl_buffer_get_extent (region.src_buffer),
+                                 MIN_PARALLEL_SUB_AREA,
+                                 (GimpParallelDistributeAreaFunc)
+                                 by_color_area,
+                                 &region);
 
-  gimp_rgba_get_pixel (color, format, start_col);
+  return region.mask_buffer;
+}
 
-  if (has_alpha)
-    {
-      if (select_transparent)
-        {
-          /*  don't select transparancy if "color" isn't fully transparent
-           */
-          if (start_col[n_components - 1] > 0.0)
-            select_transparent = FALSE;
-        }
-    }
-  else
-    {
-      select_transparent = FALSE;
-    }
+/**
+ * gimp_pickable_contiguous_region_distance_by_color:
+ * @pickable:           a #GimpPickable
+ * @select_transparent: whether transparent pixels match a transparent @color
+ * @select_criterion:   which components of the pixels are compared
+ * @color:              the color to compare with
+ *
+ * Computes the distance of each pixel of @pickable to @color, as used
+ * by gimp_pickable_contiguous_region_by_color().  Pixels which are
+ * never selected get a distance of G_MAXFLOAT.
+ *
+ * Use gimp_pickable_contiguous_region_by_distance() to turn the
+ * result into a mask, which is a lot cheaper than recomparing the
+ * colors when only the threshold changes.
+ *
+ * Return value: a "Y float" #GeglBuffer of distances.
+ **/
+GeglBuffer *
+gimp_pickable_contiguous_region_distance_by_color (GimpPickable        *pickable,
+                                                   gboolean             select_transparent,
+                                                   GimpSelectCriterion  select_criterion,
+                                                   const GimpRGB       *color)
+{
+  ContiguousRegion region;
+  gfloat           start_col[MAX_CHANNELS];
 
-  mask_buffer = gegl_buffer_new (gegl_buffer_get_extent (src_buffer),
-                                 babl_format ("Y float"));
+  g_return_val_if_fail (GIMP_IS_PICKABLE (pickable), NULL);
+  g_return_val_if_fail (color != NULL, NULL);
 
-  iter = gegl_buffer_iterator_new (src_buffer,
-                                   NULL, 0, format,
-                                   GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
+  by_color_init (&region, pickable, select_transparent, select_criterion,
+                 color, start_col);
 
-  gegl_buffer_iterator_add (iter, mask_buffer,
-                            NULL, 0, babl_format ("Y float"),
-                            GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
+  gimp_parallel_distribute_area (gegl_buffer_get_extent (region.src_buffer),
+                                 MIN_PARALLEL_SUB_AREA,
+                                 (GimpParallelDistributeAreaFunc)
+                                 distance_by_color_area,
+                                 &region);
 
-  while (gegl_buffer_iterator_next (iter))
-    {
-      const gfloat *src   = iter->data[0];
-      gfloat       *dest  = iter->data[1];
-      gint          count = iter->length;
+  return region.mask_buffer;
+}
 
-      while (count--)
-        {
-          /*  Find how closely the colors match  */
-          *dest = pixel_difference (start_col, src,
-                                    antialias,
-                                    threshold,
-                                    n_components,
-                                    has_alpha,
-                                    select_transparent,
-                                    select_criterion);
-
-          src  += n_components;
-          dest += 1;
-        }
-    }
+/**
+ * gimp_pickable_contiguous_region_by_distance:
+ * @distance_buffer: distances as returned by
+ *                   gimp_pickable_contiguous_region_distance_by_color()
+ * @antialias:       whether to antialias the mask's edges
+ * @threshold:       the largest distance which is selected
+ *
+ * Return value: the mask of the pixels within @threshold.
+ **/
+GeglBuffer *
+gimp_pickable_contiguous_region_by_distance (GeglBuffer *distance_buffer,
+                                             gboolean    antialias,
+                                             gfloat      threshold)
+{
+  ContiguousRegion region = { 0, };
 
-  return mask_buffer;
+  g_return_val_if_fail (GEGL_IS_BUFFER (distance_buffer), NULL);
+
+  region.src_buffer  = distance_buffer;
+  region.mask_buffer = gegl_buffer_new (gegl_buffer_get_extent (distance_buffer),
+                                        babl_format ("Y float"));
+  region.antialias   = antialias;
+  region.threshold   = threshold;
+
+  gimp_parallel_distribute_area (gegl_buffer_get_extent (distance_buffer),
+                                 MIN_PARALLEL_SUB_AREA,
+                                 (GimpParallelDistributeAreaFunc)
+                                 by_distance_area,
+                                 &region);
+
+  return region.mask_buffer;
 }
 
 
@@ -287,12 +368,29 @@ pixel_difference (const gfloat        *col1,
                   gboolean             has_alpha,
                   gboolean             select_transparent,
                   GimpSelectCriterion  select_criterion)
+{
+  return distance_to_mask (pixel_distance (col1, col2,
+                                           n_components,
+                                           has_alpha,
+                                           select_transparent,
+                                           select_criterion),
+                           antialias, threshold);
+}
+
+/*  returns G_MAXFLOAT for pixels which are never selected  */
+static gfloat
+pixel_distance (const gfloat        *col1,
+                const gfloat        *col2,
+                gint                 n_components,
+                gboolean             has_alpha,
+                gboolean             select_transparent,
+                GimpSelectCriterion  select_criterion)
 {
   gfloat max = 0.0;
 
   /*  if there is an alpha channel, never select transparent regions  */
   if (! select_transparent && has_alpha && col2[n_components - 1] == 0.0)
-    return 0.0;
+    return G_MAXFLOAT;
 
   if (select_transparent && has_alpha)
     {
@@ -352,6 +450,14 @@ pixel_difference (const gfloat        *col1,
         }
     }
 
+  return max;
+}
+
+static inline gfloat
+distance_to_mask (gfloat   max,
+                  gboolean antialias,
+                  gfloat   threshold)
+{
   if (antialias && threshold > 0.0)
     {
       gfloat aa = 1.5 - (max / threshold);
@@ -372,137 +478,279 @@ pixel_difference (const gfloat        *col1,
     }
 }
 
-/* #define FETCH_ROW 1 */
-
-static gboolean
-find_contiguous_segment (const gfloat        *col,
-                         GeglBuffer          *src_buffer,
-                         GeglBuffer          *mask_buffer,
-                         const Babl          *format,
-                         gint                 n_components,
-                         gboolean             has_alpha,
-                         gint                 width,
-                         gboolean             select_transparent,
-                         GimpSelectCriterion  select_criterion,
-                         gboolean             antialias,
-                         gfloat               threshold,
-                         gint                 initial_x,
-                         gint                 initial_y,
-                         gint                *start,
-                         gint                *end,
-                         gfloat              *row)
+static void
+by_color_init (ContiguousRegion    *region,
+               GimpPickable        *pickable,
+               gboolean             select_transparent,
+               GimpSelectCriterion  select_criterion,
+               const GimpRGB       *color,
+               gfloat              *start_col)
 {
-  gfloat *s;
-  gfloat  mask_row[width];
-  gfloat  diff;
-
-#ifdef FETCH_ROW
-  gegl_buffer_get (src_buffer, GEGL_RECTANGLE (0, initial_y, width, 1), 1.0,
-                   format,
-                   row, GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
-  s = row + initial_x * n_components;
-#else
-  s = g_alloca (n_components * sizeof (gfloat));
-
-  gegl_buffer_sample (src_buffer, initial_x, initial_y, NULL, s, format,
-                      GEGL_SAMPLER_NEAREST, GEGL_ABYSS_NONE);
-#endif
+  GeglBuffer *src_buffer;
+  const Babl *format;
+  gint        n_components;
+  gboolean    has_alpha;
 
-  diff = pixel_difference (col, s, antialias, threshold,
-                           n_components, has_alpha, select_transparent,
-                           select_criterion);
+  gimp_pickable_flush (pickable);
 
-  /* check the starting pixel */
-  if (! diff)
-    return FALSE;
+  src_buffer = gimp_pickable_get_buffer (pickable);
 
-  mask_row[initial_x] = diff;
+  format = choose_format (src_buffer, select_criterion,
+                          &n_components, &has_alpha);
 
-  *start = initial_x - 1;
-#ifdef FETCH_ROW
-  s = row + *start * n_components;
-#endif
+  gimp_rgba_get_pixel (color, format, start_col);
 
-  while (*start >= 0 && diff)
+  if (has_alpha)
     {
-#ifndef FETCH_ROW
-      gegl_buffer_sample (src_buffer, *start, initial_y, NULL, s, format,
-                          GEGL_SAMPLER_NEAREST, GEGL_ABYSS_NONE);
-#endif
+      if (select_transparent)
+        {
+          /*  don't select transparancy if "color" isn't fully transparent
+           */
+          if (start_col[n_components - 1] > 0.0)
+            select_transparent = FALSE;
+        }
+    }
+  else
+    {
+      select_transparent = FALSE;
+    }
 
-      diff = pixel_difference (col, s, antialias, threshold,
-                               n_components, has_alpha, select_transparent,
-                               select_criterion);
+  region->src_buffer         = src_buffer;
+  region->mask_buffer        = gegl_buffer_new (gegl_buffer_get_extent (src_buffer),
+                                                babl_format ("Y float"));
+  region->format             = format;
+  region->n_components       = n_components;
+  region->has_alpha          = has_alpha;
+  region->width              = gegl_buffer_get_width  (src_buffer);
+  region->height             = gegl_buffer_get_height (src_buffer);
+  region->select_transparent = select_transparent;
+  region->select_criterion   = select_criterion;
+  region->antialias          = FALSE;
+  region->threshold          = 0.0;
+  region->col                = start_col;
+}
 
-      mask_row[*start] = diff;
+static void
+by_color_area (const GeglRectangle    *area,
+               const ContiguousRegion *region)
+{
+  GeglBufferIterator *iter;
+
+  iter = gegl_buffer_iterator_new (region->src_buffer,
+                                   area, 0, region->format,
+                                   GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
+
+  gegl_buffer_iterator_add (iter, region->mask_buffer,
+                            area, 0, babl_format ("Y float"),
+                            GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
 
-      if (diff)
+  while (gegl_buffer_iterator_next (iter))
+    {
+      const gfloat *src   = iter->data[0];
+      gfloat       *dest  = iter->data[1];
+      gint          count = iter->length;
+
+      while (count--)
         {
-          (*start)--;
-#ifdef FETCH_ROW
-          s -= n_components;
-#endif
+          /*  Find how closely the colors match  */
+          *dest = pixel_difference (region->col, src,
+                                    region->antialias,
+                                    region->threshold,
+                                    region->n_components,
+                                    region->has_alpha,
+                                    region->select_transparent,
+                                    region->select_criterion);
+
+          src  += region->n_components;
+          dest += 1;
         }
     }
+}
 
-  diff = 1;
-  *end = initial_x + 1;
-#ifdef FETCH_ROW
-  s = row + *end * n_components;
-#endif
+static void
+distance_by_color_area (const GeglRectangle    *area,
+                        const ContiguousRegion *region)
+{
+  GeglBufferIterator *iter;
 
-  while (*end < width && diff)
-    {
-#ifndef FETCH_ROW
-      gegl_buffer_sample (src_buffer, *end, initial_y, NULL, s, format,
-                          GEGL_SAMPLER_NEAREST, GEGL_ABYSS_NONE);
-#endif
+  iter = gegl_buffer_iterator_new (region->src_buffer,
+                                   area, 0, region->format,
+                                   GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
 
-      diff = pixel_difference (col, s, antialias, threshold,
-                               n_components, has_alpha, select_transparent,
-                               select_criterion);
+  gegl_buffer_iterator_add (iter, region->mask_buffer,
+                            area, 0, babl_format ("Y float"),
+                            GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
 
-      mask_row[*end] = diff;
+  while (gegl_buffer_iterator_next (iter))
+    {
+      const gfloat *src   = iter->data[0];
+      gfloat       *dest  = iter->data[1];
+      gint          count = iter->length;
 
-      if (diff)
+      while (count--)
         {
-          (*end)++;
-#ifdef FETCH_ROW
-          s += n_components;
-#endif
+          *dest = pixel_distance (region->col, src,
+                                  region->n_components,
+                                  region->has_alpha,
+                                  region->select_transparent,
+                                  region->select_criterion);
+
+          src  += region->n_components;
+          dest += 1;
         }
     }
+}
+
+static void
+by_distance_area (const GeglRectangle    *area,
+                  const ContiguousRegion *region)
+{
+  GeglBufferIterator *iter;
+
+  iter = gegl_buffer_iterator_new (region->src_buffer,
+                                   area, 0, babl_format ("Y float"),
+                                   GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
+
+  gegl_buffer_iterator_add (iter, region->mask_buffer,
+                            area, 0, babl_format ("Y float"),
+                            GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
+
+  while (gegl_buffer_iterator_next (iter))
+    {
+      const gfloat *src   = iter->data[0];
+      gfloat       *dest  = iter->data[1];
+      gint          count = iter->length;
+
+      while (count--)
+        *dest++ = distance_to_mask (*src++,
+                                    region->antialias,
+                                    region->threshold);
+    }
+}
+
+static void
+contiguous_row_fetch (ContiguousRow *row,
+                      gint           x)
+{
+  const ContiguousRegion *region = row->region;
+  gint                    x1;
+  gint                    x2;
+  const gfloat           *s;
+  gfloat                 *d;
+  gint                    i;
+
+  x1 = x - x % CHUNK_SIZE;
+  x2 = MIN (x1 + CHUNK_SIZE, region->width);
+
+  /*  keep the cached range contiguous, scanning only ever extends it
+   *  by one chunk to the left or to the right
+   */
+  if (x2 != row->x1 && x1 != row->x2)
+    {
+      row->x1 = x1;
+      row->x2 = x1;
+    }
+
+  gegl_buffer_get (region->src_buffer,
+                   GEGL_RECTANGLE (x1, row->y, x2 - x1, 1), 1.0,
+                   region->format, row->src + x1 * region->n_components,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  s = row->src  + x1 * region->n_components;
+  d = row->diff + x1;
+
+  for (i = x1; i < x2; i++)
+    {
+      *d++ = pixel_difference (region->col, s,
+                               region->antialias,
+                               region->threshold,
+                               region->n_components,
+                               region->has_alpha,
+                               region->select_transparent,
+                               region->select_criterion);
+
+      s += region->n_components;
+    }
+
+  row->x1 = MIN (row->x1, x1);
+  row->x2 = MAX (row->x2, x2);
+}
+
+static inline gfloat
+contiguous_row_get_diff (ContiguousRow *row,
+                         gint           x)
+{
+  if (x < row->x1 || x >= row->x2)
+    contiguous_row_fetch (row, x);
+
+  return row->diff[x];
+}
+
+static gboolean
+find_contiguous_segment (const ContiguousRegion *region,
+                         ContiguousRow          *row,
+                         gint                    initial_x,
+                         gint                    initial_y,
+                         gint                   *start,
+                         gint                   *end)
+{
+  gfloat diff;
+  gint   x1;
+
+  if (row->y != initial_y)
+    {
+      row->y  = initial_y;
+      row->x1 = 0;
+      row->x2 = 0;
+    }
+
+  /* check the starting pixel */
+  if (! contiguous_row_get_diff (row, initial_x))
+    return FALSE;
+
+  *start = initial_x - 1;
+
+  while (*start >= 0 && contiguous_row_get_diff (row, *start))
+    (*start)--;
 
-  gegl_buffer_set (mask_buffer, GEGL_RECTANGLE (*start, initial_y,
-                                                *end - *start, 1),
-                   0, babl_format ("Y float"), &mask_row[*start],
+  *end = initial_x + 1;
+
+  while (*end < region->width && contiguous_row_get_diff (row, *end))
+    (*end)++;
+
+  /*  the pixels just outside the segment are unselected, their
+   *  (zero) value is written along with it
+   */
+  x1 = MAX (*start, 0);
+
+  gegl_buffer_set (region->mask_buffer,
+                   GEGL_RECTANGLE (x1, initial_y,
+                                                   *end - x1, 1),
+                   0, babl_format ("Y float"), row->diff + x1,
                    GEGL_AUTO_ROWSTRIDE);
 
   return TRUE;
 }
 
 static void
-find_contiguous_region (GeglBuffer          *src_buffer,
-                        GeglBuffer          *mask_buffer,
-                        const Babl          *format,
-                        gint                 n_components,
-                        gboolean             has_alpha,
-                        gboolean             select_transparent,
-                        GimpSelectCriterion  select_criterion,
-                        gboolean             antialias,
-                        gfloat               threshold,
-                        gint                 x,
-                        gint                 y,
-                        const gfloat        *col)
+find_contiguous_region (const ContiguousRegion *region,
+                        gint                    x,
+                        gint                    y)
 {
-  gint    start, end;
-  gint    new_start, new_end;
-  GQueue *coord_stack;
-  gfloat *row = NULL;
+  ContiguousRow  row;
+  gint           start, end;
+  gint           new_start, new_end;
+  GQueue        *coord_stack;
+  gfloat        *mask_row;
+
+  row.region = region;
+  row.y      = -1;
+  row.x1     = 0;
+  row.x2     = 0;
+  row.src    = g_new (gfloat, region->width * region->n_components);
+  row.diff   = g_new (gfloat, region->width);
 
-#ifdef FETCH_ROW
-  row = g_new (gfloat, gegl_buffer_get_width (src_buffer) * n_components);
-#endif
+  mask_row = g_new (gfloat, region->width);
 
   coord_stack = g_queue_new ();
 
@@ -521,28 +769,28 @@ find_contiguous_region (GeglBuffer          *src_buffer,
       start = GPOINTER_TO_INT (g_queue_pop_head (coord_stack));
       end   = GPOINTER_TO_INT (g_queue_pop_head (coord_stack));
 
+      start = MAX (start, -1);
+      end   = MIN (end, region->width);
+
+      if (end - start < 2)
+        continue;
+
+      /*  fetch the mask of the whole run at once  */
+      gegl_buffer_get (region->mask_buffer,
+                       GEGL_RECTANGLE (start + 1, y, end - start - 1, 1), 1.0,
+                       babl_format ("Y float"), mask_row + start + 1,
+                       GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
       for (x = start + 1; x < end; x++)
         {
-          gfloat val;
-
-          gegl_buffer_sample (mask_buffer, x, y, NULL, &val,
-                              babl_format ("Y float"),
-                              GEGL_SAMPLER_NEAREST, GEGL_ABYSS_NONE);
-          if (val != 0.0)
+          if (mask_row[x] != 0.0)
             continue;
 
-          if (! find_contiguous_segment (col, src_buffer, mask_buffer,
-                                         format,
-                                         n_components,
-                                         has_alpha,
-                                         gegl_buffer_get_width (src_buffer),
-                                         select_transparent, select_criterion,
-                                         antialias, threshold, x, y,
-                                         &new_start, &new_end,
-                                         row))
+          if (! find_contiguous_segment (region, &row, x, y,
+                                         &new_start, &new_end))
             continue;
 
-          if (y + 1 < gegl_buffer_get_height (src_buffer))
+          if (y + 1 < region->height)
             {
               g_queue_push_tail (coord_stack, GINT_TO_POINTER (y + 1));
               g_queue_push_tail (coord_stack, GINT_TO_POINTER (new_start));
@@ -555,13 +803,18 @@ find_contiguous_region (GeglBuffer          *src_buffer,
               g_queue_push_tail (coord_stack, GINT_TO_POINTER (new_start));
               g_queue_push_tail (coord_stack, GINT_TO_POINTER (new_end));
             }
+
+          /*  the segment covers the rest of the run up to new_end,
+           *  which is unselected
+           */
+          x = new_end;
         }
     }
   while (! g_queue_is_empty (coord_stack));
 
   g_queue_free (coord_stack);
 
-#ifdef FETCH_ROW
-  g_free (row);
-#endif
+  g_free (mask_row);
+  g_free (row.src);
+  g_free (row.diff);
 }
@@ -19,20 +19,30 @@
 #define __GIMP_PICKABLE_CONTIGUOUS_REGION_H__
 
 
-GeglBuffer * gimp_pickable_contiguous_region_by_seed  (GimpPickable           *pickable,
-                                                       gboolean             antialias,
-                                                       gfloat               threshold,
-                                                       gboolean             select_transparent,
-                                                       GimpSelectCriterion  select_criterion,
-                                                       gint                 x,
-                                                       gint                 y);
+GeglBuffer * gimp_pickable_contiguous_region_by_seed    (GimpPickable        *pickable,
+                                                         gboolean             antialias,
+                                                         gfloat               threshold,
+                                                         gboolean             select_transparent,
+                                                         GimpSelectCriterion  select_criterion,
+                                                         gint                 x,
+                                                         gint                 y);
 
-GeglBuffer * gimp_pickable_contiguous_region_by_color (GimpPickable           *pickable,
-                                                       gboolean             antialias,
-                                                       gfloat               threshold,
-                                                       gboolean             select_transparent,
-                                                       GimpSelectCriterion  select_criterion,
-                                                       const GimpRGB       *color);
+GeglBuffer * gimp_pickable_contiguous_region_by_color   (GimpPickable        *pickable,
+                                                         gboolean             antialias,
+                                                         gfloat               threshold,
+                                                         gboolean             select_transparent,
+                                                         GimpSelectCriterion  select_criterion,
+                                                         const GimpRGB       *color);
+
+GeglBuffer * gimp_pickable_contiguous_region_distance_by_color
+                                                        (GimpPickable        *pickable,
+                                                         gboolean             select_transparent,
+                                                         GimpSelectCriterion  select_criterion,
+                                                         const GimpRGB       *color);
+GeglBuffer * gimp_pickable_contiguous_region_by_distance
+                                                        (GeglBuffer          *distance_buffer,
+                                                         gboolean             antialias,
+                                                         gfloat               threshold);
 
 
 #endif  /*  __GIMP_PICKABLE_CONTIGUOUS_REGION_H__ */
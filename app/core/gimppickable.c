@@ -237,27 +237,46 @@ gimp_pickable_pick_color (GimpPickable *pickable,
 
   if (sample_average)
     {
-      gint    count        = 0;
-      gdouble color_avg[4] = { 0.0, 0.0, 0.0, 0.0 };
-      gint    radius       = (gint) average_radius;
-      gint    i, j;
-
-      for (i = x - radius; i <= x + radius; i++)
-        for (j = y - radius; j <= y + radius; j++)
-          if (gimp_pickable_get_pixel_at (pickable, i, j, format, pixel))
-            {
-              count++;
+      GeglBuffer    *buffer = gimp_pickable_get_buffer (pickable);
+      gint           radius = (gint) average_radius;
+      GeglRectangle  rect;
+
+      /*  read the whole window in one go, instead of sampling each
+       *  pixel on its own, which is what made large radii slow
+       */
+      if (gegl_rectangle_intersect (&rect,
+                                    GEGL_RECTANGLE (x - radius,
+                                                    y - radius,
+                                                    2 * radius + 1,
+                                                    2 * radius + 1),
+                                    gegl_buffer_get_extent (buffer)))
+        {
+          gdouble  color_avg[4] = { 0.0, 0.0, 0.0, 0.0 };
+          gint     count        = rect.width * rect.height;
+          gdouble *pixels;
+          gdouble *p;
+          gint     i;
+
+          pixels = g_new (gdouble, 4 * count);
+
+          gegl_buffer_get (buffer, &rect, 1.0, format, pixels,
+                           GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
 
-              color_avg[RED]   += pixel[RED];
-              color_avg[GREEN] += pixel[GREEN];
-              color_avg[BLUE]  += pixel[BLUE];
-              color_avg[ALPHA] += pixel[ALPHA];
+          for (i = 0, p = pixels; i < count; i++, p += 4)
+            {
+              color_avg[RED]   += p[RED];
+              color_avg[GREEN] += p[GREEN];
+              color_avg[BLUE]  += p[BLUE];
+              color_avg[ALPHA] += p[ALPHA];
             }
 
-      pixel[RED]   = color_avg[RED]   / count;
-      pixel[GREEN] = color_avg[GREEN] / count;
-      pixel[BLUE]  = color_avg[BLUE]  / count;
-      pixel[ALPHA] = color_avg[ALPHA] / count;
+          g_free (pixels);
+
+          pixel[RED]   = color_avg[RED]   / count;
+          pixel[GREEN] = color_avg[GREEN] / count;
+          pixel[BLUE]  = color_avg[BLUE]  / count;
+          pixel[ALPHA] = color_avg[ALPHA] / count;
+        }
     }
 
   gimp_rgba_set_pixel (color, format, pixel);
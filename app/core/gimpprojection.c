@@ -397,6 +397,14 @@ gimp_projection_get_buffer (GimpPickable *pickable)
       gimp_tile_handler_validate_assign (proj->priv->validate_handler,
                                          proj->priv->buffer);
 
+      /*  render zoomed-out views straight from the graph at their
+       *  mipmap level, instead of validating all of the full
+       *  resolution projection they cover
+       */
+      g_object_set (proj->priv->validate_handler,
+                    "levels", TRUE,
+                    NULL);
+
       /*  This used to call gimp_tile_handler_validate_invalidate()
        *  which forced the entire projection to be constructed in one
        *  go for new images, causing a potentially huge delay. Now we
@@ -576,6 +584,22 @@ gimp_projection_finish_draw (GimpProjection *proj)
     }
 }
 
+void
+gimp_projection_release_buffer (GimpProjection *proj)
+{
+  g_return_if_fail (GIMP_IS_PROJECTION (proj));
+
+  /*  the buffer is rebuilt from the graph the next time it is
+   *  asked for, so this only trades memory for rendering time
+   */
+  if (proj->priv->buffer)
+    {
+      gimp_projection_free_buffer (proj);
+
+      g_object_notify (G_OBJECT (proj), "buffer");
+    }
+}
+
 
 /*  private functions  */
 
@@ -927,14 +951,21 @@ gimp_projection_paint_area (GimpProjection *proj,
                                                x, y, w, h);
       if (now)
         {
-          GeglNode *graph = gimp_projectable_get_graph (proj->priv->projectable);
-
           if (proj->priv->validate_handler)
-            gimp_tile_handler_validate_undo_invalidate (proj->priv->validate_handler,
-                                                        x, y, w, h);
+            {
+              gimp_tile_handler_validate_validate_buffer (proj->priv->validate_handler,
+                                                          proj->priv->buffer,
+                                                          GEGL_RECTANGLE (x, y, w, h));
+            }
+          else
+            {
+              GeglNode *graph;
 
-          gegl_node_blit_buffer (graph, proj->priv->buffer,
-                                 GEGL_RECTANGLE (x, y, w, h));
+              graph = gimp_projectable_get_graph (proj->priv->projectable);
+
+              gegl_node_blit_buffer (graph, proj->priv->buffer,
+                                     GEGL_RECTANGLE (x, y, w, h));
+            }
         }
 
       /*  add the projectable's offsets because the list of update areas
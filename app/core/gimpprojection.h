@@ -69,6 +69,8 @@ void             gimp_projection_flush             (GimpProjection    *proj);
 void             gimp_projection_flush_now         (GimpProjection    *proj);
 void             gimp_projection_finish_draw       (GimpProjection    *proj);
 
+void             gimp_projection_release_buffer    (GimpProjection    *proj);
+
 gint64           gimp_projection_estimate_memsize  (GimpImageBaseType  type,
                                                     GimpComponentType  component_type,
                                                     gint               width,
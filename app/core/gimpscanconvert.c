@@ -29,10 +29,15 @@
 
 #include "core-types.h"
 
+#include "gimp-parallel.h"
 #include "gimpbezierdesc.h"
 #include "gimpscanconvert.h"
 
 
+#define MIN_PARALLEL_SUB_SIZE 64
+#define MIN_PARALLEL_SUB_AREA (MIN_PARALLEL_SUB_SIZE * MIN_PARALLEL_SUB_SIZE)
+
+
 struct _GimpScanConvert
 {
   gdouble         ratio_xy;
@@ -55,6 +60,29 @@ struct _GimpScanConvert
   GArray         *path_data;
 };
 
+typedef struct
+{
+  GimpScanConvert *sc;
+  GeglBuffer      *buffer;
+  cairo_path_t     path;
+  gint             off_x;
+  gint             off_y;
+  gboolean         replace;
+  gboolean         antialias;
+  gdouble          value;
+} RenderData;
+
+
+/*  local function prototypes  */
+
+static void   gimp_scan_convert_setup_cairo (GimpScanConvert     *sc,
+                                             cairo_t             *cr,
+                                             const cairo_path_t  *path,
+                                             gboolean             antialias,
+                                             gdouble              value);
+static void   gimp_scan_convert_render_area (const GeglRectangle *area,
+                                             RenderData          *data);
+
 
 /*  public functions  */
 
@@ -450,47 +478,232 @@ gimp_scan_convert_render_full (GimpScanConvert *sc,
                                gboolean         antialias,
                                gdouble          value)
 {
-  const Babl         *format;
-  GeglBufferIterator *iter;
-  GeglRectangle      *roi;
-  cairo_t            *cr;
-  cairo_surface_t    *surface;
-  cairo_path_t        path;
-  gint                bpp;
-  gint                x, y;
-  gint                width, height;
+  const GeglRectangle *extent;
+  RenderData           data;
+  GeglRectangle        rect       = { 0, };
+  gboolean             have_rect;
+  gint                 x, y;
+  gint                 width, height;
 
   g_return_if_fail (sc != NULL);
   g_return_if_fail (GEGL_IS_BUFFER (buffer));
 
+  extent = gegl_buffer_get_extent (buffer);
+
   x      = 0;
   y      = 0;
   width  = gegl_buffer_get_width  (buffer);
   height = gegl_buffer_get_height (buffer);
 
-  if (sc->clip && ! gimp_rectangle_intersect (x, y, width, height,
-                                              sc->clip_x, sc->clip_y,
-                                              sc->clip_w, sc->clip_h,
-                                              &x, &y, &width, &height))
+  have_rect = (! sc->clip ||
+               gimp_rectangle_intersect (x, y, width, height,
+                                         sc->clip_x, sc->clip_y,
+                                         sc->clip_w, sc->clip_h,
+                                         &x, &y, &width, &height));
+
+  /*  only rasterize the tiles the path actually touches  */
+  if (have_rect)
+    have_rect = gimp_scan_convert_get_bounds (sc,
+                                              &rect.x, &rect.y,
+                                              &rect.width, &rect.height);
+
+  if (have_rect)
+    have_rect = gimp_rectangle_intersect (rect.x + off_x, rect.y + off_y,
+                                          rect.width, rect.height,
+                                          x, y, width, height,
+                                          &rect.x, &rect.y,
+                                          &rect.width, &rect.height);
+
+  if (replace)
+    {
+      /*  clear the rest of the buffer  */
+      if (! have_rect)
+        {
+          gegl_buffer_clear (buffer, NULL);
+        }
+      else
+        {
+          const GeglRectangle clear[] =
+          {
+            { extent->x, extent->y,
+              extent->width, rect.y - extent->y },
+            { extent->x, rect.y + rect.height,
+              extent->width, extent->y + extent->height - rect.y - rect.height },
+            { extent->x, rect.y,
+              rect.x - extent->x, rect.height },
+            { rect.x + rect.width, rect.y,
+              extent->x + extent->width - rect.x - rect.width, rect.height }
+          };
+          gint i;
+
+          for (i = 0; i < G_N_ELEMENTS (clear); i++)
+            {
+              if (! gegl_rectangle_is_empty (&clear[i]))
+                gegl_buffer_clear (buffer, &clear[i]);
+            }
+        }
+    }
+
+  if (! have_rect)
     return;
 
+  data.sc            = sc;
+  data.buffer        = buffer;
+  data.path.status   = CAIRO_STATUS_SUCCESS;
+  data.path.data     = (cairo_path_data_t *) sc->path_data->data;
+  data.path.num_data = sc->path_data->len;
+  data.off_x         = off_x;
+  data.off_y         = off_y;
+  data.replace       = replace;
+  data.antialias     = antialias;
+  data.value         = value;
+
+  gimp_parallel_distribute_area (&rect, MIN_PARALLEL_SUB_AREA,
+                                 (GimpParallelDistributeAreaFunc)
+                                 gimp_scan_convert_render_area,
+                                 &data);
+}
+
+/**
+ * gimp_scan_convert_get_bounds:
+ * @sc:     a #GimpScanConvert context
+ * @x:      returns the left edge of the bounds
+ * @y:      returns the top edge of the bounds
+ * @width:  returns the width of the bounds
+ * @height: returns the height of the bounds
+ *
+ * Calculates the pixels which rendering @sc can touch, in the
+ * coordinates of the path, that is without any render offset.
+ *
+ * Return value: %FALSE if rendering @sc touches no pixels at all.
+ */
+gboolean
+gimp_scan_convert_get_bounds (GimpScanConvert *sc,
+                              gint            *x,
+                              gint            *y,
+                              gint            *width,
+                              gint            *height)
+{
+  cairo_surface_t *surface;
+  cairo_t         *cr;
+  cairo_path_t     path;
+  gdouble          x1, y1, x2, y2;
+
+  g_return_val_if_fail (sc != NULL, FALSE);
+  g_return_val_if_fail (x != NULL && y != NULL, FALSE);
+  g_return_val_if_fail (width != NULL && height != NULL, FALSE);
+
+  *x      = 0;
+  *y      = 0;
+  *width  = 0;
+  *height = 0;
+
+  if (sc->path_data->len == 0)
+    return FALSE;
+
   path.status   = CAIRO_STATUS_SUCCESS;
   path.data     = (cairo_path_data_t *) sc->path_data->data;
   path.num_data = sc->path_data->len;
 
+  surface = cairo_image_surface_create (CAIRO_FORMAT_A8, 1, 1);
+  cr = cairo_create (surface);
+
+  gimp_scan_convert_setup_cairo (sc, cr, &path, TRUE, 1.0);
+
+  if (sc->do_stroke)
+    cairo_stroke_extents (cr, &x1, &y1, &x2, &y2);
+  else
+    cairo_fill_extents (cr, &x1, &y1, &x2, &y2);
+
+  cairo_user_to_device (cr, &x1, &y1);
+  cairo_user_to_device (cr, &x2, &y2);
+
+  cairo_destroy (cr);
+  cairo_surface_destroy (surface);
+
+  if (x1 >= x2 || y1 >= y2)
+    return FALSE;
+
+  /*  antialiasing can touch the pixels around the exact extents  */
+  *x      = (gint) floor (x1) - 1;
+  *y      = (gint) floor (y1) - 1;
+  *width  = (gint) ceil (x2) + 1 - *x;
+  *height = (gint) ceil (y2) + 1 - *y;
+
+  return TRUE;
+}
+
+
+/*  private functions  */
+
+static void
+gimp_scan_convert_setup_cairo (GimpScanConvert    *sc,
+                               cairo_t            *cr,
+                               const cairo_path_t *path,
+                               gboolean            antialias,
+                               gdouble             value)
+{
+  cairo_set_source_rgba (cr, 0, 0, 0, value);
+  cairo_append_path (cr, path);
+
+  cairo_set_antialias (cr, antialias ?
+                       CAIRO_ANTIALIAS_GRAY : CAIRO_ANTIALIAS_NONE);
+  cairo_set_miter_limit (cr, sc->miter);
+
+  if (sc->do_stroke)
+    {
+      cairo_set_line_cap (cr,
+                          sc->cap == GIMP_CAP_BUTT ? CAIRO_LINE_CAP_BUTT :
+                          sc->cap == GIMP_CAP_ROUND ? CAIRO_LINE_CAP_ROUND :
+                          CAIRO_LINE_CAP_SQUARE);
+      cairo_set_line_join (cr,
+                           sc->join == GIMP_JOIN_MITER ? CAIRO_LINE_JOIN_MITER :
+                           sc->join == GIMP_JOIN_ROUND ? CAIRO_LINE_JOIN_ROUND :
+                           CAIRO_LINE_JOIN_BEVEL);
+
+      cairo_set_line_width (cr, sc->width);
+
+      if (sc->dash_info)
+        cairo_set_dash (cr,
+                        (double *) sc->dash_info->data,
+                        sc->dash_info->len,
+                        sc->dash_offset);
+
+      cairo_scale (cr, 1.0, sc->ratio_xy);
+    }
+  else
+    {
+      cairo_set_fill_rule (cr, CAIRO_FILL_RULE_EVEN_ODD);
+    }
+}
+
+static void
+gimp_scan_convert_render_area (const GeglRectangle *area,
+                               RenderData          *data)
+{
+  GimpScanConvert    *sc = data->sc;
+  const Babl         *format;
+  GeglBufferIterator *iter;
+  GeglRectangle      *roi;
+  cairo_t            *cr;
+  cairo_surface_t    *surface;
+  gint                bpp;
+
   format = babl_format ("Y u8");
   bpp    = babl_format_get_bytes_per_pixel (format);
 
-  iter = gegl_buffer_iterator_new (buffer, NULL, 0, format,
-                                   GEGL_ACCESS_READWRITE, GEGL_ABYSS_NONE);
+  iter = gegl_buffer_iterator_new (data->buffer, area, 0, format,
+                                   data->replace ?
+                                   GEGL_ACCESS_WRITE : GEGL_ACCESS_READWRITE,
+                                   GEGL_ABYSS_NONE);
   roi = &iter->roi[0];
 
   while (gegl_buffer_iterator_next (iter))
     {
-      guchar     *data    = iter->data[0];
-      guchar     *tmp_buf = NULL;
-      const gint  stride  = cairo_format_stride_for_width (CAIRO_FORMAT_A8,
-                                                           roi->width);
+      guchar     *data_buf = iter->data[0];
+      guchar     *tmp_buf  = NULL;
+      const gint  stride   = cairo_format_stride_for_width (CAIRO_FORMAT_A8,
+                                                            roi->width);
 
       /*  cairo rowstrides are always multiples of 4, whereas
        *  maskPR.rowstride can be anything, so to be able to create an
@@ -501,9 +714,9 @@ gimp_scan_convert_render_full (GimpScanConvert *sc,
         {
           tmp_buf = g_alloca (stride * roi->height);
 
-          if (! replace)
+          if (! data->replace)
             {
-              const guchar *src  = data;
+              const guchar *src  = data_buf;
               guchar       *dest = tmp_buf;
               gint          i;
 
@@ -518,57 +731,30 @@ gimp_scan_convert_render_full (GimpScanConvert *sc,
         }
 
       surface = cairo_image_surface_create_for_data (tmp_buf ?
-                                                     tmp_buf : data,
+                                                     tmp_buf : data_buf,
                                                      CAIRO_FORMAT_A8,
                                                      roi->width, roi->height,
                                                      stride);
 
       cairo_surface_set_device_offset (surface,
-                                       -off_x - roi->x,
-                                       -off_y - roi->y);
+                                       -data->off_x - roi->x,
+                                       -data->off_y - roi->y);
       cr = cairo_create (surface);
       cairo_set_operator (cr, CAIRO_OPERATOR_SOURCE);
 
-      if (replace)
+      if (data->replace)
         {
           cairo_set_source_rgba (cr, 0, 0, 0, 0);
           cairo_paint (cr);
         }
 
-      cairo_set_source_rgba (cr, 0, 0, 0, value);
-      cairo_append_path (cr, &path);
-
-      cairo_set_antialias (cr, antialias ?
-                           CAIRO_ANTIALIAS_GRAY : CAIRO_ANTIALIAS_NONE);
-      cairo_set_miter_limit (cr, sc->miter);
+      gimp_scan_convert_setup_cairo (sc, cr, &data->path,
+                                     data->antialias, data->value);
 
       if (sc->do_stroke)
-        {
-          cairo_set_line_cap (cr,
-                              sc->cap == GIMP_CAP_BUTT ? CAIRO_LINE_CAP_BUTT :
-                              sc->cap == GIMP_CAP_ROUND ? CAIRO_LINE_CAP_ROUND :
-                              CAIRO_LINE_CAP_SQUARE);
-          cairo_set_line_join (cr,
-                               sc->join == GIMP_JOIN_MITER ? CAIRO_LINE_JOIN_MITER :
-                               sc->join == GIMP_JOIN_ROUND ? CAIRO_LINE_JOIN_ROUND :
-                               CAIRO_LINE_JOIN_BEVEL);
-
-          cairo_set_line_width (cr, sc->width);
-
-          if (sc->dash_info)
-            cairo_set_dash (cr,
-                            (double *) sc->dash_info->data,
-                            sc->dash_info->len,
-                            sc->dash_offset);
-
-          cairo_scale (cr, 1.0, sc->ratio_xy);
-          cairo_stroke (cr);
-        }
+        cairo_stroke (cr);
       else
-        {
-          cairo_set_fill_rule (cr, CAIRO_FILL_RULE_EVEN_ODD);
-          cairo_fill (cr);
-        }
+        cairo_fill (cr);
 
       cairo_destroy (cr);
       cairo_surface_destroy (surface);
@@ -576,7 +762,7 @@ gimp_scan_convert_render_full (GimpScanConvert *sc,
       if (tmp_buf)
         {
           const guchar *src  = tmp_buf;
-          guchar       *dest = data;
+          guchar       *dest = data_buf;
           gint          i;
 
           for (i = 0; i < roi->height; i++)
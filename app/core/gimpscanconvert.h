@@ -70,5 +70,11 @@ void      gimp_scan_convert_compose_value      (GimpScanConvert   *sc,
                                                 gint               off_y,
                                                 gdouble            value);
 
+gboolean  gimp_scan_convert_get_bounds         (GimpScanConvert   *sc,
+                                                gint              *x,
+                                                gint              *y,
+                                                gint              *width,
+                                                gint              *height);
+
 
 #endif /* __GIMP_SCAN_CONVERT_H__ */
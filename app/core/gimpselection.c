@@ -19,6 +19,7 @@
 
 #include <string.h>
 
+#include <cairo.h>
 #include <gdk-pixbuf/gdk-pixbuf.h>
 #include <gegl.h>
 
@@ -26,6 +27,9 @@
 
 #include "gegl/gimp-babl.h"
 #include "gegl/gimp-gegl-apply-operation.h"
+#include "gegl/gimp-gegl-mask.h"
+#include "gegl/gimp-gegl-nodes.h"
+#include "gegl/gimp-gegl-utils.h"
 
 #include "gimp.h"
 #include "gimp-edit.h"
@@ -134,6 +138,11 @@ static void       gimp_selection_shrink        (GimpChannel         *channel,
                                                 gboolean             edge_lock,
                                                 gboolean             push_undo);
 
+static void       gimp_selection_mask_buffer   (GeglBuffer          *buffer,
+                                                GeglBuffer          *mask_buffer,
+                                                gint                 mask_offset_x,
+                                                gint                 mask_offset_y);
+
 
 G_DEFINE_TYPE (GimpSelection, gimp_selection, GIMP_TYPE_CHANNEL)
 
@@ -734,13 +743,23 @@ gimp_selection_extract (GimpSelection *selection,
 
   src_buffer = gimp_pickable_get_buffer (pickable);
 
-  /*  Allocate the temp buffer  */
-  dest_buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0, x2 - x1, y2 - y1),
-                                 dest_format);
+  if (dest_format == src_format)
+    {
+      /*  Share the pixels copy-on-write  */
+      dest_buffer =
+        gimp_gegl_buffer_dup_area (src_buffer,
+                                   GEGL_RECTANGLE (x1, y1, x2 - x1, y2 - y1));
+    }
+  else
+    {
+      /*  Allocate the temp buffer  */
+      dest_buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0, x2 - x1, y2 - y1),
+                                     dest_format);
 
-  /*  First, copy the pixels, possibly doing INDEXED->RGB and adding alpha  */
-  gegl_buffer_copy (src_buffer,  GEGL_RECTANGLE (x1, y1, x2 - x1, y2 - y1),
-                    dest_buffer, GEGL_RECTANGLE (0, 0, 0, 0));
+      /*  Copy the pixels, doing INDEXED->RGB or adding alpha  */
+      gegl_buffer_copy (src_buffer,  GEGL_RECTANGLE (x1, y1, x2 - x1, y2 - y1),
+                        dest_buffer, GEGL_RECTANGLE (0, 0, 0, 0));
+    }
 
   if (non_empty)
     {
@@ -750,11 +769,9 @@ gimp_selection_extract (GimpSelection *selection,
 
       mask_buffer = gimp_drawable_get_buffer (GIMP_DRAWABLE (selection));
 
-      gimp_gegl_apply_opacity (dest_buffer, NULL, NULL, dest_buffer,
-                               mask_buffer,
-                               - (off_x + x1),
-                               - (off_y + y1),
-                               1.0);
+      gimp_selection_mask_buffer (dest_buffer, mask_buffer,
+                                  - (off_x + x1),
+                                  - (off_y + y1));
 
       if (cut_image && GIMP_IS_DRAWABLE (pickable))
         {
@@ -863,3 +880,87 @@ gimp_selection_float (GimpSelection *selection,
 
   return layer;
 }
+
+
+/*  private functions  */
+
+/*  Masks @buffer with the selection, one tile at a time, leaving the
+ *  completely selected tiles alone, so they stay shared with the
+ *  drawable they were copied from.
+ */
+static void
+gimp_selection_mask_buffer (GeglBuffer *buffer,
+                            GeglBuffer *mask_buffer,
+                            gint        mask_offset_x,
+                            gint        mask_offset_y)
+{
+  const GeglRectangle *extent = gegl_buffer_get_extent (buffer);
+  cairo_region_t      *region;
+  GeglNode            *node;
+  gint                 shift_x;
+  gint                 shift_y;
+  gint                 tile_width;
+  gint                 tile_height;
+  gint                 x, y;
+  gint                 n_rects;
+  gint                 i;
+
+  g_object_get (buffer,
+                "shift-x",     &shift_x,
+                "shift-y",     &shift_y,
+                "tile-width",  &tile_width,
+                "tile-height", &tile_height,
+                NULL);
+
+  region = cairo_region_create ();
+
+  /*  walk the tiles in buffer coordinates, the first ones may be
+   *  partially outside the buffer
+   */
+  for (y = extent->y - ((extent->y + shift_y) % tile_height + tile_height) % tile_height;
+       y < extent->y + extent->height;
+       y += tile_height)
+    {
+      for (x = extent->x - ((extent->x + shift_x) % tile_width + tile_width) % tile_width;
+           x < extent->x + extent->width;
+           x += tile_width)
+        {
+          GeglRectangle tile;
+          GeglRectangle mask_tile;
+
+          gegl_rectangle_intersect (&tile,
+                                    GEGL_RECTANGLE (x, y,
+                                                    tile_width, tile_height),
+                                    extent);
+
+          mask_tile    = tile;
+          mask_tile.x -= mask_offset_x;
+          mask_tile.y -= mask_offset_y;
+
+          if (! gimp_gegl_mask_is_full_in_area (mask_buffer, &mask_tile))
+            cairo_region_union_rectangle (region,
+                                          (cairo_rectangle_int_t *) &tile);
+        }
+    }
+
+  node = gimp_gegl_create_apply_opacity_node (mask_buffer,
+                                              mask_offset_x,
+                                              mask_offset_y,
+                                              1.0);
+
+  n_rects = cairo_region_num_rectangles (region);
+
+  for (i = 0; i < n_rects; i++)
+    {
+      cairo_rectangle_int_t rect;
+
+      cairo_region_get_rectangle (region, i, &rect);
+
+      gimp_gegl_apply_operation (buffer, NULL, NULL,
+                                 node, buffer,
+                                 (const GeglRectangle *) &rect);
+    }
+
+  g_object_unref (node);
+  cairo_region_destroy (region);
+}
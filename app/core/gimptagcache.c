@@ -20,6 +20,8 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include <gdk-pixbuf/gdk-pixbuf.h>
 #include <gegl.h>
 
@@ -42,7 +44,14 @@
 #include "gimp-intl.h"
 
 
-#define GIMP_TAG_CACHE_FILE  "tags.xml"
+#define GIMP_TAG_CACHE_FILE         "tags.xml"
+
+/*  a binary copy of tags.xml, which is only used as long as tags.xml
+ *  has the same mtime and size as when the copy was written
+ */
+#define GIMP_TAG_CACHE_BINARY_FILE  "tags.cache"
+#define GIMP_TAG_CACHE_BINARY_MAGIC "GIMP tag cache\n"
+#define GIMP_TAG_CACHE_BINARY_VERSION 1
 
 /* #define DEBUG_GIMP_TAG_CACHE  1 */
 
@@ -70,8 +79,12 @@ typedef struct
 
 struct _GimpTagCachePriv
 {
-  GArray *records;
-  GList  *containers;
+  GArray     *records;
+  GList      *containers;
+
+  /*  GQuark => index into records  */
+  GHashTable *identifier_table;
+  GHashTable *checksum_table;
 };
 
 
@@ -83,6 +96,16 @@ static void          gimp_tag_cache_object_initialize  (GimpTagged             *
                                                         GimpTagCache           *cache);
 static void          gimp_tag_cache_add_object         (GimpTagCache           *cache,
                                                         GimpTagged             *tagged);
+static void          gimp_tag_cache_clear_records      (GimpTagCache           *cache);
+static void          gimp_tag_cache_index_records      (GimpTagCache           *cache);
+static gboolean      gimp_tag_cache_lookup             (GHashTable             *table,
+                                                        GQuark                  quark,
+                                                        gint                   *index);
+
+static void          gimp_tag_cache_save_binary        (GList                  *records,
+                                                        GFile                  *xml_file);
+static gboolean      gimp_tag_cache_load_binary        (GArray                 *records,
+                                                        GFile                  *xml_file);
 
 static void          gimp_tag_cache_load_start_element (GMarkupParseContext    *context,
                                                         const gchar            *element_name,
@@ -140,6 +163,11 @@ gimp_tag_cache_init (GimpTagCache *cache)
   cache->priv->records    = g_array_new (FALSE, FALSE,
                                          sizeof (GimpTagCacheRecord));
   cache->priv->containers = NULL;
+
+  cache->priv->identifier_table = g_hash_table_new (g_direct_hash,
+                                                    g_direct_equal);
+  cache->priv->checksum_table   = g_hash_table_new (g_direct_hash,
+                                                    g_direct_equal);
 }
 
 static void
@@ -149,20 +177,15 @@ gimp_tag_cache_finalize (GObject *object)
 
   if (cache->priv->records)
     {
-      gint i;
-
-      for (i = 0; i < cache->priv->records->len; i++)
-        {
-          GimpTagCacheRecord *rec = &g_array_index (cache->priv->records,
-                                                    GimpTagCacheRecord, i);
-
-          g_list_free_full (rec->tags, (GDestroyNotify) g_object_unref);
-        }
+      gimp_tag_cache_clear_records (cache);
 
       g_array_free (cache->priv->records, TRUE);
       cache->priv->records = NULL;
     }
 
+  g_clear_pointer (&cache->priv->identifier_table, g_hash_table_unref);
+  g_clear_pointer (&cache->priv->checksum_table,   g_hash_table_unref);
+
   if (cache->priv->containers)
     {
       g_list_free (cache->priv->containers);
@@ -181,6 +204,8 @@ gimp_tag_cache_get_memsize (GimpObject *object,
 
   memsize += gimp_g_list_get_memsize (cache->priv->containers, 0);
   memsize += cache->priv->records->len * sizeof (GimpTagCacheRecord);
+  memsize += gimp_g_hash_table_get_memsize (cache->priv->identifier_table, 0);
+  memsize += gimp_g_hash_table_get_memsize (cache->priv->checksum_table, 0);
 
   return memsize + GIMP_OBJECT_CLASS (parent_class)->get_memsize (object,
                                                                   gui_size);
@@ -234,12 +259,13 @@ static void
 gimp_tag_cache_add_object (GimpTagCache *cache,
                            GimpTagged   *tagged)
 {
-  gchar  *identifier;
-  GQuark  identifier_quark = 0;
-  gchar  *checksum;
-  GQuark  checksum_quark = 0;
-  GList  *list;
-  gint    i;
+  GimpTagCacheRecord *rec = NULL;
+  gchar              *identifier;
+  GQuark              identifier_quark = 0;
+  gchar              *checksum;
+  GQuark              checksum_quark = 0;
+  GList              *list;
+  gint                i;
 
   identifier = gimp_tagged_get_identifier (tagged);
 
@@ -249,62 +275,66 @@ gimp_tag_cache_add_object (GimpTagCache *cache,
       g_free (identifier);
     }
 
-  if (identifier_quark)
+  if (identifier_quark &&
+      gimp_tag_cache_lookup (cache->priv->identifier_table,
+                             identifier_quark, &i))
     {
-      for (i = 0; i < cache->priv->records->len; i++)
-        {
-          GimpTagCacheRecord *rec = &g_array_index (cache->priv->records,
-                                                    GimpTagCacheRecord, i);
-
-          if (rec->identifier == identifier_quark)
-            {
-              for (list = rec->tags; list; list = g_list_next (list))
-                {
-                  gimp_tagged_add_tag (tagged, GIMP_TAG (list->data));
-                }
-
-              rec->referenced = TRUE;
-              return;
-            }
-        }
+      rec = &g_array_index (cache->priv->records, GimpTagCacheRecord, i);
     }
 
-  checksum = gimp_tagged_get_checksum (tagged);
-
-  if (checksum)
+  if (! rec)
     {
-      checksum_quark = g_quark_try_string (checksum);
-      g_free (checksum);
-    }
+      checksum = gimp_tagged_get_checksum (tagged);
 
-  if (checksum_quark)
-    {
-      for (i = 0; i < cache->priv->records->len; i++)
+      if (checksum)
         {
-          GimpTagCacheRecord *rec = &g_array_index (cache->priv->records,
-                                                    GimpTagCacheRecord, i);
+          checksum_quark = g_quark_try_string (checksum);
+          g_free (checksum);
+        }
+
+      if (checksum_quark &&
+          gimp_tag_cache_lookup (cache->priv->checksum_table,
+                                 checksum_quark, &i))
+        {
+          rec = &g_array_index (cache->priv->records, GimpTagCacheRecord, i);
 
-          if (rec->checksum == checksum_quark)
-            {
 #if DEBUG_GIMP_TAG_CACHE
-              g_printerr ("remapping identifier: %s ==> %s\n",
-                          rec->identifier ? g_quark_to_string (rec->identifier) : "(NULL)",
-                          identifier_quark ? g_quark_to_string (identifier_quark) : "(NULL)");
+          g_printerr ("remapping identifier: %s ==> %s\n",
+                      rec->identifier ? g_quark_to_string (rec->identifier) : "(NULL)",
+                      identifier_quark ? g_quark_to_string (identifier_quark) : "(NULL)");
 #endif
 
-              rec->identifier = identifier_quark;
+          if (rec->identifier)
+            {
+              gint old_index;
 
-              for (list = rec->tags; list; list = g_list_next (list))
+              if (gimp_tag_cache_lookup (cache->priv->identifier_table,
+                                         rec->identifier, &old_index) &&
+                  old_index == i)
                 {
-                  gimp_tagged_add_tag (tagged, GIMP_TAG (list->data));
+                  g_hash_table_remove (cache->priv->identifier_table,
+                                       GUINT_TO_POINTER (rec->identifier));
                 }
-
-              rec->referenced = TRUE;
-              return;
             }
+
+          rec->identifier = identifier_quark;
+
+          if (identifier_quark)
+            g_hash_table_insert (cache->priv->identifier_table,
+                                 GUINT_TO_POINTER (identifier_quark),
+                                 GINT_TO_POINTER (i));
         }
     }
 
+  if (rec)
+    {
+      for (list = rec->tags; list; list = g_list_next (list))
+        {
+          gimp_tagged_add_tag (tagged, GIMP_TAG (list->data));
+        }
+
+      rec->referenced = TRUE;
+    }
 }
 
 static void
@@ -442,6 +472,10 @@ gimp_tag_cache_save (GimpTagCache *cache)
       g_printerr (_("Error writing '%s': %s\n"),
                   gimp_file_get_utf8_name (file), error->message);
     }
+  else
+    {
+      gimp_tag_cache_save_binary (saved_records, file);
+    }
 
   if (output)
     g_object_unref (output);
@@ -467,7 +501,9 @@ gimp_tag_cache_save (GimpTagCache *cache)
  * gimp_tag_cache_load:
  * @cache:      a GimpTagCache object.
  *
- * Loads tag cache from file.
+ * Loads tag cache from file. The binary copy of the cache file is
+ * used instead, as long as the cache file did not change since the
+ * copy was written.
  **/
 void
 gimp_tag_cache_load (GimpTagCache *cache)
@@ -481,7 +517,16 @@ gimp_tag_cache_load (GimpTagCache *cache)
   g_return_if_fail (GIMP_IS_TAG_CACHE (cache));
 
   /* clear any previous priv->records */
-  cache->priv->records = g_array_set_size (cache->priv->records, 0);
+  gimp_tag_cache_clear_records (cache);
+
+  file = gimp_directory_file (GIMP_TAG_CACHE_FILE, NULL);
+
+  if (gimp_tag_cache_load_binary (cache->priv->records, file))
+    {
+      gimp_tag_cache_index_records (cache);
+      g_object_unref (file);
+      return;
+    }
 
   parse_data.records = g_array_new (FALSE, FALSE, sizeof (GimpTagCacheRecord));
   memset (&parse_data.current_record, 0, sizeof (GimpTagCacheRecord));
@@ -494,8 +539,6 @@ gimp_tag_cache_load (GimpTagCache *cache)
 
   xml_parser = gimp_xml_parser_new (&markup_parser, &parse_data);
 
-  file = gimp_directory_file (GIMP_TAG_CACHE_FILE, NULL);
-
   if (gimp_xml_parser_parse_gfile (xml_parser, file, &error))
     {
       cache->priv->records = g_array_append_vals (cache->priv->records,
@@ -508,11 +551,360 @@ gimp_tag_cache_load (GimpTagCache *cache)
                   error ? error->message : "WTF unknown error");
     }
 
+  gimp_tag_cache_index_records (cache);
+
   g_object_unref (file);
   gimp_xml_parser_free (xml_parser);
   g_array_free (parse_data.records, TRUE);
 }
 
+static void
+gimp_tag_cache_clear_records (GimpTagCache *cache)
+{
+  gint i;
+
+  for (i = 0; i < cache->priv->records->len; i++)
+    {
+      GimpTagCacheRecord *rec = &g_array_index (cache->priv->records,
+                                                GimpTagCacheRecord, i);
+
+      g_list_free_full (rec->tags, (GDestroyNotify) g_object_unref);
+    }
+
+  cache->priv->records = g_array_set_size (cache->priv->records, 0);
+
+  if (cache->priv->identifier_table)
+    g_hash_table_remove_all (cache->priv->identifier_table);
+
+  if (cache->priv->checksum_table)
+    g_hash_table_remove_all (cache->priv->checksum_table);
+}
+
+/*  records are only ever added by gimp_tag_cache_load(), so their
+ *  indices stay valid until the next load
+ */
+static void
+gimp_tag_cache_index_records (GimpTagCache *cache)
+{
+  gint i;
+
+  for (i = 0; i < cache->priv->records->len; i++)
+    {
+      GimpTagCacheRecord *rec = &g_array_index (cache->priv->records,
+                                                GimpTagCacheRecord, i);
+
+      /*  like the linear search this replaces, the first record wins  */
+      if (rec->identifier &&
+          ! g_hash_table_contains (cache->priv->identifier_table,
+                                   GUINT_TO_POINTER (rec->identifier)))
+        {
+          g_hash_table_insert (cache->priv->identifier_table,
+                               GUINT_TO_POINTER (rec->identifier),
+                               GINT_TO_POINTER (i));
+        }
+
+      if (rec->checksum &&
+          ! g_hash_table_contains (cache->priv->checksum_table,
+                                   GUINT_TO_POINTER (rec->checksum)))
+        {
+          g_hash_table_insert (cache->priv->checksum_table,
+                               GUINT_TO_POINTER (rec->checksum),
+                               GINT_TO_POINTER (i));
+        }
+    }
+}
+
+static gboolean
+gimp_tag_cache_lookup (GHashTable *table,
+                       GQuark      quark,
+                       gint       *index)
+{
+  gpointer value;
+
+  if (g_hash_table_lookup_extended (table, GUINT_TO_POINTER (quark),
+                                    NULL, &value))
+    {
+      *index = GPOINTER_TO_INT (value);
+
+      return TRUE;
+    }
+
+  return FALSE;
+}
+
+static gboolean
+gimp_tag_cache_query_file (GFile   *file,
+                           guint64 *mtime,
+                           guint64 *size)
+{
+  GFileInfo *info;
+
+  info = g_file_query_info (file,
+                            G_FILE_ATTRIBUTE_TIME_MODIFIED ","
+                            G_FILE_ATTRIBUTE_STANDARD_SIZE,
+                            G_FILE_QUERY_INFO_NONE,
+                            NULL, NULL);
+  if (! info)
+    return FALSE;
+
+  *mtime = g_file_info_get_attribute_uint64 (info,
+                                             G_FILE_ATTRIBUTE_TIME_MODIFIED);
+  *size  = g_file_info_get_size (info);
+
+  g_object_unref (info);
+
+  return TRUE;
+}
+
+static void
+gimp_tag_cache_append_uint32 (GByteArray *buf,
+                              guint32     value)
+{
+  value = GUINT32_TO_LE (value);
+
+  g_byte_array_append (buf, (const guint8 *) &value, sizeof (value));
+}
+
+static void
+gimp_tag_cache_append_uint64 (GByteArray *buf,
+                              guint64     value)
+{
+  value = GUINT64_TO_LE (value);
+
+  g_byte_array_append (buf, (const guint8 *) &value, sizeof (value));
+}
+
+/*  strings are stored with their terminating NUL  */
+static void
+gimp_tag_cache_append_string (GByteArray  *buf,
+                              const gchar *string)
+{
+  gsize len;
+
+  if (! string)
+    string = "";
+
+  len = strlen (string) + 1;
+
+  gimp_tag_cache_append_uint32 (buf, len);
+  g_byte_array_append (buf, (const guint8 *) string, len);
+}
+
+/*  writes the binary copy of the tags.xml which was just written,
+ *  failing to do so only costs a slower startup
+ */
+static void
+gimp_tag_cache_save_binary (GList *records,
+                            GFile *xml_file)
+{
+  GFile      *file;
+  GByteArray *buf;
+  GList      *list;
+  guint64     mtime;
+  guint64     size;
+  GError     *error = NULL;
+
+  if (! gimp_tag_cache_query_file (xml_file, &mtime, &size))
+    return;
+
+  buf = g_byte_array_new ();
+
+  g_byte_array_append (buf, (const guint8 *) GIMP_TAG_CACHE_BINARY_MAGIC,
+                       strlen (GIMP_TAG_CACHE_BINARY_MAGIC));
+  gimp_tag_cache_append_uint32 (buf, GIMP_TAG_CACHE_BINARY_VERSION);
+  gimp_tag_cache_append_uint64 (buf, mtime);
+  gimp_tag_cache_append_uint64 (buf, size);
+  gimp_tag_cache_append_uint32 (buf, g_list_length (records));
+
+  for (list = records; list; list = g_list_next (list))
+    {
+      GimpTagCacheRecord *rec = list->data;
+      GList              *tags;
+      gint                n_tags = 0;
+
+      for (tags = rec->tags; tags; tags = g_list_next (tags))
+        if (! gimp_tag_get_internal (tags->data))
+          n_tags++;
+
+      gimp_tag_cache_append_string (buf, g_quark_to_string (rec->identifier));
+      gimp_tag_cache_append_string (buf, g_quark_to_string (rec->checksum));
+      gimp_tag_cache_append_uint32 (buf, n_tags);
+
+      for (tags = rec->tags; tags; tags = g_list_next (tags))
+        if (! gimp_tag_get_internal (tags->data))
+          gimp_tag_cache_append_string (buf, gimp_tag_get_name (tags->data));
+    }
+
+  file = gimp_directory_file (GIMP_TAG_CACHE_BINARY_FILE, NULL);
+
+  if (! g_file_replace_contents (file, (const gchar *) buf->data, buf->len,
+                                 NULL, FALSE, G_FILE_CREATE_NONE, NULL,
+                                 NULL, &error))
+    {
+      g_printerr (_("Error writing '%s': %s\n"),
+                  gimp_file_get_utf8_name (file), error->message);
+      g_clear_error (&error);
+    }
+
+  g_object_unref (file);
+  g_byte_array_free (buf, TRUE);
+}
+
+static gboolean
+gimp_tag_cache_read_uint32 (const guchar **data,
+                            const guchar  *end,
+                            guint32       *value)
+{
+  if ((gsize) (end - *data) < sizeof (guint32))
+    return FALSE;
+
+  memcpy (value, *data, sizeof (guint32));
+  *value = GUINT32_FROM_LE (*value);
+  *data += sizeof (guint32);
+
+  return TRUE;
+}
+
+static gboolean
+gimp_tag_cache_read_uint64 (const guchar **data,
+                            const guchar  *end,
+                            guint64       *value)
+{
+  if ((gsize) (end - *data) < sizeof (guint64))
+    return FALSE;
+
+  memcpy (value, *data, sizeof (guint64));
+  *value = GUINT64_FROM_LE (*value);
+  *data += sizeof (guint64);
+
+  return TRUE;
+}
+
+static gboolean
+gimp_tag_cache_read_string (const guchar **data,
+                            const guchar  *end,
+                            const gchar  **string)
+{
+  guint32 len;
+
+  if (! gimp_tag_cache_read_uint32 (data, end, &len) ||
+      len < 1 || (gsize) (end - *data) < len || (*data)[len - 1] != '\0')
+    return FALSE;
+
+  *string = (const gchar *) *data;
+  *data += len;
+
+  return TRUE;
+}
+
+static gboolean
+gimp_tag_cache_load_binary (GArray *records,
+                            GFile  *xml_file)
+{
+  GFile        *file;
+  gchar        *contents;
+  gsize         length;
+  const guchar *data;
+  const guchar *end;
+  guint64       xml_mtime;
+  guint64       xml_size;
+  guint64       mtime;
+  guint64       size;
+  guint32       version;
+  guint32       n_records = 0;
+  guint         first = records->len;
+  gboolean      success;
+  gint          i;
+
+  if (! gimp_tag_cache_query_file (xml_file, &xml_mtime, &xml_size))
+    return FALSE;
+
+  file = gimp_directory_file (GIMP_TAG_CACHE_BINARY_FILE, NULL);
+
+  success = g_file_load_contents (file, NULL, &contents, &length, NULL, NULL);
+
+  g_object_unref (file);
+
+  if (! success)
+    return FALSE;
+
+  data = (const guchar *) contents;
+  end  = data + length;
+
+  success = (length >= strlen (GIMP_TAG_CACHE_BINARY_MAGIC) &&
+             ! memcmp (data, GIMP_TAG_CACHE_BINARY_MAGIC,
+                       strlen (GIMP_TAG_CACHE_BINARY_MAGIC)));
+
+  if (success)
+    {
+      data += strlen (GIMP_TAG_CACHE_BINARY_MAGIC);
+
+      success = (gimp_tag_cache_read_uint32 (&data, end, &version)   &&
+                 version == GIMP_TAG_CACHE_BINARY_VERSION           &&
+                 gimp_tag_cache_read_uint64 (&data, end, &mtime)     &&
+                 gimp_tag_cache_read_uint64 (&data, end, &size)      &&
+                 mtime == xml_mtime && size == xml_size             &&
+                 gimp_tag_cache_read_uint32 (&data, end, &n_records));
+    }
+
+  for (i = 0; success && i < n_records; i++)
+    {
+      GimpTagCacheRecord  rec = { 0, };
+      const gchar        *identifier;
+      const gchar        *checksum;
+      guint32             n_tags;
+      gint                j;
+
+      success = (gimp_tag_cache_read_string (&data, end, &identifier) &&
+                 gimp_tag_cache_read_string (&data, end, &checksum)   &&
+                 gimp_tag_cache_read_uint32 (&data, end, &n_tags)     &&
+                 *identifier);
+
+      if (! success)
+        break;
+
+      rec.identifier = g_quark_from_string (identifier);
+      rec.checksum   = *checksum ? g_quark_from_string (checksum) : 0;
+
+      for (j = 0; success && j < n_tags; j++)
+        {
+          const gchar *name;
+
+          success = gimp_tag_cache_read_string (&data, end, &name);
+
+          if (success)
+            {
+              GimpTag *tag = gimp_tag_new (name);
+
+              if (tag)
+                rec.tags = g_list_prepend (rec.tags, tag);
+            }
+        }
+
+      rec.tags = g_list_reverse (rec.tags);
+
+      g_array_append_val (records, rec);
+    }
+
+  if (! success)
+    {
+      /*  drop what was read, tags.xml is parsed instead  */
+      for (i = first; i < records->len; i++)
+        {
+          GimpTagCacheRecord *rec = &g_array_index (records,
+                                                    GimpTagCacheRecord, i);
+
+          g_list_free_full (rec->tags, (GDestroyNotify) g_object_unref);
+        }
+
+      g_array_set_size (records, first);
+    }
+
+  g_free (contents);
+
+  return success;
+}
+
 static  void
 gimp_tag_cache_load_start_element (GMarkupParseContext *context,
                                    const gchar         *element_name,
@@ -32,6 +32,23 @@
 #include "gimptempbuf.h"
 
 
+/*  the data of temp bufs up to POOL_MAX_SIZE bytes is allocated in size
+ *  classes of a quarter octave each, starting at POOL_MIN_SIZE, and kept
+ *  on per-class free lists when released, so that the masks and paint
+ *  buffers which are created for every dab can reuse their storage
+ *  instead of going through the allocator each time.
+ */
+#define POOL_MIN_SHIFT      6
+#define POOL_MAX_SHIFT      22
+#define POOL_MIN_SIZE       (1 << POOL_MIN_SHIFT)
+#define POOL_MAX_SIZE       (1 << POOL_MAX_SHIFT)
+#define POOL_N_CLASSES      (1 + 4 * (POOL_MAX_SHIFT - POOL_MIN_SHIFT))
+#define POOL_MAX_PER_CLASS  16
+#define POOL_MAX_CACHED     (32 << 20)
+
+#define POOL_NO_CLASS       (-1)
+
+
 struct _GimpTempBuf
 {
   gint        ref_count;
@@ -39,9 +56,141 @@ struct _GimpTempBuf
   gint        height;
   const Babl *format;
   guchar     *data;
+  gsize       alloc_size;
+  gint        size_class;
 };
 
 
+typedef struct
+{
+  GSList *blocks;
+  gint    n_blocks;
+} GimpTempBufPoolClass;
+
+
+static gint     gimp_temp_buf_pool_get_class (gsize   size,
+                                              gsize  *alloc_size);
+static guchar * gimp_temp_buf_pool_alloc     (gsize   size,
+                                              gsize  *alloc_size,
+                                              gint   *size_class);
+static void     gimp_temp_buf_pool_free      (guchar *data,
+                                              gsize   alloc_size,
+                                              gint    size_class);
+
+
+static GMutex               pool_mutex;
+static GimpTempBufPoolClass pool_classes[POOL_N_CLASSES];
+static gsize                pool_cached_size = 0;
+static gsize                pool_live_size   = 0;
+
+
+/*  private functions  */
+
+static gint
+gimp_temp_buf_pool_get_class (gsize  size,
+                              gsize *alloc_size)
+{
+  gsize n;
+  gsize step;
+  gint  shift;
+
+  if (size <= POOL_MIN_SIZE)
+    {
+      *alloc_size = POOL_MIN_SIZE;
+
+      return 0;
+    }
+
+  if (size > POOL_MAX_SIZE)
+    {
+      *alloc_size = size;
+
+      return POOL_NO_CLASS;
+    }
+
+  /*  2^shift <= n < 2^(shift + 1), rounded up to a quarter of 2^shift  */
+  n     = size - 1;
+  shift = g_bit_storage (n) - 1;
+  step  = (gsize) 1 << (shift - 2);
+
+  *alloc_size = (n / step + 1) * step;
+
+  return 1 + 4 * (shift - POOL_MIN_SHIFT) + (n / step - 4);
+}
+
+static guchar *
+gimp_temp_buf_pool_alloc (gsize  size,
+                          gsize *alloc_size,
+                          gint  *size_class)
+{
+  guchar *data = NULL;
+
+  *size_class = gimp_temp_buf_pool_get_class (size, alloc_size);
+
+  g_mutex_lock (&pool_mutex);
+
+  if (*size_class != POOL_NO_CLASS)
+    {
+      GimpTempBufPoolClass *pool_class = &pool_classes[*size_class];
+
+      if (pool_class->blocks)
+        {
+          data = pool_class->blocks->data;
+
+          pool_class->blocks = g_slist_delete_link (pool_class->blocks,
+                                                    pool_class->blocks);
+          pool_class->n_blocks--;
+
+          pool_cached_size -= *alloc_size;
+        }
+    }
+
+  pool_live_size += *alloc_size;
+
+  g_mutex_unlock (&pool_mutex);
+
+  /*  gegl_malloc() returns storage aligned for SIMD access, and all
+   *  size classes are multiples of that alignment
+   */
+  if (! data)
+    data = gegl_malloc (*alloc_size);
+
+  return data;
+}
+
+static void
+gimp_temp_buf_pool_free (guchar *data,
+                         gsize   alloc_size,
+                         gint    size_class)
+{
+  g_mutex_lock (&pool_mutex);
+
+  pool_live_size -= alloc_size;
+
+  if (size_class != POOL_NO_CLASS                                &&
+      pool_classes[size_class].n_blocks < POOL_MAX_PER_CLASS     &&
+      pool_cached_size + alloc_size     <= POOL_MAX_CACHED)
+    {
+      GimpTempBufPoolClass *pool_class = &pool_classes[size_class];
+
+      pool_class->blocks = g_slist_prepend (pool_class->blocks, data);
+      pool_class->n_blocks++;
+
+      pool_cached_size += alloc_size;
+
+      data = NULL;
+    }
+
+  g_mutex_unlock (&pool_mutex);
+
+  if (data)
+    gegl_free (data);
+}
+
+
+/*  public functions  */
+
+
 GimpTempBuf *
 gimp_temp_buf_new (gint        width,
                    gint        height,
@@ -58,8 +207,10 @@ gimp_temp_buf_new (gint        width,
   temp->width     = width;
   temp->height    = height;
   temp->format    = format;
-  temp->data      = gegl_malloc (width * height *
-                                 babl_format_get_bytes_per_pixel (format));
+  temp->data      = gimp_temp_buf_pool_alloc ((gsize) width * height *
+                                              babl_format_get_bytes_per_pixel (format),
+                                              &temp->alloc_size,
+                                              &temp->size_class);
 
   return temp;
 }
@@ -132,7 +283,7 @@ gimp_temp_buf_ref (GimpTempBuf *buf)
 {
   g_return_val_if_fail (buf != NULL, NULL);
 
-  buf->ref_count++;
+  g_atomic_int_inc (&buf->ref_count);
 
   return buf;
 }
@@ -143,12 +294,10 @@ gimp_temp_buf_unref (GimpTempBuf *buf)
   g_return_if_fail (buf != NULL);
   g_return_if_fail (buf->ref_count > 0);
 
-  buf->ref_count--;
-
-  if (buf->ref_count < 1)
+  if (g_atomic_int_dec_and_test (&buf->ref_count))
     {
       if (buf->data)
-        gegl_free (buf->data);
+        gimp_temp_buf_pool_free (buf->data, buf->alloc_size, buf->size_class);
 
       g_slice_free (GimpTempBuf, buf);
     }
@@ -261,11 +410,49 @@ gsize
 gimp_temp_buf_get_memsize (const GimpTempBuf *buf)
 {
   if (buf)
-    return (sizeof (GimpTempBuf) + gimp_temp_buf_get_data_size (buf));
+    return (sizeof (GimpTempBuf) + buf->alloc_size);
 
   return 0;
 }
 
+void
+gimp_temp_buf_get_pool_stats (gsize *live_size,
+                              gsize *cached_size)
+{
+  g_mutex_lock (&pool_mutex);
+
+  if (live_size)
+    *live_size = pool_live_size;
+
+  if (cached_size)
+    *cached_size = pool_cached_size;
+
+  g_mutex_unlock (&pool_mutex);
+}
+
+void
+gimp_temp_buf_clear_pool (void)
+{
+  GSList *blocks = NULL;
+  gint    i;
+
+  g_mutex_lock (&pool_mutex);
+
+  for (i = 0; i < POOL_N_CLASSES; i++)
+    {
+      blocks = g_slist_concat (pool_classes[i].blocks, blocks);
+
+      pool_classes[i].blocks   = NULL;
+      pool_classes[i].n_blocks = 0;
+    }
+
+  pool_cached_size = 0;
+
+  g_mutex_unlock (&pool_mutex);
+
+  g_slist_free_full (blocks, (GDestroyNotify) gegl_free);
+}
+
 GeglBuffer  *
 gimp_temp_buf_create_buffer (GimpTempBuf *temp_buf)
 {
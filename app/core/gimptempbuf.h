@@ -47,6 +47,10 @@ guchar      * gimp_temp_buf_data_clear      (GimpTempBuf       *buf);
 
 gsize         gimp_temp_buf_get_memsize     (const GimpTempBuf *buf);
 
+void          gimp_temp_buf_get_pool_stats  (gsize             *live_size,
+                                             gsize             *cached_size);
+void          gimp_temp_buf_clear_pool      (void);
+
 GeglBuffer  * gimp_temp_buf_create_buffer   (GimpTempBuf       *temp_buf) G_GNUC_WARN_UNUSED_RESULT;
 GdkPixbuf   * gimp_temp_buf_create_pixbuf   (GimpTempBuf       *temp_buf) G_GNUC_WARN_UNUSED_RESULT;
 
@@ -89,6 +89,9 @@ static void          gimp_undo_real_pop            (GimpUndo            *undo,
                                                     GimpUndoAccumulator *accum);
 static void          gimp_undo_real_free           (GimpUndo            *undo,
                                                     GimpUndoMode         undo_mode);
+static gint64        gimp_undo_real_spill          (GimpUndo            *undo,
+                                                    const gchar         *swap_dir);
+static gint64   gimp_undo_real_get_spilled_size    (GimpUndo            *undo);
 
 static gboolean      gimp_undo_create_preview_idle (gpointer             data);
 static void       gimp_undo_create_preview_private (GimpUndo            *undo,
@@ -143,6 +146,8 @@ gimp_undo_class_init (GimpUndoClass *klass)
 
   klass->pop                        = gimp_undo_real_pop;
   klass->free                       = gimp_undo_real_free;
+  klass->spill                      = gimp_undo_real_spill;
+  klass->get_spilled_size           = gimp_undo_real_get_spilled_size;
 
   g_object_class_install_property (object_class, PROP_IMAGE,
                                    g_param_spec_object ("image", NULL, NULL,
@@ -350,6 +355,19 @@ gimp_undo_real_free (GimpUndo     *undo,
 {
 }
 
+static gint64
+gimp_undo_real_spill (GimpUndo    *undo,
+                      const gchar *swap_dir)
+{
+  return 0;
+}
+
+static gint64
+gimp_undo_real_get_spilled_size (GimpUndo *undo)
+{
+  return 0;
+}
+
 void
 gimp_undo_pop (GimpUndo            *undo,
                GimpUndoMode         undo_mode,
@@ -384,6 +402,42 @@ gimp_undo_free (GimpUndo     *undo,
   g_signal_emit (undo, undo_signals[FREE], 0, undo_mode);
 }
 
+/**
+ * gimp_undo_spill:
+ * @undo:     a #GimpUndo
+ * @swap_dir: the directory to write swap files to
+ *
+ * Compresses the data of @undo and moves it out of memory, into a
+ * file in @swap_dir. The data is read back when @undo is popped.
+ *
+ * Return value: the number of bytes of memory that were freed.
+ **/
+gint64
+gimp_undo_spill (GimpUndo    *undo,
+                 const gchar *swap_dir)
+{
+  g_return_val_if_fail (GIMP_IS_UNDO (undo), 0);
+  g_return_val_if_fail (swap_dir != NULL, 0);
+
+  return GIMP_UNDO_GET_CLASS (undo)->spill (undo, swap_dir);
+}
+
+/**
+ * gimp_undo_get_spilled_size:
+ * @undo: a #GimpUndo
+ *
+ * Return value: the size of the swap files that hold @undo's data,
+ *               see gimp_undo_spill(). Unlike gimp_object_get_memsize(),
+ *               this is disk space, not memory.
+ **/
+gint64
+gimp_undo_get_spilled_size (GimpUndo *undo)
+{
+  g_return_val_if_fail (GIMP_IS_UNDO (undo), 0);
+
+  return GIMP_UNDO_GET_CLASS (undo)->get_spilled_size (undo);
+}
+
 typedef struct _GimpUndoIdle GimpUndoIdle;
 
 struct _GimpUndoIdle
@@ -28,16 +28,19 @@
 #include "gimpundostack.h"
 
 
-static void    gimp_undo_stack_finalize    (GObject             *object);
+static void    gimp_undo_stack_finalize         (GObject             *object);
 
-static gint64  gimp_undo_stack_get_memsize (GimpObject          *object,
-                                            gint64              *gui_size);
+static gint64  gimp_undo_stack_get_memsize      (GimpObject          *object,
+                                                 gint64              *gui_size);
 
-static void    gimp_undo_stack_pop         (GimpUndo            *undo,
-                                            GimpUndoMode         undo_mode,
-                                            GimpUndoAccumulator *accum);
-static void    gimp_undo_stack_free        (GimpUndo            *undo,
-                                            GimpUndoMode         undo_mode);
+static void    gimp_undo_stack_pop              (GimpUndo            *undo,
+                                                 GimpUndoMode         undo_mode,
+                                                 GimpUndoAccumulator *accum);
+static void    gimp_undo_stack_free             (GimpUndo            *undo,
+                                                 GimpUndoMode         undo_mode);
+static gint64  gimp_undo_stack_spill            (GimpUndo            *undo,
+                                                 const gchar         *swap_dir);
+static gint64  gimp_undo_stack_get_spilled_size (GimpUndo            *undo);
 
 
 G_DEFINE_TYPE (GimpUndoStack, gimp_undo_stack, GIMP_TYPE_UNDO)
@@ -58,6 +61,8 @@ gimp_undo_stack_class_init (GimpUndoStackClass *klass)
 
   undo_class->pop                = gimp_undo_stack_pop;
   undo_class->free               = gimp_undo_stack_free;
+  undo_class->spill              = gimp_undo_stack_spill;
+  undo_class->get_spilled_size   = gimp_undo_stack_get_spilled_size;
 }
 
 static void
@@ -131,6 +136,45 @@ gimp_undo_stack_free (GimpUndo     *undo,
   gimp_container_clear (stack->undos);
 }
 
+static gint64
+gimp_undo_stack_spill (GimpUndo    *undo,
+                       const gchar *swap_dir)
+{
+  GimpUndoStack *stack = GIMP_UNDO_STACK (undo);
+  GList         *list;
+  gint64         freed = 0;
+
+  for (list = GIMP_LIST (stack->undos)->list;
+       list;
+       list = g_list_next (list))
+    {
+      GimpUndo *child = list->data;
+
+      freed += gimp_undo_spill (child, swap_dir);
+    }
+
+  return freed;
+}
+
+static gint64
+gimp_undo_stack_get_spilled_size (GimpUndo *undo)
+{
+  GimpUndoStack *stack = GIMP_UNDO_STACK (undo);
+  GList         *list;
+  gint64         size  = 0;
+
+  for (list = GIMP_LIST (stack->undos)->list;
+       list;
+       list = g_list_next (list))
+    {
+      GimpUndo *child = list->data;
+
+      size += gimp_undo_get_spilled_size (child);
+    }
+
+  return size;
+}
+
 GimpUndoStack *
 gimp_undo_stack_new (GimpImage *image)
 {
@@ -48,6 +48,7 @@
 #include "widgets/gimphistogrameditor.h"
 #include "widgets/gimpimageview.h"
 #include "widgets/gimplayertreeview.h"
+#include "widgets/gimpmemoryeditor.h"
 #include "widgets/gimpmenudock.h"
 #include "widgets/gimppaletteeditor.h"
 #include "widgets/gimppatternfactoryview.h"
@@ -334,6 +335,15 @@ dialogs_error_console_new (GimpDialogFactory *factory,
                                  gimp_dialog_factory_get_menu_factory (factory));
 }
 
+GtkWidget *
+dialogs_memory_editor_new (GimpDialogFactory *factory,
+                           GimpContext       *context,
+                           GimpUIManager     *ui_manager,
+                           gint               view_size)
+{
+  return gimp_memory_editor_new (context->gimp);
+}
+
 GtkWidget *
 dialogs_cursor_view_new (GimpDialogFactory *factory,
                          GimpContext       *context,
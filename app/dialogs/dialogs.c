@@ -315,6 +315,10 @@ static const GimpDialogFactoryEntry entries[] =
             N_("Errors"), N_("Error Console"), GIMP_STOCK_WARNING,
             GIMP_HELP_ERRORS_DIALOG,
             dialogs_error_console_new, 0, TRUE),
+  DOCKABLE ("gimp-memory-editor",
+            N_("Memory"), N_("Memory Usage"), GIMP_STOCK_INFO,
+            GIMP_HELP_MEMORY_DIALOG,
+            dialogs_memory_editor_new, 0, TRUE),
   DOCKABLE ("gimp-cursor-view",
             N_("Pointer"), N_("Pointer Information"), GIMP_STOCK_CURSOR,
             GIMP_HELP_POINTER_INFO_DIALOG,
@@ -1316,9 +1316,9 @@ prefs_dialog_new (Gimp       *gimp,
                            GTK_CONTAINER (vbox), FALSE);
 
 #ifdef ENABLE_MP
-  table = prefs_table_new (5, GTK_CONTAINER (vbox2));
+  table = prefs_table_new (6, GTK_CONTAINER (vbox2));
 #else
-  table = prefs_table_new (4, GTK_CONTAINER (vbox2));
+  table = prefs_table_new (5, GTK_CONTAINER (vbox2));
 #endif /* ENABLE_MP */
 
   prefs_spin_button_add (object, "undo-levels", 1.0, 5.0, 0,
@@ -1327,19 +1327,26 @@ prefs_dialog_new (Gimp       *gimp,
   prefs_memsize_entry_add (object, "undo-size",
                            _("Maximum undo _memory:"),
                            GTK_TABLE (table), 1, size_group);
+  prefs_memsize_entry_add (object, "undo-swap-size",
+                           _("Maximum undo _swap:"),
+                           GTK_TABLE (table), 2, size_group);
   prefs_memsize_entry_add (object, "tile-cache-size",
                            _("Tile cache _size:"),
-                           GTK_TABLE (table), 2, size_group);
+                           GTK_TABLE (table), 3, size_group);
   prefs_memsize_entry_add (object, "max-new-image-size",
                            _("Maximum _new image size:"),
-                           GTK_TABLE (table), 3, size_group);
+                           GTK_TABLE (table), 4, size_group);
 
 #ifdef ENABLE_MP
   prefs_spin_button_add (object, "num-processors", 1.0, 4.0, 0,
                          _("Number of _processors to use:"),
-                         GTK_TABLE (table), 4, size_group);
+                         GTK_TABLE (table), 5, size_group);
 #endif /* ENABLE_MP */
 
+  prefs_check_button_add (object, "tile-cache-adaptive",
+                          _("_Adapt tile cache to available memory"),
+                          GTK_BOX (vbox2));
+
   /*  Hardware Acceleration  */
   vbox2 = prefs_frame_new (_("Hardware Acceleration"), GTK_CONTAINER (vbox),
                            FALSE);
@@ -1371,6 +1378,10 @@ prefs_dialog_new (Gimp       *gimp,
                           _("Keep record of used files in the Recent Documents list"),
                           GTK_BOX (vbox2));
 
+  prefs_check_button_add (object, "xcf-lazy-load",
+                          _("_Read XCF pixels only when they are needed"),
+                          GTK_BOX (vbox2));
+
 
   /***************/
   /*  Interface  */
@@ -34,6 +34,7 @@
 
 #include "gimpcanvasboundary.h"
 #include "gimpdisplayshell.h"
+#include "gimpdisplayshell-transform.h"
 
 
 enum
@@ -247,19 +248,12 @@ gimp_canvas_boundary_transform (GimpCanvasItem *item,
     }
   else
     {
+      gimp_display_shell_zoom_segments (gimp_canvas_item_get_shell (item),
+                                        private->segs, segs, private->n_segs,
+                                        private->offset_x, private->offset_y);
+
       for (i = 0; i < private->n_segs; i++)
         {
-          gimp_canvas_item_transform_xy (item,
-                                         private->segs[i].x1 + private->offset_x,
-                                         private->segs[i].y1 + private->offset_y,
-                                         &segs[i].x1,
-                                         &segs[i].y1);
-          gimp_canvas_item_transform_xy (item,
-                                         private->segs[i].x2 + private->offset_x,
-                                         private->segs[i].y2 + private->offset_y,
-                                         &segs[i].x2,
-                                         &segs[i].y2);
-
           /*  If this segment is a closing segment && the segments lie inside
            *  the region, OR if this is an opening segment and the segments
            *  lie outside the region...
@@ -37,7 +37,8 @@
 enum
 {
   PROP_0,
-  PROP_BUFFER
+  PROP_BUFFER,
+  PROP_BUFFER_SCALE
 };
 
 
@@ -46,6 +47,7 @@ typedef struct _GimpCanvasBufferPreviewPrivate GimpCanvasBufferPreviewPrivate;
 struct _GimpCanvasBufferPreviewPrivate
 {
   GeglBuffer *buffer;
+  gdouble     buffer_scale;
 };
 
 
@@ -97,12 +99,20 @@ gimp_canvas_buffer_preview_class_init (GimpCanvasBufferPreviewClass *klass)
                                                         GEGL_TYPE_BUFFER,
                                                         GIMP_PARAM_READWRITE));
 
+  /*  the buffer's resolution relative to the image's  */
+  g_object_class_install_property (object_class, PROP_BUFFER_SCALE,
+                                   g_param_spec_double ("buffer-scale",
+                                                        NULL, NULL,
+                                                        0.0001, 1.0, 1.0,
+                                                        GIMP_PARAM_READWRITE));
+
   g_type_class_add_private (klass, sizeof (GimpCanvasBufferPreviewPrivate));
 }
 
 static void
 gimp_canvas_buffer_preview_init (GimpCanvasBufferPreview *transform_preview)
 {
+  GET_PRIVATE (transform_preview)->buffer_scale = 1.0;
 }
 
 static void
@@ -119,6 +129,10 @@ gimp_canvas_buffer_preview_set_property (GObject      *object,
       private->buffer = g_value_get_object (value); /* don't ref */
       break;
 
+    case PROP_BUFFER_SCALE:
+      private->buffer_scale = g_value_get_double (value);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -139,6 +153,10 @@ gimp_canvas_buffer_preview_get_property (GObject    *object,
       g_value_set_object (value, private->buffer);
       break;
 
+    case PROP_BUFFER_SCALE:
+      g_value_set_double (value, private->buffer_scale);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -151,6 +169,7 @@ gimp_canvas_buffer_preview_draw (GimpCanvasItem *item,
 {
   GimpDisplayShell      *shell  = gimp_canvas_item_get_shell (item);
   GeglBuffer            *buffer = GET_PRIVATE (item)->buffer;
+  gdouble                scale  = GET_PRIVATE (item)->buffer_scale;
   cairo_surface_t       *area;
   guchar                *data;
   cairo_rectangle_int_t  rectangle;
@@ -177,7 +196,7 @@ gimp_canvas_buffer_preview_draw (GimpCanvasItem *item,
                                    (viewport_offset_y < 0 ? 0 : viewport_offset_y),
                                    rectangle.width,
                                    rectangle.height),
-                   shell->scale_x,
+                   shell->scale_x / scale,
                    babl_format ("cairo-ARGB32"),
                    data,
                    cairo_image_surface_get_stride (area),
@@ -201,6 +220,7 @@ gimp_canvas_buffer_preview_compute_bounds (GimpCanvasItem        *item,
 {
   GimpDisplayShell *shell  = gimp_canvas_item_get_shell (item);
   GeglBuffer       *buffer = GET_PRIVATE (item)->buffer;
+  gdouble           scale  = GET_PRIVATE (item)->buffer_scale;
   gint              x_from, x_to;
   gint              y_from, y_to;
   gint              viewport_offset_x, viewport_offset_y;
@@ -221,11 +241,11 @@ gimp_canvas_buffer_preview_compute_bounds (GimpCanvasItem        *item,
   x_from = (viewport_offset_x < 0 ? -viewport_offset_x : 0);
   y_from = (viewport_offset_y < 0 ? -viewport_offset_y : 0);
 
-  x_to = width * shell->scale_x - viewport_offset_x;
+  x_to = width * shell->scale_x / scale - viewport_offset_x;
   if (x_to > viewport_width)
     x_to = viewport_width;
 
-  y_to = height * shell->scale_y - viewport_offset_y;
+  y_to = height * shell->scale_y / scale - viewport_offset_y;
   if (y_to > viewport_height)
     y_to = viewport_height;
 
@@ -247,13 +267,15 @@ gimp_canvas_buffer_preview_get_extents (GimpCanvasItem *item)
 
 GimpCanvasItem *
 gimp_canvas_buffer_preview_new (GimpDisplayShell  *shell,
-                                GeglBuffer        *buffer)
+                                GeglBuffer        *buffer,
+                                gdouble            buffer_scale)
 {
   g_return_val_if_fail (GIMP_IS_DISPLAY_SHELL (shell), NULL);
   g_return_val_if_fail (GEGL_IS_BUFFER (buffer), NULL);
 
   return g_object_new (GIMP_TYPE_CANVAS_BUFFER_PREVIEW,
-                       "shell",       shell,
-                       "buffer",      buffer,
+                       "shell",        shell,
+                       "buffer",       buffer,
+                       "buffer-scale", buffer_scale,
                        NULL);
 }
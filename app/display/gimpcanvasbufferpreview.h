@@ -50,7 +50,8 @@ struct _GimpCanvasBufferPreviewClass
 GType            gimp_canvas_buffer_preview_get_type (void) G_GNUC_CONST;
 
 GimpCanvasItem * gimp_canvas_buffer_preview_new      (GimpDisplayShell  *shell,
-                                                      GeglBuffer        *buffer);
+                                                      GeglBuffer        *buffer,
+                                                      gdouble            buffer_scale);
 
 
 #endif /* __GIMP_CANVAS_BUFFER_PREVIEW_H__ */
@@ -35,6 +35,7 @@
 #include "gimpcanvas-style.h"
 #include "gimpcanvasgrid.h"
 #include "gimpdisplayshell.h"
+#include "gimpdisplayshell-transform.h"
 
 
 enum
@@ -192,7 +193,10 @@ gimp_canvas_grid_draw (GimpCanvasItem *item,
   gdouble                xspacing, yspacing;
   gdouble                xoffset, yoffset;
   gdouble                x, y;
+  gdouble                x_start, y_start;
+  gdouble                x_end, y_end;
   gdouble                dx1, dy1, dx2, dy2;
+  gdouble                ix1, iy1, ix2, iy2;
   gint                   x0, x1, x2, x3;
   gint                   y0, y1, y2, y3;
   gint                   x_real, y_real;
@@ -229,24 +233,33 @@ gimp_canvas_grid_draw (GimpCanvasItem *item,
   while (yoffset > 0)
     yoffset -= yspacing;
 
+  /*  only walk the grid lines that can touch the exposed area,
+   *  instead of all of the image's lines to cull them one by one
+   */
+  gimp_display_shell_unzoom_xy_f (shell,
+                                  x1 - CROSSHAIR - 1, y1 - CROSSHAIR - 1,
+                                  &ix1, &iy1);
+  gimp_display_shell_unzoom_xy_f (shell,
+                                  x2 + CROSSHAIR + 1, y2 + CROSSHAIR + 1,
+                                  &ix2, &iy2);
+
+  x_start = xoffset + ceil ((MAX (ix1, 0.0) - xoffset) / xspacing) * xspacing;
+  y_start = yoffset + ceil ((MAX (iy1, 0.0) - yoffset) / yspacing) * yspacing;
+  x_end   = MIN (ix2, width);
+  y_end   = MIN (iy2, height);
+
   switch (gimp_grid_get_style (private->grid))
     {
     case GIMP_GRID_DOTS:
-      for (x = xoffset; x <= width; x += xspacing)
+      for (x = x_start; x <= x_end; x += xspacing)
         {
-          if (x < 0)
-            continue;
-
           gimp_canvas_item_transform_xy (item, x, 0, &x_real, &y_real);
 
           if (x_real < x1 || x_real >= x2)
             continue;
 
-          for (y = yoffset; y <= height; y += yspacing)
+          for (y = y_start; y <= y_end; y += yspacing)
             {
-              if (y < 0)
-                continue;
-
               gimp_canvas_item_transform_xy (item, x, y, &x_real, &y_real);
 
               if (y_real >= y1 && y_real < y2)
@@ -259,21 +272,15 @@ gimp_canvas_grid_draw (GimpCanvasItem *item,
       break;
 
     case GIMP_GRID_INTERSECTIONS:
-      for (x = xoffset; x <= width; x += xspacing)
+      for (x = x_start; x <= x_end; x += xspacing)
         {
-          if (x < 0)
-            continue;
-
           gimp_canvas_item_transform_xy (item, x, 0, &x_real, &y_real);
 
           if (x_real + CROSSHAIR < x1 || x_real - CROSSHAIR >= x2)
             continue;
 
-          for (y = yoffset; y <= height; y += yspacing)
+          for (y = y_start; y <= y_end; y += yspacing)
             {
-              if (y < 0)
-                continue;
-
               gimp_canvas_item_transform_xy (item, x, y, &x_real, &y_real);
 
               if (y_real + CROSSHAIR < y1 || y_real - CROSSHAIR >= y2)
@@ -312,11 +319,8 @@ gimp_canvas_grid_draw (GimpCanvasItem *item,
       gimp_canvas_item_transform_xy (item, 0, 0, &x0, &y0);
       gimp_canvas_item_transform_xy (item, width, height, &x3, &y3);
 
-      for (x = xoffset; x < width; x += xspacing)
+      for (x = x_start; x < width && x <= x_end; x += xspacing)
         {
-          if (x < 0)
-            continue;
-
           gimp_canvas_item_transform_xy (item, x, 0, &x_real, &y_real);
 
           if (x_real >= x1 && x_real < x2)
@@ -326,11 +330,8 @@ gimp_canvas_grid_draw (GimpCanvasItem *item,
             }
         }
 
-      for (y = yoffset; y < height; y += yspacing)
+      for (y = y_start; y < height && y <= y_end; y += yspacing)
         {
-          if (y < 0)
-            continue;
-
           gimp_canvas_item_transform_xy (item, 0, y, &x_real, &y_real);
 
           if (y_real >= y1 && y_real < y2)
@@ -44,7 +44,7 @@ typedef struct _GimpCanvasGroupPrivate GimpCanvasGroupPrivate;
 
 struct _GimpCanvasGroupPrivate
 {
-  GList    *items;
+  GQueue    items;
   gboolean  group_stroking;
   gboolean  group_filling;
 };
@@ -115,6 +115,9 @@ gimp_canvas_group_class_init (GimpCanvasGroupClass *klass)
 static void
 gimp_canvas_group_init (GimpCanvasGroup *group)
 {
+  GimpCanvasGroupPrivate *private = GET_PRIVATE (group);
+
+  g_queue_init (&private->items);
 }
 
 static void
@@ -122,10 +125,10 @@ gimp_canvas_group_dispose (GObject *object)
 {
   GimpCanvasGroupPrivate *private = GET_PRIVATE (object);
 
-  if (private->items)
+  if (private->items.head)
     {
-      g_list_free_full (private->items, (GDestroyNotify) g_object_unref);
-      private->items = NULL;
+      g_queue_foreach (&private->items, (GFunc) g_object_unref, NULL);
+      g_queue_clear (&private->items);
     }
 
   G_OBJECT_CLASS (parent_class)->dispose (object);
@@ -183,12 +186,17 @@ gimp_canvas_group_draw (GimpCanvasItem *item,
 {
   GimpCanvasGroupPrivate *private = GET_PRIVATE (item);
   GList                  *list;
+  gdouble                 x1, y1, x2, y2;
+
+  /*  skip the items that are entirely outside the exposed area  */
+  cairo_clip_extents (cr, &x1, &y1, &x2, &y2);
 
-  for (list = private->items; list; list = g_list_next (list))
+  for (list = private->items.head; list; list = g_list_next (list))
     {
       GimpCanvasItem *sub_item = list->data;
 
-      gimp_canvas_item_draw (sub_item, cr);
+      if (_gimp_canvas_item_intersects (sub_item, x1, y1, x2, y2))
+        gimp_canvas_item_draw (sub_item, cr);
     }
 
   if (private->group_stroking)
@@ -205,7 +213,7 @@ gimp_canvas_group_get_extents (GimpCanvasItem *item)
   cairo_region_t         *region  = NULL;
   GList                  *list;
 
-  for (list = private->items; list; list = g_list_next (list))
+  for (list = private->items.head; list; list = g_list_next (list))
     {
       GimpCanvasItem *sub_item   = list->data;
       cairo_region_t *sub_region = gimp_canvas_item_get_extents (sub_item);
@@ -232,7 +240,7 @@ gimp_canvas_group_hit (GimpCanvasItem *item,
   GimpCanvasGroupPrivate *private = GET_PRIVATE (item);
   GList                  *list;
 
-  for (list = private->items; list; list = g_list_next (list))
+  for (list = private->items.head; list; list = g_list_next (list))
     {
       if (gimp_canvas_item_hit (list->data, x, y))
         return TRUE;
@@ -246,6 +254,8 @@ gimp_canvas_group_child_update (GimpCanvasItem  *item,
                                 cairo_region_t  *region,
                                 GimpCanvasGroup *group)
 {
+  _gimp_canvas_item_invalidate_extents (GIMP_CANVAS_ITEM (group));
+
   if (_gimp_canvas_item_needs_update (GIMP_CANVAS_ITEM (group)))
     _gimp_canvas_item_update (GIMP_CANVAS_ITEM (group), region);
 }
@@ -281,7 +291,10 @@ gimp_canvas_group_add_item (GimpCanvasGroup *group,
   if (private->group_filling)
     gimp_canvas_item_suspend_filling (item);
 
-  private->items = g_list_append (private->items, g_object_ref (item));
+  /*  a queue, because appending to a GList gets slow with the
+   *  thousands of handles some tools add
+   */
+  g_queue_push_tail (&private->items, g_object_ref (item));
 
   if (_gimp_canvas_item_needs_update (GIMP_CANVAS_ITEM (group)))
     {
@@ -310,9 +323,9 @@ gimp_canvas_group_remove_item (GimpCanvasGroup *group,
 
   private = GET_PRIVATE (group);
 
-  g_return_if_fail (g_list_find (private->items, item));
+  g_return_if_fail (g_queue_find (&private->items, item));
 
-  private->items = g_list_remove (private->items, item);
+  g_queue_remove (&private->items, item);
 
   if (private->group_stroking)
     gimp_canvas_item_resume_stroking (item);
@@ -358,7 +371,7 @@ gimp_canvas_group_set_group_stroking (GimpCanvasGroup *group,
                     "group-stroking", group_stroking ? TRUE : FALSE,
                     NULL);
 
-      for (list = private->items; list; list = g_list_next (list))
+      for (list = private->items.head; list; list = g_list_next (list))
         {
           if (private->group_stroking)
             gimp_canvas_item_suspend_stroking (list->data);
@@ -390,7 +403,7 @@ gimp_canvas_group_set_group_filling (GimpCanvasGroup *group,
                     "group-filling", group_filling ? TRUE : FALSE,
                     NULL);
 
-      for (list = private->items; list; list = g_list_next (list))
+      for (list = private->items.head; list; list = g_list_next (list))
         {
           if (private->group_filling)
             gimp_canvas_item_suspend_filling (list->data);
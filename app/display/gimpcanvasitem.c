@@ -64,6 +64,17 @@ struct _GimpCanvasItemPrivate
   gint              suspend_filling;
   gint              change_count;
   cairo_region_t   *change_region;
+
+  /*  bounding box of the extents, for culling while drawing  */
+  gboolean               extents_valid;
+  gboolean               extents_known;
+  cairo_rectangle_int_t  extents;
+  gint                   extents_offset_x;
+  gint                   extents_offset_y;
+  gdouble                extents_scale_x;
+  gdouble                extents_scale_y;
+  gint                   extents_disp_width;
+  gint                   extents_disp_height;
 };
 
 #define GET_PRIVATE(item) \
@@ -177,6 +188,7 @@ gimp_canvas_item_init (GimpCanvasItem *item)
   private->suspend_filling  = 0;
   private->change_count     = 1; /* avoid emissions during construction */
   private->change_region    = NULL;
+  private->extents_valid    = FALSE;
 }
 
 static void
@@ -256,6 +268,8 @@ gimp_canvas_item_dispatch_properties_changed (GObject     *object,
 {
   GimpCanvasItem *item = GIMP_CANVAS_ITEM (object);
 
+  _gimp_canvas_item_invalidate_extents (item);
+
   G_OBJECT_CLASS (parent_class)->dispatch_properties_changed (object,
                                                               n_pspecs,
                                                               pspecs);
@@ -523,6 +537,8 @@ gimp_canvas_item_end_change (GimpCanvasItem *item)
 
   if (private->change_count == 0)
     {
+      _gimp_canvas_item_invalidate_extents (item);
+
       if (g_signal_has_handler_pending (item, item_signals[UPDATE], 0, FALSE))
         {
           cairo_region_t *region = gimp_canvas_item_get_extents (item);
@@ -660,6 +676,8 @@ void
 _gimp_canvas_item_update (GimpCanvasItem *item,
                           cairo_region_t *region)
 {
+  _gimp_canvas_item_invalidate_extents (item);
+
   g_signal_emit (item, item_signals[UPDATE], 0,
                  region);
 }
@@ -673,6 +691,71 @@ _gimp_canvas_item_needs_update (GimpCanvasItem *item)
           g_signal_has_handler_pending (item, item_signals[UPDATE], 0, FALSE));
 }
 
+void
+_gimp_canvas_item_invalidate_extents (GimpCanvasItem *item)
+{
+  GimpCanvasItemPrivate *private = GET_PRIVATE (item);
+
+  private->extents_valid = FALSE;
+}
+
+/*  returns FALSE if the item certainly draws nothing inside the given
+ *  rectangle, in the same coordinates as its extents.  The bounding
+ *  box of the extents is cached until the item changes or the view is
+ *  scrolled, zoomed or resized.
+ */
+gboolean
+_gimp_canvas_item_intersects (GimpCanvasItem *item,
+                              gdouble         x1,
+                              gdouble         y1,
+                              gdouble         x2,
+                              gdouble         y2)
+{
+  GimpCanvasItemPrivate *private = GET_PRIVATE (item);
+  GimpDisplayShell      *shell   = private->shell;
+
+  if (! private->visible)
+    return FALSE;
+
+  if (! private->extents_valid                         ||
+      private->extents_offset_x    != shell->offset_x   ||
+      private->extents_offset_y    != shell->offset_y   ||
+      private->extents_scale_x     != shell->scale_x    ||
+      private->extents_scale_y     != shell->scale_y    ||
+      private->extents_disp_width  != shell->disp_width ||
+      private->extents_disp_height != shell->disp_height)
+    {
+      cairo_region_t *region;
+
+      region = GIMP_CANVAS_ITEM_GET_CLASS (item)->get_extents (item);
+
+      /*  items without extents might still draw something  */
+      private->extents_known = (region != NULL);
+
+      if (region)
+        {
+          cairo_region_get_extents (region, &private->extents);
+          cairo_region_destroy (region);
+        }
+
+      private->extents_offset_x    = shell->offset_x;
+      private->extents_offset_y    = shell->offset_y;
+      private->extents_scale_x     = shell->scale_x;
+      private->extents_scale_y     = shell->scale_y;
+      private->extents_disp_width  = shell->disp_width;
+      private->extents_disp_height = shell->disp_height;
+      private->extents_valid       = TRUE;
+    }
+
+  if (! private->extents_known)
+    return TRUE;
+
+  return (private->extents.x                           < x2 &&
+          private->extents.x + private->extents.width  > x1 &&
+          private->extents.y                           < y2 &&
+          private->extents.y + private->extents.height > y1);
+}
+
 void
 _gimp_canvas_item_stroke (GimpCanvasItem *item,
                           cairo_t        *cr)
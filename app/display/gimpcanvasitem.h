@@ -117,6 +117,13 @@ void             gimp_canvas_item_transform_xy_f   (GimpCanvasItem   *item,
 void             _gimp_canvas_item_update          (GimpCanvasItem   *item,
                                                     cairo_region_t   *region);
 gboolean         _gimp_canvas_item_needs_update    (GimpCanvasItem   *item);
+void             _gimp_canvas_item_invalidate_extents
+                                                   (GimpCanvasItem   *item);
+gboolean         _gimp_canvas_item_intersects      (GimpCanvasItem   *item,
+                                                    gdouble           x1,
+                                                    gdouble           y1,
+                                                    gdouble           x2,
+                                                    gdouble           y2);
 void             _gimp_canvas_item_stroke          (GimpCanvasItem   *item,
                                                     cairo_t          *cr);
 void             _gimp_canvas_item_fill            (GimpCanvasItem   *item,
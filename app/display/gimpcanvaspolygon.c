@@ -32,6 +32,7 @@
 
 #include "gimpcanvaspolygon.h"
 #include "gimpdisplayshell.h"
+#include "gimpdisplayshell-transform.h"
 
 
 enum
@@ -201,14 +202,12 @@ gimp_canvas_polygon_transform (GimpCanvasItem *item,
   GimpCanvasPolygonPrivate *private = GET_PRIVATE (item);
   gint                      i;
 
+  gimp_display_shell_zoom_points (gimp_canvas_item_get_shell (item),
+                                  private->points, points,
+                                  private->n_points);
+
   for (i = 0; i < private->n_points; i++)
     {
-      gimp_canvas_item_transform_xy_f (item,
-                                       private->points[i].x,
-                                       private->points[i].y,
-                                       &points[i].x,
-                                       &points[i].y);
-
       points[i].x = floor (points[i].x) + 0.5;
       points[i].y = floor (points[i].y) + 0.5;
     }
@@ -47,6 +47,8 @@
 #define MAX_SUB_COLS       6 /* number of columns and  */
 #define MAX_SUB_ROWS       6 /* rows to use in perspective preview subdivision */
 
+#define MAX_TEXTURE_LEVEL  6 /* the coarsest reduced copy of the drawable */
+
 
 enum
 {
@@ -72,6 +74,10 @@ struct _GimpCanvasTransformPreviewPrivate
   gdouble            x2, y2;
   gboolean           perspective;
   gdouble            opacity;
+
+  GeglBuffer        *texture_source;
+  GeglBuffer        *texture;
+  gint               texture_level;
 };
 
 #define GET_PRIVATE(transform_preview) \
@@ -82,6 +88,7 @@ struct _GimpCanvasTransformPreviewPrivate
 
 /*  local function prototypes  */
 
+static void             gimp_canvas_transform_preview_finalize     (GObject        *object);
 static void             gimp_canvas_transform_preview_set_property (GObject        *object,
                                                                     guint           property_id,
                                                                     const GValue   *value,
@@ -95,7 +102,12 @@ static void             gimp_canvas_transform_preview_draw         (GimpCanvasIt
                                                                     cairo_t        *cr);
 static cairo_region_t * gimp_canvas_transform_preview_get_extents  (GimpCanvasItem *item);
 
-static void   gimp_canvas_transform_preview_draw_quad         (GimpDrawable    *texture,
+static GeglBuffer     * gimp_canvas_transform_preview_get_texture   (GimpCanvasItem *item,
+                                                                    gint           *level);
+static void             gimp_canvas_transform_preview_drop_texture (GimpCanvasItem *item);
+
+static void   gimp_canvas_transform_preview_draw_quad         (GeglBuffer      *texture,
+                                                               gint             texture_level,
                                                                cairo_t         *cr,
                                                                GimpChannel     *mask,
                                                                gint             mask_offx,
@@ -105,7 +117,8 @@ static void   gimp_canvas_transform_preview_draw_quad         (GimpDrawable    *
                                                                gfloat          *u,
                                                                gfloat          *v,
                                                                guchar           opacity);
-static void   gimp_canvas_transform_preview_draw_tri          (GimpDrawable    *texture,
+static void   gimp_canvas_transform_preview_draw_tri          (GeglBuffer      *texture,
+                                                               gint             texture_level,
                                                                cairo_t         *cr,
                                                                cairo_surface_t *area,
                                                                gint             area_offx,
@@ -118,7 +131,8 @@ static void   gimp_canvas_transform_preview_draw_tri          (GimpDrawable    *
                                                                gfloat          *u,
                                                                gfloat          *v,
                                                                guchar           opacity);
-static void   gimp_canvas_transform_preview_draw_tri_row      (GimpDrawable    *texture,
+static void   gimp_canvas_transform_preview_draw_tri_row      (GeglBuffer      *texture,
+                                                               gint             texture_level,
                                                                cairo_t         *cr,
                                                                cairo_surface_t *area,
                                                                gint             area_offx,
@@ -131,7 +145,8 @@ static void   gimp_canvas_transform_preview_draw_tri_row      (GimpDrawable    *
                                                                gfloat           v2,
                                                                gint             y,
                                                                guchar           opacity);
-static void   gimp_canvas_transform_preview_draw_tri_row_mask (GimpDrawable    *texture,
+static void   gimp_canvas_transform_preview_draw_tri_row_mask (GeglBuffer      *texture,
+                                                               gint             texture_level,
                                                                cairo_t         *cr,
                                                                cairo_surface_t *area,
                                                                gint             area_offx,
@@ -166,6 +181,7 @@ gimp_canvas_transform_preview_class_init (GimpCanvasTransformPreviewClass *klass
   GObjectClass        *object_class = G_OBJECT_CLASS (klass);
   GimpCanvasItemClass *item_class   = GIMP_CANVAS_ITEM_CLASS (klass);
 
+  object_class->finalize     = gimp_canvas_transform_preview_finalize;
   object_class->set_property = gimp_canvas_transform_preview_set_property;
   object_class->get_property = gimp_canvas_transform_preview_get_property;
 
@@ -236,6 +252,14 @@ gimp_canvas_transform_preview_init (GimpCanvasTransformPreview *transform_previe
 {
 }
 
+static void
+gimp_canvas_transform_preview_finalize (GObject *object)
+{
+  gimp_canvas_transform_preview_drop_texture (GIMP_CANVAS_ITEM (object));
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
 static void
 gimp_canvas_transform_preview_set_property (GObject      *object,
                                             guint         property_id,
@@ -248,6 +272,7 @@ gimp_canvas_transform_preview_set_property (GObject      *object,
     {
     case PROP_DRAWABLE:
       private->drawable = g_value_get_object (value); /* don't ref */
+      gimp_canvas_transform_preview_drop_texture (GIMP_CANVAS_ITEM (object));
       break;
 
     case PROP_TRANSFORM:
@@ -406,6 +431,8 @@ gimp_canvas_transform_preview_draw (GimpCanvasItem *item,
 {
   GimpCanvasTransformPreviewPrivate *private = GET_PRIVATE (item);
   GimpChannel                       *mask;
+  GeglBuffer                        *texture;
+  gint                               texture_level;
   gint                               mask_x1, mask_y1;
   gint                               mask_x2, mask_y2;
   gint                               mask_offx, mask_offy;
@@ -549,9 +576,11 @@ gimp_canvas_transform_preview_draw (GimpCanvasItem *item,
 #undef CALC_VERTEX
 #undef COPY_VERTEX
 
+  texture = gimp_canvas_transform_preview_get_texture (item, &texture_level);
+
   k = columns * rows;
   for (j = 0; j < k; j++)
-    gimp_canvas_transform_preview_draw_quad (private->drawable, cr,
+    gimp_canvas_transform_preview_draw_quad (texture, texture_level, cr,
                                              mask, mask_offx, mask_offy,
                                              x[j], y[j], u[j], v[j],
                                              opacity);
@@ -599,9 +628,109 @@ gimp_canvas_transform_preview_new (GimpDisplayShell  *shell,
 
 /*  private functions  */
 
+/*  the preview only needs as many texture pixels as there are screen
+ *  pixels, so when zoomed out, or when the transform scales down,
+ *  sample a reduced copy of the drawable; GEGL builds it from its
+ *  mipmap, and it is kept while the handles move
+ */
+static GeglBuffer *
+gimp_canvas_transform_preview_get_texture (GimpCanvasItem *item,
+                                           gint           *level)
+{
+  GimpCanvasTransformPreviewPrivate *private = GET_PRIVATE (item);
+  GimpDisplayShell                  *shell   = gimp_canvas_item_get_shell (item);
+  GeglBuffer                        *buffer;
+  gdouble                            scale;
+  gdouble                            step;
+  gint                               texture_level = 0;
+
+  buffer = gimp_drawable_get_buffer (private->drawable);
+
+  scale = sqrt (fabs (private->transform.coeff[0][0] *
+                      private->transform.coeff[1][1] -
+                      private->transform.coeff[0][1] *
+                      private->transform.coeff[1][0]));
+  scale *= MIN (shell->scale_x, shell->scale_y);
+
+  if (scale > 0.0)
+    {
+      step = 1.0 / scale;
+
+      while (texture_level < MAX_TEXTURE_LEVEL &&
+             step >= (gdouble) (2 << texture_level))
+        {
+          texture_level++;
+        }
+    }
+
+  *level = texture_level;
+
+  if (texture_level == 0)
+    return buffer;
+
+  if (private->texture                         &&
+      private->texture_source == buffer        &&
+      private->texture_level  == texture_level)
+    {
+      return private->texture;
+    }
+
+  gimp_canvas_transform_preview_drop_texture (item);
+
+  {
+    GeglBufferIterator *iter;
+    const Babl         *format = gegl_buffer_get_format (buffer);
+    gint                factor = 1 << texture_level;
+
+    private->texture =
+      gegl_buffer_new (GEGL_RECTANGLE (0, 0,
+                                       (gegl_buffer_get_width  (buffer) +
+                                        factor - 1) / factor,
+                                       (gegl_buffer_get_height (buffer) +
+                                        factor - 1) / factor),
+                       format);
+
+    iter = gegl_buffer_iterator_new (private->texture, NULL, 0, format,
+                                     GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
+
+    while (gegl_buffer_iterator_next (iter))
+      {
+        gegl_buffer_get (buffer, &iter->roi[0], 1.0 / factor,
+                         format, iter->data[0],
+                         GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+      }
+  }
+
+  private->texture_source = g_object_ref (buffer);
+  private->texture_level  = texture_level;
+
+  return private->texture;
+}
+
+static void
+gimp_canvas_transform_preview_drop_texture (GimpCanvasItem *item)
+{
+  GimpCanvasTransformPreviewPrivate *private = GET_PRIVATE (item);
+
+  if (private->texture)
+    {
+      g_object_unref (private->texture);
+      private->texture = NULL;
+    }
+
+  if (private->texture_source)
+    {
+      g_object_unref (private->texture_source);
+      private->texture_source = NULL;
+    }
+
+  private->texture_level = 0;
+}
+
 /**
  * gimp_canvas_transform_preview_draw_quad:
- * @texture:   the #GimpDrawable to be previewed
+ * @texture:       the buffer of the #GimpDrawable to be previewed
+ * @texture_level: @texture is scaled down by 2^@texture_level
  * @cr:        the #cairo_t to draw to
  * @mask:      a #GimpChannel
  * @opacity:   the opacity of the preview
@@ -610,7 +739,8 @@ gimp_canvas_transform_preview_new (GimpDisplayShell  *shell,
  * with gimp_canvas_transform_preview_draw_tri().
  **/
 static void
-gimp_canvas_transform_preview_draw_quad (GimpDrawable *texture,
+gimp_canvas_transform_preview_draw_quad (GeglBuffer   *texture,
+                                         gint          texture_level,
                                          cairo_t      *cr,
                                          GimpChannel  *mask,
                                          gint          mask_offx,
@@ -664,10 +794,12 @@ gimp_canvas_transform_preview_draw_quad (GimpDrawable *texture,
 
       g_return_if_fail (area != NULL);
 
-      gimp_canvas_transform_preview_draw_tri (texture, cr, area, minx, miny,
+      gimp_canvas_transform_preview_draw_tri (texture, texture_level,
+                                              cr, area, minx, miny,
                                               mask, mask_offx, mask_offy,
                                               x, y, u, v, opacity);
-      gimp_canvas_transform_preview_draw_tri (texture, cr, area, minx, miny,
+      gimp_canvas_transform_preview_draw_tri (texture, texture_level,
+                                              cr, area, minx, miny,
                                               mask, mask_offx, mask_offy,
                                               x2, y2, u2, v2, opacity);
 
@@ -691,7 +823,8 @@ gimp_canvas_transform_preview_draw_quad (GimpDrawable *texture,
  * actual pixel changing.
  **/
 static void
-gimp_canvas_transform_preview_draw_tri (GimpDrawable    *texture,
+gimp_canvas_transform_preview_draw_tri (GeglBuffer      *texture,
+                                        gint             texture_level,
                                         cairo_t         *cr,
                                         cairo_surface_t *area,
                                         gint             area_offx,
@@ -713,7 +846,7 @@ gimp_canvas_transform_preview_draw_tri (GimpDrawable    *texture,
   gfloat       dul, dvl, dur, dvr; /* left and right texture coord deltas  */
   gfloat       u_l, v_l, u_r, v_r; /* left and right texture coord pairs  */
 
-  g_return_if_fail (GIMP_IS_DRAWABLE (texture));
+  g_return_if_fail (GEGL_IS_BUFFER (texture));
   g_return_if_fail (area != NULL);
 
   g_return_if_fail (x != NULL && y != NULL && u != NULL && v != NULL);
@@ -765,7 +898,8 @@ gimp_canvas_transform_preview_draw_tri (GimpDrawable    *texture,
         for (ry = y[0]; ry < y[1]; ry++)
           {
             if (ry >= clip_y1 && ry < clip_y2)
-              gimp_canvas_transform_preview_draw_tri_row_mask (texture, cr,
+              gimp_canvas_transform_preview_draw_tri_row_mask (texture, texture_level,
+                                                               cr,
                                                                area, area_offx, area_offy,
                                                                mask, mask_offx, mask_offy,
                                                                *left, u_l, v_l,
@@ -780,7 +914,8 @@ gimp_canvas_transform_preview_draw_tri (GimpDrawable    *texture,
         for (ry = y[0]; ry < y[1]; ry++)
           {
             if (ry >= clip_y1 && ry < clip_y2)
-              gimp_canvas_transform_preview_draw_tri_row (texture, cr,
+              gimp_canvas_transform_preview_draw_tri_row (texture, texture_level,
+                                                          cr,
                                                           area, area_offx, area_offy,
                                                           *left, u_l, v_l,
                                                           *right, u_r, v_r,
@@ -806,7 +941,8 @@ gimp_canvas_transform_preview_draw_tri (GimpDrawable    *texture,
         for (ry = y[1]; ry < y[2]; ry++)
           {
             if (ry >= clip_y1 && ry < clip_y2)
-              gimp_canvas_transform_preview_draw_tri_row_mask (texture, cr,
+              gimp_canvas_transform_preview_draw_tri_row_mask (texture, texture_level,
+                                                               cr,
                                                                area, area_offx, area_offy,
                                                                mask, mask_offx, mask_offy,
                                                                *left,  u_l, v_l,
@@ -821,7 +957,8 @@ gimp_canvas_transform_preview_draw_tri (GimpDrawable    *texture,
         for (ry = y[1]; ry < y[2]; ry++)
           {
             if (ry >= clip_y1 && ry < clip_y2)
-              gimp_canvas_transform_preview_draw_tri_row (texture, cr,
+              gimp_canvas_transform_preview_draw_tri_row (texture, texture_level,
+                                                          cr,
                                                           area, area_offx, area_offy,
                                                           *left,  u_l, v_l,
                                                           *right, u_r, v_r,
@@ -849,7 +986,8 @@ gimp_canvas_transform_preview_draw_tri (GimpDrawable    *texture,
  * (u2,v2) in texture.
  **/
 static void
-gimp_canvas_transform_preview_draw_tri_row (GimpDrawable    *texture,
+gimp_canvas_transform_preview_draw_tri_row (GeglBuffer      *texture,
+                                            gint             texture_level,
                                             cairo_t         *cr,
                                             cairo_surface_t *area,
                                             gint             area_offx,
@@ -877,7 +1015,7 @@ gimp_canvas_transform_preview_draw_tri_row (GimpDrawable    *texture,
   if (x2 == x1)
     return;
 
-  g_return_if_fail (GIMP_IS_DRAWABLE (texture));
+  g_return_if_fail (GEGL_IS_BUFFER (texture));
   g_return_if_fail (area != NULL);
   g_return_if_fail (cairo_image_surface_get_format (area) == CAIRO_FORMAT_ARGB32);
 
@@ -927,7 +1065,7 @@ gimp_canvas_transform_preview_draw_tri_row (GimpDrawable    *texture,
           + (y - area_offy) * cairo_image_surface_get_stride (area)
           + (x1 - area_offx) * 4);
 
-  buffer = gimp_drawable_get_buffer (texture);
+  buffer = texture;
 
   format = gegl_buffer_get_format (buffer);
   bpp    = babl_format_get_bytes_per_pixel (format);
@@ -938,7 +1076,10 @@ gimp_canvas_transform_preview_draw_tri_row (GimpDrawable    *texture,
 
   while (samples--)
     {
-      gegl_buffer_sample (buffer, (gint) u, (gint) v, NULL, b,
+      gegl_buffer_sample (buffer,
+                          (gint) u >> texture_level,
+                          (gint) v >> texture_level,
+                          NULL, b,
                           format,
                           GEGL_SAMPLER_NEAREST, GEGL_ABYSS_NONE);
 
@@ -994,7 +1135,8 @@ gimp_canvas_transform_preview_draw_tri_row (GimpDrawable    *texture,
  * single row of a triangle onto dest, when there is a mask.
  **/
 static void
-gimp_canvas_transform_preview_draw_tri_row_mask (GimpDrawable    *texture,
+gimp_canvas_transform_preview_draw_tri_row_mask (GeglBuffer      *texture,
+                                                 gint             texture_level,
                                                  cairo_t         *cr,
                                                  cairo_surface_t *area,
                                                  gint             area_offx,
@@ -1031,7 +1173,7 @@ gimp_canvas_transform_preview_draw_tri_row_mask (GimpDrawable    *texture,
   if (x2 == x1)
     return;
 
-  g_return_if_fail (GIMP_IS_DRAWABLE (texture));
+  g_return_if_fail (GEGL_IS_BUFFER (texture));
   g_return_if_fail (GIMP_IS_CHANNEL (mask));
   g_return_if_fail (area != NULL);
   g_return_if_fail (cairo_image_surface_get_format (area) == CAIRO_FORMAT_ARGB32);
@@ -1085,7 +1227,7 @@ gimp_canvas_transform_preview_draw_tri_row_mask (GimpDrawable    *texture,
           + (y - area_offy) * cairo_image_surface_get_stride (area)
           + (x1 - area_offx) * 4);
 
-  buffer      = gimp_drawable_get_buffer (texture);
+  buffer      = texture;
   mask_buffer = gimp_drawable_get_buffer (GIMP_DRAWABLE (mask));
 
   format      = gegl_buffer_get_format (buffer);
@@ -1101,7 +1243,10 @@ gimp_canvas_transform_preview_draw_tri_row_mask (GimpDrawable    *texture,
 
   while (samples--)
     {
-      gegl_buffer_sample (buffer, (gint) u, (gint) v, NULL, b,
+      gegl_buffer_sample (buffer,
+                          (gint) u >> texture_level,
+                          (gint) v >> texture_level,
+                          NULL, b,
                           format,
                           GEGL_SAMPLER_NEAREST, GEGL_ABYSS_NONE);
       gegl_buffer_sample (mask_buffer, (gint) mu, (gint) mv, NULL, mask_b,
@@ -44,13 +44,16 @@
 #include "gimpdisplayshell-expose.h"
 #include "gimpdisplayshell-handlers.h"
 #include "gimpdisplayshell-icon.h"
+#include "gimpdisplayshell-render.h"
 #include "gimpdisplayshell-transform.h"
 #include "gimpimagewindow.h"
 
+#include "gimp-log.h"
+
 #include "gimp-intl.h"
 
 
-#define FLUSH_NOW_INTERVAL 20000 /* 20 ms in microseconds */
+#define FRAME_INTERVAL 16667 /* 60 frames per second, in microseconds */
 
 
 enum
@@ -76,7 +79,11 @@ struct _GimpDisplayPrivate
   GtkWidget      *shell;
   cairo_region_t *update_region;
 
-  guint64         last_flush_now;
+  guint           frame_id;
+  gint64          frame_time;   /*  when the last frame was painted     */
+  gint64          frame_due;    /*  when the pending frame is due       */
+  guint64         n_frames;
+  guint64         n_dropped_frames;
 };
 
 #define GIMP_DISPLAY_GET_PRIVATE(display) \
@@ -120,6 +127,10 @@ static void     gimp_display_progress_canceled      (GimpProgress        *progre
 
 static void     gimp_display_flush_whenever         (GimpDisplay         *display,
                                                      gboolean             now);
+static void     gimp_display_paint_region           (GimpDisplay         *display);
+static void     gimp_display_schedule_frame         (GimpDisplay         *display);
+static gboolean gimp_display_frame_timeout          (GimpDisplay         *display);
+static void     gimp_display_frame                  (GimpDisplay         *display);
 static void     gimp_display_paint_area             (GimpDisplay         *display,
                                                      gint                 x,
                                                      gint                 y,
@@ -652,6 +663,20 @@ gimp_display_set_image (GimpDisplay *display,
 
       gimp_display_disconnect (display);
 
+      if (private->frame_id)
+        {
+          g_source_remove (private->frame_id);
+          private->frame_id = 0;
+        }
+
+      GIMP_LOG (DISPLAY_FRAMES,
+                "%" G_GUINT64_FORMAT " frames, "
+                "%" G_GUINT64_FORMAT " dropped",
+                private->n_frames, private->n_dropped_frames);
+
+      private->n_frames         = 0;
+      private->n_dropped_frames = 0;
+
       if (private->update_region)
         {
           cairo_region_destroy (private->update_region);
@@ -778,35 +803,34 @@ gimp_display_update_area (GimpDisplay *display,
                           gint         w,
                           gint         h)
 {
-  GimpDisplayPrivate *private;
+  GimpDisplayPrivate    *private;
+  cairo_rectangle_int_t  rect;
+  gint                   image_width;
+  gint                   image_height;
 
   g_return_if_fail (GIMP_IS_DISPLAY (display));
 
   private = GIMP_DISPLAY_GET_PRIVATE (display);
 
-  if (now)
-    {
-      gimp_display_paint_area (display, x, y, w, h);
-    }
-  else
-    {
-      cairo_rectangle_int_t rect;
-      gint                  image_width;
-      gint                  image_height;
+  image_width  = gimp_image_get_width  (private->image);
+  image_height = gimp_image_get_height (private->image);
 
-      image_width  = gimp_image_get_width  (private->image);
-      image_height = gimp_image_get_height (private->image);
+  rect.x      = CLAMP (x,     0, image_width);
+  rect.y      = CLAMP (y,     0, image_height);
+  rect.width  = CLAMP (x + w, 0, image_width)  - rect.x;
+  rect.height = CLAMP (y + h, 0, image_height) - rect.y;
 
-      rect.x      = CLAMP (x,     0, image_width);
-      rect.y      = CLAMP (y,     0, image_height);
-      rect.width  = CLAMP (x + w, 0, image_width)  - rect.x;
-      rect.height = CLAMP (y + h, 0, image_height) - rect.y;
+  if (private->update_region)
+    cairo_region_union_rectangle (private->update_region, &rect);
+  else
+    private->update_region = cairo_region_create_rectangle (&rect);
 
-      if (private->update_region)
-        cairo_region_union_rectangle (private->update_region, &rect);
-      else
-        private->update_region = cairo_region_create_rectangle (&rect);
-    }
+  /*  updates that want to be seen now are merged with all other
+   *  damage until the next frame, so each pixel is painted only
+   *  once per frame no matter how many updates touched it
+   */
+  if (now)
+    gimp_display_schedule_frame (display);
 }
 
 void
@@ -834,6 +858,39 @@ gimp_display_flush_whenever (GimpDisplay *display,
 {
   GimpDisplayPrivate *private = GIMP_DISPLAY_GET_PRIVATE (display);
 
+  if (now)
+    {
+      /*  paint right away if a frame is due, so the first update of
+       *  e.g. a paint stroke shows without delay, otherwise wait for
+       *  the next frame
+       */
+      gint64 time = g_get_monotonic_time ();
+
+      if (time - private->frame_time >= FRAME_INTERVAL)
+        {
+          if (! private->frame_id)
+            private->frame_due = time;
+
+          gimp_display_frame (display);
+        }
+      else
+        {
+          gimp_display_schedule_frame (display);
+        }
+    }
+  else
+    {
+      gimp_display_paint_region (display);
+
+      gimp_display_shell_flush (gimp_display_get_shell (display), now);
+    }
+}
+
+static void
+gimp_display_paint_region (GimpDisplay *display)
+{
+  GimpDisplayPrivate *private = GIMP_DISPLAY_GET_PRIVATE (display);
+
   if (private->update_region)
     {
       gint n_rects = cairo_region_num_rectangles (private->update_region);
@@ -856,22 +913,77 @@ gimp_display_flush_whenever (GimpDisplay *display,
       cairo_region_destroy (private->update_region);
       private->update_region = NULL;
     }
+}
 
-  if (now)
-    {
-      guint64 now = g_get_monotonic_time ();
+/*  GTK+ 2 has no frame clock, so frames are timed to FRAME_INTERVAL
+ *  after the previous one instead of to the monitor's refresh
+ */
+static void
+gimp_display_schedule_frame (GimpDisplay *display)
+{
+  GimpDisplayPrivate *private = GIMP_DISPLAY_GET_PRIVATE (display);
+  gint64              time;
+  gint64              delay;
 
-      if ((now - private->last_flush_now) > FLUSH_NOW_INTERVAL)
-        {
-          gimp_display_shell_flush (gimp_display_get_shell (display), now);
+  if (private->frame_id)
+    return;
 
-          private->last_flush_now = now;
-        }
-    }
-  else
+  time  = g_get_monotonic_time ();
+  delay = private->frame_time + FRAME_INTERVAL - time;
+  delay = CLAMP (delay, 0, FRAME_INTERVAL);
+
+  private->frame_due = time + delay;
+
+  private->frame_id =
+    g_timeout_add_full (GDK_PRIORITY_REDRAW, delay / 1000,
+                        (GSourceFunc) gimp_display_frame_timeout,
+                        display, NULL);
+}
+
+static gboolean
+gimp_display_frame_timeout (GimpDisplay *display)
+{
+  GimpDisplayPrivate *private = GIMP_DISPLAY_GET_PRIVATE (display);
+
+  private->frame_id = 0;
+
+  gimp_display_frame (display);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+gimp_display_frame (GimpDisplay *display)
+{
+  GimpDisplayPrivate *private = GIMP_DISPLAY_GET_PRIVATE (display);
+  GimpDisplayShell   *shell   = gimp_display_get_shell (display);
+  gint64              start   = g_get_monotonic_time ();
+  gint64              end;
+
+  if (private->frame_id)
     {
-      gimp_display_shell_flush (gimp_display_get_shell (display), now);
+      g_source_remove (private->frame_id);
+      private->frame_id = 0;
     }
+
+  if (! shell)
+    return;
+
+  /*  a frame that had to wait for other work misses frames, and so
+   *  does a frame that takes longer than one interval to paint
+   */
+  private->n_dropped_frames += MAX (start - private->frame_due, 0) /
+                               FRAME_INTERVAL;
+
+  gimp_display_paint_region (display);
+  gimp_display_shell_flush (shell, TRUE);
+
+  end = g_get_monotonic_time ();
+
+  private->n_dropped_frames += (end - start) / FRAME_INTERVAL;
+  private->n_frames++;
+
+  private->frame_time = start;
 }
 
 static void
@@ -915,5 +1027,6 @@ gimp_display_paint_area (GimpDisplay *display,
   x2 = ceil (x2_f + 0.5);
   y2 = ceil (y2_f + 0.5);
 
+  gimp_display_shell_render_invalidate_area (shell, x1, y1, x2 - x1, y2 - y1);
   gimp_display_shell_expose_area (shell, x1, y1, x2 - x1, y2 - y1);
 }
@@ -38,6 +38,7 @@
 #include "gimpdisplayshell-appearance.h"
 #include "gimpdisplayshell-callbacks.h"
 #include "gimpdisplayshell-draw.h"
+#include "gimpdisplayshell-render.h"
 #include "gimpdisplayshell-scale.h"
 #include "gimpdisplayshell-scroll.h"
 #include "gimpdisplayshell-selection.h"
@@ -161,6 +162,8 @@ gimp_display_shell_canvas_size_allocate (GtkWidget        *widget,
       shell->disp_width  = allocation->width;
       shell->disp_height = allocation->height;
 
+      gimp_display_shell_render_invalidate_full (shell);
+
       /* When we size-allocate due to resize of the top level window,
        * we want some additional logic. Don't apply it on
        * zoom_on_resize though.
@@ -463,10 +466,9 @@ gimp_display_shell_canvas_draw_image (GimpDisplayShell *shell,
     {
       gint i;
 
-      cairo_save (cr);
-      gimp_display_shell_draw_checkerboard (shell, cr);
-      cairo_restore (cr);
-
+      /*  the rendered image includes the checks behind transparent
+       *  parts, see gimp_display_shell_render()
+       */
       for (i = 0; i < clip_rectangles->num_rectangles; i++)
         {
           cairo_rectangle_t rect = clip_rectangles->rectangles[i];
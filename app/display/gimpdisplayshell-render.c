@@ -30,6 +30,7 @@
 
 #include "gegl/gimp-gegl-utils.h"
 
+#include "core/gimp-parallel.h"
 #include "core/gimpdrawable.h"
 #include "core/gimpimage.h"
 #include "core/gimppickable.h"
@@ -39,6 +40,8 @@
 
 #include "gimpdisplay.h"
 #include "gimpdisplayshell.h"
+#include "gimpdisplayshell-draw.h"
+#include "gimpdisplayshell-expose.h"
 #include "gimpdisplayshell-transform.h"
 #include "gimpdisplayshell-filter.h"
 #include "gimpdisplayshell-render.h"
@@ -48,107 +51,1006 @@
 
 /* #define GIMP_DISPLAY_RENDER_ENABLE_SCALING 1 */
 
+/*  how long one run of the progressive render idle may take, in µs  */
+#define RENDER_IDLE_TIME 10000
 
-void
-gimp_display_shell_render (GimpDisplayShell *shell,
-                           cairo_t          *cr,
-                           gint              x,
-                           gint              y,
-                           gint              w,
-                           gint              h)
+
+typedef struct _GimpDisplayShellRender      GimpDisplayShellRender;
+typedef struct _GimpDisplayShellRenderChunk GimpDisplayShellRenderChunk;
+
+struct _GimpDisplayShellRender
 {
-  GimpImage       *image;
-  GeglBuffer      *buffer;
+  GimpDisplayShell *shell;
+  GeglBuffer       *buffer;
 #ifdef USE_NODE_BLIT
-  GeglNode        *node;
+  GeglNode         *node;
 #endif
-  gdouble          scale_x      = 1.0;
-  gdouble          scale_y      = 1.0;
-  gdouble          buffer_scale = 1.0;
-  gint             viewport_offset_x;
-  gint             viewport_offset_y;
-  gint             viewport_width;
-  gint             viewport_height;
+  gdouble           scale_x;
+  gdouble           scale_y;
+  gdouble           buffer_scale;
+  gint              viewport_offset_x;
+  gint              viewport_offset_y;
+  GArray           *chunks;
+};
+
+struct _GimpDisplayShellRenderChunk
+{
+  gint             x, y, w, h;    /*  the chunk in canvas coordinates  */
   gint             scaled_x;
   gint             scaled_y;
   gint             scaled_width;
   gint             scaled_height;
-  cairo_surface_t *xfer;
-  gint             xfer_src_x;
-  gint             xfer_src_y;
-  gint             mask_src_x = 0;
-  gint             mask_src_y = 0;
-  gint             stride;
-  guchar          *data;
+  cairo_surface_t *surface;
+  gint             src_x;         /*  the chunk's offset in surface    */
+  gint             src_y;
+  cairo_surface_t *mask_surface;
+  gboolean         opaque;
+};
+
 
+static void     gimp_display_shell_render_cache_update    (GimpDisplayShell            *shell,
+                                                           cairo_t                     *cr);
+static void     gimp_display_shell_render_cache_get_rect  (GimpDisplayShell            *shell,
+                                                           cairo_rectangle_int_t       *rect);
+static void     gimp_display_shell_render_cache_scale     (GimpDisplayShell            *shell,
+                                                           const cairo_rectangle_int_t *rect,
+                                                           cairo_surface_t             *old_cache,
+                                                           cairo_region_t              *old_region);
+static void     gimp_display_shell_render_cache_fill      (GimpDisplayShell            *shell,
+                                                           gint                         x,
+                                                           gint                         y,
+                                                           gint                         w,
+                                                           gint                         h,
+                                                           gboolean                     defer);
+static void     gimp_display_shell_render_region          (GimpDisplayShell            *shell,
+                                                           cairo_region_t              *region);
+static gboolean gimp_display_shell_render_idle            (GimpDisplayShell            *shell);
+static gint     gimp_display_shell_render_chunk_compare   (const cairo_rectangle_int_t *chunk1,
+                                                           const cairo_rectangle_int_t *chunk2,
+                                                           const cairo_rectangle_int_t *cache_rect);
+static void     gimp_display_shell_render_init            (GimpDisplayShell            *shell,
+                                                           GimpDisplayShellRender      *render);
+static void     gimp_display_shell_render_add_chunk       (GimpDisplayShellRender      *render,
+                                                           gint                         x,
+                                                           gint                         y,
+                                                           gint                         w,
+                                                           gint                         h);
+static void     gimp_display_shell_render_chunks_serial   (GimpDisplayShell            *shell,
+                                                           cairo_t                     *cr,
+                                                           GimpDisplayShellRender      *render);
+static void     gimp_display_shell_render_chunks_parallel (GimpDisplayShell            *shell,
+                                                           cairo_t                     *cr,
+                                                           GimpDisplayShellRender      *render);
+static void     gimp_display_shell_render_chunks_func     (gint                         i,
+                                                           gint                         n,
+                                                           GimpDisplayShellRender      *render);
+static void     gimp_display_shell_render_chunk_fetch     (GimpDisplayShellRender      *render,
+                                                           GimpDisplayShellRenderChunk *chunk);
+static void     gimp_display_shell_render_chunk_paint     (GimpDisplayShellRender      *render,
+                                                           cairo_t                     *cr,
+                                                           GimpDisplayShellRenderChunk *chunk);
+static gboolean gimp_display_shell_render_is_opaque       (const guchar                *data,
+                                                           gint                         stride,
+                                                           gint                         width,
+                                                           gint                         height);
+
+
+/*  public functions  */
+
+void
+gimp_display_shell_render (GimpDisplayShell *shell,
+                           cairo_t          *cr,
+                           gint              x,
+                           gint              y,
+                           gint              w,
+                           gint              h)
+{
   g_return_if_fail (GIMP_IS_DISPLAY_SHELL (shell));
   g_return_if_fail (cr != NULL);
   g_return_if_fail (w > 0 && h > 0);
 
-  image  = gimp_display_get_image (shell->display);
-  buffer = gimp_pickable_get_buffer (GIMP_PICKABLE (image));
+  gimp_display_shell_render_cache_update (shell, cr);
+
+  /*  when rotated, the chunk's edges are antialiased, so the pixels
+   *  just around it are painted too, to avoid seams between chunks,
+   *  and need to be rendered as well
+   */
+  if (shell->rotate_transform)
+    gimp_display_shell_render_cache_fill (shell, x - 1, y - 1, w + 2, h + 2,
+                                          TRUE);
+  else
+    gimp_display_shell_render_cache_fill (shell, x, y, w, h, TRUE);
+
+  /*  put it to the screen  */
+  cairo_save (cr);
+
+  cairo_rectangle (cr, x, y, w, h);
+
+  cairo_set_source_surface (cr, shell->render_cache,
+                            shell->render_cache_rect.x,
+                            shell->render_cache_rect.y);
+
+  if (shell->rotate_transform)
+    {
+      cairo_set_line_width (cr, 1.0);
+      cairo_stroke_preserve (cr);
+    }
+
+  cairo_clip (cr);
+  cairo_paint (cr);
+
+  cairo_restore (cr);
+}
+
+void
+gimp_display_shell_render_invalidate_full (GimpDisplayShell *shell)
+{
+  g_return_if_fail (GIMP_IS_DISPLAY_SHELL (shell));
+
+  if (shell->render_cache)
+    {
+      cairo_surface_destroy (shell->render_cache);
+      shell->render_cache = NULL;
+    }
+
+  if (shell->render_cache_valid)
+    {
+      cairo_region_destroy (shell->render_cache_valid);
+      shell->render_cache_valid = NULL;
+    }
+
+  if (shell->render_cache_preview)
+    {
+      cairo_region_destroy (shell->render_cache_preview);
+      shell->render_cache_preview = NULL;
+    }
+
+  if (shell->render_queue)
+    {
+      cairo_region_destroy (shell->render_queue);
+      shell->render_queue = NULL;
+    }
+
+  if (shell->render_idle_id)
+    {
+      g_source_remove (shell->render_idle_id);
+      shell->render_idle_id = 0;
+    }
+}
+
+/*  Like gimp_display_shell_render_invalidate_full(), but keeps what
+ *  was rendered so far, so it can be shown scaled to the new zoom level
+ *  while the canvas is rendered again, see
+ *  gimp_display_shell_render_cache_update().
+ */
+void
+gimp_display_shell_render_invalidate_scale (GimpDisplayShell *shell)
+{
+  g_return_if_fail (GIMP_IS_DISPLAY_SHELL (shell));
+
+  if (! shell->render_cache_valid)
+    return;
+
+  if (! shell->render_cache_preview)
+    shell->render_cache_preview = cairo_region_create ();
+
+  cairo_region_union (shell->render_cache_preview, shell->render_cache_valid);
+
+  cairo_region_destroy (shell->render_cache_valid);
+  shell->render_cache_valid = cairo_region_create ();
+}
+
+void
+gimp_display_shell_render_invalidate_area (GimpDisplayShell *shell,
+                                           gint              x,
+                                           gint              y,
+                                           gint              width,
+                                           gint              height)
+{
+  cairo_rectangle_int_t rect;
+
+  g_return_if_fail (GIMP_IS_DISPLAY_SHELL (shell));
+
+  if (! shell->render_cache_valid)
+    return;
+
+  /*  the area is in screen coordinates, the cache is not rotated  */
+  if (shell->rotate_transform)
+    {
+      gdouble x1, y1, x2, y2;
+
+      gimp_display_shell_unrotate_bounds (shell,
+                                          x, y, x + width, y + height,
+                                          &x1, &y1, &x2, &y2);
+
+      x      = floor (x1);
+      y      = floor (y1);
+      width  = ceil (x2) - x;
+      height = ceil (y2) - y;
+    }
+
+  /*  the valid region is relative to the cache's position, which
+   *  follows the offsets the cache was last rendered at
+   */
+  rect.x      = x - shell->render_cache_rect.x +
+                (shell->offset_x - shell->render_cache_offset_x);
+  rect.y      = y - shell->render_cache_rect.y +
+                (shell->offset_y - shell->render_cache_offset_y);
+  rect.width  = width;
+  rect.height = height;
+
+  cairo_region_subtract_rectangle (shell->render_cache_valid, &rect);
+
+  /*  changed pixels are rendered right away, not previewed  */
+  if (shell->render_cache_preview)
+    cairo_region_subtract_rectangle (shell->render_cache_preview, &rect);
+
+  if (shell->render_queue)
+    cairo_region_subtract_rectangle (shell->render_queue, &rect);
+}
+
+
+/*  private functions  */
+
+/*  Makes sure the cache matches the shell's current scale, rotation and
+ *  offsets.  Scrolling keeps the cached pixels that are still on the
+ *  canvas, only zooming, rotating and full invalidation discard them.
+ */
+static void
+gimp_display_shell_render_cache_update (GimpDisplayShell *shell,
+                                        cairo_t          *cr)
+{
+  cairo_rectangle_int_t  rect;
+  cairo_surface_t       *old_cache  = NULL;
+  cairo_region_t        *old_region = NULL;
+
+  if (shell->render_cache &&
+      (shell->render_cache_scale_x != shell->scale_x ||
+       shell->render_cache_scale_y != shell->scale_y ||
+       shell->render_cache_angle   != shell->rotate_angle))
+    {
+      /*  after zooming, the old rendering is shown scaled until the
+       *  new zoom level is rendered
+       */
+      if (shell->render_cache_angle == shell->rotate_angle)
+        {
+          old_cache  = cairo_surface_reference (shell->render_cache);
+          old_region = cairo_region_copy (shell->render_cache_valid);
+
+          if (shell->render_cache_preview)
+            cairo_region_union (old_region, shell->render_cache_preview);
+        }
+
+      gimp_display_shell_render_invalidate_full (shell);
+    }
+
+  gimp_display_shell_render_cache_get_rect (shell, &rect);
+
+  if (! shell->render_cache)
+    {
+      /*  a surface similar to the window's lives in the X server (or
+       *  on the graphics card), so repaints of already rendered
+       *  parts of the canvas don't have to transfer pixels again
+       */
+      shell->render_cache =
+        cairo_surface_create_similar (cairo_get_target (cr),
+                                      CAIRO_CONTENT_COLOR_ALPHA,
+                                      rect.width, rect.height);
+      shell->render_cache_valid = cairo_region_create ();
+
+      if (old_cache)
+        {
+          if (! cairo_region_is_empty (old_region))
+            gimp_display_shell_render_cache_scale (shell, &rect,
+                                                   old_cache, old_region);
+
+          cairo_surface_destroy (old_cache);
+          cairo_region_destroy (old_region);
+        }
+    }
+  else if (shell->offset_x != shell->render_cache_offset_x   ||
+           shell->offset_y != shell->render_cache_offset_y   ||
+           rect.x          != shell->render_cache_rect.x     ||
+           rect.y          != shell->render_cache_rect.y     ||
+           rect.width      != shell->render_cache_rect.width ||
+           rect.height     != shell->render_cache_rect.height)
+    {
+      cairo_surface_t       *surface;
+      cairo_t               *surface_cr;
+      cairo_rectangle_int_t  bounds;
+      gint                   dx;
+      gint                   dy;
+
+      /*  where the cached pixels are now, relative to the new cache
+       *  position.  Copy them to a new surface, cairo doesn't define
+       *  overlapping copies within one surface
+       */
+      dx = (shell->render_cache_rect.x - rect.x -
+            (shell->offset_x - shell->render_cache_offset_x));
+      dy = (shell->render_cache_rect.y - rect.y -
+            (shell->offset_y - shell->render_cache_offset_y));
+
+      bounds.x      = 0;
+      bounds.y      = 0;
+      bounds.width  = rect.width;
+      bounds.height = rect.height;
+
+      cairo_region_translate (shell->render_cache_valid, dx, dy);
+      cairo_region_intersect_rectangle (shell->render_cache_valid, &bounds);
+
+      if (shell->render_cache_preview)
+        {
+          cairo_region_translate (shell->render_cache_preview, dx, dy);
+          cairo_region_intersect_rectangle (shell->render_cache_preview,
+                                            &bounds);
+        }
+
+      if (shell->render_queue)
+        {
+          cairo_region_translate (shell->render_queue, dx, dy);
+          cairo_region_intersect_rectangle (shell->render_queue, &bounds);
+        }
+
+      surface = cairo_surface_create_similar (shell->render_cache,
+                                              CAIRO_CONTENT_COLOR_ALPHA,
+                                              rect.width, rect.height);
+
+      if (! cairo_region_is_empty (shell->render_cache_valid) ||
+          (shell->render_cache_preview &&
+           ! cairo_region_is_empty (shell->render_cache_preview)))
+        {
+          surface_cr = cairo_create (surface);
+
+          cairo_set_operator (surface_cr, CAIRO_OPERATOR_SOURCE);
+          cairo_set_source_surface (surface_cr, shell->render_cache, dx, dy);
+          cairo_paint (surface_cr);
+
+          cairo_destroy (surface_cr);
+        }
+
+      cairo_surface_destroy (shell->render_cache);
+      shell->render_cache = surface;
+    }
+
+  shell->render_cache_rect     = rect;
+  shell->render_cache_offset_x = shell->offset_x;
+  shell->render_cache_offset_y = shell->offset_y;
+  shell->render_cache_scale_x  = shell->scale_x;
+  shell->render_cache_scale_y  = shell->scale_y;
+  shell->render_cache_angle    = shell->rotate_angle;
+
+  /*  an idle render might have stopped on a change of the cache  */
+  if (shell->render_queue                            &&
+      ! cairo_region_is_empty (shell->render_queue) &&
+      ! shell->render_idle_id)
+    {
+      shell->render_idle_id =
+        g_idle_add ((GSourceFunc) gimp_display_shell_render_idle, shell);
+    }
+}
+
+/*  Paints the given region of the old cache, which was rendered at the
+ *  cache's previous scale, scaled into the new cache, and remembers
+ *  where, so those parts of the canvas can be shown right away and
+ *  rendered progressively, see gimp_display_shell_render_cache_fill().
+ */
+static void
+gimp_display_shell_render_cache_scale (GimpDisplayShell            *shell,
+                                       const cairo_rectangle_int_t *rect,
+                                       cairo_surface_t             *old_cache,
+                                       cairo_region_t              *old_region)
+{
+  cairo_t               *cache_cr;
+  cairo_rectangle_int_t  bounds;
+  gdouble                factor_x;
+  gdouble                factor_y;
+  gint                   n_rects;
+  gint                   i;
+
+  factor_x = shell->scale_x / shell->render_cache_scale_x;
+  factor_y = shell->scale_y / shell->render_cache_scale_y;
+
+  bounds.x      = 0;
+  bounds.y      = 0;
+  bounds.width  = rect->width;
+  bounds.height = rect->height;
+
+  shell->render_cache_preview = cairo_region_create ();
+
+  cache_cr = cairo_create (shell->render_cache);
+
+  /*  from old cache coordinates, through image coordinates, to new
+   *  cache coordinates
+   */
+  cairo_translate (cache_cr,
+                   - rect->x - shell->offset_x,
+                   - rect->y - shell->offset_y);
+  cairo_scale (cache_cr, factor_x, factor_y);
+  cairo_translate (cache_cr,
+                   shell->render_cache_rect.x + shell->render_cache_offset_x,
+                   shell->render_cache_rect.y + shell->render_cache_offset_y);
+
+  n_rects = cairo_region_num_rectangles (old_region);
+
+  for (i = 0; i < n_rects; i++)
+    {
+      cairo_rectangle_int_t old_rect;
+      cairo_rectangle_int_t new_rect;
+      gdouble               x1, y1, x2, y2;
+
+      cairo_region_get_rectangle (old_region, i, &old_rect);
+
+      cairo_rectangle (cache_cr,
+                       old_rect.x, old_rect.y,
+                       old_rect.width, old_rect.height);
+
+      x1 = old_rect.x;
+      y1 = old_rect.y;
+      x2 = old_rect.x + old_rect.width;
+      y2 = old_rect.y + old_rect.height;
+
+      cairo_user_to_device (cache_cr, &x1, &y1);
+      cairo_user_to_device (cache_cr, &x2, &y2);
+
+      /*  only the pixels completely covered count as previewed  */
+      new_rect.x      = ceil (x1);
+      new_rect.y      = ceil (y1);
+      new_rect.width  = floor (x2) - new_rect.x;
+      new_rect.height = floor (y2) - new_rect.y;
+
+      if (new_rect.width > 0 && new_rect.height > 0)
+        cairo_region_union_rectangle (shell->render_cache_preview, &new_rect);
+    }
+
+  cairo_clip (cache_cr);
+
+  cairo_set_operator (cache_cr, CAIRO_OPERATOR_SOURCE);
+  cairo_set_source_surface (cache_cr, old_cache, 0, 0);
+  cairo_paint (cache_cr);
+
+  cairo_destroy (cache_cr);
+
+  cairo_region_intersect_rectangle (shell->render_cache_preview, &bounds);
+}
+
+/*  The cache holds unrotated pixels, so for rotated views it covers
+ *  the unrotated bounds of the canvas, with a margin for the pixels
+ *  around the chunks.
+ */
+static void
+gimp_display_shell_render_cache_get_rect (GimpDisplayShell      *shell,
+                                          cairo_rectangle_int_t *rect)
+{
+  if (shell->rotate_transform)
+    {
+      gdouble x1, y1, x2, y2;
+
+      gimp_display_shell_unrotate_bounds (shell,
+                                          0, 0,
+                                          shell->disp_width,
+                                          shell->disp_height,
+                                          &x1, &y1, &x2, &y2);
+
+      rect->x      = floor (x1) - 2;
+      rect->y      = floor (y1) - 2;
+      rect->width  = ceil (x2) + 2 - rect->x;
+      rect->height = ceil (y2) + 2 - rect->y;
+    }
+  else
+    {
+      rect->x      = 0;
+      rect->y      = 0;
+      rect->width  = shell->disp_width;
+      rect->height = shell->disp_height;
+    }
+}
+
+/*  Renders the parts of the given canvas area that are not cached yet.
+ *  If @defer is TRUE, the parts that show a scaled preview are only
+ *  queued for rendering in the idle, so zooming shows something right
+ *  away.
+ */
+static void
+gimp_display_shell_render_cache_fill (GimpDisplayShell *shell,
+                                      gint              x,
+                                      gint              y,
+                                      gint              w,
+                                      gint              h,
+                                      gboolean          defer)
+{
+  cairo_region_t        *region;
+  cairo_rectangle_int_t  rect;
+  cairo_rectangle_int_t  bounds;
+
+  rect.x      = x - shell->render_cache_rect.x;
+  rect.y      = y - shell->render_cache_rect.y;
+  rect.width  = w;
+  rect.height = h;
+
+  bounds.x      = 0;
+  bounds.y      = 0;
+  bounds.width  = shell->render_cache_rect.width;
+  bounds.height = shell->render_cache_rect.height;
+
+  region = cairo_region_create_rectangle (&rect);
+  cairo_region_intersect_rectangle (region, &bounds);
+  cairo_region_subtract (region, shell->render_cache_valid);
+
+  if (defer && shell->render_cache_preview)
+    {
+      cairo_region_t *preview = cairo_region_copy (region);
+
+      cairo_region_intersect (preview, shell->render_cache_preview);
+
+      if (! cairo_region_is_empty (preview))
+        {
+          cairo_region_subtract (region, preview);
+
+          if (! shell->render_queue)
+            shell->render_queue = cairo_region_create ();
+
+          cairo_region_union (shell->render_queue, preview);
+
+          if (! shell->render_idle_id)
+            shell->render_idle_id =
+              g_idle_add ((GSourceFunc) gimp_display_shell_render_idle, shell);
+        }
+
+      cairo_region_destroy (preview);
+    }
+
+  gimp_display_shell_render_region (shell, region);
+
+  cairo_region_destroy (region);
+}
+
+/*  Renders the given region of the cache, in cache coordinates.  */
+static void
+gimp_display_shell_render_region (GimpDisplayShell *shell,
+                                  cairo_region_t   *region)
+{
+  cairo_rectangle_int_t   rect;
+  cairo_t                *cache_cr;
+  GimpDisplayShellRender  render;
+  gboolean                parallel;
+  gint                    chunk_width;
+  gint                    chunk_height;
+  gint                    n_rects;
+  gint                    i;
+
+  n_rects = cairo_region_num_rectangles (region);
+
+  if (n_rects == 0)
+    return;
+
+  cache_cr = cairo_create (shell->render_cache);
+
+  cairo_translate (cache_cr,
+                   - shell->render_cache_rect.x,
+                   - shell->render_cache_rect.y);
+
+  gimp_display_shell_render_init (shell, &render);
+
+  /*  the rectangles can be a bit larger than the chunks the canvas
+   *  is drawn in, but the render buffers only fit chunks
+   */
+  chunk_width  = GIMP_DISPLAY_RENDER_BUF_WIDTH;
+  chunk_height = GIMP_DISPLAY_RENDER_BUF_HEIGHT;
+
+  if ((shell->scale_x / shell->scale_y) > 2.0)
+    {
+      while ((chunk_width / chunk_height) < (shell->scale_x / shell->scale_y))
+        chunk_height /= 2;
+    }
+  else if ((shell->scale_y / shell->scale_x) > 2.0)
+    {
+      while ((chunk_height / chunk_width) < (shell->scale_y / shell->scale_x))
+        chunk_width /= 2;
+    }
+
+  for (i = 0; i < n_rects; i++)
+    {
+      gint cx, cy;
+
+      cairo_region_get_rectangle (region, i, &rect);
+
+      rect.x += shell->render_cache_rect.x;
+      rect.y += shell->render_cache_rect.y;
+
+      for (cy = rect.y; cy < rect.y + rect.height; cy += chunk_height)
+        for (cx = rect.x; cx < rect.x + rect.width; cx += chunk_width)
+          {
+            gimp_display_shell_render_add_chunk (&render, cx, cy,
+                                                 MIN (rect.x + rect.width  - cx,
+                                                      chunk_width),
+                                                 MIN (rect.y + rect.height - cy,
+                                                      chunk_height));
+          }
+    }
+
+  /*  display filters are arbitrary modules, which aren't known to
+   *  be thread-safe, and share the shell's filter buffer, so they
+   *  are only ever run in the main thread
+   */
+  parallel = (render.chunks->len > 1               &&
+              gimp_parallel_get_n_threads () > 1 &&
+              ! shell->filter_stack);
+
+#ifdef USE_NODE_BLIT
+  /*  the graph can't be blitted from several threads at once  */
+  parallel = FALSE;
+#endif
+
+  if (parallel)
+    {
+      gimp_display_shell_render_chunks_parallel (shell, cache_cr, &render);
+    }
+  else
+    {
+      gimp_display_shell_render_chunks_serial (shell, cache_cr, &render);
+    }
+
+  g_array_free (render.chunks, TRUE);
+
+  cairo_destroy (cache_cr);
+
+  cairo_region_union (shell->render_cache_valid, region);
+
+  if (shell->render_cache_preview)
+    cairo_region_subtract (shell->render_cache_preview, region);
+
+  if (shell->render_queue)
+    cairo_region_subtract (shell->render_queue, region);
+}
+
+/*  Renders the queued parts of the canvas, the ones closest to the
+ *  center of the canvas first, a batch of chunks at a time, until
+ *  RENDER_IDLE_TIME has passed, and exposes them.
+ */
+static gboolean
+gimp_display_shell_render_idle (GimpDisplayShell *shell)
+{
+  cairo_rectangle_int_t  rect;
+  GArray                *chunks;
+  gint64                 end_time;
+  gint                   n_rects;
+  gint                   n_batch;
+  gint                   i;
+
+  gimp_display_shell_render_cache_get_rect (shell, &rect);
+
+  /*  the cache is updated on the next expose, which restarts the idle  */
+  if (shell->render_cache_scale_x     != shell->scale_x      ||
+      shell->render_cache_scale_y     != shell->scale_y      ||
+      shell->render_cache_angle       != shell->rotate_angle ||
+      shell->render_cache_offset_x    != shell->offset_x     ||
+      shell->render_cache_offset_y    != shell->offset_y     ||
+      shell->render_cache_rect.x      != rect.x              ||
+      shell->render_cache_rect.y      != rect.y              ||
+      shell->render_cache_rect.width  != rect.width          ||
+      shell->render_cache_rect.height != rect.height)
+    {
+      shell->render_idle_id = 0;
+
+      return FALSE;
+    }
+
+  chunks = g_array_new (FALSE, FALSE, sizeof (cairo_rectangle_int_t));
+
+  n_rects = cairo_region_num_rectangles (shell->render_queue);
+
+  for (i = 0; i < n_rects; i++)
+    {
+      cairo_rectangle_int_t queued;
+      gint                  cx, cy;
+
+      cairo_region_get_rectangle (shell->render_queue, i, &queued);
+
+      for (cy = queued.y; cy < queued.y + queued.height;
+           cy += GIMP_DISPLAY_RENDER_BUF_HEIGHT)
+        for (cx = queued.x; cx < queued.x + queued.width;
+             cx += GIMP_DISPLAY_RENDER_BUF_WIDTH)
+          {
+            cairo_rectangle_int_t chunk;
+
+            chunk.x      = cx;
+            chunk.y      = cy;
+            chunk.width  = MIN (queued.x + queued.width - cx,
+                                GIMP_DISPLAY_RENDER_BUF_WIDTH);
+            chunk.height = MIN (queued.y + queued.height - cy,
+                                GIMP_DISPLAY_RENDER_BUF_HEIGHT);
+
+            g_array_append_val (chunks, chunk);
+          }
+    }
+
+  g_qsort_with_data (chunks->data, chunks->len, sizeof (cairo_rectangle_int_t),
+                     (GCompareDataFunc) gimp_display_shell_render_chunk_compare,
+                     &rect);
+
+  /*  render as many chunks at once as there are threads to render them  */
+  n_batch  = gimp_parallel_get_n_threads ();
+  end_time = g_get_monotonic_time () + RENDER_IDLE_TIME;
+
+  for (i = 0; i < chunks->len && g_get_monotonic_time () < end_time;)
+    {
+      cairo_region_t *region = cairo_region_create ();
+      gint            n_rendered;
+      gint            j;
+
+      for (j = 0; j < n_batch && i < chunks->len; j++, i++)
+        {
+          cairo_region_union_rectangle (region,
+                                        &g_array_index (chunks,
+                                                        cairo_rectangle_int_t,
+                                                        i));
+        }
+
+      gimp_display_shell_render_region (shell, region);
+
+      n_rendered = cairo_region_num_rectangles (region);
+
+      for (j = 0; j < n_rendered; j++)
+        {
+          cairo_rectangle_int_t rendered;
+          gdouble               x1, y1, x2, y2;
+
+          cairo_region_get_rectangle (region, j, &rendered);
+
+          x1 = rendered.x + shell->render_cache_rect.x;
+          y1 = rendered.y + shell->render_cache_rect.y;
+          x2 = x1 + rendered.width;
+          y2 = y1 + rendered.height;
+
+          /*  the antialiased edges of rotated chunks, see
+           *  gimp_display_shell_render()
+           */
+          if (shell->rotate_transform)
+            {
+              gimp_display_shell_rotate_bounds (shell,
+                                                x1 - 1, y1 - 1, x2 + 1, y2 + 1,
+                                                &x1, &y1, &x2, &y2);
+            }
+
+          gimp_display_shell_expose_area (shell,
+                                          floor (x1), floor (y1),
+                                          ceil (x2) - floor (x1),
+                                          ceil (y2) - floor (y1));
+        }
+
+      cairo_region_destroy (region);
+    }
+
+  g_array_free (chunks, TRUE);
+
+  if (cairo_region_is_empty (shell->render_queue))
+    {
+      shell->render_idle_id = 0;
+
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+/*  Orders chunks by their distance from the center of the cache, which
+ *  is the center of the canvas.
+ */
+static gint
+gimp_display_shell_render_chunk_compare (const cairo_rectangle_int_t *chunk1,
+                                         const cairo_rectangle_int_t *chunk2,
+                                         const cairo_rectangle_int_t *cache_rect)
+{
+  gint center_x = cache_rect->width  / 2;
+  gint center_y = cache_rect->height / 2;
+  gint dx1      = chunk1->x + chunk1->width  / 2 - center_x;
+  gint dy1      = chunk1->y + chunk1->height / 2 - center_y;
+  gint dx2      = chunk2->x + chunk2->width  / 2 - center_x;
+  gint dy2      = chunk2->y + chunk2->height / 2 - center_y;
+  gint d1       = dx1 * dx1 + dy1 * dy1;
+  gint d2       = dx2 * dx2 + dy2 * dy2;
+
+  return (d1 > d2) - (d1 < d2);
+}
+
+/*  Computes what all chunks of one render pass have in common.  */
+static void
+gimp_display_shell_render_init (GimpDisplayShell       *shell,
+                                GimpDisplayShellRender *render)
+{
+  GimpImage *image = gimp_display_get_image (shell->display);
+  gdouble    scale = 1.0;
+  gint       viewport_width;
+  gint       viewport_height;
+
+  render->shell  = shell;
+  render->buffer = gimp_pickable_get_buffer (GIMP_PICKABLE (image));
 #ifdef USE_NODE_BLIT
-  node   = gimp_projectable_get_graph (GIMP_PROJECTABLE (image));
+  render->node   = gimp_projectable_get_graph (GIMP_PROJECTABLE (image));
 #endif
+  render->chunks = g_array_new (FALSE, FALSE,
+                                sizeof (GimpDisplayShellRenderChunk));
 
 #ifdef GIMP_DISPLAY_RENDER_ENABLE_SCALING
   /* if we had this future API, things would look pretty on hires (retina) */
-  scale_x = gdk_window_get_scale_factor (gtk_widget_get_window (gtk_widget_get_toplevel (GTK_WIDGET (shell))));
+  scale = gdk_window_get_scale_factor (gtk_widget_get_window (gtk_widget_get_toplevel (GTK_WIDGET (shell))));
 #endif
 
-  scale_x = MIN (scale_x, GIMP_DISPLAY_RENDER_MAX_SCALE);
-  scale_y = scale_x;
+  scale = MIN (scale, GIMP_DISPLAY_RENDER_MAX_SCALE);
+
+  render->scale_x = scale;
+  render->scale_y = scale;
 
   if (shell->scale_x > shell->scale_y)
     {
-      scale_y *= (shell->scale_x / shell->scale_y);
+      render->scale_y *= (shell->scale_x / shell->scale_y);
 
-      buffer_scale = shell->scale_y * scale_y;
+      render->buffer_scale = shell->scale_y * render->scale_y;
     }
   else if (shell->scale_y > shell->scale_x)
     {
-      scale_x *= (shell->scale_y / shell->scale_x);
+      render->scale_x *= (shell->scale_y / shell->scale_x);
 
-      buffer_scale = shell->scale_x * scale_x;
+      render->buffer_scale = shell->scale_x * render->scale_x;
     }
   else
     {
-      buffer_scale = shell->scale_x * scale_x;
+      render->buffer_scale = shell->scale_x * render->scale_x;
     }
 
   gimp_display_shell_scroll_get_scaled_viewport (shell,
-                                                 &viewport_offset_x,
-                                                 &viewport_offset_y,
+                                                 &render->viewport_offset_x,
+                                                 &render->viewport_offset_y,
                                                  &viewport_width,
                                                  &viewport_height);
+}
+
+static void
+gimp_display_shell_render_add_chunk (GimpDisplayShellRender *render,
+                                     gint                    x,
+                                     gint                    y,
+                                     gint                    w,
+                                     gint                    h)
+{
+  GimpDisplayShellRenderChunk chunk = { 0, };
 
-  scaled_x      = floor ((x + viewport_offset_x) * scale_x);
-  scaled_y      = floor ((y + viewport_offset_y) * scale_y);
-  scaled_width  = ceil (w * scale_x);
-  scaled_height = ceil (h * scale_y);
+  chunk.x             = x;
+  chunk.y             = y;
+  chunk.w             = w;
+  chunk.h             = h;
+  chunk.scaled_x      = floor ((x + render->viewport_offset_x) * render->scale_x);
+  chunk.scaled_y      = floor ((y + render->viewport_offset_y) * render->scale_y);
+  chunk.scaled_width  = ceil (w * render->scale_x);
+  chunk.scaled_height = ceil (h * render->scale_y);
 
-  if (shell->rotate_transform)
+  g_array_append_val (render->chunks, chunk);
+}
+
+/*  Renders the chunks one after the other, through the shell's
+ *  transfer buffers.
+ */
+static void
+gimp_display_shell_render_chunks_serial (GimpDisplayShell       *shell,
+                                         cairo_t                *cr,
+                                         GimpDisplayShellRender *render)
+{
+  gint i;
+
+  for (i = 0; i < render->chunks->len; i++)
+    {
+      GimpDisplayShellRenderChunk *chunk;
+
+      chunk = &g_array_index (render->chunks, GimpDisplayShellRenderChunk, i);
+
+      chunk->surface = gimp_display_xfer_get_surface (shell->xfer,
+                                                      chunk->scaled_width,
+                                                      chunk->scaled_height,
+                                                      &chunk->src_x,
+                                                      &chunk->src_y);
+
+      if (shell->mask)
+        {
+          if (! shell->mask_surface)
+            {
+              shell->mask_surface =
+                cairo_image_surface_create (CAIRO_FORMAT_A8,
+                                            GIMP_DISPLAY_RENDER_BUF_WIDTH  *
+                                            GIMP_DISPLAY_RENDER_MAX_SCALE,
+                                            GIMP_DISPLAY_RENDER_BUF_HEIGHT *
+                                            GIMP_DISPLAY_RENDER_MAX_SCALE);
+            }
+
+          chunk->mask_surface = shell->mask_surface;
+        }
+
+      gimp_display_shell_render_chunk_fetch (render, chunk);
+      gimp_display_shell_render_chunk_paint (render, cr, chunk);
+    }
+}
+
+/*  Fetches the pixels of all chunks in parallel, each into its own
+ *  surfaces, and only paints them to the cache in the main thread.
+ *  Reading the projection validates its tiles, which GEGL serializes,
+ *  but the scaling and format conversion of the chunks run
+ *  concurrently.
+ */
+static void
+gimp_display_shell_render_chunks_parallel (GimpDisplayShell       *shell,
+                                           cairo_t                *cr,
+                                           GimpDisplayShellRender *render)
+{
+  gint i;
+
+  for (i = 0; i < render->chunks->len; i++)
     {
-      xfer = cairo_surface_create_similar_image (cairo_get_target (cr),
-                                                 CAIRO_FORMAT_ARGB32,
-                                                 scaled_width,
-                                                 scaled_height);
-      cairo_surface_mark_dirty (xfer);
-      xfer_src_x = 0;
-      xfer_src_y = 0;
+      GimpDisplayShellRenderChunk *chunk;
+
+      chunk = &g_array_index (render->chunks, GimpDisplayShellRenderChunk, i);
+
+      chunk->surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32,
+                                                   chunk->scaled_width,
+                                                   chunk->scaled_height);
+
+      if (shell->mask)
+        chunk->mask_surface = cairo_image_surface_create (CAIRO_FORMAT_A8,
+                                                          chunk->scaled_width,
+                                                          chunk->scaled_height);
     }
-  else
+
+  gimp_parallel_distribute (render->chunks->len,
+                            (GimpParallelDistributeFunc)
+                            gimp_display_shell_render_chunks_func,
+                            render);
+
+  for (i = 0; i < render->chunks->len; i++)
+    {
+      GimpDisplayShellRenderChunk *chunk;
+
+      chunk = &g_array_index (render->chunks, GimpDisplayShellRenderChunk, i);
+
+      gimp_display_shell_render_chunk_paint (render, cr, chunk);
+
+      cairo_surface_destroy (chunk->surface);
+
+      if (chunk->mask_surface)
+        cairo_surface_destroy (chunk->mask_surface);
+    }
+}
+
+static void
+gimp_display_shell_render_chunks_func (gint                    i,
+                                       gint                    n,
+                                       GimpDisplayShellRender *render)
+{
+  gint first = (gint64) render->chunks->len * i       / n;
+  gint last  = (gint64) render->chunks->len * (i + 1) / n;
+
+  for (; first < last; first++)
     {
-      xfer = gimp_display_xfer_get_surface (shell->xfer,
-                                            scaled_width,
-                                            scaled_height,
-                                            &xfer_src_x,
-                                            &xfer_src_y);
+      gimp_display_shell_render_chunk_fetch (render,
+                                             &g_array_index (render->chunks,
+                                                             GimpDisplayShellRenderChunk,
+                                                             first));
     }
+}
+
+/*  Reads the chunk's pixels, and its mask, into its surfaces.  Doesn't
+ *  touch anything but the chunk when there is no filter stack, so it
+ *  can run in any thread.
+ */
+static void
+gimp_display_shell_render_chunk_fetch (GimpDisplayShellRender      *render,
+                                       GimpDisplayShellRenderChunk *chunk)
+{
+  GimpDisplayShell *shell = render->shell;
+  gint              stride;
+  guchar           *data;
+
+  cairo_surface_flush (chunk->surface);
 
-  stride = cairo_image_surface_get_stride (xfer);
-  data = cairo_image_surface_get_data (xfer);
-  data += xfer_src_y * stride + xfer_src_x * 4;
+  stride = cairo_image_surface_get_stride (chunk->surface);
+  data = cairo_image_surface_get_data (chunk->surface);
+  data += chunk->src_y * stride + chunk->src_x * 4;
 
   /*  apply filters to the rendered projection  */
   if (shell->filter_stack)
@@ -175,18 +1077,18 @@ gimp_display_shell_render (GimpDisplayShell *shell,
         }
 
 #ifndef USE_NODE_BLIT
-      gegl_buffer_get (buffer,
-                       GEGL_RECTANGLE (scaled_x, scaled_y,
-                                       scaled_width, scaled_height),
-                       buffer_scale,
+      gegl_buffer_get (render->buffer,
+                       GEGL_RECTANGLE (chunk->scaled_x, chunk->scaled_y,
+                                       chunk->scaled_width, chunk->scaled_height),
+                       render->buffer_scale,
                        filter_format,
                        shell->filter_data, shell->filter_stride,
                        GEGL_ABYSS_CLAMP);
 #else
-      gegl_node_blit (node,
-                      buffer_scale,
-                      GEGL_RECTANGLE (scaled_x, scaled_y,
-                                      scaled_width, scaled_height),
+      gegl_node_blit (render->node,
+                      render->buffer_scale,
+                      GEGL_RECTANGLE (chunk->scaled_x, chunk->scaled_y,
+                                      chunk->scaled_width, chunk->scaled_height),
                       filter_format,
                       shell->filter_data, shell->filter_stride,
                       GEGL_BLIT_CACHE);
@@ -195,13 +1097,13 @@ gimp_display_shell_render (GimpDisplayShell *shell,
       gimp_color_display_stack_convert_buffer (shell->filter_stack,
                                                shell->filter_buffer,
                                                GEGL_RECTANGLE (0, 0,
-                                                               scaled_width,
-                                                               scaled_height));
+                                                               chunk->scaled_width,
+                                                               chunk->scaled_height));
 
       gegl_buffer_get (shell->filter_buffer,
                        GEGL_RECTANGLE (0, 0,
-                                       scaled_width,
-                                       scaled_height),
+                                       chunk->scaled_width,
+                                       chunk->scaled_height),
                        1.0,
                        babl_format ("cairo-ARGB32"),
                        data, stride,
@@ -210,57 +1112,52 @@ gimp_display_shell_render (GimpDisplayShell *shell,
   else
     {
 #ifndef USE_NODE_BLIT
-      gegl_buffer_get (buffer,
-                       GEGL_RECTANGLE (scaled_x, scaled_y,
-                                       scaled_width, scaled_height),
-                       buffer_scale,
+      gegl_buffer_get (render->buffer,
+                       GEGL_RECTANGLE (chunk->scaled_x, chunk->scaled_y,
+                                       chunk->scaled_width, chunk->scaled_height),
+                       render->buffer_scale,
                        babl_format ("cairo-ARGB32"),
                        data, stride,
                        GEGL_ABYSS_CLAMP);
 #else
-      gegl_node_blit (node,
-                      buffer_scale,
-                      GEGL_RECTANGLE (scaled_x, scaled_y,
-                                      scaled_width, scaled_height),
+      gegl_node_blit (render->node,
+                      render->buffer_scale,
+                      GEGL_RECTANGLE (chunk->scaled_x, chunk->scaled_y,
+                                      chunk->scaled_width, chunk->scaled_height),
                       babl_format ("cairo-ARGB32"),
                       data, stride,
                       GEGL_BLIT_CACHE);
 #endif
     }
 
-  if (shell->mask)
-    {
-      if (! shell->mask_surface)
-        {
-          shell->mask_surface =
-            cairo_image_surface_create (CAIRO_FORMAT_A8,
-                                        GIMP_DISPLAY_RENDER_BUF_WIDTH  *
-                                        GIMP_DISPLAY_RENDER_MAX_SCALE,
-                                        GIMP_DISPLAY_RENDER_BUF_HEIGHT *
-                                        GIMP_DISPLAY_RENDER_MAX_SCALE);
-        }
+  cairo_surface_mark_dirty (chunk->surface);
 
-      cairo_surface_mark_dirty (shell->mask_surface);
+  chunk->opaque = gimp_display_shell_render_is_opaque (data, stride,
+                                                       chunk->scaled_width,
+                                                       chunk->scaled_height);
 
-      stride = cairo_image_surface_get_stride (shell->mask_surface);
-      data = cairo_image_surface_get_data (shell->mask_surface);
-      data += mask_src_y * stride + mask_src_x * 4;
+  if (chunk->mask_surface)
+    {
+      cairo_surface_flush (chunk->mask_surface);
+
+      stride = cairo_image_surface_get_stride (chunk->mask_surface);
+      data = cairo_image_surface_get_data (chunk->mask_surface);
 
       gegl_buffer_get (shell->mask,
-                       GEGL_RECTANGLE (scaled_x, scaled_y,
-                                       scaled_width, scaled_height),
-                       buffer_scale,
+                       GEGL_RECTANGLE (chunk->scaled_x, chunk->scaled_y,
+                                       chunk->scaled_width, chunk->scaled_height),
+                       render->buffer_scale,
                        babl_format ("Y u8"),
                        data, stride,
                        GEGL_ABYSS_CLAMP);
 
       if (shell->mask_inverted)
         {
-          gint mask_height = scaled_height;
+          gint mask_height = chunk->scaled_height;
 
           while (mask_height--)
             {
-              gint    mask_width = scaled_width;
+              gint    mask_width = chunk->scaled_width;
               guchar *d          = data;
 
               while (mask_width--)
@@ -273,42 +1170,78 @@ gimp_display_shell_render (GimpDisplayShell *shell,
               data += stride;
             }
         }
+
+      cairo_surface_mark_dirty (chunk->mask_surface);
     }
+}
+
+static void
+gimp_display_shell_render_chunk_paint (GimpDisplayShellRender      *render,
+                                       cairo_t                     *cr,
+                                       GimpDisplayShellRenderChunk *chunk)
+{
+  GimpDisplayShell *shell = render->shell;
 
   /*  put it to the screen  */
   cairo_save (cr);
 
-  cairo_rectangle (cr, x, y, w, h);
-
-  cairo_scale (cr, 1.0 / scale_x, 1.0 / scale_y);
-
-  cairo_set_source_surface (cr, xfer,
-                            x * scale_x - xfer_src_x,
-                            y * scale_y - xfer_src_y);
+  cairo_rectangle (cr, chunk->x, chunk->y, chunk->w, chunk->h);
+  cairo_clip (cr);
 
-  if (shell->rotate_transform)
+  /*  the checks only show through where the projection is not opaque,
+   *  and most chunks of most images are opaque
+   */
+  if (! chunk->opaque)
     {
-      cairo_pattern_t *pattern;
+      cairo_save (cr);
+      gimp_display_shell_draw_checkerboard (shell, cr);
+      cairo_restore (cr);
+    }
 
-      pattern = cairo_get_source (cr);
-      cairo_pattern_set_extend (pattern, CAIRO_EXTEND_PAD);
+  cairo_scale (cr, 1.0 / render->scale_x, 1.0 / render->scale_y);
 
-      cairo_set_line_width (cr, 1.0);
-      cairo_stroke_preserve (cr);
+  cairo_set_source_surface (cr, chunk->surface,
+                            chunk->x * render->scale_x - chunk->src_x,
+                            chunk->y * render->scale_y - chunk->src_y);
 
-      cairo_surface_destroy (xfer);
-    }
+  if (chunk->opaque)
+    cairo_set_operator (cr, CAIRO_OPERATOR_SOURCE);
 
-  cairo_clip (cr);
   cairo_paint (cr);
 
-  if (shell->mask)
+  if (chunk->mask_surface)
     {
+      cairo_set_operator (cr, CAIRO_OPERATOR_OVER);
+
       gimp_cairo_set_source_rgba (cr, &shell->mask_color);
-      cairo_mask_surface (cr, shell->mask_surface,
-                          (x - mask_src_x) * scale_x,
-                          (y - mask_src_y) * scale_y);
+      cairo_mask_surface (cr, chunk->mask_surface,
+                          chunk->x * render->scale_x,
+                          chunk->y * render->scale_y);
     }
 
   cairo_restore (cr);
 }
+
+static gboolean
+gimp_display_shell_render_is_opaque (const guchar *data,
+                                     gint          stride,
+                                     gint          width,
+                                     gint          height)
+{
+  while (height--)
+    {
+      const guint32 *pixel = (const guint32 *) data;
+      gint           x;
+
+      /*  cairo's ARGB32 pixels are native endian, alpha is on top  */
+      for (x = 0; x < width; x++)
+        {
+          if ((pixel[x] & 0xff000000) != 0xff000000)
+            return FALSE;
+        }
+
+      data += stride;
+    }
+
+  return TRUE;
+}
@@ -33,7 +33,6 @@
 
 #include "gimpdisplay.h"
 #include "gimpdisplayshell.h"
-#include "gimpdisplayshell-expose.h"
 #include "gimpdisplayshell-scale.h"
 #include "gimpdisplayshell-scroll.h"
 #include "gimpdisplayshell-transform.h"
@@ -735,7 +734,10 @@ gimp_display_shell_scale_resize (GimpDisplayShell *shell,
   gimp_display_shell_scroll_clamp_and_update (shell);
   gimp_display_shell_scaled (shell);
 
-  gimp_display_shell_expose_full (shell);
+  /*  gimp_display_shell_scaled() invalidated the rendering, but kept
+   *  it to show scaled until the new scale is rendered
+   */
+  gtk_widget_queue_draw (shell->canvas);
 
   /* re-enable the active tool */
   gimp_display_shell_resume (shell);
@@ -20,6 +20,8 @@
 #include <gegl.h>
 #include <gtk/gtk.h>
 
+#include "libgimpmath/gimpmath.h"
+
 #include "display-types.h"
 
 #include "config/gimpdisplayconfig.h"
@@ -39,22 +41,52 @@
 #include "gimpdisplayshell-transform.h"
 
 
+/*  height of the bands of image rows the boundary segments are sorted
+ *  into, for finding the ones in the visible part of the image
+ */
+#define BAND_HEIGHT 64
+
+
+typedef struct _SelectionBound SelectionBound;
+
+struct _SelectionBound
+{
+  GimpBoundSeg     *segs;             /*  image space segments, by band     */
+  gint              n_segs;
+  gint             *band_start;       /*  first segment of each band        */
+  gint             *band_y2;          /*  lowest y reached by each band     */
+  gint              n_bands;
+};
+
 struct _Selection
 {
   GimpDisplayShell *shell;            /*  shell that owns the selection     */
 
+  SelectionBound   *bound_in;         /*  image space boundary of the mask  */
+  SelectionBound   *bound_out;
+
   GimpSegment      *segs_in;          /*  gdk segments of area boundary     */
   gint              n_segs_in;        /*  number of segments in segs_in     */
 
   GimpSegment      *segs_out;         /*  gdk segments of area boundary     */
   gint              n_segs_out;       /*  number of segments in segs_out    */
 
+  gboolean          segs_valid;       /*  segs match the view state below   */
+  gdouble           segs_scale_x;
+  gdouble           segs_scale_y;
+  gdouble           segs_angle;
+  gint              segs_offset_x;
+  gint              segs_offset_y;
+  gint              segs_width;
+  gint              segs_height;
+
   guint             index;            /*  index of current stipple pattern  */
   gint              paused;           /*  count of pause requests           */
   gboolean          shell_visible;    /*  visility of the display shell     */
   gboolean          show_selection;   /*  is the selection visible?         */
   guint             timeout;          /*  timer for successive draws        */
   cairo_pattern_t  *segs_in_mask;     /*  cache for rendered segments       */
+  GdkRectangle      segs_in_extents;  /*  canvas area of segs_in_mask       */
 };
 
 
@@ -68,10 +100,25 @@ static void      selection_undraw         (Selection          *selection);
 
 static void      selection_render_mask    (Selection          *selection);
 
+static SelectionBound *
+                 selection_bound_new      (const GimpBoundSeg *segs,
+                                           gint                n_segs);
+static void      selection_bound_free     (SelectionBound     *bound);
+static GimpBoundSeg *
+                 selection_bound_visible  (SelectionBound     *bound,
+                                           gint                x1,
+                                           gint                y1,
+                                           gint                x2,
+                                           gint                y2,
+                                           gint               *n_segs);
+
 static void      selection_zoom_segs      (Selection          *selection,
                                            const GimpBoundSeg *src_segs,
                                            GimpSegment        *dest_segs,
                                            gint                n_segs);
+static void      selection_create_bounds  (Selection          *selection);
+static void      selection_free_bounds    (Selection          *selection);
+static gboolean  selection_segs_are_valid (Selection          *selection);
 static void      selection_generate_segs  (Selection          *selection);
 static void      selection_free_segs      (Selection          *selection);
 
@@ -132,6 +179,7 @@ gimp_display_shell_selection_free (GimpDisplayShell *shell)
                                         selection);
 
   selection_free_segs (selection);
+  selection_free_bounds (selection);
 
   g_slice_free (Selection, selection);
 
@@ -144,6 +192,10 @@ gimp_display_shell_selection_undraw (GimpDisplayShell *shell)
   g_return_if_fail (GIMP_IS_DISPLAY_SHELL (shell));
   g_return_if_fail (shell->selection != NULL);
 
+  /*  the mask changed, or the image went away  */
+  selection_free_segs (shell->selection);
+  selection_free_bounds (shell->selection);
+
   if (gimp_display_get_image (shell->display))
     {
       selection_undraw (shell->selection);
@@ -151,7 +203,6 @@ gimp_display_shell_selection_undraw (GimpDisplayShell *shell)
   else
     {
       selection_stop (shell->selection);
-      selection_free_segs (shell->selection);
     }
 }
 
@@ -254,6 +305,10 @@ selection_draw (Selection *selection)
 
       cr = gdk_cairo_create (gtk_widget_get_window (selection->shell->canvas));
 
+      /*  only touch the part of the canvas the ants are in  */
+      gdk_cairo_rectangle (cr, &selection->segs_in_extents);
+      cairo_clip (cr);
+
       gimp_display_shell_draw_selection_in (selection->shell, cr,
                                             selection->segs_in_mask,
                                             selection->index % 8);
@@ -287,6 +342,7 @@ selection_render_mask (Selection *selection)
   GdkWindow       *window;
   cairo_surface_t *surface;
   cairo_t         *cr;
+  gdouble          x1, y1, x2, y2;
 
   window = gtk_widget_get_window (selection->shell->canvas);
   surface = gdk_window_create_similar_surface (window, CAIRO_CONTENT_ALPHA,
@@ -303,6 +359,18 @@ selection_render_mask (Selection *selection)
   gimp_cairo_add_segments (cr,
                            selection->segs_in,
                            selection->n_segs_in);
+
+  /*  the path is kept in device space, get its extents there  */
+  cairo_save (cr);
+  cairo_identity_matrix (cr);
+  cairo_stroke_extents (cr, &x1, &y1, &x2, &y2);
+  cairo_restore (cr);
+
+  selection->segs_in_extents.x      = floor (x1) - 1;
+  selection->segs_in_extents.y      = floor (y1) - 1;
+  selection->segs_in_extents.width  = ceil (x2) + 1 - selection->segs_in_extents.x;
+  selection->segs_in_extents.height = ceil (y2) + 1 - selection->segs_in_extents.y;
+
   cairo_stroke (cr);
 
   selection->segs_in_mask = cairo_pattern_create_for_surface (surface);
@@ -355,50 +423,227 @@ selection_zoom_segs (Selection          *selection,
     }
 }
 
+static SelectionBound *
+selection_bound_new (const GimpBoundSeg *segs,
+                     gint                n_segs)
+{
+  SelectionBound *bound;
+  gint            max_y = 0;
+  gint           *next;
+  gint            i;
+
+  bound = g_slice_new0 (SelectionBound);
+
+  for (i = 0; i < n_segs; i++)
+    max_y = MAX (max_y, MAX (segs[i].y1, segs[i].y2));
+
+  bound->n_segs     = n_segs;
+  bound->segs       = g_new (GimpBoundSeg, n_segs);
+  bound->n_bands    = max_y / BAND_HEIGHT + 1;
+  bound->band_start = g_new0 (gint, bound->n_bands + 1);
+  bound->band_y2    = g_new (gint, bound->n_bands);
+
+  for (i = 0; i < bound->n_bands; i++)
+    bound->band_y2[i] = G_MININT;
+
+  /*  sort the segments into bands by their top, and remember how far
+   *  down each band's segments reach
+   */
+  for (i = 0; i < n_segs; i++)
+    {
+      gint band = MIN (segs[i].y1, segs[i].y2) / BAND_HEIGHT;
+
+      bound->band_start[band + 1]++;
+      bound->band_y2[band] = MAX (bound->band_y2[band],
+                                  MAX (segs[i].y1, segs[i].y2));
+    }
+
+  for (i = 0; i < bound->n_bands; i++)
+    bound->band_start[i + 1] += bound->band_start[i];
+
+  next = g_memdup (bound->band_start, bound->n_bands * sizeof (gint));
+
+  for (i = 0; i < n_segs; i++)
+    {
+      gint band = MIN (segs[i].y1, segs[i].y2) / BAND_HEIGHT;
+
+      bound->segs[next[band]++] = segs[i];
+    }
+
+  g_free (next);
+
+  return bound;
+}
+
 static void
-selection_generate_segs (Selection *selection)
+selection_bound_free (SelectionBound *bound)
+{
+  g_free (bound->segs);
+  g_free (bound->band_start);
+  g_free (bound->band_y2);
+
+  g_slice_free (SelectionBound, bound);
+}
+
+static GimpBoundSeg *
+selection_bound_visible (SelectionBound *bound,
+                         gint            x1,
+                         gint            y1,
+                         gint            x2,
+                         gint            y2,
+                         gint           *n_segs)
+{
+  GimpBoundSeg *segs;
+  gint          last_band;
+  gint          band;
+  gint          n = 0;
+
+  segs = g_new (GimpBoundSeg, bound->n_segs);
+
+  last_band = CLAMP (y2 / BAND_HEIGHT, -1, bound->n_bands - 1);
+
+  for (band = 0; band <= last_band; band++)
+    {
+      gint i;
+
+      if (bound->band_y2[band] < y1)
+        continue;
+
+      for (i = bound->band_start[band]; i < bound->band_start[band + 1]; i++)
+        {
+          const GimpBoundSeg *seg = &bound->segs[i];
+
+          if (MAX (seg->x1, seg->x2) >= x1 && MIN (seg->x1, seg->x2) <= x2 &&
+              MAX (seg->y1, seg->y2) >= y1 && MIN (seg->y1, seg->y2) <= y2)
+            {
+              segs[n++] = *seg;
+            }
+        }
+    }
+
+  *n_segs = n;
+
+  return segs;
+}
+
+static void
+selection_create_bounds (Selection *selection)
 {
   GimpImage          *image = gimp_display_get_image (selection->shell->display);
   const GimpBoundSeg *segs_in;
   const GimpBoundSeg *segs_out;
+  gint                n_segs_in;
+  gint                n_segs_out;
 
-  /*  Ask the image for the boundary of its selected region...
-   *  Then transform that information into a new buffer of GimpSegments
+  /*  Ask the image for the boundary of its selected region, and keep
+   *  it until the mask changes
    */
   gimp_channel_boundary (gimp_image_get_mask (image),
                          &segs_in, &segs_out,
-                         &selection->n_segs_in, &selection->n_segs_out,
+                         &n_segs_in, &n_segs_out,
                          0, 0, 0, 0);
 
-  if (selection->n_segs_in)
+  selection->bound_in  = selection_bound_new (segs_in,  n_segs_in);
+  selection->bound_out = selection_bound_new (segs_out, n_segs_out);
+}
+
+static void
+selection_free_bounds (Selection *selection)
+{
+  if (selection->bound_in)
     {
-      selection->segs_in = g_new (GimpSegment, selection->n_segs_in);
-      selection_zoom_segs (selection, segs_in,
-                           selection->segs_in, selection->n_segs_in);
+      selection_bound_free (selection->bound_in);
+      selection->bound_in = NULL;
+    }
 
-      selection_render_mask (selection);
+  if (selection->bound_out)
+    {
+      selection_bound_free (selection->bound_out);
+      selection->bound_out = NULL;
     }
-  else
+}
+
+static gboolean
+selection_segs_are_valid (Selection *selection)
+{
+  GimpDisplayShell *shell = selection->shell;
+
+  return (selection->segs_valid                          &&
+          selection->segs_scale_x  == shell->scale_x      &&
+          selection->segs_scale_y  == shell->scale_y      &&
+          selection->segs_angle    == shell->rotate_angle &&
+          selection->segs_offset_x == shell->offset_x     &&
+          selection->segs_offset_y == shell->offset_y     &&
+          selection->segs_width    == shell->disp_width   &&
+          selection->segs_height   == shell->disp_height);
+}
+
+static void
+selection_generate_segs (Selection *selection)
+{
+  GimpDisplayShell *shell = selection->shell;
+  GimpBoundSeg     *segs;
+  gdouble           x1, y1, x2, y2;
+  gint              n_segs;
+
+  /*  only transform the segments in the visible part of the image
+   *  into a new buffer of GimpSegments
+   */
+  gimp_display_shell_untransform_bounds (shell,
+                                         0, 0,
+                                         shell->disp_width,
+                                         shell->disp_height,
+                                         &x1, &y1, &x2, &y2);
+
+  x1 = floor (x1) - 1;
+  y1 = floor (y1) - 1;
+  x2 = ceil (x2) + 1;
+  y2 = ceil (y2) + 1;
+
+  segs = selection_bound_visible (selection->bound_in,
+                                  x1, y1, x2, y2, &n_segs);
+
+  if (n_segs)
     {
-      selection->segs_in = NULL;
+      selection->segs_in   = g_new (GimpSegment, n_segs);
+      selection->n_segs_in = n_segs;
+      selection_zoom_segs (selection, segs,
+                           selection->segs_in, selection->n_segs_in);
+
+      selection_render_mask (selection);
     }
 
+  g_free (segs);
+
   /*  Possible secondary boundary representation  */
-  if (selection->n_segs_out)
+  segs = selection_bound_visible (selection->bound_out,
+                                  x1, y1, x2, y2, &n_segs);
+
+  if (n_segs)
     {
-      selection->segs_out = g_new (GimpSegment, selection->n_segs_out);
-      selection_zoom_segs (selection, segs_out,
+      selection->segs_out   = g_new (GimpSegment, n_segs);
+      selection->n_segs_out = n_segs;
+      selection_zoom_segs (selection, segs,
                            selection->segs_out, selection->n_segs_out);
     }
-  else
-    {
-      selection->segs_out = NULL;
-    }
+
+  g_free (segs);
+
+  selection->segs_valid    = TRUE;
+  selection->segs_scale_x  = shell->scale_x;
+  selection->segs_scale_y  = shell->scale_y;
+  selection->segs_angle    = shell->rotate_angle;
+  selection->segs_offset_x = shell->offset_x;
+  selection->segs_offset_y = shell->offset_y;
+  selection->segs_width    = shell->disp_width;
+  selection->segs_height   = shell->disp_height;
 }
 
 static void
 selection_free_segs (Selection *selection)
 {
+  selection->segs_valid = FALSE;
+
   if (selection->segs_in)
     {
       g_free (selection->segs_in);
@@ -423,15 +668,27 @@ selection_free_segs (Selection *selection)
 static gboolean
 selection_start_timeout (Selection *selection)
 {
-  selection_free_segs (selection);
   selection->timeout = 0;
 
   if (! gimp_display_get_image (selection->shell->display))
-    return FALSE;
+    {
+      selection_free_segs (selection);
+      selection_free_bounds (selection);
+
+      return FALSE;
+    }
 
-  selection_generate_segs (selection);
+  if (! selection->bound_in)
+    selection_create_bounds (selection);
 
-  selection->index = 0;
+  /*  the segments only need transforming again if the view changed,
+   *  not for every expose of the canvas
+   */
+  if (! selection_segs_are_valid (selection))
+    {
+      selection_free_segs (selection);
+      selection_generate_segs (selection);
+    }
 
   /*  Draw the ants  */
   if (selection->show_selection)
@@ -224,12 +224,54 @@ gimp_display_shell_unzoom_xy_f (const GimpDisplayShell *shell,
   *ny = (y + shell->offset_y) / shell->scale_y;
 }
 
+/**
+ * gimp_display_shell_zoom_points:
+ * @shell:       a #GimpDisplayShell
+ * @src_points:  array of points in image coordinates
+ * @dest_points: returns the corresponding points in display coordinates
+ * @n_points:    number of points
+ *
+ * Zooms an array of points from image coordinates to display shell
+ * canvas coordinates, like gimp_display_shell_zoom_xy_f() does for
+ * a single point.  @src_points and @dest_points may be the same.
+ **/
+void
+gimp_display_shell_zoom_points (const GimpDisplayShell *shell,
+                                const GimpVector2      *src_points,
+                                GimpVector2            *dest_points,
+                                gint                    n_points)
+{
+  gdouble scale_x;
+  gdouble scale_y;
+  gdouble offset_x;
+  gdouble offset_y;
+  gint    i;
+
+  g_return_if_fail (GIMP_IS_DISPLAY_SHELL (shell));
+  g_return_if_fail (src_points != NULL || n_points == 0);
+  g_return_if_fail (dest_points != NULL || n_points == 0);
+
+  /*  read the transform once, not once per point  */
+  scale_x  = shell->scale_x;
+  scale_y  = shell->scale_y;
+  offset_x = shell->offset_x;
+  offset_y = shell->offset_y;
+
+  for (i = 0; i < n_points; i++)
+    {
+      dest_points[i].x = PROJ_ROUND (src_points[i].x * scale_x) - offset_x;
+      dest_points[i].y = PROJ_ROUND (src_points[i].y * scale_y) - offset_y;
+    }
+}
+
 /**
  * gimp_display_shell_zoom_segments:
  * @shell:       a #GimpDisplayShell
  * @src_segs:    array of segments in image coordinates
  * @dest_segs:   returns the corresponding segments in display coordinates
  * @n_segs:      number of segments
+ * @offset_x:    offset to add to the segments' x coordinates
+ * @offset_y:    offset to add to the segments' y coordinates
  *
  * Zooms from image coordinates to display coordinates, so that
  * objects can be rendered at the correct points on the display.
@@ -242,24 +284,30 @@ gimp_display_shell_zoom_segments (const GimpDisplayShell *shell,
                                   gdouble                 offset_x,
                                   gdouble                 offset_y)
 {
-  gint i;
+  gdouble scale_x;
+  gdouble scale_y;
+  gint    shell_offset_x;
+  gint    shell_offset_y;
+  gint    i;
 
   g_return_if_fail (GIMP_IS_DISPLAY_SHELL (shell));
 
+  /*  read the transform once, not once per segment  */
+  scale_x        = shell->scale_x;
+  scale_y        = shell->scale_y;
+  shell_offset_x = shell->offset_x;
+  shell_offset_y = shell->offset_y;
+
   for (i = 0; i < n_segs ; i++)
     {
-      gdouble x1, x2;
-      gdouble y1, y2;
-
-      x1 = src_segs[i].x1 + offset_x;
-      x2 = src_segs[i].x2 + offset_x;
-      y1 = src_segs[i].y1 + offset_y;
-      y2 = src_segs[i].y2 + offset_y;
-
-      dest_segs[i].x1 = SCALEX (shell, x1) - shell->offset_x;
-      dest_segs[i].x2 = SCALEX (shell, x2) - shell->offset_x;
-      dest_segs[i].y1 = SCALEY (shell, y1) - shell->offset_y;
-      dest_segs[i].y2 = SCALEY (shell, y2) - shell->offset_y;
+      dest_segs[i].x1 = (PROJ_ROUND ((src_segs[i].x1 + offset_x) * scale_x) -
+                         shell_offset_x);
+      dest_segs[i].x2 = (PROJ_ROUND ((src_segs[i].x2 + offset_x) * scale_x) -
+                         shell_offset_x);
+      dest_segs[i].y1 = (PROJ_ROUND ((src_segs[i].y1 + offset_y) * scale_y) -
+                         shell_offset_y);
+      dest_segs[i].y2 = (PROJ_ROUND ((src_segs[i].y2 + offset_y) * scale_y) -
+                         shell_offset_y);
     }
 }
 
@@ -53,6 +53,10 @@ void  gimp_display_shell_unzoom_xy_f          (const GimpDisplayShell *shell,
                                                gdouble                *nx,
                                                gdouble                *ny);
 
+void  gimp_display_shell_zoom_points          (const GimpDisplayShell *shell,
+                                               const GimpVector2      *src_points,
+                                               GimpVector2            *dest_points,
+                                               gint                    n_points);
 void  gimp_display_shell_zoom_segments        (const GimpDisplayShell *shell,
                                                const GimpBoundSeg     *src_segs,
                                                GimpSegment            *dest_segs,
@@ -806,6 +806,8 @@ gimp_display_shell_dispose (GObject *object)
       shell->checkerboard = NULL;
     }
 
+  gimp_display_shell_render_invalidate_full (shell);
+
   if (shell->filter_buffer)
     {
       g_object_unref (shell->filter_buffer);
@@ -1554,6 +1556,7 @@ gimp_display_shell_scaled (GimpDisplayShell *shell)
   g_return_if_fail (GIMP_IS_DISPLAY_SHELL (shell));
 
   gimp_display_shell_rotate_update_transform (shell);
+  gimp_display_shell_render_invalidate_scale (shell);
 
   for (list = shell->children; list; list = g_list_next (list))
     {
@@ -114,6 +114,19 @@ struct _GimpDisplayShell
   cairo_surface_t   *mask_surface;     /*  buffer for rendering the mask      */
   cairo_pattern_t   *checkerboard;     /*  checkerboard pattern               */
 
+  cairo_surface_t   *render_cache;     /*  server-side copy of the rendering  */
+  cairo_region_t    *render_cache_valid; /*  valid area of render_cache     */
+  cairo_rectangle_int_t render_cache_rect; /*  unrotated canvas area cached */
+  gint               render_cache_offset_x; /*  offsets it was rendered at  */
+  gint               render_cache_offset_y;
+  gdouble            render_cache_scale_x;  /*  scale and rotation it was   */
+  gdouble            render_cache_scale_y;  /*  rendered with               */
+  gdouble            render_cache_angle;
+  cairo_region_t    *render_cache_preview; /*  area holding pixels scaled  */
+                                           /*  from an earlier zoom level  */
+  cairo_region_t    *render_queue;     /*  preview area still to render       */
+  guint              render_idle_id;   /*  progressive render idle ID         */
+
   GeglBuffer        *filter_buffer;    /*  buffer for display filters         */
   guchar            *filter_data;      /*  filter_buffer's pixels             */
   gint               filter_stride;    /*  filter_buffer's stride             */
@@ -27,9 +27,16 @@
 
 #include "gimpdisplayxfer.h"
 
+#include "gimp-log.h"
+
 
 #define NUM_PAGES 2
 
+/*  the rtree nodes come from a fixed pool, when it runs out we just
+ *  switch to the next page, as if it was full
+ */
+#define NUM_NODES 1024
+
 typedef struct _RTree     RTree;
 typedef struct _RTreeNode RTreeNode;
 
@@ -44,6 +51,9 @@ struct _RTree
 {
   RTreeNode  root;
   RTreeNode *available;
+
+  RTreeNode  nodes[NUM_NODES];
+  gint       n_nodes;
 };
 
 struct _GimpDisplayXfer
@@ -52,6 +62,13 @@ struct _GimpDisplayXfer
   RTree            rtree;
   cairo_surface_t *render_surface[NUM_PAGES];
   gint             page;
+
+  /* statistics, see the "display-xfer" log domain */
+  guint64          n_requests;
+  guint64          n_pixels;
+  guint64          n_page_flips;
+  guint64          n_pool_exhausted;
+  gint             max_nodes;
 };
 
 
@@ -72,10 +89,11 @@ rtree_node_create (RTree      *rtree,
   g_assert (x >= 0 && x+w <= rtree->root.w);
   g_assert (y >= 0 && y+h <= rtree->root.h);
 
-  node = g_slice_alloc (sizeof (*node));
-  if (node == NULL)
+  if (rtree->n_nodes == NUM_NODES)
     return NULL;
 
+  node = &rtree->nodes[rtree->n_nodes++];
+
   node->children[0] = NULL;
   node->children[1] = NULL;
   node->x = x;
@@ -89,21 +107,6 @@ rtree_node_create (RTree      *rtree,
   return node;
 }
 
-static void
-rtree_node_destroy (RTree     *rtree,
-                    RTreeNode *node)
-{
-  gint i;
-
-  for (i = 0; i < 2; i++)
-    {
-      if (node->children[i])
-	rtree_node_destroy (rtree, node->children[i]);
-    }
-
-  g_slice_free (RTreeNode, node);
-}
-
 static RTreeNode *
 rtree_node_insert (RTree      *rtree,
                    RTreeNode **prev,
@@ -172,24 +175,17 @@ rtree_init (RTree *rtree,
   rtree->root.children[1] = NULL;
   rtree->root.next = NULL;
   rtree->available = &rtree->root;
+  rtree->n_nodes = 0;
 }
 
 static void
 rtree_reset (RTree *rtree)
 {
-  gint i;
-
-  for (i = 0; i < 2; i++)
-    {
-      if (rtree->root.children[i] == NULL)
-	continue;
-
-      rtree_node_destroy (rtree, rtree->root.children[i]);
-      rtree->root.children[i] = NULL;
-    }
-
+  rtree->root.children[0] = NULL;
+  rtree->root.children[1] = NULL;
   rtree->root.next = NULL;
   rtree->available = &rtree->root;
+  rtree->n_nodes = 0;
 }
 
 static void
@@ -198,10 +194,18 @@ xfer_destroy (void *data)
   GimpDisplayXfer *xfer = data;
   gint             i;
 
+  GIMP_LOG (DISPLAY_XFER,
+            "%" G_GUINT64_FORMAT " requests, "
+            "%" G_GUINT64_FORMAT " pixels, "
+            "%" G_GUINT64_FORMAT " page flips, "
+            "%" G_GUINT64_FORMAT " of them for lack of nodes, "
+            "at most %d nodes",
+            xfer->n_requests, xfer->n_pixels, xfer->n_page_flips,
+            xfer->n_pool_exhausted, xfer->max_nodes);
+
   for (i = 0; i < NUM_PAGES; i++)
     cairo_surface_destroy (xfer->render_surface[i]);
 
-  rtree_reset (&xfer->rtree);
   g_free (xfer);
 }
 
@@ -240,7 +244,7 @@ gimp_display_xfer_realize (GtkWidget *widget)
       gint     h = GIMP_DISPLAY_RENDER_BUF_HEIGHT * GIMP_DISPLAY_RENDER_MAX_SCALE;
       int      n;
 
-      xfer = g_new (GimpDisplayXfer, 1);
+      xfer = g_new0 (GimpDisplayXfer, 1);
       rtree_init (&xfer->rtree, w, h);
 
       cr = gdk_cairo_create (gtk_widget_get_window (widget));
@@ -274,9 +278,19 @@ gimp_display_xfer_get_surface (GimpDisplayXfer *xfer,
   g_assert (w <= GIMP_DISPLAY_RENDER_BUF_WIDTH * GIMP_DISPLAY_RENDER_MAX_SCALE &&
 	    h <= GIMP_DISPLAY_RENDER_BUF_HEIGHT * GIMP_DISPLAY_RENDER_MAX_SCALE);
 
+  xfer->n_requests++;
+  xfer->n_pixels += w * h;
+
   node = rtree_insert (&xfer->rtree, w, h);
   if (node == NULL)
     {
+      xfer->n_page_flips++;
+
+      if (xfer->rtree.n_nodes >= NUM_NODES - 1)
+        xfer->n_pool_exhausted++;
+
+      xfer->max_nodes = MAX (xfer->max_nodes, xfer->rtree.n_nodes);
+
       xfer->page = (xfer->page + 1) % NUM_PAGES;
       cairo_surface_flush (xfer->render_surface[xfer->page]);
       rtree_reset (&xfer->rtree);
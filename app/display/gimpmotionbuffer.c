@@ -38,6 +38,7 @@
 #define EVENT_FILL_PRECISION 6.0
 #define DIRECTION_RADIUS     (1.0 / MAX (scale_x, scale_y))
 #define SMOOTH_FACTOR        0.3
+#define MAX_PREDICTION_STEPS 8.0
 
 
 enum
@@ -446,6 +447,49 @@ gimp_motion_buffer_get_last_motion_time (GimpMotionBuffer *buffer)
   return buffer->last_read_motion_time;
 }
 
+/**
+ * gimp_motion_buffer_predict_coords:
+ * @buffer:    a #GimpMotionBuffer
+ * @lookahead: how far to look ahead, in milliseconds
+ * @coords:    return location for the predicted coordinates
+ *
+ * Extrapolates the pointer position @lookahead milliseconds past the
+ * last motion event, at the speed and in the direction of the last
+ * motion.  The prediction never reaches further than a few motion
+ * events ahead, so it stays close to the stroke on slow devices.
+ *
+ * Return value: %TRUE if there was enough motion to predict from,
+ *               %FALSE otherwise.
+ **/
+gboolean
+gimp_motion_buffer_predict_coords (GimpMotionBuffer *buffer,
+                                   gdouble           lookahead,
+                                   GimpCoords       *coords)
+{
+  gdouble steps;
+
+  g_return_val_if_fail (GIMP_IS_MOTION_BUFFER (buffer), FALSE);
+  g_return_val_if_fail (coords != NULL, FALSE);
+
+  if (buffer->last_motion_time == 0         ||
+      buffer->last_motion_delta_time <= 0.0 ||
+      buffer->event_history->len < 2)
+    {
+      return FALSE;
+    }
+
+  steps = MIN (lookahead / buffer->last_motion_delta_time,
+               MAX_PREDICTION_STEPS);
+
+  /*  the deltas point from the current event back to the last one  */
+  *coords = buffer->last_coords;
+
+  coords->x -= buffer->last_motion_delta_x * steps;
+  coords->y -= buffer->last_motion_delta_y * steps;
+
+  return TRUE;
+}
+
 void
 gimp_motion_buffer_request_stroke (GimpMotionBuffer *buffer,
                                    GdkModifierType   state,
@@ -87,6 +87,9 @@ gboolean   gimp_motion_buffer_motion_event         (GimpMotionBuffer *buffer,
                                                     guint32           time,
                                                     gboolean          event_fill);
 guint32    gimp_motion_buffer_get_last_motion_time (GimpMotionBuffer *buffer);
+gboolean   gimp_motion_buffer_predict_coords       (GimpMotionBuffer *buffer,
+                                                    gdouble           lookahead,
+                                                    GimpCoords       *coords);
 
 void       gimp_motion_buffer_request_stroke       (GimpMotionBuffer *buffer,
                                                     GdkModifierType   state,
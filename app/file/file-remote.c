@@ -62,6 +62,9 @@ typedef struct
   GCancellable   *cancellable;
   gboolean        cancel;
   GTimeVal        last_time;
+  GMainLoop      *main_loop;
+  gboolean        success;
+  GError         *error;
 } RemoteProgress;
 
 
@@ -79,6 +82,9 @@ static gboolean   file_remote_copy_file          (Gimp            *gimp,
                                                   RemoteCopyMode   mode,
                                                   GimpProgress    *progress,
                                                   GError         **error);
+static void       file_remote_copy_file_ready    (GFile           *file,
+                                                  GAsyncResult    *result,
+                                                  RemoteProgress  *remote_progress);
 static void       file_remote_copy_file_cancel   (GimpProgress    *progress,
                                                   RemoteProgress  *remote_progress);
 
@@ -277,12 +283,11 @@ file_remote_copy_file (Gimp            *gimp,
                        GimpProgress    *progress,
                        GError         **error)
 {
-  RemoteProgress  remote_progress = { 0, };
-  gboolean        success;
-  GError         *my_error = NULL;
+  RemoteProgress remote_progress = { 0, };
 
-  remote_progress.mode     = mode;
-  remote_progress.progress = progress;
+  remote_progress.mode      = mode;
+  remote_progress.progress  = progress;
+  remote_progress.main_loop = g_main_loop_new (NULL, FALSE);
 
   if (progress)
     {
@@ -293,12 +298,24 @@ file_remote_copy_file (Gimp            *gimp,
       g_signal_connect (progress, "cancel",
                         G_CALLBACK (file_remote_copy_file_cancel),
                         &remote_progress);
+    }
 
-      success = g_file_copy (src_file, dest_file, G_FILE_COPY_OVERWRITE,
-                             remote_progress.cancellable,
-                             file_remote_progress_callback, &remote_progress,
-                             &my_error);
+  /*  copy asynchronously and wait in a main loop, so the user interface
+   *  stays responsive while a large image is transferred
+   */
+  g_file_copy_async (src_file, dest_file, G_FILE_COPY_OVERWRITE,
+                     G_PRIORITY_DEFAULT,
+                     remote_progress.cancellable,
+                     progress ? file_remote_progress_callback : NULL,
+                     &remote_progress,
+                     (GAsyncReadyCallback) file_remote_copy_file_ready,
+                     &remote_progress);
 
+  g_main_loop_run (remote_progress.main_loop);
+  g_main_loop_unref (remote_progress.main_loop);
+
+  if (progress)
+    {
       g_signal_handlers_disconnect_by_func (progress,
                                             file_remote_copy_file_cancel,
                                             &remote_progress);
@@ -308,14 +325,25 @@ file_remote_copy_file (Gimp            *gimp,
       gimp_progress_set_value (progress, 1.0);
       gimp_progress_end (progress);
     }
-  else
-    {
-      success = g_file_copy (src_file, dest_file, G_FILE_COPY_OVERWRITE,
-                             NULL, NULL, NULL,
-                             &my_error);
-    }
 
-  return success;
+  /*  a cancelled copy is reported without an error  */
+  if (remote_progress.cancel)
+    g_clear_error (&remote_progress.error);
+  else if (remote_progress.error)
+    g_propagate_error (error, remote_progress.error);
+
+  return remote_progress.success;
+}
+
+static void
+file_remote_copy_file_ready (GFile          *file,
+                             GAsyncResult   *result,
+                             RemoteProgress *remote_progress)
+{
+  remote_progress->success = g_file_copy_finish (file, result,
+                                                 &remote_progress->error);
+
+  g_main_loop_quit (remote_progress->main_loop);
 }
 
 static void
@@ -29,6 +29,65 @@
 #include "gimp-intl.h"
 
 
+/*  the RGB and grayscale formats, indexed by base type, precision and
+ *  alpha; precisions are multiples of 50 from 100 to 750
+ */
+#define N_PRECISION_SLOTS 14
+#define N_FORMAT_SLOTS    (2 * N_PRECISION_SLOTS * 2)
+
+
+typedef struct
+{
+  gint               slot;
+  GimpImageBaseType  base_type;
+  GimpComponentType  component_type;
+  GimpPrecision      precision;
+  gboolean           linear;
+} GimpBablFormatInfo;
+
+
+static const Babl * gimp_babl_format_lookup   (GimpImageBaseType  base_type,
+                                               GimpPrecision      precision,
+                                               gboolean           with_alpha);
+static void         gimp_babl_format_intern   (void);
+
+
+static const Babl         *babl_formats[N_FORMAT_SLOTS];
+static GimpBablFormatInfo  babl_format_infos[N_FORMAT_SLOTS];
+static GHashTable         *babl_format_info_hash = NULL;
+static const Babl         *babl_fishes[N_FORMAT_SLOTS][N_FORMAT_SLOTS];
+
+
+static inline gint
+gimp_babl_format_slot (GimpImageBaseType base_type,
+                       GimpPrecision     precision,
+                       gboolean          with_alpha)
+{
+  gint p = (gint) precision / 50 - 2;
+
+  if ((base_type != GIMP_RGB && base_type != GIMP_GRAY) ||
+      (gint) precision % 50 != 0                        ||
+      p < 0 || p >= N_PRECISION_SLOTS)
+    {
+      return -1;
+    }
+
+  return ((gint) base_type * N_PRECISION_SLOTS + p) * 2 + (with_alpha ? 1 : 0);
+}
+
+/*  only valid after gimp_babl_init(), the table is never changed
+ *  afterwards, so this can be used from any thread
+ */
+static inline const GimpBablFormatInfo *
+gimp_babl_format_get_info (const Babl *format)
+{
+  if (G_LIKELY (babl_format_info_hash))
+    return g_hash_table_lookup (babl_format_info_hash, format);
+
+  return NULL;
+}
+
+
 void
 gimp_babl_init (void)
 {
@@ -247,6 +306,8 @@ gimp_babl_init (void)
                    babl_type ("double"),
                    babl_component ("A"),
                    NULL);
+
+  gimp_babl_format_intern ();
 }
 
 static const struct
@@ -398,10 +459,16 @@ gimp_babl_get_description (const Babl *babl)
 GimpImageBaseType
 gimp_babl_format_get_base_type (const Babl *format)
 {
-  const Babl *model;
+  const GimpBablFormatInfo *info;
+  const Babl               *model;
 
   g_return_val_if_fail (format != NULL, -1);
 
+  info = gimp_babl_format_get_info (format);
+
+  if (info)
+    return info->base_type;
+
   model = babl_format_get_model (format);
 
   if (model == babl_model ("Y")  ||
@@ -429,10 +496,16 @@ gimp_babl_format_get_base_type (const Babl *format)
 GimpComponentType
 gimp_babl_format_get_component_type (const Babl *format)
 {
-  const Babl *type;
+  const GimpBablFormatInfo *info;
+  const Babl               *type;
 
   g_return_val_if_fail (format != NULL, -1);
 
+  info = gimp_babl_format_get_info (format);
+
+  if (info)
+    return info->component_type;
+
   type = babl_format_get_type (format, 0);
 
   if (type == babl_type ("u8"))
@@ -454,10 +527,16 @@ gimp_babl_format_get_component_type (const Babl *format)
 GimpPrecision
 gimp_babl_format_get_precision (const Babl *format)
 {
-  const Babl *type;
+  const GimpBablFormatInfo *info;
+  const Babl               *type;
 
   g_return_val_if_fail (format != NULL, -1);
 
+  info = gimp_babl_format_get_info (format);
+
+  if (info)
+    return info->precision;
+
   type = babl_format_get_type (format, 0);
 
   if (gimp_babl_format_get_linear (format))
@@ -497,10 +576,16 @@ gimp_babl_format_get_precision (const Babl *format)
 gboolean
 gimp_babl_format_get_linear (const Babl *format)
 {
-  const Babl *model;
+  const GimpBablFormatInfo *info;
+  const Babl               *model;
 
   g_return_val_if_fail (format != NULL, FALSE);
 
+  info = gimp_babl_format_get_info (format);
+
+  if (info)
+    return info->linear;
+
   model = babl_format_get_model (format);
 
   if (model == babl_model ("Y")   ||
@@ -612,192 +697,62 @@ gimp_babl_format (GimpImageBaseType  base_type,
                   GimpPrecision      precision,
                   gboolean           with_alpha)
 {
-  switch (base_type)
-    {
-    case GIMP_RGB:
-      switch (precision)
-        {
-        case GIMP_PRECISION_U8_LINEAR:
-          if (with_alpha)
-            return babl_format ("RGBA u8");
-          else
-            return babl_format ("RGB u8");
-
-        case GIMP_PRECISION_U8_GAMMA:
-          if (with_alpha)
-            return babl_format ("R'G'B'A u8");
-          else
-            return babl_format ("R'G'B' u8");
-
-        case GIMP_PRECISION_U16_LINEAR:
-          if (with_alpha)
-            return babl_format ("RGBA u16");
-          else
-            return babl_format ("RGB u16");
+  gint slot = gimp_babl_format_slot (base_type, precision, with_alpha);
 
-        case GIMP_PRECISION_U16_GAMMA:
-          if (with_alpha)
-            return babl_format ("R'G'B'A u16");
-          else
-            return babl_format ("R'G'B' u16");
+  if (G_LIKELY (slot >= 0 && babl_formats[slot]))
+    return babl_formats[slot];
 
-        case GIMP_PRECISION_U32_LINEAR:
-          if (with_alpha)
-            return babl_format ("RGBA u32");
-          else
-            return babl_format ("RGB u32");
-
-        case GIMP_PRECISION_U32_GAMMA:
-          if (with_alpha)
-            return babl_format ("R'G'B'A u32");
-          else
-            return babl_format ("R'G'B' u32");
-
-        case GIMP_PRECISION_HALF_LINEAR:
-          if (with_alpha)
-            return babl_format ("RGBA half");
-          else
-            return babl_format ("RGB half");
-
-        case GIMP_PRECISION_HALF_GAMMA:
-          if (with_alpha)
-            return babl_format ("R'G'B'A half");
-          else
-            return babl_format ("R'G'B' half");
-
-        case GIMP_PRECISION_FLOAT_LINEAR:
-          if (with_alpha)
-            return babl_format ("RGBA float");
-          else
-            return babl_format ("RGB float");
-
-        case GIMP_PRECISION_FLOAT_GAMMA:
-          if (with_alpha)
-            return babl_format ("R'G'B'A float");
-          else
-            return babl_format ("R'G'B' float");
-
-        case GIMP_PRECISION_DOUBLE_LINEAR:
-          if (with_alpha)
-            return babl_format ("RGBA double");
-          else
-            return babl_format ("RGB double");
-
-        case GIMP_PRECISION_DOUBLE_GAMMA:
-          if (with_alpha)
-            return babl_format ("R'G'B'A double");
-          else
-            return babl_format ("R'G'B' double");
-
-        default:
-          break;
-        }
-      break;
-
-    case GIMP_GRAY:
-      switch (precision)
-        {
-        case GIMP_PRECISION_U8_LINEAR:
-          if (with_alpha)
-            return babl_format ("YA u8");
-          else
-            return babl_format ("Y u8");
-
-        case GIMP_PRECISION_U8_GAMMA:
-          if (with_alpha)
-            return babl_format ("Y'A u8");
-          else
-            return babl_format ("Y' u8");
-
-        case GIMP_PRECISION_U16_LINEAR:
-          if (with_alpha)
-            return babl_format ("YA u16");
-          else
-            return babl_format ("Y u16");
-
-        case GIMP_PRECISION_U16_GAMMA:
-          if (with_alpha)
-            return babl_format ("Y'A u16");
-          else
-            return babl_format ("Y' u16");
-
-        case GIMP_PRECISION_U32_LINEAR:
-          if (with_alpha)
-            return babl_format ("YA u32");
-          else
-            return babl_format ("Y u32");
-
-        case GIMP_PRECISION_U32_GAMMA:
-          if (with_alpha)
-            return babl_format ("Y'A u32");
-          else
-            return babl_format ("Y' u32");
-
-        case GIMP_PRECISION_HALF_LINEAR:
-          if (with_alpha)
-            return babl_format ("YA half");
-          else
-            return babl_format ("Y half");
-
-        case GIMP_PRECISION_HALF_GAMMA:
-          if (with_alpha)
-            return babl_format ("Y'A half");
-          else
-            return babl_format ("Y' half");
+  return gimp_babl_format_lookup (base_type, precision, with_alpha);
+}
 
-        case GIMP_PRECISION_FLOAT_LINEAR:
-          if (with_alpha)
-            return babl_format ("YA float");
-          else
-            return babl_format ("Y float");
+/**
+ * gimp_babl_fish:
+ * @source_format: a #Babl format
+ * @dest_format:   a #Babl format
+ *
+ * Like babl_fish(), but remembers the fishes between the RGB and
+ * grayscale formats returned by gimp_babl_format(), which saves the
+ * lookup in per-row code.
+ *
+ * Return value: the fish converting @source_format to @dest_format.
+ **/
+const Babl *
+gimp_babl_fish (const Babl *source_format,
+                const Babl *dest_format)
+{
+  const GimpBablFormatInfo *source_info;
+  const GimpBablFormatInfo *dest_info;
 
-        case GIMP_PRECISION_FLOAT_GAMMA:
-          if (with_alpha)
-            return babl_format ("Y'A float");
-          else
-            return babl_format ("Y' float");
+  g_return_val_if_fail (source_format != NULL, NULL);
+  g_return_val_if_fail (dest_format != NULL, NULL);
 
-        case GIMP_PRECISION_DOUBLE_LINEAR:
-          if (with_alpha)
-            return babl_format ("YA double");
-          else
-            return babl_format ("Y double");
+  source_info = gimp_babl_format_get_info (source_format);
+  dest_info   = gimp_babl_format_get_info (dest_format);
 
-        case GIMP_PRECISION_DOUBLE_GAMMA:
-          if (with_alpha)
-            return babl_format ("Y'A double");
-          else
-            return babl_format ("Y' double");
+  if (source_info && dest_info)
+    {
+      const Babl **fish = &babl_fishes[source_info->slot][dest_info->slot];
 
-        default:
-          break;
-        }
-      break;
+      /*  racing threads store the same fish  */
+      if (G_UNLIKELY (! *fish))
+        *fish = babl_fish (source_format, dest_format);
 
-    case GIMP_INDEXED:
-      /* need to use the image's api for this */
-      break;
+      return *fish;
     }
 
-  g_return_val_if_reached (NULL);
+  return babl_fish (source_format, dest_format);
 }
 
 const Babl *
 gimp_babl_mask_format (GimpPrecision precision)
 {
-  switch (gimp_babl_component_type (precision))
-    {
-    case GIMP_COMPONENT_TYPE_U8:     return babl_format ("Y u8");
-    case GIMP_COMPONENT_TYPE_U16:    return babl_format ("Y u16");
-    case GIMP_COMPONENT_TYPE_U32:    return babl_format ("Y u32");
-    case GIMP_COMPONENT_TYPE_HALF:   return babl_format ("Y half");
-    case GIMP_COMPONENT_TYPE_FLOAT:  return babl_format ("Y float");
-    case GIMP_COMPONENT_TYPE_DOUBLE: return babl_format ("Y double");
-    }
-
-  g_return_val_if_reached (NULL);
+  return gimp_babl_format (GIMP_GRAY,
+                           gimp_babl_precision (gimp_babl_component_type (precision),
+                                                TRUE),
+                           FALSE);
 }
 
+
 const Babl *
 gimp_babl_component_format (GimpImageBaseType base_type,
                             GimpPrecision     precision,
@@ -1195,3 +1150,239 @@ gimp_babl_print_pixel (const Babl *format,
 
   return strings;
 }
+
+
+/*  private functions  */
+
+static void
+gimp_babl_format_intern (void)
+{
+  static const GimpImageBaseType base_types[] = { GIMP_RGB, GIMP_GRAY };
+  static const GimpPrecision     precisions[] =
+  {
+    GIMP_PRECISION_U8_LINEAR,
+    GIMP_PRECISION_U8_GAMMA,
+    GIMP_PRECISION_U16_LINEAR,
+    GIMP_PRECISION_U16_GAMMA,
+    GIMP_PRECISION_U32_LINEAR,
+    GIMP_PRECISION_U32_GAMMA,
+    GIMP_PRECISION_HALF_LINEAR,
+    GIMP_PRECISION_HALF_GAMMA,
+    GIMP_PRECISION_FLOAT_LINEAR,
+    GIMP_PRECISION_FLOAT_GAMMA,
+    GIMP_PRECISION_DOUBLE_LINEAR,
+    GIMP_PRECISION_DOUBLE_GAMMA
+  };
+  gint                           i;
+
+  babl_format_info_hash = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+  for (i = 0; i < G_N_ELEMENTS (base_types); i++)
+    {
+      gint p;
+
+      for (p = 0; p < G_N_ELEMENTS (precisions); p++)
+        {
+          GimpPrecision precision = precisions[p];
+          gint          alpha;
+
+          for (alpha = 0; alpha < 2; alpha++)
+            {
+              GimpBablFormatInfo *info;
+              gint                slot;
+
+              slot = gimp_babl_format_slot (base_types[i], precision, alpha);
+
+              babl_formats[slot] = gimp_babl_format_lookup (base_types[i],
+                                                            precision,
+                                                            alpha);
+
+              info = &babl_format_infos[slot];
+
+              info->slot           = slot;
+              info->base_type      = base_types[i];
+              info->component_type = gimp_babl_component_type (precision);
+              info->precision      = precision;
+              info->linear         = (p % 2 == 0); /* LINEAR, GAMMA, ... */
+
+              g_hash_table_insert (babl_format_info_hash,
+                                   (gpointer) babl_formats[slot], info);
+            }
+        }
+    }
+}
+
+static const Babl *
+gimp_babl_format_lookup (GimpImageBaseType  base_type,
+                         GimpPrecision      precision,
+                         gboolean           with_alpha)
+{
+  switch (base_type)
+    {
+    case GIMP_RGB:
+      switch (precision)
+        {
+        case GIMP_PRECISION_U8_LINEAR:
+          if (with_alpha)
+            return babl_format ("RGBA u8");
+          else
+            return babl_format ("RGB u8");
+
+        case GIMP_PRECISION_U8_GAMMA:
+          if (with_alpha)
+            return babl_format ("R'G'B'A u8");
+          else
+            return babl_format ("R'G'B' u8");
+
+        case GIMP_PRECISION_U16_LINEAR:
+          if (with_alpha)
+            return babl_format ("RGBA u16");
+          else
+            return babl_format ("RGB u16");
+
+        case GIMP_PRECISION_U16_GAMMA:
+          if (with_alpha)
+            return babl_format ("R'G'B'A u16");
+          else
+            return babl_format ("R'G'B' u16");
+
+        case GIMP_PRECISION_U32_LINEAR:
+          if (with_alpha)
+            return babl_format ("RGBA u32");
+          else
+            return babl_format ("RGB u32");
+
+        case GIMP_PRECISION_U32_GAMMA:
+          if (with_alpha)
+            return babl_format ("R'G'B'A u32");
+          else
+            return babl_format ("R'G'B' u32");
+
+        case GIMP_PRECISION_HALF_LINEAR:
+          if (with_alpha)
+            return babl_format ("RGBA half");
+          else
+            return babl_format ("RGB half");
+
+        case GIMP_PRECISION_HALF_GAMMA:
+          if (with_alpha)
+            return babl_format ("R'G'B'A half");
+          else
+            return babl_format ("R'G'B' half");
+
+        case GIMP_PRECISION_FLOAT_LINEAR:
+          if (with_alpha)
+            return babl_format ("RGBA float");
+          else
+            return babl_format ("RGB float");
+
+        case GIMP_PRECISION_FLOAT_GAMMA:
+          if (with_alpha)
+            return babl_format ("R'G'B'A float");
+          else
+            return babl_format ("R'G'B' float");
+
+        case GIMP_PRECISION_DOUBLE_LINEAR:
+          if (with_alpha)
+            return babl_format ("RGBA double");
+          else
+            return babl_format ("RGB double");
+
+        case GIMP_PRECISION_DOUBLE_GAMMA:
+          if (with_alpha)
+            return babl_format ("R'G'B'A double");
+          else
+            return babl_format ("R'G'B' double");
+
+        default:
+          break;
+        }
+      break;
+
+    case GIMP_GRAY:
+      switch (precision)
+        {
+        case GIMP_PRECISION_U8_LINEAR:
+          if (with_alpha)
+            return babl_format ("YA u8");
+          else
+            return babl_format ("Y u8");
+
+        case GIMP_PRECISION_U8_GAMMA:
+          if (with_alpha)
+            return babl_format ("Y'A u8");
+          else
+            return babl_format ("Y' u8");
+
+        case GIMP_PRECISION_U16_LINEAR:
+          if (with_alpha)
+            return babl_format ("YA u16");
+          else
+            return babl_format ("Y u16");
+
+        case GIMP_PRECISION_U16_GAMMA:
+          if (with_alpha)
+            return babl_format ("Y'A u16");
+          else
+            return babl_format ("Y' u16");
+
+        case GIMP_PRECISION_U32_LINEAR:
+          if (with_alpha)
+            return babl_format ("YA u32");
+          else
+            return babl_format ("Y u32");
+
+        case GIMP_PRECISION_U32_GAMMA:
+          if (with_alpha)
+            return babl_format ("Y'A u32");
+          else
+            return babl_format ("Y' u32");
+
+        case GIMP_PRECISION_HALF_LINEAR:
+          if (with_alpha)
+            return babl_format ("YA half");
+          else
+            return babl_format ("Y half");
+
+        case GIMP_PRECISION_HALF_GAMMA:
+          if (with_alpha)
+            return babl_format ("Y'A half");
+          else
+            return babl_format ("Y' half");
+
+        case GIMP_PRECISION_FLOAT_LINEAR:
+          if (with_alpha)
+            return babl_format ("YA float");
+          else
+            return babl_format ("Y float");
+
+        case GIMP_PRECISION_FLOAT_GAMMA:
+          if (with_alpha)
+            return babl_format ("Y'A float");
+          else
+            return babl_format ("Y' float");
+
+        case GIMP_PRECISION_DOUBLE_LINEAR:
+          if (with_alpha)
+            return babl_format ("YA double");
+          else
+            return babl_format ("Y double");
+
+        case GIMP_PRECISION_DOUBLE_GAMMA:
+          if (with_alpha)
+            return babl_format ("Y'A double");
+          else
+            return babl_format ("Y' double");
+
+        default:
+          break;
+        }
+      break;
+
+    case GIMP_INDEXED:
+      /* need to use the image's api for this */
+      break;
+    }
+
+  g_return_val_if_reached (NULL);
+}
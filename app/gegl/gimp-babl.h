@@ -38,6 +38,8 @@ GimpPrecision       gimp_babl_precision        (GimpComponentType  component,
 const Babl        * gimp_babl_format           (GimpImageBaseType  base_type,
                                                 GimpPrecision      precision,
                                                 gboolean           with_alpha);
+const Babl        * gimp_babl_fish             (const Babl        *source_format,
+                                                const Babl        *dest_format);
 const Babl        * gimp_babl_mask_format      (GimpPrecision      precision);
 const Babl        * gimp_babl_component_format (GimpImageBaseType  base_type,
                                                 GimpPrecision      precision,
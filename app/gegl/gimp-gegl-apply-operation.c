@@ -28,14 +28,74 @@
 
 #include "gimp-gegl-types.h"
 
+#include "core/gimp-parallel.h"
 #include "core/gimp-utils.h"
 #include "core/gimpprogress.h"
 
+#include "operations/gimpoperationpointfilter.h"
+
+#include "gimp-babl.h"
 #include "gimp-gegl-apply-operation.h"
 #include "gimp-gegl-nodes.h"
 #include "gegl/gimp-gegl-utils.h"
 
 
+/* the smallest area worth a thread of its own */
+#define MIN_PARALLEL_SUB_SIZE 64
+#define MIN_PARALLEL_SUB_AREA (MIN_PARALLEL_SUB_SIZE * MIN_PARALLEL_SUB_SIZE)
+
+/* the rows gimp_gegl_apply_scale() produces per step */
+#define SCALE_BAND_HEIGHT     128
+
+/* the rows a point filter is applied to per step */
+#define POINT_BAND_HEIGHT     256
+
+/* the time a chunk of a cached operation should take, in microseconds,
+ * so progress and cancellation are handled a few times per second
+ */
+#define CHUNK_INTERVAL        (G_USEC_PER_SEC / 15)
+
+/* the pixels of the first chunk, and the least of any chunk */
+#define CHUNK_INITIAL_PIXELS  (256 * 256)
+#define CHUNK_MIN_PIXELS      (64 * 64)
+
+
+typedef struct
+{
+  GeglBuffer      *src_buffer;
+  GeglBuffer      *dest_buffer;
+  const Babl      *format;
+  GeglSamplerType  sampler_type;
+  gboolean         area_filter;
+  gdouble          x;
+  gdouble          y;
+} GimpGeglScaleData;
+
+typedef struct
+{
+  GeglOperation                 *operation;
+  GeglOperationPointFilterClass *point_class;
+  GeglBuffer                    *src_buffer;
+  const Babl                    *src_format;
+  GeglBuffer                    *dest_buffer;
+  const Babl                    *dest_format;
+} GimpGeglPointFilterData;
+
+
+static void   gimp_gegl_apply_scale_area (const GeglRectangle *area,
+                                          GimpGeglScaleData   *data);
+static void   gimp_gegl_apply_point_area (const GeglRectangle     *area,
+                                          GimpGeglPointFilterData *data);
+
+static void   gimp_gegl_apply_chunked    (GeglNode                *dest_node,
+                                          cairo_region_t          *region,
+                                          GimpProgress            *progress,
+                                          gboolean                 cancellable,
+                                          gboolean                *cancel,
+                                          gint64                   done_pixels,
+                                          gint64                   all_pixels);
+
+
 void
 gimp_gegl_apply_operation (GeglBuffer          *src_buffer,
                            GimpProgress        *progress,
@@ -72,13 +132,13 @@ gimp_gegl_apply_cached_operation (GeglBuffer          *src_buffer,
                                   gint                 n_valid_rects,
                                   gboolean             cancellable)
 {
-  GeglNode      *gegl;
-  GeglNode      *dest_node;
-  GeglRectangle  rect = { 0, };
-  GeglProcessor *processor        = NULL;
-  gboolean       progress_started = FALSE;
-  gdouble        value;
-  gboolean       cancel           = FALSE;
+  GeglNode                *gegl;
+  GeglNode                *dest_node;
+  GeglRectangle            rect = { 0, };
+  gboolean                 progress_started = FALSE;
+  gboolean                 cancel           = FALSE;
+  gboolean                 parallel;
+  GimpGeglPointFilterData  data;
 
   g_return_val_if_fail (src_buffer == NULL || GEGL_IS_BUFFER (src_buffer), FALSE);
   g_return_val_if_fail (progress == NULL || GIMP_IS_PROGRESS (progress), FALSE);
@@ -98,6 +158,15 @@ gimp_gegl_apply_cached_operation (GeglBuffer          *src_buffer,
                                     gegl_buffer_get_height (dest_buffer));
     }
 
+  /*  point filters are applied by calling their process() from
+   *  several threads at once, instead of through a processor
+   */
+  parallel = (! cache                                &&
+              src_buffer                             &&
+              src_buffer != dest_buffer              &&
+              gegl_node_has_pad (operation, "input") &&
+              GIMP_IS_OPERATION_POINT_FILTER (gegl_node_get_gegl_operation (operation)));
+
   gegl = gegl_node_new ();
 
   if (! gegl_node_get_parent (operation))
@@ -108,9 +177,11 @@ gimp_gegl_apply_cached_operation (GeglBuffer          *src_buffer,
       GeglNode *src_node;
 
       /* dup() because reading and writing the same buffer doesn't
-       * work with area ops when using a processor. See bug #701875.
+       * work with area ops when rendering in chunks. See bug #701875.
+       * Point ops only read the pixels they write, so they can.
        */
-      if (progress && (src_buffer == dest_buffer))
+      if (progress && (src_buffer == dest_buffer) &&
+          ! GEGL_IS_OPERATION_POINT_FILTER (gegl_node_get_gegl_operation (operation)))
         src_buffer = gegl_buffer_dup (src_buffer);
       else
         g_object_ref (src_buffer);
@@ -134,10 +205,24 @@ gimp_gegl_apply_cached_operation (GeglBuffer          *src_buffer,
   gegl_node_connect_to (operation, "output",
                         dest_node, "input");
 
-  if (progress)
+  if (parallel)
     {
-      processor = gegl_node_new_processor (dest_node, &rect);
+      data.operation   = gegl_node_get_gegl_operation (operation);
+      data.point_class = GEGL_OPERATION_POINT_FILTER_GET_CLASS (data.operation);
+      data.src_buffer  = src_buffer;
+      data.dest_buffer = dest_buffer;
 
+      /*  prepares the graph, which makes the operation pick its formats  */
+      gegl_node_get_bounding_box (dest_node);
+
+      data.src_format  = gegl_operation_get_format (data.operation, "input");
+      data.dest_format = gegl_operation_get_format (data.operation, "output");
+
+      parallel = data.src_format && data.dest_format;
+    }
+
+  if (progress)
+    {
       if (gimp_progress_is_active (progress))
         {
           if (undo_desc)
@@ -162,14 +247,13 @@ gimp_gegl_apply_cached_operation (GeglBuffer          *src_buffer,
   if (cache)
     {
       cairo_region_t *region;
-      gint            all_pixels;
-      gint            done_pixels = 0;
-      gint            n_rects;
+      gint64          all_pixels;
+      gint64          done_pixels = 0;
       gint            i;
 
       region = cairo_region_create_rectangle ((cairo_rectangle_int_t *) &rect);
 
-      all_pixels = rect.width * rect.height;
+      all_pixels = (gint64) rect.width * rect.height;
 
       for (i = 0; i < n_valid_rects; i++)
         {
@@ -180,7 +264,7 @@ gimp_gegl_apply_cached_operation (GeglBuffer          *src_buffer,
                                            (cairo_rectangle_int_t *)
                                            valid_rects + i);
 
-          done_pixels += valid_rects[i].width * valid_rects[i].height;
+          done_pixels += (gint64) valid_rects[i].width * valid_rects[i].height;
 
           if (progress)
             gimp_progress_set_value (progress,
@@ -188,43 +272,22 @@ gimp_gegl_apply_cached_operation (GeglBuffer          *src_buffer,
                                      (gdouble) all_pixels);
         }
 
-      n_rects = cairo_region_num_rectangles (region);
-
-      for (i = 0; ! cancel && (i < n_rects); i++)
+      if (progress)
         {
-          cairo_rectangle_int_t render_rect;
-
-          cairo_region_get_rectangle (region, i, &render_rect);
+          gimp_gegl_apply_chunked (dest_node, region,
+                                   progress, cancellable, &cancel,
+                                   done_pixels, all_pixels);
+        }
+      else
+        {
+          gint n_rects = cairo_region_num_rectangles (region);
 
-          if (progress)
-            {
-              gint rect_pixels = render_rect.width * render_rect.height;
-
-#ifdef REUSE_PROCESSOR
-              gegl_processor_set_rectangle (processor,
-                                            (GeglRectangle *) &render_rect);
-#else
-              g_object_unref (processor);
-              processor = gegl_node_new_processor (dest_node,
-                                                   (GeglRectangle *) &render_rect);
-#endif
-
-              while (! cancel && gegl_processor_work (processor, &value))
-                {
-                  gimp_progress_set_value (progress,
-                                           ((gdouble) done_pixels +
-                                            value * rect_pixels) /
-                                           (gdouble) all_pixels);
-
-                  if (cancellable)
-                    while (! cancel && g_main_context_pending (NULL))
-                      g_main_context_iteration (NULL, FALSE);
-                }
-
-              done_pixels += rect_pixels;
-            }
-          else
+          for (i = 0; i < n_rects; i++)
             {
+              cairo_rectangle_int_t render_rect;
+
+              cairo_region_get_rectangle (region, i, &render_rect);
+
               gegl_node_blit (dest_node, 1.0, (GeglRectangle *) &render_rect,
                               NULL, NULL, 0, GEGL_BLIT_DEFAULT);
             }
@@ -232,19 +295,50 @@ gimp_gegl_apply_cached_operation (GeglBuffer          *src_buffer,
 
       cairo_region_destroy (region);
     }
-  else
+  else if (parallel)
     {
-      if (progress)
+      GeglRectangle band = rect;
+
+      band.height = 0;
+
+      while (! cancel && band.y + band.height < rect.y + rect.height)
         {
-          while (! cancel && gegl_processor_work (processor, &value))
+          band.y      += band.height;
+          band.height  = MIN (POINT_BAND_HEIGHT,
+                              rect.y + rect.height - band.y);
+
+          gimp_parallel_distribute_area (&band, MIN_PARALLEL_SUB_AREA,
+                                         (GimpParallelDistributeAreaFunc)
+                                         gimp_gegl_apply_point_area,
+                                         &data);
+
+          if (progress)
             {
-              gimp_progress_set_value (progress, value);
+              gimp_progress_set_value (progress,
+                                       (gdouble) (band.y + band.height - rect.y) /
+                                       (gdouble) rect.height);
 
               if (cancellable)
                 while (! cancel && g_main_context_pending (NULL))
                   g_main_context_iteration (NULL, FALSE);
             }
         }
+    }
+  else
+    {
+      if (progress)
+        {
+          cairo_region_t *region;
+
+          region = cairo_region_create_rectangle ((cairo_rectangle_int_t *)
+                                                  &rect);
+
+          gimp_gegl_apply_chunked (dest_node, region,
+                                   progress, cancellable, &cancel,
+                                   0, (gint64) rect.width * rect.height);
+
+          cairo_region_destroy (region);
+        }
       else
         {
           gegl_node_blit (dest_node, 1.0, &rect,
@@ -252,9 +346,6 @@ gimp_gegl_apply_cached_operation (GeglBuffer          *src_buffer,
         }
     }
 
-  if (processor)
-    g_object_unref (processor);
-
   g_object_unref (gegl);
 
   if (progress_started)
@@ -521,6 +612,16 @@ gimp_gegl_apply_opacity (GeglBuffer    *src_buffer,
   g_object_unref (node);
 }
 
+/*  Scales @src_buffer into @dest_buffer one band of rows after the
+ *  other, each band split over all threads, with a sampler per thread.
+ *  This is what gegl:scale-ratio does, minus the graph, which can't be
+ *  processed from several threads at once.
+ *
+ *  In @preview mode the samples are taken at single points with at
+ *  most linear interpolation, instead of averaging the whole source
+ *  area of each destination pixel, which is much faster but aliases
+ *  when scaling down.
+ */
 void
 gimp_gegl_apply_scale (GeglBuffer            *src_buffer,
                        GimpProgress          *progress,
@@ -528,26 +629,75 @@ gimp_gegl_apply_scale (GeglBuffer            *src_buffer,
                        GeglBuffer            *dest_buffer,
                        GimpInterpolationType  interpolation_type,
                        gdouble                x,
-                       gdouble                y)
+                       gdouble                y,
+                       gboolean               preview)
 {
-  GeglNode *node;
+  GimpGeglScaleData    data;
+  const GeglRectangle *extent;
+  GeglRectangle        band;
+  gboolean             progress_started = FALSE;
 
   g_return_if_fail (GEGL_IS_BUFFER (src_buffer));
   g_return_if_fail (progress == NULL || GIMP_IS_PROGRESS (progress));
   g_return_if_fail (GEGL_IS_BUFFER (dest_buffer));
+  g_return_if_fail (x > 0.0 && y > 0.0);
 
-  node = gegl_node_new_child (NULL,
-                              "operation", "gegl:scale-ratio",
-                              "origin-x",   0.0,
-                              "origin-y",   0.0,
-                              "sampler",    interpolation_type,
-                              "x",          x,
-                              "y",          y,
-                              NULL);
+  /*  interpolate premultiplied, like the GEGL transform ops  */
+  if (gimp_babl_format_get_base_type (gegl_buffer_get_format (src_buffer)) ==
+      GIMP_GRAY)
+    data.format = babl_format ("YaA float");
+  else
+    data.format = babl_format ("RaGaBaA float");
 
-  gimp_gegl_apply_operation (src_buffer, progress, undo_desc,
-                             node, dest_buffer, NULL);
-  g_object_unref (node);
+  data.src_buffer   = src_buffer;
+  data.dest_buffer  = dest_buffer;
+  data.sampler_type = (GeglSamplerType) interpolation_type;
+  data.area_filter  = ! preview;
+  data.x            = x;
+  data.y            = y;
+
+  if (preview)
+    data.sampler_type = MIN (data.sampler_type, GEGL_SAMPLER_LINEAR);
+
+  if (progress)
+    {
+      if (gimp_progress_is_active (progress))
+        {
+          if (undo_desc)
+            gimp_progress_set_text_literal (progress, undo_desc);
+        }
+      else
+        {
+          gimp_progress_start (progress, FALSE, "%s", undo_desc);
+
+          progress_started = TRUE;
+        }
+    }
+
+  extent = gegl_buffer_get_extent (dest_buffer);
+
+  band        = *extent;
+  band.height = 0;
+
+  while (band.y + band.height < extent->y + extent->height)
+    {
+      band.y      += band.height;
+      band.height  = MIN (SCALE_BAND_HEIGHT,
+                          extent->y + extent->height - band.y);
+
+      gimp_parallel_distribute_area (&band, MIN_PARALLEL_SUB_AREA,
+                                     (GimpParallelDistributeAreaFunc)
+                                     gimp_gegl_apply_scale_area,
+                                     &data);
+
+      if (progress)
+        gimp_progress_set_value (progress,
+                                 (gdouble) (band.y + band.height - extent->y) /
+                                 (gdouble) extent->height);
+    }
+
+  if (progress_started)
+    gimp_progress_end (progress);
 }
 
 void
@@ -621,3 +771,147 @@ gimp_gegl_apply_transform (GeglBuffer            *src_buffer,
                              node, dest_buffer, NULL);
   g_object_unref (node);
 }
+
+
+/*  private functions  */
+
+static void
+gimp_gegl_apply_scale_area (const GeglRectangle *area,
+                            GimpGeglScaleData   *data)
+{
+  GeglSampler        *sampler;
+  GeglBufferIterator *iter;
+  GeglMatrix2         inverse = { { { 1.0 / data->x, 0.0           },
+                                    { 0.0,           1.0 / data->y } } };
+  gint                n_components;
+
+  n_components = babl_format_get_n_components (data->format);
+
+  sampler = gegl_buffer_sampler_new (data->src_buffer, data->format,
+                                     data->sampler_type);
+
+  iter = gegl_buffer_iterator_new (data->dest_buffer, area, 0, data->format,
+                                   GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
+
+  while (gegl_buffer_iterator_next (iter))
+    {
+      const GeglRectangle *roi  = &iter->roi[0];
+      gfloat              *dest = iter->data[0];
+      gint                 x, y;
+
+      for (y = roi->y; y < roi->y + roi->height; y++)
+        {
+          /*  sample at the pixel centers  */
+          gdouble v = (y + 0.5) / data->y;
+
+          for (x = roi->x; x < roi->x + roi->width; x++)
+            {
+              gdouble u = (x + 0.5) / data->x;
+
+              gegl_sampler_get (sampler, u, v,
+                                data->area_filter ? &inverse : NULL,
+                                dest, GEGL_ABYSS_NONE);
+
+              dest += n_components;
+            }
+        }
+    }
+
+  g_object_unref (sampler);
+}
+
+static void
+gimp_gegl_apply_point_area (const GeglRectangle     *area,
+                            GimpGeglPointFilterData *data)
+{
+  GeglBufferIterator *iter;
+
+  iter = gegl_buffer_iterator_new (data->dest_buffer, area, 0,
+                                   data->dest_format,
+                                   GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
+
+  gegl_buffer_iterator_add (iter, data->src_buffer, area, 0,
+                            data->src_format,
+                            GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
+
+  while (gegl_buffer_iterator_next (iter))
+    {
+      /*  a point filter without config passes its input through  */
+      if (! data->point_class->process (data->operation,
+                                        iter->data[1], iter->data[0],
+                                        iter->length, &iter->roi[0], 0))
+        {
+          babl_process (babl_fish (data->src_format, data->dest_format),
+                        iter->data[1], iter->data[0], iter->length);
+        }
+    }
+}
+
+/*  renders @region of @dest_node in bands of rows, sized from the
+ *  measured throughput so that each band takes about CHUNK_INTERVAL.
+ *  GEGL still distributes each band over its own threads; between
+ *  bands, progress is updated and, if @cancellable, pending events are
+ *  handled, so a cancel takes effect within one interval no matter how
+ *  slow the operation is.  Bands that were completed before a cancel
+ *  stay in the caches of the graph and are reused by the next apply.
+ */
+static void
+gimp_gegl_apply_chunked (GeglNode       *dest_node,
+                         cairo_region_t *region,
+                         GimpProgress   *progress,
+                         gboolean        cancellable,
+                         gboolean       *cancel,
+                         gint64          done_pixels,
+                         gint64          all_pixels)
+{
+  gdouble chunk_pixels = CHUNK_INITIAL_PIXELS;
+  gint    n_rects      = cairo_region_num_rectangles (region);
+  gint    i;
+
+  for (i = 0; ! *cancel && i < n_rects; i++)
+    {
+      cairo_rectangle_int_t render_rect;
+      GeglRectangle         band;
+
+      cairo_region_get_rectangle (region, i, &render_rect);
+
+      band        = *(GeglRectangle *) &render_rect;
+      band.height = 0;
+
+      while (! *cancel &&
+             band.y + band.height < render_rect.y + render_rect.height)
+        {
+          gint64 start;
+          gint64 elapsed;
+
+          band.y      += band.height;
+          band.height  = CLAMP (chunk_pixels / band.width,
+                                1, render_rect.y + render_rect.height - band.y);
+
+          start = g_get_monotonic_time ();
+
+          gegl_node_blit (dest_node, 1.0, &band,
+                          NULL, NULL, 0, GEGL_BLIT_DEFAULT);
+
+          elapsed = MAX (g_get_monotonic_time () - start, 1);
+
+          /*  move halfway towards the size that would have taken
+           *  exactly CHUNK_INTERVAL, to smooth out uneven bands
+           */
+          chunk_pixels = (chunk_pixels +
+                          (gdouble) band.width * band.height *
+                          CHUNK_INTERVAL / elapsed) / 2.0;
+          chunk_pixels = MAX (chunk_pixels, CHUNK_MIN_PIXELS);
+
+          done_pixels += (gint64) band.width * band.height;
+
+          gimp_progress_set_value (progress,
+                                   (gdouble) done_pixels /
+                                   (gdouble) all_pixels);
+
+          if (cancellable)
+            while (! *cancel && g_main_context_pending (NULL))
+              g_main_context_iteration (NULL, FALSE);
+        }
+    }
+}
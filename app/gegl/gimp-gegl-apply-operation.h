@@ -128,7 +128,8 @@ void   gimp_gegl_apply_scale           (GeglBuffer            *src_buffer,
                                         GeglBuffer            *dest_buffer,
                                         GimpInterpolationType  interpolation_type,
                                         gdouble                x,
-                                        gdouble                y);
+                                        gdouble                y,
+                                        gboolean               preview);
 
 void   gimp_gegl_apply_set_alpha       (GeglBuffer            *src_buffer,
                                         GimpProgress          *progress,
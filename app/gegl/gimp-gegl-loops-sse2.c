@@ -0,0 +1,90 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimp-gegl-loops-sse2.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <glib-object.h>
+
+#include "gimp-gegl-loops-sse2.h"
+
+#if COMPILE_SSE2_INTRINISICS
+/* SSE2 */
+#include <emmintrin.h>
+
+
+/*  one RGBA float pixel per vector, with the same order of operations
+ *  as gimp_gegl_smudge_blend_row_generic(), so both give identical
+ *  results
+ */
+
+void
+gimp_gegl_smudge_blend_row_sse2 (gfloat       *top,
+                                 const gfloat *bottom,
+                                 gfloat       *dest,
+                                 gint          n_pixels,
+                                 gfloat        blend)
+{
+  const __m128 v_blend1 = _mm_set1_ps (1.0f - blend);
+  const __m128 v_blend2 = _mm_set1_ps (blend);
+  const __m128 zero     = _mm_setzero_ps ();
+  const __m128 rgb_mask = _mm_castsi128_ps (_mm_set_epi32 (0, -1, -1, -1));
+
+  while (n_pixels--)
+    {
+      __m128 v_top    = _mm_loadu_ps (top);
+      __m128 v_bottom = _mm_loadu_ps (bottom);
+      __m128 a1;
+      __m128 a2;
+      __m128 a;
+      __m128 rgb;
+      __m128 pixel;
+
+      a1 = _mm_mul_ps (v_blend1,
+                       _mm_shuffle_ps (v_bottom, v_bottom,
+                                       _MM_SHUFFLE (3, 3, 3, 3)));
+      a2 = _mm_mul_ps (v_blend2,
+                       _mm_shuffle_ps (v_top, v_top,
+                                       _MM_SHUFFLE (3, 3, 3, 3)));
+      a  = _mm_add_ps (a1, a2);
+
+      rgb = _mm_sub_ps (_mm_add_ps (_mm_mul_ps (v_bottom, a1),
+                                    _mm_mul_ps (v_top,    a2)),
+                        _mm_mul_ps (a, v_bottom));
+      rgb = _mm_add_ps (v_bottom, rgb);
+
+      pixel = _mm_or_ps (_mm_and_ps    (rgb_mask, rgb),
+                         _mm_andnot_ps (rgb_mask, a));
+
+      /*  fully transparent results are all zero  */
+      pixel = _mm_andnot_ps (_mm_cmpeq_ps (a, zero), pixel);
+
+      _mm_storeu_ps (top, pixel);
+
+      if (dest)
+        {
+          _mm_storeu_ps (dest, pixel);
+          dest += 4;
+        }
+
+      top    += 4;
+      bottom += 4;
+    }
+}
+
+#endif /* COMPILE_SSE2_INTRINISICS */
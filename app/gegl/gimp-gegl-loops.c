@@ -20,14 +20,221 @@
 
 #include "config.h"
 
+#include <string.h>
+
+#include <lcms2.h>
+
 #include <gegl.h>
 
+#include "libgimpbase/gimpbase.h"
+#include "libgimpcolor/gimpcolor.h"
 #include "libgimpmath/gimpmath.h"
 
 #include "gimp-gegl-types.h"
 
+#include "core/gimp-parallel.h"
+
 #include "gimp-babl.h"
 #include "gimp-gegl-loops.h"
+#include "gimp-gegl-loops-sse2.h"
+
+
+/*  the smallest area worth handing to a thread of its own  */
+#define MIN_PARALLEL_SUB_SIZE 64
+#define MIN_PARALLEL_SUB_AREA (MIN_PARALLEL_SUB_SIZE * MIN_PARALLEL_SUB_SIZE)
+
+
+typedef struct
+{
+  const gfloat        *src;
+  gint                 src_rowstride;
+  const GeglRectangle *src_rect;
+  GeglBuffer          *dest_buffer;
+  const Babl          *dest_format;
+  gint                 components;
+  gint                 dest_components;
+  const gfloat        *kernel;
+  gint                 kernel_size;
+  gdouble              divisor;
+  GimpConvolutionType  mode;
+  gfloat               offset;
+  gboolean             alpha_weighting;
+} GimpGeglConvolveData;
+
+typedef struct
+{
+  GeglBuffer          *src_buffer;
+  const GeglRectangle *src_rect;
+  GeglBuffer          *dest_buffer;
+  const GeglRectangle *dest_rect;
+  gfloat               exposure;
+  gfloat               factor;
+  GimpTransferMode     mode;
+  gboolean             use_lut;
+  gfloat               lut[256];
+} GimpGeglDodgeBurnData;
+
+typedef void (* GimpGeglSmudgeBlendRowFunc) (gfloat       *top,
+                                             const gfloat *bottom,
+                                             gfloat       *dest,
+                                             gint          n_pixels,
+                                             gfloat        blend);
+
+typedef struct
+{
+  GeglBuffer                 *top_buffer;
+  const GeglRectangle        *top_rect;
+  GeglBuffer                 *bottom_buffer;
+  const GeglRectangle        *bottom_rect;
+  GeglBuffer                 *dest_buffer;
+  const GeglRectangle        *dest_rect;
+  gfloat                      blend;
+  GimpGeglSmudgeBlendRowFunc  blend_row;
+} GimpGeglSmudgeBlendData;
+
+typedef struct
+{
+  GeglBuffer          *mask_buffer;
+  const GeglRectangle *mask_rect;
+  GeglBuffer          *dest_buffer;
+  const GeglRectangle *dest_rect;
+  gfloat               opacity;
+  gboolean             stipple;
+} GimpGeglMaskData;
+
+typedef struct
+{
+  GeglBuffer          *top_buffer;
+  const GeglRectangle *top_rect;
+  GeglBuffer          *bottom_buffer;
+  const GeglRectangle *bottom_rect;
+  GeglBuffer          *mask_buffer;
+  const GeglRectangle *mask_rect;
+  GeglBuffer          *dest_buffer;
+  const GeglRectangle *dest_rect;
+  gdouble              opacity;
+  const gboolean      *affect;
+} GimpGeglReplaceData;
+
+typedef struct
+{
+  GeglBuffer          *src_buffer;
+  const GeglRectangle *src_rect;
+  GeglBuffer          *dest_buffer;
+  const GeglRectangle *dest_rect;
+  const Babl          *format;
+  gint                 bpp;
+} GimpGeglCopyData;
+
+typedef struct
+{
+  GeglBuffer          *src_buffer;
+  const GeglRectangle *src_rect;
+  GeglBuffer          *dest_buffer;
+  const GeglRectangle *dest_rect;
+  const Babl          *format;
+  gint                 bpp;
+  gboolean             transpose;
+  gboolean             flip_x;
+  gboolean             flip_y;
+} GimpGeglRemapData;
+
+typedef struct
+{
+  GeglBuffer               *src_buffer;
+  const GeglRectangle      *src_rect;
+  GeglBuffer               *dest_buffer;
+  const GeglRectangle      *dest_rect;
+  const Babl               *format;
+  gint                      bpp;
+  gboolean                  has_alpha;
+  GimpColorProfile          src_profile;
+  GimpColorProfile          dest_profile;
+  cmsUInt32Number           lcms_format;
+  GimpColorRenderingIntent  intent;
+  cmsUInt32Number           flags;
+  GMutex                    mutex;
+  GSList                   *transforms;
+} GimpGeglConvertProfileData;
+
+typedef struct
+{
+  GeglBuffer          *buffer;
+  GMutex               mutex;
+  gint                 x1, y1, x2, y2;
+} GimpGeglAlphaBoundsData;
+
+
+/*  local function prototypes  */
+
+static void   gimp_gegl_convolve_area           (const GeglRectangle     *area,
+                                                 GimpGeglConvolveData    *data);
+static void   gimp_gegl_convolve_area_3x3       (const GeglRectangle     *area,
+                                                 GimpGeglConvolveData    *data);
+static gfloat gimp_gegl_dodgeburn_value         (gfloat                   value,
+                                                 GimpGeglDodgeBurnData   *data);
+static void   gimp_gegl_dodgeburn_area          (const GeglRectangle     *area,
+                                                 GimpGeglDodgeBurnData   *data);
+static void   gimp_gegl_smudge_blend_row_generic
+                                                (gfloat                  *top,
+                                                 const gfloat            *bottom,
+                                                 gfloat                  *dest,
+                                                 gint                     n_pixels,
+                                                 gfloat                   blend);
+static void   gimp_gegl_smudge_blend_area       (const GeglRectangle     *area,
+                                                 GimpGeglSmudgeBlendData *data);
+static void   gimp_gegl_apply_mask_area         (const GeglRectangle     *area,
+                                                 GimpGeglMaskData        *data);
+static void   gimp_gegl_combine_mask_area       (const GeglRectangle     *area,
+                                                 GimpGeglMaskData        *data);
+static void   gimp_gegl_combine_mask_weird_area (const GeglRectangle     *area,
+                                                 GimpGeglMaskData        *data);
+static void   gimp_gegl_replace_area            (const GeglRectangle     *area,
+                                                 GimpGeglReplaceData     *data);
+static void   gimp_gegl_buffer_copy_area        (const GeglRectangle     *area,
+                                                 GimpGeglCopyData        *data);
+static void   gimp_gegl_buffer_remap_area       (const GeglRectangle     *area,
+                                                 GimpGeglRemapData       *data);
+static void   gimp_gegl_convert_color_profile_area
+                                                (const GeglRectangle        *area,
+                                                 GimpGeglConvertProfileData *data);
+static void   gimp_gegl_buffer_get_alpha_bounds_area
+                                                (const GeglRectangle        *area,
+                                                 GimpGeglAlphaBoundsData    *data);
+
+
+static const GimpCpuAccelKernel gimp_gegl_smudge_blend_row_kernels[] =
+{
+#if COMPILE_SSE2_INTRINISICS
+  { GIMP_CPU_ACCEL_X86_SSE2, G_CALLBACK (gimp_gegl_smudge_blend_row_sse2) },
+#endif
+  { GIMP_CPU_ACCEL_NONE,     G_CALLBACK (gimp_gegl_smudge_blend_row_generic) }
+};
+
+static GimpGeglSmudgeBlendRowFunc gimp_gegl_smudge_blend_row = NULL;
+
+
+/*  returns the part of @rect that corresponds to @area, which is a
+ *  sub-area of @ref.  only the origin of @rect matters, just like
+ *  for all but the first buffer of a GeglBufferIterator
+ */
+static inline const GeglRectangle *
+gimp_gegl_loops_sub_rect (const GeglRectangle *rect,
+                          const GeglRectangle *ref,
+                          const GeglRectangle *area,
+                          GeglRectangle       *sub_rect)
+{
+  sub_rect->x      = rect->x + (area->x - ref->x);
+  sub_rect->y      = rect->y + (area->y - ref->y);
+  sub_rect->width  = area->width;
+  sub_rect->height = area->height;
+
+  return sub_rect;
+}
+
+
+/*  public functions  */
+
 
 
 void
@@ -41,14 +248,14 @@ gimp_gegl_convolve (GeglBuffer          *src_buffer,
                     GimpConvolutionType  mode,
                     gboolean             alpha_weighting)
 {
-  GeglBufferIterator *dest_iter;
-  gfloat             *src;
-  gint                src_rowstride;
+  GimpGeglConvolveData  data;
+  gfloat               *src;
+  gint                  src_rowstride;
 
-  const Babl         *src_format;
-  const Babl         *dest_format;
-  gint                src_components;
-  gint                dest_components;
+  const Babl           *src_format;
+  const Babl           *dest_format;
+  gint                  src_components;
+  gint                  dest_components;
 
   src_format = gegl_buffer_get_format (src_buffer);
 
@@ -75,56 +282,552 @@ gimp_gegl_convolve (GeglBuffer          *src_buffer,
   src_components  = babl_format_get_n_components (src_format);
   dest_components = babl_format_get_n_components (dest_format);
 
-  /* Set up dest iterator */
-  dest_iter = gegl_buffer_iterator_new (dest_buffer, dest_rect, 0, dest_format,
-                                        GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
-
   /* Get source pixel data */
   src_rowstride = src_components * src_rect->width;
   src = g_malloc (sizeof(gfloat) * src_rowstride * src_rect->height);
   gegl_buffer_get (src_buffer, src_rect, 1.0, src_format, src,
                    GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
 
+  data.src             = src;
+  data.src_rowstride   = src_rowstride;
+  data.src_rect        = src_rect;
+  data.dest_buffer     = dest_buffer;
+  data.dest_format     = dest_format;
+  data.components      = src_components;
+  data.dest_components = dest_components;
+  data.kernel          = kernel;
+  data.kernel_size     = kernel_size;
+  data.divisor         = divisor;
+  data.alpha_weighting = alpha_weighting;
+
+  /*  If the mode is NEGATIVE_CONVOL, the offset should be 128  */
+  if (mode == GIMP_NEGATIVE_CONVOL)
+    {
+      data.offset = 0.5;
+      data.mode   = GIMP_NORMAL_CONVOL;
+    }
+  else
+    {
+      data.offset = 0.0;
+      data.mode   = mode;
+    }
+
+  /*  the source is read-only from here on, so all threads share it  */
+  gimp_parallel_distribute_area (dest_rect, MIN_PARALLEL_SUB_AREA,
+                                 (GimpParallelDistributeAreaFunc)
+                                 (kernel_size == 3 ?
+                                  gimp_gegl_convolve_area_3x3 :
+                                  gimp_gegl_convolve_area),
+                                 &data);
+
+  g_free (src);
+}
+
+void
+gimp_gegl_dodgeburn (GeglBuffer          *src_buffer,
+                     const GeglRectangle *src_rect,
+                     GeglBuffer          *dest_buffer,
+                     const GeglRectangle *dest_rect,
+                     gdouble              exposure,
+                     GimpDodgeBurnType    type,
+                     GimpTransferMode     mode)
+{
+  GimpGeglDodgeBurnData  data;
+  const Babl            *src_format = gegl_buffer_get_format (src_buffer);
+
+  if (type == GIMP_DODGE_BURN_TYPE_BURN)
+    exposure = -exposure;
+
+  switch (mode)
+    {
+    case GIMP_TRANSFER_HIGHLIGHTS:
+      data.factor = 1.0 + exposure * (0.333333);
+      break;
+
+    case GIMP_TRANSFER_MIDTONES:
+      if (exposure < 0)
+        data.factor = 1.0 - exposure * (0.333333);
+      else
+        data.factor = 1.0 / (1.0 + exposure);
+      break;
+
+    case GIMP_TRANSFER_SHADOWS:
+      if (exposure >= 0)
+        data.factor = 0.333333 * exposure;
+      else
+        data.factor = -0.333333 * exposure;
+      break;
+    }
+
+  data.src_buffer  = src_buffer;
+  data.src_rect    = src_rect;
+  data.dest_buffer = dest_buffer;
+  data.dest_rect   = dest_rect;
+  data.exposure    = exposure;
+  data.mode        = mode;
+
+  /*  8-bit gamma sources only have 256 distinct values per channel,
+   *  which is much cheaper to look up than to compute per pixel
+   */
+  data.use_lut = (babl_format_is_palette (src_format) ||
+                  gimp_babl_format_get_precision (src_format) ==
+                  GIMP_PRECISION_U8_GAMMA);
+
+  if (data.use_lut)
+    {
+      gint i;
+
+      for (i = 0; i < 256; i++)
+        data.lut[i] = gimp_gegl_dodgeburn_value (i / 255.0f, &data);
+    }
+
+  gimp_parallel_distribute_area (src_rect, MIN_PARALLEL_SUB_AREA,
+                                 (GimpParallelDistributeAreaFunc)
+                                 gimp_gegl_dodgeburn_area,
+                                 &data);
+}
+
+/*
+ * blend_pixels patched 8-24-05 to fix bug #163721.  Note that this change
+ * causes the function to treat src1 and src2 asymmetrically.  This gives the
+ * right behavior for the smudge tool, which is the only user of this function
+ * at the time of patching.  If you want to use the function for something
+ * else, caveat emptor. *
+ * @top_buffer is blended in place, and @dest_buffer, if non-NULL,
+ * receives a copy of the result in the same pass.
+ */
+void
+gimp_gegl_smudge_blend (GeglBuffer          *top_buffer,
+                        const GeglRectangle *top_rect,
+                        GeglBuffer          *bottom_buffer,
+                        const GeglRectangle *bottom_rect,
+                        GeglBuffer          *dest_buffer,
+                        const GeglRectangle *dest_rect,
+                        gdouble              blend)
+{
+  GimpGeglSmudgeBlendData data;
+
+  data.top_buffer    = top_buffer;
+  data.top_rect      = top_rect;
+  data.bottom_buffer = bottom_buffer;
+  data.bottom_rect   = bottom_rect;
+  data.dest_buffer   = dest_buffer;
+  data.dest_rect     = dest_rect;
+  data.blend         = blend;
+
+  if (! gimp_gegl_smudge_blend_row)
+    gimp_gegl_smudge_blend_row =
+      (GimpGeglSmudgeBlendRowFunc)
+      GIMP_CPU_ACCEL_SELECT (gimp_gegl_smudge_blend_row_kernels);
+
+  data.blend_row     = gimp_gegl_smudge_blend_row;
+
+  gimp_parallel_distribute_area (top_rect, MIN_PARALLEL_SUB_AREA,
+                                 (GimpParallelDistributeAreaFunc)
+                                 gimp_gegl_smudge_blend_area,
+                                 &data);
+}
+
+void
+gimp_gegl_apply_mask (GeglBuffer          *mask_buffer,
+                      const GeglRectangle *mask_rect,
+                      GeglBuffer          *dest_buffer,
+                      const GeglRectangle *dest_rect,
+                      gdouble              opacity)
+{
+  GimpGeglMaskData data;
+
+  data.mask_buffer = mask_buffer;
+  data.mask_rect   = mask_rect;
+  data.dest_buffer = dest_buffer;
+  data.dest_rect   = dest_rect;
+  data.opacity     = opacity;
+  data.stipple     = FALSE;
+
+  gimp_parallel_distribute_area (mask_rect, MIN_PARALLEL_SUB_AREA,
+                                 (GimpParallelDistributeAreaFunc)
+                                 gimp_gegl_apply_mask_area,
+                                 &data);
+}
+
+void
+gimp_gegl_combine_mask (GeglBuffer          *mask_buffer,
+                        const GeglRectangle *mask_rect,
+                        GeglBuffer          *dest_buffer,
+                        const GeglRectangle *dest_rect,
+                        gdouble              opacity)
+{
+  GimpGeglMaskData data;
+
+  data.mask_buffer = mask_buffer;
+  data.mask_rect   = mask_rect;
+  data.dest_buffer = dest_buffer;
+  data.dest_rect   = dest_rect;
+  data.opacity     = opacity;
+  data.stipple     = FALSE;
+
+  gimp_parallel_distribute_area (mask_rect, MIN_PARALLEL_SUB_AREA,
+                                 (GimpParallelDistributeAreaFunc)
+                                 gimp_gegl_combine_mask_area,
+                                 &data);
+}
+
+void
+gimp_gegl_combine_mask_weird (GeglBuffer          *mask_buffer,
+                              const GeglRectangle *mask_rect,
+                              GeglBuffer          *dest_buffer,
+                              const GeglRectangle *dest_rect,
+                              gdouble              opacity,
+                              gboolean             stipple)
+{
+  GimpGeglMaskData data;
+
+  data.mask_buffer = mask_buffer;
+  data.mask_rect   = mask_rect;
+  data.dest_buffer = dest_buffer;
+  data.dest_rect   = dest_rect;
+  data.opacity     = opacity;
+  data.stipple     = stipple;
+
+  gimp_parallel_distribute_area (mask_rect, MIN_PARALLEL_SUB_AREA,
+                                 (GimpParallelDistributeAreaFunc)
+                                 gimp_gegl_combine_mask_weird_area,
+                                 &data);
+}
+
+void
+gimp_gegl_replace (GeglBuffer          *top_buffer,
+                   const GeglRectangle *top_rect,
+                   GeglBuffer          *bottom_buffer,
+                   const GeglRectangle *bottom_rect,
+                   GeglBuffer          *mask_buffer,
+                   const GeglRectangle *mask_rect,
+                   GeglBuffer          *dest_buffer,
+                   const GeglRectangle *dest_rect,
+                   gdouble              opacity,
+                   const gboolean      *affect)
+{
+  GimpGeglReplaceData data;
+
+  data.top_buffer    = top_buffer;
+  data.top_rect      = top_rect;
+  data.bottom_buffer = bottom_buffer;
+  data.bottom_rect   = bottom_rect;
+  data.mask_buffer   = mask_buffer;
+  data.mask_rect     = mask_rect;
+  data.dest_buffer   = dest_buffer;
+  data.dest_rect     = dest_rect;
+  data.opacity       = opacity;
+  data.affect        = affect;
+
+  gimp_parallel_distribute_area (top_rect, MIN_PARALLEL_SUB_AREA,
+                                 (GimpParallelDistributeAreaFunc)
+                                 gimp_gegl_replace_area,
+                                 &data);
+}
+
+/*  like gegl_buffer_copy(), but converts the pixels in parallel if
+ *  the buffers have different formats
+ */
+void
+gimp_gegl_buffer_copy (GeglBuffer          *src_buffer,
+                       const GeglRectangle *src_rect,
+                       GeglBuffer          *dest_buffer,
+                       const GeglRectangle *dest_rect)
+{
+  GimpGeglCopyData data;
+
+  g_return_if_fail (GEGL_IS_BUFFER (src_buffer));
+  g_return_if_fail (GEGL_IS_BUFFER (dest_buffer));
+
+  if (! src_rect)
+    src_rect = gegl_buffer_get_extent (src_buffer);
+
+  if (! dest_rect)
+    dest_rect = gegl_buffer_get_extent (dest_buffer);
+
+  /*  with equal formats, gegl_buffer_copy() can share tiles  */
+  if (gegl_buffer_get_format (src_buffer) ==
+      gegl_buffer_get_format (dest_buffer))
+    {
+      gegl_buffer_copy (src_buffer, src_rect, dest_buffer, dest_rect);
+
+      return;
+    }
+
+  data.src_buffer  = src_buffer;
+  data.src_rect    = src_rect;
+  data.dest_buffer = dest_buffer;
+  data.dest_rect   = dest_rect;
+  data.format      = gegl_buffer_get_format (dest_buffer);
+  data.bpp         = babl_format_get_bytes_per_pixel (data.format);
+
+  gimp_parallel_distribute_area (src_rect, MIN_PARALLEL_SUB_AREA,
+                                 (GimpParallelDistributeAreaFunc)
+                                 gimp_gegl_buffer_copy_area,
+                                 &data);
+}
+
+/*  copies @src_rect of @src_buffer to @dest_rect of @dest_buffer,
+ *  transposing it first if @transpose is set and then mirroring it
+ *  horizontally and/or vertically, which covers flipping as well as
+ *  rotating by multiples of 90 degrees.  the buffers must have the
+ *  same format, and @dest_rect must have @src_rect's size, with width
+ *  and height swapped if @transpose is set.  the pixels are remapped
+ *  in memory one block at a time, in parallel.
+ */
+void
+gimp_gegl_buffer_remap (GeglBuffer          *src_buffer,
+                        const GeglRectangle *src_rect,
+                        GeglBuffer          *dest_buffer,
+                        const GeglRectangle *dest_rect,
+                        gboolean             transpose,
+                        gboolean             flip_x,
+                        gboolean             flip_y)
+{
+  GimpGeglRemapData data;
+
+  g_return_if_fail (GEGL_IS_BUFFER (src_buffer));
+  g_return_if_fail (GEGL_IS_BUFFER (dest_buffer));
+  g_return_if_fail (gegl_buffer_get_format (src_buffer) ==
+                    gegl_buffer_get_format (dest_buffer));
+  g_return_if_fail (src_rect != NULL);
+  g_return_if_fail (dest_rect != NULL);
+  g_return_if_fail (dest_rect->width  == (transpose ? src_rect->height :
+                                                      src_rect->width));
+  g_return_if_fail (dest_rect->height == (transpose ? src_rect->width :
+                                                      src_rect->height));
+
+  data.src_buffer  = src_buffer;
+  data.src_rect    = src_rect;
+  data.dest_buffer = dest_buffer;
+  data.dest_rect   = dest_rect;
+  data.format      = gegl_buffer_get_format (dest_buffer);
+  data.bpp         = babl_format_get_bytes_per_pixel (data.format);
+  data.transpose   = transpose;
+  data.flip_x      = flip_x;
+  data.flip_y      = flip_y;
+
+  gimp_parallel_distribute_area (dest_rect, MIN_PARALLEL_SUB_AREA,
+                                 (GimpParallelDistributeAreaFunc)
+                                 gimp_gegl_buffer_remap_area,
+                                 &data);
+}
+
+/*  converts the RGB pixels of @src_buffer from @src_profile to
+ *  @dest_profile in parallel.  every thread creates its own lcms
+ *  transform the first time it needs one and keeps reusing it for
+ *  all the areas it processes.  returns FALSE if the buffer format
+ *  can't be converted or lcms fails to create a transform.
+ */
+gboolean
+gimp_gegl_convert_color_profile (GeglBuffer               *src_buffer,
+                                 const GeglRectangle      *src_rect,
+                                 GimpColorProfile          src_profile,
+                                 GeglBuffer               *dest_buffer,
+                                 const GeglRectangle      *dest_rect,
+                                 GimpColorProfile          dest_profile,
+                                 GimpColorRenderingIntent  intent,
+                                 gboolean                  bpc)
+{
+  GimpGeglConvertProfileData  data;
+  const Babl                 *format;
+  GimpPrecision               precision;
+  GSList                     *list;
+  gboolean                    success;
+
+  g_return_val_if_fail (GEGL_IS_BUFFER (src_buffer), FALSE);
+  g_return_val_if_fail (src_profile != NULL, FALSE);
+  g_return_val_if_fail (GEGL_IS_BUFFER (dest_buffer), FALSE);
+  g_return_val_if_fail (dest_profile != NULL, FALSE);
+
+  format = gegl_buffer_get_format (dest_buffer);
+
+  if (gimp_babl_format_get_base_type (format) != GIMP_RGB)
+    return FALSE;
+
+  if (! src_rect)
+    src_rect = gegl_buffer_get_extent (src_buffer);
+
+  if (! dest_rect)
+    dest_rect = gegl_buffer_get_extent (dest_buffer);
+
+  data.has_alpha = babl_format_has_alpha (format);
+
+  switch (gimp_babl_format_get_component_type (format))
+    {
+    case GIMP_COMPONENT_TYPE_U8:
+      data.lcms_format = data.has_alpha ? TYPE_RGBA_8 : TYPE_RGB_8;
+      precision        = GIMP_PRECISION_U8_GAMMA;
+      break;
+
+    case GIMP_COMPONENT_TYPE_U16:
+      data.lcms_format = data.has_alpha ? TYPE_RGBA_16 : TYPE_RGB_16;
+      precision        = GIMP_PRECISION_U16_GAMMA;
+      break;
+
+    case GIMP_COMPONENT_TYPE_HALF:
+      data.lcms_format = data.has_alpha ? TYPE_RGBA_HALF_FLT : TYPE_RGB_HALF_FLT;
+      precision        = GIMP_PRECISION_HALF_GAMMA;
+      break;
+
+    case GIMP_COMPONENT_TYPE_DOUBLE:
+      /*  lcms has no RGBA double format  */
+      if (! data.has_alpha)
+        {
+          data.lcms_format = TYPE_RGB_DBL;
+          precision        = GIMP_PRECISION_DOUBLE_GAMMA;
+          break;
+        }
+      /*  fallthru  */
+
+    default:
+      data.lcms_format = data.has_alpha ? TYPE_RGBA_FLT : TYPE_RGB_FLT;
+      precision        = GIMP_PRECISION_FLOAT_GAMMA;
+      break;
+    }
+
+  data.src_buffer   = src_buffer;
+  data.src_rect     = src_rect;
+  data.dest_buffer  = dest_buffer;
+  data.dest_rect    = dest_rect;
+  data.format       = gimp_babl_format (GIMP_RGB, precision, data.has_alpha);
+  data.bpp          = babl_format_get_bytes_per_pixel (data.format);
+  data.src_profile  = src_profile;
+  data.dest_profile = dest_profile;
+  data.intent       = intent;
+  data.flags        = (cmsFLAGS_NOOPTIMIZE |
+                       (bpc ? cmsFLAGS_BLACKPOINTCOMPENSATION : 0));
+  data.transforms   = NULL;
+
+  g_mutex_init (&data.mutex);
+
+  /*  make sure lcms can handle the profiles before going parallel  */
+  data.transforms = g_slist_prepend (data.transforms,
+                                     cmsCreateTransform (src_profile,
+                                                         data.lcms_format,
+                                                         dest_profile,
+                                                         data.lcms_format,
+                                                         intent,
+                                                         data.flags));
+
+  success = (data.transforms->data != NULL);
+
+  if (success)
+    {
+      gimp_parallel_distribute_area (src_rect, MIN_PARALLEL_SUB_AREA,
+                                     (GimpParallelDistributeAreaFunc)
+                                     gimp_gegl_convert_color_profile_area,
+                                     &data);
+    }
+
+  for (list = data.transforms; list; list = g_slist_next (list))
+    {
+      if (list->data)
+        cmsDeleteTransform (list->data);
+    }
+
+  g_slist_free (data.transforms);
+  g_mutex_clear (&data.mutex);
+
+  return success;
+}
+
+/*  Finds the bounding box of the pixels in @rect of @buffer whose alpha
+ *  is not zero.  Returns FALSE if there are none.
+ */
+gboolean
+gimp_gegl_buffer_get_alpha_bounds (GeglBuffer          *buffer,
+                                   const GeglRectangle *rect,
+                                   GeglRectangle       *bounds)
+{
+  GimpGeglAlphaBoundsData data;
+
+  g_return_val_if_fail (GEGL_IS_BUFFER (buffer), FALSE);
+  g_return_val_if_fail (bounds != NULL, FALSE);
+
+  if (! rect)
+    rect = gegl_buffer_get_extent (buffer);
+
+  if (! babl_format_has_alpha (gegl_buffer_get_format (buffer)))
+    {
+      *bounds = *rect;
+
+      return ! gegl_rectangle_is_empty (rect);
+    }
+
+  data.buffer = buffer;
+  data.x1     = G_MAXINT;
+  data.y1     = G_MAXINT;
+  data.x2     = G_MININT;
+  data.y2     = G_MININT;
+
+  g_mutex_init (&data.mutex);
+
+  gimp_parallel_distribute_area (rect, MIN_PARALLEL_SUB_AREA,
+                                 (GimpParallelDistributeAreaFunc)
+                                 gimp_gegl_buffer_get_alpha_bounds_area,
+                                 &data);
+
+  g_mutex_clear (&data.mutex);
+
+  if (data.x1 > data.x2)
+    return FALSE;
+
+  bounds->x      = data.x1;
+  bounds->y      = data.y1;
+  bounds->width  = data.x2 - data.x1 + 1;
+  bounds->height = data.y2 - data.y1 + 1;
+
+  return TRUE;
+}
+
+
+/*  private functions  */
+
+static void
+gimp_gegl_convolve_area (const GeglRectangle  *area,
+                         GimpGeglConvolveData *data)
+{
+  GeglBufferIterator *dest_iter;
+
+  /* Set up dest iterator */
+  dest_iter = gegl_buffer_iterator_new (data->dest_buffer, area, 0,
+                                        data->dest_format,
+                                        GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
+
   while (gegl_buffer_iterator_next (dest_iter))
     {
       /*  Convolve the src image using the convolution kernel, writing
        *  to dest Convolve is not tile-enabled--use accordingly
        */
-      gfloat       *dest        = dest_iter->data[0];
-      const gint    components  = src_components;
-      const gint    a_component = components - 1;
-      const gint    margin      = kernel_size / 2;
-      const gint    x1          = 0;
-      const gint    y1          = 0;
-      const gint    x2          = src_rect->width  - 1;
-      const gint    y2          = src_rect->height - 1;
-      const gint    dest_x1     = dest_iter->roi[0].x;
-      const gint    dest_y1     = dest_iter->roi[0].y;
-      const gint    dest_x2     = dest_iter->roi[0].x + dest_iter->roi[0].width;
-      const gint    dest_y2     = dest_iter->roi[0].y + dest_iter->roi[0].height;
+      const gfloat *src           = data->src;
+      const gint    src_rowstride = data->src_rowstride;
+      gfloat       *dest          = dest_iter->data[0];
+      const gint    components    = data->components;
+      const gint    a_component   = components - 1;
+      const gint    margin        = data->kernel_size / 2;
+      const gdouble divisor       = data->divisor;
+      const gfloat  offset        = data->offset;
+      const gint    x1            = 0;
+      const gint    y1            = 0;
+      const gint    x2            = data->src_rect->width  - 1;
+      const gint    y2            = data->src_rect->height - 1;
+      const gint    dest_x1       = dest_iter->roi[0].x;
+      const gint    dest_y1       = dest_iter->roi[0].y;
+      const gint    dest_x2       = dest_iter->roi[0].x + dest_iter->roi[0].width;
+      const gint    dest_y2       = dest_iter->roi[0].y + dest_iter->roi[0].height;
       gint          x, y;
-      gfloat        offset;
-
-      /*  If the mode is NEGATIVE_CONVOL, the offset should be 128  */
-      if (mode == GIMP_NEGATIVE_CONVOL)
-        {
-          offset = 0.5;
-          mode = GIMP_NORMAL_CONVOL;
-        }
-      else
-        {
-          offset = 0.0;
-        }
 
       for (y = dest_y1; y < dest_y2; y++)
         {
           gfloat *d = dest;
 
-          if (alpha_weighting)
+          if (data->alpha_weighting)
             {
               for (x = dest_x1; x < dest_x2; x++)
                 {
-                  const gfloat *m                = kernel;
+                  const gfloat *m                = data->kernel;
                   gdouble       total[4]         = { 0.0, 0.0, 0.0, 0.0 };
                   gdouble       weighted_divisor = 0.0;
                   gint          i, j, b;
@@ -164,7 +867,7 @@ gimp_gegl_convolve (GeglBuffer          *src_buffer,
                     {
                       total[b] += offset;
 
-                      if (mode != GIMP_NORMAL_CONVOL && total[b] < 0.0)
+                      if (data->mode != GIMP_NORMAL_CONVOL && total[b] < 0.0)
                         total[b] = - total[b];
 
                       *d++ = CLAMP (total[b], 0.0, 1.0);
@@ -175,7 +878,7 @@ gimp_gegl_convolve (GeglBuffer          *src_buffer,
             {
               for (x = dest_x1; x < dest_x2; x++)
                 {
-                  const gfloat *m        = kernel;
+                  const gfloat *m        = data->kernel;
                   gdouble       total[4] = { 0.0, 0.0, 0.0, 0.0 };
                   gint          i, j, b;
 
@@ -196,7 +899,7 @@ gimp_gegl_convolve (GeglBuffer          *src_buffer,
                     {
                       total[b] = total[b] / divisor + offset;
 
-                      if (mode != GIMP_NORMAL_CONVOL && total[b] < 0.0)
+                      if (data->mode != GIMP_NORMAL_CONVOL && total[b] < 0.0)
                         total[b] = - total[b];
 
                       *d++ = CLAMP (total[b], 0.0, 1.0);
@@ -204,42 +907,199 @@ gimp_gegl_convolve (GeglBuffer          *src_buffer,
                 }
             }
 
-          dest += dest_iter->roi[0].width * dest_components;
+          dest += dest_iter->roi[0].width * data->dest_components;
+        }
+    }
+}
+
+/*  the same as gimp_gegl_convolve_area(), specialized for the 3x3
+ *  kernels of the blur/sharpen tool: the source rows and columns are
+ *  clamped once per row and pixel instead of once per tap, and the
+ *  divisions are replaced by multiplications
+ */
+static void
+gimp_gegl_convolve_area_3x3 (const GeglRectangle  *area,
+                             GimpGeglConvolveData *data)
+{
+  GeglBufferIterator *dest_iter;
+
+  dest_iter = gegl_buffer_iterator_new (data->dest_buffer, area, 0,
+                                        data->dest_format,
+                                        GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
+
+  while (gegl_buffer_iterator_next (dest_iter))
+    {
+      const gfloat  *src           = data->src;
+      const gint     src_rowstride = data->src_rowstride;
+      gfloat        *dest          = dest_iter->data[0];
+      const gfloat  *m             = data->kernel;
+      const gint     components    = data->components;
+      const gint     a_component   = components - 1;
+      const gdouble  divisor       = data->divisor;
+      const gdouble  recip         = 1.0 / divisor;
+      const gfloat   offset        = data->offset;
+      const gboolean abs_result    = data->mode != GIMP_NORMAL_CONVOL;
+      const gint     x2            = data->src_rect->width  - 1;
+      const gint     y2            = data->src_rect->height - 1;
+      const gint     dest_x1       = dest_iter->roi[0].x;
+      const gint     dest_y1       = dest_iter->roi[0].y;
+      const gint     dest_x2       = dest_iter->roi[0].x + dest_iter->roi[0].width;
+      const gint     dest_y2       = dest_iter->roi[0].y + dest_iter->roi[0].height;
+      gint           x, y;
+
+      for (y = dest_y1; y < dest_y2; y++)
+        {
+          const gfloat *rows[3];
+          gfloat       *d = dest;
+
+          rows[0] = src + CLAMP (y - 1, 0, y2) * src_rowstride;
+          rows[1] = src + CLAMP (y,     0, y2) * src_rowstride;
+          rows[2] = src + CLAMP (y + 1, 0, y2) * src_rowstride;
+
+          for (x = dest_x1; x < dest_x2; x++)
+            {
+              gint    cols[3];
+              gdouble total[4] = { 0.0, 0.0, 0.0, 0.0 };
+              gint    i, j, b;
+
+              cols[0] = CLAMP (x - 1, 0, x2) * components;
+              cols[1] = CLAMP (x,     0, x2) * components;
+              cols[2] = CLAMP (x + 1, 0, x2) * components;
+
+              if (data->alpha_weighting)
+                {
+                  gdouble weighted_divisor = 0.0;
+
+                  for (j = 0; j < 3; j++)
+                    {
+                      for (i = 0; i < 3; i++)
+                        {
+                          const gfloat  *s          = rows[j] + cols[i];
+                          const gdouble  mult_alpha = m[j * 3 + i] * s[a_component];
+
+                          weighted_divisor += mult_alpha;
+
+                          for (b = 0; b < a_component; b++)
+                            total[b] += mult_alpha * s[b];
+                        }
+                    }
+
+                  total[a_component] = weighted_divisor * recip;
+
+                  if (weighted_divisor != 0.0)
+                    weighted_divisor = 1.0 / weighted_divisor;
+                  else
+                    weighted_divisor = recip;
+
+                  for (b = 0; b < a_component; b++)
+                    total[b] *= weighted_divisor;
+                }
+              else
+                {
+                  for (j = 0; j < 3; j++)
+                    {
+                      for (i = 0; i < 3; i++)
+                        {
+                          const gfloat *s = rows[j] + cols[i];
+
+                          for (b = 0; b < components; b++)
+                            total[b] += m[j * 3 + i] * s[b];
+                        }
+                    }
+
+                  for (b = 0; b < components; b++)
+                    total[b] *= recip;
+                }
+
+              for (b = 0; b < components; b++)
+                {
+                  total[b] += offset;
+
+                  if (abs_result && total[b] < 0.0)
+                    total[b] = - total[b];
+
+                  *d++ = CLAMP (total[b], 0.0, 1.0);
+                }
+            }
+
+          dest += dest_iter->roi[0].width * data->dest_components;
         }
     }
+}
 
-  g_free (src);
+static gfloat
+gimp_gegl_dodgeburn_value (gfloat                 value,
+                           GimpGeglDodgeBurnData *data)
+{
+  const gfloat factor = data->factor;
+
+  switch (data->mode)
+    {
+    case GIMP_TRANSFER_HIGHLIGHTS:
+      return value * factor;
+
+    case GIMP_TRANSFER_MIDTONES:
+      return pow (value, factor);
+
+    case GIMP_TRANSFER_SHADOWS:
+      if (data->exposure >= 0)
+        return factor + value - factor * value;
+      else if (value < factor)
+        return 0.0;
+      else
+        return (value - factor) / (1.0 - factor);
+    }
+
+  return value;
 }
 
-void
-gimp_gegl_dodgeburn (GeglBuffer          *src_buffer,
-                     const GeglRectangle *src_rect,
-                     GeglBuffer          *dest_buffer,
-                     const GeglRectangle *dest_rect,
-                     gdouble              exposure,
-                     GimpDodgeBurnType    type,
-                     GimpTransferMode     mode)
+static void
+gimp_gegl_dodgeburn_area (const GeglRectangle   *area,
+                          GimpGeglDodgeBurnData *data)
 {
   GeglBufferIterator *iter;
+  GeglRectangle       dest_area;
+  const gfloat        factor = data->factor;
 
-  if (type == GIMP_DODGE_BURN_TYPE_BURN)
-    exposure = -exposure;
-
-  iter = gegl_buffer_iterator_new (src_buffer, src_rect, 0,
+  iter = gegl_buffer_iterator_new (data->src_buffer, area, 0,
+                                   data->use_lut ?
+                                   babl_format ("R'G'B'A u8") :
                                    babl_format ("R'G'B'A float"),
                                    GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
 
-  gegl_buffer_iterator_add (iter, dest_buffer, dest_rect, 0,
-                            babl_format ("R'G'B'A float"),
+  gegl_buffer_iterator_add (iter, data->dest_buffer,
+                            gimp_gegl_loops_sub_rect (data->dest_rect,
+                                                      data->src_rect,
+                                                      area, &dest_area),
+                            0, babl_format ("R'G'B'A float"),
                             GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
 
-  switch (mode)
+  if (data->use_lut)
     {
-      gfloat factor;
+      const gfloat *lut = data->lut;
 
-    case GIMP_TRANSFER_HIGHLIGHTS:
-      factor = 1.0 + exposure * (0.333333);
+      while (gegl_buffer_iterator_next (iter))
+        {
+          const guint8 *src   = iter->data[0];
+          gfloat       *dest  = iter->data[1];
+          gint          count = iter->length;
+
+          while (count--)
+            {
+              *dest++ = lut[*src++];
+              *dest++ = lut[*src++];
+              *dest++ = lut[*src++];
 
+              *dest++ = *src++ / 255.0f;
+            }
+        }
+
+      return;
+    }
+
+  switch (data->mode)
+    {
+    case GIMP_TRANSFER_HIGHLIGHTS:
       while (gegl_buffer_iterator_next (iter))
         {
           gfloat *src   = iter->data[0];
@@ -258,11 +1118,6 @@ gimp_gegl_dodgeburn (GeglBuffer          *src_buffer,
       break;
 
     case GIMP_TRANSFER_MIDTONES:
-      if (exposure < 0)
-        factor = 1.0 - exposure * (0.333333);
-      else
-        factor = 1.0 / (1.0 + exposure);
-
       while (gegl_buffer_iterator_next (iter))
         {
           gfloat *src   = iter->data[0];
@@ -281,139 +1136,157 @@ gimp_gegl_dodgeburn (GeglBuffer          *src_buffer,
       break;
 
     case GIMP_TRANSFER_SHADOWS:
-      if (exposure >= 0)
-        factor = 0.333333 * exposure;
-      else
-        factor = -0.333333 * exposure;
-
-      while (gegl_buffer_iterator_next (iter))
+      /*  keep the test for the sign of the exposure out of the
+       *  pixel loops, so the compiler can vectorize them
+       */
+      if (data->exposure >= 0)
         {
-          gfloat *src   = iter->data[0];
-          gfloat *dest  = iter->data[1];
-          gint    count = iter->length;
-
-          while (count--)
+          while (gegl_buffer_iterator_next (iter))
             {
-              if (exposure >= 0)
+              gfloat *src   = iter->data[0];
+              gfloat *dest  = iter->data[1];
+              gint    count = iter->length;
+
+              while (count--)
                 {
                   gfloat s;
 
                   s = *src++; *dest++ = factor + s - factor * s;
                   s = *src++; *dest++ = factor + s - factor * s;
                   s = *src++; *dest++ = factor + s - factor * s;
+
+                  *dest++ = *src++;
                 }
-              else
+            }
+        }
+      else
+        {
+          const gfloat recip = 1.0 / (1.0 - factor);
+
+          while (gegl_buffer_iterator_next (iter))
+            {
+              gfloat *src   = iter->data[0];
+              gfloat *dest  = iter->data[1];
+              gint    count = iter->length;
+
+              while (count--)
                 {
-                  gfloat s;
+                  gint b;
 
-                  s = *src++;
-                  if (s < factor)
-                    *dest++ = 0;
-                  else /* factor <= value <=1 */
-                    *dest++ = (s - factor) / (1.0 - factor);
-
-                  s = *src++;
-                  if (s < factor)
-                    *dest++ = 0;
-                  else /* factor <= value <=1 */
-                    *dest++ = (s - factor) / (1.0 - factor);
-
-                  s = *src++;
-                  if (s < factor)
-                    *dest++ = 0;
-                  else /* factor <= value <=1 */
-                    *dest++ = (s - factor) / (1.0 - factor);
-                }
+                  for (b = 0; b < 3; b++)
+                    {
+                      gfloat s = *src++;
 
-              *dest++ = *src++;
-           }
+                      /* factor <= value <=1 */
+                      *dest++ = s < factor ? 0.0 : (s - factor) * recip;
+                    }
+
+                  *dest++ = *src++;
+                }
+            }
         }
       break;
     }
 }
 
-/*
- * blend_pixels patched 8-24-05 to fix bug #163721.  Note that this change
- * causes the function to treat src1 and src2 asymmetrically.  This gives the
- * right behavior for the smudge tool, which is the only user of this function
- * at the time of patching.  If you want to use the function for something
- * else, caveat emptor.
- */
-void
-gimp_gegl_smudge_blend (GeglBuffer          *top_buffer,
-                        const GeglRectangle *top_rect,
-                        GeglBuffer          *bottom_buffer,
-                        const GeglRectangle *bottom_rect,
-                        GeglBuffer          *dest_buffer,
-                        const GeglRectangle *dest_rect,
-                        gdouble              blend)
+static void
+gimp_gegl_smudge_blend_row_generic (gfloat       *top,
+                                    const gfloat *bottom,
+                                    gfloat       *dest,
+                                    gint          n_pixels,
+                                    gfloat        blend)
+{
+  const gfloat blend1 = 1.0 - blend;
+  const gfloat blend2 = blend;
+
+  while (n_pixels--)
+    {
+      const gfloat a1 = blend1 * bottom[3];
+      const gfloat a2 = blend2 * top[3];
+      const gfloat a  = a1 + a2;
+      gint         b;
+
+      if (a == 0)
+        {
+          for (b = 0; b < 4; b++)
+            top[b] = 0;
+        }
+      else
+        {
+          for (b = 0; b < 3; b++)
+            top[b] =
+              bottom[b] + (bottom[b] * a1 + top[b] * a2 - a * bottom[b]);
+
+          top[3] = a;
+        }
+
+      if (dest)
+        {
+          for (b = 0; b < 4; b++)
+            dest[b] = top[b];
+
+          dest += 4;
+        }
+
+      top    += 4;
+      bottom += 4;
+    }
+}
+
+static void
+gimp_gegl_smudge_blend_area (const GeglRectangle     *area,
+                             GimpGeglSmudgeBlendData *data)
 {
   GeglBufferIterator *iter;
+  GeglRectangle       bottom_area;
+  GeglRectangle       dest_area;
 
-  iter = gegl_buffer_iterator_new (top_buffer, top_rect, 0,
+  iter = gegl_buffer_iterator_new (data->top_buffer, area, 0,
                                    babl_format ("RGBA float"),
-                                   GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
+                                   GEGL_ACCESS_READWRITE, GEGL_ABYSS_NONE);
 
-  gegl_buffer_iterator_add (iter, bottom_buffer, bottom_rect, 0,
-                            babl_format ("RGBA float"),
+  gegl_buffer_iterator_add (iter, data->bottom_buffer,
+                            gimp_gegl_loops_sub_rect (data->bottom_rect,
+                                                      data->top_rect,
+                                                      area, &bottom_area),
+                            0, babl_format ("RGBA float"),
                             GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
 
-  gegl_buffer_iterator_add (iter, dest_buffer, dest_rect, 0,
-                            babl_format ("RGBA float"),
-                            GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
+  if (data->dest_buffer)
+    gegl_buffer_iterator_add (iter, data->dest_buffer,
+                              gimp_gegl_loops_sub_rect (data->dest_rect,
+                                                        data->top_rect,
+                                                        area, &dest_area),
+                              0, babl_format ("RGBA float"),
+                              GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
 
   while (gegl_buffer_iterator_next (iter))
     {
-      const gfloat *top    = iter->data[0];
-      const gfloat *bottom = iter->data[1];
-      gfloat       *dest   = iter->data[2];
-      gint          count  = iter->length;
-      const gfloat  blend1 = 1.0 - blend;
-      const gfloat  blend2 = blend;
-
-      while (count--)
-        {
-          const gfloat a1 = blend1 * bottom[3];
-          const gfloat a2 = blend2 * top[3];
-          const gfloat a  = a1 + a2;
-          gint         b;
-
-          if (a == 0)
-            {
-              for (b = 0; b < 4; b++)
-                dest[b] = 0;
-            }
-          else
-            {
-              for (b = 0; b < 3; b++)
-                dest[b] =
-                  bottom[b] + (bottom[b] * a1 + top[b] * a2 - a * bottom[b]);
-
-              dest[3] = a;
-            }
-
-          top    += 4;
-          bottom += 4;
-          dest   += 4;
-        }
+      data->blend_row (iter->data[0],
+                       iter->data[1],
+                       data->dest_buffer ? iter->data[2] : NULL,
+                       iter->length,
+                       data->blend);
     }
 }
 
-void
-gimp_gegl_apply_mask (GeglBuffer          *mask_buffer,
-                      const GeglRectangle *mask_rect,
-                      GeglBuffer          *dest_buffer,
-                      const GeglRectangle *dest_rect,
-                      gdouble              opacity)
+static void
+gimp_gegl_apply_mask_area (const GeglRectangle *area,
+                           GimpGeglMaskData    *data)
 {
   GeglBufferIterator *iter;
+  GeglRectangle       dest_area;
+  const gfloat        opacity = data->opacity;
 
-  iter = gegl_buffer_iterator_new (mask_buffer, mask_rect, 0,
+  iter = gegl_buffer_iterator_new (data->mask_buffer, area, 0,
                                    babl_format ("Y float"),
                                    GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
 
-  gegl_buffer_iterator_add (iter, dest_buffer, dest_rect, 0,
-                            babl_format ("RGBA float"),
+  gegl_buffer_iterator_add (iter, data->dest_buffer,
+                            gimp_gegl_loops_sub_rect (data->dest_rect,
+                                                      data->mask_rect,
+                                                      area, &dest_area),
+                            0, babl_format ("RGBA float"),
                             GEGL_ACCESS_READWRITE, GEGL_ABYSS_NONE);
 
   while (gegl_buffer_iterator_next (iter))
@@ -421,32 +1294,30 @@ gimp_gegl_apply_mask (GeglBuffer          *mask_buffer,
       const gfloat *mask  = iter->data[0];
       gfloat       *dest  = iter->data[1];
       gint          count = iter->length;
+      gint          i;
 
-      while (count--)
-        {
-          dest[3] *= *mask * opacity;
-
-          mask += 1;
-          dest += 4;
-        }
+      for (i = 0; i < count; i++)
+        dest[4 * i + 3] *= mask[i] * opacity;
     }
 }
 
-void
-gimp_gegl_combine_mask (GeglBuffer          *mask_buffer,
-                        const GeglRectangle *mask_rect,
-                        GeglBuffer          *dest_buffer,
-                        const GeglRectangle *dest_rect,
-                        gdouble              opacity)
+static void
+gimp_gegl_combine_mask_area (const GeglRectangle *area,
+                             GimpGeglMaskData    *data)
 {
   GeglBufferIterator *iter;
+  GeglRectangle       dest_area;
+  const gfloat        opacity = data->opacity;
 
-  iter = gegl_buffer_iterator_new (mask_buffer, mask_rect, 0,
+  iter = gegl_buffer_iterator_new (data->mask_buffer, area, 0,
                                    babl_format ("Y float"),
                                    GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
 
-  gegl_buffer_iterator_add (iter, dest_buffer, dest_rect, 0,
-                            babl_format ("Y float"),
+  gegl_buffer_iterator_add (iter, data->dest_buffer,
+                            gimp_gegl_loops_sub_rect (data->dest_rect,
+                                                      data->mask_rect,
+                                                      area, &dest_area),
+                            0, babl_format ("Y float"),
                             GEGL_ACCESS_READWRITE, GEGL_ABYSS_NONE);
 
   while (gegl_buffer_iterator_next (iter))
@@ -454,33 +1325,30 @@ gimp_gegl_combine_mask (GeglBuffer          *mask_buffer,
       const gfloat *mask  = iter->data[0];
       gfloat       *dest  = iter->data[1];
       gint          count = iter->length;
+      gint          i;
 
-      while (count--)
-        {
-          *dest *= *mask * opacity;
-
-          mask += 1;
-          dest += 1;
-        }
+      for (i = 0; i < count; i++)
+        dest[i] *= mask[i] * opacity;
     }
 }
 
-void
-gimp_gegl_combine_mask_weird (GeglBuffer          *mask_buffer,
-                              const GeglRectangle *mask_rect,
-                              GeglBuffer          *dest_buffer,
-                              const GeglRectangle *dest_rect,
-                              gdouble              opacity,
-                              gboolean             stipple)
+static void
+gimp_gegl_combine_mask_weird_area (const GeglRectangle *area,
+                                   GimpGeglMaskData    *data)
 {
   GeglBufferIterator *iter;
+  GeglRectangle       dest_area;
+  const gfloat        opacity = data->opacity;
 
-  iter = gegl_buffer_iterator_new (mask_buffer, mask_rect, 0,
+  iter = gegl_buffer_iterator_new (data->mask_buffer, area, 0,
                                    babl_format ("Y float"),
                                    GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
 
-  gegl_buffer_iterator_add (iter, dest_buffer, dest_rect, 0,
-                            babl_format ("Y float"),
+  gegl_buffer_iterator_add (iter, data->dest_buffer,
+                            gimp_gegl_loops_sub_rect (data->dest_rect,
+                                                      data->mask_rect,
+                                                      area, &dest_area),
+                            0, babl_format ("Y float"),
                             GEGL_ACCESS_READWRITE, GEGL_ABYSS_NONE);
 
   while (gegl_buffer_iterator_next (iter))
@@ -488,59 +1356,57 @@ gimp_gegl_combine_mask_weird (GeglBuffer          *mask_buffer,
       const gfloat *mask  = iter->data[0];
       gfloat       *dest  = iter->data[1];
       gint          count = iter->length;
+      gint          i;
 
-      if (stipple)
+      if (data->stipple)
         {
-          while (count--)
-            {
-              dest[0] += (1.0 - dest[0]) * *mask * opacity;
-
-              mask += 1;
-              dest += 1;
-            }
+          for (i = 0; i < count; i++)
+            dest[i] += (1.0f - dest[i]) * mask[i] * opacity;
         }
       else
         {
-          while (count--)
+          for (i = 0; i < count; i++)
             {
-              if (opacity > dest[0])
-                dest[0] += (opacity - dest[0]) * *mask * opacity;
-
-              mask += 1;
-              dest += 1;
+              if (opacity > dest[i])
+                dest[i] += (opacity - dest[i]) * mask[i] * opacity;
             }
         }
     }
 }
 
-void
-gimp_gegl_replace (GeglBuffer          *top_buffer,
-                   const GeglRectangle *top_rect,
-                   GeglBuffer          *bottom_buffer,
-                   const GeglRectangle *bottom_rect,
-                   GeglBuffer          *mask_buffer,
-                   const GeglRectangle *mask_rect,
-                   GeglBuffer          *dest_buffer,
-                   const GeglRectangle *dest_rect,
-                   gdouble              opacity,
-                   const gboolean      *affect)
+static void
+gimp_gegl_replace_area (const GeglRectangle *area,
+                        GimpGeglReplaceData *data)
 {
   GeglBufferIterator *iter;
+  GeglRectangle       bottom_area;
+  GeglRectangle       mask_area;
+  GeglRectangle       dest_area;
+  const gboolean     *affect = data->affect;
 
-  iter = gegl_buffer_iterator_new (top_buffer, top_rect, 0,
+  iter = gegl_buffer_iterator_new (data->top_buffer, area, 0,
                                    babl_format ("RGBA float"),
                                    GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
 
-  gegl_buffer_iterator_add (iter, bottom_buffer, bottom_rect, 0,
-                            babl_format ("RGBA float"),
+  gegl_buffer_iterator_add (iter, data->bottom_buffer,
+                            gimp_gegl_loops_sub_rect (data->bottom_rect,
+                                                      data->top_rect,
+                                                      area, &bottom_area),
+                            0, babl_format ("RGBA float"),
                             GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
 
-  gegl_buffer_iterator_add (iter, mask_buffer, mask_rect, 0,
-                            babl_format ("Y float"),
+  gegl_buffer_iterator_add (iter, data->mask_buffer,
+                            gimp_gegl_loops_sub_rect (data->mask_rect,
+                                                      data->top_rect,
+                                                      area, &mask_area),
+                            0, babl_format ("Y float"),
                             GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
 
-  gegl_buffer_iterator_add (iter, dest_buffer, dest_rect, 0,
-                            babl_format ("RGBA float"),
+  gegl_buffer_iterator_add (iter, data->dest_buffer,
+                            gimp_gegl_loops_sub_rect (data->dest_rect,
+                                                      data->top_rect,
+                                                      area, &dest_area),
+                            0, babl_format ("RGBA float"),
                             GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
 
   while (gegl_buffer_iterator_next (iter))
@@ -554,7 +1420,7 @@ gimp_gegl_replace (GeglBuffer          *top_buffer,
       while (count--)
         {
           gint    b;
-          gdouble mask_val = *mask * opacity;
+          gdouble mask_val = *mask * data->opacity;
 
           /* calculate new alpha first. */
           gfloat   s1_a  = bottom[3];
@@ -618,3 +1484,230 @@ gimp_gegl_replace (GeglBuffer          *top_buffer,
         }
     }
 }
+
+static void
+gimp_gegl_buffer_copy_area (const GeglRectangle *area,
+                            GimpGeglCopyData    *data)
+{
+  GeglBufferIterator *iter;
+  GeglRectangle       dest_area;
+
+  /*  the iterator converts the source tiles to the destination format  */
+  iter = gegl_buffer_iterator_new (data->src_buffer, area, 0,
+                                   data->format,
+                                   GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
+
+  gegl_buffer_iterator_add (iter, data->dest_buffer,
+                            gimp_gegl_loops_sub_rect (data->dest_rect,
+                                                      data->src_rect,
+                                                      area, &dest_area),
+                            0, data->format,
+                            GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
+
+  while (gegl_buffer_iterator_next (iter))
+    memcpy (iter->data[1], iter->data[0], iter->length * data->bpp);
+}
+
+static void
+gimp_gegl_buffer_remap_area (const GeglRectangle *area,
+                             GimpGeglRemapData   *data)
+{
+  const gint  block_size = MIN_PARALLEL_SUB_SIZE;
+  guchar     *src;
+  guchar     *dest;
+  gint        bpp        = data->bpp;
+  gint        block_x;
+  gint        block_y;
+
+  src  = g_malloc (block_size * block_size * bpp);
+  dest = g_malloc (block_size * block_size * bpp);
+
+  for (block_y = area->y;
+       block_y < area->y + area->height;
+       block_y += block_size)
+    {
+      for (block_x = area->x;
+           block_x < area->x + area->width;
+           block_x += block_size)
+        {
+          GeglRectangle dest_block;
+          GeglRectangle src_block;
+          gint          u, v;
+          gint          x, y;
+
+          dest_block.x      = block_x;
+          dest_block.y      = block_y;
+          dest_block.width  = MIN (block_size,
+                                   area->x + area->width  - block_x);
+          dest_block.height = MIN (block_size,
+                                   area->y + area->height - block_y);
+
+          /*  the block's origin and size in untransposed source
+           *  orientation, relative to the rects
+           */
+          if (data->transpose)
+            {
+              u                = dest_block.y - data->dest_rect->y;
+              v                = dest_block.x - data->dest_rect->x;
+              src_block.width  = dest_block.height;
+              src_block.height = dest_block.width;
+            }
+          else
+            {
+              u                = dest_block.x - data->dest_rect->x;
+              v                = dest_block.y - data->dest_rect->y;
+              src_block.width  = dest_block.width;
+              src_block.height = dest_block.height;
+            }
+
+          if (data->flip_x)
+            u = data->src_rect->width - u - src_block.width;
+
+          if (data->flip_y)
+            v = data->src_rect->height - v - src_block.height;
+
+          src_block.x = data->src_rect->x + u;
+          src_block.y = data->src_rect->y + v;
+
+          gegl_buffer_get (data->src_buffer, &src_block, 1.0,
+                           data->format, src,
+                           GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+          for (y = 0; y < dest_block.height; y++)
+            {
+              guchar *d = dest + y * dest_block.width * bpp;
+
+              for (x = 0; x < dest_block.width; x++)
+                {
+                  gint sx = data->transpose ? y : x;
+                  gint sy = data->transpose ? x : y;
+
+                  if (data->flip_x)
+                    sx = src_block.width - 1 - sx;
+
+                  if (data->flip_y)
+                    sy = src_block.height - 1 - sy;
+
+                  memcpy (d, src + (sy * src_block.width + sx) * bpp, bpp);
+                  d += bpp;
+                }
+            }
+
+          gegl_buffer_set (data->dest_buffer, &dest_block, 0,
+                           data->format, dest, GEGL_AUTO_ROWSTRIDE);
+        }
+    }
+
+  g_free (dest);
+  g_free (src);
+}
+
+static void
+gimp_gegl_convert_color_profile_area (const GeglRectangle        *area,
+                                      GimpGeglConvertProfileData *data)
+{
+  GeglBufferIterator *iter;
+  GeglRectangle       dest_area;
+  cmsHTRANSFORM       transform;
+
+  /*  lcms transforms keep a pixel cache and must not be shared
+   *  between threads, so take one from the pool or make a new one
+   */
+  g_mutex_lock (&data->mutex);
+
+  if (data->transforms)
+    {
+      transform        = data->transforms->data;
+      data->transforms = g_slist_delete_link (data->transforms,
+                                              data->transforms);
+    }
+  else
+    {
+      transform = cmsCreateTransform (data->src_profile,  data->lcms_format,
+                                      data->dest_profile, data->lcms_format,
+                                      data->intent,
+                                      data->flags);
+    }
+
+  g_mutex_unlock (&data->mutex);
+
+  if (! transform)
+    return;
+
+  iter = gegl_buffer_iterator_new (data->src_buffer, area, 0,
+                                   data->format,
+                                   GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
+
+  gegl_buffer_iterator_add (iter, data->dest_buffer,
+                            gimp_gegl_loops_sub_rect (data->dest_rect,
+                                                      data->src_rect,
+                                                      area, &dest_area),
+                            0, data->format,
+                            GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
+
+  while (gegl_buffer_iterator_next (iter))
+    {
+      /*  lcms doesn't touch the alpha channel, simply
+       *  copy everything to dest before the transform
+       */
+      if (data->has_alpha)
+        memcpy (iter->data[1], iter->data[0], iter->length * data->bpp);
+
+      cmsDoTransform (transform,
+                      iter->data[0], iter->data[1], iter->length);
+    }
+
+  g_mutex_lock (&data->mutex);
+
+  data->transforms = g_slist_prepend (data->transforms, transform);
+
+  g_mutex_unlock (&data->mutex);
+}
+
+static void
+gimp_gegl_buffer_get_alpha_bounds_area (const GeglRectangle     *area,
+                                        GimpGeglAlphaBoundsData *data)
+{
+  GeglBufferIterator *iter;
+  gint                x1 = G_MAXINT;
+  gint                y1 = G_MAXINT;
+  gint                x2 = G_MININT;
+  gint                y2 = G_MININT;
+
+  iter = gegl_buffer_iterator_new (data->buffer, area, 0,
+                                   babl_format ("A float"),
+                                   GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
+
+  while (gegl_buffer_iterator_next (iter))
+    {
+      const gfloat        *alpha = iter->data[0];
+      const GeglRectangle *roi   = &iter->roi[0];
+      gint                 x, y;
+
+      for (y = roi->y; y < roi->y + roi->height; y++)
+        {
+          for (x = roi->x; x < roi->x + roi->width; x++, alpha++)
+            {
+              if (*alpha > 0.0f)
+                {
+                  x1 = MIN (x1, x);
+                  y1 = MIN (y1, y);
+                  x2 = MAX (x2, x);
+                  y2 = MAX (y2, y);
+                }
+            }
+        }
+    }
+
+  if (x1 <= x2)
+    {
+      g_mutex_lock (&data->mutex);
+
+      data->x1 = MIN (data->x1, x1);
+      data->y1 = MIN (data->y1, y1);
+      data->x2 = MAX (data->x2, x2);
+      data->y2 = MAX (data->y2, y2);
+
+      g_mutex_unlock (&data->mutex);
+    }
+}
@@ -81,5 +81,31 @@ void   gimp_gegl_replace            (GeglBuffer          *top_buffer,
                                      gdouble              opacity,
                                      const gboolean      *affect);
 
+void   gimp_gegl_buffer_copy        (GeglBuffer          *src_buffer,
+                                     const GeglRectangle *src_rect,
+                                     GeglBuffer          *dest_buffer,
+                                     const GeglRectangle *dest_rect);
+
+void   gimp_gegl_buffer_remap       (GeglBuffer          *src_buffer,
+                                     const GeglRectangle *src_rect,
+                                     GeglBuffer          *dest_buffer,
+                                     const GeglRectangle *dest_rect,
+                                     gboolean             transpose,
+                                     gboolean             flip_x,
+                                     gboolean             flip_y);
+
+gboolean gimp_gegl_buffer_get_alpha_bounds (GeglBuffer          *buffer,
+                                            const GeglRectangle *rect,
+                                            GeglRectangle       *bounds);
+
+gboolean gimp_gegl_convert_color_profile (GeglBuffer               *src_buffer,
+                                          const GeglRectangle      *src_rect,
+                                          GimpColorProfile          src_profile,
+                                          GeglBuffer               *dest_buffer,
+                                          const GeglRectangle      *dest_rect,
+                                          GimpColorProfile          dest_profile,
+                                          GimpColorRenderingIntent  intent,
+                                          gboolean                  bpc);
+
 
 #endif /* __GIMP_GEGL_LOOPS_H__ */
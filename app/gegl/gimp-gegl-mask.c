@@ -30,9 +30,24 @@ gimp_gegl_mask_bounds (GeglBuffer *buffer,
                        gint        *y1,
                        gint        *x2,
                        gint        *y2)
+{
+  return gimp_gegl_mask_bounds_in_area (buffer, NULL, x1, y1, x2, y2);
+}
+
+/*  like gimp_gegl_mask_bounds(), but only looks at the pixels within
+ *  @area, for callers which know that the mask is empty outside of it
+ */
+gboolean
+gimp_gegl_mask_bounds_in_area (GeglBuffer          *buffer,
+                               const GeglRectangle *area,
+                               gint                *x1,
+                               gint                *y1,
+                               gint                *x2,
+                               gint                *y2)
 {
   GeglBufferIterator *iter;
   GeglRectangle      *roi;
+  GeglRectangle       rect;
   gint                tx1, tx2, ty1, ty2;
 
   g_return_val_if_fail (GEGL_IS_BUFFER (buffer), FALSE);
@@ -41,13 +56,27 @@ gimp_gegl_mask_bounds (GeglBuffer *buffer,
   g_return_val_if_fail (x2 != NULL, FALSE);
   g_return_val_if_fail (y2 != NULL, FALSE);
 
+  if (! area)
+    area = gegl_buffer_get_extent (buffer);
+
+  if (! gegl_rectangle_intersect (&rect, area,
+                                  gegl_buffer_get_extent (buffer)))
+    {
+      *x1 = 0;
+      *y1 = 0;
+      *x2 = gegl_buffer_get_width  (buffer);
+      *y2 = gegl_buffer_get_height (buffer);
+
+      return FALSE;
+    }
+
   /*  go through and calculate the bounds  */
-  tx1 = gegl_buffer_get_width  (buffer);
-  ty1 = gegl_buffer_get_height (buffer);
+  tx1 = rect.x + rect.width;
+  ty1 = rect.y + rect.height;
   tx2 = 0;
   ty2 = 0;
 
-  iter = gegl_buffer_iterator_new (buffer, NULL, 0, babl_format ("Y float"),
+  iter = gegl_buffer_iterator_new (buffer, &rect, 0, babl_format ("Y float"),
                                    GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
   roi = &iter->roi[0];
 
@@ -111,8 +140,8 @@ gimp_gegl_mask_bounds (GeglBuffer *buffer,
   tx2 = CLAMP (tx2 + 1, 0, gegl_buffer_get_width  (buffer));
   ty2 = CLAMP (ty2 + 1, 0, gegl_buffer_get_height (buffer));
 
-  if (tx1 == gegl_buffer_get_width  (buffer) &&
-      ty1 == gegl_buffer_get_height (buffer))
+  if (tx1 == rect.x + rect.width &&
+      ty1 == rect.y + rect.height)
     {
       *x1 = 0;
       *y1 = 0;
@@ -158,3 +187,34 @@ gimp_gegl_mask_is_empty (GeglBuffer *buffer)
 
   return TRUE;
 }
+
+gboolean
+gimp_gegl_mask_is_full_in_area (GeglBuffer          *buffer,
+                                const GeglRectangle *area)
+{
+  GeglBufferIterator *iter;
+
+  g_return_val_if_fail (GEGL_IS_BUFFER (buffer), FALSE);
+  g_return_val_if_fail (area != NULL, FALSE);
+
+  iter = gegl_buffer_iterator_new (buffer, area, 0, babl_format ("Y float"),
+                                   GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
+
+  while (gegl_buffer_iterator_next (iter))
+    {
+      gfloat *data = iter->data[0];
+      gint    i;
+
+      for (i = 0; i < iter->length; i++)
+        {
+          if (data[i] < 1.0)
+            {
+              gegl_buffer_iterator_stop (iter);
+
+              return FALSE;
+            }
+        }
+    }
+
+  return TRUE;
+}
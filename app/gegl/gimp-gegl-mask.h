@@ -19,12 +19,20 @@
 #define __GIMP_GEGL_MASK_H__
 
 
-gboolean   gimp_gegl_mask_bounds   (GeglBuffer *buffer,
-                                    gint        *x1,
-                                    gint        *y1,
-                                    gint        *x2,
-                                    gint        *y2);
-gboolean   gimp_gegl_mask_is_empty (GeglBuffer *buffer);
+gboolean   gimp_gegl_mask_bounds          (GeglBuffer          *buffer,
+                                           gint                *x1,
+                                           gint                *y1,
+                                           gint                *x2,
+                                           gint                *y2);
+gboolean   gimp_gegl_mask_bounds_in_area  (GeglBuffer          *buffer,
+                                           const GeglRectangle *area,
+                                           gint                *x1,
+                                           gint                *y1,
+                                           gint                *x2,
+                                           gint                *y2);
+gboolean   gimp_gegl_mask_is_empty        (GeglBuffer          *buffer);
+gboolean   gimp_gegl_mask_is_full_in_area (GeglBuffer          *buffer,
+                                           const GeglRectangle *area);
 
 
 #endif /* __GIMP_GEGL_MASK_H__ */
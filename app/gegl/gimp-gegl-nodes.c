@@ -138,6 +138,58 @@ gimp_gegl_add_buffer_source (GeglNode   *parent,
   return buffer_source;
 }
 
+/*  Creates a node from a GEGL XML graph, which can be used like a
+ *  single operation: the XML format chains the nodes from the output
+ *  down, and leaves the input of the bottom node open, which is
+ *  connected to the node's "input" here.  Returns NULL if @xml can't
+ *  be parsed or produces no output.
+ */
+GeglNode *
+gimp_gegl_create_graph_node (const gchar *xml)
+{
+  GeglNode *node;
+  GeglNode *input;
+  GeglNode *output;
+  GeglNode *bottom;
+
+  g_return_val_if_fail (xml != NULL, NULL);
+
+  node = gegl_node_new_from_xml (xml, NULL);
+
+  if (! node)
+    return NULL;
+
+  input  = gegl_node_get_input_proxy  (node, "input");
+  output = gegl_node_get_output_proxy (node, "output");
+
+  bottom = gegl_node_get_producer (output, "input", NULL);
+
+  if (! bottom)
+    {
+      g_object_unref (node);
+
+      return NULL;
+    }
+
+  if (gegl_node_get_consumers (input, "output", NULL, NULL) == 0)
+    {
+      GeglNode *producer;
+
+      while (bottom != input                     &&
+             gegl_node_has_pad (bottom, "input") &&
+             (producer = gegl_node_get_producer (bottom, "input", NULL)))
+        {
+          bottom = producer;
+        }
+
+      if (bottom != input && gegl_node_has_pad (bottom, "input"))
+        gegl_node_connect_to (input,  "output",
+                              bottom, "input");
+    }
+
+  return node;
+}
+
 void
 gimp_gegl_mode_node_set_mode (GeglNode             *node,
                               GimpLayerModeEffects  mode,
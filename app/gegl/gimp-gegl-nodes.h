@@ -31,6 +31,7 @@ GeglNode * gimp_gegl_add_buffer_source         (GeglNode             *parent,
                                                 GeglBuffer           *buffer,
                                                 gint                  offset_x,
                                                 gint                  offset_y);
+GeglNode * gimp_gegl_create_graph_node         (const gchar          *xml);
 
 void       gimp_gegl_mode_node_set_mode        (GeglNode             *node,
                                                 GimpLayerModeEffects  mode,
@@ -28,7 +28,9 @@
 #include "operations/operations-types.h"
 
 
-typedef struct _GimpApplicator GimpApplicator;
+typedef struct _GimpApplicator          GimpApplicator;
+typedef struct _GimpTileHandlerPattern  GimpTileHandlerPattern;
+typedef struct _GimpTileHandlerValidate GimpTileHandlerValidate;
 
 
 #endif /* __GIMP_GEGL_TYPES_H__ */
@@ -139,3 +139,59 @@ gimp_gegl_param_spec_has_key (GParamSpec  *pspec,
 
   return FALSE;
 }
+
+/**
+ * gimp_gegl_buffer_dup_area:
+ * @buffer: a #GeglBuffer
+ * @area:   the area of @buffer to duplicate, or %NULL for its extent
+ *
+ * Creates a new buffer of @area's size, with its origin at (0, 0),
+ * and copies @area of @buffer into it.
+ *
+ * Unlike creating the new buffer with gegl_buffer_new() and copying
+ * into it, the new buffer's tile grid is shifted so it is aligned to
+ * the one of @buffer. This lets gegl_buffer_copy() share all tiles
+ * which are fully covered by @area copy-on-write, instead of copying
+ * their pixels, which is what makes pushing undo steps of large
+ * drawables cheap.
+ *
+ * Return value: the new buffer.
+ **/
+GeglBuffer *
+gimp_gegl_buffer_dup_area (GeglBuffer          *buffer,
+                           const GeglRectangle *area)
+{
+  GeglBuffer *dup;
+  gint        shift_x;
+  gint        shift_y;
+  gint        tile_width;
+  gint        tile_height;
+
+  g_return_val_if_fail (GEGL_IS_BUFFER (buffer), NULL);
+
+  if (! area)
+    area = gegl_buffer_get_extent (buffer);
+
+  g_object_get (buffer,
+                "shift-x",     &shift_x,
+                "shift-y",     &shift_y,
+                "tile-width",  &tile_width,
+                "tile-height", &tile_height,
+                NULL);
+
+  dup = g_object_new (GEGL_TYPE_BUFFER,
+                      "format",      gegl_buffer_get_format (buffer),
+                      "x",           0,
+                      "y",           0,
+                      "width",       area->width,
+                      "height",      area->height,
+                      "shift-x",     area->x + shift_x,
+                      "shift-y",     area->y + shift_y,
+                      "tile-width",  tile_width,
+                      "tile-height", tile_height,
+                      NULL);
+
+  gegl_buffer_copy (buffer, area, dup, GEGL_RECTANGLE (0, 0, 0, 0));
+
+  return dup;
+}
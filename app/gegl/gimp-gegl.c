@@ -30,14 +30,15 @@
 #include "operations/gimp-operations.h"
 
 #include "core/gimp.h"
+#include "core/gimp-parallel.h"
+#include "core/gimp-tile-cache.h"
 
 #include "gimp-babl.h"
 #include "gimp-gegl.h"
 
 
-static void  gimp_gegl_notify_tile_cache_size (GimpGeglConfig *config);
-static void  gimp_gegl_notify_num_processors  (GimpGeglConfig *config);
-static void  gimp_gegl_notify_use_opencl      (GimpGeglConfig *config);
+static void  gimp_gegl_notify_num_processors (GimpGeglConfig *config);
+static void  gimp_gegl_notify_use_opencl     (GimpGeglConfig *config);
 
 
 void
@@ -54,16 +55,12 @@ gimp_gegl_init (Gimp *gimp)
 #endif
 
   g_object_set (gegl_config (),
-                "tile-cache-size", (guint64) config->tile_cache_size,
 #if 0
                 "threads",         config->num_processors,
 #endif
                 "use-opencl",      config->use_opencl,
                 NULL);
 
-  g_signal_connect (config, "notify::tile-cache-size",
-                    G_CALLBACK (gimp_gegl_notify_tile_cache_size),
-                    NULL);
   g_signal_connect (config, "notify::num-processors",
                     G_CALLBACK (gimp_gegl_notify_num_processors),
                     NULL);
@@ -71,17 +68,24 @@ gimp_gegl_init (Gimp *gimp)
                     G_CALLBACK (gimp_gegl_notify_use_opencl),
                     NULL);
 
+  gimp_parallel_init (gimp);
+
+  /*  sets GeglConfig:tile-cache-size, adapting it to the free memory  */
+  gimp_tile_cache_init (gimp);
+
   gimp_babl_init ();
 
   gimp_operations_init ();
 }
 
-static void
-gimp_gegl_notify_tile_cache_size (GimpGeglConfig *config)
+void
+gimp_gegl_exit (Gimp *gimp)
 {
-  g_object_set (gegl_config (),
-                "tile-cache-size", (guint64) config->tile_cache_size,
-                NULL);
+  g_return_if_fail (GIMP_IS_GIMP (gimp));
+
+  gimp_tile_cache_exit (gimp);
+
+  gimp_parallel_exit (gimp);
 }
 
 static void
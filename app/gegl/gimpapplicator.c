@@ -248,6 +248,11 @@ gimp_applicator_set_src_buffer (GimpApplicator *applicator,
                             applicator->mode_node,   "input");
       gegl_node_connect_to (applicator->input_node,  "output",
                             applicator->affect_node, "input");
+
+      /*  don't keep the buffer alive  */
+      gegl_node_set (applicator->src_node,
+                     "buffer", NULL,
+                     NULL);
     }
 
   applicator->src_buffer = src_buffer;
@@ -293,6 +298,10 @@ gimp_applicator_set_dest_buffer (GimpApplicator *applicator,
 
       gegl_node_connect_to (applicator->affect_node, "output",
                             applicator->output_node, "input");
+
+      gegl_node_set (applicator->dest_node,
+                     "buffer", NULL,
+                     NULL);
     }
 
   applicator->dest_buffer = dest_buffer;
@@ -376,6 +385,10 @@ gimp_applicator_set_apply_buffer (GimpApplicator *applicator,
     {
       gegl_node_connect_to (applicator->aux_node,          "output",
                             applicator->apply_offset_node, "input");
+
+      gegl_node_set (applicator->apply_src_node,
+                     "buffer", NULL,
+                     NULL);
     }
 
   applicator->apply_buffer = apply_buffer;
@@ -496,3 +509,18 @@ gimp_applicator_get_cache_buffer (GimpApplicator  *applicator,
 
   return NULL;
 }
+
+/*  Processes @rect of the applicator's graph into its result cache,
+ *  so later renders of it are cache hits.
+ */
+void
+gimp_applicator_render_cache (GimpApplicator      *applicator,
+                              const GeglRectangle *rect)
+{
+  g_return_if_fail (GIMP_IS_APPLICATOR (applicator));
+  g_return_if_fail (rect != NULL);
+
+  if (applicator->cache_node)
+    gegl_node_blit (applicator->cache_node, 1.0, rect,
+                    NULL, NULL, GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_DEFAULT);
+}
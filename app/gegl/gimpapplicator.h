@@ -117,6 +117,8 @@ GeglBuffer * gimp_applicator_dup_apply_buffer (GimpApplicator       *applicator,
 GeglBuffer * gimp_applicator_get_cache_buffer (GimpApplicator       *applicator,
                                                GeglRectangle       **rectangles,
                                                gint                 *n_rectangles);
+void         gimp_applicator_render_cache     (GimpApplicator       *applicator,
+                                               const GeglRectangle  *rect);
 
 
 #endif  /*  __GIMP_APPLICATOR_H__  */
@@ -0,0 +1,180 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <cairo.h>
+#include <gegl.h>
+
+#include "gimp-gegl-types.h"
+
+#include "gimptilehandlerpattern.h"
+
+
+static void   gimp_tile_handler_pattern_finalize (GObject                 *object);
+
+static void   gimp_tile_handler_pattern_validate (GimpTileHandlerValidate *validate,
+                                                  const GeglRectangle     *rect,
+                                                  const Babl              *format,
+                                                  gpointer                 dest_buf,
+                                                  gint                     dest_stride);
+
+
+G_DEFINE_TYPE (GimpTileHandlerPattern, gimp_tile_handler_pattern,
+               GIMP_TYPE_TILE_HANDLER_VALIDATE)
+
+#define parent_class gimp_tile_handler_pattern_parent_class
+
+
+static void
+gimp_tile_handler_pattern_class_init (GimpTileHandlerPatternClass *klass)
+{
+  GObjectClass                 *object_class   = G_OBJECT_CLASS (klass);
+  GimpTileHandlerValidateClass *validate_class = GIMP_TILE_HANDLER_VALIDATE_CLASS (klass);
+
+  object_class->finalize   = gimp_tile_handler_pattern_finalize;
+
+  validate_class->validate = gimp_tile_handler_pattern_validate;
+}
+
+static void
+gimp_tile_handler_pattern_init (GimpTileHandlerPattern *pattern)
+{
+  g_mutex_init (&pattern->mutex);
+}
+
+static void
+gimp_tile_handler_pattern_finalize (GObject *object)
+{
+  GimpTileHandlerPattern *pattern = GIMP_TILE_HANDLER_PATTERN (object);
+
+  if (pattern->pattern)
+    {
+      g_object_unref (pattern->pattern);
+      pattern->pattern = NULL;
+    }
+
+  g_free (pattern->data);
+  pattern->data = NULL;
+
+  g_mutex_clear (&pattern->mutex);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+gimp_tile_handler_pattern_validate (GimpTileHandlerValidate *validate,
+                                    const GeglRectangle     *rect,
+                                    const Babl              *format,
+                                    gpointer                 dest_buf,
+                                    gint                     dest_stride)
+{
+  GimpTileHandlerPattern *pattern = GIMP_TILE_HANDLER_PATTERN (validate);
+  gint                    width   = gegl_buffer_get_width  (pattern->pattern);
+  gint                    height  = gegl_buffer_get_height (pattern->pattern);
+  gint                    bpp     = babl_format_get_bytes_per_pixel (format);
+  gint                    x1;
+  gint                    y;
+
+  /*  convert the pattern once, not for every tile  */
+  g_mutex_lock (&pattern->mutex);
+
+  if (pattern->data_format != format)
+    {
+      g_free (pattern->data);
+
+      pattern->data        = g_malloc (width * height * bpp);
+      pattern->data_format = format;
+
+      gegl_buffer_get (pattern->pattern,
+                       GEGL_RECTANGLE (gegl_buffer_get_x (pattern->pattern),
+                                       gegl_buffer_get_y (pattern->pattern),
+                                       width, height),
+                       1.0, format, pattern->data,
+                       GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+    }
+
+  g_mutex_unlock (&pattern->mutex);
+
+  x1 = (rect->x - pattern->offset_x) % width;
+
+  if (x1 < 0)
+    x1 += width;
+
+  for (y = 0; y < rect->height; y++)
+    {
+      const guchar *src;
+      guchar       *dest = (guchar *) dest_buf + y * dest_stride;
+      gint          src_x;
+      gint          src_y;
+      gint          x;
+
+      src_y = (rect->y + y - pattern->offset_y) % height;
+
+      if (src_y < 0)
+        src_y += height;
+
+      src = pattern->data + src_y * width * bpp;
+
+      for (x = 0, src_x = x1; x < rect->width; x += width - src_x, src_x = 0)
+        {
+          memcpy (dest + x * bpp, src + src_x * bpp,
+                  MIN (width - src_x, rect->width - x) * bpp);
+        }
+    }
+}
+
+
+/*  public functions  */
+
+/**
+ * gimp_tile_handler_pattern_new:
+ * @pattern:  the buffer holding the pattern
+ * @offset_x: where the pattern starts horizontally
+ * @offset_y: where the pattern starts vertically
+ *
+ * Creates a tile handler that fills the tiles of a buffer with
+ * @pattern, repeated in both directions, the first time they are
+ * read.  Unlike gegl_buffer_set_pattern(), nothing is copied before
+ * the buffer is read, and @pattern is converted to the buffer's
+ * format only once.  Assign it to the buffer with
+ * gimp_tile_handler_validate_assign() and invalidate the buffer's
+ * whole extent.  Tiles that were written to keep their pixels.
+ *
+ * Return value: the new tile handler.
+ **/
+GeglTileHandler *
+gimp_tile_handler_pattern_new (GeglBuffer *pattern,
+                               gint        offset_x,
+                               gint        offset_y)
+{
+  GimpTileHandlerPattern *handler;
+
+  g_return_val_if_fail (GEGL_IS_BUFFER (pattern), NULL);
+
+  handler = g_object_new (GIMP_TYPE_TILE_HANDLER_PATTERN,
+                          "whole-tile", TRUE,
+                          NULL);
+
+  handler->pattern  = g_object_ref (pattern);
+  handler->offset_x = offset_x;
+  handler->offset_y = offset_y;
+
+  return GEGL_TILE_HANDLER (handler);
+}
@@ -0,0 +1,71 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GIMP_TILE_HANDLER_PATTERN_H__
+#define __GIMP_TILE_HANDLER_PATTERN_H__
+
+#include "gimptilehandlervalidate.h"
+
+/***
+ * GimpTileHandlerPattern is a GeglTileHandler that fills the tiles
+ * of a buffer with a repeated pattern the first time they are
+ * accessed.
+ */
+
+G_BEGIN_DECLS
+
+#define GIMP_TYPE_TILE_HANDLER_PATTERN            (gimp_tile_handler_pattern_get_type ())
+#define GIMP_TILE_HANDLER_PATTERN(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), GIMP_TYPE_TILE_HANDLER_PATTERN, GimpTileHandlerPattern))
+#define GIMP_TILE_HANDLER_PATTERN_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass),  GIMP_TYPE_TILE_HANDLER_PATTERN, GimpTileHandlerPatternClass))
+#define GIMP_IS_TILE_HANDLER_PATTERN(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GIMP_TYPE_TILE_HANDLER_PATTERN))
+#define GIMP_IS_TILE_HANDLER_PATTERN_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass),  GIMP_TYPE_TILE_HANDLER_PATTERN))
+#define GIMP_TILE_HANDLER_PATTERN_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj),  GIMP_TYPE_TILE_HANDLER_PATTERN, GimpTileHandlerPatternClass))
+
+
+typedef struct _GimpTileHandlerPatternClass GimpTileHandlerPatternClass;
+
+struct _GimpTileHandlerPattern
+{
+  GimpTileHandlerValidate  parent_instance;
+
+  GMutex                   mutex;
+
+  GeglBuffer              *pattern;
+  gint                     offset_x;
+  gint                     offset_y;
+
+  /*  the pattern's pixels in the format of the last validated tile  */
+  const Babl              *data_format;
+  guchar                  *data;
+};
+
+struct _GimpTileHandlerPatternClass
+{
+  GimpTileHandlerValidateClass  parent_class;
+};
+
+
+GType             gimp_tile_handler_pattern_get_type (void) G_GNUC_CONST;
+
+GeglTileHandler * gimp_tile_handler_pattern_new      (GeglBuffer *pattern,
+                                                      gint        offset_x,
+                                                      gint        offset_y);
+
+
+G_END_DECLS
+
+#endif /* __GIMP_TILE_HANDLER_PATTERN_H__ */
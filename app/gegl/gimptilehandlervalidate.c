@@ -31,7 +31,8 @@ enum
   PROP_FORMAT,
   PROP_TILE_WIDTH,
   PROP_TILE_HEIGHT,
-  PROP_WHOLE_TILE
+  PROP_WHOLE_TILE,
+  PROP_LEVELS
 };
 
 
@@ -51,6 +52,12 @@ static void     gimp_tile_handler_validate_real_validate (GimpTileHandlerValidat
                                                           gpointer                 dest_buf,
                                                           gint                     dest_stride);
 
+static GeglTile * gimp_tile_handler_validate_validate_level
+                                                         (GeglTileSource  *source,
+                                                          gint             x,
+                                                          gint             y,
+                                                          gint             z);
+
 static gpointer gimp_tile_handler_validate_command       (GeglTileSource  *source,
                                                           GeglTileCommand  command,
                                                           gint             x,
@@ -97,22 +104,35 @@ gimp_tile_handler_validate_class_init (GimpTileHandlerValidateClass *klass)
                                                          FALSE,
                                                          GIMP_PARAM_READWRITE |
                                                          G_PARAM_CONSTRUCT));
+
+  g_object_class_install_property (object_class, PROP_LEVELS,
+                                   g_param_spec_boolean ("levels", NULL, NULL,
+                                                         FALSE,
+                                                         GIMP_PARAM_READWRITE |
+                                                         G_PARAM_CONSTRUCT));
 }
 
 static void
 gimp_tile_handler_validate_init (GimpTileHandlerValidate *validate)
 {
   GeglTileSource *source = GEGL_TILE_SOURCE (validate);
+  gint            i;
 
   source->command = gimp_tile_handler_validate_command;
 
+  g_mutex_init (&validate->mutex);
+
   validate->dirty_region = cairo_region_create ();
+
+  for (i = 0; i < GIMP_TILE_HANDLER_VALIDATE_MAX_LEVEL; i++)
+    validate->level_dirty_regions[i] = cairo_region_create ();
 }
 
 static void
 gimp_tile_handler_validate_finalize (GObject *object)
 {
   GimpTileHandlerValidate *validate = GIMP_TILE_HANDLER_VALIDATE (object);
+  gint                     i;
 
   if (validate->graph)
     {
@@ -123,6 +143,14 @@ gimp_tile_handler_validate_finalize (GObject *object)
   cairo_region_destroy (validate->dirty_region);
   validate->dirty_region = NULL;
 
+  for (i = 0; i < GIMP_TILE_HANDLER_VALIDATE_MAX_LEVEL; i++)
+    {
+      cairo_region_destroy (validate->level_dirty_regions[i]);
+      validate->level_dirty_regions[i] = NULL;
+    }
+
+  g_mutex_clear (&validate->mutex);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -148,6 +176,9 @@ gimp_tile_handler_validate_set_property (GObject      *object,
     case PROP_WHOLE_TILE:
       validate->whole_tile = g_value_get_boolean (value);
       break;
+    case PROP_LEVELS:
+      validate->levels = g_value_get_boolean (value);
+      break;
 
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
@@ -177,6 +208,9 @@ gimp_tile_handler_validate_get_property (GObject    *object,
     case PROP_WHOLE_TILE:
       g_value_set_boolean (value, validate->whole_tile);
       break;
+    case PROP_LEVELS:
+      g_value_set_boolean (value, validate->levels);
+      break;
 
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
@@ -213,18 +247,40 @@ gimp_tile_handler_validate_validate (GeglTileSource *source,
   GimpTileHandlerValidate *validate = GIMP_TILE_HANDLER_VALIDATE (source);
   cairo_rectangle_int_t    tile_rect;
 
-  if (cairo_region_is_empty (validate->dirty_region))
-    return tile;
-
   tile_rect.x      = x * validate->tile_width;
   tile_rect.y      = y * validate->tile_height;
   tile_rect.width  = validate->tile_width;
   tile_rect.height = validate->tile_height;
 
+  /*  the dirty region is only looked at and updated with the mutex
+   *  held, not while rendering, so it stays consistent when tiles
+   *  are fetched from more than one thread; this doesn't make
+   *  readers of valid tiles independent of a render, GEGL's tile
+   *  storage lock serializes all tile fetches anyway
+   */
+  g_mutex_lock (&validate->mutex);
+
+  if (cairo_region_is_empty (validate->dirty_region))
+    {
+      g_mutex_unlock (&validate->mutex);
+
+      return tile;
+    }
+
   if (validate->whole_tile)
     {
-      if (cairo_region_contains_rectangle (validate->dirty_region, &tile_rect)
-          != CAIRO_REGION_OVERLAP_OUT)
+      gboolean dirty;
+
+      dirty = (cairo_region_contains_rectangle (validate->dirty_region,
+                                                &tile_rect) !=
+               CAIRO_REGION_OVERLAP_OUT);
+
+      if (dirty)
+        cairo_region_subtract_rectangle (validate->dirty_region, &tile_rect);
+
+      g_mutex_unlock (&validate->mutex);
+
+      if (dirty)
         {
           gint tile_bpp;
           gint tile_stride;
@@ -233,8 +289,6 @@ gimp_tile_handler_validate_validate (GeglTileSource *source,
             tile = gegl_tile_handler_create_tile (GEGL_TILE_HANDLER (source),
                                                   x, y, 0);
 
-          cairo_region_subtract_rectangle (validate->dirty_region, &tile_rect);
-
           tile_bpp    = babl_format_get_bytes_per_pixel (validate->format);
           tile_stride = tile_bpp * validate->tile_width;
 
@@ -259,6 +313,11 @@ gimp_tile_handler_validate_validate (GeglTileSource *source,
 
       cairo_region_intersect_rectangle (tile_region, &tile_rect);
 
+      if (! cairo_region_is_empty (tile_region))
+        cairo_region_subtract_rectangle (validate->dirty_region, &tile_rect);
+
+      g_mutex_unlock (&validate->mutex);
+
       if (! cairo_region_is_empty (tile_region))
         {
           gint tile_bpp;
@@ -270,8 +329,6 @@ gimp_tile_handler_validate_validate (GeglTileSource *source,
             tile = gegl_tile_handler_create_tile (GEGL_TILE_HANDLER (source),
                                                   x, y, 0);
 
-          cairo_region_subtract_rectangle (validate->dirty_region, &tile_rect);
-
           tile_bpp    = babl_format_get_bytes_per_pixel (validate->format);
           tile_stride = tile_bpp * validate->tile_width;
 
@@ -311,6 +368,64 @@ gimp_tile_handler_validate_validate (GeglTileSource *source,
   return tile;
 }
 
+/*  Renders a tile of mipmap level @z straight from the graph, instead
+ *  of letting GEGL build it from the tiles of the level below, which
+ *  would validate all the full resolution tiles it covers.  Returns
+ *  NULL if the tile isn't dirty.
+ */
+static GeglTile *
+gimp_tile_handler_validate_validate_level (GeglTileSource *source,
+                                           gint            x,
+                                           gint            y,
+                                           gint            z)
+{
+  GimpTileHandlerValidate *validate = GIMP_TILE_HANDLER_VALIDATE (source);
+  cairo_region_t          *dirty    = validate->level_dirty_regions[z - 1];
+  cairo_rectangle_int_t    tile_rect;
+  GeglTile                *tile;
+  gint                     tile_bpp;
+  gint                     tile_stride;
+
+  tile_rect.x      = x * validate->tile_width;
+  tile_rect.y      = y * validate->tile_height;
+  tile_rect.width  = validate->tile_width;
+  tile_rect.height = validate->tile_height;
+
+  g_mutex_lock (&validate->mutex);
+
+  if (cairo_region_contains_rectangle (dirty, &tile_rect) ==
+      CAIRO_REGION_OVERLAP_OUT)
+    {
+      g_mutex_unlock (&validate->mutex);
+
+      return NULL;
+    }
+
+  cairo_region_subtract_rectangle (dirty, &tile_rect);
+
+  g_mutex_unlock (&validate->mutex);
+
+  tile = gegl_tile_handler_create_tile (GEGL_TILE_HANDLER (source), x, y, z);
+
+  tile_bpp    = babl_format_get_bytes_per_pixel (validate->format);
+  tile_stride = tile_bpp * validate->tile_width;
+
+  gegl_tile_lock (tile);
+
+  gegl_node_blit (validate->graph, 1.0 / (1 << z),
+                  GEGL_RECTANGLE (tile_rect.x,
+                                  tile_rect.y,
+                                  tile_rect.width,
+                                  tile_rect.height),
+                  validate->format,
+                  gegl_tile_get_data (tile), tile_stride,
+                  GEGL_BLIT_DEFAULT);
+
+  gegl_tile_unlock (tile);
+
+  return tile;
+}
+
 static gpointer
 gimp_tile_handler_validate_command (GeglTileSource  *source,
                                     GeglTileCommand  command,
@@ -324,6 +439,15 @@ gimp_tile_handler_validate_command (GeglTileSource  *source,
 
   validate->max_z = MAX (validate->max_z, z);
 
+  if (command == GEGL_TILE_GET && validate->levels &&
+      z > 0 && z <= GIMP_TILE_HANDLER_VALIDATE_MAX_LEVEL)
+    {
+      retval = gimp_tile_handler_validate_validate_level (source, x, y, z);
+
+      if (retval)
+        return retval;
+    }
+
   retval = gegl_tile_handler_source_command (source, command, x, y, z, data);
 
   if (command == GEGL_TILE_GET && z == 0)
@@ -376,8 +500,30 @@ gimp_tile_handler_validate_invalidate (GimpTileHandlerValidate *validate,
 
   g_return_if_fail (GIMP_IS_TILE_HANDLER_VALIDATE (validate));
 
+  g_mutex_lock (&validate->mutex);
+
   cairo_region_union_rectangle (validate->dirty_region, &rect);
 
+  if (validate->levels)
+    {
+      gint z;
+
+      for (z = 1; z <= GIMP_TILE_HANDLER_VALIDATE_MAX_LEVEL; z++)
+        {
+          cairo_rectangle_int_t level_rect;
+
+          level_rect.x      = x >> z;
+          level_rect.y      = y >> z;
+          level_rect.width  = ((x + width  + (1 << z) - 1) >> z) - level_rect.x;
+          level_rect.height = ((y + height + (1 << z) - 1) >> z) - level_rect.y;
+
+          cairo_region_union_rectangle (validate->level_dirty_regions[z - 1],
+                                        &level_rect);
+        }
+    }
+
+  g_mutex_unlock (&validate->mutex);
+
   if (validate->max_z > 0)
     {
       GeglTileSource *source  = GEGL_TILE_SOURCE (validate);
@@ -414,5 +560,86 @@ gimp_tile_handler_validate_undo_invalidate (GimpTileHandlerValidate *validate,
 
   g_return_if_fail (GIMP_IS_TILE_HANDLER_VALIDATE (validate));
 
+  g_mutex_lock (&validate->mutex);
+
   cairo_region_subtract_rectangle (validate->dirty_region, &rect);
+
+  g_mutex_unlock (&validate->mutex);
+}
+
+/*  Validates the dirty part of @rect of @buffer, which must be the
+ *  buffer @validate is assigned to, in one go: the whole area of the
+ *  tiles it touches is rendered with one graph process call per
+ *  rectangle of the dirty region, instead of one call per tile as they
+ *  are fetched.  The graph can't be blitted from several threads at
+ *  once, so the rectangles are rendered one after the other.
+ */
+void
+gimp_tile_handler_validate_validate_buffer (GimpTileHandlerValidate *validate,
+                                            GeglBuffer              *buffer,
+                                            const GeglRectangle     *rect)
+{
+  GimpTileHandlerValidateClass *klass;
+  cairo_rectangle_int_t         tiles_rect;
+  cairo_region_t               *region;
+  gint                          n_rects;
+  gint                          i;
+
+  g_return_if_fail (GIMP_IS_TILE_HANDLER_VALIDATE (validate));
+  g_return_if_fail (GEGL_IS_BUFFER (buffer));
+  g_return_if_fail (rect != NULL);
+
+  klass = GIMP_TILE_HANDLER_VALIDATE_GET_CLASS (validate);
+
+  /*  snap to the tile grid, so no tile is left partially dirty and
+   *  validated again on its own when it is fetched
+   */
+  tiles_rect.x      = (rect->x / validate->tile_width)  * validate->tile_width;
+  tiles_rect.y      = (rect->y / validate->tile_height) * validate->tile_height;
+  tiles_rect.width  = ((rect->x + rect->width  + validate->tile_width  - 1) /
+                       validate->tile_width)  * validate->tile_width -
+                      tiles_rect.x;
+  tiles_rect.height = ((rect->y + rect->height + validate->tile_height - 1) /
+                       validate->tile_height) * validate->tile_height -
+                      tiles_rect.y;
+
+  g_mutex_lock (&validate->mutex);
+
+  region = cairo_region_copy (validate->dirty_region);
+
+  cairo_region_intersect_rectangle (region, &tiles_rect);
+  cairo_region_subtract_rectangle (validate->dirty_region, &tiles_rect);
+
+  g_mutex_unlock (&validate->mutex);
+
+  n_rects = cairo_region_num_rectangles (region);
+
+  for (i = 0; i < n_rects; i++)
+    {
+      cairo_rectangle_int_t blit_rect;
+
+      cairo_region_get_rectangle (region, i, &blit_rect);
+
+      if (klass->validate == gimp_tile_handler_validate_real_validate)
+        {
+          gegl_node_blit_buffer (validate->graph, buffer,
+                                 (GeglRectangle *) &blit_rect);
+        }
+      else
+        {
+          gint    bpp    = babl_format_get_bytes_per_pixel (validate->format);
+          gint    stride = bpp * blit_rect.width;
+          guchar *buf    = g_malloc ((gsize) stride * blit_rect.height);
+
+          klass->validate (validate, (GeglRectangle *) &blit_rect,
+                           validate->format, buf, stride);
+
+          gegl_buffer_set (buffer, (GeglRectangle *) &blit_rect, 0,
+                           validate->format, buf, stride);
+
+          g_free (buf);
+        }
+    }
+
+  cairo_region_destroy (region);
 }
@@ -35,13 +35,18 @@ G_BEGIN_DECLS
 #define GIMP_TILE_HANDLER_VALIDATE_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj),  GIMP_TYPE_TILE_HANDLER_VALIDATE, GimpTileHandlerValidateClass))
 
 
-typedef struct _GimpTileHandlerValidate      GimpTileHandlerValidate;
+/*  the coarsest mipmap level which can be validated directly  */
+#define GIMP_TILE_HANDLER_VALIDATE_MAX_LEVEL 8
+
+
 typedef struct _GimpTileHandlerValidateClass GimpTileHandlerValidateClass;
 
 struct _GimpTileHandlerValidate
 {
   GeglTileHandler  parent_instance;
 
+  GMutex           mutex;
+
   GeglNode        *graph;
   cairo_region_t  *dirty_region;
   const Babl      *format;
@@ -49,6 +54,9 @@ struct _GimpTileHandlerValidate
   gint             tile_height;
   gint             max_z;
   gboolean         whole_tile;
+
+  gboolean         levels;
+  cairo_region_t  *level_dirty_regions[GIMP_TILE_HANDLER_VALIDATE_MAX_LEVEL];
 };
 
 struct _GimpTileHandlerValidateClass
@@ -81,6 +89,10 @@ void         gimp_tile_handler_validate_undo_invalidate (GimpTileHandlerValidate
                                                          gint                     width,
                                                          gint                     height);
 
+void        gimp_tile_handler_validate_validate_buffer (GimpTileHandlerValidate *validate,
+                                                         GeglBuffer              *buffer,
+                                                         const GeglRectangle     *rect);
+
 
 G_END_DECLS
 
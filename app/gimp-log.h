@@ -41,7 +41,9 @@ typedef enum
   GIMP_LOG_RECTANGLE_TOOL     = 1 << 17,
   GIMP_LOG_BRUSH_CACHE        = 1 << 18,
   GIMP_LOG_PROJECTION         = 1 << 19,
-  GIMP_LOG_XCF                = 1 << 20
+  GIMP_LOG_XCF                = 1 << 20,
+  GIMP_LOG_DISPLAY_XFER       = 1 << 21,
+  GIMP_LOG_DISPLAY_FRAMES     = 1 << 22
 } GimpLogFlags;
 
 
@@ -103,6 +105,8 @@ void   gimp_logv     (GimpLogFlags  flags,
 #define BRUSH_CACHE        GIMP_LOG_BRUSH_CACHE
 #define PROJECTION         GIMP_LOG_PROJECTION
 #define XCF                GIMP_LOG_XCF
+#define DISPLAY_XFER       GIMP_LOG_DISPLAY_XFER
+#define DISPLAY_FRAMES     GIMP_LOG_DISPLAY_FRAMES
 
 #if 0 /* last resort */
 #  define GIMP_LOG /* nothing => no varargs, no log */
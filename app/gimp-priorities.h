@@ -33,8 +33,17 @@
 /*  just a bit less than GDK_PRIORITY_REDRAW   */
 #define GIMP_PRIORITY_PROJECTION_IDLE (G_PRIORITY_HIGH_IDLE + 22)
 
+/*  a bit less than projection construction, for the visible part  */
+#define GIMP_PRIORITY_IMAGE_MAP_IDLE (G_PRIORITY_HIGH_IDLE + 23)
+
+/*  same as the visible part of an image map preview  */
+#define GIMP_PRIORITY_FOREGROUND_EXTRACT_IDLE (G_PRIORITY_HIGH_IDLE + 23)
+
 /* #define G_PRIORITY_DEFAULT_IDLE 200 */
 
+/*  for the part of an image map preview which is not visible  */
+#define GIMP_PRIORITY_IMAGE_MAP_HIDDEN_IDLE (G_PRIORITY_DEFAULT_IDLE)
+
 #define GIMP_PRIORITY_VIEWABLE_IDLE (G_PRIORITY_LOW)
 
 /* #define G_PRIORITY_LOW 300 */
@@ -35,6 +35,7 @@
 #include "display/gimpdisplayshell.h"
 
 #include "gimpdbusservice.h"
+#include "gui.h"
 
 
 typedef struct
@@ -169,6 +170,10 @@ gimp_dbus_service_activate (GimpDBusServiceUI     *service,
     {
       GimpObject *display;
 
+      /*  a resident instance shows its windows now  */
+      if (! gimp_get_show_gui (gimp))
+        gui_show (gimp);
+
       display = gimp_container_get_first_child (gimp->displays);
 
       if (display)
@@ -269,6 +274,8 @@ gimp_dbus_service_open_idle (GimpDBusService *service)
 
   if (data)
     {
+      gui_show (service->gimp);
+
       file_open_from_command_line (service->gimp, data->file, data->as_new,
                                    NULL, /* FIXME monitor */
                                    0 /* FIXME monitor */);
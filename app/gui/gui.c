@@ -101,6 +101,10 @@ static void       gui_restore_callback          (Gimp               *gimp,
 static void       gui_restore_after_callback    (Gimp               *gimp,
                                                  GimpInitStatusFunc  callback);
 
+static void       gui_show_windows              (Gimp               *gimp,
+                                                 GdkScreen          *screen,
+                                                 gint                monitor);
+
 static gboolean   gui_exit_callback             (Gimp               *gimp,
                                                  gboolean            force);
 static gboolean   gui_exit_after_callback       (Gimp               *gimp,
@@ -264,6 +268,32 @@ gui_init (Gimp     *gimp,
   return status_callback;
 }
 
+/**
+ * gui_show:
+ * @gimp: a #Gimp
+ *
+ * Shows the image window and the session's docks of a resident
+ * instance, which was started with all its windows hidden, on the
+ * monitor under the pointer. Does nothing if they are shown already.
+ **/
+void
+gui_show (Gimp *gimp)
+{
+  GdkScreen *screen;
+  gint       monitor;
+
+  g_return_if_fail (GIMP_IS_GIMP (gimp));
+
+  if (gimp_get_show_gui (gimp) || ! gimp_is_restored (gimp))
+    return;
+
+  gimp_set_show_gui (gimp, TRUE);
+
+  monitor = gimp_get_monitor_at_pointer (&screen);
+
+  gui_show_windows (gimp, screen, monitor);
+}
+
 gint
 gui_get_initial_monitor (Gimp       *gimp,
                          GdkScreen **screen)
@@ -484,7 +514,6 @@ gui_restore_after_callback (Gimp               *gimp,
                             GimpInitStatusFunc  status_callback)
 {
   GimpGuiConfig *gui_config = GIMP_GUI_CONFIG (gimp->config);
-  GimpDisplay   *display;
 
   if (gimp->be_verbose)
     g_print ("INIT: %s\n", G_STRFUNC);
@@ -596,28 +625,9 @@ gui_restore_after_callback (Gimp               *gimp,
   if (status_callback == splash_update)
     splash_destroy ();
 
+  /*  a resident instance shows its windows in gui_show()  */
   if (gimp_get_show_gui (gimp))
-    {
-      GimpDisplayShell *shell;
-      GtkWidget        *toplevel;
-
-      /*  create the empty display  */
-      display = GIMP_DISPLAY (gimp_create_display (gimp, NULL,
-                                                   GIMP_UNIT_PIXEL, 1.0,
-                                                   G_OBJECT (initial_screen),
-                                                   initial_monitor));
-
-      shell = gimp_display_get_shell (display);
-
-      if (gui_config->restore_session)
-        session_restore (gimp,
-                         initial_screen,
-                         initial_monitor);
-
-      /*  move keyboard focus to the display  */
-      toplevel = gtk_widget_get_toplevel (GTK_WIDGET (shell));
-      gtk_window_present (GTK_WINDOW (toplevel));
-    }
+    gui_show_windows (gimp, initial_screen, initial_monitor);
 
   /*  indicate that the application has finished loading  */
   gdk_notify_startup_complete ();
@@ -627,6 +637,32 @@ gui_restore_after_callback (Gimp               *gimp,
   initial_monitor = -1;
 }
 
+static void
+gui_show_windows (Gimp      *gimp,
+                  GdkScreen *screen,
+                  gint       monitor)
+{
+  GimpGuiConfig    *gui_config = GIMP_GUI_CONFIG (gimp->config);
+  GimpDisplay      *display;
+  GimpDisplayShell *shell;
+  GtkWidget        *toplevel;
+
+  /*  create the empty display  */
+  display = GIMP_DISPLAY (gimp_create_display (gimp, NULL,
+                                               GIMP_UNIT_PIXEL, 1.0,
+                                               G_OBJECT (screen),
+                                               monitor));
+
+  shell = gimp_display_get_shell (display);
+
+  if (gui_config->restore_session)
+    session_restore (gimp, screen, monitor);
+
+  /*  move keyboard focus to the display  */
+  toplevel = gtk_widget_get_toplevel (GTK_WIDGET (shell));
+  gtk_window_present (GTK_WINDOW (toplevel));
+}
+
 static gboolean
 gui_exit_callback (Gimp     *gimp,
                    gboolean  force)
@@ -25,5 +25,7 @@ void               gui_abort     (const gchar    *abort_message);
 GimpInitStatusFunc gui_init      (Gimp           *gimp,
                                   gboolean        no_splash);
 
+void               gui_show      (Gimp           *gimp);
+
 
 #endif /* __GUI_H__ */
@@ -115,6 +115,7 @@ static const gchar        *user_gimprc       = NULL;
 static const gchar        *session_name      = NULL;
 static const gchar        *batch_interpreter = NULL;
 static const gchar       **batch_commands    = NULL;
+static gint                batch_jobs        = 1;
 static const gchar       **filenames         = NULL;
 static gboolean            as_new            = FALSE;
 static gboolean            no_interface      = FALSE;
@@ -131,6 +132,8 @@ static gboolean            use_shm           = FALSE;
 static gboolean            use_cpu_accel     = TRUE;
 static gboolean            console_messages  = FALSE;
 static gboolean            use_debug_handler = FALSE;
+static gboolean            profile_startup   = FALSE;
+static gboolean            resident          = FALSE;
 
 #ifdef GIMP_UNSTABLE
 static gboolean            show_playground   = TRUE;
@@ -164,6 +167,12 @@ static const GOptionEntry main_entries[] =
     G_OPTION_ARG_NONE, &new_instance,
     N_("Start a new GIMP instance"), NULL
   },
+  {
+    "resident", 0, 0,
+    G_OPTION_ARG_NONE, &resident,
+    N_("Start in the background without windows, show them when "
+       "GIMP is started again"), NULL
+  },
   {
     "as-new", 'a', 0,
     G_OPTION_ARG_NONE, &as_new,
@@ -224,6 +233,11 @@ static const GOptionEntry main_entries[] =
     G_OPTION_ARG_STRING, &batch_interpreter,
     N_("The procedure to process batch commands with"), "<proc>"
   },
+  {
+    "batch-jobs", 0, 0,
+    G_OPTION_ARG_INT, &batch_jobs,
+    N_("Number of commands from a batch job list to run at once"), "<n>"
+  },
   {
     "console-messages", 'c', 0,
     G_OPTION_ARG_NONE, &console_messages,
@@ -246,6 +260,11 @@ static const GOptionEntry main_entries[] =
     G_OPTION_ARG_NONE, &use_debug_handler,
     N_("Enable non-fatal debugging signal handlers"), NULL
   },
+  {
+    "profile-startup", 0, 0,
+    G_OPTION_ARG_NONE, &profile_startup,
+    N_("Print how long each step of the startup takes"), NULL
+  },
   {
     "g-fatal-warnings", 0, G_OPTION_FLAG_NO_ARG,
     G_OPTION_ARG_CALLBACK, gimp_option_fatal_warnings,
@@ -465,6 +484,10 @@ main (int    argc,
   if (no_interface)
     new_instance = TRUE;
 
+  /*  a resident instance starts silently  */
+  if (resident)
+    no_splash = TRUE;
+
 #ifndef GIMP_CONSOLE_COMPILATION
   if (! new_instance && gimp_unique_open (filenames, as_new))
     {
@@ -497,6 +520,7 @@ main (int    argc,
            session_name,
            batch_interpreter,
            batch_commands,
+           batch_jobs,
            as_new,
            no_interface,
            no_data,
@@ -508,6 +532,8 @@ main (int    argc,
            console_messages,
            use_debug_handler,
            show_playground,
+           profile_startup,
+           resident,
            stack_trace_mode,
            pdb_compat_mode);
 
@@ -32,6 +32,7 @@
 #include "operations-types.h"
 
 #include "core/gimpcurve.h"
+#include "core/gimpcurve-map.h"
 #include "core/gimphistogram.h"
 
 #include "gimpcurvesconfig.h"
@@ -60,6 +61,8 @@ static void     gimp_curves_config_set_property (GObject          *object,
                                                  guint             property_id,
                                                  const GValue     *value,
                                                  GParamSpec       *pspec);
+static void     gimp_curves_config_notify       (GObject          *object,
+                                                 GParamSpec       *pspec);
 
 static gboolean gimp_curves_config_serialize    (GimpConfig       *config,
                                                  GimpConfigWriter *writer,
@@ -96,6 +99,7 @@ gimp_curves_config_class_init (GimpCurvesConfigClass *klass)
   object_class->finalize            = gimp_curves_config_finalize;
   object_class->set_property        = gimp_curves_config_set_property;
   object_class->get_property        = gimp_curves_config_get_property;
+  object_class->notify              = gimp_curves_config_notify;
 
   viewable_class->default_icon_name = "gimp-tool-curves";
 
@@ -127,6 +131,8 @@ gimp_curves_config_init (GimpCurvesConfig *self)
 {
   GimpHistogramChannel channel;
 
+  g_mutex_init (&self->lut_mutex);
+
   for (channel = GIMP_HISTOGRAM_VALUE;
        channel <= GIMP_HISTOGRAM_ALPHA;
        channel++)
@@ -155,6 +161,14 @@ gimp_curves_config_finalize (GObject *object)
       self->curve[channel] = NULL;
     }
 
+  if (self->lut)
+    {
+      g_bytes_unref (self->lut);
+      self->lut = NULL;
+    }
+
+  g_mutex_clear (&self->lut_mutex);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -216,6 +230,27 @@ gimp_curves_config_set_property (GObject      *object,
     }
 }
 
+static void
+gimp_curves_config_notify (GObject    *object,
+                           GParamSpec *pspec)
+{
+  GimpCurvesConfig *config = GIMP_CURVES_CONFIG (object);
+
+  if (G_OBJECT_CLASS (parent_class)->notify)
+    G_OBJECT_CLASS (parent_class)->notify (object, pspec);
+
+  /*  any change invalidates the lookup table  */
+  g_mutex_lock (&config->lut_mutex);
+
+  if (config->lut)
+    {
+      g_bytes_unref (config->lut);
+      config->lut = NULL;
+    }
+
+  g_mutex_unlock (&config->lut_mutex);
+}
+
 static gboolean
 gimp_curves_config_serialize (GimpConfig       *config,
                               GimpConfigWriter *writer,
@@ -492,6 +527,59 @@ gimp_curves_config_reset_channel (GimpCurvesConfig *config)
   gimp_config_reset (GIMP_CONFIG (config->curve[config->channel]));
 }
 
+/*  returns a reference to a table of @size float values for each of
+ *  the R, G, B and A channels, which maps the integer input value i
+ *  to curve(i / (size - 1)).  the table is built on first use and
+ *  kept until the config changes.
+ */
+GBytes *
+gimp_curves_config_get_lut (GimpCurvesConfig *config,
+                            gint              size)
+{
+  GBytes *lut;
+
+  g_return_val_if_fail (GIMP_IS_CURVES_CONFIG (config), NULL);
+  g_return_val_if_fail (size > 1, NULL);
+
+  g_mutex_lock (&config->lut_mutex);
+
+  if (! config->lut ||
+      g_bytes_get_size (config->lut) != 4 * size * sizeof (gfloat))
+    {
+      gfloat *data = g_new (gfloat, 4 * size);
+      gint    i;
+
+      for (i = 0; i < size; i++)
+        {
+          gdouble value = (gdouble) i / (size - 1);
+          gint    channel;
+
+          for (channel = 0; channel < 3; channel++)
+            {
+              /* the colors curve is applied after the channel's curve */
+              data[channel * size + i] =
+                gimp_curve_map_value (config->curve[0],
+                                      gimp_curve_map_value (config->curve[channel + 1],
+                                                            value));
+            }
+
+          /* don't apply the colors curve to the alpha channel */
+          data[3 * size + i] = gimp_curve_map_value (config->curve[4], value);
+        }
+
+      if (config->lut)
+        g_bytes_unref (config->lut);
+
+      config->lut = g_bytes_new_take (data, 4 * size * sizeof (gfloat));
+    }
+
+  lut = g_bytes_ref (config->lut);
+
+  g_mutex_unlock (&config->lut_mutex);
+
+  return lut;
+}
+
 #define GIMP_CURVE_N_CRUFT_POINTS 17
 
 gboolean
@@ -42,6 +42,10 @@ struct _GimpCurvesConfig
   GimpHistogramChannel  channel;
 
   GimpCurve            *curve[5];
+
+  /*  cached lookup table for integer input, see get_lut()  */
+  GMutex                lut_mutex;
+  GBytes               *lut;
 };
 
 struct _GimpCurvesConfigClass
@@ -68,6 +72,9 @@ GObject *  gimp_curves_config_new_explicit_cruft  (gint32             channel,
 
 void       gimp_curves_config_reset_channel       (GimpCurvesConfig  *config);
 
+GBytes   * gimp_curves_config_get_lut             (GimpCurvesConfig  *config,
+                                                   gint               size);
+
 gboolean   gimp_curves_config_load_cruft          (GimpCurvesConfig  *config,
                                                    GInputStream      *input,
                                                    GError           **error);
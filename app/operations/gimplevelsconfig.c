@@ -57,6 +57,7 @@ enum
 
 static void     gimp_levels_config_iface_init   (GimpConfigInterface *iface);
 
+static void     gimp_levels_config_finalize     (GObject          *object);
 static void     gimp_levels_config_get_property (GObject          *object,
                                                  guint             property_id,
                                                  GValue           *value,
@@ -65,6 +66,8 @@ static void     gimp_levels_config_set_property (GObject          *object,
                                                  guint             property_id,
                                                  const GValue     *value,
                                                  GParamSpec       *pspec);
+static void     gimp_levels_config_notify       (GObject          *object,
+                                                 GParamSpec       *pspec);
 
 static gboolean gimp_levels_config_serialize    (GimpConfig       *config,
                                                  GimpConfigWriter *writer,
@@ -95,8 +98,10 @@ gimp_levels_config_class_init (GimpLevelsConfigClass *klass)
   GObjectClass      *object_class   = G_OBJECT_CLASS (klass);
   GimpViewableClass *viewable_class = GIMP_VIEWABLE_CLASS (klass);
 
+  object_class->finalize            = gimp_levels_config_finalize;
   object_class->set_property        = gimp_levels_config_set_property;
   object_class->get_property        = gimp_levels_config_get_property;
+  object_class->notify              = gimp_levels_config_notify;
 
   viewable_class->default_icon_name = "gimp-tool-levels";
 
@@ -145,9 +150,27 @@ gimp_levels_config_iface_init (GimpConfigInterface *iface)
 static void
 gimp_levels_config_init (GimpLevelsConfig *self)
 {
+  g_mutex_init (&self->lut_mutex);
+
   gimp_config_reset (GIMP_CONFIG (self));
 }
 
+static void
+gimp_levels_config_finalize (GObject *object)
+{
+  GimpLevelsConfig *self = GIMP_LEVELS_CONFIG (object);
+
+  if (self->lut)
+    {
+      g_bytes_unref (self->lut);
+      self->lut = NULL;
+    }
+
+  g_mutex_clear (&self->lut_mutex);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
 static void
 gimp_levels_config_get_property (GObject    *object,
                                  guint       property_id,
@@ -233,6 +256,27 @@ gimp_levels_config_set_property (GObject      *object,
     }
 }
 
+static void
+gimp_levels_config_notify (GObject    *object,
+                           GParamSpec *pspec)
+{
+  GimpLevelsConfig *config = GIMP_LEVELS_CONFIG (object);
+
+  if (G_OBJECT_CLASS (parent_class)->notify)
+    G_OBJECT_CLASS (parent_class)->notify (object, pspec);
+
+  /*  any change invalidates the lookup table  */
+  g_mutex_lock (&config->lut_mutex);
+
+  if (config->lut)
+    {
+      g_bytes_unref (config->lut);
+      config->lut = NULL;
+    }
+
+  g_mutex_unlock (&config->lut_mutex);
+}
+
 static gboolean
 gimp_levels_config_serialize (GimpConfig       *config,
                               GimpConfigWriter *writer,
@@ -389,6 +433,41 @@ gimp_levels_config_reset_channel (GimpLevelsConfig *config)
   g_object_thaw_notify (G_OBJECT (config));
 }
 
+/*  returns a reference to a table of @size float values for each of
+ *  the R, G, B and A channels, see gimp_operation_levels_map_lut().
+ *  the table is built on first use and kept until the config changes.
+ */
+GBytes *
+gimp_levels_config_get_lut (GimpLevelsConfig *config,
+                            gint              size)
+{
+  GBytes *lut;
+
+  g_return_val_if_fail (GIMP_IS_LEVELS_CONFIG (config), NULL);
+  g_return_val_if_fail (size > 1, NULL);
+
+  g_mutex_lock (&config->lut_mutex);
+
+  if (! config->lut ||
+      g_bytes_get_size (config->lut) != 4 * size * sizeof (gfloat))
+    {
+      gfloat *data = g_new (gfloat, 4 * size);
+
+      gimp_operation_levels_map_lut (config, data, size);
+
+      if (config->lut)
+        g_bytes_unref (config->lut);
+
+      config->lut = g_bytes_new_take (data, 4 * size * sizeof (gfloat));
+    }
+
+  lut = g_bytes_ref (config->lut);
+
+  g_mutex_unlock (&config->lut_mutex);
+
+  return lut;
+}
+
 void
 gimp_levels_config_stretch (GimpLevelsConfig *config,
                             GimpHistogram    *histogram,
@@ -48,6 +48,10 @@ struct _GimpLevelsConfig
 
   gdouble               low_output[5];
   gdouble               high_output[5];
+
+  /*  cached lookup table for integer input, see get_lut()  */
+  GMutex                lut_mutex;
+  GBytes               *lut;
 };
 
 struct _GimpLevelsConfigClass
@@ -60,6 +64,9 @@ GType      gimp_levels_config_get_type         (void) G_GNUC_CONST;
 
 void       gimp_levels_config_reset_channel    (GimpLevelsConfig      *config);
 
+GBytes   * gimp_levels_config_get_lut          (GimpLevelsConfig      *config,
+                                                gint                   size);
+
 void       gimp_levels_config_stretch          (GimpLevelsConfig      *config,
                                                 GimpHistogram         *histogram,
                                                 gboolean               is_color);
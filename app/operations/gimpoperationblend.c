@@ -38,7 +38,6 @@
 
 #include "gimp-intl.h"
 
-//#define USE_GRADIENT_CACHE 1
 
 enum
 {
@@ -63,10 +62,7 @@ typedef struct
 {
   GimpGradient     *gradient;
   gboolean          reverse;
-#ifdef USE_GRADIENT_CACHE
-  GimpRGB          *gradient_cache;
-  gint              gradient_cache_size;
-#endif
+  const GimpRGB    *gradient_lut;
   gdouble           offset;
   gdouble           sx, sy;
   GimpGradientType  gradient_type;
@@ -918,12 +914,8 @@ gradient_render_pixel (gdouble   x,
     }
   else
     {
-#ifdef USE_GRADIENT_CACHE
-      *color = rbd->gradient_cache[(gint) (factor * (rbd->gradient_cache_size - 1))];
-#else
-      gimp_gradient_get_color_at (rbd->gradient, NULL, NULL,
-                                  factor, rbd->reverse, color);
-#endif
+      gimp_gradient_lut_get_color (rbd->gradient_lut, factor, rbd->reverse,
+                                   color);
     }
 }
 
@@ -990,23 +982,8 @@ gimp_operation_blend_process (GeglOperation       *operation,
   else
     rbd.gradient = GIMP_GRADIENT (gimp_gradient_new (NULL, "Blend-Temp"));
 
-#ifdef USE_GRADIENT_CACHE
-  {
-    gint i;
-
-    rbd.gradient_cache_size = ceil (sqrt (SQR (sx - ex) + SQR (sy - ey)));
-    rbd.gradient_cache      = g_new0 (GimpRGB, rbd.gradient_cache_size);
-
-    for (i = 0; i < rbd.gradient_cache_size; i++)
-      {
-        gdouble factor = (gdouble) i / (gdouble) (rbd.gradient_cache_size - 1);
-
-        gimp_gradient_get_color_at (rbd.gradient, NULL, NULL,
-                                    factor, rbd.reverse,
-                                    rbd.gradient_cache + i);
-      }
-  }
-#endif
+  /* the gradient was flattened, so its colors don't need a context */
+  rbd.gradient_lut = gimp_gradient_get_lut (rbd.gradient, NULL);
 
   /* Calculate type-specific parameters */
 
@@ -1154,10 +1131,6 @@ gimp_operation_blend_process (GeglOperation       *operation,
         g_rand_free (rbd.seed);
     }
 
-#ifdef USE_GRADIENT_CACHE
-  g_free (rbd.gradient_cache);
-#endif
-
   g_object_unref (rbd.gradient);
 
   if (rbd.dist_buffer)
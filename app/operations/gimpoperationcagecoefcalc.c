@@ -19,6 +19,8 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include <gdk-pixbuf/gdk-pixbuf.h>
 #include <gegl.h>
 
@@ -26,12 +28,38 @@
 
 #include "operations-types.h"
 
+#include "core/gimp-parallel.h"
+
 #include "gimpoperationcagecoefcalc.h"
 #include "gimpcageconfig.h"
 
 #include "gimp-intl.h"
 
 
+#define MIN_PARALLEL_SUB_SIZE 64
+#define MIN_PARALLEL_SUB_AREA (MIN_PARALLEL_SUB_SIZE * MIN_PARALLEL_SUB_SIZE)
+
+
+/*  the parts of a cage edge that don't depend on the pixel  */
+typedef struct
+{
+  GimpVector2 v1;
+  GimpVector2 v2;
+  GimpVector2 a;
+  gdouble     absa;
+  gdouble     Q;
+} CageEdge;
+
+typedef struct
+{
+  GimpCageConfig *config;
+  GeglBuffer     *output;
+  const Babl     *format;
+  const CageEdge *edges;
+  gint            n_cage_vertices;
+} CageCoefCalcData;
+
+
 static void           gimp_operation_cage_coef_calc_finalize         (GObject              *object);
 static void           gimp_operation_cage_coef_calc_get_property     (GObject              *object,
                                                                       guint                 property_id,
@@ -48,6 +76,8 @@ static gboolean       gimp_operation_cage_coef_calc_process          (GeglOperat
                                                                       GeglBuffer           *output,
                                                                       const GeglRectangle  *roi,
                                                                       gint                  level);
+static void           gimp_operation_cage_coef_calc_area             (const GeglRectangle  *area,
+                                                                      CageCoefCalcData     *data);
 
 
 G_DEFINE_TYPE (GimpOperationCageCoefCalc, gimp_operation_cage_coef_calc,
@@ -201,22 +231,67 @@ gimp_operation_cage_coef_calc_process (GeglOperation       *operation,
 {
   GimpOperationCageCoefCalc *occc   = GIMP_OPERATION_CAGE_COEF_CALC (operation);
   GimpCageConfig            *config = GIMP_CAGE_CONFIG (occc->config);
-
-  const Babl *format;
-
-  GeglBufferIterator *it;
-  guint               n_cage_vertices;
-  GimpCagePoint      *current, *last;
+  CageCoefCalcData           data;
+  CageEdge                  *edges;
+  gint                       n_cage_vertices;
+  gint                       j;
 
   if (! config)
     return FALSE;
 
-  format = babl_format_n (babl_type ("float"), 2 * gimp_cage_config_get_n_points (config));
+  n_cage_vertices = gimp_cage_config_get_n_points (config);
+
+  edges = g_new (CageEdge, n_cage_vertices);
+
+  for (j = 0; j < n_cage_vertices; j++)
+    {
+      GimpCagePoint *last;
+      GimpCagePoint *current;
+
+      last    = &g_array_index (config->cage_points, GimpCagePoint, j);
+      current = &g_array_index (config->cage_points, GimpCagePoint,
+                                (j + 1) % n_cage_vertices);
+
+      edges[j].v1   = last->src_point;
+      edges[j].v2   = current->src_point;
+      edges[j].a.x  = edges[j].v2.x - edges[j].v1.x;
+      edges[j].a.y  = edges[j].v2.y - edges[j].v1.y;
+      edges[j].absa = gimp_vector2_length (&edges[j].a);
+      edges[j].Q    = (edges[j].a.x * edges[j].a.x +
+                       edges[j].a.y * edges[j].a.y);
+    }
 
-  n_cage_vertices   = gimp_cage_config_get_n_points (config);
+  data.config          = config;
+  data.output          = output;
+  data.format          = babl_format_n (babl_type ("float"),
+                                        2 * n_cage_vertices);
+  data.edges           = edges;
+  data.n_cage_vertices = n_cage_vertices;
 
-  it = gegl_buffer_iterator_new (output, roi, 0, format,
-                                 GEGL_ACCESS_READWRITE, GEGL_ABYSS_NONE);
+  /*  every pixel only depends on the source cage, so the areas are
+   *  computed independently; the output buffer is written tile-wise
+   *  by each thread
+   */
+  gimp_parallel_distribute_area (roi, MIN_PARALLEL_SUB_AREA,
+                                 (GimpParallelDistributeAreaFunc)
+                                 gimp_operation_cage_coef_calc_area,
+                                 &data);
+
+  g_free (edges);
+
+  return TRUE;
+}
+
+static void
+gimp_operation_cage_coef_calc_area (const GeglRectangle *area,
+                                    CageCoefCalcData    *data)
+{
+  GeglBufferIterator *it;
+  const CageEdge     *edges           = data->edges;
+  gint                n_cage_vertices = data->n_cage_vertices;
+
+  it = gegl_buffer_iterator_new (data->output, area, 0, data->format,
+                                 GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
 
   while (gegl_buffer_iterator_next (it))
     {
@@ -228,32 +303,32 @@ gimp_operation_cage_coef_calc_process (GeglOperation       *operation,
 
       gfloat      *coef = it->data[0];
 
-      while(n_pixels--)
+      while (n_pixels--)
         {
-          if (gimp_cage_config_point_inside(config, x, y))
-            {
-              last = &(g_array_index (config->cage_points, GimpCagePoint, 0));
+          /*  the buffer is written, not read, so pixels outside the
+           *  cage must be cleared explicitly
+           */
+          memset (coef, 0, 2 * n_cage_vertices * sizeof (gfloat));
 
-              for( j = 0; j < n_cage_vertices; j++)
+          if (gimp_cage_config_point_inside (data->config, x, y))
+            {
+              for (j = 0; j < n_cage_vertices; j++)
                 {
-                  GimpVector2 v1,v2,a,b,p;
-                  gdouble BA,SRT,L0,L1,A0,A1,A10,L10, Q,S,R, absa;
+                  const CageEdge *edge = &edges[j];
+                  GimpVector2     v1, v2, b, p;
+                  gdouble         BA, SRT, L0, L1, A0, A1, A10, L10, Q, S, R;
 
-                  current = &(g_array_index (config->cage_points, GimpCagePoint, (j+1) % n_cage_vertices));
-                  v1 = last->src_point;
-                  v2 = current->src_point;
+                  v1  = edge->v1;
+                  v2  = edge->v2;
+                  Q   = edge->Q;
                   p.x = x;
                   p.y = y;
-                  a.x = v2.x - v1.x;
-                  a.y = v2.y - v1.y;
-                  absa = gimp_vector2_length (&a);
 
                   b.x = v1.x - x;
                   b.y = v1.y - y;
-                  Q = a.x * a.x + a.y * a.y;
                   S = b.x * b.x + b.y * b.y;
-                  R = 2.0 * (a.x * b.x + a.y * b.y);
-                  BA = b.x * a.y - b.y * a.x;
+                  R = 2.0 * (edge->a.x * b.x + edge->a.y * b.y);
+                  BA = b.x * edge->a.y - b.y * edge->a.x;
                   SRT = sqrt(4.0 * S * Q - R * R);
 
                   L0 = log(S);
@@ -264,7 +339,7 @@ gimp_operation_cage_coef_calc_process (GeglOperation       *operation,
                   L10 = L1 - L0;
 
                   /* edge coef */
-                  coef[j + n_cage_vertices] = (-absa / (4.0 * G_PI)) * ((4.0*S-(R*R)/Q) * A10 + (R / (2.0 * Q)) * L10 + L1 - 2.0);
+                  coef[j + n_cage_vertices] = (-edge->absa / (4.0 * G_PI)) * ((4.0*S-(R*R)/Q) * A10 + (R / (2.0 * Q)) * L10 + L1 - 2.0);
 
                   if (isnan(coef[j + n_cage_vertices]))
                     {
@@ -277,8 +352,6 @@ gimp_operation_cage_coef_calc_process (GeglOperation       *operation,
                       coef[j] += (BA / (2.0 * G_PI)) * (L10 /(2.0*Q) - A10 * (2.0 + R / Q));
                       coef[(j+1)%n_cage_vertices] -= (BA / (2.0 * G_PI)) * (L10 / (2.0 * Q) - A10 * (R / Q));
                     }
-
-                  last = current;
                 }
             }
 
@@ -293,6 +366,4 @@ gimp_operation_cage_coef_calc_process (GeglOperation       *operation,
             }
         }
     }
-
-  return TRUE;
 }
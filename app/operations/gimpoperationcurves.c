@@ -67,6 +67,8 @@ gimp_operation_curves_class_init (GimpOperationCurvesClass *klass)
 
   point_class->process = gimp_operation_curves_process;
 
+  GIMP_OPERATION_POINT_FILTER_CLASS (klass)->integer_lut = TRUE;
+
   g_object_class_install_property (object_class,
                                    GIMP_OPERATION_POINT_FILTER_PROP_CONFIG,
                                    g_param_spec_object ("config",
@@ -98,6 +100,16 @@ gimp_operation_curves_process (GeglOperation       *operation,
   if (! config)
     return FALSE;
 
+  if (point->lut_size)
+    {
+      GBytes *lut = gimp_curves_config_get_lut (config, point->lut_size);
+
+      gimp_operation_point_filter_map_lut (point, lut, in_buf, dest, samples);
+      g_bytes_unref (lut);
+
+      return TRUE;
+    }
+
   gimp_curve_map_pixels (config->curve[0],
                          config->curve[1],
                          config->curve[2],
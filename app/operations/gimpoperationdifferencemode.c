@@ -21,13 +21,19 @@
 
 #include "config.h"
 
+#include <gio/gio.h>
 #include <gegl-plugin.h>
 
+#include "libgimpbase/gimpbase.h"
+
 #include "operations-types.h"
 
 #include "gimpoperationdifferencemode.h"
 
 
+GimpLayerModeFunction gimp_operation_difference_mode_process_pixels = NULL;
+
+
 static gboolean gimp_operation_difference_mode_process (GeglOperation       *operation,
                                                         void                *in_buf,
                                                         void                *aux_buf,
@@ -38,6 +44,15 @@ static gboolean gimp_operation_difference_mode_process (GeglOperation       *ope
                                                         gint                 level);
 
 
+static const GimpCpuAccelKernel gimp_operation_difference_mode_process_pixels_kernels[] =
+{
+#if COMPILE_SSE2_INTRINISICS
+  { GIMP_CPU_ACCEL_X86_SSE2, G_CALLBACK (gimp_operation_difference_mode_process_pixels_sse2) },
+#endif
+  { GIMP_CPU_ACCEL_NONE,     G_CALLBACK (gimp_operation_difference_mode_process_pixels_core) }
+};
+
+
 G_DEFINE_TYPE (GimpOperationDifferenceMode, gimp_operation_difference_mode,
                GIMP_TYPE_OPERATION_POINT_LAYER_MODE)
 
@@ -57,6 +72,9 @@ gimp_operation_difference_mode_class_init (GimpOperationDifferenceModeClass *kla
                                  NULL);
 
   point_class->process = gimp_operation_difference_mode_process;
+
+  gimp_operation_difference_mode_process_pixels =
+    (GimpLayerModeFunction) GIMP_CPU_ACCEL_SELECT (gimp_operation_difference_mode_process_pixels_kernels);
 }
 
 static void
@@ -80,14 +98,14 @@ gimp_operation_difference_mode_process (GeglOperation       *operation,
 }
 
 gboolean
-gimp_operation_difference_mode_process_pixels (gfloat              *in,
-                                               gfloat              *layer,
-                                               gfloat              *mask,
-                                               gfloat              *out,
-                                               gfloat               opacity,
-                                               glong                samples,
-                                               const GeglRectangle *roi,
-                                               gint                 level)
+gimp_operation_difference_mode_process_pixels_core (gfloat              *in,
+                                                    gfloat              *layer,
+                                                    gfloat              *mask,
+                                                    gfloat              *out,
+                                                    gfloat               opacity,
+                                                    glong                samples,
+                                                    const GeglRectangle *roi,
+                                                    gint                 level)
 {
   const gboolean has_mask = mask != NULL;
 
@@ -51,6 +51,7 @@ static void     gimp_operation_equalize_set_property (GObject             *objec
                                                       const GValue        *value,
                                                       GParamSpec          *pspec);
 
+static void     gimp_operation_equalize_prepare      (GeglOperation       *operation);
 static gboolean gimp_operation_equalize_process      (GeglOperation       *operation,
                                                       void                *in_buf,
                                                       void                *out_buf,
@@ -82,7 +83,11 @@ gimp_operation_equalize_class_init (GimpOperationEqualizeClass *klass)
                                  "description", "GIMP Equalize operation",
                                  NULL);
 
-  point_class->process = gimp_operation_equalize_process;
+  operation_class->prepare = gimp_operation_equalize_prepare;
+
+  point_class->process     = gimp_operation_equalize_process;
+
+  GIMP_OPERATION_POINT_FILTER_CLASS (klass)->integer_lut = TRUE;
 
   g_object_class_install_property (object_class, PROP_HISTOGRAM,
                                    g_param_spec_object ("histogram",
@@ -98,6 +103,7 @@ gimp_operation_equalize_init (GimpOperationEqualize *self)
 {
   self->values = NULL;
   self->n_bins = 0;
+  self->lut    = NULL;
 }
 
 static void
@@ -116,6 +122,14 @@ gimp_operation_equalize_finalize (GObject *object)
       g_object_unref (self->histogram);
       self->histogram = NULL;
     }
+
+  if (self->lut)
+    {
+      g_bytes_unref (self->lut);
+      self->lut = NULL;
+    }
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
 static void
@@ -154,6 +168,12 @@ gimp_operation_equalize_set_property (GObject      *object,
 
       self->histogram = g_value_dup_object (value);
 
+      if (self->lut)
+        {
+          g_bytes_unref (self->lut);
+          self->lut = NULL;
+        }
+
       if (self->histogram)
         {
           gdouble pixels;
@@ -228,6 +248,46 @@ gimp_operation_equalize_map (GimpOperationEqualize *self,
   return self->values[index];
 }
 
+static void
+gimp_operation_equalize_prepare (GeglOperation *operation)
+{
+  GimpOperationPointFilter *point = GIMP_OPERATION_POINT_FILTER (operation);
+  GimpOperationEqualize    *self  = GIMP_OPERATION_EQUALIZE (operation);
+  gint                      size;
+
+  GEGL_OPERATION_CLASS (parent_class)->prepare (operation);
+
+  size = point->lut_size;
+
+  if (self->lut &&
+      g_bytes_get_size (self->lut) != 4 * size * sizeof (gfloat))
+    {
+      g_bytes_unref (self->lut);
+      self->lut = NULL;
+    }
+
+  /*  tabulate the mapping for each possible integer input value, once,
+   *  before process() runs from any number of threads
+   */
+  if (size && self->values && ! self->lut)
+    {
+      gfloat *lut = g_new (gfloat, 4 * size);
+      gint    i;
+
+      for (i = 0; i < size; i++)
+        {
+          gfloat value = (gfloat) i / (gfloat) (size - 1);
+
+          lut[RED   * size + i] = gimp_operation_equalize_map (self, RED,   value);
+          lut[GREEN * size + i] = gimp_operation_equalize_map (self, GREEN, value);
+          lut[BLUE  * size + i] = gimp_operation_equalize_map (self, BLUE,  value);
+          lut[ALPHA * size + i] = value;
+        }
+
+      self->lut = g_bytes_new_take (lut, 4 * size * sizeof (gfloat));
+    }
+}
+
 static gboolean
 gimp_operation_equalize_process (GeglOperation       *operation,
                                  void                *in_buf,
@@ -240,6 +300,14 @@ gimp_operation_equalize_process (GeglOperation       *operation,
   gfloat                *src  = in_buf;
   gfloat                *dest = out_buf;
 
+  if (GIMP_OPERATION_POINT_FILTER (operation)->lut_size && self->lut)
+    {
+      gimp_operation_point_filter_map_lut (GIMP_OPERATION_POINT_FILTER (operation),
+                                           self->lut, in_buf, dest, samples);
+
+      return TRUE;
+    }
+
   while (samples--)
     {
       dest[RED]   = gimp_operation_equalize_map (self, RED,   src[RED]);
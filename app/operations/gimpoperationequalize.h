@@ -43,6 +43,8 @@ struct _GimpOperationEqualize
   GimpHistogram            *histogram;
   gdouble                  *values;
   gint                      n_bins;
+
+  GBytes                   *lut;
 };
 
 struct _GimpOperationEqualizeClass
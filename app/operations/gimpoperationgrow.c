@@ -29,9 +29,28 @@
 
 #include "operations-types.h"
 
+#include "core/gimp-parallel.h"
+
 #include "gimpoperationgrow.h"
 
 
+/*  the minimal number of rows or columns handled by one thread  */
+#define MIN_PARALLEL_SUB_SIZE 64
+
+
+typedef struct
+{
+  gfloat        *data;
+  guint16       *dist;
+  const gint16  *half_width;
+  gint           width;
+  gint           height;
+  gint           radius_y;
+  gfloat         value;
+  gboolean       value_outside;
+} GrowData;
+
+
 enum
 {
   PROP_0,
@@ -64,6 +83,13 @@ static gboolean gimp_operation_grow_process           (GeglOperation       *oper
                                                        const GeglRectangle *roi,
                                                        gint                 level);
 
+static void     gimp_operation_grow_columns           (gint                 i,
+                                                       gint                 n,
+                                                       GrowData            *data);
+static void     gimp_operation_grow_rows              (gint                 i,
+                                                       gint                 n,
+                                                       GrowData            *data);
+
 
 G_DEFINE_TYPE (GimpOperationGrow, gimp_operation_grow,
                GEGL_TYPE_OPERATION_FILTER)
@@ -244,6 +270,27 @@ gimp_operation_grow_process (GeglOperation       *operation,
   gfloat             last_max;
   gint16             last_index;
   gfloat            *buffer;
+  gfloat            *data;
+
+  data = g_new (gfloat, roi->width * roi->height);
+
+  gegl_buffer_get (input, roi, 1.0, input_format, data,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  /*  binary masks, which is what selections mostly are, take a path
+   *  whose cost doesn't depend on the radius
+   */
+  if (gimp_operation_grow_binary (data, roi->width, roi->height,
+                                  self->radius_x, self->radius_y,
+                                  1.0, FALSE))
+    {
+      gegl_buffer_set (output, roi, 0, output_format, data,
+                       GEGL_AUTO_ROWSTRIDE);
+
+      g_free (data);
+
+      return TRUE;
+    }
 
   max = g_new (gfloat *, roi->width + 2 * self->radius_x);
   buf = g_new (gfloat *, self->radius_y + 1);
@@ -285,11 +332,7 @@ gimp_operation_grow_process (GeglOperation       *operation,
   memset (buf[0], 0, roi->width * sizeof (gfloat));
 
   for (i = 0; i < self->radius_y && i < roi->height; i++) /* load top of image */
-    gegl_buffer_get (input,
-                     GEGL_RECTANGLE (roi->x, roi->y + i,
-                                     roi->width, 1),
-                     1.0, input_format, buf[i + 1],
-                     GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+    memcpy (buf[i + 1], data + i * roi->width, roi->width * sizeof (gfloat));
 
   for (x = 0; x < roi->width; x++) /* set up max for top of image */
     {
@@ -305,11 +348,9 @@ gimp_operation_grow_process (GeglOperation       *operation,
       rotate_pointers (buf, self->radius_y + 1);
 
       if (y < roi->height - (self->radius_y))
-        gegl_buffer_get (input,
-                         GEGL_RECTANGLE (roi->x,  roi->y + y + self->radius_y,
-                                         roi->width, 1),
-                         1.0, input_format, buf[self->radius_y],
-                         GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+        memcpy (buf[self->radius_y],
+                data + (y + self->radius_y) * roi->width,
+                roi->width * sizeof (gfloat));
       else
         memset (buf[self->radius_y], 0, roi->width * sizeof (gfloat));
 
@@ -384,6 +425,188 @@ gimp_operation_grow_process (GeglOperation       *operation,
 
   g_free (buf);
   g_free (out);
+  g_free (data);
 
   return TRUE;
 }
+
+
+/*  public functions  */
+
+/*  Dilates the pixels of @data which are equal to @value (0.0 or 1.0)
+ *  with the same elliptic structuring element the generic code uses,
+ *  and sets all other pixels to the opposite value.  If @value_outside
+ *  is TRUE, the pixels around @data are assumed to be equal to @value.
+ *
+ *  A column pass finds each pixel's vertical distance to @value, which
+ *  a row pass turns into the horizontal span the pixel covers, so the
+ *  cost per pixel is constant.  Returns FALSE, leaving @data alone, if
+ *  @data is not a binary mask.
+ */
+gboolean
+gimp_operation_grow_binary (gfloat   *data,
+                            gint      width,
+                            gint      height,
+                            gint      radius_x,
+                            gint      radius_y,
+                            gfloat    value,
+                            gboolean  value_outside)
+{
+  GrowData  grow_data;
+  gint16   *circ;
+  gint16   *half_width;
+  gint      i;
+  gint      d;
+
+  for (i = 0; i < width * height; i++)
+    {
+      if (data[i] != 0.0 && data[i] != 1.0)
+        return FALSE;
+    }
+
+  circ = g_new (gint16, 2 * radius_x + 1);
+  compute_border (circ, radius_x, radius_y);
+
+  /*  half_width[v] is how far a pixel at vertical distance v reaches
+   *  to either side, -1 if it doesn't reach at all
+   */
+  half_width = g_new (gint16, radius_y + 2);
+
+  for (i = 0, d = radius_x; i <= radius_y; i++)
+    {
+      while (circ[radius_x + d] < i)
+        d--;
+
+      half_width[i] = d;
+    }
+
+  half_width[radius_y + 1] = -1;
+
+  grow_data.data          = data;
+  grow_data.dist          = g_new (guint16, width * height);
+  grow_data.half_width    = half_width;
+  grow_data.width         = width;
+  grow_data.height        = height;
+  grow_data.radius_y      = radius_y;
+  grow_data.value         = value;
+  grow_data.value_outside = value_outside;
+
+  gimp_parallel_distribute (MAX (width / MIN_PARALLEL_SUB_SIZE, 1),
+                            (GimpParallelDistributeFunc)
+                            gimp_operation_grow_columns,
+                            &grow_data);
+
+  gimp_parallel_distribute (MAX (height / MIN_PARALLEL_SUB_SIZE, 1),
+                            (GimpParallelDistributeFunc)
+                            gimp_operation_grow_rows,
+                            &grow_data);
+
+  g_free (grow_data.dist);
+  g_free (half_width);
+  g_free (circ);
+
+  return TRUE;
+}
+
+
+/*  private functions  */
+
+static void
+gimp_operation_grow_columns (gint      i,
+                             gint      n,
+                             GrowData *data)
+{
+  gint     x1      = (gint64) data->width * i       / n;
+  gint     x2      = (gint64) data->width * (i + 1) / n;
+  gint     width   = data->width;
+  guint16  far     = data->radius_y + 1;
+  guint16  outside = data->value_outside ? 1 : far;
+  gint     x, y;
+
+  /*  the distance to the nearest pixel of value above, then below,
+   *  clamped to just out of reach
+   */
+  for (y = 0; y < data->height; y++)
+    {
+      const gfloat *src  = data->data + y * width;
+      guint16      *dist = data->dist + y * width;
+
+      for (x = x1; x < x2; x++)
+        {
+          if (src[x] == data->value)
+            dist[x] = 0;
+          else if (y > 0)
+            dist[x] = MIN (dist[x - width] + 1, far);
+          else
+            dist[x] = outside;
+        }
+    }
+
+  for (y = data->height - 1; y >= 0; y--)
+    {
+      guint16 *dist = data->dist + y * width;
+
+      for (x = x1; x < x2; x++)
+        {
+          if (dist[x])
+            {
+              if (y < data->height - 1)
+                dist[x] = MIN (dist[x], dist[x + width] + 1);
+              else
+                dist[x] = MIN (dist[x], outside);
+            }
+        }
+    }
+}
+
+static void
+gimp_operation_grow_rows (gint      i,
+                          gint      n,
+                          GrowData *data)
+{
+  gint    y1    = (gint64) data->height * i       / n;
+  gint    y2    = (gint64) data->height * (i + 1) / n;
+  gint    width = data->width;
+  gint   *reach = g_new (gint, width);
+  gint    x, y;
+
+  for (y = y1; y < y2; y++)
+    {
+      const guint16 *dist = data->dist + y * width;
+      gfloat        *dest = data->data + y * width;
+      gint           r;
+
+      /*  reach[x] is the rightmost pixel covered by a span starting
+       *  at x
+       */
+      for (x = 0; x < width; x++)
+        reach[x] = -1;
+
+      if (data->value_outside)
+        {
+          r = data->half_width[0];
+
+          reach[0] = r - 1;
+
+          x = MAX (width - r, 0);
+          reach[x] = MAX (reach[x], width - 1);
+        }
+
+      for (x = 0; x < width; x++)
+        {
+          r = data->half_width[dist[x]];
+
+          if (r >= 0 && x + r > reach[MAX (x - r, 0)])
+            reach[MAX (x - r, 0)] = x + r;
+        }
+
+      for (x = 0, r = -1; x < width; x++)
+        {
+          r = MAX (r, reach[x]);
+
+          dest[x] = (r >= x) ? data->value : 1.0 - data->value;
+        }
+    }
+
+  g_free (reach);
+}
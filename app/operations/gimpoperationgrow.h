@@ -50,7 +50,15 @@ struct _GimpOperationGrowClass
 };
 
 
-GType   gimp_operation_grow_get_type (void) G_GNUC_CONST;
+GType      gimp_operation_grow_get_type (void) G_GNUC_CONST;
+
+gboolean   gimp_operation_grow_binary   (gfloat   *data,
+                                         gint      width,
+                                         gint      height,
+                                         gint      radius_x,
+                                         gint      radius_y,
+                                         gfloat    value,
+                                         gboolean  value_outside);
 
 
 #endif /* __GIMP_OPERATION_GROW_H__ */
@@ -64,6 +64,8 @@ gimp_operation_levels_class_init (GimpOperationLevelsClass *klass)
 
   point_class->process = gimp_operation_levels_process;
 
+  GIMP_OPERATION_POINT_FILTER_CLASS (klass)->integer_lut = TRUE;
+
   g_object_class_install_property (object_class,
                                    GIMP_OPERATION_POINT_FILTER_PROP_CONFIG,
                                    g_param_spec_object ("config",
@@ -123,6 +125,16 @@ gimp_operation_levels_process (GeglOperation       *operation,
   if (! config)
     return FALSE;
 
+  if (point->lut_size)
+    {
+      GBytes *lut = gimp_levels_config_get_lut (config, point->lut_size);
+
+      gimp_operation_point_filter_map_lut (point, lut, in_buf, dest, samples);
+      g_bytes_unref (lut);
+
+      return TRUE;
+    }
+
   for (channel = 0; channel < 5; channel++)
     {
       g_return_val_if_fail (config->gamma[channel] != 0.0, FALSE);
@@ -184,3 +196,54 @@ gimp_operation_levels_map_input (GimpLevelsConfig     *config,
 
   return value;
 }
+
+/*  fills @lut with @size values for each of the R, G, B and A
+ *  channels, mapping the integer input value i to the result of
+ *  applying @config to i / (size - 1)
+ */
+void
+gimp_operation_levels_map_lut (GimpLevelsConfig *config,
+                               gfloat           *lut,
+                               gint              size)
+{
+  gdouble inv_gamma[5];
+  gint    channel;
+  gint    i;
+
+  g_return_if_fail (GIMP_IS_LEVELS_CONFIG (config));
+  g_return_if_fail (lut != NULL);
+  g_return_if_fail (size > 1);
+
+  for (channel = 0; channel < 5; channel++)
+    {
+      g_return_if_fail (config->gamma[channel] != 0.0);
+
+      inv_gamma[channel] = 1.0 / config->gamma[channel];
+    }
+
+  for (channel = 0; channel < 4; channel++)
+    {
+      for (i = 0; i < size; i++)
+        {
+          gdouble value;
+
+          value = gimp_operation_levels_map ((gdouble) i / (size - 1),
+                                             inv_gamma[channel + 1],
+                                             config->low_input[channel + 1],
+                                             config->high_input[channel + 1],
+                                             config->low_output[channel + 1],
+                                             config->high_output[channel + 1]);
+
+          /* don't apply the overall curve to the alpha channel */
+          if (channel != ALPHA)
+            value = gimp_operation_levels_map (value,
+                                               inv_gamma[0],
+                                               config->low_input[0],
+                                               config->high_input[0],
+                                               config->low_output[0],
+                                               config->high_output[0]);
+
+          lut[channel * size + i] = value;
+        }
+    }
+}
@@ -52,6 +52,9 @@ GType     gimp_operation_levels_get_type  (void) G_GNUC_CONST;
 gdouble   gimp_operation_levels_map_input (GimpLevelsConfig     *config,
                                            GimpHistogramChannel  channel,
                                            gdouble               value);
+void      gimp_operation_levels_map_lut   (GimpLevelsConfig     *config,
+                                           gfloat               *lut,
+                                           gint                  size);
 
 
 #endif /* __GIMP_OPERATION_LEVELS_H__ */
@@ -48,6 +48,18 @@ static gboolean gimp_operation_normal_mode_process   (GeglOperation        *oper
                                                       gint                  level);
 
 
+static const GimpCpuAccelKernel gimp_operation_normal_mode_process_pixels_kernels[] =
+{
+#if COMPILE_SSE4_1_INTRINISICS
+  { GIMP_CPU_ACCEL_X86_SSE4_1, G_CALLBACK (gimp_operation_normal_mode_process_pixels_sse4) },
+#endif
+#if COMPILE_SSE2_INTRINISICS
+  { GIMP_CPU_ACCEL_X86_SSE2,   G_CALLBACK (gimp_operation_normal_mode_process_pixels_sse2) },
+#endif
+  { GIMP_CPU_ACCEL_NONE,       G_CALLBACK (gimp_operation_normal_mode_process_pixels_core) }
+};
+
+
 G_DEFINE_TYPE (GimpOperationNormalMode, gimp_operation_normal_mode,
                GIMP_TYPE_OPERATION_POINT_LAYER_MODE)
 
@@ -90,17 +102,8 @@ gimp_operation_normal_mode_class_init (GimpOperationNormalModeClass *klass)
 
   point_class->process         = gimp_operation_normal_mode_process;
 
-  gimp_operation_normal_mode_process_pixels = gimp_operation_normal_mode_process_pixels_core;
-
-#if COMPILE_SSE2_INTRINISICS
-  if (gimp_cpu_accel_get_support() & GIMP_CPU_ACCEL_X86_SSE2)
-    gimp_operation_normal_mode_process_pixels = gimp_operation_normal_mode_process_pixels_sse2;
-#endif /* COMPILE_SSE2_INTRINISICS */
-
-#if COMPILE_SSE4_1_INTRINISICS
-  if (gimp_cpu_accel_get_support() & GIMP_CPU_ACCEL_X86_SSE4_1)
-    gimp_operation_normal_mode_process_pixels = gimp_operation_normal_mode_process_pixels_sse4;
-#endif /* COMPILE_SSE4_1_INTRINISICS */
+  gimp_operation_normal_mode_process_pixels =
+    (GimpLayerModeFunction) GIMP_CPU_ACCEL_SELECT (gimp_operation_normal_mode_process_pixels_kernels);
 }
 
 static void
@@ -112,8 +112,99 @@ gimp_operation_point_filter_set_property (GObject      *object,
 static void
 gimp_operation_point_filter_prepare (GeglOperation *operation)
 {
-  const Babl *format = babl_format ("R'G'B'A float");
+  GimpOperationPointFilter      *self         = GIMP_OPERATION_POINT_FILTER (operation);
+  GimpOperationPointFilterClass *klass        = GIMP_OPERATION_POINT_FILTER_GET_CLASS (operation);
+  const Babl                    *format       = babl_format ("R'G'B'A float");
+  const Babl                    *input_format = format;
 
-  gegl_operation_set_format (operation, "input",  format);
+  self->lut_size = 0;
+
+  /*  gamma integer input can be read as R'G'B'A without any loss, and
+   *  mapped through a table with one entry per possible value
+   */
+  if (klass->integer_lut)
+    {
+      const Babl *source = gegl_operation_get_source_format (operation,
+                                                             "input");
+
+      if (source == babl_format ("R'G'B'A u8") ||
+          source == babl_format ("R'G'B' u8")  ||
+          source == babl_format ("Y'A u8")     ||
+          source == babl_format ("Y' u8"))
+        {
+          input_format   = babl_format ("R'G'B'A u8");
+          self->lut_size = 1 << 8;
+        }
+      else if (source == babl_format ("R'G'B'A u16") ||
+               source == babl_format ("R'G'B' u16")  ||
+               source == babl_format ("Y'A u16")     ||
+               source == babl_format ("Y' u16"))
+        {
+          input_format   = babl_format ("R'G'B'A u16");
+          self->lut_size = 1 << 16;
+        }
+    }
+
+  gegl_operation_set_format (operation, "input",  input_format);
   gegl_operation_set_format (operation, "output", format);
 }
+
+
+/*  public functions  */
+
+/*  maps the integer R'G'B'A pixels of @src to float through @lut,
+ *  which holds filter->lut_size values for each of the four channels
+ */
+void
+gimp_operation_point_filter_map_lut (GimpOperationPointFilter *filter,
+                                     GBytes                   *lut,
+                                     gconstpointer             src,
+                                     gfloat                   *dest,
+                                     glong                     samples)
+{
+  const gfloat *r;
+  const gfloat *g;
+  const gfloat *b;
+  const gfloat *a;
+
+  g_return_if_fail (GIMP_IS_OPERATION_POINT_FILTER (filter));
+  g_return_if_fail (lut != NULL);
+  g_return_if_fail (g_bytes_get_size (lut) ==
+                    4 * filter->lut_size * sizeof (gfloat));
+
+  r = g_bytes_get_data (lut, NULL);
+  g = r + filter->lut_size;
+  b = g + filter->lut_size;
+  a = b + filter->lut_size;
+
+  if (filter->lut_size == 1 << 8)
+    {
+      const guint8 *s = src;
+
+      while (samples--)
+        {
+          dest[0] = r[s[0]];
+          dest[1] = g[s[1]];
+          dest[2] = b[s[2]];
+          dest[3] = a[s[3]];
+
+          s    += 4;
+          dest += 4;
+        }
+    }
+  else
+    {
+      const guint16 *s = src;
+
+      while (samples--)
+        {
+          dest[0] = r[s[0]];
+          dest[1] = g[s[1]];
+          dest[2] = b[s[2]];
+          dest[3] = a[s[3]];
+
+          s    += 4;
+          dest += 4;
+        }
+    }
+}
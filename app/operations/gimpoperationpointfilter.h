@@ -48,11 +48,21 @@ struct _GimpOperationPointFilter
   GeglOperationPointFilter  parent_instance;
 
   GObject                  *config;
+
+  /*  the number of values per channel of the integer input, or 0 if
+   *  the input is float
+   */
+  gint                      lut_size;
 };
 
 struct _GimpOperationPointFilterClass
 {
   GeglOperationPointFilterClass  parent_class;
+
+  /*  whether process() can map 8 and 16 bit input through a lookup
+   *  table instead of working on floats
+   */
+  gboolean                       integer_lut;
 };
 
 
@@ -67,5 +77,11 @@ void    gimp_operation_point_filter_set_property (GObject      *object,
                                                   const GValue *value,
                                                   GParamSpec   *pspec);
 
+void    gimp_operation_point_filter_map_lut      (GimpOperationPointFilter *filter,
+                                                  GBytes                   *lut,
+                                                  gconstpointer             src,
+                                                  gfloat                   *dest,
+                                                  glong                     samples);
+
 
 #endif /* __GIMP_OPERATION_POINT_FILTER_H__ */
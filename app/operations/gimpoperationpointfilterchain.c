@@ -0,0 +1,187 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimpoperationpointfilterchain.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*  runs a sequence of GimpOperationPointFilter nodes over each chunk
+ *  in a single pass, so a stack of color adjustments walks the buffer
+ *  and converts its pixels only once instead of once per adjustment.
+ *  the filter nodes are not part of any graph, they only provide the
+ *  configured operations.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <gegl.h>
+
+#include "operations-types.h"
+
+#include "gimpoperationpointfilter.h"
+#include "gimpoperationpointfilterchain.h"
+
+
+static void       gimp_operation_point_filter_chain_finalize (GObject             *object);
+
+static void       gimp_operation_point_filter_chain_prepare  (GeglOperation       *operation);
+static gboolean   gimp_operation_point_filter_chain_process  (GeglOperation       *operation,
+                                                              void                *in_buf,
+                                                              void                *out_buf,
+                                                              glong                samples,
+                                                              const GeglRectangle *roi,
+                                                              gint                 level);
+
+
+G_DEFINE_TYPE (GimpOperationPointFilterChain, gimp_operation_point_filter_chain,
+               GEGL_TYPE_OPERATION_POINT_FILTER)
+
+#define parent_class gimp_operation_point_filter_chain_parent_class
+
+
+static void
+gimp_operation_point_filter_chain_class_init (GimpOperationPointFilterChainClass *klass)
+{
+  GObjectClass                  *object_class    = G_OBJECT_CLASS (klass);
+  GeglOperationClass            *operation_class = GEGL_OPERATION_CLASS (klass);
+  GeglOperationPointFilterClass *point_class     = GEGL_OPERATION_POINT_FILTER_CLASS (klass);
+
+  object_class->finalize   = gimp_operation_point_filter_chain_finalize;
+
+  gegl_operation_class_set_keys (operation_class,
+                                 "name",        "gimp:point-filter-chain",
+                                 "categories",  "color",
+                                 "description", "GIMP fused point filters operation",
+                                 NULL);
+
+  operation_class->prepare = gimp_operation_point_filter_chain_prepare;
+
+  point_class->process     = gimp_operation_point_filter_chain_process;
+}
+
+static void
+gimp_operation_point_filter_chain_init (GimpOperationPointFilterChain *self)
+{
+}
+
+static void
+gimp_operation_point_filter_chain_finalize (GObject *object)
+{
+  GimpOperationPointFilterChain *self = GIMP_OPERATION_POINT_FILTER_CHAIN (object);
+
+  g_list_free_full (self->filters, (GDestroyNotify) g_object_unref);
+  self->filters = NULL;
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+gimp_operation_point_filter_chain_prepare (GeglOperation *operation)
+{
+  const Babl *format = babl_format ("R'G'B'A float");
+
+  /*  the format all GimpOperationPointFilters work in  */
+  gegl_operation_set_format (operation, "input",  format);
+  gegl_operation_set_format (operation, "output", format);
+}
+
+static gboolean
+gimp_operation_point_filter_chain_process (GeglOperation       *operation,
+                                           void                *in_buf,
+                                           void                *out_buf,
+                                           glong                samples,
+                                           const GeglRectangle *roi,
+                                           gint                 level)
+{
+  GimpOperationPointFilterChain *self = GIMP_OPERATION_POINT_FILTER_CHAIN (operation);
+  GList                         *list;
+  gfloat                        *src  = in_buf;
+
+  /*  the first filter reads the input, all following ones work in
+   *  place on the output, which all point filters support because
+   *  they read each pixel completely before writing it
+   */
+  for (list = self->filters; list; list = g_list_next (list))
+    {
+      GeglOperation                 *filter;
+      GeglOperationPointFilterClass *filter_class;
+
+      filter       = gegl_node_get_gegl_operation (list->data);
+      filter_class = GEGL_OPERATION_POINT_FILTER_GET_CLASS (filter);
+
+      /*  a filter without config passes its input through  */
+      if (! filter_class->process (filter, src, out_buf, samples, roi, level))
+        continue;
+
+      src = out_buf;
+    }
+
+  if (src != out_buf)
+    memcpy (out_buf, src, samples * 4 * sizeof (gfloat));
+
+  return TRUE;
+}
+
+
+/*  public functions  */
+
+void
+gimp_operation_point_filter_chain_set_filters (GimpOperationPointFilterChain *chain,
+                                               GList                         *filters)
+{
+  GList *list;
+
+  g_return_if_fail (GIMP_IS_OPERATION_POINT_FILTER_CHAIN (chain));
+
+  for (list = filters; list; list = g_list_next (list))
+    {
+      g_return_if_fail (GEGL_IS_NODE (list->data));
+      g_return_if_fail (GIMP_IS_OPERATION_POINT_FILTER (gegl_node_get_gegl_operation (list->data)));
+    }
+
+  g_list_free_full (chain->filters, (GDestroyNotify) g_object_unref);
+
+  chain->filters = g_list_copy (filters);
+  g_list_foreach (chain->filters, (GFunc) g_object_ref, NULL);
+}
+
+/*  creates a "gimp:point-filter-chain" node in @parent which applies
+ *  the point filter nodes in @filters one after the other, first to
+ *  last, like the same nodes linked in a row would.  since the filter
+ *  nodes are not connected, changing their configs doesn't invalidate
+ *  the chain node, the caller has to take care of that.
+ */
+GeglNode *
+gimp_operation_point_filter_chain_new_node (GeglNode *parent,
+                                            GList    *filters)
+{
+  GeglNode      *node;
+  GeglOperation *operation;
+
+  g_return_val_if_fail (parent == NULL || GEGL_IS_NODE (parent), NULL);
+
+  node = gegl_node_new_child (parent,
+                              "operation", "gimp:point-filter-chain",
+                              NULL);
+
+  operation = gegl_node_get_gegl_operation (node);
+
+  gimp_operation_point_filter_chain_set_filters (GIMP_OPERATION_POINT_FILTER_CHAIN (operation),
+                                                 filters);
+
+  return node;
+}
@@ -0,0 +1,61 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimpoperationpointfilterchain.h
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GIMP_OPERATION_POINT_FILTER_CHAIN_H__
+#define __GIMP_OPERATION_POINT_FILTER_CHAIN_H__
+
+
+#include <gegl-plugin.h>
+#include <operation/gegl-operation-point-filter.h>
+
+
+#define GIMP_TYPE_OPERATION_POINT_FILTER_CHAIN            (gimp_operation_point_filter_chain_get_type ())
+#define GIMP_OPERATION_POINT_FILTER_CHAIN(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), GIMP_TYPE_OPERATION_POINT_FILTER_CHAIN, GimpOperationPointFilterChain))
+#define GIMP_OPERATION_POINT_FILTER_CHAIN_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass),  GIMP_TYPE_OPERATION_POINT_FILTER_CHAIN, GimpOperationPointFilterChainClass))
+#define GIMP_IS_OPERATION_POINT_FILTER_CHAIN(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GIMP_TYPE_OPERATION_POINT_FILTER_CHAIN))
+#define GIMP_IS_OPERATION_POINT_FILTER_CHAIN_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass),  GIMP_TYPE_OPERATION_POINT_FILTER_CHAIN))
+#define GIMP_OPERATION_POINT_FILTER_CHAIN_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj),  GIMP_TYPE_OPERATION_POINT_FILTER_CHAIN, GimpOperationPointFilterChainClass))
+
+
+typedef struct _GimpOperationPointFilterChain      GimpOperationPointFilterChain;
+typedef struct _GimpOperationPointFilterChainClass GimpOperationPointFilterChainClass;
+
+struct _GimpOperationPointFilterChain
+{
+  GeglOperationPointFilter  parent_instance;
+
+  GList                    *filters;
+};
+
+struct _GimpOperationPointFilterChainClass
+{
+  GeglOperationPointFilterClass  parent_class;
+};
+
+
+GType   gimp_operation_point_filter_chain_get_type    (void) G_GNUC_CONST;
+
+void    gimp_operation_point_filter_chain_set_filters (GimpOperationPointFilterChain *chain,
+                                                       GList                         *filters);
+
+GeglNode * gimp_operation_point_filter_chain_new_node (GeglNode                      *parent,
+                                                       GList                         *filters);
+
+
+#endif /* __GIMP_OPERATION_POINT_FILTER_CHAIN_H__ */
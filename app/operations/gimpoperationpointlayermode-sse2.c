@@ -0,0 +1,301 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimpoperationpointlayermode-sse2.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <gegl-plugin.h>
+
+#include "operations-types.h"
+
+#include "gimpoperationadditionmode.h"
+#include "gimpoperationburnmode.h"
+#include "gimpoperationdarkenonlymode.h"
+#include "gimpoperationdifferencemode.h"
+#include "gimpoperationdividemode.h"
+#include "gimpoperationdodgemode.h"
+#include "gimpoperationgrainextractmode.h"
+#include "gimpoperationgrainmergemode.h"
+#include "gimpoperationhardlightmode.h"
+#include "gimpoperationlightenonlymode.h"
+#include "gimpoperationmultiplymode.h"
+#include "gimpoperationoverlaymode.h"
+#include "gimpoperationscreenmode.h"
+#include "gimpoperationsoftlightmode.h"
+#include "gimpoperationsubtractmode.h"
+
+#if COMPILE_SSE2_INTRINISICS
+/* SSE2 */
+#include <emmintrin.h>
+
+
+/*  All the separable layer modes composite the same way, they only
+ *  differ in how a color channel of the layer is combined with the
+ *  one below it.  Each blend function does that for R, G and B (and
+ *  a don't-care alpha) of one pixel at a time.
+ */
+
+typedef __v4sf (* BlendFunc) (__v4sf in,
+                              __v4sf layer);
+
+
+static inline __v4sf
+clamp01 (__v4sf v)
+{
+  return _mm_max_ps (_mm_min_ps (v, _mm_set1_ps (1.0f)), _mm_setzero_ps ());
+}
+
+static inline gboolean
+process_pixels_sse2 (gfloat    *in,
+                     gfloat    *layer,
+                     gfloat    *mask,
+                     gfloat    *out,
+                     gfloat     opacity,
+                     glong      samples,
+                     BlendFunc  blend)
+{
+  const __v4sf *v_in    = (const __v4sf *) in;
+  const __v4sf *v_layer = (const __v4sf *) layer;
+        __v4sf *v_out   = (      __v4sf *) out;
+
+  const __v4sf one       = _mm_set1_ps (1.0f);
+  const __v4sf zero      = _mm_setzero_ps ();
+  const __v4sf v_opacity = _mm_set1_ps (opacity);
+  const __v4sf rgb_mask  = (__v4sf) _mm_set_epi32 (0, -1, -1, -1);
+
+  while (samples--)
+    {
+      __v4sf rgba_in, rgba_layer, in_alpha, comp_alpha, new_alpha;
+
+      rgba_in    = *v_in++;
+      rgba_layer = *v_layer++;
+
+      /* expand alpha */
+      in_alpha = (__v4sf) _mm_shuffle_epi32 ((__m128i) rgba_in,
+                                             _MM_SHUFFLE (3, 3, 3, 3));
+      comp_alpha = (__v4sf) _mm_shuffle_epi32 ((__m128i) rgba_layer,
+                                               _MM_SHUFFLE (3, 3, 3, 3));
+
+      comp_alpha = _mm_min_ps (in_alpha, comp_alpha) * v_opacity;
+
+      if (mask)
+        comp_alpha = comp_alpha * _mm_set1_ps (*mask++);
+
+      new_alpha = in_alpha + (one - in_alpha) * comp_alpha;
+
+      if (_mm_ucomineq_ss (comp_alpha, zero) &&
+          _mm_ucomineq_ss (new_alpha, zero))
+        {
+          __v4sf ratio = comp_alpha / new_alpha;
+          __v4sf comp  = blend (rgba_in, rgba_layer);
+          __v4sf out_pixel;
+
+          out_pixel = comp * ratio + rgba_in * (one - ratio);
+
+          /* keep the original alpha */
+          *v_out++ = _mm_or_ps (_mm_and_ps (rgb_mask, out_pixel),
+                                _mm_andnot_ps (rgb_mask, rgba_in));
+        }
+      else
+        {
+          *v_out++ = rgba_in;
+        }
+    }
+
+  return TRUE;
+}
+
+#define LAYER_MODE_SSE2(name)                                                 \
+gboolean                                                                      \
+gimp_operation_##name##_mode_process_pixels_sse2 (gfloat              *in,    \
+                                                  gfloat              *layer, \
+                                                  gfloat              *mask,  \
+                                                  gfloat              *out,   \
+                                                  gfloat               opacity,\
+                                                  glong                samples,\
+                                                  const GeglRectangle *roi,   \
+                                                  gint                 level) \
+{                                                                             \
+  /* check alignment */                                                       \
+  if ((((uintptr_t) in) | ((uintptr_t) layer) | ((uintptr_t) out)) & 0x0F)    \
+    return gimp_operation_##name##_mode_process_pixels_core (in, layer, mask, \
+                                                             out, opacity,    \
+                                                             samples,         \
+                                                             roi, level);     \
+                                                                              \
+  return process_pixels_sse2 (in, layer, mask, out, opacity, samples,         \
+                              blend_##name);                                  \
+}
+
+
+static inline __v4sf
+blend_multiply (__v4sf in,
+                __v4sf layer)
+{
+  return clamp01 (layer * in);
+}
+
+static inline __v4sf
+blend_screen (__v4sf in,
+              __v4sf layer)
+{
+  const __v4sf one = _mm_set1_ps (1.0f);
+
+  return one - (one - in) * (one - layer);
+}
+
+static inline __v4sf
+blend_overlay (__v4sf in,
+               __v4sf layer)
+{
+  const __v4sf one = _mm_set1_ps (1.0f);
+  const __v4sf two = _mm_set1_ps (2.0f);
+
+  return in * (in + (two * layer) * (one - in));
+}
+
+static inline __v4sf
+blend_difference (__v4sf in,
+                  __v4sf layer)
+{
+  const __v4sf sign = _mm_set1_ps (-0.0f);
+
+  return _mm_andnot_ps (sign, in - layer);
+}
+
+static inline __v4sf
+blend_addition (__v4sf in,
+                __v4sf layer)
+{
+  return clamp01 (in + layer);
+}
+
+static inline __v4sf
+blend_subtract (__v4sf in,
+                __v4sf layer)
+{
+  return _mm_max_ps (in - layer, _mm_setzero_ps ());
+}
+
+static inline __v4sf
+blend_darken_only (__v4sf in,
+                   __v4sf layer)
+{
+  return _mm_min_ps (in, layer);
+}
+
+static inline __v4sf
+blend_lighten_only (__v4sf in,
+                    __v4sf layer)
+{
+  return _mm_max_ps (layer, in);
+}
+
+static inline __v4sf
+blend_divide (__v4sf in,
+              __v4sf layer)
+{
+  const __v4sf scale = _mm_set1_ps (4294967296.0 / 4294967295.0);
+  const __v4sf bias  = _mm_set1_ps (1.0 / 4294967295.0);
+
+  return clamp01 ((scale * in) / (bias + layer));
+}
+
+static inline __v4sf
+blend_dodge (__v4sf in,
+             __v4sf layer)
+{
+  const __v4sf one = _mm_set1_ps (1.0f);
+
+  return _mm_min_ps (in / (one - layer), one);
+}
+
+static inline __v4sf
+blend_burn (__v4sf in,
+            __v4sf layer)
+{
+  const __v4sf one = _mm_set1_ps (1.0f);
+
+  return clamp01 (one - (one - in) / layer);
+}
+
+static inline __v4sf
+blend_hardlight (__v4sf in,
+                 __v4sf layer)
+{
+  const __v4sf one  = _mm_set1_ps (1.0f);
+  const __v4sf two  = _mm_set1_ps (2.0f);
+  const __v4sf half = _mm_set1_ps (0.5f);
+  __v4sf       light;
+  __v4sf       dark;
+  __v4sf       select;
+
+  light = _mm_min_ps (one - (one - in) * (one - (layer - half) * two), one);
+  dark  = _mm_min_ps (in * (layer * two), one);
+
+  select = _mm_cmpgt_ps (layer, half);
+
+  return _mm_or_ps (_mm_and_ps (select, light), _mm_andnot_ps (select, dark));
+}
+
+static inline __v4sf
+blend_softlight (__v4sf in,
+                 __v4sf layer)
+{
+  const __v4sf one = _mm_set1_ps (1.0f);
+  __v4sf       multiply;
+  __v4sf       screen;
+
+  multiply = in * layer;
+  screen   = one - (one - in) * (one - layer);
+
+  return (one - in) * multiply + in * screen;
+}
+
+static inline __v4sf
+blend_grain_extract (__v4sf in,
+                     __v4sf layer)
+{
+  return clamp01 (in - layer + _mm_set1_ps (0.5f));
+}
+
+static inline __v4sf
+blend_grain_merge (__v4sf in,
+                   __v4sf layer)
+{
+  return clamp01 (in + layer - _mm_set1_ps (0.5f));
+}
+
+
+LAYER_MODE_SSE2 (multiply)
+LAYER_MODE_SSE2 (screen)
+LAYER_MODE_SSE2 (overlay)
+LAYER_MODE_SSE2 (difference)
+LAYER_MODE_SSE2 (addition)
+LAYER_MODE_SSE2 (subtract)
+LAYER_MODE_SSE2 (darken_only)
+LAYER_MODE_SSE2 (lighten_only)
+LAYER_MODE_SSE2 (divide)
+LAYER_MODE_SSE2 (dodge)
+LAYER_MODE_SSE2 (burn)
+LAYER_MODE_SSE2 (hardlight)
+LAYER_MODE_SSE2 (softlight)
+LAYER_MODE_SSE2 (grain_extract)
+LAYER_MODE_SSE2 (grain_merge)
+
+#endif /* COMPILE_SSE2_INTRINISICS */
@@ -56,6 +56,9 @@ static gboolean gimp_operation_point_layer_mode_process      (GeglOperation
                                                               const GeglRectangle  *result,
                                                               gint                  level);
 
+static gboolean gimp_operation_point_layer_mode_aux_is_clear (GeglBuffer           *aux,
+                                                              const GeglRectangle  *result);
+
 
 G_DEFINE_TYPE (GimpOperationPointLayerMode, gimp_operation_point_layer_mode,
                GEGL_TYPE_OPERATION_POINT_COMPOSER3)
@@ -75,6 +78,8 @@ gimp_operation_point_layer_mode_class_init (GimpOperationPointLayerModeClass *kl
   operation_class->prepare   = gimp_operation_point_layer_mode_prepare;
   operation_class->process   = gimp_operation_point_layer_mode_process;
 
+  klass->clear_aux_is_nop = TRUE;
+
   g_object_class_install_property (object_class, PROP_LINEAR,
                                    g_param_spec_boolean ("linear",
                                                          NULL, NULL,
@@ -168,11 +173,21 @@ gimp_operation_point_layer_mode_process (GeglOperation        *operation,
                                          gint                  level)
 {
   GimpOperationPointLayerMode *point;
+  GObject                     *aux;
 
   point = GIMP_OPERATION_POINT_LAYER_MODE (operation);
 
+  /* get the raw value this does not increase the reference count */
+  aux = gegl_operation_context_get_object (context, "aux");
+
+  /* in most modes, a fully transparent layer area leaves the input
+   * unchanged, just like a missing one
+   */
   if (point->opacity == 0.0 ||
-      ! gegl_operation_context_get_object (context, "aux"))
+      ! aux                 ||
+      (GIMP_OPERATION_POINT_LAYER_MODE_GET_CLASS (point)->clear_aux_is_nop &&
+       gimp_operation_point_layer_mode_aux_is_clear (GEGL_BUFFER (aux),
+                                                     result)))
     {
       GObject *input;
 
@@ -193,3 +208,48 @@ gimp_operation_point_layer_mode_process (GeglOperation        *operation,
                                                        output_prop, result,
                                                        level);
 }
+
+static gboolean
+gimp_operation_point_layer_mode_aux_is_clear (GeglBuffer          *aux,
+                                              const GeglRectangle *result)
+{
+  GeglBufferIterator *iter;
+  gfloat              alpha;
+
+  if (! gegl_rectangle_intersect (NULL, gegl_buffer_get_abyss (aux), result))
+    return TRUE;
+
+  if (! babl_format_has_alpha (gegl_buffer_get_format (aux)))
+    return FALSE;
+
+  /* look at a single pixel first, so opaque layers don't pay for
+   * reading the whole area twice
+   */
+  gegl_buffer_get (aux, GEGL_RECTANGLE (result->x, result->y, 1, 1), 1.0,
+                   babl_format ("A float"), &alpha,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  if (alpha != 0.0)
+    return FALSE;
+
+  iter = gegl_buffer_iterator_new (aux, result, 0, babl_format ("A float"),
+                                   GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
+
+  while (gegl_buffer_iterator_next (iter))
+    {
+      const gfloat *data  = iter->data[0];
+      gint          count = iter->length;
+
+      while (count--)
+        {
+          if (*data++ != 0.0)
+            {
+              gegl_buffer_iterator_stop (iter);
+
+              return FALSE;
+            }
+        }
+    }
+
+  return TRUE;
+}
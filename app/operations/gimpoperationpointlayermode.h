@@ -36,6 +36,9 @@ typedef struct _GimpOperationPointLayerModeClass GimpOperationPointLayerModeClas
 struct _GimpOperationPointLayerModeClass
 {
   GeglOperationPointComposer3Class  parent_class;
+
+  /*  whether a fully transparent aux area leaves the input unchanged  */
+  gboolean                          clear_aux_is_nop;
 };
 
 struct _GimpOperationPointLayerMode
@@ -46,9 +46,11 @@ gimp_operation_replace_mode_class_init (GimpOperationReplaceModeClass *klass)
 {
   GeglOperationClass               *operation_class;
   GeglOperationPointComposer3Class *point_class;
+  GimpOperationPointLayerModeClass *layer_mode_class;
 
-  operation_class = GEGL_OPERATION_CLASS (klass);
-  point_class     = GEGL_OPERATION_POINT_COMPOSER3_CLASS (klass);
+  operation_class  = GEGL_OPERATION_CLASS (klass);
+  point_class      = GEGL_OPERATION_POINT_COMPOSER3_CLASS (klass);
+  layer_mode_class = GIMP_OPERATION_POINT_LAYER_MODE_CLASS (klass);
 
   gegl_operation_class_set_keys (operation_class,
                                  "name",        "gimp:replace-mode",
@@ -56,6 +58,9 @@ gimp_operation_replace_mode_class_init (GimpOperationReplaceModeClass *klass)
                                  NULL);
 
   point_class->process = gimp_operation_replace_mode_process;
+
+  /*  replacing with transparency clears the input  */
+  layer_mode_class->clear_aux_is_nop = FALSE;
 }
 
 static void
@@ -29,9 +29,27 @@
 
 #include "operations-types.h"
 
+#include "core/gimp-parallel.h"
+
 #include "gimpoperationshapeburst.h"
 
 
+/*  pixels below this value are outside of the shape  */
+#define EPSILON 0.0001
+
+/*  the minimal number of rows or columns handled by one thread  */
+#define MIN_PARALLEL_SUB_SIZE 64
+
+
+typedef struct
+{
+  gfloat *data;
+  gint    width;
+  gint    height;
+  gfloat  max_dist[GIMP_PARALLEL_MAX_THREADS];
+} ShapeburstData;
+
+
 enum
 {
   PROP_0,
@@ -63,6 +81,13 @@ static gboolean gimp_operation_shapeburst_process (GeglOperation       *operatio
                                                    const GeglRectangle *roi,
                                                    gint                 level);
 
+static void     gimp_operation_shapeburst_columns (gint                 i,
+                                                   gint                 n,
+                                                   ShapeburstData      *data);
+static void     gimp_operation_shapeburst_rows    (gint                 i,
+                                                   gint                 n,
+                                                   ShapeburstData      *data);
+
 
 G_DEFINE_TYPE (GimpOperationShapeburst, gimp_operation_shapeburst,
                GEGL_TYPE_OPERATION_FILTER)
@@ -189,150 +214,181 @@ gimp_operation_shapeburst_process (GeglOperation       *operation,
                                    const GeglRectangle *roi,
                                    gint                 level)
 {
-  const Babl *input_format   = babl_format ("Y float");
-  const Babl *output_format  = babl_format ("Y float");
-  gfloat      max_dist = 0.0;
-  gfloat     *distbuf;
-  gint        x, y;
-
-  distbuf = g_new0 (gfloat, (roi->width + 1) * 2);
+  const Babl     *input_format  = babl_format ("Y float");
+  const Babl     *output_format = babl_format ("Y float");
+  ShapeburstData  data          = { 0, };
+  gfloat          max_dist      = 0.0;
+  gint            i;
+
+  /*  An exact euclidean distance transform of the shape, where
+   *  everything outside of @roi counts as outside of the shape.  The
+   *  first pass finds the vertical distances within each column, the
+   *  second one the lower envelope of the parabolas they define along
+   *  each row, both passes run in parallel over the columns and rows,
+   *  see Felzenszwalb and Huttenlocher, "Distance Transforms of
+   *  Sampled Functions".
+   */
+  data.data   = g_new (gfloat, (gsize) roi->width * roi->height);
+  data.width  = roi->width;
+  data.height = roi->height;
+
+  gegl_buffer_get (input, roi, 1.0, input_format,
+                   data.data, GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  gimp_parallel_distribute (MAX (roi->width / MIN_PARALLEL_SUB_SIZE, 1),
+                            (GimpParallelDistributeFunc)
+                            gimp_operation_shapeburst_columns,
+                            &data);
+
+  g_object_set (operation,
+                "progress", 0.5,
+                NULL);
+
+  gimp_parallel_distribute (MAX (roi->height / MIN_PARALLEL_SUB_SIZE, 1),
+                            (GimpParallelDistributeFunc)
+                            gimp_operation_shapeburst_rows,
+                            &data);
+
+  for (i = 0; i < GIMP_PARALLEL_MAX_THREADS; i++)
+    max_dist = MAX (max_dist, data.max_dist[i]);
 
-  for (y = 0; y < roi->height; y++)
+  if (GIMP_OPERATION_SHAPEBURST (operation)->normalize && max_dist > 0.0)
     {
-      gfloat *distbuf_cur;
-      gfloat *distbuf_prev;
-      gfloat  src = 0.0;
+      gfloat *d     = data.data;
+      gsize   count = (gsize) roi->width * roi->height;
 
-      /* toggling distance buffers for the current and previous row.
-       * with one spare zero element on the left side */
-      if (y % 2)
-        {
-          distbuf_prev = distbuf + 1;
-          distbuf_cur  = distbuf + 1 + roi->width + 1;
-        }
-      else
-        {
-          distbuf_prev = distbuf + 1 + roi->width + 1;
-          distbuf_cur  = distbuf + 1;
-        }
+      while (count--)
+        *d++ /= max_dist;
+    }
+
+  gegl_buffer_set (output, roi, 0, output_format,
+                   data.data, GEGL_AUTO_ROWSTRIDE);
+
+  g_free (data.data);
+
+  g_object_set (operation,
+                "progress", 1.0,
+                NULL);
 
-      /*  clear the current rows distbuffer */
-      memset (distbuf_cur, 0, sizeof (gfloat) * roi->width);
+  return TRUE;
+}
 
-      for (x = 0; x < roi->width; x++)
+static void
+gimp_operation_shapeburst_columns (gint            i,
+                                   gint            n,
+                                   ShapeburstData *data)
+{
+  gint    x1    = (gint64) data->width * i       / n;
+  gint    x2    = (gint64) data->width * (i + 1) / n;
+  gint    width = data->width;
+  gfloat *row;
+  gint    x, y;
+
+  /*  the distance to the nearest pixel outside of the shape above,
+   *  walking the columns a row at a time to stay in the cache
+   */
+  for (y = 0, row = data->data; y < data->height; y++, row += width)
+    {
+      for (x = x1; x < x2; x++)
         {
-          gfloat dist_nw = MIN (distbuf_cur[x-1], distbuf_prev[x]);
-          gfloat dist_se = MIN ((roi->width - x - 1), (roi->height - y - 1));
-          gfloat dist    = MIN (dist_se, dist_nw);
-          gfloat frac    = 1.0;
-          gint   k;
+          if (row[x] < EPSILON)
+            row[x] = 0.0;
+          else
+            row[x] = (y > 0 ? row[x - width] : 0.0) + 1.0;
+        }
+    }
 
-#define EPSILON 0.0001
+  /*  and the nearer of that and the one below  */
+  for (y = data->height - 1, row = data->data + (gsize) y * width;
+       y >= 0;
+       y--, row -= width)
+    {
+      for (x = x1; x < x2; x++)
+        row[x] = MIN (row[x],
+                      (y < data->height - 1 ? row[x + width] : 0.0) + 1.0);
+    }
+}
 
-          /*  This loop used to start at "k = (dist) ? (dist - 1) : 0"
-           *  and this comment suggested it might have to be changed to
-           *  "k = 0", but "k = 0" increases processing time significantly.
-           *
-           *  When porting this to float, i noticed that starting at
-           *  "dist - 2" gets rid of a lot of 8-bit artifacts, while starting
-           *  at "dist - 3" or smaller would introduce different artifacts.
-           *
-           *  Note that I didn't really understand the entire algorithm,
-           *  I just "blindly" ported it to float :) --mitch
-           */
-
-          /* the idea here is to check the south-eastern "thick" diagonal
-           * along the already established accumulated minimum distance.
-           *
-           * it is easy to understand why it is sufficient to check
-           * the triangle to this diagonal (k=0), but in fact we can
-           * omit that, since this check has already been incorporated
-           * in the accumulated minimum distance of the previous pixels.
-           *
-           * Not sure however if this is implemented properly.
-           *      -- simon
-           */
-
-          for (k = MAX (dist - 2, 0); k <= dist; k++)
-            {
-              gint x1  = x;
-              gint y1  = y + k;
-
-              while (y1 >= y)
-                {
-                  /* FIXME: this should be much faster, it converts to
-                   * 32 bit rgba intermediately, bah...
-                   */
-                  gegl_buffer_sample (input, x1, y1, NULL, &src,
-                                      input_format,
-                                      GEGL_SAMPLER_NEAREST, GEGL_ABYSS_NONE);
-
-                  if (src < EPSILON)
-                    {
-                      dist = k;
-                      break;
-                    }
-
-                  frac = MIN (frac, src);
-
-                  x1++;
-                  y1--;
-                }
-            }
+static inline gfloat
+parabola_intersection (const gfloat *f,
+                       gint          p,
+                       gint          q)
+{
+  return ((f[q] + (gfloat) q * q) - (f[p] + (gfloat) p * p)) / (2.0 * (q - p));
+}
 
-          if (src > EPSILON)
-            {
-              /*  If dist_se != dist_nw use the previous frac
-               *   if it is less than the one found
-               */
-              if (dist_se != dist)
-                {
-                  gfloat prev_frac = dist_nw - dist;
+static void
+gimp_operation_shapeburst_rows (gint            i,
+                                gint            n,
+                                ShapeburstData *data)
+{
+  gint    y1       = (gint64) data->height * i       / n;
+  gint    y2       = (gint64) data->height * (i + 1) / n;
+  gint    width    = data->width;
+  gfloat  max_dist = 0.0;
+  gfloat *f;
+  gfloat *z;
+  gint   *v;
+  gint    y;
+
+  f = g_new (gfloat, width);
+  z = g_new (gfloat, width + 1);
+  v = g_new (gint,   width);
+
+  for (y = y1; y < y2; y++)
+    {
+      gfloat *row = data->data + (gsize) y * width;
+      gint    k   = 0;
+      gint    q;
+
+      for (q = 0; q < width; q++)
+        f[q] = row[q] * row[q];
 
-                  if (ABS (prev_frac - 1.0) < EPSILON)
-                    prev_frac = 0.0;
+      /*  the lower envelope of the parabolas rooted at each pixel  */
+      v[0] = 0;
+      z[0] = -G_MAXFLOAT;
+      z[1] =  G_MAXFLOAT;
 
-                  frac = MIN (frac, prev_frac);
-                }
+      for (q = 1; q < width; q++)
+        {
+          gfloat s = parabola_intersection (f, v[k], q);
 
-              dist += 1.0;
+          /*  z[0] is -G_MAXFLOAT, so k never drops below 0  */
+          while (s <= z[k])
+            {
+              k--;
+              s = parabola_intersection (f, v[k], q);
             }
 
-          distbuf_cur[x] = dist + frac;
+          k++;
 
-          max_dist = MAX (max_dist, distbuf_cur[x]);
+          v[k]     = q;
+          z[k]     = s;
+          z[k + 1] = G_MAXFLOAT;
         }
 
-      /*  set the dist row  */
-      gegl_buffer_set (output,
-                       GEGL_RECTANGLE (roi->x, roi->y + y,
-                                       roi->width, 1),
-                       0, output_format, distbuf_cur,
-                       GEGL_AUTO_ROWSTRIDE);
-
-      g_object_set (operation,
-                    "progress", (gdouble) y / roi->height,
-                    NULL);
-    }
+      for (q = 0, k = 0; q < width; q++)
+        {
+          gfloat dist;
 
-  g_free (distbuf);
+          while (z[k + 1] < q)
+            k++;
 
-  if (GIMP_OPERATION_SHAPEBURST (operation)->normalize && max_dist > 0.0)
-    {
-      GeglBufferIterator *iter;
+          dist = (gfloat) (q - v[k]) * (q - v[k]) + f[v[k]];
 
-      iter = gegl_buffer_iterator_new (output, NULL, 0, NULL,
-                                       GEGL_ACCESS_READWRITE, GEGL_ABYSS_NONE);
+          /*  the left and right edges are outside of the shape, too  */
+          dist = MIN (dist, (gfloat) (q + 1) * (q + 1));
+          dist = MIN (dist, (gfloat) (width - q) * (width - q));
 
-      while (gegl_buffer_iterator_next (iter))
-        {
-          gint    count = iter->length;
-          gfloat *data  = iter->data[0];
+          row[q] = sqrtf (dist);
 
-          while (count--)
-            *data++ /= max_dist;
+          max_dist = MAX (max_dist, row[q]);
         }
     }
 
-  return TRUE;
+  g_free (f);
+  g_free (z);
+  g_free (v);
+
+  data->max_dist[i] = max_dist;
 }
@@ -29,6 +29,7 @@
 
 #include "operations-types.h"
 
+#include "gimpoperationgrow.h"
 #include "gimpoperationshrink.h"
 
 
@@ -266,6 +267,25 @@ gimp_operation_shrink_process (GeglOperation       *operation,
   gint16               last_index;
   gfloat              *buffer;
   gint                 buffer_size;
+  gfloat              *data;
+
+  data = g_new (gfloat, roi->width * roi->height);
+
+  gegl_buffer_get (input, roi, 1.0, input_format, data,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  /*  shrinking a binary mask is growing its unselected part  */
+  if (gimp_operation_grow_binary (data, roi->width, roi->height,
+                                  self->radius_x, self->radius_y,
+                                  0.0, ! self->edge_lock))
+    {
+      gegl_buffer_set (output, roi, 0, output_format, data,
+                       GEGL_AUTO_ROWSTRIDE);
+
+      g_free (data);
+
+      return TRUE;
+    }
 
   max = g_new (gfloat *, roi->width + 2 * self->radius_x);
   buf = g_new (gfloat *, self->radius_y + 1);
@@ -293,7 +313,7 @@ gimp_operation_shrink_process (GeglOperation       *operation,
           if (self->edge_lock)
             max[i] = buffer;
           else
-            max[i] = &buffer[(self->radius_x + 1) * (roi->width + self->radius_x)];
+            max[i] = &buffer[(self->radius_y + 1) * (roi->width + self->radius_x)];
         }
       else if (i < roi->width + self->radius_x)
         {
@@ -302,14 +322,14 @@ gimp_operation_shrink_process (GeglOperation       *operation,
       else
         {
           if (self->edge_lock)
-            max[i] = &buffer[(self->radius_x + 1) * (roi->width + self->radius_x - 1)];
+            max[i] = &buffer[(self->radius_y + 1) * (roi->width + self->radius_x - 1)];
           else
-            max[i] = &buffer[(self->radius_x + 1) * (roi->width + self->radius_x)];
+            max[i] = &buffer[(self->radius_y + 1) * (roi->width + self->radius_x)];
         }
     }
 
   if (! self->edge_lock)
-    for (j = 0 ; j < self->radius_x + 1; j++)
+    for (j = 0 ; j < self->radius_y + 1; j++)
       max[0][j] = 0.0;
 
   /* offset the max pointer by self->radius_x so the range of the
@@ -328,11 +348,7 @@ gimp_operation_shrink_process (GeglOperation       *operation,
   circ += self->radius_x;
 
   for (i = 0; i < self->radius_y && i < roi->height; i++) /* load top of image */
-    gegl_buffer_get (input,
-                     GEGL_RECTANGLE (roi->x, roi->y + i,
-                                     roi->width, 1),
-                     1.0, input_format, buf[i + 1],
-                     GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+    memcpy (buf[i + 1], data + i * roi->width, roi->width * sizeof (gfloat));
 
   if (self->edge_lock)
     memcpy (buf[0], buf[1], roi->width * sizeof (gfloat));
@@ -352,11 +368,9 @@ gimp_operation_shrink_process (GeglOperation       *operation,
       rotate_pointers (buf, self->radius_y + 1);
 
       if (y < roi->height - self->radius_y)
-        gegl_buffer_get (input,
-                         GEGL_RECTANGLE (roi->x,  roi->y + y + self->radius_y,
-                                         roi->width, 1),
-                         1.0, input_format, buf[self->radius_y],
-                         GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+        memcpy (buf[self->radius_y],
+                data + (y + self->radius_y) * roi->width,
+                roi->width * sizeof (gfloat));
 
       else if (self->edge_lock)
         memcpy (buf[self->radius_y], buf[self->radius_y - 1],
@@ -402,7 +416,7 @@ gimp_operation_shrink_process (GeglOperation       *operation,
           else
             {
               last_index = self->radius_x;
-              last_max = max[x + self->radius_y][circ[self->radius_x]];
+              last_max = max[x + self->radius_x][circ[self->radius_x]];
 
               for (i = self->radius_x - 1; i >= -self->radius_x; i--)
                 if (last_max > max[x + i][circ[i]])
@@ -431,11 +445,12 @@ gimp_operation_shrink_process (GeglOperation       *operation,
   g_free (buffer);
   g_free (max);
 
-  for (i = 0; i < self->radius_x + 1; i++)
+  for (i = 0; i < self->radius_y + 1; i++)
     g_free (buf[i]);
 
   g_free (buf);
   g_free (out);
+  g_free (data);
 
   return TRUE;
 }
@@ -0,0 +1,573 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * benchmark-operations.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*  Throughput benchmark for the layer modes and point filters.
+ *
+ *  The layer mode process functions are called directly for every ISA
+ *  path this machine supports, the layer modes and point filters are
+ *  then run through a GEGL graph on float and u8 buffers.  Results are
+ *  printed as Mpixels/s, compare them across builds to spot
+ *  regressions.
+ *
+ *  Usage: benchmark-operations [--size=N] [--iterations=N] [--filter=STR]
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <gegl.h>
+#include <gegl-plugin.h>
+
+#include "libgimpbase/gimpbase.h"
+
+#include "app/operations/operations-types.h"
+
+#include "app/operations/gimp-operations.h"
+
+#include "app/operations/gimpoperationadditionmode.h"
+#include "app/operations/gimpoperationantierasemode.h"
+#include "app/operations/gimpoperationbehindmode.h"
+#include "app/operations/gimpoperationburnmode.h"
+#include "app/operations/gimpoperationcolorerasemode.h"
+#include "app/operations/gimpoperationcolormode.h"
+#include "app/operations/gimpoperationdarkenonlymode.h"
+#include "app/operations/gimpoperationdifferencemode.h"
+#include "app/operations/gimpoperationdissolvemode.h"
+#include "app/operations/gimpoperationdividemode.h"
+#include "app/operations/gimpoperationdodgemode.h"
+#include "app/operations/gimpoperationerasemode.h"
+#include "app/operations/gimpoperationgrainextractmode.h"
+#include "app/operations/gimpoperationgrainmergemode.h"
+#include "app/operations/gimpoperationhardlightmode.h"
+#include "app/operations/gimpoperationhuemode.h"
+#include "app/operations/gimpoperationlightenonlymode.h"
+#include "app/operations/gimpoperationmultiplymode.h"
+#include "app/operations/gimpoperationnormalmode.h"
+#include "app/operations/gimpoperationoverlaymode.h"
+#include "app/operations/gimpoperationreplacemode.h"
+#include "app/operations/gimpoperationsaturationmode.h"
+#include "app/operations/gimpoperationscreenmode.h"
+#include "app/operations/gimpoperationsoftlightmode.h"
+#include "app/operations/gimpoperationsubtractmode.h"
+#include "app/operations/gimpoperationvaluemode.h"
+
+#include "app/operations/gimpbrightnesscontrastconfig.h"
+#include "app/operations/gimpcolorbalanceconfig.h"
+#include "app/operations/gimpcolorizeconfig.h"
+#include "app/operations/gimpcurvesconfig.h"
+#include "app/operations/gimpdesaturateconfig.h"
+#include "app/operations/gimphuesaturationconfig.h"
+#include "app/operations/gimplevelsconfig.h"
+#include "app/operations/gimpposterizeconfig.h"
+#include "app/operations/gimpthresholdconfig.h"
+
+
+#define N_CHUNK_PIXELS (128 * 128)
+
+
+typedef struct
+{
+  const gchar           *name;
+  GimpLayerModeFunction  core;
+  GimpLayerModeFunction  sse2;
+  GimpLayerModeFunction  sse4;
+} LayerMode;
+
+typedef struct
+{
+  const gchar *operation;
+  GType      (*config_type) (void);
+} PointFilter;
+
+typedef struct
+{
+  const gchar *name;
+  gfloat       opacity;
+  gboolean     use_mask;
+  gboolean     opaque;
+} Variant;
+
+
+#if COMPILE_SSE2_INTRINISICS
+#define SIMD(name, mode)                                \
+  { name,                                               \
+    gimp_operation_##mode##_mode_process_pixels_core,   \
+    gimp_operation_##mode##_mode_process_pixels_sse2,   \
+    NULL }
+#else
+#define SIMD(name, mode)                                \
+  { name,                                               \
+    gimp_operation_##mode##_mode_process_pixels_core,   \
+    NULL,                                               \
+    NULL }
+#endif
+
+static const LayerMode layer_modes[] =
+{
+  { "normal",
+    gimp_operation_normal_mode_process_pixels_core,
+#if COMPILE_SSE2_INTRINISICS
+    gimp_operation_normal_mode_process_pixels_sse2,
+#else
+    NULL,
+#endif
+#if COMPILE_SSE4_1_INTRINISICS
+    gimp_operation_normal_mode_process_pixels_sse4
+#else
+    NULL
+#endif
+  },
+
+  SIMD ("multiply",       multiply),
+  SIMD ("screen",         screen),
+  SIMD ("overlay",        overlay),
+  SIMD ("difference",     difference),
+  SIMD ("addition",       addition),
+  SIMD ("subtract",       subtract),
+  SIMD ("darken-only",    darken_only),
+  SIMD ("lighten-only",   lighten_only),
+  SIMD ("divide",         divide),
+  SIMD ("dodge",          dodge),
+  SIMD ("burn",           burn),
+  SIMD ("hardlight",      hardlight),
+  SIMD ("softlight",      softlight),
+  SIMD ("grain-extract",  grain_extract),
+  SIMD ("grain-merge",    grain_merge),
+
+  { "dissolve",     gimp_operation_dissolve_mode_process_pixels,     NULL, NULL },
+  { "behind",       gimp_operation_behind_mode_process_pixels,       NULL, NULL },
+  { "hue",          gimp_operation_hue_mode_process_pixels,          NULL, NULL },
+  { "saturation",   gimp_operation_saturation_mode_process_pixels,   NULL, NULL },
+  { "color",        gimp_operation_color_mode_process_pixels,        NULL, NULL },
+  { "value",        gimp_operation_value_mode_process_pixels,        NULL, NULL },
+  { "color-erase",  gimp_operation_color_erase_mode_process_pixels,  NULL, NULL },
+  { "erase",        gimp_operation_erase_mode_process_pixels,        NULL, NULL },
+  { "replace",      gimp_operation_replace_mode_process_pixels,      NULL, NULL },
+  { "anti-erase",   gimp_operation_anti_erase_mode_process_pixels,   NULL, NULL }
+};
+
+#undef SIMD
+
+static const PointFilter point_filters[] =
+{
+  { "gimp:brightness-contrast", gimp_brightness_contrast_config_get_type },
+  { "gimp:color-balance",       gimp_color_balance_config_get_type       },
+  { "gimp:colorize",            gimp_colorize_config_get_type            },
+  { "gimp:curves",              gimp_curves_config_get_type              },
+  { "gimp:desaturate",          gimp_desaturate_config_get_type          },
+  { "gimp:hue-saturation",      gimp_hue_saturation_config_get_type      },
+  { "gimp:levels",              gimp_levels_config_get_type              },
+  { "gimp:posterize",           gimp_posterize_config_get_type           },
+  { "gimp:threshold",           gimp_threshold_config_get_type           }
+};
+
+static const Variant variants[] =
+{
+  { "opaque",          1.0, FALSE, TRUE  },
+  { "opacity 50%",     0.5, FALSE, TRUE  },
+  { "mask",            1.0, TRUE,  TRUE  },
+  { "alpha",           1.0, FALSE, FALSE },
+  { "alpha+mask 50%",  0.5, TRUE,  FALSE }
+};
+
+
+static gint         size       = 2048;
+static gint         iterations = 5;
+static gchar       *filter     = NULL;
+
+static const GOptionEntry entries[] =
+{
+  { "size", 's', 0, G_OPTION_ARG_INT, &size,
+    "Width and height of the benchmark buffers (default: 2048)", "N" },
+  { "iterations", 'i', 0, G_OPTION_ARG_INT, &iterations,
+    "Number of runs per measurement, the best one counts (default: 5)", "N" },
+  { "filter", 'f', 0, G_OPTION_ARG_STRING, &filter,
+    "Only run benchmarks whose name contains STR", "STR" },
+  { NULL }
+};
+
+
+static gboolean
+benchmark_selected (const gchar *name)
+{
+  return ! filter || strstr (name, filter);
+}
+
+static void
+benchmark_report (const gchar *name,
+                  const gchar *path,
+                  const gchar *variant,
+                  gdouble      seconds)
+{
+  gdouble mpixels = (gdouble) size * size / 1000000.0;
+
+  g_print ("%-28s %-6s %-16s %10.2f Mpixels/s\n",
+           name, path, variant, seconds > 0.0 ? mpixels / seconds : 0.0);
+}
+
+static void
+fill_pixels (gfloat   *pixels,
+             gint      n_pixels,
+             gboolean  opaque,
+             GRand    *rand)
+{
+  gint i;
+
+  for (i = 0; i < n_pixels; i++)
+    {
+      pixels[0] = g_rand_double (rand);
+      pixels[1] = g_rand_double (rand);
+      pixels[2] = g_rand_double (rand);
+      pixels[3] = opaque ? 1.0 : g_rand_double (rand);
+
+      pixels += 4;
+    }
+}
+
+
+/*  layer mode process functions  */
+
+static gdouble
+benchmark_layer_mode_func (GimpLayerModeFunction  func,
+                           gfloat                *in,
+                           gfloat                *layer,
+                           gfloat                *mask,
+                           gfloat                *out,
+                           gfloat                 opacity)
+{
+  gdouble best = G_MAXDOUBLE;
+  gint    n_pixels = size * size;
+  gint    i;
+
+  for (i = 0; i < iterations; i++)
+    {
+      GTimer *timer = g_timer_new ();
+      gint    offset;
+
+      /*  call the function on tile sized chunks, like GEGL does  */
+      for (offset = 0; offset < n_pixels; offset += N_CHUNK_PIXELS)
+        {
+          GeglRectangle roi;
+          gint          n = MIN (N_CHUNK_PIXELS, n_pixels - offset);
+
+          roi.x      = offset % size;
+          roi.y      = offset / size;
+          roi.width  = n;
+          roi.height = 1;
+
+          func (in    + offset * 4,
+                layer + offset * 4,
+                mask ? mask + offset : NULL,
+                out   + offset * 4,
+                opacity, n, &roi, 0);
+        }
+
+      best = MIN (best, g_timer_elapsed (timer, NULL));
+
+      g_timer_destroy (timer);
+    }
+
+  return best;
+}
+
+static void
+benchmark_layer_mode_funcs (void)
+{
+  GimpCpuAccelFlags  accel    = gimp_cpu_accel_get_support ();
+  gint               n_pixels = size * size;
+  GRand             *rand     = g_rand_new_with_seed (42);
+  gfloat            *in;
+  gfloat            *layer;
+  gfloat            *mask;
+  gfloat            *out;
+  gint               i, j;
+
+  /*  the SSE paths need 16 byte aligned buffers  */
+  in    = gegl_malloc (n_pixels * 4 * sizeof (gfloat));
+  layer = gegl_malloc (n_pixels * 4 * sizeof (gfloat));
+  mask  = gegl_malloc (n_pixels * sizeof (gfloat));
+  out   = gegl_malloc (n_pixels * 4 * sizeof (gfloat));
+
+  for (i = 0; i < n_pixels; i++)
+    mask[i] = g_rand_double (rand);
+
+  g_print ("\nLayer mode process functions (%dx%d RGBA float)\n\n",
+           size, size);
+
+  for (j = 0; j < G_N_ELEMENTS (variants); j++)
+    {
+      const Variant *variant = &variants[j];
+
+      fill_pixels (in,    n_pixels, variant->opaque, rand);
+      fill_pixels (layer, n_pixels, variant->opaque, rand);
+
+      for (i = 0; i < G_N_ELEMENTS (layer_modes); i++)
+        {
+          const LayerMode *mode      = &layer_modes[i];
+          gfloat          *mode_mask = variant->use_mask ? mask : NULL;
+
+          if (! benchmark_selected (mode->name))
+            continue;
+
+          benchmark_report (mode->name, "core", variant->name,
+                            benchmark_layer_mode_func (mode->core,
+                                                       in, layer,
+                                                       mode_mask, out,
+                                                       variant->opacity));
+
+          if (mode->sse2 && (accel & GIMP_CPU_ACCEL_X86_SSE2))
+            benchmark_report (mode->name, "sse2", variant->name,
+                              benchmark_layer_mode_func (mode->sse2,
+                                                         in, layer,
+                                                         mode_mask, out,
+                                                         variant->opacity));
+
+          if (mode->sse4 && (accel & GIMP_CPU_ACCEL_X86_SSE4_1))
+            benchmark_report (mode->name, "sse4", variant->name,
+                              benchmark_layer_mode_func (mode->sse4,
+                                                         in, layer,
+                                                         mode_mask, out,
+                                                         variant->opacity));
+        }
+    }
+
+  gegl_free (in);
+  gegl_free (layer);
+  gegl_free (mask);
+  gegl_free (out);
+
+  g_rand_free (rand);
+}
+
+
+/*  GEGL graphs  */
+
+static GeglBuffer *
+create_buffer (const Babl *format,
+               gboolean    opaque,
+               GRand      *rand)
+{
+  GeglRectangle  rect     = { 0, 0, size, size };
+  GeglBuffer    *buffer   = gegl_buffer_new (&rect, format);
+  gint           n_pixels = size * size;
+  gfloat        *pixels   = g_new (gfloat, n_pixels * 4);
+
+  fill_pixels (pixels, n_pixels, opaque, rand);
+
+  gegl_buffer_set (buffer, &rect, 0, babl_format ("RGBA float"),
+                   pixels, GEGL_AUTO_ROWSTRIDE);
+
+  g_free (pixels);
+
+  return buffer;
+}
+
+static gdouble
+benchmark_node (GeglNode   *node,
+                GeglBuffer *input,
+                GeglBuffer *aux,
+                GeglBuffer *mask)
+{
+  GeglNode   *graph;
+  GeglNode   *output;
+  GeglBuffer *dest;
+  gdouble     best = G_MAXDOUBLE;
+  gint        i;
+
+  dest  = gegl_buffer_new (gegl_buffer_get_extent (input),
+                           gegl_buffer_get_format (input));
+
+  graph = gegl_node_new ();
+
+  gegl_node_add_child (graph, node);
+
+  gegl_node_connect_to (gegl_node_new_child (graph,
+                                             "operation", "gegl:buffer-source",
+                                             "buffer",    input,
+                                             NULL),
+                        "output", node, "input");
+
+  if (aux)
+    gegl_node_connect_to (gegl_node_new_child (graph,
+                                               "operation", "gegl:buffer-source",
+                                               "buffer",    aux,
+                                               NULL),
+                          "output", node, "aux");
+
+  if (mask)
+    gegl_node_connect_to (gegl_node_new_child (graph,
+                                               "operation", "gegl:buffer-source",
+                                               "buffer",    mask,
+                                               NULL),
+                          "output", node, "aux2");
+
+  output = gegl_node_new_child (graph,
+                                "operation", "gegl:write-buffer",
+                                "buffer",    dest,
+                                NULL);
+
+  gegl_node_connect_to (node, "output", output, "input");
+
+  for (i = 0; i < iterations; i++)
+    {
+      GTimer *timer = g_timer_new ();
+
+      gegl_node_process (output);
+
+      best = MIN (best, g_timer_elapsed (timer, NULL));
+
+      g_timer_destroy (timer);
+    }
+
+  g_object_unref (graph);
+  g_object_unref (dest);
+
+  return best;
+}
+
+static void
+benchmark_graphs (const Babl  *format,
+                  const gchar *format_name)
+{
+  GRand      *rand = g_rand_new_with_seed (42);
+  GeglBuffer *mask;
+  gint        i, j;
+
+  g_print ("\nGEGL graphs (%dx%d %s)\n\n", size, size, format_name);
+
+  {
+    GeglRectangle  rect     = { 0, 0, size, size };
+    gint           n_pixels = size * size;
+    gfloat        *pixels   = g_new (gfloat, n_pixels);
+
+    for (i = 0; i < n_pixels; i++)
+      pixels[i] = g_rand_double (rand);
+
+    mask = gegl_buffer_new (&rect, babl_format ("Y float"));
+    gegl_buffer_set (mask, &rect, 0, babl_format ("Y float"),
+                     pixels, GEGL_AUTO_ROWSTRIDE);
+
+    g_free (pixels);
+  }
+
+  for (j = 0; j < G_N_ELEMENTS (variants); j++)
+    {
+      const Variant *variant = &variants[j];
+      GeglBuffer    *input   = create_buffer (format, variant->opaque, rand);
+      GeglBuffer    *aux     = create_buffer (format, variant->opaque, rand);
+
+      for (i = 0; i < G_N_ELEMENTS (layer_modes); i++)
+        {
+          const LayerMode *mode = &layer_modes[i];
+          gchar           *operation;
+          GeglNode        *node;
+
+          if (! benchmark_selected (mode->name))
+            continue;
+
+          operation = g_strdup_printf ("gimp:%s-mode", mode->name);
+
+          node = gegl_node_new ();
+          gegl_node_set (node,
+                         "operation", operation,
+                         "opacity",   (gdouble) variant->opacity,
+                         NULL);
+
+          benchmark_report (operation, "graph", variant->name,
+                            benchmark_node (node, input, aux,
+                                            variant->use_mask ? mask : NULL));
+
+          g_object_unref (node);
+          g_free (operation);
+        }
+
+      /*  point filters only care about the input's alpha  */
+      if (variant->opacity == 1.0 && ! variant->use_mask)
+        {
+          for (i = 0; i < G_N_ELEMENTS (point_filters); i++)
+            {
+              const PointFilter *point = &point_filters[i];
+              GObject           *config;
+              GeglNode          *node;
+
+              if (! benchmark_selected (point->operation))
+                continue;
+
+              config = g_object_new (point->config_type (), NULL);
+
+              node = gegl_node_new ();
+              gegl_node_set (node,
+                             "operation", point->operation,
+                             "config",    config,
+                             NULL);
+
+              benchmark_report (point->operation, "graph", variant->name,
+                                benchmark_node (node, input, NULL, NULL));
+
+              g_object_unref (node);
+              g_object_unref (config);
+            }
+        }
+
+      g_object_unref (input);
+      g_object_unref (aux);
+    }
+
+  g_object_unref (mask);
+
+  g_rand_free (rand);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  GOptionContext *context;
+  GError         *error = NULL;
+
+  context = g_option_context_new ("- benchmark GIMP layer modes and filters");
+  g_option_context_add_main_entries (context, entries, NULL);
+  g_option_context_add_group (context, gegl_get_option_group ());
+
+  if (! g_option_context_parse (context, &argc, &argv, &error))
+    {
+      g_printerr ("%s\n", error->message);
+      g_clear_error (&error);
+
+      return 1;
+    }
+
+  g_option_context_free (context);
+
+  size       = MAX (size, 1);
+  iterations = MAX (iterations, 1);
+
+  gegl_init (&argc, &argv);
+  gimp_operations_init ();
+
+  benchmark_layer_mode_funcs ();
+
+  benchmark_graphs (babl_format ("RGBA float"),  "RGBA float");
+  benchmark_graphs (babl_format ("R'G'B'A u8"),  "R'G'B'A u8");
+
+  gegl_exit ();
+
+  return 0;
+}
@@ -0,0 +1,132 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimpbrushcore-loops-sse2.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <glib-object.h>
+
+#include "gimpbrushcore-kernels.h"
+#include "gimpbrushcore-loops.h"
+
+#if COMPILE_SSE2_INTRINISICS
+/* SSE2 */
+#include <emmintrin.h>
+
+
+/*  The subsample kernels sum up to 256 and the bias is at most 128,
+ *  so every intermediate sum fits into 16 unsigned bits and eight
+ *  pixels can be weighted per SSE2 multiply.
+ */
+
+void
+gimp_brush_core_subsample_row_sse2 (const guchar * const *rows,
+                                    const gint           *kernel,
+                                    guchar               *dest,
+                                    gint                  width,
+                                    guint                 bias)
+{
+  const __m128i zero   = _mm_setzero_si128 ();
+  const __m128i v_bias = _mm_set1_epi16 (bias);
+  gint          x      = 0;
+
+  for (; x + 16 <= width; x += 16)
+    {
+      __m128i lo = v_bias;
+      __m128i hi = v_bias;
+      gint    r, c;
+
+      for (r = 0; r < KERNEL_HEIGHT; r++)
+        {
+          const guchar *s = rows[r] + x + KERNEL_WIDTH - 1;
+
+          for (c = 0; c < KERNEL_WIDTH; c++)
+            {
+              const gint k = kernel[r * KERNEL_WIDTH + c];
+              __m128i    v_k;
+              __m128i    v;
+
+              if (! k)
+                continue;
+
+              v_k = _mm_set1_epi16 (k);
+              v   = _mm_loadu_si128 ((const __m128i *) (s - c));
+
+              lo = _mm_add_epi16 (lo,
+                                  _mm_mullo_epi16 (_mm_unpacklo_epi8 (v, zero),
+                                                   v_k));
+              hi = _mm_add_epi16 (hi,
+                                  _mm_mullo_epi16 (_mm_unpackhi_epi8 (v, zero),
+                                                   v_k));
+            }
+        }
+
+      lo = _mm_srli_epi16 (lo, 8);
+      hi = _mm_srli_epi16 (hi, 8);
+
+      _mm_storeu_si128 ((__m128i *) (dest + x), _mm_packus_epi16 (lo, hi));
+    }
+
+  if (x < width)
+    {
+      const guchar *tail_rows[KERNEL_HEIGHT];
+      gint          r;
+
+      for (r = 0; r < KERNEL_HEIGHT; r++)
+        tail_rows[r] = rows[r] + x;
+
+      gimp_brush_core_subsample_row_generic (tail_rows, kernel,
+                                             dest + x, width - x, bias);
+    }
+}
+
+void
+gimp_brush_core_solidify_row_sse2 (const guchar *src,
+                                   gfloat       *dest,
+                                   gint          width)
+{
+  const __m128i zero = _mm_setzero_si128 ();
+  const __m128  one  = _mm_set1_ps (1.0f);
+  gint          x    = 0;
+
+  for (; x + 16 <= width; x += 16)
+    {
+      __m128i v, is_zero, lo, hi;
+
+      v       = _mm_loadu_si128 ((const __m128i *) (src + x));
+      is_zero = _mm_cmpeq_epi8 (v, zero);
+
+      /*  widen the byte masks to dword masks  */
+      lo = _mm_unpacklo_epi8 (is_zero, is_zero);
+      hi = _mm_unpackhi_epi8 (is_zero, is_zero);
+
+      _mm_storeu_ps (dest + x,
+                     _mm_andnot_ps ((__m128) _mm_unpacklo_epi16 (lo, lo), one));
+      _mm_storeu_ps (dest + x + 4,
+                     _mm_andnot_ps ((__m128) _mm_unpackhi_epi16 (lo, lo), one));
+      _mm_storeu_ps (dest + x + 8,
+                     _mm_andnot_ps ((__m128) _mm_unpacklo_epi16 (hi, hi), one));
+      _mm_storeu_ps (dest + x + 12,
+                     _mm_andnot_ps ((__m128) _mm_unpackhi_epi16 (hi, hi), one));
+    }
+
+  if (x < width)
+    gimp_brush_core_solidify_row_generic (src + x, dest + x, width - x);
+}
+
+#endif /* COMPILE_SSE2_INTRINISICS */
@@ -0,0 +1,62 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimpbrushcore-loops.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <glib-object.h>
+
+#include "gimpbrushcore-kernels.h"
+#include "gimpbrushcore-loops.h"
+
+
+void
+gimp_brush_core_subsample_row_generic (const guchar * const *rows,
+                                       const gint           *kernel,
+                                       guchar               *dest,
+                                       gint                  width,
+                                       guint                 bias)
+{
+  gint x;
+
+  for (x = 0; x < width; x++)
+    {
+      const gint *k   = kernel;
+      guint       sum = bias;
+      gint        r, c;
+
+      for (r = 0; r < KERNEL_HEIGHT; r++)
+        {
+          const guchar *s = rows[r] + x + KERNEL_WIDTH - 1;
+
+          for (c = 0; c < KERNEL_WIDTH; c++)
+            sum += s[-c] * *k++;
+        }
+
+      dest[x] = sum / KERNEL_SUM;
+    }
+}
+
+void
+gimp_brush_core_solidify_row_generic (const guchar *src,
+                                      gfloat       *dest,
+                                      gint          width)
+{
+  while (width--)
+    *dest++ = (*src++) ? 1.0 : 0.0;
+}
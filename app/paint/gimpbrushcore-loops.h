@@ -0,0 +1,62 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimpbrushcore-loops.h
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GIMP_BRUSH_CORE_LOOPS_H__
+#define __GIMP_BRUSH_CORE_LOOPS_H__
+
+
+/*  computes one row of a subsampled brush mask: @rows[r] is the
+ *  source row weighted by row r of the KERNEL_WIDTH x KERNEL_HEIGHT
+ *  @kernel, starting KERNEL_WIDTH - 1 pixels left of @dest's first
+ *  pixel; @rows must be readable for @width + KERNEL_WIDTH - 1 pixels
+ */
+typedef void (* GimpBrushCoreSubsampleRowFunc) (const guchar * const *rows,
+                                                const gint           *kernel,
+                                                guchar               *dest,
+                                                gint                  width,
+                                                guint                 bias);
+
+/*  converts a row of mask pixels to 1.0 where they are set and to 0.0
+ *  where they are not
+ */
+typedef void (* GimpBrushCoreSolidifyRowFunc)  (const guchar         *src,
+                                                gfloat               *dest,
+                                                gint                  width);
+
+
+void   gimp_brush_core_subsample_row_generic (const guchar * const *rows,
+                                              const gint           *kernel,
+                                              guchar               *dest,
+                                              gint                  width,
+                                              guint                 bias);
+void   gimp_brush_core_subsample_row_sse2    (const guchar * const *rows,
+                                              const gint           *kernel,
+                                              guchar               *dest,
+                                              gint                  width,
+                                              guint                 bias);
+
+void   gimp_brush_core_solidify_row_generic  (const guchar         *src,
+                                              gfloat               *dest,
+                                              gint                  width);
+void   gimp_brush_core_solidify_row_sse2     (const guchar         *src,
+                                              gfloat               *dest,
+                                              gint                  width);
+
+
+#endif  /*  __GIMP_BRUSH_CORE_LOOPS_H__  */
@@ -22,6 +22,7 @@
 #include <gdk-pixbuf/gdk-pixbuf.h>
 #include <gegl.h>
 
+#include "libgimpbase/gimpbase.h"
 #include "libgimpmath/gimpmath.h"
 
 #include "paint-types.h"
@@ -39,6 +40,7 @@
 
 #include "gimpbrushcore.h"
 #include "gimpbrushcore-kernels.h"
+#include "gimpbrushcore-loops.h"
 
 #include "gimppaintoptions.h"
 
@@ -47,6 +49,13 @@
 
 #define EPSILON  0.00001
 
+/*  quantization of dynamically transformed brushes  */
+#define SIZE_QUANTUM       0.25           /*  in pixels               */
+#define SIZE_REL_QUANTUM   (1.0 / 256.0)  /*  of the brush size       */
+#define ANGLE_STEPS        1024.0         /*  per full turn           */
+#define ASPECT_RATIO_STEPS 64.0
+#define HARDNESS_STEPS     256.0
+
 enum
 {
   SET_BRUSH,
@@ -134,6 +143,25 @@ G_DEFINE_TYPE (GimpBrushCore, gimp_brush_core, GIMP_TYPE_PAINT_CORE)
 
 static guint core_signals[LAST_SIGNAL] = { 0, };
 
+static GimpBrushCoreSubsampleRowFunc gimp_brush_core_subsample_row = NULL;
+static GimpBrushCoreSolidifyRowFunc  gimp_brush_core_solidify_row  = NULL;
+
+static const GimpCpuAccelKernel gimp_brush_core_subsample_row_kernels[] =
+{
+#if COMPILE_SSE2_INTRINISICS
+  { GIMP_CPU_ACCEL_X86_SSE2, G_CALLBACK (gimp_brush_core_subsample_row_sse2) },
+#endif
+  { GIMP_CPU_ACCEL_NONE,     G_CALLBACK (gimp_brush_core_subsample_row_generic) }
+};
+
+static const GimpCpuAccelKernel gimp_brush_core_solidify_row_kernels[] =
+{
+#if COMPILE_SSE2_INTRINISICS
+  { GIMP_CPU_ACCEL_X86_SSE2, G_CALLBACK (gimp_brush_core_solidify_row_sse2) },
+#endif
+  { GIMP_CPU_ACCEL_NONE,     G_CALLBACK (gimp_brush_core_solidify_row_generic) }
+};
+
 
 static void
 gimp_brush_core_class_init (GimpBrushCoreClass *klass)
@@ -172,9 +200,17 @@ gimp_brush_core_class_init (GimpBrushCoreClass *klass)
   klass->handles_changing_brush             = FALSE;
   klass->handles_transforming_brush         = TRUE;
   klass->handles_dynamic_transforming_brush = TRUE;
+  klass->handles_batched_pastes             = FALSE;
 
   klass->set_brush                          = gimp_brush_core_real_set_brush;
   klass->set_dynamics                       = gimp_brush_core_real_set_dynamics;
+
+  gimp_brush_core_subsample_row =
+    (GimpBrushCoreSubsampleRowFunc)
+    GIMP_CPU_ACCEL_SELECT (gimp_brush_core_subsample_row_kernels);
+  gimp_brush_core_solidify_row =
+    (GimpBrushCoreSolidifyRowFunc)
+    GIMP_CPU_ACCEL_SELECT (gimp_brush_core_solidify_row_kernels);
 }
 
 static void
@@ -485,6 +521,7 @@ gimp_brush_core_interpolate (GimpPaintCore    *paint_core,
   gdouble             dyn_spacing = core->spacing;
   gdouble             fade_point;
   gboolean            use_dyn_spacing;
+  gboolean            batch;
 
   g_return_if_fail (GIMP_IS_BRUSH (core->brush));
 
@@ -732,6 +769,13 @@ gimp_brush_core_interpolate (GimpPaintCore    *paint_core,
         }
     }
 
+  /*  composite all dabs of this segment at once  */
+  batch = (num_points > 1 &&
+           GIMP_BRUSH_CORE_GET_CLASS (core)->handles_batched_pastes);
+
+  if (batch)
+    gimp_paint_core_begin_batch (paint_core);
+
   for (n = 0; n < num_points; n++)
     {
       gdouble t = t0 + n * dt;
@@ -788,6 +832,9 @@ gimp_brush_core_interpolate (GimpPaintCore    *paint_core,
                              GIMP_PAINT_STATE_MOTION, time);
     }
 
+  if (batch)
+    gimp_paint_core_end_batch (paint_core, drawable);
+
   current_coords.x        = last_coords.x        + delta_vec.x;
   current_coords.y        = last_coords.y        + delta_vec.y;
   current_coords.pressure = last_coords.pressure + delta_pressure;
@@ -849,10 +896,11 @@ gimp_brush_core_get_paint_buffer (GimpPaintCore    *paint_core,
       GimpTempBuf *temp_buf;
       const Babl  *format;
 
-      if (gimp_drawable_get_linear (drawable))
-        format = babl_format ("RGBA float");
-      else
-        format = babl_format ("R'G'B'A float");
+      format = gimp_babl_format (GIMP_RGB,
+                                 gimp_drawable_get_linear (drawable) ?
+                                 GIMP_PRECISION_FLOAT_LINEAR :
+                                 GIMP_PRECISION_FLOAT_GAMMA,
+                                 TRUE);
 
       if (paint_core->paint_buffer                                       &&
           gegl_buffer_get_width  (paint_core->paint_buffer) == (x2 - x1) &&
@@ -1054,21 +1102,6 @@ gimp_brush_core_invalidate_cache (GimpBrush     *brush,
  *             LOCAL FUNCTION DEFINITIONS                   *
  ************************************************************/
 
-static inline void
-rotate_pointers (gulong  **p,
-                 guint32   n)
-{
-  guint32  i;
-  gulong  *tmp;
-
-  tmp = p[0];
-
-  for (i = 0; i < n-1; i++)
-    p[i] = p[i+1];
-
-  p[i] = tmp;
-}
-
 static const GimpTempBuf *
 gimp_brush_core_subsample_mask (GimpBrushCore     *core,
                                 const GimpTempBuf *mask,
@@ -1079,16 +1112,15 @@ gimp_brush_core_subsample_mask (GimpBrushCore     *core,
   gdouble       left;
   const guchar *m;
   guchar       *d;
-  const gint   *k;
+  guchar       *padded;
+  gint          padded_stride;
   gint          index1;
   gint          index2;
   gint          dest_offset_x = 0;
   gint          dest_offset_y = 0;
   const gint   *kernel;
   gint          i, j;
-  gint          r, s;
-  gulong       *accum[KERNEL_HEIGHT];
-  gint          offs;
+  gint          r;
   gint          mask_width  = gimp_temp_buf_get_width  (mask);
   gint          mask_height = gimp_temp_buf_get_height (mask);
   gint          dest_width;
@@ -1160,51 +1192,46 @@ gimp_brush_core_subsample_mask (GimpBrushCore     *core,
   dest_width  = gimp_temp_buf_get_width  (dest);
   dest_height = gimp_temp_buf_get_height (dest);
 
-  /* Allocate and initialize the accum buffer */
-  for (i = 0; i < KERNEL_HEIGHT ; i++)
-    accum[i] = g_new0 (gulong, dest_width + 1);
-
   core->subsample_brushes[index2][index1] = dest;
 
+  /*  copy the mask into a buffer with a zero border wide enough for
+   *  every dest pixel to be gathered from a full 3x3 neighbourhood,
+   *  the mask starts KERNEL_HEIGHT - 1 rows and KERNEL_WIDTH pixels
+   *  into it
+   */
+  padded_stride = dest_width + KERNEL_WIDTH;
+  padded = g_new0 (guchar, (mask_height + 2 * (KERNEL_HEIGHT - 1)) *
+                           padded_stride);
+
   m = gimp_temp_buf_get_data (mask);
   for (i = 0; i < mask_height; i++)
     {
-      for (j = 0; j < mask_width; j++)
-        {
-          k = kernel;
-          for (r = 0; r < KERNEL_HEIGHT; r++)
-            {
-              offs = j + dest_offset_x;
-              s = KERNEL_WIDTH;
-              while (s--)
-                accum[r][offs++] += *m * *k++;
-            }
-          m++;
-        }
-
-      /* store the accum buffer into the destination mask */
-      d = gimp_temp_buf_get_data (dest) + (i + dest_offset_y) * dest_width;
-      for (j = 0; j < dest_width; j++)
-        *d++ = (accum[0][j] + 127) / KERNEL_SUM;
-
-      rotate_pointers (accum, KERNEL_HEIGHT);
-
-      memset (accum[KERNEL_HEIGHT - 1], 0, sizeof (gulong) * dest_width);
+      memcpy (padded + (i + KERNEL_HEIGHT - 1) * padded_stride + KERNEL_WIDTH,
+              m, mask_width);
+      m += mask_width;
     }
 
-  /* store the rest of the accum buffer into the dest mask */
-  while (i + dest_offset_y < dest_height)
+  /*  dest row (i + dest_offset_y) gathers mask rows i - r, weighted by
+   *  kernel row r; rows which still get contributions from the mask's
+   *  last row are rounded slightly down, like they always were
+   */
+  for (i = 0; i + dest_offset_y < dest_height; i++)
     {
+      const guchar *rows[KERNEL_HEIGHT];
+
+      for (r = 0; r < KERNEL_HEIGHT; r++)
+        rows[r] = (padded +
+                   (i - r + KERNEL_HEIGHT - 1) * padded_stride +
+                   (1 - dest_offset_x));
+
       d = gimp_temp_buf_get_data (dest) + (i + dest_offset_y) * dest_width;
-      for (j = 0; j < dest_width; j++)
-        *d++ = (accum[0][j] + (KERNEL_SUM / 2)) / KERNEL_SUM;
 
-      rotate_pointers (accum, KERNEL_HEIGHT);
-      i++;
+      gimp_brush_core_subsample_row (rows, kernel, d, dest_width,
+                                     i < mask_height ?
+                                     KERNEL_SUM / 2 - 1 : KERNEL_SUM / 2);
     }
 
-  for (i = 0; i < KERNEL_HEIGHT ; i++)
-    g_free (accum[i]);
+  g_free (padded);
 
   return dest;
 }
@@ -1396,10 +1423,10 @@ gimp_brush_core_solidify_mask (GimpBrushCore     *core,
 
   for (i = 0; i < brush_mask_height; i++)
     {
-      for (j = 0; j < brush_mask_width; j++)
-        *d++ = (*m++) ? 1.0 : 0.0;
+      gimp_brush_core_solidify_row (m, d, brush_mask_width);
 
-      d += 2;
+      m += brush_mask_width;
+      d += brush_mask_width + 2;
     }
 
   return dest;
@@ -1579,6 +1606,32 @@ gimp_brush_core_eval_transform_dynamics (GimpBrushCore     *core,
           else
             core->aspect_ratio *= dyn_aspect;
         }
+
+      /*  quantize the dynamic transform, so the brush's transform
+       *  caches get hits when e.g. pressure varies only slightly
+       */
+      if (core->main_brush && core->scale > 0.0)
+        {
+          gdouble max_side;
+          gdouble size;
+          gdouble step;
+
+          max_side = MAX (gimp_brush_get_width  (core->main_brush),
+                          gimp_brush_get_height (core->main_brush));
+
+          size = core->scale * max_side;
+          step = MAX (SIZE_QUANTUM, size * SIZE_REL_QUANTUM);
+
+          core->scale = MAX (RINT (size / step) * step,
+                             SIZE_QUANTUM) / max_side;
+        }
+
+      core->angle =
+        RINT (core->angle * ANGLE_STEPS) / ANGLE_STEPS;
+      core->aspect_ratio =
+        RINT (core->aspect_ratio * ASPECT_RATIO_STEPS) / ASPECT_RATIO_STEPS;
+      core->hardness =
+        RINT (core->hardness * HARDNESS_STEPS) / HARDNESS_STEPS;
     }
 }
 
@@ -1637,7 +1690,9 @@ gimp_brush_core_color_area_with_pixmap (GimpBrushCore            *core,
   offsety = area_y - uly;
 
   iter = gegl_buffer_iterator_new (area, NULL, 0,
-                                   babl_format ("RGBA float"),
+                                   gimp_babl_format (GIMP_RGB,
+                                                     GIMP_PRECISION_FLOAT_LINEAR,
+                                                     TRUE),
                                    GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
   roi = &iter->roi[0];
 
@@ -1701,9 +1756,12 @@ gimp_brush_core_paint_line_pixmap_mask (GimpDrawable             *drawable,
       guchar       *l        = line_buf;
       gint          i;
 
-      fish = babl_fish (gimp_babl_format (pixmap_base_type, pixmap_precision,
-                                          TRUE),
-                        babl_format ("RGBA float"));
+      fish = gimp_babl_fish (gimp_babl_format (pixmap_base_type,
+                                               pixmap_precision,
+                                               TRUE),
+                             gimp_babl_format (GIMP_RGB,
+                                               GIMP_PRECISION_FLOAT_LINEAR,
+                                               TRUE));
 
       /* put the source pixmap's pixels, plus the mask's alpha, into
        * one line, so we can use one single call to babl_process() to
@@ -1730,7 +1788,10 @@ gimp_brush_core_paint_line_pixmap_mask (GimpDrawable             *drawable,
       guchar     *l        = line_buf;
       gint        i;
 
-      fish = babl_fish (pixmap_format, babl_format ("RGBA float"));
+      fish = gimp_babl_fish (pixmap_format,
+                             gimp_babl_format (GIMP_RGB,
+                                               GIMP_PRECISION_FLOAT_LINEAR,
+                                               TRUE));
 
       /* put the source pixmap's pixels into one line, so we can use
        * one single call to babl_process() to convert the entire line
@@ -84,6 +84,11 @@ struct _GimpBrushCoreClass
   /*  Set for tools that don't mind if the brush scales mid stroke  */
   gboolean            handles_dynamic_transforming_brush;
 
+  /*  Set for tools whose dabs don't depend on the pixels painted
+   *  earlier in the stroke, so their pastes can be batched
+   */
+  gboolean            handles_batched_pastes;
+
   void (* set_brush)    (GimpBrushCore *core,
                          GimpBrush     *brush);
   void (* set_dynamics) (GimpBrushCore *core,
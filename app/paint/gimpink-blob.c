@@ -20,6 +20,8 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include <glib-object.h>
 
 #include "libgimpmath/gimpmath.h"
@@ -37,10 +39,21 @@ typedef enum
 } EdgeType;
 
 
+/*  the per-row edge flags of blobs up to this height live on the
+ *  stack, so that building a blob for every dab doesn't hit the
+ *  allocator more often than needed
+ */
+#define PRESENT_STACK_SIZE 1024
+
+
 /*  local function prototypes  */
 
 static GimpBlob * gimp_blob_new            (gint      y,
                                             gint      height);
+static EdgeType * gimp_blob_present_new    (gint      height,
+                                            EdgeType *stack_present);
+static void       gimp_blob_present_free   (EdgeType *present,
+                                            EdgeType *stack_present);
 static void       gimp_blob_fill           (GimpBlob *b,
                                             EdgeType *present);
 static void       gimp_blob_make_convex    (GimpBlob *b,
@@ -68,6 +81,7 @@ gimp_blob_polygon (GimpBlobPoint *points,
 {
   GimpBlob *result;
   EdgeType *present;
+  EdgeType  stack_present[PRESENT_STACK_SIZE];
   gint      i;
   gint      im1;
   gint      ip1;
@@ -85,7 +99,7 @@ gimp_blob_polygon (GimpBlobPoint *points,
     }
 
   result = gimp_blob_new (ymin, ymax - ymin + 1);
-  present = g_new0 (EdgeType, result->height);
+  present = gimp_blob_present_new (result->height, stack_present);
 
   im1 = n_points - 1;
   i = 0;
@@ -139,7 +153,7 @@ gimp_blob_polygon (GimpBlobPoint *points,
     }
 
   gimp_blob_fill (result, present);
-  g_free (present);
+  gimp_blob_present_free (present, stack_present);
 
   return result;
 }
@@ -254,6 +268,7 @@ gimp_blob_ellipse (gdouble xc,
 {
   GimpBlob *result;
   EdgeType *present;
+  EdgeType  stack_present[PRESENT_STACK_SIZE];
   gint      i;
   gdouble   r1, r2;
   gint      maxy, miny;
@@ -287,7 +302,7 @@ gimp_blob_ellipse (gdouble xc,
   miny = floor (yc - fabs (yp) - fabs (yq));
 
   result = gimp_blob_new (miny, maxy - miny + 1);
-  present = g_new0 (EdgeType, result->height);
+  present = gimp_blob_present_new (result->height, stack_present);
 
   xc_base = floor (xc);
   yc_base = floor (yc);
@@ -354,7 +369,7 @@ gimp_blob_ellipse (gdouble xc,
   /* Now fill in missing points */
 
   gimp_blob_fill (result, present);
-  g_free (present);
+  gimp_blob_present_free (present, stack_present);
 
   return result;
 }
@@ -408,6 +423,7 @@ gimp_blob_convex_union (GimpBlob *b1,
   gint      y;
   gint      i, j;
   EdgeType *present;
+  EdgeType  stack_present[PRESENT_STACK_SIZE];
 
   /* Create the storage for the result */
 
@@ -417,7 +433,7 @@ gimp_blob_convex_union (GimpBlob *b1,
   if (result->height == 0)
     return result;
 
-  present = g_new0 (EdgeType, result->height);
+  present = gimp_blob_present_new (result->height, stack_present);
 
   /* Initialize spans from original objects */
 
@@ -453,7 +469,7 @@ gimp_blob_convex_union (GimpBlob *b1,
 
   gimp_blob_make_convex (result, present);
 
-  g_free (present);
+  gimp_blob_present_free (present, stack_present);
 
   return result;
 }
@@ -502,6 +518,28 @@ gimp_blob_new (gint y,
   return result;
 }
 
+static EdgeType *
+gimp_blob_present_new (gint      height,
+                       EdgeType *stack_present)
+{
+  if (height <= PRESENT_STACK_SIZE)
+    {
+      memset (stack_present, 0, height * sizeof (EdgeType));
+
+      return stack_present;
+    }
+
+  return g_new0 (EdgeType, height);
+}
+
+static void
+gimp_blob_present_free (EdgeType *present,
+                        EdgeType *stack_present)
+{
+  if (present != stack_present)
+    g_free (present);
+}
+
 static void
 gimp_blob_fill (GimpBlob *b,
                 EdgeType *present)
@@ -28,6 +28,7 @@
 
 #include "gegl/gimp-gegl-utils.h"
 
+#include "core/gimp-parallel.h"
 #include "core/gimpdrawable.h"
 #include "core/gimpimage.h"
 #include "core/gimpimage-undo.h"
@@ -43,6 +44,17 @@
 
 #define SUBSAMPLE 8
 
+/*  the smallest area worth rendering in a thread of its own  */
+#define MIN_PARALLEL_SUB_SIZE 64
+#define MIN_PARALLEL_SUB_AREA (MIN_PARALLEL_SUB_SIZE * MIN_PARALLEL_SUB_SIZE)
+
+
+typedef struct
+{
+  GeglBuffer *buffer;
+  GimpBlob   *blob;
+} RenderBlobData;
+
 
 /*  local function prototypes  */
 
@@ -81,6 +93,8 @@ static GimpBlob   * ink_pen_ellipse           (GimpInkOptions   *options,
 static void         render_blob               (GeglBuffer       *buffer,
                                                GeglRectangle    *rect,
                                                GimpBlob         *blob);
+static void         render_blob_area          (const GeglRectangle *area,
+                                               RenderBlobData      *data);
 
 
 G_DEFINE_TYPE (GimpInk, gimp_ink, GIMP_TYPE_PAINT_CORE)
@@ -654,11 +668,28 @@ static void
 render_blob (GeglBuffer    *buffer,
              GeglRectangle *rect,
              GimpBlob      *blob)
+{
+  RenderBlobData data;
+
+  data.buffer = buffer;
+  data.blob   = blob;
+
+  /*  the rows of the blob are independent, render them in parallel  */
+  gimp_parallel_distribute_area (rect, MIN_PARALLEL_SUB_AREA,
+                                 (GimpParallelDistributeAreaFunc)
+                                 render_blob_area,
+                                 &data);
+}
+
+static void
+render_blob_area (const GeglRectangle *area,
+                  RenderBlobData      *data)
 {
   GeglBufferIterator *iter;
   GeglRectangle      *roi;
 
-  iter = gegl_buffer_iterator_new (buffer, rect, 0, babl_format ("Y float"),
+  iter = gegl_buffer_iterator_new (data->buffer, area, 0,
+                                   babl_format ("Y float"),
                                    GEGL_ACCESS_READWRITE, GEGL_ABYSS_NONE);
   roi = &iter->roi[0];
 
@@ -670,7 +701,7 @@ render_blob (GeglBuffer    *buffer,
 
       for (y = 0; y < h; y++, d += roi->width * 1)
         {
-          render_blob_line (blob, d, roi->x, roi->y + y, roi->width);
+          render_blob_line (data->blob, d, roi->x, roi->y + y, roi->width);
         }
     }
 }
@@ -35,6 +35,7 @@
 #include "paint-types.h"
 
 #include "gegl/gimp-gegl-utils.h"
+#include "gegl/gimptilehandlervalidate.h"
 
 #include "config/gimpguiconfig.h" /* playground */
 
@@ -59,18 +60,19 @@ struct _GimpMybrushPrivate
 
 /*  local function prototypes  */
 
-static void   gimp_mybrush_paint  (GimpPaintCore    *paint_core,
-                                   GimpDrawable     *drawable,
-                                   GimpPaintOptions *paint_options,
-                                   const GimpCoords *coords,
-                                   GimpPaintState    paint_state,
-                                   guint32           time);
-static void   gimp_mybrush_motion (GimpPaintCore    *paint_core,
-                                   GimpDrawable     *drawable,
-                                   GimpPaintOptions *paint_options,
-                                   const GimpCoords *coords,
-                                   guint32           time);
-
+static void         gimp_mybrush_paint              (GimpPaintCore    *paint_core,
+                                                     GimpDrawable     *drawable,
+                                                     GimpPaintOptions *paint_options,
+                                                     const GimpCoords *coords,
+                                                     GimpPaintState    paint_state,
+                                                     guint32           time);
+static GeglBuffer * gimp_mybrush_surface_buffer_new (GimpMybrush      *mybrush,
+                                                     GimpDrawable     *drawable);
+static void         gimp_mybrush_motion             (GimpPaintCore    *paint_core,
+                                                     GimpDrawable     *drawable,
+                                                     GimpPaintOptions *paint_options,
+                                                     const GimpCoords *coords,
+                                                     guint32           time);
 
 G_DEFINE_TYPE (GimpMybrush, gimp_mybrush, GIMP_TYPE_PAINT_CORE)
 
@@ -125,13 +127,7 @@ gimp_mybrush_paint (GimpPaintCore    *paint_core,
     case GIMP_PAINT_STATE_INIT:
       mybrush->private->surface = mypaint_gegl_tiled_surface_new ();
 
-      buffer = mypaint_gegl_tiled_surface_get_buffer (mybrush->private->surface);
-      buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0,
-                                                gimp_item_get_width (GIMP_ITEM (drawable)),
-                                                gimp_item_get_height (GIMP_ITEM (drawable))),
-                                gegl_buffer_get_format (buffer));
-      gegl_buffer_copy (gimp_drawable_get_buffer (drawable), NULL,
-                        buffer, NULL);
+      buffer = gimp_mybrush_surface_buffer_new (mybrush, drawable);
       mypaint_gegl_tiled_surface_set_buffer (mybrush->private->surface, buffer);
       g_object_unref (buffer);
 
@@ -170,6 +166,43 @@ gimp_mybrush_paint (GimpPaintCore    *paint_core,
     }
 }
 
+/*  the surface's tiles are converted from the drawable only when
+ *  libmypaint first requests them, instead of copying the whole
+ *  drawable when the stroke starts
+ */
+static GeglBuffer *
+gimp_mybrush_surface_buffer_new (GimpMybrush  *mybrush,
+                                 GimpDrawable *drawable)
+{
+  GeglBuffer      *buffer;
+  GeglNode        *source;
+  GeglTileHandler *handler;
+  gint             width  = gimp_item_get_width  (GIMP_ITEM (drawable));
+  gint             height = gimp_item_get_height (GIMP_ITEM (drawable));
+
+  buffer = mypaint_gegl_tiled_surface_get_buffer (mybrush->private->surface);
+  buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0, width, height),
+                            gegl_buffer_get_format (buffer));
+
+  source = gegl_node_new_child (NULL,
+                                "operation", "gegl:buffer-source",
+                                "buffer",    gimp_drawable_get_buffer (drawable),
+                                NULL);
+
+  handler = gimp_tile_handler_validate_new (source);
+  g_object_unref (source);
+
+  gimp_tile_handler_validate_assign (GIMP_TILE_HANDLER_VALIDATE (handler),
+                                     buffer);
+  gimp_tile_handler_validate_invalidate (GIMP_TILE_HANDLER_VALIDATE (handler),
+                                         0, 0, width, height);
+
+  /*  the buffer keeps the handler alive  */
+  g_object_unref (handler);
+
+  return buffer;
+}
+
 static void
 gimp_mybrush_motion (GimpPaintCore    *paint_core,
                      GimpDrawable     *drawable,
@@ -229,9 +262,6 @@ gimp_mybrush_motion (GimpPaintCore    *paint_core,
   mypaint_surface_end_atomic ((MyPaintSurface *) mybrush->private->surface,
                               &rect);
 
-  g_printerr ("painted rect: %d %d %d %d\n",
-              rect.x, rect.y, rect.width, rect.height);
-
   if (rect.width > 0 && rect.height > 0)
     {
       GeglBuffer *src;
@@ -75,6 +75,7 @@ gimp_paintbrush_class_init (GimpPaintbrushClass *klass)
   paint_core_class->paint                  = gimp_paintbrush_paint;
 
   brush_core_class->handles_changing_brush = TRUE;
+  brush_core_class->handles_batched_pastes = TRUE;
 }
 
 static void
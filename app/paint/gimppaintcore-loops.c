@@ -22,6 +22,8 @@
 
 #include "paint-types.h"
 
+#include "gegl/gimp-babl.h"
+
 #include "core/gimptempbuf.h"
 #include "gimppaintcore-loops.h"
 #include "operations/gimplayermodefunctions.h"
@@ -298,10 +300,11 @@ do_layer_blend (GeglBuffer  *src_buffer,
 
   GimpLayerModeFunction apply_func = get_layer_mode_function (paint_mode);
 
-  if (linear_mode)
-    iterator_format = babl_format ("RGBA float");
-  else
-    iterator_format = babl_format ("R'G'B'A float");
+  iterator_format = gimp_babl_format (GIMP_RGB,
+                                      linear_mode ?
+                                      GIMP_PRECISION_FLOAT_LINEAR :
+                                      GIMP_PRECISION_FLOAT_GAMMA,
+                                      TRUE);
 
   roi.x = x_offset;
   roi.y = y_offset;
@@ -378,10 +381,11 @@ mask_components_onto (GeglBuffer        *src_buffer,
   GeglBufferIterator *iter;
   const Babl         *iterator_format;
 
-  if (linear_mode)
-    iterator_format = babl_format ("RGBA float");
-  else
-    iterator_format = babl_format ("R'G'B'A float");
+  iterator_format = gimp_babl_format (GIMP_RGB,
+                                      linear_mode ?
+                                      GIMP_PRECISION_FLOAT_LINEAR :
+                                      GIMP_PRECISION_FLOAT_GAMMA,
+                                      TRUE);
 
   iter = gegl_buffer_iterator_new (dst_buffer, roi, 0,
                                    iterator_format,
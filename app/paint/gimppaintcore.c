@@ -28,6 +28,7 @@
 
 #include "paint-types.h"
 
+#include "gegl/gimp-babl.h"
 #include "gegl/gimp-gegl-loops.h"
 #include "gegl/gimp-gegl-nodes.h"
 #include "gegl/gimp-gegl-utils.h"
@@ -109,6 +110,19 @@ static GimpUndo* gimp_paint_core_real_push_undo      (GimpPaintCore    *core,
                                                       GimpImage        *image,
                                                       const gchar      *undo_desc);
 
+static void   gimp_paint_core_batch_paste (GimpPaintCore        *core,
+                                           const GimpTempBuf    *paint_mask,
+                                           gint                  paint_mask_offset_x,
+                                           gint                  paint_mask_offset_y,
+                                           GimpDrawable         *drawable,
+                                           gdouble               paint_opacity,
+                                           gdouble               image_opacity,
+                                           GimpLayerModeEffects  paint_mode);
+static void   gimp_paint_core_flush_batch (GimpPaintCore        *core,
+                                           GimpDrawable         *drawable);
+
+static void   gimp_paint_core_release_applicator (GimpPaintCore *core);
+
 
 G_DEFINE_TYPE (GimpPaintCore, gimp_paint_core, GIMP_TYPE_OBJECT)
 
@@ -281,6 +295,131 @@ gimp_paint_core_real_push_undo (GimpPaintCore *core,
                                NULL);
 }
 
+static void
+gimp_paint_core_batch_paste (GimpPaintCore        *core,
+                             const GimpTempBuf    *paint_mask,
+                             gint                  paint_mask_offset_x,
+                             gint                  paint_mask_offset_y,
+                             GimpDrawable         *drawable,
+                             gdouble               paint_opacity,
+                             gdouble               image_opacity,
+                             GimpLayerModeEffects  paint_mode)
+{
+  GeglBuffer    *paint_mask_buffer;
+  GeglRectangle  area;
+
+  area.x      = core->paint_buffer_x;
+  area.y      = core->paint_buffer_y;
+  area.width  = gegl_buffer_get_width  (core->paint_buffer);
+  area.height = gegl_buffer_get_height (core->paint_buffer);
+
+  /*  the batch is composited with a single opacity and mode  */
+  if (core->batch_area.width > 0 &&
+      (core->batch_opacity    != image_opacity ||
+       core->batch_paint_mode != paint_mode))
+    {
+      gimp_paint_core_flush_batch (core, drawable);
+    }
+
+  paint_mask_buffer = gimp_temp_buf_create_buffer ((GimpTempBuf *) paint_mask);
+
+  gimp_gegl_combine_mask_weird (paint_mask_buffer,
+                                GEGL_RECTANGLE (paint_mask_offset_x,
+                                                paint_mask_offset_y,
+                                                area.width, area.height),
+                                core->canvas_buffer,
+                                &area,
+                                paint_opacity,
+                                GIMP_IS_AIRBRUSH (core));
+
+  g_object_unref (paint_mask_buffer);
+
+  /*  Unbatched, every pixel of the dab's area would be composited with
+   *  the dab's color, so remember that color for the pixel until the
+   *  batch is flushed.  The buffer lives as long as the stroke, so
+   *  canvas pixels painted by earlier batches keep their color too.
+   */
+  if (! core->batch_buffer)
+    {
+      GimpItem *item = GIMP_ITEM (drawable);
+
+      core->batch_buffer =
+        gegl_buffer_new (GEGL_RECTANGLE (0, 0,
+                                         gimp_item_get_width  (item),
+                                         gimp_item_get_height (item)),
+                         gegl_buffer_get_format (core->paint_buffer));
+    }
+
+  gegl_buffer_copy (core->paint_buffer,
+                    GEGL_RECTANGLE (0, 0, area.width, area.height),
+                    core->batch_buffer,
+                    &area);
+
+  if (core->batch_area.width > 0)
+    gegl_rectangle_bounding_box (&core->batch_area, &core->batch_area, &area);
+  else
+    core->batch_area = area;
+
+  core->batch_opacity    = image_opacity;
+  core->batch_paint_mode = paint_mode;
+
+  /*  Update the undo extents  */
+  core->x1 = MIN (core->x1, area.x);
+  core->y1 = MIN (core->y1, area.y);
+  core->x2 = MAX (core->x2, area.x + area.width);
+  core->y2 = MAX (core->y2, area.y + area.height);
+}
+
+static void
+gimp_paint_core_flush_batch (GimpPaintCore *core,
+                             GimpDrawable  *drawable)
+{
+  GeglRectangle  area = core->batch_area;
+  GeglBuffer    *apply_buffer;
+
+  if (area.width <= 0 || area.height <= 0)
+    return;
+
+  core->batch_area.width  = 0;
+  core->batch_area.height = 0;
+
+  apply_buffer = gimp_gegl_buffer_dup_area (core->batch_buffer, &area);
+
+  gimp_gegl_apply_mask (core->canvas_buffer,
+                        &area,
+                        apply_buffer,
+                        GEGL_RECTANGLE (0, 0, area.width, area.height),
+                        1.0);
+
+  gimp_applicator_set_src_buffer (core->applicator, core->undo_buffer);
+  gimp_applicator_set_apply_buffer (core->applicator, apply_buffer);
+  gimp_applicator_set_apply_offset (core->applicator, area.x, area.y);
+
+  gimp_applicator_set_mode (core->applicator,
+                            core->batch_opacity, core->batch_paint_mode);
+
+  gimp_applicator_blit (core->applicator, &area);
+
+  g_object_unref (apply_buffer);
+
+  gimp_drawable_update (drawable, area.x, area.y, area.width, area.height);
+}
+
+/*  Detaches the stroke's buffers from the applicator, which is kept
+ *  for the next stroke.
+ */
+static void
+gimp_paint_core_release_applicator (GimpPaintCore *core)
+{
+  if (core->applicator)
+    {
+      gimp_applicator_set_src_buffer   (core->applicator, NULL);
+      gimp_applicator_set_apply_buffer (core->applicator, NULL);
+      gimp_applicator_set_dest_buffer  (core->applicator, NULL);
+      gimp_applicator_set_mask_buffer  (core->applicator, NULL);
+    }
+}
+
 
 /*  public functions  */
 
@@ -427,18 +566,30 @@ gimp_paint_core_start (GimpPaintCore     *core,
 
   core->linear_mode = gimp_drawable_get_linear (drawable);
 
+  /*  the applicator is kept between strokes, only its graph's
+   *  blending space is fixed at construction
+   */
+  if (core->applicator &&
+      (! paint_options->use_applicator ||
+       core->applicator->linear != core->linear_mode))
+    {
+      g_object_unref (core->applicator);
+      core->applicator = NULL;
+    }
+
   if (paint_options->use_applicator)
     {
-      core->applicator = gimp_applicator_new (NULL, core->linear_mode, FALSE);
+      if (! core->applicator)
+        core->applicator = gimp_applicator_new (NULL, core->linear_mode,
+                                                FALSE);
+
+      gimp_applicator_set_mask_buffer (core->applicator,
+                                       core->mask_buffer);
 
       if (core->mask_buffer)
-        {
-          gimp_applicator_set_mask_buffer (core->applicator,
-                                           core->mask_buffer);
-          gimp_applicator_set_mask_offset (core->applicator,
-                                           core->mask_x_offset,
-                                           core->mask_y_offset);
-        }
+        gimp_applicator_set_mask_offset (core->applicator,
+                                         core->mask_x_offset,
+                                         core->mask_y_offset);
 
       gimp_applicator_set_affect (core->applicator,
                                   gimp_drawable_get_active_mask (drawable));
@@ -458,10 +609,11 @@ gimp_paint_core_start (GimpPaintCore     *core,
         {
           const Babl *format;
 
-          if (core->linear_mode)
-            format = babl_format ("RGBA float");
-          else
-            format = babl_format ("R'G'B'A float");
+          format = gimp_babl_format (GIMP_RGB,
+                                     core->linear_mode ?
+                                     GIMP_PRECISION_FLOAT_LINEAR :
+                                     GIMP_PRECISION_FLOAT_GAMMA,
+                                     TRUE);
 
           core->comp_buffer =
             gegl_buffer_new (GEGL_RECTANGLE (0, 0,
@@ -488,11 +640,7 @@ gimp_paint_core_finish (GimpPaintCore *core,
   g_return_if_fail (GIMP_IS_DRAWABLE (drawable));
   g_return_if_fail (gimp_item_is_attached (GIMP_ITEM (drawable)));
 
-  if (core->applicator)
-    {
-      g_object_unref (core->applicator);
-      core->applicator = NULL;
-    }
+  gimp_paint_core_release_applicator (core);
 
   if (core->stroke_buffer)
     {
@@ -512,6 +660,12 @@ gimp_paint_core_finish (GimpPaintCore *core,
       core->comp_buffer = NULL;
     }
 
+  if (core->batch_buffer)
+    {
+      g_object_unref (core->batch_buffer);
+      core->batch_buffer = NULL;
+    }
+
   image = gimp_item_get_image (GIMP_ITEM (drawable));
 
   /*  Determine if any part of the image has been altered--
@@ -540,13 +694,8 @@ gimp_paint_core_finish (GimpPaintCore *core,
 
       GIMP_PAINT_CORE_GET_CLASS (core)->push_undo (core, image, NULL);
 
-      buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0, width, height),
-                                gimp_drawable_get_format (drawable));
-
-      gegl_buffer_copy (core->undo_buffer,
-                        GEGL_RECTANGLE (x, y, width, height),
-                        buffer,
-                        GEGL_RECTANGLE (0, 0, 0, 0));
+      buffer = gimp_gegl_buffer_dup_area (core->undo_buffer,
+                                          GEGL_RECTANGLE (x, y, width, height));
 
       gimp_drawable_push_undo (drawable, NULL,
                                buffer, x, y, width, height);
@@ -579,6 +728,8 @@ gimp_paint_core_cancel (GimpPaintCore *core,
   g_return_if_fail (GIMP_IS_DRAWABLE (drawable));
   g_return_if_fail (gimp_item_is_attached (GIMP_ITEM (drawable)));
 
+  gimp_paint_core_release_applicator (core);
+
   /*  Determine if any part of the image has been altered--
    *  if nothing has, then just return...
    */
@@ -618,6 +769,12 @@ gimp_paint_core_cleanup (GimpPaintCore *core)
 {
   g_return_if_fail (GIMP_IS_PAINT_CORE (core));
 
+  if (core->applicator)
+    {
+      g_object_unref (core->applicator);
+      core->applicator = NULL;
+    }
+
   if (core->undo_buffer)
     {
       g_object_unref (core->undo_buffer);
@@ -641,6 +798,12 @@ gimp_paint_core_cleanup (GimpPaintCore *core)
       g_object_unref (core->paint_buffer);
       core->paint_buffer = NULL;
     }
+
+  if (core->batch_buffer)
+    {
+      g_object_unref (core->batch_buffer);
+      core->batch_buffer = NULL;
+    }
 }
 
 void
@@ -738,6 +901,50 @@ gimp_paint_core_round_line (GimpPaintCore    *core,
                          GIMP_CONSTRAIN_LINE_15_DEGREES);
 }
 
+/**
+ * gimp_paint_core_begin_batch:
+ * @core: the #GimpPaintCore
+ *
+ * Starts batching the dabs pasted by @core. While batching, dabs
+ * pasted in %GIMP_PAINT_CONSTANT mode are only combined into the
+ * canvas buffer, and the whole batched area is composited onto the
+ * drawable once by gimp_paint_core_end_batch(), instead of once per
+ * dab. Other pastes composite all batched dabs first, so the result
+ * is the same as without batching.
+ *
+ * Only paint cores whose dabs don't depend on the drawable's pixels
+ * painted earlier in the same stroke may batch their pastes.
+ **/
+void
+gimp_paint_core_begin_batch (GimpPaintCore *core)
+{
+  g_return_if_fail (GIMP_IS_PAINT_CORE (core));
+
+  core->batch_level++;
+}
+
+/**
+ * gimp_paint_core_end_batch:
+ * @core:     the #GimpPaintCore
+ * @drawable: the #GimpDrawable painted on
+ *
+ * Ends a batch started by gimp_paint_core_begin_batch(), compositing
+ * all batched dabs onto @drawable.
+ **/
+void
+gimp_paint_core_end_batch (GimpPaintCore *core,
+                           GimpDrawable  *drawable)
+{
+  g_return_if_fail (GIMP_IS_PAINT_CORE (core));
+  g_return_if_fail (GIMP_IS_DRAWABLE (drawable));
+  g_return_if_fail (core->batch_level > 0);
+
+  core->batch_level--;
+
+  if (core->batch_level == 0)
+    gimp_paint_core_flush_batch (core, drawable);
+}
+
 
 /*  protected functions  */
 
@@ -804,6 +1011,23 @@ gimp_paint_core_paste (GimpPaintCore            *core,
   gint width  = gegl_buffer_get_width  (core->paint_buffer);
   gint height = gegl_buffer_get_height (core->paint_buffer);
 
+  if (core->batch_level > 0       &&
+      core->applicator            &&
+      mode == GIMP_PAINT_CONSTANT &&
+      paint_mask != NULL)
+    {
+      gimp_paint_core_batch_paste (core, paint_mask,
+                                   paint_mask_offset_x,
+                                   paint_mask_offset_y,
+                                   drawable,
+                                   paint_opacity,
+                                   image_opacity,
+                                   paint_mode);
+      return;
+    }
+
+  gimp_paint_core_flush_batch (core, drawable);
+
   if (core->applicator)
     {
       /*  If the mode is CONSTANT:
@@ -998,6 +1222,8 @@ gimp_paint_core_replace (GimpPaintCore            *core,
   GeglBuffer    *paint_mask_buffer;
   gint           width, height;
 
+  gimp_paint_core_flush_batch (core, drawable);
+
   if (! gimp_drawable_has_alpha (drawable))
     {
       gimp_paint_core_paste (core, paint_mask,
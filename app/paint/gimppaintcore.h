@@ -71,6 +71,12 @@ struct _GimpPaintCore
 
   GimpApplicator *applicator;
 
+  gint         batch_level;       /*  > 0 while pastes are being batched  */
+  GeglBuffer  *batch_buffer;      /*  the colors of all batched dabs      */
+  GeglRectangle batch_area;       /*  batched area, not blitted yet       */
+  gdouble      batch_opacity;
+  GimpLayerModeEffects batch_paint_mode;
+
   GArray      *stroke_buffer;
 };
 
@@ -160,6 +166,10 @@ void      gimp_paint_core_round_line                (GimpPaintCore    *core,
                                                      GimpPaintOptions *options,
                                                      gboolean          constrain_15_degrees);
 
+void      gimp_paint_core_begin_batch               (GimpPaintCore    *core);
+void      gimp_paint_core_end_batch                 (GimpPaintCore    *core,
+                                                     GimpDrawable     *drawable);
+
 
 /*  protected functions  */
 
@@ -51,6 +51,7 @@
 
 #define DEFAULT_APPLICATION_MODE        GIMP_PAINT_CONSTANT
 #define DEFAULT_HARD                    FALSE
+#define DEFAULT_PREDICT_STROKE          FALSE
 
 #define DEFAULT_USE_JITTER              FALSE
 #define DEFAULT_JITTER_AMOUNT           0.2
@@ -97,6 +98,7 @@ enum
 
   PROP_APPLICATION_MODE,
   PROP_HARD,
+  PROP_PREDICT_STROKE,
 
   PROP_USE_JITTER,
   PROP_JITTER_AMOUNT,
@@ -144,6 +146,10 @@ static void    gimp_paint_options_get_property     (GObject      *object,
 static void    gimp_paint_options_brush_changed    (GimpContext  *context,
                                                     GimpBrush    *brush);
 
+static void    gimp_paint_options_copy_props       (GimpPaintOptions  *src,
+                                                    GimpPaintOptions  *dest,
+                                                    const gchar      **names,
+                                                    gint               n_names);
 
 
 G_DEFINE_TYPE (GimpPaintOptions, gimp_paint_options, GIMP_TYPE_TOOL_OPTIONS)
@@ -254,6 +260,13 @@ gimp_paint_options_class_init (GimpPaintOptionsClass *klass)
                                     DEFAULT_HARD,
                                     GIMP_PARAM_STATIC_STRINGS);
 
+  GIMP_CONFIG_INSTALL_PROP_BOOLEAN (object_class, PROP_PREDICT_STROKE,
+                                    "predict-stroke",
+                                    _("Preview where the stroke is heading "
+                                      "before it is painted"),
+                                    DEFAULT_PREDICT_STROKE,
+                                    GIMP_PARAM_STATIC_STRINGS);
+
   GIMP_CONFIG_INSTALL_PROP_BOOLEAN (object_class, PROP_USE_JITTER,
                                     "use-jitter", _("Scatter brush as you paint"),
                                     DEFAULT_USE_JITTER,
@@ -472,6 +485,9 @@ gimp_paint_options_set_property (GObject      *object,
     case PROP_HARD:
       options->hard = g_value_get_boolean (value);
       break;
+    case PROP_PREDICT_STROKE:
+      options->predict_stroke = g_value_get_boolean (value);
+      break;
 
     case PROP_USE_JITTER:
       jitter_options->use_jitter = g_value_get_boolean (value);
@@ -632,6 +648,9 @@ gimp_paint_options_get_property (GObject    *object,
     case PROP_HARD:
       g_value_set_boolean (value, options->hard);
       break;
+    case PROP_PREDICT_STROKE:
+      g_value_set_boolean (value, options->predict_stroke);
+      break;
 
     case PROP_USE_JITTER:
       g_value_set_boolean (value, jitter_options->use_jitter);
@@ -869,10 +888,11 @@ gimp_paint_options_get_gradient_color (GimpPaintOptions *paint_options,
 
       gradient = gimp_context_get_gradient (GIMP_CONTEXT (paint_options));
 
-      gimp_gradient_get_color_at (gradient, GIMP_CONTEXT (paint_options),
-                                  NULL, grad_point,
-                                  gradient_options->gradient_reverse,
-                                  color);
+      gimp_gradient_lut_get_color (gimp_gradient_get_lut (gradient,
+                                                          GIMP_CONTEXT (paint_options)),
+                                   grad_point,
+                                   gradient_options->gradient_reverse,
+                                   color);
 
       return TRUE;
     }
@@ -973,98 +993,102 @@ void
 gimp_paint_options_copy_brush_props (GimpPaintOptions *src,
                                      GimpPaintOptions *dest)
 {
-  gdouble  brush_size;
-  gboolean brush_zoom;
-  gdouble  brush_angle;
-  gdouble  brush_aspect_ratio;
-  gdouble  brush_spacing;
-  gdouble  brush_hardness;
-  gdouble  brush_force;
-
-  gboolean brush_link_size;
-  gboolean brush_link_aspect_ratio;
-  gboolean brush_link_angle;
-  gboolean brush_link_spacing;
-  gboolean brush_link_hardness;
+  static const gchar *brush_props[] =
+  {
+    "brush-size",
+    "brush-zoom",
+    "brush-angle",
+    "brush-aspect-ratio",
+    "brush-spacing",
+    "brush-hardness",
+    "brush-force",
+    "brush-link-size",
+    "brush-link-angle",
+    "brush-link-aspect-ratio",
+    "brush-link-spacing",
+    "brush-link-hardness"
+  };
 
   g_return_if_fail (GIMP_IS_PAINT_OPTIONS (src));
   g_return_if_fail (GIMP_IS_PAINT_OPTIONS (dest));
 
-  g_object_get (src,
-                "brush-size", &brush_size,
-                "brush-zoom", &brush_zoom,
-                "brush-angle", &brush_angle,
-                "brush-aspect-ratio", &brush_aspect_ratio,
-                "brush-spacing", &brush_spacing,
-                "brush-hardness", &brush_hardness,
-                "brush-force", &brush_force,
-                "brush-link-size", &brush_link_size,
-                "brush-link-angle", &brush_link_angle,
-                "brush-link-aspect-ratio", &brush_link_aspect_ratio,
-                "brush-link-spacing", &brush_link_spacing,
-                "brush-link-hardness", &brush_link_hardness,
-                NULL);
-
-  g_object_set (dest,
-                "brush-size", brush_size,
-                "brush-zoom", brush_zoom,
-                "brush-angle", brush_angle,
-                "brush-aspect-ratio", brush_aspect_ratio,
-                "brush-spacing", brush_spacing,
-                "brush-hardness", brush_hardness,
-                "brush-force", brush_force,
-                "brush-link-size", brush_link_size,
-                "brush-link-angle", brush_link_angle,
-                "brush-link-aspect-ratio", brush_link_aspect_ratio,
-                "brush-link-spacing", brush_link_spacing,
-                "brush-link-hardness", brush_link_hardness,
-                NULL);
+  gimp_paint_options_copy_props (src, dest,
+                                 brush_props, G_N_ELEMENTS (brush_props));
 }
 
 void
 gimp_paint_options_copy_dynamics_props (GimpPaintOptions *src,
                                         GimpPaintOptions *dest)
 {
-  gboolean        dynamics_expanded;
-  gboolean        fade_reverse;
-  gdouble         fade_length;
-  GimpUnit        fade_unit;
-  GimpRepeatMode  fade_repeat;
+  static const gchar *dynamics_props[] =
+  {
+    "dynamics-expanded",
+    "fade-reverse",
+    "fade-length",
+    "fade-unit",
+    "fade-repeat"
+  };
 
   g_return_if_fail (GIMP_IS_PAINT_OPTIONS (src));
   g_return_if_fail (GIMP_IS_PAINT_OPTIONS (dest));
 
-  g_object_get (src,
-                "dynamics-expanded", &dynamics_expanded,
-                "fade-reverse", &fade_reverse,
-                "fade-length", &fade_length,
-                "fade-unit", &fade_unit,
-                "fade-repeat", &fade_repeat,
-                NULL);
-
-  g_object_set (dest,
-                "dynamics-expanded", dynamics_expanded,
-                "fade-reverse", fade_reverse,
-                "fade-length", fade_length,
-                "fade-unit", fade_unit,
-                "fade-repeat", fade_repeat,
-                NULL);
+  gimp_paint_options_copy_props (src, dest,
+                                 dynamics_props, G_N_ELEMENTS (dynamics_props));
 }
 
 void
 gimp_paint_options_copy_gradient_props (GimpPaintOptions *src,
                                         GimpPaintOptions *dest)
 {
-  gboolean  gradient_reverse;
+  static const gchar *gradient_props[] =
+  {
+    "gradient-reverse"
+  };
 
   g_return_if_fail (GIMP_IS_PAINT_OPTIONS (src));
   g_return_if_fail (GIMP_IS_PAINT_OPTIONS (dest));
 
-  g_object_get (src,
-                "gradient-reverse", &gradient_reverse,
-                NULL);
+  gimp_paint_options_copy_props (src, dest,
+                                 gradient_props, G_N_ELEMENTS (gradient_props));
+}
+
+
+/*  private functions  */
+
+/*  copies only the values that differ, so switching tools or presets
+ *  doesn't emit "notify" (and invalidate whatever listens to it) for
+ *  properties that end up unchanged; the remaining notifications are
+ *  emitted in one batch
+ */
+static void
+gimp_paint_options_copy_props (GimpPaintOptions  *src,
+                               GimpPaintOptions  *dest,
+                               const gchar      **names,
+                               gint               n_names)
+{
+  GObjectClass *klass = G_OBJECT_GET_CLASS (src);
+  gint          i;
+
+  g_object_freeze_notify (G_OBJECT (dest));
+
+  for (i = 0; i < n_names; i++)
+    {
+      GParamSpec *pspec      = g_object_class_find_property (klass, names[i]);
+      GValue      src_value  = { 0, };
+      GValue      dest_value = { 0, };
+
+      g_value_init (&src_value,  pspec->value_type);
+      g_value_init (&dest_value, pspec->value_type);
+
+      g_object_get_property (G_OBJECT (src),  names[i], &src_value);
+      g_object_get_property (G_OBJECT (dest), names[i], &dest_value);
+
+      if (g_param_values_cmp (pspec, &src_value, &dest_value))
+        g_object_set_property (G_OBJECT (dest), names[i], &src_value);
+
+      g_value_unset (&src_value);
+      g_value_unset (&dest_value);
+    }
 
-  g_object_set (dest,
-                "gradient-reverse", gradient_reverse,
-                NULL);
+  g_object_thaw_notify (G_OBJECT (dest));
 }
@@ -100,6 +100,7 @@ struct _GimpPaintOptions
   GimpPaintApplicationMode  application_mode_save;
 
   gboolean                  hard;
+  gboolean                  predict_stroke;
 
   GimpJitterOptions        *jitter_options;
 
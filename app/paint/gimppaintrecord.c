@@ -0,0 +1,386 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimppaintrecord.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <gdk-pixbuf/gdk-pixbuf.h>
+#include <gegl.h>
+
+#include "libgimpbase/gimpbase.h"
+
+#include "paint-types.h"
+
+#include "core/gimpdrawable.h"
+#include "core/gimperror.h"
+
+#include "gimppaintcore.h"
+#include "gimppaintoptions.h"
+#include "gimppaintrecord.h"
+
+#include "gimp-intl.h"
+
+
+/*  A paint record is the sequence of input events of one or more
+ *  strokes, as the paint tool passed them to its paint core.  It is
+ *  saved as text, one stroke per "stroke" line followed by one line
+ *  per event:
+ *
+ *    time x y pressure xtilt ytilt wheel velocity direction xscale yscale
+ */
+
+#define PAINT_RECORD_HEADER  "# GIMP paint record"
+#define PAINT_RECORD_STROKE  "stroke"
+#define PAINT_RECORD_FIELDS  11
+
+
+struct _GimpPaintRecord
+{
+  GPtrArray *strokes;  /*  of GArray of GimpPaintRecordEvent  */
+};
+
+
+GimpPaintRecord *
+gimp_paint_record_new (void)
+{
+  GimpPaintRecord *record = g_slice_new0 (GimpPaintRecord);
+
+  record->strokes = g_ptr_array_new_with_free_func ((GDestroyNotify)
+                                                    g_array_unref);
+
+  return record;
+}
+
+void
+gimp_paint_record_free (GimpPaintRecord *record)
+{
+  g_return_if_fail (record != NULL);
+
+  g_ptr_array_unref (record->strokes);
+
+  g_slice_free (GimpPaintRecord, record);
+}
+
+void
+gimp_paint_record_begin_stroke (GimpPaintRecord *record)
+{
+  g_return_if_fail (record != NULL);
+
+  g_ptr_array_add (record->strokes,
+                   g_array_new (FALSE, FALSE, sizeof (GimpPaintRecordEvent)));
+}
+
+void
+gimp_paint_record_add_event (GimpPaintRecord  *record,
+                             const GimpCoords *coords,
+                             guint32           time)
+{
+  GimpPaintRecordEvent event;
+
+  g_return_if_fail (record != NULL);
+  g_return_if_fail (record->strokes->len > 0);
+  g_return_if_fail (coords != NULL);
+
+  event.coords = *coords;
+  event.time   = time;
+
+  g_array_append_val (g_ptr_array_index (record->strokes,
+                                         record->strokes->len - 1),
+                      event);
+}
+
+gint
+gimp_paint_record_get_n_strokes (GimpPaintRecord *record)
+{
+  g_return_val_if_fail (record != NULL, 0);
+
+  return record->strokes->len;
+}
+
+const GimpPaintRecordEvent *
+gimp_paint_record_get_stroke (GimpPaintRecord *record,
+                              gint             stroke,
+                              gint            *n_events)
+{
+  GArray *events;
+
+  g_return_val_if_fail (record != NULL, NULL);
+  g_return_val_if_fail (stroke >= 0 && stroke < record->strokes->len, NULL);
+  g_return_val_if_fail (n_events != NULL, NULL);
+
+  events = g_ptr_array_index (record->strokes, stroke);
+
+  *n_events = events->len;
+
+  return (const GimpPaintRecordEvent *) events->data;
+}
+
+gboolean
+gimp_paint_record_save (GimpPaintRecord  *record,
+                        GFile            *file,
+                        GError          **error)
+{
+  GString  *string;
+  gboolean  success;
+  gint      i;
+
+  g_return_val_if_fail (record != NULL, FALSE);
+  g_return_val_if_fail (G_IS_FILE (file), FALSE);
+  g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  string = g_string_new (PAINT_RECORD_HEADER "\n");
+
+  for (i = 0; i < record->strokes->len; i++)
+    {
+      GArray *events = g_ptr_array_index (record->strokes, i);
+      gint    j;
+
+      g_string_append (string, PAINT_RECORD_STROKE "\n");
+
+      for (j = 0; j < events->len; j++)
+        {
+          const GimpPaintRecordEvent *event;
+          gdouble                     values[PAINT_RECORD_FIELDS - 1];
+          gint                        k;
+
+          event = &g_array_index (events, GimpPaintRecordEvent, j);
+
+          values[0] = event->coords.x;
+          values[1] = event->coords.y;
+          values[2] = event->coords.pressure;
+          values[3] = event->coords.xtilt;
+          values[4] = event->coords.ytilt;
+          values[5] = event->coords.wheel;
+          values[6] = event->coords.velocity;
+          values[7] = event->coords.direction;
+          values[8] = event->coords.xscale;
+          values[9] = event->coords.yscale;
+
+          g_string_append_printf (string, "%u", event->time);
+
+          for (k = 0; k < G_N_ELEMENTS (values); k++)
+            {
+              gchar buf[G_ASCII_DTOSTR_BUF_SIZE];
+
+              g_string_append_c (string, ' ');
+              g_string_append (string,
+                               g_ascii_dtostr (buf, sizeof (buf), values[k]));
+            }
+
+          g_string_append_c (string, '\n');
+        }
+    }
+
+  success = g_file_replace_contents (file, string->str, string->len,
+                                     NULL, FALSE, G_FILE_CREATE_NONE,
+                                     NULL, NULL, error);
+
+  g_string_free (string, TRUE);
+
+  return success;
+}
+
+GimpPaintRecord *
+gimp_paint_record_load (GFile   *file,
+                        GError **error)
+{
+  GimpPaintRecord  *record;
+  gchar            *contents;
+  gchar           **lines;
+  gint              i;
+
+  g_return_val_if_fail (G_IS_FILE (file), NULL);
+  g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+  if (! g_file_load_contents (file, NULL, &contents, NULL, NULL, error))
+    return NULL;
+
+  if (! g_str_has_prefix (contents, PAINT_RECORD_HEADER))
+    {
+      g_set_error (error, GIMP_ERROR, GIMP_FAILED,
+                   _("'%s' is not a paint record"),
+                   gimp_file_get_utf8_name (file));
+      g_free (contents);
+
+      return NULL;
+    }
+
+  record = gimp_paint_record_new ();
+
+  lines = g_strsplit (contents, "\n", -1);
+  g_free (contents);
+
+  for (i = 1; lines[i]; i++)
+    {
+      gchar                **fields;
+      GimpPaintRecordEvent   event;
+
+      if (! *lines[i] || *lines[i] == '#')
+        continue;
+
+      if (! strcmp (lines[i], PAINT_RECORD_STROKE))
+        {
+          gimp_paint_record_begin_stroke (record);
+          continue;
+        }
+
+      fields = g_strsplit (lines[i], " ", -1);
+
+      if (record->strokes->len == 0 ||
+          g_strv_length (fields) != PAINT_RECORD_FIELDS)
+        {
+          g_set_error (error, GIMP_ERROR, GIMP_FAILED,
+                       _("Invalid paint record '%s' at line %d"),
+                       gimp_file_get_utf8_name (file), i + 1);
+          g_strfreev (fields);
+          g_strfreev (lines);
+          gimp_paint_record_free (record);
+
+          return NULL;
+        }
+
+      event.time             = strtoul (fields[0], NULL, 10);
+      event.coords.x         = g_ascii_strtod (fields[1],  NULL);
+      event.coords.y         = g_ascii_strtod (fields[2],  NULL);
+      event.coords.pressure  = g_ascii_strtod (fields[3],  NULL);
+      event.coords.xtilt     = g_ascii_strtod (fields[4],  NULL);
+      event.coords.ytilt     = g_ascii_strtod (fields[5],  NULL);
+      event.coords.wheel     = g_ascii_strtod (fields[6],  NULL);
+      event.coords.velocity  = g_ascii_strtod (fields[7],  NULL);
+      event.coords.direction = g_ascii_strtod (fields[8],  NULL);
+      event.coords.xscale    = g_ascii_strtod (fields[9],  NULL);
+      event.coords.yscale    = g_ascii_strtod (fields[10], NULL);
+
+      gimp_paint_record_add_event (record, &event.coords, event.time);
+
+      g_strfreev (fields);
+    }
+
+  g_strfreev (lines);
+
+  return record;
+}
+
+/**
+ * gimp_paint_record_replay:
+ * @record:        a #GimpPaintRecord
+ * @core:          the #GimpPaintCore to paint with
+ * @drawable:      the #GimpDrawable to paint on
+ * @paint_options: the #GimpPaintOptions to paint with
+ * @push_undo:     whether to push an undo step for each stroke
+ * @latencies:     a #GArray of #gdouble, or %NULL
+ * @error:         return location for an error
+ *
+ * Feeds the recorded strokes through @core the same way the paint
+ * tool feeds live input events to it, including the recorded
+ * timestamps.  If @latencies is not %NULL, the time in seconds it took
+ * to paint each event is appended to it.
+ *
+ * Return value: %TRUE if all strokes were painted.
+ **/
+gboolean
+gimp_paint_record_replay (GimpPaintRecord   *record,
+                          GimpPaintCore     *core,
+                          GimpDrawable      *drawable,
+                          GimpPaintOptions  *paint_options,
+                          gboolean           push_undo,
+                          GArray            *latencies,
+                          GError           **error)
+{
+  GTimer *timer;
+  gint    i;
+
+  g_return_val_if_fail (record != NULL, FALSE);
+  g_return_val_if_fail (GIMP_IS_PAINT_CORE (core), FALSE);
+  g_return_val_if_fail (GIMP_IS_DRAWABLE (drawable), FALSE);
+  g_return_val_if_fail (GIMP_IS_PAINT_OPTIONS (paint_options), FALSE);
+  g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  timer = g_timer_new ();
+
+  for (i = 0; i < record->strokes->len; i++)
+    {
+      GArray                     *stroke = g_ptr_array_index (record->strokes,
+                                                              i);
+      const GimpPaintRecordEvent *events;
+      GimpCoords                  coords;
+      gdouble                     latency;
+      gint                        j;
+
+      if (stroke->len == 0)
+        continue;
+
+      events = (const GimpPaintRecordEvent *) stroke->data;
+      coords = events[0].coords;
+
+      if (! gimp_paint_core_start (core, drawable, paint_options, &coords,
+                                   error))
+        {
+          g_timer_destroy (timer);
+
+          return FALSE;
+        }
+
+      core->last_coords = core->cur_coords;
+      core->distance    = 0.0;
+      core->pixel_dist  = 0.0;
+
+      gimp_paint_core_paint (core, drawable, paint_options,
+                             GIMP_PAINT_STATE_INIT, events[0].time);
+
+      g_timer_start (timer);
+
+      gimp_paint_core_paint (core, drawable, paint_options,
+                             GIMP_PAINT_STATE_MOTION, events[0].time);
+
+      latency = g_timer_elapsed (timer, NULL);
+
+      if (latencies)
+        g_array_append_val (latencies, latency);
+
+      for (j = 1; j < stroke->len; j++)
+        {
+          coords = events[j].coords;
+
+          g_timer_start (timer);
+
+          gimp_paint_core_interpolate (core, drawable, paint_options,
+                                       &coords, events[j].time);
+
+          latency = g_timer_elapsed (timer, NULL);
+
+          if (latencies)
+            g_array_append_val (latencies, latency);
+        }
+
+      gimp_paint_core_paint (core, drawable, paint_options,
+                             GIMP_PAINT_STATE_FINISH,
+                             events[stroke->len - 1].time);
+
+      gimp_paint_core_finish (core, drawable, push_undo);
+
+      gimp_paint_core_cleanup (core);
+    }
+
+  g_timer_destroy (timer);
+
+  return TRUE;
+}
@@ -0,0 +1,62 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimppaintrecord.h
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GIMP_PAINT_RECORD_H__
+#define __GIMP_PAINT_RECORD_H__
+
+
+typedef struct _GimpPaintRecordEvent GimpPaintRecordEvent;
+
+struct _GimpPaintRecordEvent
+{
+  GimpCoords coords;  /*  in drawable coordinates  */
+  guint32    time;
+};
+
+
+GimpPaintRecord * gimp_paint_record_new           (void);
+void              gimp_paint_record_free          (GimpPaintRecord   *record);
+
+void              gimp_paint_record_begin_stroke  (GimpPaintRecord   *record);
+void              gimp_paint_record_add_event     (GimpPaintRecord   *record,
+                                                   const GimpCoords  *coords,
+                                                   guint32            time);
+
+gint              gimp_paint_record_get_n_strokes (GimpPaintRecord   *record);
+const GimpPaintRecordEvent *
+                  gimp_paint_record_get_stroke    (GimpPaintRecord   *record,
+                                                   gint               stroke,
+                                                   gint              *n_events);
+
+gboolean          gimp_paint_record_save          (GimpPaintRecord   *record,
+                                                   GFile             *file,
+                                                   GError           **error);
+GimpPaintRecord * gimp_paint_record_load          (GFile             *file,
+                                                   GError           **error);
+
+gboolean          gimp_paint_record_replay        (GimpPaintRecord   *record,
+                                                   GimpPaintCore     *core,
+                                                   GimpDrawable      *drawable,
+                                                   GimpPaintOptions  *paint_options,
+                                                   gboolean           push_undo,
+                                                   GArray            *latencies,
+                                                   GError           **error);
+
+
+#endif  /*  __GIMP_PAINT_RECORD_H__  */
@@ -45,6 +45,12 @@
 #include "gimp-intl.h"
 
 
+/*  the transformed source is rendered into a per-stroke cache in tiles
+ *  of this size, so overlapping dabs don't transform it again
+ */
+#define SRC_CACHE_TILE_SIZE 64
+
+
 static void         gimp_perspective_clone_paint      (GimpPaintCore     *paint_core,
                                                        GimpDrawable      *drawable,
                                                        GimpPaintOptions  *paint_options,
@@ -71,6 +77,12 @@ static GeglBuffer * gimp_perspective_clone_get_source (GimpSourceCore    *source
 
 static void         gimp_perspective_clone_get_matrix (GimpPerspectiveClone *clone,
                                                        GimpMatrix3          *matrix);
+static void         gimp_perspective_clone_get_source_rect
+                                                      (GimpPerspectiveClone *clone,
+                                                       const GeglRectangle  *dest_rect,
+                                                       GeglRectangle        *src_rect);
+static void         gimp_perspective_clone_clear_cache
+                                                      (GimpPerspectiveClone *clone);
 
 
 G_DEFINE_TYPE (GimpPerspectiveClone, gimp_perspective_clone,
@@ -318,6 +330,8 @@ gimp_perspective_clone_paint (GimpPaintCore    *paint_core,
       break;
 
     case GIMP_PAINT_STATE_FINISH:
+      gimp_perspective_clone_clear_cache (clone);
+
       if (clone->node)
         {
           g_object_unref (clone->node);
@@ -362,42 +376,27 @@ gimp_perspective_clone_get_source (GimpSourceCore   *source_core,
   GimpPerspectiveClone *clone         = GIMP_PERSPECTIVE_CLONE (source_core);
   GimpCloneOptions     *clone_options = GIMP_CLONE_OPTIONS (paint_options);
   GeglBuffer           *src_buffer;
-  GeglBuffer           *dest_buffer;
   const Babl           *src_format_alpha;
-  gint                  x1d, y1d, x2d, y2d;
-  gdouble               x1s, y1s, x2s, y2s, x3s, y3s, x4s, y4s;
-  gint                  xmin, ymin, xmax, ymax;
+  GeglRectangle         dest_rect;
+  GeglRectangle         rect;
   GimpMatrix3           matrix;
-  GimpMatrix3           gegl_matrix;
+  gint                  x, y;
 
   src_buffer       = gimp_pickable_get_buffer (src_pickable);
   src_format_alpha = gimp_pickable_get_format_with_alpha (src_pickable);
 
   /* Destination coordinates that will be painted */
-  x1d = paint_buffer_x;
-  y1d = paint_buffer_y;
-  x2d = paint_buffer_x + gegl_buffer_get_width  (paint_buffer);
-  y2d = paint_buffer_y + gegl_buffer_get_height (paint_buffer);
+  dest_rect.x      = paint_buffer_x;
+  dest_rect.y      = paint_buffer_y;
+  dest_rect.width  = gegl_buffer_get_width  (paint_buffer);
+  dest_rect.height = gegl_buffer_get_height (paint_buffer);
 
-  /* Boundary box for source pixels to copy: Convert all the vertex of
-   * the box to paint in destination area to its correspondent in
-   * source area bearing in mind perspective
-   */
-  gimp_perspective_clone_get_source_point (clone, x1d, y1d, &x1s, &y1s);
-  gimp_perspective_clone_get_source_point (clone, x1d, y2d, &x2s, &y2s);
-  gimp_perspective_clone_get_source_point (clone, x2d, y1d, &x3s, &y3s);
-  gimp_perspective_clone_get_source_point (clone, x2d, y2d, &x4s, &y4s);
-
-  xmin = floor (MIN4 (x1s, x2s, x3s, x4s));
-  ymin = floor (MIN4 (y1s, y2s, y3s, y4s));
-  xmax = ceil  (MAX4 (x1s, x2s, x3s, x4s));
-  ymax = ceil  (MAX4 (y1s, y2s, y3s, y4s));
-
-  switch (clone_options->clone_type)
+  if (clone_options->clone_type == GIMP_CLONE_IMAGE)
     {
-    case GIMP_CLONE_IMAGE:
-      if (! gimp_rectangle_intersect (xmin, ymin,
-                                      xmax - xmin, ymax - ymin,
+      gimp_perspective_clone_get_source_rect (clone, &dest_rect, &rect);
+
+      if (! gimp_rectangle_intersect (rect.x, rect.y,
+                                      rect.width, rect.height,
                                       0, 0,
                                       gegl_buffer_get_width  (src_buffer),
                                       gegl_buffer_get_height (src_buffer),
@@ -406,40 +405,86 @@ gimp_perspective_clone_get_source (GimpSourceCore   *source_core,
           /* if the source area is completely out of the image */
           return NULL;
         }
-      break;
+    }
+
+  gimp_perspective_clone_get_matrix (clone, &matrix);
+
+  /*  the transform only changes when the source is moved, which can't
+   *  happen during a stroke; drop the cache if it does anyway
+   */
+  if (clone->src_cache &&
+      (memcmp (&matrix, &clone->src_cache_matrix, sizeof (matrix)) ||
+       gegl_buffer_get_format (clone->src_cache) != src_format_alpha))
+    {
+      gimp_perspective_clone_clear_cache (clone);
+    }
 
-    case GIMP_CLONE_PATTERN:
-      gegl_node_set (clone->crop,
-                     "x",      (gdouble) xmin,
-                     "y",      (gdouble) ymin,
-                     "width",  (gdouble) xmax - xmin,
-                     "height", (gdouble) ymax - ymin,
+  if (! clone->src_cache)
+    {
+      clone->src_cache =
+        gegl_buffer_new (GEGL_RECTANGLE (0, 0,
+                                         gimp_item_get_width  (GIMP_ITEM (drawable)),
+                                         gimp_item_get_height (GIMP_ITEM (drawable))),
+                         src_format_alpha);
+      clone->src_cache_tiles  = g_hash_table_new (g_direct_hash,
+                                                  g_direct_equal);
+      clone->src_cache_matrix = matrix;
+
+      gimp_gegl_node_set_matrix (clone->transform_node, &matrix);
+
+      gegl_node_set (clone->dest_node,
+                     "buffer", clone->src_cache,
                      NULL);
-      break;
     }
 
-  dest_buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0, x2d - x1d, y2d - y1d),
-                                 src_format_alpha);
+  /*  render the cache tiles this dab touches which no earlier dab
+   *  has rendered yet
+   */
+  for (y = dest_rect.y / SRC_CACHE_TILE_SIZE;
+       y <= (dest_rect.y + dest_rect.height - 1) / SRC_CACHE_TILE_SIZE;
+       y++)
+    {
+      for (x = dest_rect.x / SRC_CACHE_TILE_SIZE;
+           x <= (dest_rect.x + dest_rect.width - 1) / SRC_CACHE_TILE_SIZE;
+           x++)
+        {
+          gpointer key = GUINT_TO_POINTER (((guint) y << 16) | (guint) x);
 
-  gimp_perspective_clone_get_matrix (clone, &matrix);
+          if (g_hash_table_contains (clone->src_cache_tiles, key))
+            continue;
 
-  gimp_matrix3_identity (&gegl_matrix);
-  gimp_matrix3_mult (&matrix, &gegl_matrix);
-  gimp_matrix3_translate (&gegl_matrix, -x1d, -y1d);
+          if (! gegl_rectangle_intersect (&rect,
+                                          GEGL_RECTANGLE (x * SRC_CACHE_TILE_SIZE,
+                                                          y * SRC_CACHE_TILE_SIZE,
+                                                          SRC_CACHE_TILE_SIZE,
+                                                          SRC_CACHE_TILE_SIZE),
+                                          gegl_buffer_get_extent (clone->src_cache)))
+            continue;
 
-  gimp_gegl_node_set_matrix (clone->transform_node, &gegl_matrix);
+          if (clone_options->clone_type == GIMP_CLONE_PATTERN)
+            {
+              GeglRectangle src_rect;
+
+              gimp_perspective_clone_get_source_rect (clone, &rect, &src_rect);
 
-  gegl_node_set (clone->dest_node,
-                 "buffer", dest_buffer,
-                 NULL);
+              gegl_node_set (clone->crop,
+                             "x",      (gdouble) src_rect.x,
+                             "y",      (gdouble) src_rect.y,
+                             "width",  (gdouble) src_rect.width,
+                             "height", (gdouble) src_rect.height,
+                             NULL);
+            }
 
-  gegl_node_blit (clone->dest_node, 1.0,
-                  GEGL_RECTANGLE (0, 0, x2d - x1d, y2d - y1d),
-                  NULL, NULL, 0, GEGL_BLIT_DEFAULT);
+          gegl_node_blit (clone->dest_node, 1.0, &rect,
+                          NULL, NULL, 0, GEGL_BLIT_DEFAULT);
 
-  *src_rect = *GEGL_RECTANGLE (0, 0, x2d - x1d, y2d - y1d);
+          g_hash_table_add (clone->src_cache_tiles, key);
+        }
+    }
 
-  return dest_buffer;
+  *src_rect = dest_rect;
+
+  return g_object_ref (clone->src_cache);
 }
 
 
@@ -525,3 +570,49 @@ gimp_perspective_clone_get_matrix (GimpPerspectiveClone *clone,
   gimp_matrix3_mult (&temp, matrix);
   gimp_matrix3_mult (&clone->transform, matrix);
 }
+
+static void
+gimp_perspective_clone_get_source_rect (GimpPerspectiveClone *clone,
+                                        const GeglRectangle  *dest_rect,
+                                        GeglRectangle        *src_rect)
+{
+  gint    x1d, y1d, x2d, y2d;
+  gdouble x1s, y1s, x2s, y2s, x3s, y3s, x4s, y4s;
+  gint    xmin, ymin, xmax, ymax;
+
+  x1d = dest_rect->x;
+  y1d = dest_rect->y;
+  x2d = dest_rect->x + dest_rect->width;
+  y2d = dest_rect->y + dest_rect->height;
+
+  /* Boundary box for source pixels to copy: Convert all the vertex of
+   * the box to paint in destination area to its correspondent in
+   * source area bearing in mind perspective
+   */
+  gimp_perspective_clone_get_source_point (clone, x1d, y1d, &x1s, &y1s);
+  gimp_perspective_clone_get_source_point (clone, x1d, y2d, &x2s, &y2s);
+  gimp_perspective_clone_get_source_point (clone, x2d, y1d, &x3s, &y3s);
+  gimp_perspective_clone_get_source_point (clone, x2d, y2d, &x4s, &y4s);
+
+  xmin = floor (MIN4 (x1s, x2s, x3s, x4s));
+  ymin = floor (MIN4 (y1s, y2s, y3s, y4s));
+  xmax = ceil  (MAX4 (x1s, x2s, x3s, x4s));
+  ymax = ceil  (MAX4 (y1s, y2s, y3s, y4s));
+
+  src_rect->x      = xmin;
+  src_rect->y      = ymin;
+  src_rect->width  = xmax - xmin;
+  src_rect->height = ymax - ymin;
+}
+
+static void
+gimp_perspective_clone_clear_cache (GimpPerspectiveClone *clone)
+{
+  g_clear_object (&clone->src_cache);
+
+  if (clone->src_cache_tiles)
+    {
+      g_hash_table_unref (clone->src_cache_tiles);
+      clone->src_cache_tiles = NULL;
+    }
+}
@@ -49,6 +49,10 @@ struct _GimpPerspectiveClone
   GeglNode      *crop;
   GeglNode      *transform_node;
   GeglNode      *dest_node;
+
+  GeglBuffer    *src_cache;        /* transformed source, drawable coords */
+  GHashTable    *src_cache_tiles;  /* src_cache tiles already rendered    */
+  GimpMatrix3    src_cache_matrix;
 };
 
 struct _GimpPerspectiveCloneClass
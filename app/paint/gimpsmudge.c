@@ -289,6 +289,8 @@ gimp_smudge_motion (GimpPaintCore    *paint_core,
    *  where I is the pixels under the current painthit.
    *  Then the paint area (paint_area) is built as
    *    (Accum,1) (if no alpha),
+   *  Accum is updated in place and copied to the paint area in the
+   *  same pass.
    */
 
   gimp_gegl_smudge_blend (smudge->accum_buffer,
@@ -301,21 +303,12 @@ gimp_smudge_motion (GimpPaintCore    *paint_core,
                                           paint_buffer_y,
                                           paint_buffer_width,
                                           paint_buffer_height),
-                          smudge->accum_buffer,
-                          GEGL_RECTANGLE (paint_buffer_x - x,
-                                          paint_buffer_y - y,
+                          paint_buffer,
+                          GEGL_RECTANGLE (0, 0,
                                           paint_buffer_width,
                                           paint_buffer_height),
                           rate);
 
-  gegl_buffer_copy (smudge->accum_buffer,
-                    GEGL_RECTANGLE (paint_buffer_x - x,
-                                    paint_buffer_y - y,
-                                    paint_buffer_width,
-                                    paint_buffer_height),
-                    paint_buffer,
-                    GEGL_RECTANGLE (0, 0, 0, 0));
-
   if (gimp_dynamics_is_output_enabled (dynamics, GIMP_DYNAMICS_OUTPUT_FORCE))
     force = gimp_dynamics_get_linear_value (dynamics,
                                             GIMP_DYNAMICS_OUTPUT_FORCE,
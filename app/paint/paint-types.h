@@ -66,6 +66,11 @@ typedef struct _GimpPaintCoreUndo GimpPaintCoreUndo;
 typedef struct _GimpInkUndo       GimpInkUndo;
 
 
+/*  paint records  */
+
+typedef struct _GimpPaintRecord   GimpPaintRecord;
+
+
 /*  functions  */
 
 typedef void (* GimpPaintRegisterCallback) (Gimp        *gimp,
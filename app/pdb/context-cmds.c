@@ -1778,8 +1778,8 @@ context_set_ink_size_invoker (GimpProcedure         *procedure,
   if (success)
     {
       GimpPaintOptions *options =
-        gimp_pdb_context_get_paint_options (GIMP_PDB_CONTEXT (context),
-                                            "gimp-ink");
+        gimp_pdb_context_get_writable_paint_options (GIMP_PDB_CONTEXT (context),
+                                                     "gimp-ink");
 
       if (options)
         g_object_set (options,
@@ -1841,8 +1841,8 @@ context_set_ink_angle_invoker (GimpProcedure         *procedure,
   if (success)
     {
       GimpPaintOptions *options =
-        gimp_pdb_context_get_paint_options (GIMP_PDB_CONTEXT (context),
-                                            "gimp-ink");
+        gimp_pdb_context_get_writable_paint_options (GIMP_PDB_CONTEXT (context),
+                                                     "gimp-ink");
 
       if (options)
         g_object_set (options,
@@ -1904,8 +1904,8 @@ context_set_ink_size_sensitivity_invoker (GimpProcedure         *procedure,
   if (success)
     {
       GimpPaintOptions *options =
-        gimp_pdb_context_get_paint_options (GIMP_PDB_CONTEXT (context),
-                                            "gimp-ink");
+        gimp_pdb_context_get_writable_paint_options (GIMP_PDB_CONTEXT (context),
+                                                     "gimp-ink");
 
       if (options)
         g_object_set (options,
@@ -1967,8 +1967,8 @@ context_set_ink_tilt_sensitivity_invoker (GimpProcedure         *procedure,
   if (success)
     {
       GimpPaintOptions *options =
-        gimp_pdb_context_get_paint_options (GIMP_PDB_CONTEXT (context),
-                                            "gimp-ink");
+        gimp_pdb_context_get_writable_paint_options (GIMP_PDB_CONTEXT (context),
+                                                     "gimp-ink");
 
       if (options)
         g_object_set (options,
@@ -2030,8 +2030,8 @@ context_set_ink_speed_sensitivity_invoker (GimpProcedure         *procedure,
   if (success)
     {
       GimpPaintOptions *options =
-        gimp_pdb_context_get_paint_options (GIMP_PDB_CONTEXT (context),
-                                            "gimp-ink");
+        gimp_pdb_context_get_writable_paint_options (GIMP_PDB_CONTEXT (context),
+                                                     "gimp-ink");
 
       if (options)
         g_object_set (options,
@@ -2093,8 +2093,8 @@ context_set_ink_blob_type_invoker (GimpProcedure         *procedure,
   if (success)
     {
       GimpPaintOptions *options =
-        gimp_pdb_context_get_paint_options (GIMP_PDB_CONTEXT (context),
-                                            "gimp-ink");
+        gimp_pdb_context_get_writable_paint_options (GIMP_PDB_CONTEXT (context),
+                                                     "gimp-ink");
 
       if (options)
         g_object_set (options,
@@ -2156,8 +2156,8 @@ context_set_ink_blob_aspect_ratio_invoker (GimpProcedure         *procedure,
   if (success)
     {
       GimpPaintOptions *options =
-        gimp_pdb_context_get_paint_options (GIMP_PDB_CONTEXT (context),
-                                            "gimp-ink");
+        gimp_pdb_context_get_writable_paint_options (GIMP_PDB_CONTEXT (context),
+                                                     "gimp-ink");
 
       if (options)
         g_object_set (options,
@@ -2222,8 +2222,8 @@ context_set_ink_blob_angle_invoker (GimpProcedure         *procedure,
   if (success)
     {
       GimpPaintOptions *options =
-        gimp_pdb_context_get_paint_options (GIMP_PDB_CONTEXT (context),
-                                            "gimp-ink");
+        gimp_pdb_context_get_writable_paint_options (GIMP_PDB_CONTEXT (context),
+                                                     "gimp-ink");
 
       if (options)
         g_object_set (options,
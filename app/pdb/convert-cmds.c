@@ -19,10 +19,14 @@
 
 #include "config.h"
 
+#include <lcms2.h>
+
 #include <gegl.h>
 
 #include <gdk-pixbuf/gdk-pixbuf.h>
 
+#include "libgimpcolor/gimpcolor.h"
+
 #include "libgimpbase/gimpbase.h"
 
 #include "pdb-types.h"
@@ -30,6 +34,7 @@
 #include "core/gimp.h"
 #include "core/gimpimage-convert-precision.h"
 #include "core/gimpimage-convert-type.h"
+#include "core/gimpimage-profile.h"
 #include "core/gimpimage.h"
 #include "core/gimpitemstack.h"
 #include "core/gimppalette.h"
@@ -259,6 +264,59 @@ image_convert_precision_invoker (GimpProcedure         *procedure,
                                            error ? *error : NULL);
 }
 
+static GimpValueArray *
+image_convert_color_profile_invoker (GimpProcedure         *procedure,
+                                     Gimp                  *gimp,
+                                     GimpContext           *context,
+                                     GimpProgress          *progress,
+                                     const GimpValueArray  *args,
+                                     GError               **error)
+{
+  gboolean success = TRUE;
+  GimpImage *image;
+  gint32 num_bytes;
+  const guint8 *color_profile;
+  gint32 intent;
+  gboolean bpc;
+
+  image = gimp_value_get_image (gimp_value_array_index (args, 0), gimp);
+  num_bytes = g_value_get_int (gimp_value_array_index (args, 1));
+  color_profile = gimp_value_get_int8array (gimp_value_array_index (args, 2));
+  intent = g_value_get_int (gimp_value_array_index (args, 3));
+  bpc = g_value_get_boolean (gimp_value_array_index (args, 4));
+
+  if (success)
+    {
+      if (gimp_pdb_image_is_not_base_type (image, GIMP_GRAY, error))
+        {
+          GimpColorProfile profile;
+
+          profile = gimp_lcms_profile_open_from_data (color_profile, num_bytes,
+                                                      error);
+
+          if (profile)
+            {
+              success = gimp_image_convert_color_profile (image, profile,
+                                                          intent, bpc,
+                                                          progress, error);
+
+              cmsCloseProfile (profile);
+            }
+          else
+            {
+              success = FALSE;
+            }
+        }
+      else
+        {
+          success = FALSE;
+        }
+    }
+
+  return gimp_procedure_get_return_values (procedure, success,
+                                           error ? *error : NULL);
+}
+
 void
 register_convert_procs (GimpPDB *pdb)
 {
@@ -441,4 +499,50 @@ register_convert_procs (GimpPDB *pdb)
                                                   GIMP_PARAM_READWRITE));
   gimp_pdb_register_procedure (pdb, procedure);
   g_object_unref (procedure);
+
+  /*
+   * gimp-image-convert-color-profile
+   */
+  procedure = gimp_procedure_new (image_convert_color_profile_invoker);
+  gimp_object_set_static_name (GIMP_OBJECT (procedure),
+                               "gimp-image-convert-color-profile");
+  gimp_procedure_set_static_strings (procedure,
+                                     "gimp-image-convert-color-profile",
+                                     "Convert the image from its color profile to the specified one",
+                                     "This procedure converts all layers of the specified RGB image, or the colormap of an indexed image, from the image's current color profile to the profile given as ICC data, and attaches that profile to the image. If the image has no color profile, its pixels are assumed to be in the color profile configured in the preferences, or sRGB. The conversion is done in the core, in parallel, and can be undone in one step.",
+                                     "Spencer Kimball & Peter Mattis",
+                                     "Spencer Kimball & Peter Mattis",
+                                     "1995-1996",
+                                     NULL);
+  gimp_procedure_add_argument (procedure,
+                               gimp_param_spec_image_id ("image",
+                                                         "image",
+                                                         "The image",
+                                                         pdb->gimp, FALSE,
+                                                         GIMP_PARAM_READWRITE));
+  gimp_procedure_add_argument (procedure,
+                               gimp_param_spec_int32 ("num-bytes",
+                                                      "num bytes",
+                                                      "Number of bytes in the color_profile array",
+                                                      0, G_MAXINT32, 0,
+                                                      GIMP_PARAM_READWRITE));
+  gimp_procedure_add_argument (procedure,
+                               gimp_param_spec_int8_array ("color-profile",
+                                                           "color profile",
+                                                           "The serialized color profile",
+                                                           GIMP_PARAM_READWRITE));
+  gimp_procedure_add_argument (procedure,
+                               gimp_param_spec_int32 ("intent",
+                                                      "intent",
+                                                      "The rendering intent: { PERCEPTUAL (0), RELATIVE-COLORIMETRIC (1), SATURATION (2), ABSOLUTE-COLORIMETRIC (3) }",
+                                                      0, 3, 0,
+                                                      GIMP_PARAM_READWRITE));
+  gimp_procedure_add_argument (procedure,
+                               g_param_spec_boolean ("bpc",
+                                                     "bpc",
+                                                     "Whether to use black point compensation",
+                                                     FALSE,
+                                                     GIMP_PARAM_READWRITE));
+  gimp_pdb_register_procedure (pdb, procedure);
+  g_object_unref (procedure);
 }
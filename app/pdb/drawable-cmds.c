@@ -32,6 +32,7 @@
 #include "core/gimpchannel-select.h"
 #include "core/gimpdrawable-foreground-extract.h"
 #include "core/gimpdrawable-offset.h"
+#include "core/gimpdrawable-operation.h"
 #include "core/gimpdrawable-preview.h"
 #include "core/gimpdrawable-shadow.h"
 #include "core/gimpdrawable.h"
@@ -40,6 +41,7 @@
 #include "core/gimptempbuf.h"
 #include "gegl/gimp-babl-compat.h"
 #include "gegl/gimp-babl.h"
+#include "gegl/gimp-gegl-nodes.h"
 #include "plug-in/gimpplugin-cleanup.h"
 #include "plug-in/gimpplugin.h"
 #include "plug-in/gimppluginmanager.h"
@@ -694,6 +696,127 @@ drawable_set_pixel_invoker (GimpProcedure         *procedure,
                                            error ? *error : NULL);
 }
 
+static GimpValueArray *
+drawable_get_pixel_rect_invoker (GimpProcedure         *procedure,
+                                 Gimp                  *gimp,
+                                 GimpContext           *context,
+                                 GimpProgress          *progress,
+                                 const GimpValueArray  *args,
+                                 GError               **error)
+{
+  gboolean success = TRUE;
+  GimpValueArray *return_vals;
+  GimpDrawable *drawable;
+  gint32 x;
+  gint32 y;
+  gint32 width;
+  gint32 height;
+  gint32 num_bytes = 0;
+  guint8 *pixels = NULL;
+
+  drawable = gimp_value_get_drawable (gimp_value_array_index (args, 0), gimp);
+  x = g_value_get_int (gimp_value_array_index (args, 1));
+  y = g_value_get_int (gimp_value_array_index (args, 2));
+  width = g_value_get_int (gimp_value_array_index (args, 3));
+  height = g_value_get_int (gimp_value_array_index (args, 4));
+
+  if (success)
+    {
+      const Babl *format = gimp_drawable_get_format (drawable);
+      gint64      n_bytes;
+
+      if (! gimp->plug_in_manager->current_plug_in ||
+          ! gimp_plug_in_precision_enabled (gimp->plug_in_manager->current_plug_in))
+        {
+          format = gimp_babl_compat_u8_format (format);
+        }
+
+      n_bytes = ((gint64) width * height *
+                 babl_format_get_bytes_per_pixel (format));
+
+      if (width  <= gimp_item_get_width  (GIMP_ITEM (drawable)) - x &&
+          height <= gimp_item_get_height (GIMP_ITEM (drawable)) - y &&
+          n_bytes <= G_MAXINT32)
+        {
+          num_bytes = n_bytes;
+          pixels    = g_malloc (num_bytes);
+
+          gegl_buffer_get (gimp_drawable_get_buffer (drawable),
+                           GEGL_RECTANGLE (x, y, width, height), 1.0,
+                           format, pixels,
+                           GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+        }
+      else
+        success = FALSE;
+    }
+
+  return_vals = gimp_procedure_get_return_values (procedure, success,
+                                                  error ? *error : NULL);
+
+  if (success)
+    {
+      g_value_set_int (gimp_value_array_index (return_vals, 1), num_bytes);
+      gimp_value_take_int8array (gimp_value_array_index (return_vals, 2), pixels, num_bytes);
+    }
+
+  return return_vals;
+}
+
+static GimpValueArray *
+drawable_set_pixel_rect_invoker (GimpProcedure         *procedure,
+                                 Gimp                  *gimp,
+                                 GimpContext           *context,
+                                 GimpProgress          *progress,
+                                 const GimpValueArray  *args,
+                                 GError               **error)
+{
+  gboolean success = TRUE;
+  GimpDrawable *drawable;
+  gint32 x;
+  gint32 y;
+  gint32 width;
+  gint32 height;
+  gint32 num_bytes;
+  const guint8 *pixels;
+
+  drawable = gimp_value_get_drawable (gimp_value_array_index (args, 0), gimp);
+  x = g_value_get_int (gimp_value_array_index (args, 1));
+  y = g_value_get_int (gimp_value_array_index (args, 2));
+  width = g_value_get_int (gimp_value_array_index (args, 3));
+  height = g_value_get_int (gimp_value_array_index (args, 4));
+  num_bytes = g_value_get_int (gimp_value_array_index (args, 5));
+  pixels = gimp_value_get_int8array (gimp_value_array_index (args, 6));
+
+  if (success)
+    {
+      const Babl *format = gimp_drawable_get_format (drawable);
+
+      if (! gimp->plug_in_manager->current_plug_in ||
+          ! gimp_plug_in_precision_enabled (gimp->plug_in_manager->current_plug_in))
+        {
+          format = gimp_babl_compat_u8_format (format);
+        }
+
+      if (gimp_pdb_item_is_modifyable (GIMP_ITEM (drawable),
+                                       GIMP_PDB_ITEM_CONTENT, error) &&
+          gimp_pdb_item_is_not_group (GIMP_ITEM (drawable), error) &&
+          width  <= gimp_item_get_width  (GIMP_ITEM (drawable)) - x &&
+          height <= gimp_item_get_height (GIMP_ITEM (drawable)) - y &&
+          num_bytes == ((gint64) width * height *
+                        babl_format_get_bytes_per_pixel (format)))
+        {
+          gegl_buffer_set (gimp_drawable_get_buffer (drawable),
+                           GEGL_RECTANGLE (x, y, width, height),
+                           0, format, pixels, GEGL_AUTO_ROWSTRIDE);
+        }
+      else
+        success = FALSE;
+    }
+
+  return gimp_procedure_get_return_values (procedure, success,
+                                           error ? *error : NULL);
+}
+
 static GimpValueArray *
 drawable_fill_invoker (GimpProcedure         *procedure,
                        Gimp                  *gimp,
@@ -761,6 +884,52 @@ drawable_offset_invoker (GimpProcedure         *procedure,
                                            error ? *error : NULL);
 }
 
+static GimpValueArray *
+drawable_apply_gegl_graph_invoker (GimpProcedure         *procedure,
+                                   Gimp                  *gimp,
+                                   GimpContext           *context,
+                                   GimpProgress          *progress,
+                                   const GimpValueArray  *args,
+                                   GError               **error)
+{
+  gboolean success = TRUE;
+  GimpDrawable *drawable;
+  const gchar *graph;
+
+  drawable = gimp_value_get_drawable (gimp_value_array_index (args, 0), gimp);
+  graph = g_value_get_string (gimp_value_array_index (args, 1));
+
+  if (success)
+    {
+      if (gimp_pdb_item_is_attached (GIMP_ITEM (drawable), NULL,
+                                     GIMP_PDB_ITEM_CONTENT, error) &&
+          gimp_pdb_item_is_not_group (GIMP_ITEM (drawable), error))
+        {
+          GeglNode *node = gimp_gegl_create_graph_node (graph);
+
+          if (node)
+            {
+              gimp_drawable_apply_operation (drawable, progress,
+                                             C_("undo-type", "GEGL Graph"),
+                                             node);
+              g_object_unref (node);
+            }
+          else
+            {
+              g_set_error_literal (error, GIMP_PDB_ERROR,
+                                   GIMP_PDB_ERROR_INVALID_ARGUMENT,
+                                   _("Invalid GEGL graph"));
+              success = FALSE;
+            }
+        }
+      else
+        success = FALSE;
+    }
+
+  return gimp_procedure_get_return_values (procedure, success,
+                                           error ? *error : NULL);
+}
+
 static GimpValueArray *
 drawable_thumbnail_invoker (GimpProcedure         *procedure,
                             Gimp                  *gimp,
@@ -1642,6 +1811,122 @@ register_drawable_procs (GimpPDB *pdb)
   gimp_pdb_register_procedure (pdb, procedure);
   g_object_unref (procedure);
 
+  /*
+   * gimp-drawable-get-pixel-rect
+   */
+  procedure = gimp_procedure_new (drawable_get_pixel_rect_invoker);
+  gimp_object_set_static_name (GIMP_OBJECT (procedure),
+                               "gimp-drawable-get-pixel-rect");
+  gimp_procedure_set_static_strings (procedure,
+                                     "gimp-drawable-get-pixel-rect",
+                                     "Gets the values of the pixels in the specified rectangle.",
+                                     "This procedure gets the values of all pixels in the specified rectangle of the drawable in one call, row by row, without padding between rows. The rectangle must lie completely inside the drawable. Each pixel uses the same number of bytes as 'gimp-drawable-get-pixel' returns for the drawable.",
+                                     "Spencer Kimball & Peter Mattis",
+                                     "Spencer Kimball & Peter Mattis",
+                                     "2016",
+                                     NULL);
+  gimp_procedure_add_argument (procedure,
+                               gimp_param_spec_drawable_id ("drawable",
+                                                            "drawable",
+                                                            "The drawable",
+                                                            pdb->gimp, FALSE,
+                                                            GIMP_PARAM_READWRITE));
+  gimp_procedure_add_argument (procedure,
+                               gimp_param_spec_int32 ("x",
+                                                      "x",
+                                                      "The x coordinate of the rectangle",
+                                                      0, G_MAXINT32, 0,
+                                                      GIMP_PARAM_READWRITE));
+  gimp_procedure_add_argument (procedure,
+                               gimp_param_spec_int32 ("y",
+                                                      "y",
+                                                      "The y coordinate of the rectangle",
+                                                      0, G_MAXINT32, 0,
+                                                      GIMP_PARAM_READWRITE));
+  gimp_procedure_add_argument (procedure,
+                               gimp_param_spec_int32 ("width",
+                                                      "width",
+                                                      "The width of the rectangle",
+                                                      1, G_MAXINT32, 1,
+                                                      GIMP_PARAM_READWRITE));
+  gimp_procedure_add_argument (procedure,
+                               gimp_param_spec_int32 ("height",
+                                                      "height",
+                                                      "The height of the rectangle",
+                                                      1, G_MAXINT32, 1,
+                                                      GIMP_PARAM_READWRITE));
+  gimp_procedure_add_return_value (procedure,
+                                   gimp_param_spec_int32 ("num-bytes",
+                                                          "num bytes",
+                                                          "The number of bytes in the pixels array",
+                                                          0, G_MAXINT32, 0,
+                                                          GIMP_PARAM_READWRITE | GIMP_PARAM_NO_VALIDATE));
+  gimp_procedure_add_return_value (procedure,
+                                   gimp_param_spec_int8_array ("pixels",
+                                                               "pixels",
+                                                               "The pixel values",
+                                                               GIMP_PARAM_READWRITE));
+  gimp_pdb_register_procedure (pdb, procedure);
+  g_object_unref (procedure);
+
+  /*
+   * gimp-drawable-set-pixel-rect
+   */
+  procedure = gimp_procedure_new (drawable_set_pixel_rect_invoker);
+  gimp_object_set_static_name (GIMP_OBJECT (procedure),
+                               "gimp-drawable-set-pixel-rect");
+  gimp_procedure_set_static_strings (procedure,
+                                     "gimp-drawable-set-pixel-rect",
+                                     "Sets the values of the pixels in the specified rectangle.",
+                                     "This procedure sets the values of all pixels in the specified rectangle of the drawable in one call, row by row, without padding between rows. The rectangle must lie completely inside the drawable, and 'num_bytes' must be equal to width * height * the bytes-per-pixel value of 'gimp-drawable-get-pixel'. Like 'gimp-drawable-set-pixel', this function is not undoable, and does not update the drawable's projection; call 'gimp-drawable-update' when done.",
+                                     "Spencer Kimball & Peter Mattis",
+                                     "Spencer Kimball & Peter Mattis",
+                                     "2016",
+                                     NULL);
+  gimp_procedure_add_argument (procedure,
+                               gimp_param_spec_drawable_id ("drawable",
+                                                            "drawable",
+                                                            "The drawable",
+                                                            pdb->gimp, FALSE,
+                                                            GIMP_PARAM_READWRITE));
+  gimp_procedure_add_argument (procedure,
+                               gimp_param_spec_int32 ("x",
+                                                      "x",
+                                                      "The x coordinate of the rectangle",
+                                                      0, G_MAXINT32, 0,
+                                                      GIMP_PARAM_READWRITE));
+  gimp_procedure_add_argument (procedure,
+                               gimp_param_spec_int32 ("y",
+                                                      "y",
+                                                      "The y coordinate of the rectangle",
+                                                      0, G_MAXINT32, 0,
+                                                      GIMP_PARAM_READWRITE));
+  gimp_procedure_add_argument (procedure,
+                               gimp_param_spec_int32 ("width",
+                                                      "width",
+                                                      "The width of the rectangle",
+                                                      1, G_MAXINT32, 1,
+                                                      GIMP_PARAM_READWRITE));
+  gimp_procedure_add_argument (procedure,
+                               gimp_param_spec_int32 ("height",
+                                                      "height",
+                                                      "The height of the rectangle",
+                                                      1, G_MAXINT32, 1,
+                                                      GIMP_PARAM_READWRITE));
+  gimp_procedure_add_argument (procedure,
+                               gimp_param_spec_int32 ("num-bytes",
+                                                      "num bytes",
+                                                      "The number of bytes in the pixels array",
+                                                      0, G_MAXINT32, 0,
+                                                      GIMP_PARAM_READWRITE | GIMP_PARAM_NO_VALIDATE));
+  gimp_procedure_add_argument (procedure,
+                               gimp_param_spec_int8_array ("pixels",
+                                                           "pixels",
+                                                           "The pixel values",
+                                                           GIMP_PARAM_READWRITE));
+  gimp_pdb_register_procedure (pdb, procedure);
+  g_object_unref (procedure);
+
   /*
    * gimp-drawable-fill
    */
@@ -1721,6 +2006,36 @@ register_drawable_procs (GimpPDB *pdb)
   gimp_pdb_register_procedure (pdb, procedure);
   g_object_unref (procedure);
 
+  /*
+   * gimp-drawable-apply-gegl-graph
+   */
+  procedure = gimp_procedure_new (drawable_apply_gegl_graph_invoker);
+  gimp_object_set_static_name (GIMP_OBJECT (procedure),
+                               "gimp-drawable-apply-gegl-graph");
+  gimp_procedure_set_static_strings (procedure,
+                                     "gimp-drawable-apply-gegl-graph",
+                                     "Apply a GEGL graph to the specified drawable.",
+                                     "This procedure applies a GEGL graph, given in GEGL's XML format, to the drawable, inside the GIMP core, like the GEGL filters in the image window do. The drawable's pixels are the graph's input; if the graph doesn't use its \"input\" proxy, the input of its bottom node is connected to it. The result replaces the drawable's pixels inside the selection, as one undo step. No pixels are transferred to the caller.",
+                                     "Spencer Kimball & Peter Mattis",
+                                     "Spencer Kimball & Peter Mattis",
+                                     "2016",
+                                     NULL);
+  gimp_procedure_add_argument (procedure,
+                               gimp_param_spec_drawable_id ("drawable",
+                                                            "drawable",
+                                                            "The drawable",
+                                                            pdb->gimp, FALSE,
+                                                            GIMP_PARAM_READWRITE));
+  gimp_procedure_add_argument (procedure,
+                               gimp_param_spec_string ("graph",
+                                                       "graph",
+                                                       "The GEGL graph, in GEGL XML",
+                                                       FALSE, FALSE, TRUE,
+                                                       NULL,
+                                                       GIMP_PARAM_READWRITE));
+  gimp_pdb_register_procedure (pdb, procedure);
+  g_object_unref (procedure);
+
   /*
    * gimp-drawable-thumbnail
    */
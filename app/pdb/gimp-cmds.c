@@ -32,6 +32,8 @@
 #include "core/gimp-parasites.h"
 #include "core/gimp-utils.h"
 #include "core/gimp.h"
+#include "core/gimpimage.h"
+#include "core/gimpmemorymonitor.h"
 #include "core/gimpparamspecs.h"
 
 #include "gimppdb.h"
@@ -200,6 +202,60 @@ get_parasite_list_invoker (GimpProcedure         *procedure,
   return return_vals;
 }
 
+static GimpValueArray *
+get_memory_usage_invoker (GimpProcedure         *procedure,
+                          Gimp                  *gimp,
+                          GimpContext           *context,
+                          GimpProgress          *progress,
+                          const GimpValueArray  *args,
+                          GError               **error)
+{
+  gboolean success = TRUE;
+  GimpValueArray *return_vals;
+  GimpImage *image;
+  gdouble layers = 0.0;
+  gdouble channels = 0.0;
+  gdouble vectors = 0.0;
+  gdouble undo = 0.0;
+  gdouble undo_swap = 0.0;
+  gdouble projection = 0.0;
+  gdouble temp_buffers = 0.0;
+
+  image = gimp_value_get_image (gimp_value_array_index (args, 0), gimp);
+
+  if (success)
+    {
+      gint64 sizes[GIMP_MEMORY_N_CATEGORIES];
+
+      gimp_memory_monitor_update (gimp->memory_monitor);
+      gimp_memory_monitor_get_usage (gimp->memory_monitor, image, sizes);
+
+      layers       = sizes[GIMP_MEMORY_LAYERS];
+      channels     = sizes[GIMP_MEMORY_CHANNELS];
+      vectors      = sizes[GIMP_MEMORY_VECTORS];
+      undo         = sizes[GIMP_MEMORY_UNDO];
+      undo_swap    = sizes[GIMP_MEMORY_UNDO_SWAP];
+      projection   = sizes[GIMP_MEMORY_PROJECTION];
+      temp_buffers = image ? 0 : sizes[GIMP_MEMORY_TEMP_BUFS];
+    }
+
+  return_vals = gimp_procedure_get_return_values (procedure, success,
+                                                  error ? *error : NULL);
+
+  if (success)
+    {
+      g_value_set_double (gimp_value_array_index (return_vals, 1), layers);
+      g_value_set_double (gimp_value_array_index (return_vals, 2), channels);
+      g_value_set_double (gimp_value_array_index (return_vals, 3), vectors);
+      g_value_set_double (gimp_value_array_index (return_vals, 4), undo);
+      g_value_set_double (gimp_value_array_index (return_vals, 5), undo_swap);
+      g_value_set_double (gimp_value_array_index (return_vals, 6), projection);
+      g_value_set_double (gimp_value_array_index (return_vals, 7), temp_buffers);
+    }
+
+  return return_vals;
+}
+
 void
 register_gimp_procs (GimpPDB *pdb)
 {
@@ -377,4 +433,69 @@ register_gimp_procs (GimpPDB *pdb)
                                                                  GIMP_PARAM_READWRITE));
   gimp_pdb_register_procedure (pdb, procedure);
   g_object_unref (procedure);
+
+  /*
+   * gimp-get-memory-usage
+   */
+  procedure = gimp_procedure_new (get_memory_usage_invoker);
+  gimp_object_set_static_name (GIMP_OBJECT (procedure),
+                               "gimp-get-memory-usage");
+  gimp_procedure_set_static_strings (procedure,
+                                     "gimp-get-memory-usage",
+                                     "Returns the memory used by images and temporary buffers.",
+                                     "This procedure returns the number of bytes used by the layers, channels, paths, undo steps and projection of the specified image, or the sum over all images if no image is specified. The size of undo steps which were moved to the swap is returned separately, and is not part of the undo size. Temporary buffers are not associated with an image, their size is only returned if no image is specified.",
+                                     "Spencer Kimball & Peter Mattis",
+                                     "Spencer Kimball & Peter Mattis",
+                                     "1995-1996",
+                                     NULL);
+  gimp_procedure_add_argument (procedure,
+                               gimp_param_spec_image_id ("image",
+                                                         "image",
+                                                         "The image, or -1 for all images",
+                                                         pdb->gimp, TRUE,
+                                                         GIMP_PARAM_READWRITE));
+  gimp_procedure_add_return_value (procedure,
+                                   g_param_spec_double ("layers",
+                                                        "layers",
+                                                        "The memory used by layers and layer masks",
+                                                        0, G_MAXDOUBLE, 0,
+                                                        GIMP_PARAM_READWRITE));
+  gimp_procedure_add_return_value (procedure,
+                                   g_param_spec_double ("channels",
+                                                        "channels",
+                                                        "The memory used by channels and the selection",
+                                                        0, G_MAXDOUBLE, 0,
+                                                        GIMP_PARAM_READWRITE));
+  gimp_procedure_add_return_value (procedure,
+                                   g_param_spec_double ("vectors",
+                                                        "vectors",
+                                                        "The memory used by paths",
+                                                        0, G_MAXDOUBLE, 0,
+                                                        GIMP_PARAM_READWRITE));
+  gimp_procedure_add_return_value (procedure,
+                                   g_param_spec_double ("undo",
+                                                        "undo",
+                                                        "The memory used by the undo and redo steps",
+                                                        0, G_MAXDOUBLE, 0,
+                                                        GIMP_PARAM_READWRITE));
+  gimp_procedure_add_return_value (procedure,
+                                   g_param_spec_double ("undo-swap",
+                                                        "undo swap",
+                                                        "The swap space used by undo steps",
+                                                        0, G_MAXDOUBLE, 0,
+                                                        GIMP_PARAM_READWRITE));
+  gimp_procedure_add_return_value (procedure,
+                                   g_param_spec_double ("projection",
+                                                        "projection",
+                                                        "The memory used by the projection",
+                                                        0, G_MAXDOUBLE, 0,
+                                                        GIMP_PARAM_READWRITE));
+  gimp_procedure_add_return_value (procedure,
+                                   g_param_spec_double ("temp-buffers",
+                                                        "temp buffers",
+                                                        "The memory used by temporary buffers",
+                                                        0, G_MAXDOUBLE, 0,
+                                                        GIMP_PARAM_READWRITE));
+  gimp_pdb_register_procedure (pdb, procedure);
+  g_object_unref (procedure);
 }
@@ -0,0 +1,496 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimppdb-profile.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <gio/gio.h>
+
+#include "libgimpbase/gimpbase.h"
+
+#include "pdb-types.h"
+
+#include "core/gimp-utils.h"
+
+#include "gimppdb.h"
+#include "gimppdb-profile.h"
+#include "gimpprocedure.h"
+
+#include "gimp-intl.h"
+
+
+/*  The profiler records every procedure run by gimp_procedure_execute()
+ *  while it is enabled.  Calls nest like the C stack they run on, which
+ *  is what lets us tell the time a procedure spent itself from the
+ *  time spent in the procedures it called.  For plug-in procedures
+ *  "itself" is the plug-in process plus the wire, the wire part is
+ *  measured separately around the core's writes and tile transfers.
+ */
+
+#define PROFILE_MAX_EVENTS  (1 << 20)
+
+
+typedef struct _GimpPDBProfileStats GimpPDBProfileStats;
+typedef struct _GimpPDBProfileEntry GimpPDBProfileEntry;
+typedef struct _GimpPDBProfileFrame GimpPDBProfileFrame;
+typedef struct _GimpPDBProfileEvent GimpPDBProfileEvent;
+
+struct _GimpPDBProfileStats
+{
+  gint64   wire_time;
+  guint64  wire_bytes;
+  guint64  tile_bytes;
+  guint64  n_tiles;
+};
+
+struct _GimpPDBProfileEntry
+{
+  const gchar         *name;
+  guint                n_calls;
+  gint64               total_time;
+  gint64               self_time;
+  GimpPDBProfileStats  stats;
+};
+
+struct _GimpPDBProfileFrame
+{
+  GimpProcedure       *procedure;
+  const gchar         *name;
+  gint64               start;
+  gint64               child_time;
+  GimpPDBProfileStats  stats;      /*  the totals when the call began  */
+};
+
+struct _GimpPDBProfileEvent
+{
+  const gchar         *name;
+  gint64               start;
+  gint64               duration;
+  GimpPDBProfileStats  stats;
+};
+
+struct _GimpPDBProfile
+{
+  gboolean             enabled;
+  gint64               start_time;
+
+  GHashTable          *entries;
+  GArray              *frames;
+  GArray              *events;
+  guint                n_dropped;
+
+  gint                 io_depth;
+  GimpPDBProfileStats  totals;
+};
+
+
+static void   gimp_pdb_profile_reset      (GimpPDBProfile            *profile);
+static void   gimp_pdb_profile_stats_diff (GimpPDBProfileStats       *diff,
+                                           const GimpPDBProfileStats *now,
+                                           const GimpPDBProfileStats *then);
+static void   gimp_pdb_profile_stats_add  (GimpPDBProfileStats       *stats,
+                                           const GimpPDBProfileStats *diff);
+
+
+/*  public functions  */
+
+void
+gimp_pdb_profile_set_enabled (GimpPDB  *pdb,
+                              gboolean  enabled)
+{
+  GimpPDBProfile *profile;
+
+  g_return_if_fail (GIMP_IS_PDB (pdb));
+
+  if (! pdb->profile)
+    {
+      if (! enabled)
+        return;
+
+      profile = g_slice_new0 (GimpPDBProfile);
+
+      profile->entries = g_hash_table_new_full (g_direct_hash,
+                                                g_direct_equal,
+                                                NULL,
+                                                g_free);
+      profile->frames  = g_array_new (FALSE, FALSE,
+                                      sizeof (GimpPDBProfileFrame));
+      profile->events  = g_array_new (FALSE, FALSE,
+                                      sizeof (GimpPDBProfileEvent));
+
+      pdb->profile = profile;
+    }
+
+  profile = pdb->profile;
+
+  /*  starting the profiler starts a new profile, stopping it keeps the
+   *  collected data around until it is queried or dumped
+   */
+  if (enabled && ! profile->enabled)
+    gimp_pdb_profile_reset (profile);
+
+  profile->enabled = enabled ? TRUE : FALSE;
+}
+
+gboolean
+gimp_pdb_profile_get_enabled (GimpPDB *pdb)
+{
+  g_return_val_if_fail (GIMP_IS_PDB (pdb), FALSE);
+
+  return pdb->profile && pdb->profile->enabled;
+}
+
+void
+gimp_pdb_profile_free (GimpPDB *pdb)
+{
+  GimpPDBProfile *profile;
+
+  g_return_if_fail (GIMP_IS_PDB (pdb));
+
+  profile = pdb->profile;
+
+  if (! profile)
+    return;
+
+  g_hash_table_unref (profile->entries);
+  g_array_free (profile->frames, TRUE);
+  g_array_free (profile->events, TRUE);
+
+  g_slice_free (GimpPDBProfile, profile);
+
+  pdb->profile = NULL;
+}
+
+void
+gimp_pdb_profile_begin (GimpPDB       *pdb,
+                        GimpProcedure *procedure)
+{
+  GimpPDBProfile      *profile = pdb->profile;
+  GimpPDBProfileFrame  frame;
+
+  if (G_LIKELY (! profile || ! profile->enabled))
+    return;
+
+  frame.procedure  = procedure;
+  frame.name       = g_intern_string (gimp_object_get_name (procedure));
+  frame.child_time = 0;
+  frame.stats      = profile->totals;
+  frame.start      = g_get_monotonic_time ();
+
+  g_array_append_val (profile->frames, frame);
+}
+
+void
+gimp_pdb_profile_end (GimpPDB       *pdb,
+                      GimpProcedure *procedure)
+{
+  GimpPDBProfile      *profile = pdb->profile;
+  GimpPDBProfileFrame *frame;
+  GimpPDBProfileEntry *entry;
+  GimpPDBProfileStats  diff;
+  gint64               duration;
+
+  /*  calls that were running when the current profile was started
+   *  have no frame, just ignore them
+   */
+  if (G_LIKELY (! profile || profile->frames->len == 0))
+    return;
+
+  frame = &g_array_index (profile->frames, GimpPDBProfileFrame,
+                          profile->frames->len - 1);
+
+  if (frame->procedure != procedure)
+    return;
+
+  duration = g_get_monotonic_time () - frame->start;
+
+  gimp_pdb_profile_stats_diff (&diff, &profile->totals, &frame->stats);
+
+  entry = g_hash_table_lookup (profile->entries, frame->name);
+
+  if (! entry)
+    {
+      entry = g_new0 (GimpPDBProfileEntry, 1);
+
+      entry->name = frame->name;
+
+      g_hash_table_insert (profile->entries, (gpointer) entry->name, entry);
+    }
+
+  entry->n_calls++;
+  entry->total_time += duration;
+  entry->self_time  += MAX (duration - frame->child_time, 0);
+
+  gimp_pdb_profile_stats_add (&entry->stats, &diff);
+
+  if (profile->events->len < PROFILE_MAX_EVENTS)
+    {
+      GimpPDBProfileEvent event;
+
+      event.name     = frame->name;
+      event.start    = frame->start - profile->start_time;
+      event.duration = duration;
+      event.stats    = diff;
+
+      g_array_append_val (profile->events, event);
+    }
+  else
+    {
+      profile->n_dropped++;
+    }
+
+  g_array_set_size (profile->frames, profile->frames->len - 1);
+
+  if (profile->frames->len > 0)
+    {
+      frame = &g_array_index (profile->frames, GimpPDBProfileFrame,
+                              profile->frames->len - 1);
+
+      frame->child_time += duration;
+    }
+}
+
+/*  Returns the time to pass to gimp_pdb_profile_io_end(), or 0 if the
+ *  profiler is off.  Nested I/O, like the writes done while sending a
+ *  tile, is only timed once.
+ */
+gint64
+gimp_pdb_profile_io_begin (GimpPDB *pdb)
+{
+  GimpPDBProfile *profile = pdb->profile;
+
+  if (G_LIKELY (! profile || ! profile->enabled))
+    return 0;
+
+  profile->io_depth++;
+
+  return g_get_monotonic_time ();
+}
+
+void
+gimp_pdb_profile_io_end (GimpPDB *pdb,
+                         gint64   start,
+                         gsize    wire_bytes,
+                         gsize    tile_bytes,
+                         gint     n_tiles)
+{
+  GimpPDBProfile *profile = pdb->profile;
+
+  if (G_LIKELY (start == 0 || ! profile))
+    return;
+
+  profile->io_depth--;
+
+  if (profile->io_depth == 0)
+    profile->totals.wire_time += g_get_monotonic_time () - start;
+
+  profile->totals.wire_bytes += wire_bytes;
+  profile->totals.tile_bytes += tile_bytes;
+  profile->totals.n_tiles    += n_tiles;
+}
+
+gchar **
+gimp_pdb_profile_get_procedures (GimpPDB *pdb,
+                                 gint    *n_procedures)
+{
+  GHashTableIter  iter;
+  gpointer        key;
+  gchar         **names;
+  gint            i = 0;
+
+  g_return_val_if_fail (GIMP_IS_PDB (pdb), NULL);
+  g_return_val_if_fail (n_procedures != NULL, NULL);
+
+  if (! pdb->profile || g_hash_table_size (pdb->profile->entries) == 0)
+    {
+      *n_procedures = 0;
+
+      return NULL;
+    }
+
+  *n_procedures = g_hash_table_size (pdb->profile->entries);
+
+  names = g_new (gchar *, *n_procedures);
+
+  g_hash_table_iter_init (&iter, pdb->profile->entries);
+
+  while (g_hash_table_iter_next (&iter, &key, NULL))
+    names[i++] = g_strdup (key);
+
+  return names;
+}
+
+gboolean
+gimp_pdb_profile_get_stats (GimpPDB     *pdb,
+                            const gchar *procedure_name,
+                            gint        *n_calls,
+                            gdouble     *total_time,
+                            gdouble     *self_time,
+                            gdouble     *wire_time,
+                            gdouble     *wire_bytes,
+                            gdouble     *tile_bytes,
+                            gint        *n_tiles)
+{
+  GimpPDBProfileEntry *entry = NULL;
+
+  g_return_val_if_fail (GIMP_IS_PDB (pdb), FALSE);
+  g_return_val_if_fail (procedure_name != NULL, FALSE);
+
+  if (pdb->profile)
+    entry = g_hash_table_lookup (pdb->profile->entries,
+                                 g_intern_string (procedure_name));
+
+  if (! entry)
+    return FALSE;
+
+  if (n_calls)    *n_calls    = entry->n_calls;
+  if (total_time) *total_time = (gdouble) entry->total_time / G_TIME_SPAN_SECOND;
+  if (self_time)  *self_time  = (gdouble) entry->self_time  / G_TIME_SPAN_SECOND;
+  if (wire_time)  *wire_time  = (gdouble) entry->stats.wire_time / G_TIME_SPAN_SECOND;
+  if (wire_bytes) *wire_bytes = entry->stats.wire_bytes;
+  if (tile_bytes) *tile_bytes = entry->stats.tile_bytes;
+  if (n_tiles)    *n_tiles    = MIN (entry->stats.n_tiles, G_MAXINT);
+
+  return TRUE;
+}
+
+/*  Writes the recorded calls in the Trace Event Format understood by
+ *  chrome://tracing and similar viewers, one complete ("X") event per
+ *  call with timestamps in microseconds since the profile was started.
+ *  Procedure names are canonical and need no escaping.
+ */
+gboolean
+gimp_pdb_profile_dump (GimpPDB  *pdb,
+                       GFile    *file,
+                       GError  **error)
+{
+  GOutputStream *output;
+  GArray        *events;
+  GError        *my_error = NULL;
+  gint           pid;
+  guint          i;
+
+  g_return_val_if_fail (GIMP_IS_PDB (pdb), FALSE);
+  g_return_val_if_fail (G_IS_FILE (file), FALSE);
+  g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  output = G_OUTPUT_STREAM (g_file_replace (file,
+                                            NULL, FALSE, G_FILE_CREATE_NONE,
+                                            NULL, error));
+  if (! output)
+    return FALSE;
+
+  events = pdb->profile ? pdb->profile->events : NULL;
+  pid    = gimp_get_pid ();
+
+  if (! g_output_stream_printf (output, NULL, NULL, &my_error,
+                                "{\n"
+                                "\"displayTimeUnit\": \"ms\",\n"
+                                "\"droppedEvents\": %u,\n"
+                                "\"traceEvents\": [\n"
+                                "{\"name\": \"process_name\", \"ph\": \"M\", "
+                                "\"pid\": %d, \"tid\": 1, "
+                                "\"args\": {\"name\": \"GIMP\"}}",
+                                pdb->profile ? pdb->profile->n_dropped : 0,
+                                pid))
+    goto error;
+
+  for (i = 0; events && i < events->len; i++)
+    {
+      GimpPDBProfileEvent *event = &g_array_index (events,
+                                                   GimpPDBProfileEvent, i);
+
+      if (! g_output_stream_printf (output, NULL, NULL, &my_error,
+                                    ",\n"
+                                    "{\"name\": \"%s\", \"cat\": \"pdb\", "
+                                    "\"ph\": \"X\", \"pid\": %d, \"tid\": 1, "
+                                    "\"ts\": %" G_GINT64_FORMAT ", "
+                                    "\"dur\": %" G_GINT64_FORMAT ", "
+                                    "\"args\": {"
+                                    "\"wire-time\": %" G_GINT64_FORMAT ", "
+                                    "\"wire-bytes\": %" G_GUINT64_FORMAT ", "
+                                    "\"tile-bytes\": %" G_GUINT64_FORMAT ", "
+                                    "\"tiles\": %" G_GUINT64_FORMAT "}}",
+                                    event->name, pid,
+                                    event->start,
+                                    event->duration,
+                                    event->stats.wire_time,
+                                    event->stats.wire_bytes,
+                                    event->stats.tile_bytes,
+                                    event->stats.n_tiles))
+        goto error;
+    }
+
+  if (! g_output_stream_printf (output, NULL, NULL, &my_error,
+                                "\n]\n}\n") ||
+      ! g_output_stream_close (output, NULL, &my_error))
+    goto error;
+
+  g_object_unref (output);
+
+  return TRUE;
+
+ error:
+  g_set_error (error, my_error->domain, my_error->code,
+               _("Writing profile file '%s' failed: %s"),
+               gimp_file_get_utf8_name (file), my_error->message);
+  g_clear_error (&my_error);
+  g_object_unref (output);
+
+  return FALSE;
+}
+
+
+/*  private functions  */
+
+static void
+gimp_pdb_profile_reset (GimpPDBProfile *profile)
+{
+  g_hash_table_remove_all (profile->entries);
+  g_array_set_size (profile->frames, 0);
+  g_array_set_size (profile->events, 0);
+
+  profile->n_dropped  = 0;
+  profile->start_time = g_get_monotonic_time ();
+
+  /*  io_depth is left alone, an I/O operation may be in progress  */
+  memset (&profile->totals, 0, sizeof (GimpPDBProfileStats));
+}
+
+static void
+gimp_pdb_profile_stats_diff (GimpPDBProfileStats       *diff,
+                             const GimpPDBProfileStats *now,
+                             const GimpPDBProfileStats *then)
+{
+  diff->wire_time  = now->wire_time  - then->wire_time;
+  diff->wire_bytes = now->wire_bytes - then->wire_bytes;
+  diff->tile_bytes = now->tile_bytes - then->tile_bytes;
+  diff->n_tiles    = now->n_tiles    - then->n_tiles;
+}
+
+static void
+gimp_pdb_profile_stats_add (GimpPDBProfileStats       *stats,
+                            const GimpPDBProfileStats *diff)
+{
+  stats->wire_time  += diff->wire_time;
+  stats->wire_bytes += diff->wire_bytes;
+  stats->tile_bytes += diff->tile_bytes;
+  stats->n_tiles    += diff->n_tiles;
+}
@@ -0,0 +1,58 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimppdb-profile.h
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GIMP_PDB_PROFILE_H__
+#define __GIMP_PDB_PROFILE_H__
+
+
+void       gimp_pdb_profile_set_enabled    (GimpPDB        *pdb,
+                                            gboolean        enabled);
+gboolean   gimp_pdb_profile_get_enabled    (GimpPDB        *pdb);
+void       gimp_pdb_profile_free           (GimpPDB        *pdb);
+
+void       gimp_pdb_profile_begin          (GimpPDB        *pdb,
+                                            GimpProcedure  *procedure);
+void       gimp_pdb_profile_end            (GimpPDB        *pdb,
+                                            GimpProcedure  *procedure);
+
+gint64     gimp_pdb_profile_io_begin       (GimpPDB        *pdb);
+void       gimp_pdb_profile_io_end         (GimpPDB        *pdb,
+                                            gint64          start,
+                                            gsize           wire_bytes,
+                                            gsize           tile_bytes,
+                                            gint            n_tiles);
+
+gchar   ** gimp_pdb_profile_get_procedures (GimpPDB        *pdb,
+                                            gint           *n_procedures);
+gboolean   gimp_pdb_profile_get_stats      (GimpPDB        *pdb,
+                                            const gchar    *procedure_name,
+                                            gint           *n_calls,
+                                            gdouble        *total_time,
+                                            gdouble        *self_time,
+                                            gdouble        *wire_time,
+                                            gdouble        *wire_bytes,
+                                            gdouble        *tile_bytes,
+                                            gint           *n_tiles);
+
+gboolean   gimp_pdb_profile_dump           (GimpPDB        *pdb,
+                                            GFile          *file,
+                                            GError        **error);
+
+
+#endif /* __GIMP_PDB_PROFILE_H__ */
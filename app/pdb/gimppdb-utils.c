@@ -33,6 +33,7 @@
 #include "core/gimpimage-guides.h"
 #include "core/gimpitem.h"
 
+#include "text/gimp-fonts.h"
 #include "text/gimptextlayer.h"
 
 #include "vectors/gimpvectors.h"
@@ -269,6 +270,8 @@ gimp_pdb_get_font (Gimp         *gimp,
       return NULL;
     }
 
+  gimp_fonts_wait (gimp);
+
   font = (GimpFont *)
     gimp_container_get_child_by_name (gimp->fonts, name);
 
@@ -36,6 +36,7 @@
 #include "core/gimpprogress.h"
 
 #include "gimppdb.h"
+#include "gimppdb-profile.h"
 #include "gimppdberror.h"
 #include "gimpprocedure.h"
 
@@ -130,6 +131,8 @@ gimp_pdb_finalize (GObject *object)
       pdb->compat_proc_names = NULL;
     }
 
+  gimp_pdb_profile_free (pdb);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
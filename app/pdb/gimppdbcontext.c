@@ -150,6 +150,11 @@ gimp_pdb_context_init (GimpPDBContext *context)
 {
   context->paint_options_list = gimp_list_new (GIMP_TYPE_PAINT_OPTIONS,
                                                FALSE);
+
+  /*  the options in paint_options_list which still belong to the
+   *  context this one was pushed from, see gimp_pdb_context_new()
+   */
+  context->shared_paint_options = g_hash_table_new (NULL, NULL);
 }
 
 static void
@@ -197,6 +202,12 @@ gimp_pdb_context_finalize (GObject *object)
       context->paint_options_list = NULL;
     }
 
+  if (context->shared_paint_options)
+    {
+      g_hash_table_unref (context->shared_paint_options);
+      context->shared_paint_options = NULL;
+    }
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -336,6 +347,11 @@ gimp_pdb_context_new (Gimp        *gimp,
                           "name", "PDB Context",
                           NULL);
 
+  /*  nobody is connected to the new context yet, don't emit a notify
+   *  for every single property that is copied
+   */
+  g_object_freeze_notify (G_OBJECT (context));
+
   gimp_config_sync (G_OBJECT (parent), G_OBJECT (context), 0);
 
   if (set_parent)
@@ -356,18 +372,24 @@ gimp_pdb_context_new (Gimp        *gimp,
     }
   else
     {
+      /*  share the parent's paint options instead of copying them all,
+       *  most pushed contexts never change any of them, and
+       *  gimp_pdb_context_get_writable_paint_options() copies the ones
+       *  that are changed
+       */
       for (list = GIMP_LIST (GIMP_PDB_CONTEXT (parent)->paint_options_list)->list;
            list;
            list = g_list_next (list))
         {
-          GimpPaintOptions *options = gimp_config_duplicate (list->data);
-
           gimp_container_add (context->paint_options_list,
-                              GIMP_OBJECT (options));
-          g_object_unref (options);
+                              GIMP_OBJECT (list->data));
+
+          g_hash_table_add (context->shared_paint_options, list->data);
         }
     }
 
+  g_object_thaw_notify (G_OBJECT (context));
+
   return GIMP_CONTEXT (context);
 }
 
@@ -384,6 +406,44 @@ gimp_pdb_context_get_paint_options (GimpPDBContext *context,
     gimp_container_get_child_by_name (context->paint_options_list, name);
 }
 
+/*  Like gimp_pdb_context_get_paint_options(), but the returned options
+ *  may be modified: if they are still shared with the context this one
+ *  was pushed from, they are replaced by a private copy first.
+ */
+GimpPaintOptions *
+gimp_pdb_context_get_writable_paint_options (GimpPDBContext *context,
+                                             const gchar    *name)
+{
+  GimpPaintOptions *options;
+
+  g_return_val_if_fail (GIMP_IS_PDB_CONTEXT (context), NULL);
+
+  options = gimp_pdb_context_get_paint_options (context, name);
+
+  if (options &&
+      g_hash_table_remove (context->shared_paint_options, options))
+    {
+      GimpPaintOptions *copy  = gimp_config_duplicate (GIMP_CONFIG (options));
+      gint              index;
+
+      index = gimp_container_get_child_index (context->paint_options_list,
+                                              GIMP_OBJECT (options));
+
+      gimp_container_remove (context->paint_options_list,
+                             GIMP_OBJECT (options));
+      gimp_container_insert (context->paint_options_list,
+                             GIMP_OBJECT (copy), index);
+      g_object_unref (copy);
+
+      options = copy;
+    }
+
+  return options;
+}
+
+/*  Returns the options of all brush based paint methods, for setting a
+ *  brush property on all of them, so they are writable.
+ */
 GList *
 gimp_pdb_context_get_brush_options (GimpPDBContext *context)
 {
@@ -402,5 +462,15 @@ gimp_pdb_context_get_brush_options (GimpPDBContext *context)
         brush_options = g_list_prepend (brush_options, options);
     }
 
+  for (list = brush_options; list; list = g_list_next (list))
+    {
+      GimpPaintOptions *options = list->data;
+
+      if (g_hash_table_contains (context->shared_paint_options, options))
+        list->data =
+          gimp_pdb_context_get_writable_paint_options (context,
+                                                       gimp_object_get_name (options));
+    }
+
   return g_list_reverse (brush_options);
 }
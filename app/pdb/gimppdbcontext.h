@@ -53,6 +53,7 @@ struct _GimpPDBContext
   GimpTransformResize     transform_resize;
 
   GimpContainer          *paint_options_list;
+  GHashTable             *shared_paint_options;
 };
 
 struct _GimpPDBContextClass
@@ -69,6 +70,9 @@ GimpContext      * gimp_pdb_context_new               (Gimp           *gimp,
 
 GimpPaintOptions * gimp_pdb_context_get_paint_options (GimpPDBContext *context,
                                                        const gchar    *name);
+GimpPaintOptions * gimp_pdb_context_get_writable_paint_options
+                                                      (GimpPDBContext *context,
+                                                       const gchar    *name);
 GList            * gimp_pdb_context_get_brush_options (GimpPDBContext *context);
 
 
@@ -36,6 +36,8 @@
 
 #include "vectors/gimpvectors.h"
 
+#include "gimppdb.h"
+#include "gimppdb-profile.h"
 #include "gimppdbcontext.h"
 #include "gimppdberror.h"
 #include "gimpprocedure.h"
@@ -329,6 +331,8 @@ gimp_procedure_execute (GimpProcedure   *procedure,
   else
     context = gimp_pdb_context_new (gimp, context, TRUE);
 
+  gimp_pdb_profile_begin (gimp->pdb, procedure);
+
   /*  call the procedure  */
   return_vals = GIMP_PROCEDURE_GET_CLASS (procedure)->execute (procedure,
                                                                gimp,
@@ -337,6 +341,8 @@ gimp_procedure_execute (GimpProcedure   *procedure,
                                                                args,
                                                                error);
 
+  gimp_pdb_profile_end (gimp->pdb, procedure);
+
   g_object_unref (context);
 
   if (return_vals)
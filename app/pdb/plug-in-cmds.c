@@ -400,6 +400,37 @@ plugin_precision_enabled_invoker (GimpProcedure         *procedure,
   return return_vals;
 }
 
+static GimpValueArray *
+plugin_set_resident_invoker (GimpProcedure         *procedure,
+                             Gimp                  *gimp,
+                             GimpContext           *context,
+                             GimpProgress          *progress,
+                             const GimpValueArray  *args,
+                             GError               **error)
+{
+  gboolean success = TRUE;
+  gboolean resident;
+
+  resident = g_value_get_boolean (gimp_value_array_index (args, 0));
+
+  if (success)
+    {
+      GimpPlugIn *plug_in = gimp->plug_in_manager->current_plug_in;
+
+      if (plug_in)
+        {
+          success = gimp_plug_in_set_resident (plug_in, resident);
+        }
+      else
+        {
+          success = FALSE;
+        }
+    }
+
+  return gimp_procedure_get_return_values (procedure, success,
+                                           error ? *error : NULL);
+}
+
 void
 register_plug_in_procs (GimpPDB *pdb)
 {
@@ -748,4 +779,27 @@ register_plug_in_procs (GimpPDB *pdb)
                                                          GIMP_PARAM_READWRITE));
   gimp_pdb_register_procedure (pdb, procedure);
   g_object_unref (procedure);
+
+  /*
+   * gimp-plugin-set-resident
+   */
+  procedure = gimp_procedure_new (plugin_set_resident_invoker);
+  gimp_object_set_static_name (GIMP_OBJECT (procedure),
+                               "gimp-plugin-set-resident");
+  gimp_procedure_set_static_strings (procedure,
+                                     "gimp-plugin-set-resident",
+                                     "Keeps this plug-in running for the next call to one of its procedures.",
+                                     "Asks GIMP to keep this plug-in's process running after the current procedure returned, so that the next call to any procedure of the same plug-in is served by it instead of by a newly started process. Only plug-in procedures, not extensions, can be resident. GIMP closes idle resident plug-ins after a while.",
+                                     "Spencer Kimball & Peter Mattis",
+                                     "Spencer Kimball & Peter Mattis",
+                                     "1995-1996",
+                                     NULL);
+  gimp_procedure_add_argument (procedure,
+                               g_param_spec_boolean ("resident",
+                                                     "resident",
+                                                     "Whether the plug-in stays resident",
+                                                     FALSE,
+                                                     GIMP_PARAM_READWRITE));
+  gimp_pdb_register_procedure (pdb, procedure);
+  g_object_unref (procedure);
 }
@@ -33,6 +33,7 @@
 #include "core/gimpparamspecs-desc.h"
 #include "core/gimpparamspecs.h"
 #include "gimp-pdb-compat.h"
+#include "gimppdb-profile.h"
 #include "gimppdb-query.h"
 #include "plug-in/gimppluginmanager-data.h"
 
@@ -480,6 +481,124 @@ procedural_db_set_data_invoker (GimpProcedure         *procedure,
                                            error ? *error : NULL);
 }
 
+static GimpValueArray *
+procedural_db_set_profiling_invoker (GimpProcedure         *procedure,
+                                     Gimp                  *gimp,
+                                     GimpContext           *context,
+                                     GimpProgress          *progress,
+                                     const GimpValueArray  *args,
+                                     GError               **error)
+{
+  gboolean success = TRUE;
+  gboolean enabled;
+
+  enabled = g_value_get_boolean (gimp_value_array_index (args, 0));
+
+  if (success)
+    {
+      gimp_pdb_profile_set_enabled (gimp->pdb, enabled);
+    }
+
+  return gimp_procedure_get_return_values (procedure, success,
+                                           error ? *error : NULL);
+}
+
+static GimpValueArray *
+procedural_db_get_profile_invoker (GimpProcedure         *procedure,
+                                   Gimp                  *gimp,
+                                   GimpContext           *context,
+                                   GimpProgress          *progress,
+                                   const GimpValueArray  *args,
+                                   GError               **error)
+{
+  GimpValueArray *return_vals;
+  gint32 num_procedures = 0;
+  gchar **procedure_names = NULL;
+
+  procedure_names = gimp_pdb_profile_get_procedures (gimp->pdb,
+                                                     &num_procedures);
+
+  return_vals = gimp_procedure_get_return_values (procedure, TRUE, NULL);
+
+  g_value_set_int (gimp_value_array_index (return_vals, 1), num_procedures);
+  gimp_value_take_stringarray (gimp_value_array_index (return_vals, 2), procedure_names, num_procedures);
+
+  return return_vals;
+}
+
+static GimpValueArray *
+procedural_db_proc_profile_invoker (GimpProcedure         *procedure,
+                                    Gimp                  *gimp,
+                                    GimpContext           *context,
+                                    GimpProgress          *progress,
+                                    const GimpValueArray  *args,
+                                    GError               **error)
+{
+  gboolean success = TRUE;
+  GimpValueArray *return_vals;
+  const gchar *procedure_name;
+  gint32 num_calls = 0;
+  gdouble total_time = 0.0;
+  gdouble self_time = 0.0;
+  gdouble wire_time = 0.0;
+  gdouble wire_bytes = 0.0;
+  gdouble tile_bytes = 0.0;
+  gint32 num_tiles = 0;
+
+  procedure_name = g_value_get_string (gimp_value_array_index (args, 0));
+
+  if (success)
+    {
+      success = gimp_pdb_profile_get_stats (gimp->pdb, procedure_name,
+                                            &num_calls,
+                                            &total_time, &self_time, &wire_time,
+                                            &wire_bytes, &tile_bytes,
+                                            &num_tiles);
+    }
+
+  return_vals = gimp_procedure_get_return_values (procedure, success,
+                                                  error ? *error : NULL);
+
+  if (success)
+    {
+      g_value_set_int (gimp_value_array_index (return_vals, 1), num_calls);
+      g_value_set_double (gimp_value_array_index (return_vals, 2), total_time);
+      g_value_set_double (gimp_value_array_index (return_vals, 3), self_time);
+      g_value_set_double (gimp_value_array_index (return_vals, 4), wire_time);
+      g_value_set_double (gimp_value_array_index (return_vals, 5), wire_bytes);
+      g_value_set_double (gimp_value_array_index (return_vals, 6), tile_bytes);
+      g_value_set_int (gimp_value_array_index (return_vals, 7), num_tiles);
+    }
+
+  return return_vals;
+}
+
+static GimpValueArray *
+procedural_db_dump_profile_invoker (GimpProcedure         *procedure,
+                                    Gimp                  *gimp,
+                                    GimpContext           *context,
+                                    GimpProgress          *progress,
+                                    const GimpValueArray  *args,
+                                    GError               **error)
+{
+  gboolean success = TRUE;
+  const gchar *filename;
+
+  filename = g_value_get_string (gimp_value_array_index (args, 0));
+
+  if (success)
+    {
+      GFile *file = g_file_new_for_path (filename);
+
+      success = gimp_pdb_profile_dump (gimp->pdb, file, error);
+
+      g_object_unref (file);
+    }
+
+  return gimp_procedure_get_return_values (procedure, success,
+                                           error ? *error : NULL);
+}
+
 void
 register_procedural_db_procs (GimpPDB *pdb)
 {
@@ -923,4 +1042,145 @@ register_procedural_db_procs (GimpPDB *pdb)
                                                            GIMP_PARAM_READWRITE));
   gimp_pdb_register_procedure (pdb, procedure);
   g_object_unref (procedure);
+
+  /*
+   * gimp-procedural-db-set-profiling
+   */
+  procedure = gimp_procedure_new (procedural_db_set_profiling_invoker);
+  gimp_object_set_static_name (GIMP_OBJECT (procedure),
+                               "gimp-procedural-db-set-profiling");
+  gimp_procedure_set_static_strings (procedure,
+                                     "gimp-procedural-db-set-profiling",
+                                     "Starts or stops recording statistics about procedure calls.",
+                                     "While profiling is enabled, GIMP records the number of calls, the time spent and the amount of data sent to plug-ins for every procedure that is run. Enabling profiling discards the statistics collected before, disabling it keeps them for 'gimp-procedural-db-get-profile', 'gimp-procedural-db-proc-profile' and 'gimp-procedural-db-dump-profile'.",
+                                     "Spencer Kimball & Peter Mattis",
+                                     "Spencer Kimball & Peter Mattis",
+                                     "1995-1996",
+                                     NULL);
+  gimp_procedure_add_argument (procedure,
+                               g_param_spec_boolean ("enabled",
+                                                     "enabled",
+                                                     "Whether procedure calls are recorded",
+                                                     FALSE,
+                                                     GIMP_PARAM_READWRITE));
+  gimp_pdb_register_procedure (pdb, procedure);
+  g_object_unref (procedure);
+
+  /*
+   * gimp-procedural-db-get-profile
+   */
+  procedure = gimp_procedure_new (procedural_db_get_profile_invoker);
+  gimp_object_set_static_name (GIMP_OBJECT (procedure),
+                               "gimp-procedural-db-get-profile");
+  gimp_procedure_set_static_strings (procedure,
+                                     "gimp-procedural-db-get-profile",
+                                     "Returns the procedures that were called while profiling.",
+                                     "This procedure returns the names of all procedures which were called since profiling was last enabled using 'gimp-procedural-db-set-profiling'. Use 'gimp-procedural-db-proc-profile' to get the statistics of each of them.",
+                                     "Spencer Kimball & Peter Mattis",
+                                     "Spencer Kimball & Peter Mattis",
+                                     "1995-1996",
+                                     NULL);
+  gimp_procedure_add_return_value (procedure,
+                                   gimp_param_spec_int32 ("num-procedures",
+                                                          "num procedures",
+                                                          "The number of profiled procedures",
+                                                          0, G_MAXINT32, 0,
+                                                          GIMP_PARAM_READWRITE));
+  gimp_procedure_add_return_value (procedure,
+                                   gimp_param_spec_string_array ("procedure-names",
+                                                                 "procedure names",
+                                                                 "The names of the profiled procedures",
+                                                                 GIMP_PARAM_READWRITE));
+  gimp_pdb_register_procedure (pdb, procedure);
+  g_object_unref (procedure);
+
+  /*
+   * gimp-procedural-db-proc-profile
+   */
+  procedure = gimp_procedure_new (procedural_db_proc_profile_invoker);
+  gimp_object_set_static_name (GIMP_OBJECT (procedure),
+                               "gimp-procedural-db-proc-profile");
+  gimp_procedure_set_static_strings (procedure,
+                                     "gimp-procedural-db-proc-profile",
+                                     "Returns the statistics recorded for a procedure while profiling.",
+                                     "This procedure returns the number of calls of the specified procedure since profiling was enabled, and the time spent in them. The self time excludes the time spent in the procedures it called; for a plug-in procedure that is the time the plug-in spent computing, and communicating with GIMP. The part of it GIMP spent sending data and transferring tiles is returned as wire time. Times are in seconds.",
+                                     "Spencer Kimball & Peter Mattis",
+                                     "Spencer Kimball & Peter Mattis",
+                                     "1995-1996",
+                                     NULL);
+  gimp_procedure_add_argument (procedure,
+                               gimp_param_spec_string ("procedure-name",
+                                                       "procedure name",
+                                                       "The procedure name",
+                                                       FALSE, FALSE, TRUE,
+                                                       NULL,
+                                                       GIMP_PARAM_READWRITE));
+  gimp_procedure_add_return_value (procedure,
+                                   gimp_param_spec_int32 ("num-calls",
+                                                          "num calls",
+                                                          "The number of calls",
+                                                          0, G_MAXINT32, 0,
+                                                          GIMP_PARAM_READWRITE));
+  gimp_procedure_add_return_value (procedure,
+                                   g_param_spec_double ("total-time",
+                                                        "total time",
+                                                        "The time spent in the procedure",
+                                                        0, G_MAXDOUBLE, 0,
+                                                        GIMP_PARAM_READWRITE));
+  gimp_procedure_add_return_value (procedure,
+                                   g_param_spec_double ("self-time",
+                                                        "self time",
+                                                        "The time spent in the procedure itself",
+                                                        0, G_MAXDOUBLE, 0,
+                                                        GIMP_PARAM_READWRITE));
+  gimp_procedure_add_return_value (procedure,
+                                   g_param_spec_double ("wire-time",
+                                                        "wire time",
+                                                        "The time spent talking to plug-ins",
+                                                        0, G_MAXDOUBLE, 0,
+                                                        GIMP_PARAM_READWRITE));
+  gimp_procedure_add_return_value (procedure,
+                                   g_param_spec_double ("wire-bytes",
+                                                        "wire bytes",
+                                                        "The number of bytes sent to plug-ins",
+                                                        0, G_MAXDOUBLE, 0,
+                                                        GIMP_PARAM_READWRITE));
+  gimp_procedure_add_return_value (procedure,
+                                   g_param_spec_double ("tile-bytes",
+                                                        "tile bytes",
+                                                        "The number of bytes of pixel data transferred",
+                                                        0, G_MAXDOUBLE, 0,
+                                                        GIMP_PARAM_READWRITE));
+  gimp_procedure_add_return_value (procedure,
+                                   gimp_param_spec_int32 ("num-tiles",
+                                                          "num tiles",
+                                                          "The number of tiles transferred",
+                                                          0, G_MAXINT32, 0,
+                                                          GIMP_PARAM_READWRITE));
+  gimp_pdb_register_procedure (pdb, procedure);
+  g_object_unref (procedure);
+
+  /*
+   * gimp-procedural-db-dump-profile
+   */
+  procedure = gimp_procedure_new (procedural_db_dump_profile_invoker);
+  gimp_object_set_static_name (GIMP_OBJECT (procedure),
+                               "gimp-procedural-db-dump-profile");
+  gimp_procedure_set_static_strings (procedure,
+                                     "gimp-procedural-db-dump-profile",
+                                     "Writes the calls recorded while profiling to a trace file.",
+                                     "This procedure writes every procedure call recorded since profiling was enabled to the specified file, in the JSON trace event format which can be viewed with chrome://tracing and compatible tools.",
+                                     "Spencer Kimball & Peter Mattis",
+                                     "Spencer Kimball & Peter Mattis",
+                                     "1995-1996",
+                                     NULL);
+  gimp_procedure_add_argument (procedure,
+                               gimp_param_spec_string ("filename",
+                                                       "filename",
+                                                       "The trace filename",
+                                                       TRUE, FALSE, TRUE,
+                                                       NULL,
+                                                       GIMP_PARAM_READWRITE));
+  gimp_pdb_register_procedure (pdb, procedure);
+  g_object_unref (procedure);
 }
@@ -40,12 +40,14 @@
 
 #include "pdb/gimp-pdb-compat.h"
 #include "pdb/gimppdb.h"
+#include "pdb/gimppdb-profile.h"
 #include "pdb/gimppdberror.h"
 
 #include "gimpplugin.h"
 #include "gimpplugin-cleanup.h"
 #include "gimpplugin-message.h"
 #include "gimppluginmanager.h"
+#include "gimppluginmanager-resident.h"
 #include "gimpplugindef.h"
 #include "gimppluginshm.h"
 #include "gimptemporaryprocedure.h"
@@ -60,9 +62,22 @@ static void gimp_plug_in_handle_quit             (GimpPlugIn      *plug_in);
 static void gimp_plug_in_handle_tile_request     (GimpPlugIn      *plug_in,
                                                   GPTileReq       *request);
 static void gimp_plug_in_handle_tile_put         (GimpPlugIn      *plug_in,
-                                                  GPTileReq       *request);
+                                                  GPTileReq       *request,
+                                                  gsize           *tile_bytes,
+                                                  gint            *n_tiles_sent);
 static void gimp_plug_in_handle_tile_get         (GimpPlugIn      *plug_in,
-                                                  GPTileReq       *request);
+                                                  GPTileReq       *request,
+                                                  gsize           *tile_bytes,
+                                                  gint            *n_tiles_sent);
+static void gimp_plug_in_handle_tile_run_request (GimpPlugIn      *plug_in,
+                                                  GPTileRunReq    *request);
+static void gimp_plug_in_handle_tile_run_get     (GimpPlugIn      *plug_in,
+                                                  gint32           drawable_ID,
+                                                  guint32          tile_num,
+                                                  guint32          n_tiles,
+                                                  guint32          shadow,
+                                                  gsize           *tile_bytes,
+                                                  gint            *n_tiles_sent);
 static void gimp_plug_in_handle_proc_run         (GimpPlugIn      *plug_in,
                                                   GPProcRun       *proc_run);
 static void gimp_plug_in_handle_proc_return      (GimpPlugIn      *plug_in,
@@ -160,6 +175,10 @@ gimp_plug_in_handle_message (GimpPlugIn      *plug_in,
     case GP_HAS_INIT:
       gimp_plug_in_handle_has_init (plug_in);
       break;
+
+    case GP_TILE_RUN_REQ:
+      gimp_plug_in_handle_tile_run_request (plug_in, msg->data);
+      break;
     }
 }
 
@@ -176,17 +195,42 @@ static void
 gimp_plug_in_handle_tile_request (GimpPlugIn *plug_in,
                                   GPTileReq  *request)
 {
+  GimpPDB *pdb          = plug_in->manager->gimp->pdb;
+  gint64   start;
+  gsize    tile_bytes   = 0;
+  gint     n_tiles_sent = 0;
+
   g_return_if_fail (request != NULL);
 
+  start = gimp_pdb_profile_io_begin (pdb);
+
+  plug_in->tile_stats.n_requests++;
+
   if (request->drawable_ID == -1)
-    gimp_plug_in_handle_tile_put (plug_in, request);
+    {
+      gimp_plug_in_handle_tile_put (plug_in, request,
+                                    &tile_bytes, &n_tiles_sent);
+
+      plug_in->tile_stats.n_tiles_written += n_tiles_sent;
+    }
   else
-    gimp_plug_in_handle_tile_get (plug_in, request);
+    {
+      gimp_plug_in_handle_tile_get (plug_in, request,
+                                    &tile_bytes, &n_tiles_sent);
+
+      plug_in->tile_stats.n_tiles_read += n_tiles_sent;
+    }
+
+  plug_in->tile_stats.n_bytes += tile_bytes;
+
+  gimp_pdb_profile_io_end (pdb, start, 0, tile_bytes, n_tiles_sent);
 }
 
 static void
 gimp_plug_in_handle_tile_put (GimpPlugIn *plug_in,
-                              GPTileReq  *request)
+                              GPTileReq  *request,
+                              gsize      *tile_bytes,
+                              gint       *n_tiles_sent)
 {
   GPTileData       tile_data;
   GPTileData      *tile_info;
@@ -333,6 +377,10 @@ gimp_plug_in_handle_tile_put (GimpPlugIn *plug_in,
                        GEGL_AUTO_ROWSTRIDE);
     }
 
+  *tile_bytes   = (babl_format_get_bytes_per_pixel (format) *
+                   tile_rect.width * tile_rect.height);
+  *n_tiles_sent = 1;
+
   gimp_wire_destroy (&msg);
 
   if (! gp_tile_ack_write (plug_in->my_write, plug_in))
@@ -346,7 +394,61 @@ gimp_plug_in_handle_tile_put (GimpPlugIn *plug_in,
 
 static void
 gimp_plug_in_handle_tile_get (GimpPlugIn *plug_in,
-                              GPTileReq  *request)
+                              GPTileReq  *request,
+                              gsize      *tile_bytes,
+                              gint       *n_tiles_sent)
+{
+  gimp_plug_in_handle_tile_run_get (plug_in,
+                                    request->drawable_ID,
+                                    request->tile_num,
+                                    1,
+                                    request->shadow,
+                                    tile_bytes,
+                                    n_tiles_sent);
+}
+
+static void
+gimp_plug_in_handle_tile_run_request (GimpPlugIn   *plug_in,
+                                      GPTileRunReq *request)
+{
+  GimpPDB *pdb          = plug_in->manager->gimp->pdb;
+  gint64   start;
+  gsize    tile_bytes   = 0;
+  gint     n_tiles_sent = 0;
+
+  g_return_if_fail (request != NULL);
+
+  start = gimp_pdb_profile_io_begin (pdb);
+
+  gimp_plug_in_handle_tile_run_get (plug_in,
+                                    request->drawable_ID,
+                                    request->tile_num,
+                                    MAX (request->n_tiles, 1),
+                                    request->shadow,
+                                    &tile_bytes,
+                                    &n_tiles_sent);
+
+  plug_in->tile_stats.n_requests++;
+  plug_in->tile_stats.n_tiles_read += n_tiles_sent;
+  plug_in->tile_stats.n_bytes      += tile_bytes;
+
+  gimp_pdb_profile_io_end (pdb, start, 0, tile_bytes, n_tiles_sent);
+}
+
+/*  Sends a horizontal run of @n_tiles tiles, starting at @tile_num, as
+ *  a single contiguous area in one GP_TILE_DATA message.  The run is
+ *  clipped to the tile row and to the size of the shared memory
+ *  segment, the plug-in finds the number of tiles actually sent from
+ *  the returned width.
+ */
+static void
+gimp_plug_in_handle_tile_run_get (GimpPlugIn *plug_in,
+                                  gint32      drawable_ID,
+                                  guint32     tile_num,
+                                  guint32     n_tiles,
+                                  guint32     shadow,
+                                  gsize      *tile_bytes,
+                                  gint       *n_tiles_sent)
 {
   GPTileData       tile_data;
   GimpWireMessage  msg;
@@ -355,9 +457,10 @@ gimp_plug_in_handle_tile_get (GimpPlugIn *plug_in,
   const Babl      *format;
   GeglRectangle    tile_rect;
   gint             tile_size;
+  gint             bpp;
 
   drawable = (GimpDrawable *) gimp_item_get_by_ID (plug_in->manager->gimp,
-                                                   request->drawable_ID);
+                                                   drawable_ID);
 
   if (! GIMP_IS_DRAWABLE (drawable))
     {
@@ -366,7 +469,7 @@ gimp_plug_in_handle_tile_get (GimpPlugIn *plug_in,
                     "tried reading from invalid drawable %d (killing)",
                     gimp_object_get_name (plug_in),
                     gimp_file_get_utf8_name (plug_in->file),
-                    request->drawable_ID);
+                    drawable_ID);
       gimp_plug_in_close (plug_in, TRUE);
       return;
     }
@@ -378,12 +481,12 @@ gimp_plug_in_handle_tile_get (GimpPlugIn *plug_in,
                     "from the image (killing)",
                     gimp_object_get_name (plug_in),
                     gimp_file_get_utf8_name (plug_in->file),
-                    request->drawable_ID);
+                    drawable_ID);
       gimp_plug_in_close (plug_in, TRUE);
       return;
     }
 
-  if (request->shadow)
+  if (shadow)
     {
       buffer = gimp_drawable_get_shadow_buffer (drawable);
 
@@ -397,7 +500,7 @@ gimp_plug_in_handle_tile_get (GimpPlugIn *plug_in,
   if (! gimp_gegl_buffer_get_tile_rect (buffer,
                                         GIMP_PLUG_IN_TILE_WIDTH,
                                         GIMP_PLUG_IN_TILE_HEIGHT,
-                                        request->tile_num,
+                                        tile_num,
                                         &tile_rect))
     {
       gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
@@ -416,13 +519,41 @@ gimp_plug_in_handle_tile_get (GimpPlugIn *plug_in,
       format = gimp_babl_compat_u8_format (format);
     }
 
-  tile_size = (babl_format_get_bytes_per_pixel (format) *
-               tile_rect.width * tile_rect.height);
+  bpp = babl_format_get_bytes_per_pixel (format);
+
+  if (n_tiles > 1)
+    {
+      GeglRectangle last_rect;
+      gint          n_cols;
+      gint          max_tiles;
+
+      n_cols = ((gegl_buffer_get_width (buffer) + GIMP_PLUG_IN_TILE_WIDTH - 1) /
+                GIMP_PLUG_IN_TILE_WIDTH);
+
+      n_tiles = MIN (n_tiles, n_cols - tile_num % n_cols);
+
+      max_tiles = (gimp_plug_in_shm_get_size () /
+                   (GIMP_PLUG_IN_TILE_WIDTH * GIMP_PLUG_IN_TILE_HEIGHT * bpp));
 
-  tile_data.drawable_ID = request->drawable_ID;
-  tile_data.tile_num    = request->tile_num;
-  tile_data.shadow      = request->shadow;
-  tile_data.bpp         = babl_format_get_bytes_per_pixel (format);
+      n_tiles = CLAMP (n_tiles, 1, max_tiles);
+
+      if (n_tiles > 1 &&
+          gimp_gegl_buffer_get_tile_rect (buffer,
+                                          GIMP_PLUG_IN_TILE_WIDTH,
+                                          GIMP_PLUG_IN_TILE_HEIGHT,
+                                          tile_num + n_tiles - 1,
+                                          &last_rect))
+        {
+          gegl_rectangle_bounding_box (&tile_rect, &tile_rect, &last_rect);
+        }
+    }
+
+  tile_size = bpp * tile_rect.width * tile_rect.height;
+
+  tile_data.drawable_ID = drawable_ID;
+  tile_data.tile_num    = tile_num;
+  tile_data.shadow      = shadow;
+  tile_data.bpp         = bpp;
   tile_data.width       = tile_rect.width;
   tile_data.height      = tile_rect.height;
   tile_data.use_shm     = (plug_in->manager->shm != NULL);
@@ -466,6 +597,9 @@ gimp_plug_in_handle_tile_get (GimpPlugIn *plug_in,
       return;
     }
 
+  *tile_bytes   = tile_size;
+  *n_tiles_sent = n_tiles;
+
   gimp_wire_destroy (&msg);
 }
 
@@ -666,7 +800,22 @@ gimp_plug_in_handle_proc_return (GimpPlugIn   *plug_in,
                                                    proc_frame->return_vals);
     }
 
-  gimp_plug_in_close (plug_in, FALSE);
+  if (plug_in->manager->gimp->be_verbose)
+    {
+      GimpPlugInTileStats *stats = &plug_in->tile_stats;
+
+      g_print ("Plug-in '%s' ran '%s': %u tile requests, "
+               "%u tiles read, %u tiles written, "
+               "%" G_GUINT64_FORMAT " bytes of pixel data\n",
+               gimp_file_get_utf8_name (plug_in->file),
+               gimp_object_get_name (proc_frame->procedure),
+               stats->n_requests,
+               stats->n_tiles_read, stats->n_tiles_written,
+               stats->n_bytes);
+    }
+
+  if (! gimp_plug_in_manager_resident_add (plug_in->manager, plug_in))
+    gimp_plug_in_close (plug_in, FALSE);
 }
 
 static void
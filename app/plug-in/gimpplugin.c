@@ -77,6 +77,8 @@
 #include "core/gimp.h"
 #include "core/gimpprogress.h"
 
+#include "pdb/gimppdb.h"
+#include "pdb/gimppdb-profile.h"
 #include "pdb/gimppdbcontext.h"
 
 #include "gimpenvirontable.h"
@@ -89,6 +91,7 @@
 #include "gimppluginmanager.h"
 #include "gimppluginmanager-help-domain.h"
 #include "gimppluginmanager-locale-domain.h"
+#include "gimppluginmanager-resident.h"
 #include "gimptemporaryprocedure.h"
 #include "plug-in-params.h"
 
@@ -103,6 +106,10 @@ static gboolean   gimp_plug_in_write         (GIOChannel   *channel,
                                               gpointer      data);
 static gboolean   gimp_plug_in_flush         (GIOChannel   *channel,
                                               gpointer      data);
+static gboolean   gimp_plug_in_write_chars   (GimpPlugIn   *plug_in,
+                                              GIOChannel   *channel,
+                                              const gchar  *buf,
+                                              gsize         count);
 
 static gboolean   gimp_plug_in_recv_message  (GIOChannel   *channel,
                                               GIOCondition  cond,
@@ -144,6 +151,7 @@ gimp_plug_in_init (GimpPlugIn *plug_in)
   plug_in->call_mode          = GIMP_PLUG_IN_CALL_NONE;
   plug_in->open               = FALSE;
   plug_in->hup                = FALSE;
+  plug_in->resident           = FALSE;
   plug_in->pid                = 0;
 
   plug_in->my_read            = NULL;
@@ -587,7 +595,9 @@ gimp_plug_in_close (GimpPlugIn *plug_in,
   while (plug_in->temp_procedures)
     gimp_plug_in_remove_temp_proc (plug_in, plug_in->temp_procedures->data);
 
-  gimp_plug_in_manager_remove_open_plug_in (plug_in->manager, plug_in);
+  /*  an idle resident plug-in is not in the list of open plug-ins  */
+  if (! gimp_plug_in_manager_resident_remove (plug_in->manager, plug_in))
+    gimp_plug_in_manager_remove_open_plug_in (plug_in->manager, plug_in);
 }
 
 static gboolean
@@ -667,6 +677,14 @@ gimp_plug_in_write (GIOChannel   *channel,
   GimpPlugIn *plug_in = data;
   gulong      bytes;
 
+  /*  large blocks like tile data and arrays are written directly,
+   *  instead of being copied through the write buffer in pieces
+   */
+  if (count >= WRITE_BUFFER_SIZE)
+    return (gimp_wire_flush (channel, plug_in) &&
+            gimp_plug_in_write_chars (plug_in, channel,
+                                      (const gchar *) buf, count));
+
   while (count > 0)
     {
       if ((plug_in->write_buffer_index + count) >= WRITE_BUFFER_SIZE)
@@ -701,49 +719,67 @@ gimp_plug_in_flush (GIOChannel *channel,
 
   if (plug_in->write_buffer_index > 0)
     {
-      GIOStatus  status;
-      GError    *error = NULL;
-      gint       count;
-      gsize      bytes;
+      if (! gimp_plug_in_write_chars (plug_in, channel,
+                                      plug_in->write_buffer,
+                                      plug_in->write_buffer_index))
+        return FALSE;
+
+      plug_in->write_buffer_index = 0;
+    }
+
+  return TRUE;
+}
+
+static gboolean
+gimp_plug_in_write_chars (GimpPlugIn  *plug_in,
+                          GIOChannel  *channel,
+                          const gchar *buf,
+                          gsize        count)
+{
+  GimpPDB   *pdb   = plug_in->manager->gimp->pdb;
+  gint64     start = gimp_pdb_profile_io_begin (pdb);
+  gsize      total = count;
+  GIOStatus  status;
+  GError    *error = NULL;
+  gsize      bytes;
+
+  while (count > 0)
+    {
+      do
+        {
+          bytes = 0;
+          status = g_io_channel_write_chars (channel, buf, count,
+                                             &bytes,
+                                             &error);
+        }
+      while (status == G_IO_STATUS_AGAIN);
 
-      count = 0;
-      while (count != plug_in->write_buffer_index)
+      if (status != G_IO_STATUS_NORMAL)
         {
-          do
+          if (error)
             {
-              bytes = 0;
-              status = g_io_channel_write_chars (channel,
-                                                 &plug_in->write_buffer[count],
-                                                 (plug_in->write_buffer_index - count),
-                                                 &bytes,
-                                                 &error);
+              g_warning ("%s: plug_in_flush(): error: %s",
+                         gimp_filename_to_utf8 (g_get_prgname ()),
+                         error->message);
+              g_error_free (error);
             }
-          while (status == G_IO_STATUS_AGAIN);
-
-          if (status != G_IO_STATUS_NORMAL)
+          else
             {
-              if (error)
-                {
-                  g_warning ("%s: plug_in_flush(): error: %s",
-                             gimp_filename_to_utf8 (g_get_prgname ()),
-                             error->message);
-                  g_error_free (error);
-                }
-              else
-                {
-                  g_warning ("%s: plug_in_flush(): error",
-                             gimp_filename_to_utf8 (g_get_prgname ()));
-                }
-
-              return FALSE;
+              g_warning ("%s: plug_in_flush(): error",
+                         gimp_filename_to_utf8 (g_get_prgname ()));
             }
 
-          count += bytes;
+          gimp_pdb_profile_io_end (pdb, start, total - count, 0, 0);
+
+          return FALSE;
         }
 
-      plug_in->write_buffer_index = 0;
+      buf   += bytes;
+      count -= bytes;
     }
 
+  gimp_pdb_profile_io_end (pdb, start, total, 0, 0);
+
   return TRUE;
 }
 
@@ -1057,3 +1093,23 @@ gimp_plug_in_precision_enabled (GimpPlugIn *plug_in)
 
   return plug_in->precision;
 }
+
+gboolean
+gimp_plug_in_set_resident (GimpPlugIn *plug_in,
+                           gboolean    resident)
+{
+  GimpProcedure *procedure;
+
+  g_return_val_if_fail (GIMP_IS_PLUG_IN (plug_in), FALSE);
+
+  procedure = plug_in->main_proc_frame.procedure;
+
+  /*  extensions stay around anyway  */
+  if (plug_in->call_mode != GIMP_PLUG_IN_CALL_RUN ||
+      ! procedure || procedure->proc_type != GIMP_PLUGIN)
+    return FALSE;
+
+  plug_in->resident = resident ? TRUE : FALSE;
+
+  return TRUE;
+}
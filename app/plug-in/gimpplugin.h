@@ -35,7 +35,16 @@
 #define GIMP_IS_PLUG_IN_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass), GIMP_TYPE_PLUG_IN))
 
 
-typedef struct _GimpPlugInClass GimpPlugInClass;
+typedef struct _GimpPlugInClass     GimpPlugInClass;
+typedef struct _GimpPlugInTileStats GimpPlugInTileStats;
+
+struct _GimpPlugInTileStats
+{
+  guint    n_requests;       /*  GP_TILE_REQ and GP_TILE_RUN_REQ messages  */
+  guint    n_tiles_read;     /*  Tiles sent to the plug-in                 */
+  guint    n_tiles_written;  /*  Tiles received from the plug-in           */
+  guint64  n_bytes;          /*  Pixel data moved either way               */
+};
 
 struct _GimpPlugIn
 {
@@ -48,6 +57,7 @@ struct _GimpPlugIn
   guint                open : 1;        /*  Is the plug-in open?              */
   guint                hup : 1;         /*  Did we receive a G_IO_HUP         */
   guint                precision : 1;   /*  True drawable precision enabled   */
+  guint                resident : 1;    /*  Stay alive for the next run       */
   GPid                 pid;             /*  Plug-in's process id              */
 
   GIOChannel          *my_read;         /*  App's read and write channels     */
@@ -69,6 +79,8 @@ struct _GimpPlugIn
   GList               *temp_proc_frames;
 
   GimpPlugInDef       *plug_in_def;     /*  Valid during query() and init()   */
+
+  GimpPlugInTileStats  tile_stats;      /*  Tile traffic of the current run   */
 };
 
 struct _GimpPlugInClass
@@ -123,5 +135,8 @@ GimpPDBErrorHandler
 void          gimp_plug_in_enable_precision  (GimpPlugIn             *plug_in);
 gboolean      gimp_plug_in_precision_enabled (GimpPlugIn             *plug_in);
 
+gboolean      gimp_plug_in_set_resident      (GimpPlugIn             *plug_in,
+                                              gboolean                resident);
+
 
 #endif /* __GIMP_PLUG_IN_H__ */
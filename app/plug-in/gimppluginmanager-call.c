@@ -19,6 +19,8 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include <gdk-pixbuf/gdk-pixbuf.h>
 #include <gegl.h>
 
@@ -42,6 +44,7 @@
 #include "gimppluginmanager.h"
 #define __YES_I_NEED_GIMP_PLUG_IN_MANAGER_CALL__
 #include "gimppluginmanager-call.h"
+#include "gimppluginmanager-resident.h"
 #include "gimppluginshm.h"
 #include "gimptemporaryprocedure.h"
 #include "plug-in-params.h"
@@ -62,6 +65,23 @@ gimp_plug_in_manager_call_query (GimpPlugInManager *manager,
   g_return_if_fail (GIMP_IS_PDB_CONTEXT (context));
   g_return_if_fail (GIMP_IS_PLUG_IN_DEF (plug_in_def));
 
+  plug_in = gimp_plug_in_manager_query_start (manager, context, plug_in_def);
+
+  if (plug_in)
+    gimp_plug_in_manager_query_finish (manager, plug_in);
+}
+
+GimpPlugIn *
+gimp_plug_in_manager_query_start (GimpPlugInManager *manager,
+                                  GimpContext       *context,
+                                  GimpPlugInDef     *plug_in_def)
+{
+  GimpPlugIn *plug_in;
+
+  g_return_val_if_fail (GIMP_IS_PLUG_IN_MANAGER (manager), NULL);
+  g_return_val_if_fail (GIMP_IS_PDB_CONTEXT (context), NULL);
+  g_return_val_if_fail (GIMP_IS_PLUG_IN_DEF (plug_in_def), NULL);
+
   plug_in = gimp_plug_in_new (manager, context, NULL,
                               NULL, plug_in_def->file);
 
@@ -69,26 +89,39 @@ gimp_plug_in_manager_call_query (GimpPlugInManager *manager,
     {
       plug_in->plug_in_def = plug_in_def;
 
-      if (gimp_plug_in_open (plug_in, GIMP_PLUG_IN_CALL_QUERY, TRUE))
-        {
-          while (plug_in->open)
-            {
-              GimpWireMessage msg;
+      /*  the plug-in process runs its query() right away and writes
+       *  its messages into the pipe, they are only handled in
+       *  gimp_plug_in_manager_query_finish()
+       */
+      gimp_plug_in_open (plug_in, GIMP_PLUG_IN_CALL_QUERY, TRUE);
+    }
 
-              if (! gimp_wire_read_msg (plug_in->my_read, &msg, plug_in))
-                {
-                  gimp_plug_in_close (plug_in, TRUE);
-                }
-              else
-                {
-                  gimp_plug_in_handle_message (plug_in, &msg);
-                  gimp_wire_destroy (&msg);
-                }
-            }
-        }
+  return plug_in;
+}
 
-      g_object_unref (plug_in);
+void
+gimp_plug_in_manager_query_finish (GimpPlugInManager *manager,
+                                   GimpPlugIn        *plug_in)
+{
+  g_return_if_fail (GIMP_IS_PLUG_IN_MANAGER (manager));
+  g_return_if_fail (GIMP_IS_PLUG_IN (plug_in));
+
+  while (plug_in->open)
+    {
+      GimpWireMessage msg;
+
+      if (! gimp_wire_read_msg (plug_in->my_read, &msg, plug_in))
+        {
+          gimp_plug_in_close (plug_in, TRUE);
+        }
+      else
+        {
+          gimp_plug_in_handle_message (plug_in, &msg);
+          gimp_wire_destroy (&msg);
+        }
     }
+
+  g_object_unref (plug_in);
 }
 
 void
@@ -150,7 +183,11 @@ gimp_plug_in_manager_call_run (GimpPlugInManager   *manager,
   g_return_val_if_fail (args != NULL, NULL);
   g_return_val_if_fail (display == NULL || GIMP_IS_OBJECT (display), NULL);
 
-  plug_in = gimp_plug_in_new (manager, context, progress, procedure, NULL);
+  plug_in = gimp_plug_in_manager_resident_take (manager,
+                                                context, progress, procedure);
+
+  if (! plug_in)
+    plug_in = gimp_plug_in_new (manager, context, progress, procedure, NULL);
 
   if (plug_in)
     {
@@ -164,7 +201,11 @@ gimp_plug_in_manager_call_run (GimpPlugInManager   *manager,
       GObject           *screen;
       gint               monitor;
 
-      if (! gimp_plug_in_open (plug_in, GIMP_PLUG_IN_CALL_RUN, FALSE))
+      memset (&plug_in->tile_stats, 0, sizeof (GimpPlugInTileStats));
+
+      /*  a resident plug-in taken from the pool is already running  */
+      if (! plug_in->open &&
+          ! gimp_plug_in_open (plug_in, GIMP_PLUG_IN_CALL_RUN, FALSE))
         {
           const gchar *name  = gimp_object_get_name (plug_in);
           GError      *error = g_error_new (GIMP_PLUG_IN_ERROR,
@@ -274,6 +315,12 @@ gimp_plug_in_manager_call_run (GimpPlugInManager   *manager,
           proc_frame->main_loop = NULL;
 
           return_vals = gimp_plug_in_proc_frame_get_return_values (proc_frame);
+
+          /*  the plug-in stays alive in the resident pool, so clean up
+           *  behind this call now instead of when it is finalized
+           */
+          if (plug_in->resident && plug_in->open)
+            gimp_plug_in_proc_frame_dispose (proc_frame, plug_in);
         }
 
       g_object_unref (plug_in);
@@ -31,6 +31,16 @@ void             gimp_plug_in_manager_call_query    (GimpPlugInManager      *man
                                                      GimpContext            *context,
                                                      GimpPlugInDef          *plug_in_def);
 
+/*  Start the plug-in's query() function without handling its messages
+ *  yet, and finish it later, so that several plug-ins can run their
+ *  query() concurrently
+ */
+GimpPlugIn     * gimp_plug_in_manager_query_start   (GimpPlugInManager      *manager,
+                                                     GimpContext            *context,
+                                                     GimpPlugInDef          *plug_in_def);
+void             gimp_plug_in_manager_query_finish  (GimpPlugInManager      *manager,
+                                                     GimpPlugIn             *plug_in);
+
 /*  Call the plug-in's init() function
  */
 void             gimp_plug_in_manager_call_init     (GimpPlugInManager      *manager,
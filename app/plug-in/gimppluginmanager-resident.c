@@ -0,0 +1,309 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimppluginmanager-resident.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#include <gdk-pixbuf/gdk-pixbuf.h>
+#include <gegl.h>
+
+#include "libgimpbase/gimpbase.h"
+
+#include "plug-in-types.h"
+
+#include "core/gimp.h"
+
+#include "gimpplugin.h"
+#include "gimppluginmanager.h"
+#include "gimppluginmanager-resident.h"
+#include "gimppluginprocedure.h"
+
+
+/*  A plug-in which called gimp_plugin_set_resident() is not closed when
+ *  its procedure returns.  It is kept in a pool of idle processes
+ *  instead, and the next call to any procedure of the same executable
+ *  is sent to it.  Idle plug-ins are closed after a while, or when
+ *  the pool grows too large.
+ */
+
+#define RESIDENT_MAX_PLUG_INS    8           /*  idle processes         */
+#define RESIDENT_MAX_MEMSIZE     (256 << 20) /*  their resident memory  */
+#define RESIDENT_IDLE_TIMEOUT    30          /*  seconds                */
+#define RESIDENT_CHECK_INTERVAL  5           /*  seconds                */
+
+
+typedef struct _GimpResidentPlugIn GimpResidentPlugIn;
+
+struct _GimpResidentPlugIn
+{
+  GimpPlugIn *plug_in;
+  gint64      idle_since;
+};
+
+
+static gint64     gimp_plug_in_manager_resident_memsize (GimpPlugIn        *plug_in);
+static void       gimp_plug_in_manager_resident_limit   (GimpPlugInManager *manager);
+static gboolean   gimp_plug_in_manager_resident_timeout (GimpPlugInManager *manager);
+
+
+/*  public functions  */
+
+gboolean
+gimp_plug_in_manager_resident_add (GimpPlugInManager *manager,
+                                   GimpPlugIn        *plug_in)
+{
+  GimpResidentPlugIn *resident;
+
+  g_return_val_if_fail (GIMP_IS_PLUG_IN_MANAGER (manager), FALSE);
+  g_return_val_if_fail (GIMP_IS_PLUG_IN (plug_in), FALSE);
+
+  /*  temporary procedures would outlive the call that installed them  */
+  if (! plug_in->resident                         ||
+      ! plug_in->open                             ||
+      plug_in->hup                                ||
+      plug_in->call_mode != GIMP_PLUG_IN_CALL_RUN ||
+      plug_in->temp_procedures                    ||
+      plug_in->temp_proc_frames)
+    {
+      return FALSE;
+    }
+
+  resident = g_slice_new (GimpResidentPlugIn);
+
+  resident->plug_in    = g_object_ref (plug_in);
+  resident->idle_since = g_get_monotonic_time ();
+
+  manager->resident_plug_ins = g_list_prepend (manager->resident_plug_ins,
+                                               resident);
+
+  /*  nobody waits for the return values of an asynchronous call, so
+   *  clean up behind it now; gimp_plug_in_manager_call_run() does that
+   *  for synchronous calls
+   */
+  if (! plug_in->main_proc_frame.main_loop)
+    gimp_plug_in_proc_frame_dispose (&plug_in->main_proc_frame, plug_in);
+
+  gimp_plug_in_manager_remove_open_plug_in (manager, plug_in);
+
+  gimp_plug_in_manager_resident_limit (manager);
+
+  if (manager->resident_plug_ins && ! manager->resident_timeout_id)
+    manager->resident_timeout_id =
+      g_timeout_add_seconds (RESIDENT_CHECK_INTERVAL,
+                             (GSourceFunc) gimp_plug_in_manager_resident_timeout,
+                             manager);
+
+  return TRUE;
+}
+
+gboolean
+gimp_plug_in_manager_resident_remove (GimpPlugInManager *manager,
+                                      GimpPlugIn        *plug_in)
+{
+  GList *list;
+
+  g_return_val_if_fail (GIMP_IS_PLUG_IN_MANAGER (manager), FALSE);
+  g_return_val_if_fail (GIMP_IS_PLUG_IN (plug_in), FALSE);
+
+  for (list = manager->resident_plug_ins; list; list = g_list_next (list))
+    {
+      GimpResidentPlugIn *resident = list->data;
+
+      if (resident->plug_in == plug_in)
+        {
+          manager->resident_plug_ins =
+            g_list_delete_link (manager->resident_plug_ins, list);
+
+          g_slice_free (GimpResidentPlugIn, resident);
+          g_object_unref (plug_in);
+
+          return TRUE;
+        }
+    }
+
+  return FALSE;
+}
+
+GimpPlugIn *
+gimp_plug_in_manager_resident_take (GimpPlugInManager   *manager,
+                                    GimpContext         *context,
+                                    GimpProgress        *progress,
+                                    GimpPlugInProcedure *procedure)
+{
+  GFile *file;
+  GList *list;
+
+  g_return_val_if_fail (GIMP_IS_PLUG_IN_MANAGER (manager), NULL);
+  g_return_val_if_fail (GIMP_IS_PLUG_IN_PROCEDURE (procedure), NULL);
+
+  if (GIMP_PROCEDURE (procedure)->proc_type != GIMP_PLUGIN)
+    return NULL;
+
+  file = gimp_plug_in_procedure_get_file (procedure);
+
+  for (list = manager->resident_plug_ins; list; list = g_list_next (list))
+    {
+      GimpResidentPlugIn *resident = list->data;
+      GimpPlugIn         *plug_in  = resident->plug_in;
+
+      /*  skip plug-ins whose synchronous caller did not pick up the
+       *  return values yet
+       */
+      if (! plug_in->main_proc_frame.main_loop &&
+          g_file_equal (plug_in->file, file))
+        {
+          manager->resident_plug_ins =
+            g_list_delete_link (manager->resident_plug_ins, list);
+
+          g_slice_free (GimpResidentPlugIn, resident);
+
+          gimp_plug_in_proc_frame_dispose (&plug_in->main_proc_frame, plug_in);
+          gimp_plug_in_proc_frame_init (&plug_in->main_proc_frame,
+                                        context, progress, procedure);
+
+          gimp_plug_in_manager_add_open_plug_in (manager, plug_in);
+
+          /*  the pool's reference is passed on to the caller  */
+          return plug_in;
+        }
+    }
+
+  return NULL;
+}
+
+void
+gimp_plug_in_manager_resident_exit (GimpPlugInManager *manager)
+{
+  g_return_if_fail (GIMP_IS_PLUG_IN_MANAGER (manager));
+
+  if (manager->resident_timeout_id)
+    {
+      g_source_remove (manager->resident_timeout_id);
+      manager->resident_timeout_id = 0;
+    }
+
+  /*  gimp_plug_in_close() removes the plug-in from the pool  */
+  while (manager->resident_plug_ins)
+    {
+      GimpResidentPlugIn *resident = manager->resident_plug_ins->data;
+
+      gimp_plug_in_close (resident->plug_in, TRUE);
+    }
+}
+
+
+/*  private functions  */
+
+static gint64
+gimp_plug_in_manager_resident_memsize (GimpPlugIn *plug_in)
+{
+  gint64 memsize = 0;
+
+#if defined (__linux__) && defined (_SC_PAGESIZE)
+  gchar *filename;
+  gchar *contents;
+
+  filename = g_strdup_printf ("/proc/%d/statm", (gint) plug_in->pid);
+
+  if (g_file_get_contents (filename, &contents, NULL, NULL))
+    {
+      gint64 pages;
+
+      if (sscanf (contents, "%*s %" G_GINT64_FORMAT, &pages) == 1)
+        memsize = pages * sysconf (_SC_PAGESIZE);
+
+      g_free (contents);
+    }
+
+  g_free (filename);
+#endif
+
+  return memsize;
+}
+
+/*  close the oldest idle plug-ins until the pool fits its limits  */
+static void
+gimp_plug_in_manager_resident_limit (GimpPlugInManager *manager)
+{
+  gint64 memsize = 0;
+  GList *list;
+
+  for (list = manager->resident_plug_ins; list; list = g_list_next (list))
+    {
+      GimpResidentPlugIn *resident = list->data;
+
+      memsize += gimp_plug_in_manager_resident_memsize (resident->plug_in);
+    }
+
+  while (manager->resident_plug_ins &&
+         (g_list_length (manager->resident_plug_ins) > RESIDENT_MAX_PLUG_INS ||
+          memsize > RESIDENT_MAX_MEMSIZE))
+    {
+      GimpResidentPlugIn *resident;
+      GimpPlugIn         *plug_in;
+
+      resident = g_list_last (manager->resident_plug_ins)->data;
+      plug_in  = resident->plug_in;
+
+      memsize -= gimp_plug_in_manager_resident_memsize (plug_in);
+
+      if (manager->gimp->be_verbose)
+        g_print ("Closing resident plug-in: '%s'\n",
+                 gimp_file_get_utf8_name (plug_in->file));
+
+      gimp_plug_in_close (plug_in, TRUE);
+    }
+}
+
+static gboolean
+gimp_plug_in_manager_resident_timeout (GimpPlugInManager *manager)
+{
+  gint64 now = g_get_monotonic_time ();
+  GList *list;
+
+  list = manager->resident_plug_ins;
+
+  while (list)
+    {
+      GimpResidentPlugIn *resident = list->data;
+
+      list = g_list_next (list);
+
+      if (now - resident->idle_since >= RESIDENT_IDLE_TIMEOUT * G_TIME_SPAN_SECOND)
+        {
+          if (manager->gimp->be_verbose)
+            g_print ("Closing idle resident plug-in: '%s'\n",
+                     gimp_file_get_utf8_name (resident->plug_in->file));
+
+          gimp_plug_in_close (resident->plug_in, TRUE);
+        }
+    }
+
+  if (manager->resident_plug_ins)
+    return G_SOURCE_CONTINUE;
+
+  manager->resident_timeout_id = 0;
+
+  return G_SOURCE_REMOVE;
+}
@@ -38,6 +38,7 @@
 #include "pdb/gimppdbcontext.h"
 
 #include "gimpinterpreterdb.h"
+#include "gimpplugin.h"
 #include "gimpplugindef.h"
 #include "gimppluginmanager.h"
 #define __YES_I_NEED_GIMP_PLUG_IN_MANAGER_CALL__
@@ -47,15 +48,24 @@
 #include "gimppluginmanager-restore.h"
 #include "gimppluginprocedure.h"
 #include "plug-in-rc.h"
+#include "plug-in-rc-cache.h"
 
 #include "gimp-intl.h"
 
 
+#define GIMP_PLUG_IN_MANAGER_MAX_QUERIES 16
+
+
 static void    gimp_plug_in_manager_search            (GimpPlugInManager    *manager,
                                                        GimpInitStatusFunc    status_callback);
 static void    gimp_plug_in_manager_search_directory  (GimpPlugInManager    *manager,
                                                        GFile                *directory);
 static GFile * gimp_plug_in_manager_get_pluginrc      (GimpPlugInManager    *manager);
+static GFile * gimp_plug_in_manager_get_rc_cache      (GFile                *pluginrc);
+static gint64  gimp_plug_in_manager_get_rc_mtime      (GFile                *pluginrc);
+static void    gimp_plug_in_manager_write_rc_cache    (GimpPlugInManager    *manager,
+                                                       GSList               *plug_in_defs,
+                                                       GFile                *pluginrc);
 static void    gimp_plug_in_manager_read_pluginrc     (GimpPlugInManager    *manager,
                                                        GFile                *file,
                                                        GimpInitStatusFunc    status_callback);
@@ -140,6 +150,12 @@ gimp_plug_in_manager_restore (GimpPlugInManager  *manager,
                                 NULL, GIMP_MESSAGE_ERROR, error->message);
           g_clear_error (&error);
         }
+      else
+        {
+          gimp_plug_in_manager_write_rc_cache (manager,
+                                               manager->plug_in_defs,
+                                               pluginrc);
+        }
 
       manager->write_pluginrc = FALSE;
     }
@@ -322,22 +338,128 @@ gimp_plug_in_manager_get_pluginrc (GimpPlugInManager *manager)
   return pluginrc;
 }
 
+/*  the binary cache lives next to the text pluginrc, which stays the
+ *  canonical, human-readable copy
+ */
+static GFile *
+gimp_plug_in_manager_get_rc_cache (GFile *pluginrc)
+{
+  GFile *cache = NULL;
+  gchar *path  = g_file_get_path (pluginrc);
+
+  if (path)
+    {
+      gchar *cache_path = g_strconcat (path, ".cache", NULL);
+
+      cache = g_file_new_for_path (cache_path);
+
+      g_free (cache_path);
+      g_free (path);
+    }
+
+  return cache;
+}
+
+static gint64
+gimp_plug_in_manager_get_rc_mtime (GFile *pluginrc)
+{
+  GFileInfo *info;
+  gint64     mtime = -1;
+
+  info = g_file_query_info (pluginrc,
+                            G_FILE_ATTRIBUTE_TIME_MODIFIED,
+                            G_FILE_QUERY_INFO_NONE,
+                            NULL, NULL);
+
+  if (info)
+    {
+      mtime = g_file_info_get_attribute_uint64 (info,
+                                                G_FILE_ATTRIBUTE_TIME_MODIFIED);
+      g_object_unref (info);
+    }
+
+  return mtime;
+}
+
+static void
+gimp_plug_in_manager_write_rc_cache (GimpPlugInManager *manager,
+                                     GSList            *plug_in_defs,
+                                     GFile             *pluginrc)
+{
+  GFile  *cache = gimp_plug_in_manager_get_rc_cache (pluginrc);
+  gint64  mtime = gimp_plug_in_manager_get_rc_mtime (pluginrc);
+  GError *error = NULL;
+
+  if (! cache)
+    return;
+
+  if (mtime >= 0)
+    {
+      if (manager->gimp->be_verbose)
+        g_print ("Writing '%s'\n", gimp_file_get_utf8_name (cache));
+
+      /*  the cache is an optimization only, don't bother the user  */
+      if (! plug_in_rc_cache_write (plug_in_defs, cache, mtime, &error))
+        {
+          if (manager->gimp->be_verbose)
+            g_printerr ("%s\n", error->message);
+
+          g_clear_error (&error);
+        }
+    }
+
+  g_object_unref (cache);
+}
+
 /* read the pluginrc file for cached data */
 static void
 gimp_plug_in_manager_read_pluginrc (GimpPlugInManager  *manager,
                                     GFile              *pluginrc,
                                     GimpInitStatusFunc  status_callback)
 {
-  GSList *rc_defs;
-  GError *error = NULL;
+  GSList *rc_defs = NULL;
+  GFile  *cache;
+  GError *error   = NULL;
 
   status_callback (_("Resource configuration"),
                    gimp_file_get_utf8_name (pluginrc), 0.0);
 
-  if (manager->gimp->be_verbose)
-    g_print ("Parsing '%s'\n", gimp_file_get_utf8_name (pluginrc));
+  /*  try the binary cache first, it is only valid if it was written
+   *  together with the current pluginrc
+   */
+  cache = gimp_plug_in_manager_get_rc_cache (pluginrc);
+
+  if (cache)
+    {
+      gint64 mtime = gimp_plug_in_manager_get_rc_mtime (pluginrc);
+
+      if (mtime >= 0)
+        {
+          if (manager->gimp->be_verbose)
+            g_print ("Parsing '%s'\n", gimp_file_get_utf8_name (cache));
+
+          rc_defs = plug_in_rc_cache_parse (manager->gimp, cache, mtime,
+                                            &error);
+
+          if (! rc_defs && manager->gimp->be_verbose && error)
+            g_print ("%s\n", error->message);
+
+          g_clear_error (&error);
+        }
+
+      g_object_unref (cache);
+    }
+
+  if (! rc_defs)
+    {
+      if (manager->gimp->be_verbose)
+        g_print ("Parsing '%s'\n", gimp_file_get_utf8_name (pluginrc));
+
+      rc_defs = plug_in_rc_parse (manager->gimp, pluginrc, &error);
 
-  rc_defs = plug_in_rc_parse (manager->gimp, pluginrc, &error);
+      if (rc_defs && ! manager->write_pluginrc)
+        gimp_plug_in_manager_write_rc_cache (manager, rc_defs, pluginrc);
+    }
 
   if (rc_defs)
     {
@@ -379,30 +501,62 @@ gimp_plug_in_manager_query_new (GimpPlugInManager  *manager,
 
   if (n_plugins)
     {
-      gint nth;
+      GQueue running = G_QUEUE_INIT;
+      gint   max_running;
+      gint   nth;
 
       manager->write_pluginrc = TRUE;
 
-      for (list = manager->plug_in_defs, nth = 0; list; list = list->next)
+      /*  start several plug-ins at once so their query() functions run
+       *  concurrently, but handle their messages strictly in order, so
+       *  procedures are installed exactly as by a serial query
+       */
+      max_running =
+        CLAMP (GIMP_GEGL_CONFIG (manager->gimp->config)->num_processors,
+               1, GIMP_PLUG_IN_MANAGER_MAX_QUERIES);
+
+      list = manager->plug_in_defs;
+      nth  = 0;
+
+      while (list || ! g_queue_is_empty (&running))
         {
-          GimpPlugInDef *plug_in_def = list->data;
+          GimpPlugIn *plug_in;
+          gchar      *basename;
 
-          if (plug_in_def->needs_query)
+          for (;
+               list && g_queue_get_length (&running) < max_running;
+               list = list->next)
             {
-              gchar *basename;
+              GimpPlugInDef *plug_in_def = list->data;
 
-              basename =
-                g_path_get_basename (gimp_file_get_utf8_name (plug_in_def->file));
-              status_callback (NULL, basename,
-                               (gdouble) nth++ / (gdouble) n_plugins);
-              g_free (basename);
+              if (! plug_in_def->needs_query)
+                continue;
 
               if (manager->gimp->be_verbose)
                 g_print ("Querying plug-in: '%s'\n",
                          gimp_file_get_utf8_name (plug_in_def->file));
 
-              gimp_plug_in_manager_call_query (manager, context, plug_in_def);
+              plug_in = gimp_plug_in_manager_query_start (manager, context,
+                                                          plug_in_def);
+
+              if (plug_in)
+                g_queue_push_tail (&running, plug_in);
+              else
+                nth++;
             }
+
+          plug_in = g_queue_pop_head (&running);
+
+          if (! plug_in)
+            continue;
+
+          basename =
+            g_path_get_basename (gimp_file_get_utf8_name (plug_in->file));
+          status_callback (NULL, basename,
+                           (gdouble) nth++ / (gdouble) n_plugins);
+          g_free (basename);
+
+          gimp_plug_in_manager_query_finish (manager, plug_in);
         }
     }
 
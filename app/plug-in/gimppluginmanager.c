@@ -48,6 +48,7 @@
 #include "gimppluginmanager-history.h"
 #include "gimppluginmanager-locale-domain.h"
 #include "gimppluginmanager-menu-branch.h"
+#include "gimppluginmanager-resident.h"
 #include "gimppluginshm.h"
 #include "gimptemporaryprocedure.h"
 
@@ -306,6 +307,8 @@ gimp_plug_in_manager_exit (GimpPlugInManager *manager)
 {
   g_return_if_fail (GIMP_IS_PLUG_IN_MANAGER (manager));
 
+  gimp_plug_in_manager_resident_exit (manager);
+
   while (manager->open_plug_ins)
     gimp_plug_in_close (manager->open_plug_ins->data, TRUE);
 
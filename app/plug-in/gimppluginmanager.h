@@ -54,6 +54,8 @@ struct _GimpPlugInManager
 
   GimpPlugIn        *current_plug_in;
   GSList            *open_plug_ins;
+  GList             *resident_plug_ins;
+  guint              resident_timeout_id;
   GSList            *plug_in_stack;
   GSList            *history;
 
@@ -299,3 +299,9 @@ gimp_plug_in_shm_get_addr (GimpPlugInShm *shm)
 
   return shm->shm_addr;
 }
+
+gint
+gimp_plug_in_shm_get_size (void)
+{
+  return TILE_MAP_SIZE;
+}
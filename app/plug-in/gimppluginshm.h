@@ -26,6 +26,7 @@ void            gimp_plug_in_shm_free     (GimpPlugInShm *shm);
 
 gint            gimp_plug_in_shm_get_ID   (GimpPlugInShm *shm);
 guchar        * gimp_plug_in_shm_get_addr (GimpPlugInShm *shm);
+gint            gimp_plug_in_shm_get_size (void);
 
 
 #endif /* __GIMP_PLUG_IN_SHM_H__ */
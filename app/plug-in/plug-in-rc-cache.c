@@ -0,0 +1,635 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * plug-in-rc-cache.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <gdk-pixbuf/gdk-pixbuf.h>
+
+#include "libgimpbase/gimpbase.h"
+#include "libgimpbase/gimpprotocol.h"
+#include "libgimpconfig/gimpconfig.h"
+
+#include "plug-in-types.h"
+
+#include "core/gimp.h"
+
+#include "pdb/gimp-pdb-compat.h"
+
+#include "gimpplugindef.h"
+#include "gimppluginprocedure.h"
+#include "plug-in-rc-cache.h"
+
+#include "gimp-intl.h"
+
+
+/*  The binary pluginrc cache is a native-endian dump of the same
+ *  information the text pluginrc holds.  It is only ever read back by
+ *  the GIMP that wrote it, the header makes sure of that, and it is
+ *  parsed straight out of a memory mapping without any tokenizing.
+ */
+
+#define PLUG_IN_RC_CACHE_MAGIC        "GIMPPRC"
+#define PLUG_IN_RC_CACHE_BYTE_ORDER   0x01020304
+#define PLUG_IN_RC_CACHE_FILE_VERSION 1
+
+#define PLUG_IN_RC_CACHE_NULL_STRING  G_MAXUINT32
+
+
+typedef struct
+{
+  const guchar *data;
+  gsize         size;
+  gsize         offset;
+  gboolean      error;
+} CacheReader;
+
+
+static GimpPlugInDef * plug_in_rc_cache_read_def       (Gimp          *gimp,
+                                                        CacheReader   *reader);
+static gboolean        plug_in_rc_cache_read_procedure (Gimp          *gimp,
+                                                        CacheReader   *reader,
+                                                        GimpPlugInDef *plug_in_def);
+
+static guint32         cache_read_uint32               (CacheReader   *reader);
+static gint64          cache_read_int64                (CacheReader   *reader);
+static gchar         * cache_read_string               (CacheReader   *reader);
+static guint8        * cache_read_data                 (CacheReader   *reader,
+                                                        gint           length);
+
+static void            cache_write_uint32              (GByteArray    *array,
+                                                        guint32        value);
+static void            cache_write_int64               (GByteArray    *array,
+                                                        gint64         value);
+static void            cache_write_string              (GByteArray    *array,
+                                                        const gchar   *value);
+static void            cache_write_procedure           (GByteArray    *array,
+                                                        GimpPlugInProcedure *proc);
+
+
+/*  public functions  */
+
+GSList *
+plug_in_rc_cache_parse (Gimp    *gimp,
+                        GFile   *file,
+                        gint64   pluginrc_mtime,
+                        GError **error)
+{
+  GMappedFile *mapped;
+  CacheReader  reader = { 0, };
+  GSList      *plug_in_defs = NULL;
+  gchar       *path;
+  guint32      n_defs;
+  guint32      i;
+
+  g_return_val_if_fail (GIMP_IS_GIMP (gimp), NULL);
+  g_return_val_if_fail (G_IS_FILE (file), NULL);
+  g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+  path = g_file_get_path (file);
+
+  if (! path)
+    {
+      g_set_error (error, GIMP_CONFIG_ERROR, GIMP_CONFIG_ERROR_OPEN,
+                   _("Skipping '%s': not a local file."),
+                   gimp_file_get_utf8_name (file));
+      return NULL;
+    }
+
+  mapped = g_mapped_file_new (path, FALSE, NULL);
+  g_free (path);
+
+  if (! mapped)
+    {
+      g_set_error (error, GIMP_CONFIG_ERROR, GIMP_CONFIG_ERROR_OPEN_ENOENT,
+                   _("Could not open '%s' for reading"),
+                   gimp_file_get_utf8_name (file));
+      return NULL;
+    }
+
+  reader.data = (const guchar *) g_mapped_file_get_contents (mapped);
+  reader.size = g_mapped_file_get_length (mapped);
+
+  if (reader.size < sizeof (PLUG_IN_RC_CACHE_MAGIC) ||
+      memcmp (reader.data, PLUG_IN_RC_CACHE_MAGIC,
+              sizeof (PLUG_IN_RC_CACHE_MAGIC)))
+    {
+      g_set_error (error, GIMP_CONFIG_ERROR, GIMP_CONFIG_ERROR_PARSE,
+                   _("Skipping '%s': not a pluginrc cache."),
+                   gimp_file_get_utf8_name (file));
+      goto out;
+    }
+
+  reader.offset = sizeof (PLUG_IN_RC_CACHE_MAGIC);
+
+  if (cache_read_uint32 (&reader) != PLUG_IN_RC_CACHE_BYTE_ORDER     ||
+      cache_read_uint32 (&reader) != PLUG_IN_RC_CACHE_FILE_VERSION   ||
+      cache_read_uint32 (&reader) != GIMP_PROTOCOL_VERSION           ||
+      cache_read_int64  (&reader) != pluginrc_mtime                  ||
+      reader.error)
+    {
+      g_set_error (error, GIMP_CONFIG_ERROR, GIMP_CONFIG_ERROR_VERSION,
+                   _("Skipping '%s': out of date."),
+                   gimp_file_get_utf8_name (file));
+      goto out;
+    }
+
+  n_defs = cache_read_uint32 (&reader);
+
+  for (i = 0; i < n_defs && ! reader.error; i++)
+    {
+      GimpPlugInDef *plug_in_def = plug_in_rc_cache_read_def (gimp, &reader);
+
+      if (plug_in_def)
+        plug_in_defs = g_slist_prepend (plug_in_defs, plug_in_def);
+    }
+
+  if (reader.error)
+    {
+      g_set_error (error, GIMP_CONFIG_ERROR, GIMP_CONFIG_ERROR_PARSE,
+                   _("Skipping '%s': file is truncated or corrupt."),
+                   gimp_file_get_utf8_name (file));
+
+      g_slist_free_full (plug_in_defs, (GDestroyNotify) g_object_unref);
+      plug_in_defs = NULL;
+    }
+
+ out:
+  g_mapped_file_unref (mapped);
+
+  return g_slist_reverse (plug_in_defs);
+}
+
+gboolean
+plug_in_rc_cache_write (GSList  *plug_in_defs,
+                        GFile   *file,
+                        gint64   pluginrc_mtime,
+                        GError **error)
+{
+  GByteArray *array;
+  GSList     *list;
+  guint32     n_defs = 0;
+  gboolean    success;
+
+  g_return_val_if_fail (G_IS_FILE (file), FALSE);
+  g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  for (list = plug_in_defs; list; list = list->next)
+    {
+      GimpPlugInDef *plug_in_def = list->data;
+
+      if (plug_in_def->procedures)
+        n_defs++;
+    }
+
+  array = g_byte_array_new ();
+
+  g_byte_array_append (array, (const guint8 *) PLUG_IN_RC_CACHE_MAGIC,
+                       sizeof (PLUG_IN_RC_CACHE_MAGIC));
+  cache_write_uint32 (array, PLUG_IN_RC_CACHE_BYTE_ORDER);
+  cache_write_uint32 (array, PLUG_IN_RC_CACHE_FILE_VERSION);
+  cache_write_uint32 (array, GIMP_PROTOCOL_VERSION);
+  cache_write_int64  (array, pluginrc_mtime);
+  cache_write_uint32 (array, n_defs);
+
+  for (list = plug_in_defs; list; list = list->next)
+    {
+      GimpPlugInDef *plug_in_def = list->data;
+      GSList        *list2;
+      gchar         *path;
+      guint32        n_procs = 0;
+
+      if (! plug_in_def->procedures)
+        continue;
+
+      path = g_file_get_path (plug_in_def->file);
+      cache_write_string (array, path);
+      g_free (path);
+
+      cache_write_int64 (array, plug_in_def->mtime);
+
+      for (list2 = plug_in_def->procedures; list2; list2 = list2->next)
+        {
+          GimpPlugInProcedure *proc = list2->data;
+
+          if (! proc->installed_during_init)
+            n_procs++;
+        }
+
+      cache_write_uint32 (array, n_procs);
+
+      for (list2 = plug_in_def->procedures; list2; list2 = list2->next)
+        {
+          GimpPlugInProcedure *proc = list2->data;
+
+          if (! proc->installed_during_init)
+            cache_write_procedure (array, proc);
+        }
+
+      cache_write_string (array, plug_in_def->locale_domain_name);
+      cache_write_string (array, plug_in_def->locale_domain_path);
+      cache_write_string (array, plug_in_def->help_domain_name);
+      cache_write_string (array, plug_in_def->help_domain_uri);
+      cache_write_uint32 (array, plug_in_def->has_init);
+    }
+
+  success = g_file_replace_contents (file,
+                                     (const gchar *) array->data, array->len,
+                                     NULL, FALSE, G_FILE_CREATE_NONE,
+                                     NULL, NULL, error);
+
+  g_byte_array_free (array, TRUE);
+
+  return success;
+}
+
+
+/*  private functions  */
+
+static GimpPlugInDef *
+plug_in_rc_cache_read_def (Gimp        *gimp,
+                           CacheReader *reader)
+{
+  GimpPlugInDef *plug_in_def;
+  GFile         *file;
+  gchar         *path;
+  gchar         *domain_name;
+  gchar         *domain_path;
+  guint32        n_procs;
+  guint32        i;
+
+  path = cache_read_string (reader);
+
+  if (! path)
+    {
+      reader->error = TRUE;
+      return NULL;
+    }
+
+  file = g_file_new_for_path (path);
+  g_free (path);
+
+  plug_in_def = gimp_plug_in_def_new (file);
+  g_object_unref (file);
+
+  plug_in_def->mtime = cache_read_int64 (reader);
+
+  n_procs = cache_read_uint32 (reader);
+
+  for (i = 0; i < n_procs && ! reader->error; i++)
+    plug_in_rc_cache_read_procedure (gimp, reader, plug_in_def);
+
+  domain_name = cache_read_string (reader);
+  domain_path = cache_read_string (reader);
+
+  if (domain_name)
+    gimp_plug_in_def_set_locale_domain (plug_in_def, domain_name, domain_path);
+
+  g_free (domain_name);
+  g_free (domain_path);
+
+  domain_name = cache_read_string (reader);
+  domain_path = cache_read_string (reader);
+
+  if (domain_name)
+    gimp_plug_in_def_set_help_domain (plug_in_def, domain_name, domain_path);
+
+  g_free (domain_name);
+  g_free (domain_path);
+
+  if (cache_read_uint32 (reader))
+    gimp_plug_in_def_set_has_init (plug_in_def, TRUE);
+
+  if (reader->error)
+    {
+      g_object_unref (plug_in_def);
+      return NULL;
+    }
+
+  return plug_in_def;
+}
+
+static gboolean
+plug_in_rc_cache_read_procedure (Gimp          *gimp,
+                                 CacheReader   *reader,
+                                 GimpPlugInDef *plug_in_def)
+{
+  GimpProcedure       *procedure;
+  GimpPlugInProcedure *proc;
+  gchar               *name;
+  gchar               *str;
+  gint                 proc_type;
+  guint32              n_menu_paths;
+  guint32              n_args;
+  guint32              n_return_vals;
+  guint32              i;
+
+  name      = cache_read_string (reader);
+  proc_type = cache_read_uint32 (reader);
+
+  if (! name || reader->error)
+    {
+      g_free (name);
+      reader->error = TRUE;
+      return FALSE;
+    }
+
+  procedure = gimp_plug_in_procedure_new (proc_type, plug_in_def->file);
+  proc      = GIMP_PLUG_IN_PROCEDURE (procedure);
+
+  gimp_object_take_name (GIMP_OBJECT (procedure),
+                         gimp_canonicalize_identifier (name));
+
+  procedure->original_name = name;
+
+  procedure->blurb     = cache_read_string (reader);
+  procedure->help      = cache_read_string (reader);
+  procedure->author    = cache_read_string (reader);
+  procedure->copyright = cache_read_string (reader);
+  procedure->date      = cache_read_string (reader);
+  proc->menu_label     = cache_read_string (reader);
+
+  n_menu_paths = cache_read_uint32 (reader);
+
+  for (i = 0; i < n_menu_paths && ! reader->error; i++)
+    {
+      gchar *menu_path = cache_read_string (reader);
+
+      if (menu_path)
+        proc->menu_paths = g_list_append (proc->menu_paths, menu_path);
+    }
+
+  proc->icon_type        = cache_read_uint32 (reader);
+  proc->icon_data_length = cache_read_uint32 (reader);
+
+  switch (proc->icon_type)
+    {
+    case GIMP_ICON_TYPE_ICON_NAME:
+    case GIMP_ICON_TYPE_IMAGE_FILE:
+      proc->icon_data_length = -1;
+      proc->icon_data        = (guint8 *) cache_read_string (reader);
+      break;
+
+    case GIMP_ICON_TYPE_INLINE_PIXBUF:
+      proc->icon_data = cache_read_data (reader, proc->icon_data_length);
+      break;
+
+    default:
+      reader->error = TRUE;
+      break;
+    }
+
+  proc->file_proc = cache_read_uint32 (reader);
+
+  if (proc->file_proc)
+    {
+      proc->extensions = cache_read_string (reader);
+      proc->prefixes   = cache_read_string (reader);
+      proc->magics     = cache_read_string (reader);
+
+      str = cache_read_string (reader);
+      if (str)
+        gimp_plug_in_procedure_set_mime_type (proc, str);
+      g_free (str);
+
+      if (cache_read_uint32 (reader))
+        gimp_plug_in_procedure_set_handles_uri (proc);
+
+      str = cache_read_string (reader);
+      if (str)
+        gimp_plug_in_procedure_set_thumb_loader (proc, str);
+      g_free (str);
+    }
+
+  str = cache_read_string (reader);
+  gimp_plug_in_procedure_set_image_types (proc, str);
+  g_free (str);
+
+  n_args        = cache_read_uint32 (reader);
+  n_return_vals = cache_read_uint32 (reader);
+
+  for (i = 0; i < n_args + n_return_vals && ! reader->error; i++)
+    {
+      GParamSpec *pspec;
+      gint        arg_type;
+      gchar      *arg_name;
+      gchar      *arg_desc;
+
+      arg_type = cache_read_uint32 (reader);
+      arg_name = cache_read_string (reader);
+      arg_desc = cache_read_string (reader);
+
+      if (! reader->error)
+        {
+          pspec = gimp_pdb_compat_param_spec (gimp, arg_type,
+                                              arg_name, arg_desc);
+
+          if (i < n_args)
+            gimp_procedure_add_argument (procedure, pspec);
+          else
+            gimp_procedure_add_return_value (procedure, pspec);
+        }
+
+      g_free (arg_name);
+      g_free (arg_desc);
+    }
+
+  if (! reader->error)
+    gimp_plug_in_def_add_procedure (plug_in_def, proc);
+
+  g_object_unref (proc);
+
+  return ! reader->error;
+}
+
+static guint32
+cache_read_uint32 (CacheReader *reader)
+{
+  guint32 value;
+
+  if (reader->error || reader->size - reader->offset < sizeof (value))
+    {
+      reader->error = TRUE;
+      return 0;
+    }
+
+  memcpy (&value, reader->data + reader->offset, sizeof (value));
+  reader->offset += sizeof (value);
+
+  return value;
+}
+
+static gint64
+cache_read_int64 (CacheReader *reader)
+{
+  gint64 value;
+
+  if (reader->error || reader->size - reader->offset < sizeof (value))
+    {
+      reader->error = TRUE;
+      return 0;
+    }
+
+  memcpy (&value, reader->data + reader->offset, sizeof (value));
+  reader->offset += sizeof (value);
+
+  return value;
+}
+
+static gchar *
+cache_read_string (CacheReader *reader)
+{
+  guint32  length = cache_read_uint32 (reader);
+  gchar   *value;
+
+  if (reader->error || length == PLUG_IN_RC_CACHE_NULL_STRING)
+    return NULL;
+
+  if (reader->size - reader->offset < length)
+    {
+      reader->error = TRUE;
+      return NULL;
+    }
+
+  value = g_strndup ((const gchar *) reader->data + reader->offset, length);
+  reader->offset += length;
+
+  return value;
+}
+
+static guint8 *
+cache_read_data (CacheReader *reader,
+                 gint         length)
+{
+  guint8 *value;
+
+  if (reader->error || length < 0 ||
+      reader->size - reader->offset < (gsize) length)
+    {
+      reader->error = TRUE;
+      return NULL;
+    }
+
+  value = g_memdup (reader->data + reader->offset, length);
+  reader->offset += length;
+
+  return value;
+}
+
+static void
+cache_write_uint32 (GByteArray *array,
+                    guint32     value)
+{
+  g_byte_array_append (array, (const guint8 *) &value, sizeof (value));
+}
+
+static void
+cache_write_int64 (GByteArray *array,
+                   gint64      value)
+{
+  g_byte_array_append (array, (const guint8 *) &value, sizeof (value));
+}
+
+static void
+cache_write_string (GByteArray  *array,
+                    const gchar *value)
+{
+  if (value)
+    {
+      gsize length = strlen (value);
+
+      cache_write_uint32 (array, length);
+      g_byte_array_append (array, (const guint8 *) value, length);
+    }
+  else
+    {
+      cache_write_uint32 (array, PLUG_IN_RC_CACHE_NULL_STRING);
+    }
+}
+
+static void
+cache_write_procedure (GByteArray          *array,
+                       GimpPlugInProcedure *proc)
+{
+  GimpProcedure *procedure = GIMP_PROCEDURE (proc);
+  GList         *list;
+  gint           i;
+
+  cache_write_string (array, procedure->original_name);
+  cache_write_uint32 (array, procedure->proc_type);
+  cache_write_string (array, procedure->blurb);
+  cache_write_string (array, procedure->help);
+  cache_write_string (array, procedure->author);
+  cache_write_string (array, procedure->copyright);
+  cache_write_string (array, procedure->date);
+  cache_write_string (array, proc->menu_label);
+
+  cache_write_uint32 (array, g_list_length (proc->menu_paths));
+
+  for (list = proc->menu_paths; list; list = list->next)
+    cache_write_string (array, list->data);
+
+  cache_write_uint32 (array, proc->icon_type);
+  cache_write_uint32 (array, proc->icon_data_length);
+
+  switch (proc->icon_type)
+    {
+    case GIMP_ICON_TYPE_ICON_NAME:
+    case GIMP_ICON_TYPE_IMAGE_FILE:
+      cache_write_string (array, (const gchar *) proc->icon_data);
+      break;
+
+    case GIMP_ICON_TYPE_INLINE_PIXBUF:
+      g_byte_array_append (array, proc->icon_data, proc->icon_data_length);
+      break;
+    }
+
+  cache_write_uint32 (array, proc->file_proc);
+
+  if (proc->file_proc)
+    {
+      cache_write_string (array, proc->extensions);
+      cache_write_string (array, proc->prefixes);
+      cache_write_string (array, proc->magics);
+      cache_write_string (array, proc->mime_type);
+      cache_write_uint32 (array, proc->handles_uri);
+      cache_write_string (array, proc->thumb_loader);
+    }
+
+  cache_write_string (array, proc->image_types);
+
+  cache_write_uint32 (array, procedure->num_args);
+  cache_write_uint32 (array, procedure->num_values);
+
+  for (i = 0; i < procedure->num_args + procedure->num_values; i++)
+    {
+      GParamSpec *pspec;
+
+      if (i < procedure->num_args)
+        pspec = procedure->args[i];
+      else
+        pspec = procedure->values[i - procedure->num_args];
+
+      cache_write_uint32 (array,
+                          gimp_pdb_compat_arg_type_from_gtype (G_PARAM_SPEC_VALUE_TYPE (pspec)));
+      cache_write_string (array, g_param_spec_get_name (pspec));
+      cache_write_string (array, g_param_spec_get_blurb (pspec));
+    }
+}
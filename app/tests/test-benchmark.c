@@ -0,0 +1,814 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+
+#include <gegl.h>
+#include <gtk/gtk.h>
+
+#include "libgimpbase/gimpbase.h"
+#include "libgimpmath/gimpmath.h"
+
+#include "widgets/widgets-types.h"
+
+#include "core/gimp.h"
+#include "core/gimpcontext.h"
+#include "core/gimpdrawable.h"
+#include "core/gimpdrawable-operation.h"
+#include "core/gimpimage.h"
+#include "core/gimpimage-undo.h"
+#include "core/gimpitem.h"
+#include "core/gimplayer.h"
+#include "core/gimppaintinfo.h"
+#include "core/gimppickable.h"
+#include "core/gimpprojection.h"
+
+#include "paint/gimppaintcore.h"
+#include "paint/gimppaintcore-stroke.h"
+#include "paint/gimppaintoptions.h"
+#include "paint/gimppaintrecord.h"
+
+#include "pdb/gimppdb-utils.h"
+
+#include "file/file-open.h"
+#include "file/file-procedure.h"
+#include "file/file-save.h"
+
+#include "plug-in/gimppluginmanager.h"
+
+#include "tests.h"
+
+#include "gimp-app-test-utils.h"
+
+
+/*  The benchmarks are not run by "make check", run them with "make
+ *  benchmark".  The image size, the number of layers and the number of
+ *  times each operation is timed can be set with the environment
+ *  variables below.  Every result is printed as a tab separated line
+ *
+ *    benchmark <name> <width> <height> <layers> <seconds>
+ *
+ *  where <seconds> is the fastest of the timed runs.  The paint replay
+ *  benchmark replays the strokes recorded in the file named by
+ *  GIMP_BENCHMARK_PAINT_RECORD, and reports percentiles of the time
+ *  spent on each input event instead.
+ */
+#define GIMP_BENCHMARK_SIZE_ENV          "GIMP_BENCHMARK_SIZE"
+#define GIMP_BENCHMARK_LAYERS_ENV        "GIMP_BENCHMARK_LAYERS"
+#define GIMP_BENCHMARK_ITERATIONS_ENV    "GIMP_BENCHMARK_ITERATIONS"
+#define GIMP_BENCHMARK_PAINT_RECORD_ENV  "GIMP_BENCHMARK_PAINT_RECORD"
+
+#define GIMP_BENCHMARK_DEFAULT_SIZE       2048
+#define GIMP_BENCHMARK_DEFAULT_LAYERS     8
+#define GIMP_BENCHMARK_DEFAULT_ITERATIONS 3
+
+#define GIMP_BENCHMARK_STROKE_POINTS      256
+#define GIMP_BENCHMARK_BRUSH_SIZE         64.0
+
+#define ADD_BENCHMARK(function) \
+  g_test_add ("/gimp-benchmark/" #function, \
+              GimpTestFixture, \
+              gimp, \
+              gimp_benchmark_image_setup, \
+              function, \
+              gimp_benchmark_image_teardown);
+
+
+typedef struct
+{
+  GimpImage *image;
+} GimpTestFixture;
+
+
+static void gimp_benchmark_image_setup    (GimpTestFixture *fixture,
+                                           gconstpointer    data);
+static void gimp_benchmark_image_teardown (GimpTestFixture *fixture,
+                                           gconstpointer    data);
+
+
+static gint benchmark_size       = GIMP_BENCHMARK_DEFAULT_SIZE;
+static gint benchmark_layers     = GIMP_BENCHMARK_DEFAULT_LAYERS;
+static gint benchmark_iterations = GIMP_BENCHMARK_DEFAULT_ITERATIONS;
+
+
+static gint
+gimp_benchmark_get_env (const gchar *name,
+                        gint         default_value)
+{
+  const gchar *value = g_getenv (name);
+
+  if (value && atoi (value) > 0)
+    return atoi (value);
+
+  return default_value;
+}
+
+static void
+gimp_benchmark_report (const gchar *name,
+                       gdouble      seconds)
+{
+  g_print ("benchmark\t%s\t%d\t%d\t%d\t%.6f\n",
+           name,
+           benchmark_size, benchmark_size, benchmark_layers,
+           seconds);
+}
+
+/**
+ * gimp_benchmark_fill_layer:
+ * @layer:
+ * @seed:
+ *
+ * Fills @layer with gradients and some noise, so that its tiles
+ * neither compress trivially nor are incompressible.
+ **/
+static void
+gimp_benchmark_fill_layer (GimpLayer *layer,
+                           guint32    seed)
+{
+  GeglBuffer         *buffer;
+  GeglBufferIterator *iter;
+  GRand              *rand;
+
+  buffer = gimp_drawable_get_buffer (GIMP_DRAWABLE (layer));
+  rand   = g_rand_new_with_seed (seed);
+
+  iter = gegl_buffer_iterator_new (buffer, NULL, 0,
+                                   babl_format ("R'G'B'A u8"),
+                                   GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
+
+  while (gegl_buffer_iterator_next (iter))
+    {
+      const GeglRectangle *roi  = &iter->roi[0];
+      guchar              *data = iter->data[0];
+      gint                 x, y;
+
+      for (y = roi->y; y < roi->y + roi->height; y++)
+        for (x = roi->x; x < roi->x + roi->width; x++)
+          {
+            gint noise = g_rand_int_range (rand, 0, 32);
+
+            data[0] = (x + seed * 37 + noise) & 0xff;
+            data[1] = (y + noise) & 0xff;
+            data[2] = ((x + y) / 2 + noise) & 0xff;
+            data[3] = 255;
+
+            data += 4;
+          }
+    }
+
+  g_rand_free (rand);
+}
+
+/**
+ * gimp_benchmark_image_setup:
+ * @fixture:
+ * @data:
+ *
+ * Creates an RGB image with the configured size and number of
+ * half-transparent, filled layers.
+ **/
+static void
+gimp_benchmark_image_setup (GimpTestFixture *fixture,
+                            gconstpointer    data)
+{
+  Gimp *gimp = GIMP (data);
+  gint  i;
+
+  fixture->image = gimp_image_new (gimp,
+                                   benchmark_size,
+                                   benchmark_size,
+                                   GIMP_RGB,
+                                   GIMP_PRECISION_U8_GAMMA);
+
+  gimp_image_undo_disable (fixture->image);
+
+  for (i = 0; i < benchmark_layers; i++)
+    {
+      GimpLayer *layer;
+
+      layer = gimp_layer_new (fixture->image,
+                              benchmark_size,
+                              benchmark_size,
+                              gimp_image_get_layer_format (fixture->image,
+                                                           TRUE),
+                              "Benchmark Layer",
+                              i == 0 ? 1.0 : 0.5,
+                              GIMP_NORMAL_MODE);
+
+      gimp_benchmark_fill_layer (layer, i);
+
+      gimp_image_add_layer (fixture->image,
+                            layer,
+                            GIMP_IMAGE_ACTIVE_PARENT,
+                            0,
+                            FALSE);
+    }
+
+  gimp_image_undo_enable (fixture->image);
+}
+
+/**
+ * gimp_benchmark_image_teardown:
+ * @fixture:
+ * @data:
+ *
+ * Frees the benchmark image.
+ **/
+static void
+gimp_benchmark_image_teardown (GimpTestFixture *fixture,
+                               gconstpointer    data)
+{
+  g_object_unref (fixture->image);
+}
+
+static GimpLayer *
+gimp_benchmark_get_top_layer (GimpImage *image)
+{
+  return gimp_image_get_layer_iter (image)->data;
+}
+
+static void
+gimp_benchmark_invalidate_layers (GimpImage *image)
+{
+  GList *list;
+
+  for (list = gimp_image_get_layer_iter (image);
+       list;
+       list = g_list_next (list))
+    {
+      gimp_drawable_update (list->data, 0, 0,
+                            benchmark_size, benchmark_size);
+    }
+}
+
+static GFile *
+gimp_benchmark_get_xcf_file (void)
+{
+  gchar *filename;
+  GFile *file;
+
+  filename = g_build_filename (g_get_tmp_dir (), "gimp-benchmark.xcf", NULL);
+  file = g_file_new_for_path (filename);
+  g_free (filename);
+
+  return file;
+}
+
+static void
+gimp_benchmark_save_xcf (GimpImage *image,
+                         GFile     *file)
+{
+  GimpPlugInProcedure *proc;
+  GimpPDBStatusType    status;
+
+  proc = file_procedure_find (image->gimp->plug_in_manager->save_procs,
+                              file,
+                              NULL /*error*/);
+
+  status = file_save (image->gimp,
+                      image,
+                      NULL /*progress*/,
+                      file,
+                      proc,
+                      GIMP_RUN_NONINTERACTIVE,
+                      FALSE /*change_saved_state*/,
+                      FALSE /*export_backward*/,
+                      FALSE /*export_forward*/,
+                      NULL /*error*/);
+
+  g_assert_cmpint (status, ==, GIMP_PDB_SUCCESS);
+}
+
+static GimpPaintOptions *
+gimp_benchmark_paint_options_new (Gimp *gimp)
+{
+  GimpPaintInfo    *paint_info;
+  GimpPaintOptions *options;
+
+  paint_info = gimp_pdb_get_paint_info (gimp, "gimp-paintbrush", NULL);
+  g_assert (paint_info != NULL);
+
+  options = gimp_paint_options_new (paint_info);
+
+  gimp_context_define_properties (GIMP_CONTEXT (options),
+                                  GIMP_CONTEXT_PAINT_PROPS_MASK,
+                                  FALSE);
+  gimp_context_set_parent (GIMP_CONTEXT (options),
+                           gimp_get_user_context (gimp));
+
+  g_object_set (options,
+                "brush-size", GIMP_BENCHMARK_BRUSH_SIZE,
+                NULL);
+
+  return options;
+}
+
+static void
+gimp_benchmark_get_stroke_coords (gint        i,
+                                  GimpCoords *coords)
+{
+  const GimpCoords default_coords = GIMP_COORDS_DEFAULT_VALUES;
+
+  /*  a zigzag over the whole image  */
+  *coords   = default_coords;
+  coords->x = (gdouble) benchmark_size * i /
+              (GIMP_BENCHMARK_STROKE_POINTS - 1);
+  coords->y = (i % 32 < 16 ?
+               benchmark_size * (i % 16) / 16.0 :
+               benchmark_size * (16 - i % 16) / 16.0);
+}
+
+static void
+gimp_benchmark_paint_stroke (GimpImage *image)
+{
+  GimpDrawable     *drawable;
+  GimpPaintOptions *options;
+  GimpPaintCore    *core;
+  GimpCoords        coords[GIMP_BENCHMARK_STROKE_POINTS];
+  gboolean          success;
+  gint              i;
+
+  drawable = GIMP_DRAWABLE (gimp_benchmark_get_top_layer (image));
+  options  = gimp_benchmark_paint_options_new (image->gimp);
+
+  for (i = 0; i < GIMP_BENCHMARK_STROKE_POINTS; i++)
+    gimp_benchmark_get_stroke_coords (i, &coords[i]);
+
+  core = g_object_new (options->paint_info->paint_type, NULL);
+
+  success = gimp_paint_core_stroke (core, drawable, options,
+                                    coords, GIMP_BENCHMARK_STROKE_POINTS,
+                                    TRUE, NULL);
+
+  g_assert (success);
+
+  g_object_unref (core);
+  g_object_unref (options);
+}
+
+/**
+ * gimp_benchmark_get_paint_record:
+ *
+ * Loads the paint record named by GIMP_BENCHMARK_PAINT_RECORD, as
+ * recorded with GIMP_PAINT_RECORD while painting, or makes up a
+ * single stroke with varying pressure and 10 ms between events.
+ **/
+static GimpPaintRecord *
+gimp_benchmark_get_paint_record (void)
+{
+  const gchar     *filename = g_getenv (GIMP_BENCHMARK_PAINT_RECORD_ENV);
+  GimpPaintRecord *record;
+  gint             i;
+
+  if (filename)
+    {
+      GFile  *file  = g_file_new_for_path (filename);
+      GError *error = NULL;
+
+      record = gimp_paint_record_load (file, &error);
+
+      g_assert_no_error (error);
+      g_object_unref (file);
+
+      return record;
+    }
+
+  record = gimp_paint_record_new ();
+
+  gimp_paint_record_begin_stroke (record);
+
+  for (i = 0; i < GIMP_BENCHMARK_STROKE_POINTS; i++)
+    {
+      GimpCoords coords;
+
+      gimp_benchmark_get_stroke_coords (i, &coords);
+      coords.pressure = 0.5 + 0.5 * sin (i * G_PI / 32.0);
+
+      gimp_paint_record_add_event (record, &coords, i * 10);
+    }
+
+  return record;
+}
+
+static gint
+gimp_benchmark_compare_doubles (const gdouble *a,
+                                const gdouble *b)
+{
+  return *a < *b ? -1 : *a > *b ? 1 : 0;
+}
+
+static gdouble
+gimp_benchmark_percentile (GArray  *sorted,
+                           gdouble  percentile)
+{
+  gint index = ceil (percentile / 100.0 * sorted->len) - 1;
+
+  return g_array_index (sorted, gdouble, CLAMP (index, 0, sorted->len - 1));
+}
+
+/**
+ * projection:
+ * @fixture:
+ * @data:
+ *
+ * Times compositing all layers into the image's projection.
+ **/
+static void
+projection (GimpTestFixture *fixture,
+            gconstpointer    data)
+{
+  GimpImage      *image      = fixture->image;
+  GimpProjection *projection = gimp_image_get_projection (image);
+  GeglRectangle   rect       = { 0, 0, benchmark_size, benchmark_size };
+  GeglBuffer     *buffer;
+  guchar         *pixels;
+  GTimer         *timer      = g_timer_new ();
+  gdouble         best       = G_MAXDOUBLE;
+  gint            i;
+
+  buffer = gimp_pickable_get_buffer (GIMP_PICKABLE (projection));
+  pixels = g_malloc ((gsize) benchmark_size * benchmark_size * 4);
+
+  for (i = 0; i < benchmark_iterations; i++)
+    {
+      gimp_benchmark_invalidate_layers (image);
+
+      g_timer_start (timer);
+
+      gimp_pickable_flush (GIMP_PICKABLE (projection));
+
+      /*  read back everything, to render what is rendered on demand  */
+      gegl_buffer_get (buffer, &rect, 1.0, babl_format ("R'G'B'A u8"),
+                       pixels, GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+      best = MIN (best, g_timer_elapsed (timer, NULL));
+    }
+
+  gimp_benchmark_report ("projection", best);
+
+  g_free (pixels);
+  g_timer_destroy (timer);
+}
+
+/**
+ * xcf_save:
+ * @fixture:
+ * @data:
+ *
+ * Times saving the image as XCF, once with all layers changed and once
+ * unchanged since the previous save.
+ **/
+static void
+xcf_save (GimpTestFixture *fixture,
+          gconstpointer    data)
+{
+  GimpImage *image     = fixture->image;
+  GFile     *file      = gimp_benchmark_get_xcf_file ();
+  GTimer    *timer     = g_timer_new ();
+  gdouble    best      = G_MAXDOUBLE;
+  gdouble    unchanged = G_MAXDOUBLE;
+  gint       i;
+
+  for (i = 0; i < benchmark_iterations; i++)
+    {
+      /*  make every level get compressed again  */
+      gimp_benchmark_invalidate_layers (image);
+
+      g_timer_start (timer);
+      gimp_benchmark_save_xcf (image, file);
+      best = MIN (best, g_timer_elapsed (timer, NULL));
+
+      g_timer_start (timer);
+      gimp_benchmark_save_xcf (image, file);
+      unchanged = MIN (unchanged, g_timer_elapsed (timer, NULL));
+    }
+
+  gimp_benchmark_report ("xcf-save", best);
+  gimp_benchmark_report ("xcf-save-unchanged", unchanged);
+
+  g_file_delete (file, NULL, NULL);
+  g_object_unref (file);
+  g_timer_destroy (timer);
+}
+
+/**
+ * xcf_load:
+ * @fixture:
+ * @data:
+ *
+ * Times loading the image from XCF.
+ **/
+static void
+xcf_load (GimpTestFixture *fixture,
+          gconstpointer    data)
+{
+  GimpImage           *image = fixture->image;
+  Gimp                *gimp  = image->gimp;
+  GFile               *file  = gimp_benchmark_get_xcf_file ();
+  GimpPlugInProcedure *proc;
+  GTimer              *timer = g_timer_new ();
+  gdouble              best  = G_MAXDOUBLE;
+  gint                 i;
+
+  gimp_benchmark_save_xcf (image, file);
+
+  proc = file_procedure_find (gimp->plug_in_manager->load_procs,
+                              file,
+                              NULL /*error*/);
+
+  for (i = 0; i < benchmark_iterations; i++)
+    {
+      GimpImage         *loaded_image;
+      GimpPDBStatusType  status;
+
+      g_timer_start (timer);
+
+      loaded_image = file_open_image (gimp,
+                                      gimp_get_user_context (gimp),
+                                      NULL /*progress*/,
+                                      file,
+                                      file,
+                                      FALSE /*as_new*/,
+                                      proc,
+                                      GIMP_RUN_NONINTERACTIVE,
+                                      &status,
+                                      NULL /*mime_type*/,
+                                      NULL /*error*/);
+
+      best = MIN (best, g_timer_elapsed (timer, NULL));
+
+      g_assert (GIMP_IS_IMAGE (loaded_image));
+      g_assert_cmpint (gimp_image_get_n_layers (loaded_image), ==,
+                       benchmark_layers);
+
+      g_object_unref (loaded_image);
+    }
+
+  gimp_benchmark_report ("xcf-load", best);
+
+  g_file_delete (file, NULL, NULL);
+  g_object_unref (file);
+  g_timer_destroy (timer);
+}
+
+/**
+ * paint_stroke:
+ * @fixture:
+ * @data:
+ *
+ * Times a paintbrush stroke over the whole image.
+ **/
+static void
+paint_stroke (GimpTestFixture *fixture,
+              gconstpointer    data)
+{
+  GTimer  *timer = g_timer_new ();
+  gdouble  best  = G_MAXDOUBLE;
+  gint     i;
+
+  for (i = 0; i < benchmark_iterations; i++)
+    {
+      g_timer_start (timer);
+      gimp_benchmark_paint_stroke (fixture->image);
+      best = MIN (best, g_timer_elapsed (timer, NULL));
+    }
+
+  gimp_benchmark_report ("paint-stroke", best);
+
+  g_timer_destroy (timer);
+}
+
+/**
+ * paint_replay:
+ * @fixture:
+ * @data:
+ *
+ * Replays a paint record through the paintbrush and reports the
+ * distribution of the time it took to paint each input event.
+ **/
+static void
+paint_replay (GimpTestFixture *fixture,
+              gconstpointer    data)
+{
+  GimpImage        *image = fixture->image;
+  GimpDrawable     *drawable;
+  GimpPaintOptions *options;
+  GimpPaintCore    *core;
+  GimpPaintRecord  *record;
+  GArray           *latencies;
+  GError           *error = NULL;
+  gint              i;
+
+  drawable  = GIMP_DRAWABLE (gimp_benchmark_get_top_layer (image));
+  options   = gimp_benchmark_paint_options_new (image->gimp);
+  core      = g_object_new (options->paint_info->paint_type, NULL);
+  record    = gimp_benchmark_get_paint_record ();
+  latencies = g_array_new (FALSE, FALSE, sizeof (gdouble));
+
+  for (i = 0; i < benchmark_iterations; i++)
+    {
+      gimp_paint_record_replay (record, core, drawable, options,
+                                TRUE, latencies, &error);
+
+      g_assert_no_error (error);
+    }
+
+  g_assert_cmpint (latencies->len, >, 0);
+
+  g_array_sort (latencies, (GCompareFunc) gimp_benchmark_compare_doubles);
+
+  gimp_benchmark_report ("paint-replay-p50",
+                         gimp_benchmark_percentile (latencies, 50.0));
+  gimp_benchmark_report ("paint-replay-p90",
+                         gimp_benchmark_percentile (latencies, 90.0));
+  gimp_benchmark_report ("paint-replay-p99",
+                         gimp_benchmark_percentile (latencies, 99.0));
+  gimp_benchmark_report ("paint-replay-max",
+                         gimp_benchmark_percentile (latencies, 100.0));
+
+  g_array_free (latencies, TRUE);
+  gimp_paint_record_free (record);
+  g_object_unref (core);
+  g_object_unref (options);
+}
+
+/**
+ * undo_redo:
+ * @fixture:
+ * @data:
+ *
+ * Times undoing and redoing a paintbrush stroke.
+ **/
+static void
+undo_redo (GimpTestFixture *fixture,
+           gconstpointer    data)
+{
+  GimpImage *image     = fixture->image;
+  GTimer    *timer     = g_timer_new ();
+  gdouble    best_undo = G_MAXDOUBLE;
+  gdouble    best_redo = G_MAXDOUBLE;
+  gint       i;
+
+  gimp_benchmark_paint_stroke (image);
+
+  for (i = 0; i < benchmark_iterations; i++)
+    {
+      g_timer_start (timer);
+      g_assert (gimp_image_undo (image));
+      best_undo = MIN (best_undo, g_timer_elapsed (timer, NULL));
+
+      g_timer_start (timer);
+      g_assert (gimp_image_redo (image));
+      best_redo = MIN (best_redo, g_timer_elapsed (timer, NULL));
+    }
+
+  gimp_benchmark_report ("undo", best_undo);
+  gimp_benchmark_report ("redo", best_redo);
+
+  g_timer_destroy (timer);
+}
+
+/**
+ * transform:
+ * @fixture:
+ * @data:
+ *
+ * Times rotating the top layer around the image center.
+ **/
+static void
+transform (GimpTestFixture *fixture,
+           gconstpointer    data)
+{
+  GimpImage   *image   = fixture->image;
+  GimpContext *context = gimp_get_user_context (image->gimp);
+  GimpLayer   *layer   = gimp_benchmark_get_top_layer (image);
+  GimpMatrix3  matrix;
+  GTimer      *timer   = g_timer_new ();
+  gdouble      best    = G_MAXDOUBLE;
+  gint         i;
+
+  gimp_matrix3_identity (&matrix);
+  gimp_matrix3_translate (&matrix,
+                          -benchmark_size / 2.0, -benchmark_size / 2.0);
+  gimp_matrix3_rotate (&matrix, G_PI / 6.0);
+  gimp_matrix3_translate (&matrix,
+                          benchmark_size / 2.0, benchmark_size / 2.0);
+
+  for (i = 0; i < benchmark_iterations; i++)
+    {
+      g_timer_start (timer);
+
+      gimp_item_transform (GIMP_ITEM (layer), context, &matrix,
+                           GIMP_TRANSFORM_FORWARD,
+                           GIMP_INTERPOLATION_LINEAR,
+                           GIMP_TRANSFORM_RESIZE_CLIP,
+                           NULL /*progress*/);
+
+      best = MIN (best, g_timer_elapsed (timer, NULL));
+    }
+
+  gimp_benchmark_report ("transform", best);
+
+  g_timer_destroy (timer);
+}
+
+/**
+ * filter:
+ * @fixture:
+ * @data:
+ *
+ * Times applying a gaussian blur to the top layer.
+ **/
+static void
+filter (GimpTestFixture *fixture,
+        gconstpointer    data)
+{
+  GimpImage *image = fixture->image;
+  GimpLayer *layer = gimp_benchmark_get_top_layer (image);
+  GeglNode  *node;
+  GTimer    *timer = g_timer_new ();
+  gdouble    best  = G_MAXDOUBLE;
+  gint       i;
+
+  node = gegl_node_new_child (NULL,
+                              "operation", "gegl:gaussian-blur",
+                              "std-dev-x", 10.0,
+                              "std-dev-y", 10.0,
+                              NULL);
+
+  for (i = 0; i < benchmark_iterations; i++)
+    {
+      g_timer_start (timer);
+
+      gimp_drawable_apply_operation (GIMP_DRAWABLE (layer),
+                                     NULL /*progress*/,
+                                     "Gaussian Blur",
+                                     node);
+
+      best = MIN (best, g_timer_elapsed (timer, NULL));
+    }
+
+  gimp_benchmark_report ("filter-gaussian-blur", best);
+
+  g_object_unref (node);
+  g_timer_destroy (timer);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  Gimp *gimp;
+  int   result;
+
+  g_test_init (&argc, &argv, NULL);
+
+  benchmark_size       = gimp_benchmark_get_env (GIMP_BENCHMARK_SIZE_ENV,
+                                                 GIMP_BENCHMARK_DEFAULT_SIZE);
+  benchmark_layers     = gimp_benchmark_get_env (GIMP_BENCHMARK_LAYERS_ENV,
+                                                 GIMP_BENCHMARK_DEFAULT_LAYERS);
+  benchmark_iterations = gimp_benchmark_get_env (GIMP_BENCHMARK_ITERATIONS_ENV,
+                                                 GIMP_BENCHMARK_DEFAULT_ITERATIONS);
+
+  gimp_test_utils_set_gimp2_directory ("GIMP_TESTING_ABS_TOP_SRCDIR",
+                                       "app/tests/gimpdir");
+
+  /* We share the same application instance across all benchmarks */
+  gimp = gimp_init_for_testing ();
+
+  /* Add benchmarks */
+  ADD_BENCHMARK (projection);
+  ADD_BENCHMARK (xcf_save);
+  ADD_BENCHMARK (xcf_load);
+  ADD_BENCHMARK (paint_stroke);
+  ADD_BENCHMARK (paint_replay);
+  ADD_BENCHMARK (undo_redo);
+  ADD_BENCHMARK (transform);
+  ADD_BENCHMARK (filter);
+
+  /* Don't write files to the source dir */
+  gimp_test_utils_set_gimp2_directory ("GIMP_TESTING_ABS_TOP_BUILDDIR",
+                                       "app/tests/gimpdir-output");
+
+  /* Run the benchmarks */
+  result = g_test_run ();
+
+  /* Exit so we don't break script-fu plug-in wire */
+  gimp_exit (gimp, TRUE);
+
+  return result;
+}
@@ -0,0 +1,611 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <gegl.h>
+#include <gtk/gtk.h>
+
+#include "widgets/widgets-types.h"
+
+#include "core/gimp.h"
+#include "core/gimpboundary.h"
+
+#include "tests.h"
+
+#include "gimp-app-test-utils.h"
+
+
+/*  high enough for several bands of scanlines  */
+#define TEST_WIDTH  123
+#define TEST_HEIGHT 301
+
+#define ADD_TEST(function) \
+  g_test_add_data_func ("/gimp-boundary/" #function, gimp, function);
+
+
+/*  The serial trace as it was before it was split into bands, kept
+ *  here to check that the segments did not change.
+ */
+
+#define REFERENCE_MAX_SEGS_INC 2048
+
+typedef struct
+{
+  GimpBoundSeg *segs;
+  gint          num_segs;
+  gint          max_segs;
+
+  gint         *vert_segs;
+
+  gint         *empty_segs_n;
+  gint         *empty_segs_c;
+  gint         *empty_segs_l;
+  gint          max_empty_segs;
+} ReferenceBoundary;
+
+
+static ReferenceBoundary *
+reference_boundary_new (const GeglRectangle *region)
+{
+  ReferenceBoundary *boundary = g_slice_new0 (ReferenceBoundary);
+  gint               i;
+
+  boundary->vert_segs = g_new (gint, region->width + region->x + 1);
+
+  for (i = 0; i <= (region->width + region->x); i++)
+    boundary->vert_segs[i] = -1;
+
+  boundary->max_empty_segs = region->width + 3;
+
+  boundary->empty_segs_n = g_new (gint, boundary->max_empty_segs);
+  boundary->empty_segs_c = g_new (gint, boundary->max_empty_segs);
+  boundary->empty_segs_l = g_new (gint, boundary->max_empty_segs);
+
+  return boundary;
+}
+
+static GimpBoundSeg *
+reference_boundary_free (ReferenceBoundary *boundary)
+{
+  GimpBoundSeg *segs = boundary->segs;
+
+  g_free (boundary->vert_segs);
+  g_free (boundary->empty_segs_n);
+  g_free (boundary->empty_segs_c);
+  g_free (boundary->empty_segs_l);
+
+  g_slice_free (ReferenceBoundary, boundary);
+
+  return segs;
+}
+
+static void
+reference_boundary_add_seg (ReferenceBoundary *boundary,
+                            gint               x1,
+                            gint               y1,
+                            gint               x2,
+                            gint               y2,
+                            gboolean           open)
+{
+  if (boundary->num_segs >= boundary->max_segs)
+    {
+      boundary->max_segs += REFERENCE_MAX_SEGS_INC;
+
+      boundary->segs = g_renew (GimpBoundSeg, boundary->segs,
+                                boundary->max_segs);
+    }
+
+  boundary->segs[boundary->num_segs].x1      = x1;
+  boundary->segs[boundary->num_segs].y1      = y1;
+  boundary->segs[boundary->num_segs].x2      = x2;
+  boundary->segs[boundary->num_segs].y2      = y2;
+  boundary->segs[boundary->num_segs].open    = open;
+  boundary->segs[boundary->num_segs].visited = FALSE;
+
+  boundary->num_segs ++;
+}
+
+static void
+reference_find_empty_segs (const GeglRectangle *region,
+                           const gfloat        *line_data,
+                           gint                 scanline,
+                           gint                 empty_segs[],
+                           gint                *num_empty,
+                           GimpBoundaryType     type,
+                           gint                 x1,
+                           gint                 y1,
+                           gint                 x2,
+                           gint                 y2,
+                           gfloat               threshold)
+{
+  gint start = 0;
+  gint end   = 0;
+  gint endx  = 0;
+  gint last  = -1;
+  gint l_num_empty;
+  gint x;
+
+  *num_empty = 0;
+
+  if (scanline < region->y || scanline >= (region->y + region->height))
+    {
+      empty_segs[(*num_empty)++] = 0;
+      empty_segs[(*num_empty)++] = G_MAXINT;
+      return;
+    }
+
+  if (type == GIMP_BOUNDARY_WITHIN_BOUNDS)
+    {
+      if (scanline < y1 || scanline >= y2)
+        {
+          empty_segs[(*num_empty)++] = 0;
+          empty_segs[(*num_empty)++] = G_MAXINT;
+          return;
+        }
+
+      start = x1;
+      end   = x2;
+    }
+  else if (type == GIMP_BOUNDARY_IGNORE_BOUNDS)
+    {
+      start = region->x;
+      end   = region->x + region->width;
+      if (scanline < y1 || scanline >= y2)
+        x2 = -1;
+    }
+
+  empty_segs[(*num_empty)++] = 0;
+
+  l_num_empty = *num_empty;
+
+  endx = end;
+
+  line_data += start;
+
+  for (x = start; x < end;)
+    {
+      if (type == GIMP_BOUNDARY_IGNORE_BOUNDS && (endx > x1 || x < x2))
+        {
+          for (; x < endx; x++)
+            {
+              gint val;
+
+              if (*line_data > threshold)
+                {
+                  if (x >= x1 && x < x2)
+                    val = -1;
+                  else
+                    val = 1;
+                }
+              else
+                {
+                  val = -1;
+                }
+
+              line_data++;
+
+              if (last != val)
+                empty_segs[l_num_empty++] = x;
+
+              last = val;
+            }
+        }
+      else
+        {
+          for (; x < endx; x++)
+            {
+              gint val;
+
+              if (*line_data > threshold)
+                val = 1;
+              else
+                val = -1;
+
+              line_data++;
+
+              if (last != val)
+                empty_segs[l_num_empty++] = x;
+
+              last = val;
+            }
+        }
+    }
+
+  *num_empty = l_num_empty;
+
+  if (last > 0)
+    empty_segs[(*num_empty)++] = x;
+
+  empty_segs[(*num_empty)++] = G_MAXINT;
+}
+
+static void
+reference_process_horiz_seg (ReferenceBoundary *boundary,
+                             gint               x1,
+                             gint               y1,
+                             gint               x2,
+                             gint               y2,
+                             gboolean           open)
+{
+  if (boundary->vert_segs[x1] >= 0)
+    {
+      reference_boundary_add_seg (boundary,
+                                  x1, boundary->vert_segs[x1], x1, y1, !open);
+      boundary->vert_segs[x1] = -1;
+    }
+  else
+    boundary->vert_segs[x1] = y1;
+
+  if (boundary->vert_segs[x2] >= 0)
+    {
+      reference_boundary_add_seg (boundary,
+                                  x2, boundary->vert_segs[x2], x2, y2, open);
+      boundary->vert_segs[x2] = -1;
+    }
+  else
+    boundary->vert_segs[x2] = y2;
+
+  reference_boundary_add_seg (boundary, x1, y1, x2, y2, open);
+}
+
+static void
+reference_make_horiz_segs (ReferenceBoundary *boundary,
+                           gint               start,
+                           gint               end,
+                           gint               scanline,
+                           gint               empty[],
+                           gint               num_empty,
+                           gint               top)
+{
+  gint empty_index;
+  gint e_s, e_e;
+
+  for (empty_index = 0; empty_index < num_empty; empty_index += 2)
+    {
+      e_s = *empty++;
+      e_e = *empty++;
+
+      if (e_s <= start && e_e >= end)
+        {
+          reference_process_horiz_seg (boundary,
+                                       start, scanline, end, scanline, top);
+        }
+      else if ((e_s > start && e_s < end) ||
+               (e_e < end && e_e > start))
+        {
+          reference_process_horiz_seg (boundary,
+                                       MAX (e_s, start), scanline,
+                                       MIN (e_e, end), scanline, top);
+        }
+    }
+}
+
+static GimpBoundSeg *
+reference_boundary_find (GeglBuffer          *buffer,
+                         const GeglRectangle *region,
+                         GimpBoundaryType     type,
+                         gint                 x1,
+                         gint                 y1,
+                         gint                 x2,
+                         gint                 y2,
+                         gfloat               threshold,
+                         gint                *num_segs)
+{
+  ReferenceBoundary *boundary;
+  GeglRectangle      line_rect = { 0, };
+  gfloat            *line_data;
+  gint               scanline;
+  gint               i;
+  gint               start = 0;
+  gint               end   = 0;
+  gint              *tmp_segs;
+  gint               num_empty_n = 0;
+  gint               num_empty_c = 0;
+  gint               num_empty_l = 0;
+
+  boundary = reference_boundary_new (region);
+
+  line_rect.width  = gegl_buffer_get_width (buffer);
+  line_rect.height = 1;
+
+  line_data = g_new (gfloat, line_rect.width);
+
+  if (type == GIMP_BOUNDARY_WITHIN_BOUNDS)
+    {
+      start = y1;
+      end   = y2;
+    }
+  else if (type == GIMP_BOUNDARY_IGNORE_BOUNDS)
+    {
+      start = region->y;
+      end   = region->y + region->height;
+    }
+
+  reference_find_empty_segs (region, NULL,
+                             start - 1, boundary->empty_segs_l, &num_empty_l,
+                             type, x1, y1, x2, y2, threshold);
+
+  line_rect.y = start;
+  gegl_buffer_get (buffer, &line_rect, 1.0, babl_format ("Y float"),
+                   line_data, GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  reference_find_empty_segs (region, line_data,
+                             start, boundary->empty_segs_c, &num_empty_c,
+                             type, x1, y1, x2, y2, threshold);
+
+  for (scanline = start; scanline < end; scanline++)
+    {
+      const gfloat *next_data = line_data;
+
+      line_rect.y = scanline + 1;
+      if (scanline + 1 == end)
+        next_data = NULL;
+      else
+        gegl_buffer_get (buffer, &line_rect, 1.0, babl_format ("Y float"),
+                         line_data, GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+      reference_find_empty_segs (region, next_data,
+                                 scanline + 1,
+                                 boundary->empty_segs_n, &num_empty_n,
+                                 type, x1, y1, x2, y2, threshold);
+
+      for (i = 1; i < num_empty_c - 1; i += 2)
+        {
+          reference_make_horiz_segs (boundary,
+                                     boundary->empty_segs_c [i],
+                                     boundary->empty_segs_c [i+1],
+                                     scanline,
+                                     boundary->empty_segs_l, num_empty_l, 1);
+          reference_make_horiz_segs (boundary,
+                                     boundary->empty_segs_c [i],
+                                     boundary->empty_segs_c [i+1],
+                                     scanline + 1,
+                                     boundary->empty_segs_n, num_empty_n, 0);
+        }
+
+      tmp_segs               = boundary->empty_segs_l;
+      boundary->empty_segs_l = boundary->empty_segs_c;
+      num_empty_l            = num_empty_c;
+      boundary->empty_segs_c = boundary->empty_segs_n;
+      num_empty_c            = num_empty_n;
+      boundary->empty_segs_n = tmp_segs;
+    }
+
+  g_free (line_data);
+
+  *num_segs = boundary->num_segs;
+
+  return reference_boundary_free (boundary);
+}
+
+
+/*  fixtures  */
+
+/*  Scatters random rectangles and discs, some of them holes, over an
+ *  empty mask, so that outlines cross the bands' edges in every way.
+ */
+static GeglBuffer *
+create_test_mask (guint32 seed)
+{
+  GeglBuffer *buffer;
+  gfloat     *pixels;
+  GRand      *rand;
+  gint        i;
+
+  rand   = g_rand_new_with_seed (seed);
+  pixels = g_new0 (gfloat, TEST_WIDTH * TEST_HEIGHT);
+
+  for (i = 0; i < 40; i++)
+    {
+      gint   cx    = g_rand_int_range (rand, -10, TEST_WIDTH  + 10);
+      gint   cy    = g_rand_int_range (rand, -10, TEST_HEIGHT + 10);
+      gint   r     = g_rand_int_range (rand, 1, 40);
+      gint   disc  = g_rand_boolean (rand);
+      gfloat value = (i % 4 == 3) ? 0.0 : g_rand_double_range (rand, 0.3, 1.0);
+      gint   x, y;
+
+      for (y = MAX (cy - r, 0); y < MIN (cy + r, TEST_HEIGHT); y++)
+        for (x = MAX (cx - r, 0); x < MIN (cx + r, TEST_WIDTH); x++)
+          {
+            if (! disc || (x - cx) * (x - cx) + (y - cy) * (y - cy) < r * r)
+              pixels[y * TEST_WIDTH + x] = value;
+          }
+    }
+
+  /*  single pixels and one-pixel lines  */
+  for (i = 0; i < 200; i++)
+    {
+      gint x = g_rand_int_range (rand, 0, TEST_WIDTH);
+      gint y = g_rand_int_range (rand, 0, TEST_HEIGHT);
+
+      pixels[y * TEST_WIDTH + x] = 1.0 - pixels[y * TEST_WIDTH + x];
+    }
+
+  buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0, TEST_WIDTH, TEST_HEIGHT),
+                            babl_format ("Y float"));
+
+  gegl_buffer_set (buffer, GEGL_RECTANGLE (0, 0, TEST_WIDTH, TEST_HEIGHT), 0,
+                   babl_format ("Y float"), pixels, GEGL_AUTO_ROWSTRIDE);
+
+  g_free (pixels);
+  g_rand_free (rand);
+
+  return buffer;
+}
+
+static gint
+cmp_segs (const GimpBoundSeg *a,
+          const GimpBoundSeg *b)
+{
+  if (a->x1 != b->x1) return a->x1 - b->x1;
+  if (a->y1 != b->y1) return a->y1 - b->y1;
+  if (a->x2 != b->x2) return a->x2 - b->x2;
+  if (a->y2 != b->y2) return a->y2 - b->y2;
+
+  return (gint) a->open - (gint) b->open;
+}
+
+/*  the bands are concatenated in order, but only the set of segments
+ *  is part of the contract, so compare them sorted
+ */
+static void
+assert_segs_equal (GimpBoundSeg *segs,
+                   gint          num_segs,
+                   GimpBoundSeg *expected,
+                   gint          num_expected)
+{
+  gint i;
+
+  g_assert_cmpint (num_segs, ==, num_expected);
+
+  qsort (segs, num_segs, sizeof (GimpBoundSeg),
+         (GCompareFunc) cmp_segs);
+  qsort (expected, num_expected, sizeof (GimpBoundSeg),
+         (GCompareFunc) cmp_segs);
+
+  for (i = 0; i < num_segs; i++)
+    g_assert_cmpint (cmp_segs (&segs[i], &expected[i]), ==, 0);
+}
+
+static void
+check_boundary (GeglBuffer          *buffer,
+                const GeglRectangle *region,
+                GimpBoundaryType     type,
+                gint                 x1,
+                gint                 y1,
+                gint                 x2,
+                gint                 y2)
+{
+  GeglRectangle  rect = { 0, 0, TEST_WIDTH, TEST_HEIGHT };
+  GimpBoundSeg  *segs;
+  GimpBoundSeg  *expected;
+  gint           num_segs;
+  gint           num_expected;
+
+  if (region)
+    rect = *region;
+
+  segs = gimp_boundary_find (buffer, region, babl_format ("Y float"),
+                             type, x1, y1, x2, y2,
+                             GIMP_BOUNDARY_HALF_WAY, &num_segs);
+  expected = reference_boundary_find (buffer, &rect,
+                                      type, x1, y1, x2, y2,
+                                      GIMP_BOUNDARY_HALF_WAY, &num_expected);
+
+  assert_segs_equal (segs, num_segs, expected, num_expected);
+
+  g_free (segs);
+  g_free (expected);
+}
+
+
+/*  tests  */
+
+/**
+ * within_bounds_matches_reference:
+ * @data:
+ *
+ * Trace random masks inside bounds that cover all of the mask, start
+ * and end in the middle of a band, or are a single scanline high,
+ * and compare the segments to the ones of the serial trace.
+ **/
+static void
+within_bounds_matches_reference (gconstpointer data)
+{
+  const GeglRectangle region = { 0, 0, TEST_WIDTH, TEST_HEIGHT };
+  guint32             seed;
+
+  for (seed = 1; seed <= 8; seed++)
+    {
+      GeglBuffer *buffer = create_test_mask (seed);
+
+      check_boundary (buffer, &region, GIMP_BOUNDARY_WITHIN_BOUNDS,
+                      0, 0, TEST_WIDTH, TEST_HEIGHT);
+      check_boundary (buffer, &region, GIMP_BOUNDARY_WITHIN_BOUNDS,
+                      7, 31, TEST_WIDTH - 13, TEST_HEIGHT - 50);
+      check_boundary (buffer, &region, GIMP_BOUNDARY_WITHIN_BOUNDS,
+                      0, 100, TEST_WIDTH, 101);
+
+      g_object_unref (buffer);
+    }
+}
+
+/**
+ * ignore_bounds_matches_reference:
+ * @data:
+ *
+ * Trace random masks in an offset region with a hole punched by the
+ * bounds, the way floating selections are traced, and compare the
+ * segments to the ones of the serial trace.
+ **/
+static void
+ignore_bounds_matches_reference (gconstpointer data)
+{
+  const GeglRectangle region = { 5, 9, TEST_WIDTH - 11, TEST_HEIGHT - 20 };
+  guint32             seed;
+
+  for (seed = 1; seed <= 8; seed++)
+    {
+      GeglBuffer *buffer = create_test_mask (seed);
+
+      check_boundary (buffer, &region, GIMP_BOUNDARY_IGNORE_BOUNDS,
+                      20, 70, 80, 200);
+      check_boundary (buffer, NULL, GIMP_BOUNDARY_IGNORE_BOUNDS,
+                      0, 0, 0, 0);
+
+      g_object_unref (buffer);
+    }
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  Gimp *gimp;
+  int   result;
+
+  g_test_init (&argc, &argv, NULL);
+
+  gimp_test_utils_set_gimp2_directory ("GIMP_TESTING_ABS_TOP_SRCDIR",
+                                       "app/tests/gimpdir");
+
+  /* We share the same application instance across all tests */
+  gimp = gimp_init_for_testing ();
+
+  /* Make sure the scanlines are split into bands */
+  g_object_set (gimp->config,
+                "num-processors", 4,
+                NULL);
+
+  /* Add tests */
+  ADD_TEST (within_bounds_matches_reference);
+  ADD_TEST (ignore_bounds_matches_reference);
+
+  /* Run the tests */
+  result = g_test_run ();
+
+  /* Don't write files to the source dir */
+  gimp_test_utils_set_gimp2_directory ("GIMP_TESTING_ABS_TOP_BUILDDIR",
+                                       "app/tests/gimpdir-output");
+
+  /* Exit so we don't break script-fu plug-in wire */
+  gimp_exit (gimp, TRUE);
+
+  return result;
+}
@@ -0,0 +1,547 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include <gegl.h>
+#include <gtk/gtk.h>
+
+#include "libgimpmath/gimpmath.h"
+
+#include "widgets/widgets-types.h"
+
+#include "core/gimp.h"
+#include "core/gimpbrushgenerated.h"
+#include "core/gimptempbuf.h"
+
+#include "tests.h"
+
+#include "gimp-app-test-utils.h"
+
+
+#define OVERSAMPLING 4
+
+#define ADD_TEST(function) \
+  g_test_add_data_func ("/gimp-brush-generated/" #function, gimp, function);
+
+
+static const GimpBrushGeneratedShape shapes[] =
+{
+  GIMP_BRUSH_GENERATED_CIRCLE,
+  GIMP_BRUSH_GENERATED_SQUARE,
+  GIMP_BRUSH_GENERATED_DIAMOND
+};
+
+static const gfloat radii[]    = { 0.5, 1.5, 5.0, 12.3, 25.0 };
+static const gint   spikes[]   = { 2, 3, 4, 5 };
+static const gfloat aspects[]  = { 1.0, 2.7 };
+static const gfloat angles[]   = { 0.0, 30.0, 90.0, 135.0, 180.0, 270.0 };
+static const gfloat hardness[] = { 0.3, 1.0 };
+
+
+/*  The mask rendering as it was before, to compare with  */
+
+static gdouble
+reference_gauss (gdouble f)
+{
+  /* this aint' a real gauss function */
+  if (f < -0.5)
+    {
+      f = -1.0 - f;
+      return (2.0 * f*f);
+    }
+
+  if (f < 0.5)
+    return (1.0 - 2.0 * f*f);
+
+  f = 1.0 - f;
+  return (2.0 * f*f);
+}
+
+static guchar *
+reference_calc_lut (gdouble radius,
+                    gdouble hardness)
+{
+  guchar  *lookup;
+  gint     length;
+  gint     x;
+  gdouble  d;
+  gdouble  sum;
+  gdouble  exponent;
+  gdouble  buffer[OVERSAMPLING];
+
+  length = OVERSAMPLING * ceil (1 + sqrt (2 * SQR (ceil (radius + 1.0))));
+
+  lookup = g_malloc (length);
+  sum = 0.0;
+
+  if ((1.0 - hardness) < 0.0000004)
+    exponent = 1000000.0;
+  else
+    exponent = 0.4 / (1.0 - hardness);
+
+  for (x = 0; x < OVERSAMPLING; x++)
+    {
+      d = fabs ((x + 0.5) / OVERSAMPLING - 0.5);
+
+      if (d > radius)
+        buffer[x] = 0.0;
+      else
+        buffer[x] = reference_gauss (pow (d / radius, exponent));
+
+      sum += buffer[x];
+    }
+
+  for (x = 0; d < radius || sum > 0.00001; d += 1.0 / OVERSAMPLING)
+    {
+      sum -= buffer[x % OVERSAMPLING];
+
+      if (d > radius)
+        buffer[x % OVERSAMPLING] = 0.0;
+      else
+        buffer[x % OVERSAMPLING] = reference_gauss (pow (d / radius, exponent));
+
+      sum += buffer[x % OVERSAMPLING];
+      lookup[x++] = RINT (sum * (255.0 / OVERSAMPLING));
+    }
+
+  while (x < length)
+    {
+      lookup[x++] = 0;
+    }
+
+  return lookup;
+}
+
+static void
+reference_get_size (GimpBrushGeneratedShape  shape,
+                    gfloat                   radius,
+                    gint                     spikes,
+                    gfloat                   aspect_ratio,
+                    gdouble                  angle_in_degrees,
+                    gint                    *width,
+                    gint                    *height,
+                    gdouble                 *_s,
+                    gdouble                 *_c)
+{
+  gdouble      half_width  = 0.0;
+  gdouble      half_height = 0.0;
+  gint         w, h;
+  gdouble      c, s;
+  gdouble      short_radius;
+  GimpVector2  x_axis;
+  GimpVector2  y_axis;
+
+  angle_in_degrees = ROUND (angle_in_degrees * 1000.0) / 1000.0;
+
+  s = sin (gimp_deg_to_rad (angle_in_degrees));
+  c = cos (gimp_deg_to_rad (angle_in_degrees));
+
+  short_radius = radius / aspect_ratio;
+
+  x_axis.x =        c * radius;
+  x_axis.y = -1.0 * s * radius;
+  y_axis.x =        s * short_radius;
+  y_axis.y =        c * short_radius;
+
+  switch (shape)
+    {
+    case GIMP_BRUSH_GENERATED_CIRCLE:
+      half_width  = sqrt (x_axis.x * x_axis.x + y_axis.x * y_axis.x);
+      half_height = sqrt (x_axis.y * x_axis.y + y_axis.y * y_axis.y);
+      break;
+
+    case GIMP_BRUSH_GENERATED_SQUARE:
+      half_width  = fabs (x_axis.x) + fabs (y_axis.x);
+      half_height = fabs (x_axis.y) + fabs (y_axis.y);
+      break;
+
+    case GIMP_BRUSH_GENERATED_DIAMOND:
+      half_width  = MAX (fabs (x_axis.x), fabs (y_axis.x));
+      half_height = MAX (fabs (x_axis.y), fabs (y_axis.y));
+      break;
+    }
+
+  if (spikes > 2)
+    {
+      half_width = half_height = sqrt (radius * radius +
+                                       short_radius * short_radius);
+    }
+
+  w = MAX (1, ceil (half_width  * 2));
+  h = MAX (1, ceil (half_height * 2));
+
+  if (! (w & 0x1)) w++;
+  if (! (h & 0x1)) h++;
+
+  *width  = w;
+  *height = h;
+  *_s     = s;
+  *_c     = c;
+}
+
+static guchar *
+reference_calc (GimpBrushGeneratedShape  shape,
+                gfloat                   radius,
+                gint                     spikes,
+                gfloat                   hardness,
+                gfloat                   aspect_ratio,
+                gfloat                   angle,
+                gint                    *width,
+                gint                    *height)
+{
+  guchar  *mask;
+  guchar  *centerp;
+  guchar  *lookup;
+  guchar   a;
+  gint     x, y;
+  gdouble  c, s, cs, ss;
+  gint     half_width;
+  gint     half_height;
+
+  reference_get_size (shape, radius, spikes, aspect_ratio, angle,
+                      width, height, &s, &c);
+
+  mask = g_new0 (guchar, *width * *height);
+
+  half_width  = *width  / 2;
+  half_height = *height / 2;
+
+  centerp = mask + half_height * *width + half_width;
+
+  lookup = reference_calc_lut (radius, hardness);
+
+  cs = cos (- 2 * G_PI / spikes);
+  ss = sin (- 2 * G_PI / spikes);
+
+  /* for an even number of spikes compute one half and mirror it */
+  for (y = ((spikes % 2) ? -half_height : 0); y <= half_height; y++)
+    {
+      for (x = -half_width; x <= half_width; x++)
+        {
+          gdouble d  = 0;
+          gdouble tx = c * x - s * y;
+          gdouble ty = fabs (s * x + c * y);
+
+          if (spikes > 2)
+            {
+              gdouble angle = atan2 (ty, tx);
+
+              while (angle > G_PI / spikes)
+                {
+                  gdouble sx = tx;
+                  gdouble sy = ty;
+
+                  tx = cs * sx - ss * sy;
+                  ty = ss * sx + cs * sy;
+
+                  angle -= 2 * G_PI / spikes;
+                }
+            }
+
+          ty *= aspect_ratio;
+
+          switch (shape)
+            {
+            case GIMP_BRUSH_GENERATED_CIRCLE:
+              d = sqrt (SQR (tx) + SQR (ty));
+              break;
+            case GIMP_BRUSH_GENERATED_SQUARE:
+              d = MAX (fabs (tx), fabs (ty));
+              break;
+            case GIMP_BRUSH_GENERATED_DIAMOND:
+              d = fabs (tx) + fabs (ty);
+              break;
+            }
+
+          if (d < radius + 1)
+            a = lookup[(gint) RINT (d * OVERSAMPLING)];
+          else
+            a = 0;
+
+          centerp[y * *width + x] = a;
+
+          if (spikes % 2 == 0)
+            centerp[-1 * y * *width - x] = a;
+        }
+    }
+
+  g_free (lookup);
+
+  return mask;
+}
+
+/*  what gimp_brush_transform_mask() rendered before, for parameters
+ *  which are already on the steps the parameters are rounded to now
+ */
+static guchar *
+reference_transform_mask (GimpBrushGenerated *brush,
+                          gdouble             scale,
+                          gdouble             aspect_ratio,
+                          gdouble             angle,
+                          gdouble             hardness,
+                          gint               *width,
+                          gint               *height)
+{
+  gdouble ratio;
+
+  if (aspect_ratio == 0.0)
+    {
+      ratio = gimp_brush_generated_get_aspect_ratio (brush);
+    }
+  else
+    {
+      ratio = MIN (fabs (aspect_ratio) + 1, 20);
+
+      if (aspect_ratio < 0.0)
+        angle = angle + 0.25;
+    }
+
+  return reference_calc (gimp_brush_generated_get_shape (brush),
+                         gimp_brush_generated_get_radius (brush) * scale,
+                         gimp_brush_generated_get_spikes (brush),
+                         hardness,
+                         ratio,
+                         gimp_brush_generated_get_angle (brush) + 360 * angle,
+                         width, height);
+}
+
+static void
+assert_mask_equal (const GimpTempBuf *mask,
+                   const guchar      *expected,
+                   gint               width,
+                   gint               height)
+{
+  g_assert_cmpint (gimp_temp_buf_get_width  (mask), ==, width);
+  g_assert_cmpint (gimp_temp_buf_get_height (mask), ==, height);
+
+  g_assert (memcmp (gimp_temp_buf_get_data (mask), expected,
+                    width * height) == 0);
+}
+
+
+/*  tests  */
+
+/**
+ * brush_mask_is_unchanged:
+ * @data:
+ *
+ * The mask of a generated brush must be the same as before the
+ * rendering was rewritten, for all shapes and a range of parameters.
+ **/
+static void
+brush_mask_is_unchanged (gconstpointer data)
+{
+  gint i_shape, i_radius, i_spikes, i_aspect, i_angle, i_hard;
+
+  for (i_shape = 0; i_shape < G_N_ELEMENTS (shapes); i_shape++)
+    for (i_radius = 0; i_radius < G_N_ELEMENTS (radii); i_radius++)
+      for (i_spikes = 0; i_spikes < G_N_ELEMENTS (spikes); i_spikes++)
+        for (i_aspect = 0; i_aspect < G_N_ELEMENTS (aspects); i_aspect++)
+          for (i_angle = 0; i_angle < G_N_ELEMENTS (angles); i_angle++)
+            for (i_hard = 0; i_hard < G_N_ELEMENTS (hardness); i_hard++)
+              {
+                GimpBrushGenerated *brush;
+                guchar             *expected;
+                gint                width;
+                gint                height;
+
+                brush = GIMP_BRUSH_GENERATED (
+                  gimp_brush_generated_new ("Test Brush",
+                                            shapes[i_shape],
+                                            radii[i_radius],
+                                            spikes[i_spikes],
+                                            hardness[i_hard],
+                                            aspects[i_aspect],
+                                            angles[i_angle]));
+
+                expected =
+                  reference_calc (gimp_brush_generated_get_shape (brush),
+                                  gimp_brush_generated_get_radius (brush),
+                                  gimp_brush_generated_get_spikes (brush),
+                                  gimp_brush_generated_get_hardness (brush),
+                                  gimp_brush_generated_get_aspect_ratio (brush),
+                                  gimp_brush_generated_get_angle (brush),
+                                  &width, &height);
+
+                assert_mask_equal (gimp_brush_get_mask (GIMP_BRUSH (brush)),
+                                   expected, width, height);
+
+                g_free (expected);
+                g_object_unref (brush);
+              }
+}
+
+/**
+ * transform_mask_is_unchanged:
+ * @data:
+ *
+ * Transforming a generated brush with parameters which need no
+ * rounding must render the same mask as before.
+ **/
+static void
+transform_mask_is_unchanged (gconstpointer data)
+{
+  /*  in steps of a quarter pixel of radius, 1/100 aspect ratio,
+   *  half a degree and 1/255 hardness
+   */
+  static const gint scale_steps[]  = { 3, 19, 31, 53 };
+  static const gint aspect_steps[] = { 0, 150, -240 };
+  static const gint angle_steps[]  = { 0, 45, 180, 277 };
+  static const gint hard_steps[]   = { 51, 200, 255 };
+  gint              i_shape, i_spikes;
+  gint              i_scale, i_aspect, i_angle, i_hard;
+
+  for (i_shape = 0; i_shape < G_N_ELEMENTS (shapes); i_shape++)
+    for (i_spikes = 0; i_spikes < G_N_ELEMENTS (spikes); i_spikes++)
+      {
+        GimpBrushGenerated *brush;
+        gdouble             radius;
+
+        brush = GIMP_BRUSH_GENERATED (
+          gimp_brush_generated_new ("Test Brush",
+                                    shapes[i_shape],
+                                    7.5,
+                                    spikes[i_spikes],
+                                    0.5,
+                                    1.5,
+                                    20.0));
+
+        radius = gimp_brush_generated_get_radius (brush);
+
+        for (i_scale = 0; i_scale < G_N_ELEMENTS (scale_steps); i_scale++)
+          for (i_aspect = 0; i_aspect < G_N_ELEMENTS (aspect_steps); i_aspect++)
+            for (i_angle = 0; i_angle < G_N_ELEMENTS (angle_steps); i_angle++)
+              for (i_hard = 0; i_hard < G_N_ELEMENTS (hard_steps); i_hard++)
+                {
+                  const GimpTempBuf *mask;
+                  guchar            *expected;
+                  gdouble            scale;
+                  gdouble            aspect;
+                  gdouble            angle;
+                  gdouble            hard;
+                  gint               width;
+                  gint               height;
+
+                  scale  = scale_steps[i_scale]   / (radius * 4.0);
+                  aspect = aspect_steps[i_aspect] / 100.0;
+                  angle  = angle_steps[i_angle]   / 720.0;
+                  hard   = hard_steps[i_hard]     / 255.0;
+
+                  mask = gimp_brush_transform_mask (GIMP_BRUSH (brush),
+                                                    scale, aspect,
+                                                    angle, hard);
+
+                  expected = reference_transform_mask (brush,
+                                                       scale, aspect,
+                                                       angle, hard,
+                                                       &width, &height);
+
+                  assert_mask_equal (mask, expected, width, height);
+
+                  g_free (expected);
+                }
+
+        g_object_unref (brush);
+      }
+}
+
+/**
+ * transform_mask_is_shared:
+ * @data:
+ *
+ * Parameters which differ by less than half a rounding step must get
+ * the same mask from the cache.
+ **/
+static void
+transform_mask_is_shared (gconstpointer data)
+{
+  GimpBrushGenerated *brush;
+  const GimpTempBuf  *mask;
+  gdouble             radius;
+  gdouble             scale  = 0.8;
+  gdouble             aspect = 1.25;
+  gdouble             angle  = 0.1;
+  gdouble             hard   = 0.6;
+  gint                width, height;
+  gint                i;
+
+  brush = GIMP_BRUSH_GENERATED (
+    gimp_brush_generated_new ("Test Brush",
+                              GIMP_BRUSH_GENERATED_CIRCLE,
+                              10.0, 2, 0.5, 1.0, 0.0));
+
+  radius = gimp_brush_generated_get_radius (brush);
+
+  mask = gimp_brush_transform_mask (GIMP_BRUSH (brush),
+                                    scale, aspect, angle, hard);
+
+  for (i = -3; i <= 3; i++)
+    {
+      gdouble offset = i / 8.0;
+
+      gimp_brush_transform_size (GIMP_BRUSH (brush),
+                                 scale  + offset / (radius * 4.0),
+                                 aspect + offset / 100.0,
+                                 angle  + offset / 720.0,
+                                 &width, &height);
+
+      g_assert_cmpint (width,  ==, gimp_temp_buf_get_width  (mask));
+      g_assert_cmpint (height, ==, gimp_temp_buf_get_height (mask));
+
+      g_assert (gimp_brush_transform_mask (GIMP_BRUSH (brush),
+                                           scale  + offset / (radius * 4.0),
+                                           aspect + offset / 100.0,
+                                           angle  + offset / 720.0,
+                                           hard   + offset / 255.0) == mask);
+    }
+
+  g_object_unref (brush);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  Gimp *gimp;
+  int   result;
+
+  g_test_init (&argc, &argv, NULL);
+
+  gimp_test_utils_set_gimp2_directory ("GIMP_TESTING_ABS_TOP_SRCDIR",
+                                       "app/tests/gimpdir");
+
+  /* We share the same application instance across all tests */
+  gimp = gimp_init_for_testing ();
+
+  /* Add tests */
+  ADD_TEST (brush_mask_is_unchanged);
+  ADD_TEST (transform_mask_is_unchanged);
+  ADD_TEST (transform_mask_is_shared);
+
+  /* Run the tests */
+  result = g_test_run ();
+
+  /* Don't write files to the source dir */
+  gimp_test_utils_set_gimp2_directory ("GIMP_TESTING_ABS_TOP_BUILDDIR",
+                                       "app/tests/gimpdir-output");
+
+  /* Exit so we don't break script-fu plug-in wire */
+  gimp_exit (gimp, TRUE);
+
+  return result;
+}
@@ -0,0 +1,666 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include <gegl.h>
+#include <gtk/gtk.h>
+
+#include "libgimpcolor/gimpcolor.h"
+#include "libgimpmath/gimpmath.h"
+
+#include "widgets/widgets-types.h"
+
+#include "gegl/gimp-babl.h"
+
+#include "core/gimp.h"
+#include "core/gimpdrawable.h"
+#include "core/gimpimage.h"
+#include "core/gimplayer.h"
+#include "core/gimppickable.h"
+#include "core/gimppickable-contiguous-region.h"
+
+#include "tests.h"
+
+#include "gimp-app-test-utils.h"
+
+
+/*  not a multiple of the tile or chunk sizes on purpose  */
+#define TEST_WIDTH  141
+#define TEST_HEIGHT 97
+
+#define ADD_TEST(function) \
+  g_test_add_data_func ("/gimp-contiguous-region/" #function, gimp, function);
+
+
+/*  The fill as it was before it fetched whole chunks, kept here to
+ *  check that the masks did not change.
+ */
+
+static const Babl *
+reference_choose_format (GeglBuffer          *buffer,
+                         GimpSelectCriterion  select_criterion,
+                         gint                *n_components,
+                         gboolean            *has_alpha)
+{
+  const Babl *format = gegl_buffer_get_format (buffer);
+
+  *has_alpha = babl_format_has_alpha (format);
+
+  switch (select_criterion)
+    {
+    case GIMP_SELECT_CRITERION_COMPOSITE:
+      if (babl_format_is_palette (format))
+        format = babl_format ("R'G'B'A float");
+      else
+        format = gimp_babl_format (gimp_babl_format_get_base_type (format),
+                                   GIMP_PRECISION_FLOAT_GAMMA,
+                                   *has_alpha);
+      break;
+
+    case GIMP_SELECT_CRITERION_R:
+    case GIMP_SELECT_CRITERION_G:
+    case GIMP_SELECT_CRITERION_B:
+      format = babl_format ("R'G'B'A float");
+      break;
+
+    case GIMP_SELECT_CRITERION_H:
+    case GIMP_SELECT_CRITERION_S:
+    case GIMP_SELECT_CRITERION_V:
+      format = babl_format ("HSVA float");
+      break;
+
+    default:
+      g_return_val_if_reached (NULL);
+      break;
+    }
+
+  *n_components = babl_format_get_n_components (format);
+
+  return format;
+}
+
+static gfloat
+reference_pixel_difference (const gfloat        *col1,
+                            const gfloat        *col2,
+                            gboolean             antialias,
+                            gfloat               threshold,
+                            gint                 n_components,
+                            gboolean             has_alpha,
+                            gboolean             select_transparent,
+                            GimpSelectCriterion  select_criterion)
+{
+  gfloat max = 0.0;
+
+  if (! select_transparent && has_alpha && col2[n_components - 1] == 0.0)
+    return 0.0;
+
+  if (select_transparent && has_alpha)
+    {
+      max = fabs (col1[n_components - 1] - col2[n_components - 1]);
+    }
+  else
+    {
+      gfloat diff;
+      gint   b;
+
+      if (has_alpha)
+        n_components--;
+
+      switch (select_criterion)
+        {
+        case GIMP_SELECT_CRITERION_COMPOSITE:
+          for (b = 0; b < n_components; b++)
+            {
+              diff = fabs (col1[b] - col2[b]);
+              if (diff > max)
+                max = diff;
+            }
+          break;
+
+        case GIMP_SELECT_CRITERION_R:
+          max = fabs (col1[0] - col2[0]);
+          break;
+
+        case GIMP_SELECT_CRITERION_G:
+          max = fabs (col1[1] - col2[1]);
+          break;
+
+        case GIMP_SELECT_CRITERION_B:
+          max = fabs (col1[2] - col2[2]);
+          break;
+
+        case GIMP_SELECT_CRITERION_H:
+          {
+            gfloat dist1 = fabs (col1[0] - col2[0]);
+            gfloat dist2 = fabs (col1[0] - 1.0 - col2[0]);
+            gfloat dist3 = fabs (col1[0] - col2[0] + 1.0);
+
+            max = MIN (dist1, dist2);
+            if (max > dist3)
+              max = dist3;
+          }
+          break;
+
+        case GIMP_SELECT_CRITERION_S:
+          max = fabs (col1[1] - col2[1]);
+          break;
+
+        case GIMP_SELECT_CRITERION_V:
+          max = fabs (col1[2] - col2[2]);
+          break;
+        }
+    }
+
+  if (antialias && threshold > 0.0)
+    {
+      gfloat aa = 1.5 - (max / threshold);
+
+      if (aa <= 0.0)
+        return 0.0;
+      else if (aa < 0.5)
+        return aa * 2.0;
+      else
+        return 1.0;
+    }
+  else
+    {
+      if (max > threshold)
+        return 0.0;
+      else
+        return 1.0;
+    }
+}
+
+static gboolean
+reference_find_contiguous_segment (const gfloat        *col,
+                                   GeglBuffer          *src_buffer,
+                                   GeglBuffer          *mask_buffer,
+                                   const Babl          *format,
+                                   gint                 n_components,
+                                   gboolean             has_alpha,
+                                   gint                 width,
+                                   gboolean             select_transparent,
+                                   GimpSelectCriterion  select_criterion,
+                                   gboolean             antialias,
+                                   gfloat               threshold,
+                                   gint                 initial_x,
+                                   gint                 initial_y,
+                                   gint                *start,
+                                   gint                *end)
+{
+  gfloat *s;
+  gfloat  mask_row[width];
+  gfloat  diff;
+
+  s = g_alloca (n_components * sizeof (gfloat));
+
+  gegl_buffer_sample (src_buffer, initial_x, initial_y, NULL, s, format,
+                      GEGL_SAMPLER_NEAREST, GEGL_ABYSS_NONE);
+
+  diff = reference_pixel_difference (col, s, antialias, threshold,
+                                     n_components, has_alpha,
+                                     select_transparent, select_criterion);
+
+  if (! diff)
+    return FALSE;
+
+  mask_row[initial_x] = diff;
+
+  *start = initial_x - 1;
+
+  while (*start >= 0 && diff)
+    {
+      gegl_buffer_sample (src_buffer, *start, initial_y, NULL, s, format,
+                          GEGL_SAMPLER_NEAREST, GEGL_ABYSS_NONE);
+
+      diff = reference_pixel_difference (col, s, antialias, threshold,
+                                         n_components, has_alpha,
+                                         select_transparent, select_criterion);
+
+      mask_row[*start] = diff;
+
+      if (diff)
+        (*start)--;
+    }
+
+  diff = 1;
+  *end = initial_x + 1;
+
+  while (*end < width && diff)
+    {
+      gegl_buffer_sample (src_buffer, *end, initial_y, NULL, s, format,
+                          GEGL_SAMPLER_NEAREST, GEGL_ABYSS_NONE);
+
+      diff = reference_pixel_difference (col, s, antialias, threshold,
+                                         n_components, has_alpha,
+                                         select_transparent, select_criterion);
+
+      mask_row[*end] = diff;
+
+      if (diff)
+        (*end)++;
+    }
+
+  /*  the old code wrote mask_row[-1] here when the segment touched
+   *  the left edge, which is the out-of-bounds read the rewrite fixed;
+   *  skip that one (always zero) pixel so the reference is well-defined
+   */
+  if (*start < 0)
+    gegl_buffer_set (mask_buffer, GEGL_RECTANGLE (0, initial_y, *end, 1),
+                     0, babl_format ("Y float"), &mask_row[0],
+                     GEGL_AUTO_ROWSTRIDE);
+  else
+    gegl_buffer_set (mask_buffer, GEGL_RECTANGLE (*start, initial_y,
+                                                  *end - *start, 1),
+                     0, babl_format ("Y float"), &mask_row[*start],
+                     GEGL_AUTO_ROWSTRIDE);
+
+  return TRUE;
+}
+
+static void
+reference_find_contiguous_region (GeglBuffer          *src_buffer,
+                                  GeglBuffer          *mask_buffer,
+                                  const Babl          *format,
+                                  gint                 n_components,
+                                  gboolean             has_alpha,
+                                  gboolean             select_transparent,
+                                  GimpSelectCriterion  select_criterion,
+                                  gboolean             antialias,
+                                  gfloat               threshold,
+                                  gint                 x,
+                                  gint                 y,
+                                  const gfloat        *col)
+{
+  gint    start, end;
+  gint    new_start, new_end;
+  GQueue *coord_stack;
+
+  coord_stack = g_queue_new ();
+
+  g_queue_push_tail (coord_stack, GINT_TO_POINTER (y));
+  g_queue_push_tail (coord_stack, GINT_TO_POINTER (x - 1));
+  g_queue_push_tail (coord_stack, GINT_TO_POINTER (x + 1));
+
+  do
+    {
+      y     = GPOINTER_TO_INT (g_queue_pop_head (coord_stack));
+      start = GPOINTER_TO_INT (g_queue_pop_head (coord_stack));
+      end   = GPOINTER_TO_INT (g_queue_pop_head (coord_stack));
+
+      for (x = start + 1; x < end; x++)
+        {
+          gfloat val;
+
+          gegl_buffer_sample (mask_buffer, x, y, NULL, &val,
+                              babl_format ("Y float"),
+                              GEGL_SAMPLER_NEAREST, GEGL_ABYSS_NONE);
+          if (val != 0.0)
+            continue;
+
+          if (! reference_find_contiguous_segment (col, src_buffer,
+                                                   mask_buffer, format,
+                                                   n_components, has_alpha,
+                                                   gegl_buffer_get_width (src_buffer),
+                                                   select_transparent,
+                                                   select_criterion,
+                                                   antialias, threshold,
+                                                   x, y,
+                                                   &new_start, &new_end))
+            continue;
+
+          if (y + 1 < gegl_buffer_get_height (src_buffer))
+            {
+              g_queue_push_tail (coord_stack, GINT_TO_POINTER (y + 1));
+              g_queue_push_tail (coord_stack, GINT_TO_POINTER (new_start));
+              g_queue_push_tail (coord_stack, GINT_TO_POINTER (new_end));
+            }
+
+          if (y - 1 >= 0)
+            {
+              g_queue_push_tail (coord_stack, GINT_TO_POINTER (y - 1));
+              g_queue_push_tail (coord_stack, GINT_TO_POINTER (new_start));
+              g_queue_push_tail (coord_stack, GINT_TO_POINTER (new_end));
+            }
+        }
+    }
+  while (! g_queue_is_empty (coord_stack));
+
+  g_queue_free (coord_stack);
+}
+
+static GeglBuffer *
+reference_by_seed (GimpPickable        *pickable,
+                   gboolean             antialias,
+                   gfloat               threshold,
+                   gboolean             select_transparent,
+                   GimpSelectCriterion  select_criterion,
+                   gint                 x,
+                   gint                 y)
+{
+  GeglBuffer *src_buffer;
+  GeglBuffer *mask_buffer;
+  const Babl *format;
+  gint        n_components;
+  gboolean    has_alpha;
+  gfloat      start_col[MAX_CHANNELS];
+
+  gimp_pickable_flush (pickable);
+
+  src_buffer = gimp_pickable_get_buffer (pickable);
+
+  format = reference_choose_format (src_buffer, select_criterion,
+                                    &n_components, &has_alpha);
+
+  gegl_buffer_sample (src_buffer, x, y, NULL, start_col, format,
+                      GEGL_SAMPLER_NEAREST, GEGL_ABYSS_NONE);
+
+  if (! has_alpha || start_col[n_components - 1] > 0)
+    select_transparent = FALSE;
+
+  mask_buffer = gegl_buffer_new (gegl_buffer_get_extent (src_buffer),
+                                 babl_format ("Y float"));
+
+  reference_find_contiguous_region (src_buffer, mask_buffer,
+                                    format, n_components, has_alpha,
+                                    select_transparent, select_criterion,
+                                    antialias, threshold,
+                                    x, y, start_col);
+
+  return mask_buffer;
+}
+
+static GeglBuffer *
+reference_by_color (GimpPickable        *pickable,
+                    gboolean             antialias,
+                    gfloat               threshold,
+                    gboolean             select_transparent,
+                    GimpSelectCriterion  select_criterion,
+                    const GimpRGB       *color)
+{
+  GeglBufferIterator *iter;
+  GeglBuffer         *src_buffer;
+  GeglBuffer         *mask_buffer;
+  const Babl         *format;
+  gint                n_components;
+  gboolean            has_alpha;
+  gfloat              start_col[MAX_CHANNELS];
+
+  gimp_pickable_flush (pickable);
+
+  src_buffer = gimp_pickable_get_buffer (pickable);
+
+  format = reference_choose_format (src_buffer, select_criterion,
+                                    &n_components, &has_alpha);
+
+  gimp_rgba_get_pixel (color, format, start_col);
+
+  if (! has_alpha || start_col[n_components - 1] > 0.0)
+    select_transparent = FALSE;
+
+  mask_buffer = gegl_buffer_new (gegl_buffer_get_extent (src_buffer),
+                                 babl_format ("Y float"));
+
+  iter = gegl_buffer_iterator_new (src_buffer,
+                                   NULL, 0, format,
+                                   GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
+
+  gegl_buffer_iterator_add (iter, mask_buffer,
+                            NULL, 0, babl_format ("Y float"),
+                            GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
+
+  while (gegl_buffer_iterator_next (iter))
+    {
+      const gfloat *src   = iter->data[0];
+      gfloat       *dest  = iter->data[1];
+      gint          count = iter->length;
+
+      while (count--)
+        {
+          *dest = reference_pixel_difference (start_col, src,
+                                              antialias, threshold,
+                                              n_components, has_alpha,
+                                              select_transparent,
+                                              select_criterion);
+
+          src  += n_components;
+          dest += 1;
+        }
+    }
+
+  return mask_buffer;
+}
+
+
+/*  fixtures  */
+
+/*  Paints bands of similar colors with soft edges, transparent holes
+ *  and a few one-pixel gaps, so that fills have to wind around and
+ *  antialiasing has something to do.
+ */
+static GimpLayer *
+create_test_layer (Gimp *gimp)
+{
+  GimpImage  *image;
+  GimpLayer  *layer;
+  GeglBuffer *buffer;
+  guchar     *pixels;
+  gint        x, y;
+
+  image = gimp_image_new (gimp, TEST_WIDTH, TEST_HEIGHT,
+                          GIMP_RGB, GIMP_PRECISION_U8_GAMMA);
+
+  layer = gimp_layer_new (image, TEST_WIDTH, TEST_HEIGHT,
+                          babl_format ("R'G'B'A u8"),
+                          "Test Layer",
+                          1.0,
+                          GIMP_NORMAL_MODE);
+
+  gimp_image_add_layer (image, layer, NULL, 0, FALSE);
+
+  pixels = g_new (guchar, TEST_WIDTH * TEST_HEIGHT * 4);
+
+  for (y = 0; y < TEST_HEIGHT; y++)
+    for (x = 0; x < TEST_WIDTH; x++)
+      {
+        guchar *p    = pixels + (y * TEST_WIDTH + x) * 4;
+        gint    band = ((x + 2 * y) / 23) % 3;
+        gint    ramp = (x * 7 + y * 3) % 40;
+
+        p[0] = band == 0 ? 200 + ramp / 2 : 30 + ramp;
+        p[1] = band == 1 ? 180 + ramp     : 60;
+        p[2] = band == 2 ? 90  + ramp     : 20 + ramp / 4;
+        p[3] = ((x / 11 + y / 13) % 5 == 0) ? 0 : 255;
+
+        if (x % 37 == 5 || (y % 29 == 3 && x > TEST_WIDTH / 2))
+          p[0] = p[1] = p[2] = 255 - p[0];
+      }
+
+  buffer = gimp_drawable_get_buffer (GIMP_DRAWABLE (layer));
+
+  gegl_buffer_set (buffer, GEGL_RECTANGLE (0, 0, TEST_WIDTH, TEST_HEIGHT), 0,
+                   babl_format ("R'G'B'A u8"), pixels, GEGL_AUTO_ROWSTRIDE);
+
+  g_free (pixels);
+
+  return layer;
+}
+
+static void
+assert_masks_equal (GeglBuffer *mask,
+                    GeglBuffer *expected)
+{
+  gfloat *a = g_new (gfloat, TEST_WIDTH * TEST_HEIGHT);
+  gfloat *b = g_new (gfloat, TEST_WIDTH * TEST_HEIGHT);
+  gint    i;
+
+  gegl_buffer_get (mask, GEGL_RECTANGLE (0, 0, TEST_WIDTH, TEST_HEIGHT), 1.0,
+                   babl_format ("Y float"), a,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+  gegl_buffer_get (expected, GEGL_RECTANGLE (0, 0, TEST_WIDTH, TEST_HEIGHT), 1.0,
+                   babl_format ("Y float"), b,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  for (i = 0; i < TEST_WIDTH * TEST_HEIGHT; i++)
+    g_assert_cmpfloat (a[i], ==, b[i]);
+
+  g_free (a);
+  g_free (b);
+}
+
+
+/*  tests  */
+
+static const GimpSelectCriterion criteria[] =
+{
+  GIMP_SELECT_CRITERION_COMPOSITE,
+  GIMP_SELECT_CRITERION_R,
+  GIMP_SELECT_CRITERION_H,
+  GIMP_SELECT_CRITERION_V
+};
+
+static const gfloat thresholds[] = { 0.0, 15.0 / 255.0, 60.0 / 255.0 };
+
+/**
+ * by_seed_matches_reference:
+ * @data:
+ *
+ * Fill from seeds in the middle, at the edges and on transparent
+ * pixels, with and without antialiasing, and compare the masks to
+ * the ones of the old per-pixel fill.
+ **/
+static void
+by_seed_matches_reference (gconstpointer data)
+{
+  static const gint seeds[][2] =
+  {
+    { 0,              0               },
+    { TEST_WIDTH - 1, TEST_HEIGHT - 1 },
+    { 0,              TEST_HEIGHT / 2 },
+    { TEST_WIDTH / 2, TEST_HEIGHT / 3 },
+    { 70,             64              },
+    { 3,              20              }
+  };
+
+  Gimp      *gimp  = GIMP (data);
+  GimpLayer *layer = create_test_layer (gimp);
+  gint       c, t, s, aa, tr;
+
+  for (c = 0; c < G_N_ELEMENTS (criteria); c++)
+    for (t = 0; t < G_N_ELEMENTS (thresholds); t++)
+      for (s = 0; s < G_N_ELEMENTS (seeds); s++)
+        for (aa = 0; aa < 2; aa++)
+          for (tr = 0; tr < 2; tr++)
+            {
+              GeglBuffer *mask;
+              GeglBuffer *expected;
+
+              mask = gimp_pickable_contiguous_region_by_seed (GIMP_PICKABLE (layer),
+                                                              aa, thresholds[t],
+                                                              tr, criteria[c],
+                                                              seeds[s][0],
+                                                              seeds[s][1]);
+              expected = reference_by_seed (GIMP_PICKABLE (layer),
+                                            aa, thresholds[t],
+                                            tr, criteria[c],
+                                            seeds[s][0], seeds[s][1]);
+
+              assert_masks_equal (mask, expected);
+
+              g_object_unref (mask);
+              g_object_unref (expected);
+            }
+
+  g_object_unref (gimp_item_get_image (GIMP_ITEM (layer)));
+}
+
+/**
+ * by_color_matches_reference:
+ * @data:
+ *
+ * Select by color, now split over threads, and compare the masks to
+ * the ones of the old single iterator.
+ **/
+static void
+by_color_matches_reference (gconstpointer data)
+{
+  Gimp      *gimp  = GIMP (data);
+  GimpLayer *layer = create_test_layer (gimp);
+  GimpRGB    colors[2];
+  gint       c, t, i, aa;
+
+  gimp_rgba_set_uchar (&colors[0], 230, 60, 25, 255);
+  gimp_rgba_set_uchar (&colors[1], 50, 200, 110, 255);
+
+  for (c = 0; c < G_N_ELEMENTS (criteria); c++)
+    for (t = 0; t < G_N_ELEMENTS (thresholds); t++)
+      for (i = 0; i < G_N_ELEMENTS (colors); i++)
+        for (aa = 0; aa < 2; aa++)
+          {
+            GeglBuffer *mask;
+            GeglBuffer *expected;
+
+            mask = gimp_pickable_contiguous_region_by_color (GIMP_PICKABLE (layer),
+                                                             aa, thresholds[t],
+                                                             FALSE, criteria[c],
+                                                             &colors[i]);
+            expected = reference_by_color (GIMP_PICKABLE (layer),
+                                           aa, thresholds[t],
+                                           FALSE, criteria[c],
+                                           &colors[i]);
+
+            assert_masks_equal (mask, expected);
+
+            g_object_unref (mask);
+            g_object_unref (expected);
+          }
+
+  g_object_unref (gimp_item_get_image (GIMP_ITEM (layer)));
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  Gimp *gimp;
+  int   result;
+
+  g_test_init (&argc, &argv, NULL);
+
+  gimp_test_utils_set_gimp2_directory ("GIMP_TESTING_ABS_TOP_SRCDIR",
+                                       "app/tests/gimpdir");
+
+  /* We share the same application instance across all tests */
+  gimp = gimp_init_for_testing ();
+
+  /* Add tests */
+  ADD_TEST (by_seed_matches_reference);
+  ADD_TEST (by_color_matches_reference);
+
+  /* Run the tests */
+  result = g_test_run ();
+
+  /* Don't write files to the source dir */
+  gimp_test_utils_set_gimp2_directory ("GIMP_TESTING_ABS_TOP_BUILDDIR",
+                                       "app/tests/gimpdir-output");
+
+  /* Exit so we don't break script-fu plug-in wire */
+  gimp_exit (gimp, TRUE);
+
+  return result;
+}
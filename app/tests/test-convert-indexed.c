@@ -0,0 +1,370 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include <gegl.h>
+#include <gtk/gtk.h>
+
+#include "widgets/widgets-types.h"
+
+#include "core/gimp.h"
+#include "core/gimpimage.h"
+#include "core/gimpimage-colormap.h"
+#include "core/gimpimage-convert-type.h"
+#include "core/gimplayer.h"
+
+#include "tests.h"
+
+#include "gimp-app-test-utils.h"
+
+
+/*  large enough for the histogram to be counted in several bands  */
+#define TEST_WIDTH     263
+#define TEST_HEIGHT    257
+#define TOP_WIDTH      61
+#define TOP_HEIGHT     47
+#define TOP_OFFSET_X   13
+#define TOP_OFFSET_Y   29
+
+#define ADD_TEST(function) \
+  g_test_add_data_func ("/gimp-convert-indexed/" #function, gimp, function);
+
+
+typedef struct
+{
+  guchar  colormap[256 * 3];
+  gint    n_colors;
+  guchar *bottom;  /*  indices                     */
+  guchar *top;     /*  indices and alpha, per pixel */
+} IndexedResult;
+
+
+/*  fixtures  */
+
+/*  An RGB background and a smaller, offset RGBA layer on top, both
+ *  painted with colors picked from @n_colors random ones, and random
+ *  alpha on the top layer.
+ */
+static GimpImage *
+create_test_image (Gimp    *gimp,
+                   guint32  seed,
+                   gint     n_colors)
+{
+  GRand     *rand    = g_rand_new_with_seed (seed);
+  guchar    *palette = g_new (guchar, n_colors * 3);
+  guchar    *bottom  = g_new (guchar, TEST_WIDTH * TEST_HEIGHT * 3);
+  guchar    *top     = g_new (guchar, TOP_WIDTH * TOP_HEIGHT * 4);
+  GimpImage *image;
+  GimpLayer *layer;
+  gint       i;
+
+  for (i = 0; i < n_colors * 3; i++)
+    palette[i] = g_rand_int_range (rand, 0, 256);
+
+  for (i = 0; i < TEST_WIDTH * TEST_HEIGHT; i++)
+    memcpy (bottom + i * 3,
+            palette + g_rand_int_range (rand, 0, n_colors) * 3, 3);
+
+  for (i = 0; i < TOP_WIDTH * TOP_HEIGHT; i++)
+    {
+      memcpy (top + i * 4,
+              palette + g_rand_int_range (rand, 0, n_colors) * 3, 3);
+      top[i * 4 + 3] = g_rand_int_range (rand, 0, 256);
+    }
+
+  image = gimp_image_new (gimp, TEST_WIDTH, TEST_HEIGHT,
+                          GIMP_RGB, GIMP_PRECISION_U8_GAMMA);
+
+  layer = gimp_layer_new (image, TEST_WIDTH, TEST_HEIGHT,
+                          babl_format ("R'G'B' u8"),
+                          "Bottom", 1.0, GIMP_NORMAL_MODE);
+  gegl_buffer_set (gimp_drawable_get_buffer (GIMP_DRAWABLE (layer)),
+                   GEGL_RECTANGLE (0, 0, TEST_WIDTH, TEST_HEIGHT), 0,
+                   babl_format ("R'G'B' u8"), bottom, GEGL_AUTO_ROWSTRIDE);
+  gimp_image_add_layer (image, layer, GIMP_IMAGE_ACTIVE_PARENT, 0, FALSE);
+
+  layer = gimp_layer_new (image, TOP_WIDTH, TOP_HEIGHT,
+                          babl_format ("R'G'B'A u8"),
+                          "Top", 1.0, GIMP_NORMAL_MODE);
+  gegl_buffer_set (gimp_drawable_get_buffer (GIMP_DRAWABLE (layer)),
+                   GEGL_RECTANGLE (0, 0, TOP_WIDTH, TOP_HEIGHT), 0,
+                   babl_format ("R'G'B'A u8"), top, GEGL_AUTO_ROWSTRIDE);
+  gimp_item_set_offset (GIMP_ITEM (layer), TOP_OFFSET_X, TOP_OFFSET_Y);
+  gimp_image_add_layer (image, layer, GIMP_IMAGE_ACTIVE_PARENT, 0, FALSE);
+
+  g_rand_free (rand);
+  g_free (palette);
+  g_free (bottom);
+  g_free (top);
+
+  return image;
+}
+
+static guchar *
+get_pixels (GimpLayer *layer)
+{
+  GimpDrawable *drawable = GIMP_DRAWABLE (layer);
+  const Babl   *format   = gimp_drawable_get_format (drawable);
+  gint          width    = gimp_item_get_width  (GIMP_ITEM (layer));
+  gint          height   = gimp_item_get_height (GIMP_ITEM (layer));
+  guchar       *pixels;
+
+  pixels = g_new (guchar,
+                  width * height * babl_format_get_bytes_per_pixel (format));
+
+  gegl_buffer_get (gimp_drawable_get_buffer (drawable),
+                   GEGL_RECTANGLE (0, 0, width, height), 1.0,
+                   format, pixels,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  return pixels;
+}
+
+/*  converts the test image to indexed on @n_threads threads  */
+static IndexedResult *
+convert_test_image (Gimp                  *gimp,
+                    guint32                seed,
+                    gint                   n_colors,
+                    gint                   n_threads,
+                    GimpConvertDitherType  dither,
+                    gboolean               alpha_dither,
+                    GimpConvertPaletteType palette_type)
+{
+  IndexedResult *result = g_new0 (IndexedResult, 1);
+  GimpImage     *image;
+  GList         *layers;
+
+  g_object_set (gimp->config,
+                "num-processors", n_threads,
+                NULL);
+
+  image = create_test_image (gimp, seed, n_colors);
+
+  g_assert (gimp_image_convert_type (image, GIMP_INDEXED,
+                                     256, dither, alpha_dither, FALSE,
+                                     FALSE, palette_type, NULL,
+                                     NULL, NULL));
+
+  result->n_colors = gimp_image_get_colormap_size (image);
+  memcpy (result->colormap, gimp_image_get_colormap (image),
+          result->n_colors * 3);
+
+  layers = gimp_image_get_layer_iter (image);
+
+  result->top    = get_pixels (layers->data);
+  result->bottom = get_pixels (layers->next->data);
+
+  g_object_unref (image);
+
+  return result;
+}
+
+static void
+indexed_result_free (IndexedResult *result)
+{
+  g_free (result->bottom);
+  g_free (result->top);
+  g_free (result);
+}
+
+static void
+assert_results_equal (const IndexedResult *result,
+                      const IndexedResult *expected)
+{
+  g_assert_cmpint (result->n_colors, ==, expected->n_colors);
+
+  g_assert (memcmp (result->colormap, expected->colormap,
+                    expected->n_colors * 3) == 0);
+  g_assert (memcmp (result->bottom, expected->bottom,
+                    TEST_WIDTH * TEST_HEIGHT) == 0);
+  g_assert (memcmp (result->top, expected->top,
+                    TOP_WIDTH * TOP_HEIGHT * 2) == 0);
+}
+
+/*  a single thread counts the histogram in one band and remaps the
+ *  layers in one pass, in the order the serial code did
+ */
+static void
+check_serial_and_parallel (Gimp                  *gimp,
+                           GimpConvertDitherType  dither,
+                           gboolean               alpha_dither)
+{
+  guint32 seed;
+
+  for (seed = 1; seed <= 2; seed++)
+    {
+      IndexedResult *expected;
+      IndexedResult *result;
+
+      expected = convert_test_image (gimp, seed, 4096, 1,
+                                     dither, alpha_dither,
+                                     GIMP_MAKE_PALETTE);
+      result   = convert_test_image (gimp, seed, 4096, 4,
+                                     dither, alpha_dither,
+                                     GIMP_MAKE_PALETTE);
+
+      assert_results_equal (result, expected);
+
+      indexed_result_free (expected);
+      indexed_result_free (result);
+
+      expected = convert_test_image (gimp, seed, 4096, 1,
+                                     dither, alpha_dither,
+                                     GIMP_WEB_PALETTE);
+      result   = convert_test_image (gimp, seed, 4096, 4,
+                                     dither, alpha_dither,
+                                     GIMP_WEB_PALETTE);
+
+      assert_results_equal (result, expected);
+
+      indexed_result_free (expected);
+      indexed_result_free (result);
+    }
+}
+
+
+/*  tests  */
+
+/**
+ * exact_colors_are_kept:
+ * @data:
+ *
+ * An image with fewer colors than asked for must keep them all, and
+ * every pixel must keep its own color, like before.
+ **/
+static void
+exact_colors_are_kept (gconstpointer data)
+{
+  Gimp    *gimp = GIMP (data);
+  guint32  seed;
+
+  for (seed = 1; seed <= 2; seed++)
+    {
+      GimpImage     *image;
+      guchar        *bottom;
+      guchar        *top;
+      IndexedResult *result;
+      gint           i;
+
+      image = create_test_image (gimp, seed, 200);
+      bottom = get_pixels (gimp_image_get_layer_iter (image)->next->data);
+      top    = get_pixels (gimp_image_get_layer_iter (image)->data);
+      g_object_unref (image);
+
+      result = convert_test_image (gimp, seed, 200, 4,
+                                   GIMP_FS_DITHER, FALSE,
+                                   GIMP_MAKE_PALETTE);
+
+      g_assert_cmpint (result->n_colors, <=, 200);
+
+      for (i = 0; i < TEST_WIDTH * TEST_HEIGHT; i++)
+        {
+          g_assert_cmpint (result->bottom[i], <, result->n_colors);
+          g_assert (memcmp (result->colormap + result->bottom[i] * 3,
+                            bottom + i * 3, 3) == 0);
+        }
+
+      for (i = 0; i < TOP_WIDTH * TOP_HEIGHT; i++)
+        {
+          if (top[i * 4 + 3] <= 127)
+            continue;
+
+          g_assert_cmpint (result->top[i * 2], <, result->n_colors);
+          g_assert (memcmp (result->colormap + result->top[i * 2] * 3,
+                            top + i * 4, 3) == 0);
+        }
+
+      g_free (bottom);
+      g_free (top);
+      indexed_result_free (result);
+    }
+}
+
+/**
+ * no_dither_is_unchanged:
+ * @data:
+ *
+ * Quantizing without dithering must come out the same when the
+ * histogram and remap are split over threads.
+ **/
+static void
+no_dither_is_unchanged (gconstpointer data)
+{
+  check_serial_and_parallel (GIMP (data), GIMP_NO_DITHER, FALSE);
+}
+
+/**
+ * fixed_dither_is_unchanged:
+ * @data:
+ *
+ * Positioned dithering must come out the same when the histogram and
+ * remap are split over threads.
+ **/
+static void
+fixed_dither_is_unchanged (gconstpointer data)
+{
+  check_serial_and_parallel (GIMP (data), GIMP_FIXED_DITHER, FALSE);
+}
+
+/**
+ * alpha_dither_is_unchanged:
+ * @data:
+ *
+ * Alpha dithering depends on the position of each pixel in the image,
+ * it must come out the same in every band.
+ **/
+static void
+alpha_dither_is_unchanged (gconstpointer data)
+{
+  check_serial_and_parallel (GIMP (data), GIMP_NO_DITHER, TRUE);
+  check_serial_and_parallel (GIMP (data), GIMP_FIXED_DITHER, TRUE);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  Gimp *gimp;
+  int   result;
+
+  g_test_init (&argc, &argv, NULL);
+
+  gimp_test_utils_set_gimp2_directory ("GIMP_TESTING_ABS_TOP_SRCDIR",
+                                       "app/tests/gimpdir");
+
+  /* We share the same application instance across all tests */
+  gimp = gimp_init_for_testing ();
+
+  /* Add tests */
+  ADD_TEST (exact_colors_are_kept);
+  ADD_TEST (no_dither_is_unchanged);
+  ADD_TEST (fixed_dither_is_unchanged);
+  ADD_TEST (alpha_dither_is_unchanged);
+
+  /* Run the tests */
+  result = g_test_run ();
+
+  /* Don't write files to the source dir */
+  gimp_test_utils_set_gimp2_directory ("GIMP_TESTING_ABS_TOP_BUILDDIR",
+                                       "app/tests/gimpdir-output");
+
+  /* Exit so we don't break script-fu plug-in wire */
+  gimp_exit (gimp, TRUE);
+
+  return result;
+}
@@ -0,0 +1,669 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include <gegl.h>
+#include <gtk/gtk.h>
+
+#include "libgimpmath/gimpmath.h"
+
+#include "widgets/widgets-types.h"
+
+#include "gegl/gimp-gegl-apply-operation.h"
+
+#include "core/gimp.h"
+
+#include "tests.h"
+
+#include "gimp-app-test-utils.h"
+
+
+/*  wide and high enough for several threads in both passes  */
+#define TEST_WIDTH  157
+#define TEST_HEIGHT 133
+
+#define ADD_TEST(function) \
+  g_test_add_data_func ("/gimp-grow-shrink/" #function, gimp, function);
+
+
+/*  gimp:grow and gimp:shrink as they were before binary masks got a
+ *  path of their own, reading from and writing to arrays instead of
+ *  buffers, kept here to check that the results did not change.
+ *
+ *  The old shrink code indexed its column cache with radius_x where
+ *  it meant radius_y, so it is only used with equal radii.
+ */
+
+static void
+reference_compute_border (gint16  *circ,
+                          guint16  xradius,
+                          guint16  yradius)
+{
+  gint32  i;
+  gint32  diameter = xradius * 2 + 1;
+  gdouble tmp;
+
+  for (i = 0; i < diameter; i++)
+    {
+      if (i > xradius)
+        tmp = (i - xradius) - 0.5;
+      else if (i < xradius)
+        tmp = (xradius - i) - 0.5;
+      else
+        tmp = 0.0;
+
+      circ[i] = RINT (yradius /
+                      (gdouble) xradius * sqrt (SQR (xradius) - SQR (tmp)));
+    }
+}
+
+static inline void
+reference_rotate_pointers (gfloat  **p,
+                           guint32   n)
+{
+  guint32  i;
+  gfloat  *tmp;
+
+  tmp = p[0];
+
+  for (i = 0; i < n - 1; i++)
+    p[i] = p[i + 1];
+
+  p[i] = tmp;
+}
+
+static void
+reference_grow (const gfloat *src,
+                gfloat       *dest,
+                gint          width,
+                gint          height,
+                gint          radius_x,
+                gint          radius_y)
+{
+  gint32   i, j, x, y;
+  gfloat **buf;
+  gfloat  *out;
+  gfloat **max;
+  gint16  *circ;
+  gfloat   last_max;
+  gint16   last_index;
+  gfloat  *buffer;
+
+  max = g_new (gfloat *, width + 2 * radius_x);
+  buf = g_new (gfloat *, radius_y + 1);
+
+  for (i = 0; i < radius_y + 1; i++)
+    buf[i] = g_new (gfloat, width);
+
+  buffer = g_new (gfloat, (width + 2 * radius_x) * (radius_y + 1));
+
+  for (i = 0; i < width + 2 * radius_x; i++)
+    {
+      if (i < radius_x)
+        max[i] = buffer;
+      else if (i < width + radius_x)
+        max[i] = &buffer[(radius_y + 1) * (i - radius_x)];
+      else
+        max[i] = &buffer[(radius_y + 1) * (width + radius_x - 1)];
+
+      for (j = 0; j < radius_x + 1; j++)
+        max[i][j] = 0.0;
+    }
+
+  max += radius_x;
+
+  out = g_new (gfloat, width);
+
+  circ = g_new (gint16, 2 * radius_x + 1);
+  reference_compute_border (circ, radius_x, radius_y);
+
+  circ += radius_x;
+
+  memset (buf[0], 0, width * sizeof (gfloat));
+
+  for (i = 0; i < radius_y && i < height; i++)
+    memcpy (buf[i + 1], src + i * width, width * sizeof (gfloat));
+
+  for (x = 0; x < width; x++)
+    {
+      max[x][0] = 0.0;
+      max[x][1] = buf[1][x];
+
+      for (j = 2; j < radius_y + 1; j++)
+        max[x][j] = MAX (buf[j][x], max[x][j - 1]);
+    }
+
+  for (y = 0; y < height; y++)
+    {
+      reference_rotate_pointers (buf, radius_y + 1);
+
+      if (y < height - radius_y)
+        memcpy (buf[radius_y], src + (y + radius_y) * width,
+                width * sizeof (gfloat));
+      else
+        memset (buf[radius_y], 0, width * sizeof (gfloat));
+
+      for (x = 0; x < width; x++)
+        {
+          for (i = radius_y; i > 0; i--)
+            max[x][i] = MAX (MAX (max[x][i - 1], buf[i - 1][x]), buf[i][x]);
+
+          max[x][0] = buf[0][x];
+        }
+
+      last_max = max[0][circ[-1]];
+      last_index = 1;
+
+      for (x = 0; x < width; x++)
+        {
+          last_index--;
+
+          if (last_index >= 0)
+            {
+              if (last_max >= 1.0)
+                {
+                  out[x] = 1.0;
+                }
+              else
+                {
+                  last_max = 0.0;
+
+                  for (i = radius_x; i >= 0; i--)
+                    if (last_max < max[x + i][circ[i]])
+                      {
+                        last_max = max[x + i][circ[i]];
+                        last_index = i;
+                      }
+
+                  out[x] = last_max;
+                }
+            }
+          else
+            {
+              last_index = radius_x;
+              last_max = max[x + radius_x][circ[radius_x]];
+
+              for (i = radius_x - 1; i >= -radius_x; i--)
+                if (last_max < max[x + i][circ[i]])
+                  {
+                    last_max = max[x + i][circ[i]];
+                    last_index = i;
+                  }
+
+              out[x] = last_max;
+            }
+        }
+
+      memcpy (dest + y * width, out, width * sizeof (gfloat));
+    }
+
+  circ -= radius_x;
+  max -= radius_x;
+
+  g_free (circ);
+  g_free (buffer);
+  g_free (max);
+
+  for (i = 0; i < radius_y + 1; i++)
+    g_free (buf[i]);
+
+  g_free (buf);
+  g_free (out);
+}
+
+static void
+reference_shrink (const gfloat *src,
+                  gfloat       *dest,
+                  gint          width,
+                  gint          height,
+                  gint          radius_x,
+                  gint          radius_y,
+                  gboolean      edge_lock)
+{
+  gint32   i, j, x, y;
+  gfloat **buf;
+  gfloat  *out;
+  gfloat **max;
+  gint16  *circ;
+  gfloat   last_max;
+  gint16   last_index;
+  gfloat  *buffer;
+  gint     buffer_size;
+
+  max = g_new (gfloat *, width + 2 * radius_x);
+  buf = g_new (gfloat *, radius_y + 1);
+
+  for (i = 0; i < radius_y + 1; i++)
+    buf[i] = g_new (gfloat, width);
+
+  buffer_size = (width + 2 * radius_x + 1) * (radius_y + 1);
+  buffer = g_new (gfloat, buffer_size);
+
+  if (edge_lock)
+    {
+      for (i = 0; i < buffer_size; i++)
+        buffer[i] = 1.0;
+    }
+  else
+    {
+      memset (buffer, 0, buffer_size * sizeof (gfloat));
+    }
+
+  for (i = 0; i < width + 2 * radius_x; i++)
+    {
+      if (i < radius_x)
+        {
+          if (edge_lock)
+            max[i] = buffer;
+          else
+            max[i] = &buffer[(radius_x + 1) * (width + radius_x)];
+        }
+      else if (i < width + radius_x)
+        {
+          max[i] = &buffer[(radius_y + 1) * (i - radius_x)];
+        }
+      else
+        {
+          if (edge_lock)
+            max[i] = &buffer[(radius_x + 1) * (width + radius_x - 1)];
+          else
+            max[i] = &buffer[(radius_x + 1) * (width + radius_x)];
+        }
+    }
+
+  if (! edge_lock)
+    for (j = 0 ; j < radius_x + 1; j++)
+      max[0][j] = 0.0;
+
+  max += radius_x;
+
+  out = g_new (gfloat, width);
+
+  circ = g_new (gint16, 2 * radius_x + 1);
+  reference_compute_border (circ, radius_x, radius_y);
+
+  circ += radius_x;
+
+  for (i = 0; i < radius_y && i < height; i++)
+    memcpy (buf[i + 1], src + i * width, width * sizeof (gfloat));
+
+  if (edge_lock)
+    memcpy (buf[0], buf[1], width * sizeof (gfloat));
+  else
+    memset (buf[0], 0, width * sizeof (gfloat));
+
+  for (x = 0; x < width; x++)
+    {
+      max[x][0] = buf[0][x];
+
+      for (j = 1; j < radius_y + 1; j++)
+        max[x][j] = MIN (buf[j][x], max[x][j - 1]);
+    }
+
+  for (y = 0; y < height; y++)
+    {
+      reference_rotate_pointers (buf, radius_y + 1);
+
+      if (y < height - radius_y)
+        memcpy (buf[radius_y], src + (y + radius_y) * width,
+                width * sizeof (gfloat));
+      else if (edge_lock)
+        memcpy (buf[radius_y], buf[radius_y - 1], width * sizeof (gfloat));
+      else
+        memset (buf[radius_y], 0, width * sizeof (gfloat));
+
+      for (x = 0 ; x < width; x++)
+        {
+          for (i = radius_y; i > 0; i--)
+            max[x][i] = MIN (MIN (max[x][i - 1], buf[i - 1][x]), buf[i][x]);
+
+          max[x][0] = buf[0][x];
+        }
+
+      last_max =  max[0][circ[-1]];
+      last_index = 0;
+
+      for (x = 0 ; x < width; x++)
+        {
+          last_index--;
+
+          if (last_index >= 0)
+            {
+              if (last_max <= 0.0)
+                {
+                  out[x] = 0.0;
+                }
+              else
+                {
+                  last_max = 1.0;
+
+                  for (i = radius_x; i >= 0; i--)
+                    if (last_max > max[x + i][circ[i]])
+                      {
+                        last_max = max[x + i][circ[i]];
+                        last_index = i;
+                      }
+
+                  out[x] = last_max;
+                }
+            }
+          else
+            {
+              last_index = radius_x;
+              last_max = max[x + radius_y][circ[radius_x]];
+
+              for (i = radius_x - 1; i >= -radius_x; i--)
+                if (last_max > max[x + i][circ[i]])
+                  {
+                    last_max = max[x + i][circ[i]];
+                    last_index = i;
+                  }
+
+              out[x] = last_max;
+            }
+        }
+
+      memcpy (dest + y * width, out, width * sizeof (gfloat));
+    }
+
+  circ -= radius_x;
+  max -= radius_x;
+
+  g_free (circ);
+  g_free (buffer);
+  g_free (max);
+
+  for (i = 0; i < radius_y + 1; i++)
+    g_free (buf[i]);
+
+  g_free (buf);
+  g_free (out);
+}
+
+
+/*  fixtures  */
+
+/*  Random rectangles and discs, some of them holes, and single
+ *  pixels, touching the edges too.  If @binary is FALSE, the shapes
+ *  get values between 0.0 and 1.0.
+ */
+static gfloat *
+create_test_mask (guint32  seed,
+                  gboolean binary)
+{
+  GRand  *rand   = g_rand_new_with_seed (seed);
+  gfloat *pixels = g_new0 (gfloat, TEST_WIDTH * TEST_HEIGHT);
+  gint    i;
+
+  for (i = 0; i < 30; i++)
+    {
+      gint   cx    = g_rand_int_range (rand, -10, TEST_WIDTH  + 10);
+      gint   cy    = g_rand_int_range (rand, -10, TEST_HEIGHT + 10);
+      gint   r     = g_rand_int_range (rand, 1, 30);
+      gint   disc  = g_rand_boolean (rand);
+      gfloat value = (i % 4 == 3) ? 0.0 : 1.0;
+      gint   x, y;
+
+      if (! binary && value > 0.0)
+        value = g_rand_double_range (rand, 0.1, 1.0);
+
+      for (y = MAX (cy - r, 0); y < MIN (cy + r, TEST_HEIGHT); y++)
+        for (x = MAX (cx - r, 0); x < MIN (cx + r, TEST_WIDTH); x++)
+          {
+            if (! disc || (x - cx) * (x - cx) + (y - cy) * (y - cy) < r * r)
+              pixels[y * TEST_WIDTH + x] = value;
+          }
+    }
+
+  for (i = 0; i < 100; i++)
+    {
+      gint x = g_rand_int_range (rand, 0, TEST_WIDTH);
+      gint y = g_rand_int_range (rand, 0, TEST_HEIGHT);
+
+      pixels[y * TEST_WIDTH + x] = binary ? g_rand_boolean (rand) :
+                                            g_rand_double (rand);
+    }
+
+  g_rand_free (rand);
+
+  return pixels;
+}
+
+static gfloat *
+apply_operation (const gfloat *pixels,
+                 GeglNode     *node)
+{
+  GeglBuffer *src_buffer;
+  GeglBuffer *dest_buffer;
+  gfloat     *result;
+
+  src_buffer  = gegl_buffer_new (GEGL_RECTANGLE (0, 0, TEST_WIDTH, TEST_HEIGHT),
+                                 babl_format ("Y float"));
+  dest_buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0, TEST_WIDTH, TEST_HEIGHT),
+                                 babl_format ("Y float"));
+
+  gegl_buffer_set (src_buffer, GEGL_RECTANGLE (0, 0, TEST_WIDTH, TEST_HEIGHT), 0,
+                   babl_format ("Y float"), pixels, GEGL_AUTO_ROWSTRIDE);
+
+  gimp_gegl_apply_operation (src_buffer, NULL, NULL,
+                             node,
+                             dest_buffer, NULL);
+
+  result = g_new (gfloat, TEST_WIDTH * TEST_HEIGHT);
+
+  gegl_buffer_get (dest_buffer,
+                   GEGL_RECTANGLE (0, 0, TEST_WIDTH, TEST_HEIGHT), 1.0,
+                   babl_format ("Y float"), result,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  g_object_unref (src_buffer);
+  g_object_unref (dest_buffer);
+
+  return result;
+}
+
+static void
+check_grow (const gfloat *pixels,
+            gint          radius_x,
+            gint          radius_y)
+{
+  GeglNode *node;
+  gfloat   *result;
+  gfloat   *expected;
+  gint      i;
+
+  node = gegl_node_new_child (NULL,
+                              "operation", "gimp:grow",
+                              "radius-x",  radius_x,
+                              "radius-y",  radius_y,
+                              NULL);
+
+  result   = apply_operation (pixels, node);
+  expected = g_new (gfloat, TEST_WIDTH * TEST_HEIGHT);
+
+  reference_grow (pixels, expected, TEST_WIDTH, TEST_HEIGHT,
+                  radius_x, radius_y);
+
+  for (i = 0; i < TEST_WIDTH * TEST_HEIGHT; i++)
+    g_assert_cmpfloat (result[i], ==, expected[i]);
+
+  g_object_unref (node);
+  g_free (result);
+  g_free (expected);
+}
+
+static void
+check_shrink (const gfloat *pixels,
+              gint          radius,
+              gboolean      edge_lock)
+{
+  GeglNode *node;
+  gfloat   *result;
+  gfloat   *expected;
+  gint      i;
+
+  node = gegl_node_new_child (NULL,
+                              "operation", "gimp:shrink",
+                              "radius-x",  radius,
+                              "radius-y",  radius,
+                              "edge-lock", edge_lock,
+                              NULL);
+
+  result   = apply_operation (pixels, node);
+  expected = g_new (gfloat, TEST_WIDTH * TEST_HEIGHT);
+
+  reference_shrink (pixels, expected, TEST_WIDTH, TEST_HEIGHT,
+                    radius, radius, edge_lock);
+
+  for (i = 0; i < TEST_WIDTH * TEST_HEIGHT; i++)
+    g_assert_cmpfloat (result[i], ==, expected[i]);
+
+  g_object_unref (node);
+  g_free (result);
+  g_free (expected);
+}
+
+
+/*  tests  */
+
+static const gint grow_radii[][2] =
+{
+  { 1,  1  },
+  { 3,  3  },
+  { 20, 20 },
+  { 5,  2  },
+  { 2,  9  },
+  { 1,  12 },
+  { 40, 40 }
+};
+
+static const gint shrink_radii[] = { 1, 3, 7, 20, 40 };
+
+/**
+ * grow_binary_matches_reference:
+ * @data:
+ *
+ * Grow binary masks, which takes the new path whose cost doesn't
+ * depend on the radius, and compare to the old code.
+ **/
+static void
+grow_binary_matches_reference (gconstpointer data)
+{
+  guint32 seed;
+  gint    r;
+
+  for (seed = 1; seed <= 3; seed++)
+    {
+      gfloat *pixels = create_test_mask (seed, TRUE);
+
+      for (r = 0; r < G_N_ELEMENTS (grow_radii); r++)
+        check_grow (pixels, grow_radii[r][0], grow_radii[r][1]);
+
+      g_free (pixels);
+    }
+}
+
+/**
+ * shrink_binary_matches_reference:
+ * @data:
+ *
+ * Shrink binary masks, with and without edge lock, and compare to
+ * the old code.
+ **/
+static void
+shrink_binary_matches_reference (gconstpointer data)
+{
+  guint32 seed;
+  gint    r;
+
+  for (seed = 1; seed <= 3; seed++)
+    {
+      gfloat *pixels = create_test_mask (seed, TRUE);
+
+      for (r = 0; r < G_N_ELEMENTS (shrink_radii); r++)
+        {
+          check_shrink (pixels, shrink_radii[r], FALSE);
+          check_shrink (pixels, shrink_radii[r], TRUE);
+        }
+
+      g_free (pixels);
+    }
+}
+
+/**
+ * grayscale_matches_reference:
+ * @data:
+ *
+ * Greyscale masks still take the old path, which now reads its rows
+ * from memory, make sure that didn't change anything either.
+ **/
+static void
+grayscale_matches_reference (gconstpointer data)
+{
+  gfloat *pixels = create_test_mask (1, FALSE);
+  gint    r;
+
+  for (r = 0; r < G_N_ELEMENTS (grow_radii); r++)
+    check_grow (pixels, grow_radii[r][0], grow_radii[r][1]);
+
+  for (r = 0; r < G_N_ELEMENTS (shrink_radii); r++)
+    {
+      check_shrink (pixels, shrink_radii[r], FALSE);
+      check_shrink (pixels, shrink_radii[r], TRUE);
+    }
+
+  g_free (pixels);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  Gimp *gimp;
+  int   result;
+
+  g_test_init (&argc, &argv, NULL);
+
+  gimp_test_utils_set_gimp2_directory ("GIMP_TESTING_ABS_TOP_SRCDIR",
+                                       "app/tests/gimpdir");
+
+  /* We share the same application instance across all tests */
+  gimp = gimp_init_for_testing ();
+
+  /* Make sure the rows and columns are split over threads */
+  g_object_set (gimp->config,
+                "num-processors", 4,
+                NULL);
+
+  /* Add tests */
+  ADD_TEST (grow_binary_matches_reference);
+  ADD_TEST (shrink_binary_matches_reference);
+  ADD_TEST (grayscale_matches_reference);
+
+  /* Run the tests */
+  result = g_test_run ();
+
+  /* Don't write files to the source dir */
+  gimp_test_utils_set_gimp2_directory ("GIMP_TESTING_ABS_TOP_BUILDDIR",
+                                       "app/tests/gimpdir-output");
+
+  /* Exit so we don't break script-fu plug-in wire */
+  gimp_exit (gimp, TRUE);
+
+  return result;
+}
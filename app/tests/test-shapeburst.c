@@ -0,0 +1,278 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include <gegl.h>
+#include <gtk/gtk.h>
+
+#include "libgimpmath/gimpmath.h"
+
+#include "widgets/widgets-types.h"
+
+#include "gegl/gimp-gegl-apply-operation.h"
+
+#include "core/gimp.h"
+
+#include "tests.h"
+
+#include "gimp-app-test-utils.h"
+
+
+/*  wide and high enough for several threads in both passes  */
+#define TEST_WIDTH  193
+#define TEST_HEIGHT 151
+
+#define EPSILON 1e-4
+
+#define ADD_TEST(function) \
+  g_test_add_data_func ("/gimp-shapeburst/" #function, gimp, function);
+
+
+/*  fixtures  */
+
+/*  Random discs and rectangles of different non-zero values, with
+ *  holes punched into them and shapes touching the edges.
+ */
+static gfloat *
+create_test_shape (guint32 seed)
+{
+  GRand  *rand   = g_rand_new_with_seed (seed);
+  gfloat *pixels = g_new0 (gfloat, TEST_WIDTH * TEST_HEIGHT);
+  gint    i;
+
+  for (i = 0; i < 24; i++)
+    {
+      gint   cx    = g_rand_int_range (rand, -20, TEST_WIDTH  + 20);
+      gint   cy    = g_rand_int_range (rand, -20, TEST_HEIGHT + 20);
+      gint   r     = g_rand_int_range (rand, 2, 60);
+      gint   disc  = g_rand_boolean (rand);
+      gfloat value = (i % 5 == 4) ? 0.0 : g_rand_double_range (rand, 0.25, 1.0);
+      gint   x, y;
+
+      for (y = MAX (cy - r, 0); y < MIN (cy + r, TEST_HEIGHT); y++)
+        for (x = MAX (cx - r, 0); x < MIN (cx + r, TEST_WIDTH); x++)
+          {
+            if (! disc || (x - cx) * (x - cx) + (y - cy) * (y - cy) < r * r)
+              pixels[y * TEST_WIDTH + x] = value;
+          }
+    }
+
+  g_rand_free (rand);
+
+  return pixels;
+}
+
+static GeglBuffer *
+create_buffer (const gfloat *pixels)
+{
+  GeglBuffer *buffer;
+
+  buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0, TEST_WIDTH, TEST_HEIGHT),
+                            babl_format ("Y float"));
+
+  gegl_buffer_set (buffer, GEGL_RECTANGLE (0, 0, TEST_WIDTH, TEST_HEIGHT), 0,
+                   babl_format ("Y float"), pixels, GEGL_AUTO_ROWSTRIDE);
+
+  return buffer;
+}
+
+/*  runs @operation on @pixels the way the blend tool's shapeburst
+ *  precalculation does, and returns the result as an array
+ */
+static gfloat *
+apply_operation (const gfloat *pixels,
+                 const gchar  *operation)
+{
+  GeglBuffer *src_buffer;
+  GeglBuffer *dest_buffer;
+  GeglNode   *node;
+  gfloat     *result;
+
+  src_buffer  = create_buffer (pixels);
+  dest_buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0, TEST_WIDTH, TEST_HEIGHT),
+                                 babl_format ("Y float"));
+
+  node = gegl_node_new_child (NULL,
+                              "operation", operation,
+                              "normalize", TRUE,
+                              NULL);
+
+  gimp_gegl_apply_operation (src_buffer, NULL, NULL,
+                             node,
+                             dest_buffer, NULL);
+
+  g_object_unref (node);
+
+  result = g_new (gfloat, TEST_WIDTH * TEST_HEIGHT);
+
+  gegl_buffer_get (dest_buffer,
+                   GEGL_RECTANGLE (0, 0, TEST_WIDTH, TEST_HEIGHT), 1.0,
+                   babl_format ("Y float"), result,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  g_object_unref (src_buffer);
+  g_object_unref (dest_buffer);
+
+  return result;
+}
+
+/*  the euclidean distance of each pixel of the shape to the nearest
+ *  pixel outside of it, where everything beyond the edges is outside,
+ *  by trying all of them, normalized like the operation does
+ */
+static gfloat *
+brute_force_distance (const gfloat *pixels)
+{
+  gfloat *result   = g_new0 (gfloat, TEST_WIDTH * TEST_HEIGHT);
+  gfloat  max_dist = 0.0;
+  gint    x, y, i;
+
+  for (y = 0; y < TEST_HEIGHT; y++)
+    for (x = 0; x < TEST_WIDTH; x++)
+      {
+        gint min_sq;
+        gint u, v;
+
+        if (pixels[y * TEST_WIDTH + x] < EPSILON)
+          continue;
+
+        min_sq = MIN (MIN ((x + 1) * (x + 1),
+                           (TEST_WIDTH - x) * (TEST_WIDTH - x)),
+                      MIN ((y + 1) * (y + 1),
+                           (TEST_HEIGHT - y) * (TEST_HEIGHT - y)));
+
+        for (v = 0; v < TEST_HEIGHT; v++)
+          for (u = 0; u < TEST_WIDTH; u++)
+            {
+              if (pixels[v * TEST_WIDTH + u] < EPSILON)
+                min_sq = MIN (min_sq, (u - x) * (u - x) + (v - y) * (v - y));
+            }
+
+        result[y * TEST_WIDTH + x] = sqrt (min_sq);
+
+        max_dist = MAX (max_dist, result[y * TEST_WIDTH + x]);
+      }
+
+  if (max_dist > 0.0)
+    for (i = 0; i < TEST_WIDTH * TEST_HEIGHT; i++)
+      result[i] /= max_dist;
+
+  return result;
+}
+
+static void
+assert_distances_equal (const gfloat *distances,
+                        const gfloat *expected)
+{
+  gint i;
+
+  for (i = 0; i < TEST_WIDTH * TEST_HEIGHT; i++)
+    g_assert_cmpfloat (fabs (distances[i] - expected[i]), <, EPSILON);
+}
+
+
+/*  tests  */
+
+/**
+ * shapeburst_is_exact:
+ * @data:
+ *
+ * Compare the parallel transform to a brute-force euclidean distance
+ * transform on random shapes.
+ **/
+static void
+shapeburst_is_exact (gconstpointer data)
+{
+  guint32 seed;
+
+  for (seed = 1; seed <= 2; seed++)
+    {
+      gfloat *pixels    = create_test_shape (seed);
+      gfloat *distances = apply_operation (pixels, "gimp:shapeburst");
+      gfloat *expected  = brute_force_distance (pixels);
+
+      assert_distances_equal (distances, expected);
+
+      g_free (pixels);
+      g_free (distances);
+      g_free (expected);
+    }
+}
+
+/**
+ * shapeburst_matches_distance_transform:
+ * @data:
+ *
+ * The blend tool's shapeburst gradients used gegl:distance-transform
+ * before, make sure they come out the same with gimp:shapeburst.
+ **/
+static void
+shapeburst_matches_distance_transform (gconstpointer data)
+{
+  guint32 seed;
+
+  for (seed = 1; seed <= 4; seed++)
+    {
+      gfloat *pixels    = create_test_shape (seed);
+      gfloat *distances = apply_operation (pixels, "gimp:shapeburst");
+      gfloat *expected  = apply_operation (pixels, "gegl:distance-transform");
+
+      assert_distances_equal (distances, expected);
+
+      g_free (pixels);
+      g_free (distances);
+      g_free (expected);
+    }
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  Gimp *gimp;
+  int   result;
+
+  g_test_init (&argc, &argv, NULL);
+
+  gimp_test_utils_set_gimp2_directory ("GIMP_TESTING_ABS_TOP_SRCDIR",
+                                       "app/tests/gimpdir");
+
+  /* We share the same application instance across all tests */
+  gimp = gimp_init_for_testing ();
+
+  /* Make sure the rows and columns are split over threads */
+  g_object_set (gimp->config,
+                "num-processors", 4,
+                NULL);
+
+  /* Add tests */
+  ADD_TEST (shapeburst_is_exact);
+  ADD_TEST (shapeburst_matches_distance_transform);
+
+  /* Run the tests */
+  result = g_test_run ();
+
+  /* Don't write files to the source dir */
+  gimp_test_utils_set_gimp2_directory ("GIMP_TESTING_ABS_TOP_BUILDDIR",
+                                       "app/tests/gimpdir-output");
+
+  /* Exit so we don't break script-fu plug-in wire */
+  gimp_exit (gimp, TRUE);
+
+  return result;
+}
@@ -20,6 +20,9 @@
 
 #include "config.h"
 
+#include <string.h>
+
+#include <glib/gstdio.h>
 #include <gio/gio.h>
 
 #include <fontconfig/fontconfig.h>
@@ -32,18 +35,63 @@
 #include "config/gimpcoreconfig.h"
 
 #include "core/gimp.h"
+#include "core/gimpcontainer.h"
 
 #include "gimp-fonts.h"
 #include "gimpfontlist.h"
 
 
-#define CONF_FNAME "fonts.conf"
+#define CONF_FNAME  "fonts.conf"
+#define CACHE_FNAME "fontcache"
+
+#define CACHE_HEADER "# GIMP font cache"
+
+
+/*  Fonts are loaded in a thread, so that startup does not wait for
+ *  fontconfig to scan the font directories.  The list of font names is
+ *  also saved to disk, and reused as long as the font directories and
+ *  fontconfig's configuration files did not change, because enumerating
+ *  and naming thousands of faces often takes longer than the scan.
+ *
+ *  The GimpFont objects and the new configuration are only set up when
+ *  the thread is done, from an idle handler, or from gimp_fonts_wait()
+ *  by code that can't do without the fonts.
+ */
 
+typedef struct _GimpFontsLoad GimpFontsLoad;
+
+struct _GimpFontsLoad
+{
+  Gimp      *gimp;
+  GThread   *thread;
+  gboolean   finished;
 
-static gboolean gimp_fonts_load_fonts_conf (FcConfig *config,
-                                            GFile    *fonts_conf);
-static void     gimp_fonts_add_directories (FcConfig *config,
-                                            GList    *path);
+  /*  set up before the thread runs  */
+  gchar    **conf_files;
+  gchar    **font_dirs;
+  gchar     *cache_file;
+  gboolean   be_verbose;
+
+  /*  results of the thread  */
+  FcConfig  *config;
+  gchar    **names;
+};
+
+
+static gpointer gimp_fonts_load_thread     (GimpFontsLoad *load);
+static gboolean gimp_fonts_load_idle       (GimpFontsLoad *load);
+static void     gimp_fonts_load_finish     (GimpFontsLoad *load);
+
+static gchar  * gimp_fonts_get_fingerprint (FcConfig      *config,
+                                            gchar        **font_dirs);
+static gchar ** gimp_fonts_cache_read      (const gchar   *filename,
+                                            const gchar   *fingerprint);
+static void     gimp_fonts_cache_write     (const gchar   *filename,
+                                            const gchar   *fingerprint,
+                                            gchar        **names);
+
+
+static GimpFontsLoad *fonts_load = NULL;
 
 
 void
@@ -61,51 +109,61 @@ gimp_fonts_init (Gimp *gimp)
 void
 gimp_fonts_load (Gimp *gimp)
 {
-  FcConfig *config;
-  GFile    *fonts_conf;
-  GList    *path;
+  GimpFontsLoad *load;
+  GFile         *file;
+  GList         *path;
+  GList         *list;
+  gint           i;
 
   g_return_if_fail (GIMP_IS_FONT_LIST (gimp->fonts));
 
-  gimp_set_busy (gimp);
+  /*  let a running load finish first, it used the old font path  */
+  gimp_fonts_wait (gimp);
 
   if (gimp->be_verbose)
     g_print ("Loading fonts\n");
 
-  gimp_container_freeze (GIMP_CONTAINER (gimp->fonts));
+  load = g_slice_new0 (GimpFontsLoad);
 
-  gimp_container_clear (GIMP_CONTAINER (gimp->fonts));
+  load->gimp       = gimp;
+  load->be_verbose = gimp->be_verbose;
 
-  config = FcInitLoadConfig ();
-
-  if (! config)
-    goto cleanup;
+  load->conf_files = g_new0 (gchar *, 3);
 
-  fonts_conf = gimp_directory_file (CONF_FNAME, NULL);
-  if (! gimp_fonts_load_fonts_conf (config, fonts_conf))
-    goto cleanup;
+  file = gimp_directory_file (CONF_FNAME, NULL);
+  load->conf_files[0] = g_file_get_path (file);
+  g_object_unref (file);
 
-  fonts_conf = gimp_sysconf_directory_file (CONF_FNAME, NULL);
-  if (! gimp_fonts_load_fonts_conf (config, fonts_conf))
-    goto cleanup;
+  file = gimp_sysconf_directory_file (CONF_FNAME, NULL);
+  load->conf_files[1] = g_file_get_path (file);
+  g_object_unref (file);
 
   path = gimp_config_path_expand_to_files (gimp->config->font_path, FALSE);
-  gimp_fonts_add_directories (config, path);
+
+  load->font_dirs = g_new0 (gchar *, g_list_length (path) + 1);
+
+  for (list = path, i = 0; list; list = g_list_next (list), i++)
+    load->font_dirs[i] = g_file_get_path (list->data);
+
   g_list_free_full (path, (GDestroyNotify) g_object_unref);
 
-  if (! FcConfigBuildFonts (config))
-    {
-      FcConfigDestroy (config);
-      goto cleanup;
-    }
+  file = gimp_directory_file (CACHE_FNAME, NULL);
+  load->cache_file = g_file_get_path (file);
+  g_object_unref (file);
 
-  FcConfigSetCurrent (config);
+  fonts_load = load;
 
-  gimp_font_list_restore (GIMP_FONT_LIST (gimp->fonts));
+  load->thread = g_thread_new ("fonts",
+                               (GThreadFunc) gimp_fonts_load_thread, load);
+}
+
+void
+gimp_fonts_wait (Gimp *gimp)
+{
+  g_return_if_fail (GIMP_IS_GIMP (gimp));
 
- cleanup:
-  gimp_container_thaw (GIMP_CONTAINER (gimp->fonts));
-  gimp_unset_busy (gimp);
+  if (fonts_load && fonts_load->gimp == gimp)
+    gimp_fonts_load_finish (fonts_load);
 }
 
 void
@@ -116,43 +174,244 @@ gimp_fonts_reset (Gimp *gimp)
   if (gimp->no_fonts)
     return;
 
+  gimp_fonts_wait (gimp);
+
   /* Reinit the library with defaults. */
   FcInitReinitialize ();
 }
 
-static gboolean
-gimp_fonts_load_fonts_conf (FcConfig *config,
-                            GFile    *fonts_conf)
+
+/*  private functions  */
+
+static gpointer
+gimp_fonts_load_thread (GimpFontsLoad *load)
 {
-  gchar    *path = g_file_get_path (fonts_conf);
-  gboolean  ret  = TRUE;
+  FcConfig *config;
+  gchar    *fingerprint;
+  gint      i;
+
+  config = FcInitLoadConfig ();
 
-  if (! FcConfigParseAndLoad (config, (const guchar *) path, FcFalse))
+  if (! config)
+    goto done;
+
+  for (i = 0; load->conf_files[i]; i++)
+    {
+      if (! FcConfigParseAndLoad (config,
+                                  (const guchar *) load->conf_files[i],
+                                  FcFalse))
+        {
+          FcConfigDestroy (config);
+          goto done;
+        }
+    }
+
+  for (i = 0; load->font_dirs[i]; i++)
+    FcConfigAppFontAddDir (config, (const FcChar8 *) load->font_dirs[i]);
+
+  if (! FcConfigBuildFonts (config))
     {
       FcConfigDestroy (config);
-      ret = FALSE;
+      goto done;
     }
 
-  g_free (path);
-  g_object_unref (fonts_conf);
+  load->config = config;
 
-  return ret;
+  fingerprint = gimp_fonts_get_fingerprint (config, load->font_dirs);
+
+  load->names = gimp_fonts_cache_read (load->cache_file, fingerprint);
+
+  if (load->names)
+    {
+      if (load->be_verbose)
+        g_print ("Using font cache '%s'\n", load->cache_file);
+    }
+  else
+    {
+      /*  gimp_font_list_get_names() lists the current configuration  */
+      FcConfigSetCurrent (config);
+
+      load->names = gimp_font_list_get_names ();
+
+      gimp_fonts_cache_write (load->cache_file, fingerprint, load->names);
+    }
+
+  g_free (fingerprint);
+
+ done:
+  /*  the idle handler owns the load from here on  */
+  g_idle_add ((GSourceFunc) gimp_fonts_load_idle, load);
+
+  return NULL;
+}
+
+static gboolean
+gimp_fonts_load_idle (GimpFontsLoad *load)
+{
+  if (! load->finished)
+    gimp_fonts_load_finish (load);
+
+  g_strfreev (load->conf_files);
+  g_strfreev (load->font_dirs);
+  g_free (load->cache_file);
+  g_strfreev (load->names);
+
+  g_slice_free (GimpFontsLoad, load);
+
+  return G_SOURCE_REMOVE;
 }
 
 static void
-gimp_fonts_add_directories (FcConfig *config,
-                            GList    *path)
+gimp_fonts_load_finish (GimpFontsLoad *load)
 {
-  GList *list;
+  Gimp *gimp = load->gimp;
 
-  g_return_if_fail (config != NULL);
+  g_thread_join (load->thread);
 
-  for (list = path; list; list = list->next)
+  load->thread   = NULL;
+  load->finished = TRUE;
+
+  if (fonts_load == load)
+    fonts_load = NULL;
+
+  if (load->config)
     {
-      gchar *dir = g_file_get_path (list->data);
+      /*  does nothing if the thread made it current already  */
+      FcConfigSetCurrent (load->config);
 
-      FcConfigAppFontAddDir (config, (const FcChar8 *) dir);
+      gimp_font_list_set_names (GIMP_FONT_LIST (gimp->fonts), load->names);
+    }
+  else
+    {
+      gimp_container_clear (gimp->fonts);
+    }
+
+  if (gimp->be_verbose)
+    g_print ("Loaded %d fonts\n",
+             gimp_container_get_n_children (gimp->fonts));
+}
+
+/*  the font directories include their subdirectories, their mtimes
+ *  change whenever fonts are added or removed
+ */
+static gchar *
+gimp_fonts_get_fingerprint (FcConfig  *config,
+                            gchar    **font_dirs)
+{
+  GChecksum *checksum = g_checksum_new (G_CHECKSUM_SHA1);
+  FcStrList *list;
+  FcChar8   *str;
+  gchar     *fingerprint;
+  gint       version;
+  gint       i;
 
-      g_free (dir);
+  version = FcGetVersion ();
+  g_checksum_update (checksum, (const guchar *) &version, sizeof (version));
+
+  for (i = 0; font_dirs[i]; i++)
+    g_checksum_update (checksum, (const guchar *) font_dirs[i], -1);
+
+  list = FcStrListCreate (FcConfigGetConfigFiles (config));
+
+  while ((str = FcStrListNext (list)))
+    {
+      GStatBuf  st;
+      gint64    mtime = 0;
+
+      if (! g_stat ((const gchar *) str, &st))
+        mtime = st.st_mtime;
+
+      g_checksum_update (checksum, str, -1);
+      g_checksum_update (checksum, (const guchar *) &mtime, sizeof (mtime));
+    }
+
+  FcStrListDone (list);
+
+  list = FcConfigGetFontDirs (config);
+
+  while ((str = FcStrListNext (list)))
+    {
+      GStatBuf  st;
+      gint64    mtime = 0;
+
+      if (! g_stat ((const gchar *) str, &st))
+        mtime = st.st_mtime;
+
+      g_checksum_update (checksum, str, -1);
+      g_checksum_update (checksum, (const guchar *) &mtime, sizeof (mtime));
     }
+
+  FcStrListDone (list);
+
+  fingerprint = g_strdup (g_checksum_get_string (checksum));
+
+  g_checksum_free (checksum);
+
+  return fingerprint;
+}
+
+static gchar **
+gimp_fonts_cache_read (const gchar *filename,
+                       const gchar *fingerprint)
+{
+  gchar  *contents;
+  gchar **lines;
+  gchar **names = NULL;
+  gint    n_lines;
+
+  if (! g_file_get_contents (filename, &contents, NULL, NULL))
+    return NULL;
+
+  if (! g_utf8_validate (contents, -1, NULL))
+    {
+      g_free (contents);
+      return NULL;
+    }
+
+  lines   = g_strsplit (contents, "\n", -1);
+  n_lines = g_strv_length (lines);
+
+  g_free (contents);
+
+  /*  the header, the fingerprint, and the empty string after the last
+   *  newline
+   */
+  if (n_lines >= 3                      &&
+      ! strcmp (lines[0], CACHE_HEADER) &&
+      ! strcmp (lines[1], fingerprint)  &&
+      ! strcmp (lines[n_lines - 1], ""))
+    {
+      g_free (lines[n_lines - 1]);
+      lines[n_lines - 1] = NULL;
+
+      names = g_strdupv (lines + 2);
+    }
+
+  g_strfreev (lines);
+
+  return names;
+}
+
+static void
+gimp_fonts_cache_write (const gchar  *filename,
+                        const gchar  *fingerprint,
+                        gchar       **names)
+{
+  GString *string = g_string_new (CACHE_HEADER "\n");
+  GError  *error  = NULL;
+  gint     i;
+
+  g_string_append_printf (string, "%s\n", fingerprint);
+
+  for (i = 0; names[i]; i++)
+    g_string_append_printf (string, "%s\n", names[i]);
+
+  if (! g_file_set_contents (filename, string->str, string->len, &error))
+    {
+      g_printerr ("Could not write font cache '%s': %s\n",
+                  filename, error->message);
+      g_clear_error (&error);
+    }
+
+  g_string_free (string, TRUE);
 }
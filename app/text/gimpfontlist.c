@@ -47,13 +47,10 @@
 #endif
 
 
-static void   gimp_font_list_add_font   (GimpFontList         *list,
-                                         PangoContext         *context,
+static void   gimp_font_list_add_name   (GPtrArray            *names,
                                          PangoFontDescription *desc);
 
-static void   gimp_font_list_load_names (GimpFontList         *list,
-                                         PangoFontMap         *fontmap,
-                                         PangoContext         *context);
+static void   gimp_font_list_load_names (GPtrArray            *names);
 
 
 G_DEFINE_TYPE (GimpFontList, gimp_font_list, GIMP_TYPE_LIST)
@@ -89,11 +86,29 @@ gimp_font_list_new (gdouble xresolution,
   return GIMP_CONTAINER (list);
 }
 
+/*  Enumerates the fonts of the current fontconfig configuration.  Only
+ *  fontconfig is used, so this can run in a thread while the list is
+ *  in use.
+ */
+gchar **
+gimp_font_list_get_names (void)
+{
+  GPtrArray *names = g_ptr_array_new ();
+
+  gimp_font_list_load_names (names);
+
+  g_ptr_array_add (names, NULL);
+
+  return (gchar **) g_ptr_array_free (names, FALSE);
+}
+
 void
-gimp_font_list_restore (GimpFontList *list)
+gimp_font_list_set_names (GimpFontList  *list,
+                          gchar        **names)
 {
   PangoFontMap *fontmap;
   PangoContext *context;
+  gint          i;
 
   g_return_if_fail (GIMP_IS_FONT_LIST (list));
 
@@ -109,7 +124,24 @@ gimp_font_list_restore (GimpFontList *list)
 
   gimp_container_freeze (GIMP_CONTAINER (list));
 
-  gimp_font_list_load_names (list, PANGO_FONT_MAP (fontmap), context);
+  gimp_container_clear (GIMP_CONTAINER (list));
+
+  /*  fonts only keep their name and the shared context around, their
+   *  PangoFontDescription and preview layout are made on first use
+   */
+  for (i = 0; names && names[i]; i++)
+    {
+      GimpFont *font;
+
+      font = g_object_new (GIMP_TYPE_FONT,
+                           "name",          names[i],
+                           "pango-context", context,
+                           NULL);
+
+      gimp_container_add (GIMP_CONTAINER (list), GIMP_OBJECT (font));
+      g_object_unref (font);
+    }
+
   g_object_unref (context);
 
   gimp_list_sort_by_name (GIMP_LIST (list));
@@ -118,8 +150,7 @@ gimp_font_list_restore (GimpFontList *list)
 }
 
 static void
-gimp_font_list_add_font (GimpFontList         *list,
-                         PangoContext         *context,
+gimp_font_list_add_name (GPtrArray            *names,
                          PangoFontDescription *desc)
 {
   gchar *name;
@@ -130,33 +161,22 @@ gimp_font_list_add_font (GimpFontList         *list,
   name = pango_font_description_to_string (desc);
 
   if (g_utf8_validate (name, -1, NULL))
-    {
-      GimpFont *font;
-
-      font = g_object_new (GIMP_TYPE_FONT,
-                           "name",          name,
-                           "pango-context", context,
-                           NULL);
-
-      gimp_container_add (GIMP_CONTAINER (list), GIMP_OBJECT (font));
-      g_object_unref (font);
-    }
-
-  g_free (name);
+    g_ptr_array_add (names, name);
+  else
+    g_free (name);
 }
 
 #ifdef USE_FONTCONFIG_DIRECTLY
 /* We're really chummy here with the implementation. Oh well. */
 
 /* This is copied straight from make_alias_description in pango, plus
- * the gimp_font_list_add_font bits.
+ * the gimp_font_list_add_name bits.
  */
 static void
-gimp_font_list_make_alias (GimpFontList *list,
-                           PangoContext *context,
-                           const gchar  *family,
-                           gboolean      bold,
-                           gboolean      italic)
+gimp_font_list_make_alias (GPtrArray   *names,
+                           const gchar *family,
+                           gboolean     bold,
+                           gboolean     italic)
 {
   PangoFontDescription *desc = pango_font_description_new ();
 
@@ -170,31 +190,28 @@ gimp_font_list_make_alias (GimpFontList *list,
                                      PANGO_WEIGHT_BOLD : PANGO_WEIGHT_NORMAL);
   pango_font_description_set_stretch (desc, PANGO_STRETCH_NORMAL);
 
-  gimp_font_list_add_font (list, context, desc);
+  gimp_font_list_add_name (names, desc);
 
   pango_font_description_free (desc);
 }
 
 static void
-gimp_font_list_load_aliases (GimpFontList *list,
-                             PangoContext *context)
+gimp_font_list_load_aliases (GPtrArray *names)
 {
   const gchar *families[] = { "Sans", "Serif", "Monospace" };
   gint         i;
 
   for (i = 0; i < 3; i++)
     {
-      gimp_font_list_make_alias (list, context, families[i], FALSE, FALSE);
-      gimp_font_list_make_alias (list, context, families[i], TRUE,  FALSE);
-      gimp_font_list_make_alias (list, context, families[i], FALSE, TRUE);
-      gimp_font_list_make_alias (list, context, families[i], TRUE,  TRUE);
+      gimp_font_list_make_alias (names, families[i], FALSE, FALSE);
+      gimp_font_list_make_alias (names, families[i], TRUE,  FALSE);
+      gimp_font_list_make_alias (names, families[i], FALSE, TRUE);
+      gimp_font_list_make_alias (names, families[i], TRUE,  TRUE);
     }
 }
 
 static void
-gimp_font_list_load_names (GimpFontList *list,
-                           PangoFontMap *fontmap,
-                           PangoContext *context)
+gimp_font_list_load_names (GPtrArray *names)
 {
   FcObjectSet *os;
   FcPattern   *pat;
@@ -217,13 +234,13 @@ gimp_font_list_load_names (GimpFontList *list,
       PangoFontDescription *desc;
 
       desc = pango_fc_font_description_from_pattern (fontset->fonts[i], FALSE);
-      gimp_font_list_add_font (list, context, desc);
+      gimp_font_list_add_name (names, desc);
       pango_font_description_free (desc);
     }
 
   /*  only create aliases if there is at least one font available  */
   if (fontset->nfont > 0)
-    gimp_font_list_load_aliases (list, context);
+    gimp_font_list_load_aliases (names);
 
   FcFontSetDestroy (fontset);
 }
@@ -231,16 +248,19 @@ gimp_font_list_load_names (GimpFontList *list,
 #else  /* ! USE_FONTCONFIG_DIRECTLY */
 
 static void
-gimp_font_list_load_names (GimpFontList *list,
-                           PangoFontMap *fontmap,
-                           PangoContext *context)
+gimp_font_list_load_names (GPtrArray *names)
 {
+  PangoFontMap     *fontmap;
   PangoFontFamily **families;
   PangoFontFace   **faces;
   gint              n_families;
   gint              n_faces;
   gint              i, j;
 
+  fontmap = pango_cairo_font_map_new_for_font_type (CAIRO_FONT_TYPE_FT);
+  if (! fontmap)
+    return;
+
   pango_font_map_list_families (fontmap, &families, &n_families);
 
   for (i = 0; i < n_families; i++)
@@ -252,12 +272,15 @@ gimp_font_list_load_names (GimpFontList *list,
           PangoFontDescription *desc;
 
           desc = pango_font_face_describe (faces[j]);
-          gimp_font_list_add_font (list, context, desc);
+          gimp_font_list_add_name (names, desc);
           pango_font_description_free (desc);
         }
+
+      g_free (faces);
     }
 
   g_free (families);
+  g_object_unref (fontmap);
 }
 
 #endif /* USE_FONTCONFIG_DIRECTLY */
@@ -50,11 +50,14 @@ struct _GimpFontListClass
 };
 
 
-GType           gimp_font_list_get_type (void) G_GNUC_CONST;
+GType           gimp_font_list_get_type  (void) G_GNUC_CONST;
 
-GimpContainer * gimp_font_list_new      (gdouble       xresolution,
-                                         gdouble       yresolution);
-void            gimp_font_list_restore  (GimpFontList *list);
+GimpContainer * gimp_font_list_new       (gdouble        xresolution,
+                                          gdouble        yresolution);
+
+gchar        ** gimp_font_list_get_names (void);
+void            gimp_font_list_set_names (GimpFontList  *list,
+                                          gchar        **names);
 
 
 #endif  /*  __GIMP_FONT_LIST_H__  */
@@ -46,6 +46,7 @@
 #include "core/gimpitemtree.h"
 #include "core/gimpparasitelist.h"
 
+#include "gimp-fonts.h"
 #include "gimptext.h"
 #include "gimptextlayer.h"
 #include "gimptextlayer-transform.h"
@@ -55,6 +56,10 @@
 #include "gimp-intl.h"
 
 
+/*  the granularity of partial updates after a re-render  */
+#define RENDER_CELL_SIZE 64
+
+
 enum
 {
   PROP_0,
@@ -106,8 +111,14 @@ static void       gimp_text_layer_push_undo      (GimpDrawable      *drawable,
                                                   gint               width,
                                                   gint               height);
 
+static void       gimp_text_layer_swap_pixels    (GimpDrawable      *drawable,
+                                                  GeglBuffer        *buffer,
+                                                  gint               x,
+                                                  gint               y);
+
 static void       gimp_text_layer_text_changed   (GimpTextLayer     *layer);
 static gboolean   gimp_text_layer_render         (GimpTextLayer     *layer);
+static void       gimp_text_layer_clear_hashes   (GimpTextLayer     *layer);
 static void       gimp_text_layer_render_layout  (GimpTextLayer     *layer,
                                                   GimpTextLayout    *layout);
 
@@ -156,6 +167,7 @@ gimp_text_layer_class_init (GimpTextLayerClass *klass)
   drawable_class->convert_type      = gimp_text_layer_convert_type;
   drawable_class->set_buffer        = gimp_text_layer_set_buffer;
   drawable_class->push_undo         = gimp_text_layer_push_undo;
+  drawable_class->swap_pixels       = gimp_text_layer_swap_pixels;
 
   GIMP_CONFIG_INSTALL_PROP_OBJECT (object_class, PROP_TEXT,
                                    "text", NULL,
@@ -191,6 +203,8 @@ gimp_text_layer_finalize (GObject *object)
       layer->text = NULL;
     }
 
+  gimp_text_layer_clear_hashes (layer);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -256,6 +270,9 @@ gimp_text_layer_get_memsize (GimpObject *object,
   memsize += gimp_object_get_memsize (GIMP_OBJECT (text_layer->text),
                                       gui_size);
 
+  memsize += (text_layer->render_n_cols * text_layer->render_n_rows *
+              sizeof (guint64));
+
   return memsize + GIMP_OBJECT_CLASS (parent_class)->get_memsize (object,
                                                                   gui_size);
 }
@@ -333,6 +350,30 @@ gimp_text_layer_convert_type (GimpDrawable      *drawable,
                                                         mask_dither_type,
                                                         push_undo);
     }
+  else if (layer->text_parasite)
+    {
+      /*  The pixels are still the ones loaded from the XCF, the text
+       *  was never laid out in this session.  Convert them like any
+       *  other layer's pixels instead of going through Pango, which
+       *  would need the fonts loaded and could substitute missing
+       *  ones.  The conversion doesn't mark the layer as modified, the
+       *  text is laid out when it's changed.
+       *
+       *  Keep the original pixels in a drawable undo, a text layer
+       *  convert undo would convert the converted pixels back, which
+       *  is lossy.
+       */
+      if (push_undo)
+        gimp_image_undo_push_drawable_mod (image, NULL, drawable, FALSE);
+
+      GIMP_DRAWABLE_CLASS (parent_class)->convert_type (drawable, dest_image,
+                                                        new_format,
+                                                        new_base_type,
+                                                        new_precision,
+                                                        layer_dither_type,
+                                                        mask_dither_type,
+                                                        FALSE);
+    }
   else
     {
       if (push_undo)
@@ -357,6 +398,8 @@ gimp_text_layer_set_buffer (GimpDrawable *drawable,
   GimpTextLayer *layer = GIMP_TEXT_LAYER (drawable);
   GimpImage     *image = gimp_item_get_image (GIMP_ITEM (layer));
 
+  gimp_text_layer_clear_hashes (layer);
+
   if (push_undo && ! layer->modified)
     gimp_image_undo_group_start (image, GIMP_UNDO_GROUP_DRAWABLE_MOD,
                                  undo_desc);
@@ -388,6 +431,8 @@ gimp_text_layer_push_undo (GimpDrawable *drawable,
   GimpTextLayer *layer = GIMP_TEXT_LAYER (drawable);
   GimpImage     *image = gimp_item_get_image (GIMP_ITEM (layer));
 
+  gimp_text_layer_clear_hashes (layer);
+
   if (! layer->modified)
     gimp_image_undo_group_start (image, GIMP_UNDO_GROUP_DRAWABLE, undo_desc);
 
@@ -405,6 +450,17 @@ gimp_text_layer_push_undo (GimpDrawable *drawable,
     }
 }
 
+static void
+gimp_text_layer_swap_pixels (GimpDrawable *drawable,
+                             GeglBuffer   *buffer,
+                             gint          x,
+                             gint          y)
+{
+  gimp_text_layer_clear_hashes (GIMP_TEXT_LAYER (drawable));
+
+  GIMP_DRAWABLE_CLASS (parent_class)->swap_pixels (drawable, buffer, x, y);
+}
+
 
 /*  public functions  */
 
@@ -623,6 +679,8 @@ gimp_text_layer_render (GimpTextLayer *layer)
   item     = GIMP_ITEM (layer);
   image    = gimp_item_get_image (item);
 
+  gimp_fonts_wait (image->gimp);
+
   if (gimp_container_is_empty (image->gimp->fonts))
     {
       gimp_message_literal (image->gimp, NULL, GIMP_MESSAGE_ERROR,
@@ -709,6 +767,40 @@ gimp_text_layer_render (GimpTextLayer *layer)
   return (width > 0 && height > 0);
 }
 
+static void
+gimp_text_layer_clear_hashes (GimpTextLayer *layer)
+{
+  g_free (layer->render_hashes);
+
+  layer->render_hashes = NULL;
+  layer->render_n_cols = 0;
+  layer->render_n_rows = 0;
+}
+
+/*  FNV-1a over the 32 bit pixels of one cell of the surface  */
+static guint64
+gimp_text_layer_hash_cell (const guchar *data,
+                           gint          stride,
+                           gint          width,
+                           gint          height)
+{
+  guint64 hash = G_GUINT64_CONSTANT (14695981039346656037);
+  gint    x, y;
+
+  for (y = 0; y < height; y++)
+    {
+      const guint32 *pixel = (const guint32 *) (data + y * stride);
+
+      for (x = 0; x < width; x++)
+        {
+          hash ^= pixel[x];
+          hash *= G_GUINT64_CONSTANT (1099511628211);
+        }
+    }
+
+  return hash;
+}
+
 static void
 gimp_text_layer_render_layout (GimpTextLayer  *layer,
                                GimpTextLayout *layout)
@@ -721,6 +813,13 @@ gimp_text_layer_render_layout (GimpTextLayer  *layer,
   gint             width;
   gint             height;
   cairo_status_t   status;
+  guint64         *hashes;
+  const guchar    *data;
+  gint             stride;
+  gint             n_cols;
+  gint             n_rows;
+  gint             row, col;
+  gint             x1, y1, x2, y2;
 
   g_return_if_fail (gimp_drawable_has_alpha (drawable));
 
@@ -747,13 +846,69 @@ gimp_text_layer_render_layout (GimpTextLayer  *layer,
 
   cairo_surface_flush (surface);
 
-  buffer = gimp_cairo_surface_create_buffer (surface);
+  /*  a re-render after an edit usually changes a few lines only, so
+   *  compare checksums of the cells of the new rendering with the last
+   *  one, and copy and update just the bounding box of what changed
+   */
+  n_cols = (width  + RENDER_CELL_SIZE - 1) / RENDER_CELL_SIZE;
+  n_rows = (height + RENDER_CELL_SIZE - 1) / RENDER_CELL_SIZE;
 
-  gegl_buffer_copy (buffer, NULL,
-                    gimp_drawable_get_buffer (drawable), NULL);
+  if (layer->render_n_cols != n_cols ||
+      layer->render_n_rows != n_rows)
+    {
+      gimp_text_layer_clear_hashes (layer);
+    }
 
-  g_object_unref (buffer);
-  cairo_surface_destroy (surface);
+  hashes = g_new (guint64, n_cols * n_rows);
 
-  gimp_drawable_update (drawable, 0, 0, width, height);
+  data   = cairo_image_surface_get_data (surface);
+  stride = cairo_image_surface_get_stride (surface);
+
+  x1 = width;
+  y1 = height;
+  x2 = 0;
+  y2 = 0;
+
+  for (row = 0; row < n_rows; row++)
+    for (col = 0; col < n_cols; col++)
+      {
+        gint i = row * n_cols + col;
+        gint x = col * RENDER_CELL_SIZE;
+        gint y = row * RENDER_CELL_SIZE;
+        gint w = MIN (RENDER_CELL_SIZE, width  - x);
+        gint h = MIN (RENDER_CELL_SIZE, height - y);
+
+        hashes[i] = gimp_text_layer_hash_cell (data + y * stride + x * 4,
+                                               stride, w, h);
+
+        if (! layer->render_hashes || hashes[i] != layer->render_hashes[i])
+          {
+            x1 = MIN (x1, x);
+            y1 = MIN (y1, y);
+            x2 = MAX (x2, x + w);
+            y2 = MAX (y2, y + h);
+          }
+      }
+
+  g_free (layer->render_hashes);
+
+  layer->render_hashes = hashes;
+  layer->render_n_cols = n_cols;
+  layer->render_n_rows = n_rows;
+
+  if (x2 > x1 && y2 > y1)
+    {
+      GeglRectangle rect = { x1, y1, x2 - x1, y2 - y1 };
+
+      buffer = gimp_cairo_surface_create_buffer (surface);
+
+      gegl_buffer_copy (buffer, &rect,
+                        gimp_drawable_get_buffer (drawable), &rect);
+
+      g_object_unref (buffer);
+
+      gimp_drawable_update (drawable, rect.x, rect.y, rect.width, rect.height);
+    }
+
+  cairo_surface_destroy (surface);
 }
@@ -48,6 +48,12 @@ struct _GimpTextLayer
   gboolean      modified;
 
   const Babl   *convert_format;
+
+  guint64      *render_hashes;  /*  checksums of the rendered cells, to
+                                 *  update only what a re-render changed
+                                 */
+  gint          render_n_cols;
+  gint          render_n_rows;
 };
 
 struct _GimpTextLayerClass
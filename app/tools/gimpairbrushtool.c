@@ -71,6 +71,9 @@ gimp_airbrush_tool_init (GimpAirbrushTool *airbrush)
   GimpTool *tool = GIMP_TOOL (airbrush);
 
   gimp_tool_control_set_tool_cursor (tool->control, GIMP_TOOL_CURSOR_AIRBRUSH);
+
+  /*  the airbrush also stamps from a main loop timeout  */
+  GIMP_PAINT_TOOL (airbrush)->paint_threaded = FALSE;
 }
 
 
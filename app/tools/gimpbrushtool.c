@@ -43,6 +43,7 @@
 #include "display/gimpdisplayshell.h"
 
 #include "gimpbrushtool.h"
+#include "gimppainttool-paint.h"
 #include "gimptoolcontrol.h"
 
 
@@ -210,6 +211,8 @@ gimp_brush_tool_options_notify (GimpTool         *tool,
       GimpPaintTool *paint_tool = GIMP_PAINT_TOOL (tool);
       GimpBrushCore *brush_core = GIMP_BRUSH_CORE (paint_tool->core);
 
+      gimp_paint_tool_paint_sync (paint_tool);
+
       g_signal_emit_by_name (brush_core, "set-brush",
                              brush_core->main_brush);
     }
@@ -317,6 +320,8 @@ gimp_brush_tool_brush_changed (GimpContext   *context,
   GimpPaintTool *paint_tool = GIMP_PAINT_TOOL (brush_tool);
   GimpBrushCore *brush_core = GIMP_BRUSH_CORE (paint_tool->core);
 
+  gimp_paint_tool_paint_sync (paint_tool);
+
   gimp_brush_core_set_brush (brush_core, brush);
 
 }
@@ -45,8 +45,19 @@
 #include "gimp-intl.h"
 
 
-static GeglBuffer * gimp_by_color_select_tool_get_mask (GimpRegionSelectTool *region_select,
-                                                        GimpDisplay          *display);
+static void         gimp_by_color_select_tool_finalize     (GObject               *object);
+
+static void         gimp_by_color_select_tool_button_press (GimpTool              *tool,
+                                                            const GimpCoords      *coords,
+                                                            guint32                time,
+                                                            GdkModifierType        state,
+                                                            GimpButtonPressType    press_type,
+                                                            GimpDisplay           *display);
+
+static GeglBuffer * gimp_by_color_select_tool_get_mask     (GimpRegionSelectTool  *region_select,
+                                                            GimpDisplay           *display);
+
+static void         gimp_by_color_select_tool_drop_cache   (GimpByColorSelectTool *by_color_select);
 
 
 G_DEFINE_TYPE (GimpByColorSelectTool, gimp_by_color_select_tool,
@@ -75,12 +86,18 @@ gimp_by_color_select_tool_register (GimpToolRegisterCallback  callback,
 static void
 gimp_by_color_select_tool_class_init (GimpByColorSelectToolClass *klass)
 {
+  GObjectClass              *object_class = G_OBJECT_CLASS (klass);
+  GimpToolClass             *tool_class   = GIMP_TOOL_CLASS (klass);
   GimpRegionSelectToolClass *region_class;
 
   region_class = GIMP_REGION_SELECT_TOOL_CLASS (klass);
 
-  region_class->undo_desc = C_("command", "Select by Color");
-  region_class->get_mask  = gimp_by_color_select_tool_get_mask;
+  object_class->finalize   = gimp_by_color_select_tool_finalize;
+
+  tool_class->button_press = gimp_by_color_select_tool_button_press;
+
+  region_class->undo_desc  = C_("command", "Select by Color");
+  region_class->get_mask   = gimp_by_color_select_tool_get_mask;
 }
 
 static void
@@ -91,15 +108,39 @@ gimp_by_color_select_tool_init (GimpByColorSelectTool *by_color_select)
   gimp_tool_control_set_tool_cursor (tool->control, GIMP_TOOL_CURSOR_HAND);
 }
 
+static void
+gimp_by_color_select_tool_finalize (GObject *object)
+{
+  gimp_by_color_select_tool_drop_cache (GIMP_BY_COLOR_SELECT_TOOL (object));
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+gimp_by_color_select_tool_button_press (GimpTool            *tool,
+                                        const GimpCoords    *coords,
+                                        guint32              time,
+                                        GdkModifierType      state,
+                                        GimpButtonPressType  press_type,
+                                        GimpDisplay         *display)
+{
+  /*  the pixels may have changed since the last click  */
+  gimp_by_color_select_tool_drop_cache (GIMP_BY_COLOR_SELECT_TOOL (tool));
+
+  GIMP_TOOL_CLASS (parent_class)->button_press (tool, coords, time, state,
+                                                press_type, display);
+}
+
 static GeglBuffer *
 gimp_by_color_select_tool_get_mask (GimpRegionSelectTool *region_select,
                                     GimpDisplay          *display)
 {
-  GimpTool                *tool        = GIMP_TOOL (region_select);
-  GimpSelectionOptions    *sel_options = GIMP_SELECTION_TOOL_GET_OPTIONS (tool);
-  GimpRegionSelectOptions *options     = GIMP_REGION_SELECT_TOOL_GET_OPTIONS (tool);
-  GimpImage               *image       = gimp_display_get_image (display);
-  GimpDrawable            *drawable    = gimp_image_get_active_drawable (image);
+  GimpByColorSelectTool   *by_color_select = GIMP_BY_COLOR_SELECT_TOOL (region_select);
+  GimpTool                *tool            = GIMP_TOOL (region_select);
+  GimpSelectionOptions    *sel_options     = GIMP_SELECTION_TOOL_GET_OPTIONS (tool);
+  GimpRegionSelectOptions *options         = GIMP_REGION_SELECT_TOOL_GET_OPTIONS (tool);
+  GimpImage               *image           = gimp_display_get_image (display);
+  GimpDrawable            *drawable        = gimp_image_get_active_drawable (image);
   GimpPickable            *pickable;
   GimpRGB                  color;
   gint                     x, y;
@@ -125,13 +166,45 @@ gimp_by_color_select_tool_get_mask (GimpRegionSelectTool *region_select,
 
   gimp_pickable_flush (pickable);
 
-  if (gimp_pickable_get_color_at (pickable, x, y, &color))
-    return gimp_pickable_contiguous_region_by_color (pickable,
-                                                     sel_options->antialias,
-                                                     options->threshold / 255.0,
-                                                     options->select_transparent,
-                                                     options->select_criterion,
-                                                     &color);
+  if (! gimp_pickable_get_color_at (pickable, x, y, &color))
+    return NULL;
+
+  /*  only the threshold changes while dragging, so keep the distances
+   *  and just threshold them again
+   */
+  if (! by_color_select->distance_buffer                                         ||
+      by_color_select->distance_pickable           != pickable                    ||
+      by_color_select->distance_select_transparent != options->select_transparent ||
+      by_color_select->distance_select_criterion   != options->select_criterion   ||
+      gimp_rgba_distance (&by_color_select->distance_color, &color) != 0.0)
+    {
+      gimp_by_color_select_tool_drop_cache (by_color_select);
+
+      by_color_select->distance_buffer =
+        gimp_pickable_contiguous_region_distance_by_color (pickable,
+                                                           options->select_transparent,
+                                                           options->select_criterion,
+                                                           &color);
+
+      by_color_select->distance_pickable           = pickable;
+      by_color_select->distance_color              = color;
+      by_color_select->distance_select_transparent = options->select_transparent;
+      by_color_select->distance_select_criterion   = options->select_criterion;
+    }
+
+  return gimp_pickable_contiguous_region_by_distance (by_color_select->distance_buffer,
+                                                      sel_options->antialias,
+                                                      options->threshold / 255.0);
+}
+
+static void
+gimp_by_color_select_tool_drop_cache (GimpByColorSelectTool *by_color_select)
+{
+  if (by_color_select->distance_buffer)
+    {
+      g_object_unref (by_color_select->distance_buffer);
+      by_color_select->distance_buffer = NULL;
+    }
 
-  return NULL;
+  by_color_select->distance_pickable = NULL;
 }
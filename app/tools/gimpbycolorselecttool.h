@@ -38,6 +38,15 @@ typedef struct _GimpByColorSelectToolClass GimpByColorSelectToolClass;
 struct _GimpByColorSelectTool
 {
   GimpRegionSelectTool  parent_instance;
+
+  /*  the distances to the picked color, cached while the threshold
+   *  is changed by dragging
+   */
+  GeglBuffer           *distance_buffer;
+  GimpPickable         *distance_pickable;
+  GimpRGB               distance_color;
+  gboolean              distance_select_transparent;
+  GimpSelectCriterion   distance_select_criterion;
 };
 
 struct _GimpByColorSelectToolClass
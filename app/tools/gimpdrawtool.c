@@ -78,6 +78,11 @@ static void          gimp_draw_tool_draw         (GimpDrawTool     *draw_tool);
 static void          gimp_draw_tool_undraw       (GimpDrawTool     *draw_tool);
 static void          gimp_draw_tool_real_draw    (GimpDrawTool     *draw_tool);
 
+static gdouble       gimp_draw_tool_get_handle_radius
+                                                 (GimpDisplay      *display,
+                                                  gint              width,
+                                                  gint              height);
+
 
 G_DEFINE_TYPE (GimpDrawTool, gimp_draw_tool, GIMP_TYPE_TOOL)
 
@@ -1065,6 +1070,19 @@ gimp_draw_tool_on_handle (GimpDrawTool     *draw_tool,
   return FALSE;
 }
 
+/*  an upper bound, in image coordinates, for the distance at which
+ *  gimp_draw_tool_on_handle() can still report a circular handle as hit
+ */
+static gdouble
+gimp_draw_tool_get_handle_radius (GimpDisplay *display,
+                                  gint         width,
+                                  gint         height)
+{
+  GimpDisplayShell *shell = gimp_display_get_shell (display);
+
+  return (MAX (width, height) / 2 + 1) / MIN (shell->scale_x, shell->scale_y);
+}
+
 gboolean
 gimp_draw_tool_on_vectors_handle (GimpDrawTool      *draw_tool,
                                   GimpDisplay       *display,
@@ -1084,6 +1102,7 @@ gimp_draw_tool_on_vectors_handle (GimpDrawTool      *draw_tool,
   gdouble     dx, dy;
   gdouble     pref_mindist = -1;
   gdouble     mindist      = -1;
+  gdouble     radius;
 
   g_return_val_if_fail (GIMP_IS_DRAW_TOOL (draw_tool), FALSE);
   g_return_val_if_fail (GIMP_IS_DISPLAY (display), FALSE);
@@ -1093,13 +1112,21 @@ gimp_draw_tool_on_vectors_handle (GimpDrawTool      *draw_tool,
   if (ret_anchor) *ret_anchor = NULL;
   if (ret_stroke) *ret_stroke = NULL;
 
+  /*  anchors farther away than this can't be on the handle, so only
+   *  look at the ones around coord
+   */
+  radius = gimp_draw_tool_get_handle_radius (display, width, height);
+
   while ((stroke = gimp_vectors_stroke_get_next (vectors, stroke)))
     {
       GList *anchor_list;
       GList *list;
 
-      anchor_list = g_list_concat (gimp_stroke_get_draw_anchors (stroke),
-                                   gimp_stroke_get_draw_controls (stroke));
+      anchor_list =
+        g_list_concat (gimp_stroke_get_draw_anchors_near (stroke,
+                                                          coord, radius),
+                       gimp_stroke_get_draw_controls_near (stroke,
+                                                           coord, radius));
 
       for (list = anchor_list; list; list = g_list_next (list))
         {
@@ -1202,6 +1229,7 @@ gimp_draw_tool_on_vectors_curve (GimpDrawTool      *draw_tool,
   GimpCoords  min_coords = GIMP_COORDS_DEFAULT_VALUES;
   GimpCoords  cur_coords;
   gdouble     min_dist, cur_dist, cur_pos;
+  gdouble     radius;
 
   g_return_val_if_fail (GIMP_IS_DRAW_TOOL (draw_tool), FALSE);
   g_return_val_if_fail (GIMP_IS_DISPLAY (display), FALSE);
@@ -1215,14 +1243,15 @@ gimp_draw_tool_on_vectors_curve (GimpDrawTool      *draw_tool,
   if (ret_stroke)        *ret_stroke        = NULL;
 
   min_dist = -1.0;
+  radius   = gimp_draw_tool_get_handle_radius (display, width, height);
 
   while ((stroke = gimp_vectors_stroke_get_next (vectors, stroke)))
     {
-      cur_dist = gimp_stroke_nearest_point_get (stroke, coord, 1.0,
-                                                &cur_coords,
-                                                &segment_start,
-                                                &segment_end,
-                                                &cur_pos);
+      cur_dist = gimp_stroke_nearest_point_within (stroke, coord, 1.0, radius,
+                                                   &cur_coords,
+                                                   &segment_start,
+                                                   &segment_end,
+                                                   &cur_pos);
 
       if (cur_dist >= 0 && (min_dist < 0 || cur_dist < min_dist))
         {
@@ -56,10 +56,13 @@
 #include "gimpforegroundselectoptions.h"
 #include "gimptoolcontrol.h"
 
+#include "gimp-priorities.h"
+
 #include "gimp-intl.h"
 
 
 typedef struct _StrokeUndo StrokeUndo;
+typedef struct _ExtractJob ExtractJob;
 
 struct _StrokeUndo
 {
@@ -70,6 +73,18 @@ struct _StrokeUndo
   gint                 stroke_width;
 };
 
+struct _ExtractJob
+{
+  GeglBuffer          *buffer;
+  GeglBuffer          *trimap;
+  GimpMattingEngine    engine;
+  gint                 iterations;
+  gint                 levels;
+  gint                 active_levels;
+  GCancellable        *cancellable;
+  gint                 generation;
+};
+
 
 static void   gimp_foreground_select_tool_finalize       (GObject          *object);
 
@@ -145,6 +160,15 @@ static void   gimp_foreground_select_tool_set_trimap     (GimpForegroundSelectTo
 static void   gimp_foreground_select_tool_set_preview    (GimpForegroundSelectTool *fg_select);
 static void   gimp_foreground_select_tool_preview        (GimpForegroundSelectTool *fg_select);
 
+static void   gimp_foreground_select_tool_extract_cancel (GimpForegroundSelectTool *fg_select);
+static void   gimp_foreground_select_tool_extract_thread (ExtractJob               *job,
+                                                          GimpForegroundSelectTool *fg_select);
+static void   gimp_foreground_select_tool_extract_deliver(GimpForegroundSelectTool *fg_select,
+                                                          ExtractJob               *job,
+                                                          GeglBuffer               *mask,
+                                                          gboolean                  final);
+static gboolean gimp_foreground_select_tool_extract_idle (GimpForegroundSelectTool *fg_select);
+
 static void   gimp_foreground_select_tool_stroke_paint   (GimpForegroundSelectTool *fg_select);
 static void   gimp_foreground_select_tool_cancel_paint   (GimpForegroundSelectTool *fg_select);
 
@@ -241,6 +265,8 @@ gimp_foreground_select_tool_init (GimpForegroundSelectTool *fg_select)
                                      "tools/tools-foreground-select-brush-size-set");
 
   fg_select->state = MATTING_STATE_FREE_SELECT;
+
+  g_mutex_init (&fg_select->extract_mutex);
 }
 
 static void
@@ -248,6 +274,19 @@ gimp_foreground_select_tool_finalize (GObject *object)
 {
   GimpForegroundSelectTool *fg_select = GIMP_FOREGROUND_SELECT_TOOL (object);
 
+  gimp_foreground_select_tool_extract_cancel (fg_select);
+
+  if (fg_select->extract_pool)
+    {
+      /*  the queued jobs are cancelled and return right away  */
+      g_thread_pool_free (fg_select->extract_pool, FALSE, TRUE);
+      fg_select->extract_pool = NULL;
+
+      gimp_foreground_select_tool_extract_cancel (fg_select);
+    }
+
+  g_mutex_clear (&fg_select->extract_mutex);
+
   if (fg_select->gui)
     {
       g_object_unref (fg_select->gui);
@@ -916,6 +955,8 @@ gimp_foreground_select_tool_halt (GimpForegroundSelectTool *fg_select)
 {
   GimpTool *tool = GIMP_TOOL (fg_select);
 
+  gimp_foreground_select_tool_extract_cancel (fg_select);
+
   if (fg_select->trimap)
     {
       g_object_unref (fg_select->trimap);
@@ -928,6 +969,8 @@ gimp_foreground_select_tool_halt (GimpForegroundSelectTool *fg_select)
       fg_select->mask = NULL;
     }
 
+  fg_select->mask_final = FALSE;
+
   if (fg_select->undo_stack)
     {
       g_list_free_full (fg_select->undo_stack,
@@ -974,10 +1017,31 @@ gimp_foreground_select_tool_commit (GimpForegroundSelectTool *fg_select)
 
   if (tool->display && fg_select->state != MATTING_STATE_FREE_SELECT)
     {
-      GimpImage *image = gimp_display_get_image (tool->display);
+      GimpImage                   *image = gimp_display_get_image (tool->display);
+      GimpForegroundSelectOptions *fg_options;
 
-      if (fg_select->state != MATTING_STATE_PREVIEW_MASK)
-        gimp_foreground_select_tool_preview (fg_select);
+      fg_options = GIMP_FOREGROUND_SELECT_TOOL_GET_OPTIONS (tool);
+
+      gimp_foreground_select_tool_extract_cancel (fg_select);
+
+      /*  a preview mask can be used only if it is the full size one  */
+      if (! fg_select->mask || ! fg_select->mask_final)
+        {
+          GimpDrawable *drawable = gimp_image_get_active_drawable (image);
+
+          if (fg_select->mask)
+            g_object_unref (fg_select->mask);
+
+          fg_select->mask =
+            gimp_drawable_foreground_extract (drawable,
+                                              fg_options->engine,
+                                              fg_options->iterations,
+                                              fg_options->levels,
+                                              fg_options->active_levels,
+                                              fg_select->trimap,
+                                              GIMP_PROGRESS (fg_select));
+          fg_select->mask_final = TRUE;
+        }
 
       gimp_channel_select_buffer (gimp_image_get_mask (image),
                                   C_("command", "Foreground Select"),
@@ -1004,6 +1068,17 @@ gimp_foreground_select_tool_set_trimap (GimpForegroundSelectTool *fg_select)
 
   options = GIMP_FOREGROUND_SELECT_TOOL_GET_OPTIONS (tool);
 
+  /*  any preview mask is outdated as soon as the trimap is painted on  */
+  gimp_foreground_select_tool_extract_cancel (fg_select);
+
+  if (fg_select->mask)
+    {
+      g_object_unref (fg_select->mask);
+      fg_select->mask = NULL;
+    }
+
+  fg_select->mask_final = FALSE;
+
   gimp_foreground_select_options_get_mask_color (options, &color);
   gimp_display_shell_set_mask (gimp_display_get_shell (tool->display),
                                fg_select->trimap, &color, TRUE);
@@ -1028,13 +1103,16 @@ gimp_foreground_select_tool_set_preview (GimpForegroundSelectTool *fg_select)
   GimpForegroundSelectOptions *options;
   GimpRGB                      color;
 
-  g_return_if_fail (fg_select->mask != NULL);
+  g_return_if_fail (fg_select->trimap != NULL);
 
   options = GIMP_FOREGROUND_SELECT_TOOL_GET_OPTIONS (tool);
 
+  /*  until the first mask arrives from the worker, show the trimap  */
   gimp_foreground_select_options_get_mask_color (options, &color);
   gimp_display_shell_set_mask (gimp_display_get_shell (tool->display),
-                               fg_select->mask, &color, TRUE);
+                               fg_select->mask ?
+                               fg_select->mask : fg_select->trimap,
+                               &color, TRUE);
 
   gimp_tool_control_set_tool_cursor        (tool->control,
                                             GIMP_TOOL_CURSOR_PAINTBRUSH);
@@ -1048,6 +1126,10 @@ gimp_foreground_select_tool_set_preview (GimpForegroundSelectTool *fg_select)
   gimp_foreground_select_tool_update_gui (fg_select);
 }
 
+/*  The mask is computed on a worker thread: first at a reduced size
+ *  for a quick preview, then the unknown band at full size. The old
+ *  mask stays visible until the new one arrives.
+ */
 static void
 gimp_foreground_select_tool_preview (GimpForegroundSelectTool *fg_select)
 {
@@ -1055,24 +1137,170 @@ gimp_foreground_select_tool_preview (GimpForegroundSelectTool *fg_select)
   GimpForegroundSelectOptions *options;
   GimpImage                   *image    = gimp_display_get_image (tool->display);
   GimpDrawable                *drawable = gimp_image_get_active_drawable (image);
+  ExtractJob                  *job;
 
   options  = GIMP_FOREGROUND_SELECT_TOOL_GET_OPTIONS (tool);
 
-  if (fg_select->mask)
+  gimp_foreground_select_tool_extract_cancel (fg_select);
+
+  fg_select->mask_final = FALSE;
+
+  if (! fg_select->extract_pool)
+    fg_select->extract_pool =
+      g_thread_pool_new ((GFunc) gimp_foreground_select_tool_extract_thread,
+                         fg_select, 1, FALSE, NULL);
+
+  fg_select->extract_cancellable = g_cancellable_new ();
+
+  job = g_slice_new (ExtractJob);
+
+  /*  the worker gets copies, the originals can change meanwhile  */
+  job->buffer        = gegl_buffer_dup (gimp_drawable_get_buffer (drawable));
+  job->trimap        = gegl_buffer_dup (fg_select->trimap);
+  job->engine        = options->engine;
+  job->iterations    = options->iterations;
+  job->levels        = options->levels;
+  job->active_levels = options->active_levels;
+  job->cancellable   = g_object_ref (fg_select->extract_cancellable);
+  job->generation    = g_atomic_int_get (&fg_select->extract_generation);
+
+  g_thread_pool_push (fg_select->extract_pool, job, NULL);
+
+  gimp_foreground_select_tool_set_preview (fg_select);
+}
+
+static void
+gimp_foreground_select_tool_extract_cancel (GimpForegroundSelectTool *fg_select)
+{
+  g_atomic_int_inc (&fg_select->extract_generation);
+
+  if (fg_select->extract_cancellable)
     {
-      g_object_unref (fg_select->mask);
-      fg_select->mask = NULL;
+      g_cancellable_cancel (fg_select->extract_cancellable);
+      g_object_unref (fg_select->extract_cancellable);
+      fg_select->extract_cancellable = NULL;
     }
 
-  fg_select->mask = gimp_drawable_foreground_extract (drawable,
-                                                      options->engine,
-                                                      options->iterations,
-                                                      options->levels,
-                                                      options->active_levels,
-                                                      fg_select->trimap,
-                                                      GIMP_PROGRESS (fg_select));
+  g_mutex_lock (&fg_select->extract_mutex);
 
-  gimp_foreground_select_tool_set_preview (fg_select);
+  if (fg_select->extract_idle_id)
+    {
+      g_source_remove (fg_select->extract_idle_id);
+      fg_select->extract_idle_id = 0;
+    }
+
+  if (fg_select->extract_mask)
+    {
+      g_object_unref (fg_select->extract_mask);
+      fg_select->extract_mask = NULL;
+    }
+
+  g_mutex_unlock (&fg_select->extract_mutex);
+}
+
+static void
+gimp_foreground_select_tool_extract_thread (ExtractJob               *job,
+                                            GimpForegroundSelectTool *fg_select)
+{
+  GeglBuffer *mask    = NULL;
+  gboolean    reduced = FALSE;
+
+  if (! g_cancellable_is_cancelled (job->cancellable))
+    mask = gimp_foreground_extract_buffer (job->buffer,
+                                           job->engine,
+                                           job->iterations,
+                                           job->levels,
+                                           job->active_levels,
+                                           job->trimap,
+                                           TRUE, &reduced,
+                                           job->cancellable, NULL);
+
+  if (mask)
+    gimp_foreground_select_tool_extract_deliver (fg_select, job, mask,
+                                                 ! reduced);
+
+  if (mask && reduced)
+    {
+      mask = gimp_foreground_extract_buffer (job->buffer,
+                                             job->engine,
+                                             job->iterations,
+                                             job->levels,
+                                             job->active_levels,
+                                             job->trimap,
+                                             FALSE, NULL,
+                                             job->cancellable, NULL);
+
+      if (mask)
+        gimp_foreground_select_tool_extract_deliver (fg_select, job, mask,
+                                                     TRUE);
+    }
+
+  g_object_unref (job->buffer);
+  g_object_unref (job->trimap);
+  g_object_unref (job->cancellable);
+
+  g_slice_free (ExtractJob, job);
+}
+
+static void
+gimp_foreground_select_tool_extract_deliver (GimpForegroundSelectTool *fg_select,
+                                             ExtractJob               *job,
+                                             GeglBuffer               *mask,
+                                             gboolean                  final)
+{
+  g_mutex_lock (&fg_select->extract_mutex);
+
+  if (g_atomic_int_get (&fg_select->extract_generation) == job->generation)
+    {
+      if (fg_select->extract_mask)
+        g_object_unref (fg_select->extract_mask);
+
+      fg_select->extract_mask  = mask;
+      fg_select->extract_final = final;
+
+      mask = NULL;
+
+      if (! fg_select->extract_idle_id)
+        fg_select->extract_idle_id =
+          g_idle_add_full (GIMP_PRIORITY_FOREGROUND_EXTRACT_IDLE,
+                           (GSourceFunc) gimp_foreground_select_tool_extract_idle,
+                           fg_select, NULL);
+    }
+
+  g_mutex_unlock (&fg_select->extract_mutex);
+
+  if (mask)
+    g_object_unref (mask);
+}
+
+static gboolean
+gimp_foreground_select_tool_extract_idle (GimpForegroundSelectTool *fg_select)
+{
+  GeglBuffer *mask;
+  gboolean    final;
+
+  g_mutex_lock (&fg_select->extract_mutex);
+
+  mask  = fg_select->extract_mask;
+  final = fg_select->extract_final;
+
+  fg_select->extract_mask    = NULL;
+  fg_select->extract_idle_id = 0;
+
+  g_mutex_unlock (&fg_select->extract_mutex);
+
+  if (mask)
+    {
+      if (fg_select->mask)
+        g_object_unref (fg_select->mask);
+
+      fg_select->mask       = mask;
+      fg_select->mask_final = final;
+
+      gimp_foreground_select_tool_set_preview (fg_select);
+    }
+
+  return G_SOURCE_REMOVE;
 }
 
 static void
@@ -53,6 +53,15 @@ struct _GimpForegroundSelectTool
   GArray             *stroke;
   GeglBuffer         *trimap;
   GeglBuffer         *mask;
+  gboolean            mask_final;
+
+  GThreadPool        *extract_pool;
+  GCancellable       *extract_cancellable;
+  gint                extract_generation;
+  GMutex              extract_mutex;
+  GeglBuffer         *extract_mask;
+  gboolean            extract_final;
+  guint               extract_idle_id;
 
   GList              *undo_stack;
   GList              *redo_stack;
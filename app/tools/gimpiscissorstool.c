@@ -45,6 +45,7 @@
 #include "config.h"
 
 #include <stdlib.h>
+#include <string.h>
 
 #include <gegl.h>
 #include <gtk/gtk.h>
@@ -62,7 +63,6 @@
 #include "core/gimpimage.h"
 #include "core/gimppickable.h"
 #include "core/gimpscanconvert.h"
-#include "core/gimptempbuf.h"
 #include "core/gimptoolinfo.h"
 
 #include "widgets/gimphelp-ids.h"
@@ -90,12 +90,21 @@
 #define  OMEGA_D           0.2
 #define  OMEGA_G           0.8
 
-/* sentinel to mark seed point in ?cost? map */
+/* sentinel to mark seed point in the link map */
 #define  SEED_POINT        9
 
-/*  Functional defines  */
-#define  PIXEL_COST(x)     ((x) >> 8)
-#define  PIXEL_DIR(x)      ((x) & 0x000000ff)
+/* link map value of pixels the search has not reached yet */
+#define  UNREACHED         0x0f
+
+/* flag in the link map marking pixels whose cost is final */
+#define  SETTLED           0x80
+
+#define  LINK_DIR(x)       ((x) & 0x0f)
+
+/* number of buckets in the priority queue, a power of two larger
+ * than the largest possible link cost (~390)
+ */
+#define  N_BUCKETS         512
 
 
 struct _ISegment
@@ -112,6 +121,26 @@ struct _ICurve
   gboolean  connected;
 };
 
+/*  A shortest path search from a seed point, over a part of the
+ *  gradient map.  Pixels are settled in order of their cost, using a
+ *  queue of buckets indexed by cost.  The search stops as soon as the
+ *  wanted end point is settled, and can later be continued for
+ *  another end point from the same seed.
+ */
+struct _ISearch
+{
+  GeglRectangle  area;               /*  the searched part of the image   */
+  gint           xs, ys;             /*  the seed point                   */
+
+  guint8        *gradient;           /*  gradient map of the area         */
+  guint32       *cost;               /*  cumulative cost of each pixel    */
+  guint8        *link;               /*  direction towards the seed       */
+
+  GArray        *buckets[N_BUCKETS]; /*  pixels to visit, by cost         */
+  guint32        current;            /*  cost of the current bucket       */
+  gint           n_queued;
+};
+
 
 /*  local function prototypes  */
 
@@ -173,14 +202,17 @@ static void          iscissors_convert         (GimpIscissorsTool *iscissors,
                                                 GimpDisplay       *display);
 static GeglBuffer  * gradient_map_new          (GimpImage         *image);
 
-static void          find_optimal_path         (GeglBuffer        *gradient_map,
-                                                GimpTempBuf       *dp_buf,
-                                                gint               x1,
-                                                gint               y1,
-                                                gint               x2,
-                                                gint               y2,
+static ISearch     * isearch_new               (GeglBuffer        *gradient_map,
+                                                const GeglRectangle *area,
                                                 gint               xs,
                                                 gint               ys);
+static void          isearch_free              (ISearch           *search);
+static void          isearch_push              (ISearch           *search,
+                                                gint               index,
+                                                guint32            cost);
+static void          isearch_run               (ISearch           *search,
+                                                gint               xe,
+                                                gint               ye);
 static void          find_max_gradient         (GimpIscissorsTool *iscissors,
                                                 GimpImage         *image,
                                                 gint              *x,
@@ -203,12 +235,7 @@ static gboolean      clicked_on_segment        (GimpIscissorsTool *iscissors,
                                                 gdouble            x,
                                                 gdouble            y);
 
-static GPtrArray   * plot_pixels               (GimpIscissorsTool *iscissors,
-                                                GimpTempBuf       *dp_buf,
-                                                gint               x1,
-                                                gint               y1,
-                                                gint               xs,
-                                                gint               ys,
+static GPtrArray   * plot_pixels               (ISearch           *search,
                                                 gint               xe,
                                                 gint               ye);
 
@@ -1244,6 +1271,8 @@ static void
 gimp_iscissors_tool_halt (GimpIscissorsTool *iscissors,
                           GimpDisplay       *display)
 {
+  gint i;
+
   icurve_clear (iscissors->curve);
 
   iscissors->segment1 = NULL;
@@ -1268,10 +1297,13 @@ gimp_iscissors_tool_halt (GimpIscissorsTool *iscissors,
       iscissors->gradient_map = NULL;
     }
 
-  if (iscissors->dp_buf)
+  for (i = 0; i < G_N_ELEMENTS (iscissors->search); i++)
     {
-      gimp_temp_buf_unref (iscissors->dp_buf);
-      iscissors->dp_buf = NULL;
+      if (iscissors->search[i])
+        {
+          isearch_free (iscissors->search[i]);
+          iscissors->search[i] = NULL;
+        }
     }
 
   if (iscissors->mask)
@@ -1484,15 +1516,15 @@ calculate_segment (GimpIscissorsTool *iscissors,
   gint         x, y, dir;
   gint         xs, ys, xe, ye;
   gint         x1, y1, x2, y2;
-  gint         width, height;
   gint         ewidth, eheight;
 
   /*  Calculate the lowest cost path from one vertex to the next as specified
    *  by the parameter "segment".
    *    Here are the steps:
    *      1)  Calculate the appropriate working area for this operation
-   *      2)  Allocate a temp buf for the dynamic programming array
-   *      3)  Run the dynamic programming algorithm to find the optimal path
+   *      2)  Reuse a previous search from the same seed point that
+   *            covers the end point, or start a new one
+   *      3)  Run the search until the end point is reached
    *      4)  Translate the optimal path into pixels in the isegment data
    *            structure.
    */
@@ -1537,28 +1569,60 @@ calculate_segment (GimpIscissorsTool *iscissors,
   /*  If the bounding box has width and height...  */
   if ((x2 - x1) && (y2 - y1))
     {
-      width = (x2 - x1);
-      height = (y2 - y1);
+      ISearch *search = NULL;
+      gint     n      = G_N_ELEMENTS (iscissors->search);
+      gint     i;
 
       /* Initialise the gradient map tile manager for this image if we
        * don't already have one. */
       if (! iscissors->gradient_map)
         iscissors->gradient_map = gradient_map_new (image);
 
-      /*  allocate the dynamic programming array  */
-      if (iscissors->dp_buf)
-        gimp_temp_buf_unref (iscissors->dp_buf);
+      /*  while one end of a segment is dragged, the other end stays
+       *  put, so the search from it can simply go on; its area may
+       *  differ from the one computed above, but it contains the end
+       *  point and its path is at least as good
+       */
+      for (i = 0; i < n; i++)
+        {
+          ISearch *recent = iscissors->search[i];
+
+          if (recent                        &&
+              recent->xs == xs              &&
+              recent->ys == ys              &&
+              xe >= recent->area.x          &&
+              ye >= recent->area.y          &&
+              xe <  recent->area.x + recent->area.width &&
+              ye <  recent->area.y + recent->area.height)
+            {
+              search = recent;
+              break;
+            }
+        }
+
+      if (! search)
+        {
+          i = n - 1;
+
+          if (iscissors->search[i])
+            isearch_free (iscissors->search[i]);
+
+          search = isearch_new (iscissors->gradient_map,
+                                GEGL_RECTANGLE (x1, y1, x2 - x1, y2 - y1),
+                                xs, ys);
+        }
+
+      /*  keep the most recently used search first  */
+      for (; i > 0; i--)
+        iscissors->search[i] = iscissors->search[i - 1];
 
-      iscissors->dp_buf = gimp_temp_buf_new (width, height,
-                                             babl_format ("Y u32"));
+      iscissors->search[0] = search;
 
-      /*  find the optimal path of pixels from (x1, y1) to (x2, y2)  */
-      find_optimal_path (iscissors->gradient_map, iscissors->dp_buf,
-                         x1, y1, x2, y2, xs, ys);
+      /*  find the optimal path of pixels from (xs, ys) to (xe, ye)  */
+      isearch_run (search, xe, ye);
 
       /*  get a list of the pixels in the optimal path  */
-      segment->points = plot_pixels (iscissors, iscissors->dp_buf,
-                                     x1, y1, xs, ys, xe, ye);
+      segment->points = plot_pixels (search, xe, ye);
     }
   /*  If the bounding box has no width  */
   else if ((x2 - x1) == 0)
@@ -1589,52 +1653,18 @@ calculate_segment (GimpIscissorsTool *iscissors,
 }
 
 
-/* badly need to get a replacement - this is _way_ too expensive */
-static gboolean
-gradient_map_value (GeglBuffer *map,
-                    gint        x,
-                    gint        y,
-                    guint8     *grad,
-                    guint8     *dir)
-{
-  const GeglRectangle *extents;
-
-  extents = gegl_buffer_get_extent (map);
-
-  if (x >= extents->x     &&
-      y >= extents->y     &&
-      x <  extents->width &&
-      y <  extents->height)
-    {
-      guint8 sample[2];
-
-      gegl_buffer_sample (map, x, y, NULL, sample, NULL,
-                          GEGL_SAMPLER_NEAREST, GEGL_ABYSS_NONE);
-
-      *grad = sample[0];
-      *dir  = sample[1];
-
-      return TRUE;
-    }
-
-  return FALSE;
-}
-
 static gint
-calculate_link (GeglBuffer *gradient_map,
-                gint        x,
-                gint        y,
-                guint32     pixel,
-                gint        link)
+calculate_link (ISearch *search,
+                gint     from,
+                gint     to,
+                gint     link)
 {
   gint   value = 0;
-  guint8 grad1, dir1, grad2, dir2;
+  guint8 grad1, dir1, dir2;
 
-  if (! gradient_map_value (gradient_map, x, y, &grad1, &dir1))
-    {
-      grad1 = 0;
-      dir1 = 255;
-    }
+  grad1 = search->gradient[to   * COST_WIDTH];
+  dir1  = search->gradient[to   * COST_WIDTH + 1];
+  dir2  = search->gradient[from * COST_WIDTH + 1];
 
   /* Convert the gradient into a cost: large gradients are good, and
    * so have low cost. */
@@ -1647,15 +1677,6 @@ calculate_link (GeglBuffer *gradient_map,
     value += grad1 * OMEGA_G;
 
   /*  calculate the contribution of the gradient direction  */
-  x += (gint8)(pixel & 0xff);
-  y += (gint8)((pixel & 0xff00) >> 8);
-
-  if (! gradient_map_value (gradient_map, x, y, &grad2, &dir2))
-    {
-      grad2 = 0;
-      dir2 = 255;
-    }
-
   value +=
     (direction_value[dir1][link] + direction_value[dir2][link]) * OMEGA_D;
 
@@ -1664,24 +1685,20 @@ calculate_link (GeglBuffer *gradient_map,
 
 
 static GPtrArray *
-plot_pixels (GimpIscissorsTool *iscissors,
-             GimpTempBuf       *dp_buf,
-             gint               x1,
-             gint               y1,
-             gint               xs,
-             gint               ys,
-             gint               xe,
-             gint               ye)
+plot_pixels (ISearch *search,
+             gint     xe,
+             gint     ye)
 {
   gint       x, y;
   guint32    coords;
   gint       link;
-  gint       width = gimp_temp_buf_get_width (dp_buf);
-  guint     *data;
+  gint       width = search->area.width;
+  guint8    *data;
   GPtrArray *list;
 
   /*  Start the data pointer at the correct location  */
-  data = (guint *) gimp_temp_buf_get_data (dp_buf) + (ye - y1) * width + (xe - x1);
+  data = search->link +
+         (ye - search->area.y) * width + (xe - search->area.x);
 
   x = xe;
   y = ye;
@@ -1693,8 +1710,8 @@ plot_pixels (GimpIscissorsTool *iscissors,
       coords = (y << 16) + x;
       g_ptr_array_add (list, GINT_TO_POINTER (coords));
 
-      link = PIXEL_DIR (*data);
-      if (link == SEED_POINT)
+      link = LINK_DIR (*data);
+      if (link == SEED_POINT || link == UNREACHED)
         return list;
 
       x += move[link][0];
@@ -1707,146 +1724,146 @@ plot_pixels (GimpIscissorsTool *iscissors,
 }
 
 
-#define PACK(x, y)    ((((y) & 0xff) << 8) | ((x) & 0xff))
-#define OFFSET(pixel) ((gint8)((pixel) & 0xff) + \
-                       ((gint8)(((pixel) & 0xff00) >> 8)) * \
-                       gimp_temp_buf_get_width (dp_buf))
+static ISearch *
+isearch_new (GeglBuffer          *gradient_map,
+             const GeglRectangle *area,
+             gint                 xs,
+             gint                 ys)
+{
+  ISearch                  *search = g_slice_new0 (ISearch);
+  GimpTileHandlerIscissors *handler;
+  gsize                     n_pixels;
+
+  search->area = *area;
+  search->xs   = xs;
+  search->ys   = ys;
+
+  n_pixels = (gsize) area->width * area->height;
+
+  /*  compute the missing gradient tiles in parallel, then read the
+   *  whole area once, instead of sampling it pixel by pixel
+   */
+  handler = g_object_get_data (G_OBJECT (gradient_map),
+                               "gimp-tile-handler-iscissors");
+
+  gimp_tile_handler_iscissors_prepare (handler, gradient_map, area);
+
+  search->gradient = g_new (guint8, n_pixels * COST_WIDTH);
+
+  gegl_buffer_get (gradient_map, area, 1.0,
+                   gegl_buffer_get_format (gradient_map),
+                   search->gradient,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  search->cost = g_new (guint32, n_pixels);
+  search->link = g_new (guint8,  n_pixels);
+
+  memset (search->cost, 0xff,      n_pixels * sizeof (guint32));
+  memset (search->link, UNREACHED, n_pixels);
+
+  search->link[(ys - area->y) * area->width + (xs - area->x)] = SEED_POINT;
+
+  isearch_push (search, (ys - area->y) * area->width + (xs - area->x), 0);
+
+  return search;
+}
+
+static void
+isearch_free (ISearch *search)
+{
+  gint i;
+
+  for (i = 0; i < N_BUCKETS; i++)
+    {
+      if (search->buckets[i])
+        g_array_free (search->buckets[i], TRUE);
+    }
+
+  g_free (search->gradient);
+  g_free (search->cost);
+  g_free (search->link);
+
+  g_slice_free (ISearch, search);
+}
+
+static void
+isearch_push (ISearch *search,
+              gint     index,
+              guint32  cost)
+{
+  GArray **bucket = &search->buckets[cost & (N_BUCKETS - 1)];
+
+  if (! *bucket)
+    *bucket = g_array_new (FALSE, FALSE, sizeof (gint));
+
+  search->cost[index] = cost;
+
+  g_array_append_val (*bucket, index);
+  search->n_queued++;
+}
 
 static void
-find_optimal_path (GeglBuffer  *gradient_map,
-                   GimpTempBuf *dp_buf,
-                   gint         x1,
-                   gint         y1,
-                   gint         x2,
-                   gint         y2,
-                   gint         xs,
-                   gint         ys)
+isearch_run (ISearch *search,
+             gint     xe,
+             gint     ye)
 {
-  gint     i, j, k;
-  gint     x, y;
-  gint     link;
-  gint     linkdir;
-  gint     dirx, diry;
-  gint     min_cost;
-  gint     new_cost;
-  gint     offset;
-  gint     cum_cost[8];
-  gint     link_cost[8];
-  gint     pixel_cost[8];
-  guint32  pixel[8];
-  guint32 *data;
-  guint32 *d;
-  gint     dp_buf_width  = gimp_temp_buf_get_width  (dp_buf);
-  gint     dp_buf_height = gimp_temp_buf_get_height (dp_buf);
-
-  /*  initialize the dynamic programming buffer  */
-  data = (guint32 *) gimp_temp_buf_data_clear (dp_buf);
-
-  /*  what directions are we filling the array in according to?  */
-  dirx = (xs - x1 == 0) ? 1 : -1;
-  diry = (ys - y1 == 0) ? 1 : -1;
-  linkdir = (dirx * diry);
-
-  y = ys;
-
-  for (i = 0; i < dp_buf_height; i++)
+  gint width  = search->area.width;
+  gint height = search->area.height;
+  gint target = (ye - search->area.y) * width + (xe - search->area.x);
+
+  while (! (search->link[target] & SETTLED) && search->n_queued > 0)
     {
-      x = xs;
+      GArray *bucket = search->buckets[search->current & (N_BUCKETS - 1)];
+      gint    index;
+      gint    x, y;
+      gint    k;
+
+      if (! bucket || bucket->len == 0)
+        {
+          search->current++;
+          continue;
+        }
+
+      index = g_array_index (bucket, gint, bucket->len - 1);
+      g_array_set_size (bucket, bucket->len - 1);
+      search->n_queued--;
+
+      /*  skip entries superseded by a cheaper path to the pixel  */
+      if ((search->link[index] & SETTLED) ||
+          search->cost[index] != search->current)
+        continue;
+
+      search->link[index] |= SETTLED;
 
-      d = data + (y-y1) * dp_buf_width + (x-x1);
+      x = index % width;
+      y = index / width;
 
-      for (j = 0; j < dp_buf_width; j++)
+      for (k = 0; k < 8; k++)
         {
-          min_cost = G_MAXINT;
-
-          /* pixel[] array encodes how to get to a neighbour, if possible.
-           * 0 means no connection (eg edge).
-           * Rest packed as bottom two bytes: y offset then x offset.
-           * Initially, we assume we can't get anywhere.
-           */
-          for (k = 0; k < 8; k++)
-            pixel[k] = 0;
-
-          /*  Find the valid neighboring pixels  */
-          /*  the previous pixel  */
-          if (j)
-            pixel[((dirx == 1) ? 4 : 0)] = PACK (-dirx, 0);
-
-          /*  the previous row of pixels  */
-          if (i)
-            {
-              pixel[((diry == 1) ? 5 : 1)] = PACK (0, -diry);
+          gint    nx = x + move[k][0];
+          gint    ny = y + move[k][1];
+          gint    neighbor;
+          guint32 cost;
 
-              link = (linkdir == 1) ? 3 : 2;
-              if (j)
-                pixel[((diry == 1) ? (link + 4) : link)] = PACK (-dirx, -diry);
+          if (nx < 0 || nx >= width || ny < 0 || ny >= height)
+            continue;
 
-              link = (linkdir == 1) ? 2 : 3;
-              if (j != dp_buf_width - 1)
-                pixel[((diry == 1) ? (link + 4) : link)] = PACK (dirx, -diry);
-            }
+          neighbor = ny * width + nx;
 
-          /*  find the minimum cost of going through each neighbor to reach the
-           *  seed point...
-           */
-          link = -1;
-          for (k = 0; k < 8; k ++)
-            if (pixel[k])
-              {
-                link_cost[k] = calculate_link (gradient_map,
-                                               xs + j*dirx, ys + i*diry,
-                                               pixel [k],
-                                               ((k > 3) ? k - 4 : k));
-                offset = OFFSET (pixel [k]);
-                pixel_cost[k] = PIXEL_COST (d[offset]);
-                cum_cost[k] = pixel_cost[k] + link_cost[k];
-                if (cum_cost[k] < min_cost)
-                  {
-                    min_cost = cum_cost[k];
-                    link = k;
-                  }
-              }
-
-          /*  If anything can be done...  */
-          if (link >= 0)
-            {
-              /*  set the cumulative cost of this pixel and the new direction
-               */
-              *d = (cum_cost[link] << 8) + link;
-
-              /*  possibly change the links from the other pixels to this pixel...
-               *  these changes occur if a neighboring pixel will receive a lower
-               *  cumulative cost by going through this pixel.
-               */
-              for (k = 0; k < 8; k ++)
-                if (pixel[k] && k != link)
-                  {
-                    /*  if the cumulative cost at the neighbor is greater than
-                     *  the cost through the link to the current pixel, change the
-                     *  neighbor's link to point to the current pixel.
-                     */
-                    new_cost = link_cost[k] + cum_cost[link];
-                    if (pixel_cost[k] > new_cost)
-                    {
-                      /*  reverse the link direction   /--------------------\ */
-                      offset = OFFSET (pixel[k]);
-                      d[offset] = (new_cost << 8) + ((k > 3) ? k - 4 : k + 4);
-                    }
-                  }
-            }
-          /*  Set the seed point  */
-          else if (!i && !j)
+          if (search->link[neighbor] & SETTLED)
+            continue;
+
+          cost = search->current + calculate_link (search, index, neighbor,
+                                                   k & 3);
+
+          if (cost < search->cost[neighbor])
             {
-              *d = SEED_POINT;
-            }
+              /*  link back the way we came  */
+              search->link[neighbor] = (k + 4) & 7;
 
-          /*  increment the data pointer and the x counter  */
-          d += dirx;
-          x += dirx;
+              isearch_push (search, neighbor, cost);
+            }
         }
-
-      /*  increment the y counter  */
-      y += diry;
     }
 }
 
@@ -1866,6 +1883,11 @@ gradient_map_new (GimpImage *image)
   gimp_tile_handler_validate_assign (GIMP_TILE_HANDLER_VALIDATE (handler),
                                      buffer);
 
+  /*  for gimp_tile_handler_iscissors_prepare()  */
+  g_object_set_data_full (G_OBJECT (buffer), "gimp-tile-handler-iscissors",
+                          g_object_ref (handler),
+                          (GDestroyNotify) g_object_unref);
+
   gimp_tile_handler_validate_invalidate (GIMP_TILE_HANDLER_VALIDATE (handler),
                                          0, 0,
                                          gimp_image_get_width  (image),
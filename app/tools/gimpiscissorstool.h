@@ -45,6 +45,7 @@ typedef enum
 
 typedef struct _ISegment ISegment;
 typedef struct _ICurve   ICurve;
+typedef struct _ISearch  ISearch;
 
 
 #define GIMP_TYPE_ISCISSORS_TOOL            (gimp_iscissors_tool_get_type ())
@@ -79,7 +80,7 @@ struct _GimpIscissorsTool
   IscissorsState  state;        /*  state of iscissors                      */
 
   GeglBuffer     *gradient_map; /*  lazily filled gradient map              */
-  GimpTempBuf    *dp_buf;       /*  dynamic programming buffer              */
+  ISearch        *search[2];    /*  recent path searches, kept for reuse    */
   GimpChannel    *mask;         /*  selection mask                          */
 };
 
@@ -19,12 +19,15 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include <gegl.h>
 #include <gegl-plugin.h>
 #include <gtk/gtk.h>
 #include <gdk/gdkkeysyms.h>
 
 #include <npd/npd_common.h>
+#include <npd/deformation.h>
 
 #include "libgimpmath/gimpmath.h"
 #include "libgimpwidgets/gimpwidgets.h"
@@ -37,6 +40,7 @@
 #include "gegl/gimp-gegl-apply-operation.h"
 
 #include "core/gimp.h"
+#include "core/gimp-parallel.h"
 #include "core/gimpdrawable.h"
 #include "core/gimpimage.h"
 #include "core/gimpprogress.h"
@@ -61,6 +65,9 @@
 #define GIMP_NPD_MAXIMUM_DEFORMATION_DELAY 100000 /* 100000 microseconds == 10 FPS */
 #define GIMP_NPD_DRAW_INTERVAL                 50 /*     50 milliseconds == 20 FPS */
 
+#define MIN_PARALLEL_SUB_SIZE 64
+#define EPSILON               1e-6
+
 
 static void     gimp_n_point_deformation_tool_start                   (GimpNPointDeformationTool *npd_tool,
                                                                        GimpDisplay               *display);
@@ -124,9 +131,22 @@ static gboolean gimp_n_point_deformation_tool_is_cp_in_area           (NPDContro
 static void     gimp_n_point_deformation_tool_remove_cp_from_selection
                                                                       (GimpNPointDeformationTool *npd_tool,
                                                                        NPDControlPoint           *cp);
+static void     gimp_n_point_deformation_tool_start_threads           (GimpNPointDeformationTool *npd_tool);
 static gpointer gimp_n_point_deformation_tool_deform_thread_func      (gpointer                   data);
 static gboolean gimp_n_point_deformation_tool_canvas_update_timeout   (GimpNPointDeformationTool *npd_tool);
 static void     gimp_n_point_deformation_tool_perform_deformation     (GimpNPointDeformationTool *npd_tool);
+static void     gimp_n_point_deformation_tool_render_rows             (gint                       i,
+                                                                       gint                       n,
+                                                                       GimpNPointDeformationTool *npd_tool);
+static void     gimp_n_point_deformation_tool_render_triangle         (GimpNPointDeformationTool *npd_tool,
+                                                                       const NPDPoint            *current,
+                                                                       const NPDPoint            *reference,
+                                                                       gint                       a,
+                                                                       gint                       b,
+                                                                       gint                       c,
+                                                                       gint                       y1,
+                                                                       gint                       y2);
+static void     gimp_n_point_deformation_tool_invalidate_operation    (GimpNPointDeformationTool *npd_tool);
 static void     gimp_n_point_deformation_tool_halt_threads            (GimpNPointDeformationTool *npd_tool);
 static void     gimp_n_point_deformation_tool_apply_deformation       (GimpNPointDeformationTool *npd_tool);
 
@@ -234,9 +254,10 @@ gimp_n_point_deformation_tool_start (GimpNPointDeformationTool *npd_tool,
   GimpTool                     *tool = GIMP_TOOL (npd_tool);
   GimpNPointDeformationOptions *npd_options;
   GimpImage                    *image;
+  GimpDisplayShell             *shell;
   GeglBuffer                   *source_buffer;
-  GeglBuffer                   *preview_buffer;
   NPDModel                     *model;
+  gint                          width, height;
 
   npd_options = GIMP_N_POINT_DEFORMATION_TOOL_GET_OPTIONS (npd_tool);
 
@@ -252,9 +273,6 @@ gimp_n_point_deformation_tool_start (GimpNPointDeformationTool *npd_tool,
   /* create GEGL graph */
   source_buffer  = gimp_drawable_get_buffer (tool->drawable);
 
-  preview_buffer = gegl_buffer_new (gegl_buffer_get_extent (source_buffer),
-                                    babl_format ("cairo-ARGB32"));
-
   npd_tool->graph    = gegl_node_new ();
 
   npd_tool->source   = gegl_node_new_child (npd_tool->graph,
@@ -264,14 +282,9 @@ gimp_n_point_deformation_tool_start (GimpNPointDeformationTool *npd_tool,
   npd_tool->npd_node = gegl_node_new_child (npd_tool->graph,
                                             "operation", "gegl:npd",
                                             NULL);
-  npd_tool->sink     = gegl_node_new_child (npd_tool->graph,
-                                            "operation", "gegl:write-buffer",
-                                            "buffer",    preview_buffer,
-                                            NULL);
 
   gegl_node_link_many (npd_tool->source,
                        npd_tool->npd_node,
-                       npd_tool->sink,
                        NULL);
 
   /* initialize some options */
@@ -282,8 +295,34 @@ gimp_n_point_deformation_tool_start (GimpNPointDeformationTool *npd_tool,
   gegl_node_process (npd_tool->npd_node);
   gegl_node_get (npd_tool->npd_node, "model", &model, NULL);
 
+  /* until the commit, the drawable is only deformed at the display's
+   * resolution, from a copy that is scaled down once
+   */
+  shell = gimp_display_get_shell (display);
+
+  npd_tool->preview_scale  = MIN (shell->scale_x, 1.0);
+  npd_tool->preview_width  = width  =
+    MAX (1, ceil (gegl_buffer_get_width  (source_buffer) *
+                  npd_tool->preview_scale));
+  npd_tool->preview_height = height =
+    MAX (1, ceil (gegl_buffer_get_height (source_buffer) *
+                  npd_tool->preview_scale));
+
+  npd_tool->preview_source = g_new (guint32, (gsize) width * height);
+  npd_tool->preview_data   = g_new (guint32, (gsize) width * height);
+
+  gegl_buffer_get (source_buffer,
+                   GEGL_RECTANGLE (0, 0, width, height),
+                   npd_tool->preview_scale,
+                   babl_format ("cairo-ARGB32"),
+                   npd_tool->preview_source,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  npd_tool->preview_buffer =
+    gegl_buffer_new (GEGL_RECTANGLE (0, 0, width, height),
+                     babl_format ("cairo-ARGB32"));
+
   npd_tool->model          = model;
-  npd_tool->preview_buffer = preview_buffer;
   npd_tool->selected_cp    = NULL;
   npd_tool->hovering_cp    = NULL;
   npd_tool->selected_cps   = NULL;
@@ -303,19 +342,7 @@ gimp_n_point_deformation_tool_start (GimpNPointDeformationTool *npd_tool,
   gimp_item_set_visible (GIMP_ITEM (tool->drawable), FALSE, FALSE);
   gimp_image_flush (image);
 
-  /* create and start a deformation thread */
-  npd_tool->deform_thread =
-    g_thread_new ("deform thread",
-                  (GThreadFunc) gimp_n_point_deformation_tool_deform_thread_func,
-                  npd_tool);
-
-  /* create and start canvas update timeout */
-  npd_tool->draw_timeout_id =
-    gdk_threads_add_timeout_full (G_PRIORITY_DEFAULT_IDLE,
-                                  GIMP_NPD_DRAW_INTERVAL,
-                                  (GSourceFunc) gimp_n_point_deformation_tool_canvas_update_timeout,
-                                  npd_tool,
-                                  NULL);
+  gimp_n_point_deformation_tool_start_threads (npd_tool);
 }
 
 static void
@@ -373,7 +400,6 @@ gimp_n_point_deformation_tool_halt (GimpNPointDeformationTool *npd_tool)
       npd_tool->graph = NULL;
       npd_tool->source = NULL;
       npd_tool->npd_node = NULL;
-      npd_tool->sink = NULL;
     }
 
   if (npd_tool->preview_buffer)
@@ -382,6 +408,12 @@ gimp_n_point_deformation_tool_halt (GimpNPointDeformationTool *npd_tool)
       npd_tool->preview_buffer = NULL;
     }
 
+  g_free (npd_tool->preview_source);
+  npd_tool->preview_source = NULL;
+
+  g_free (npd_tool->preview_data);
+  npd_tool->preview_data = NULL;
+
   if (npd_tool->lattice_points)
     {
       g_free (npd_tool->lattice_points);
@@ -424,6 +456,21 @@ gimp_n_point_deformation_tool_options_notify (GimpTool         *tool,
   gimp_npd_debug (("npd options notify\n"));
   gimp_n_point_deformation_tool_set_options (npd_tool, npd_options);
 
+  /* the deformation mode only reaches the model when the operation
+   * runs, which it otherwise doesn't before the commit
+   */
+  if (! strcmp (pspec->name, "asap-deformation") ||
+      ! strcmp (pspec->name, "mls-weights")      ||
+      ! strcmp (pspec->name, "mls-weights-alpha"))
+    {
+      gimp_n_point_deformation_tool_halt_threads (npd_tool);
+
+      gimp_n_point_deformation_tool_invalidate_operation (npd_tool);
+      gegl_node_process (npd_tool->npd_node);
+
+      gimp_n_point_deformation_tool_start_threads (npd_tool);
+    }
+
   gimp_draw_tool_resume (draw_tool);
 }
 
@@ -849,7 +896,8 @@ gimp_n_point_deformation_tool_draw (GimpDrawTool *draw_tool)
       GimpCanvasItem *item;
 
       item = gimp_canvas_buffer_preview_new (gimp_display_get_shell (draw_tool->display),
-                                             npd_tool->preview_buffer);
+                                             npd_tool->preview_buffer,
+                                             npd_tool->preview_scale);
 
       gimp_draw_tool_add_preview (draw_tool, item);
       g_object_unref (item);
@@ -915,6 +963,26 @@ gimp_n_point_deformation_tool_canvas_update_timeout (GimpNPointDeformationTool *
   return TRUE;
 }
 
+static void
+gimp_n_point_deformation_tool_start_threads (GimpNPointDeformationTool *npd_tool)
+{
+  npd_tool->deformation_active = TRUE;
+
+  /* create and start a deformation thread */
+  npd_tool->deform_thread =
+    g_thread_new ("deform thread",
+                  (GThreadFunc) gimp_n_point_deformation_tool_deform_thread_func,
+                  npd_tool);
+
+  /* create and start canvas update timeout */
+  npd_tool->draw_timeout_id =
+    gdk_threads_add_timeout_full (G_PRIORITY_DEFAULT_IDLE,
+                                  GIMP_NPD_DRAW_INTERVAL,
+                                  (GSourceFunc) gimp_n_point_deformation_tool_canvas_update_timeout,
+                                  npd_tool,
+                                  NULL);
+}
+
 static gpointer
 gimp_n_point_deformation_tool_deform_thread_func (gpointer data)
 {
@@ -949,6 +1017,128 @@ gimp_n_point_deformation_tool_deform_thread_func (gpointer data)
 
 static void
 gimp_n_point_deformation_tool_perform_deformation (GimpNPointDeformationTool *npd_tool)
+{
+  GimpNPointDeformationOptions *npd_options;
+  gint                          width  = npd_tool->preview_width;
+  gint                          height = npd_tool->preview_height;
+
+  npd_options = GIMP_N_POINT_DEFORMATION_TOOL_GET_OPTIONS (npd_tool);
+
+  gimp_npd_debug (("npd_deform_model\n"));
+  npd_deform_model (npd_tool->model, npd_options->rigidity);
+
+  /* map the drawable through the deformed mesh, at the preview's
+   * resolution, and with the rows split between threads
+   */
+  memset (npd_tool->preview_data, 0, sizeof (guint32) * width * height);
+
+  gimp_parallel_distribute (MAX (height / MIN_PARALLEL_SUB_SIZE, 1),
+                            (GimpParallelDistributeFunc)
+                            gimp_n_point_deformation_tool_render_rows,
+                            npd_tool);
+
+  gegl_buffer_set (npd_tool->preview_buffer, NULL, 0,
+                   babl_format ("cairo-ARGB32"),
+                   npd_tool->preview_data, GEGL_AUTO_ROWSTRIDE);
+}
+
+static void
+gimp_n_point_deformation_tool_render_rows (gint                       i,
+                                           gint                       n,
+                                           GimpNPointDeformationTool *npd_tool)
+{
+  NPDHiddenModel *hm = npd_tool->model->hidden_model;
+  gint            y1 = (gint64) npd_tool->preview_height * i       / n;
+  gint            y2 = (gint64) npd_tool->preview_height * (i + 1) / n;
+  gint            j;
+
+  for (j = 0; j < hm->num_of_bones; j++)
+    {
+      const NPDPoint *current   = hm->current_bones[j].points;
+      const NPDPoint *reference = hm->reference_bones[j].points;
+
+      /* bones are quads, map them as two triangles */
+      gimp_n_point_deformation_tool_render_triangle (npd_tool,
+                                                     current, reference,
+                                                     0, 1, 2, y1, y2);
+      gimp_n_point_deformation_tool_render_triangle (npd_tool,
+                                                     current, reference,
+                                                     0, 2, 3, y1, y2);
+    }
+}
+
+static void
+gimp_n_point_deformation_tool_render_triangle (GimpNPointDeformationTool *npd_tool,
+                                               const NPDPoint            *current,
+                                               const NPDPoint            *reference,
+                                               gint                       a,
+                                               gint                       b,
+                                               gint                       c,
+                                               gint                       y1,
+                                               gint                       y2)
+{
+  gdouble  scale  = npd_tool->preview_scale;
+  gint     width  = npd_tool->preview_width;
+  gint     height = npd_tool->preview_height;
+  gdouble  x0, y0, dx1, dy1, dx2, dy2;
+  gdouble  u0, v0, du1, dv1, du2, dv2;
+  gdouble  det;
+  gint     min_x, max_x;
+  gint     min_y, max_y;
+  gint     x, y;
+
+  x0  = current[a].x * scale;
+  y0  = current[a].y * scale;
+  dx1 = current[b].x * scale - x0;
+  dy1 = current[b].y * scale - y0;
+  dx2 = current[c].x * scale - x0;
+  dy2 = current[c].y * scale - y0;
+
+  det = dx1 * dy2 - dx2 * dy1;
+
+  if (fabs (det) < EPSILON)
+    return;
+
+  u0  = reference[a].x * scale;
+  v0  = reference[a].y * scale;
+  du1 = reference[b].x * scale - u0;
+  dv1 = reference[b].y * scale - v0;
+  du2 = reference[c].x * scale - u0;
+  dv2 = reference[c].y * scale - v0;
+
+  min_x = MAX (floor (x0 + MIN (0.0, MIN (dx1, dx2))), 0);
+  max_x = MIN (ceil  (x0 + MAX (0.0, MAX (dx1, dx2))), width);
+  min_y = MAX (floor (y0 + MIN (0.0, MIN (dy1, dy2))), y1);
+  max_y = MIN (ceil  (y0 + MAX (0.0, MAX (dy1, dy2))), y2);
+
+  for (y = min_y; y < max_y; y++)
+    {
+      guint32 *dest = npd_tool->preview_data + (gsize) y * width;
+      gdouble  py   = y + 0.5 - y0;
+
+      for (x = min_x; x < max_x; x++)
+        {
+          gdouble px = x + 0.5 - x0;
+          gdouble l1 = (px * dy2 - dx2 * py) / det;
+          gdouble l2 = (dx1 * py - px * dy1) / det;
+          gint    u, v;
+
+          if (l1 < -EPSILON || l2 < -EPSILON || l1 + l2 > 1.0 + EPSILON)
+            continue;
+
+          u = u0 + l1 * du1 + l2 * du2;
+          v = v0 + l1 * dv1 + l2 * dv2;
+
+          u = CLAMP (u, 0, width  - 1);
+          v = CLAMP (v, 0, height - 1);
+
+          dest[x] = npd_tool->preview_source[(gsize) v * width + u];
+        }
+    }
+}
+
+static void
+gimp_n_point_deformation_tool_invalidate_operation (GimpNPointDeformationTool *npd_tool)
 {
   GObject *operation;
 
@@ -958,9 +1148,6 @@ gimp_n_point_deformation_tool_perform_deformation (GimpNPointDeformationTool *np
   gimp_npd_debug (("gegl_operation_invalidate\n"));
   gegl_operation_invalidate (GEGL_OPERATION (operation), NULL, FALSE);
   g_object_unref (operation);
-
-  gimp_npd_debug (("gegl_node_process\n"));
-  gegl_node_process (npd_tool->sink);
 }
 
 static void
@@ -1014,6 +1201,8 @@ gimp_n_point_deformation_tool_apply_deformation (GimpNPointDeformationTool *npd_
   gimp_drawable_push_undo (tool->drawable, _("N-Point Deformation"), NULL,
                            0, 0, width, height);
 
+  /* only now the drawable is deformed at full resolution */
+  gimp_n_point_deformation_tool_invalidate_operation (npd_tool);
 
   gimp_gegl_apply_operation (NULL, NULL, _("N-Point Deformation"),
                              npd_tool->npd_node,
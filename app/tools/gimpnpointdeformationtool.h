@@ -49,9 +49,13 @@ struct _GimpNPointDeformationTool
   GeglNode         *graph;
   GeglNode         *source;
   GeglNode         *npd_node;
-  GeglNode         *sink;
 
-  GeglBuffer       *preview_buffer;
+  GeglBuffer       *preview_buffer;  /* the deformed drawable, at the     */
+  gdouble           preview_scale;   /* display's resolution while the   */
+  gint              preview_width;   /* tool is active                   */
+  gint              preview_height;
+  guint32          *preview_source;  /* the drawable, scaled the same way */
+  guint32          *preview_data;
 
   NPDModel         *model;
   NPDControlPoint  *selected_cp;    /* last selected control point     */
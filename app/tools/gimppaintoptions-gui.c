@@ -243,6 +243,18 @@ gimp_paint_options_gui (GimpToolOptions *tool_options)
       gtk_widget_show (frame);
     }
 
+  /*  the "predict stroke" toggle  */
+  if (g_type_is_a (tool_type, GIMP_TYPE_PAINT_TOOL))
+    {
+      GtkWidget *button;
+
+      button = gimp_prop_check_button_new (config,
+                                           "predict-stroke",
+                                           _("Predict stroke"));
+      gtk_box_pack_start (GTK_BOX (vbox), button, FALSE, FALSE, 0);
+      gtk_widget_show (button);
+    }
+
   /*  the "Link size to zoom" toggle  */
   if (g_type_is_a (tool_type, GIMP_TYPE_BRUSH_TOOL))
     {
@@ -0,0 +1,270 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <gegl.h>
+#include <gtk/gtk.h>
+
+#include "tools-types.h"
+
+#include "core/gimpdrawable.h"
+#include "core/gimpimage.h"
+#include "core/gimpprojection.h"
+
+#include "paint/gimppaintcore.h"
+#include "paint/gimppaintoptions.h"
+
+#include "display/gimpdisplay.h"
+
+#include "gimppainttool.h"
+#include "gimppainttool-paint.h"
+
+
+/*  How often the strokes rasterized by the paint thread are shown  */
+#define PAINT_FLUSH_INTERVAL 20 /* milliseconds */
+
+
+/*  Motion events are queued by the main thread and rasterized by a
+ *  single paint thread, so sampling input never waits for painting.
+ *
+ *  paint_mutex is held by the paint thread while it paints, and by
+ *  the main thread while it shows what was painted so far; the
+ *  drawable's updates are deferred in between (see
+ *  gimp_drawable_start_paint()), so GimpDrawable::update is only
+ *  ever emitted on the main thread.
+ */
+
+typedef struct _PaintItem PaintItem;
+
+struct _PaintItem
+{
+  GimpPaintTool    *paint_tool;
+  GimpPaintOptions *paint_options;
+  GimpCoords        coords;
+  guint32           time;
+};
+
+
+/*  local function prototypes  */
+
+static gpointer   gimp_paint_tool_paint_thread  (gpointer       data);
+static gboolean   gimp_paint_tool_paint_timeout (GimpPaintTool *paint_tool);
+
+
+/*  private variables  */
+
+static GThread  *paint_thread;
+
+static GMutex    paint_mutex;
+static GCond     paint_cond;
+static gint      paint_timeout_pending;
+
+static GMutex    paint_queue_mutex;
+static GCond     paint_queue_cond;
+static GCond     paint_idle_cond;
+static GQueue    paint_queue = G_QUEUE_INIT;
+static gint      paint_n_pending;
+
+
+/*  public functions  */
+
+void
+gimp_paint_tool_paint_start (GimpPaintTool *paint_tool,
+                             GimpDisplay   *display,
+                             GimpDrawable  *drawable)
+{
+  g_return_if_fail (GIMP_IS_PAINT_TOOL (paint_tool));
+  g_return_if_fail (GIMP_IS_DISPLAY (display));
+  g_return_if_fail (GIMP_IS_DRAWABLE (drawable));
+  g_return_if_fail (paint_tool->paint_drawable == NULL);
+
+  if (! paint_tool->paint_threaded)
+    return;
+
+  if (! paint_thread)
+    paint_thread = g_thread_new ("paint",
+                                 gimp_paint_tool_paint_thread, NULL);
+
+  paint_tool->paint_display  = display;
+  paint_tool->paint_drawable = drawable;
+
+  gimp_drawable_start_paint (drawable);
+
+  paint_tool->paint_timeout_id =
+    g_timeout_add (PAINT_FLUSH_INTERVAL,
+                   (GSourceFunc) gimp_paint_tool_paint_timeout,
+                   paint_tool);
+}
+
+void
+gimp_paint_tool_paint_end (GimpPaintTool *paint_tool)
+{
+  g_return_if_fail (GIMP_IS_PAINT_TOOL (paint_tool));
+
+  if (! paint_tool->paint_drawable)
+    return;
+
+  gimp_paint_tool_paint_sync (paint_tool);
+
+  g_source_remove (paint_tool->paint_timeout_id);
+  paint_tool->paint_timeout_id = 0;
+
+  gimp_drawable_end_paint (paint_tool->paint_drawable);
+
+  paint_tool->paint_display  = NULL;
+  paint_tool->paint_drawable = NULL;
+}
+
+/*  Returns whether the current stroke is painted by the paint thread  */
+gboolean
+gimp_paint_tool_paint_is_active (GimpPaintTool *paint_tool)
+{
+  g_return_val_if_fail (GIMP_IS_PAINT_TOOL (paint_tool), FALSE);
+
+  return paint_tool->paint_drawable != NULL;
+}
+
+/*  Queues interpolating the stroke to @coords, which are in the
+ *  drawable's coordinate space
+ */
+void
+gimp_paint_tool_paint_push (GimpPaintTool    *paint_tool,
+                            GimpPaintOptions *paint_options,
+                            const GimpCoords *coords,
+                            guint32           time)
+{
+  PaintItem *item;
+
+  g_return_if_fail (GIMP_IS_PAINT_TOOL (paint_tool));
+  g_return_if_fail (GIMP_IS_PAINT_OPTIONS (paint_options));
+  g_return_if_fail (coords != NULL);
+  g_return_if_fail (paint_tool->paint_drawable != NULL);
+
+  item = g_slice_new (PaintItem);
+
+  item->paint_tool    = paint_tool;
+  item->paint_options = paint_options;
+  item->coords        = *coords;
+  item->time          = time;
+
+  g_mutex_lock (&paint_queue_mutex);
+
+  g_queue_push_tail (&paint_queue, item);
+  paint_n_pending++;
+
+  g_cond_signal (&paint_queue_cond);
+
+  g_mutex_unlock (&paint_queue_mutex);
+}
+
+/*  Waits until the paint thread has painted all queued motion, call
+ *  this before touching the paint core from the main thread during a
+ *  stroke.
+ */
+void
+gimp_paint_tool_paint_sync (GimpPaintTool *paint_tool)
+{
+  g_return_if_fail (GIMP_IS_PAINT_TOOL (paint_tool));
+
+  if (! paint_tool->paint_drawable)
+    return;
+
+  g_mutex_lock (&paint_queue_mutex);
+
+  while (paint_n_pending > 0)
+    g_cond_wait (&paint_idle_cond, &paint_queue_mutex);
+
+  g_mutex_unlock (&paint_queue_mutex);
+}
+
+
+/*  private functions  */
+
+static gpointer
+gimp_paint_tool_paint_thread (gpointer data)
+{
+  g_mutex_lock (&paint_queue_mutex);
+
+  while (TRUE)
+    {
+      PaintItem     *item;
+      GimpPaintTool *paint_tool;
+
+      while (! (item = g_queue_pop_head (&paint_queue)))
+        g_cond_wait (&paint_queue_cond, &paint_queue_mutex);
+
+      g_mutex_unlock (&paint_queue_mutex);
+
+      paint_tool = item->paint_tool;
+
+      g_mutex_lock (&paint_mutex);
+
+      /*  let a pending flush go first, so the display keeps up  */
+      while (g_atomic_int_get (&paint_timeout_pending))
+        g_cond_wait (&paint_cond, &paint_mutex);
+
+      gimp_paint_core_interpolate (paint_tool->core,
+                                   paint_tool->paint_drawable,
+                                   item->paint_options,
+                                   &item->coords,
+                                   item->time);
+
+      g_mutex_unlock (&paint_mutex);
+
+      g_slice_free (PaintItem, item);
+
+      g_mutex_lock (&paint_queue_mutex);
+
+      paint_n_pending--;
+
+      if (paint_n_pending == 0)
+        g_cond_broadcast (&paint_idle_cond);
+    }
+
+  return NULL;
+}
+
+static gboolean
+gimp_paint_tool_paint_timeout (GimpPaintTool *paint_tool)
+{
+  GimpDrawTool *draw_tool = GIMP_DRAW_TOOL (paint_tool);
+  GimpImage    *image;
+
+  image = gimp_item_get_image (GIMP_ITEM (paint_tool->paint_drawable));
+
+  g_atomic_int_set (&paint_timeout_pending, TRUE);
+
+  g_mutex_lock (&paint_mutex);
+
+  if (gimp_drawable_flush_paint (paint_tool->paint_drawable))
+    {
+      gimp_draw_tool_pause (draw_tool);
+
+      gimp_projection_flush_now (gimp_image_get_projection (image));
+      gimp_display_flush_now (paint_tool->paint_display);
+
+      gimp_draw_tool_resume (draw_tool);
+    }
+
+  g_atomic_int_set (&paint_timeout_pending, FALSE);
+  g_cond_signal (&paint_cond);
+
+  g_mutex_unlock (&paint_mutex);
+
+  return G_SOURCE_CONTINUE;
+}
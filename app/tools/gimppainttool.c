@@ -38,6 +38,7 @@
 
 #include "paint/gimppaintcore.h"
 #include "paint/gimppaintoptions.h"
+#include "paint/gimppaintrecord.h"
 
 #include "widgets/gimpdevices.h"
 #include "widgets/gimpwidgets-utils.h"
@@ -45,9 +46,11 @@
 #include "display/gimpdisplay.h"
 #include "display/gimpdisplayshell.h"
 #include "display/gimpdisplayshell-selection.h"
+#include "display/gimpmotionbuffer.h"
 
 #include "gimpcoloroptions.h"
 #include "gimppainttool.h"
+#include "gimppainttool-paint.h"
 #include "gimptoolcontrol.h"
 
 #include "gimp-intl.h"
@@ -99,6 +102,11 @@ static GimpCanvasItem *
                                               gdouble                x,
                                               gdouble                y);
 
+static void   gimp_paint_tool_update_prediction
+                                             (GimpPaintTool         *paint_tool,
+                                              GimpPaintOptions      *paint_options,
+                                              GimpDisplay           *display);
+
 static void   gimp_paint_tool_hard_notify    (GimpPaintOptions      *options,
                                               const GParamSpec      *pspec,
                                               GimpTool              *tool);
@@ -106,11 +114,27 @@ static void   gimp_paint_tool_cursor_notify  (GimpDisplayConfig     *config,
                                               GParamSpec            *pspec,
                                               GimpPaintTool         *paint_tool);
 
+static void   gimp_paint_tool_record_event   (const GimpCoords      *coords,
+                                              guint32                time,
+                                              gboolean               new_stroke);
+static void   gimp_paint_tool_record_save    (void);
+
 
 G_DEFINE_TYPE (GimpPaintTool, gimp_paint_tool, GIMP_TYPE_COLOR_TOOL)
 
 #define parent_class gimp_paint_tool_parent_class
 
+/*  how far ahead of the last motion event the stroke preview reaches,
+ *  about the time it takes for painted dabs to show on the canvas
+ */
+#define PREDICTION_TIME 33.0 /* milliseconds */
+
+
+/*  the strokes of all paint tools, recorded when GIMP_PAINT_RECORD
+ *  names a file to save them to
+ */
+static GimpPaintRecord *paint_record = NULL;
+
 
 static void
 gimp_paint_tool_class_init (GimpPaintToolClass *klass)
@@ -158,6 +182,8 @@ gimp_paint_tool_init (GimpPaintTool *paint_tool)
   paint_tool->status_ctrl = _("%s to pick a color");
 
   paint_tool->core        = NULL;
+
+  paint_tool->paint_threaded = TRUE;
 }
 
 static void
@@ -229,6 +255,7 @@ gimp_paint_tool_control (GimpTool       *tool,
       break;
 
     case GIMP_TOOL_ACTION_HALT:
+      gimp_paint_tool_paint_end (paint_tool);
       gimp_paint_core_cleanup (paint_tool->core);
       break;
 
@@ -359,6 +386,8 @@ gimp_paint_tool_button_press (GimpTool            *tool,
     }
   else
     {
+      gimp_paint_tool_record_event (&curr_coords, time, TRUE);
+
       gimp_paint_core_paint (core, drawable, paint_options,
                              GIMP_PAINT_STATE_MOTION, time);
     }
@@ -366,7 +395,12 @@ gimp_paint_tool_button_press (GimpTool            *tool,
   gimp_projection_flush_now (gimp_image_get_projection (image));
   gimp_display_flush_now (display);
 
+  paint_tool->draw_prediction = FALSE;
+
   gimp_draw_tool_start (draw_tool, display);
+
+  /*  rasterize the rest of the stroke in the paint thread  */
+  gimp_paint_tool_paint_start (paint_tool, display, drawable);
 }
 
 static void
@@ -392,8 +426,13 @@ gimp_paint_tool_button_release (GimpTool              *tool,
       return;
     }
 
+  /*  wait for the paint thread to finish the stroke  */
+  gimp_paint_tool_paint_end (paint_tool);
+
   gimp_draw_tool_pause (GIMP_DRAW_TOOL (tool));
 
+  paint_tool->draw_prediction = FALSE;
+
   /*  Let the specific painting function finish up  */
   gimp_paint_core_paint (core, drawable, paint_options,
                          GIMP_PAINT_STATE_FINISH, time);
@@ -412,6 +451,8 @@ gimp_paint_tool_button_release (GimpTool              *tool,
 
   gimp_image_flush (image);
 
+  gimp_paint_tool_record_save ();
+
   gimp_draw_tool_resume (GIMP_DRAW_TOOL (tool));
 }
 
@@ -447,12 +488,36 @@ gimp_paint_tool_motion (GimpTool         *tool,
   /*  don't paint while the Shift key is pressed for line drawing  */
   if (paint_tool->draw_line)
     {
+      gimp_paint_tool_paint_sync (paint_tool);
+
       gimp_paint_core_set_current_coords (core, &curr_coords);
       return;
     }
 
+  gimp_paint_tool_record_event (&curr_coords, time, FALSE);
+
+  if (gimp_paint_tool_paint_is_active (paint_tool))
+    {
+      gimp_paint_tool_paint_push (paint_tool, paint_options,
+                                  &curr_coords, time);
+
+      if (paint_options->predict_stroke)
+        {
+          gimp_draw_tool_pause (GIMP_DRAW_TOOL (tool));
+
+          gimp_paint_tool_update_prediction (paint_tool, paint_options,
+                                             display);
+
+          gimp_draw_tool_resume (GIMP_DRAW_TOOL (tool));
+        }
+
+      return;
+    }
+
   gimp_draw_tool_pause (GIMP_DRAW_TOOL (tool));
 
+  gimp_paint_tool_update_prediction (paint_tool, paint_options, display);
+
   gimp_paint_core_interpolate (core, drawable, paint_options,
                                &curr_coords, time);
 
@@ -783,6 +848,32 @@ gimp_paint_tool_draw (GimpDrawTool *draw_tool)
           line_drawn = TRUE;
         }
 
+      if (paint_tool->draw_prediction &&
+          gimp_tool_control_is_active (GIMP_TOOL (draw_tool)->control))
+        {
+          GimpCanvasItem *prediction;
+          gdouble         prediction_x = paint_tool->prediction_coords.x;
+          gdouble         prediction_y = paint_tool->prediction_coords.y;
+
+          /*  a cheap preview of the part of the stroke that is not
+           *  painted yet, the next redraw replaces it by the real dabs
+           */
+          gimp_draw_tool_add_line (draw_tool,
+                                   cur_x, cur_y,
+                                   prediction_x, prediction_y);
+
+          prediction = gimp_paint_tool_get_outline (paint_tool,
+                                                    draw_tool->display,
+                                                    prediction_x,
+                                                    prediction_y);
+
+          if (prediction)
+            {
+              gimp_draw_tool_add_item (draw_tool, prediction);
+              g_object_unref (prediction);
+            }
+        }
+
       gimp_paint_tool_set_draw_fallback (paint_tool, FALSE, 0.0);
 
       if (paint_tool->draw_brush)
@@ -888,6 +979,20 @@ gimp_paint_tool_get_outline (GimpPaintTool *paint_tool,
   return NULL;
 }
 
+static void
+gimp_paint_tool_update_prediction (GimpPaintTool    *paint_tool,
+                                   GimpPaintOptions *paint_options,
+                                   GimpDisplay      *display)
+{
+  GimpDisplayShell *shell = gimp_display_get_shell (display);
+
+  paint_tool->draw_prediction =
+    (paint_options->predict_stroke &&
+     gimp_motion_buffer_predict_coords (shell->motion_buffer,
+                                        PREDICTION_TIME,
+                                        &paint_tool->prediction_coords));
+}
+
 static void
 gimp_paint_tool_hard_notify (GimpPaintOptions *options,
                              const GParamSpec *pspec,
@@ -954,3 +1059,47 @@ gimp_paint_tool_set_draw_circle (GimpPaintTool *tool,
   tool->draw_circle = draw_circle;
   tool->circle_size = circle_size;
 }
+
+static void
+gimp_paint_tool_record_event (const GimpCoords *coords,
+                              guint32           time,
+                              gboolean          new_stroke)
+{
+  if (new_stroke)
+    {
+      if (! g_getenv ("GIMP_PAINT_RECORD"))
+        return;
+
+      if (! paint_record)
+        paint_record = gimp_paint_record_new ();
+
+      gimp_paint_record_begin_stroke (paint_record);
+    }
+
+  if (paint_record)
+    gimp_paint_record_add_event (paint_record, coords, time);
+}
+
+static void
+gimp_paint_tool_record_save (void)
+{
+  const gchar *filename = g_getenv ("GIMP_PAINT_RECORD");
+  GFile       *file;
+  GError      *error = NULL;
+
+  if (! paint_record || ! filename)
+    return;
+
+  /*  rewrite the whole record after each stroke, so it is complete
+   *  whenever GIMP is quit
+   */
+  file = g_file_new_for_path (filename);
+
+  if (! gimp_paint_record_save (paint_record, file, &error))
+    {
+      g_printerr ("Saving the paint record failed: %s\n", error->message);
+      g_clear_error (&error);
+    }
+
+  g_object_unref (file);
+}
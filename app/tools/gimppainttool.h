@@ -47,12 +47,19 @@ struct _GimpPaintTool
   gint           fallback_size;
   gboolean       draw_circle;
   gint           circle_size;
+  gboolean       draw_prediction;
+  GimpCoords     prediction_coords; /* in image coordinates */
 
   const gchar   *status;       /* status message */
   const gchar   *status_line;  /* status message when drawing a line */
   const gchar   *status_ctrl;  /* additional message for the ctrl modifier */
 
   GimpPaintCore *core;
+
+  gboolean       paint_threaded; /* rasterize strokes in the paint thread */
+  guint          paint_timeout_id;
+  GimpDisplay   *paint_display;
+  GimpDrawable  *paint_drawable;
 };
 
 struct _GimpPaintToolClass
@@ -20,15 +20,17 @@
 #include "config.h"
 
 #include <gegl.h>
-#include <gegl-plugin.h> /* gegl_operation_invalidate() */
 #include <gtk/gtk.h>
 #include <gdk/gdkkeysyms.h>
 
 #include "libgimpbase/gimpbase.h"
+#include "libgimpmath/gimpmath.h"
 #include "libgimpwidgets/gimpwidgets.h"
 
 #include "tools-types.h"
 
+#include "gegl/gimp-gegl-apply-operation.h"
+
 #include "core/gimp.h"
 #include "core/gimpbuffer.h"
 #include "core/gimpimage.h"
@@ -62,6 +64,9 @@
 #define sc_debug_fend()
 #endif
 
+/*  while dragging, the paste is cloned at a size of at most this  */
+#define PREVIEW_MAX_PIXELS (512 * 512)
+
 #define gimp_seamless_clone_tool_is_in_paste(sc,x0,y0)          \
   (   ((sc)->xoff <= (x0) && (x0) < (sc)->xoff + (sc)->width)   \
    && ((sc)->yoff <= (y0) && (y0) < (sc)->yoff + (sc)->height)) \
@@ -158,12 +163,14 @@ static void       gimp_seamless_clone_tool_stop               (GimpSeamlessClone
 static void       gimp_seamless_clone_tool_commit             (GimpSeamlessCloneTool *sc);
 
 static void       gimp_seamless_clone_tool_create_render_node (GimpSeamlessCloneTool *sc);
-static gboolean   gimp_seamless_clone_tool_render_node_update (GimpSeamlessCloneTool *sc);
+static gboolean   gimp_seamless_clone_tool_render_node_update (GimpSeamlessCloneTool *sc,
+                                                               GeglRectangle         *area);
 static void       gimp_seamless_clone_tool_create_image_map   (GimpSeamlessCloneTool *sc,
                                                                GimpDrawable          *drawable);
 static void       gimp_seamless_clone_tool_image_map_flush    (GimpImageMap          *image_map,
                                                                GimpTool              *tool);
-static void       gimp_seamless_clone_tool_image_map_update   (GimpSeamlessCloneTool *sc);
+static void       gimp_seamless_clone_tool_image_map_update   (GimpSeamlessCloneTool *sc,
+                                                               const GeglRectangle   *area);
 
 
 G_DEFINE_TYPE (GimpSeamlessCloneTool, gimp_seamless_clone_tool,
@@ -347,8 +354,11 @@ gimp_seamless_clone_tool_stop (GimpSeamlessCloneTool *sc,
       if (sc->render_node)
         {
           g_object_unref (sc->render_node);
-          sc->render_node = NULL;
-          sc->sc_node     = NULL;
+          sc->render_node       = NULL;
+          sc->sc_node           = NULL;
+          sc->preview_sc_node   = NULL;
+          sc->preview_crop_node = NULL;
+          sc->overlay_node      = NULL;
         }
     }
 
@@ -394,6 +404,7 @@ gimp_seamless_clone_tool_button_press (GimpTool            *tool,
                                        GimpDisplay         *display)
 {
   GimpSeamlessCloneTool *sc = GIMP_SEAMLESS_CLONE_TOOL (tool);
+  GeglRectangle          area;
 
   if (display != tool->display)
     {
@@ -423,9 +434,9 @@ gimp_seamless_clone_tool_button_press (GimpTool            *tool,
 
       gimp_draw_tool_resume (GIMP_DRAW_TOOL (tool));
 
-      if (gimp_seamless_clone_tool_render_node_update (sc))
+      if (gimp_seamless_clone_tool_render_node_update (sc, &area))
         {
-          gimp_seamless_clone_tool_image_map_update (sc);
+          gimp_seamless_clone_tool_image_map_update (sc, &area);
         }
 
       sc->tool_state = SC_STATE_RENDER_MOTION;
@@ -446,6 +457,7 @@ gimp_seamless_clone_tool_button_release (GimpTool              *tool,
                                          GimpDisplay           *display)
 {
   GimpSeamlessCloneTool *sc = GIMP_SEAMLESS_CLONE_TOOL (tool);
+  GeglRectangle          area;
 
   gimp_tool_control_halt (tool->control);
 
@@ -467,12 +479,13 @@ gimp_seamless_clone_tool_button_release (GimpTool              *tool,
 
       gimp_draw_tool_resume (GIMP_DRAW_TOOL (tool));
 
-      if (gimp_seamless_clone_tool_render_node_update (sc))
+      /* Leaving the motion state switches back to the full size clone */
+      sc->tool_state = SC_STATE_RENDER_WAIT;
+
+      if (gimp_seamless_clone_tool_render_node_update (sc, &area))
         {
-          gimp_seamless_clone_tool_image_map_update (sc);
+          gimp_seamless_clone_tool_image_map_update (sc, &area);
         }
-
-      sc->tool_state = SC_STATE_RENDER_WAIT;
     }
 }
 
@@ -484,6 +497,7 @@ gimp_seamless_clone_tool_motion (GimpTool         *tool,
                                  GimpDisplay      *display)
 {
   GimpSeamlessCloneTool *sc = GIMP_SEAMLESS_CLONE_TOOL (tool);
+  GeglRectangle          area;
 
   if (sc->tool_state == SC_STATE_RENDER_MOTION)
     {
@@ -494,9 +508,9 @@ gimp_seamless_clone_tool_motion (GimpTool         *tool,
 
       gimp_draw_tool_resume (GIMP_DRAW_TOOL (tool));
 
-      if (gimp_seamless_clone_tool_render_node_update (sc))
+      if (gimp_seamless_clone_tool_render_node_update (sc, &area))
         {
-          gimp_seamless_clone_tool_image_map_update (sc);
+          gimp_seamless_clone_tool_image_map_update (sc, &area);
         }
     }
 }
@@ -507,6 +521,7 @@ gimp_seamless_clone_tool_key_press (GimpTool    *tool,
                                     GimpDisplay *display)
 {
   GimpSeamlessCloneTool *sct = GIMP_SEAMLESS_CLONE_TOOL (tool);
+  GeglRectangle          area;
 
   if (sct->tool_state == SC_STATE_RENDER_MOTION ||
       sct->tool_state == SC_STATE_RENDER_WAIT)
@@ -516,6 +531,12 @@ gimp_seamless_clone_tool_key_press (GimpTool    *tool,
         case GDK_KEY_Return:
         case GDK_KEY_KP_Enter:
         case GDK_KEY_ISO_Enter:
+          /* Don't commit the reduced size clone of a drag */
+          sct->tool_state = SC_STATE_RENDER_WAIT;
+
+          if (gimp_seamless_clone_tool_render_node_update (sct, &area))
+            gimp_seamless_clone_tool_image_map_update (sct, &area);
+
           gimp_tool_control_set_preserve (tool->control, TRUE);
 
           /* TODO: there may be issues with committing the image map
@@ -604,6 +625,7 @@ gimp_seamless_clone_tool_options_notify (GimpTool         *tool,
                                          const GParamSpec *pspec)
 {
   GimpSeamlessCloneTool *sc = GIMP_SEAMLESS_CLONE_TOOL (tool);
+  GeglRectangle          area;
 
   GIMP_TOOL_CLASS (parent_class)->options_notify (tool, options, pspec);
 
@@ -614,9 +636,9 @@ gimp_seamless_clone_tool_options_notify (GimpTool         *tool,
 
   if (! strcmp (pspec->name, "max-refine-steps"))
     {
-      if (gimp_seamless_clone_tool_render_node_update (sc))
+      if (gimp_seamless_clone_tool_render_node_update (sc, &area))
         {
-          gimp_seamless_clone_tool_image_map_update (sc);
+          gimp_seamless_clone_tool_image_map_update (sc, &area);
         }
     }
 
@@ -665,11 +687,19 @@ gimp_seamless_clone_tool_create_render_node (GimpSeamlessCloneTool *sc)
    * |    |input                   |
    * +----+------------------------+
    *   <output>
+   *
+   * For large pastes, there is a second <seamless-paste-render> that
+   * works on a scaled down drawable and paste, and whose scaled up
+   * output is used instead while the paste is dragged. Both of them
+   * keep their own preprocessing of the paste, which depends only on
+   * the paste and not on its position, so neither is set up again
+   * when the paste moves.
    */
   GimpSeamlessCloneOptions *options = GIMP_SEAMLESS_CLONE_TOOL_GET_OPTIONS (sc);
   GeglNode *node;
   GeglNode *op, *paste, *overlay;
   GeglNode *input, *output;
+  gint      n_pixels;
 
   node = gegl_node_new ();
 
@@ -705,43 +735,167 @@ gimp_seamless_clone_tool_create_render_node (GimpSeamlessCloneTool *sc)
   gegl_node_connect_to (overlay, "output",
                         output,  "input");
 
-  sc->render_node = node;
-  sc->sc_node     = op;
+  sc->render_node       = node;
+  sc->sc_node           = op;
+  sc->overlay_node      = overlay;
+  sc->preview_sc_node   = NULL;
+  sc->preview_crop_node = NULL;
+  sc->preview_scale     = 1.0;
+
+  n_pixels = sc->width * sc->height;
+
+  if (n_pixels > PREVIEW_MAX_PIXELS)
+    {
+      GeglBuffer *small_paste;
+      GeglNode   *small_input;
+      GeglNode   *scale_up;
+
+      sc->preview_scale = sqrt ((gdouble) PREVIEW_MAX_PIXELS /
+                                (gdouble) n_pixels);
+
+      small_paste =
+        gegl_buffer_new (GEGL_RECTANGLE (0, 0,
+                                         ceil (sc->width  * sc->preview_scale),
+                                         ceil (sc->height * sc->preview_scale)),
+                         gegl_buffer_get_format (sc->paste));
+
+      gimp_gegl_apply_scale (sc->paste, NULL, NULL, small_paste,
+                             GIMP_INTERPOLATION_LINEAR,
+                             sc->preview_scale, sc->preview_scale,
+                             TRUE);
+
+      paste = gegl_node_new_child (node,
+                                   "operation", "gegl:buffer-source",
+                                   "buffer",    small_paste,
+                                   NULL);
+      g_object_unref (small_paste);
+
+      small_input = gegl_node_new_child (node,
+                                         "operation", "gegl:scale-ratio",
+                                         "origin-x",  0.0,
+                                         "origin-y",  0.0,
+                                         "sampler",   GEGL_SAMPLER_LINEAR,
+                                         "x",         sc->preview_scale,
+                                         "y",         sc->preview_scale,
+                                         NULL);
+
+      op = gegl_node_new_child (node,
+                                "operation",         "gegl:seamless-clone",
+                                "max-refine-steps",  options->max_refine_steps,
+                                NULL);
+
+      scale_up = gegl_node_new_child (node,
+                                      "operation", "gegl:scale-ratio",
+                                      "origin-x",  0.0,
+                                      "origin-y",  0.0,
+                                      "sampler",   GEGL_SAMPLER_LINEAR,
+                                      "x",         1.0 / sc->preview_scale,
+                                      "y",         1.0 / sc->preview_scale,
+                                      NULL);
+
+      sc->preview_crop_node = gegl_node_new_child (node,
+                                                   "operation", "gegl:crop",
+                                                   NULL);
+
+      gegl_node_link_many (input, small_input, op, scale_up,
+                           sc->preview_crop_node, NULL);
+
+      gegl_node_connect_to (paste, "output",
+                            op,    "aux");
+
+      sc->preview_sc_node = op;
+    }
 }
 
 /* gimp_seamless_clone_tool_render_node_update:
  * sc: the Seamless Clone tool whose render has to be updated.
+ * area: returns the part of the drawable which has to be re-rendered.
  *
  * Returns: TRUE if any property changed.
  */
 static gboolean
-gimp_seamless_clone_tool_render_node_update (GimpSeamlessCloneTool *sc)
+gimp_seamless_clone_tool_render_node_update (GimpSeamlessCloneTool *sc,
+                                             GeglRectangle         *area)
 {
-  static gint rendered__max_refine_steps = -1;
-  static gint rendered_xoff              = G_MAXINT;
-  static gint rendered_yoff              = G_MAXINT;
-
   GimpSeamlessCloneOptions *options = GIMP_SEAMLESS_CLONE_TOOL_GET_OPTIONS (sc);
   GimpDrawable *bg = GIMP_TOOL (sc)->drawable;
   gint          off_x, off_y;
+  gboolean      preview;
+  GeglRectangle rect;
+
+  /* Clone at the reduced size only while dragging */
+  preview = (sc->tool_state == SC_STATE_RENDER_MOTION &&
+             sc->preview_sc_node != NULL);
 
   /* All properties stay the same. No need to update. */
-  if (rendered__max_refine_steps == options->max_refine_steps &&
-      rendered_xoff == sc->xoff                               &&
-      rendered_yoff == sc->yoff)
+  if (sc->rendered_max_refine_steps == options->max_refine_steps &&
+      sc->rendered_xoff             == sc->xoff                  &&
+      sc->rendered_yoff             == sc->yoff                  &&
+      sc->rendered_preview          == preview)
     return FALSE;
 
   gimp_item_get_offset (GIMP_ITEM (bg), &off_x, &off_y);
 
-  gegl_node_set (sc->sc_node,
-                 "xoff", (gint) sc->xoff - off_x,
-                 "yoff", (gint) sc->yoff - off_y,
-                 "max-refine-steps", (gint) options->max_refine_steps,
-                 NULL);
+  rect.x      = sc->xoff - off_x;
+  rect.y      = sc->yoff - off_y;
+  rect.width  = sc->width;
+  rect.height = sc->height;
+
+  if (preview)
+    {
+      gegl_node_set (sc->preview_sc_node,
+                     "xoff", (gint) RINT (rect.x * sc->preview_scale),
+                     "yoff", (gint) RINT (rect.y * sc->preview_scale),
+                     "max-refine-steps", (gint) options->max_refine_steps,
+                     NULL);
+
+      gegl_node_set (sc->preview_crop_node,
+                     "x",      (gdouble) rect.x,
+                     "y",      (gdouble) rect.y,
+                     "width",  (gdouble) rect.width,
+                     "height", (gdouble) rect.height,
+                     NULL);
+    }
+  else
+    {
+      gegl_node_set (sc->sc_node,
+                     "xoff", (gint) rect.x,
+                     "yoff", (gint) rect.y,
+                     "max-refine-steps", (gint) options->max_refine_steps,
+                     NULL);
+    }
+
+  if (preview != sc->rendered_preview)
+    gegl_node_connect_to (preview ? sc->preview_crop_node : sc->sc_node,
+                          "output",
+                          sc->overlay_node, "input");
 
-  rendered__max_refine_steps = options->max_refine_steps;
-  rendered_xoff              = sc->xoff;
-  rendered_yoff              = sc->yoff;
+  /* Outside of the paste the drawable stays as it is, so only the old
+   * and the new location of the paste need to be rendered again
+   */
+  if (sc->rendered_max_refine_steps < 0)
+    {
+      area->x      = 0;
+      area->y      = 0;
+      area->width  = gimp_item_get_width  (GIMP_ITEM (bg));
+      area->height = gimp_item_get_height (GIMP_ITEM (bg));
+    }
+  else
+    {
+      GeglRectangle old_rect;
+
+      old_rect.x      = sc->rendered_xoff - off_x;
+      old_rect.y      = sc->rendered_yoff - off_y;
+      old_rect.width  = sc->width;
+      old_rect.height = sc->height;
+
+      gegl_rectangle_bounding_box (area, &old_rect, &rect);
+    }
+
+  sc->rendered_max_refine_steps = options->max_refine_steps;
+  sc->rendered_xoff             = sc->xoff;
+  sc->rendered_yoff             = sc->yoff;
+  sc->rendered_preview          = preview;
 
   return TRUE;
 }
@@ -763,6 +917,12 @@ gimp_seamless_clone_tool_create_image_map (GimpSeamlessCloneTool *sc,
   g_signal_connect (sc->image_map, "flush",
                     G_CALLBACK (gimp_seamless_clone_tool_image_map_flush),
                     sc);
+
+  /* A new image map has nothing rendered yet */
+  sc->rendered_max_refine_steps = -1;
+  sc->rendered_xoff             = G_MAXINT;
+  sc->rendered_yoff             = G_MAXINT;
+  sc->rendered_preview          = FALSE;
 }
 
 static void
@@ -775,74 +935,31 @@ gimp_seamless_clone_tool_image_map_flush (GimpImageMap *image_map,
 }
 
 static void
-gimp_seamless_clone_tool_image_map_update (GimpSeamlessCloneTool *sc)
+gimp_seamless_clone_tool_image_map_update (GimpSeamlessCloneTool *sc,
+                                           const GeglRectangle   *area)
 {
   GimpTool         *tool  = GIMP_TOOL (sc);
   GimpDisplayShell *shell = gimp_display_get_shell (tool->display);
   GimpItem         *item  = GIMP_ITEM (tool->drawable);
-  gint              x, y;
-  gint              w, h;
-  gint              off_x, off_y;
   GeglRectangle     visible;
-  GeglOperation    *op = NULL;
-
-  GimpProgress     *progress;
-  GeglNode         *output;
-  GeglProcessor    *processor;
-  gdouble           value;
-
-  progress = gimp_progress_start (GIMP_PROGRESS (sc), FALSE,
-                                  _("Cloning the foreground object"));
+  gint              off_x, off_y;
 
-  /* Find out at which x,y is the top left corner of the currently
-   * displayed part */
-  gimp_display_shell_untransform_viewport (shell, &x, &y, &w, &h);
+  /* Find out which part of the drawable is currently displayed */
+  gimp_display_shell_untransform_viewport (shell,
+                                           &visible.x, &visible.y,
+                                           &visible.width, &visible.height);
 
-  /* Find out where is our drawable positioned */
+  /* Since the image map wants rectangles relative to the drawable's
+   * location, we now offset back by the drawable's offsets.
+   */
   gimp_item_get_offset (item, &off_x, &off_y);
 
-  /* Create a rectangle from the intersection of the currently displayed
-   * part with the drawable */
-  gimp_rectangle_intersect (x, y, w, h,
-                            off_x,
-                            off_y,
-                            gimp_item_get_width  (item),
-                            gimp_item_get_height (item),
-                            &visible.x,
-                            &visible.y,
-                            &visible.width,
-                            &visible.height);
-
-  /* Since the image_map_apply function receives a rectangle describing
-   * where it should update the preview, and since that rectangle should
-   * be relative to the drawable's location, we now offset back by the
-   * drawable's offsetts. */
   visible.x -= off_x;
   visible.y -= off_y;
 
-  g_object_get (sc->sc_node, "gegl-operation", &op, NULL);
-  /* If any cache of the visible area was present, clear it!
-   * We need to clear the cache in the sc_node, since that is
-   * where the previous paste was located
+  /* The image map renders the changed area on its worker thread,
+   * starting with what's visible
    */
-  gegl_operation_invalidate (op, &visible, TRUE);
-  g_object_unref (op);
-
-  /* Now update the image map and show this area */
-  gimp_image_map_apply (sc->image_map, NULL);
-
-  /* Show update progress. */
-  output = gegl_node_get_output_proxy (sc->render_node, "output");
-  processor = gegl_node_new_processor (output, NULL);
-
-  while (gegl_processor_work (processor, &value))
-    {
-      if (progress)
-        gimp_progress_set_value (progress, value);
-    }
-
-  if (progress)
-    gimp_progress_end (progress);
-
-  g_object_unref (processor);
+  gimp_image_map_set_preview_rect (sc->image_map, &visible);
+  gimp_image_map_apply (sc->image_map, area);
 }
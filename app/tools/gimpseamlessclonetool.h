@@ -52,6 +52,20 @@ struct _GimpSeamlessCloneTool
                                    * cloning live with translation of
                                    * the paste */
 
+  GeglNode       *preview_sc_node;   /* The same at a reduced size, used
+                                      * while the paste is dragged. NULL
+                                      * if the paste is small enough */
+  GeglNode       *preview_crop_node; /* Crops the scaled up preview to
+                                      * the paste */
+  GeglNode       *overlay_node;      /* Composites either of the above
+                                      * over the drawable */
+  gdouble         preview_scale;
+
+  gint            rendered_max_refine_steps;
+  gint            rendered_xoff;   /* What the graph was last set up for, */
+  gint            rendered_yoff;   /* to know which area changed          */
+  gboolean        rendered_preview;
+
   gint            tool_state;     /* The current state in the tool's
                                    * state machine */
 
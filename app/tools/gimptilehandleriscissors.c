@@ -28,6 +28,7 @@
 
 #include "gegl/gimp-gegl-loops.h"
 
+#include "core/gimp-parallel.h"
 #include "core/gimpimage.h"
 #include "core/gimppickable.h"
 
@@ -41,6 +42,17 @@ enum
 };
 
 
+typedef struct
+{
+  GimpTileHandlerIscissors *iscissors;
+  const GeglRectangle      *tiles;
+  gint                      n_tiles;
+  guint8                   *data;
+  gint                      tile_size;
+  gint                      tile_stride;
+} PrepareData;
+
+
 static void   gimp_tile_handler_iscissors_finalize     (GObject         *object);
 static void   gimp_tile_handler_iscissors_set_property (GObject         *object,
                                                         guint            property_id,
@@ -57,6 +69,14 @@ static void   gimp_tile_handler_iscissors_validate     (GimpTileHandlerValidate
                                                         gpointer                 dest_buf,
                                                         gint                     dest_stride);
 
+static void   gimp_tile_handler_iscissors_render       (GimpTileHandlerIscissors *iscissors,
+                                                        const GeglRectangle      *rect,
+                                                        gpointer                  dest_buf,
+                                                        gint                      dest_stride);
+static void   gimp_tile_handler_iscissors_prepare_func (gint                      i,
+                                                        gint                      n,
+                                                        PrepareData              *data);
+
 
 G_DEFINE_TYPE (GimpTileHandlerIscissors, gimp_tile_handler_iscissors,
                GIMP_TYPE_TILE_HANDLER_VALIDATE)
@@ -177,6 +197,22 @@ gimp_tile_handler_iscissors_validate (GimpTileHandlerValidate *validate,
                                       gint                     dest_stride)
 {
   GimpTileHandlerIscissors *iscissors = GIMP_TILE_HANDLER_ISCISSORS (validate);
+
+  gimp_pickable_flush (GIMP_PICKABLE (iscissors->image));
+
+  gimp_tile_handler_iscissors_render (iscissors, rect, dest_buf, dest_stride);
+}
+
+/*  computes the gradient map of @rect, this is called from several
+ *  threads by gimp_tile_handler_iscissors_prepare(), so it must not
+ *  flush the image
+ */
+static void
+gimp_tile_handler_iscissors_render (GimpTileHandlerIscissors *iscissors,
+                                    const GeglRectangle      *rect,
+                                    gpointer                  dest_buf,
+                                    gint                      dest_stride)
+{
   GeglBuffer               *src;
   GeglBuffer               *temp0;
   GeglBuffer               *temp1;
@@ -197,8 +233,6 @@ gimp_tile_handler_iscissors_validate (GimpTileHandlerValidate *validate,
               rect->height);
 #endif
 
-  gimp_pickable_flush (GIMP_PICKABLE (iscissors->image));
-
   src = gimp_pickable_get_buffer (GIMP_PICKABLE (iscissors->image));
 
   temp0 = gegl_buffer_new (GEGL_RECTANGLE (0, 0,
@@ -320,6 +354,22 @@ gimp_tile_handler_iscissors_validate (GimpTileHandlerValidate *validate,
   g_object_unref (temp2);
 }
 
+static void
+gimp_tile_handler_iscissors_prepare_func (gint         i,
+                                          gint         n,
+                                          PrepareData *data)
+{
+  gint t;
+
+  for (t = i; t < data->n_tiles; t += n)
+    {
+      gimp_tile_handler_iscissors_render (data->iscissors,
+                                          &data->tiles[t],
+                                          data->data + t * data->tile_size,
+                                          data->tile_stride);
+    }
+}
+
 GeglTileHandler *
 gimp_tile_handler_iscissors_new (GimpImage *image)
 {
@@ -330,3 +380,104 @@ gimp_tile_handler_iscissors_new (GimpImage *image)
                        "image",      image,
                        NULL);
 }
+
+/*  Computes all tiles of @buffer's gradient map within @rect that are
+ *  not valid yet, in parallel, instead of one after the other as they
+ *  are read.  @buffer must be the buffer @iscissors is assigned to.
+ */
+void
+gimp_tile_handler_iscissors_prepare (GimpTileHandlerIscissors *iscissors,
+                                     GeglBuffer               *buffer,
+                                     const GeglRectangle      *rect)
+{
+  GimpTileHandlerValidate *validate;
+  PrepareData              data;
+  GArray                  *tiles;
+  gint                     tile_x1, tile_y1;
+  gint                     tile_x2, tile_y2;
+  gint                     tx, ty;
+  gint                     t;
+
+  g_return_if_fail (GIMP_IS_TILE_HANDLER_ISCISSORS (iscissors));
+  g_return_if_fail (GEGL_IS_BUFFER (buffer));
+  g_return_if_fail (rect != NULL);
+
+  validate = GIMP_TILE_HANDLER_VALIDATE (iscissors);
+
+  if (cairo_region_is_empty (validate->dirty_region) ||
+      rect->width < 1 || rect->height < 1)
+    return;
+
+  tile_x1 = rect->x / validate->tile_width;
+  tile_y1 = rect->y / validate->tile_height;
+  tile_x2 = (rect->x + rect->width  - 1) / validate->tile_width;
+  tile_y2 = (rect->y + rect->height - 1) / validate->tile_height;
+
+  tiles = g_array_new (FALSE, FALSE, sizeof (GeglRectangle));
+
+  for (ty = tile_y1; ty <= tile_y2; ty++)
+    for (tx = tile_x1; tx <= tile_x2; tx++)
+      {
+        cairo_rectangle_int_t tile_rect;
+
+        tile_rect.x      = tx * validate->tile_width;
+        tile_rect.y      = ty * validate->tile_height;
+        tile_rect.width  = validate->tile_width;
+        tile_rect.height = validate->tile_height;
+
+        if (cairo_region_contains_rectangle (validate->dirty_region,
+                                             &tile_rect) !=
+            CAIRO_REGION_OVERLAP_OUT)
+          {
+            g_array_append_val (tiles,
+                                *GEGL_RECTANGLE (tile_rect.x,
+                                                 tile_rect.y,
+                                                 tile_rect.width,
+                                                 tile_rect.height));
+          }
+      }
+
+  /*  a single tile is validated just as fast when it is read  */
+  if (tiles->len < 2)
+    {
+      g_array_free (tiles, TRUE);
+      return;
+    }
+
+  gimp_pickable_flush (GIMP_PICKABLE (iscissors->image));
+
+  data.iscissors   = iscissors;
+  data.tiles       = (const GeglRectangle *) tiles->data;
+  data.n_tiles     = tiles->len;
+  data.tile_stride = (validate->tile_width *
+                      babl_format_get_bytes_per_pixel (validate->format));
+  data.tile_size   = data.tile_stride * validate->tile_height;
+  data.data        = g_malloc ((gsize) data.tile_size * data.n_tiles);
+
+  gimp_parallel_distribute (data.n_tiles,
+                            (GimpParallelDistributeFunc)
+                            gimp_tile_handler_iscissors_prepare_func,
+                            &data);
+
+  /*  the tiles are no longer dirty, so writing them doesn't validate
+   *  them a second time
+   */
+  for (t = 0; t < data.n_tiles; t++)
+    {
+      const GeglRectangle   *tile = &data.tiles[t];
+      cairo_rectangle_int_t  tile_rect;
+
+      tile_rect.x      = tile->x;
+      tile_rect.y      = tile->y;
+      tile_rect.width  = tile->width;
+      tile_rect.height = tile->height;
+
+      cairo_region_subtract_rectangle (validate->dirty_region, &tile_rect);
+
+      gegl_buffer_set (buffer, tile, 0, validate->format,
+                       data.data + t * data.tile_size, data.tile_stride);
+    }
+
+  g_free (data.data);
+  g_array_free (tiles, TRUE);
+}
@@ -1138,22 +1138,12 @@ gimp_transform_tool_draw (GimpDrawTool *draw_tool)
 
       if (segs_in)
         {
-          for (i = 0; i < num_segs_in; i++)
-            {
-              gdouble tx, ty;
-
-              gimp_matrix3_transform_point (&matrix,
-                                            segs_in[i].x1, segs_in[i].y1,
-                                            &tx, &ty);
-              segs_in[i].x1 = RINT (tx);
-              segs_in[i].y1 = RINT (ty);
-
-              gimp_matrix3_transform_point (&matrix,
-                                            segs_in[i].x2, segs_in[i].y2,
-                                            &tx, &ty);
-              segs_in[i].x2 = RINT (tx);
-              segs_in[i].y2 = RINT (ty);
-            }
+          gimp_matrix3_transform_points_round (&matrix,
+                                               &segs_in[0].x1, num_segs_in,
+                                               sizeof (GimpBoundSeg));
+          gimp_matrix3_transform_points_round (&matrix,
+                                               &segs_in[0].x2, num_segs_in,
+                                               sizeof (GimpBoundSeg));
 
           gimp_draw_tool_add_boundary (draw_tool,
                                        segs_in, num_segs_in,
@@ -1164,22 +1154,12 @@ gimp_transform_tool_draw (GimpDrawTool *draw_tool)
 
       if (segs_out)
         {
-          for (i = 0; i < num_segs_out; i++)
-            {
-              gdouble tx, ty;
-
-              gimp_matrix3_transform_point (&matrix,
-                                            segs_out[i].x1, segs_out[i].y1,
-                                            &tx, &ty);
-              segs_out[i].x1 = RINT (tx);
-              segs_out[i].y1 = RINT (ty);
-
-              gimp_matrix3_transform_point (&matrix,
-                                            segs_out[i].x2, segs_out[i].y2,
-                                            &tx, &ty);
-              segs_out[i].x2 = RINT (tx);
-              segs_out[i].y2 = RINT (ty);
-            }
+          gimp_matrix3_transform_points_round (&matrix,
+                                               &segs_out[0].x1, num_segs_out,
+                                               sizeof (GimpBoundSeg));
+          gimp_matrix3_transform_points_round (&matrix,
+                                               &segs_out[0].x2, num_segs_out,
+                                               sizeof (GimpBoundSeg));
 
           gimp_draw_tool_add_boundary (draw_tool,
                                        segs_out, num_segs_out,
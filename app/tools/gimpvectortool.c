@@ -1410,9 +1410,13 @@ gimp_vector_tool_cursor_update (GimpTool         *tool,
 static void
 gimp_vector_tool_draw (GimpDrawTool *draw_tool)
 {
-  GimpVectorTool *vector_tool = GIMP_VECTOR_TOOL (draw_tool);
-  GimpStroke     *cur_stroke;
-  GimpVectors    *vectors;
+  GimpVectorTool  *vector_tool = GIMP_VECTOR_TOOL (draw_tool);
+  GimpStroke      *cur_stroke;
+  GimpVectors     *vectors;
+  GimpCanvasGroup *anchor_fill_group;
+  GimpCanvasGroup *anchor_stroke_group;
+  GimpCanvasGroup *line_group;
+  GimpCanvasGroup *control_group;
 
   vectors = vector_tool->vectors;
 
@@ -1423,6 +1427,16 @@ gimp_vector_tool_draw (GimpDrawTool *draw_tool)
   if (! gimp_item_get_visible (GIMP_ITEM (vectors)))
     gimp_draw_tool_add_path (draw_tool, gimp_vectors_get_bezier (vectors), 0, 0);
 
+  /*  collect handles and lines of the same kind in groups, so they
+   *  are stroked or filled in one go instead of one by one
+   */
+  anchor_fill_group   = gimp_draw_tool_add_fill_group (draw_tool);
+  anchor_stroke_group = gimp_draw_tool_add_stroke_group (draw_tool);
+  line_group          = gimp_draw_tool_add_stroke_group (draw_tool);
+  control_group       = gimp_draw_tool_add_stroke_group (draw_tool);
+
+  gimp_canvas_item_set_highlight (GIMP_CANVAS_ITEM (line_group), TRUE);
+
   for (cur_stroke = gimp_vectors_stroke_get_next (vectors, NULL);
        cur_stroke;
        cur_stroke = gimp_vectors_stroke_get_next (vectors, cur_stroke))
@@ -1440,6 +1454,11 @@ gimp_vector_tool_draw (GimpDrawTool *draw_tool)
 
           if (cur_anchor->type == GIMP_ANCHOR_ANCHOR)
             {
+              gimp_draw_tool_push_group (draw_tool,
+                                         cur_anchor->selected ?
+                                         anchor_stroke_group :
+                                         anchor_fill_group);
+
               gimp_draw_tool_add_handle (draw_tool,
                                          cur_anchor->selected ?
                                          GIMP_HANDLE_CIRCLE :
@@ -1449,6 +1468,8 @@ gimp_vector_tool_draw (GimpDrawTool *draw_tool)
                                          GIMP_TOOL_HANDLE_SIZE_CIRCLE,
                                          GIMP_TOOL_HANDLE_SIZE_CIRCLE,
                                          GIMP_HANDLE_ANCHOR_CENTER);
+
+              gimp_draw_tool_pop_group (draw_tool);
             }
         }
 
@@ -1465,19 +1486,19 @@ gimp_vector_tool_draw (GimpDrawTool *draw_tool)
                 {
                   gint i;
 
+                  gimp_draw_tool_push_group (draw_tool, line_group);
+
                   for (i = 0; i < coords->len; i += 2)
                     {
-                      GimpCanvasItem *item;
-
-                      item = gimp_draw_tool_add_line
+                      gimp_draw_tool_add_line
                         (draw_tool,
                          g_array_index (coords, GimpCoords, i).x,
                          g_array_index (coords, GimpCoords, i).y,
                          g_array_index (coords, GimpCoords, i + 1).x,
                          g_array_index (coords, GimpCoords, i + 1).y);
-
-                      gimp_canvas_item_set_highlight (item, TRUE);
                     }
+
+                  gimp_draw_tool_pop_group (draw_tool);
                 }
 
               g_array_free (coords, TRUE);
@@ -1486,6 +1507,8 @@ gimp_vector_tool_draw (GimpDrawTool *draw_tool)
           /* control handles */
           draw_anchors = gimp_stroke_get_draw_controls (cur_stroke);
 
+          gimp_draw_tool_push_group (draw_tool, control_group);
+
           for (list = draw_anchors; list; list = g_list_next (list))
             {
               GimpAnchor *cur_anchor = GIMP_ANCHOR (list->data);
@@ -1499,6 +1522,8 @@ gimp_vector_tool_draw (GimpDrawTool *draw_tool)
                                          GIMP_HANDLE_ANCHOR_CENTER);
             }
 
+          gimp_draw_tool_pop_group (draw_tool);
+
           g_list_free (draw_anchors);
         }
     }
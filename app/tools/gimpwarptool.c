@@ -19,11 +19,14 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include <gegl.h>
 #include "gegl-utils.h"
 #include <gtk/gtk.h>
 #include <gdk/gdkkeysyms.h>
 
+#include "libgimpmath/gimpmath.h"
 #include "libgimpwidgets/gimpwidgets.h"
 
 #include "tools-types.h"
@@ -121,6 +124,8 @@ static void       gimp_warp_tool_add_op             (GimpWarpTool          *wt,
                                                      GeglNode              *op);
 static void       gimp_warp_tool_remove_op          (GimpWarpTool          *wt,
                                                      GeglNode              *op);
+static void       gimp_warp_tool_link_cache         (GimpWarpTool          *wt);
+static void       gimp_warp_tool_unlink_cache       (GimpWarpTool          *wt);
 
 static void       gimp_warp_tool_animate            (GimpWarpTool          *wt);
 
@@ -596,6 +601,7 @@ gimp_warp_tool_halt (GimpWarpTool *wt)
       g_object_unref (wt->graph);
       wt->graph       = NULL;
       wt->render_node = NULL;
+      wt->cache_node  = NULL;
     }
 
   if (wt->image_map)
@@ -668,6 +674,7 @@ gimp_warp_tool_create_graph (GimpWarpTool *wt)
   GeglNode *graph;           /* Wraper to be returned */
   GeglNode *input, *output;  /* Proxy nodes */
   GeglNode *coords, *render; /* Render nodes */
+  GeglNode *cache;           /* Cache of all but the last op */
 
   /* render_node is not supposed to be recreated */
   g_return_if_fail (wt->graph == NULL);
@@ -686,6 +693,11 @@ gimp_warp_tool_create_graph (GimpWarpTool *wt)
                                 "operation", "gegl:map-relative",
                                 NULL);
 
+  /*  not linked until there are two ops, see gimp_warp_tool_link_cache()  */
+  cache = gegl_node_new_child (graph,
+                               "operation", "gegl:cache",
+                               NULL);
+
   gegl_node_connect_to (input,  "output",
                         render, "input");
 
@@ -697,6 +709,7 @@ gimp_warp_tool_create_graph (GimpWarpTool *wt)
 
   wt->graph       = graph;
   wt->render_node = render;
+  wt->cache_node  = cache;
 }
 
 static void
@@ -745,10 +758,10 @@ gimp_warp_tool_update_stroke (GimpWarpTool *wt,
       gegl_path_get_bounds (stroke, &min_x, &max_x, &min_y, &max_y);
       g_object_unref (stroke);
 
-      bbox.x      = min_x - size * 0.5;
-      bbox.y      = min_y - size * 0.5;
-      bbox.width  = max_x - min_x + size;
-      bbox.height = max_y - min_y + size;
+      bbox.x      = floor (min_x - size * 0.5);
+      bbox.y      = floor (min_y - size * 0.5);
+      bbox.width  = ceil (max_x + size * 0.5) - bbox.x;
+      bbox.height = ceil (max_y + size * 0.5) - bbox.y;
 
 #ifdef WARP_DEBUG
   g_printerr ("update stroke: (%d,%d), %dx%d\n",
@@ -765,13 +778,17 @@ gimp_warp_tool_stroke_changed (GeglPath            *path,
                                const GeglRectangle *roi,
                                GimpWarpTool        *wt)
 {
-  GimpWarpOptions *options       = GIMP_WARP_TOOL_GET_OPTIONS (wt);
-  GeglRectangle    update_region = *roi;
+  GimpWarpOptions *options = GIMP_WARP_TOOL_GET_OPTIONS (wt);
+  gdouble          radius  = options->effect_size * 0.5;
+  GeglRectangle    update_region;
 
-  update_region.x      -= options->effect_size * 0.5;
-  update_region.y      -= options->effect_size * 0.5;
-  update_region.width  += options->effect_size;
-  update_region.height += options->effect_size;
+  /*  only the area the new dabs can reach needs to be rendered again;
+   *  all previous strokes come from the cache
+   */
+  update_region.x      = floor (roi->x - radius);
+  update_region.y      = floor (roi->y - radius);
+  update_region.width  = ceil (roi->x + roi->width  + radius) - update_region.x;
+  update_region.height = ceil (roi->y + roi->height + radius) - update_region.y;
 
 #ifdef WARP_DEBUG
   g_printerr ("update rect: (%d,%d), %dx%d\n",
@@ -799,6 +816,8 @@ gimp_warp_tool_add_op (GimpWarpTool *wt,
 
   g_return_if_fail (GEGL_IS_NODE (wt->render_node));
 
+  gimp_warp_tool_unlink_cache (wt);
+
   gegl_node_add_child (wt->graph, op);
 
   last_op = gegl_node_get_producer (wt->render_node, "aux", NULL);
@@ -808,6 +827,8 @@ gimp_warp_tool_add_op (GimpWarpTool *wt,
                         op    ,          "input");
   gegl_node_connect_to (op,              "output",
                         wt->render_node, "aux");
+
+  gimp_warp_tool_link_cache (wt);
 }
 
 static void
@@ -818,6 +839,8 @@ gimp_warp_tool_remove_op (GimpWarpTool *wt,
 
   g_return_if_fail (GEGL_IS_NODE (wt->render_node));
 
+  gimp_warp_tool_unlink_cache (wt);
+
   previous = gegl_node_get_producer (op, "input", NULL);
 
   gegl_node_disconnect (op,              "input");
@@ -825,6 +848,49 @@ gimp_warp_tool_remove_op (GimpWarpTool *wt,
                         wt->render_node, "aux");
 
   gegl_node_remove_child (wt->graph, op);
+
+  gimp_warp_tool_link_cache (wt);
+}
+
+/*  Puts the cache node right before the last op, so that while a
+ *  stroke is being drawn, the ops of all previous strokes are
+ *  evaluated only once per tile instead of once per update.
+ */
+static void
+gimp_warp_tool_link_cache (GimpWarpTool *wt)
+{
+  GeglNode *last_op;
+  GeglNode *previous;
+
+  last_op  = gegl_node_get_producer (wt->render_node, "aux", NULL);
+  previous = gegl_node_get_producer (last_op, "input", NULL);
+
+  /*  nothing worth caching below a single stroke  */
+  if (! previous || strcmp (gegl_node_get_operation (previous), "gegl:warp"))
+    return;
+
+  gegl_node_connect_to (previous,       "output",
+                        wt->cache_node, "input");
+  gegl_node_connect_to (wt->cache_node, "output",
+                        last_op,        "input");
+}
+
+static void
+gimp_warp_tool_unlink_cache (GimpWarpTool *wt)
+{
+  GeglNode *last_op;
+  GeglNode *previous;
+
+  previous = gegl_node_get_producer (wt->cache_node, "input", NULL);
+
+  if (! previous)
+    return;
+
+  last_op = gegl_node_get_producer (wt->render_node, "aux", NULL);
+
+  gegl_node_disconnect (wt->cache_node, "input");
+  gegl_node_connect_to (previous, "output",
+                        last_op,  "input");
 }
 
 static void
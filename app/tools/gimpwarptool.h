@@ -48,6 +48,7 @@ struct _GimpWarpTool
 
   GeglNode       *graph;         /* Top level GeglNode */
   GeglNode       *render_node;   /* Gegl node to render the transformation */
+  GeglNode       *cache_node;    /* Caches the coordinates before the last op */
 
   GeglPath       *current_stroke;
   guint           stroke_timer;
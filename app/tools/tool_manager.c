@@ -732,6 +732,13 @@ tool_manager_preset_changed (GimpContext     *user_context,
   if (preset_tool != gimp_context_get_tool (user_context))
     tool_change = TRUE;
 
+  /*  only properties that differ from the preset are actually set
+   *  below, collect their "notify" signals and emit them in one go
+   *  once the whole preset is applied
+   */
+  g_object_freeze_notify (G_OBJECT (user_context));
+  g_object_freeze_notify (G_OBJECT (preset_tool->tool_options));
+
   if (! tool_change)
     tool_manager_disconnect_options (tool_manager, user_context, preset_tool);
 
@@ -775,6 +782,12 @@ tool_manager_preset_changed (GimpContext     *user_context,
         gimp_paint_options_copy_gradient_props (GIMP_PAINT_OPTIONS (src),
                                                 GIMP_PAINT_OPTIONS (dest));
     }
+
+  /*  thaw the user context first, the tool options inherit from it
+   *  through "notify"
+   */
+  g_object_thaw_notify (G_OBJECT (user_context));
+  g_object_thaw_notify (G_OBJECT (preset_tool->tool_options));
 }
 
 static void
@@ -33,6 +33,15 @@
 
 #include "gimpanchor.h"
 #include "gimpbezierstroke.h"
+#include "gimpstroke-index.h"
+
+
+typedef struct
+{
+  GimpCoords  coords[4];
+  GimpAnchor *start;
+  GimpAnchor *end;
+} GimpBezierSegment;
 
 
 /*  local prototypes  */
@@ -141,6 +150,15 @@ static void gimp_bezier_stroke_finalize    (GObject               *object);
 static GList * gimp_bezier_stroke_get_anchor_listitem
                                            (GList                 *list);
 
+static GimpStrokeIndex * gimp_bezier_stroke_get_segment_index
+                                           (const GimpStroke      *stroke);
+static void    gimp_bezier_stroke_segment_add
+                                           (GimpStrokeIndex       *index,
+                                            const GimpCoords      *coords,
+                                            GimpAnchor            *start,
+                                            GimpAnchor            *end);
+static void    gimp_bezier_segment_free    (GimpBezierSegment     *segment);
+
 
 G_DEFINE_TYPE (GimpBezierStroke, gimp_bezier_stroke, GIMP_TYPE_STROKE)
 
@@ -554,39 +572,55 @@ gimp_bezier_stroke_nearest_point_get (const GimpStroke     *stroke,
                                       GimpAnchor          **ret_segment_end,
                                       gdouble              *ret_pos)
 {
-  gdouble     min_dist, dist, pos;
-  GimpCoords  point = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
-  GimpCoords  segmentcoords[4];
-  GList      *anchorlist;
-  GimpAnchor *segment_start;
-  GimpAnchor *segment_end = NULL;
-  GimpAnchor *anchor;
-  gint        count;
+  GimpStrokeIndex *index;
+  GArray          *items;
+  gdouble          x1, y1, x2, y2;
+  gdouble          radius;
+  gdouble          min_dist = -1;
 
   if (!stroke->anchors)
     return -1.0;
 
-  count = 0;
-  min_dist = -1;
-  pos = 0;
+  index = gimp_bezier_stroke_get_segment_index (stroke);
 
-  for (anchorlist = stroke->anchors;
-       GIMP_ANCHOR (anchorlist->data)->type != GIMP_ANCHOR_ANCHOR;
-       anchorlist = g_list_next (anchorlist));
+  if (! gimp_stroke_index_get_bounds (index, &x1, &y1, &x2, &y2))
+    return -1.0;
 
-  segment_start = anchorlist->data;
+  /*  Every segment lies within the bounding box of its control points.
+   *  If the nearest point found among the segments whose box meets the
+   *  square of size 2 * radius around coord is no farther away than
+   *  radius, no other segment can come closer.  Otherwise grow the
+   *  square until it covers the whole stroke.
+   */
+  radius = MAX ((x2 - x1) + (y2 - y1), 1.0) /
+           sqrt (gimp_stroke_index_get_n_items (index));
+  radius = MAX (radius, MAX (MAX (x1 - coord->x, coord->x - x2),
+                             MAX (y1 - coord->y, coord->y - y2)));
 
-  for ( ; anchorlist; anchorlist = g_list_next (anchorlist))
+  items = g_array_new (FALSE, FALSE, sizeof (gint));
+
+  while (TRUE)
     {
-      anchor = anchorlist->data;
+      gint i;
 
-      segmentcoords[count] = anchor->position;
-      count++;
+      g_array_set_size (items, 0);
+      min_dist = -1;
 
-      if (count == 4)
+      gimp_stroke_index_query (index,
+                               coord->x - radius, coord->y - radius,
+                               coord->x + radius, coord->y + radius,
+                               items);
+
+      for (i = 0; i < items->len; i++)
         {
-          segment_end = anchorlist->data;
-          dist = gimp_bezier_stroke_segment_nearest_point_get (segmentcoords,
+          GimpBezierSegment *segment;
+          GimpCoords         point = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+          gdouble            dist, pos;
+
+          segment = gimp_stroke_index_get_data (index,
+                                                g_array_index (items, gint, i));
+
+          dist = gimp_bezier_stroke_segment_nearest_point_get (segment->coords,
                                                                coord, precision,
                                                                &point, &pos,
                                                                10);
@@ -600,10 +634,69 @@ gimp_bezier_stroke_nearest_point_get (const GimpStroke     *stroke,
               if (ret_point)
                 *ret_point = point;
               if (ret_segment_start)
-                *ret_segment_start = segment_start;
+                *ret_segment_start = segment->start;
               if (ret_segment_end)
-                *ret_segment_end = segment_end;
+                *ret_segment_end = segment->end;
             }
+        }
+
+      if (min_dist >= 0 && min_dist <= radius)
+        break;
+
+      if (coord->x - radius <= x1 && coord->x + radius >= x2 &&
+          coord->y - radius <= y1 && coord->y + radius >= y2)
+        break;
+
+      radius *= 2.0;
+    }
+
+  g_array_free (items, TRUE);
+
+  return min_dist;
+}
+
+static GimpStrokeIndex *
+gimp_bezier_stroke_get_segment_index (const GimpStroke *stroke)
+{
+  GimpStrokeIndex *index;
+  GimpCoords       segmentcoords[4];
+  GList           *anchorlist;
+  GimpAnchor      *segment_start;
+  GimpAnchor      *segment_end = NULL;
+  gint             count;
+
+  if (stroke->segment_index)
+    return stroke->segment_index;
+
+  index = gimp_stroke_index_new ((GDestroyNotify) gimp_bezier_segment_free);
+
+  ((GimpStroke *) stroke)->segment_index = index;
+
+  /*  walk the segments the same way the nearest point search used to  */
+  for (anchorlist = stroke->anchors;
+       anchorlist &&
+       GIMP_ANCHOR (anchorlist->data)->type != GIMP_ANCHOR_ANCHOR;
+       anchorlist = g_list_next (anchorlist));
+
+  if (! anchorlist)
+    return index;
+
+  segment_start = anchorlist->data;
+  count = 0;
+
+  for ( ; anchorlist; anchorlist = g_list_next (anchorlist))
+    {
+      GimpAnchor *anchor = anchorlist->data;
+
+      segmentcoords[count] = anchor->position;
+      count++;
+
+      if (count == 4)
+        {
+          segment_end = anchorlist->data;
+
+          gimp_bezier_stroke_segment_add (index, segmentcoords,
+                                          segment_start, segment_end);
 
           segment_start = anchorlist->data;
           segmentcoords[0] = segmentcoords[3];
@@ -611,7 +704,7 @@ gimp_bezier_stroke_nearest_point_get (const GimpStroke     *stroke,
         }
     }
 
-  if (stroke->closed && stroke->anchors)
+  if (stroke->closed)
     {
       anchorlist = stroke->anchors;
 
@@ -628,28 +721,51 @@ gimp_bezier_stroke_nearest_point_get (const GimpStroke     *stroke,
           segment_end = GIMP_ANCHOR (anchorlist->data);
           segmentcoords[3] = segment_end->position;
         }
+      else
+        {
+          segmentcoords[3] = segmentcoords[2];
+        }
 
-      dist = gimp_bezier_stroke_segment_nearest_point_get (segmentcoords,
-                                                           coord, precision,
-                                                           &point, &pos,
-                                                           10);
+      gimp_bezier_stroke_segment_add (index, segmentcoords,
+                                      segment_start, segment_end);
+    }
 
-      if (dist < min_dist || min_dist < 0)
-        {
-          min_dist = dist;
+  return index;
+}
 
-          if (ret_pos)
-            *ret_pos = pos;
-          if (ret_point)
-            *ret_point = point;
-          if (ret_segment_start)
-            *ret_segment_start = segment_start;
-          if (ret_segment_end)
-            *ret_segment_end = segment_end;
-        }
+static void
+gimp_bezier_stroke_segment_add (GimpStrokeIndex  *index,
+                                const GimpCoords *coords,
+                                GimpAnchor       *start,
+                                GimpAnchor       *end)
+{
+  GimpBezierSegment *segment = g_slice_new (GimpBezierSegment);
+  gdouble            x1, y1, x2, y2;
+  gint               i;
+
+  x1 = x2 = coords[0].x;
+  y1 = y2 = coords[0].y;
+
+  for (i = 0; i < 4; i++)
+    {
+      segment->coords[i] = coords[i];
+
+      x1 = MIN (x1, coords[i].x);
+      y1 = MIN (y1, coords[i].y);
+      x2 = MAX (x2, coords[i].x);
+      y2 = MAX (y2, coords[i].y);
     }
 
-  return min_dist;
+  segment->start = start;
+  segment->end   = end;
+
+  gimp_stroke_index_add (index, x1, y1, x2, y2, segment);
+}
+
+static void
+gimp_bezier_segment_free (GimpBezierSegment *segment)
+{
+  g_slice_free (GimpBezierSegment, segment);
 }
 
 
@@ -1650,6 +1766,8 @@ gimp_bezier_stroke_lineto (GimpStroke       *stroke,
   stroke->anchors = g_list_prepend (stroke->anchors,
                                     gimp_anchor_new (GIMP_ANCHOR_CONTROL,
                                                      end));
+
+  gimp_stroke_invalidate_cache (stroke);
 }
 
 void
@@ -1681,6 +1799,8 @@ gimp_bezier_stroke_conicto (GimpStroke       *stroke,
   stroke->anchors = g_list_prepend (stroke->anchors,
                                     gimp_anchor_new (GIMP_ANCHOR_CONTROL,
                                                      end));
+
+  gimp_stroke_invalidate_cache (stroke);
 }
 
 void
@@ -1704,6 +1824,8 @@ gimp_bezier_stroke_cubicto (GimpStroke       *stroke,
   stroke->anchors = g_list_prepend (stroke->anchors,
                                     gimp_anchor_new (GIMP_ANCHOR_CONTROL,
                                                      end));
+
+  gimp_stroke_invalidate_cache (stroke);
 }
 
 static gdouble
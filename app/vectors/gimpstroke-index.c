@@ -0,0 +1,379 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimpstroke-index.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <stdlib.h>
+
+#include <glib-object.h>
+
+#include "libgimpmath/gimpmath.h"
+
+#include "vectors-types.h"
+
+#include "gimpstroke-index.h"
+
+
+/*  aim for this many items per grid cell  */
+#define ITEMS_PER_CELL 4
+#define MAX_GRID_SIZE  1024
+
+
+typedef struct
+{
+  gdouble  x1, y1;
+  gdouble  x2, y2;
+  gpointer data;
+} GimpStrokeIndexItem;
+
+struct _GimpStrokeIndex
+{
+  GArray         *items;
+  GDestroyNotify  data_free;
+
+  gdouble         x1, y1;
+  gdouble         x2, y2;
+
+  /*  the grid, built on the first query  */
+  gboolean        valid;
+  gdouble         cell_width;
+  gdouble         cell_height;
+  gint            n_cols;
+  gint            n_rows;
+  gint           *cell_start;   /* n_cols * n_rows + 1 offsets into cell_items */
+  gint           *cell_items;
+};
+
+
+/*  local function prototypes  */
+
+static void   gimp_stroke_index_build     (GimpStrokeIndex *index);
+static void   gimp_stroke_index_get_cells (GimpStrokeIndex *index,
+                                           gdouble          x1,
+                                           gdouble          y1,
+                                           gdouble          x2,
+                                           gdouble          y2,
+                                           gint            *col1,
+                                           gint            *row1,
+                                           gint            *col2,
+                                           gint            *row2);
+static int    gimp_stroke_index_compare   (const void      *a,
+                                           const void      *b);
+
+
+/*  public functions  */
+
+GimpStrokeIndex *
+gimp_stroke_index_new (GDestroyNotify data_free)
+{
+  GimpStrokeIndex *index = g_slice_new0 (GimpStrokeIndex);
+
+  index->items     = g_array_new (FALSE, FALSE, sizeof (GimpStrokeIndexItem));
+  index->data_free = data_free;
+
+  return index;
+}
+
+void
+gimp_stroke_index_free (GimpStrokeIndex *index)
+{
+  g_return_if_fail (index != NULL);
+
+  if (index->data_free)
+    {
+      gint i;
+
+      for (i = 0; i < index->items->len; i++)
+        index->data_free (g_array_index (index->items,
+                                         GimpStrokeIndexItem, i).data);
+    }
+
+  g_array_free (index->items, TRUE);
+
+  g_free (index->cell_start);
+  g_free (index->cell_items);
+
+  g_slice_free (GimpStrokeIndex, index);
+}
+
+void
+gimp_stroke_index_add (GimpStrokeIndex *index,
+                       gdouble          x1,
+                       gdouble          y1,
+                       gdouble          x2,
+                       gdouble          y2,
+                       gpointer         data)
+{
+  GimpStrokeIndexItem item;
+
+  g_return_if_fail (index != NULL);
+
+  item.x1   = MIN (x1, x2);
+  item.y1   = MIN (y1, y2);
+  item.x2   = MAX (x1, x2);
+  item.y2   = MAX (y1, y2);
+  item.data = data;
+
+  if (index->items->len == 0)
+    {
+      index->x1 = item.x1;
+      index->y1 = item.y1;
+      index->x2 = item.x2;
+      index->y2 = item.y2;
+    }
+  else
+    {
+      index->x1 = MIN (index->x1, item.x1);
+      index->y1 = MIN (index->y1, item.y1);
+      index->x2 = MAX (index->x2, item.x2);
+      index->y2 = MAX (index->y2, item.y2);
+    }
+
+  g_array_append_val (index->items, item);
+
+  index->valid = FALSE;
+}
+
+gint
+gimp_stroke_index_get_n_items (const GimpStrokeIndex *index)
+{
+  g_return_val_if_fail (index != NULL, 0);
+
+  return index->items->len;
+}
+
+gpointer
+gimp_stroke_index_get_data (const GimpStrokeIndex *index,
+                            gint                   item)
+{
+  g_return_val_if_fail (index != NULL, NULL);
+  g_return_val_if_fail (item >= 0 && item < index->items->len, NULL);
+
+  return g_array_index (index->items, GimpStrokeIndexItem, item).data;
+}
+
+gboolean
+gimp_stroke_index_get_bounds (const GimpStrokeIndex *index,
+                              gdouble               *x1,
+                              gdouble               *y1,
+                              gdouble               *x2,
+                              gdouble               *y2)
+{
+  g_return_val_if_fail (index != NULL, FALSE);
+
+  if (index->items->len == 0)
+    return FALSE;
+
+  if (x1) *x1 = index->x1;
+  if (y1) *y1 = index->y1;
+  if (x2) *x2 = index->x2;
+  if (y2) *y2 = index->y2;
+
+  return TRUE;
+}
+
+gint
+gimp_stroke_index_query (GimpStrokeIndex *index,
+                         gdouble          x1,
+                         gdouble          y1,
+                         gdouble          x2,
+                         gdouble          y2,
+                         GArray          *items)
+{
+  gint first;
+  gint col1, row1;
+  gint col2, row2;
+  gint row;
+  gint i, j;
+
+  g_return_val_if_fail (index != NULL, 0);
+  g_return_val_if_fail (items != NULL, 0);
+
+  if (index->items->len == 0 ||
+      x2 < index->x1 || x1 > index->x2 ||
+      y2 < index->y1 || y1 > index->y2)
+    return 0;
+
+  if (! index->valid)
+    gimp_stroke_index_build (index);
+
+  first = items->len;
+
+  gimp_stroke_index_get_cells (index, x1, y1, x2, y2,
+                               &col1, &row1, &col2, &row2);
+
+  for (row = row1; row <= row2; row++)
+    {
+      gint cell = row * index->n_cols;
+
+      for (i = index->cell_start[cell + col1];
+           i < index->cell_start[cell + col2 + 1];
+           i++)
+        {
+          gint                 n    = index->cell_items[i];
+          GimpStrokeIndexItem *item = &g_array_index (index->items,
+                                                      GimpStrokeIndexItem, n);
+
+          if (item->x2 >= x1 && item->x1 <= x2 &&
+              item->y2 >= y1 && item->y1 <= y2)
+            {
+              g_array_append_val (items, n);
+            }
+        }
+    }
+
+  /*  items spanning several cells were found more than once, and callers
+   *  want them in insertion order anyway
+   */
+  if (items->len - first > 1)
+    {
+      gint *found = &g_array_index (items, gint, first);
+      gint  n     = items->len - first;
+
+      qsort (found, n, sizeof (gint), gimp_stroke_index_compare);
+
+      for (i = 1, j = 0; i < n; i++)
+        {
+          if (found[i] != found[j])
+            found[++j] = found[i];
+        }
+
+      g_array_set_size (items, first + j + 1);
+    }
+
+  return items->len - first;
+}
+
+
+/*  private functions  */
+
+static void
+gimp_stroke_index_build (GimpStrokeIndex *index)
+{
+  gdouble width  = index->x2 - index->x1;
+  gdouble height = index->y2 - index->y1;
+  gint    n_items = index->items->len;
+  gint    n_cells;
+  gint   *fill;
+  gint    i;
+
+  n_cells = MAX (1, n_items / ITEMS_PER_CELL);
+
+  if (width > 0.0 && height > 0.0)
+    {
+      gdouble cell_size = sqrt (width * height / n_cells);
+
+      index->n_cols = ceil (width  / cell_size);
+      index->n_rows = ceil (height / cell_size);
+    }
+  else
+    {
+      /*  degenerate, all items on a horizontal or vertical line  */
+      index->n_cols = width  > 0.0 ? n_cells : 1;
+      index->n_rows = height > 0.0 ? n_cells : 1;
+    }
+
+  index->n_cols = CLAMP (index->n_cols, 1, MAX_GRID_SIZE);
+  index->n_rows = CLAMP (index->n_rows, 1, MAX_GRID_SIZE);
+
+  index->cell_width  = MAX (width  / index->n_cols, 1e-6);
+  index->cell_height = MAX (height / index->n_rows, 1e-6);
+
+  g_free (index->cell_start);
+  g_free (index->cell_items);
+
+  index->cell_start = g_new0 (gint, index->n_cols * index->n_rows + 1);
+
+  /*  count the items of each cell...  */
+  for (i = 0; i < n_items; i++)
+    {
+      GimpStrokeIndexItem *item = &g_array_index (index->items,
+                                                  GimpStrokeIndexItem, i);
+      gint                 col1, row1;
+      gint                 col2, row2;
+      gint                 row, col;
+
+      gimp_stroke_index_get_cells (index, item->x1, item->y1,
+                                   item->x2, item->y2,
+                                   &col1, &row1, &col2, &row2);
+
+      for (row = row1; row <= row2; row++)
+        for (col = col1; col <= col2; col++)
+          index->cell_start[row * index->n_cols + col + 1]++;
+    }
+
+  for (i = 0; i < index->n_cols * index->n_rows; i++)
+    index->cell_start[i + 1] += index->cell_start[i];
+
+  /*  ...and fill them, keeping insertion order within each cell  */
+  index->cell_items = g_new (gint, index->cell_start[index->n_cols *
+                                                     index->n_rows]);
+  fill = g_memdup (index->cell_start,
+                   index->n_cols * index->n_rows * sizeof (gint));
+
+  for (i = 0; i < n_items; i++)
+    {
+      GimpStrokeIndexItem *item = &g_array_index (index->items,
+                                                  GimpStrokeIndexItem, i);
+      gint                 col1, row1;
+      gint                 col2, row2;
+      gint                 row, col;
+
+      gimp_stroke_index_get_cells (index, item->x1, item->y1,
+                                   item->x2, item->y2,
+                                   &col1, &row1, &col2, &row2);
+
+      for (row = row1; row <= row2; row++)
+        for (col = col1; col <= col2; col++)
+          index->cell_items[fill[row * index->n_cols + col]++] = i;
+    }
+
+  g_free (fill);
+
+  index->valid = TRUE;
+}
+
+static void
+gimp_stroke_index_get_cells (GimpStrokeIndex *index,
+                             gdouble          x1,
+                             gdouble          y1,
+                             gdouble          x2,
+                             gdouble          y2,
+                             gint            *col1,
+                             gint            *row1,
+                             gint            *col2,
+                             gint            *row2)
+{
+  x1 = (x1 - index->x1) / index->cell_width;
+  y1 = (y1 - index->y1) / index->cell_height;
+  x2 = (x2 - index->x1) / index->cell_width;
+  y2 = (y2 - index->y1) / index->cell_height;
+
+  *col1 = CLAMP (floor (x1), 0, index->n_cols - 1);
+  *row1 = CLAMP (floor (y1), 0, index->n_rows - 1);
+  *col2 = CLAMP (floor (x2), 0, index->n_cols - 1);
+  *row2 = CLAMP (floor (y2), 0, index->n_rows - 1);
+}
+
+static int
+gimp_stroke_index_compare (const void *a,
+                           const void *b)
+{
+  return *(const gint *) a - *(const gint *) b;
+}
@@ -0,0 +1,60 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimpstroke-index.h
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GIMP_STROKE_INDEX_H__
+#define __GIMP_STROKE_INDEX_H__
+
+
+/*  A uniform grid over the bounding boxes of a stroke's anchors or
+ *  segments, used to answer "what is near this point" without walking
+ *  the whole anchor list.
+ */
+
+GimpStrokeIndex * gimp_stroke_index_new        (GDestroyNotify         data_free);
+void              gimp_stroke_index_free       (GimpStrokeIndex       *index);
+
+/*  items are numbered in the order they are added  */
+void              gimp_stroke_index_add        (GimpStrokeIndex       *index,
+                                                gdouble                x1,
+                                                gdouble                y1,
+                                                gdouble                x2,
+                                                gdouble                y2,
+                                                gpointer               data);
+
+gint              gimp_stroke_index_get_n_items (const GimpStrokeIndex *index);
+gpointer          gimp_stroke_index_get_data   (const GimpStrokeIndex *index,
+                                                gint                   item);
+gboolean          gimp_stroke_index_get_bounds (const GimpStrokeIndex *index,
+                                                gdouble               *x1,
+                                                gdouble               *y1,
+                                                gdouble               *x2,
+                                                gdouble               *y2);
+
+/*  appends the numbers of all items whose bounding box intersects the
+ *  given rectangle to "items", in ascending order
+ */
+gint              gimp_stroke_index_query      (GimpStrokeIndex       *index,
+                                                gdouble                x1,
+                                                gdouble                y1,
+                                                gdouble                x2,
+                                                gdouble                y2,
+                                                GArray                *items);
+
+
+#endif /* __GIMP_STROKE_INDEX_H__ */
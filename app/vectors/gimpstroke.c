@@ -30,12 +30,18 @@
 #include "vectors-types.h"
 
 #include "core/gimp-memsize.h"
+#include "core/gimpbezierdesc.h"
 #include "core/gimpcoords.h"
 #include "core/gimpparamspecs.h"
 #include "core/gimp-transform-utils.h"
 
 #include "gimpanchor.h"
 #include "gimpstroke.h"
+#include "gimpstroke-index.h"
+
+/*  the number of precisions gimp_stroke_interpolate() keeps around  */
+#define MAX_CACHED_INTERPOLATIONS 4
+
 
 enum
 {
@@ -44,6 +50,15 @@ enum
   PROP_CLOSED
 };
 
+
+typedef struct
+{
+  gdouble   precision;
+  gboolean  closed;
+  GArray   *coords;
+} GimpStrokeInterpolation;
+
+
 /* Prototypes */
 
 static void    gimp_stroke_set_property              (GObject      *object,
@@ -157,6 +172,15 @@ static void         gimp_stroke_real_transform       (GimpStroke        *stroke,
 
 static GList    * gimp_stroke_real_get_draw_anchors  (const GimpStroke *stroke);
 static GList    * gimp_stroke_real_get_draw_controls (const GimpStroke *stroke);
+static GList    * gimp_stroke_draw_control_add       (GList            *ret_list,
+                                                      GList            *list);
+static GimpStrokeIndex *
+                  gimp_stroke_get_anchor_index       (const GimpStroke *stroke);
+static GList    * gimp_stroke_get_anchors_near       (const GimpStroke *stroke,
+                                                      const GimpCoords *coord,
+                                                      gdouble           radius);
+static void       gimp_stroke_interpolation_free     (GimpStrokeInterpolation *interpolation);
+static GArray   * gimp_stroke_coords_copy            (GArray           *coords);
 static GArray   * gimp_stroke_real_get_draw_lines    (const GimpStroke *stroke);
 static GArray *  gimp_stroke_real_control_points_get (const GimpStroke *stroke,
                                                       gboolean         *ret_closed);
@@ -264,9 +288,13 @@ gimp_stroke_class_init (GimpStrokeClass *klass)
 static void
 gimp_stroke_init (GimpStroke *stroke)
 {
-  stroke->ID      = 0;
-  stroke->anchors = NULL;
-  stroke->closed  = FALSE;
+  stroke->ID             = 0;
+  stroke->anchors        = NULL;
+  stroke->closed         = FALSE;
+  stroke->anchor_index   = NULL;
+  stroke->segment_index  = NULL;
+  stroke->bezier_desc    = NULL;
+  stroke->interpolations = NULL;
 }
 
 static void
@@ -339,6 +367,8 @@ gimp_stroke_finalize (GObject *object)
 {
   GimpStroke *stroke = GIMP_STROKE (object);
 
+  gimp_stroke_invalidate_cache (stroke);
+
   if (stroke->anchors)
     {
       g_list_free_full (stroke->anchors, (GDestroyNotify) gimp_anchor_free);
@@ -353,10 +383,24 @@ gimp_stroke_get_memsize (GimpObject *object,
                          gint64     *gui_size)
 {
   GimpStroke *stroke  = GIMP_STROKE (object);
+  GList      *list;
   gint64      memsize = 0;
 
   memsize += gimp_g_list_get_memsize (stroke->anchors, sizeof (GimpAnchor));
 
+  if (stroke->bezier_desc)
+    *gui_size += gimp_bezier_desc_get_memsize (stroke->bezier_desc);
+
+  for (list = stroke->interpolations; list; list = g_list_next (list))
+    {
+      GimpStrokeInterpolation *interpolation = list->data;
+
+      *gui_size += sizeof (GList) + sizeof (GimpStrokeInterpolation);
+
+      if (interpolation->coords)
+        *gui_size += interpolation->coords->len * sizeof (GimpCoords);
+    }
+
   return memsize + GIMP_OBJECT_CLASS (parent_class)->get_memsize (object,
                                                                   gui_size);
 }
@@ -413,6 +457,52 @@ gimp_stroke_nearest_point_get (const GimpStroke *stroke,
   return -1;
 }
 
+gdouble
+gimp_stroke_nearest_point_within (const GimpStroke *stroke,
+                                  const GimpCoords *coord,
+                                  const gdouble     precision,
+                                  gdouble           max_dist,
+                                  GimpCoords       *ret_point,
+                                  GimpAnchor      **ret_segment_start,
+                                  GimpAnchor      **ret_segment_end,
+                                  gdouble          *ret_pos)
+{
+  GimpStrokeIndex *index;
+  gdouble          x1, y1, x2, y2;
+  GimpCoords       point;
+  GimpAnchor      *segment_start;
+  GimpAnchor      *segment_end;
+  gdouble          pos;
+  gdouble          dist;
+
+  g_return_val_if_fail (GIMP_IS_STROKE (stroke), -1.0);
+  g_return_val_if_fail (coord != NULL, -1.0);
+
+  /*  the curve lies within the bounds of its control points, so a
+   *  stroke whose anchors are all far away can be skipped right away
+   */
+  index = gimp_stroke_get_anchor_index (stroke);
+
+  if (! gimp_stroke_index_get_bounds (index, &x1, &y1, &x2, &y2) ||
+      coord->x < x1 - max_dist || coord->x > x2 + max_dist ||
+      coord->y < y1 - max_dist || coord->y > y2 + max_dist)
+    return -1.0;
+
+  dist = gimp_stroke_nearest_point_get (stroke, coord, precision,
+                                        &point, &segment_start, &segment_end,
+                                        &pos);
+
+  if (dist < 0 || dist > max_dist)
+    return -1.0;
+
+  if (ret_point)         *ret_point         = point;
+  if (ret_segment_start) *ret_segment_start = segment_start;
+  if (ret_segment_end)   *ret_segment_end   = segment_end;
+  if (ret_pos)           *ret_pos           = pos;
+
+  return dist;
+}
+
 gdouble
 gimp_stroke_nearest_tangent_get   (const GimpStroke      *stroke,
                                    const GimpCoords      *coords1,
@@ -594,6 +684,8 @@ gimp_stroke_anchor_move_relative (GimpStroke            *stroke,
 
   GIMP_STROKE_GET_CLASS (stroke)->anchor_move_relative (stroke, anchor,
                                                         delta, feature);
+
+  gimp_stroke_invalidate_cache (stroke);
 }
 
 static void
@@ -619,6 +711,8 @@ gimp_stroke_anchor_move_absolute (GimpStroke            *stroke,
 
   GIMP_STROKE_GET_CLASS (stroke)->anchor_move_absolute (stroke, anchor,
                                                         coord, feature);
+
+  gimp_stroke_invalidate_cache (stroke);
 }
 
 static void
@@ -664,6 +758,8 @@ gimp_stroke_point_move_relative (GimpStroke            *stroke,
   GIMP_STROKE_GET_CLASS (stroke)->point_move_relative (stroke, predec,
                                                        position, deltacoord,
                                                        feature);
+
+  gimp_stroke_invalidate_cache (stroke);
 }
 
 
@@ -690,6 +786,8 @@ gimp_stroke_point_move_absolute (GimpStroke            *stroke,
   GIMP_STROKE_GET_CLASS (stroke)->point_move_absolute (stroke, predec,
                                                        position, coord,
                                                        feature);
+
+  gimp_stroke_invalidate_cache (stroke);
 }
 
 static void
@@ -710,6 +808,8 @@ gimp_stroke_close (GimpStroke *stroke)
   g_return_if_fail (stroke->anchors != NULL);
 
   GIMP_STROKE_GET_CLASS (stroke)->close (stroke);
+
+  gimp_stroke_invalidate_cache (stroke);
 }
 
 static void
@@ -728,6 +828,8 @@ gimp_stroke_anchor_convert (GimpStroke            *stroke,
   g_return_if_fail (GIMP_IS_STROKE (stroke));
 
   GIMP_STROKE_GET_CLASS (stroke)->anchor_convert (stroke, anchor, feature);
+
+  gimp_stroke_invalidate_cache (stroke);
 }
 
 static void
@@ -747,6 +849,8 @@ gimp_stroke_anchor_delete (GimpStroke *stroke,
   g_return_if_fail (anchor && anchor->type == GIMP_ANCHOR_ANCHOR);
 
   GIMP_STROKE_GET_CLASS (stroke)->anchor_delete (stroke, anchor);
+
+  gimp_stroke_invalidate_cache (stroke);
 }
 
 static void
@@ -760,11 +864,17 @@ GimpStroke *
 gimp_stroke_open (GimpStroke *stroke,
                   GimpAnchor *end_anchor)
 {
+  GimpStroke *new_stroke;
+
   g_return_val_if_fail (GIMP_IS_STROKE (stroke), NULL);
   g_return_val_if_fail (end_anchor &&
                         end_anchor->type == GIMP_ANCHOR_ANCHOR, NULL);
 
-  return GIMP_STROKE_GET_CLASS (stroke)->open (stroke, end_anchor);
+  new_stroke = GIMP_STROKE_GET_CLASS (stroke)->open (stroke, end_anchor);
+
+  gimp_stroke_invalidate_cache (stroke);
+
+  return new_stroke;
 }
 
 static GimpStroke *
@@ -802,11 +912,17 @@ gimp_stroke_anchor_insert (GimpStroke *stroke,
                            GimpAnchor *predec,
                            gdouble     position)
 {
+  GimpAnchor *anchor;
+
   g_return_val_if_fail (GIMP_IS_STROKE (stroke), NULL);
   g_return_val_if_fail (predec->type == GIMP_ANCHOR_ANCHOR, NULL);
 
-  return GIMP_STROKE_GET_CLASS (stroke)->anchor_insert (stroke,
-                                                        predec, position);
+  anchor = GIMP_STROKE_GET_CLASS (stroke)->anchor_insert (stroke,
+                                                          predec, position);
+
+  gimp_stroke_invalidate_cache (stroke);
+
+  return anchor;
 }
 
 static GimpAnchor *
@@ -843,11 +959,17 @@ gimp_stroke_extend (GimpStroke           *stroke,
                     GimpAnchor           *neighbor,
                     GimpVectorExtendMode  extend_mode)
 {
+  GimpAnchor *anchor;
+
   g_return_val_if_fail (GIMP_IS_STROKE (stroke), NULL);
   g_return_val_if_fail (!stroke->closed, NULL);
 
-  return GIMP_STROKE_GET_CLASS (stroke)->extend (stroke, coords,
-                                                 neighbor, extend_mode);
+  anchor = GIMP_STROKE_GET_CLASS (stroke)->extend (stroke, coords,
+                                                   neighbor, extend_mode);
+
+  gimp_stroke_invalidate_cache (stroke);
+
+  return anchor;
 }
 
 static GimpAnchor *
@@ -866,13 +988,21 @@ gimp_stroke_connect_stroke (GimpStroke *stroke,
                             GimpStroke *extension,
                             GimpAnchor *neighbor)
 {
+  gboolean success;
+
   g_return_val_if_fail (GIMP_IS_STROKE (stroke), FALSE);
   g_return_val_if_fail (GIMP_IS_STROKE (extension), FALSE);
   g_return_val_if_fail (stroke->closed == FALSE &&
                         extension->closed == FALSE, FALSE);
 
-  return GIMP_STROKE_GET_CLASS (stroke)->connect_stroke (stroke, anchor,
-                                                         extension, neighbor);
+  success = GIMP_STROKE_GET_CLASS (stroke)->connect_stroke (stroke, anchor,
+                                                            extension,
+                                                            neighbor);
+
+  gimp_stroke_invalidate_cache (stroke);
+  gimp_stroke_invalidate_cache (extension);
+
+  return success;
 }
 
 gboolean
@@ -900,6 +1030,103 @@ gimp_stroke_real_is_empty (const GimpStroke *stroke)
 }
 
 
+void
+gimp_stroke_invalidate_cache (GimpStroke *stroke)
+{
+  g_return_if_fail (GIMP_IS_STROKE (stroke));
+
+  if (stroke->anchor_index)
+    {
+      gimp_stroke_index_free (stroke->anchor_index);
+      stroke->anchor_index = NULL;
+    }
+
+  if (stroke->segment_index)
+    {
+      gimp_stroke_index_free (stroke->segment_index);
+      stroke->segment_index = NULL;
+    }
+
+  if (stroke->bezier_desc)
+    {
+      gimp_bezier_desc_free (stroke->bezier_desc);
+      stroke->bezier_desc = NULL;
+    }
+
+  if (stroke->interpolations)
+    {
+      g_list_free_full (stroke->interpolations,
+                        (GDestroyNotify) gimp_stroke_interpolation_free);
+      stroke->interpolations = NULL;
+    }
+}
+
+static GimpStrokeIndex *
+gimp_stroke_get_anchor_index (const GimpStroke *stroke)
+{
+  if (! stroke->anchor_index)
+    {
+      GimpStrokeIndex *index = gimp_stroke_index_new (NULL);
+      GList           *list;
+
+      for (list = stroke->anchors; list; list = g_list_next (list))
+        {
+          GimpAnchor *anchor = list->data;
+
+          gimp_stroke_index_add (index,
+                                 anchor->position.x, anchor->position.y,
+                                 anchor->position.x, anchor->position.y,
+                                 list);
+        }
+
+      ((GimpStroke *) stroke)->anchor_index = index;
+    }
+
+  return stroke->anchor_index;
+}
+
+/*  returns the list items of all anchors within radius of coord, in
+ *  the order of stroke->anchors
+ */
+static GList *
+gimp_stroke_get_anchors_near (const GimpStroke *stroke,
+                              const GimpCoords *coord,
+                              gdouble           radius)
+{
+  GimpStrokeIndex *index = gimp_stroke_get_anchor_index (stroke);
+  GArray          *items;
+  GList           *ret_list = NULL;
+  gint             i;
+
+  items = g_array_new (FALSE, FALSE, sizeof (gint));
+
+  gimp_stroke_index_query (index,
+                           coord->x - radius, coord->y - radius,
+                           coord->x + radius, coord->y + radius,
+                           items);
+
+  for (i = items->len - 1; i >= 0; i--)
+    {
+      GList      *list;
+      GimpAnchor *anchor;
+
+      list   = gimp_stroke_index_get_data (index,
+                                           g_array_index (items, gint, i));
+      anchor = list->data;
+
+      if (SQR (anchor->position.x - coord->x) +
+          SQR (anchor->position.y - coord->y) <= SQR (radius))
+        {
+          ret_list = g_list_prepend (ret_list, list);
+        }
+    }
+
+  g_array_free (items, TRUE);
+
+  return ret_list;
+}
+
+
 gdouble
 gimp_stroke_get_length (const GimpStroke *stroke,
                         const gdouble     precision)
@@ -965,10 +1192,77 @@ gimp_stroke_interpolate (const GimpStroke *stroke,
                          gdouble           precision,
                          gboolean         *ret_closed)
 {
+  GimpStroke              *cache = (GimpStroke *) stroke;
+  GimpStrokeInterpolation *interpolation;
+  GList                   *list;
+
   g_return_val_if_fail (GIMP_IS_STROKE (stroke), NULL);
 
-  return GIMP_STROKE_GET_CLASS (stroke)->interpolate (stroke, precision,
-                                                      ret_closed);
+  for (list = cache->interpolations; list; list = g_list_next (list))
+    {
+      interpolation = list->data;
+
+      if (interpolation->precision == precision)
+        {
+          /*  move to the front, so the least recently used goes first  */
+          cache->interpolations = g_list_remove_link (cache->interpolations,
+                                                      list);
+          cache->interpolations = g_list_concat (list, cache->interpolations);
+
+          if (ret_closed)
+            *ret_closed = interpolation->closed;
+
+          return gimp_stroke_coords_copy (interpolation->coords);
+        }
+    }
+
+  interpolation = g_slice_new (GimpStrokeInterpolation);
+
+  interpolation->precision = precision;
+  interpolation->closed    = FALSE;
+  interpolation->coords    =
+    GIMP_STROKE_GET_CLASS (stroke)->interpolate (stroke, precision,
+                                                 &interpolation->closed);
+
+  cache->interpolations = g_list_prepend (cache->interpolations,
+                                          interpolation);
+
+  if (g_list_length (cache->interpolations) > MAX_CACHED_INTERPOLATIONS)
+    {
+      list = g_list_last (cache->interpolations);
+
+      gimp_stroke_interpolation_free (list->data);
+      cache->interpolations = g_list_delete_link (cache->interpolations,
+                                                  list);
+    }
+
+  if (ret_closed)
+    *ret_closed = interpolation->closed;
+
+  return gimp_stroke_coords_copy (interpolation->coords);
+}
+
+static void
+gimp_stroke_interpolation_free (GimpStrokeInterpolation *interpolation)
+{
+  if (interpolation->coords)
+    g_array_free (interpolation->coords, TRUE);
+
+  g_slice_free (GimpStrokeInterpolation, interpolation);
+}
+
+static GArray *
+gimp_stroke_coords_copy (GArray *coords)
+{
+  GArray *copy;
+
+  if (! coords)
+    return NULL;
+
+  copy = g_array_sized_new (FALSE, FALSE, sizeof (GimpCoords), coords->len);
+  g_array_append_vals (copy, coords->data, coords->len);
+
+  return copy;
 }
 
 static GArray *
@@ -1016,9 +1310,27 @@ gimp_stroke_real_duplicate (const GimpStroke *stroke)
 GimpBezierDesc *
 gimp_stroke_make_bezier (const GimpStroke *stroke)
 {
+  const GimpBezierDesc *desc;
+
   g_return_val_if_fail (GIMP_IS_STROKE (stroke), NULL);
 
-  return GIMP_STROKE_GET_CLASS (stroke)->make_bezier (stroke);
+  desc = gimp_stroke_get_bezier (stroke);
+
+  return desc ? gimp_bezier_desc_copy (desc) : NULL;
+}
+
+const GimpBezierDesc *
+gimp_stroke_get_bezier (const GimpStroke *stroke)
+{
+  g_return_val_if_fail (GIMP_IS_STROKE (stroke), NULL);
+
+  if (! stroke->bezier_desc)
+    {
+      ((GimpStroke *) stroke)->bezier_desc =
+        GIMP_STROKE_GET_CLASS (stroke)->make_bezier (stroke);
+    }
+
+  return stroke->bezier_desc;
 }
 
 static GimpBezierDesc *
@@ -1038,6 +1350,8 @@ gimp_stroke_translate (GimpStroke *stroke,
   g_return_if_fail (GIMP_IS_STROKE (stroke));
 
   GIMP_STROKE_GET_CLASS (stroke)->translate (stroke, offset_x, offset_y);
+
+  gimp_stroke_invalidate_cache (stroke);
 }
 
 static void
@@ -1065,6 +1379,8 @@ gimp_stroke_scale (GimpStroke *stroke,
   g_return_if_fail (GIMP_IS_STROKE (stroke));
 
   GIMP_STROKE_GET_CLASS (stroke)->scale (stroke, scale_x, scale_y);
+
+  gimp_stroke_invalidate_cache (stroke);
 }
 
 static void
@@ -1092,6 +1408,8 @@ gimp_stroke_rotate (GimpStroke *stroke,
   g_return_if_fail (GIMP_IS_STROKE (stroke));
 
   GIMP_STROKE_GET_CLASS (stroke)->rotate (stroke, center_x, center_y, angle);
+
+  gimp_stroke_invalidate_cache (stroke);
 }
 
 static void
@@ -1117,6 +1435,8 @@ gimp_stroke_flip   (GimpStroke          *stroke,
   g_return_if_fail (GIMP_IS_STROKE (stroke));
 
   GIMP_STROKE_GET_CLASS (stroke)->flip (stroke, flip_type, axis);
+
+  gimp_stroke_invalidate_cache (stroke);
 }
 
 static void
@@ -1141,6 +1461,8 @@ gimp_stroke_flip_free   (GimpStroke          *stroke,
   g_return_if_fail (GIMP_IS_STROKE (stroke));
 
   GIMP_STROKE_GET_CLASS (stroke)->flip_free (stroke, x1, y1, x2, y2);
+
+  gimp_stroke_invalidate_cache (stroke);
 }
 
 static void
@@ -1166,6 +1488,8 @@ gimp_stroke_transform (GimpStroke        *stroke,
   g_return_if_fail (GIMP_IS_STROKE (stroke));
 
   GIMP_STROKE_GET_CLASS (stroke)->transform (stroke, matrix);
+
+  gimp_stroke_invalidate_cache (stroke);
 }
 
 static void
@@ -1226,35 +1550,134 @@ gimp_stroke_real_get_draw_controls (const GimpStroke  *stroke)
   GList *ret_list = NULL;
 
   for (list = stroke->anchors; list; list = g_list_next (list))
+    ret_list = gimp_stroke_draw_control_add (ret_list, list);
+
+  return g_list_reverse (ret_list);
+}
+
+static GList *
+gimp_stroke_draw_control_add (GList *ret_list,
+                              GList *list)
+{
+  GimpAnchor *anchor = list->data;
+
+  if (anchor->type == GIMP_ANCHOR_CONTROL)
     {
-      GimpAnchor *anchor = list->data;
+      GimpAnchor *next = list->next ? list->next->data : NULL;
+      GimpAnchor *prev = list->prev ? list->prev->data : NULL;
 
-      if (anchor->type == GIMP_ANCHOR_CONTROL)
+      if (next && next->type == GIMP_ANCHOR_ANCHOR && next->selected)
+        {
+          /* Ok, this is a hack.
+           * The idea is to give control points at the end of a
+           * stroke a higher priority for the interactive tool. */
+          if (prev)
+            ret_list = g_list_prepend (ret_list, anchor);
+          else
+            ret_list = g_list_append (ret_list, anchor);
+        }
+      else if (prev && prev->type == GIMP_ANCHOR_ANCHOR && prev->selected)
         {
-          GimpAnchor *next = list->next ? list->next->data : NULL;
-          GimpAnchor *prev = list->prev ? list->prev->data : NULL;
+          /* same here... */
+          if (next)
+            ret_list = g_list_prepend (ret_list, anchor);
+          else
+            ret_list = g_list_append (ret_list, anchor);
+        }
+    }
 
-          if (next && next->type == GIMP_ANCHOR_ANCHOR && next->selected)
-            {
-              /* Ok, this is a hack.
-               * The idea is to give control points at the end of a
-               * stroke a higher priority for the interactive tool. */
-              if (prev)
-                ret_list = g_list_prepend (ret_list, anchor);
-              else
-                ret_list = g_list_append (ret_list, anchor);
-            }
-          else if (prev && prev->type == GIMP_ANCHOR_ANCHOR && prev->selected)
-            {
-              /* same here... */
-              if (next)
-                ret_list = g_list_prepend (ret_list, anchor);
-              else
-                ret_list = g_list_append (ret_list, anchor);
-            }
+  return ret_list;
+}
+
+
+/*  the _near() variants return the same anchors as the functions
+ *  above, in the same order, but only those within radius of coord
+ */
+
+GList *
+gimp_stroke_get_draw_anchors_near (const GimpStroke *stroke,
+                                   const GimpCoords *coord,
+                                   gdouble           radius)
+{
+  GList *near_list;
+  GList *list;
+  GList *ret_list = NULL;
+
+  g_return_val_if_fail (GIMP_IS_STROKE (stroke), NULL);
+  g_return_val_if_fail (coord != NULL, NULL);
+
+  if (GIMP_STROKE_GET_CLASS (stroke)->get_draw_anchors !=
+      gimp_stroke_real_get_draw_anchors)
+    {
+      near_list = gimp_stroke_get_draw_anchors (stroke);
+
+      for (list = near_list; list; list = g_list_next (list))
+        {
+          GimpAnchor *anchor = list->data;
+
+          if (SQR (anchor->position.x - coord->x) +
+              SQR (anchor->position.y - coord->y) <= SQR (radius))
+            ret_list = g_list_prepend (ret_list, anchor);
+        }
+
+      g_list_free (near_list);
+
+      return g_list_reverse (ret_list);
+    }
+
+  near_list = gimp_stroke_get_anchors_near (stroke, coord, radius);
+
+  for (list = near_list; list; list = g_list_next (list))
+    {
+      GimpAnchor *anchor = GIMP_ANCHOR (((GList *) list->data)->data);
+
+      if (anchor->type == GIMP_ANCHOR_ANCHOR)
+        ret_list = g_list_prepend (ret_list, anchor);
+    }
+
+  g_list_free (near_list);
+
+  return g_list_reverse (ret_list);
+}
+
+GList *
+gimp_stroke_get_draw_controls_near (const GimpStroke *stroke,
+                                    const GimpCoords *coord,
+                                    gdouble           radius)
+{
+  GList *near_list;
+  GList *list;
+  GList *ret_list = NULL;
+
+  g_return_val_if_fail (GIMP_IS_STROKE (stroke), NULL);
+  g_return_val_if_fail (coord != NULL, NULL);
+
+  if (GIMP_STROKE_GET_CLASS (stroke)->get_draw_controls !=
+      gimp_stroke_real_get_draw_controls)
+    {
+      near_list = gimp_stroke_get_draw_controls (stroke);
+
+      for (list = near_list; list; list = g_list_next (list))
+        {
+          GimpAnchor *anchor = list->data;
+
+          if (SQR (anchor->position.x - coord->x) +
+              SQR (anchor->position.y - coord->y) <= SQR (radius))
+            ret_list = g_list_prepend (ret_list, anchor);
         }
+
+      g_list_free (near_list);
+
+      return g_list_reverse (ret_list);
     }
 
+  near_list = gimp_stroke_get_anchors_near (stroke, coord, radius);
+
+  for (list = near_list; list; list = g_list_next (list))
+    ret_list = gimp_stroke_draw_control_add (ret_list, list->data);
+
+  g_list_free (near_list);
+
   return g_list_reverse (ret_list);
 }
 
@@ -36,12 +36,18 @@ typedef struct _GimpStrokeClass GimpStrokeClass;
 
 struct _GimpStroke
 {
-  GimpObject  parent_instance;
-  gint        ID;
+  GimpObject       parent_instance;
+  gint             ID;
 
-  GList      *anchors;
+  GList           *anchors;
 
-  gboolean    closed;
+  gboolean         closed;
+
+  GimpStrokeIndex *anchor_index;   /* Cached spatial index of the anchors  */
+  GimpStrokeIndex *segment_index;  /* Cached spatial index of the segments */
+
+  GimpBezierDesc  *bezier_desc;    /* Cached bezier representation         */
+  GList           *interpolations; /* Cached polylines, most recent first  */
 };
 
 struct _GimpStrokeClass
@@ -218,6 +224,18 @@ gdouble  gimp_stroke_nearest_intersection_get (const GimpStroke      *stroke,
                                                GimpAnchor           **ret_segment_end,
                                                gdouble               *ret_pos);
 
+/* like gimp_stroke_nearest_point_get(), but returns -1 when no point of
+ * the stroke is closer than max_dist
+ */
+gdouble      gimp_stroke_nearest_point_within (const GimpStroke      *stroke,
+                                               const GimpCoords      *coord,
+                                               const gdouble          precision,
+                                               gdouble                max_dist,
+                                               GimpCoords            *ret_point,
+                                               GimpAnchor           **ret_segment_start,
+                                               GimpAnchor           **ret_segment_end,
+                                               gdouble               *ret_pos);
+
 
 /* prev == NULL: "first" anchor */
 GimpAnchor * gimp_stroke_anchor_get_next      (const GimpStroke      *stroke,
@@ -288,6 +306,11 @@ gboolean     gimp_stroke_connect_stroke       (GimpStroke            *stroke,
 
 gboolean     gimp_stroke_is_empty             (const GimpStroke      *stroke);
 
+/* drops the cached spatial indices and flattened curves, call after
+ * modifying the anchors without going through the functions above
+ */
+void         gimp_stroke_invalidate_cache     (GimpStroke            *stroke);
+
 /* accessing the shape of the curve */
 
 gdouble      gimp_stroke_get_length           (const GimpStroke      *stroke,
@@ -310,6 +333,7 @@ GimpStroke * gimp_stroke_duplicate            (const GimpStroke      *stroke);
 
 /* creates a bezier approximation. */
 GimpBezierDesc * gimp_stroke_make_bezier      (const GimpStroke      *stroke);
+const GimpBezierDesc * gimp_stroke_get_bezier (const GimpStroke      *stroke);
 
 void         gimp_stroke_translate            (GimpStroke            *stroke,
                                                gdouble                offset_x,
@@ -335,6 +359,12 @@ void         gimp_stroke_transform            (GimpStroke            *stroke,
 
 GList      * gimp_stroke_get_draw_anchors     (const GimpStroke      *stroke);
 GList      * gimp_stroke_get_draw_controls    (const GimpStroke      *stroke);
+GList      * gimp_stroke_get_draw_anchors_near  (const GimpStroke    *stroke,
+                                                 const GimpCoords    *coord,
+                                                 gdouble              radius);
+GList      * gimp_stroke_get_draw_controls_near (const GimpStroke    *stroke,
+                                                 const GimpCoords    *coord,
+                                                 gdouble              radius);
 GArray     * gimp_stroke_get_draw_lines       (const GimpStroke      *stroke);
 
 #endif /* __GIMP_STROKE_H__ */
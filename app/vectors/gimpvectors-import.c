@@ -80,7 +80,7 @@ struct _SvgHandler
   gdouble       width;
   gdouble       height;
   gchar        *id;
-  GList        *paths;
+  GList        *paths;      /* in reverse document order */
   GimpMatrix3  *transform;
 };
 
@@ -322,8 +322,7 @@ gimp_vectors_import (GimpImage    *image,
       if (base->paths)
         {
           GimpVectors *vectors = NULL;
-
-          base->paths = g_list_reverse (base->paths);
+          GList       *merged  = NULL;
 
           merge = merge && base->paths->next;
 
@@ -333,7 +332,6 @@ gimp_vectors_import (GimpImage    *image,
           for (paths = base->paths; paths; paths = paths->next)
             {
               SvgPath *path = paths->data;
-              GList   *list;
 
               if (! merge || ! vectors)
                 {
@@ -351,18 +349,32 @@ gimp_vectors_import (GimpImage    *image,
                     position++;
                 }
 
-              for (list = path->strokes; list; list = list->next)
-                gimp_vectors_stroke_add (vectors, GIMP_STROKE (list->data));
+              if (merge)
+                {
+                  /*  collect all strokes, so they are added in one go  */
+                  merged = g_list_concat (g_list_reverse (path->strokes),
+                                          merged);
+                  path->strokes = NULL;
+
+                  continue;
+                }
 
-              if (! merge)
-                gimp_vectors_thaw (vectors);
+              gimp_vectors_stroke_add_list (vectors, path->strokes);
+              gimp_vectors_thaw (vectors);
 
               g_list_free_full (path->strokes, g_object_unref);
               path->strokes = NULL;
             }
 
           if (merge)
-            gimp_vectors_thaw (vectors);
+            {
+              merged = g_list_reverse (merged);
+
+              gimp_vectors_stroke_add_list (vectors, merged);
+              gimp_vectors_thaw (vectors);
+
+              g_list_free_full (merged, g_object_unref);
+            }
 
           gimp_image_undo_group_end (image);
         }
@@ -492,8 +504,11 @@ svg_parser_end_element (GMarkupParseContext  *context,
           g_slice_free (GimpMatrix3, handler->transform);
         }
 
+      /*  both lists are in reverse order, so this only walks the
+       *  (usually short) list of the element that just ended
+       */
       base = g_queue_peek_head (parser->stack);
-      base->paths = g_list_concat (base->paths, handler->paths);
+      base->paths = g_list_concat (handler->paths, base->paths);
     }
 
   g_slice_free (SvgHandler, handler);
@@ -1448,7 +1463,10 @@ parse_path_data (const gchar *data)
         {
           /* end of number */
 
-          val *= sign * pow (10, exp_sign * exp);
+          if (exp)
+            val *= sign * pow (10, exp_sign * exp);
+          else
+            val *= sign;
 
           if (ctx.rel)
             {
@@ -147,6 +147,8 @@ gimp_vectors_warp_stroke (const GimpVectors *vectors,
                                &anchor->position, &anchor->position,
                                y_offset);
     }
+
+  gimp_stroke_invalidate_cache (stroke);
 }
 
 void
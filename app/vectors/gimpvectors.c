@@ -751,6 +751,46 @@ gimp_vectors_stroke_add (GimpVectors *vectors,
   gimp_vectors_thaw (vectors);
 }
 
+/*  adds all strokes in the list, in order, without walking
+ *  vectors->strokes once per stroke
+ */
+void
+gimp_vectors_stroke_add_list (GimpVectors *vectors,
+                              GList       *strokes)
+{
+  GList *list;
+
+  g_return_if_fail (GIMP_IS_VECTORS (vectors));
+
+  gimp_vectors_freeze (vectors);
+
+  if (GIMP_VECTORS_GET_CLASS (vectors)->stroke_add ==
+      gimp_vectors_real_stroke_add)
+    {
+      GList *new_strokes = NULL;
+
+      for (list = strokes; list; list = g_list_next (list))
+        {
+          GimpStroke *stroke = list->data;
+
+          vectors->last_stroke_ID ++;
+          gimp_stroke_set_ID (stroke, vectors->last_stroke_ID);
+
+          new_strokes = g_list_prepend (new_strokes, g_object_ref (stroke));
+        }
+
+      vectors->strokes = g_list_concat (vectors->strokes,
+                                        g_list_reverse (new_strokes));
+    }
+  else
+    {
+      for (list = strokes; list; list = g_list_next (list))
+        GIMP_VECTORS_GET_CLASS (vectors)->stroke_add (vectors, list->data);
+    }
+
+  gimp_vectors_thaw (vectors);
+}
+
 static void
 gimp_vectors_real_stroke_add (GimpVectors *vectors,
                               GimpStroke  *stroke)
@@ -1153,14 +1193,11 @@ gimp_vectors_real_make_bezier (const GimpVectors *vectors)
        stroke;
        stroke = gimp_vectors_stroke_get_next (vectors, stroke))
     {
-      GimpBezierDesc *bezdesc = gimp_stroke_make_bezier (stroke);
+      const GimpBezierDesc *bezdesc = gimp_stroke_get_bezier (stroke);
 
       if (bezdesc)
-        {
-          cmd_array = g_array_append_vals (cmd_array, bezdesc->data,
-                                           bezdesc->num_data);
-          gimp_bezier_desc_free (bezdesc);
-        }
+        cmd_array = g_array_append_vals (cmd_array, bezdesc->data,
+                                         bezdesc->num_data);
     }
 
   if (cmd_array->len > 0)
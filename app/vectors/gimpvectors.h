@@ -145,6 +145,8 @@ void          gimp_vectors_anchor_select        (GimpVectors        *vectors,
 
 void            gimp_vectors_stroke_add         (GimpVectors        *vectors,
                                                  GimpStroke         *stroke);
+void            gimp_vectors_stroke_add_list    (GimpVectors        *vectors,
+                                                 GList              *strokes);
 void            gimp_vectors_stroke_remove      (GimpVectors        *vectors,
                                                  GimpStroke         *stroke);
 gint            gimp_vectors_get_n_strokes      (const GimpVectors  *vectors);
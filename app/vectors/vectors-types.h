@@ -35,6 +35,7 @@ typedef struct _GimpVectorsModUndo  GimpVectorsModUndo;
 typedef struct _GimpVectorsPropUndo GimpVectorsPropUndo;
 typedef struct _GimpStroke          GimpStroke;
 typedef struct _GimpBezierStroke    GimpBezierStroke;
+typedef struct _GimpStrokeIndex     GimpStrokeIndex;
 
 
 #endif /* __VECTORS_TYPES_H__ */
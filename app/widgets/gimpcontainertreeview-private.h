@@ -39,6 +39,8 @@ struct _GimpContainerTreeViewPriv
   guint               scroll_timeout_interval;
   GdkScrollDirection  scroll_dir;
 
+  guint               release_previews_id;
+
   gboolean            dnd_drop_to_empty;
 };
 
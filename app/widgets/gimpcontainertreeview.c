@@ -47,6 +47,9 @@
 #include "gimpwidgets-utils.h"
 
 
+#define RELEASE_PREVIEWS_DELAY 500
+
+
 enum
 {
   EDIT_NAME,
@@ -54,6 +57,14 @@ enum
 };
 
 
+typedef struct
+{
+  GimpContainerTreeView *tree_view;
+  GtkTreePath           *start;
+  GtkTreePath           *end;
+} ReleasePreviewsData;
+
+
 static void          gimp_container_tree_view_view_iface_init   (GimpContainerViewInterface  *iface);
 
 static void          gimp_container_tree_view_constructed       (GObject                     *object);
@@ -127,6 +138,14 @@ static void          gimp_container_tree_view_expand_rows         (GtkTreeModel
                                                                    GtkTreeView              *view,
                                                                    GtkTreeIter              *parent);
 
+static void          gimp_container_tree_view_queue_release       (GimpContainerTreeView     *tree_view);
+static gboolean      gimp_container_tree_view_release_timeout     (GimpContainerTreeView     *tree_view);
+static void          gimp_container_tree_view_release_previews    (GimpContainerTreeView     *tree_view);
+static gboolean      gimp_container_tree_view_release_foreach     (GtkTreeModel              *model,
+                                                                   GtkTreePath               *path,
+                                                                   GtkTreeIter               *iter,
+                                                                   gpointer                   data);
+
 
 G_DEFINE_TYPE_WITH_CODE (GimpContainerTreeView, gimp_container_tree_view,
                          GIMP_TYPE_CONTAINER_BOX,
@@ -312,6 +331,13 @@ gimp_container_tree_view_constructed (GObject *object)
   g_signal_connect (tree_view->view, "query-tooltip",
                     G_CALLBACK (gimp_container_tree_view_tooltip),
                     tree_view);
+
+  /*  only keep previews of the rows which are actually shown  */
+  g_signal_connect_object (gtk_scrolled_window_get_vadjustment (GTK_SCROLLED_WINDOW (box->scrolled_win)),
+                           "value-changed",
+                           G_CALLBACK (gimp_container_tree_view_queue_release),
+                           tree_view,
+                           G_CONNECT_SWAPPED);
 }
 
 static void
@@ -319,6 +345,12 @@ gimp_container_tree_view_finalize (GObject *object)
 {
   GimpContainerTreeView *tree_view = GIMP_CONTAINER_TREE_VIEW (object);
 
+  if (tree_view->priv->release_previews_id)
+    {
+      g_source_remove (tree_view->priv->release_previews_id);
+      tree_view->priv->release_previews_id = 0;
+    }
+
   if (tree_view->model)
     {
       g_object_unref (tree_view->model);
@@ -358,6 +390,9 @@ gimp_container_tree_view_unmap (GtkWidget *widget)
     }
 
   GTK_WIDGET_CLASS (parent_class)->unmap (widget);
+
+  /*  nothing is shown, drop all previews  */
+  gimp_container_tree_view_release_previews (tree_view);
 }
 
 static void
@@ -1420,3 +1455,86 @@ gimp_container_tree_view_expand_rows (GtkTreeModel *model,
         }
     while (gtk_tree_model_iter_next (model, &iter));
 }
+
+static void
+gimp_container_tree_view_queue_release (GimpContainerTreeView *tree_view)
+{
+  if (tree_view->priv->release_previews_id)
+    g_source_remove (tree_view->priv->release_previews_id);
+
+  tree_view->priv->release_previews_id =
+    g_timeout_add (RELEASE_PREVIEWS_DELAY,
+                   (GSourceFunc) gimp_container_tree_view_release_timeout,
+                   tree_view);
+}
+
+static gboolean
+gimp_container_tree_view_release_timeout (GimpContainerTreeView *tree_view)
+{
+  tree_view->priv->release_previews_id = 0;
+
+  gimp_container_tree_view_release_previews (tree_view);
+
+  return FALSE;
+}
+
+/*  drops the rendered previews of all rows outside the visible range,
+ *  they are rendered again on demand when scrolled back into view
+ */
+static void
+gimp_container_tree_view_release_previews (GimpContainerTreeView *tree_view)
+{
+  ReleasePreviewsData data = { tree_view, NULL, NULL };
+
+  if (! tree_view->model)
+    return;
+
+  if (gtk_widget_get_mapped (GTK_WIDGET (tree_view->view)))
+    gtk_tree_view_get_visible_range (tree_view->view, &data.start, &data.end);
+
+  gtk_tree_model_foreach (tree_view->model,
+                          gimp_container_tree_view_release_foreach,
+                          &data);
+
+  if (data.start)
+    gtk_tree_path_free (data.start);
+
+  if (data.end)
+    gtk_tree_path_free (data.end);
+}
+
+static gboolean
+gimp_container_tree_view_release_foreach (GtkTreeModel *model,
+                                          GtkTreePath  *path,
+                                          GtkTreeIter  *iter,
+                                          gpointer      data)
+{
+  ReleasePreviewsData   *release   = data;
+  GimpContainerTreeView *tree_view = release->tree_view;
+  gint                   i;
+
+  if (release->start                                  &&
+      gtk_tree_path_compare (path, release->start) >= 0 &&
+      gtk_tree_path_compare (path, release->end)   <= 0)
+    return FALSE;
+
+  for (i = 0; i < tree_view->n_model_columns; i++)
+    {
+      if (tree_view->model_columns[i] == GIMP_TYPE_VIEW_RENDERER)
+        {
+          GimpViewRenderer *renderer;
+
+          gtk_tree_model_get (model, iter,
+                              i, &renderer,
+                              -1);
+
+          if (renderer)
+            {
+              gimp_view_renderer_free_preview (renderer);
+              g_object_unref (renderer);
+            }
+        }
+    }
+
+  return FALSE;
+}
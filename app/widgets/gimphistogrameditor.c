@@ -54,6 +54,13 @@ static void     gimp_histogram_editor_layer_changed (GimpImage           *image,
 static void     gimp_histogram_editor_frozen_update (GimpHistogramEditor *editor,
                                                      const GParamSpec    *pspec);
 static void     gimp_histogram_editor_update        (GimpHistogramEditor *editor);
+static void     gimp_histogram_editor_area_update   (GimpDrawable        *drawable,
+                                                     gint                 x,
+                                                     gint                 y,
+                                                     gint                 width,
+                                                     gint                 height,
+                                                     GimpHistogramEditor *editor);
+static void     gimp_histogram_editor_queue_update  (GimpHistogramEditor *editor);
 
 static gboolean gimp_histogram_editor_idle_update   (GimpHistogramEditor *editor);
 static gboolean gimp_histogram_menu_sensitivity     (gint                 value,
@@ -107,6 +114,7 @@ gimp_histogram_editor_init (GimpHistogramEditor *editor)
   editor->histogram    = NULL;
   editor->bg_histogram = NULL;
   editor->valid        = FALSE;
+  editor->recalculate  = TRUE;
   editor->idle_id      = 0;
   editor->box          = gimp_histogram_box_new ();
 
@@ -282,6 +290,9 @@ gimp_histogram_editor_set_image (GimpImageEditor *image_editor,
     {
       editor->histogram = gimp_histogram_new (TRUE);
 
+      /*  only rebin what changed while the user paints  */
+      gimp_histogram_set_incremental (editor->histogram, TRUE);
+
       gimp_histogram_view_set_histogram (view, editor->histogram);
 
       g_signal_connect_object (image, "mode-changed",
@@ -327,7 +338,7 @@ gimp_histogram_editor_layer_changed (GimpImage           *image,
                                             gimp_histogram_editor_menu_update,
                                             editor);
       g_signal_handlers_disconnect_by_func (editor->drawable,
-                                            gimp_histogram_editor_update,
+                                            gimp_histogram_editor_area_update,
                                             editor);
       g_signal_handlers_disconnect_by_func (editor->drawable,
                                             gimp_histogram_editor_frozen_update,
@@ -346,8 +357,8 @@ gimp_histogram_editor_layer_changed (GimpImage           *image,
                                G_CALLBACK (gimp_histogram_editor_frozen_update),
                                editor, G_CONNECT_SWAPPED);
       g_signal_connect_object (editor->drawable, "update",
-                               G_CALLBACK (gimp_histogram_editor_update),
-                               editor, G_CONNECT_SWAPPED);
+                               G_CALLBACK (gimp_histogram_editor_area_update),
+                               editor, 0);
       g_signal_connect_object (editor->drawable, "alpha-changed",
                                G_CALLBACK (gimp_histogram_editor_menu_update),
                                editor, G_CONNECT_SWAPPED);
@@ -372,10 +383,18 @@ gimp_histogram_editor_validate (GimpHistogramEditor *editor)
 {
   if (! editor->valid && editor->histogram)
     {
-      if (editor->drawable)
-        gimp_drawable_calculate_histogram (editor->drawable, editor->histogram);
-      else
+      if (! editor->drawable)
         gimp_histogram_clear_values (editor->histogram);
+      else if (! editor->recalculate && editor->update_area.width > 0)
+        gimp_drawable_calculate_histogram_area (editor->drawable,
+                                                editor->histogram,
+                                                &editor->update_area);
+      else
+        gimp_drawable_calculate_histogram (editor->drawable, editor->histogram);
+
+      editor->recalculate        = FALSE;
+      editor->update_area.width  = 0;
+      editor->update_area.height = 0;
 
       gimp_histogram_editor_info_update (editor);
 
@@ -419,6 +438,33 @@ gimp_histogram_editor_frozen_update (GimpHistogramEditor *editor,
 
 static void
 gimp_histogram_editor_update (GimpHistogramEditor *editor)
+{
+  editor->recalculate = TRUE;
+
+  gimp_histogram_editor_queue_update (editor);
+}
+
+static void
+gimp_histogram_editor_area_update (GimpDrawable        *drawable,
+                                   gint                 x,
+                                   gint                 y,
+                                   gint                 width,
+                                   gint                 height,
+                                   GimpHistogramEditor *editor)
+{
+  GeglRectangle area = { x, y, width, height };
+
+  if (editor->update_area.width > 0 && editor->update_area.height > 0)
+    gegl_rectangle_bounding_box (&editor->update_area,
+                                 &editor->update_area, &area);
+  else
+    editor->update_area = area;
+
+  gimp_histogram_editor_queue_update (editor);
+}
+
+static void
+gimp_histogram_editor_queue_update (GimpHistogramEditor *editor)
 {
   if (editor->idle_id)
     g_source_remove (editor->idle_id);
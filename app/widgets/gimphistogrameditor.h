@@ -42,6 +42,8 @@ struct _GimpHistogramEditor
 
   guint                 idle_id;
   gboolean              valid;
+  gboolean              recalculate;
+  GeglRectangle         update_area;
 
   GtkWidget            *menu;
   GtkWidget            *box;
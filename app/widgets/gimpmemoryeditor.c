@@ -0,0 +1,505 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimpmemoryeditor.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <gegl.h>
+#include <gtk/gtk.h>
+
+#include "libgimpcolor/gimpcolor.h"
+#include "libgimpbase/gimpbase.h"
+#include "libgimpwidgets/gimpwidgets.h"
+
+#include "widgets-types.h"
+
+#include "core/gimp.h"
+#include "core/gimp-tile-cache.h"
+#include "core/gimpimage.h"
+#include "core/gimplist.h"
+#include "core/gimpmemorymonitor.h"
+
+#include "gimpmemoryeditor.h"
+
+#include "gimp-intl.h"
+
+
+#define GRAPH_HEIGHT 80
+
+
+enum
+{
+  COLUMN_ID,
+  COLUMN_HAS_COLOR,
+  COLUMN_COLOR,
+  COLUMN_NAME,
+  COLUMN_SIZE,
+  N_COLUMNS
+};
+
+
+static void     gimp_memory_editor_map           (GtkWidget         *widget);
+
+static void     gimp_memory_editor_changed       (GimpMemoryMonitor *monitor,
+                                                  GimpMemoryEditor  *editor);
+static gboolean gimp_memory_editor_graph_expose  (GtkWidget         *widget,
+                                                  GdkEventExpose    *event,
+                                                  GimpMemoryEditor  *editor);
+
+static void     gimp_memory_editor_refresh       (GimpMemoryEditor  *editor);
+static void     gimp_memory_editor_add_usage     (GimpMemoryEditor  *editor,
+                                                  GimpImage         *image,
+                                                  const gchar       *id,
+                                                  const gchar       *name,
+                                                  gint               n_categories);
+static void     gimp_memory_editor_add_row       (GimpMemoryEditor  *editor,
+                                                  GtkTreeIter       *iter,
+                                                  GtkTreeIter       *parent,
+                                                  const gchar       *id,
+                                                  const GimpRGB     *color,
+                                                  const gchar       *name,
+                                                  gint64             size);
+static void     gimp_memory_editor_get_expanded  (GtkTreeView       *view,
+                                                  GtkTreePath       *path,
+                                                  GHashTable        *expanded);
+static void     gimp_memory_editor_set_expanded  (GimpMemoryEditor  *editor,
+                                                  GtkTreeIter       *parent,
+                                                  GHashTable        *expanded);
+
+
+G_DEFINE_TYPE (GimpMemoryEditor, gimp_memory_editor, GIMP_TYPE_EDITOR)
+
+#define parent_class gimp_memory_editor_parent_class
+
+
+static const GimpRGB category_colors[GIMP_MEMORY_N_CATEGORIES] =
+{
+  { 0.20, 0.40, 0.80, 1.0 }, /* layers      */
+  { 0.30, 0.70, 0.30, 1.0 }, /* channels    */
+  { 0.60, 0.40, 0.70, 1.0 }, /* paths       */
+  { 0.90, 0.60, 0.10, 1.0 }, /* undo        */
+  { 0.70, 0.70, 0.70, 1.0 }, /* undo swap   */
+  { 0.80, 0.25, 0.25, 1.0 }, /* projection  */
+  { 0.40, 0.70, 0.80, 1.0 }  /* temp bufs   */
+};
+
+
+static void
+gimp_memory_editor_class_init (GimpMemoryEditorClass *klass)
+{
+  GtkWidgetClass *widget_class = GTK_WIDGET_CLASS (klass);
+
+  widget_class->map = gimp_memory_editor_map;
+}
+
+static void
+gimp_memory_editor_init (GimpMemoryEditor *editor)
+{
+  GtkWidget         *frame;
+  GtkWidget         *scrolled_window;
+  GtkTreeViewColumn *column;
+  GtkCellRenderer   *cell;
+
+  frame = gtk_frame_new (NULL);
+  gtk_frame_set_shadow_type (GTK_FRAME (frame), GTK_SHADOW_IN);
+  gtk_box_pack_start (GTK_BOX (editor), frame, FALSE, FALSE, 0);
+  gtk_widget_show (frame);
+
+  editor->graph = gtk_drawing_area_new ();
+  gtk_widget_set_size_request (editor->graph, -1, GRAPH_HEIGHT);
+  gtk_container_add (GTK_CONTAINER (frame), editor->graph);
+  gtk_widget_show (editor->graph);
+
+  g_signal_connect (editor->graph, "expose-event",
+                    G_CALLBACK (gimp_memory_editor_graph_expose),
+                    editor);
+
+  scrolled_window = gtk_scrolled_window_new (NULL, NULL);
+  gtk_scrolled_window_set_policy (GTK_SCROLLED_WINDOW (scrolled_window),
+                                  GTK_POLICY_AUTOMATIC,
+                                  GTK_POLICY_AUTOMATIC);
+  gtk_scrolled_window_set_shadow_type (GTK_SCROLLED_WINDOW (scrolled_window),
+                                       GTK_SHADOW_IN);
+  gtk_box_pack_start (GTK_BOX (editor), scrolled_window, TRUE, TRUE, 0);
+  gtk_widget_show (scrolled_window);
+
+  editor->store = gtk_tree_store_new (N_COLUMNS,
+                                      G_TYPE_STRING,
+                                      G_TYPE_BOOLEAN,
+                                      GIMP_TYPE_RGB,
+                                      G_TYPE_STRING,
+                                      G_TYPE_STRING);
+
+  editor->view = gtk_tree_view_new_with_model (GTK_TREE_MODEL (editor->store));
+  g_object_unref (editor->store);
+
+  gtk_tree_view_set_headers_visible (GTK_TREE_VIEW (editor->view), FALSE);
+  gtk_container_add (GTK_CONTAINER (scrolled_window), editor->view);
+  gtk_widget_show (editor->view);
+
+  column = gtk_tree_view_column_new ();
+  gtk_tree_view_column_set_expand (column, TRUE);
+  gtk_tree_view_append_column (GTK_TREE_VIEW (editor->view), column);
+
+  cell = gimp_cell_renderer_color_new ();
+  gtk_tree_view_column_pack_start (column, cell, FALSE);
+  gtk_tree_view_column_set_attributes (column, cell,
+                                       "visible", COLUMN_HAS_COLOR,
+                                       "color",   COLUMN_COLOR,
+                                       NULL);
+
+  cell = gtk_cell_renderer_text_new ();
+  g_object_set (cell, "ellipsize", PANGO_ELLIPSIZE_END, NULL);
+  gtk_tree_view_column_pack_start (column, cell, TRUE);
+  gtk_tree_view_column_set_attributes (column, cell,
+                                       "text", COLUMN_NAME,
+                                       NULL);
+
+  cell = gtk_cell_renderer_text_new ();
+  g_object_set (cell, "xalign", 1.0, NULL);
+  gtk_tree_view_insert_column_with_attributes (GTK_TREE_VIEW (editor->view),
+                                               -1, NULL, cell,
+                                               "text", COLUMN_SIZE,
+                                               NULL);
+}
+
+static void
+gimp_memory_editor_map (GtkWidget *widget)
+{
+  GTK_WIDGET_CLASS (parent_class)->map (widget);
+
+  /*  changes are ignored while we are not visible  */
+  gimp_memory_editor_refresh (GIMP_MEMORY_EDITOR (widget));
+}
+
+
+/*  public functions  */
+
+GtkWidget *
+gimp_memory_editor_new (Gimp *gimp)
+{
+  GimpMemoryEditor *editor;
+
+  g_return_val_if_fail (GIMP_IS_GIMP (gimp), NULL);
+
+  editor = g_object_new (GIMP_TYPE_MEMORY_EDITOR, NULL);
+
+  editor->gimp    = gimp;
+  editor->monitor = gimp->memory_monitor;
+
+  g_signal_connect_object (editor->monitor, "changed",
+                           G_CALLBACK (gimp_memory_editor_changed),
+                           editor, 0);
+
+  return GTK_WIDGET (editor);
+}
+
+
+/*  private functions  */
+
+static void
+gimp_memory_editor_changed (GimpMemoryMonitor *monitor,
+                            GimpMemoryEditor  *editor)
+{
+  if (gtk_widget_is_drawable (GTK_WIDGET (editor)))
+    gimp_memory_editor_refresh (editor);
+}
+
+static gboolean
+gimp_memory_editor_graph_expose (GtkWidget        *widget,
+                                 GdkEventExpose   *event,
+                                 GimpMemoryEditor *editor)
+{
+  GtkStyle      *style = gtk_widget_get_style (widget);
+  GtkAllocation  allocation;
+  cairo_t       *cr;
+  gint           n_samples;
+  gint64         max_size = 1;
+  gdouble        x_step;
+  gint           category;
+  gint           i;
+
+  gtk_widget_get_allocation (widget, &allocation);
+
+  cr = gdk_cairo_create (gtk_widget_get_window (widget));
+
+  gdk_cairo_region (cr, event->region);
+  cairo_clip (cr);
+
+  gdk_cairo_set_source_color (cr, &style->base[GTK_STATE_NORMAL]);
+  cairo_paint (cr);
+
+  n_samples = gimp_memory_monitor_get_n_samples (editor->monitor);
+
+  for (i = 0; i < n_samples; i++)
+    {
+      const GimpMemorySample *sample;
+      gint64                  total = 0;
+
+      sample = gimp_memory_monitor_get_sample (editor->monitor, i);
+
+      for (category = 0; category < GIMP_MEMORY_N_CATEGORIES; category++)
+        total += sample->sizes[category];
+
+      max_size = MAX (max_size, total);
+    }
+
+  /*  newest sample at the right edge, one step per sample  */
+  x_step = (gdouble) allocation.width / (GIMP_MEMORY_MONITOR_HISTORY - 1);
+
+  /*  stack the categories, drawing each cumulative area on top of the
+   *  next larger one
+   */
+  for (category = GIMP_MEMORY_N_CATEGORIES - 1; category >= 0; category--)
+    {
+      gdouble x = allocation.width - (n_samples - 1) * x_step;
+
+      cairo_move_to (cr, x, allocation.height);
+
+      for (i = 0; i < n_samples; i++)
+        {
+          const GimpMemorySample *sample;
+          gint64                  size = 0;
+          gint                    c;
+          gdouble                 y;
+
+          sample = gimp_memory_monitor_get_sample (editor->monitor, i);
+
+          for (c = 0; c <= category; c++)
+            size += sample->sizes[c];
+
+          y = allocation.height * (1.0 - (gdouble) size / max_size);
+
+          cairo_line_to (cr, x, y);
+
+          x = (i < n_samples - 1) ? x + x_step : allocation.width;
+
+          cairo_line_to (cr, x, y);
+        }
+
+      cairo_line_to (cr, allocation.width, allocation.height);
+      cairo_close_path (cr);
+
+      gimp_cairo_set_source_rgb (cr, &category_colors[category]);
+      cairo_fill (cr);
+    }
+
+  if (n_samples > 0)
+    {
+      PangoLayout *layout;
+      gchar       *str;
+
+      str = g_format_size (max_size);
+      layout = gtk_widget_create_pango_layout (widget, str);
+      g_free (str);
+
+      gdk_cairo_set_source_color (cr, &style->text[GTK_STATE_NORMAL]);
+      cairo_move_to (cr, 2, 2);
+      pango_cairo_show_layout (cr, layout);
+
+      g_object_unref (layout);
+    }
+
+  cairo_destroy (cr);
+
+  return TRUE;
+}
+
+static void
+gimp_memory_editor_refresh (GimpMemoryEditor *editor)
+{
+  GtkTreeView *view = GTK_TREE_VIEW (editor->view);
+  GHashTable  *expanded;
+  GList       *list;
+  GtkTreeIter  iter;
+  gchar       *str;
+
+  expanded = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+  gtk_tree_view_map_expanded_rows (view,
+                                   (GtkTreeViewMappingFunc)
+                                   gimp_memory_editor_get_expanded,
+                                   expanded);
+
+  gtk_tree_store_clear (editor->store);
+
+  gimp_memory_editor_add_usage (editor, NULL, "total", _("Total"),
+                                GIMP_MEMORY_N_CATEGORIES);
+
+  for (list = GIMP_LIST (editor->gimp->images)->list;
+       list;
+       list = g_list_next (list))
+    {
+      GimpImage *image = list->data;
+      gchar     *id;
+
+      id = g_strdup_printf ("image-%d", gimp_image_get_ID (image));
+
+      gimp_memory_editor_add_usage (editor, image, id,
+                                    gimp_image_get_display_name (image),
+                                    GIMP_MEMORY_TEMP_BUFS);
+
+      g_free (id);
+    }
+
+  /*  GEGL 0.3 has no API to query the tile cache's actual usage  */
+  str = g_format_size (gimp_tile_cache_get_size ());
+
+  gtk_tree_store_insert_with_values (editor->store, &iter, NULL, -1,
+                                     COLUMN_ID,   "tile-cache",
+                                     COLUMN_NAME, _("Tile Cache Limit"),
+                                     COLUMN_SIZE, str,
+                                     -1);
+  g_free (str);
+
+  gimp_memory_editor_set_expanded (editor, NULL, expanded);
+
+  g_hash_table_unref (expanded);
+
+  gtk_widget_queue_draw (editor->graph);
+}
+
+static void
+gimp_memory_editor_add_usage (GimpMemoryEditor *editor,
+                              GimpImage        *image,
+                              const gchar      *id,
+                              const gchar      *name,
+                              gint              n_categories)
+{
+  GtkTreeIter  parent;
+  gint64       sizes[GIMP_MEMORY_N_CATEGORIES];
+  gint64       total = 0;
+  gint         category;
+
+  gimp_memory_monitor_get_usage (editor->monitor, image, sizes);
+
+  for (category = 0; category < n_categories; category++)
+    total += sizes[category];
+
+  gimp_memory_editor_add_row (editor, &parent, NULL, id, NULL, name, total);
+
+  for (category = 0; category < n_categories; category++)
+    {
+      GtkTreeIter  iter;
+      gchar       *child_id;
+
+      child_id = g_strdup_printf ("%s/%d", id, category);
+
+      gimp_memory_editor_add_row (editor, &iter, &parent, child_id,
+                                  &category_colors[category],
+                                  gimp_memory_category_get_name (category),
+                                  sizes[category]);
+
+      g_free (child_id);
+
+      /*  list the top-level layers, group layers include their children  */
+      if (image && category == GIMP_MEMORY_LAYERS)
+        {
+          GList *list;
+
+          for (list = GIMP_LIST (gimp_image_get_layers (image))->list;
+               list;
+               list = g_list_next (list))
+            {
+              GimpItem    *item = list->data;
+              GtkTreeIter  layer_iter;
+              gint64       size;
+
+              size = gimp_memory_monitor_get_item_size (editor->monitor, item);
+
+              gimp_memory_editor_add_row (editor, &layer_iter, &iter, NULL,
+                                          NULL,
+                                          gimp_object_get_name (item),
+                                          size);
+            }
+        }
+    }
+}
+
+static void
+gimp_memory_editor_add_row (GimpMemoryEditor *editor,
+                            GtkTreeIter      *iter,
+                            GtkTreeIter      *parent,
+                            const gchar      *id,
+                            const GimpRGB    *color,
+                            const gchar      *name,
+                            gint64            size)
+{
+  gchar *str = g_format_size (size);
+
+  gtk_tree_store_insert_with_values (editor->store, iter, parent, -1,
+                                     COLUMN_ID,        id,
+                                     COLUMN_HAS_COLOR, color != NULL,
+                                     COLUMN_COLOR,     color,
+                                     COLUMN_NAME,      name,
+                                     COLUMN_SIZE,      str,
+                                     -1);
+
+  g_free (str);
+}
+
+static void
+gimp_memory_editor_get_expanded (GtkTreeView *view,
+                                 GtkTreePath *path,
+                                 GHashTable  *expanded)
+{
+  GtkTreeModel *model = gtk_tree_view_get_model (view);
+  GtkTreeIter   iter;
+  gchar        *id;
+
+  gtk_tree_model_get_iter (model, &iter, path);
+  gtk_tree_model_get (model, &iter,
+                      COLUMN_ID, &id,
+                      -1);
+
+  if (id)
+    g_hash_table_add (expanded, id);
+}
+
+static void
+gimp_memory_editor_set_expanded (GimpMemoryEditor *editor,
+                                 GtkTreeIter      *parent,
+                                 GHashTable       *expanded)
+{
+  GtkTreeModel *model = GTK_TREE_MODEL (editor->store);
+  GtkTreeIter   iter;
+  gboolean      iter_valid;
+
+  for (iter_valid = gtk_tree_model_iter_children (model, &iter, parent);
+       iter_valid;
+       iter_valid = gtk_tree_model_iter_next (model, &iter))
+    {
+      gchar *id;
+
+      gtk_tree_model_get (model, &iter,
+                          COLUMN_ID, &id,
+                          -1);
+
+      if (id && g_hash_table_contains (expanded, id))
+        {
+          GtkTreePath *path = gtk_tree_model_get_path (model, &iter);
+
+          gtk_tree_view_expand_row (GTK_TREE_VIEW (editor->view), path, FALSE);
+          gtk_tree_path_free (path);
+
+          gimp_memory_editor_set_expanded (editor, &iter, expanded);
+        }
+
+      g_free (id);
+    }
+}
@@ -587,6 +587,29 @@ gimp_view_renderer_remove_idle (GimpViewRenderer *renderer)
     }
 }
 
+/*  drops the rendered preview, it is rendered again when the
+ *  renderer is drawn the next time
+ */
+void
+gimp_view_renderer_free_preview (GimpViewRenderer *renderer)
+{
+  g_return_if_fail (GIMP_IS_VIEW_RENDERER (renderer));
+
+  if (renderer->surface)
+    {
+      cairo_surface_destroy (renderer->surface);
+      renderer->surface = NULL;
+    }
+
+  if (renderer->pixbuf)
+    {
+      g_object_unref (renderer->pixbuf);
+      renderer->pixbuf = NULL;
+    }
+
+  renderer->needs_render = TRUE;
+}
+
 void
 gimp_view_renderer_draw (GimpViewRenderer *renderer,
                          GtkWidget        *widget,
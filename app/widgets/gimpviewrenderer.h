@@ -131,6 +131,7 @@ void   gimp_view_renderer_invalidate       (GimpViewRenderer   *renderer);
 void   gimp_view_renderer_update           (GimpViewRenderer   *renderer);
 void   gimp_view_renderer_update_idle      (GimpViewRenderer   *renderer);
 void   gimp_view_renderer_remove_idle      (GimpViewRenderer   *renderer);
+void   gimp_view_renderer_free_preview     (GimpViewRenderer   *renderer);
 
 void   gimp_view_renderer_draw             (GimpViewRenderer   *renderer,
                                             GtkWidget          *widget,
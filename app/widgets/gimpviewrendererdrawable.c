@@ -28,6 +28,9 @@
 
 #include "widgets-types.h"
 
+#include "config/gimpcoreconfig.h"
+
+#include "core/gimp.h"
 #include "core/gimpdrawable.h"
 #include "core/gimpdrawable-preview.h"
 #include "core/gimpimage.h"
@@ -36,8 +39,25 @@
 #include "gimpviewrendererdrawable.h"
 
 
-static void   gimp_view_renderer_drawable_render (GimpViewRenderer *renderer,
-                                                  GtkWidget        *widget);
+/*  previews of drawables with at least this many pixels are computed
+ *  in a thread, smaller ones are quick enough to do right away
+ */
+#define ASYNC_PREVIEW_MIN_PIXELS (1024 * 1024)
+
+
+static void          gimp_view_renderer_drawable_dispose    (GObject                  *object);
+static void          gimp_view_renderer_drawable_finalize   (GObject                  *object);
+
+static void          gimp_view_renderer_drawable_invalidate (GimpViewRenderer         *renderer);
+static void          gimp_view_renderer_drawable_render     (GimpViewRenderer         *renderer,
+                                                             GtkWidget                *widget);
+
+static GimpTempBuf * gimp_view_renderer_drawable_get_async  (GimpViewRendererDrawable *rdrawable,
+                                                             gint                      width,
+                                                             gint                      height);
+static void          gimp_view_renderer_drawable_async_done (GimpDrawable             *drawable,
+                                                             GAsyncResult             *result,
+                                                             GimpViewRendererDrawable *rdrawable);
 
 
 G_DEFINE_TYPE (GimpViewRendererDrawable, gimp_view_renderer_drawable,
@@ -49,9 +69,14 @@ G_DEFINE_TYPE (GimpViewRendererDrawable, gimp_view_renderer_drawable,
 static void
 gimp_view_renderer_drawable_class_init (GimpViewRendererDrawableClass *klass)
 {
+  GObjectClass          *object_class   = G_OBJECT_CLASS (klass);
   GimpViewRendererClass *renderer_class = GIMP_VIEW_RENDERER_CLASS (klass);
 
-  renderer_class->render = gimp_view_renderer_drawable_render;
+  object_class->dispose      = gimp_view_renderer_drawable_dispose;
+  object_class->finalize     = gimp_view_renderer_drawable_finalize;
+
+  renderer_class->invalidate = gimp_view_renderer_drawable_invalidate;
+  renderer_class->render     = gimp_view_renderer_drawable_render;
 }
 
 static void
@@ -59,6 +84,52 @@ gimp_view_renderer_drawable_init (GimpViewRendererDrawable *renderer)
 {
 }
 
+static void
+gimp_view_renderer_drawable_dispose (GObject *object)
+{
+  GimpViewRendererDrawable *rdrawable = GIMP_VIEW_RENDERER_DRAWABLE (object);
+
+  if (rdrawable->cancellable)
+    {
+      g_cancellable_cancel (rdrawable->cancellable);
+      g_clear_object (&rdrawable->cancellable);
+    }
+
+  G_OBJECT_CLASS (parent_class)->dispose (object);
+}
+
+static void
+gimp_view_renderer_drawable_finalize (GObject *object)
+{
+  GimpViewRendererDrawable *rdrawable = GIMP_VIEW_RENDERER_DRAWABLE (object);
+
+  if (rdrawable->async_preview)
+    {
+      gimp_temp_buf_unref (rdrawable->async_preview);
+      rdrawable->async_preview = NULL;
+    }
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+gimp_view_renderer_drawable_invalidate (GimpViewRenderer *renderer)
+{
+  GimpViewRendererDrawable *rdrawable = GIMP_VIEW_RENDERER_DRAWABLE (renderer);
+
+  rdrawable->serial++;
+
+  /*  a pending preview of another drawable is useless now  */
+  if (rdrawable->cancellable &&
+      rdrawable->async_viewable != renderer->viewable)
+    {
+      g_cancellable_cancel (rdrawable->cancellable);
+      g_clear_object (&rdrawable->cancellable);
+    }
+
+  GIMP_VIEW_RENDERER_CLASS (parent_class)->invalidate (renderer);
+}
+
 static void
 gimp_view_renderer_drawable_render (GimpViewRenderer *renderer,
                                     GtkWidget        *widget)
@@ -186,6 +257,23 @@ gimp_view_renderer_drawable_render (GimpViewRenderer *renderer,
             }
         }
     }
+  else if (image && image->gimp->config->layer_previews &&
+           gimp_item_get_width  (item) *
+           gimp_item_get_height (item) >= ASYNC_PREVIEW_MIN_PIXELS)
+    {
+      render_buf = gimp_view_renderer_drawable_get_async
+        (GIMP_VIEW_RENDERER_DRAWABLE (renderer), view_width, view_height);
+
+      /*  keep showing the old preview until the new one is ready  */
+      if (! render_buf)
+        {
+          if (! renderer->surface)
+            gimp_view_renderer_render_icon (renderer, widget,
+                                            gimp_viewable_get_icon_name (renderer->viewable));
+
+          return;
+        }
+    }
   else
     {
       render_buf = gimp_viewable_get_new_preview (renderer->viewable,
@@ -244,3 +332,84 @@ gimp_view_renderer_drawable_render (GimpViewRenderer *renderer,
       gimp_view_renderer_render_icon (renderer, widget, icon_name);
     }
 }
+
+/*  returns the asynchronously computed preview if one of the right
+ *  size is ready, and requests a new one if there is none or it is
+ *  outdated
+ */
+static GimpTempBuf *
+gimp_view_renderer_drawable_get_async (GimpViewRendererDrawable *rdrawable,
+                                       gint                      width,
+                                       gint                      height)
+{
+  GimpViewRenderer *renderer = GIMP_VIEW_RENDERER (rdrawable);
+  GimpItem         *item     = GIMP_ITEM (renderer->viewable);
+  GimpTempBuf      *preview  = rdrawable->async_preview;
+
+  rdrawable->async_preview = NULL;
+
+  if (preview &&
+      (gimp_temp_buf_get_width  (preview) != width ||
+       gimp_temp_buf_get_height (preview) != height))
+    {
+      gimp_temp_buf_unref (preview);
+      preview = NULL;
+    }
+
+  if ((! preview || rdrawable->async_preview_serial != rdrawable->serial) &&
+      ! rdrawable->cancellable)
+    {
+      rdrawable->cancellable    = g_cancellable_new ();
+      rdrawable->async_viewable = renderer->viewable;
+      rdrawable->async_serial   = rdrawable->serial;
+
+      /*  popups are looked at right now  */
+      gimp_drawable_get_sub_preview_async (GIMP_DRAWABLE (item),
+                                           0, 0,
+                                           gimp_item_get_width  (item),
+                                           gimp_item_get_height (item),
+                                           width, height,
+                                           renderer->is_popup ?
+                                           G_PRIORITY_HIGH : G_PRIORITY_DEFAULT,
+                                           rdrawable->cancellable,
+                                           (GAsyncReadyCallback) gimp_view_renderer_drawable_async_done,
+                                           rdrawable);
+    }
+
+  return preview;
+}
+
+static void
+gimp_view_renderer_drawable_async_done (GimpDrawable             *drawable,
+                                        GAsyncResult             *result,
+                                        GimpViewRendererDrawable *rdrawable)
+{
+  GimpViewRenderer *renderer;
+  GimpTempBuf      *preview;
+  GError           *error = NULL;
+
+  preview = gimp_drawable_get_sub_preview_finish (drawable, result, &error);
+
+  /*  the renderer may be gone already  */
+  if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    {
+      g_clear_error (&error);
+      return;
+    }
+
+  renderer = GIMP_VIEW_RENDERER (rdrawable);
+
+  g_clear_object (&rdrawable->cancellable);
+
+  if (! preview)
+    return;
+
+  if (rdrawable->async_preview)
+    gimp_temp_buf_unref (rdrawable->async_preview);
+
+  rdrawable->async_preview        = preview;
+  rdrawable->async_preview_serial = rdrawable->async_serial;
+
+  renderer->needs_render = TRUE;
+  gimp_view_renderer_update (renderer);
+}
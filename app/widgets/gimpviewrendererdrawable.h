@@ -36,6 +36,14 @@ typedef struct _GimpViewRendererDrawableClass  GimpViewRendererDrawableClass;
 struct _GimpViewRendererDrawable
 {
   GimpViewRenderer  parent_instance;
+
+  /*  previews of large drawables are computed asynchronously  */
+  GCancellable     *cancellable;
+  GimpViewable     *async_viewable;
+  guint             serial;
+  guint             async_serial;
+  GimpTempBuf      *async_preview;
+  guint             async_preview_serial;
 };
 
 struct _GimpViewRendererDrawableClass
@@ -112,10 +112,16 @@ gimp_view_renderer_image_render (GimpViewRenderer *renderer,
         }
       else
         {
-          render_buf = gimp_viewable_get_new_preview (renderer->viewable,
-                                                      renderer->context,
-                                                      view_width,
-                                                      view_height);
+          /*  the image keeps this preview and only updates the parts
+           *  that changed, instead of scaling down all of it again
+           */
+          render_buf = gimp_viewable_get_preview (renderer->viewable,
+                                                  renderer->context,
+                                                  view_width,
+                                                  view_height);
+
+          if (render_buf)
+            gimp_temp_buf_ref (render_buf);
         }
 
       if (render_buf)
@@ -0,0 +1,547 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <cairo.h>
+#include <gegl.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+
+#include "libgimpbase/gimpbase.h"
+
+#include "core/core-types.h"
+
+#include "core/gimp.h"
+
+#include "xcf-private.h"
+#include "xcf-tile.h"
+
+#include "gimptilehandlerxcf.h"
+
+#include "gimp-intl.h"
+
+
+#define XCF_READ_FAILED_KEY  "gimp-xcf-read-failed"
+#define XCF_FILE_CHANGED_KEY "gimp-xcf-file-changed"
+
+
+static void       gimp_tile_handler_xcf_finalize (GObject                 *object);
+
+static gpointer   gimp_tile_handler_xcf_command  (GeglTileSource          *source,
+                                                  GeglTileCommand          command,
+                                                  gint                     x,
+                                                  gint                     y,
+                                                  gint                     z,
+                                                  gpointer                 data);
+
+static void       gimp_tile_handler_xcf_validate (GimpTileHandlerValidate *validate,
+                                                  const GeglRectangle     *rect,
+                                                  const Babl              *format,
+                                                  gpointer                 dest_buf,
+                                                  gint                     dest_stride);
+
+static gboolean   gimp_tile_handler_xcf_decode   (GimpTileHandlerXcf      *xcf,
+                                                  gint                     tile,
+                                                  const GeglRectangle     *tile_rect,
+                                                  gint                     bpp,
+                                                  guchar                  *tile_data);
+static guchar   * gimp_tile_handler_xcf_read     (GimpTileHandlerXcf      *xcf,
+                                                  goffset                  offset,
+                                                  gsize                   *data_length);
+static void       gimp_tile_handler_xcf_failed   (GimpTileHandlerXcf      *xcf);
+static gboolean   gimp_tile_handler_xcf_report   (GFile                   *file);
+
+static GeglTileHandler *
+                  gimp_tile_handler_xcf_create   (Gimp                    *gimp,
+                                                  GFile                   *file,
+                                                  XcfCompressionType       compression,
+                                                  const goffset           *offsets,
+                                                  gint                     width,
+                                                  gint                     height);
+
+
+G_DEFINE_TYPE (GimpTileHandlerXcf, gimp_tile_handler_xcf,
+               GIMP_TYPE_TILE_HANDLER_VALIDATE)
+
+#define parent_class gimp_tile_handler_xcf_parent_class
+
+
+/*  the handlers of all layers read from the same stream  */
+static GMutex stream_mutex;
+
+
+static void
+gimp_tile_handler_xcf_class_init (GimpTileHandlerXcfClass *klass)
+{
+  GObjectClass                 *object_class   = G_OBJECT_CLASS (klass);
+  GimpTileHandlerValidateClass *validate_class = GIMP_TILE_HANDLER_VALIDATE_CLASS (klass);
+
+  object_class->finalize   = gimp_tile_handler_xcf_finalize;
+
+  validate_class->validate = gimp_tile_handler_xcf_validate;
+}
+
+static void
+gimp_tile_handler_xcf_init (GimpTileHandlerXcf *xcf)
+{
+  GeglTileSource *source = GEGL_TILE_SOURCE (xcf);
+
+  g_rec_mutex_init (&xcf->mutex);
+
+  /*  chain up to GimpTileHandlerValidate's command, but serialize it,
+   *  layers are read from more than one thread
+   */
+  xcf->parent_command = source->command;
+  source->command     = gimp_tile_handler_xcf_command;
+}
+
+static void
+gimp_tile_handler_xcf_finalize (GObject *object)
+{
+  GimpTileHandlerXcf *xcf = GIMP_TILE_HANDLER_XCF (object);
+
+  if (xcf->mapped_file)
+    {
+      g_mapped_file_unref (xcf->mapped_file);
+      xcf->mapped_file = NULL;
+    }
+
+  if (xcf->input)
+    {
+      g_object_unref (xcf->input);
+      xcf->input = NULL;
+    }
+
+  if (xcf->file)
+    {
+      g_object_unref (xcf->file);
+      xcf->file = NULL;
+    }
+
+  g_free (xcf->etag);
+  xcf->etag = NULL;
+
+  g_free (xcf->offsets);
+  xcf->offsets = NULL;
+
+  g_rec_mutex_clear (&xcf->mutex);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static gpointer
+gimp_tile_handler_xcf_command (GeglTileSource  *source,
+                               GeglTileCommand  command,
+                               gint             x,
+                               gint             y,
+                               gint             z,
+                               gpointer         data)
+{
+  GimpTileHandlerXcf *xcf = GIMP_TILE_HANDLER_XCF (source);
+  gpointer            retval;
+
+  g_rec_mutex_lock (&xcf->mutex);
+
+  retval = xcf->parent_command (source, command, x, y, z, data);
+
+  g_rec_mutex_unlock (&xcf->mutex);
+
+  return retval;
+}
+
+static void
+gimp_tile_handler_xcf_validate (GimpTileHandlerValidate *validate,
+                                const GeglRectangle     *rect,
+                                const Babl              *format,
+                                gpointer                 dest_buf,
+                                gint                     dest_stride)
+{
+  GimpTileHandlerXcf *xcf    = GIMP_TILE_HANDLER_XCF (validate);
+  GeglRectangle       extent = { 0, 0, xcf->width, xcf->height };
+  GeglRectangle       area;
+  gint                bpp;
+  guchar             *tile_data;
+  gint                col1, col2;
+  gint                row1, row2;
+  gint                col, row;
+
+  bpp = babl_format_get_bytes_per_pixel (format);
+
+  /*  the parts of the tile outside the buffer are never decoded  */
+  if (! gegl_rectangle_contains (&extent, rect))
+    {
+      gint y;
+
+      for (y = 0; y < rect->height; y++)
+        memset ((guchar *) dest_buf + y * dest_stride, 0, rect->width * bpp);
+    }
+
+  if (! gegl_rectangle_intersect (&area, rect, &extent))
+    return;
+
+  tile_data = g_alloca (XCF_TILE_WIDTH * XCF_TILE_HEIGHT * bpp);
+
+  col1 = area.x / XCF_TILE_WIDTH;
+  col2 = (area.x + area.width - 1) / XCF_TILE_WIDTH;
+  row1 = area.y / XCF_TILE_HEIGHT;
+  row2 = (area.y + area.height - 1) / XCF_TILE_HEIGHT;
+
+  for (row = row1; row <= row2; row++)
+    for (col = col1; col <= col2; col++)
+      {
+        GeglRectangle  tile_rect;
+        GeglRectangle  isect;
+        const guchar  *src;
+        guchar        *dest;
+        gint           y;
+
+        tile_rect.x      = col * XCF_TILE_WIDTH;
+        tile_rect.y      = row * XCF_TILE_HEIGHT;
+        tile_rect.width  = MIN (XCF_TILE_WIDTH,  xcf->width  - tile_rect.x);
+        tile_rect.height = MIN (XCF_TILE_HEIGHT, xcf->height - tile_rect.y);
+
+        gegl_rectangle_intersect (&isect, &tile_rect, &area);
+
+        /*  a broken tile reads as transparent, like a tile that was
+         *  skipped by the non-lazy loader, but unlike the loader we
+         *  can't fail the load, so tell the user
+         */
+        if (! gimp_tile_handler_xcf_decode (xcf, row * xcf->n_tile_cols + col,
+                                            &tile_rect, bpp, tile_data))
+          {
+            memset (tile_data, 0, tile_rect.width * tile_rect.height * bpp);
+
+            gimp_tile_handler_xcf_failed (xcf);
+          }
+
+        src  = (tile_data +
+                ((isect.y - tile_rect.y) * tile_rect.width +
+                 (isect.x - tile_rect.x)) * bpp);
+        dest = ((guchar *) dest_buf +
+                (isect.y - rect->y) * dest_stride +
+                (isect.x - rect->x) * bpp);
+
+        for (y = 0; y < isect.height; y++)
+          {
+            memcpy (dest, src, isect.width * bpp);
+
+            src  += tile_rect.width * bpp;
+            dest += dest_stride;
+          }
+      }
+}
+
+static gboolean
+gimp_tile_handler_xcf_decode (GimpTileHandlerXcf  *xcf,
+                              gint                 tile,
+                              const GeglRectangle *tile_rect,
+                              gint                 bpp,
+                              guchar              *tile_data)
+{
+  const guchar *contents;
+  guchar       *data   = NULL;
+  goffset       offset = xcf->offsets[tile];
+  gsize         data_length;
+  gsize         tile_size;
+  gboolean      success;
+
+  tile_size = bpp * tile_rect->width * tile_rect->height;
+
+  /*  see xcf_load_level() for the size of the last tile  */
+  if (xcf->offsets[tile + 1] > offset)
+    data_length = xcf->offsets[tile + 1] - offset;
+  else
+    data_length = XCF_TILE_WIDTH * XCF_TILE_HEIGHT * bpp * 1.5;
+
+  if (xcf->mapped_file)
+    {
+      gsize file_size = g_mapped_file_get_length (xcf->mapped_file);
+
+      if (offset >= (goffset) file_size)
+        return FALSE;
+
+      contents    = ((const guchar *)
+                     g_mapped_file_get_contents (xcf->mapped_file) + offset);
+      data_length = MIN (data_length, file_size - offset);
+    }
+  else
+    {
+      data = gimp_tile_handler_xcf_read (xcf, offset, &data_length);
+
+      if (! data)
+        return FALSE;
+
+      contents = data;
+    }
+
+  switch (xcf->compression)
+    {
+    case COMPRESS_NONE:
+      success = data_length >= tile_size;
+
+      if (success)
+        memcpy (tile_data, contents, tile_size);
+      break;
+
+    case COMPRESS_RLE:
+      success = xcf_tile_decode_rle (contents, data_length,
+                                     tile_data, bpp,
+                                     tile_rect->width * tile_rect->height);
+      break;
+
+    case COMPRESS_ZLIB:
+      success = xcf_tile_decode_zlib (contents, data_length,
+                                      tile_data, tile_size);
+      break;
+
+    default:
+      success = FALSE;
+      break;
+    }
+
+  g_free (data);
+
+  return success;
+}
+
+/*  reads up to *@data_length bytes at @offset of the stream, the last
+ *  tile's size is only an estimate and may reach past the end of file
+ */
+static guchar *
+gimp_tile_handler_xcf_read (GimpTileHandlerXcf *xcf,
+                            goffset             offset,
+                            gsize              *data_length)
+{
+  guchar *data;
+  gsize   bytes_read = 0;
+
+  data = g_malloc (*data_length);
+
+  g_mutex_lock (&stream_mutex);
+
+  /*  never decode a tile of a different file than the one we loaded,
+   *  once the file changed on the server, all its tiles fail
+   */
+  if (! g_object_get_data (G_OBJECT (xcf->input), XCF_FILE_CHANGED_KEY))
+    {
+      GFileInfo *info;
+      gboolean   changed = TRUE;
+
+      info = g_file_query_info (xcf->file, G_FILE_ATTRIBUTE_ETAG_VALUE,
+                                G_FILE_QUERY_INFO_NONE, NULL, NULL);
+
+      if (info)
+        {
+          changed = g_strcmp0 (g_file_info_get_etag (info), xcf->etag) != 0;
+
+          g_object_unref (info);
+        }
+
+      if (changed)
+        g_object_set_data (G_OBJECT (xcf->input), XCF_FILE_CHANGED_KEY,
+                           GINT_TO_POINTER (TRUE));
+    }
+
+  if (! g_object_get_data (G_OBJECT (xcf->input), XCF_FILE_CHANGED_KEY) &&
+      g_seekable_seek (G_SEEKABLE (xcf->input), offset, G_SEEK_SET,
+                       NULL, NULL))
+    {
+      g_input_stream_read_all (xcf->input, data, *data_length,
+                               &bytes_read, NULL, NULL);
+    }
+
+  g_mutex_unlock (&stream_mutex);
+
+  if (bytes_read == 0)
+    {
+      g_free (data);
+      return NULL;
+    }
+
+  *data_length = bytes_read;
+
+  return data;
+}
+
+/*  reports the first tile of a file that couldn't be read, the
+ *  handlers of all of the file's layers share @file
+ */
+static void
+gimp_tile_handler_xcf_failed (GimpTileHandlerXcf *xcf)
+{
+  gboolean report = FALSE;
+
+  g_mutex_lock (&stream_mutex);
+
+  if (! g_object_get_data (G_OBJECT (xcf->file), XCF_READ_FAILED_KEY))
+    {
+      g_object_set_data (G_OBJECT (xcf->file), XCF_READ_FAILED_KEY,
+                         xcf->gimp);
+      report = TRUE;
+    }
+
+  g_mutex_unlock (&stream_mutex);
+
+  /*  tiles are validated from any thread, report from the main loop  */
+  if (report)
+    g_idle_add ((GSourceFunc) gimp_tile_handler_xcf_report,
+                g_object_ref (xcf->file));
+}
+
+static gboolean
+gimp_tile_handler_xcf_report (GFile *file)
+{
+  Gimp *gimp = g_object_get_data (G_OBJECT (file), XCF_READ_FAILED_KEY);
+
+  gimp_message (gimp, NULL, GIMP_MESSAGE_ERROR,
+                _("Reading '%s' failed or the file changed since it was "
+                  "opened.  Parts of the image could not be loaded and "
+                  "are transparent, saving the image would save them "
+                  "as transparent too."),
+                gimp_file_get_utf8_name (file));
+
+  g_object_unref (file);
+
+  return G_SOURCE_REMOVE;
+}
+
+static GeglTileHandler *
+gimp_tile_handler_xcf_create (Gimp               *gimp,
+                              GFile              *file,
+                              XcfCompressionType  compression,
+                              const goffset      *offsets,
+                              gint                width,
+                              gint                height)
+{
+  GimpTileHandlerXcf *xcf;
+  gint                n_tiles;
+
+  xcf = g_object_new (GIMP_TYPE_TILE_HANDLER_XCF,
+                      "whole-tile", TRUE,
+                      NULL);
+
+  xcf->gimp        = gimp;
+  xcf->file        = g_object_ref (file);
+  xcf->compression = compression;
+  xcf->width       = width;
+  xcf->height      = height;
+  xcf->n_tile_cols = (width  + XCF_TILE_WIDTH  - 1) / XCF_TILE_WIDTH;
+  xcf->n_tile_rows = (height + XCF_TILE_HEIGHT - 1) / XCF_TILE_HEIGHT;
+
+  n_tiles = xcf->n_tile_cols * xcf->n_tile_rows;
+
+  xcf->offsets = g_memdup (offsets, (n_tiles + 1) * sizeof (goffset));
+
+  return GEGL_TILE_HANDLER (xcf);
+}
+
+
+/*  public functions  */
+
+/**
+ * gimp_tile_handler_xcf_new:
+ * @gimp:        a #Gimp, to report read errors to
+ * @file:        the XCF file, the same #GFile for all of its levels
+ * @mapped_file: the memory-mapped XCF file
+ * @compression: the file's tile compression
+ * @offsets:     the level's tile offset table, including the
+ *               terminating 0
+ * @width:       the level's width
+ * @height:      the level's height
+ *
+ * Creates a tile handler that decodes a level's tiles straight from
+ * @mapped_file. Assign it to the buffer with
+ * gimp_tile_handler_validate_assign() and invalidate the buffer's
+ * whole extent.
+ *
+ * Return value: the new tile handler.
+ **/
+GeglTileHandler *
+gimp_tile_handler_xcf_new (Gimp               *gimp,
+                           GFile              *file,
+                           GMappedFile        *mapped_file,
+                           XcfCompressionType  compression,
+                           const goffset      *offsets,
+                           gint                width,
+                           gint                height)
+{
+  GeglTileHandler *handler;
+
+  g_return_val_if_fail (GIMP_IS_GIMP (gimp), NULL);
+  g_return_val_if_fail (G_IS_FILE (file), NULL);
+  g_return_val_if_fail (mapped_file != NULL, NULL);
+  g_return_val_if_fail (offsets != NULL, NULL);
+  g_return_val_if_fail (width > 0 && height > 0, NULL);
+
+  handler = gimp_tile_handler_xcf_create (gimp, file, compression,
+                                          offsets, width, height);
+
+  GIMP_TILE_HANDLER_XCF (handler)->mapped_file = g_mapped_file_ref (mapped_file);
+
+  return handler;
+}
+
+/**
+ * gimp_tile_handler_xcf_new_for_stream:
+ * @gimp:        a #Gimp, to report read errors to
+ * @file:        the XCF file, the same #GFile for all of its levels
+ * @input:       a seekable stream of the XCF file
+ * @etag:        @file's entity tag when @input was opened
+ * @compression: the file's tile compression
+ * @offsets:     the level's tile offset table, including the
+ *               terminating 0
+ * @width:       the level's width
+ * @height:      the level's height
+ *
+ * Like gimp_tile_handler_xcf_new(), but reads each tile from @input,
+ * seeking to it, for files which can't be memory-mapped, like remote
+ * ones. @input must not be used by anything else meanwhile.
+ *
+ * Before each read, @file's entity tag is compared with @etag, so
+ * tiles of a file that changed since it was opened are never decoded.
+ *
+ * Return value: the new tile handler.
+ **/
+GeglTileHandler *
+gimp_tile_handler_xcf_new_for_stream (Gimp               *gimp,
+                                      GFile              *file,
+                                      GInputStream       *input,
+                                      const gchar        *etag,
+                                      XcfCompressionType  compression,
+                                      const goffset      *offsets,
+                                      gint                width,
+                                      gint                height)
+{
+  GeglTileHandler *handler;
+
+  g_return_val_if_fail (GIMP_IS_GIMP (gimp), NULL);
+  g_return_val_if_fail (G_IS_FILE (file), NULL);
+  g_return_val_if_fail (G_IS_SEEKABLE (input), NULL);
+  g_return_val_if_fail (etag != NULL, NULL);
+  g_return_val_if_fail (offsets != NULL, NULL);
+  g_return_val_if_fail (width > 0 && height > 0, NULL);
+
+  handler = gimp_tile_handler_xcf_create (gimp, file, compression,
+                                          offsets, width, height);
+
+  GIMP_TILE_HANDLER_XCF (handler)->input = g_object_ref (input);
+  GIMP_TILE_HANDLER_XCF (handler)->etag  = g_strdup (etag);
+
+  return handler;
+}
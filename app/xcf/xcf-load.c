@@ -34,6 +34,7 @@
 #include "gegl/gimp-gegl-tile-compat.h"
 
 #include "core/gimp.h"
+#include "core/gimp-parallel.h"
 #include "core/gimpcontainer.h"
 #include "core/gimpdrawable-private.h" /* eek */
 #include "core/gimpgrid.h"
@@ -67,6 +68,9 @@
 #include "xcf-load.h"
 #include "xcf-read.h"
 #include "xcf-seek.h"
+#include "xcf-tile.h"
+
+#include "gimptilehandlerxcf.h"
 
 #include "gimp-log.h"
 #include "gimp-intl.h"
@@ -77,6 +81,20 @@
 /* #define GIMP_XCF_PATH_DEBUG */
 
 
+/* an RLE or zlib compressed tile that has been read, but not decoded yet */
+typedef struct
+{
+  GeglRectangle       rect;
+  XcfCompressionType  compression;
+  gint                bpp;
+  guchar             *src;
+  gsize               src_size;
+  guchar             *data;
+  gsize               size;
+  gboolean            success;
+} XcfLoadTile;
+
+
 static void            xcf_load_add_masks     (GimpImage     *image);
 static gboolean        xcf_load_image_props   (XcfInfo       *info,
                                                GimpImage     *image);
@@ -95,6 +113,9 @@ static gboolean        xcf_load_channel_props (XcfInfo       *info,
 static gboolean        xcf_load_prop          (XcfInfo       *info,
                                                PropType      *prop_type,
                                                guint32       *prop_size);
+static guint          xcf_read_offset        (XcfInfo       *info,
+                                               goffset       *data,
+                                               gint           count);
 static GimpLayer     * xcf_load_layer         (XcfInfo       *info,
                                                GimpImage     *image,
                                                GList        **item_path);
@@ -106,20 +127,26 @@ static gboolean        xcf_load_buffer        (XcfInfo       *info,
                                                GeglBuffer    *buffer);
 static gboolean        xcf_load_level         (XcfInfo       *info,
                                                GeglBuffer    *buffer);
+static goffset       * xcf_load_level_offsets (XcfInfo       *info,
+                                               goffset        offset,
+                                               guint          ntiles);
+static gboolean        xcf_load_level_lazy    (XcfInfo       *info,
+                                               GeglBuffer    *buffer,
+                                               goffset        offset,
+                                               guint          ntiles);
 static gboolean        xcf_load_tile          (XcfInfo       *info,
                                                GeglBuffer    *buffer,
                                                GeglRectangle *tile_rect,
                                                const Babl    *format);
-static gboolean        xcf_load_tile_rle      (XcfInfo       *info,
-                                               GeglBuffer    *buffer,
+static gboolean        xcf_load_tile_data     (XcfInfo       *info,
+                                               XcfLoadTile   *tile,
                                                GeglRectangle *tile_rect,
                                                const Babl    *format,
                                                gint           data_length);
-static gboolean        xcf_load_tile_zlib     (XcfInfo       *info,
-                                               GeglBuffer    *buffer,
-                                               GeglRectangle *tile_rect,
+static gboolean        xcf_load_tiles         (GeglBuffer    *buffer,
                                                const Babl    *format,
-                                               gint           data_length);
+                                               XcfLoadTile   *tiles,
+                                               gint           n_tiles);
 static GimpParasite  * xcf_load_parasite      (XcfInfo       *info);
 static gboolean        xcf_load_old_paths     (XcfInfo       *info,
                                                GimpImage     *image);
@@ -149,13 +176,14 @@ xcf_load_image (Gimp     *gimp,
   GimpImage          *image = NULL;
   const GimpParasite *parasite;
   gboolean            has_metadata = FALSE;
-  guint32             saved_pos;
-  guint32             offset;
+  goffset             saved_pos;
+  goffset             offset;
   gint                width;
   gint                height;
   gint                image_type;
   GimpPrecision       precision = GIMP_PRECISION_U8_GAMMA;
   gint                num_successful_elements = 0;
+  gboolean            layers_frozen = FALSE;
 
   /* read in the image width, height and type */
   info->cp += xcf_read_int32 (info->input, (guint32 *) &width, 1);
@@ -364,13 +392,16 @@ xcf_load_image (Gimp     *gimp,
 
   xcf_progress_update (info);
 
+  gimp_image_freeze_layers (image);
+  layers_frozen = TRUE;
+
   while (TRUE)
     {
       GimpLayer *layer;
       GList     *item_path = NULL;
 
       /* read in the offset of the next layer */
-      info->cp += xcf_read_int32 (info->input, &offset, 1);
+      info->cp += xcf_read_offset (info, &offset, 1);
 
       /* if the offset is 0 then we are at the end
        *  of the layer list.
@@ -449,12 +480,15 @@ xcf_load_image (Gimp     *gimp,
         goto error;
     }
 
+  gimp_image_thaw_layers (image);
+  layers_frozen = FALSE;
+
   while (TRUE)
     {
       GimpChannel *channel;
 
       /* read in the offset of the next channel */
-      info->cp += xcf_read_int32 (info->input, &offset, 1);
+      info->cp += xcf_read_offset (info, &offset, 1);
 
       /* if the offset is 0 then we are at the end
        *  of the channel list.
@@ -515,6 +549,9 @@ xcf_load_image (Gimp     *gimp,
   return image;
 
  error:
+  if (layers_frozen)
+    gimp_image_thaw_layers (image);
+
   if (num_successful_elements == 0)
     goto hard_error;
 
@@ -777,7 +814,7 @@ xcf_load_image_props (XcfInfo   *info,
 
         case PROP_PARASITES:
           {
-            glong base = info->cp;
+            goffset base = info->cp;
 
             while (info->cp - base < prop_size)
               {
@@ -888,14 +925,14 @@ xcf_load_image_props (XcfInfo   *info,
 
         case PROP_VECTORS:
           {
-            guint32 base = info->cp;
+            goffset base = info->cp;
 
             if (xcf_load_vectors (info, image))
               {
                 if (base + prop_size != info->cp)
                   {
                     g_printerr ("Mismatch in PROP_VECTORS size: "
-                                "skipping %d bytes.\n",
+                                "skipping %" G_GOFFSET_FORMAT " bytes.\n",
                                 base + prop_size - info->cp);
                     xcf_seek_pos (info, base + prop_size, NULL);
                   }
@@ -954,9 +991,7 @@ xcf_load_layer_props (XcfInfo    *info,
 
         case PROP_FLOATING_SELECTION:
           info->floating_sel = *layer;
-          info->cp +=
-            xcf_read_int32 (info->input,
-                            (guint32 *) &info->floating_sel_offset, 1);
+          info->cp += xcf_read_offset (info, &info->floating_sel_offset, 1);
           break;
 
         case PROP_OPACITY:
@@ -1065,7 +1100,7 @@ xcf_load_layer_props (XcfInfo    *info,
 
         case PROP_PARASITES:
           {
-            glong base = info->cp;
+            goffset base = info->cp;
 
             while (info->cp - base < prop_size)
               {
@@ -1119,8 +1154,8 @@ xcf_load_layer_props (XcfInfo    *info,
 
         case PROP_ITEM_PATH:
           {
-            glong  base = info->cp;
-            GList *path = NULL;
+            goffset  base = info->cp;
+            GList   *path = NULL;
 
             while (info->cp - base < prop_size)
               {
@@ -1279,7 +1314,7 @@ xcf_load_channel_props (XcfInfo      *info,
 
         case PROP_PARASITES:
           {
-            glong base = info->cp;
+            goffset base = info->cp;
 
             while ((info->cp - base) < prop_size)
               {
@@ -1345,6 +1380,32 @@ xcf_load_prop (XcfInfo  *info,
   return TRUE;
 }
 
+/* Reads @count file offsets, which are 64-bit since XCF version 9 and
+ * 32-bit before.
+ */
+static guint
+xcf_read_offset (XcfInfo *info,
+                 goffset *data,
+                 gint     count)
+{
+  guint32 *data32 = (guint32 *) data;
+  guint    total;
+  gint     i;
+
+  if (info->bytes_per_offset == 8)
+    return xcf_read_int64 (info->input, (guint64 *) data, count);
+
+  /*  read the 32-bit offsets into the front of @data, and widen them
+   *  from the back, so no value is overwritten before it is read
+   */
+  total = xcf_read_int32 (info->input, data32, count);
+
+  for (i = count - 1; i >= 0; i--)
+    data[i] = data32[i];
+
+  return total;
+}
+
 static GimpLayer *
 xcf_load_layer (XcfInfo    *info,
                 GimpImage  *image,
@@ -1352,8 +1413,8 @@ xcf_load_layer (XcfInfo    *info,
 {
   GimpLayer         *layer;
   GimpLayerMask     *layer_mask;
-  guint32            hierarchy_offset;
-  guint32            layer_mask_offset;
+  goffset            hierarchy_offset;
+  goffset            layer_mask_offset;
   gboolean           apply_mask = TRUE;
   gboolean           edit_mask  = FALSE;
   gboolean           show_mask  = FALSE;
@@ -1463,8 +1524,8 @@ xcf_load_layer (XcfInfo    *info,
     }
 
   /* read the hierarchy and layer mask offsets */
-  info->cp += xcf_read_int32 (info->input, &hierarchy_offset, 1);
-  info->cp += xcf_read_int32 (info->input, &layer_mask_offset, 1);
+  info->cp += xcf_read_offset (info, &hierarchy_offset, 1);
+  info->cp += xcf_read_offset (info, &layer_mask_offset, 1);
 
   /* read in the hierarchy (ignore it for group layers, both as an
    * optimization and because the hierarchy's extents don't match
@@ -1535,7 +1596,7 @@ xcf_load_channel (XcfInfo   *info,
                   GimpImage *image)
 {
   GimpChannel *channel;
-  guint32      hierarchy_offset;
+  goffset      hierarchy_offset;
   gint         width;
   gint         height;
   gboolean     is_fs_drawable;
@@ -1568,7 +1629,7 @@ xcf_load_channel (XcfInfo   *info,
   xcf_progress_update (info);
 
   /* read the hierarchy and layer mask offsets */
-  info->cp += xcf_read_int32 (info->input, &hierarchy_offset, 1);
+  info->cp += xcf_read_offset (info, &hierarchy_offset, 1);
 
   /* read in the hierarchy */
   if (!xcf_seek_pos (info, hierarchy_offset, NULL))
@@ -1596,7 +1657,7 @@ xcf_load_layer_mask (XcfInfo   *info,
 {
   GimpLayerMask *layer_mask;
   GimpChannel   *channel;
-  guint32        hierarchy_offset;
+  goffset        hierarchy_offset;
   gint           width;
   gint           height;
   gboolean       is_fs_drawable;
@@ -1630,7 +1691,7 @@ xcf_load_layer_mask (XcfInfo   *info,
   xcf_progress_update (info);
 
   /* read the hierarchy and layer mask offsets */
-  info->cp += xcf_read_int32 (info->input, &hierarchy_offset, 1);
+  info->cp += xcf_read_offset (info, &hierarchy_offset, 1);
 
   /* read in the hierarchy */
   if (! xcf_seek_pos (info, hierarchy_offset, NULL))
@@ -1658,7 +1719,7 @@ xcf_load_buffer (XcfInfo    *info,
                  GeglBuffer *buffer)
 {
   const Babl *format;
-  guint32     offset;
+  goffset     offset;
   gint        width;
   gint        height;
   gint        bpp;
@@ -1677,7 +1738,7 @@ xcf_load_buffer (XcfInfo    *info,
       bpp    != babl_format_get_bytes_per_pixel (format))
     return FALSE;
 
-  info->cp += xcf_read_int32 (info->input, &offset, 1); /* top level */
+  info->cp += xcf_read_offset (info, &offset, 1); /* top level */
 
   /* seek to the level offset */
   if (!xcf_seek_pos (info, offset, NULL))
@@ -1698,17 +1759,20 @@ static gboolean
 xcf_load_level (XcfInfo    *info,
                 GeglBuffer *buffer)
 {
-  const Babl *format;
-  gint        bpp;
-  guint32     saved_pos;
-  guint32     offset, offset2;
-  gint        n_tile_rows;
-  gint        n_tile_cols;
-  guint       ntiles;
-  gint        width;
-  gint        height;
-  gint        i;
-  gint        fail;
+  const Babl  *format;
+  gint         bpp;
+  goffset     *offsets;
+  goffset      offset;
+  gint         n_tile_rows;
+  gint         n_tile_cols;
+  guint        ntiles;
+  gint         width;
+  gint         height;
+  gint         i;
+  gint         fail;
+  XcfLoadTile  tiles[XCF_TILE_BATCH_SIZE];
+  gint         n_tiles = 0;
+  gboolean     success = FALSE;
 
   format = gegl_buffer_get_format (buffer);
   bpp    = babl_format_get_bytes_per_pixel (format);
@@ -1724,7 +1788,7 @@ xcf_load_level (XcfInfo    *info,
    *  if it is '0', then this tile level is empty
    *  and we can simply return.
    */
-  info->cp += xcf_read_int32 (info->input, &offset, 1);
+  info->cp += xcf_read_offset (info, &offset, 1);
   if (offset == 0)
     return TRUE;
 
@@ -1732,39 +1796,41 @@ xcf_load_level (XcfInfo    *info,
   n_tile_cols = gimp_gegl_buffer_get_n_tile_cols (buffer, XCF_TILE_WIDTH);
 
   ntiles = n_tile_rows * n_tile_cols;
+
+  if ((info->mapped_file || info->lazy_input) &&
+      (info->compression == COMPRESS_NONE ||
+       info->compression == COMPRESS_RLE  ||
+       info->compression == COMPRESS_ZLIB))
+    {
+      return xcf_load_level_lazy (info, buffer, offset, ntiles);
+    }
+
+  /* read the whole offset table up front, so the tiles can be read
+   * one after another instead of seeking back to the table each time
+   */
+  offsets = xcf_load_level_offsets (info, offset, ntiles);
+  if (! offsets)
+    return FALSE;
+
   for (i = 0; i < ntiles; i++)
     {
       GeglRectangle rect;
+      gint          data_length;
 
       fail = FALSE;
 
-      if (offset == 0)
-        {
-          gimp_message_literal (info->gimp, G_OBJECT (info->progress),
-                                GIMP_MESSAGE_ERROR,
-                                "not enough tiles found in level");
-          return FALSE;
-        }
-
-      /* save the current position as it is where the
-       *  next tile offset is stored.
-       */
-      saved_pos = info->cp;
-
-      /* read in the offset of the next tile so we can calculate the amount
-         of data needed for this tile*/
-      info->cp += xcf_read_int32 (info->input, &offset2, 1);
-
-      /* if the offset is 0 then we need to read in the maximum possible
-         allowing for negative compression */
-      if (offset2 == 0)
-        offset2 = offset + XCF_TILE_WIDTH * XCF_TILE_WIDTH * bpp * 1.5;
+      /* if the next offset is 0 then we need to read in the maximum
+         possible allowing for negative compression */
+      if (offsets[i + 1] != 0)
+        data_length = offsets[i + 1] - offsets[i];
+      else
+        data_length = XCF_TILE_WIDTH * XCF_TILE_WIDTH * bpp * 1.5;
                                         /* 1.5 is probably more
                                            than we need to allow */
 
       /* seek to the tile offset */
-      if (! xcf_seek_pos (info, offset, NULL))
-        return FALSE;
+      if (! xcf_seek_pos (info, offsets[i], NULL))
+        goto out;
 
       /* get the tile from the tile manager */
       gimp_gegl_buffer_get_tile_rect (buffer,
@@ -1781,14 +1847,23 @@ xcf_load_level (XcfInfo    *info,
             fail = TRUE;
           break;
         case COMPRESS_RLE:
-          if (!xcf_load_tile_rle (info, buffer, &rect, format,
-                                  offset2 - offset))
-            fail = TRUE;
-          break;
         case COMPRESS_ZLIB:
-          if (!xcf_load_tile_zlib (info, buffer, &rect, format,
-                                   offset2 - offset))
+          /* only read the tile here, the tiles are decoded in parallel
+           * once a batch is complete
+           */
+          if (!xcf_load_tile_data (info, &tiles[n_tiles],
+                                   &rect, format, data_length))
             fail = TRUE;
+          else
+            n_tiles++;
+
+          if (n_tiles == XCF_TILE_BATCH_SIZE || i == ntiles - 1)
+            {
+              if (!xcf_load_tiles (buffer, format, tiles, n_tiles))
+                fail = TRUE;
+
+              n_tiles = 0;
+            }
           break;
         case COMPRESS_FRACTAL:
           g_printerr ("xcf: fractal compression unimplemented. "
@@ -1803,27 +1878,106 @@ xcf_load_level (XcfInfo    *info,
         }
 
       if (fail)
-        return FALSE;
+        goto out;
 
       GIMP_LOG (XCF, "loaded tile %d/%d", i + 1, ntiles);
+    }
 
-      /* restore the saved position so we'll be ready to
-       *  read the next offset.
-       */
-      if (!xcf_seek_pos (info, saved_pos, NULL))
-        return FALSE;
+  success = TRUE;
+
+ out:
+  for (i = 0; i < n_tiles; i++)
+    g_free (tiles[i].src);
+
+  g_free (offsets);
+
+  return success;
+}
+
+/* Reads the rest of the offset table of a level of @ntiles tiles,
+ * whose first entry @offset has already been read. Returns the
+ * @ntiles + 1 offsets, the last one being 0, or NULL if the table
+ * is broken.
+ */
+static goffset *
+xcf_load_level_offsets (XcfInfo *info,
+                        goffset  offset,
+                        guint    ntiles)
+{
+  goffset *offsets;
+  guint    i;
+
+  offsets = g_new (goffset, ntiles + 1);
 
-      /* read in the offset of the next tile */
-      info->cp += xcf_read_int32 (info->input, &offset, 1);
+  offsets[0] = offset;
+  info->cp += xcf_read_offset (info, offsets + 1, ntiles);
+
+  for (i = 0; i < ntiles; i++)
+    {
+      if (offsets[i] == 0)
+        {
+          gimp_message_literal (info->gimp, G_OBJECT (info->progress),
+                                GIMP_MESSAGE_ERROR,
+                                "not enough tiles found in level");
+          g_free (offsets);
+          return NULL;
+        }
     }
 
-  if (offset != 0)
+  if (offsets[ntiles] != 0)
     {
       gimp_message (info->gimp, G_OBJECT (info->progress), GIMP_MESSAGE_ERROR,
-                    "encountered garbage after reading level: %d", offset);
-      return FALSE;
+                    "encountered garbage after reading level: %"
+                    G_GOFFSET_FORMAT, offsets[ntiles]);
+      g_free (offsets);
+      return NULL;
     }
 
+  return offsets;
+}
+
+/* Only reads the level's tile offset table and installs a tile handler
+ * on @buffer that decodes each tile from the memory-mapped file, or the
+ * remote file's own stream, when it is first accessed. @offset is the already read first tile offset.
+ */
+static gboolean
+xcf_load_level_lazy (XcfInfo    *info,
+                     GeglBuffer *buffer,
+                     goffset     offset,
+                     guint       ntiles)
+{
+  GeglTileHandler *handler;
+  goffset         *offsets;
+  gint             width;
+  gint             height;
+
+  width  = gegl_buffer_get_width  (buffer);
+  height = gegl_buffer_get_height (buffer);
+
+  offsets = xcf_load_level_offsets (info, offset, ntiles);
+  if (! offsets)
+    return FALSE;
+
+  if (info->mapped_file)
+    handler = gimp_tile_handler_xcf_new (info->gimp, info->file,
+                                         info->mapped_file, info->compression,
+                                         offsets, width, height);
+  else
+    handler = gimp_tile_handler_xcf_new_for_stream (info->gimp, info->file,
+                                                    info->lazy_input,
+                                                    info->lazy_etag,
+                                                    info->compression,
+                                                    offsets, width, height);
+  g_free (offsets);
+
+  gimp_tile_handler_validate_assign (GIMP_TILE_HANDLER_VALIDATE (handler),
+                                     buffer);
+  gimp_tile_handler_validate_invalidate (GIMP_TILE_HANDLER_VALIDATE (handler),
+                                         0, 0, width, height);
+
+  /*  the buffer keeps the handler alive  */
+  g_object_unref (handler);
+
   return TRUE;
 }
 
@@ -1846,20 +2000,22 @@ xcf_load_tile (XcfInfo       *info,
 }
 
 static gboolean
-xcf_load_tile_rle (XcfInfo       *info,
-                   GeglBuffer    *buffer,
-                   GeglRectangle *tile_rect,
-                   const Babl    *format,
-                   gint           data_length)
+xcf_load_tile_data (XcfInfo       *info,
+                    XcfLoadTile   *tile,
+                    GeglRectangle *tile_rect,
+                    const Babl    *format,
+                    gint           data_length)
 {
-  gint    bpp       = babl_format_get_bytes_per_pixel (format);
-  gint    tile_size = bpp * tile_rect->width * tile_rect->height;
-  guchar *tile_data = g_alloca (tile_size);
-  gint    i;
-  gsize   nmemb_read_successfully;
-  guchar *xcfdata;
-  guchar *xcfodata;
-  guchar *xcfdatalimit;
+  gsize bytes_read;
+
+  tile->rect        = *tile_rect;
+  tile->compression = info->compression;
+  tile->bpp         = babl_format_get_bytes_per_pixel (format);
+  tile->src         = NULL;
+  tile->src_size    = 0;
+  tile->data        = NULL;
+  tile->size        = tile->bpp * tile_rect->width * tile_rect->height;
+  tile->success     = TRUE;
 
   /* Workaround for bug #357809: avoid crashing on g_malloc() and skip
    * this tile (return TRUE without storing data) as if it did not
@@ -1870,207 +2026,92 @@ xcf_load_tile_rle (XcfInfo       *info,
   if (data_length <= 0)
     return TRUE;
 
-  xcfdata = xcfodata = g_alloca (data_length);
+  tile->src = g_malloc (data_length);
 
   /* we have to read directly instead of xcf_read_* because we may be
    * reading past the end of the file here
    */
-  g_input_stream_read_all (info->input, xcfdata, data_length,
-                           &nmemb_read_successfully, NULL, NULL);
+  g_input_stream_read_all (info->input, tile->src, data_length,
+                           &bytes_read, NULL, NULL);
 
-  if (nmemb_read_successfully == 0)
-    return TRUE;
+  info->cp       += bytes_read;
+  tile->src_size  = bytes_read;
 
-  info->cp += nmemb_read_successfully;
+  return TRUE;
+}
 
-  xcfdatalimit = &xcfodata[nmemb_read_successfully - 1];
+static void
+xcf_load_decode_tiles (gsize        offset,
+                       gsize        size,
+                       XcfLoadTile *tiles)
+{
+  gsize i;
 
-  for (i = 0; i < bpp; i++)
+  for (i = offset; i < offset + size; i++)
     {
-      guchar *data  = tile_data + i;
-      gint    size  = tile_rect->width * tile_rect->height;
-      gint    count = 0;
-      guchar  val;
-      gint    length;
-      gint    j;
-
-      while (size > 0)
-        {
-          if (xcfdata > xcfdatalimit)
-            {
-              goto bogus_rle;
-            }
-
-          val = *xcfdata++;
-
-          length = val;
-          if (length >= 128)
-            {
-              length = 255 - (length - 1);
-              if (length == 128)
-                {
-                  if (xcfdata >= xcfdatalimit)
-                    {
-                      goto bogus_rle;
-                    }
-
-                  length = (*xcfdata << 8) + xcfdata[1];
-                  xcfdata += 2;
-                }
+      XcfLoadTile *tile = &tiles[i];
 
-              count += length;
-              size -= length;
+      /* an empty tile, see xcf_load_tile_data() */
+      if (tile->src_size == 0)
+        continue;
 
-              if (size < 0)
-                {
-                  goto bogus_rle;
-                }
-
-              if (&xcfdata[length-1] > xcfdatalimit)
-                {
-                  goto bogus_rle;
-                }
-
-              while (length-- > 0)
-                {
-                  *data = *xcfdata++;
-                  data += bpp;
-                }
-            }
-          else
-            {
-              length += 1;
-              if (length == 128)
-                {
-                  if (xcfdata >= xcfdatalimit)
-                    {
-                      goto bogus_rle;
-                    }
-
-                  length = (*xcfdata << 8) + xcfdata[1];
-                  xcfdata += 2;
-                }
-
-              count += length;
-              size -= length;
-
-              if (size < 0)
-                {
-                  goto bogus_rle;
-                }
-
-              if (xcfdata > xcfdatalimit)
-                {
-                  goto bogus_rle;
-                }
-
-              val = *xcfdata++;
-
-              for (j = 0; j < length; j++)
-                {
-                  *data = val;
-                  data += bpp;
-                }
-            }
-        }
+      if (tile->compression == COMPRESS_RLE)
+        tile->success = xcf_tile_decode_rle (tile->src, tile->src_size,
+                                             tile->data, tile->bpp,
+                                             tile->rect.width *
+                                             tile->rect.height);
+      else
+        tile->success = xcf_tile_decode_zlib (tile->src, tile->src_size,
+                                              tile->data, tile->size);
     }
-
-  gegl_buffer_set (buffer, tile_rect, 0, format, tile_data,
-                   GEGL_AUTO_ROWSTRIDE);
-
-  return TRUE;
-
- bogus_rle:
-  return FALSE;
 }
 
+/* Decodes the batch of @n_tiles @tiles in parallel and stores them in
+ * @buffer, freeing the compressed data.
+ */
 static gboolean
-xcf_load_tile_zlib (XcfInfo       *info,
-                    GeglBuffer    *buffer,
-                    GeglRectangle *tile_rect,
-                    const Babl    *format,
-                    gint           data_length)
+xcf_load_tiles (GeglBuffer  *buffer,
+                const Babl  *format,
+                XcfLoadTile *tiles,
+                gint         n_tiles)
 {
-  z_stream  strm;
-  int       action;
-  int       status;
-  gint      bpp       = babl_format_get_bytes_per_pixel (format);
-  gint      tile_size = bpp * tile_rect->width * tile_rect->height;
-  guchar   *tile_data = g_alloca (tile_size);
-  gsize     bytes_read;
-  guchar   *xcfdata;
+  gint     bpp      = babl_format_get_bytes_per_pixel (format);
+  gint     max_size = bpp * XCF_TILE_WIDTH * XCF_TILE_HEIGHT;
+  guchar  *data;
+  gboolean success  = TRUE;
+  gint     i;
 
-  /* Workaround for bug #357809: avoid crashing on g_malloc() and skip
-   * this tile (return TRUE without storing data) as if it did not
-   * contain any data.  It is better than returning FALSE, which would
-   * skip the whole hierarchy while there may still be some valid
-   * tiles in the file.
-   */
-  if (data_length <= 0)
+  if (n_tiles == 0)
     return TRUE;
 
-  xcfdata = g_alloca (data_length);
+  data = g_malloc (n_tiles * max_size);
 
-  /* we have to read directly instead of xcf_read_* because we may be
-   * reading past the end of the file here
-   */
-  g_input_stream_read_all (info->input, xcfdata, data_length,
-                           &bytes_read, NULL, NULL);
-
-  if (bytes_read == 0)
-    return TRUE;
-
-  info->cp      += bytes_read;
-
-  strm.next_out  = tile_data;
-  strm.avail_out = tile_size;
-
-  strm.zalloc    = Z_NULL;
-  strm.zfree     = Z_NULL;
-  strm.opaque    = Z_NULL;
-  strm.next_in   = xcfdata;
-  strm.avail_in  = bytes_read;
+  for (i = 0; i < n_tiles; i++)
+    tiles[i].data = data + i * max_size;
 
-  /* Initialize the stream decompression. */
-  status = inflateInit (&strm);
-  if (status != Z_OK)
-    return FALSE;
-
-  action = Z_NO_FLUSH;
+  gimp_parallel_distribute_range (n_tiles, 1,
+                                  (GimpParallelDistributeRangeFunc)
+                                  xcf_load_decode_tiles,
+                                  tiles);
 
-  while (status == Z_OK)
+  for (i = 0; i < n_tiles; i++)
     {
-      if (strm.avail_in == 0)
-        {
-          action = Z_FINISH;
-        }
+      XcfLoadTile *tile = &tiles[i];
 
-      status = inflate (&strm, action);
+      if (! tile->success)
+        success = FALSE;
+      else if (success && tile->src_size > 0)
+        gegl_buffer_set (buffer, &tile->rect, 0, format, tile->data,
+                         GEGL_AUTO_ROWSTRIDE);
 
-      if (status == Z_STREAM_END)
-        {
-          /* All the data was successfully decoded. */
-          break;
-        }
-      else if (status == Z_BUF_ERROR)
-        {
-          g_printerr ("xcf: decompressed tile bigger than the expected size.");
-          inflateEnd (&strm);
-          return FALSE;
-        }
-      else if (status != Z_OK)
-        {
-          g_printerr ("xcf: tile decompression failed: %s", zError (status));
-          inflateEnd (&strm);
-          return FALSE;
-        }
+      g_free (tile->src);
+      tile->src  = NULL;
+      tile->data = NULL;
     }
 
-  gegl_buffer_set (buffer, tile_rect, 0, format, tile_data,
-                   GEGL_AUTO_ROWSTRIDE);
+  g_free (data);
 
-  inflateEnd (&strm);
-  return TRUE;
+  return success;
 }
 
 static GimpParasite *
@@ -22,6 +22,15 @@
 #define XCF_TILE_WIDTH  64
 #define XCF_TILE_HEIGHT 64
 
+/* the number of tiles which are compressed or decompressed in parallel,
+ * and kept in memory at once, when zlib compression is used for saving,
+ * or RLE or zlib compression for loading
+ */
+#define XCF_TILE_BATCH_SIZE 64
+
+/* the size of the buffer that collects the writes of an XCF file */
+#define XCF_WRITE_BUFFER_SIZE (1024 * 1024)
+
 typedef enum
 {
   PROP_END                =  0,
@@ -63,7 +72,7 @@ typedef enum
 {
   COMPRESS_NONE              =  0,
   COMPRESS_RLE               =  1,
-  COMPRESS_ZLIB              =  2,  /* unused */
+  COMPRESS_ZLIB              =  2,
   COMPRESS_FRACTAL           =  3   /* unused */
 } XcfCompressionType;
 
@@ -93,16 +102,26 @@ struct _XcfInfo
   GInputStream       *input;
   GOutputStream      *output;
   GSeekable          *seekable;
-  guint               cp;
+  GFile              *file;
+  GMappedFile        *mapped_file;  /* set when loading lazily */
+  GInputStream       *lazy_input;   /* set when loading a remote file lazily */
+  gchar              *lazy_etag;    /* lazy_input's file's entity tag */
+  goffset             cp;
   const gchar        *filename;
   GimpTattoo          tattoo_state;
   GimpLayer          *active_layer;
   GimpChannel        *active_channel;
   GimpDrawable       *floating_sel_drawable;
   GimpLayer          *floating_sel;
-  guint               floating_sel_offset;
+  goffset             floating_sel_offset;
   XcfCompressionType  compression;
   gint                file_version;
+  gint                bytes_per_offset; /* 8 since version 9, else 4 */
+
+  /* saving only */
+  GList              *saved_levels; /* the levels written, see xcf-save.c */
+  GFile              *copy_file;    /* the file unchanged levels come from */
+  GInputStream       *copy_input;
 };
 
 
@@ -50,6 +50,27 @@ xcf_read_int32 (GInputStream *input,
   return total;
 }
 
+guint
+xcf_read_int64 (GInputStream *input,
+                guint64      *data,
+                gint          count)
+{
+  guint total = 0;
+
+  if (count > 0)
+    {
+      total += xcf_read_int8 (input, (guint8 *) data, count * 8);
+
+      while (count--)
+        {
+          *data = GUINT64_FROM_BE (*data);
+          data++;
+        }
+    }
+
+  return total;
+}
+
 guint
 xcf_read_float (GInputStream *input,
                 gfloat       *data,
@@ -33,6 +33,7 @@
 #include "gegl/gimp-gegl-tile-compat.h"
 
 #include "core/gimp.h"
+#include "core/gimp-parallel.h"
 #include "core/gimpcontainer.h"
 #include "core/gimpchannel.h"
 #include "core/gimpdrawable.h"
@@ -69,6 +70,38 @@
 #include "gimp-intl.h"
 
 
+#define XCF_SAVED_LEVEL_KEY "gimp-xcf-saved-level"
+#define XCF_TRACKED_KEY     "gimp-xcf-tracked"
+#define XCF_COPY_CHUNK_SIZE (1024 * 1024)
+
+
+/* A buffer's level as written by a previous save.  As long as neither
+ * the buffer nor the file have changed since, the level's tile data
+ * can be copied from that file instead of being compressed again.
+ */
+typedef struct _XcfSavedLevel XcfSavedLevel;
+
+struct _XcfSavedLevel
+{
+  GeglBuffer         *buffer;      /* only while the save is running */
+
+  GFile              *file;
+  guint64             file_size;
+  guint64             file_mtime;
+
+  XcfCompressionType  compression;
+  gint                bytes_per_offset;
+  const Babl         *format;
+  gint                width;
+  gint                height;
+
+  guint               n_tiles;
+  goffset            *offsets;     /* relative to data_start */
+  goffset             data_start;
+  goffset             data_length;
+};
+
+
 static gboolean xcf_save_image_props   (XcfInfo           *info,
                                         GimpImage         *image,
                                         GError           **error);
@@ -99,6 +132,13 @@ static gboolean xcf_save_buffer        (XcfInfo           *info,
 static gboolean xcf_save_level         (XcfInfo           *info,
                                         GeglBuffer        *buffer,
                                         GError           **error);
+static gboolean xcf_save_level_copy    (XcfInfo           *info,
+                                        GeglBuffer        *buffer,
+                                        gboolean          *copied,
+                                        GError           **error);
+static void     xcf_save_track_drawable
+                                       (GimpDrawable      *drawable);
+static void     xcf_save_track_buffer  (GeglBuffer        *buffer);
 static gboolean xcf_save_tile          (XcfInfo           *info,
                                         GeglBuffer        *buffer,
                                         GeglRectangle     *tile_rect,
@@ -110,10 +150,19 @@ static gboolean xcf_save_tile_rle      (XcfInfo           *info,
                                         const Babl        *format,
                                         guchar            *rlebuf,
                                         GError           **error);
-static gboolean xcf_save_tile_zlib     (XcfInfo           *info,
+static gboolean xcf_save_tiles_zlib    (XcfInfo           *info,
                                         GeglBuffer        *buffer,
-                                        GeglRectangle     *tile_rect,
                                         const Babl        *format,
+                                        goffset           *offset_table,
+                                        guint              ntiles,
+                                        GError           **error);
+static gboolean xcf_save_tile_is_uniform
+                                       (const guchar      *tile_data,
+                                        gint               n_pixels,
+                                        gint               bpp);
+static guint    xcf_write_offset       (XcfInfo           *info,
+                                        const goffset     *data,
+                                        gint               count,
                                         GError           **error);
 static gboolean xcf_save_parasite      (XcfInfo           *info,
                                         GimpParasite      *parasite,
@@ -139,6 +188,18 @@ static gboolean xcf_save_vectors       (XcfInfo           *info,
     }                                                                  \
   } G_STMT_END
 
+#define xcf_write_offset_check_error(info, data, count) G_STMT_START {  \
+  info->cp += xcf_write_offset (info, data, count, &tmp_error);        \
+  if (tmp_error)                                                       \
+    {                                                                  \
+      g_propagate_error (error, tmp_error);                            \
+      return FALSE;                                                    \
+    }                                                                  \
+  } G_STMT_END
+
+#define xcf_write_zero_offset_check_error(info, count) \
+  xcf_write_zero_int32_check_error (info, (count) * info->bytes_per_offset / 4)
+
 #define xcf_write_zero_int32_check_error(info, count) G_STMT_START {  \
   info->cp += xcf_write_zero_int32 (info->output, count, &tmp_error); \
   if (tmp_error)                                                      \
@@ -202,8 +263,8 @@ xcf_save_image (XcfInfo    *info,
   GList   *all_layers;
   GList   *all_channels;
   GList   *list;
-  guint32  saved_pos;
-  guint32  offset;
+  goffset  saved_pos;
+  goffset  offset;
   guint32  value;
   guint    n_layers;
   guint    n_channels;
@@ -268,7 +329,7 @@ xcf_save_image (XcfInfo    *info,
   saved_pos = info->cp;
 
   /* write an empty offset table */
-  xcf_write_zero_int32_check_error (info, n_layers + n_channels + 2);
+  xcf_write_zero_offset_check_error (info, n_layers + n_channels + 2);
 
   /* 'offset' is where we will write the next layer or channel */
   offset = info->cp;
@@ -281,7 +342,7 @@ xcf_save_image (XcfInfo    *info,
        * offset of the layer
        */
       xcf_check_error (xcf_seek_pos (info, saved_pos, error));
-      xcf_write_int32_check_error (info, &offset, 1);
+      xcf_write_offset_check_error (info, &offset, 1);
 
       /* remember the next slot in the offset table */
       saved_pos = info->cp;
@@ -299,7 +360,7 @@ xcf_save_image (XcfInfo    *info,
   /* skip a '0' in the offset table to indicate the end of the layer
    * offsets
    */
-  saved_pos += 4;
+  saved_pos += info->bytes_per_offset;
 
   for (list = all_channels; list; list = g_list_next (list))
     {
@@ -309,7 +370,7 @@ xcf_save_image (XcfInfo    *info,
        * offset of the channel
        */
       xcf_check_error (xcf_seek_pos (info, saved_pos, error));
-      xcf_write_int32_check_error (info, &offset, 1);
+      xcf_write_offset_check_error (info, &offset, 1);
 
       /* remember the next slot in the offset table */
       saved_pos = info->cp;
@@ -334,6 +395,64 @@ xcf_save_image (XcfInfo    *info,
   return ! g_output_stream_is_closed (info->output);
 }
 
+/* Called after the file is closed.  On success, the levels written
+ * by this save replace the ones remembered from the previous save.
+ */
+void
+xcf_save_finish (XcfInfo  *info,
+                 GFile    *file,
+                 gboolean  success)
+{
+  guint64  size;
+  guint64  mtime;
+  GList   *list;
+
+  if (success && ! xcf_save_get_file_stamp (file, &size, &mtime))
+    success = FALSE;
+
+  for (list = info->saved_levels; list; list = g_list_next (list))
+    {
+      XcfSavedLevel *level  = list->data;
+      GeglBuffer    *buffer = level->buffer;
+
+      level->buffer = NULL;
+
+      if (success)
+        {
+          level->file       = g_object_ref (file);
+          level->file_size  = size;
+          level->file_mtime = mtime;
+
+          xcf_save_track_buffer (buffer);
+
+          g_object_set_data_full (G_OBJECT (buffer),
+                                  XCF_SAVED_LEVEL_KEY, level,
+                                  (GDestroyNotify) xcf_saved_level_free);
+        }
+      else
+        {
+          xcf_saved_level_free (level);
+        }
+
+      g_object_unref (buffer);
+    }
+
+  g_list_free (info->saved_levels);
+  info->saved_levels = NULL;
+
+  if (info->copy_input)
+    {
+      g_object_unref (info->copy_input);
+      info->copy_input = NULL;
+    }
+
+  if (info->copy_file)
+    {
+      g_object_unref (info->copy_file);
+      info->copy_file = NULL;
+    }
+}
+
 static gboolean
 xcf_save_image_props (XcfInfo    *info,
                       GimpImage  *image,
@@ -647,15 +766,15 @@ xcf_save_prop (XcfInfo    *info,
 
     case PROP_FLOATING_SELECTION:
       {
-        guint32 dummy;
+        goffset dummy;
 
         dummy = 0;
-        size = 4;
+        size = info->bytes_per_offset;
 
         xcf_write_prop_type_check_error (info, prop_type);
         xcf_write_int32_check_error (info, &size, 1);
         info->floating_sel_offset = info->cp;
-        xcf_write_int32_check_error (info, &dummy, 1);
+        xcf_write_offset_check_error (info, &dummy, 1);
       }
       break;
 
@@ -954,8 +1073,8 @@ xcf_save_prop (XcfInfo    *info,
 
         if (gimp_parasite_list_persistent_length (list) > 0)
           {
-            guint32 base, length = 0;
-            long    pos;
+            goffset base, pos;
+            guint32 length = 0;
 
             xcf_write_prop_type_check_error (info, prop_type);
 
@@ -995,8 +1114,8 @@ xcf_save_prop (XcfInfo    *info,
 
     case PROP_PATHS:
       {
-        guint32 base, length = 0;
-        glong   pos;
+        goffset base, pos;
+        guint32 length = 0;
 
         xcf_write_prop_type_check_error (info, prop_type);
 
@@ -1056,8 +1175,8 @@ xcf_save_prop (XcfInfo    *info,
 
     case PROP_VECTORS:
       {
-        guint32 base, length = 0;
-        glong   pos;
+        goffset base, pos;
+        guint32 length = 0;
 
         xcf_write_prop_type_check_error (info, prop_type);
 
@@ -1140,8 +1259,8 @@ xcf_save_layer (XcfInfo    *info,
                 GimpLayer  *layer,
                 GError    **error)
 {
-  guint32      saved_pos;
-  guint32      offset;
+  goffset      saved_pos;
+  goffset      offset;
   guint32      value;
   const gchar *string;
   GError      *tmp_error = NULL;
@@ -1153,7 +1272,7 @@ xcf_save_layer (XcfInfo    *info,
     {
       saved_pos = info->cp;
       xcf_check_error (xcf_seek_pos (info, info->floating_sel_offset, error));
-      xcf_write_int32_check_error (info, &saved_pos, 1);
+      xcf_write_offset_check_error (info, &saved_pos, 1);
       xcf_check_error (xcf_seek_pos (info, saved_pos, error));
     }
 
@@ -1175,13 +1294,15 @@ xcf_save_layer (XcfInfo    *info,
   xcf_save_layer_props (info, image, layer, error);
 
   /* write out the layer tile hierarchy */
-  offset = info->cp + 8;
-  xcf_write_int32_check_error (info, &offset, 1);
+  xcf_save_track_drawable (GIMP_DRAWABLE (layer));
+
+  offset = info->cp + 2 * info->bytes_per_offset;
+  xcf_write_offset_check_error (info, &offset, 1);
 
   saved_pos = info->cp;
 
   /* write a zero layer mask offset */
-  xcf_write_zero_int32_check_error (info, 1);
+  xcf_write_zero_offset_check_error (info, 1);
 
   xcf_check_error (xcf_save_buffer (info,
                                     gimp_drawable_get_buffer (GIMP_DRAWABLE (layer)),
@@ -1195,7 +1316,7 @@ xcf_save_layer (XcfInfo    *info,
       GimpLayerMask *mask = gimp_layer_get_mask (layer);
 
       xcf_check_error (xcf_seek_pos (info, saved_pos, error));
-      xcf_write_int32_check_error (info, &offset, 1);
+      xcf_write_offset_check_error (info, &offset, 1);
 
       xcf_check_error (xcf_seek_pos (info, offset, error));
       xcf_check_error (xcf_save_channel (info, image, GIMP_CHANNEL (mask),
@@ -1211,8 +1332,8 @@ xcf_save_channel (XcfInfo      *info,
                   GimpChannel  *channel,
                   GError      **error)
 {
-  guint32      saved_pos;
-  guint32      offset;
+  goffset      saved_pos;
+  goffset      offset;
   guint32      value;
   const gchar *string;
   GError      *tmp_error = NULL;
@@ -1224,7 +1345,7 @@ xcf_save_channel (XcfInfo      *info,
     {
       saved_pos = info->cp;
       xcf_check_error (xcf_seek_pos (info, info->floating_sel_offset, error));
-      xcf_write_int32_check_error (info, &saved_pos, 1);
+      xcf_write_offset_check_error (info, &saved_pos, 1);
       xcf_check_error (xcf_seek_pos (info, saved_pos, error));
     }
 
@@ -1243,8 +1364,10 @@ xcf_save_channel (XcfInfo      *info,
   xcf_save_channel_props (info, image, channel, error);
 
   /* write out the channel tile hierarchy */
-  offset = info->cp + 4;
-  xcf_write_int32_check_error (info, &offset, 1);
+  xcf_save_track_drawable (GIMP_DRAWABLE (channel));
+
+  offset = info->cp + info->bytes_per_offset;
+  xcf_write_offset_check_error (info, &offset, 1);
 
   xcf_check_error (xcf_save_buffer (info,
                                     gimp_drawable_get_buffer (GIMP_DRAWABLE (channel)),
@@ -1276,8 +1399,8 @@ xcf_save_buffer (XcfInfo     *info,
                  GError     **error)
 {
   const Babl *format;
-  guint32     saved_pos;
-  guint32     offset;
+  goffset     saved_pos;
+  goffset     offset;
   guint32     width;
   guint32     height;
   guint32     bpp;
@@ -1306,7 +1429,7 @@ xcf_save_buffer (XcfInfo     *info,
   saved_pos = info->cp;
 
   /* write an empty offset table */
-  xcf_write_zero_int32_check_error (info, nlevels + 1);
+  xcf_write_zero_offset_check_error (info, nlevels + 1);
 
   /* 'offset' is where we will write the next level */
   offset = info->cp;
@@ -1317,7 +1440,7 @@ xcf_save_buffer (XcfInfo     *info,
        * offset of the level
        */
       xcf_check_error (xcf_seek_pos (info, saved_pos, error));
-      xcf_write_int32_check_error (info, &offset, 1);
+      xcf_write_offset_check_error (info, &offset, 1);
 
       /* remember the next slot in the offset table */
       saved_pos = info->cp;
@@ -1327,18 +1450,25 @@ xcf_save_buffer (XcfInfo     *info,
 
       if (i == 0)
         {
-          /* write out the level. */
-          xcf_check_error (xcf_save_level (info, buffer, error));
+          gboolean copied;
+
+          /* copy the level from the previous save if it is unchanged,
+           * otherwise write it out
+           */
+          xcf_check_error (xcf_save_level_copy (info, buffer, &copied,
+                                                error));
+
+          if (! copied)
+            xcf_check_error (xcf_save_level (info, buffer, error));
         }
       else
         {
           /* fake an empty level */
-          tmp1 = 0;
           width  /= 2;
           height /= 2;
           xcf_write_int32_check_error (info, (guint32 *) &width,  1);
           xcf_write_int32_check_error (info, (guint32 *) &height, 1);
-          xcf_write_int32_check_error (info, (guint32 *) &tmp1,   1);
+          xcf_write_zero_offset_check_error (info, 1);
         }
 
       /* the next level's offset if after the level we just wrote */
@@ -1358,10 +1488,10 @@ xcf_save_level (XcfInfo     *info,
                 GError     **error)
 {
   const Babl *format;
-  guint32    *offset_table;
-  guint32    *next_offset;
-  guint32     saved_pos;
-  guint32     offset;
+  goffset    *offset_table;
+  goffset    *next_offset;
+  goffset     saved_pos;
+  goffset     offset;
   guint32     width;
   guint32     height;
   gint        bpp;
@@ -1398,57 +1528,88 @@ xcf_save_level (XcfInfo     *info,
    * tile, see bug #686862. allocate ntiles + 1 slots because a zero
    * offset indicates the offset table's end.
    */
-  offset_table = g_alloca ((ntiles + 1) * sizeof (gint32));
-  memset (offset_table, 0, (ntiles + 1) * sizeof (gint32));
+  offset_table = g_alloca ((ntiles + 1) * sizeof (goffset));
+  memset (offset_table, 0, (ntiles + 1) * sizeof (goffset));
   next_offset = offset_table;
 
   /* 'saved_pos' is the offset of the tile offset table  */
   saved_pos = info->cp;
 
   /* write an empty offset table */
-  xcf_write_zero_int32_check_error (info, ntiles + 1);
+  xcf_write_zero_offset_check_error (info, ntiles + 1);
 
   /* 'offset' is where we will write the next tile */
   offset = info->cp;
 
-  for (i = 0; i < ntiles; i++)
+  if (info->compression == COMPRESS_ZLIB)
+    {
+      /* zlib tiles are compressed in parallel and written in batches */
+      xcf_check_error (xcf_save_tiles_zlib (info, buffer, format,
+                                            offset_table, ntiles, error));
+
+      offset = info->cp;
+    }
+  else
     {
-      GeglRectangle rect;
+      for (i = 0; i < ntiles; i++)
+        {
+          GeglRectangle rect;
 
-      /* store the offset in the table and increment the next pointer */
-      *next_offset++ = offset;
+          /* store the offset in the table and increment the next pointer */
+          *next_offset++ = offset;
 
-      gimp_gegl_buffer_get_tile_rect (buffer,
-                                      XCF_TILE_WIDTH, XCF_TILE_HEIGHT,
-                                      i, &rect);
+          gimp_gegl_buffer_get_tile_rect (buffer,
+                                          XCF_TILE_WIDTH, XCF_TILE_HEIGHT,
+                                          i, &rect);
 
-      /* write out the tile. */
-      switch (info->compression)
-        {
-        case COMPRESS_NONE:
-          xcf_check_error (xcf_save_tile (info, buffer, &rect, format,
-                                          error));
-          break;
-        case COMPRESS_RLE:
-          xcf_check_error (xcf_save_tile_rle (info, buffer, &rect, format,
-                                              rlebuf, error));
-          break;
-        case COMPRESS_ZLIB:
-          xcf_check_error (xcf_save_tile_zlib (info, buffer, &rect, format,
-                                               error));
-          break;
-        case COMPRESS_FRACTAL:
-          g_warning ("xcf: fractal compression unimplemented");
-          return FALSE;
+          /* write out the tile. */
+          switch (info->compression)
+            {
+            case COMPRESS_NONE:
+              xcf_check_error (xcf_save_tile (info, buffer, &rect, format,
+                                              error));
+              break;
+            case COMPRESS_RLE:
+              xcf_check_error (xcf_save_tile_rle (info, buffer, &rect, format,
+                                                  rlebuf, error));
+              break;
+            case COMPRESS_ZLIB:
+              g_return_val_if_reached (FALSE);
+            case COMPRESS_FRACTAL:
+              g_warning ("xcf: fractal compression unimplemented");
+              return FALSE;
+            }
+
+          /* the next tile's offset is after the tile we just wrote */
+          offset = info->cp;
         }
+    }
 
-      /* the next tile's offset is after the tile we just wrote */
-      offset = info->cp;
+  /* remember where the tiles went, for the next save */
+  if (ntiles > 0)
+    {
+      XcfSavedLevel *level = g_slice_new0 (XcfSavedLevel);
+
+      level->buffer           = g_object_ref (buffer);
+      level->compression      = info->compression;
+      level->bytes_per_offset = info->bytes_per_offset;
+      level->format           = format;
+      level->width            = width;
+      level->height           = height;
+      level->n_tiles          = ntiles;
+      level->offsets          = g_new (goffset, ntiles);
+      level->data_start       = offset_table[0];
+      level->data_length      = offset - offset_table[0];
+
+      for (i = 0; i < ntiles; i++)
+        level->offsets[i] = offset_table[i] - offset_table[0];
+
+      info->saved_levels = g_list_prepend (info->saved_levels, level);
     }
 
   /* seek back to the offset table and write it  */
   xcf_check_error (xcf_seek_pos (info, saved_pos, error));
-  xcf_write_int32_check_error (info, offset_table, ntiles + 1);
+  xcf_write_offset_check_error (info, offset_table, ntiles + 1);
 
   /* seek to the end of the file */
   xcf_check_error (xcf_seek_pos (info, offset, error));
@@ -1494,6 +1655,35 @@ xcf_save_tile_rle (XcfInfo        *info,
   gegl_buffer_get (buffer, tile_rect, 1.0, format, tile_data,
                    GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
 
+  /* a uniform tile is a single run per channel, which is exactly what
+   * the encoder below would produce for it
+   */
+  if (xcf_save_tile_is_uniform (tile_data,
+                                tile_rect->width * tile_rect->height, bpp))
+    {
+      gint size = tile_rect->width * tile_rect->height;
+
+      for (i = 0; i < bpp; i++)
+        {
+          if (size >= 128)
+            {
+              rlebuf[len++] = 127;
+              rlebuf[len++] = (size >> 8);
+              rlebuf[len++] = size & 0x00FF;
+              rlebuf[len++] = tile_data[i];
+            }
+          else
+            {
+              rlebuf[len++] = size - 1;
+              rlebuf[len++] = tile_data[i];
+            }
+        }
+
+      xcf_write_int8_check_error (info, rlebuf, len);
+
+      return TRUE;
+    }
+
   for (i = 0; i < bpp; i++)
     {
       const guchar *data   = tile_data + i;
@@ -1595,74 +1785,473 @@ xcf_save_tile_rle (XcfInfo        *info,
   return TRUE;
 }
 
+typedef struct
+{
+  GeglRectangle  rect;
+  const guchar  *data;
+  uLong          size;
+  guchar        *zdata;
+  uLongf         zsize;
+  gint           status;
+} XcfZlibTile;
+
+static void
+xcf_save_compress_tiles_zlib (gsize        offset,
+                              gsize        size,
+                              XcfZlibTile *tiles)
+{
+  gsize i;
+
+  for (i = offset; i < offset + size; i++)
+    {
+      XcfZlibTile *tile = &tiles[i];
+
+      /* already compressed */
+      if (! tile->data)
+        continue;
+
+      tile->status = compress2 (tile->zdata, &tile->zsize,
+                                tile->data, tile->size,
+                                Z_DEFAULT_COMPRESSION);
+    }
+}
+
+/* Reads up to XCF_TILE_BATCH_SIZE tiles at a time, compresses them in
+ * parallel, and then writes them to the file in order, recording each
+ * tile's file offset in @offset_table.  Uniform tiles of the same
+ * color and size, such as the empty parts of a layer or a mask, reuse
+ * the compressed data of an earlier one.
+ */
 static gboolean
-xcf_save_tile_zlib (XcfInfo        *info,
-                    GeglBuffer     *buffer,
-                    GeglRectangle  *tile_rect,
-                    const Babl     *format,
-                    GError        **error)
+xcf_save_tiles_zlib (XcfInfo     *info,
+                     GeglBuffer  *buffer,
+                     const Babl  *format,
+                     goffset     *offset_table,
+                     guint        ntiles,
+                     GError     **error)
 {
-  gint      bpp       = babl_format_get_bytes_per_pixel (format);
-  gint      tile_size = bpp * tile_rect->width * tile_rect->height;
-  guchar   *tile_data = g_alloca (tile_size);
-  /* The buffer for compressed data. */
-  guchar   *buf       = g_alloca (tile_size);
-  GError   *tmp_error = NULL;
-  z_stream  strm;
-  int       action;
-  int       status;
+  XcfZlibTile  tiles[XCF_TILE_BATCH_SIZE];
+  gint         bpp       = babl_format_get_bytes_per_pixel (format);
+  gint         max_size  = bpp * XCF_TILE_WIDTH * XCF_TILE_HEIGHT;
+  uLong        max_zsize = compressBound (max_size);
+  guchar      *data;
+  guchar      *zdata;
+  guchar      *uniform_pixel;
+  guchar      *uniform_zdata;
+  uLongf       uniform_zsize = 0;
+  uLong        uniform_size  = 0;
+  guint        first;
+  gboolean     success   = TRUE;
+  GError      *tmp_error = NULL;
 
-  gegl_buffer_get (buffer, tile_rect, 1.0, format, tile_data,
-                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+  data  = g_malloc (XCF_TILE_BATCH_SIZE * max_size);
+  zdata = g_malloc (XCF_TILE_BATCH_SIZE * max_zsize);
+
+  uniform_pixel = g_malloc (bpp);
+  uniform_zdata = g_malloc (max_zsize);
+
+  for (first = 0; success && first < ntiles; first += XCF_TILE_BATCH_SIZE)
+    {
+      guint n_tiles = MIN (ntiles - first, XCF_TILE_BATCH_SIZE);
+      guint i;
+
+      for (i = 0; i < n_tiles; i++)
+        {
+          XcfZlibTile *tile = &tiles[i];
+          guchar      *tile_data = data + i * max_size;
+
+          gimp_gegl_buffer_get_tile_rect (buffer,
+                                          XCF_TILE_WIDTH, XCF_TILE_HEIGHT,
+                                          first + i, &tile->rect);
+
+          gegl_buffer_get (buffer, &tile->rect, 1.0, format, tile_data,
+                           GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+          tile->data  = tile_data;
+          tile->size  = bpp * tile->rect.width * tile->rect.height;
+          tile->zdata = zdata + i * max_zsize;
+          tile->zsize = max_zsize;
+
+          if (uniform_size == tile->size               &&
+              ! memcmp (tile_data, uniform_pixel, bpp) &&
+              xcf_save_tile_is_uniform (tile_data,
+                                        tile->size / bpp, bpp))
+            {
+              tile->data   = NULL;
+              tile->zdata  = uniform_zdata;
+              tile->zsize  = uniform_zsize;
+              tile->status = Z_OK;
+            }
+        }
+
+      gimp_parallel_distribute_range (n_tiles, 1,
+                                      (GimpParallelDistributeRangeFunc)
+                                      xcf_save_compress_tiles_zlib,
+                                      tiles);
+
+      for (i = 0; i < n_tiles; i++)
+        {
+          XcfZlibTile *tile = &tiles[i];
+
+          if (tile->status != Z_OK)
+            {
+              g_printerr ("xcf: tile compression failed: %s",
+                          zError (tile->status));
+              success = FALSE;
+              break;
+            }
+
+          offset_table[first + i] = info->cp;
+
+          info->cp += xcf_write_int8 (info->output,
+                                      tile->zdata, tile->zsize, &tmp_error);
+
+          if (tmp_error)
+            {
+              g_propagate_error (error, tmp_error);
+              success = FALSE;
+              break;
+            }
+        }
+
+      /* remember the last newly compressed uniform tile for the next
+       * batch, only now that none of this batch's tiles point to the
+       * previous one anymore
+       */
+      for (i = n_tiles; success && i > 0; i--)
+        {
+          XcfZlibTile *tile = &tiles[i - 1];
+
+          if (tile->data &&
+              xcf_save_tile_is_uniform (tile->data, tile->size / bpp, bpp))
+            {
+              memcpy (uniform_pixel, tile->data, bpp);
+              memcpy (uniform_zdata, tile->zdata, tile->zsize);
+              uniform_zsize = tile->zsize;
+              uniform_size  = tile->size;
+              break;
+            }
+        }
+    }
+
+  g_free (uniform_zdata);
+  g_free (uniform_pixel);
+  g_free (zdata);
+  g_free (data);
+
+  return success;
+}
 
-  /* allocate deflate state */
-  strm.zalloc = Z_NULL;
-  strm.zfree  = Z_NULL;
-  strm.opaque = Z_NULL;
+static gboolean
+xcf_save_tile_is_uniform (const guchar *tile_data,
+                          gint          n_pixels,
+                          gint          bpp)
+{
+  /* every byte equals the one a pixel later, iff all pixels are equal */
+  return n_pixels < 2 ||
+         ! memcmp (tile_data, tile_data + bpp, (n_pixels - 1) * bpp);
+}
+
+static void
+xcf_saved_level_free (XcfSavedLevel *level)
+{
+  if (level->buffer)
+    g_object_unref (level->buffer);
+
+  if (level->file)
+    g_object_unref (level->file);
+
+  g_free (level->offsets);
+
+  g_slice_free (XcfSavedLevel, level);
+}
 
-  status = deflateInit (&strm, Z_DEFAULT_COMPRESSION);
-  if (status != Z_OK)
+static gboolean
+xcf_save_get_file_stamp (GFile   *file,
+                         guint64 *size,
+                         guint64 *mtime)
+{
+  GFileInfo *file_info;
+
+  file_info = g_file_query_info (file,
+                                 G_FILE_ATTRIBUTE_STANDARD_SIZE ","
+                                 G_FILE_ATTRIBUTE_TIME_MODIFIED ","
+                                 G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC,
+                                 G_FILE_QUERY_INFO_NONE,
+                                 NULL, NULL);
+
+  if (! file_info)
     return FALSE;
 
-  strm.next_in   = tile_data;
-  strm.avail_in  = tile_size;
-  strm.next_out  = buf;
-  strm.avail_out = tile_size;
+  *size  = g_file_info_get_size (file_info);
+  *mtime = (g_file_info_get_attribute_uint64 (file_info,
+                                              G_FILE_ATTRIBUTE_TIME_MODIFIED) *
+            G_USEC_PER_SEC +
+            g_file_info_get_attribute_uint32 (file_info,
+                                              G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC));
+
+  g_object_unref (file_info);
+
+  return TRUE;
+}
+
+static void
+xcf_save_drawable_update (GimpDrawable *drawable,
+                          gint          x,
+                          gint          y,
+                          gint          width,
+                          gint          height)
+{
+  /*  the pixels changed, the saved level is stale  */
+  g_object_set_data (G_OBJECT (gimp_drawable_get_buffer (drawable)),
+                     XCF_SAVED_LEVEL_KEY, NULL);
+}
+
+/* Makes sure a level saved from @drawable's buffer is forgotten when
+ * the drawable is updated without its buffer being written to, like a
+ * group layer whose projection is merely invalidated.  A new buffer
+ * never has a saved level.
+ */
+static void
+xcf_save_track_drawable (GimpDrawable *drawable)
+{
+  if (! g_object_get_data (G_OBJECT (drawable), XCF_TRACKED_KEY))
+    {
+      g_signal_connect (drawable, "update",
+                        G_CALLBACK (xcf_save_drawable_update),
+                        NULL);
+
+      g_object_set_data (G_OBJECT (drawable), XCF_TRACKED_KEY,
+                         GINT_TO_POINTER (TRUE));
+    }
+}
+
+static void
+xcf_save_buffer_changed (GeglBuffer          *buffer,
+                         const GeglRectangle *rect,
+                         gpointer             data)
+{
+  /*  the pixels changed, the saved level is stale  */
+  g_object_set_data (G_OBJECT (buffer), XCF_SAVED_LEVEL_KEY, NULL);
+}
+
+/* Makes sure a level saved from @buffer is forgotten on any write to
+ * the buffer, also the ones no "update" follows, like
+ * gimp-drawable-set-pixel or plug-in tile writes.
+ */
+static void
+xcf_save_track_buffer (GeglBuffer *buffer)
+{
+  if (! g_object_get_data (G_OBJECT (buffer), XCF_TRACKED_KEY))
+    {
+      gegl_buffer_signal_connect (buffer, "changed",
+                                  G_CALLBACK (xcf_save_buffer_changed),
+                                  NULL);
+
+      g_object_set_data (G_OBJECT (buffer), XCF_TRACKED_KEY,
+                         GINT_TO_POINTER (TRUE));
+    }
+}
 
-  action = Z_NO_FLUSH;
+/* Copies @buffer's level from the file it was last saved to, if it can
+ * be reused as is.  Sets @copied to FALSE, without writing anything,
+ * if it can't.
+ */
+static gboolean
+xcf_save_level_copy (XcfInfo     *info,
+                     GeglBuffer  *buffer,
+                     gboolean    *copied,
+                     GError     **error)
+{
+  XcfSavedLevel *level;
+  XcfSavedLevel *new_level;
+  goffset       *offset_table;
+  goffset        data_start;
+  goffset        remaining;
+  guint32        width;
+  guint32        height;
+  guchar        *data;
+  guint          i;
+  GError        *tmp_error = NULL;
+
+  *copied = FALSE;
+
+  level = g_object_get_data (G_OBJECT (buffer), XCF_SAVED_LEVEL_KEY);
+
+  if (! level                                                   ||
+      level->compression      != info->compression              ||
+      level->bytes_per_offset != info->bytes_per_offset         ||
+      level->format           != gegl_buffer_get_format (buffer) ||
+      level->width            != gegl_buffer_get_width (buffer)  ||
+      level->height           != gegl_buffer_get_height (buffer))
+    {
+      return TRUE;
+    }
 
-  while (status == Z_OK || status == Z_BUF_ERROR)
+  /*  open the level's file, once per save, if it is still the file we
+   *  wrote
+   */
+  if (! info->copy_file || ! g_file_equal (info->copy_file, level->file))
     {
-      if (strm.avail_in == 0)
+      guint64 size;
+      guint64 mtime;
+
+      if (info->copy_input)
         {
-          /* Finish the encoding. */
-          action = Z_FINISH;
+          g_object_unref (info->copy_input);
+          info->copy_input = NULL;
         }
 
-      status = deflate (&strm, action);
+      if (info->copy_file)
+        g_object_unref (info->copy_file);
 
-      if (status == Z_STREAM_END || status == Z_BUF_ERROR)
+      info->copy_file = g_object_ref (level->file);
+
+      if (xcf_save_get_file_stamp (level->file, &size, &mtime) &&
+          size  == level->file_size                            &&
+          mtime == level->file_mtime)
         {
-          size_t write_size = tile_size - strm.avail_out;
+          info->copy_input = G_INPUT_STREAM (g_file_read (level->file,
+                                                          NULL, NULL));
+        }
+    }
+
+  if (! info->copy_input)
+    return TRUE;
+
+  if (! g_seekable_seek (G_SEEKABLE (info->copy_input), level->data_start,
+                         G_SEEK_SET, NULL, NULL))
+    return TRUE;
 
-          xcf_write_int8_check_error (info, buf, write_size);
+  /*  from here on, the level is written, and failing to copy it fails
+   *  the save
+   */
+  width  = level->width;
+  height = level->height;
+
+  xcf_write_int32_check_error (info, &width,  1);
+  xcf_write_int32_check_error (info, &height, 1);
+
+  data_start = info->cp + (level->n_tiles + 1) * info->bytes_per_offset;
+
+  offset_table = g_new (goffset, level->n_tiles + 1);
 
-          /* Reset next_out and avail_out. */
-          strm.next_out  = buf;
-          strm.avail_out = tile_size;
+  for (i = 0; i < level->n_tiles; i++)
+    offset_table[i] = data_start + level->offsets[i];
+
+  offset_table[level->n_tiles] = 0;
+
+  info->cp += xcf_write_offset (info, offset_table, level->n_tiles + 1,
+                                &tmp_error);
+  g_free (offset_table);
+
+  if (tmp_error)
+    {
+      g_propagate_error (error, tmp_error);
+      return FALSE;
+    }
+
+  data = g_malloc (XCF_COPY_CHUNK_SIZE);
+
+  for (remaining = level->data_length; remaining > 0; )
+    {
+      gsize size = MIN (remaining, XCF_COPY_CHUNK_SIZE);
+      gsize bytes_read;
+
+      if (! g_input_stream_read_all (info->copy_input, data, size,
+                                     &bytes_read, NULL, &tmp_error) ||
+          bytes_read != size)
+        {
+          if (! tmp_error)
+            g_set_error_literal (&tmp_error,
+                                 G_FILE_ERROR, G_FILE_ERROR_FAILED,
+                                 _("previously saved file was truncated"));
+
+          g_propagate_prefixed_error (error, tmp_error,
+                                      _("Error reading XCF: "));
+          g_free (data);
+          return FALSE;
         }
-      else if (status != Z_OK)
+
+      info->cp += xcf_write_int8 (info->output, data, size, &tmp_error);
+
+      if (tmp_error)
         {
-          g_printerr ("xcf: tile compression failed: %s", zError (status));
-          deflateEnd (&strm);
+          g_propagate_error (error, tmp_error);
+          g_free (data);
           return FALSE;
         }
+
+      remaining -= size;
     }
 
-  deflateEnd (&strm);
+  g_free (data);
+
+  new_level = g_slice_dup (XcfSavedLevel, level);
+
+  new_level->buffer     = g_object_ref (buffer);
+  new_level->file       = NULL;
+  new_level->offsets    = g_memdup (level->offsets,
+                                    level->n_tiles * sizeof (goffset));
+  new_level->data_start = data_start;
+
+  info->saved_levels = g_list_prepend (info->saved_levels, new_level);
+
+  *copied = TRUE;
+
   return TRUE;
 }
 
+/* Writes @count file offsets, as 64-bit values since XCF version 9,
+ * and as 32-bit values before, failing if one doesn't fit.
+ */
+static guint
+xcf_write_offset (XcfInfo        *info,
+                  const goffset  *data,
+                  gint            count,
+                  GError        **error)
+{
+  guint32 tmp[256];
+  guint   total = 0;
+
+  if (info->bytes_per_offset == 8)
+    return xcf_write_int64 (info->output, (const guint64 *) data, count,
+                            error);
+
+  while (count > 0)
+    {
+      GError *tmp_error = NULL;
+      gint    n         = MIN (count, (gint) G_N_ELEMENTS (tmp));
+      gint    i;
+
+      for (i = 0; i < n; i++)
+        {
+          if (data[i] > G_MAXUINT32)
+            {
+              g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
+                           _("Error writing XCF: the file is too large "
+                             "for XCF version %d"), info->file_version);
+              return total;
+            }
+
+          tmp[i] = data[i];
+        }
+
+      total += xcf_write_int32 (info->output, tmp, n, &tmp_error);
+
+      if (tmp_error)
+        {
+          g_propagate_error (error, tmp_error);
+          return total;
+        }
+
+      data  += n;
+      count -= n;
+    }
+
+  return total;
+}
+
 static gboolean
 xcf_save_parasite (XcfInfo       *info,
                    GimpParasite  *parasite,
@@ -19,9 +19,12 @@
 #define __XCF_SAVE_H__
 
 
-gboolean   xcf_save_image (XcfInfo    *info,
-                           GimpImage  *image,
-                           GError    **error);
+gboolean   xcf_save_image  (XcfInfo    *info,
+                            GimpImage  *image,
+                            GError    **error);
+void       xcf_save_finish (XcfInfo    *info,
+                            GFile      *file,
+                            gboolean    success);
 
 
 #endif  /* __XCF_SAVE_H__ */
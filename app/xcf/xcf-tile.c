@@ -0,0 +1,221 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <zlib.h>
+
+#include <glib.h>
+
+#include "xcf-tile.h"
+
+
+/**
+ * xcf_tile_decode_rle:
+ * @src:       the RLE encoded tile data
+ * @src_size:  the size of @src, in bytes
+ * @tile_data: the buffer to store the decoded pixels in
+ * @bpp:       the number of bytes per pixel
+ * @n_pixels:  the number of pixels of the tile
+ *
+ * Decodes one RLE encoded XCF tile, making sure never to read past
+ * the end of @src.
+ *
+ * Return value: %FALSE if the RLE data is bogus.
+ **/
+gboolean
+xcf_tile_decode_rle (const guchar *src,
+                     gsize         src_size,
+                     guchar       *tile_data,
+                     gint          bpp,
+                     gint          n_pixels)
+{
+  const guchar *xcfdata = src;
+  const guchar *xcfdatalimit;
+  gint          i;
+
+  if (src_size == 0)
+    return FALSE;
+
+  xcfdatalimit = &src[src_size - 1];
+
+  for (i = 0; i < bpp; i++)
+    {
+      guchar *data  = tile_data + i;
+      gint    size  = n_pixels;
+      gint    count = 0;
+      guchar  val;
+      gint    length;
+      gint    j;
+
+      while (size > 0)
+        {
+          if (xcfdata > xcfdatalimit)
+            {
+              goto bogus_rle;
+            }
+
+          val = *xcfdata++;
+
+          length = val;
+          if (length >= 128)
+            {
+              length = 255 - (length - 1);
+              if (length == 128)
+                {
+                  if (xcfdata >= xcfdatalimit)
+                    {
+                      goto bogus_rle;
+                    }
+
+                  length = (*xcfdata << 8) + xcfdata[1];
+                  xcfdata += 2;
+                }
+
+              count += length;
+              size -= length;
+
+              if (size < 0)
+                {
+                  goto bogus_rle;
+                }
+
+              if (&xcfdata[length-1] > xcfdatalimit)
+                {
+                  goto bogus_rle;
+                }
+
+              while (length-- > 0)
+                {
+                  *data = *xcfdata++;
+                  data += bpp;
+                }
+            }
+          else
+            {
+              length += 1;
+              if (length == 128)
+                {
+                  if (xcfdata >= xcfdatalimit)
+                    {
+                      goto bogus_rle;
+                    }
+
+                  length = (*xcfdata << 8) + xcfdata[1];
+                  xcfdata += 2;
+                }
+
+              count += length;
+              size -= length;
+
+              if (size < 0)
+                {
+                  goto bogus_rle;
+                }
+
+              if (xcfdata > xcfdatalimit)
+                {
+                  goto bogus_rle;
+                }
+
+              val = *xcfdata++;
+
+              for (j = 0; j < length; j++)
+                {
+                  *data = val;
+                  data += bpp;
+                }
+            }
+        }
+    }
+
+  return TRUE;
+
+ bogus_rle:
+  return FALSE;
+}
+
+/**
+ * xcf_tile_decode_zlib:
+ * @src:       the zlib compressed tile data
+ * @src_size:  the size of @src, in bytes
+ * @tile_data: the buffer to store the decoded pixels in
+ * @tile_size: the size of @tile_data, in bytes
+ *
+ * Decodes one zlib compressed XCF tile. This function doesn't touch
+ * any global state and can be called from any thread.
+ *
+ * Return value: %FALSE if decompression failed.
+ **/
+gboolean
+xcf_tile_decode_zlib (const guchar *src,
+                      gsize         src_size,
+                      guchar       *tile_data,
+                      gsize         tile_size)
+{
+  z_stream strm;
+  int      action;
+  int      status;
+
+  strm.next_out  = tile_data;
+  strm.avail_out = tile_size;
+
+  strm.zalloc    = Z_NULL;
+  strm.zfree     = Z_NULL;
+  strm.opaque    = Z_NULL;
+  strm.next_in   = (guchar *) src;
+  strm.avail_in  = src_size;
+
+  /* Initialize the stream decompression. */
+  status = inflateInit (&strm);
+  if (status != Z_OK)
+    return FALSE;
+
+  action = Z_NO_FLUSH;
+
+  while (status == Z_OK)
+    {
+      if (strm.avail_in == 0)
+        {
+          action = Z_FINISH;
+        }
+
+      status = inflate (&strm, action);
+
+      if (status == Z_STREAM_END)
+        {
+          /* All the data was successfully decoded. */
+          break;
+        }
+      else if (status == Z_BUF_ERROR)
+        {
+          g_printerr ("xcf: decompressed tile bigger than the expected size.");
+          inflateEnd (&strm);
+          return FALSE;
+        }
+      else if (status != Z_OK)
+        {
+          g_printerr ("xcf: tile decompression failed: %s", zError (status));
+          inflateEnd (&strm);
+          return FALSE;
+        }
+    }
+
+  inflateEnd (&strm);
+
+  return TRUE;
+}
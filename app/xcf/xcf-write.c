@@ -26,33 +26,78 @@
 
 #include "gimp-intl.h"
 
+/* the number of values converted and written at once */
+#define XCF_WRITE_CHUNK 1024
+
+
 guint
 xcf_write_int32 (GOutputStream  *output,
                  const guint32  *data,
                  gint            count,
                  GError        **error)
 {
-  GError  *tmp_error = NULL;
-  gint     i;
+  guint32 tmp[XCF_WRITE_CHUNK];
+  guint   total = 0;
 
-  if (count > 0)
+  while (count > 0)
     {
-      for (i = 0; i < count; i++)
+      GError *tmp_error = NULL;
+      gint    n         = MIN (count, XCF_WRITE_CHUNK);
+      gint    i;
+
+      for (i = 0; i < n; i++)
+        tmp[i] = g_htonl (data[i]);
+
+      total += xcf_write_int8 (output, (const guint8 *) tmp, n * 4,
+                               &tmp_error);
+
+      if (tmp_error)
         {
-          guint32  tmp = g_htonl (data[i]);
+          g_propagate_error (error, tmp_error);
+
+          return total;
+        }
+
+      data  += n;
+      count -= n;
+    }
+
+  return total;
+}
+
+guint
+xcf_write_int64 (GOutputStream  *output,
+                 const guint64  *data,
+                 gint            count,
+                 GError        **error)
+{
+  guint64 tmp[XCF_WRITE_CHUNK];
+  guint   total = 0;
+
+  while (count > 0)
+    {
+      GError *tmp_error = NULL;
+      gint    n         = MIN (count, XCF_WRITE_CHUNK);
+      gint    i;
+
+      for (i = 0; i < n; i++)
+        tmp[i] = GUINT64_TO_BE (data[i]);
 
-          xcf_write_int8 (output, (const guint8 *) &tmp, 4, &tmp_error);
+      total += xcf_write_int8 (output, (const guint8 *) tmp, n * 8,
+                               &tmp_error);
 
-          if (tmp_error)
-            {
-              g_propagate_error (error, tmp_error);
+      if (tmp_error)
+        {
+          g_propagate_error (error, tmp_error);
 
-              return i * 4;
-            }
+          return total;
         }
+
+      data  += n;
+      count -= n;
     }
 
-  return count * 4;
+  return total;
 }
 
 guint
@@ -60,16 +105,28 @@ xcf_write_zero_int32 (GOutputStream  *output,
                       gint            count,
                       GError        **error)
 {
-  if (count > 0)
+  static const guint32 zero[XCF_WRITE_CHUNK] = { 0, };
+  guint                total = 0;
+
+  while (count > 0)
     {
-      guint32 *tmp = g_alloca (count * 4);
+      GError *tmp_error = NULL;
+      gint    n         = MIN (count, XCF_WRITE_CHUNK);
+
+      total += xcf_write_int8 (output, (const guint8 *) zero, n * 4,
+                               &tmp_error);
+
+      if (tmp_error)
+        {
+          g_propagate_error (error, tmp_error);
 
-      memset (tmp, 0, count * 4);
+          return total;
+        }
 
-      return xcf_write_int8 (output, (const guint8 *) tmp, count * 4, error);
+      count -= n;
     }
 
-  return 0;
+  return total;
 }
 
 guint
@@ -23,6 +23,10 @@ guint   xcf_write_int32      (GOutputStream  *output,
                               const guint32  *data,
                               gint            count,
                               GError        **error);
+guint   xcf_write_int64      (GOutputStream  *output,
+                              const guint64  *data,
+                              gint            count,
+                              GError        **error);
 guint   xcf_write_zero_int32 (GOutputStream  *output,
                               gint            count,
                               GError        **error);
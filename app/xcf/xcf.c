@@ -29,6 +29,8 @@
 
 #include "core/core-types.h"
 
+#include "config/gimpcoreconfig.h"
+
 #include "core/gimp.h"
 #include "core/gimpimage.h"
 #include "core/gimpparamspecs.h"
@@ -75,7 +77,8 @@ static GimpXcfLoaderFunc * const xcf_loaders[] =
   xcf_load_image,   /* version 5 */
   xcf_load_image,   /* version 6 */
   xcf_load_image,   /* version 7 */
-  xcf_load_image    /* version 8 */
+  xcf_load_image,   /* version 8 */
+  xcf_load_image    /* version 9 */
 };
 
 
@@ -243,6 +246,110 @@ xcf_exit (Gimp *gimp)
   g_return_if_fail (GIMP_IS_GIMP (gimp));
 }
 
+/*  Saves @image to @file, in at least XCF version @min_version.  The
+ *  save procedure passes 0, i.e. the version @image's features need;
+ *  the tests use it to write versions no test image needs, like v9
+ *  and its 64-bit offsets.
+ */
+gboolean
+xcf_save_file (Gimp          *gimp,
+               GimpImage     *image,
+               GFile         *file,
+               gint           min_version,
+               GimpProgress  *progress,
+               GError       **error)
+{
+  XcfInfo            info = { 0, };
+  gchar             *filename;
+  GFileOutputStream *output;
+  gboolean           success  = FALSE;
+  GError            *my_error = NULL;
+
+  g_return_val_if_fail (GIMP_IS_GIMP (gimp), FALSE);
+  g_return_val_if_fail (GIMP_IS_IMAGE (image), FALSE);
+  g_return_val_if_fail (G_IS_FILE (file), FALSE);
+  g_return_val_if_fail (min_version >= 0 &&
+                        min_version < G_N_ELEMENTS (xcf_loaders), FALSE);
+  g_return_val_if_fail (progress == NULL || GIMP_IS_PROGRESS (progress), FALSE);
+  g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  filename = g_file_get_parse_name (file);
+
+  output = g_file_replace (file,
+                           NULL, FALSE, G_FILE_CREATE_NONE,
+                           NULL, &my_error);
+
+  if (output)
+    {
+      gboolean compat_mode = gimp_image_get_xcf_compat_mode (image);
+
+      /*  collect the many small writes into large ones; the buffered
+       *  stream flushes before seeking, and closes @output with itself
+       */
+      info.output = g_buffered_output_stream_new_sized (G_OUTPUT_STREAM (output),
+                                                        XCF_WRITE_BUFFER_SIZE);
+      g_object_unref (output);
+
+      info.gimp         = gimp;
+      info.seekable     = G_SEEKABLE (info.output);
+      info.progress     = progress;
+      info.filename     = filename;
+
+      if (compat_mode)
+        info.compression = COMPRESS_RLE;
+      else
+        info.compression = COMPRESS_ZLIB;
+
+      info.file_version = gimp_image_get_xcf_version (image,
+                                                      info.compression ==
+                                                      COMPRESS_ZLIB,
+                                                      NULL, NULL);
+
+      info.file_version = MAX (min_version, info.file_version);
+
+      /* version 9 and later use 64-bit file offsets */
+      info.bytes_per_offset = info.file_version >= 9 ? 8 : 4;
+
+      if (progress)
+        gimp_progress_start (progress, FALSE, _("Saving '%s'"), filename);
+
+      success = xcf_save_image (&info, image, &my_error);
+
+      /*  done copying unchanged levels, close the file they came from
+       *  before it is replaced
+       */
+      if (info.copy_input)
+        {
+          g_object_unref (info.copy_input);
+          info.copy_input = NULL;
+        }
+
+      if (success)
+        {
+          if (progress)
+            gimp_progress_set_text (progress, _("Closing '%s'"), filename);
+
+          success = g_output_stream_close (info.output, NULL, &my_error);
+        }
+
+      if (! success)
+        g_propagate_prefixed_error (error, my_error,
+                                    _("Error writing '%s': "),
+                                    filename);
+
+      g_object_unref (info.output);
+
+      xcf_save_finish (&info, file, success);
+
+      if (progress)
+        gimp_progress_end (progress);
+    }
+
+  g_free (filename);
+
+  return success;
+}
+
 static GimpValueArray *
 xcf_load_invoker (GimpProcedure         *procedure,
                   Gimp                  *gimp,
@@ -275,8 +382,53 @@ xcf_load_invoker (GimpProcedure         *procedure,
       info.seekable    = G_SEEKABLE (info.input);
       info.progress    = progress;
       info.filename    = filename;
+      info.file        = file;
       info.compression = COMPRESS_NONE;
 
+      /*  with xcf-lazy-load set, the tiles of local files are
+       *  decoded from the memory-mapped file when they are first
+       *  accessed, instead of all of them being loaded up front;
+       *  remote files are read the same way through a second stream
+       *  that seeks to each tile, if the remote file supports it and
+       *  has an entity tag, so a changed file is detected before
+       *  each read; other remote files are loaded up front
+       */
+      if (gimp->config->xcf_lazy_load)
+        {
+          gchar *path = g_file_get_path (file);
+
+          if (path)
+            {
+              info.mapped_file = g_mapped_file_new (path, FALSE, NULL);
+              g_free (path);
+            }
+          else
+            {
+              GFileInfo *file_info;
+
+              file_info = g_file_query_info (file, G_FILE_ATTRIBUTE_ETAG_VALUE,
+                                             G_FILE_QUERY_INFO_NONE,
+                                             NULL, NULL);
+
+              if (file_info)
+                {
+                  info.lazy_etag = g_strdup (g_file_info_get_etag (file_info));
+                  g_object_unref (file_info);
+                }
+
+              if (info.lazy_etag)
+                info.lazy_input = G_INPUT_STREAM (g_file_read (file,
+                                                               NULL, NULL));
+
+              if (info.lazy_input &&
+                  ! g_seekable_can_seek (G_SEEKABLE (info.lazy_input)))
+                {
+                  g_object_unref (info.lazy_input);
+                  info.lazy_input = NULL;
+                }
+            }
+        }
+
       if (progress)
         gimp_progress_start (progress, FALSE, _("Opening '%s'"), filename);
 
@@ -303,6 +455,9 @@ xcf_load_invoker (GimpProcedure         *procedure,
 
       if (success)
         {
+          /* version 9 and later use 64-bit file offsets */
+          info.bytes_per_offset = info.file_version >= 9 ? 8 : 4;
+
           if (info.file_version >= 0 &&
               info.file_version < G_N_ELEMENTS (xcf_loaders))
             {
@@ -322,6 +477,15 @@ xcf_load_invoker (GimpProcedure         *procedure,
 
       g_object_unref (info.input);
 
+      /*  the tile handlers keep their own references  */
+      if (info.mapped_file)
+        g_mapped_file_unref (info.mapped_file);
+
+      if (info.lazy_input)
+        g_object_unref (info.lazy_input);
+
+      g_free (info.lazy_etag);
+
       if (progress)
         gimp_progress_end (progress);
     }
@@ -354,70 +518,20 @@ xcf_save_invoker (GimpProcedure         *procedure,
                   const GimpValueArray  *args,
                   GError               **error)
 {
-  XcfInfo         info = { 0, };
   GimpValueArray *return_vals;
   GimpImage      *image;
   const gchar    *uri;
-  gchar          *filename;
   GFile          *file;
-  gboolean        success  = FALSE;
-  GError         *my_error = NULL;
+  gboolean        success;
 
   gimp_set_busy (gimp);
 
-  image    = gimp_value_get_image (gimp_value_array_index (args, 1), gimp);
-  uri      = g_value_get_string (gimp_value_array_index (args, 3));
-  file     = g_file_new_for_uri (uri);
-  filename = g_file_get_parse_name (file);
-
-  info.output = G_OUTPUT_STREAM (g_file_replace (file,
-                                                 NULL, FALSE, G_FILE_CREATE_NONE,
-                                                 NULL, &my_error));
-
-  if (info.output)
-    {
-      gboolean compat_mode = gimp_image_get_xcf_compat_mode (image);
-
-      info.gimp         = gimp;
-      info.seekable     = G_SEEKABLE (info.output);
-      info.progress     = progress;
-      info.filename     = filename;
-
-      if (compat_mode)
-        info.compression = COMPRESS_RLE;
-      else
-        info.compression = COMPRESS_ZLIB;
-
-      info.file_version = gimp_image_get_xcf_version (image,
-                                                      info.compression ==
-                                                      COMPRESS_ZLIB,
-                                                      NULL, NULL);
-
-      if (progress)
-        gimp_progress_start (progress, FALSE, _("Saving '%s'"), filename);
-
-      success = xcf_save_image (&info, image, &my_error);
-
-      if (success)
-        {
-          if (progress)
-            gimp_progress_set_text (progress, _("Closing '%s'"), filename);
-
-          success = g_output_stream_close (info.output, NULL, &my_error);
-        }
+  image = gimp_value_get_image (gimp_value_array_index (args, 1), gimp);
+  uri   = g_value_get_string (gimp_value_array_index (args, 3));
+  file  = g_file_new_for_uri (uri);
 
-      if (! success)
-        g_propagate_prefixed_error (error, my_error,
-                                    _("Error writing '%s': "),
-                                    filename);
+  success = xcf_save_file (gimp, image, file, 0, progress, error);
 
-      g_object_unref (info.output);
-
-      if (progress)
-        gimp_progress_end (progress);
-    }
-
-  g_free (filename);
   g_object_unref (file);
 
   return_vals = gimp_procedure_get_return_values (procedure, success,
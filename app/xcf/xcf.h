@@ -19,8 +19,15 @@
 #define __XCF_H__
 
 
-void   xcf_init (Gimp *gimp);
-void   xcf_exit (Gimp *gimp);
+void       xcf_init      (Gimp          *gimp);
+void       xcf_exit      (Gimp          *gimp);
+
+gboolean   xcf_save_file (Gimp          *gimp,
+                          GimpImage     *image,
+                          GFile         *file,
+                          gint           min_version,
+                          GimpProgress  *progress,
+                          GError       **error);
 
 
 #endif /* __XCF_H__ */
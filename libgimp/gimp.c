@@ -132,6 +132,7 @@ typedef enum
   GIMP_DEBUG_INIT           = 1 << 3,
   GIMP_DEBUG_RUN            = 1 << 4,
   GIMP_DEBUG_QUIT           = 1 << 5,
+  GIMP_DEBUG_TILES          = 1 << 6,
 
   GIMP_DEBUG_DEFAULT        = (GIMP_DEBUG_RUN | GIMP_DEBUG_FATAL_WARNINGS)
 } GimpDebugFlag;
@@ -160,6 +161,9 @@ static gboolean   gimp_write                   (GIOChannel      *channel,
                                                 gpointer         user_data);
 static gboolean   gimp_flush                   (GIOChannel      *channel,
                                                 gpointer         user_data);
+static gboolean   gimp_write_chars             (GIOChannel      *channel,
+                                                const gchar     *buf,
+                                                gsize            count);
 static void       gimp_loop                    (void);
 static void       gimp_config                  (GPConfig        *config);
 static void       gimp_proc_run                (GPProcRun       *proc_run);
@@ -195,6 +199,7 @@ static gint           _min_colors        = 144;
 static gint           _gdisp_ID          = -1;
 static gchar         *_wm_class          = NULL;
 static gchar         *_display_name      = NULL;
+static gboolean       _resident          = FALSE;
 static gint           _monitor_number    = 0;
 static guint32        _timestamp         = 0;
 static const gchar   *progname           = NULL;
@@ -217,6 +222,7 @@ static const GDebugKey gimp_debug_keys[] =
   { "init",           GIMP_DEBUG_INIT           },
   { "run",            GIMP_DEBUG_RUN            },
   { "quit",           GIMP_DEBUG_QUIT           },
+  { "tiles",          GIMP_DEBUG_TILES          },
   { "on",             GIMP_DEBUG_DEFAULT        }
 };
 
@@ -1499,6 +1505,35 @@ gimp_extension_enable (void)
     }
 }
 
+/**
+ * gimp_plugin_set_resident:
+ * @resident: whether the plug-in should stay resident
+ *
+ * Asks GIMP to keep this plug-in running after the procedure it is
+ * currently running returned. The next call to any of the plug-in's
+ * procedures is then served by the same process, which saves starting
+ * the plug-in again, for example when a batch job loads and saves
+ * many files.
+ *
+ * Only call this from plug-ins whose run() procedure does not depend
+ * on state left behind by a previous run. GIMP closes resident
+ * plug-ins again when they have been idle for a while.
+ *
+ * Returns: %TRUE if the plug-in will stay resident.
+ *
+ * Since: 2.10
+ **/
+gboolean
+gimp_plugin_set_resident (gboolean resident)
+{
+  if (! _gimp_plugin_set_resident (resident))
+    return FALSE;
+
+  _resident = resident ? TRUE : FALSE;
+
+  return TRUE;
+}
+
 /**
  * gimp_extension_process:
  * @timeout: The timeout (in ms) to use for the select() call.
@@ -1823,6 +1858,13 @@ gimp_write (GIOChannel   *channel,
 {
   gulong bytes;
 
+  /*  large blocks like tile data and arrays are written directly,
+   *  instead of being copied through the write buffer in pieces
+   */
+  if (count >= WRITE_BUFFER_SIZE)
+    return (gimp_flush (channel, user_data) &&
+            gimp_write_chars (channel, (const gchar *) buf, count));
+
   while (count > 0)
     {
       if ((write_buffer_index + count) >= WRITE_BUFFER_SIZE)
@@ -1850,48 +1892,56 @@ gimp_write (GIOChannel   *channel,
 static gboolean
 gimp_flush (GIOChannel *channel,
             gpointer    user_data)
+{
+  if (write_buffer_index > 0)
+    {
+      if (! gimp_write_chars (channel, write_buffer, write_buffer_index))
+        return FALSE;
+
+      write_buffer_index = 0;
+    }
+
+  return TRUE;
+}
+
+static gboolean
+gimp_write_chars (GIOChannel  *channel,
+                  const gchar *buf,
+                  gsize        count)
 {
   GIOStatus  status;
   GError    *error = NULL;
-  gsize      count;
   gsize      bytes;
 
-  if (write_buffer_index > 0)
+  while (count > 0)
     {
-      count = 0;
-      while (count != write_buffer_index)
+      do
         {
-          do
+          bytes = 0;
+          status = g_io_channel_write_chars (channel, buf, count,
+                                             &bytes,
+                                             &error);
+        }
+      while (status == G_IO_STATUS_AGAIN);
+
+      if (status != G_IO_STATUS_NORMAL)
+        {
+          if (error)
             {
-              bytes = 0;
-              status = g_io_channel_write_chars (channel,
-                                                 &write_buffer[count],
-                                                 (write_buffer_index - count),
-                                                 &bytes,
-                                                 &error);
+              g_warning ("%s: gimp_flush(): error: %s",
+                         g_get_prgname (), error->message);
+              g_error_free (error);
             }
-          while (status == G_IO_STATUS_AGAIN);
-
-          if (status != G_IO_STATUS_NORMAL)
+          else
             {
-              if (error)
-                {
-                  g_warning ("%s: gimp_flush(): error: %s",
-                             g_get_prgname (), error->message);
-                  g_error_free (error);
-                }
-              else
-                {
-                  g_warning ("%s: gimp_flush(): error", g_get_prgname ());
-                }
-
-              return FALSE;
+              g_warning ("%s: gimp_flush(): error", g_get_prgname ());
             }
 
-          count += bytes;
+          return FALSE;
         }
 
-      write_buffer_index = 0;
+      buf   += bytes;
+      count -= bytes;
     }
 
   return TRUE;
@@ -1922,6 +1972,7 @@ gimp_loop (void)
           break;
 
         case GP_TILE_REQ:
+        case GP_TILE_RUN_REQ:
         case GP_TILE_ACK:
         case GP_TILE_DATA:
           g_warning ("unexpected tile message received (should not happen)");
@@ -1929,6 +1980,11 @@ gimp_loop (void)
 
         case GP_PROC_RUN:
           gimp_proc_run (msg.data);
+
+          /*  a resident plug-in waits for the next GP_CONFIG and GP_PROC_RUN  */
+          if (_resident)
+            break;
+
           gimp_wire_destroy (&msg);
           gimp_close ();
           return;
@@ -1961,6 +2017,8 @@ gimp_loop (void)
 static void
 gimp_config (GPConfig *config)
 {
+  static gboolean app_name_set = FALSE;
+
   if (config->version < GIMP_PROTOCOL_VERSION)
     {
       g_message ("Could not execute plug-in \"%s\"\n(%s)\n"
@@ -1990,13 +2048,22 @@ gimp_config (GPConfig *config)
   _show_help_button = config->show_help_button ? TRUE : FALSE;
   _min_colors       = config->min_colors;
   _gdisp_ID         = config->gdisp_ID;
-  _wm_class         = g_strdup (config->wm_class);
-  _display_name     = g_strdup (config->display_name);
   _monitor_number   = config->monitor_number;
   _timestamp        = config->timestamp;
 
-  if (config->app_name)
-    g_set_application_name (config->app_name);
+  /*  a resident plug-in gets a config message for every run  */
+  g_free (_wm_class);
+  g_free (_display_name);
+
+  _wm_class         = g_strdup (config->wm_class);
+  _display_name     = g_strdup (config->display_name);
+
+  /*  the application name can only be set once  */
+  if (config->app_name && ! app_name_set)
+    {
+      g_set_application_name (config->app_name);
+      app_name_set = TRUE;
+    }
 
   gimp_cpu_accel_set_use (config->use_cpu_accel);
 
@@ -2005,7 +2072,7 @@ gimp_config (GPConfig *config)
                 "application-license", "GPL3",
                 NULL);
 
-  if (_shm_ID != -1)
+  if (_shm_ID != -1 && ! _shm_addr)
     {
 #if defined(USE_SYSV_SHM)
 
@@ -2099,11 +2166,17 @@ gimp_proc_run (GPProcRun *proc_run)
       GimpParam    *return_vals;
       gint          n_return_vals;
 
+      if (gimp_debug_flags & GIMP_DEBUG_TILES)
+        _gimp_tile_stats_reset ();
+
       (* PLUG_IN_INFO.run_proc) (proc_run->name,
                                  proc_run->nparams,
                                  (GimpParam *) proc_run->params,
                                  &n_return_vals, &return_vals);
 
+      if (gimp_debug_flags & GIMP_DEBUG_TILES)
+        _gimp_tile_stats_print (proc_run->name);
+
       proc_return.name    = proc_run->name;
       proc_return.nparams = n_return_vals;
       proc_return.params  = (GPParam *) return_vals;
@@ -2158,6 +2231,7 @@ gimp_process_message (GimpWireMessage *msg)
       gimp_config (msg->data);
       break;
     case GP_TILE_REQ:
+    case GP_TILE_RUN_REQ:
     case GP_TILE_ACK:
     case GP_TILE_DATA:
       g_warning ("unexpected tile message received (should not happen)");
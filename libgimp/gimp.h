@@ -280,6 +280,10 @@ void           gimp_extension_enable    (void);
  */
 void           gimp_extension_process   (guint            timeout);
 
+/* Keep the plug-in running for the next call of its procedures
+ */
+gboolean       gimp_plugin_set_resident (gboolean         resident);
+
 /* Run a procedure in the procedure database. The parameters are
  *  specified via the variable length argument list. The return
  *  values are returned in the 'GimpParam*' array.
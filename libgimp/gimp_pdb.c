@@ -228,3 +228,70 @@ gimp_get_parasite_list (gint *num_parasites)
 
   return parasites;
 }
+
+/**
+ * gimp_get_memory_usage:
+ * @image_ID: The image, or -1 for all images.
+ * @layers: The memory used by layers and layer masks.
+ * @channels: The memory used by channels and the selection.
+ * @vectors: The memory used by paths.
+ * @undo: The memory used by the undo and redo steps.
+ * @undo_swap: The swap space used by undo steps.
+ * @projection: The memory used by the projection.
+ * @temp_buffers: The memory used by temporary buffers.
+ *
+ * Returns the memory used by images and temporary buffers.
+ *
+ * This procedure returns the number of bytes used by the layers,
+ * channels, paths, undo steps and projection of the specified image,
+ * or the sum over all images if no image is specified. The size of
+ * undo steps which were moved to the swap is returned separately, and
+ * is not part of the undo size. Temporary buffers are not associated
+ * with an image, their size is only returned if no image is specified.
+ *
+ * Returns: TRUE on success.
+ **/
+gboolean
+gimp_get_memory_usage (gint32   image_ID,
+                       gdouble *layers,
+                       gdouble *channels,
+                       gdouble *vectors,
+                       gdouble *undo,
+                       gdouble *undo_swap,
+                       gdouble *projection,
+                       gdouble *temp_buffers)
+{
+  GimpParam *return_vals;
+  gint nreturn_vals;
+  gboolean success = TRUE;
+
+  return_vals = gimp_run_procedure ("gimp-get-memory-usage",
+                                    &nreturn_vals,
+                                    GIMP_PDB_IMAGE, image_ID,
+                                    GIMP_PDB_END);
+
+  *layers = 0.0;
+  *channels = 0.0;
+  *vectors = 0.0;
+  *undo = 0.0;
+  *undo_swap = 0.0;
+  *projection = 0.0;
+  *temp_buffers = 0.0;
+
+  success = return_vals[0].data.d_status == GIMP_PDB_SUCCESS;
+
+  if (success)
+    {
+      *layers = return_vals[1].data.d_float;
+      *channels = return_vals[2].data.d_float;
+      *vectors = return_vals[3].data.d_float;
+      *undo = return_vals[4].data.d_float;
+      *undo_swap = return_vals[5].data.d_float;
+      *projection = return_vals[6].data.d_float;
+      *temp_buffers = return_vals[7].data.d_float;
+    }
+
+  gimp_destroy_params (return_vals, nreturn_vals);
+
+  return success;
+}
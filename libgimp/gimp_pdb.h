@@ -38,6 +38,14 @@ gboolean      gimp_attach_parasite   (const GimpParasite *parasite);
 gboolean      gimp_detach_parasite   (const gchar        *name);
 GimpParasite* gimp_get_parasite      (const gchar        *name);
 gchar**       gimp_get_parasite_list (gint               *num_parasites);
+gboolean      gimp_get_memory_usage  (gint32              image_ID,
+                                      gdouble            *layers,
+                                      gdouble            *channels,
+                                      gdouble            *vectors,
+                                      gdouble            *undo,
+                                      gdouble            *undo_swap,
+                                      gdouble            *projection,
+                                      gdouble            *temp_buffers);
 
 
 G_END_DECLS
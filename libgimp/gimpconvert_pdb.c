@@ -232,3 +232,50 @@ gimp_image_convert_precision (gint32        image_ID,
 
   return success;
 }
+
+/**
+ * gimp_image_convert_color_profile:
+ * @image_ID: The image.
+ * @num_bytes: Number of bytes in the color_profile array.
+ * @color_profile: The serialized color profile.
+ * @intent: The rendering intent: { PERCEPTUAL (0), RELATIVE-COLORIMETRIC (1), SATURATION (2), ABSOLUTE-COLORIMETRIC (3) }.
+ * @bpc: Whether to use black point compensation.
+ *
+ * Convert the image from its color profile to the specified one
+ *
+ * This procedure converts all layers of the specified RGB image, or
+ * the colormap of an indexed image, from the image's current color
+ * profile to the profile given as ICC data, and attaches that profile
+ * to the image. If the image has no color profile, its pixels are
+ * assumed to be in the color profile configured in the preferences, or
+ * sRGB. The conversion is done in the core, in parallel, and can be
+ * undone in one step.
+ *
+ * Returns: TRUE on success.
+ **/
+gboolean
+gimp_image_convert_color_profile (gint32        image_ID,
+                                  gint          num_bytes,
+                                  const guint8 *color_profile,
+                                  gint          intent,
+                                  gboolean      bpc)
+{
+  GimpParam *return_vals;
+  gint nreturn_vals;
+  gboolean success = TRUE;
+
+  return_vals = gimp_run_procedure ("gimp-image-convert-color-profile",
+                                    &nreturn_vals,
+                                    GIMP_PDB_IMAGE, image_ID,
+                                    GIMP_PDB_INT32, num_bytes,
+                                    GIMP_PDB_INT8ARRAY, color_profile,
+                                    GIMP_PDB_INT32, intent,
+                                    GIMP_PDB_INT32, bpc,
+                                    GIMP_PDB_END);
+
+  success = return_vals[0].data.d_status == GIMP_PDB_SUCCESS;
+
+  gimp_destroy_params (return_vals, nreturn_vals);
+
+  return success;
+}
@@ -47,6 +47,11 @@ gboolean gimp_image_convert_set_dither_matrix (gint                    width,
                                                const guint8           *matrix);
 gboolean gimp_image_convert_precision         (gint32                  image_ID,
                                                GimpPrecision           precision);
+gboolean gimp_image_convert_color_profile     (gint32                  image_ID,
+                                               gint                    num_bytes,
+                                               const guint8           *color_profile,
+                                               gint                    intent,
+                                               gboolean                bpc);
 
 
 G_END_DECLS
@@ -735,6 +735,120 @@ gimp_drawable_set_pixel (gint32        drawable_ID,
   return success;
 }
 
+/**
+ * gimp_drawable_get_pixel_rect:
+ * @drawable_ID: The drawable.
+ * @x: The x coordinate of the rectangle.
+ * @y: The y coordinate of the rectangle.
+ * @width: The width of the rectangle.
+ * @height: The height of the rectangle.
+ * @num_bytes: The number of bytes in the pixels array.
+ *
+ * Gets the values of the pixels in the specified rectangle.
+ *
+ * This procedure gets the values of all pixels in the specified
+ * rectangle of the drawable in one call, row by row, without padding
+ * between rows. The rectangle must lie completely inside the drawable.
+ * Each pixel uses the same number of bytes as
+ * gimp_drawable_get_pixel() returns for the drawable.
+ *
+ * Returns: The pixel values.
+ *
+ * Since: GIMP 2.10
+ **/
+guint8 *
+gimp_drawable_get_pixel_rect (gint32  drawable_ID,
+                              gint    x,
+                              gint    y,
+                              gint    width,
+                              gint    height,
+                              gint   *num_bytes)
+{
+  GimpParam *return_vals;
+  gint nreturn_vals;
+  guint8 *pixels = NULL;
+
+  return_vals = gimp_run_procedure ("gimp-drawable-get-pixel-rect",
+                                    &nreturn_vals,
+                                    GIMP_PDB_DRAWABLE, drawable_ID,
+                                    GIMP_PDB_INT32, x,
+                                    GIMP_PDB_INT32, y,
+                                    GIMP_PDB_INT32, width,
+                                    GIMP_PDB_INT32, height,
+                                    GIMP_PDB_END);
+
+  *num_bytes = 0;
+
+  if (return_vals[0].data.d_status == GIMP_PDB_SUCCESS)
+    {
+      *num_bytes = return_vals[1].data.d_int32;
+      pixels = g_new (guint8, *num_bytes);
+      memcpy (pixels,
+              return_vals[2].data.d_int8array,
+              *num_bytes * sizeof (guint8));
+    }
+
+  gimp_destroy_params (return_vals, nreturn_vals);
+
+  return pixels;
+}
+
+/**
+ * gimp_drawable_set_pixel_rect:
+ * @drawable_ID: The drawable.
+ * @x: The x coordinate of the rectangle.
+ * @y: The y coordinate of the rectangle.
+ * @width: The width of the rectangle.
+ * @height: The height of the rectangle.
+ * @num_bytes: The number of bytes in the pixels array.
+ * @pixels: The pixel values.
+ *
+ * Sets the values of the pixels in the specified rectangle.
+ *
+ * This procedure sets the values of all pixels in the specified
+ * rectangle of the drawable in one call, row by row, without padding
+ * between rows. The rectangle must lie completely inside the drawable,
+ * and 'num_bytes' must be equal to width * height * the
+ * bytes-per-pixel value of gimp_drawable_get_pixel(). Like
+ * gimp_drawable_set_pixel(), this function is not undoable, and does
+ * not update the drawable's projection; call gimp_drawable_update()
+ * when done.
+ *
+ * Returns: TRUE on success.
+ *
+ * Since: GIMP 2.10
+ **/
+gboolean
+gimp_drawable_set_pixel_rect (gint32        drawable_ID,
+                              gint          x,
+                              gint          y,
+                              gint          width,
+                              gint          height,
+                              gint          num_bytes,
+                              const guint8 *pixels)
+{
+  GimpParam *return_vals;
+  gint nreturn_vals;
+  gboolean success = TRUE;
+
+  return_vals = gimp_run_procedure ("gimp-drawable-set-pixel-rect",
+                                    &nreturn_vals,
+                                    GIMP_PDB_DRAWABLE, drawable_ID,
+                                    GIMP_PDB_INT32, x,
+                                    GIMP_PDB_INT32, y,
+                                    GIMP_PDB_INT32, width,
+                                    GIMP_PDB_INT32, height,
+                                    GIMP_PDB_INT32, num_bytes,
+                                    GIMP_PDB_INT8ARRAY, pixels,
+                                    GIMP_PDB_END);
+
+  success = return_vals[0].data.d_status == GIMP_PDB_SUCCESS;
+
+  gimp_destroy_params (return_vals, nreturn_vals);
+
+  return success;
+}
+
 /**
  * gimp_drawable_fill:
  * @drawable_ID: The drawable.
@@ -824,6 +938,46 @@ gimp_drawable_offset (gint32         drawable_ID,
   return success;
 }
 
+/**
+ * gimp_drawable_apply_gegl_graph:
+ * @drawable_ID: The drawable.
+ * @graph: The GEGL graph, in GEGL XML.
+ *
+ * Apply a GEGL graph to the specified drawable.
+ *
+ * This procedure applies a GEGL graph, given in GEGL's XML format, to
+ * the drawable, inside the GIMP core, like the GEGL filters in the
+ * image window do. The drawable's pixels are the graph's input; if the
+ * graph doesn't use its \"input\" proxy, the input of its bottom node
+ * is connected to it. The result replaces the drawable's pixels inside
+ * the selection, as one undo step. No pixels are transferred to the
+ * caller.
+ *
+ * Returns: TRUE on success.
+ *
+ * Since: GIMP 2.10
+ **/
+gboolean
+gimp_drawable_apply_gegl_graph (gint32       drawable_ID,
+                                const gchar *graph)
+{
+  GimpParam *return_vals;
+  gint nreturn_vals;
+  gboolean success = TRUE;
+
+  return_vals = gimp_run_procedure ("gimp-drawable-apply-gegl-graph",
+                                    &nreturn_vals,
+                                    GIMP_PDB_DRAWABLE, drawable_ID,
+                                    GIMP_PDB_STRING, graph,
+                                    GIMP_PDB_END);
+
+  success = return_vals[0].data.d_status == GIMP_PDB_SUCCESS;
+
+  gimp_destroy_params (return_vals, nreturn_vals);
+
+  return success;
+}
+
 /**
  * _gimp_drawable_thumbnail:
  * @drawable_ID: The drawable.
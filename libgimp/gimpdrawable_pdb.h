@@ -75,6 +75,19 @@ gboolean                 gimp_drawable_set_pixel          (gint32
                                                            gint                        y_coord,
                                                            gint                        num_channels,
                                                            const guint8               *pixel);
+guint8*                  gimp_drawable_get_pixel_rect     (gint32                      drawable_ID,
+                                                           gint                        x,
+                                                           gint                        y,
+                                                           gint                        width,
+                                                           gint                        height,
+                                                           gint                       *num_bytes);
+gboolean                 gimp_drawable_set_pixel_rect     (gint32                      drawable_ID,
+                                                           gint                        x,
+                                                           gint                        y,
+                                                           gint                        width,
+                                                           gint                        height,
+                                                           gint                        num_bytes,
+                                                           const guint8               *pixels);
 gboolean                 gimp_drawable_fill               (gint32                      drawable_ID,
                                                            GimpFillType                fill_type);
 gboolean                 gimp_drawable_offset             (gint32                      drawable_ID,
@@ -82,6 +95,8 @@ gboolean                 gimp_drawable_offset             (gint32
                                                            GimpOffsetType              fill_type,
                                                            gint                        offset_x,
                                                            gint                        offset_y);
+gboolean                 gimp_drawable_apply_gegl_graph   (gint32                      drawable_ID,
+                                                           const gchar                *graph);
 G_GNUC_INTERNAL gboolean _gimp_drawable_thumbnail         (gint32                      drawable_ID,
                                                            gint                        width,
                                                            gint                        height,
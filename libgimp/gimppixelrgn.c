@@ -70,6 +70,10 @@ static gint     gimp_get_portion_height   (GimpPixelRgnIterator *pri);
 static gpointer gimp_pixel_rgns_configure (GimpPixelRgnIterator *pri);
 static void     gimp_pixel_rgn_configure  (GimpPixelRgnHolder   *prh,
                                            GimpPixelRgnIterator *pri);
+static void     gimp_pixel_rgn_prefetch   (GimpPixelRgn         *pr,
+                                           gint                  x,
+                                           gint                  y,
+                                           gint                  width);
 
 /**
  * gimp_pixel_rgn_init:
@@ -244,6 +248,8 @@ gimp_pixel_rgn_get_row (GimpPixelRgn *pr,
 
   end = x + width;
 
+  gimp_pixel_rgn_prefetch (pr, x, y, width);
+
   while (x < end)
     {
       GimpTile     *tile;
@@ -380,6 +386,8 @@ gimp_pixel_rgn_get_rect (GimpPixelRgn *pr,
     {
       x = xstart;
 
+      gimp_pixel_rgn_prefetch (pr, xstart, y, width);
+
       while (x < xend)
         {
           GimpTile *tile;
@@ -483,6 +491,8 @@ gimp_pixel_rgn_set_row (GimpPixelRgn *pr,
 
   end = x + width;
 
+  gimp_pixel_rgn_prefetch (pr, x, y, width);
+
   while (x < end)
     {
       tile = gimp_drawable_get_tile2 (pr->drawable, pr->shadow, x, y);
@@ -614,6 +624,8 @@ gimp_pixel_rgn_set_rect (GimpPixelRgn *pr,
     {
       x = xstart;
 
+      gimp_pixel_rgn_prefetch (pr, xstart, y, width);
+
       while (x < xend)
         {
           GimpTile *tile;
@@ -944,6 +956,17 @@ gimp_pixel_rgn_configure (GimpPixelRgnHolder   *prh,
                                       prh->pr->shadow,
                                       prh->pr->x,
                                       prh->pr->y);
+
+      /*  regions are processed left to right, so fetch the rest of
+       *  this tile row in one go
+       */
+      if (! tile->data)
+        gimp_pixel_rgn_prefetch (prh->pr,
+                                 prh->pr->x,
+                                 prh->pr->y,
+                                 pri->region_width -
+                                 (prh->pr->x - prh->startx));
+
       gimp_tile_ref (tile);
 
       offx = prh->pr->x % TILE_WIDTH;
@@ -963,3 +986,22 @@ gimp_pixel_rgn_configure (GimpPixelRgnHolder   *prh,
   prh->pr->w = pri->portion_width;
   prh->pr->h = pri->portion_height;
 }
+
+static void
+gimp_pixel_rgn_prefetch (GimpPixelRgn *pr,
+                         gint          x,
+                         gint          y,
+                         gint          width)
+{
+  gint col;
+  gint end_col;
+
+  if (width <= 0)
+    return;
+
+  col     = x / TILE_WIDTH;
+  end_col = (x + width - 1) / TILE_WIDTH;
+
+  _gimp_tile_prefetch (pr->drawable, pr->shadow,
+                       y / TILE_HEIGHT, col, end_col - col + 1);
+}
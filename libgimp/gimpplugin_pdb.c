@@ -355,3 +355,37 @@ gimp_plugin_precision_enabled (void)
 
   return enabled;
 }
+
+/**
+ * _gimp_plugin_set_resident:
+ * @resident: Whether the plug-in stays resident.
+ *
+ * Keeps this plug-in running for the next call to one of its
+ * procedures.
+ *
+ * Asks GIMP to keep this plug-in's process running after the current
+ * procedure returned, so that the next call to any procedure of the
+ * same plug-in is served by it instead of by a newly started process.
+ * Only plug-in procedures, not extensions, can be resident. GIMP
+ * closes idle resident plug-ins after a while.
+ *
+ * Returns: TRUE on success.
+ **/
+gboolean
+_gimp_plugin_set_resident (gboolean resident)
+{
+  GimpParam *return_vals;
+  gint nreturn_vals;
+  gboolean success = TRUE;
+
+  return_vals = gimp_run_procedure ("gimp-plugin-set-resident",
+                                    &nreturn_vals,
+                                    GIMP_PDB_INT32, resident,
+                                    GIMP_PDB_END);
+
+  success = return_vals[0].data.d_status == GIMP_PDB_SUCCESS;
+
+  gimp_destroy_params (return_vals, nreturn_vals);
+
+  return success;
+}
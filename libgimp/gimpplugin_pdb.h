@@ -48,6 +48,7 @@ gboolean                 gimp_plugin_set_pdb_error_handler (GimpPDBErrorHandler
 GimpPDBErrorHandler      gimp_plugin_get_pdb_error_handler (void);
 gboolean                 gimp_plugin_enable_precision      (void);
 gboolean                 gimp_plugin_precision_enabled     (void);
+G_GNUC_INTERNAL gboolean _gimp_plugin_set_resident         (gboolean             resident);
 
 
 G_END_DECLS
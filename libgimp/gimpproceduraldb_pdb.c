@@ -497,3 +497,183 @@ _gimp_procedural_db_set_data (const gchar  *identifier,
 
   return success;
 }
+
+/**
+ * gimp_procedural_db_set_profiling:
+ * @enabled: Whether procedure calls are recorded.
+ *
+ * Starts or stops recording statistics about procedure calls.
+ *
+ * While profiling is enabled, GIMP records the number of calls, the
+ * time spent and the amount of data sent to plug-ins for every
+ * procedure that is run. Enabling profiling discards the statistics
+ * collected before, disabling it keeps them for
+ * gimp_procedural_db_get_profile(), gimp_procedural_db_proc_profile()
+ * and gimp_procedural_db_dump_profile().
+ *
+ * Returns: TRUE on success.
+ **/
+gboolean
+gimp_procedural_db_set_profiling (gboolean enabled)
+{
+  GimpParam *return_vals;
+  gint nreturn_vals;
+  gboolean success = TRUE;
+
+  return_vals = gimp_run_procedure ("gimp-procedural-db-set-profiling",
+                                    &nreturn_vals,
+                                    GIMP_PDB_INT32, enabled,
+                                    GIMP_PDB_END);
+
+  success = return_vals[0].data.d_status == GIMP_PDB_SUCCESS;
+
+  gimp_destroy_params (return_vals, nreturn_vals);
+
+  return success;
+}
+
+/**
+ * gimp_procedural_db_get_profile:
+ * @num_procedures: The number of profiled procedures.
+ * @procedure_names: The names of the profiled procedures.
+ *
+ * Returns the procedures that were called while profiling.
+ *
+ * This procedure returns the names of all procedures which were called
+ * since profiling was last enabled using
+ * gimp_procedural_db_set_profiling(). Use
+ * gimp_procedural_db_proc_profile() to get the statistics of each of
+ * them.
+ *
+ * Returns: TRUE on success.
+ **/
+gboolean
+gimp_procedural_db_get_profile (gint    *num_procedures,
+                                gchar ***procedure_names)
+{
+  GimpParam *return_vals;
+  gint nreturn_vals;
+  gboolean success = TRUE;
+  gint i;
+
+  return_vals = gimp_run_procedure ("gimp-procedural-db-get-profile",
+                                    &nreturn_vals,
+                                    GIMP_PDB_END);
+
+  *num_procedures = 0;
+  *procedure_names = NULL;
+
+  success = return_vals[0].data.d_status == GIMP_PDB_SUCCESS;
+
+  if (success)
+    {
+      *num_procedures = return_vals[1].data.d_int32;
+      *procedure_names = g_new (gchar *, *num_procedures + 1);
+      for (i = 0; i < *num_procedures; i++)
+        (*procedure_names)[i] = g_strdup (return_vals[2].data.d_stringarray[i]);
+      (*procedure_names)[i] = NULL;
+    }
+
+  gimp_destroy_params (return_vals, nreturn_vals);
+
+  return success;
+}
+
+/**
+ * gimp_procedural_db_proc_profile:
+ * @procedure_name: The procedure name.
+ * @num_calls: The number of calls.
+ * @total_time: The time spent in the procedure.
+ * @self_time: The time spent in the procedure itself.
+ * @wire_time: The time spent talking to plug-ins.
+ * @wire_bytes: The number of bytes sent to plug-ins.
+ * @tile_bytes: The number of bytes of pixel data transferred.
+ * @num_tiles: The number of tiles transferred.
+ *
+ * Returns the statistics recorded for a procedure while profiling.
+ *
+ * This procedure returns the number of calls of the specified
+ * procedure since profiling was enabled, and the time spent in them.
+ * The self time excludes the time spent in the procedures it called;
+ * for a plug-in procedure that is the time the plug-in spent
+ * computing, and communicating with GIMP. The part of it GIMP spent
+ * sending data and transferring tiles is returned as wire time. Times
+ * are in seconds.
+ *
+ * Returns: TRUE on success.
+ **/
+gboolean
+gimp_procedural_db_proc_profile (const gchar *procedure_name,
+                                 gint        *num_calls,
+                                 gdouble     *total_time,
+                                 gdouble     *self_time,
+                                 gdouble     *wire_time,
+                                 gdouble     *wire_bytes,
+                                 gdouble     *tile_bytes,
+                                 gint        *num_tiles)
+{
+  GimpParam *return_vals;
+  gint nreturn_vals;
+  gboolean success = TRUE;
+
+  return_vals = gimp_run_procedure ("gimp-procedural-db-proc-profile",
+                                    &nreturn_vals,
+                                    GIMP_PDB_STRING, procedure_name,
+                                    GIMP_PDB_END);
+
+  *num_calls = 0;
+  *total_time = 0.0;
+  *self_time = 0.0;
+  *wire_time = 0.0;
+  *wire_bytes = 0.0;
+  *tile_bytes = 0.0;
+  *num_tiles = 0;
+
+  success = return_vals[0].data.d_status == GIMP_PDB_SUCCESS;
+
+  if (success)
+    {
+      *num_calls = return_vals[1].data.d_int32;
+      *total_time = return_vals[2].data.d_float;
+      *self_time = return_vals[3].data.d_float;
+      *wire_time = return_vals[4].data.d_float;
+      *wire_bytes = return_vals[5].data.d_float;
+      *tile_bytes = return_vals[6].data.d_float;
+      *num_tiles = return_vals[7].data.d_int32;
+    }
+
+  gimp_destroy_params (return_vals, nreturn_vals);
+
+  return success;
+}
+
+/**
+ * gimp_procedural_db_dump_profile:
+ * @filename: The trace filename.
+ *
+ * Writes the calls recorded while profiling to a trace file.
+ *
+ * This procedure writes every procedure call recorded since profiling
+ * was enabled to the specified file, in the JSON trace event format
+ * which can be viewed with chrome://tracing and compatible tools.
+ *
+ * Returns: TRUE on success.
+ **/
+gboolean
+gimp_procedural_db_dump_profile (const gchar *filename)
+{
+  GimpParam *return_vals;
+  gint nreturn_vals;
+  gboolean success = TRUE;
+
+  return_vals = gimp_run_procedure ("gimp-procedural-db-dump-profile",
+                                    &nreturn_vals,
+                                    GIMP_PDB_STRING, filename,
+                                    GIMP_PDB_END);
+
+  success = return_vals[0].data.d_status == GIMP_PDB_SUCCESS;
+
+  gimp_destroy_params (return_vals, nreturn_vals);
+
+  return success;
+}
@@ -70,6 +70,18 @@ gint                     gimp_procedural_db_get_data_size (const gchar       *id
 G_GNUC_INTERNAL gboolean _gimp_procedural_db_set_data     (const gchar       *identifier,
                                                            gint               bytes,
                                                            const guint8      *data);
+gboolean                 gimp_procedural_db_set_profiling (gboolean           enabled);
+gboolean                 gimp_procedural_db_get_profile   (gint              *num_procedures,
+                                                           gchar           ***procedure_names);
+gboolean                 gimp_procedural_db_proc_profile  (const gchar       *procedure_name,
+                                                           gint              *num_calls,
+                                                           gdouble           *total_time,
+                                                           gdouble           *self_time,
+                                                           gdouble           *wire_time,
+                                                           gdouble           *wire_bytes,
+                                                           gdouble           *tile_bytes,
+                                                           gint              *num_tiles);
+gboolean                 gimp_procedural_db_dump_profile  (const gchar       *filename);
 
 
 G_END_DECLS
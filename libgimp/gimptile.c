@@ -54,10 +54,30 @@ void         gimp_read_expect_msg   (GimpWireMessage *msg,
 
 static void  gimp_tile_get          (GimpTile        *tile);
 static void  gimp_tile_put          (GimpTile        *tile);
+static void  gimp_tile_get_rows     (GimpTile        *tile,
+                                     guchar          *dest,
+                                     gint             dest_stride);
+static void  gimp_tile_put_rows     (GimpTile        *tile,
+                                     const guchar    *src,
+                                     gint             src_stride);
 static void  gimp_tile_cache_insert (GimpTile        *tile);
 static void  gimp_tile_cache_flush  (GimpTile        *tile);
 
 
+typedef struct
+{
+  guint    n_requests;       /*  round trips to the core           */
+  guint    n_tiles_read;
+  guint    n_tiles_written;
+  guint64  n_bytes_read;
+  guint64  n_bytes_written;
+  guint    n_hits;           /*  tiles found in memory             */
+  guint    n_misses;         /*  tiles that had to be fetched      */
+  guint    n_prefetched;
+  guint    n_evictions;      /*  tiles dropped to make room        */
+} GimpTileStats;
+
+
 /*  private variables  */
 
 static GHashTable * tile_hash_table = NULL;
@@ -67,6 +87,8 @@ static gulong       max_tile_size   = 0;
 static gulong       cur_cache_size  = 0;
 static gulong       max_cache_size  = 0;
 
+static GimpTileStats tile_stats     = { 0, };
+
 
 /*  public functions  */
 
@@ -79,9 +101,15 @@ gimp_tile_ref (GimpTile *tile)
 
   if (tile->ref_count == 1)
     {
+      tile_stats.n_misses++;
+
       gimp_tile_get (tile);
       tile->dirty = FALSE;
     }
+  else
+    {
+      tile_stats.n_hits++;
+    }
 
   gimp_tile_cache_insert (tile);
 }
@@ -185,16 +213,258 @@ _gimp_tile_cache_flush_drawable (GimpDrawable *drawable)
 }
 
 
+/*  Reads @tile's pixels directly into @dest.  If the tile is currently
+ *  referenced, its (possibly modified) data is used, otherwise the
+ *  pixels are copied straight from the core's shared memory, skipping
+ *  the intermediate tile->data allocation and the tile cache.
+ */
+void
+_gimp_tile_read_direct (GimpTile *tile,
+                        guchar   *dest,
+                        gint      dest_stride)
+{
+  g_return_if_fail (tile != NULL);
+  g_return_if_fail (dest != NULL);
+
+  if (tile->data)
+    {
+      gint src_stride = tile->ewidth * tile->bpp;
+      gint row;
+
+      tile_stats.n_hits++;
+
+      for (row = 0; row < tile->eheight; row++)
+        memcpy (dest + row * dest_stride,
+                tile->data + row * src_stride, src_stride);
+    }
+  else
+    {
+      tile_stats.n_misses++;
+
+      gimp_tile_get_rows (tile, dest, dest_stride);
+    }
+}
+
+/*  Writes @src into @tile.  If the tile is currently referenced, its
+ *  data is updated and marked dirty, otherwise the pixels are copied
+ *  straight into the core's shared memory.
+ */
+void
+_gimp_tile_write_direct (GimpTile     *tile,
+                         const guchar *src,
+                         gint          src_stride)
+{
+  g_return_if_fail (tile != NULL);
+  g_return_if_fail (src != NULL);
+
+  if (tile->data)
+    {
+      gint dest_stride = tile->ewidth * tile->bpp;
+      gint row;
+
+      for (row = 0; row < tile->eheight; row++)
+        memcpy (tile->data + row * dest_stride,
+                src + row * src_stride, dest_stride);
+
+      tile->dirty = TRUE;
+    }
+  else
+    {
+      gimp_tile_put_rows (tile, src, src_stride);
+    }
+}
+
+
+/*  Fetches the run of up to @n_tiles uncached tiles starting at
+ *  (@row, @col) from the core with a single GP_TILE_RUN_REQ and puts
+ *  them into the tile cache, so that subsequent gimp_tile_ref() calls
+ *  on them don't need a round trip each.
+ */
+void
+_gimp_tile_prefetch (GimpDrawable *drawable,
+                     gint          shadow,
+                     gint          row,
+                     gint          col,
+                     gint          n_tiles)
+{
+  extern GIOChannel *_writechannel;
+
+  GPTileRunReq     tile_run_req;
+  GPTileData      *tile_data;
+  GimpWireMessage  msg;
+  GimpTile        *first;
+  const guchar    *src;
+  gint             max_tiles;
+  gint             src_stride;
+  gint             x;
+  gint             i;
+
+  g_return_if_fail (drawable != NULL);
+
+  n_tiles = MIN (n_tiles, drawable->ntile_cols - col);
+
+  /*  only prefetch what the cache can keep and the shm segment can hold  */
+  max_tiles = MIN (max_cache_size /
+                   (gimp_tile_width () * gimp_tile_height () * 4) / 2,
+                   32 / drawable->bpp);
+
+  n_tiles = MIN (n_tiles, max_tiles);
+
+  if (n_tiles < 2)
+    return;
+
+  first = gimp_drawable_get_tile (drawable, shadow, row, col);
+
+  if (first->data)
+    return;
+
+  for (i = 1; i < n_tiles; i++)
+    {
+      GimpTile *tile = gimp_drawable_get_tile (drawable, shadow, row, col + i);
+
+      if (tile->data)
+        break;
+    }
+
+  n_tiles = i;
+
+  if (n_tiles < 2)
+    return;
+
+  tile_run_req.drawable_ID = drawable->drawable_id;
+  tile_run_req.tile_num    = first->tile_num;
+  tile_run_req.n_tiles     = n_tiles;
+  tile_run_req.shadow      = shadow;
+
+  if (! gp_tile_run_req_write (_writechannel, &tile_run_req, NULL))
+    gimp_quit ();
+
+  tile_stats.n_requests++;
+
+  gimp_read_expect_msg (&msg, GP_TILE_DATA);
+
+  tile_data = msg.data;
+  if (tile_data->drawable_ID != drawable->drawable_id ||
+      tile_data->tile_num    != first->tile_num       ||
+      tile_data->shadow      != shadow                ||
+      tile_data->height      != first->eheight        ||
+      tile_data->bpp         != first->bpp)
+    {
+      g_message ("received tile info did not match computed tile info");
+      gimp_quit ();
+    }
+
+  if (tile_data->use_shm)
+    src = gimp_shm_addr ();
+  else
+    src = tile_data->data;
+
+  src_stride = tile_data->width * tile_data->bpp;
+
+  for (i = 0, x = 0; i < n_tiles && x < tile_data->width; i++)
+    {
+      GimpTile *tile   = gimp_drawable_get_tile (drawable, shadow,
+                                                 row, col + i);
+      gint      stride = tile->ewidth * tile->bpp;
+      gint      y;
+
+      if (x + tile->ewidth > tile_data->width)
+        {
+          g_message ("received tile info did not match computed tile info");
+          gimp_quit ();
+        }
+
+      tile->ref_count++;
+      tile->data  = g_new (guchar, stride * tile->eheight);
+      tile->dirty = FALSE;
+
+      for (y = 0; y < tile->eheight; y++)
+        memcpy (tile->data + y * stride,
+                src + y * src_stride + x * tile->bpp,
+                stride);
+
+      x += tile->ewidth;
+
+      tile_stats.n_tiles_read++;
+      tile_stats.n_prefetched++;
+      tile_stats.n_bytes_read += stride * tile->eheight;
+
+      gimp_tile_cache_insert (tile);
+      gimp_tile_unref (tile, FALSE);
+    }
+
+  if (! gp_tile_ack_write (_writechannel, NULL))
+    gimp_quit ();
+
+  gimp_wire_destroy (&msg);
+}
+
+void
+_gimp_tile_stats_reset (void)
+{
+  memset (&tile_stats, 0, sizeof (GimpTileStats));
+}
+
+/*  Prints the tile traffic since the last _gimp_tile_stats_reset(),
+ *  a low hit rate with many evictions means the tile cache is too
+ *  small for the way the plug-in walks the image.
+ */
+void
+_gimp_tile_stats_print (const gchar *name)
+{
+  guint n_lookups = tile_stats.n_hits + tile_stats.n_misses;
+
+  g_printerr ("%s: %u tile requests, "
+              "%u tiles read (%u prefetched), %u tiles written, "
+              "%" G_GUINT64_FORMAT " bytes read, "
+              "%" G_GUINT64_FORMAT " bytes written\n",
+              name,
+              tile_stats.n_requests,
+              tile_stats.n_tiles_read, tile_stats.n_prefetched,
+              tile_stats.n_tiles_written,
+              tile_stats.n_bytes_read, tile_stats.n_bytes_written);
+
+  g_printerr ("%s: tile cache of %lu kB, %u hits, %u misses (%.1f%% hit rate), "
+              "%u evictions\n",
+              name,
+              max_cache_size / 1024,
+              tile_stats.n_hits, tile_stats.n_misses,
+              n_lookups ? 100.0 * tile_stats.n_hits / n_lookups : 0.0,
+              tile_stats.n_evictions);
+}
+
+
 /*  private functions  */
 
 static void
 gimp_tile_get (GimpTile *tile)
+{
+  gimp_tile_get_rows (tile, NULL, 0);
+}
+
+static void
+gimp_tile_put (GimpTile *tile)
+{
+  gimp_tile_put_rows (tile, tile->data, tile->ewidth * tile->bpp);
+}
+
+/*  Fetches the tile's pixels from the core.  If @dest is NULL, the
+ *  pixels are stored in tile->data, otherwise they are copied straight
+ *  out of the shared memory segment (or the wire message) into @dest,
+ *  without going through tile->data and the tile cache.
+ */
+static void
+gimp_tile_get_rows (GimpTile *tile,
+                    guchar   *dest,
+                    gint      dest_stride)
 {
   extern GIOChannel *_writechannel;
 
   GPTileReq        tile_req;
   GPTileData      *tile_data;
   GimpWireMessage  msg;
+  const guchar    *src;
+  gint             src_stride = tile->ewidth * tile->bpp;
 
   tile_req.drawable_ID = tile->drawable->drawable_id;
   tile_req.tile_num    = tile->tile_num;
@@ -203,6 +473,10 @@ gimp_tile_get (GimpTile *tile)
   if (! gp_tile_req_write (_writechannel, &tile_req, NULL))
     gimp_quit ();
 
+  tile_stats.n_requests++;
+  tile_stats.n_tiles_read++;
+  tile_stats.n_bytes_read += src_stride * tile->eheight;
+
   gimp_read_expect_msg (&msg, GP_TILE_DATA);
 
   tile_data = msg.data;
@@ -218,14 +492,32 @@ gimp_tile_get (GimpTile *tile)
     }
 
   if (tile_data->use_shm)
+    src = gimp_shm_addr ();
+  else
+    src = tile_data->data;
+
+  if (! dest)
     {
-      tile->data = g_memdup (gimp_shm_addr (),
-                             tile->ewidth * tile->eheight * tile->bpp);
+      if (tile_data->use_shm)
+        {
+          tile->data = g_memdup (src, src_stride * tile->eheight);
+        }
+      else
+        {
+          tile->data = tile_data->data;
+          tile_data->data = NULL;
+        }
+    }
+  else if (dest_stride == src_stride)
+    {
+      memcpy (dest, src, src_stride * tile->eheight);
     }
   else
     {
-      tile->data = tile_data->data;
-      tile_data->data = NULL;
+      gint row;
+
+      for (row = 0; row < tile->eheight; row++)
+        memcpy (dest + row * dest_stride, src + row * src_stride, src_stride);
     }
 
   if (! gp_tile_ack_write (_writechannel, NULL))
@@ -234,8 +526,13 @@ gimp_tile_get (GimpTile *tile)
   gimp_wire_destroy (&msg);
 }
 
+/*  Sends the tile's pixels, read from @src with a row stride of
+ *  @src_stride, to the core.
+ */
 static void
-gimp_tile_put (GimpTile *tile)
+gimp_tile_put_rows (GimpTile     *tile,
+                    const guchar *src,
+                    gint          src_stride)
 {
   extern GIOChannel *_writechannel;
 
@@ -243,6 +540,8 @@ gimp_tile_put (GimpTile *tile)
   GPTileData       tile_data;
   GPTileData      *tile_info;
   GimpWireMessage  msg;
+  guchar          *temp       = NULL;
+  gint             row_stride = tile->ewidth * tile->bpp;
 
   tile_req.drawable_ID = -1;
   tile_req.tile_num    = 0;
@@ -251,6 +550,10 @@ gimp_tile_put (GimpTile *tile)
   if (! gp_tile_req_write (_writechannel, &tile_req, NULL))
     gimp_quit ();
 
+  tile_stats.n_requests++;
+  tile_stats.n_tiles_written++;
+  tile_stats.n_bytes_written += row_stride * tile->eheight;
+
   gimp_read_expect_msg (&msg, GP_TILE_DATA);
 
   tile_info = msg.data;
@@ -264,18 +567,35 @@ gimp_tile_put (GimpTile *tile)
   tile_data.use_shm     = tile_info->use_shm;
   tile_data.data        = NULL;
 
-  if (tile_info->use_shm)
-    memcpy (gimp_shm_addr (),
-            tile->data,
-            tile->ewidth * tile->eheight * tile->bpp);
+  if (tile_info->use_shm || src_stride != row_stride)
+    {
+      guchar *dest;
+      gint    row;
+
+      if (tile_info->use_shm)
+        dest = gimp_shm_addr ();
+      else
+        dest = temp = g_malloc (row_stride * tile->eheight);
+
+      if (src_stride == row_stride)
+        memcpy (dest, src, row_stride * tile->eheight);
+      else
+        for (row = 0; row < tile->eheight; row++)
+          memcpy (dest + row * row_stride, src + row * src_stride, row_stride);
+
+      if (! tile_info->use_shm)
+        tile_data.data = temp;
+    }
   else
-    tile_data.data = tile->data;
+    {
+      tile_data.data = (guchar *) src;
+    }
 
   if (! gp_tile_data_write (_writechannel, &tile_data, NULL))
     gimp_quit ();
 
-  if (! tile_info->use_shm)
-    tile_data.data = NULL;
+  tile_data.data = NULL;
+  g_free (temp);
 
   gimp_wire_destroy (&msg);
 
@@ -337,6 +657,8 @@ gimp_tile_cache_insert (GimpTile *tile)
                   max_cache_size * FREE_QUANTUM) > max_cache_size)
             {
               gimp_tile_cache_flush ((GimpTile *) tile_list_head->data);
+
+              tile_stats.n_evictions++;
             }
 
           if ((cur_cache_size + max_tile_size) > max_cache_size)
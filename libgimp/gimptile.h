@@ -63,6 +63,19 @@ void    gimp_tile_cache_ntiles (gulong     ntiles);
 /*  private function  */
 
 G_GNUC_INTERNAL void _gimp_tile_cache_flush_drawable (GimpDrawable *drawable);
+G_GNUC_INTERNAL void _gimp_tile_prefetch             (GimpDrawable *drawable,
+                                                      gint          shadow,
+                                                      gint          row,
+                                                      gint          col,
+                                                      gint          n_tiles);
+G_GNUC_INTERNAL void _gimp_tile_read_direct          (GimpTile     *tile,
+                                                      guchar       *dest,
+                                                      gint          dest_stride);
+G_GNUC_INTERNAL void _gimp_tile_write_direct         (GimpTile     *tile,
+                                                      const guchar *src,
+                                                      gint          src_stride);
+G_GNUC_INTERNAL void _gimp_tile_stats_reset          (void);
+G_GNUC_INTERNAL void _gimp_tile_stats_print          (const gchar  *name);
 
 
 G_END_DECLS
@@ -183,26 +183,15 @@ gimp_tile_read_mul (GimpTileBackendPlugin *backend_plugin,
           gimp_tile = gimp_drawable_get_tile (priv->drawable,
                                               priv->shadow,
                                               y + v, x + u);
-          gimp_tile_ref (gimp_tile);
-
-          {
-            gint ewidth           = gimp_tile->ewidth;
-            gint eheight          = gimp_tile->eheight;
-            gint bpp              = gimp_tile->bpp;
-            gint tile_stride      = mul * TILE_WIDTH * bpp;
-            gint gimp_tile_stride = ewidth * bpp;
-            gint row;
-
-            for (row = 0; row < eheight; row++)
-              {
-                memcpy (tile_data + (row + TILE_HEIGHT * v) *
-                        tile_stride + u * TILE_WIDTH * bpp,
-                        ((gchar *) gimp_tile->data) + row * gimp_tile_stride,
-                        gimp_tile_stride);
-              }
-          }
-
-          gimp_tile_unref (gimp_tile, FALSE);
+
+          /*  read straight into the GEGL tile, bypassing the
+           *  libgimp tile cache
+           */
+          _gimp_tile_read_direct (gimp_tile,
+                                  tile_data +
+                                  (TILE_HEIGHT * v * mul * TILE_WIDTH +
+                                   u * TILE_WIDTH) * gimp_tile->bpp,
+                                  mul * TILE_WIDTH * gimp_tile->bpp);
         }
     }
 
@@ -234,25 +223,13 @@ gimp_tile_write_mul (GimpTileBackendPlugin *backend_plugin,
 
           gimp_tile = gimp_drawable_get_tile (priv->drawable,
                                               priv->shadow,
-                                              y+v, x+u);
-          gimp_tile_ref (gimp_tile);
-
-          {
-            gint ewidth           = gimp_tile->ewidth;
-            gint eheight          = gimp_tile->eheight;
-            gint bpp              = gimp_tile->bpp;
-            gint tile_stride      = mul * TILE_WIDTH * bpp;
-            gint gimp_tile_stride = ewidth * bpp;
-            gint row;
-
-            for (row = 0; row < eheight; row++)
-              memcpy (((gchar *)gimp_tile->data) + row * gimp_tile_stride,
-                      source + (row + v * TILE_HEIGHT) *
-                      tile_stride + u * TILE_WIDTH * bpp,
-                      gimp_tile_stride);
-          }
-
-          gimp_tile_unref (gimp_tile, TRUE);
+                                              y + v, x + u);
+
+          _gimp_tile_write_direct (gimp_tile,
+                                   source +
+                                   (TILE_HEIGHT * v * mul * TILE_WIDTH +
+                                    u * TILE_WIDTH) * gimp_tile->bpp,
+                                   mul * TILE_WIDTH * gimp_tile->bpp);
         }
     }
 }
@@ -33,7 +33,7 @@
 #include <signal.h>
 #include <setjmp.h>
 
-#include <glib.h>
+#include <glib-object.h>
 
 #include "gimpcpuaccel.h"
 
@@ -68,6 +68,43 @@ gimp_cpu_accel_get_support (void)
   return use_cpu_accel ? cpu_accel () : GIMP_CPU_ACCEL_NONE;
 }
 
+/**
+ * gimp_cpu_accel_select:
+ * @kernels:   variants of one function, the most specialized first
+ * @n_kernels: the number of elements in @kernels
+ *
+ * Picks the first of @kernels whose required #GimpCpuAccelFlags are
+ * all supported by the CPU, so that code with per-instruction-set
+ * variants doesn't need its own checks. The last element should be a
+ * plain C fallback that requires %GIMP_CPU_ACCEL_NONE.
+ *
+ * Call this once, when the class or module is initialized, and keep
+ * the result; the support flags don't change while running.
+ *
+ * Return value: the selected kernel, or %NULL if none is supported.
+ *
+ * Since: 2.10
+ **/
+GCallback
+gimp_cpu_accel_select (const GimpCpuAccelKernel *kernels,
+                       gint                      n_kernels)
+{
+  GimpCpuAccelFlags support;
+  gint              i;
+
+  g_return_val_if_fail (kernels != NULL || n_kernels == 0, NULL);
+
+  support = gimp_cpu_accel_get_support ();
+
+  for (i = 0; i < n_kernels; i++)
+    {
+      if ((kernels[i].required & support) == kernels[i].required)
+        return kernels[i].func;
+    }
+
+  return NULL;
+}
+
 /**
  * gimp_cpu_accel_set_use:
  * @use:  whether to use CPU acceleration features or not
@@ -127,9 +164,25 @@ enum
   ARCH_X86_INTEL_FEATURE_SSSE3    = 1 << 9,
   ARCH_X86_INTEL_FEATURE_SSE4_1   = 1 << 19,
   ARCH_X86_INTEL_FEATURE_SSE4_2   = 1 << 20,
+  ARCH_X86_INTEL_FEATURE_OSXSAVE  = 1 << 27,
   ARCH_X86_INTEL_FEATURE_AVX      = 1 << 28
 };
 
+/* extended features, cpuid leaf 7 ebx */
+enum
+{
+  ARCH_X86_INTEL_FEATURE_AVX2     = 1 << 5,
+  ARCH_X86_INTEL_FEATURE_AVX512F  = 1 << 16
+};
+
+/* register state the OS saves on context switches, xcr0 */
+enum
+{
+  ARCH_X86_XCR0_SSE               = 1 << 1,
+  ARCH_X86_XCR0_AVX               = 1 << 2,
+  ARCH_X86_XCR0_AVX512            = 7 << 5
+};
+
 #if !defined(ARCH_X86_64) && (defined(PIC) || defined(__PIC__))
 #define cpuid(op,eax,ebx,ecx,edx)  \
   __asm__ ("movl %%ebx, %%esi\n\t" \
@@ -140,6 +193,16 @@ enum
              "=c" (ecx),           \
              "=d" (edx)            \
            : "0" (op))
+#define cpuid_count(op,count,eax,ebx,ecx,edx) \
+  __asm__ ("movl %%ebx, %%esi\n\t"             \
+           "cpuid\n\t"                         \
+           "xchgl %%ebx,%%esi"                 \
+           : "=a" (eax),                       \
+             "=S" (ebx),                       \
+             "=c" (ecx),                       \
+             "=d" (edx)                        \
+           : "0" (op),                         \
+             "2" (count))
 #else
 #define cpuid(op,eax,ebx,ecx,edx)  \
   __asm__ ("cpuid"                 \
@@ -148,8 +211,23 @@ enum
              "=c" (ecx),           \
              "=d" (edx)            \
            : "0" (op))
+#define cpuid_count(op,count,eax,ebx,ecx,edx) \
+  __asm__ ("cpuid"                             \
+           : "=a" (eax),                       \
+             "=b" (ebx),                       \
+             "=c" (ecx),                       \
+             "=d" (edx)                        \
+           : "0" (op),                         \
+             "2" (count))
 #endif
 
+/* xgetbv, spelled out for assemblers that don't know it */
+#define xgetbv(index,eax,edx)            \
+  __asm__ (".byte 0x0f, 0x01, 0xd0"      \
+           : "=a" (eax),                 \
+             "=d" (edx)                  \
+           : "c" (index))
+
 
 static X86Vendor
 arch_get_vendor (void)
@@ -259,8 +337,35 @@ arch_accel_intel (void)
     if (ecx & ARCH_X86_INTEL_FEATURE_SSE4_2)
       caps |= GIMP_CPU_ACCEL_X86_SSE4_2;
 
-    if (ecx & ARCH_X86_INTEL_FEATURE_AVX)
-      caps |= GIMP_CPU_ACCEL_X86_AVX;
+    /*  the AVX registers are only usable if the OS saves them  */
+    if ((ecx & ARCH_X86_INTEL_FEATURE_AVX) &&
+        (ecx & ARCH_X86_INTEL_FEATURE_OSXSAVE))
+      {
+        guint32 xcr0, xcr0_high;
+        guint32 max_level;
+
+        xgetbv (0, xcr0, xcr0_high);
+
+        if ((xcr0 & (ARCH_X86_XCR0_SSE | ARCH_X86_XCR0_AVX)) ==
+            (ARCH_X86_XCR0_SSE | ARCH_X86_XCR0_AVX))
+          {
+            caps |= GIMP_CPU_ACCEL_X86_AVX;
+
+            cpuid (0, max_level, ebx, ecx, edx);
+
+            if (max_level >= 7)
+              {
+                cpuid_count (7, 0, eax, ebx, ecx, edx);
+
+                if (ebx & ARCH_X86_INTEL_FEATURE_AVX2)
+                  caps |= GIMP_CPU_ACCEL_X86_AVX2;
+
+                if ((ebx & ARCH_X86_INTEL_FEATURE_AVX512F) &&
+                    (xcr0 & ARCH_X86_XCR0_AVX512) == ARCH_X86_XCR0_AVX512)
+                  caps |= GIMP_CPU_ACCEL_X86_AVX512F;
+              }
+          }
+      }
 #endif /* USE_SSE */
   }
 #endif /* USE_MMX */
@@ -506,6 +611,39 @@ arch_accel (void)
 #endif /* ARCH_PPC && USE_ALTIVEC */
 
 
+#if defined(__aarch64__) || defined(__ARM_NEON) || defined(__ARM_NEON__)
+
+#define HAVE_ACCEL 1
+
+/* NEON is part of the baseline here, or we are built to require it */
+static guint32
+arch_accel (void)
+{
+  return GIMP_CPU_ACCEL_ARM_NEON;
+}
+
+#elif defined(__arm__) && defined(__linux__) && defined(__GNUC__)
+
+#include <sys/auxv.h>
+
+#define HAVE_ACCEL 1
+
+#ifndef HWCAP_NEON
+#define HWCAP_NEON (1 << 12)
+#endif
+
+static guint32
+arch_accel (void)
+{
+  if (getauxval (AT_HWCAP) & HWCAP_NEON)
+    return GIMP_CPU_ACCEL_ARM_NEON;
+
+  return 0;
+}
+
+#endif /* __arm__ && __linux__ && __GNUC__ */
+
+
 static GimpCpuAccelFlags
 cpu_accel (void)
 {
@@ -41,17 +41,55 @@ typedef enum
   GIMP_CPU_ACCEL_X86_SSE4_1  = 0x00800000,
   GIMP_CPU_ACCEL_X86_SSE4_2  = 0x00400000,
   GIMP_CPU_ACCEL_X86_AVX     = 0x00200000,
+  GIMP_CPU_ACCEL_X86_AVX2    = 0x00100000,
+  GIMP_CPU_ACCEL_X86_AVX512F = 0x00080000,
 
   /* powerpc accelerations */
-  GIMP_CPU_ACCEL_PPC_ALTIVEC = 0x04000000
+  GIMP_CPU_ACCEL_PPC_ALTIVEC = 0x04000000,
+
+  /* arm accelerations */
+  GIMP_CPU_ACCEL_ARM_NEON    = 0x00040000
 } GimpCpuAccelFlags;
 
 
+typedef struct _GimpCpuAccelKernel GimpCpuAccelKernel;
+
+/**
+ * GimpCpuAccelKernel:
+ * @required: the #GimpCpuAccelFlags the kernel needs
+ * @func:     the kernel
+ *
+ * One variant of a function, see gimp_cpu_accel_select().
+ *
+ * Since: 2.10
+ **/
+struct _GimpCpuAccelKernel
+{
+  GimpCpuAccelFlags  required;
+  GCallback          func;
+};
+
+
+/**
+ * GIMP_CPU_ACCEL_SELECT:
+ * @kernels: a static array of #GimpCpuAccelKernel
+ *
+ * Calls gimp_cpu_accel_select() on a whole array.
+ *
+ * Since: 2.10
+ **/
+#define GIMP_CPU_ACCEL_SELECT(kernels) \
+  gimp_cpu_accel_select ((kernels), G_N_ELEMENTS (kernels))
+
+
 GimpCpuAccelFlags  gimp_cpu_accel_get_support (void);
 
+GCallback          gimp_cpu_accel_select      (const GimpCpuAccelKernel *kernels,
+                                               gint                      n_kernels);
+
 
 /* for internal use only */
-void               gimp_cpu_accel_set_use     (gboolean use);
+void               gimp_cpu_accel_set_use     (gboolean                  use);
 
 
 G_END_DECLS
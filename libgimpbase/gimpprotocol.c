@@ -140,6 +140,14 @@ static void _gp_has_init_write           (GIOChannel       *channel,
                                           gpointer          user_data);
 static void _gp_has_init_destroy         (GimpWireMessage  *msg);
 
+static void _gp_tile_run_req_read        (GIOChannel       *channel,
+                                          GimpWireMessage  *msg,
+                                          gpointer          user_data);
+static void _gp_tile_run_req_write       (GIOChannel       *channel,
+                                          GimpWireMessage  *msg,
+                                          gpointer          user_data);
+static void _gp_tile_run_req_destroy     (GimpWireMessage  *msg);
+
 
 
 void
@@ -197,6 +205,10 @@ gp_init (void)
                       _gp_has_init_read,
                       _gp_has_init_write,
                       _gp_has_init_destroy);
+  gimp_wire_register (GP_TILE_RUN_REQ,
+                      _gp_tile_run_req_read,
+                      _gp_tile_run_req_write,
+                      _gp_tile_run_req_destroy);
 }
 
 gboolean
@@ -442,6 +454,25 @@ gp_has_init_write (GIOChannel *channel,
   return TRUE;
 }
 
+gboolean
+gp_tile_run_req_write (GIOChannel   *channel,
+                       GPTileRunReq *tile_run_req,
+                       gpointer      user_data)
+{
+  GimpWireMessage msg;
+
+  msg.type = GP_TILE_RUN_REQ;
+  msg.data = tile_run_req;
+
+  if (! gimp_wire_write_msg (channel, &msg, user_data))
+    return FALSE;
+
+  if (! gimp_wire_flush (channel, user_data))
+    return FALSE;
+
+  return TRUE;
+}
+
 /*  quit  */
 
 static void
@@ -1868,3 +1899,65 @@ static void
 _gp_has_init_destroy (GimpWireMessage *msg)
 {
 }
+
+/*  tile_run_req  */
+
+static void
+_gp_tile_run_req_read (GIOChannel      *channel,
+                       GimpWireMessage *msg,
+                       gpointer         user_data)
+{
+  GPTileRunReq *tile_run_req = g_slice_new0 (GPTileRunReq);
+
+  if (! _gimp_wire_read_int32 (channel,
+                               (guint32 *) &tile_run_req->drawable_ID, 1,
+                               user_data))
+    goto cleanup;
+  if (! _gimp_wire_read_int32 (channel,
+                               &tile_run_req->tile_num, 1, user_data))
+    goto cleanup;
+  if (! _gimp_wire_read_int32 (channel,
+                               &tile_run_req->n_tiles, 1, user_data))
+    goto cleanup;
+  if (! _gimp_wire_read_int32 (channel,
+                               &tile_run_req->shadow, 1, user_data))
+    goto cleanup;
+
+  msg->data = tile_run_req;
+  return;
+
+ cleanup:
+  g_slice_free (GPTileRunReq, tile_run_req);
+  msg->data = NULL;
+}
+
+static void
+_gp_tile_run_req_write (GIOChannel      *channel,
+                        GimpWireMessage *msg,
+                        gpointer         user_data)
+{
+  GPTileRunReq *tile_run_req = msg->data;
+
+  if (! _gimp_wire_write_int32 (channel,
+                                (const guint32 *) &tile_run_req->drawable_ID, 1,
+                                user_data))
+    return;
+  if (! _gimp_wire_write_int32 (channel,
+                                &tile_run_req->tile_num, 1, user_data))
+    return;
+  if (! _gimp_wire_write_int32 (channel,
+                                &tile_run_req->n_tiles, 1, user_data))
+    return;
+  if (! _gimp_wire_write_int32 (channel,
+                                &tile_run_req->shadow, 1, user_data))
+    return;
+}
+
+static void
+_gp_tile_run_req_destroy (GimpWireMessage *msg)
+{
+  GPTileRunReq *tile_run_req = msg->data;
+
+  if (tile_run_req)
+    g_slice_free (GPTileRunReq, msg->data);
+}
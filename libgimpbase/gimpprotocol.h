@@ -26,7 +26,7 @@ G_BEGIN_DECLS
 
 /* Increment every time the protocol changes
  */
-#define GIMP_PROTOCOL_VERSION  0x0015
+#define GIMP_PROTOCOL_VERSION  0x0016
 
 
 enum
@@ -43,12 +43,14 @@ enum
   GP_PROC_INSTALL,
   GP_PROC_UNINSTALL,
   GP_EXTENSION_ACK,
-  GP_HAS_INIT
+  GP_HAS_INIT,
+  GP_TILE_RUN_REQ
 };
 
 
 typedef struct _GPConfig        GPConfig;
 typedef struct _GPTileReq       GPTileReq;
+typedef struct _GPTileRunReq    GPTileRunReq;
 typedef struct _GPTileAck       GPTileAck;
 typedef struct _GPTileData      GPTileData;
 typedef struct _GPParam         GPParam;
@@ -91,6 +93,14 @@ struct _GPTileReq
   guint32  shadow;
 };
 
+struct _GPTileRunReq
+{
+  gint32   drawable_ID;
+  guint32  tile_num;
+  guint32  n_tiles;
+  guint32  shadow;
+};
+
 struct _GPTileData
 {
   gint32   drawable_ID;
@@ -224,6 +234,9 @@ gboolean  gp_extension_ack_write    (GIOChannel      *channel,
                                      gpointer         user_data);
 gboolean  gp_has_init_write         (GIOChannel      *channel,
                                      gpointer         user_data);
+gboolean  gp_tile_run_req_write     (GIOChannel      *channel,
+                                     GPTileRunReq    *tile_run_req,
+                                     gpointer         user_data);
 
 void      gp_params_destroy         (GPParam         *params,
                                      gint             nparams);
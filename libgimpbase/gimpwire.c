@@ -27,6 +27,13 @@
 #include "gimpwire.h"
 
 
+/*  message types below this are looked up without hashing  */
+#define WIRE_N_DIRECT_HANDLERS  32
+
+/*  arrays are converted to network byte order in chunks of this size  */
+#define WIRE_CHUNK_SIZE         1024
+
+
 typedef struct _GimpWireHandler  GimpWireHandler;
 
 struct _GimpWireHandler
@@ -39,13 +46,15 @@ struct _GimpWireHandler
 
 
 static GHashTable        *wire_ht         = NULL;
+static GimpWireHandler   *wire_direct_handlers[WIRE_N_DIRECT_HANDLERS] = { NULL, };
 static GimpWireIOFunc     wire_read_func  = NULL;
 static GimpWireIOFunc     wire_write_func = NULL;
 static GimpWireFlushFunc  wire_flush_func = NULL;
 static gboolean           wire_error_val  = FALSE;
 
 
-static void  gimp_wire_init (void);
+static void              gimp_wire_init   (void);
+static GimpWireHandler * gimp_wire_lookup (guint32 type);
 
 
 void
@@ -59,7 +68,7 @@ gimp_wire_register (guint32             type,
   if (! wire_ht)
     gimp_wire_init ();
 
-  handler = g_hash_table_lookup (wire_ht, &type);
+  handler = gimp_wire_lookup (type);
 
   if (! handler)
     handler = g_slice_new0 (GimpWireHandler);
@@ -70,6 +79,9 @@ gimp_wire_register (guint32             type,
   handler->destroy_func = destroy_func;
 
   g_hash_table_insert (wire_ht, &handler->type, handler);
+
+  if (type < WIRE_N_DIRECT_HANDLERS)
+    wire_direct_handlers[type] = handler;
 }
 
 void
@@ -256,7 +268,7 @@ gimp_wire_read_msg (GIOChannel      *channel,
   if (! _gimp_wire_read_int32 (channel, &msg->type, 1, user_data))
     return FALSE;
 
-  handler = g_hash_table_lookup (wire_ht, &msg->type);
+  handler = gimp_wire_lookup (msg->type);
 
   if (G_UNLIKELY (! handler))
     g_error ("gimp_wire_read_msg: could not find handler for message: %d",
@@ -280,7 +292,7 @@ gimp_wire_write_msg (GIOChannel      *channel,
   if (wire_error_val)
     return !wire_error_val;
 
-  handler = g_hash_table_lookup (wire_ht, &msg->type);
+  handler = gimp_wire_lookup (msg->type);
 
   if (G_UNLIKELY (! handler))
     g_error ("gimp_wire_write_msg: could not find handler for message: %d",
@@ -302,7 +314,7 @@ gimp_wire_destroy (GimpWireMessage *msg)
   if (G_UNLIKELY (! wire_ht))
     g_error ("gimp_wire_destroy: the wire protocol has not been initialized");
 
-  handler = g_hash_table_lookup (wire_ht, &msg->type);
+  handler = gimp_wire_lookup (msg->type);
 
   if (G_UNLIKELY (! handler))
     g_error ("gimp_wire_destroy: could not find handler for message: %d\n",
@@ -376,35 +388,26 @@ _gimp_wire_read_double (GIOChannel *channel,
                         gint        count,
                         gpointer    user_data)
 {
-  gdouble *t;
-  guint8   tmp[8];
-  gint     i;
-
   g_return_val_if_fail (count >= 0, FALSE);
 
-  t = (gdouble *) tmp;
-
-  for (i = 0; i < count; i++)
+  if (count > 0)
     {
-#if (G_BYTE_ORDER == G_LITTLE_ENDIAN)
-      gint j;
-#endif
-
-      if (! _gimp_wire_read_int8 (channel, tmp, 8, user_data))
+      if (! _gimp_wire_read_int8 (channel,
+                                  (guint8 *) data, count * 8, user_data))
         return FALSE;
 
 #if (G_BYTE_ORDER == G_LITTLE_ENDIAN)
-      for (j = 0; j < 4; j++)
+      while (count--)
         {
-          guint8 swap;
+          guint64 tmp;
+
+          memcpy (&tmp, data, 8);
+          tmp = GUINT64_FROM_BE (tmp);
+          memcpy (data, &tmp, 8);
 
-          swap       = tmp[j];
-          tmp[j]     = tmp[7 - j];
-          tmp[7 - j] = swap;
+          data++;
         }
 #endif
-
-      data[i] = *t;
     }
 
   return TRUE;
@@ -476,21 +479,29 @@ _gimp_wire_write_int32 (GIOChannel    *channel,
 {
   g_return_val_if_fail (count >= 0, FALSE);
 
-  if (count > 0)
+#if (G_BYTE_ORDER == G_BIG_ENDIAN)
+  return _gimp_wire_write_int8 (channel,
+                                (const guint8 *) data, count * 4, user_data);
+#else
+  while (count > 0)
     {
-      gint i;
+      guint32 tmp[WIRE_CHUNK_SIZE / 4];
+      gint    n = MIN (count, (gint) G_N_ELEMENTS (tmp));
+      gint    i;
 
-      for (i = 0; i < count; i++)
-        {
-          guint32 tmp = g_htonl (data[i]);
+      for (i = 0; i < n; i++)
+        tmp[i] = g_htonl (data[i]);
 
-          if (! _gimp_wire_write_int8 (channel,
-                                       (const guint8 *) &tmp, 4, user_data))
-            return FALSE;
-        }
+      if (! _gimp_wire_write_int8 (channel,
+                                   (const guint8 *) tmp, n * 4, user_data))
+        return FALSE;
+
+      data  += n;
+      count -= n;
     }
 
   return TRUE;
+#endif
 }
 
 gboolean
@@ -501,21 +512,29 @@ _gimp_wire_write_int16 (GIOChannel    *channel,
 {
   g_return_val_if_fail (count >= 0, FALSE);
 
-  if (count > 0)
+#if (G_BYTE_ORDER == G_BIG_ENDIAN)
+  return _gimp_wire_write_int8 (channel,
+                                (const guint8 *) data, count * 2, user_data);
+#else
+  while (count > 0)
     {
-      gint i;
+      guint16 tmp[WIRE_CHUNK_SIZE / 2];
+      gint    n = MIN (count, (gint) G_N_ELEMENTS (tmp));
+      gint    i;
 
-      for (i = 0; i < count; i++)
-        {
-          guint16 tmp = g_htons (data[i]);
+      for (i = 0; i < n; i++)
+        tmp[i] = g_htons (data[i]);
 
-          if (! _gimp_wire_write_int8 (channel,
-                                       (const guint8 *) &tmp, 2, user_data))
-            return FALSE;
-        }
+      if (! _gimp_wire_write_int8 (channel,
+                                   (const guint8 *) tmp, n * 2, user_data))
+        return FALSE;
+
+      data  += n;
+      count -= n;
     }
 
   return TRUE;
+#endif
 }
 
 gboolean
@@ -535,50 +554,34 @@ _gimp_wire_write_double (GIOChannel    *channel,
                          gint           count,
                          gpointer       user_data)
 {
-  gdouble *t;
-  guint8   tmp[8];
-  gint     i;
-#if (G_BYTE_ORDER == G_LITTLE_ENDIAN)
-  gint     j;
-#endif
-
   g_return_val_if_fail (count >= 0, FALSE);
 
-  t = (gdouble *) tmp;
-
-  for (i = 0; i < count; i++)
+#if (G_BYTE_ORDER == G_BIG_ENDIAN)
+  return _gimp_wire_write_int8 (channel,
+                                (const guint8 *) data, count * 8, user_data);
+#else
+  while (count > 0)
     {
-      *t = data[i];
+      guint64 tmp[WIRE_CHUNK_SIZE / 8];
+      gint    n = MIN (count, (gint) G_N_ELEMENTS (tmp));
+      gint    i;
 
-#if (G_BYTE_ORDER == G_LITTLE_ENDIAN)
-      for (j = 0; j < 4; j++)
+      for (i = 0; i < n; i++)
         {
-          guint8 swap;
-
-          swap       = tmp[j];
-          tmp[j]     = tmp[7 - j];
-          tmp[7 - j] = swap;
+          memcpy (&tmp[i], &data[i], 8);
+          tmp[i] = GUINT64_TO_BE (tmp[i]);
         }
-#endif
 
-      if (! _gimp_wire_write_int8 (channel, tmp, 8, user_data))
+      if (! _gimp_wire_write_int8 (channel,
+                                   (const guint8 *) tmp, n * 8, user_data))
         return FALSE;
 
-#if 0
-      {
-        gint k;
-
-        g_print ("Wire representation of %f:\t", data[i]);
-
-        for (k = 0; k < 8; k++)
-          g_print ("%02x ", tmp[k]);
-
-        g_print ("\n");
-      }
-#endif
+      data  += n;
+      count -= n;
     }
 
   return TRUE;
+#endif
 }
 
 gboolean
@@ -644,3 +647,12 @@ gimp_wire_init (void)
     wire_ht = g_hash_table_new ((GHashFunc) gimp_wire_hash,
                                 (GCompareFunc) gimp_wire_compare);
 }
+
+static GimpWireHandler *
+gimp_wire_lookup (guint32 type)
+{
+  if (type < WIRE_N_DIRECT_HANDLERS)
+    return wire_direct_handlers[type];
+
+  return g_hash_table_lookup (wire_ht, &type);
+}
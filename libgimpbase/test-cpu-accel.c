@@ -4,7 +4,7 @@
 
 #include <stdlib.h>
 
-#include <glib.h>
+#include <glib-object.h>
 
 #include "gimpcpuaccel.h"
 
@@ -31,10 +31,26 @@ cpu_accel_print_results (void)
               (support & GIMP_CPU_ACCEL_X86_SSE2)    ? "yes" : "no");
   g_printerr ("  sse3    : %s\n",
               (support & GIMP_CPU_ACCEL_X86_SSE3)    ? "yes" : "no");
+  g_printerr ("  ssse3   : %s\n",
+              (support & GIMP_CPU_ACCEL_X86_SSSE3)   ? "yes" : "no");
+  g_printerr ("  sse4.1  : %s\n",
+              (support & GIMP_CPU_ACCEL_X86_SSE4_1)  ? "yes" : "no");
+  g_printerr ("  sse4.2  : %s\n",
+              (support & GIMP_CPU_ACCEL_X86_SSE4_2)  ? "yes" : "no");
+  g_printerr ("  avx     : %s\n",
+              (support & GIMP_CPU_ACCEL_X86_AVX)     ? "yes" : "no");
+  g_printerr ("  avx2    : %s\n",
+              (support & GIMP_CPU_ACCEL_X86_AVX2)    ? "yes" : "no");
+  g_printerr ("  avx512f : %s\n",
+              (support & GIMP_CPU_ACCEL_X86_AVX512F) ? "yes" : "no");
 #endif
 #ifdef ARCH_PPC
   g_printerr ("  altivec : %s\n",
               (support & GIMP_CPU_ACCEL_PPC_ALTIVEC) ? "yes" : "no");
+#endif
+#if defined(__arm__) || defined(__aarch64__)
+  g_printerr ("  neon    : %s\n",
+              (support & GIMP_CPU_ACCEL_ARM_NEON)    ? "yes" : "no");
 #endif
   g_printerr ("\n");
 }
@@ -392,3 +392,200 @@ gimp_adaptive_supersample_area (gint              x1,
 
   return num_samples;
 }
+
+
+#define GIMP_SUPERSAMPLE_MAX_THREADS  16
+#define GIMP_SUPERSAMPLE_BAND_HEIGHT  16
+
+typedef struct
+{
+  gint              x1, y1, x2, y2;
+  gint              max_depth;
+  gdouble           threshold;
+  GimpRenderFunc    render_func;
+  gpointer          render_data;
+  GimpPutPixelFunc  put_pixel_func;
+  gpointer          put_pixel_data;
+
+  gint              next_band;
+  gint              n_bands;
+
+  GMutex            mutex;
+  GCond             cond;
+  gint              rows_done;
+  gulong            num_samples;
+} GimpSupersampleShared;
+
+
+static void
+gimp_adaptive_supersample_row_done (gint     min,
+                                    gint     max,
+                                    gint     current,
+                                    gpointer data)
+{
+  GimpSupersampleShared *shared = data;
+
+  g_mutex_lock (&shared->mutex);
+
+  shared->rows_done++;
+  g_cond_signal (&shared->cond);
+
+  g_mutex_unlock (&shared->mutex);
+}
+
+static gpointer
+gimp_adaptive_supersample_thread (gpointer data)
+{
+  GimpSupersampleShared *shared = data;
+  gulong                 num_samples = 0;
+  gint                   band;
+
+  /*  every band is rendered by a separate call, so each one gets its
+   *  own sample row and block caches
+   */
+  while ((band = g_atomic_int_add (&shared->next_band, 1)) < shared->n_bands)
+    {
+      gint y1 = shared->y1 + band * GIMP_SUPERSAMPLE_BAND_HEIGHT;
+      gint y2 = MIN (y1 + GIMP_SUPERSAMPLE_BAND_HEIGHT - 1, shared->y2);
+
+      num_samples +=
+        gimp_adaptive_supersample_area (shared->x1, y1, shared->x2, y2,
+                                        shared->max_depth,
+                                        shared->threshold,
+                                        shared->render_func,
+                                        shared->render_data,
+                                        shared->put_pixel_func,
+                                        shared->put_pixel_data,
+                                        gimp_adaptive_supersample_row_done,
+                                        shared);
+    }
+
+  g_mutex_lock (&shared->mutex);
+  shared->num_samples += num_samples;
+  g_mutex_unlock (&shared->mutex);
+
+  return NULL;
+}
+
+/**
+ * gimp_adaptive_supersample_area_parallel:
+ * @x1:             left edge of the area
+ * @y1:             top edge of the area
+ * @x2:             right edge of the area
+ * @y2:             bottom edge of the area
+ * @max_depth:      maximum recursion depth
+ * @threshold:      color distance that triggers supersampling
+ * @render_func:    thread-safe function that renders a sample
+ * @render_data:    data passed to @render_func
+ * @put_pixel_func: thread-safe function that stores a pixel
+ * @put_pixel_data: data passed to @put_pixel_func
+ * @progress_func:  function that reports progress, or %NULL
+ * @progress_data:  data passed to @progress_func
+ *
+ * Like gimp_adaptive_supersample_area(), but splits the area into
+ * horizontal bands which are rendered by a pool of threads.
+ *
+ * @render_func and @put_pixel_func are called from several threads
+ * at once and must be safe to call concurrently; @put_pixel_func is
+ * never called twice for the same pixel.  @progress_func is only
+ * called from the calling thread, with the number of rows completed
+ * so far.
+ *
+ * Samples on the edges between bands are rendered twice, so the
+ * returned sample count can be slightly larger than the one
+ * gimp_adaptive_supersample_area() returns for the same area.
+ *
+ * Return value: the number of samples rendered.
+ *
+ * Since: 2.10
+ **/
+gulong
+gimp_adaptive_supersample_area_parallel (gint              x1,
+                                         gint              y1,
+                                         gint              x2,
+                                         gint              y2,
+                                         gint              max_depth,
+                                         gdouble           threshold,
+                                         GimpRenderFunc    render_func,
+                                         gpointer          render_data,
+                                         GimpPutPixelFunc  put_pixel_func,
+                                         gpointer          put_pixel_data,
+                                         GimpProgressFunc  progress_func,
+                                         gpointer          progress_data)
+{
+  GimpSupersampleShared  shared;
+  GThread               *threads[GIMP_SUPERSAMPLE_MAX_THREADS];
+  gint                   n_threads;
+  gint                   n_rows;
+  gint                   i;
+
+  g_return_val_if_fail (render_func != NULL, 0);
+  g_return_val_if_fail (put_pixel_func != NULL, 0);
+
+  n_rows = y2 - y1 + 1;
+
+  if (n_rows <= 0)
+    return 0;
+
+  shared.x1             = x1;
+  shared.y1             = y1;
+  shared.x2             = x2;
+  shared.y2             = y2;
+  shared.max_depth      = max_depth;
+  shared.threshold      = threshold;
+  shared.render_func    = render_func;
+  shared.render_data    = render_data;
+  shared.put_pixel_func = put_pixel_func;
+  shared.put_pixel_data = put_pixel_data;
+  shared.next_band      = 0;
+  shared.n_bands        = (n_rows + GIMP_SUPERSAMPLE_BAND_HEIGHT - 1) /
+                          GIMP_SUPERSAMPLE_BAND_HEIGHT;
+  shared.rows_done      = 0;
+  shared.num_samples    = 0;
+
+  n_threads = CLAMP (g_get_num_processors (), 1,
+                     MIN (shared.n_bands, GIMP_SUPERSAMPLE_MAX_THREADS));
+
+  if (n_threads == 1)
+    return gimp_adaptive_supersample_area (x1, y1, x2, y2,
+                                           max_depth, threshold,
+                                           render_func, render_data,
+                                           put_pixel_func, put_pixel_data,
+                                           progress_func, progress_data);
+
+  g_mutex_init (&shared.mutex);
+  g_cond_init (&shared.cond);
+
+  for (i = 0; i < n_threads; i++)
+    threads[i] = g_thread_new ("supersample",
+                               gimp_adaptive_supersample_thread, &shared);
+
+  if (progress_func)
+    {
+      gint rows_done = 0;
+
+      g_mutex_lock (&shared.mutex);
+
+      while (rows_done < n_rows)
+        {
+          while (shared.rows_done == rows_done)
+            g_cond_wait (&shared.cond, &shared.mutex);
+
+          rows_done = shared.rows_done;
+
+          g_mutex_unlock (&shared.mutex);
+          (* progress_func) (y1, y2, y1 + rows_done - 1, progress_data);
+          g_mutex_lock (&shared.mutex);
+        }
+
+      g_mutex_unlock (&shared.mutex);
+    }
+
+  for (i = 0; i < n_threads; i++)
+    g_thread_join (threads[i]);
+
+  g_mutex_clear (&shared.mutex);
+  g_cond_clear (&shared.cond);
+
+  return shared.num_samples;
+}
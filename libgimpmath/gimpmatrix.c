@@ -491,6 +491,149 @@ gimp_matrix3_transform_point (const GimpMatrix3 *matrix,
            matrix->coeff[1][2]) * w;
 }
 
+/**
+ * gimp_matrix3_transform_points:
+ * @matrix:     The transformation matrix.
+ * @points:     An array of @n_points source points.
+ * @n_points:   The number of points.
+ * @new_points: An array of @n_points for the transformed points, may
+ *              be the same as @points.
+ *
+ * Transforms an array of points in 2D as specified by the
+ * transformation matrix.  This gives the same result as calling
+ * gimp_matrix3_transform_point() for each point, but inspects the
+ * matrix only once, and uses cheaper loops for pure translations and
+ * affine matrices.
+ *
+ * Since: 2.10
+ */
+void
+gimp_matrix3_transform_points (const GimpMatrix3 *matrix,
+                               const GimpVector2 *points,
+                               gint               n_points,
+                               GimpVector2       *new_points)
+{
+  gdouble m00, m01, m02;
+  gdouble m10, m11, m12;
+  gdouble m20, m21, m22;
+  gint    i;
+
+  g_return_if_fail (matrix != NULL);
+  g_return_if_fail (n_points == 0 || (points != NULL && new_points != NULL));
+
+  m00 = matrix->coeff[0][0];
+  m01 = matrix->coeff[0][1];
+  m02 = matrix->coeff[0][2];
+  m10 = matrix->coeff[1][0];
+  m11 = matrix->coeff[1][1];
+  m12 = matrix->coeff[1][2];
+  m20 = matrix->coeff[2][0];
+  m21 = matrix->coeff[2][1];
+  m22 = matrix->coeff[2][2];
+
+  if (m20 == 0.0 && m21 == 0.0 && m22 == 1.0)
+    {
+      if (m00 == 1.0 && m01 == 0.0 && m10 == 0.0 && m11 == 1.0)
+        {
+          for (i = 0; i < n_points; i++)
+            {
+              new_points[i].x = points[i].x + m02;
+              new_points[i].y = points[i].y + m12;
+            }
+        }
+      else
+        {
+          for (i = 0; i < n_points; i++)
+            {
+              const gdouble x = points[i].x;
+              const gdouble y = points[i].y;
+
+              new_points[i].x = m00 * x + m01 * y + m02;
+              new_points[i].y = m10 * x + m11 * y + m12;
+            }
+        }
+    }
+  else
+    {
+      for (i = 0; i < n_points; i++)
+        {
+          const gdouble x = points[i].x;
+          const gdouble y = points[i].y;
+          gdouble       w = m20 * x + m21 * y + m22;
+
+          w = (w == 0.0) ? 1.0 : 1.0 / w;
+
+          new_points[i].x = (m00 * x + m01 * y + m02) * w;
+          new_points[i].y = (m10 * x + m11 * y + m12) * w;
+        }
+    }
+}
+
+/**
+ * gimp_matrix3_transform_points_round:
+ * @matrix:   The transformation matrix.
+ * @points:   A pointer to the X coordinate of the first point, which is
+ *            immediately followed by its Y coordinate.
+ * @n_points: The number of points.
+ * @stride:   The distance between two consecutive points in bytes.
+ *
+ * Transforms an array of integer points in place as specified by the
+ * transformation matrix, rounding the results to the nearest integer.
+ * The @stride allows transforming points which are embedded in larger
+ * structs, such as the end points of an array of segments.
+ *
+ * Since: 2.10
+ */
+void
+gimp_matrix3_transform_points_round (const GimpMatrix3 *matrix,
+                                     gint              *points,
+                                     gint               n_points,
+                                     gsize              stride)
+{
+  guchar *p = (guchar *) points;
+  gint    i;
+
+  g_return_if_fail (matrix != NULL);
+  g_return_if_fail (n_points == 0 || points != NULL);
+  g_return_if_fail (stride >= 2 * sizeof (gint));
+
+  if (matrix->coeff[2][0] == 0.0 && matrix->coeff[2][1] == 0.0 &&
+      matrix->coeff[2][2] == 1.0 &&
+      matrix->coeff[0][0] == 1.0 && matrix->coeff[0][1] == 0.0 &&
+      matrix->coeff[1][0] == 0.0 && matrix->coeff[1][1] == 1.0 &&
+      matrix->coeff[0][2] == RINT (matrix->coeff[0][2]) &&
+      matrix->coeff[1][2] == RINT (matrix->coeff[1][2]))
+    {
+      /*  an integer translation keeps the points on the grid  */
+      const gint dx = matrix->coeff[0][2];
+      const gint dy = matrix->coeff[1][2];
+
+      for (i = 0; i < n_points; i++, p += stride)
+        {
+          gint *point = (gint *) p;
+
+          point[0] += dx;
+          point[1] += dy;
+        }
+    }
+  else
+    {
+      for (i = 0; i < n_points; i++, p += stride)
+        {
+          gint        *point = (gint *) p;
+          GimpVector2  v;
+
+          v.x = point[0];
+          v.y = point[1];
+
+          gimp_matrix3_transform_points (matrix, &v, 1, &v);
+
+          point[0] = RINT (v.x);
+          point[1] = RINT (v.y);
+        }
+    }
+}
+
 /**
  * gimp_matrix3_mult:
  * @matrix1: The first input matrix.
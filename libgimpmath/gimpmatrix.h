@@ -38,24 +38,24 @@ G_BEGIN_DECLS
 #define GIMP_TYPE_MATRIX2               (gimp_matrix2_get_type ())
 #define GIMP_VALUE_HOLDS_MATRIX2(value) (G_TYPE_CHECK_VALUE_TYPE ((value), GIMP_TYPE_MATRIX2))
 
-GType         gimp_matrix2_get_type        (void) G_GNUC_CONST;
+GType         gimp_matrix2_get_type               (void) G_GNUC_CONST;
 
 
 #define GIMP_TYPE_PARAM_MATRIX2            (gimp_param_matrix2_get_type ())
 #define GIMP_IS_PARAM_SPEC_MATRIX2(pspec)  (G_TYPE_CHECK_INSTANCE_TYPE ((pspec), GIMP_TYPE_PARAM_MATRIX2))
 
-GType         gimp_param_matrix2_get_type  (void) G_GNUC_CONST;
+GType         gimp_param_matrix2_get_type         (void) G_GNUC_CONST;
 
-GParamSpec *  gimp_param_spec_matrix2      (const gchar        *name,
-                                            const gchar        *nick,
-                                            const gchar        *blurb,
-                                            const GimpMatrix2  *default_value,
-                                            GParamFlags         flags);
+GParamSpec *  gimp_param_spec_matrix2             (const gchar        *name,
+                                                   const gchar        *nick,
+                                                   const gchar        *blurb,
+                                                   const GimpMatrix2  *default_value,
+                                                   GParamFlags         flags);
 
 
-void          gimp_matrix2_identity        (GimpMatrix2       *matrix);
-void          gimp_matrix2_mult            (const GimpMatrix2 *matrix1,
-                                            GimpMatrix2       *matrix2);
+void          gimp_matrix2_identity               (GimpMatrix2       *matrix);
+void          gimp_matrix2_mult                   (const GimpMatrix2 *matrix1,
+                                                   GimpMatrix2       *matrix2);
 
 
 /*****************/
@@ -65,67 +65,75 @@ void          gimp_matrix2_mult            (const GimpMatrix2 *matrix1,
 #define GIMP_TYPE_MATRIX3               (gimp_matrix3_get_type ())
 #define GIMP_VALUE_HOLDS_MATRIX3(value) (G_TYPE_CHECK_VALUE_TYPE ((value), GIMP_TYPE_MATRIX3))
 
-GType         gimp_matrix3_get_type        (void) G_GNUC_CONST;
+GType         gimp_matrix3_get_type               (void) G_GNUC_CONST;
 
 
 #define GIMP_TYPE_PARAM_MATRIX3            (gimp_param_matrix3_get_type ())
 #define GIMP_IS_PARAM_SPEC_MATRIX3(pspec)  (G_TYPE_CHECK_INSTANCE_TYPE ((pspec), GIMP_TYPE_PARAM_MATRIX3))
 
-GType         gimp_param_matrix3_get_type  (void) G_GNUC_CONST;
-
-GParamSpec *  gimp_param_spec_matrix3      (const gchar        *name,
-                                            const gchar        *nick,
-                                            const gchar        *blurb,
-                                            const GimpMatrix3  *default_value,
-                                            GParamFlags         flags);
-
-
-void          gimp_matrix3_identity        (GimpMatrix3       *matrix);
-void          gimp_matrix3_mult            (const GimpMatrix3 *matrix1,
-                                            GimpMatrix3       *matrix2);
-void          gimp_matrix3_translate       (GimpMatrix3       *matrix,
-                                            gdouble            x,
-                                            gdouble            y);
-void          gimp_matrix3_scale           (GimpMatrix3       *matrix,
-                                            gdouble            x,
-                                            gdouble            y);
-void          gimp_matrix3_rotate          (GimpMatrix3       *matrix,
-                                            gdouble            theta);
-void          gimp_matrix3_xshear          (GimpMatrix3       *matrix,
-                                            gdouble            amount);
-void          gimp_matrix3_yshear          (GimpMatrix3       *matrix,
-                                            gdouble            amount);
-void          gimp_matrix3_affine          (GimpMatrix3       *matrix,
-                                            gdouble            a,
-                                            gdouble            b,
-                                            gdouble            c,
-                                            gdouble            d,
-                                            gdouble            e,
-                                            gdouble            f);
-
-gdouble       gimp_matrix3_determinant     (const GimpMatrix3 *matrix);
-void          gimp_matrix3_invert          (GimpMatrix3       *matrix);
-
-gboolean      gimp_matrix3_is_identity     (const GimpMatrix3 *matrix);
-gboolean      gimp_matrix3_is_diagonal     (const GimpMatrix3 *matrix);
-gboolean      gimp_matrix3_is_affine       (const GimpMatrix3 *matrix);
-gboolean      gimp_matrix3_is_simple       (const GimpMatrix3 *matrix);
-
-void          gimp_matrix3_transform_point (const GimpMatrix3 *matrix,
-                                            gdouble            x,
-                                            gdouble            y,
-                                            gdouble           *newx,
-                                            gdouble           *newy);
+GType         gimp_param_matrix3_get_type         (void) G_GNUC_CONST;
+
+GParamSpec *  gimp_param_spec_matrix3             (const gchar        *name,
+                                                   const gchar        *nick,
+                                                   const gchar        *blurb,
+                                                   const GimpMatrix3  *default_value,
+                                                   GParamFlags         flags);
+
+
+void          gimp_matrix3_identity               (GimpMatrix3       *matrix);
+void          gimp_matrix3_mult                   (const GimpMatrix3 *matrix1,
+                                                   GimpMatrix3       *matrix2);
+void          gimp_matrix3_translate              (GimpMatrix3       *matrix,
+                                                   gdouble            x,
+                                                   gdouble            y);
+void          gimp_matrix3_scale                  (GimpMatrix3       *matrix,
+                                                   gdouble            x,
+                                                   gdouble            y);
+void          gimp_matrix3_rotate                 (GimpMatrix3       *matrix,
+                                                   gdouble            theta);
+void          gimp_matrix3_xshear                 (GimpMatrix3       *matrix,
+                                                   gdouble            amount);
+void          gimp_matrix3_yshear                 (GimpMatrix3       *matrix,
+                                                   gdouble            amount);
+void          gimp_matrix3_affine                 (GimpMatrix3       *matrix,
+                                                   gdouble            a,
+                                                   gdouble            b,
+                                                   gdouble            c,
+                                                   gdouble            d,
+                                                   gdouble            e,
+                                                   gdouble            f);
+
+gdouble       gimp_matrix3_determinant            (const GimpMatrix3 *matrix);
+void          gimp_matrix3_invert                 (GimpMatrix3       *matrix);
+
+gboolean      gimp_matrix3_is_identity            (const GimpMatrix3 *matrix);
+gboolean      gimp_matrix3_is_diagonal            (const GimpMatrix3 *matrix);
+gboolean      gimp_matrix3_is_affine              (const GimpMatrix3 *matrix);
+gboolean      gimp_matrix3_is_simple              (const GimpMatrix3 *matrix);
+
+void          gimp_matrix3_transform_point        (const GimpMatrix3 *matrix,
+                                                   gdouble            x,
+                                                   gdouble            y,
+                                                   gdouble           *newx,
+                                                   gdouble           *newy);
+void          gimp_matrix3_transform_points       (const GimpMatrix3 *matrix,
+                                                   const GimpVector2 *points,
+                                                   gint               n_points,
+                                                   GimpVector2       *new_points);
+void          gimp_matrix3_transform_points_round (const GimpMatrix3 *matrix,
+                                                   gint              *points,
+                                                   gint               n_points,
+                                                   gsize              stride);
 
 
 /*****************/
 /*  GimpMatrix4  */
 /*****************/
 
-void          gimp_matrix4_to_deg          (const GimpMatrix4 *matrix,
-                                            gdouble           *a,
-                                            gdouble           *b,
-                                            gdouble           *c);
+void          gimp_matrix4_to_deg                 (const GimpMatrix4 *matrix,
+                                                   gdouble           *a,
+                                                   gdouble           *b,
+                                                   gdouble           *c);
 
 
 G_END_DECLS
@@ -2,7 +2,10 @@
  * gimp-thumbnail-list.c
  */
 
+#include <errno.h>
+#include <stdio.h>
 #include <string.h>
+#include <glib/gstdio.h>
 #include <gdk-pixbuf/gdk-pixbuf.h>
 #include <libgimpthumb/gimpthumb.h>
 
@@ -10,22 +13,72 @@
 #define STATE_NONE  -1
 #define STATE_ERROR -2
 
+/*  how many files may wait in the queue per worker thread; this keeps
+ *  memory bounded when feeding millions of files
+ */
+#define QUEUE_PER_JOB 64
+
+#define SOFTWARE "gimp-thumbnail-list"
 
-static gboolean  parse_option_state (const gchar  *option_name,
-                                     const gchar  *value,
-                                     gpointer      data,
-                                     GError      **error);
-static gboolean  parse_option_path  (const gchar  *option_name,
-                                     const gchar  *value,
-                                     gpointer      data,
-                                     GError      **error);
-static void      process_folder     (const gchar  *folder);
-static void      process_thumbnail  (const gchar  *filename);
+#define SCALED(value, scale) MAX (1, (gint) ((value) * (scale) + 0.5))
 
 
-static GimpThumbState  option_state   = STATE_NONE;
-static gboolean        option_verbose = FALSE;
-static gchar          *option_path    = NULL;
+typedef struct
+{
+  gint width;
+  gint height;
+} ImageSize;
+
+
+static gboolean     parse_option_state (const gchar      *option_name,
+                                        const gchar      *value,
+                                        gpointer          data,
+                                        GError          **error);
+static gboolean     parse_option_path  (const gchar      *option_name,
+                                        const gchar      *value,
+                                        gpointer          data,
+                                        GError          **error);
+static void         process_folder     (const gchar      *folder);
+static void         process_thumbnail  (const gchar      *filename);
+
+static gint         generate_main      (gchar           **files);
+static void         generate_path      (const gchar      *path);
+static void         generate_list      (const gchar      *list);
+static void         generate_push      (const gchar      *filename);
+static void         generate_func      (gchar            *filename,
+                                        gpointer          data);
+static gboolean     generate_thumbnail (GimpThumbnail    *thumbnail,
+                                        const gchar      *filename,
+                                        GError          **error);
+static void         generate_done      (const gchar      *filename);
+
+static void         size_prepared      (GdkPixbufLoader  *loader,
+                                        gint              width,
+                                        gint              height,
+                                        ImageSize        *size);
+
+static GHashTable * progress_load      (const gchar      *filename);
+
+
+static GimpThumbState  option_state      = STATE_NONE;
+static gboolean        option_verbose    = FALSE;
+static gchar          *option_path       = NULL;
+
+static gboolean        option_generate   = FALSE;
+static gchar          *option_files_from = NULL;
+static gint            option_jobs       = 0;
+static gchar          *option_progress   = NULL;
+static gchar         **option_files      = NULL;
+
+static GThreadPool    *generate_pool     = NULL;
+static GHashTable     *generate_skip     = NULL;
+static FILE           *progress_file     = NULL;
+static GMutex          progress_mutex;
+static GMutex          queue_mutex;
+static GCond           queue_cond;
+static gint            n_generated       = 0;
+static gint            n_failed          = 0;
+static gint            n_skipped         = 0;
 
 
 static const GOptionEntry main_entries[] =
@@ -48,6 +101,36 @@ static const GOptionEntry main_entries[] =
     G_OPTION_ARG_NONE, &option_verbose,
     "Print additional info per matched file", NULL
   },
+  {
+    "generate", 'g', 0,
+    G_OPTION_ARG_NONE, &option_generate,
+    "Generate normal and large thumbnails for the given files and folders "
+    "instead of listing existing thumbnails", NULL
+  },
+  {
+    "files-from", 'f', 0,
+    G_OPTION_ARG_FILENAME, &option_files_from,
+    "Read the files to generate thumbnails for from <file>, "
+    "one per line ('-' reads from stdin)",
+    "<file>"
+  },
+  {
+    "jobs", 'j', 0,
+    G_OPTION_ARG_INT, &option_jobs,
+    "Number of threads generating thumbnails (default: number of CPUs)",
+    "<n>"
+  },
+  {
+    "progress", 'r', 0,
+    G_OPTION_ARG_FILENAME, &option_progress,
+    "Record finished files in <file> and skip them when run again",
+    "<file>"
+  },
+  {
+    G_OPTION_REMAINING, 0, 0,
+    G_OPTION_ARG_FILENAME_ARRAY, &option_files,
+    NULL, NULL
+  },
   { NULL }
 };
 
@@ -66,7 +149,7 @@ main (gint   argc,
 
   thumb_folder = gimp_thumb_get_thumb_base_dir ();
 
-  context = g_option_context_new (NULL);
+  context = g_option_context_new ("[FILE|FOLDER...]");
   g_option_context_add_main_entries (context, main_entries, NULL);
 
   if (! g_option_context_parse (context, &argc, &argv, &error))
@@ -75,6 +158,9 @@ main (gint   argc,
       return -1;
     }
 
+  if (option_generate || option_files_from)
+    return generate_main (option_files);
+
   dir = g_dir_open (thumb_folder, 0, &error);
 
   if (! dir)
@@ -249,3 +335,430 @@ process_thumbnail (const gchar *filename)
 
   g_object_unref (thumbnail);
 }
+
+
+/*  batch generation of thumbnails  */
+
+static gint
+generate_main (gchar **files)
+{
+  GError *error = NULL;
+  gint    i;
+
+  if (! gimp_thumb_ensure_thumb_dir (GIMP_THUMB_SIZE_NORMAL, &error) ||
+      ! gimp_thumb_ensure_thumb_dir (GIMP_THUMB_SIZE_LARGE,  &error))
+    {
+      g_printerr ("%s\n", error->message);
+      return -1;
+    }
+
+  if (option_progress)
+    {
+      generate_skip = progress_load (option_progress);
+
+      progress_file = fopen (option_progress, "a");
+
+      if (! progress_file)
+        {
+          g_printerr ("Error opening '%s': %s\n",
+                      option_progress, g_strerror (errno));
+          return -1;
+        }
+    }
+
+  if (option_jobs < 1)
+    option_jobs = g_get_num_processors ();
+
+  generate_pool = g_thread_pool_new ((GFunc) generate_func, NULL,
+                                     option_jobs, TRUE, &error);
+
+  if (! generate_pool)
+    {
+      g_printerr ("%s\n", error->message);
+      return -1;
+    }
+
+  if (option_files_from)
+    generate_list (option_files_from);
+
+  for (i = 0; files && files[i]; i++)
+    generate_path (files[i]);
+
+  g_thread_pool_free (generate_pool, FALSE, TRUE);
+
+  if (progress_file)
+    fclose (progress_file);
+
+  if (generate_skip)
+    g_hash_table_unref (generate_skip);
+
+  if (option_verbose)
+    g_print ("%d generated, %d failed, %d skipped\n",
+             n_generated, n_failed, n_skipped);
+
+  return n_failed > 0 ? 1 : 0;
+}
+
+static void
+generate_path (const gchar *path)
+{
+  GDir        *dir;
+  const gchar *name;
+  GError      *error = NULL;
+
+  if (! g_file_test (path, G_FILE_TEST_IS_DIR))
+    {
+      generate_push (path);
+      return;
+    }
+
+  dir = g_dir_open (path, 0, &error);
+
+  if (! dir)
+    {
+      g_printerr ("Error opening '%s': %s\n", path, error->message);
+      g_clear_error (&error);
+      return;
+    }
+
+  while ((name = g_dir_read_name (dir)))
+    {
+      gchar *filename;
+
+      /*  skip hidden files and folders, such as local thumbnail
+       *  repositories
+       */
+      if (name[0] == '.')
+        continue;
+
+      filename = g_build_filename (path, name, NULL);
+
+      generate_path (filename);
+
+      g_free (filename);
+    }
+
+  g_dir_close (dir);
+}
+
+static void
+generate_list (const gchar *list)
+{
+  GIOChannel *channel;
+  gchar      *line;
+  gsize       terminator;
+  GError     *error = NULL;
+
+  if (strcmp (list, "-") == 0)
+    channel = g_io_channel_unix_new (0);
+  else
+    channel = g_io_channel_new_file (list, "r", &error);
+
+  if (! channel)
+    {
+      g_printerr ("Error opening '%s': %s\n", list, error->message);
+      g_clear_error (&error);
+      return;
+    }
+
+  g_io_channel_set_encoding (channel, NULL, NULL);
+
+  while (g_io_channel_read_line (channel, &line, NULL, &terminator,
+                                 &error) == G_IO_STATUS_NORMAL)
+    {
+      line[terminator] = '\0';
+
+      if (*line)
+        generate_path (line);
+
+      g_free (line);
+    }
+
+  if (error)
+    {
+      g_printerr ("Error reading '%s': %s\n", list, error->message);
+      g_clear_error (&error);
+    }
+
+  g_io_channel_unref (channel);
+}
+
+static void
+generate_push (const gchar *filename)
+{
+  guint limit = option_jobs * QUEUE_PER_JOB;
+
+  if (generate_skip && g_hash_table_contains (generate_skip, filename))
+    {
+      g_atomic_int_inc (&n_skipped);
+      return;
+    }
+
+  g_mutex_lock (&queue_mutex);
+
+  while (g_thread_pool_unprocessed (generate_pool) >= limit)
+    g_cond_wait (&queue_cond, &queue_mutex);
+
+  g_mutex_unlock (&queue_mutex);
+
+  g_thread_pool_push (generate_pool, g_strdup (filename), NULL);
+}
+
+static void
+generate_func (gchar    *filename,
+               gpointer  data)
+{
+  GimpThumbnail *thumbnail = gimp_thumbnail_new ();
+  gchar         *path      = NULL;
+  GError        *error     = NULL;
+
+  if (! g_path_is_absolute (filename))
+    {
+      gchar *cwd = g_get_current_dir ();
+
+      path = g_build_filename (cwd, filename, NULL);
+      g_free (cwd);
+    }
+
+  if (! gimp_thumbnail_set_filename (thumbnail, path ? path : filename,
+                                     &error))
+    {
+      g_printerr ("%s '%s'\n", filename, error->message);
+      g_clear_error (&error);
+
+      g_atomic_int_inc (&n_failed);
+    }
+  else if (gimp_thumbnail_peek_image (thumbnail) != GIMP_THUMB_STATE_EXISTS)
+    {
+      /*  folders, special files and vanished files  */
+      g_atomic_int_inc (&n_skipped);
+      generate_done (filename);
+    }
+  else if (! generate_thumbnail (thumbnail, thumbnail->image_filename,
+                                 &error))
+    {
+      g_printerr ("%s '%s'\n", filename, error->message);
+      g_clear_error (&error);
+
+      /*  remember the failure, like the application does, so that
+       *  nobody tries to load this file again
+       */
+      gimp_thumbnail_save_failure (thumbnail, SOFTWARE, NULL);
+
+      g_atomic_int_inc (&n_failed);
+      generate_done (filename);
+    }
+  else
+    {
+      if (option_verbose)
+        g_print ("%s\n", filename);
+
+      g_atomic_int_inc (&n_generated);
+      generate_done (filename);
+    }
+
+  g_object_unref (thumbnail);
+  g_free (path);
+  g_free (filename);
+
+  g_mutex_lock (&queue_mutex);
+  g_cond_signal (&queue_cond);
+  g_mutex_unlock (&queue_mutex);
+}
+
+/*  decodes the image once, at no more than the large thumbnail size,
+ *  and writes the large and the normal thumbnail from that
+ */
+static gboolean
+generate_thumbnail (GimpThumbnail  *thumbnail,
+                    const gchar    *filename,
+                    GError        **error)
+{
+  GdkPixbufLoader *loader;
+  GdkPixbufFormat *format;
+  GdkPixbuf       *pixbuf;
+  ImageSize        size    = { 0, 0 };
+  FILE            *file;
+  guchar           buffer[65536];
+  gsize            length;
+  gint             width;
+  gint             height;
+  gboolean         success = TRUE;
+
+  file = g_fopen (filename, "rb");
+
+  if (! file)
+    {
+      g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (errno),
+                   "Could not open '%s' for reading: %s",
+                   filename, g_strerror (errno));
+      return FALSE;
+    }
+
+  loader = gdk_pixbuf_loader_new ();
+
+  g_signal_connect (loader, "size-prepared",
+                    G_CALLBACK (size_prepared),
+                    &size);
+
+  /*  feed the file in chunks, so large images are never held in
+   *  memory as a whole
+   */
+  while (success && (length = fread (buffer, 1, sizeof (buffer), file)) > 0)
+    success = gdk_pixbuf_loader_write (loader, buffer, length, error);
+
+  if (success && ferror (file))
+    {
+      g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (errno),
+                   "Error reading '%s': %s",
+                   filename, g_strerror (errno));
+      success = FALSE;
+    }
+
+  fclose (file);
+
+  /*  the loader must be closed even if writing failed  */
+  if (success)
+    success = gdk_pixbuf_loader_close (loader, error);
+  else
+    gdk_pixbuf_loader_close (loader, NULL);
+
+  if (! success)
+    {
+      g_object_unref (loader);
+      return FALSE;
+    }
+
+  pixbuf = gdk_pixbuf_apply_embedded_orientation
+    (gdk_pixbuf_loader_get_pixbuf (loader));
+
+  format = gdk_pixbuf_loader_get_format (loader);
+
+  if (format)
+    {
+      gchar **mime_types = gdk_pixbuf_format_get_mime_types (format);
+
+      if (mime_types && mime_types[0])
+        g_object_set (thumbnail,
+                      "image-mimetype", mime_types[0],
+                      NULL);
+
+      g_strfreev (mime_types);
+    }
+
+  g_object_unref (loader);
+
+  g_object_set (thumbnail,
+                "image-width",  size.width,
+                "image-height", size.height,
+                NULL);
+
+  width  = gdk_pixbuf_get_width (pixbuf);
+  height = gdk_pixbuf_get_height (pixbuf);
+
+  /*  an image that fits the normal size needs only one thumbnail,
+   *  lookups of the large size fall back to it
+   */
+  if (MAX (width, height) > GIMP_THUMB_SIZE_NORMAL)
+    {
+      GdkPixbuf *normal;
+      gdouble    scale;
+
+      success = gimp_thumbnail_save_thumb (thumbnail, pixbuf, SOFTWARE,
+                                           error);
+
+      scale = (gdouble) GIMP_THUMB_SIZE_NORMAL / MAX (width, height);
+
+      normal = gdk_pixbuf_scale_simple (pixbuf,
+                                        SCALED (width,  scale),
+                                        SCALED (height, scale),
+                                        GDK_INTERP_BILINEAR);
+
+      g_object_unref (pixbuf);
+      pixbuf = normal;
+    }
+
+  if (success)
+    success = gimp_thumbnail_save_thumb (thumbnail, pixbuf, SOFTWARE,
+                                         error);
+
+  g_object_unref (pixbuf);
+
+  if (success)
+    gimp_thumbnail_delete_failure (thumbnail);
+
+  return success;
+}
+
+static void
+generate_done (const gchar *filename)
+{
+  if (! progress_file)
+    return;
+
+  g_mutex_lock (&progress_mutex);
+
+  fputs (filename, progress_file);
+  fputc ('\n', progress_file);
+
+  g_mutex_unlock (&progress_mutex);
+}
+
+static void
+size_prepared (GdkPixbufLoader *loader,
+               gint             width,
+               gint             height,
+               ImageSize       *size)
+{
+  size->width  = width;
+  size->height = height;
+
+  /*  lets loaders like JPEG decode at a reduced scale  */
+  if (MAX (width, height) > GIMP_THUMB_SIZE_LARGE)
+    {
+      gdouble scale = (gdouble) GIMP_THUMB_SIZE_LARGE / MAX (width, height);
+
+      gdk_pixbuf_loader_set_size (loader,
+                                  SCALED (width,  scale),
+                                  SCALED (height, scale));
+    }
+}
+
+static GHashTable *
+progress_load (const gchar *filename)
+{
+  GHashTable *table;
+  GIOChannel *channel;
+  gchar      *line;
+  gsize       terminator;
+
+  table = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+  channel = g_io_channel_new_file (filename, "r", NULL);
+
+  if (! channel)
+    return table;
+
+  g_io_channel_set_encoding (channel, NULL, NULL);
+
+  while (g_io_channel_read_line (channel, &line, NULL, &terminator,
+                                 NULL) == G_IO_STATUS_NORMAL)
+    {
+      /*  a line cut short by an interrupted run has no terminator
+       *  and is not trusted
+       */
+      if (terminator > 0 && line[terminator] == '\n')
+        {
+          line[terminator] = '\0';
+          g_hash_table_add (table, line);
+        }
+      else
+        {
+          g_free (line);
+        }
+    }
+
+  g_io_channel_unref (channel);
+
+  return table;
+}
@@ -59,7 +59,8 @@ static gint           gimp_thumb_size       (GimpThumbSize  size);
 static gchar        * gimp_thumb_png_lookup (const gchar   *name,
                                              const gchar   *basedir,
                                              GimpThumbSize *size) G_GNUC_MALLOC;
-static const gchar  * gimp_thumb_png_name   (const gchar   *uri);
+static const gchar  * gimp_thumb_png_name   (const gchar   *uri,
+                                             gchar         *name);
 static void           gimp_thumb_exit       (void);
 
 
@@ -387,6 +388,8 @@ gchar *
 gimp_thumb_name_from_uri (const gchar   *uri,
                           GimpThumbSize  size)
 {
+  gchar name[40];
+
   g_return_val_if_fail (gimp_thumb_initialized, NULL);
   g_return_val_if_fail (uri != NULL, NULL);
 
@@ -396,7 +399,7 @@ gimp_thumb_name_from_uri (const gchar   *uri,
   size = gimp_thumb_size (size);
 
   return g_build_filename (thumb_subdirs[size],
-                           gimp_thumb_png_name (uri),
+                           gimp_thumb_png_name (uri, name),
                            NULL);
 }
 
@@ -439,10 +442,11 @@ gimp_thumb_name_from_uri_local (const gchar   *uri,
         {
           gchar *dirname = g_path_get_dirname (filename);
           gint   i       = gimp_thumb_size (size);
+          gchar  name[40];
 
           result = g_build_filename (dirname,
                                      ".thumblocal", thumb_sizenames[i],
-                                     gimp_thumb_png_name (uri),
+                                     gimp_thumb_png_name (uri, name),
                                      NULL);
 
           g_free (dirname);
@@ -480,13 +484,15 @@ gimp_thumb_find_thumb (const gchar   *uri,
                        GimpThumbSize *size)
 {
   gchar *result;
+  gchar  name[40];
 
   g_return_val_if_fail (gimp_thumb_initialized, NULL);
   g_return_val_if_fail (uri != NULL, NULL);
   g_return_val_if_fail (size != NULL, NULL);
   g_return_val_if_fail (*size > GIMP_THUMB_SIZE_FAIL, NULL);
 
-  result = gimp_thumb_png_lookup (gimp_thumb_png_name (uri), NULL, size);
+  result = gimp_thumb_png_lookup (gimp_thumb_png_name (uri, name),
+                                  NULL, size);
 
   if (! result)
     {
@@ -500,7 +506,8 @@ gimp_thumb_find_thumb (const gchar   *uri,
             {
               gchar *dirname = g_path_get_dirname (filename);
 
-              result = gimp_thumb_png_lookup (gimp_thumb_png_name (baseuri + 1),
+              result = gimp_thumb_png_lookup (gimp_thumb_png_name (baseuri + 1,
+                                                                   name),
                                               dirname, size);
 
               g_free (dirname);
@@ -838,11 +845,13 @@ gimp_thumb_png_lookup (const gchar   *name,
   return thumb_name;
 }
 
+/*  writes the thumbnail basename into @name, which must have room
+ *  for 40 bytes; using the caller's buffer keeps this thread-safe
+ */
 static const gchar *
-gimp_thumb_png_name (const gchar *uri)
+gimp_thumb_png_name (const gchar *uri,
+                     gchar       *name)
 {
-  static gchar name[40];
-
   GChecksum *checksum;
   guchar     digest[16];
   gsize      len = sizeof (digest);
@@ -100,6 +100,40 @@ enum
 };
 
 
+/*  thumbnails for asynchronous loads are read by a small pool of
+ *  threads, the pixbuf is checked against the image in the main thread
+ */
+#define LOAD_MAX_THREADS  4
+#define LOAD_DATA_KEY     "gimp-thumbnail-load"
+
+
+typedef struct _GimpThumbnailLoad   GimpThumbnailLoad;
+typedef struct _GimpThumbnailWaiter GimpThumbnailWaiter;
+
+struct _GimpThumbnailLoad
+{
+  GimpThumbnail *thumbnail;
+  GimpThumbSize  size;
+  gchar         *filename;
+  gint           priority;
+  guint          serial;
+
+  GList         *waiters;
+  gint           n_waiters;    /*  atomic  */
+  gint           n_cancelled;  /*  atomic  */
+
+  GdkPixbuf     *pixbuf;
+  GError        *error;
+};
+
+struct _GimpThumbnailWaiter
+{
+  GimpThumbnailLoad *load;
+  GTask             *task;
+  gulong             cancelled_id;
+};
+
+
 static void      gimp_thumbnail_finalize     (GObject        *object);
 static void      gimp_thumbnail_set_property (GObject        *object,
                                               guint           property_id,
@@ -121,6 +155,20 @@ static gboolean  gimp_thumbnail_save         (GimpThumbnail  *thumbnail,
                                               GdkPixbuf      *pixbuf,
                                               const gchar    *software,
                                               GError        **error);
+static GdkPixbuf * gimp_thumbnail_check_pixbuf   (GimpThumbnail       *thumbnail,
+                                                  GdkPixbuf           *pixbuf);
+
+static void        gimp_thumbnail_load_add       (GimpThumbnailLoad   *load,
+                                                  GTask               *task);
+static void        gimp_thumbnail_load_cancelled (GCancellable        *cancellable,
+                                                  GimpThumbnailWaiter *waiter);
+static gint        gimp_thumbnail_load_compare   (GimpThumbnailLoad   *load1,
+                                                  GimpThumbnailLoad   *load2,
+                                                  gpointer             data);
+static void        gimp_thumbnail_load_func      (GimpThumbnailLoad   *load,
+                                                  gpointer             data);
+static gboolean    gimp_thumbnail_load_idle      (GimpThumbnailLoad   *load);
+
 #ifdef GIMP_THUMB_DEBUG
 static void      gimp_thumbnail_debug_notify (GObject        *object,
                                               GParamSpec     *pspec);
@@ -131,6 +179,9 @@ G_DEFINE_TYPE (GimpThumbnail, gimp_thumbnail, G_TYPE_OBJECT)
 
 #define parent_class gimp_thumbnail_parent_class
 
+static GThreadPool *load_pool   = NULL;
+static guint        load_serial = 0;
+
 
 static void
 gimp_thumbnail_class_init (GimpThumbnailClass *klass)
@@ -1007,9 +1058,6 @@ gimp_thumbnail_load_thumb (GimpThumbnail  *thumbnail,
 {
   GimpThumbState  state;
   GdkPixbuf      *pixbuf;
-  const gchar    *option;
-  gint64          image_mtime;
-  gint64          image_size;
 
   g_return_val_if_fail (GIMP_IS_THUMBNAIL (thumbnail), NULL);
 
@@ -1031,6 +1079,21 @@ gimp_thumbnail_load_thumb (GimpThumbnail  *thumbnail,
   g_printerr ("thumbnail loaded from %s\n", thumbnail->thumb_filename);
 #endif
 
+  return gimp_thumbnail_check_pixbuf (thumbnail, pixbuf);
+}
+
+/*  checks the loaded @pixbuf against the image and updates the
+ *  thumbnail's state and info from it, @pixbuf is consumed
+ */
+static GdkPixbuf *
+gimp_thumbnail_check_pixbuf (GimpThumbnail *thumbnail,
+                             GdkPixbuf     *pixbuf)
+{
+  GimpThumbState  state = thumbnail->thumb_state;
+  const gchar    *option;
+  gint64          image_mtime;
+  gint64          image_size;
+
   g_object_freeze_notify (G_OBJECT (thumbnail));
 
   /* URI and mtime from the thumbnail need to match our file */
@@ -1089,6 +1152,260 @@ gimp_thumbnail_load_thumb (GimpThumbnail  *thumbnail,
   return pixbuf;
 }
 
+/**
+ * gimp_thumbnail_load_thumb_async:
+ * @thumbnail:   a #GimpThumbnail object
+ * @size:        the preferred #GimpThumbSize for the preview
+ * @priority:    the I/O priority of the request
+ * @cancellable: optional #GCancellable object, %NULL to ignore
+ * @callback:    a #GAsyncReadyCallback to call when the request is satisfied
+ * @user_data:   the data to pass to callback function
+ *
+ * Asynchronously loads a thumbnail preview for the image associated
+ * with @thumbnail, like gimp_thumbnail_load_thumb() does. The
+ * thumbnail file is read in a thread, requests with a lower
+ * @priority value are served first, and among requests of the same
+ * priority the most recent one is served first.
+ *
+ * A request for a thumbnail which is already being loaded in the same
+ * @size shares the result of the pending load. The thumbnail file is
+ * not read at all if all requests sharing it are cancelled.
+ *
+ * When the operation is finished, @callback will be called in the main
+ * thread. You can then call gimp_thumbnail_load_thumb_finish() to get
+ * the result of the operation.
+ *
+ * Since: GIMP 2.10
+ **/
+void
+gimp_thumbnail_load_thumb_async (GimpThumbnail       *thumbnail,
+                                 GimpThumbSize        size,
+                                 gint                 priority,
+                                 GCancellable        *cancellable,
+                                 GAsyncReadyCallback  callback,
+                                 gpointer             user_data)
+{
+  GimpThumbnailLoad *load;
+  GimpThumbState     state;
+  GTask             *task;
+
+  g_return_if_fail (GIMP_IS_THUMBNAIL (thumbnail));
+  g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+  GIMP_THUMB_DEBUG_CALL (thumbnail);
+
+  task = g_task_new (thumbnail, cancellable, callback, user_data);
+  g_task_set_source_tag (task, gimp_thumbnail_load_thumb_async);
+  g_task_set_priority (task, priority);
+
+  if (! thumbnail->image_uri)
+    {
+      g_task_return_pointer (task, NULL, NULL);
+      g_object_unref (task);
+      return;
+    }
+
+  /*  finding the thumbnail file only takes a few stat() calls  */
+  state = gimp_thumbnail_peek_thumb (thumbnail, size);
+
+  if (state < GIMP_THUMB_STATE_EXISTS || state == GIMP_THUMB_STATE_FAILED)
+    {
+      g_task_return_pointer (task, NULL, NULL);
+      g_object_unref (task);
+      return;
+    }
+
+  load = g_object_get_data (G_OBJECT (thumbnail), LOAD_DATA_KEY);
+
+  if (load                 &&
+      load->size == size   &&
+      ! strcmp (load->filename, thumbnail->thumb_filename))
+    {
+      gimp_thumbnail_load_add (load, task);
+      return;
+    }
+
+  if (! load_pool)
+    {
+      load_pool = g_thread_pool_new ((GFunc) gimp_thumbnail_load_func, NULL,
+                                     CLAMP (g_get_num_processors (),
+                                            1, LOAD_MAX_THREADS),
+                                     FALSE, NULL);
+
+      g_thread_pool_set_sort_function (load_pool,
+                                       (GCompareDataFunc) gimp_thumbnail_load_compare,
+                                       NULL);
+    }
+
+  load = g_slice_new0 (GimpThumbnailLoad);
+
+  load->thumbnail = g_object_ref (thumbnail);
+  load->size      = size;
+  load->filename  = g_strdup (thumbnail->thumb_filename);
+  load->priority  = priority;
+  load->serial    = load_serial++;
+
+  /*  a load which is still running for another size or file simply
+   *  finishes on its own
+   */
+  g_object_set_data (G_OBJECT (thumbnail), LOAD_DATA_KEY, load);
+
+  /*  add the first waiter before the load can be picked up  */
+  gimp_thumbnail_load_add (load, task);
+
+  g_thread_pool_push (load_pool, load, NULL);
+}
+
+/**
+ * gimp_thumbnail_load_thumb_finish:
+ * @thumbnail: a #GimpThumbnail object
+ * @result:    a #GAsyncResult
+ * @error:     return location for possible errors
+ *
+ * Finishes an operation started with gimp_thumbnail_load_thumb_async().
+ *
+ * Return value: a preview pixbuf or %NULL if no thumbnail was found
+ *
+ * Since: GIMP 2.10
+ **/
+GdkPixbuf *
+gimp_thumbnail_load_thumb_finish (GimpThumbnail  *thumbnail,
+                                  GAsyncResult   *result,
+                                  GError        **error)
+{
+  g_return_val_if_fail (GIMP_IS_THUMBNAIL (thumbnail), NULL);
+  g_return_val_if_fail (g_task_is_valid (result, thumbnail), NULL);
+  g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+  return g_task_propagate_pointer (G_TASK (result), error);
+}
+
+/*  the task is owned by the load from now on  */
+static void
+gimp_thumbnail_load_add (GimpThumbnailLoad *load,
+                         GTask             *task)
+{
+  GimpThumbnailWaiter *waiter = g_slice_new0 (GimpThumbnailWaiter);
+  GCancellable        *cancellable;
+
+  waiter->load = load;
+  waiter->task = task;
+
+  load->waiters = g_list_prepend (load->waiters, waiter);
+  g_atomic_int_inc (&load->n_waiters);
+
+  cancellable = g_task_get_cancellable (task);
+
+  if (cancellable)
+    waiter->cancelled_id =
+      g_cancellable_connect (cancellable,
+                             G_CALLBACK (gimp_thumbnail_load_cancelled),
+                             waiter, NULL);
+}
+
+/*  called from whatever thread cancelled the request  */
+static void
+gimp_thumbnail_load_cancelled (GCancellable        *cancellable,
+                               GimpThumbnailWaiter *waiter)
+{
+  g_atomic_int_inc (&waiter->load->n_cancelled);
+}
+
+static gint
+gimp_thumbnail_load_compare (GimpThumbnailLoad *load1,
+                             GimpThumbnailLoad *load2,
+                             gpointer           data)
+{
+  if (load1->priority != load2->priority)
+    return load1->priority < load2->priority ? -1 : 1;
+
+  /*  most recent first, it is most likely still visible  */
+  if (load1->serial != load2->serial)
+    return load1->serial > load2->serial ? -1 : 1;
+
+  return 0;
+}
+
+/*  runs in a thread of the load pool, @load must not be touched
+ *  except for reading the file
+ */
+static void
+gimp_thumbnail_load_func (GimpThumbnailLoad *load,
+                          gpointer           data)
+{
+  if (g_atomic_int_get (&load->n_cancelled) <
+      g_atomic_int_get (&load->n_waiters))
+    {
+      load->pixbuf = gdk_pixbuf_new_from_file (load->filename, &load->error);
+    }
+
+  g_idle_add_full (G_PRIORITY_DEFAULT_IDLE,
+                   (GSourceFunc) gimp_thumbnail_load_idle, load,
+                   NULL);
+}
+
+static gboolean
+gimp_thumbnail_load_idle (GimpThumbnailLoad *load)
+{
+  GimpThumbnail *thumbnail = load->thumbnail;
+  GdkPixbuf     *pixbuf    = load->pixbuf;
+  GList         *list;
+
+  if (g_object_get_data (G_OBJECT (thumbnail), LOAD_DATA_KEY) == load)
+    g_object_set_data (G_OBJECT (thumbnail), LOAD_DATA_KEY, NULL);
+
+  if (pixbuf)
+    {
+      /*  the thumbnail may have moved on while the file was read  */
+      if (g_strcmp0 (thumbnail->thumb_filename, load->filename) ||
+          thumbnail->thumb_size != load->size)
+        {
+          g_object_unref (pixbuf);
+          pixbuf = NULL;
+        }
+      else
+        {
+#ifdef GIMP_THUMB_DEBUG
+          g_printerr ("thumbnail loaded from %s\n", load->filename);
+#endif
+
+          pixbuf = gimp_thumbnail_check_pixbuf (thumbnail, pixbuf);
+        }
+    }
+
+  for (list = load->waiters; list; list = g_list_next (list))
+    {
+      GimpThumbnailWaiter *waiter = list->data;
+
+      if (waiter->cancelled_id)
+        g_cancellable_disconnect (g_task_get_cancellable (waiter->task),
+                                  waiter->cancelled_id);
+
+      /*  a broken thumbnail file is no error, like for
+       *  gimp_thumbnail_load_thumb()
+       */
+      if (! g_task_return_error_if_cancelled (waiter->task))
+        g_task_return_pointer (waiter->task,
+                               pixbuf ? g_object_ref (pixbuf) : NULL,
+                               (GDestroyNotify) g_object_unref);
+
+      g_object_unref (waiter->task);
+      g_slice_free (GimpThumbnailWaiter, waiter);
+    }
+
+  if (pixbuf)
+    g_object_unref (pixbuf);
+
+  g_list_free (load->waiters);
+  g_clear_error (&load->error);
+  g_free (load->filename);
+  g_object_unref (thumbnail);
+
+  g_slice_free (GimpThumbnailLoad, load);
+
+  return G_SOURCE_REMOVE;
+}
+
 /**
  * gimp_thumbnail_save_thumb:
  * @thumbnail: a #GimpThumbnail object
@@ -87,47 +87,56 @@ struct _GimpThumbnailClass
 };
 
 
-GType            gimp_thumbnail_get_type         (void) G_GNUC_CONST;
-
-GimpThumbnail  * gimp_thumbnail_new              (void);
-
-void             gimp_thumbnail_set_uri          (GimpThumbnail  *thumbnail,
-                                                  const gchar    *uri);
-gboolean         gimp_thumbnail_set_filename     (GimpThumbnail  *thumbnail,
-                                                  const gchar    *filename,
-                                                  GError        **error);
-gboolean         gimp_thumbnail_set_from_thumb   (GimpThumbnail  *thumbnail,
-                                                  const gchar    *filename,
-                                                  GError        **error);
-
-GimpThumbState   gimp_thumbnail_peek_image       (GimpThumbnail  *thumbnail);
-GimpThumbState   gimp_thumbnail_peek_thumb       (GimpThumbnail  *thumbnail,
-                                                  GimpThumbSize   size);
-
-GimpThumbState   gimp_thumbnail_check_thumb      (GimpThumbnail  *thumbnail,
-                                                  GimpThumbSize   size);
-
-GdkPixbuf      * gimp_thumbnail_load_thumb       (GimpThumbnail  *thumbnail,
-                                                  GimpThumbSize   size,
-                                                  GError        **error);
-
-gboolean         gimp_thumbnail_save_thumb       (GimpThumbnail  *thumbnail,
-                                                  GdkPixbuf      *pixbuf,
-                                                  const gchar    *software,
-                                                  GError        **error);
-gboolean         gimp_thumbnail_save_thumb_local (GimpThumbnail  *thumbnail,
-                                                  GdkPixbuf      *pixbuf,
-                                                  const gchar    *software,
-                                                  GError        **error);
-
-gboolean         gimp_thumbnail_save_failure     (GimpThumbnail  *thumbnail,
-                                                  const gchar    *software,
-                                                  GError        **error);
-void             gimp_thumbnail_delete_failure   (GimpThumbnail  *thumbnail);
-void             gimp_thumbnail_delete_others    (GimpThumbnail  *thumbnail,
-                                                  GimpThumbSize   size);
-
-gboolean         gimp_thumbnail_has_failed       (GimpThumbnail  *thumbnail);
+GType            gimp_thumbnail_get_type          (void) G_GNUC_CONST;
+
+GimpThumbnail  * gimp_thumbnail_new               (void);
+
+void             gimp_thumbnail_set_uri           (GimpThumbnail       *thumbnail,
+                                                   const gchar         *uri);
+gboolean         gimp_thumbnail_set_filename      (GimpThumbnail       *thumbnail,
+                                                   const gchar         *filename,
+                                                   GError             **error);
+gboolean         gimp_thumbnail_set_from_thumb    (GimpThumbnail       *thumbnail,
+                                                   const gchar         *filename,
+                                                   GError             **error);
+
+GimpThumbState   gimp_thumbnail_peek_image        (GimpThumbnail       *thumbnail);
+GimpThumbState   gimp_thumbnail_peek_thumb        (GimpThumbnail       *thumbnail,
+                                                   GimpThumbSize        size);
+
+GimpThumbState   gimp_thumbnail_check_thumb       (GimpThumbnail       *thumbnail,
+                                                   GimpThumbSize        size);
+
+GdkPixbuf      * gimp_thumbnail_load_thumb        (GimpThumbnail       *thumbnail,
+                                                   GimpThumbSize        size,
+                                                   GError             **error);
+void             gimp_thumbnail_load_thumb_async  (GimpThumbnail       *thumbnail,
+                                                   GimpThumbSize        size,
+                                                   gint                 priority,
+                                                   GCancellable        *cancellable,
+                                                   GAsyncReadyCallback  callback,
+                                                   gpointer             user_data);
+GdkPixbuf      * gimp_thumbnail_load_thumb_finish (GimpThumbnail       *thumbnail,
+                                                   GAsyncResult        *result,
+                                                   GError             **error);
+
+gboolean         gimp_thumbnail_save_thumb        (GimpThumbnail       *thumbnail,
+                                                   GdkPixbuf           *pixbuf,
+                                                   const gchar         *software,
+                                                   GError             **error);
+gboolean         gimp_thumbnail_save_thumb_local  (GimpThumbnail       *thumbnail,
+                                                   GdkPixbuf           *pixbuf,
+                                                   const gchar         *software,
+                                                   GError             **error);
+
+gboolean         gimp_thumbnail_save_failure      (GimpThumbnail       *thumbnail,
+                                                   const gchar         *software,
+                                                   GError             **error);
+void             gimp_thumbnail_delete_failure    (GimpThumbnail       *thumbnail);
+void             gimp_thumbnail_delete_others     (GimpThumbnail       *thumbnail,
+                                                   GimpThumbSize        size);
+
+gboolean         gimp_thumbnail_has_failed        (GimpThumbnail       *thumbnail);
 
 
 G_END_DECLS
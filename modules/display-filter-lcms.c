@@ -55,6 +55,10 @@
 #define CDISPLAY_IS_LCMS_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass), CDISPLAY_TYPE_LCMS))
 
 
+/*  number of grid points per axis of the display transform LUT  */
+#define LUT_SIZE 33
+
+
 typedef struct _CdisplayLcms      CdisplayLcms;
 typedef struct _CdisplayLcmsClass CdisplayLcmsClass;
 
@@ -62,7 +66,7 @@ struct _CdisplayLcms
 {
   GimpColorDisplay  parent_instance;
 
-  cmsHTRANSFORM     transform;
+  gfloat           *lut;
 };
 
 struct _CdisplayLcmsClass
@@ -81,6 +85,8 @@ static void         cdisplay_lcms_convert_buffer       (GimpColorDisplay  *displ
                                                         GeglRectangle     *area);
 static void         cdisplay_lcms_changed              (GimpColorDisplay  *display);
 
+static gfloat     * cdisplay_lcms_create_lut           (cmsHTRANSFORM      transform);
+
 static cmsHPROFILE  cdisplay_lcms_get_rgb_profile      (CdisplayLcms      *lcms);
 static cmsHPROFILE  cdisplay_lcms_get_display_profile  (CdisplayLcms      *lcms);
 static cmsHPROFILE  cdisplay_lcms_get_printer_profile  (CdisplayLcms      *lcms);
@@ -148,7 +154,7 @@ cdisplay_lcms_class_finalize (CdisplayLcmsClass *klass)
 static void
 cdisplay_lcms_init (CdisplayLcms *lcms)
 {
-  lcms->transform = NULL;
+  lcms->lut = NULL;
 }
 
 static void
@@ -156,10 +162,10 @@ cdisplay_lcms_finalize (GObject *object)
 {
   CdisplayLcms *lcms = CDISPLAY_LCMS (object);
 
-  if (lcms->transform)
+  if (lcms->lut)
     {
-      cmsDeleteTransform (lcms->transform);
-      lcms->transform = NULL;
+      g_free (lcms->lut);
+      lcms->lut = NULL;
     }
 
   G_OBJECT_CLASS (cdisplay_lcms_parent_class)->finalize (object);
@@ -253,8 +259,11 @@ cdisplay_lcms_convert_buffer (GimpColorDisplay *display,
 {
   CdisplayLcms       *lcms = CDISPLAY_LCMS (display);
   GeglBufferIterator *iter;
+  const gint          stride_r = LUT_SIZE * LUT_SIZE * 3;
+  const gint          stride_g = LUT_SIZE * 3;
+  const gint          stride_b = 3;
 
-  if (! lcms->transform)
+  if (! lcms->lut)
     return;
 
   iter = gegl_buffer_iterator_new (buffer, area, 0,
@@ -263,12 +272,132 @@ cdisplay_lcms_convert_buffer (GimpColorDisplay *display,
 
   while (gegl_buffer_iterator_next (iter))
     {
-      gfloat *data = iter->data[0];
+      gfloat *data  = iter->data[0];
+      gint    count = iter->length;
+
+      /*  tetrahedral interpolation in the display transform LUT,
+       *  alpha is passed through unchanged
+       */
+      while (count--)
+        {
+          const gfloat *c000;
+          const gfloat *c111;
+          const gfloat *c1;
+          const gfloat *c2;
+          gfloat        r, g, b;
+          gfloat        w0, w1, w2, w3;
+          gint          ir, ig, ib;
+          gint          i;
+
+          r = CLAMP (data[0], 0.0f, 1.0f) * (LUT_SIZE - 1);
+          g = CLAMP (data[1], 0.0f, 1.0f) * (LUT_SIZE - 1);
+          b = CLAMP (data[2], 0.0f, 1.0f) * (LUT_SIZE - 1);
+
+          ir = MIN ((gint) r, LUT_SIZE - 2);
+          ig = MIN ((gint) g, LUT_SIZE - 2);
+          ib = MIN ((gint) b, LUT_SIZE - 2);
+
+          r -= ir;
+          g -= ig;
+          b -= ib;
+
+          c000 = lcms->lut + ir * stride_r + ig * stride_g + ib * stride_b;
+          c111 = c000 + stride_r + stride_g + stride_b;
+
+          if (r >= g)
+            {
+              if (g >= b)
+                {
+                  c1 = c000 + stride_r;
+                  c2 = c1   + stride_g;
+                  w0 = 1.0f - r; w1 = r - g; w2 = g - b; w3 = b;
+                }
+              else if (r >= b)
+                {
+                  c1 = c000 + stride_r;
+                  c2 = c1   + stride_b;
+                  w0 = 1.0f - r; w1 = r - b; w2 = b - g; w3 = g;
+                }
+              else
+                {
+                  c1 = c000 + stride_b;
+                  c2 = c1   + stride_r;
+                  w0 = 1.0f - b; w1 = b - r; w2 = r - g; w3 = g;
+                }
+            }
+          else
+            {
+              if (b >= g)
+                {
+                  c1 = c000 + stride_b;
+                  c2 = c1   + stride_g;
+                  w0 = 1.0f - b; w1 = b - g; w2 = g - r; w3 = r;
+                }
+              else if (b >= r)
+                {
+                  c1 = c000 + stride_g;
+                  c2 = c1   + stride_b;
+                  w0 = 1.0f - g; w1 = g - b; w2 = b - r; w3 = r;
+                }
+              else
+                {
+                  c1 = c000 + stride_g;
+                  c2 = c1   + stride_r;
+                  w0 = 1.0f - g; w1 = g - r; w2 = r - b; w3 = b;
+                }
+            }
 
-      cmsDoTransform (lcms->transform, data, data, iter->length);
+          for (i = 0; i < 3; i++)
+            data[i] = w0 * c000[i] + w1 * c1[i] + w2 * c2[i] + w3 * c111[i];
+
+          data += 4;
+        }
     }
 }
 
+static gfloat *
+cdisplay_lcms_create_lut (cmsHTRANSFORM transform)
+{
+  gfloat *lut;
+  gfloat *row;
+  gint    r, g, b;
+
+  lut = g_new (gfloat, LUT_SIZE * LUT_SIZE * LUT_SIZE * 3);
+  row = g_new (gfloat, LUT_SIZE * 4);
+
+  /*  run the transform once over the whole grid, so that rendering
+   *  never has to call into lcms
+   */
+  for (r = 0; r < LUT_SIZE; r++)
+    {
+      for (g = 0; g < LUT_SIZE; g++)
+        {
+          gfloat *dest = lut + (r * LUT_SIZE + g) * LUT_SIZE * 3;
+
+          for (b = 0; b < LUT_SIZE; b++)
+            {
+              row[b * 4 + 0] = (gfloat) r / (LUT_SIZE - 1);
+              row[b * 4 + 1] = (gfloat) g / (LUT_SIZE - 1);
+              row[b * 4 + 2] = (gfloat) b / (LUT_SIZE - 1);
+              row[b * 4 + 3] = 1.0f;
+            }
+
+          cmsDoTransform (transform, row, row, LUT_SIZE);
+
+          for (b = 0; b < LUT_SIZE; b++)
+            {
+              dest[b * 3 + 0] = row[b * 4 + 0];
+              dest[b * 3 + 1] = row[b * 4 + 1];
+              dest[b * 3 + 2] = row[b * 4 + 2];
+            }
+        }
+    }
+
+  g_free (row);
+
+  return lut;
+}
+
 static void
 cdisplay_lcms_changed (GimpColorDisplay *display)
 {
@@ -278,12 +407,13 @@ cdisplay_lcms_changed (GimpColorDisplay *display)
   cmsHPROFILE      src_profile   = NULL;
   cmsHPROFILE      dest_profile  = NULL;
   cmsHPROFILE      proof_profile = NULL;
+  cmsHTRANSFORM    transform     = NULL;
   cmsUInt16Number  alarmCodes[cmsMAXCHANNELS] = { 0, };
 
-  if (lcms->transform)
+  if (lcms->lut)
     {
-      cmsDeleteTransform (lcms->transform);
-      lcms->transform = NULL;
+      g_free (lcms->lut);
+      lcms->lut = NULL;
     }
 
   if (! config)
@@ -336,12 +466,12 @@ cdisplay_lcms_changed (GimpColorDisplay *display)
           cmsSetAlarmCodes (alarmCodes);
         }
 
-      lcms->transform = cmsCreateProofingTransform (src_profile,  TYPE_RGBA_FLT,
-                                                    dest_profile, TYPE_RGBA_FLT,
-                                                    proof_profile,
-                                                    config->simulation_intent,
-                                                    config->display_intent,
-                                                    softproof_flags);
+      transform = cmsCreateProofingTransform (src_profile,  TYPE_RGBA_FLT,
+                                              dest_profile, TYPE_RGBA_FLT,
+                                              proof_profile,
+                                              config->simulation_intent,
+                                              config->display_intent,
+                                              softproof_flags);
       cmsCloseProfile (proof_profile);
     }
   else if (src_profile || dest_profile)
@@ -359,10 +489,17 @@ cdisplay_lcms_changed (GimpColorDisplay *display)
           display_flags |= cmsFLAGS_BLACKPOINTCOMPENSATION;
         }
 
-      lcms->transform = cmsCreateTransform (src_profile,  TYPE_RGBA_FLT,
-                                            dest_profile, TYPE_RGBA_FLT,
-                                            config->display_intent,
-                                            display_flags);
+      transform = cmsCreateTransform (src_profile,  TYPE_RGBA_FLT,
+                                      dest_profile, TYPE_RGBA_FLT,
+                                      config->display_intent,
+                                      display_flags);
+    }
+
+  if (transform)
+    {
+      lcms->lut = cdisplay_lcms_create_lut (transform);
+
+      cmsDeleteTransform (transform);
     }
 
   if (dest_profile)
@@ -566,7 +566,9 @@ align_layers_perform_alignment (gint      *layers,
           break;
         }
 
-      gimp_layer_set_offsets (layers[index], x, y);
+      /* don't push undo steps and updates for layers staying in place */
+      if (x != orig_x || y != orig_y)
+        gimp_layer_set_offsets (layers[index], x, y);
     }
 }
 
@@ -42,6 +42,9 @@
 #define REMOVE_BACKDROP_PROC "plug-in-animation-remove-backdrop"
 #define FIND_BACKDROP_PROC   "plug-in-animation-find-backdrop"
 
+#define MAX_THREADS          16
+#define CHUNK_ROWS           16
+
 
 typedef enum
 {
@@ -60,6 +63,53 @@ typedef enum
 } operatingMode;
 
 
+/* A source layer, with everything compose_rows() needs to know about
+ * it, so it doesn't have to be asked for again for every row.
+ */
+typedef struct
+{
+  GeglBuffer *buffer;
+  const Babl *format;
+  gint        x, y;
+  gint        width, height;
+  gint        bpp;
+  gboolean    has_alpha;
+} FrameLayer;
+
+/* A bounding box, with inclusive right and bottom edges, and whether
+ * the frame can be combined with the previous one.
+ */
+typedef struct
+{
+  gint     left, top, right, bottom;
+  gboolean can_combine;
+} FrameBox;
+
+typedef struct _RowsJob RowsJob;
+
+typedef void (* RowsFunc) (RowsJob  *job,
+                           gint      row,
+                           FrameBox *box);
+
+struct _RowsJob
+{
+  RowsFunc      func;
+  guchar       *this_frame;
+  const guchar *last_frame;
+  const guchar *back_frame;
+  guchar       *opti_frame;
+  gint          left, right;   /* of the rows compress_row() works on */
+  gint          next_row;
+  gint          last_row;
+};
+
+typedef struct
+{
+  RowsJob  *job;
+  FrameBox  box;
+} RowsThread;
+
+
 /* Declare local functions. */
 static  void query (void);
 static  void run   (const gchar      *name,
@@ -71,6 +121,18 @@ static  void run   (const gchar      *name,
 static  gint32      do_optimizations    (GimpRunMode  run_mode,
                                          gboolean     diff_only);
 
+static  const Babl *get_layer_format    (gint32       layer_id);
+static  void        compose_rows        (FrameLayer  *layer,
+                                         DisposeType  dispose,
+                                         gint         first_row,
+                                         gint         n_rows,
+                                         guchar      *dest);
+static  void        run_rows            (RowsJob     *job,
+                                         RowsFunc     func,
+                                         gint         first_row,
+                                         gint         last_row,
+                                         FrameBox    *box);
+
 /* tag util functions*/
 static  gint        parse_ms_tag        (const gchar *str);
 static  DisposeType parse_disposal_tag  (const gchar *str);
@@ -103,7 +165,7 @@ static  gint32            image_id;
 static  gint32            new_image_id;
 static  gint32            total_frames;
 static  gint32           *layers;
-static  GimpDrawable     *drawable;
+static  FrameLayer       *frame_layers;
 static  GimpImageBaseType imagetype;
 static  GimpImageType     drawabletype_alpha;
 static  guchar            pixelstep;
@@ -240,6 +302,7 @@ run (const gchar      *name,
   run_mode = param[0].data.d_int32;
 
   INIT_I18N ();
+  gegl_init (NULL, NULL);
 
   if (run_mode == GIMP_RUN_NONINTERACTIVE && n_params != 3)
     {
@@ -279,6 +342,8 @@ run (const gchar      *name,
 
   values[1].type         = GIMP_PDB_IMAGE;
   values[1].data.d_image = new_image_id;
+
+  gegl_exit ();
 }
 
 
@@ -297,96 +362,352 @@ total_alpha (guchar  *imdata,
 }
 
 
+static const Babl *
+get_layer_format (gint32 layer_id)
+{
+  /* indexed layers are read as their raw indices */
+  if (gimp_drawable_is_indexed (layer_id))
+    return gimp_drawable_get_format (layer_id);
+
+  if (gimp_drawable_is_rgb (layer_id))
+    {
+      if (gimp_drawable_has_alpha (layer_id))
+        return babl_format ("R'G'B'A u8");
+      else
+        return babl_format ("R'G'B' u8");
+    }
+  else
+    {
+      if (gimp_drawable_has_alpha (layer_id))
+        return babl_format ("Y'A u8");
+      else
+        return babl_format ("Y' u8");
+    }
+}
+
+
+/* Composes rows first_row .. first_row + n_rows - 1 of a frame onto
+ * the rows in dest, which are as wide as the image.
+ */
 static void
-compose_row (gint          frame_num,
-             DisposeType   dispose,
-             gint          row_num,
-             guchar       *dest,
-             gint          dest_width,
-             GimpDrawable *drawable,
-             gboolean      cleanup)
+compose_rows (FrameLayer  *layer,
+              DisposeType  dispose,
+              gint         first_row,
+              gint         n_rows,
+              guchar      *dest)
 {
-  static guchar *line_buf = NULL;
-  guchar        *srcptr;
-  GimpPixelRgn   pixel_rgn;
-  gint           rawx, rawy, rawbpp, rawwidth, rawheight;
-  gint           i;
-  gboolean       has_alpha;
+  guchar *buf;
+  guchar *srcptr;
+  gint    y1, y2;
+  gint    row, i;
 
-  if (cleanup)
+  if (dispose == DISPOSE_REPLACE)
+    {
+      total_alpha (dest, width * n_rows, pixelstep);
+    }
+
+  y1 = MAX (first_row, layer->y);
+  y2 = MIN (first_row + n_rows, layer->y + layer->height);
+
+  /* this frame has nothing to give us for these rows; return */
+  if (y1 >= y2)
+    return;
+
+  buf = g_malloc ((gsize) layer->width * (y2 - y1) * layer->bpp);
+
+  gegl_buffer_get (layer->buffer,
+                   GEGL_RECTANGLE (0, y1 - layer->y, layer->width, y2 - y1),
+                   1.0, layer->format, buf,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  /* render... */
+
+  srcptr = buf;
+
+  for (row = y1; row < y2; row++)
     {
-      if (line_buf)
+      guchar *destrow = dest + (gsize) (row - first_row) * width * pixelstep;
+
+      for (i = layer->x; i < layer->width + layer->x; i++)
         {
-          g_free (line_buf);
-          line_buf = NULL;
+          if (i >= 0 && i < width)
+            {
+              if ((! layer->has_alpha) || (srcptr[layer->bpp - 1] & 128))
+                {
+                  gint pi;
+
+                  for (pi = 0; pi < pixelstep - 1; pi++)
+                    {
+                      destrow[i * pixelstep + pi] = srcptr[pi];
+                    }
+                  destrow[i * pixelstep + pixelstep - 1] = 255;
+                }
+            }
+
+          srcptr += layer->bpp;
         }
+    }
 
-      return;
+  g_free (buf);
+}
+
+
+static void
+frame_box_init (FrameBox *box)
+{
+  box->left        = width;
+  box->top         = height;
+  box->right       = 0;
+  box->bottom      = 0;
+  box->can_combine = TRUE;
+}
+
+static void
+frame_box_add (FrameBox *box,
+               gint      x,
+               gint      y)
+{
+  if (x < box->left)   box->left   = x;
+  if (x > box->right)  box->right  = x;
+  if (y < box->top)    box->top    = y;
+  if (y > box->bottom) box->bottom = y;
+}
+
+
+/* Makes the pixels of 'this' frame which are the same as in the
+ * backdrop transparent.
+ */
+static void
+foreground_row (RowsJob  *job,
+                gint      row,
+                FrameBox *box)
+{
+  guchar       *this_row = job->this_frame + (gsize) row * width * pixelstep;
+  const guchar *back_row = job->back_frame + (gsize) row * width * pixelstep;
+  gint          x;
+
+  for (x = 0; x < width; x++)
+    {
+      if (! memcmp (this_row + x * pixelstep, back_row + x * pixelstep,
+                    pixelstep - 1))
+        {
+          this_row[x * pixelstep + pixelstep - 1] = 0;
+        }
     }
+}
 
-  if (dispose == DISPOSE_REPLACE)
+
+/* Finds the pixels which have to be kept in the optimized frame, and
+ * makes all other pixels transparent in it.
+ */
+static void
+diff_row (RowsJob  *job,
+          gint      row,
+          FrameBox *box)
+{
+  const guchar *this_row = job->this_frame + (gsize) row * width * pixelstep;
+  const guchar *last_row = job->last_frame + (gsize) row * width * pixelstep;
+  guchar       *opti_row = job->opti_frame + (gsize) row * width * pixelstep;
+  gint          alpha    = pixelstep - 1;
+  gint          x;
+
+  /* Nothing changed in this row, drop all of it */
+  if (! memcmp (this_row, last_row, width * pixelstep))
     {
-      total_alpha (dest, dest_width, pixelstep);
+      for (x = 0; x < width; x++)
+        opti_row[x * pixelstep + alpha] = 0;
+
+      return;
     }
 
-  gimp_drawable_offsets (drawable->drawable_id,
-                         &rawx,
-                         &rawy);
+  for (x = 0; x < width; x++)
+    {
+      const guchar *this_pix = this_row + x * pixelstep;
+      const guchar *last_pix = last_row + x * pixelstep;
+      gboolean      keep_pix;
 
-  rawheight = gimp_drawable_height (drawable->drawable_id);
+      if (! (this_pix[alpha] & 128))
+        {
+          /* If just 'this' is transparent, an opaque pixel became
+           * transparent, and the frame can't be combined.
+           */
+          keep_pix = (last_pix[alpha] & 128) != 0;
+
+          if (keep_pix)
+            box->can_combine = FALSE;
+        }
+      else if (! (last_pix[alpha] & 128))
+        {
+          /* just 'last' is transparent */
+          keep_pix = TRUE;
+        }
+      else
+        {
+          /* If 'last' and 'this' are opaque, we only have to keep
+           * the pixel if they're different colors.
+           */
+          keep_pix = memcmp (this_pix, last_pix, alpha) != 0;
+        }
+
+      if (keep_pix)
+        {
+          frame_box_add (box, x, row);
+        }
+      else
+        {
+          /* pixel didn't change this frame - make
+           *  it transparent in our optimized buffer!
+           */
+          opti_row[x * pixelstep + alpha] = 0;
+        }
+    }
+}
 
-  /* this frame has nothing to give us for this row; return */
-  if (row_num >= rawheight + rawy ||
-      row_num < rawy)
-    return;
 
-  rawbpp = gimp_drawable_bpp (drawable->drawable_id);
-  rawwidth = gimp_drawable_width (drawable->drawable_id);
-  has_alpha = gimp_drawable_has_alpha (drawable->drawable_id);
+/* Finds the opaque pixels of 'this' frame, which all have to be kept
+ * if it can't be combined with the previous one.
+ */
+static void
+opaque_row (RowsJob  *job,
+            gint      row,
+            FrameBox *box)
+{
+  const guchar *this_row = job->this_frame + (gsize) row * width * pixelstep;
+  gint          x;
 
-  if (line_buf)
+  for (x = 0; x < width; x++)
     {
-      g_free (line_buf);
-      line_buf = NULL;
+      if (this_row[x * pixelstep + pixelstep - 1] & 128)
+        frame_box_add (box, x, row);
     }
-  line_buf = g_malloc (rawwidth * rawbpp);
+}
 
-  /* Initialise and fetch the raw new frame row */
 
-  gimp_pixel_rgn_init (&pixel_rgn,
-                       drawable,
-                       0, row_num - rawy,
-                       rawwidth, 1,
-                       FALSE,
-                       FALSE);
-  gimp_pixel_rgn_get_rect (&pixel_rgn,
-                           line_buf,
-                           0, row_num - rawy,
-                           rawwidth, 1);
+/* Try to optimize the pixel data for RLE or LZW compression
+ * by making some transparent pixels non-transparent if they
+ * would have the same color as the adjacent pixels.  This
+ * gives a better compression if the algorithm compresses
+ * the image line by line.
+ * See: http://bugzilla.gnome.org/show_bug.cgi?id=66367
+ * It may not be very efficient to add two additional passes
+ * over the pixels, but this hopefully makes the code easier
+ * to maintain and less error-prone.
+ */
+static void
+compress_row (RowsJob  *job,
+              gint      row,
+              FrameBox *box)
+{
+  const guchar *last_row = job->last_frame + (gsize) row * width * pixelstep;
+  guchar       *opti_row = job->opti_frame + (gsize) row * width * pixelstep;
+  gint          alpha    = pixelstep - 1;
+  gint          xit;
 
-  /* render... */
+  /* Compare with previous pixels from left to right */
+  for (xit = job->left + 1; xit < job->right; xit++)
+    {
+      guchar       *pix  = opti_row + xit * pixelstep;
+      const guchar *last = last_row + xit * pixelstep;
 
-  srcptr = line_buf;
+      if (! (pix[alpha] & 128)              &&
+          (pix[alpha - pixelstep] & 128)    &&
+          (last[alpha] & 128)               &&
+          ! memcmp (pix - pixelstep, last, alpha))
+        {
+          /* copy the color and alpha */
+          memcpy (pix, last, pixelstep);
+        }
+    }
 
-  for (i=rawx; i<rawwidth+rawx; i++)
+  /* Compare with next pixels from right to left */
+  for (xit = job->right - 2; xit >= job->left; xit--)
     {
-      if (i>=0 && i<dest_width)
-        {
-          if ((!has_alpha) || ((*(srcptr+rawbpp-1))&128))
-            {
-              gint pi;
+      guchar       *pix  = opti_row + xit * pixelstep;
+      const guchar *last = last_row + xit * pixelstep;
 
-              for (pi = 0; pi < pixelstep-1; pi++)
-                {
-                  dest[i*pixelstep +pi] = *(srcptr + pi);
-                }
-              dest[i*pixelstep + pixelstep - 1] = 255;
-            }
+      if (! (pix[alpha] & 128)              &&
+          (pix[alpha + pixelstep] & 128)    &&
+          (last[alpha] & 128)               &&
+          ! memcmp (pix + pixelstep, last, alpha))
+        {
+          /* copy the color and alpha */
+          memcpy (pix, last, pixelstep);
         }
+    }
+}
+
+
+static gpointer
+rows_thread (RowsThread *thread)
+{
+  RowsJob *job = thread->job;
+  gint     first;
+
+  while ((first = g_atomic_int_add (&job->next_row, CHUNK_ROWS)) <
+         job->last_row)
+    {
+      gint last = MIN (first + CHUNK_ROWS, job->last_row);
+      gint row;
+
+      for (row = first; row < last; row++)
+        job->func (job, row, &thread->box);
+    }
+
+  return NULL;
+}
 
-      srcptr += rawbpp;
+/* Runs func on the rows first_row .. last_row - 1 on all processors.
+ * Rows don't depend on each other, so they can be done in any order;
+ * the boxes the threads find are merged into box, if it is not NULL.
+ */
+static void
+run_rows (RowsJob  *job,
+          RowsFunc  func,
+          gint      first_row,
+          gint      last_row,
+          FrameBox *box)
+{
+  RowsThread  threads[MAX_THREADS];
+  GThread    *ids[MAX_THREADS];
+  gint        n_threads;
+  gint        i;
+
+  n_threads = CLAMP (g_get_num_processors (), 1, MAX_THREADS);
+
+  job->func     = func;
+  job->next_row = first_row;
+  job->last_row = last_row;
+
+  for (i = 0; i < n_threads; i++)
+    {
+      threads[i].job = job;
+      frame_box_init (&threads[i].box);
     }
 
+  for (i = 1; i < n_threads; i++)
+    ids[i] = g_thread_new ("animation-optimize",
+                           (GThreadFunc) rows_thread, &threads[i]);
+
+  rows_thread (&threads[0]);
+
+  for (i = 1; i < n_threads; i++)
+    g_thread_join (ids[i]);
+
+  if (box)
+    {
+      frame_box_init (box);
+
+      for (i = 0; i < n_threads; i++)
+        {
+          box->left   = MIN (box->left,   threads[i].box.left);
+          box->top    = MIN (box->top,    threads[i].box.top);
+          box->right  = MAX (box->right,  threads[i].box.right);
+          box->bottom = MAX (box->bottom, threads[i].box.bottom);
+
+          if (! threads[i].box.can_combine)
+            box->can_combine = FALSE;
+        }
+    }
 }
 
 
@@ -394,8 +715,7 @@ static gint32
 do_optimizations (GimpRunMode run_mode,
                   gboolean    diff_only)
 {
-  GimpPixelRgn   pixel_rgn;
-  static guchar *rawframe = NULL;
+  GeglBuffer    *buffer;
   guchar        *srcptr;
   guchar        *destptr;
   gint           row, this_frame_num;
@@ -406,6 +726,8 @@ do_optimizations (GimpRunMode run_mode,
   guchar        *last_frame = NULL;
   guchar        *opti_frame = NULL;
   guchar        *back_frame = NULL;
+  RowsJob        job;
+  FrameBox       box;
 
   gint           this_delay;
   gint           cumulated_delay = 0;
@@ -418,7 +740,6 @@ do_optimizations (GimpRunMode run_mode,
   gboolean       can_combine;
 
   gint32         bbox_top, bbox_bottom, bbox_left, bbox_right;
-  gint32         rbox_top, rbox_bottom, rbox_left, rbox_right;
 
   switch (opmode)
     {
@@ -443,14 +764,38 @@ do_optimizations (GimpRunMode run_mode,
   imagetype = gimp_image_base_type (image_id);
   pixelstep = (imagetype == GIMP_RGB) ? 4 : 2;
 
-  /*  gimp_tile_cache_ntiles(total_frames * (width / gimp_tile_width() + 1) );*/
-
-
   drawabletype_alpha = (imagetype == GIMP_RGB) ? GIMP_RGBA_IMAGE :
     ((imagetype == GIMP_INDEXED) ? GIMP_INDEXEDA_IMAGE : GIMP_GRAYA_IMAGE);
 
   frame_sizebytes = width * height * pixelstep;
 
+  /* Look up the frames' layers once, and read them through their
+   * buffers, frame 0 being the bottom layer.
+   */
+  frame_layers = g_new0 (FrameLayer, total_frames);
+
+  for (this_frame_num = 0; this_frame_num < total_frames; this_frame_num++)
+    {
+      FrameLayer *layer    = &frame_layers[this_frame_num];
+      gint32      layer_id = layers[total_frames - (this_frame_num + 1)];
+
+      layer->width  = gimp_drawable_width (layer_id);
+      layer->height = gimp_drawable_height (layer_id);
+
+      /* Image has been closed/etc since we got the layer list? */
+      if (layer->width == 0)
+        {
+          gimp_quit ();
+        }
+
+      gimp_drawable_offsets (layer_id, &layer->x, &layer->y);
+
+      layer->buffer    = gimp_drawable_get_buffer (layer_id);
+      layer->format    = get_layer_format (layer_id);
+      layer->bpp       = babl_format_get_bytes_per_pixel (layer->format);
+      layer->has_alpha = gimp_drawable_has_alpha (layer_id);
+    }
+
   this_frame = g_malloc (frame_sizebytes);
   last_frame = g_malloc (frame_sizebytes);
   opti_frame = g_malloc (frame_sizebytes);
@@ -462,6 +807,11 @@ do_optimizations (GimpRunMode run_mode,
   total_alpha (this_frame, width*height, pixelstep);
   total_alpha (last_frame, width*height, pixelstep);
 
+  job.this_frame = this_frame;
+  job.last_frame = last_frame;
+  job.back_frame = back_frame;
+  job.opti_frame = opti_frame;
+
   new_image_id = gimp_image_new(width, height, imagetype);
   gimp_image_undo_disable (new_image_id);
 
@@ -510,21 +860,12 @@ do_optimizations (GimpRunMode run_mode,
 
           for (this_frame_num=0; this_frame_num<total_frames; this_frame_num++)
             {
-              drawable =
-                gimp_drawable_get (layers[total_frames-(this_frame_num+1)]);
-
               dispose = get_frame_disposal (this_frame_num);
 
-              compose_row(this_frame_num,
-                          dispose,
-                          row,
-                          these_rows[this_frame_num],
-                          width,
-                          drawable,
-                          FALSE
-                          );
-
-              gimp_drawable_detach(drawable);
+              compose_rows (&frame_layers[this_frame_num],
+                            dispose,
+                            row, 1,
+                            these_rows[this_frame_num]);
             }
 
           for (this_frame_num=0; this_frame_num<total_frames; this_frame_num++)
@@ -646,17 +987,13 @@ do_optimizations (GimpRunMode run_mode,
 
       gimp_image_insert_layer (new_image_id, new_layer_id, -1, 0);
 
-      drawable = gimp_drawable_get (new_layer_id);
-
-      gimp_pixel_rgn_init (&pixel_rgn, drawable,
-                           0, 0,
-                           width, height,
-                           TRUE, FALSE);
-      gimp_pixel_rgn_set_rect (&pixel_rgn, back_frame,
-                               0, 0,
-                               width, height);
-      gimp_drawable_flush (drawable);
-      gimp_drawable_detach (drawable);
+      buffer = gimp_drawable_get_buffer (new_layer_id);
+
+      gegl_buffer_set (buffer, GEGL_RECTANGLE (0, 0, width, height), 0,
+                       get_layer_format (new_layer_id), back_frame,
+                       GEGL_AUTO_ROWSTRIDE);
+
+      g_object_unref (buffer);
     }
   else
     {
@@ -666,60 +1003,17 @@ do_optimizations (GimpRunMode run_mode,
            * BUILD THIS FRAME into our 'this_frame' buffer.
            */
 
-          drawable =
-            gimp_drawable_get (layers[total_frames-(this_frame_num+1)]);
-
-          /* Image has been closed/etc since we got the layer list? */
-          /* FIXME - How do we tell if a gimp_drawable_get() fails? */
-          if (gimp_drawable_width (drawable->drawable_id) == 0)
-            {
-              gimp_quit ();
-            }
-
           this_delay = get_frame_duration (this_frame_num);
           dispose    = get_frame_disposal (this_frame_num);
 
-          for (row = 0; row < height; row++)
-            {
-              compose_row (this_frame_num,
-                           dispose,
-                           row,
-                           &this_frame[pixelstep*width * row],
-                           width,
-                           drawable,
-                           FALSE
-                           );
-            }
-
-          /* clean up */
-          gimp_drawable_detach(drawable);
-
+          compose_rows (&frame_layers[this_frame_num],
+                        dispose,
+                        0, height,
+                        this_frame);
 
           if (opmode == OPFOREGROUND)
             {
-              gint xit, yit, byteit;
-
-              for (yit=0; yit<height; yit++)
-                {
-                  for (xit=0; xit<width; xit++)
-                    {
-                      for (byteit=0; byteit<pixelstep-1; byteit++)
-                        {
-                          if (back_frame[yit*width*pixelstep + xit*pixelstep
-                                        + byteit]
-                              !=
-                              this_frame[yit*width*pixelstep + xit*pixelstep
-                                        + byteit])
-                            {
-                              goto enough;
-                            }
-                        }
-                      this_frame[yit*width*pixelstep + xit*pixelstep
-                                + pixelstep - 1] = 0;
-                    enough:
-                      /* nop */;
-                    }
-                }
+              run_rows (&job, foreground_row, 0, height, NULL);
             }
 
           can_combine = FALSE;
@@ -727,10 +1021,6 @@ do_optimizations (GimpRunMode run_mode,
           bbox_top    = 0;
           bbox_right  = width;
           bbox_bottom = height;
-          rbox_left   = 0;
-          rbox_top    = 0;
-          rbox_right  = width;
-          rbox_bottom = height;
 
           /* copy 'this' frame into a buffer which we can safely molest */
           memcpy (opti_frame, this_frame, frame_sizebytes);
@@ -744,216 +1034,33 @@ do_optimizations (GimpRunMode run_mode,
               && (opmode == OPOPTIMIZE)
               )
             {
-              gint xit, yit, byteit;
-
-              can_combine = TRUE;
+              gint yit;
 
               /*
                * SEARCH FOR BOUNDING BOX
                */
-              bbox_left   = width;
-              bbox_top    = height;
-              bbox_right  = 0;
-              bbox_bottom = 0;
-              rbox_left   = width;
-              rbox_top    = height;
-              rbox_right  = 0;
-              rbox_bottom = 0;
-
-              for (yit=0; yit<height; yit++)
-                {
-                  for (xit=0; xit<width; xit++)
-                    {
-                      gboolean keep_pix;
-                      gboolean opaq_pix;
-
-                      /* Check if 'this' and 'last' are transparent */
-                      if (!(this_frame[yit*width*pixelstep + xit*pixelstep
-                                      + pixelstep-1]&128)
-                          &&
-                          !(last_frame[yit*width*pixelstep + xit*pixelstep
-                                      + pixelstep-1]&128))
-                        {
-                          keep_pix = FALSE;
-                          opaq_pix = FALSE;
-                          goto decided;
-                        }
-                      /* Check if just 'this' is transparent */
-                      if ((last_frame[yit*width*pixelstep + xit*pixelstep
-                                     + pixelstep-1]&128)
-                          &&
-                          !(this_frame[yit*width*pixelstep + xit*pixelstep
-                                      + pixelstep-1]&128))
-                        {
-                          keep_pix = TRUE;
-                          opaq_pix = FALSE;
-                          can_combine = FALSE;
-                          goto decided;
-                        }
-                      /* Check if just 'last' is transparent */
-                      if (!(last_frame[yit*width*pixelstep + xit*pixelstep
-                                      + pixelstep-1]&128)
-                          &&
-                          (this_frame[yit*width*pixelstep + xit*pixelstep
-                                     + pixelstep-1]&128))
-                        {
-                          keep_pix = TRUE;
-                          opaq_pix = TRUE;
-                          goto decided;
-                        }
-                      /* If 'last' and 'this' are opaque, we have
-                       *  to check if they're the same color - we
-                       *  only have to keep the pixel if 'last' or
-                       *  'this' are opaque and different.
-                       */
-                      keep_pix = FALSE;
-                      opaq_pix = TRUE;
-                      for (byteit=0; byteit<pixelstep-1; byteit++)
-                        {
-                          if ((last_frame[yit*width*pixelstep + xit*pixelstep
-                                         + byteit]
-                               !=
-                               this_frame[yit*width*pixelstep + xit*pixelstep
-                                         + byteit])
-                              )
-                            {
-                              keep_pix = TRUE;
-                              goto decided;
-                            }
-                        }
-                    decided:
-                      if (opaq_pix)
-                        {
-                          if (xit<rbox_left) rbox_left=xit;
-                          if (xit>rbox_right) rbox_right=xit;
-                          if (yit<rbox_top) rbox_top=yit;
-                          if (yit>rbox_bottom) rbox_bottom=yit;
-                        }
-                      if (keep_pix)
-                        {
-                          if (xit<bbox_left) bbox_left=xit;
-                          if (xit>bbox_right) bbox_right=xit;
-                          if (yit<bbox_top) bbox_top=yit;
-                          if (yit>bbox_bottom) bbox_bottom=yit;
-                        }
-                      else
-                        {
-                          /* pixel didn't change this frame - make
-                           *  it transparent in our optimized buffer!
-                           */
-                          opti_frame[yit*width*pixelstep + xit*pixelstep
-                                    + pixelstep-1] = 0;
-                        }
-                    } /* xit */
-                } /* yit */
+              run_rows (&job, diff_row, 0, height, &box);
 
-              if (!can_combine)
-                {
-                  bbox_left = rbox_left;
-                  bbox_top = rbox_top;
-                  bbox_right = rbox_right;
-                  bbox_bottom = rbox_bottom;
-                }
+              can_combine = box.can_combine;
+
+              /* an opaque pixel became transparent, so all opaque
+               * pixels of this frame have to be kept
+               */
+              if (! can_combine)
+                run_rows (&job, opaque_row, 0, height, &box);
 
-              bbox_right++;
-              bbox_bottom++;
+              bbox_left   = box.left;
+              bbox_top    = box.top;
+              bbox_right  = box.right + 1;
+              bbox_bottom = box.bottom + 1;
 
-              if (can_combine && !diff_only)
+              if (can_combine && !diff_only &&
+                  bbox_right > bbox_left && bbox_bottom > bbox_top)
                 {
-                  /* Try to optimize the pixel data for RLE or LZW compression
-                   * by making some transparent pixels non-transparent if they
-                   * would have the same color as the adjacent pixels.  This
-                   * gives a better compression if the algorithm compresses
-                   * the image line by line.
-                   * See: http://bugzilla.gnome.org/show_bug.cgi?id=66367
-                   * It may not be very efficient to add two additional passes
-                   * over the pixels, but this hopefully makes the code easier
-                   * to maintain and less error-prone.
-                   */
-                  for (yit = bbox_top; yit < bbox_bottom; yit++)
-                    {
-                      /* Compare with previous pixels from left to right */
-                      for (xit = bbox_left + 1; xit < bbox_right; xit++)
-                        {
-                          if (!(opti_frame[yit*width*pixelstep
-                                           + xit*pixelstep
-                                           + pixelstep-1]&128)
-                              && (opti_frame[yit*width*pixelstep
-                                             + (xit-1)*pixelstep
-                                             + pixelstep-1]&128)
-                              && (last_frame[yit*width*pixelstep
-                                             + xit*pixelstep
-                                             + pixelstep-1]&128))
-                            {
-                              for (byteit=0; byteit<pixelstep-1; byteit++)
-                                {
-                                  if (opti_frame[yit*width*pixelstep
-                                                 + (xit-1)*pixelstep
-                                                 + byteit]
-                                      !=
-                                      last_frame[yit*width*pixelstep
-                                                 + xit*pixelstep
-                                                 + byteit])
-                                    {
-                                      goto skip_right;
-                                    }
-                                }
-                              /* copy the color and alpha */
-                              for (byteit=0; byteit<pixelstep; byteit++)
-                                {
-                                  opti_frame[yit*width*pixelstep
-                                             + xit*pixelstep
-                                             + byteit]
-                                    = last_frame[yit*width*pixelstep
-                                                 + xit*pixelstep
-                                                 + byteit];
-                                }
-                            }
-                        skip_right:
-                          /* nop */;
-                        } /* xit */
+                  job.left  = bbox_left;
+                  job.right = bbox_right;
 
-                      /* Compare with next pixels from right to left */
-                      for (xit = bbox_right - 2; xit >= bbox_left; xit--)
-                        {
-                          if (!(opti_frame[yit*width*pixelstep
-                                           + xit*pixelstep
-                                           + pixelstep-1]&128)
-                              && (opti_frame[yit*width*pixelstep
-                                             + (xit+1)*pixelstep
-                                             + pixelstep-1]&128)
-                              && (last_frame[yit*width*pixelstep
-                                             + xit*pixelstep
-                                             + pixelstep-1]&128))
-                            {
-                              for (byteit=0; byteit<pixelstep-1; byteit++)
-                                {
-                                  if (opti_frame[yit*width*pixelstep
-                                                 + (xit+1)*pixelstep
-                                                 + byteit]
-                                      !=
-                                      last_frame[yit*width*pixelstep
-                                                 + xit*pixelstep
-                                                 + byteit])
-                                    {
-                                      goto skip_left;
-                                    }
-                                }
-                              /* copy the color and alpha */
-                              for (byteit=0; byteit<pixelstep; byteit++)
-                                {
-                                  opti_frame[yit*width*pixelstep
-                                             + xit*pixelstep
-                                             + byteit]
-                                    = last_frame[yit*width*pixelstep
-                                                 + xit*pixelstep
-                                                 + byteit];
-                                }
-                            }
-                        skip_left:
-                          /* nop */;
-                        } /* xit */
-                    } /* yit */
+                  run_rows (&job, compress_row, bbox_top, bbox_bottom, NULL);
                 }
 
               /*
@@ -974,14 +1081,11 @@ do_optimizations (GimpRunMode run_mode,
                 srcptr = this_frame;
               for (yit=bbox_top; yit<bbox_bottom; yit++)
                 {
-                  for (xit=bbox_left; xit<bbox_right; xit++)
-                    {
-                      for (byteit=0; byteit<pixelstep; byteit++)
-                        {
-                          *(destptr++) = srcptr[yit*pixelstep*width +
-                                               pixelstep*xit + byteit];
-                        }
-                    }
+                  memmove (destptr,
+                           srcptr + (yit * width + bbox_left) * pixelstep,
+                           (bbox_right - bbox_left) * pixelstep);
+
+                  destptr += (bbox_right - bbox_left) * pixelstep;
                 }
             } /* !bot frame? */
           else
@@ -1070,17 +1174,16 @@ do_optimizations (GimpRunMode run_mode,
 
               gimp_image_insert_layer (new_image_id, new_layer_id, -1, 0);
 
-              drawable = gimp_drawable_get (new_layer_id);
-
-              gimp_pixel_rgn_init (&pixel_rgn, drawable, 0, 0,
-                                   bbox_right-bbox_left,
-                                   bbox_bottom-bbox_top,
-                                   TRUE, FALSE);
-              gimp_pixel_rgn_set_rect (&pixel_rgn, opti_frame, 0, 0,
-                                       bbox_right-bbox_left,
-                                       bbox_bottom-bbox_top);
-              gimp_drawable_flush (drawable);
-              gimp_drawable_detach (drawable);
+              buffer = gimp_drawable_get_buffer (new_layer_id);
+
+              gegl_buffer_set (buffer,
+                               GEGL_RECTANGLE (0, 0,
+                                               bbox_right - bbox_left,
+                                               bbox_bottom - bbox_top), 0,
+                               get_layer_format (new_layer_id), opti_frame,
+                               GEGL_AUTO_ROWSTRIDE);
+
+              g_object_unref (buffer);
               gimp_layer_translate (new_layer_id, bbox_left, bbox_top);
             }
 
@@ -1095,8 +1198,11 @@ do_optimizations (GimpRunMode run_mode,
   if (run_mode != GIMP_RUN_NONINTERACTIVE)
     gimp_display_new (new_image_id);
 
-  g_free (rawframe);
-  rawframe = NULL;
+  for (this_frame_num = 0; this_frame_num < total_frames; this_frame_num++)
+    g_object_unref (frame_layers[this_frame_num].buffer);
+
+  g_free (frame_layers);
+  frame_layers = NULL;
 
   g_free (last_frame);
   last_frame = NULL;
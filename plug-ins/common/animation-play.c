@@ -46,6 +46,11 @@
 #define PLUG_IN_ROLE   "gimp-animation-play"
 #define DITHERTYPE     GDK_RGB_DITHER_NORMAL
 
+/* Memory used to keep scaled frames around, so that playing doesn't
+ * have to fetch them from the core again on each loop.
+ */
+#define FRAME_CACHE_SIZE (256 * 1024 * 1024)
+
 
 typedef enum
 {
@@ -111,6 +116,9 @@ static gboolean    repaint_da                (GtkWidget       *darea,
                                               gpointer         data);
 
 static void        init_frames               (void);
+static void        frame_cache_clear         (void);
+static guchar    * get_frame                 (gint32           whichframe);
+static gboolean    prefetch_frames           (gpointer         data);
 static void        render_frame              (gint32           whichframe);
 static void        show_frame                (void);
 static void        total_alpha_preview       (void);
@@ -179,6 +187,15 @@ static guchar            *rawframe                  = NULL;
 static guint32           *frame_durations           = NULL;
 static guint              frame_number              = 0;
 
+static guchar           **frame_cache               = NULL;
+static gint32             frame_cache_length        = 0;
+static gsize              frame_cache_used          = 0;
+static guint              frame_cache_width         = 0,
+                          frame_cache_height        = 0;
+static gdouble            frame_cache_scale         = 0.0;
+static gint32             shown_frame               = -1;
+static guint              prefetch_idle             = 0;
+
 static gboolean           playing                   = FALSE;
 static guint              timer                     = 0;
 static gboolean           detached                  = FALSE;
@@ -580,6 +597,9 @@ detach_callback (GtkToggleAction *action)
   else
     gtk_widget_hide (shape_window);
 
+  /* The other drawing area doesn't show the current frame yet. */
+  shown_frame = -1;
+
   render_frame (frame_number);
 }
 
@@ -1013,15 +1033,22 @@ init_frames (void)
       g_free (frames);
       g_free (frame_durations);
     }
+  frame_cache_clear ();
+  g_free (frame_cache);
+  frame_cache_length = 0;
+
   frames = g_try_malloc0_n (total_frames, sizeof (gint32));
   frame_durations = g_try_malloc0_n (total_frames, sizeof (guint32));
-  if (! frames || ! frame_durations)
+  frame_cache = g_try_malloc0_n (total_frames, sizeof (guchar *));
+  if (! frames || ! frame_durations || ! frame_cache)
     {
       gimp_message (_("Memory could not be allocated to the frame container."));
       gtk_main_quit ();
       gimp_quit ();
       return;
     }
+  frame_cache_length = total_frames;
+
   /* We only use RGB images for display because indexed images would somehow
      render terrible colors. Layers from other types will be automatically
      converted. */
@@ -1110,16 +1137,193 @@ initialize (void)
 /* Rendering Functions */
 
 static void
-render_frame (gint32 whichframe)
+frame_cache_clear (void)
+{
+  gint32 i;
+
+  for (i = 0; i < frame_cache_length; i++)
+    {
+      g_free (frame_cache[i]);
+      frame_cache[i] = NULL;
+    }
+
+  frame_cache_used = 0;
+  shown_frame      = -1;
+}
+
+/* Returns the frame scaled to the drawing area, as R'G'B'A u8.  Frames
+ * are kept in the frame cache as long as it has room for them, other
+ * frames are fetched into rawframe, and only valid until the next call.
+ */
+static guchar *
+get_frame (gint32 whichframe)
 {
   GeglBuffer    *buffer;
+  guint          drawing_width, drawing_height;
+  gdouble        drawing_scale;
+  gsize          size;
+  guchar        *data;
+
+  if (detached)
+    {
+      drawing_width = shape_drawing_area_width;
+      drawing_height = shape_drawing_area_height;
+      drawing_scale = shape_scale;
+    }
+  else
+    {
+      drawing_width = drawing_area_width;
+      drawing_height = drawing_area_height;
+      drawing_scale = scale;
+    }
+
+  if (drawing_width  != frame_cache_width  ||
+      drawing_height != frame_cache_height ||
+      drawing_scale  != frame_cache_scale)
+    {
+      frame_cache_clear ();
+
+      frame_cache_width  = drawing_width;
+      frame_cache_height = drawing_height;
+      frame_cache_scale  = drawing_scale;
+    }
+
+  if (frame_cache[whichframe])
+    return frame_cache[whichframe];
+
+  size = (gsize) drawing_width * drawing_height * 4;
+
+  if (frame_cache_used + size <= FRAME_CACHE_SIZE)
+    {
+      data = frame_cache[whichframe] = g_malloc (size);
+      frame_cache_used += size;
+    }
+  else
+    {
+      data = rawframe;
+    }
+
+  buffer = gimp_drawable_get_buffer (frames[whichframe]);
+
+  /* Fetch and scale the whole raw new frame */
+  gegl_buffer_get (buffer, GEGL_RECTANGLE (0, 0, drawing_width, drawing_height),
+                   drawing_scale, babl_format ("R'G'B'A u8"),
+                   data, GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_CLAMP);
+
+  g_object_unref (buffer);
+
+  return data;
+}
+
+/* Fetches the frames which are played next into the frame cache, while
+ * waiting for the next frame to be due.  libgimp can only talk to the
+ * core from the main thread, so this is a low priority idle handler
+ * rather than a thread.
+ */
+static gboolean
+prefetch_frames (gpointer data)
+{
+  gsize  size = (gsize) frame_cache_width * frame_cache_height * 4;
+  gint32 i;
+
+  if (playing && frame_cache_used + size <= FRAME_CACHE_SIZE)
+    {
+      for (i = 1; i < total_frames; i++)
+        {
+          gint32 whichframe = (frame_number + i) % total_frames;
+
+          if (! frame_cache[whichframe])
+            {
+              get_frame (whichframe);
+
+              return TRUE;
+            }
+        }
+    }
+
+  prefetch_idle = 0;
+
+  return FALSE;
+}
+
+static void
+prefetch_start (void)
+{
+  if (! prefetch_idle)
+    prefetch_idle = g_idle_add_full (G_PRIORITY_LOW, prefetch_frames,
+                                     NULL, NULL);
+}
+
+/* Finds the bounding box of the pixels which differ between two frames.
+ * Returns FALSE if the frames are identical.
+ */
+static gboolean
+frame_diff_rect (const guchar *frame1,
+                 const guchar *frame2,
+                 gint          frame_width,
+                 gint          frame_height,
+                 GdkRectangle *rect)
+{
+  gint rowstride = frame_width * 4;
+  gint x1, y1, x2, y2;
+  gint y;
+
+  for (y1 = 0; y1 < frame_height; y1++)
+    if (memcmp (frame1 + y1 * rowstride, frame2 + y1 * rowstride, rowstride))
+      break;
+
+  if (y1 == frame_height)
+    return FALSE;
+
+  for (y2 = frame_height; y2 > y1 + 1; y2--)
+    if (memcmp (frame1 + (y2 - 1) * rowstride,
+                frame2 + (y2 - 1) * rowstride, rowstride))
+      break;
+
+  x1 = frame_width;
+  x2 = 0;
+
+  for (y = y1; y < y2; y++)
+    {
+      const guint32 *row1 = (const guint32 *) (frame1 + y * rowstride);
+      const guint32 *row2 = (const guint32 *) (frame2 + y * rowstride);
+      gint           x;
+
+      for (x = 0; x < x1; x++)
+        if (row1[x] != row2[x])
+          {
+            x1 = x;
+            break;
+          }
+
+      for (x = frame_width - 1; x >= x2; x--)
+        if (row1[x] != row2[x])
+          {
+            x2 = x + 1;
+            break;
+          }
+    }
+
+  rect->x      = x1;
+  rect->y      = y1;
+  rect->width  = x2 - x1;
+  rect->height = y2 - y1;
+
+  return TRUE;
+}
+
+static void
+render_frame (gint32 whichframe)
+{
   gint           i, j, k;
+  guchar        *frame;
   guchar        *srcptr;
   guchar        *destptr;
   GtkWidget     *da;
   guint          drawing_width, drawing_height;
   gdouble        drawing_scale;
   guchar        *preview_data;
+  GdkRectangle   rect;
 
   g_assert (whichframe < total_frames);
 
@@ -1138,43 +1342,66 @@ render_frame (gint32 whichframe)
       drawing_width = drawing_area_width;
       drawing_height = drawing_area_height;
       drawing_scale = scale;
-
-      /* Set "alpha grid" background. */
-      total_alpha_preview ();
     }
 
-  buffer = gimp_drawable_get_buffer (frames[whichframe]);
+  frame = get_frame (whichframe);
 
-  /* Fetch and scale the whole raw new frame */
-  gegl_buffer_get (buffer, GEGL_RECTANGLE (0, 0, drawing_width, drawing_height),
-                   drawing_scale, babl_format ("R'G'B'A u8"),
-                   rawframe, GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_CLAMP);
-
-  /* Number of pixels. */
-  i = drawing_width * drawing_height;
-  destptr = preview_data;
-  srcptr  = rawframe;
-  while (i--)
+  /* Only redraw what changed since the frame which is shown, if we
+   * still have that one.
+   */
+  if (shown_frame >= 0 && frame_cache[shown_frame] &&
+      frame == frame_cache[whichframe])
     {
-      if (! (srcptr[3] & 128))
+      if (! frame_diff_rect (frame_cache[shown_frame], frame,
+                             drawing_width, drawing_height, &rect))
         {
-          srcptr  += 4;
-          destptr += 3;
-          continue;
+          shown_frame = whichframe;
+          return;
         }
+    }
+  else
+    {
+      rect.x      = 0;
+      rect.y      = 0;
+      rect.width  = drawing_width;
+      rect.height = drawing_height;
+    }
+
+  shown_frame = (frame == frame_cache[whichframe]) ? whichframe : -1;
+
+  for (j = rect.y; j < rect.y + rect.height; j++)
+    {
+      destptr = preview_data + (j * drawing_width + rect.x) * 3;
+      srcptr  = frame + (j * drawing_width + rect.x) * 4;
+
+      /* Set "alpha grid" background. */
+      if (! detached)
+        memcpy (destptr,
+                ((j & 8) ? preview_alpha1_data : preview_alpha2_data) + rect.x * 3,
+                rect.width * 3);
+
+      for (i = 0; i < rect.width; i++)
+        {
+          if (! (srcptr[3] & 128))
+            {
+              srcptr  += 4;
+              destptr += 3;
+              continue;
+            }
 
-      *(destptr++) = *(srcptr++);
-      *(destptr++) = *(srcptr++);
-      *(destptr++) = *(srcptr++);
+          *(destptr++) = *(srcptr++);
+          *(destptr++) = *(srcptr++);
+          *(destptr++) = *(srcptr++);
 
-      srcptr++;
+          srcptr++;
+        }
     }
 
   /* calculate the shape mask */
   if (detached)
     {
       memset (shape_preview_mask, 0, (drawing_width * drawing_height) / 8 + drawing_height);
-      srcptr = rawframe + 3;
+      srcptr = frame + 3;
 
       for (j = 0; j < drawing_height; j++)
         {
@@ -1191,18 +1418,16 @@ render_frame (gint32 whichframe)
       reshape_from_bitmap (shape_preview_mask);
     }
 
-  /* Display the preview buffer. */
+  /* Display the changed part of the preview buffer. */
   gdk_draw_rgb_image (gtk_widget_get_window (da),
                       (gtk_widget_get_style (da))->white_gc,
-                      (gint) ((drawing_width - drawing_scale * width) / 2),
-                      (gint) ((drawing_height - drawing_scale * height) / 2),
-                      drawing_width, drawing_height,
+                      (gint) ((drawing_width - drawing_scale * width) / 2) + rect.x,
+                      (gint) ((drawing_height - drawing_scale * height) / 2) + rect.y,
+                      rect.width, rect.height,
                       (total_frames == 1 ?
                        GDK_RGB_DITHER_MAX : DITHERTYPE),
-                      preview_data, drawing_width * 3);
-
-  /* clean up */
-  g_object_unref (buffer);
+                      preview_data + (rect.y * drawing_width + rect.x) * 3,
+                      drawing_width * 3);
 }
 
 static void
@@ -1306,6 +1531,12 @@ window_destroy (GtkWidget *widget)
   if (playing)
     remove_timer ();
 
+  if (prefetch_idle)
+    {
+      g_source_remove (prefetch_idle);
+      prefetch_idle = 0;
+    }
+
   if (shape_window)
     gtk_widget_destroy (GTK_WIDGET (shape_window));
 
@@ -1328,6 +1559,8 @@ advance_frame_callback (gpointer data)
   do_step ();
   show_frame ();
 
+  prefetch_start ();
+
   return FALSE;
 }
 
@@ -1346,6 +1579,8 @@ play_callback (GtkToggleAction *action)
                              get_duration_factor (settings.duration_index),
                              advance_frame_callback, NULL);
 
+      prefetch_start ();
+
       gtk_action_set_icon_name (GTK_ACTION (action), "media-playback-pause");
     }
   else
@@ -48,6 +48,9 @@
 #endif
 #endif
 
+#define MAX_THREADS  16
+#define CHUNK_ROWS   16
+
 
 typedef struct
 {
@@ -55,6 +58,20 @@ typedef struct
   gint     maxdelta;
 } BlurValues;
 
+typedef struct
+{
+  const guchar  *src;
+  guchar        *dest;
+  gint           width;
+  gint           height;
+  const gdouble *mat;
+  gint           numrad;
+  gint           bytes;
+  gboolean       has_alpha;
+  gint           maxdelta;
+  gint           next_row;
+} SelGaussJob;
+
 
 /* Declare local functions.
  */
@@ -65,9 +82,21 @@ static void      run              (const gchar      *name,
                                    gint             *nreturn_vals,
                                    GimpParam       **return_vals);
 
-static void      sel_gauss        (GimpDrawable     *drawable,
+static void      sel_gauss        (gint32            drawable_id,
                                    gdouble           radius,
                                    gint              maxdelta);
+static void      sel_gauss_render (const guchar     *src,
+                                   guchar           *dest,
+                                   gint              width,
+                                   gint              height,
+                                   gdouble           radius,
+                                   gint              bytes,
+                                   gboolean          has_alpha,
+                                   gint              maxdelta,
+                                   gboolean          show_progress);
+static gpointer  sel_gauss_thread (SelGaussJob      *job);
+static const Babl *
+                 sel_gauss_format (gint32            drawable_id);
 static gboolean  sel_gauss_dialog (GimpDrawable     *drawable);
 static void      preview_update   (GimpPreview      *preview);
 
@@ -140,13 +169,13 @@ run (const gchar      *name,
   *return_vals  = values;
 
   INIT_I18N ();
+  gegl_init (NULL, NULL);
 
   values[0].type          = GIMP_PDB_STATUS;
   values[0].data.d_status = status;
 
   /* Get the specified drawable */
   drawable = gimp_drawable_get (param[2].data.d_drawable);
-  gimp_tile_cache_ntiles (2 * drawable->ntile_cols);
 
   switch (run_mode)
     {
@@ -197,7 +226,7 @@ run (const gchar      *name,
       radius = fabs (bvals.radius) + 1.0;
 
       /* run the gaussian blur */
-      sel_gauss (drawable, radius, bvals.maxdelta);
+      sel_gauss (drawable->drawable_id, radius, bvals.maxdelta);
 
       /* Store data */
       if (run_mode == GIMP_RUN_INTERACTIVE)
@@ -214,6 +243,8 @@ run (const gchar      *name,
 
   gimp_drawable_detach (drawable);
   values[0].data.d_status = status;
+
+  gegl_exit ();
 }
 
 static gboolean
@@ -330,7 +361,8 @@ matrixmult_mmx (const guchar  *src,
                 gint           bytes,
                 gboolean       has_alpha,
                 gint           maxdelta,
-                gboolean       preview_mode)
+                gint           y1,
+                gint           y2)
 {
   const gint       rowstride = width * bytes;
   const long long  maxdelta4 = maxdelta * 0x0001000100010001ULL;
@@ -356,7 +388,7 @@ matrixmult_mmx (const guchar  *src,
   for (y = numrad; y < numrad + 3; y++)
     imat[numrad + y] = 0;
 
-  for (y = 0; y < height; y++)
+  for (y = y1; y < y2; y++)
     {
       asm volatile (
         "pxor  %%mm7, %%mm7 \n\t":
@@ -567,12 +599,6 @@ matrixmult_mmx (const guchar  *src,
                 }
             }
         }
-
-      if (!(y % 16) && !preview_mode)
-        {
-          asm volatile ("emms");
-          gimp_progress_update ((gdouble) y / (gdouble) height);
-        }
     }
 
   asm volatile ("emms");
@@ -590,7 +616,8 @@ matrixmult_int (const guchar  *src,
                 gint           bytes,
                 gboolean       has_alpha,
                 gint           maxdelta,
-                gboolean       preview_mode)
+                gint           y1,
+                gint           y2)
 {
   const gint  nb        = bytes - (has_alpha ? 1 : 0);
   const gint  rowstride = width * bytes;
@@ -605,7 +632,7 @@ matrixmult_int (const guchar  *src,
 
       if (cpu & (GIMP_CPU_ACCEL_X86_MMXEXT | GIMP_CPU_ACCEL_X86_SSE))
         return matrixmult_mmx (src, dest, width, height, mat, numrad,
-                               bytes, has_alpha, maxdelta, preview_mode);
+                               bytes, has_alpha, maxdelta, y1, y2);
     }
 #endif
 
@@ -620,7 +647,7 @@ matrixmult_int (const guchar  *src,
   for (y = 0; y < numrad; y++)
     imat[numrad - y] = imat[numrad + y] = mat[y] * fscale;
 
-  for (y = 0; y < height; y++)
+  for (y = y1; y < y2; y++)
     {
       for (x = 0; x < width; x++)
         {
@@ -689,9 +716,6 @@ matrixmult_int (const guchar  *src,
                 dest[dix + b] = sum / fact;
             }
         }
-
-      if (!(y % 16) && !preview_mode)
-        gimp_progress_update ((gdouble) y / (gdouble) height);
     }
 }
 
@@ -706,7 +730,8 @@ matrixmult (const guchar  *src,
             gint           bytes,
             gboolean       has_alpha,
             gint           maxdelta,
-            gboolean       preview_mode)
+            gint           y1,
+            gint           y2)
 {
   has_alpha = has_alpha ? 1 : 0;
 
@@ -714,7 +739,7 @@ matrixmult (const guchar  *src,
   if (bytes == BYTES && has_alpha == ALPHA)\
     {\
       matrixmult_int (src, dest, width, height, mat, numrad,\
-                      BYTES, ALPHA, maxdelta, preview_mode);\
+                      BYTES, ALPHA, maxdelta, y1, y2);\
       return;\
     }
 
@@ -726,34 +751,133 @@ matrixmult (const guchar  *src,
 #undef EXPAND
 }
 
+static gpointer
+sel_gauss_thread (SelGaussJob *job)
+{
+  gint row;
+
+  while ((row = g_atomic_int_add (&job->next_row, CHUNK_ROWS)) < job->height)
+    {
+      matrixmult (job->src, job->dest, job->width, job->height,
+                  job->mat, job->numrad,
+                  job->bytes, job->has_alpha, job->maxdelta,
+                  row, MIN (row + CHUNK_ROWS, job->height));
+    }
+
+  return NULL;
+}
+
+/* Blurs @src into @dest.  Every output row only depends on @src, so
+ * chunks of rows are picked up by as many threads as there are
+ * processors.  Progress is only reported from the main thread, for
+ * the chunks it does itself.
+ */
 static void
-sel_gauss (GimpDrawable *drawable,
-           gdouble       radius,
-           gint          maxdelta)
+sel_gauss_render (const guchar *src,
+                  guchar       *dest,
+                  gint          width,
+                  gint          height,
+                  gdouble       radius,
+                  gint          bytes,
+                  gboolean      has_alpha,
+                  gint          maxdelta,
+                  gboolean      show_progress)
 {
-  GimpPixelRgn src_rgn, dest_rgn;
-  gint         bytes;
-  gboolean     has_alpha;
-  guchar      *dest;
-  guchar      *src;
-  gint         x, y, x2, y2;
-  gint         width, height;
+  SelGaussJob  job;
+  GThread     *threads[MAX_THREADS];
   gdouble     *mat;
   gint         numrad;
+  gint         n_threads;
+  gint         row;
+  gint         i;
+
+  numrad = (gint) (radius + 1.0);
+  mat = g_new (gdouble, numrad);
+  init_matrix (radius, mat, numrad);
 
-  if (! gimp_drawable_mask_intersect (drawable->drawable_id,
+  job.src       = src;
+  job.dest      = dest;
+  job.width     = width;
+  job.height    = height;
+  job.mat       = mat;
+  job.numrad    = numrad;
+  job.bytes     = bytes;
+  job.has_alpha = has_alpha;
+  job.maxdelta  = maxdelta;
+  job.next_row  = 0;
+
+  n_threads = CLAMP (g_get_num_processors (), 1, MAX_THREADS);
+  n_threads = MIN (n_threads, (height + CHUNK_ROWS - 1) / CHUNK_ROWS);
+
+  for (i = 1; i < n_threads; i++)
+    threads[i] = g_thread_new ("blur-gauss-selective",
+                               (GThreadFunc) sel_gauss_thread, &job);
+
+  while ((row = g_atomic_int_add (&job.next_row, CHUNK_ROWS)) < height)
+    {
+      gint last = MIN (row + CHUNK_ROWS, height);
+
+      matrixmult (src, dest, width, height, mat, numrad,
+                  bytes, has_alpha, maxdelta,
+                  row, last);
+
+      if (show_progress)
+        gimp_progress_update ((gdouble) last / (gdouble) height);
+    }
+
+  for (i = 1; i < n_threads; i++)
+    g_thread_join (threads[i]);
+
+  g_free (mat);
+}
+
+static const Babl *
+sel_gauss_format (gint32 drawable_id)
+{
+  if (gimp_drawable_is_rgb (drawable_id))
+    {
+      if (gimp_drawable_has_alpha (drawable_id))
+        return babl_format ("R'G'B'A u8");
+      else
+        return babl_format ("R'G'B' u8");
+    }
+  else
+    {
+      if (gimp_drawable_has_alpha (drawable_id))
+        return babl_format ("Y'A u8");
+      else
+        return babl_format ("Y' u8");
+    }
+}
+
+static void
+sel_gauss (gint32  drawable_id,
+           gdouble radius,
+           gint    maxdelta)
+{
+  GeglBuffer *src_buffer;
+  GeglBuffer *dest_buffer;
+  const Babl *format;
+  gint        bytes;
+  gboolean    has_alpha;
+  guchar     *dest;
+  guchar     *src;
+  gint        x, y, x2, y2;
+  gint        width, height;
+  gint        numrad;
+
+  if (! gimp_drawable_mask_intersect (drawable_id,
                                       &x, &y, &width, &height))
     return;
 
-  bytes     = drawable->bpp;
-  has_alpha = gimp_drawable_has_alpha (drawable->drawable_id);
+  format    = sel_gauss_format (drawable_id);
+  bytes     = babl_format_get_bytes_per_pixel (format);
+  has_alpha = gimp_drawable_has_alpha (drawable_id);
 
   numrad = (gint) (radius + 1.0);
-  mat = g_new (gdouble, numrad);
-  init_matrix (radius, mat, numrad);
 
-  x2 = MIN (x + width - 1 + numrad, drawable->width);
-  y2 = MIN (y + height - 1 + numrad, drawable->height);
+  x2 = MIN (x + width - 1 + numrad, gimp_drawable_width (drawable_id));
+  y2 = MIN (y + height - 1 + numrad, gimp_drawable_height (drawable_id));
 
   x = MAX (x - numrad + 1, 0);
   y = MAX (y - numrad + 1, 0);
@@ -762,53 +886,58 @@ sel_gauss (GimpDrawable *drawable,
 
   /*  allocate with extra padding because MMX instructions may read
       more than strictly necessary  */
-  src  = g_new (guchar, width * height * bytes + 16);
-  dest = g_new (guchar, width * height * bytes);
+  src  = g_new (guchar, (gsize) width * height * bytes + 16);
+  dest = g_new (guchar, (gsize) width * height * bytes);
 
-  gimp_pixel_rgn_init (&src_rgn,
-                       drawable, x, y, width, height, FALSE, FALSE);
-  gimp_pixel_rgn_get_rect (&src_rgn, src, x, y, width, height);
+  src_buffer  = gimp_drawable_get_buffer (drawable_id);
+  dest_buffer = gimp_drawable_get_shadow_buffer (drawable_id);
 
-  matrixmult (src, dest, width, height, mat, numrad,
-              bytes, has_alpha, maxdelta, FALSE);
+  gegl_buffer_get (src_buffer, GEGL_RECTANGLE (x, y, width, height), 1.0,
+                   format, src,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  sel_gauss_render (src, dest, width, height, radius,
+                    bytes, has_alpha, maxdelta, TRUE);
   gimp_progress_update (1.0);
 
-  gimp_pixel_rgn_init (&dest_rgn,
-                       drawable, x, y, width, height, TRUE, TRUE);
-  gimp_pixel_rgn_set_rect (&dest_rgn, dest, x, y, width, height);
+  gegl_buffer_set (dest_buffer, GEGL_RECTANGLE (x, y, width, height), 0,
+                   format, dest,
+                   GEGL_AUTO_ROWSTRIDE);
+
+  g_object_unref (src_buffer);
+  g_object_unref (dest_buffer);
 
   /*  merge the shadow, update the drawable  */
-  gimp_drawable_flush (drawable);
-  gimp_drawable_merge_shadow (drawable->drawable_id, TRUE);
-  gimp_drawable_update (drawable->drawable_id, x, y, width, height);
+  gimp_drawable_merge_shadow (drawable_id, TRUE);
+  gimp_drawable_update (drawable_id, x, y, width, height);
 
   /* free up buffers */
   g_free (src);
   g_free (dest);
-  g_free (mat);
 }
 
 static void
 preview_update (GimpPreview *preview)
 {
   GimpDrawable  *drawable;
-  glong          bytes;
+  GeglBuffer    *buffer;
+  const Babl    *format;
+  gint           bytes;
   gint           x, y;
   guchar        *render_buffer;  /* Buffer to hold rendered image */
   gint           width;          /* Width of preview widget */
   gint           height;         /* Height of preview widget */
-
-  GimpPixelRgn   srcPR;           /* Pixel region */
   guchar        *src;
   gboolean       has_alpha;
-  gint           numrad;
-  gdouble       *mat;
-  gdouble       radius;
+  gdouble        radius;
 
   /* Get drawable info */
   drawable =
     gimp_drawable_preview_get_drawable (GIMP_DRAWABLE_PREVIEW (preview));
-  bytes = drawable->bpp;
+
+  format    = sel_gauss_format (drawable->drawable_id);
+  bytes     = babl_format_get_bytes_per_pixel (format);
+  has_alpha = gimp_drawable_has_alpha (drawable->drawable_id);
 
   /*
    * Setup for filter...
@@ -816,10 +945,6 @@ preview_update (GimpPreview *preview)
   gimp_preview_get_position (preview, &x, &y);
   gimp_preview_get_size (preview, &width, &height);
 
-  /* initialize pixel regions */
-  gimp_pixel_rgn_init (&srcPR, drawable,
-                       x, y, width, height,
-                       FALSE, FALSE);
   render_buffer = g_new (guchar, width * height * bytes);
 
   /*  allocate with extra padding because MMX instructions may read
@@ -827,21 +952,21 @@ preview_update (GimpPreview *preview)
   src = g_new (guchar, width * height * bytes + 16);
 
   /* render image */
-  gimp_pixel_rgn_get_rect (&srcPR, src, x, y, width, height);
-  has_alpha = gimp_drawable_has_alpha (drawable->drawable_id);
+  buffer = gimp_drawable_get_buffer (drawable->drawable_id);
 
-  radius = fabs (bvals.radius) + 1.0;
-  numrad = (gint) (radius + 1.0);
+  gegl_buffer_get (buffer, GEGL_RECTANGLE (x, y, width, height), 1.0,
+                   format, src,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
 
-  mat = g_new (gdouble, numrad);
-  init_matrix (radius, mat, numrad);
+  g_object_unref (buffer);
 
-  matrixmult (src, render_buffer,
-              width, height,
-              mat, numrad,
-              bytes, has_alpha, bvals.maxdelta, TRUE);
+  radius = fabs (bvals.radius) + 1.0;
+
+  sel_gauss_render (src, render_buffer,
+                    width, height,
+                    radius,
+                    bytes, has_alpha, bvals.maxdelta, FALSE);
 
-  g_free (mat);
   g_free (src);
 
   /*
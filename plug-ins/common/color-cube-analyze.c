@@ -73,6 +73,7 @@ static gdouble    hist_red[256], hist_green[256], hist_blue[256];
 static gdouble    maxred = 0.0, maxgreen = 0.0, maxblue = 0.0;
 static gint       uniques = 0;
 static gint32     imageID;
+static guint32   *seen_colors = NULL;  /* one bit per color of the cube */
 
 /* lets declare what we want to do */
 const GimpPlugInInfo PLUG_IN_INFO =
@@ -181,8 +182,10 @@ static void
 analyze (GimpDrawable *drawable)
 {
   GimpPixelRgn  srcPR;
-  guchar       *src_row, *cmap;
+  guchar       *src_rows, *cmap;
+  guchar       *sel_rows;
   gint          x, y, numcol;
+  gint          y_end, n_rows;
   gint          x1, y1, x2, y2;
   guchar        r, g, b;
   gint          a;
@@ -190,7 +193,6 @@ analyze (GimpDrawable *drawable)
   gboolean      gray;
   gboolean      has_alpha;
   gboolean      has_sel;
-  guchar       *sel;
   GimpPixelRgn  selPR;
   gint          ofsx, ofsy;
   GimpDrawable *selDrawable;
@@ -223,70 +225,86 @@ analyze (GimpDrawable *drawable)
                        selDrawable,
                        0, 0, width, height, FALSE, FALSE);
 
-  /* allocate row buffer */
-  src_row = g_new (guchar, (x2 - x1) * bpp);
-  sel = g_new (guchar, x2 - x1);
+  seen_colors = g_new0 (guint32, (1 << 24) / 32);
 
-  for (y = y1; y < y2; y++)
+  /* the rows are read one tile row at a time */
+  n_rows = gimp_tile_height ();
+
+  src_rows = g_new (guchar, (x2 - x1) * n_rows * bpp);
+  sel_rows = g_new (guchar, (x2 - x1) * n_rows);
+
+  for (y = y1; y < y2; y = y_end)
     {
-      gimp_pixel_rgn_get_row (&srcPR, src_row, x1, y, (x2 - x1));
+      gint row;
+
+      y_end = MIN (y2, (y / n_rows + 1) * n_rows);
+
+      gimp_pixel_rgn_get_rect (&srcPR, src_rows, x1, y, x2 - x1, y_end - y);
       if (has_sel)
-        gimp_pixel_rgn_get_row (&selPR, sel, x1 + ofsx, y + ofsy, (x2 - x1));
+        gimp_pixel_rgn_get_rect (&selPR, sel_rows,
+                                 x1 + ofsx, y + ofsy, x2 - x1, y_end - y);
 
-      for (x = 0; x < x2 - x1; x++)
+      for (row = 0; row < y_end - y; row++)
         {
-          /* Start with full opacity.  */
-          a = 255;
-
-          /*
-           * If the image is indexed, fetch RGB values
-           * from colormap.
-           */
-          if (cmap)
-            {
-              idx = src_row[x * bpp];
+          const guchar *src_row = src_rows + row * (x2 - x1) * bpp;
+          const guchar *sel     = sel_rows + row * (x2 - x1);
 
-              r = cmap[idx * 3];
-              g = cmap[idx * 3 + 1];
-              b = cmap[idx * 3 + 2];
-              if (has_alpha)
-                a = src_row[x * bpp + 1];
-            }
-          else if (gray)
-            {
-              r = g = b = src_row[x * bpp];
-              if (has_alpha)
-                a = src_row[x * bpp + 1];
-            }
-          else
+          for (x = 0; x < x2 - x1; x++)
             {
-              r = src_row[x * bpp];
-              g = src_row[x * bpp + 1];
-              b = src_row[x * bpp + 2];
-              if (has_alpha)
-                a = src_row[x * bpp + 3];
+              /* Start with full opacity.  */
+              a = 255;
+
+              /*
+               * If the image is indexed, fetch RGB values
+               * from colormap.
+               */
+              if (cmap)
+                {
+                  idx = src_row[x * bpp];
+
+                  r = cmap[idx * 3];
+                  g = cmap[idx * 3 + 1];
+                  b = cmap[idx * 3 + 2];
+                  if (has_alpha)
+                    a = src_row[x * bpp + 1];
+                }
+              else if (gray)
+                {
+                  r = g = b = src_row[x * bpp];
+                  if (has_alpha)
+                    a = src_row[x * bpp + 1];
+                }
+              else
+                {
+                  r = src_row[x * bpp];
+                  g = src_row[x * bpp + 1];
+                  b = src_row[x * bpp + 2];
+                  if (has_alpha)
+                    a = src_row[x * bpp + 3];
+                }
+
+              if (has_sel)
+                a *= sel[x];
+              else
+                a *= 255;
+
+              if (a != 0)
+                insertcolor (r, g, b, (gdouble) a * (1.0 / (255.0 * 255.0)));
             }
-
-          if (has_sel)
-            a *= sel[x];
-          else
-            a *= 255;
-
-          if (a != 0)
-            insertcolor (r, g, b, (gdouble) a * (1.0 / (255.0 * 255.0)));
         }
 
       /* tell the user what we're doing */
-      if ((y % 10) == 0)
-        gimp_progress_update ((gdouble) y / (gdouble) (y2 - y1));
+      gimp_progress_update ((gdouble) (y_end - y1) / (gdouble) (y2 - y1));
     }
 
   gimp_progress_update (1.0);
 
   /* clean up */
   gimp_drawable_detach (selDrawable);
-  g_free (src_row);
-  g_free (sel);
+  g_free (src_rows);
+  g_free (sel_rows);
+  g_free (seen_colors);
+  seen_colors = NULL;
 }
 
 static void
@@ -295,22 +313,18 @@ insertcolor (guchar  r,
              guchar  b,
              gdouble a)
 {
-  static GHashTable *hash_table;
-  guint key;
-
-  if (!hash_table)
-    hash_table = g_hash_table_new (g_direct_hash, g_direct_equal);
+  guint   key;
+  guint32 bit;
 
   histogram (r, g, b, a);
 
   key = r + 256 * (g + 256 * b);
-  if (g_hash_table_lookup (hash_table, GINT_TO_POINTER (key)))
-    {
-      return;
-    }
+  bit = 1u << (key % 32);
+
+  if (seen_colors[key / 32] & bit)
+    return;
 
-  g_hash_table_insert (hash_table, GINT_TO_POINTER (key),
-                       GINT_TO_POINTER (1));
+  seen_colors[key / 32] |= bit;
 
   uniques++;
 }
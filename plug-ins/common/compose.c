@@ -96,16 +96,6 @@ static void      run                    (const gchar     *name,
                                          gint            *nreturn_vals,
                                          GimpParam      **return_vals);
 
-static void      cpn_affine_transform   (GeglBuffer      *buffer,
-                                         gdouble          min,
-                                         gdouble          max);
-
-static void fill_buffer_from_components (GeglBuffer      *temp[MAX_COMPOSE_IMAGES],
-                                         GeglBuffer      *dst,
-                                         gint             num_cpn,
-                                         ComposeInput    *inputs,
-                                         gdouble          mask_vals[MAX_COMPOSE_IMAGES]);
-
 static void      perform_composition    (COMPOSE_DSC      curr_compose_dsc,
                                          GeglBuffer      *buffer_src[MAX_COMPOSE_IMAGES],
                                          GeglBuffer      *buffer_dst,
@@ -634,81 +624,11 @@ run (const gchar      *name,
   values[0].data.d_status = status;
 }
 
-static void
-cpn_affine_transform (GeglBuffer  *buffer,
-                      gdouble      min,
-                      gdouble      max)
-{
-  GeglBufferIterator *gi;
-
-  const gdouble scale  = max - min;
-  const gdouble offset = min;
-
-  /* We want to scale values linearly, regardless of the format of the buffer */
-  gegl_buffer_set_format (buffer, babl_format ("Y double"));
-
-  gi = gegl_buffer_iterator_new (buffer, NULL, 0, NULL,
-                                 GEGL_ACCESS_READWRITE, GEGL_ABYSS_NONE);
-
-  while (gegl_buffer_iterator_next (gi))
-    {
-      guint   k;
-      double *data;
-
-      data = (double*) gi->data[0];
-
-      for (k = 0; k < gi->length; k++)
-        {
-          data[k] = data[k] * scale + offset;
-        }
-    }
-}
-
-static void
-fill_buffer_from_components (GeglBuffer   *temp[MAX_COMPOSE_IMAGES],
-                             GeglBuffer   *dst,
-                             gint          num_cpn,
-                             ComposeInput *inputs,
-                             gdouble       mask_vals[MAX_COMPOSE_IMAGES])
-{
-  GeglBufferIterator *gi;
-  gint j;
-
-  gi = gegl_buffer_iterator_new (dst, NULL, 0, NULL,
-                                 GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
-
-  for (j = 0; j < num_cpn; j++)
-    {
-      if (inputs[j].is_ID)
-        gegl_buffer_iterator_add (gi, temp[j], NULL, 0, NULL,
-                                  GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
-    }
-
-  while (gegl_buffer_iterator_next (gi))
-    {
-      gulong k, count;
-      gdouble *src_data[MAX_COMPOSE_IMAGES], *dst_data;
-
-      dst_data = (gdouble*) gi->data[0];
-
-      count = 1;
-      for (j = 0; j < num_cpn; j++)
-        if (inputs[j].is_ID)
-          src_data[j] = (gdouble*) gi->data[count++];
-
-      for (k = 0; k < gi->length; k++)
-        {
-          gulong pos = k * num_cpn;
-
-          for (j = 0; j < num_cpn; j++)
-            if (inputs[j].is_ID)
-              dst_data[pos+j] = src_data[j][k];
-            else
-              dst_data[pos+j] = mask_vals[j];
-        }
-    }
-}
-
+/* Composes in a single pass: the sources are read as "Y double" or
+ * "Y' double", rescaled to the component's range, and interleaved into
+ * the model's format, which babl converts to the destination's format
+ * chunk by chunk.
+ */
 static void
 perform_composition (COMPOSE_DSC   curr_compose_dsc,
                      GeglBuffer   *buffer_src[MAX_COMPOSE_IMAGES],
@@ -717,17 +637,32 @@ perform_composition (COMPOSE_DSC   curr_compose_dsc,
                      gint          num_images)
 {
   const Babl          *dst_format;
-  GeglBuffer          *temp[MAX_COMPOSE_IMAGES];
-  GeglBuffer          *dst_temp;
-  const GeglRectangle *extent = NULL;
-
+  GeglBufferIterator  *gi;
   const COMPONENT_DSC *components;
   gdouble              mask_vals[MAX_COMPOSE_IMAGES];
+  gdouble              scale[MAX_COMPOSE_IMAGES];
+  gdouble              offset[MAX_COMPOSE_IMAGES];
+  gint                 src_index[MAX_COMPOSE_IMAGES];
+  gint64               done = 0;
+  gint64               total;
   gint                 i;
 
   components = curr_compose_dsc.components;
 
-  /* Get all individual components in gray buffers */
+  dst_format = babl_format_new (babl_model (curr_compose_dsc.babl_model),
+                                babl_type ("double"),
+                                babl_component (components[0].babl_name),
+                                num_images > 1 ? babl_component (components[1].babl_name) : NULL,
+                                num_images > 2 ? babl_component (components[2].babl_name) : NULL,
+                                num_images > 3 ? babl_component (components[3].babl_name) : NULL,
+                                NULL);
+
+  total = ((gint64) gegl_buffer_get_width (buffer_dst) *
+           gegl_buffer_get_height (buffer_dst));
+
+  gi = gegl_buffer_iterator_new (buffer_dst, NULL, 0, dst_format,
+                                 GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
+
   for (i = 0; i < num_images; i++)
     {
       COMPONENT_DSC  cpn_dsc = components[i];
@@ -738,54 +673,53 @@ perform_composition (COMPOSE_DSC   curr_compose_dsc,
       else
         gray_format = babl_format ("Y double");
 
+      scale[i]  = cpn_dsc.range_max - cpn_dsc.range_min;
+      offset[i] = cpn_dsc.range_min;
+
       if (! inputs[i].is_ID)
         {
           const Babl *fish = babl_fish (babl_format ("Y' u8"), gray_format);
 
           babl_process (fish, &inputs[i].comp.val, &mask_vals[i], 1);
 
-          mask_vals[i] = mask_vals[i] * (cpn_dsc.range_max - cpn_dsc.range_min) + cpn_dsc.range_min;
+          mask_vals[i] = mask_vals[i] * scale[i] + offset[i];
         }
       else
         {
-          extent = gegl_buffer_get_extent (buffer_src[i]);
-
-          temp[i] = gegl_buffer_new (extent, gray_format);
-
-          gegl_buffer_copy (buffer_src[i], NULL, temp[i], NULL);
-
-          if (cpn_dsc.range_min != 0.0 || cpn_dsc.range_max != 1.0)
-            cpn_affine_transform (temp[i], cpn_dsc.range_min, cpn_dsc.range_max);
-
+          src_index[i] = gegl_buffer_iterator_add (gi, buffer_src[i], NULL, 0,
+                                                   gray_format,
+                                                   GEGL_ACCESS_READ,
+                                                   GEGL_ABYSS_NONE);
         }
-
-      gimp_progress_update ((gdouble) i / (gdouble) (num_images + 1.0));
     }
 
-  dst_format = babl_format_new (babl_model (curr_compose_dsc.babl_model),
-                                babl_type ("double"),
-                                babl_component (components[0].babl_name),
-                                num_images > 1 ? babl_component (components[1].babl_name) : NULL,
-                                num_images > 2 ? babl_component (components[2].babl_name) : NULL,
-                                num_images > 3 ? babl_component (components[3].babl_name) : NULL,
-                                NULL);
-
-  /* extent is not NULL because there is at least one drawable */
-  dst_temp = gegl_buffer_new (extent, dst_format);
+  while (gegl_buffer_iterator_next (gi))
+    {
+      gdouble       *dst_data = gi->data[0];
+      const gdouble *src_data[MAX_COMPOSE_IMAGES];
+      gint           k;
 
-  /* Gather all individual components in the dst_format buffer */
-  fill_buffer_from_components (temp, dst_temp, num_images, inputs, mask_vals);
+      for (i = 0; i < num_images; i++)
+        if (inputs[i].is_ID)
+          src_data[i] = gi->data[src_index[i]];
 
-  gimp_progress_update ((gdouble) num_images / (gdouble) (num_images + 1.0));
+      for (k = 0; k < gi->length; k++)
+        {
+          for (i = 0; i < num_images; i++)
+            {
+              if (inputs[i].is_ID)
+                dst_data[i] = src_data[i][k] * scale[i] + offset[i];
+              else
+                dst_data[i] = mask_vals[i];
+            }
 
-  /* Copy back to the format GIMP wants (and perform the conversion in itself) */
-  gegl_buffer_copy (dst_temp, NULL, buffer_dst, NULL);
+          dst_data += num_images;
+        }
 
-  for (i = 0; i< num_images; i++)
-    if( inputs[i].is_ID)
-      g_object_unref (temp[i]);
+      done += gi->length;
 
-  g_object_unref (dst_temp);
+      gimp_progress_update ((gdouble) done / (gdouble) total);
+    }
 }
 
 /* Compose an image from several gray-images */
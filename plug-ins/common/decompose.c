@@ -116,20 +116,10 @@ static gint32    create_new_layer            (gint32               image_ID,
                                               guint                width,
                                               guint                height,
                                               GimpImageBaseType    type);
-static void      transfer_registration_color (GeglBuffer          *src,
-                                              GeglBuffer         **dst,
-                                              gint                 count);
-static void      cpn_affine_transform_clamp  (GeglBuffer          *buffer,
-                                              gdouble              min,
-                                              gdouble              max);
 static void      copy_n_components           (GeglBuffer          *src,
                                               GeglBuffer         **dst,
-                                              EXTRACT              ext);
-static void      copy_one_component          (GeglBuffer          *src,
-                                              GeglBuffer          *dst,
-                                              const char          *model,
-                                              const COMPONENT      component,
-                                              gboolean             clamp);
+                                              EXTRACT              ext,
+                                              gboolean             registration);
 static gboolean  decompose_dialog            (void);
 static gchar   * generate_filename           (guint32              image_ID,
                                               guint                colorspace,
@@ -528,10 +518,7 @@ decompose (gint32       image_ID,
     }
 
   copy_n_components (src_buffer, dst_buffer,
-                     extract[extract_idx]);
-
-  if (decovals.use_registration)
-    transfer_registration_color (src_buffer, dst_buffer, num_layers);
+                     extract[extract_idx], decovals.use_registration);
 
   gimp_progress_update (1.0);
 
@@ -609,154 +596,117 @@ create_new_layer (gint32              image_ID,
   return layer_ID;
 }
 
-/* Registration Color function */
-
+/* Extracts all components in a single pass: babl converts the source
+ * to the extraction's model once per chunk, and every component is
+ * rescaled and written to its destination right away.  The
+ * destination buffers are accessed as "Y double" or "Y' double", so
+ * the component value is stored as is, and babl converts it to the
+ * destination's format.
+ */
 static void
-transfer_registration_color (GeglBuffer  *src,
-                             GeglBuffer **dst,
-                             gint         count)
+copy_n_components (GeglBuffer  *src,
+                   GeglBuffer **dst,
+                   EXTRACT      ext,
+                   gboolean     registration)
 {
-  GimpRGB color, test;
   GeglBufferIterator *gi;
-  const Babl *src_format, *dst_format;
-  gint i, src_bpp, dst_bpp;
-  gdouble white;
-
-  gimp_context_get_foreground (&color);
-  white = 1.0;
-
-  src_format = gegl_buffer_get_format (src);
-  src_bpp = babl_format_get_bytes_per_pixel (src_format);
-
-  dst_format = gegl_buffer_get_format (dst[0]);
-  dst_bpp = babl_format_get_bytes_per_pixel (dst_format);
-
-  gi = gegl_buffer_iterator_new (src, NULL, 0, NULL,
+  const Babl         *src_format;
+  GimpRGB             color;
+  gboolean            transform[MAX_EXTRACT_IMAGES];
+  gdouble             scale[MAX_EXTRACT_IMAGES];
+  gdouble             offset[MAX_EXTRACT_IMAGES];
+  gint                n = ext.num_images;
+  gint                reg_index = 0;
+  gint64              done      = 0;
+  gint64              total;
+  gint                j;
+
+  /* We are working in linear double precison */
+  src_format = babl_format_new (babl_model (ext.model),
+                                babl_type ("double"),
+                                babl_component (ext.component[0].babl_name),
+                                n > 1 ? babl_component (ext.component[1].babl_name) : NULL,
+                                n > 2 ? babl_component (ext.component[2].babl_name) : NULL,
+                                n > 3 ? babl_component (ext.component[3].babl_name) : NULL,
+                                NULL);
+
+  total = (gint64) gegl_buffer_get_width (src) * gegl_buffer_get_height (src);
+
+  gi = gegl_buffer_iterator_new (src, NULL, 0, src_format,
                                  GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
 
-  for (i = 0; i < count; i++)
+  for (j = 0; j < n; j++)
     {
-      gegl_buffer_iterator_add (gi, dst[i], NULL, 0, NULL,
-                                GEGL_ACCESS_READWRITE, GEGL_ABYSS_NONE);
+      const COMPONENT *component = &ext.component[j];
+
+      /* We need to enforce linearity here
+       * If the output is "Y'", the component is already ok
+       * If the output is "Y" , it will enforce gamma-decoding.
+       * A bit tricky and suboptimal...
+       */
+      gegl_buffer_iterator_add (gi, dst[j], NULL, 0,
+                                babl_format (component->perceptual_channel ?
+                                             "Y' double" : "Y double"),
+                                GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
+
+      transform[j] = (component->range_min != 0.0 ||
+                      component->range_max != 1.0 ||
+                      ext.clamp);
+      scale[j]     = 1.0 / (component->range_max - component->range_min);
+      offset[j]    = - component->range_min;
     }
 
-  while (gegl_buffer_iterator_next (gi))
+  /* pixels of the registration color become white in all components */
+  if (registration)
     {
-      guint j, k;
-      gpointer src_data, dst_data[MAX_EXTRACT_IMAGES];
-
-      src_data = gi->data[0];
-      for (j = 0; j < count; j++)
-        dst_data[j] = gi->data[j+1];
-
-      for (k = 0; k < gi->length; k++)
-        {
-          gulong pos;
-          pos = k * src_bpp;
-          gimp_rgba_set_pixel (&test, src_format, ((guchar *)src_data) + pos);
+      gimp_context_get_foreground (&color);
 
-          if (gimp_rgb_distance (&test, &color) < 1e-6)
-            {
-              for (j = 0; j < count; j++)
-                {
-                  gpointer data;
-                  data = dst_data[j];
-                  babl_process (babl_fish (babl_format ("Y double"), dst_format),
-                                &white, (guchar *)data + (k * dst_bpp), 1);
-                }
-            }
-        }
+      reg_index = gegl_buffer_iterator_add (gi, src, NULL, 0,
+                                            babl_format ("R'G'B'A double"),
+                                            GEGL_ACCESS_READ,
+                                            GEGL_ABYSS_NONE);
     }
-}
-
-static void
-cpn_affine_transform_clamp (GeglBuffer  *buffer,
-                            gdouble      min,
-                            gdouble      max)
-{
-  GeglBufferIterator *gi;
-
-  gdouble scale = 1.0 / (max - min);
-  gdouble offset = - min;
-
-  /* We want to scale values linearly, regardless of the format of the buffer */
-  gegl_buffer_set_format (buffer, babl_format ("Y double"));
-
-  gi = gegl_buffer_iterator_new (buffer, NULL, 0, NULL,
-                                 GEGL_ACCESS_READWRITE, GEGL_ABYSS_NONE);
 
   while (gegl_buffer_iterator_next (gi))
     {
-      guint k;
-      double *data;
+      const gdouble *src_data = gi->data[0];
+      gdouble       *dst_data[MAX_EXTRACT_IMAGES];
+      const GimpRGB *reg_data = NULL;
+      gint           k;
 
-      data = (double*) gi->data[0];
+      for (j = 0; j < n; j++)
+        dst_data[j] = gi->data[j + 1];
+
+      if (registration)
+        reg_data = gi->data[reg_index];
 
       for (k = 0; k < gi->length; k++)
         {
-          data[k] = CLAMP ((data[k] + offset) * scale, 0.0, 1.0);
-        }
-    }
-}
-
-static void
-copy_n_components (GeglBuffer      *src,
-                   GeglBuffer     **dst,
-                   EXTRACT          ext)
-{
-  gint i;
-
-  for (i = 0; i < ext.num_images; i++)
-    {
-      gimp_progress_update ((gdouble) i / (gdouble) ext.num_images);
-      copy_one_component (src, dst[i], ext.model, ext.component[i], ext.clamp);
-    }
-}
-
-static void
-copy_one_component (GeglBuffer      *src,
-                    GeglBuffer      *dst,
-                    const gchar     *model,
-                    const COMPONENT  component,
-                    gboolean         clamp)
-{
-  const Babl *component_format, *dst_format;
-  GeglBuffer *temp;
-  const GeglRectangle *extent;
-
-  /* We are working in linear double precison*/
-  component_format = babl_format_new (babl_model (model),
-                                      babl_type ("double"),
-                                      babl_component (component.babl_name),
-                                      NULL);
-
-  /* We need to enforce linearity here
-   * If the output is "Y'", the ouput of temp is already ok
-   * If the output is "Y" , it will enforce gamma-decoding.
-   * A bit tricky and suboptimal...
-   */
-  if (component.perceptual_channel)
-    dst_format = babl_format ("Y' double");
-  else
-    dst_format = babl_format ("Y double");
-
-  extent = gegl_buffer_get_extent (src);
-  temp = gegl_buffer_new (extent, dst_format);
+          if (reg_data && gimp_rgb_distance (&reg_data[k], &color) < 1e-6)
+            {
+              for (j = 0; j < n; j++)
+                dst_data[j][k] = 1.0;
+            }
+          else
+            {
+              for (j = 0; j < n; j++)
+                {
+                  gdouble value = src_data[j];
 
-  /* we want to copy the component as is */
-  gegl_buffer_set_format (temp, component_format);
-  gegl_buffer_copy (src, NULL, temp, NULL);
+                  if (transform[j])
+                    value = CLAMP ((value + offset[j]) * scale[j], 0.0, 1.0);
 
-  if (component.range_min != 0.0 || component.range_max != 1.0 || clamp)
-    cpn_affine_transform_clamp (temp, component.range_min, component.range_max);
+                  dst_data[j][k] = value;
+                }
+            }
 
-  /* This is our new "Y(') double" component buffer */
-  gegl_buffer_set_format (temp, NULL);
+          src_data += n;
+        }
 
-  /* Now we let babl convert it back to the format that dst needs */
-  gegl_buffer_copy (temp, NULL, dst, NULL);
+      done += gi->length;
 
-  g_object_unref (temp);
+      gimp_progress_update ((gdouble) done / (gdouble) total);
+    }
 }
 
 static gboolean
@@ -45,37 +45,51 @@
 #define FILTER_ADAPTIVE  0x01
 #define FILTER_RECURSIVE 0x02
 
+#define MAX_THREADS      16
+#define CHUNK_ROWS       32
+
 #define despeckle_radius (despeckle_vals[0])    /* diameter of filter */
 #define filter_type      (despeckle_vals[1])    /* filter type */
 #define black_level      (despeckle_vals[2])    /* Black level */
 #define white_level      (despeckle_vals[3])    /* White level */
 
 /* List that stores pixels falling in to the same luma bucket */
-#define MAX_LIST_ELEMS SQR(2 * MAX_RADIUS + 1)
-
 typedef struct
 {
-  const guchar *elems[MAX_LIST_ELEMS];
-  gint          start;
-  gint          count;
+  const guchar **elems;
+  gint           size;
+  gint           start;
+  gint           count;
 } PixelsList;
 
 typedef struct
 {
-  gint       elems[256]; /* Number of pixels that fall into each luma bucket */
-  PixelsList origs[256]; /* Original pixels */
-  gint       xmin;
-  gint       ymin;
-  gint       xmax;
-  gint       ymax; /* Source rect */
+  gint           elems[256]; /* Number of pixels that fall into each luma bucket */
+  PixelsList     origs[256]; /* Original pixels */
+  const guchar **origs_mem;
+  gint           xmin;
+  gint           ymin;
+  gint           xmax;
+  gint           ymax; /* Source rect */
+
+  /* Number of pixels in actual histogram falling into each category */
+  gint           hist0;    /* Less than min treshold */
+  gint           hist255;  /* More than max treshold */
+  gint           histrest; /* From min to max        */
+
+  GRand         *rand;
 } DespeckleHistogram;
 
-/* Number of pixels in actual histogram falling into each category */
-static gint                hist0;    /* Less than min treshold */
-static gint                hist255;  /* More than max treshold */
-static gint                histrest; /* From min to max        */
-
-static DespeckleHistogram  histogram;
+typedef struct
+{
+  guchar   *src;
+  guchar   *dst;
+  gint      width;
+  gint      height;
+  gint      bpp;
+  gint      radius;
+  gint      next_row;
+} DespeckleJob;
 
 
 /*
@@ -639,7 +653,7 @@ list_add_elem (PixelsList   *list,
 {
   const gint pos = list->start + list->count++;
 
-  list->elems[pos >= MAX_LIST_ELEMS ? pos - MAX_LIST_ELEMS : pos] = elem;
+  list->elems[pos >= list->size ? pos - list->size : pos] = elem;
 }
 
 static inline void
@@ -648,17 +662,18 @@ list_del_elem (PixelsList* list)
   list->count--;
   list->start++;
 
-  if (list->start >= MAX_LIST_ELEMS)
+  if (list->start >= list->size)
     list->start = 0;
 }
 
 static inline const guchar *
-list_get_random_elem (PixelsList *list)
+list_get_random_elem (PixelsList *list,
+                      GRand      *rand)
 {
-  const gint pos = list->start + rand () % list->count;
+  const gint pos = list->start + g_rand_int_range (rand, 0, list->count);
 
-  if (pos >= MAX_LIST_ELEMS)
-    return list->elems[pos - MAX_LIST_ELEMS];
+  if (pos >= list->size)
+    return list->elems[pos - list->size];
 
   return list->elems[pos];
 }
@@ -696,7 +711,7 @@ static inline const guchar *
 histogram_get_median (DespeckleHistogram *hist,
                       const guchar       *_default)
 {
-  gint count = histrest;
+  gint count = hist->histrest;
   gint i;
   gint sum = 0;
 
@@ -709,7 +724,7 @@ histogram_get_median (DespeckleHistogram *hist,
   while ((sum += hist->elems[i]) < count)
     i++;
 
-  return list_get_random_elem (&hist->origs[i]);
+  return list_get_random_elem (&hist->origs[i], hist->rand);
 }
 
 static inline void
@@ -726,15 +741,15 @@ add_val (DespeckleHistogram *hist,
   if (value > black_level && value < white_level)
   {
     histogram_add (hist, value, src + pos);
-    histrest++;
+    hist->histrest++;
   }
   else
   {
     if (value <= black_level)
-      hist0++;
+      hist->hist0++;
 
     if (value >= white_level)
-      hist255++;
+      hist->hist255++;
   }
 }
 
@@ -752,15 +767,15 @@ del_val (DespeckleHistogram *hist,
   if (value > black_level && value < white_level)
   {
     histogram_remove (hist, value);
-    histrest--;
+    hist->histrest--;
   }
   else
   {
     if (value <= black_level)
-      hist0--;
+      hist->hist0--;
 
     if (value >= white_level)
-      hist255--;
+      hist->hist255--;
   }
 }
 
@@ -845,51 +860,79 @@ update_histogram (DespeckleHistogram *hist,
 }
 
 
+static DespeckleHistogram *
+histogram_new (gint radius)
+{
+  DespeckleHistogram *hist = g_new0 (DespeckleHistogram, 1);
+  gint                size = SQR (2 * radius + 1);
+  gint                i;
+
+  /* a bucket never holds more pixels than the biggest box */
+  hist->origs_mem = g_new (const guchar *, 256 * size);
+
+  for (i = 0; i < 256; i++)
+    {
+      hist->origs[i].elems = hist->origs_mem + i * size;
+      hist->origs[i].size  = size;
+    }
+
+  hist->rand = g_rand_new ();
+
+  return hist;
+}
+
 static void
-despeckle_median (guchar   *src,
-                  guchar   *dst,
-                  gint      width,
-                  gint      height,
-                  gint      bpp,
-                  gint      radius,
-                  gboolean  preview)
+histogram_free (DespeckleHistogram *hist)
 {
-  guint  progress;
-  guint  max_progress;
-  gint   x, y;
-  gint   adapt_radius;
-  gint   pos;
-  gint   ymin;
-  gint   ymax;
-  gint   xmin;
-  gint   xmax;
-
-  memset (&histogram, 0, sizeof(histogram));
-  progress     = 0;
-  max_progress = width * height;
+  g_rand_free (hist->rand);
+  g_free (hist->origs_mem);
+  g_free (hist);
+}
 
-  if (! preview)
-    gimp_progress_init(_("Despeckle"));
+/* Filters the rows from @first to @last.  Each row starts with a
+ * fresh histogram, and the adaptive radius starts over at each
+ * chunk of rows, so chunks don't depend on each other, except in
+ * recursive mode, where they are run one after the other.
+ */
+static void
+despeckle_median_rows (DespeckleJob       *job,
+                       DespeckleHistogram *hist,
+                       gint                first,
+                       gint                last)
+{
+  guchar *src    = job->src;
+  guchar *dst    = job->dst;
+  gint    width  = job->width;
+  gint    height = job->height;
+  gint    bpp    = job->bpp;
+  gint    radius = job->radius;
+  gint    x, y;
+  gint    adapt_radius;
+  gint    pos;
+  gint    ymin;
+  gint    ymax;
+  gint    xmin;
+  gint    xmax;
 
   adapt_radius = radius;
-  for (y = 0; y < height; y++)
+  for (y = first; y < last; y++)
     {
       x = 0;
       ymin = MAX (0, y - adapt_radius);
       ymax = MIN (height - 1, y + adapt_radius);
       xmin = MAX (0, x - adapt_radius);
       xmax = MIN (width - 1, x + adapt_radius);
-      hist0   = 0;
-      histrest = 0;
-      hist255 = 0;
-      histogram_clean (&histogram);
-      histogram.xmin = xmin;
-      histogram.ymin = ymin;
-      histogram.xmax = xmax;
-      histogram.ymax = ymax;
-      add_vals (&histogram,
+      hist->hist0    = 0;
+      hist->histrest = 0;
+      hist->hist255  = 0;
+      histogram_clean (hist);
+      hist->xmin = xmin;
+      hist->ymin = ymin;
+      hist->xmax = xmax;
+      hist->ymax = ymax;
+      add_vals (hist,
                 src, width, bpp,
-                histogram.xmin, histogram.ymin, histogram.xmax, histogram.ymax);
+                hist->xmin, hist->ymin, hist->xmax, hist->ymax);
 
       for (x = 0; x < width; x++)
         {
@@ -900,17 +943,17 @@ despeckle_median (guchar   *src,
           xmin = MAX (0, x - adapt_radius);
           xmax = MIN (width - 1, x + adapt_radius);
 
-          update_histogram (&histogram,
+          update_histogram (hist,
                             src, width, bpp, xmin, ymin, xmax, ymax);
 
           pos = (x + (y * width)) * bpp;
-          pixel = histogram_get_median (&histogram, src + pos);
+          pixel = histogram_get_median (hist, src + pos);
 
           if (filter_type & FILTER_RECURSIVE)
             {
-              del_val (&histogram, src, width, bpp, x, y);
+              del_val (hist, src, width, bpp, x, y);
               pixel_copy (src + pos, pixel, bpp);
-              add_val (&histogram, src, width, bpp, x, y);
+              add_val (hist, src, width, bpp, x, y);
             }
 
           pixel_copy (dst + pos, pixel, bpp);
@@ -920,7 +963,7 @@ despeckle_median (guchar   *src,
            */
           if (filter_type & FILTER_ADAPTIVE)
             {
-              if (hist0 >= adapt_radius || hist255 >= adapt_radius)
+              if (hist->hist0 >= adapt_radius || hist->hist255 >= adapt_radius)
                 {
                   if (adapt_radius < radius)
                     adapt_radius++;
@@ -931,13 +974,84 @@ despeckle_median (guchar   *src,
                 }
             }
         }
+    }
+}
+
+static gpointer
+despeckle_median_thread (DespeckleJob *job)
+{
+  DespeckleHistogram *hist = histogram_new (job->radius);
+  gint                row;
+
+  while ((row = g_atomic_int_add (&job->next_row, CHUNK_ROWS)) < job->height)
+    {
+      despeckle_median_rows (job, hist,
+                             row, MIN (row + CHUNK_ROWS, job->height));
+    }
 
-      progress += width;
+  histogram_free (hist);
+
+  return NULL;
+}
+
+static void
+despeckle_median (guchar   *src,
+                  guchar   *dst,
+                  gint      width,
+                  gint      height,
+                  gint      bpp,
+                  gint      radius,
+                  gboolean  preview)
+{
+  DespeckleJob        job;
+  DespeckleHistogram *hist;
+  GThread            *threads[MAX_THREADS];
+  gint                n_threads;
+  gint                row;
+  gint                i;
 
-      if (! preview && y % 32 == 0)
-        gimp_progress_update ((gdouble) progress / (gdouble) max_progress);
+  if (! preview)
+    gimp_progress_init(_("Despeckle"));
+
+  job.src      = src;
+  job.dst      = dst;
+  job.width    = width;
+  job.height   = height;
+  job.bpp      = bpp;
+  job.radius   = radius;
+  job.next_row = 0;
+
+  /* recursive filtering writes back into @src, so each row depends
+   * on all previous ones
+   */
+  if (filter_type & FILTER_RECURSIVE)
+    n_threads = 1;
+  else
+    n_threads = CLAMP (g_get_num_processors (), 1, MAX_THREADS);
+
+  n_threads = MIN (n_threads, (height + CHUNK_ROWS - 1) / CHUNK_ROWS);
+
+  for (i = 1; i < n_threads; i++)
+    threads[i] = g_thread_new ("despeckle",
+                               (GThreadFunc) despeckle_median_thread, &job);
+
+  hist = histogram_new (radius);
+
+  while ((row = g_atomic_int_add (&job.next_row, CHUNK_ROWS)) < height)
+    {
+      gint last = MIN (row + CHUNK_ROWS, height);
+
+      despeckle_median_rows (&job, hist, row, last);
+
+      if (! preview)
+        gimp_progress_update ((gdouble) last / (gdouble) height);
     }
 
+  histogram_free (hist);
+
+  for (i = 1; i < n_threads; i++)
+    g_thread_join (threads[i]);
+
   if (! preview)
     gimp_progress_update (1.0);
 }
@@ -58,7 +58,9 @@
 #define PLUG_IN_ROLE    "gimp-displace"
 
 #define ENTRY_WIDTH     75
-#define TILE_CACHE_SIZE 48
+
+#define MAX_THREADS     16
+#define CHUNK_ROWS      16
 
 
 typedef enum
@@ -79,6 +81,31 @@ typedef struct
   DisplaceMode mode;
 } DisplaceVals;
 
+typedef struct
+{
+  const guchar *src;        /* the whole drawable                  */
+  gint          width;
+  gint          height;
+  gint          bytes;
+
+  const guchar *map_x;      /* the maps, for the rendered area only */
+  gint          xm_bytes;
+  gint          xm_alpha;
+  const guchar *map_y;
+  gint          ym_bytes;
+  gint          ym_alpha;
+
+  guchar       *dest;       /* the area being rendered             */
+  gint          x1;
+  gint          y1;
+  gint          dest_width;
+  gint          dest_height;
+  gdouble       cx;
+  gdouble       cy;
+
+  gint          next_row;
+} DisplaceParam;
+
 
 /*
  * Function prototypes.
@@ -91,9 +118,13 @@ static void      run    (const gchar      *name,
                          gint             *nreturn_vals,
                          GimpParam       **return_vals);
 
-static void      displace        (GimpDrawable *drawable,
-                                  GimpPreview  *preview);
-static gboolean  displace_dialog (GimpDrawable *drawable);
+static void      displace        (GimpDrawable  *drawable,
+                                  GimpPreview   *preview);
+static void      displace_rows   (DisplaceParam *param,
+                                  gint           first,
+                                  gint           last);
+static gpointer  displace_thread (DisplaceParam *param);
+static gboolean  displace_dialog (GimpDrawable  *drawable);
 
 static void      displace_radio_update   (GtkWidget     *widget,
                                           gpointer       data);
@@ -101,12 +132,20 @@ static void      displace_radio_update   (GtkWidget     *widget,
 static void      displace_set_labels     (void);
 static gint      displace_get_label_size (void);
 
-static gboolean  displace_map_constrain    (gint32     image_id,
-                                            gint32     drawable_id,
-                                            gpointer   data);
-static gdouble   displace_map_give_value   (guchar    *ptr,
-                                            gint       alpha,
-                                            gint       bytes);
+static gboolean  displace_map_constrain    (gint32        image_id,
+                                            gint32        drawable_id,
+                                            gpointer      data);
+static gdouble   displace_map_give_value   (const guchar *ptr,
+                                            gint          alpha,
+                                            gint          bytes);
+static const Babl *
+                 displace_get_format       (gint32        drawable_id);
+static guchar  * displace_get_pixels       (gint32        drawable_id,
+                                            const Babl   *format,
+                                            gint          x,
+                                            gint          y,
+                                            gint          width,
+                                            gint          height);
 
 /***** Local vars *****/
 
@@ -215,13 +254,11 @@ run (const gchar      *name,
   run_mode = param[0].data.d_int32;
 
   INIT_I18N ();
+  gegl_init (NULL, NULL);
 
   /*  Get the specified drawable  */
   drawable = gimp_drawable_get (param[2].data.d_drawable);
 
-  /*  set the tile cache size  */
-  gimp_tile_cache_ntiles (TILE_CACHE_SIZE);
-
   *nreturn_vals = 1;
   *return_vals  = values;
 
@@ -303,6 +340,8 @@ run (const gchar      *name,
   values[0].data.d_status = status;
 
   gimp_drawable_detach (drawable);
+
+  gegl_exit ();
 }
 
 static gboolean
@@ -508,69 +547,194 @@ displace_dialog (GimpDrawable *drawable)
 
 /* The displacement is done here. */
 
+static inline void
+displace_get_pixel (DisplaceParam *param,
+                    gint           x,
+                    gint           y,
+                    guchar        *pixel)
+{
+  if (x < 0 || x >= param->width ||
+      y < 0 || y >= param->height)
+    {
+      switch (dvals.displace_type)
+        {
+        case GIMP_PIXEL_FETCHER_EDGE_WRAP:
+          x %= param->width;
+          if (x < 0)
+            x += param->width;
+
+          y %= param->height;
+          if (y < 0)
+            y += param->height;
+          break;
+
+        case GIMP_PIXEL_FETCHER_EDGE_SMEAR:
+          x = CLAMP (x, 0, param->width - 1);
+          y = CLAMP (y, 0, param->height - 1);
+          break;
+
+        default:
+          memset (pixel, 0, param->bytes);
+          return;
+        }
+    }
+
+  memcpy (pixel,
+          param->src + ((gsize) y * param->width + x) * param->bytes,
+          param->bytes);
+}
+
 static void
-displace (GimpDrawable *drawable,
-          GimpPreview  *preview)
+displace_rows (DisplaceParam *param,
+               gint           first,
+               gint           last)
 {
-  GimpDrawable     *map_x = NULL;
-  GimpDrawable     *map_y = NULL;
-  GimpPixelRgn      dest_rgn;
-  GimpPixelRgn      map_x_rgn;
-  GimpPixelRgn      map_y_rgn;
-  gpointer          pr;
-  GimpPixelFetcher *pft;
-
-  gint              width;
-  gint              height;
-  gint              bytes;
-  guchar           *destrow, *dest;
-  guchar           *mxrow, *mx;
-  guchar           *myrow, *my;
-  guchar            pixel[4][4];
-  gint              x1, y1;
-  gint              x, y;
-  gdouble           cx, cy;
-  gint              progress, max_progress;
-
-  gdouble           amnt;
-  gdouble           needx, needy;
-  gdouble           radius, d_alpha;
-  gint              xi, yi;
-
-  guchar            values[4];
-  guchar            val;
-
-  gint              k;
-
-  gdouble           xm_val, ym_val;
-  gint              xm_alpha = 0;
-  gint              ym_alpha = 0;
-  gint              xm_bytes = 1;
-  gint              ym_bytes = 1;
-  guchar           *buffer   = NULL;
-  gdouble           pi;
-
-  /* initialize */
+  const gint    bytes = param->bytes;
+  const gdouble cx    = param->cx;
+  const gdouble cy    = param->cy;
+  guchar        pixel[4][4];
+  guchar        values[4];
+  gdouble       amnt;
+  gdouble       needx, needy;
+  gdouble       radius, d_alpha;
+  gdouble       xm_val, ym_val;
+  gint          xi, yi;
+  gint          x, y;
+  gint          k;
 
   /* get rid of uninitialized warnings */
-  cx = cy = needx = needy = radius = d_alpha = 0.0;
+  needx = needy = radius = d_alpha = 0.0;
+
+  for (y = param->y1 + first; y < param->y1 + last; y++)
+    {
+      gsize         offset = (gsize) (y - param->y1) * param->dest_width;
+      guchar       *dest   = param->dest + offset * bytes;
+      const guchar *mx     = NULL;
+      const guchar *my     = NULL;
+
+      if (param->map_x)
+        mx = param->map_x + offset * param->xm_bytes;
+      if (param->map_y)
+        my = param->map_y + offset * param->ym_bytes;
+
+      for (x = param->x1; x < param->x1 + param->dest_width; x++)
+        {
+          if (param->map_x)
+            {
+              xm_val = displace_map_give_value (mx, param->xm_alpha,
+                                                param->xm_bytes);
+              amnt = dvals.amount_x * (xm_val - 127.5) / 127.5;
+              /* CARTESIAN_MODE == 0 - performance important here */
+              if (! dvals.mode)
+                {
+                  needx = x + amnt;
+                }
+              else
+                {
+                  radius = sqrt (SQR (x - cx) + SQR (y - cy)) + amnt;
+                }
+              mx += param->xm_bytes;
+            }
+          else
+            {
+              if (! dvals.mode)
+                needx = x;
+              else
+                radius = sqrt ((x - cx) * (x - cx) + (y - cy) * (y - cy));
+            }
 
-  pi = 4 * atan (1);
 
-  mxrow = NULL;
-  myrow = NULL;
+          if (param->map_y)
+            {
+              ym_val = displace_map_give_value (my, param->ym_alpha,
+                                                param->ym_bytes);
+              amnt = dvals.amount_y * (ym_val - 127.5) / 127.5;
+              if (! dvals.mode)
+                {
+                  needy = y + amnt;
+                }
+              else
+                {
+                  d_alpha = atan2 (x - cx, y - cy) + (dvals.amount_y / 180)
+                            * G_PI * (ym_val - 127.5) / 127.5;
+                }
+              my += param->ym_bytes;
+            }
+          else
+            {
+              if (! dvals.mode)
+                needy = y;
+              else
+                d_alpha = atan2 (x - cx, y - cy);
+            }
+          if (dvals.mode)
+            {
+               needx = cx + radius * sin (d_alpha);
+               needy = cy + radius * cos (d_alpha);
+            }
+          /* Calculations complete; now copy the proper pixel */
+
+          if (needx >= 0.0)
+            xi = (int) needx;
+          else
+            xi = -((int) -needx + 1);
+
+          if (needy >= 0.0)
+            yi = (int) needy;
+          else
+            yi = -((int) -needy + 1);
+
+          displace_get_pixel (param, xi, yi, pixel[0]);
+          displace_get_pixel (param, xi + 1, yi, pixel[1]);
+          displace_get_pixel (param, xi, yi + 1, pixel[2]);
+          displace_get_pixel (param, xi + 1, yi + 1, pixel[3]);
+
+          for (k = 0; k < bytes; k++)
+            {
+              values[0] = pixel[0][k];
+              values[1] = pixel[1][k];
+              values[2] = pixel[2][k];
+              values[3] = pixel[3][k];
+
+              *dest++ = gimp_bilinear_8 (needx, needy, values);
+            }
+        }
+    }
+}
+
+static gpointer
+displace_thread (DisplaceParam *param)
+{
+  gint row;
 
-  pft = gimp_pixel_fetcher_new (drawable, FALSE);
-  gimp_pixel_fetcher_set_edge_mode (pft, dvals.displace_type);
+  while ((row = g_atomic_int_add (&param->next_row, CHUNK_ROWS)) <
+         param->dest_height)
+    {
+      displace_rows (param, row, MIN (row + CHUNK_ROWS, param->dest_height));
+    }
 
-  bytes  = drawable->bpp;
+  return NULL;
+}
 
+static void
+displace (GimpDrawable *drawable,
+          GimpPreview  *preview)
+{
+  DisplaceParam  param  = { 0, };
+  const Babl    *format;
+  const Babl    *map_x_format = NULL;
+  const Babl    *map_y_format = NULL;
+  GThread       *threads[MAX_THREADS];
+  gint           n_threads;
+  gint           x1, y1;
+  gint           width, height;
+  gint           row;
+  gint           i;
 
   if (preview)
     {
       gimp_preview_get_position (preview, &x1, &y1);
       gimp_preview_get_size (preview, &width, &height);
-      buffer = g_new (guchar, width * height * bytes);
     }
   else if (! gimp_drawable_mask_intersect (drawable->drawable_id, &x1, &y1,
                                            &width, &height))
@@ -578,209 +742,149 @@ displace (GimpDrawable *drawable,
       return;
     }
 
+  format = displace_get_format (drawable->drawable_id);
+
+  param.width       = drawable->width;
+  param.height      = drawable->height;
+  param.bytes       = babl_format_get_bytes_per_pixel (format);
+  param.x1          = x1;
+  param.y1          = y1;
+  param.dest_width  = width;
+  param.dest_height = height;
+
   if (dvals.mode == POLAR_MODE)
     {
-      cx = x1 + width / 2.0;
-      cy = y1 + height / 2.0;
+      param.cx = x1 + width / 2.0;
+      param.cy = y1 + height / 2.0;
     }
 
-  progress     = 0;
-  max_progress = width * height;
-
   /*
    * The algorithm used here is simple - see
    * http://the-tech.mit.edu/KPT/Tips/KPT7/KPT7.html for a description.
    */
 
-  /* Get the drawables  */
-  if (dvals.displace_map_x != -1 && dvals.do_x)
-    {
-      map_x = gimp_drawable_get (dvals.displace_map_x);
-      gimp_pixel_rgn_init (&map_x_rgn, map_x,
-                           x1, y1, width, height, FALSE, FALSE);
-
-      if (gimp_drawable_has_alpha (map_x->drawable_id))
-        xm_alpha = 1;
+  /*  The displaced pixels can come from anywhere in the drawable, so
+   *  fetch all of it once; the maps are only needed where we render.
+   */
+  param.src = displace_get_pixels (drawable->drawable_id, format,
+                                   0, 0, param.width, param.height);
 
-      xm_bytes = gimp_drawable_bpp (map_x->drawable_id);
+  if (dvals.do_x && dvals.displace_map_x != -1)
+    {
+      map_x_format   = displace_get_format (dvals.displace_map_x);
+      param.xm_bytes = babl_format_get_bytes_per_pixel (map_x_format);
+      param.xm_alpha = gimp_drawable_has_alpha (dvals.displace_map_x);
+      param.map_x    = displace_get_pixels (dvals.displace_map_x,
+                                            map_x_format,
+                                            x1, y1, width, height);
     }
 
-  if (dvals.displace_map_y != -1 && dvals.do_y)
+  if (dvals.do_y && dvals.displace_map_y != -1)
     {
-      map_y = gimp_drawable_get (dvals.displace_map_y);
-      gimp_pixel_rgn_init (&map_y_rgn, map_y,
-                           x1, y1, width, height, FALSE, FALSE);
-
-      if (gimp_drawable_has_alpha (map_y->drawable_id))
-        ym_alpha = 1;
-
-      ym_bytes = gimp_drawable_bpp (map_y->drawable_id);
+      map_y_format   = displace_get_format (dvals.displace_map_y);
+      param.ym_bytes = babl_format_get_bytes_per_pixel (map_y_format);
+      param.ym_alpha = gimp_drawable_has_alpha (dvals.displace_map_y);
+      param.map_y    = displace_get_pixels (dvals.displace_map_y,
+                                            map_y_format,
+                                            x1, y1, width, height);
     }
 
-  gimp_pixel_rgn_init (&dest_rgn, drawable,
-                       x1, y1, width, height,
-                       preview == NULL, preview == NULL);
-
-  /*  Register the pixel regions  */
-  if (dvals.do_x && dvals.do_y)
-    pr = gimp_pixel_rgns_register (3, &dest_rgn, &map_x_rgn, &map_y_rgn);
-  else if (dvals.do_x)
-    pr = gimp_pixel_rgns_register (2, &dest_rgn, &map_x_rgn);
-  else if (dvals.do_y)
-    pr = gimp_pixel_rgns_register (2, &dest_rgn, &map_y_rgn);
-  else
-    pr = NULL;
-
-  for (pr = pr; pr != NULL; pr = gimp_pixel_rgns_process (pr))
-    {
-      destrow = dest_rgn.data;
-      if (dvals.do_x)
-        mxrow = map_x_rgn.data;
-      if (dvals.do_y)
-        myrow = map_y_rgn.data;
+  param.dest = g_new (guchar, (gsize) width * height * param.bytes);
 
-      for (y = dest_rgn.y; y < (dest_rgn.y + dest_rgn.h); y++)
-        {
-          if (preview)
-            dest = buffer + ((y - y1) * width + (dest_rgn.x - x1)) * bytes;
-          else
-            dest = destrow;
-          mx = mxrow;
-          my = myrow;
-
-          /*
-           * We could move the displacement image address calculation
-           * out of here, but when we can have different sized
-           * displacement and destination images we'd have to move it
-           * back anyway.
-           */
-
-          for (x = dest_rgn.x; x < (dest_rgn.x + dest_rgn.w); x++)
-            {
-              if (dvals.do_x)
-                {
-                  xm_val = displace_map_give_value(mx, xm_alpha, xm_bytes);
-                  amnt = dvals.amount_x * (xm_val - 127.5) / 127.5;
-                  /* CARTESIAN_MODE == 0 - performance important here */
-                  if (! dvals.mode)
-                    {
-                      needx = x + amnt;
-                    }
-                  else
-                    {
-                      radius = sqrt (SQR (x - cx) + SQR (y - cy)) + amnt;
-                    }
-                  mx += xm_bytes;
-                }
-              else
-                {
-                  if (! dvals.mode)
-                    needx = x;
-                  else
-                    radius = sqrt ((x - cx) * (x - cx) + (y - cy) * (y - cy));
-                }
+  n_threads = CLAMP (g_get_num_processors (), 1, MAX_THREADS);
+  n_threads = MIN (n_threads, (height + CHUNK_ROWS - 1) / CHUNK_ROWS);
 
+  for (i = 1; i < n_threads; i++)
+    threads[i] = g_thread_new ("displace",
+                               (GThreadFunc) displace_thread, &param);
 
-              if (dvals.do_y)
-                {
-                  ym_val = displace_map_give_value(my, ym_alpha, ym_bytes);
-                  amnt = dvals.amount_y * (ym_val - 127.5) / 127.5;
-                  if (! dvals.mode)
-                    {
-                      needy = y + amnt;
-                    }
-                  else
-                    {
-                      d_alpha = atan2 (x - cx, y - cy) + (dvals.amount_y / 180)
-                                * pi * (ym_val - 127.5) / 127.5;
-                    }
-                  my += ym_bytes;
-                }
-              else
-                {
-                  if (! dvals.mode)
-                    needy = y;
-                  else
-                    d_alpha = atan2 (x - cx, y - cy);
-                }
-              if (dvals.mode)
-                {
-                   needx = cx + radius * sin (d_alpha);
-                   needy = cy + radius * cos (d_alpha);
-                }
-              /* Calculations complete; now copy the proper pixel */
+  while ((row = g_atomic_int_add (&param.next_row, CHUNK_ROWS)) < height)
+    {
+      gint last = MIN (row + CHUNK_ROWS, height);
 
-              if (needx >= 0.0)
-                xi = (int) needx;
-              else
-                xi = -((int) -needx + 1);
+      displace_rows (&param, row, last);
 
-              if (needy >= 0.0)
-                yi = (int) needy;
-              else
-                yi = -((int) -needy + 1);
+      if (! preview)
+        gimp_progress_update ((gdouble) last / (gdouble) height);
+    }
 
-              gimp_pixel_fetcher_get_pixel (pft, xi, yi, pixel[0]);
-              gimp_pixel_fetcher_get_pixel (pft, xi + 1, yi, pixel[1]);
-              gimp_pixel_fetcher_get_pixel (pft, xi, yi + 1, pixel[2]);
-              gimp_pixel_fetcher_get_pixel (pft, xi + 1, yi + 1, pixel[3]);
+  for (i = 1; i < n_threads; i++)
+    g_thread_join (threads[i]);
 
-              for (k = 0; k < bytes; k++)
-                {
-                  values[0] = pixel[0][k];
-                  values[1] = pixel[1][k];
-                  values[2] = pixel[2][k];
-                  values[3] = pixel[3][k];
-                  val = gimp_bilinear_8 (needx, needy, values);
-
-                  *dest++ = val;
-                } /* for */
-            }
+  if (preview)
+    {
+      gimp_preview_draw_buffer (preview, param.dest, width * param.bytes);
+    }
+  else
+    {
+      GeglBuffer *dest_buffer;
 
-          destrow += dest_rgn.rowstride;
+      dest_buffer = gimp_drawable_get_shadow_buffer (drawable->drawable_id);
 
-          if (dvals.do_x)
-            mxrow += map_x_rgn.rowstride;
-          if (dvals.do_y)
-            myrow += map_y_rgn.rowstride;
-        }
+      gegl_buffer_set (dest_buffer, GEGL_RECTANGLE (x1, y1, width, height), 0,
+                       format, param.dest,
+                       GEGL_AUTO_ROWSTRIDE);
 
-      if (!preview)
-        {
-          progress += dest_rgn.w * dest_rgn.h;
-          gimp_progress_update ((double) progress / (double) max_progress);
-        }
-    } /* for */
+      g_object_unref (dest_buffer);
 
-  gimp_pixel_fetcher_destroy (pft);
+      gimp_progress_update (1.0);
+      /*  update the region  */
+      gimp_drawable_merge_shadow (drawable->drawable_id, TRUE);
+      gimp_drawable_update (drawable->drawable_id, x1, y1, width, height);
+    }
 
-  /*  detach from the map drawables  */
-  if (dvals.do_x)
-    gimp_drawable_detach (map_x);
-  if (dvals.do_y)
-    gimp_drawable_detach (map_y);
+  g_free (param.dest);
+  g_free ((guchar *) param.map_y);
+  g_free ((guchar *) param.map_x);
+  g_free ((guchar *) param.src);
+}
 
-  if (preview)
+static const Babl *
+displace_get_format (gint32 drawable_id)
+{
+  if (gimp_drawable_is_gray (drawable_id))
     {
-/*      gimp_drawable_preview_draw_region (GIMP_DRAWABLE_PREVIEW (preview),
-                                         &dest_rgn);*/
-      gimp_preview_draw_buffer (preview, buffer, width * bytes);
-      g_free (buffer);
+      if (gimp_drawable_has_alpha (drawable_id))
+        return babl_format ("Y'A u8");
+      else
+        return babl_format ("Y' u8");
     }
   else
     {
-      gimp_progress_update (1.0);
-      /*  update the region  */
-      gimp_drawable_flush (drawable);
-      gimp_drawable_merge_shadow (drawable->drawable_id, TRUE);
-      gimp_drawable_update (drawable->drawable_id, x1, y1, width, height);
+      if (gimp_drawable_has_alpha (drawable_id))
+        return babl_format ("R'G'B'A u8");
+      else
+        return babl_format ("R'G'B' u8");
     }
 }
 
+static guchar *
+displace_get_pixels (gint32      drawable_id,
+                     const Babl *format,
+                     gint        x,
+                     gint        y,
+                     gint        width,
+                     gint        height)
+{
+  GeglBuffer *buffer = gimp_drawable_get_buffer (drawable_id);
+  guchar     *pixels;
+
+  pixels = g_new (guchar, (gsize) width * height *
+                          babl_format_get_bytes_per_pixel (format));
+
+  gegl_buffer_get (buffer, GEGL_RECTANGLE (x, y, width, height), 1.0,
+                   format, pixels,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  g_object_unref (buffer);
+
+  return pixels;
+}
+
 static gdouble
-displace_map_give_value (guchar *pt,
-                         gint    alpha,
-                         gint    bytes)
+displace_map_give_value (const guchar *pt,
+                         gint          alpha,
+                         gint          bytes)
 {
   gdouble ret, val_alpha;
 
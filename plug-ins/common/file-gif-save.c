@@ -103,7 +103,6 @@ static GimpRunMode   run_mode;
 static GimpParasite *comment_parasite   = NULL;
 static gboolean      comment_was_edited = FALSE;
 static gchar        *globalcomment      = NULL;
-static gint          Interlace; /* For compression code */
 
 
 const GimpPlugInInfo PLUG_IN_INFO =
@@ -374,10 +373,25 @@ run (const gchar      *name,
 
 #define MAXCOLORS 256
 
-/*
- * Pointer to function returning an int
+#define MAX_THREADS 16
+
+/* One image of the GIF, as it is prepared from a layer, encoded, and
+ * finally written.
  */
-typedef int (*ifunptr) (int, int);
+typedef struct
+{
+  guchar     *pixels;         /* the indices, in the order they are encoded */
+  gint        width;
+  gint        height;
+  gint        offset_x;
+  gint        offset_y;
+  gint        interlace;
+  gint        bpp;
+  gint        transparent;
+  gint        disposal;
+  gint        delay;
+  GByteArray *data;           /* the LZW compressed data sub-blocks */
+} GifFrame;
 
 
 static gint find_unused_ia_color           (const guchar *pixels,
@@ -391,10 +405,7 @@ static void special_flatten_indexed_alpha  (guchar      *pixels,
 
 static gint colors_to_bpp                  (int          colors);
 static gint bpp_to_colors                  (int          bpp);
-static gint get_pixel                      (int          x,
-                                            int          y);
-static gint gif_next_pixel                 (ifunptr      getpixel);
-static void bump_pixel                     (void);
+static void interlace_rows                 (GifFrame    *frame);
 
 static void gif_encode_header              (FILE        *fp,
                                             gboolean     gif89,
@@ -404,57 +415,23 @@ static void gif_encode_header              (FILE        *fp,
                                             int          BitsPerPixel,
                                             int          Red[],
                                             int          Green[],
-                                            int          Blue[],
-                                            ifunptr      get_pixel);
+                                            int          Blue[]);
 static void gif_encode_graphic_control_ext (FILE        *fp,
                                             int          Disposal,
                                             int          Delay89,
                                             int          NumFramesInImage,
-                                            int          GWidth,
-                                            int          GHeight,
-                                            int          Transparent,
-                                            int          BitsPerPixel,
-                                            ifunptr      get_pixel);
+                                            int          Transparent);
 static void gif_encode_image_data          (FILE        *fp,
-                                            int          GWidth,
-                                            int          GHeight,
-                                            int          GInterlace,
-                                            int          BitsPerPixel,
-                                            ifunptr      get_pixel,
-                                            gint         offset_x,
-                                            gint         offset_y);
+                                            GifFrame    *frame);
 static void gif_encode_close               (FILE        *fp);
 static void gif_encode_loop_ext            (FILE        *fp,
                                             guint        num_loops);
 static void gif_encode_comment_ext         (FILE        *fp,
                                             const gchar *comment);
 
-static gint     rowstride;
-static guchar  *pixels;
-static gint     cur_progress;
-static gint     max_progress;
-
-static void compress        (int      init_bits,
-                             FILE    *outfile,
-                             ifunptr  ReadValue);
-static void no_compress     (int      init_bits,
-                             FILE    *outfile,
-                             ifunptr  ReadValue);
-static void rle_compress    (int      init_bits,
-                             FILE    *outfile,
-                             ifunptr  ReadValue);
-static void normal_compress (int      init_bits,
-                             FILE    *outfile,
-                             ifunptr  ReadValue);
-
-static void put_word        (int      w,
-                             FILE    *fp);
-static void output          (gint     code);
-static void cl_block        (void);
-static void cl_hash         (glong    hsize);
-static void char_init       (void);
-static void char_out        (int      c);
-static void flush_char      (void);
+static void     put_word        (int       w,
+                                 FILE     *fp);
+static gpointer compress        (GifFrame *frame);
 
 
 static gint
@@ -692,14 +669,15 @@ save_image (const gchar *filename,
   gint           i;
   gint           transparent;
   gint           offset_x, offset_y;
+  gint           n_threads;
 
   gint32        *layers;
   gint           nlayers;
 
   gboolean       is_gif89 = FALSE;
 
-  gint           Delay89;
-  gint           Disposal;
+  gint           Delay89  = 0;
+  gint           Disposal = 0;
   gchar         *layer_name;
 
   GimpRGB        background;
@@ -856,9 +834,8 @@ save_image (const gchar *filename,
 
   cols = gimp_image_width (image_ID);
   rows = gimp_image_height (image_ID);
-  Interlace = gsvals.interlace;
   gif_encode_header (outfile, is_gif89, cols, rows, bgindex,
-                     BitsPerPixel, Red, Green, Blue, get_pixel);
+                     BitsPerPixel, Red, Green, Blue);
 
 
   /* If the image has multiple layers it'll be made into an
@@ -876,124 +853,165 @@ save_image (const gchar *filename,
   /*** Now for each layer in the image, save an image in a compound GIF ***/
   /************************************************************************/
 
-  cur_progress = 0;
-  max_progress = nlayers * rows;
+  /* The layers are read and prepared in order, a batch at a time.  The
+   * frames of a batch are compressed on all processors, and then
+   * written in order.
+   */
+  n_threads = CLAMP (g_get_num_processors (), 1, MAX_THREADS);
 
-  for (i = nlayers - 1; i >= 0; i--, cur_progress = (nlayers - i) * rows)
+  for (i = nlayers - 1; i >= 0; )
     {
-      drawable_type = gimp_drawable_type (layers[i]);
-      buffer = gimp_drawable_get_buffer (layers[i]);
-      gimp_drawable_offsets (layers[i], &offset_x, &offset_y);
-      cols = gimp_drawable_width (layers[i]);
-      rows = gimp_drawable_height (layers[i]);
-      rowstride = cols;
+      GifFrame  frames[MAX_THREADS];
+      GThread  *threads[MAX_THREADS];
+      gint      n_frames;
+      gint      j;
 
-      pixels = g_new (guchar, (cols * rows *
-                               (((drawable_type == GIMP_INDEXEDA_IMAGE) ||
-                                 (drawable_type == GIMP_GRAYA_IMAGE)) ? 2 : 1)));
-
-      gegl_buffer_get (buffer, GEGL_RECTANGLE (0, 0, cols, rows), 1.0,
-                       format, pixels,
-                       GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
-
-      /* sort out whether we need to do transparency jiggery-pokery */
-      if ((drawable_type == GIMP_INDEXEDA_IMAGE) ||
-          (drawable_type == GIMP_GRAYA_IMAGE))
-        {
-          /* Try to find an entry which isn't actually used in the
-             image, for a transparency index. */
-
-          transparent =
-            find_unused_ia_color (pixels,
-                                   cols * rows,
-                                   bpp_to_colors (colors_to_bpp (colors)),
-                                   &colors);
-
-          special_flatten_indexed_alpha (pixels,
-                                         transparent,
-                                         cols * rows);
-        }
-      else
+      for (n_frames = 0; n_frames < n_threads && i >= 0; n_frames++, i--)
         {
-          transparent = -1;
-        }
-
-      BitsPerPixel = colors_to_bpp (colors);
-
-      if (BitsPerPixel != liberalBPP)
-        {
-          /* We were able to re-use an index within the existing bitspace,
-             whereas the estimate in the header was pessimistic but still
-             needs to be upheld... */
-#ifdef GIFDEBUG
-          static gboolean onceonly = FALSE;
-
-          if (! onceonly)
+          GifFrame *frame = &frames[n_frames];
+
+          drawable_type = gimp_drawable_type (layers[i]);
+          buffer = gimp_drawable_get_buffer (layers[i]);
+          gimp_drawable_offsets (layers[i], &offset_x, &offset_y);
+          cols = gimp_drawable_width (layers[i]);
+          rows = gimp_drawable_height (layers[i]);
+
+          frame->width    = cols;
+          frame->height   = rows;
+          frame->offset_x = offset_x;
+          frame->offset_y = offset_y;
+          frame->pixels   = g_new (guchar, (cols * rows *
+                                            (((drawable_type == GIMP_INDEXEDA_IMAGE) ||
+                                              (drawable_type == GIMP_GRAYA_IMAGE)) ? 2 : 1)));
+
+          gegl_buffer_get (buffer, GEGL_RECTANGLE (0, 0, cols, rows), 1.0,
+                           format, frame->pixels,
+                           GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+          g_object_unref (buffer);
+
+          /* sort out whether we need to do transparency jiggery-pokery */
+          if ((drawable_type == GIMP_INDEXEDA_IMAGE) ||
+              (drawable_type == GIMP_GRAYA_IMAGE))
             {
-              g_warning ("Promised %d bpp, pondered writing chunk with %d bpp!",
-                         liberalBPP, BitsPerPixel);
-              onceonly = TRUE;
-            }
-#endif
-        }
-
-      useBPP = (BitsPerPixel > liberalBPP) ? BitsPerPixel : liberalBPP;
-
-      if (is_gif89)
-        {
-          if (i > 0 && ! gsvals.always_use_default_dispose)
-            {
-              layer_name = gimp_item_get_name (layers[i - 1]);
-              Disposal = parse_disposal_tag (layer_name);
-              g_free (layer_name);
+              /* Try to find an entry which isn't actually used in the
+                 image, for a transparency index. */
+
+              transparent =
+                find_unused_ia_color (frame->pixels,
+                                      cols * rows,
+                                      bpp_to_colors (colors_to_bpp (colors)),
+                                      &colors);
+
+              special_flatten_indexed_alpha (frame->pixels,
+                                             transparent,
+                                             cols * rows);
             }
           else
             {
-              Disposal = gsvals.default_dispose;
+              transparent = -1;
             }
 
-          layer_name = gimp_item_get_name (layers[i]);
-          Delay89 = parse_ms_tag (layer_name);
-          g_free (layer_name);
+          BitsPerPixel = colors_to_bpp (colors);
 
-          if (Delay89 < 0 || gsvals.always_use_default_delay)
-            Delay89 = (gsvals.default_delay + 5) / 10;
-          else
-            Delay89 = (Delay89 + 5) / 10;
-
-          /* don't allow a CPU-sucking completely 0-delay looping anim */
-          if ((nlayers > 1) && gsvals.loop && (Delay89 == 0))
+          if (BitsPerPixel != liberalBPP)
             {
+              /* We were able to re-use an index within the existing bitspace,
+                 whereas the estimate in the header was pessimistic but still
+                 needs to be upheld... */
+#ifdef GIFDEBUG
               static gboolean onceonly = FALSE;
 
-              if (!onceonly)
+              if (! onceonly)
                 {
-                  g_message (_("Delay inserted to prevent evil "
-                               "CPU-sucking animation."));
+                  g_warning ("Promised %d bpp, pondered writing chunk with %d bpp!",
+                             liberalBPP, BitsPerPixel);
                   onceonly = TRUE;
                 }
-              Delay89 = 1;
+#endif
+            }
+
+          useBPP = (BitsPerPixel > liberalBPP) ? BitsPerPixel : liberalBPP;
+
+          if (is_gif89)
+            {
+              if (i > 0 && ! gsvals.always_use_default_dispose)
+                {
+                  layer_name = gimp_item_get_name (layers[i - 1]);
+                  Disposal = parse_disposal_tag (layer_name);
+                  g_free (layer_name);
+                }
+              else
+                {
+                  Disposal = gsvals.default_dispose;
+                }
+
+              layer_name = gimp_item_get_name (layers[i]);
+              Delay89 = parse_ms_tag (layer_name);
+              g_free (layer_name);
+
+              if (Delay89 < 0 || gsvals.always_use_default_delay)
+                Delay89 = (gsvals.default_delay + 5) / 10;
+              else
+                Delay89 = (Delay89 + 5) / 10;
+
+              /* don't allow a CPU-sucking completely 0-delay looping anim */
+              if ((nlayers > 1) && gsvals.loop && (Delay89 == 0))
+                {
+                  static gboolean onceonly = FALSE;
+
+                  if (!onceonly)
+                    {
+                      g_message (_("Delay inserted to prevent evil "
+                                   "CPU-sucking animation."));
+                      onceonly = TRUE;
+                    }
+                  Delay89 = 1;
+                }
             }
 
-          gif_encode_graphic_control_ext (outfile, Disposal, Delay89, nlayers,
-                                          cols, rows,
-                                          transparent,
-                                          useBPP,
-                                          get_pixel);
+          frame->interlace   = (rows > 4) ? gsvals.interlace : 0;
+          frame->bpp         = useBPP;
+          frame->transparent = transparent;
+          frame->disposal    = Disposal;
+          frame->delay       = Delay89;
+
+          if (frame->interlace)
+            interlace_rows (frame);
         }
 
-      gif_encode_image_data (outfile, cols, rows,
-                             (rows > 4) ? gsvals.interlace : 0,
-                             useBPP,
-                             get_pixel,
-                             offset_x, offset_y);
-      gimp_progress_update (1.0);
+      for (j = 1; j < n_frames; j++)
+        threads[j] = g_thread_new ("gif-compress",
+                                   (GThreadFunc) compress, &frames[j]);
+
+      compress (&frames[0]);
 
-      g_object_unref (buffer);
+      for (j = 1; j < n_frames; j++)
+        g_thread_join (threads[j]);
 
-      g_free (pixels);
+      for (j = 0; j < n_frames; j++)
+        {
+          GifFrame *frame = &frames[j];
+
+          if (is_gif89)
+            gif_encode_graphic_control_ext (outfile,
+                                            frame->disposal, frame->delay,
+                                            nlayers, frame->transparent);
+
+          gif_encode_image_data (outfile, frame);
+
+          g_byte_array_free (frame->data, TRUE);
+          g_free (frame->pixels);
+        }
+
+      gimp_progress_update ((gdouble) (nlayers - 1 - i) / (gdouble) nlayers);
     }
 
+  gimp_progress_update (1.0);
+
+  if (ferror (outfile))
+    g_message (_("Error writing output file."));
+
   g_free(layers);
 
   gif_encode_close (outfile);
@@ -1309,114 +1327,43 @@ bpp_to_colors (int bpp)
 
 
 
-static int
-get_pixel (int x,
-           int y)
-{
-  return *(pixels + (rowstride * (long) y) + (long) x);
-}
-
-
-/*****************************************************************************
- *
- * GIFENCODE.C    - GIF Image compression interface
- *
- * GIFEncode( FName, GHeight, GWidth, GInterlace, Background, Transparent,
- *            BitsPerPixel, Red, Green, Blue, get_pixel )
- *
- *****************************************************************************/
-
-static gint  Width, Height;
-static gint  curx, cury;
-static glong CountDown;
-static gint  Pass = 0;
-
-/*
- * Bump the 'curx' and 'cury' to point to the next pixel
+/* Reorders the rows of an interlaced frame into the order they are
+ * encoded in.
  */
 static void
-bump_pixel (void)
+interlace_rows (GifFrame *frame)
 {
-  /*
-   * Bump the current X position
-   */
-  curx++;
-
-  /*
-   * If we are at the end of a scan line, set curx back to the beginning
-   * If we are interlaced, bump the cury to the appropriate spot,
-   * otherwise, just increment it.
-   */
-  if (curx == Width)
-    {
-      cur_progress++;
-
-      if ((cur_progress % 20) == 0)
-        gimp_progress_update ((gdouble) cur_progress / (gdouble) max_progress);
+  static const gint start[] = { 0, 4, 2, 1 };
+  static const gint step[]  = { 8, 8, 4, 2 };
+  guchar           *pixels;
+  guchar           *dest;
+  gint              pass, y;
 
-      curx = 0;
+  pixels = g_new (guchar, frame->width * frame->height);
+  dest   = pixels;
 
-      if (! Interlace)
-        ++cury;
-      else
+  for (pass = 0; pass < 4; pass++)
+    {
+      for (y = start[pass]; y < frame->height; y += step[pass])
         {
-          switch (Pass)
-            {
-
-            case 0:
-              cury += 8;
-              if (cury >= Height)
-                {
-                  Pass++;
-                  cury = 4;
-                }
-              break;
-
-            case 1:
-              cury += 8;
-              if (cury >= Height)
-                {
-                  Pass++;
-                  cury = 2;
-                }
-              break;
-
-            case 2:
-              cury += 4;
-              if (cury >= Height)
-                {
-                  Pass++;
-                  cury = 1;
-                }
-              break;
-
-            case 3:
-              cury += 2;
-              break;
-            }
+          memcpy (dest, frame->pixels + y * frame->width, frame->width);
+          dest += frame->width;
         }
     }
-}
 
-/*
- * Return the next pixel from the image
- */
-static int
-gif_next_pixel (ifunptr getpixel)
-{
-  int r;
-
-  if (CountDown == 0)
-    return EOF;
-
-  --CountDown;
-
-  r = (*getpixel) (curx, cury);
+  g_free (frame->pixels);
+  frame->pixels = pixels;
+}
 
-  bump_pixel ();
 
-  return r;
-}
+/*****************************************************************************
+ *
+ * GIFENCODE.C    - GIF Image compression interface
+ *
+ * gif_encode_header( fp, gif89, GWidth, GHeight, Background,
+ *                    BitsPerPixel, Red, Green, Blue )
+ *
+ *****************************************************************************/
 
 /* public */
 
@@ -1429,8 +1376,7 @@ gif_encode_header (FILE     *fp,
                    int       BitsPerPixel,
                    int       Red[],
                    int       Green[],
-                   int       Blue[],
-                   ifunptr   get_pixel)
+                   int       Blue[])
 {
   int B;
   int RWidth, RHeight;
@@ -1440,26 +1386,11 @@ gif_encode_header (FILE     *fp,
 
   ColorMapSize = 1 << BitsPerPixel;
 
-  RWidth = Width = GWidth;
-  RHeight = Height = GHeight;
+  RWidth = GWidth;
+  RHeight = GHeight;
 
   Resolution = BitsPerPixel;
 
-  /*
-   * Calculate number of bits we are expecting
-   */
-  CountDown = (long) Width *(long) Height;
-
-  /*
-   * Indicate which pass we are on (if interlace)
-   */
-  Pass = 0;
-
-  /*
-   * Set up the current x and y position
-   */
-  curx = cury = 0;
-
   /*
    * Write the Magic header
    */
@@ -1518,30 +1449,8 @@ gif_encode_graphic_control_ext (FILE    *fp,
                                 int      Disposal,
                                 int      Delay89,
                                 int      NumFramesInImage,
-                                int      GWidth,
-                                int      GHeight,
-                                int      Transparent,
-                                int      BitsPerPixel,
-                                ifunptr  get_pixel)
+                                int      Transparent)
 {
-  Width = GWidth;
-  Height = GHeight;
-
-  /*
-   * Calculate number of bits we are expecting
-   */
-  CountDown = (long) Width *(long) Height;
-
-  /*
-   * Indicate which pass we are on (if interlace)
-   */
-  Pass = 0;
-
-  /*
-   * Set up the current x and y position
-   */
-  curx = cury = 0;
-
   /*
    * Write out extension for transparent color index, if necessary.
    */
@@ -1576,47 +1485,18 @@ gif_encode_graphic_control_ext (FILE    *fp,
 
 
 static void
-gif_encode_image_data (FILE    *fp,
-                       int      GWidth,
-                       int      GHeight,
-                       int      GInterlace,
-                       int      BitsPerPixel,
-                       ifunptr  get_pixel,
-                       gint     offset_x,
-                       gint     offset_y)
+gif_encode_image_data (FILE     *fp,
+                       GifFrame *frame)
 {
-  int LeftOfs, TopOfs;
   int InitCodeSize;
 
-  Interlace = GInterlace;
-
-  Width = GWidth;
-  Height = GHeight;
-  LeftOfs = (int) offset_x;
-  TopOfs = (int) offset_y;
-
-  /*
-   * Calculate number of bits we are expecting
-   */
-  CountDown = (long) Width * (long) Height;
-
-  /*
-   * Indicate which pass we are on (if interlace)
-   */
-  Pass = 0;
-
   /*
    * The initial code size
    */
-  if (BitsPerPixel <= 1)
+  if (frame->bpp <= 1)
     InitCodeSize = 2;
   else
-    InitCodeSize = BitsPerPixel;
-
-  /*
-   * Set up the current x and y position
-   */
-  curx = cury = 0;
+    InitCodeSize = frame->bpp;
 
   /*
    * Write an Image separator
@@ -1627,15 +1507,15 @@ gif_encode_image_data (FILE    *fp,
    * Write the Image header
    */
 
-  put_word (LeftOfs, fp);
-  put_word (TopOfs, fp);
-  put_word (Width, fp);
-  put_word (Height, fp);
+  put_word (frame->offset_x, fp);
+  put_word (frame->offset_y, fp);
+  put_word (frame->width, fp);
+  put_word (frame->height, fp);
 
   /*
    * Write out whether or not the image is interlaced
    */
-  if (Interlace)
+  if (frame->interlace)
     fputc (0x40, fp);
   else
     fputc (0x00, fp);
@@ -1646,36 +1526,14 @@ gif_encode_image_data (FILE    *fp,
   fputc (InitCodeSize, fp);
 
   /*
-   * Go and actually compress the data
+   * Write the compressed data
    */
-  compress (InitCodeSize + 1, fp, get_pixel);
+  fwrite (frame->data->data, 1, frame->data->len, fp);
 
   /*
    * Write out a Zero-length packet (to end the series)
    */
   fputc (0, fp);
-
-#if 0
-  /***************************/
-  Interlace = GInterlace;
-  Width = GWidth;
-  Height = GHeight;
-  LeftOfs = TopOfs = 0;
-
-  CountDown = (long) Width *(long) Height;
-  Pass = 0;
-  /*
-   * The initial code size
-   */
-  if (BitsPerPixel <= 1)
-    InitCodeSize = 2;
-  else
-    InitCodeSize = BitsPerPixel;
-  /*
-   * Set up the current x and y position
-   */
-  curx = cury = 0;
-#endif
 }
 
 
@@ -1761,7 +1619,7 @@ put_word (int   w,
 
 #define GIF_BITS    12
 
-#define HSIZE  5003                /* 80% occupancy */
+#define MAXCODE(Mn_bits)        (((gint) 1 << (Mn_bits)) - 1)
 
 /*
  * GIF Image compression - modified 'compress'
@@ -1775,67 +1633,36 @@ put_word (int   w,
  *              James A. Woods          (decvax!ihnp4!ames!jaw)
  *              Joe Orost               (decvax!vax135!petsd!joe)
  *
+ * Instead of the original open addressing hash table, the code table
+ * is indexed directly by prefix code and next pixel, and only the
+ * entries which were used are cleared again.  Both find the longest
+ * known string, so the output is the same.  All state lives in a
+ * GifCompressor, so that several frames can be compressed at once.
  */
 
-static int n_bits;                /* number of bits/code */
-static int maxbits = GIF_BITS;        /* user settable max # bits/code */
-static gint maxcode;        /* maximum code, given n_bits */
-static gint maxmaxcode = (gint) 1 << GIF_BITS;        /* should NEVER generate this code */
-#ifdef COMPATIBLE                /* But wrong! */
-#define MAXCODE(Mn_bits)        ((gint) 1 << (Mn_bits) - 1)
-#else /*COMPATIBLE */
-#define MAXCODE(Mn_bits)        (((gint) 1 << (Mn_bits)) - 1)
-#endif /*COMPATIBLE */
-
-static glong htab[HSIZE];
-static unsigned short codetab[HSIZE];
-#define HashTabOf(i)       htab[i]
-#define CodeTabOf(i)    codetab[i]
-
-static const gint hsize = HSIZE; /* the original reason for this being
-                                    variable was "for dynamic table sizing",
-                                    but since it was never actually changed
-                                    I made it const   --Adam. */
-
-static gint free_ent = 0;        /* first unused entry */
-
-/*
- * block compression parameters -- after all codes are used up,
- * and compression rate changes, start over.
- */
-static int clear_flg = 0;
-
-static int offset;
-static long int in_count = 1;        /* length of input */
-static long int out_count = 0;        /* # of codes output (for debugging) */
-
-/*
- * compress stdin to stdout
- *
- * Algorithm:  use open addressing double hashing (no chaining) on the
- * prefix code / next character combination.  We do a variant of Knuth's
- * algorithm D (vol. 3, sec. 6.4) along with G. Knott's relatively-prime
- * secondary probe.  Here, the modular division first probe is gives way
- * to a faster exclusive-or manipulation.  Also do block compression with
- * an adaptive reset, whereby the code table is cleared when the compression
- * ratio decreases, but after the table fills.  The variable-length output
- * codes are re-sized at this point, and a special CLEAR code is generated
- * for the decompressor.  Late addition:  construct the table according to
- * file size for noticeable speed improvement on small files.  Please direct
- * questions about this implementation to ames!jaw.
- */
-
-static gint  g_init_bits;
-static FILE *g_outfile;
-
-static int ClearCode;
-static int EOFCode;
-
-
-static gulong cur_accum;
-static gint   cur_bits;
-
-static gulong masks[] =
+typedef struct
+{
+  GByteArray *data;
+  gint        n_bits;                 /* number of bits/code */
+  gint        maxcode;                /* maximum code, given n_bits */
+  gint        init_bits;
+  gint        free_ent;               /* first unused entry */
+  gboolean    clear_flg;
+  gint        ClearCode;
+  gint        EOFCode;
+  gulong      cur_accum;
+  gint        cur_bits;
+  guchar      accum[256];             /* the current packet */
+  gint        a_count;                /* number of characters in it */
+  guint16    *codetab;                /* code of prefix code + pixel */
+  guint32     used[1 << GIF_BITS];    /* the codetab entries in use */
+  gint        n_used;
+} GifCompressor;
+
+static const gint maxmaxcode = (gint) 1 << GIF_BITS; /* should NEVER generate
+                                                        this code */
+
+static const gulong masks[] =
 {
   0x0000, 0x0001, 0x0003, 0x0007,
   0x000F, 0x001F, 0x003F, 0x007F,
@@ -1845,317 +1672,39 @@ static gulong masks[] =
 };
 
 
-static void
-compress (int      init_bits,
-          FILE    *outfile,
-          ifunptr  ReadValue)
-{
-  if (FALSE)
-    no_compress (init_bits, outfile, ReadValue);
-  else if (FALSE)
-    rle_compress (init_bits, outfile, ReadValue);
-  else
-    normal_compress (init_bits, outfile, ReadValue);
-}
-
-static void
-no_compress (int      init_bits,
-             FILE    *outfile,
-             ifunptr  ReadValue)
-{
-  long fcode;
-  gint i /* = 0 */ ;
-  int c;
-  gint ent;
-  gint hsize_reg;
-  int hshift;
-
-
-  /*
-   * Set up the globals:  g_init_bits - initial number of bits
-   *                      g_outfile   - pointer to output file
-   */
-  g_init_bits = init_bits;
-  g_outfile = outfile;
-
-  cur_bits = 0;
-  cur_accum = 0;
-
-  /*
-   * Set up the necessary values
-   */
-  offset = 0;
-  out_count = 0;
-  clear_flg = 0;
-  in_count = 1;
-
-  ClearCode = (1 << (init_bits - 1));
-  EOFCode = ClearCode + 1;
-  free_ent = ClearCode + 2;
-
-
-  /* Had some problems here... should be okay now.  --Adam */
-  n_bits = g_init_bits;
-  maxcode = MAXCODE (n_bits);
-
-
-  char_init ();
-
-  ent = gif_next_pixel (ReadValue);
-
-  hshift = 0;
-  for (fcode = (long) hsize; fcode < 65536L; fcode *= 2L)
-    ++hshift;
-  hshift = 8 - hshift;                /* set hash code range bound */
-
-  hsize_reg = hsize;
-  cl_hash ((glong) hsize_reg);        /* clear hash table */
-
-  output ((gint) ClearCode);
-
-
-  while ((c = gif_next_pixel (ReadValue)) != EOF)
-    {
-      ++in_count;
-
-      fcode = (long) (((long) c << maxbits) + ent);
-      i = (((gint) c << hshift) ^ ent);        /* xor hashing */
-
-      output ((gint) ent);
-      ++out_count;
-      ent = c;
-
-      if (free_ent < maxmaxcode)
-        {
-          CodeTabOf (i) = free_ent++;        /* code -> hashtable */
-          HashTabOf (i) = fcode;
-        }
-      else
-        cl_block ();
-    }
-
-  /*
-   * Put out the final code.
-   */
-  output ((gint) ent);
-  ++out_count;
-  output ((gint) EOFCode);
-}
+/******************************************************************************
+ *
+ * GIF Specific routines
+ *
+ ******************************************************************************/
 
+/*
+ * Flush the packet to the data, and reset the accumulator
+ */
 static void
-rle_compress (int      init_bits,
-              FILE    *outfile,
-              ifunptr  ReadValue)
+flush_char (GifCompressor *comp)
 {
-  long fcode;
-  gint i /* = 0 */ ;
-  int c, last;
-  gint ent;
-  gint disp;
-  gint hsize_reg;
-  int hshift;
-
-
-  /*
-   * Set up the globals:  g_init_bits - initial number of bits
-   *                      g_outfile   - pointer to output file
-   */
-  g_init_bits = init_bits;
-  g_outfile = outfile;
-
-  cur_bits = 0;
-  cur_accum = 0;
-
-  /*
-   * Set up the necessary values
-   */
-  offset = 0;
-  out_count = 0;
-  clear_flg = 0;
-  in_count = 1;
-
-  ClearCode = (1 << (init_bits - 1));
-  EOFCode = ClearCode + 1;
-  free_ent = ClearCode + 2;
-
-
-  /* Had some problems here... should be okay now.  --Adam */
-  n_bits = g_init_bits;
-  maxcode = MAXCODE (n_bits);
-
-
-  char_init ();
-
-  last = ent = gif_next_pixel (ReadValue);
-
-  hshift = 0;
-  for (fcode = (long) hsize; fcode < 65536L; fcode *= 2L)
-    ++hshift;
-  hshift = 8 - hshift;                /* set hash code range bound */
-
-  hsize_reg = hsize;
-  cl_hash ((glong) hsize_reg);        /* clear hash table */
-
-  output ((gint) ClearCode);
-
-
-
-  while ((c = gif_next_pixel (ReadValue)) != EOF)
+  if (comp->a_count > 0)
     {
-      ++in_count;
+      guchar count = comp->a_count;
 
-      fcode = (long) (((long) c << maxbits) + ent);
-      i = (((gint) c << hshift) ^ ent);        /* xor hashing */
-
-
-      if (last == c) {
-        if (HashTabOf (i) == fcode)
-          {
-            ent = CodeTabOf (i);
-            continue;
-          }
-        else if ((long) HashTabOf (i) < 0)        /* empty slot */
-          goto nomatch;
-        disp = hsize_reg - i;        /* secondary hash (after G. Knott) */
-        if (i == 0)
-          disp = 1;
-      probe:
-        if ((i -= disp) < 0)
-          i += hsize_reg;
-
-        if (HashTabOf (i) == fcode)
-          {
-            ent = CodeTabOf (i);
-            continue;
-          }
-        if ((long) HashTabOf (i) > 0)
-          goto probe;
-        }
-    nomatch:
-      output ((gint) ent);
-      ++out_count;
-      last = ent = c;
-      if (free_ent < maxmaxcode)
-        {
-          CodeTabOf (i) = free_ent++;        /* code -> hashtable */
-          HashTabOf (i) = fcode;
-        }
-      else
-        cl_block ();
+      g_byte_array_append (comp->data, &count, 1);
+      g_byte_array_append (comp->data, comp->accum, comp->a_count);
+      comp->a_count = 0;
     }
-
-  /*
-   * Put out the final code.
-   */
-  output ((gint) ent);
-  ++out_count;
-  output ((gint) EOFCode);
 }
 
-static void
-normal_compress (int      init_bits,
-                 FILE    *outfile,
-                 ifunptr  ReadValue)
+/*
+ * Add a character to the end of the current packet, and if it is 254
+ * characters, flush the packet.
+ */
+static inline void
+char_out (GifCompressor *comp,
+          gint           c)
 {
-  long fcode;
-  gint i /* = 0 */ ;
-  int c;
-  gint ent;
-  gint disp;
-  gint hsize_reg;
-  int hshift;
-
-
-  /*
-   * Set up the globals:  g_init_bits - initial number of bits
-   *                      g_outfile   - pointer to output file
-   */
-  g_init_bits = init_bits;
-  g_outfile = outfile;
-
-  cur_bits = 0;
-  cur_accum = 0;
-
-  /*
-   * Set up the necessary values
-   */
-  offset = 0;
-  out_count = 0;
-  clear_flg = 0;
-  in_count = 1;
-
-  ClearCode = (1 << (init_bits - 1));
-  EOFCode = ClearCode + 1;
-  free_ent = ClearCode + 2;
-
-
-  /* Had some problems here... should be okay now.  --Adam */
-  n_bits = g_init_bits;
-  maxcode = MAXCODE (n_bits);
-
-
-  char_init ();
-
-  ent = gif_next_pixel (ReadValue);
-
-  hshift = 0;
-  for (fcode = (long) hsize; fcode < 65536L; fcode *= 2L)
-    ++hshift;
-  hshift = 8 - hshift;                /* set hash code range bound */
-
-  hsize_reg = hsize;
-  cl_hash ((glong) hsize_reg);        /* clear hash table */
-
-  output ((gint) ClearCode);
-
-
-  while ((c = gif_next_pixel (ReadValue)) != EOF)
-    {
-      ++in_count;
-
-      fcode = (long) (((long) c << maxbits) + ent);
-      i = (((gint) c << hshift) ^ ent);        /* xor hashing */
-
-      if (HashTabOf (i) == fcode)
-        {
-          ent = CodeTabOf (i);
-          continue;
-        }
-      else if ((long) HashTabOf (i) < 0)        /* empty slot */
-        goto nomatch;
-      disp = hsize_reg - i;        /* secondary hash (after G. Knott) */
-      if (i == 0)
-        disp = 1;
-    probe:
-      if ((i -= disp) < 0)
-        i += hsize_reg;
-
-      if (HashTabOf (i) == fcode)
-        {
-          ent = CodeTabOf (i);
-          continue;
-        }
-      if ((long) HashTabOf (i) > 0)
-        goto probe;
-    nomatch:
-      output ((gint) ent);
-      ++out_count;
-      ent = c;
-      if (free_ent < maxmaxcode)
-        {
-          CodeTabOf (i) = free_ent++;        /* code -> hashtable */
-          HashTabOf (i) = fcode;
-        }
-      else
-        cl_block ();
-    }
-
-  /*
-   * Put out the final code.
-   */
-  output ((gint) ent);
-  ++out_count;
-  output ((gint) EOFCode);
+  comp->accum[comp->a_count++] = c;
+  if (comp->a_count >= 254)
+    flush_char (comp);
 }
 
 
@@ -2167,7 +1716,7 @@ normal_compress (int      init_bits,
  *      code:   A n_bits-bit integer.  If == -1, then EOF.  This assumes
  *              that n_bits =< (long)wordsize - 1.
  * Outputs:
- *      Outputs code to the file.
+ *      Outputs code to the data.
  * Assumptions:
  *      Chars are 8 bits long.
  * Algorithm:
@@ -2177,168 +1726,154 @@ normal_compress (int      init_bits,
  */
 
 static void
-output (gint code)
+output (GifCompressor *comp,
+        gint           code)
 {
-  cur_accum &= masks[cur_bits];
+  comp->cur_accum &= masks[comp->cur_bits];
 
-  if (cur_bits > 0)
-    cur_accum |= ((long) code << cur_bits);
+  if (comp->cur_bits > 0)
+    comp->cur_accum |= ((long) code << comp->cur_bits);
   else
-    cur_accum = code;
+    comp->cur_accum = code;
 
-  cur_bits += n_bits;
+  comp->cur_bits += comp->n_bits;
 
-  while (cur_bits >= 8)
+  while (comp->cur_bits >= 8)
     {
-      char_out ((unsigned int) (cur_accum & 0xff));
-      cur_accum >>= 8;
-      cur_bits -= 8;
+      char_out (comp, (unsigned int) (comp->cur_accum & 0xff));
+      comp->cur_accum >>= 8;
+      comp->cur_bits -= 8;
     }
 
   /*
    * If the next entry is going to be too big for the code size,
    * then increase it, if possible.
    */
-  if (free_ent > maxcode || clear_flg)
+  if (comp->free_ent > comp->maxcode || comp->clear_flg)
     {
-      if (clear_flg)
+      if (comp->clear_flg)
         {
-
-          maxcode = MAXCODE (n_bits = g_init_bits);
-          clear_flg = 0;
-
+          comp->maxcode = MAXCODE (comp->n_bits = comp->init_bits);
+          comp->clear_flg = FALSE;
         }
       else
         {
-
-          ++n_bits;
-          if (n_bits == maxbits)
-            maxcode = maxmaxcode;
+          ++comp->n_bits;
+          if (comp->n_bits == GIF_BITS)
+            comp->maxcode = maxmaxcode;
           else
-            maxcode = MAXCODE (n_bits);
+            comp->maxcode = MAXCODE (comp->n_bits);
         }
     }
 
-  if (code == EOFCode)
+  if (code == comp->EOFCode)
     {
       /*
        * At EOF, write the rest of the buffer.
        */
-      while (cur_bits > 0)
+      while (comp->cur_bits > 0)
         {
-          char_out ((unsigned int) (cur_accum & 0xff));
-          cur_accum >>= 8;
-          cur_bits -= 8;
+          char_out (comp, (unsigned int) (comp->cur_accum & 0xff));
+          comp->cur_accum >>= 8;
+          comp->cur_bits -= 8;
         }
 
-      flush_char ();
-
-      fflush (g_outfile);
-
-      if (ferror (g_outfile))
-        g_message (_("Error writing output file."));
+      flush_char (comp);
     }
 }
 
 /*
- * Clear out the hash table
+ * Clear out the code table
  */
 static void
-cl_block (void)                        /* table clear for block compress */
+cl_block (GifCompressor *comp)             /* table clear for block compress */
 {
-  cl_hash ((glong) hsize);
-  free_ent = ClearCode + 2;
-  clear_flg = 1;
+  gint i;
+
+  for (i = 0; i < comp->n_used; i++)
+    comp->codetab[comp->used[i]] = 0;
 
-  output ((gint) ClearCode);
+  comp->n_used = 0;
+  comp->free_ent = comp->ClearCode + 2;
+  comp->clear_flg = TRUE;
+
+  output (comp, (gint) comp->ClearCode);
 }
 
-static void
-cl_hash (glong hsize)        /* reset code table */
+/*
+ * Compresses the frame's pixels into frame->data.  This doesn't touch
+ * anything but the frame, so it can run in a thread.
+ */
+static gpointer
+compress (GifFrame *frame)
 {
+  GifCompressor *comp;
+  const guchar  *pixels   = frame->pixels;
+  glong          n_pixels = (glong) frame->width * frame->height;
+  glong          p;
+  gint           ent;
 
-  glong *htab_p = htab + hsize;
+  comp = g_new (GifCompressor, 1);
 
-  long i;
-  long m1 = -1;
+  comp->data    = g_byte_array_sized_new (n_pixels / 2 + 256);
+  comp->codetab = g_new0 (guint16, maxmaxcode * 256);
+  comp->n_used  = 0;
 
-  i = hsize - 16;
-  do
-    {                                /* might use Sys V memset(3) here */
-      *(htab_p - 16) = m1;
-      *(htab_p - 15) = m1;
-      *(htab_p - 14) = m1;
-      *(htab_p - 13) = m1;
-      *(htab_p - 12) = m1;
-      *(htab_p - 11) = m1;
-      *(htab_p - 10) = m1;
-      *(htab_p - 9) = m1;
-      *(htab_p - 8) = m1;
-      *(htab_p - 7) = m1;
-      *(htab_p - 6) = m1;
-      *(htab_p - 5) = m1;
-      *(htab_p - 4) = m1;
-      *(htab_p - 3) = m1;
-      *(htab_p - 2) = m1;
-      *(htab_p - 1) = m1;
-      htab_p -= 16;
-    }
-  while ((i -= 16) >= 0);
+  /*
+   * Set up the necessary values
+   */
+  comp->init_bits = ((frame->bpp <= 1) ? 2 : frame->bpp) + 1;
+  comp->cur_bits  = 0;
+  comp->cur_accum = 0;
+  comp->clear_flg = FALSE;
+  comp->a_count   = 0;
 
-  for (i += 16; i > 0; --i)
-    *--htab_p = m1;
-}
+  comp->ClearCode = (1 << (comp->init_bits - 1));
+  comp->EOFCode   = comp->ClearCode + 1;
+  comp->free_ent  = comp->ClearCode + 2;
 
+  comp->n_bits  = comp->init_bits;
+  comp->maxcode = MAXCODE (comp->n_bits);
 
-/******************************************************************************
- *
- * GIF Specific routines
- *
- ******************************************************************************/
+  ent = pixels[0];
 
-/*
- * Number of characters so far in this 'packet'
- */
-static int a_count;
+  output (comp, (gint) comp->ClearCode);
 
-/*
- * Set up the 'byte output' routine
- */
-static void
-char_init (void)
-{
-  a_count = 0;
-}
+  for (p = 1; p < n_pixels; p++)
+    {
+      gint  c    = pixels[p];
+      guint slot = ((guint) ent << 8) | c;
 
-/*
- * Define the storage for the packet accumulator
- */
-static char accum[256];
+      if (comp->codetab[slot])
+        {
+          ent = comp->codetab[slot];
+          continue;
+        }
 
-/*
- * Add a character to the end of the current packet, and if it is 254
- * characters, flush the packet to disk.
- */
-static void
-char_out (int c)
-{
-  accum[a_count++] = c;
-  if (a_count >= 254)
-    flush_char ();
-}
+      output (comp, ent);
+      ent = c;
 
-/*
- * Flush the packet to disk, and reset the accumulator
- */
-static void
-flush_char (void)
-{
-  if (a_count > 0)
-    {
-      fputc (a_count, g_outfile);
-      fwrite (accum, 1, a_count, g_outfile);
-      a_count = 0;
+      if (comp->free_ent < maxmaxcode)
+        {
+          comp->codetab[slot] = comp->free_ent++;  /* code -> table */
+          comp->used[comp->n_used++] = slot;
+        }
+      else
+        cl_block (comp);
     }
+
+  /*
+   * Put out the final code.
+   */
+  output (comp, ent);
+  output (comp, (gint) comp->EOFCode);
+
+  frame->data = comp->data;
+
+  g_free (comp->codetab);
+  g_free (comp);
+
+  return NULL;
 }
 
 
@@ -42,6 +42,8 @@
 
 #define THUMBNAIL_SIZE  128
 
+#define MAX_THREADS     16
+
 
 /* Structs for the load dialog */
 typedef struct
@@ -81,10 +83,14 @@ static gint32            load_image        (PopplerDocument        *doc,
                                             PdfSelectedPages       *pages);
 
 static GimpPDBStatusType load_dialog       (PopplerDocument        *doc,
+                                            const gchar            *filename,
                                             PdfSelectedPages       *pages);
 
 static PopplerDocument * open_document     (const gchar            *filename,
                                             GError                **error);
+static gint              open_documents    (const gchar            *filename,
+                                            PopplerDocument       **docs,
+                                            gint                    max_docs);
 
 static cairo_surface_t * get_thumb_surface (PopplerDocument        *doc,
                                             gint                    page,
@@ -370,7 +376,7 @@ run (const gchar      *name,
               break;
             }
 
-          status = load_dialog (doc, &pages);
+          status = load_dialog (doc, param[1].data.d_string, &pages);
           if (status == GIMP_PDB_SUCCESS)
             gimp_set_data (LOAD_PROC, &loadvals, sizeof(loadvals));
           break;
@@ -571,6 +577,28 @@ open_document (const gchar  *filename,
   return doc;
 }
 
+/* Poppler documents must not be used by more than one thread at a
+ * time, so every thread which renders pages gets its own.  Returns the
+ * number of documents which could be opened, up to @max_docs.
+ */
+static gint
+open_documents (const gchar      *filename,
+                PopplerDocument **docs,
+                gint              max_docs)
+{
+  gint n_docs;
+
+  for (n_docs = 0; n_docs < max_docs; n_docs++)
+    {
+      docs[n_docs] = open_document (filename, NULL);
+
+      if (! docs[n_docs])
+        break;
+    }
+
+  return n_docs;
+}
+
 /* FIXME: Remove this someday when we depend fully on GTK+ >= 3 */
 
 #if (!GTK_CHECK_VERSION (3, 0, 0))
@@ -837,6 +865,88 @@ render_page_to_pixbuf (PopplerPage *page,
 
 #endif
 
+/* The pages are rendered by a pool of threads, while the main thread
+ * turns them into layers in order.  The threads stay at most a few
+ * pages ahead of the main thread, so that not all of the rendered
+ * pages have to be kept in memory.
+ */
+typedef struct
+{
+  PdfSelectedPages  *pages;
+  gdouble            scale;
+  gboolean           antialias;
+  gint              *widths;
+  gint              *heights;
+  cairo_surface_t  **surfaces;
+  gint               next_page;
+  gint               n_inserted;
+  gint               max_ahead;
+  GMutex             mutex;
+  GCond              cond;
+} RenderJob;
+
+typedef struct
+{
+  RenderJob       *job;
+  PopplerDocument *doc;
+  GThread         *thread;
+} RenderThread;
+
+static cairo_surface_t *
+render_page (PopplerDocument *doc,
+             RenderJob       *job,
+             gint             i)
+{
+  PopplerPage     *page;
+  cairo_surface_t *surface;
+
+  page = poppler_document_get_page (doc, job->pages->pages[i]);
+
+  surface = render_page_to_surface (page,
+                                    job->widths[i], job->heights[i],
+                                    job->scale, job->antialias);
+
+  g_object_unref (page);
+
+  return surface;
+}
+
+static gpointer
+render_thread (RenderThread *thread)
+{
+  RenderJob *job = thread->job;
+
+  g_mutex_lock (&job->mutex);
+
+  while (TRUE)
+    {
+      cairo_surface_t *surface;
+      gint             i;
+
+      while (job->next_page < job->pages->n_pages &&
+             job->next_page >= job->n_inserted + job->max_ahead)
+        g_cond_wait (&job->cond, &job->mutex);
+
+      if (job->next_page >= job->pages->n_pages)
+        break;
+
+      i = job->next_page++;
+
+      g_mutex_unlock (&job->mutex);
+
+      surface = render_page (thread->doc, job, i);
+
+      g_mutex_lock (&job->mutex);
+
+      job->surfaces[i] = surface;
+      g_cond_broadcast (&job->cond);
+    }
+
+  g_mutex_unlock (&job->mutex);
+
+  return NULL;
+}
+
 static gint32
 load_image (PopplerDocument        *doc,
             const gchar            *filename,
@@ -846,11 +956,16 @@ load_image (PopplerDocument        *doc,
             gboolean                antialias,
             PdfSelectedPages       *pages)
 {
-  gint32   image_ID = 0;
-  gint32  *images   = NULL;
-  gint     i;
-  gdouble  scale;
-  gdouble  doc_progress = 0;
+  RenderJob        job;
+  RenderThread     threads[MAX_THREADS];
+  PopplerDocument *docs[MAX_THREADS];
+  gchar          **page_labels;
+  gint32           image_ID = 0;
+  gint32          *images   = NULL;
+  gint             n_threads;
+  gint             i;
+  gdouble          scale;
+  gdouble          doc_progress = 0;
 
   if (target == GIMP_PAGE_SELECTOR_TARGET_IMAGES)
     images = g_new0 (gint32, pages->n_pages);
@@ -860,36 +975,96 @@ load_image (PopplerDocument        *doc,
 
   scale = resolution / gimp_unit_get_factor (GIMP_UNIT_POINT);
 
-  /* read the file */
+  /* read the page sizes and labels */
+
+  page_labels = g_new0 (gchar *, pages->n_pages);
+
+  job.pages      = pages;
+  job.scale      = scale;
+  job.antialias  = antialias;
+  job.widths     = g_new (gint, pages->n_pages);
+  job.heights    = g_new (gint, pages->n_pages);
+  job.surfaces   = g_new0 (cairo_surface_t *, pages->n_pages);
+  job.next_page  = 0;
+  job.n_inserted = 0;
 
   for (i = 0; i < pages->n_pages; i++)
     {
       PopplerPage *page;
-      gchar       *page_label;
       gdouble      page_width;
       gdouble      page_height;
 
-      cairo_surface_t *surface;
-      gint             width;
-      gint             height;
-
       page = poppler_document_get_page (doc, pages->pages[i]);
 
       poppler_page_get_size (page, &page_width, &page_height);
-      width  = page_width  * scale;
-      height = page_height * scale;
+      job.widths[i]  = page_width  * scale;
+      job.heights[i] = page_height * scale;
+
+      g_object_get (G_OBJECT (page), "label", &page_labels[i], NULL);
+
+      g_object_unref (page);
+    }
+
+  /* start rendering the pages */
+
+  n_threads = 0;
+
+  if (pages->n_pages > 1)
+    {
+      n_threads = CLAMP (g_get_num_processors (), 1, MAX_THREADS);
+      n_threads = MIN (n_threads, pages->n_pages);
+      n_threads = open_documents (filename, docs, n_threads);
+    }
+
+  job.max_ahead = 2 * n_threads;
+
+  g_mutex_init (&job.mutex);
+  g_cond_init (&job.cond);
+
+  for (i = 0; i < n_threads; i++)
+    {
+      threads[i].job    = &job;
+      threads[i].doc    = docs[i];
+      threads[i].thread = g_thread_new ("pdf-render",
+                                        (GThreadFunc) render_thread,
+                                        &threads[i]);
+    }
+
+  /* read the file */
+
+  for (i = 0; i < pages->n_pages; i++)
+    {
+      cairo_surface_t *surface;
 
-      g_object_get (G_OBJECT (page), "label", &page_label, NULL);
+      if (n_threads > 0)
+        {
+          g_mutex_lock (&job.mutex);
+
+          while (! job.surfaces[i])
+            g_cond_wait (&job.cond, &job.mutex);
+
+          surface = job.surfaces[i];
+          job.surfaces[i] = NULL;
+
+          job.n_inserted = i + 1;
+          g_cond_broadcast (&job.cond);
+
+          g_mutex_unlock (&job.mutex);
+        }
+      else
+        {
+          surface = render_page (doc, &job, i);
+        }
 
       if (! image_ID)
         {
           gchar *name;
 
-          image_ID = gimp_image_new (width, height, GIMP_RGB);
+          image_ID = gimp_image_new (job.widths[i], job.heights[i], GIMP_RGB);
           gimp_image_undo_disable (image_ID);
 
           if (target == GIMP_PAGE_SELECTOR_TARGET_IMAGES)
-            name = g_strdup_printf (_("%s-%s"), filename, page_label);
+            name = g_strdup_printf (_("%s-%s"), filename, page_labels[i]);
           else
             name = g_strdup_printf (_("%s-pages"), filename);
 
@@ -899,12 +1074,9 @@ load_image (PopplerDocument        *doc,
           gimp_image_set_resolution (image_ID, resolution, resolution);
         }
 
-      surface = render_page_to_surface (page, width, height, scale, antialias);
-
-      layer_from_surface (image_ID, page_label, i, surface,
+      layer_from_surface (image_ID, page_labels[i], i, surface,
                           doc_progress, 1.0 / pages->n_pages);
 
-      g_free (page_label);
       cairo_surface_destroy (surface);
 
       doc_progress = (double) (i + 1) / pages->n_pages;
@@ -922,6 +1094,23 @@ load_image (PopplerDocument        *doc,
     }
   gimp_progress_update (1.0);
 
+  for (i = 0; i < n_threads; i++)
+    {
+      g_thread_join (threads[i].thread);
+      g_object_unref (docs[i]);
+    }
+
+  g_mutex_clear (&job.mutex);
+  g_cond_clear (&job.cond);
+
+  for (i = 0; i < pages->n_pages; i++)
+    g_free (page_labels[i]);
+
+  g_free (page_labels);
+  g_free (job.widths);
+  g_free (job.heights);
+  g_free (job.surfaces);
+
   if (image_ID)
     {
       gimp_image_undo_enable (image_ID);
@@ -1000,13 +1189,25 @@ get_thumb_pixbuf (PopplerDocument *doc,
   return pixbuf;
 }
 
+/* The dialog's thumbnails are rendered by several threads, each with
+ * its own document, which take the pages in turn.  They only ever use
+ * the page's embedded thumbnail or render at thumbnail size.
+ */
 typedef struct
 {
-  PopplerDocument  *document;
   GimpPageSelector *selector;
+  gint              n_pages;
+  gint              next_page;
   gboolean          stop_thumbnailing;
 } ThreadData;
 
+typedef struct
+{
+  ThreadData       *data;
+  PopplerDocument  *document;
+  GThread          *thread;
+} ThumbnailThread;
+
 typedef struct
 {
   GimpPageSelector *selector;
@@ -1031,13 +1232,12 @@ idle_set_thumbnail (gpointer data)
 static gpointer
 thumbnail_thread (gpointer data)
 {
-  ThreadData  *thread_data = data;
-  gint         n_pages;
-  gint         i;
+  ThumbnailThread *thread      = data;
+  ThreadData      *thread_data = thread->data;
+  gint             i;
 
-  n_pages = poppler_document_get_n_pages (thread_data->document);
-
-  for (i = 0; i < n_pages; i++)
+  while ((i = g_atomic_int_add (&thread_data->next_page, 1)) <
+         thread_data->n_pages)
     {
       IdleData *idle_data = g_new0 (IdleData, 1);
 
@@ -1045,12 +1245,12 @@ thumbnail_thread (gpointer data)
       idle_data->page_no  = i;
 
       /* FIXME get preferred size from somewhere? */
-      idle_data->pixbuf = get_thumb_pixbuf (thread_data->document, i,
+      idle_data->pixbuf = get_thumb_pixbuf (thread->document, i,
                                             THUMBNAIL_SIZE);
 
       g_idle_add (idle_set_thumbnail, idle_data);
 
-      if (thread_data->stop_thumbnailing)
+      if (g_atomic_int_get (&thread_data->stop_thumbnailing))
         break;
     }
 
@@ -1059,6 +1259,7 @@ thumbnail_thread (gpointer data)
 
 static GimpPDBStatusType
 load_dialog (PopplerDocument  *doc,
+             const gchar      *filename,
              PdfSelectedPages *pages)
 {
   GtkWidget  *dialog;
@@ -1069,11 +1270,13 @@ load_dialog (PopplerDocument  *doc,
   GtkWidget  *antialias;
   GtkWidget  *hbox;
 
-  ThreadData  thread_data;
-  GThread    *thread;
+  ThreadData       thread_data;
+  ThumbnailThread  threads[MAX_THREADS];
+  PopplerDocument *docs[MAX_THREADS];
 
   gint        i;
   gint        n_pages;
+  gint        n_threads;
 
   gdouble     width;
   gdouble     height;
@@ -1150,11 +1353,29 @@ load_dialog (PopplerDocument  *doc,
                             G_CALLBACK (gtk_window_activate_default),
                             dialog);
 
-  thread_data.document          = doc;
   thread_data.selector          = GIMP_PAGE_SELECTOR (selector);
+  thread_data.n_pages           = n_pages;
+  thread_data.next_page         = 0;
   thread_data.stop_thumbnailing = FALSE;
 
-  thread = g_thread_new ("thumbnailer", thumbnail_thread, &thread_data);
+  n_threads = CLAMP (g_get_num_processors (), 1, MAX_THREADS);
+  n_threads = MIN (n_threads, n_pages);
+  n_threads = open_documents (filename, docs, n_threads);
+
+  /* fall back to a single thumbnailer on the dialog's document */
+  if (n_threads == 0)
+    {
+      docs[0]   = g_object_ref (doc);
+      n_threads = 1;
+    }
+
+  for (i = 0; i < n_threads; i++)
+    {
+      threads[i].data     = &thread_data;
+      threads[i].document = docs[i];
+      threads[i].thread   = g_thread_new ("thumbnailer", thumbnail_thread,
+                                          &threads[i]);
+    }
 
   /* Resolution */
 
@@ -1208,8 +1429,13 @@ load_dialog (PopplerDocument  *doc,
     }
 
   /* cleanup */
-  thread_data.stop_thumbnailing = TRUE;
-  g_thread_join (thread);
+  g_atomic_int_set (&thread_data.stop_thumbnailing, TRUE);
+
+  for (i = 0; i < n_threads; i++)
+    {
+      g_thread_join (threads[i].thread);
+      g_object_unref (docs[i]);
+    }
 
   return run ? GIMP_PDB_SUCCESS : GIMP_PDB_CANCEL;
 }
@@ -103,6 +103,7 @@
 #include "config.h"
 
 #include <errno.h>
+#include <string.h>
 
 #include <glib/gstdio.h>
 #include <cairo-pdf.h>
@@ -241,6 +242,8 @@ static void              remove_call                (GtkTreeModel    *tree_model
                                                      gpointer         user_data);
 static void              recount_pages              (void);
 
+static void              set_surface_unique_id      (cairo_surface_t *surface);
+
 static cairo_surface_t * get_drawable_image         (gint32           drawable_ID,
                                                      GError         **error);
 
@@ -554,7 +557,11 @@ run (const gchar      *name,
 
                   GimpRGB layer_color;
 
-                  layer_color = get_layer_color (layer_ID, &single_color);
+                  /* the histograms are only needed for vectorizing */
+                  if (optimize.vectorize)
+                    layer_color = get_layer_color (layer_ID, &single_color);
+                  else
+                    single_color = FALSE;
 
                   cairo_rectangle (cr, x, y,
                                    gimp_drawable_width (layer_ID),
@@ -596,14 +603,30 @@ run (const gchar      *name,
                       cairo_clip (cr);
 
                       cairo_set_source_surface (cr, layer_image, x, y);
-                      cairo_push_group (cr);
-                      cairo_paint_with_alpha (cr, opacity);
-                      cairo_pop_group_to_source (cr);
 
+                      /* Only a masked, translucent layer needs a group,
+                       * everything else lets cairo reference the image
+                       * directly.
+                       */
                       if (mask_ID != -1)
-                        cairo_mask_surface (cr, mask_image, x, y);
+                        {
+                          if (opacity < 1.0)
+                            {
+                              cairo_push_group (cr);
+                              cairo_paint_with_alpha (cr, opacity);
+                              cairo_pop_group_to_source (cr);
+                            }
+
+                          cairo_mask_surface (cr, mask_image, x, y);
+                        }
+                      else if (opacity < 1.0)
+                        {
+                          cairo_paint_with_alpha (cr, opacity);
+                        }
                       else
-                        cairo_paint (cr);
+                        {
+                          cairo_paint (cr);
+                        }
 
                       cairo_reset_clip (cr);
 
@@ -1224,6 +1247,41 @@ recount_pages (void)
 /* Beginning of the actual PDF functions              */
 /******************************************************/
 
+/* Tags the surface with a hash of its contents.  The PDF surface
+ * writes surfaces with the same unique ID only once, so layers and
+ * masks which are identical on several pages, like a common
+ * background, are stored once and referenced from each page.
+ */
+static void
+set_surface_unique_id (cairo_surface_t *surface)
+{
+#ifdef CAIRO_MIME_TYPE_UNIQUE_ID
+  GChecksum *checksum;
+  gint       header[4];
+  gchar     *id;
+
+  header[0] = cairo_image_surface_get_format (surface);
+  header[1] = cairo_image_surface_get_width  (surface);
+  header[2] = cairo_image_surface_get_height (surface);
+  header[3] = cairo_image_surface_get_stride (surface);
+
+  checksum = g_checksum_new (G_CHECKSUM_SHA1);
+
+  g_checksum_update (checksum, (const guchar *) header, sizeof (header));
+  g_checksum_update (checksum,
+                     cairo_image_surface_get_data (surface),
+                     (gsize) header[2] * header[3]);
+
+  id = g_strdup (g_checksum_get_string (checksum));
+
+  g_checksum_free (checksum);
+
+  cairo_surface_set_mime_data (surface, CAIRO_MIME_TYPE_UNIQUE_ID,
+                               (const guchar *) id, strlen (id),
+                               g_free, id);
+#endif
+}
+
 static cairo_surface_t *
 get_drawable_image (gint32 drawable_ID,
                     GError **error)
@@ -1275,11 +1333,13 @@ get_drawable_image (gint32 drawable_ID,
 
   gegl_buffer_copy (src_buffer, NULL, dest_buffer, NULL);
 
-  cairo_surface_mark_dirty (surface);
-
   g_object_unref (src_buffer);
   g_object_unref (dest_buffer);
 
+  cairo_surface_mark_dirty (surface);
+
+  set_surface_unique_id (surface);
+
   return surface;
 }
 
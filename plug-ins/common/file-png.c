@@ -41,6 +41,7 @@
 #include "config.h"
 
 #include <stdlib.h>
+#include <string.h>
 #include <errno.h>
 
 #include <glib/gstdio.h>
@@ -49,6 +50,7 @@
 #include <libgimp/gimpui.h>
 
 #include <png.h>                /* PNG library definitions */
+#include <zlib.h>
 
 #include "libgimp/stdplugins-intl.h"
 
@@ -73,6 +75,11 @@
 
 #define PNG_DEFAULTS_PARASITE  "png-save-defaults"
 
+#define DEFLATE_BLOCK_SIZE     (128 * 1024)
+#define DEFLATE_DICT_SIZE      (32 * 1024)
+#define DEFLATE_MAX_THREADS    16
+#define PNG_N_FILTERS          5
+
 /*
  * Structures...
  */
@@ -127,6 +134,43 @@ typedef struct
 }
 PngGlobals;
 
+typedef struct
+{
+  const guchar *input;
+  gsize         input_size;
+  const guchar *dict;
+  gsize         dict_size;
+  gint          level;
+  gint          strategy;
+  gboolean      last;
+  guchar       *output;
+  gsize         output_size;
+  guint32       adler;
+  gboolean      success;
+}
+DeflateBlock;
+
+typedef struct
+{
+  png_structp  pp;
+  gint         level;
+  gint         n_threads;
+  gsize        row_bytes;
+  gint         filter_bpp;
+  gboolean     filter;
+  gboolean     swap;
+  guchar      *prev_row;
+  guchar      *row;
+  guchar      *filtered[PNG_N_FILTERS];
+  guchar      *input;
+  gsize        input_size;
+  guchar       dict[DEFLATE_DICT_SIZE];
+  gsize        dict_size;
+  guint32      adler;
+  GByteArray  *output;
+}
+PngDeflate;
+
 
 /*
  * Local functions...
@@ -155,6 +199,18 @@ static int       respin_cmap               (png_structp       pp,
                                             gint32            image_ID,
                                             gint32            drawable_ID);
 
+static PngDeflate *png_deflate_new         (png_structp       pp,
+                                            gint              level,
+                                            gsize             row_bytes,
+                                            gint              filter_bpp,
+                                            gboolean          filter,
+                                            gboolean          swap);
+static void      png_deflate_free          (PngDeflate       *deflater);
+static void      png_deflate_write_rows    (PngDeflate       *deflater,
+                                            guchar          **rows,
+                                            gint              n_rows);
+static void      png_deflate_finish        (PngDeflate       *deflater);
+
 static gboolean  save_dialog               (gint32            image_ID,
                                             gboolean          alpha);
 
@@ -424,6 +480,11 @@ run (const gchar      *name,
   INIT_I18N ();
   gegl_init (NULL, NULL);
 
+  /*  batch conversions load and save many files in a row, so keep the
+   *  process around for the next call instead of starting it again
+   */
+  gimp_plugin_set_resident (run_mode == GIMP_RUN_NONINTERACTIVE);
+
   *nreturn_vals = 1;
   *return_vals = values;
 
@@ -1437,6 +1498,7 @@ save_image (const gchar  *filename,
   png_time mod_time;            /* Modification time (ie NOW) */
   time_t cutime;                /* Time since epoch */
   struct tm *gmt;               /* GMT broken down */
+  PngDeflate *deflater = NULL;   /* Parallel IDAT compressor */
   int color_type;
   int bit_depth;
 
@@ -1797,6 +1859,25 @@ save_image (const gchar  *filename,
       bit_depth < 8)
     png_set_packing (pp);
 
+  /*
+   * Compress large non-interlaced images on all cores, doing the
+   * filtering and byte swapping libpng would do ourselves...
+   */
+
+  if (num_passes == 1 && bit_depth >= 8 &&
+      pngvals.compression_level > 0 &&
+      g_get_num_processors () > 1 &&
+      (gsize) png_get_rowbytes (pp, info) * height > 2 * DEFLATE_BLOCK_SIZE)
+    {
+      deflater = png_deflate_new (pp, pngvals.compression_level,
+                                 png_get_rowbytes (pp, info),
+                                 MAX (png_get_channels (pp, info) *
+                                      bit_depth / 8, 1),
+                                 color_type != PNG_COLOR_TYPE_PALETTE,
+                                 bit_depth == 16 &&
+                                 G_BYTE_ORDER == G_LITTLE_ENDIAN);
+    }
+
   /*
    * Allocate memory for "tile_height" rows and save the image...
    */
@@ -1894,7 +1975,10 @@ save_image (const gchar  *filename,
                 }
             }
 
-          png_write_rows (pp, pixels, num);
+          if (deflater)
+            png_deflate_write_rows (deflater, pixels, num);
+          else
+            png_write_rows (pp, pixels, num);
 
           gimp_progress_update (((double) pass + (double) end /
                                  (double) height) /
@@ -1902,9 +1986,23 @@ save_image (const gchar  *filename,
         }
     }
 
+  if (deflater)
+    {
+      png_deflate_finish (deflater);
+      png_deflate_free (deflater);
+
+      /*  everything else was written by png_write_info(), and
+       *  png_write_end() refuses to run without its own IDAT
+       */
+      png_write_chunk (pp, (png_const_bytep) "IEND", NULL, 0);
+    }
+  else
+    {
+      png_write_end (pp, info);
+    }
+
   gimp_progress_update (1.0);
 
-  png_write_end (pp, info);
   png_destroy_write_struct (&pp, &info);
 
   g_free (pixel);
@@ -1928,6 +2026,376 @@ save_image (const gchar  *filename,
   return TRUE;
 }
 
+/*
+ * Parallel deflate for non-interlaced saves.  The filtered scanlines
+ * are cut into DEFLATE_BLOCK_SIZE blocks which are compressed on
+ * separate threads as raw deflate streams, each primed with the last
+ * 32k of the data before it and ended on a byte boundary with a sync
+ * flush, so that simply concatenating them (between a zlib header and
+ * the adler32 of the whole data) yields a single valid zlib stream for
+ * the IDAT chunks.
+ */
+
+static PngDeflate *
+png_deflate_new (png_structp pp,
+                 gint        level,
+                 gsize       row_bytes,
+                 gint        filter_bpp,
+                 gboolean    filter,
+                 gboolean    swap)
+{
+  PngDeflate *deflater = g_slice_new0 (PngDeflate);
+  gint        i;
+
+  deflater->pp         = pp;
+  deflater->level      = level;
+  deflater->n_threads  = CLAMP (g_get_num_processors (),
+                               1, DEFLATE_MAX_THREADS);
+  deflater->row_bytes  = row_bytes;
+  deflater->filter_bpp = filter_bpp;
+  deflater->filter     = filter;
+  deflater->swap       = swap;
+
+  deflater->prev_row = g_malloc0 (row_bytes);
+  deflater->row      = g_malloc (row_bytes);
+
+  for (i = 0; i < PNG_N_FILTERS; i++)
+    deflater->filtered[i] = g_malloc (row_bytes + 1);
+
+  deflater->input  = g_malloc (deflater->n_threads * DEFLATE_BLOCK_SIZE +
+                               row_bytes + 1);
+  deflater->output = g_byte_array_new ();
+  deflater->adler  = adler32 (0, NULL, 0);
+
+  /*  the zlib stream header: 32k window, deflate, level hint  */
+  {
+    guint8 cmf = 0x78;
+    guint8 flg;
+
+    if (level < 2)
+      flg = 0 << 6;
+    else if (level < 6)
+      flg = 1 << 6;
+    else if (level == 6)
+      flg = 2 << 6;
+    else
+      flg = 3 << 6;
+
+    flg += 31 - ((cmf << 8) + flg) % 31;
+
+    g_byte_array_append (deflater->output, &cmf, 1);
+    g_byte_array_append (deflater->output, &flg, 1);
+  }
+
+  return deflater;
+}
+
+static void
+png_deflate_free (PngDeflate *deflater)
+{
+  gint i;
+
+  g_free (deflater->prev_row);
+  g_free (deflater->row);
+
+  for (i = 0; i < PNG_N_FILTERS; i++)
+    g_free (deflater->filtered[i]);
+
+  g_free (deflater->input);
+  g_byte_array_free (deflater->output, TRUE);
+
+  g_slice_free (PngDeflate, deflater);
+}
+
+static inline guint
+png_filter_cost (const guchar *filtered,
+                 gsize         n)
+{
+  guint sum = 0;
+  gsize i;
+
+  /*  libpng's heuristic: the sum of the bytes taken as signed values  */
+  for (i = 0; i < n; i++)
+    sum += filtered[i] < 128 ? filtered[i] : 256 - filtered[i];
+
+  return sum;
+}
+
+static const guchar *
+png_filter_row (PngDeflate   *deflater,
+                const guchar *row)
+{
+  const guchar *prev = deflater->prev_row;
+  gsize         n    = deflater->row_bytes;
+  gint          bpp  = deflater->filter_bpp;
+  guchar       *out;
+  guint         best_cost;
+  gint          best;
+  gint          f;
+  gsize         i;
+
+  out = deflater->filtered[PNG_FILTER_VALUE_NONE];
+  out[0] = PNG_FILTER_VALUE_NONE;
+  memcpy (out + 1, row, n);
+
+  if (! deflater->filter)
+    return out;
+
+  /*  keep each filter a plain loop over bytes so they vectorize  */
+  out = deflater->filtered[PNG_FILTER_VALUE_SUB] + 1;
+  for (i = 0; i < bpp; i++)
+    out[i] = row[i];
+  for (i = bpp; i < n; i++)
+    out[i] = row[i] - row[i - bpp];
+
+  out = deflater->filtered[PNG_FILTER_VALUE_UP] + 1;
+  for (i = 0; i < n; i++)
+    out[i] = row[i] - prev[i];
+
+  out = deflater->filtered[PNG_FILTER_VALUE_AVG] + 1;
+  for (i = 0; i < bpp; i++)
+    out[i] = row[i] - (prev[i] >> 1);
+  for (i = bpp; i < n; i++)
+    out[i] = row[i] - ((row[i - bpp] + prev[i]) >> 1);
+
+  out = deflater->filtered[PNG_FILTER_VALUE_PAETH] + 1;
+  for (i = 0; i < bpp; i++)
+    out[i] = row[i] - prev[i];
+  for (i = bpp; i < n; i++)
+    {
+      gint a  = row[i - bpp];
+      gint b  = prev[i];
+      gint c  = prev[i - bpp];
+      gint pa = ABS (b - c);
+      gint pb = ABS (a - c);
+      gint pc = ABS (a + b - c - c);
+      gint p  = (pa <= pb && pa <= pc) ? a : (pb <= pc) ? b : c;
+
+      out[i] = row[i] - p;
+    }
+
+  best      = PNG_FILTER_VALUE_NONE;
+  best_cost = png_filter_cost (row, n);
+
+  for (f = PNG_FILTER_VALUE_SUB; f < PNG_N_FILTERS; f++)
+    {
+      guint cost;
+
+      deflater->filtered[f][0] = f;
+
+      cost = png_filter_cost (deflater->filtered[f] + 1, n);
+
+      if (cost < best_cost)
+        {
+          best      = f;
+          best_cost = cost;
+        }
+    }
+
+  return deflater->filtered[best];
+}
+
+static gpointer
+png_deflate_block (gpointer data)
+{
+  DeflateBlock *block = data;
+  z_stream      strm  = { 0, };
+  gsize         size;
+  gint          ret;
+
+  block->success = FALSE;
+  block->adler   = adler32 (adler32 (0, NULL, 0),
+                            block->input, block->input_size);
+
+  if (deflateInit2 (&strm, block->level, Z_DEFLATED, -15, 8,
+                    block->strategy) != Z_OK)
+    return NULL;
+
+  if (block->dict_size > 0 &&
+      deflateSetDictionary (&strm,
+                            block->dict, block->dict_size) != Z_OK)
+    {
+      deflateEnd (&strm);
+      return NULL;
+    }
+
+  /*  room for the data plus the empty stored block of the sync flush  */
+  size = deflateBound (&strm, block->input_size) + 16;
+
+  block->output = g_malloc (size);
+
+  strm.next_in   = (Bytef *) block->input;
+  strm.avail_in  = block->input_size;
+  strm.next_out  = block->output;
+  strm.avail_out = size;
+
+  ret = deflate (&strm, block->last ? Z_FINISH : Z_SYNC_FLUSH);
+
+  if ((block->last ? ret == Z_STREAM_END : ret == Z_OK) &&
+      strm.avail_in == 0 && strm.avail_out > 0)
+    {
+      block->output_size = size - strm.avail_out;
+      block->success     = TRUE;
+    }
+
+  deflateEnd (&strm);
+
+  return NULL;
+}
+
+static void
+png_deflate_blocks (PngDeflate *deflater,
+                    gsize       size,
+                    gboolean    last)
+{
+  DeflateBlock  blocks[DEFLATE_MAX_THREADS];
+  GThread      *threads[DEFLATE_MAX_THREADS];
+  gint          n_blocks;
+  gint          i;
+
+  n_blocks = MAX ((size + DEFLATE_BLOCK_SIZE - 1) / DEFLATE_BLOCK_SIZE, 1);
+
+  for (i = 0; i < n_blocks; i++)
+    {
+      DeflateBlock *block  = &blocks[i];
+      gsize         offset = (gsize) i * DEFLATE_BLOCK_SIZE;
+
+      block->input      = deflater->input + offset;
+      block->input_size = MIN (size - offset, DEFLATE_BLOCK_SIZE);
+      block->level      = deflater->level;
+      block->strategy   = deflater->filter ? Z_FILTERED : Z_DEFAULT_STRATEGY;
+      block->last       = last && i == n_blocks - 1;
+      block->output     = NULL;
+
+      if (i == 0)
+        {
+          block->dict      = deflater->dict;
+          block->dict_size = deflater->dict_size;
+        }
+      else
+        {
+          block->dict      = block->input - DEFLATE_DICT_SIZE;
+          block->dict_size = DEFLATE_DICT_SIZE;
+        }
+    }
+
+  for (i = 1; i < n_blocks; i++)
+    threads[i] = g_thread_new ("png-deflate", png_deflate_block, &blocks[i]);
+
+  png_deflate_block (&blocks[0]);
+
+  for (i = 1; i < n_blocks; i++)
+    g_thread_join (threads[i]);
+
+  for (i = 0; i < n_blocks; i++)
+    {
+      if (! blocks[i].success)
+        {
+          for (; i < n_blocks; i++)
+            g_free (blocks[i].output);
+
+          png_error (deflater->pp, "Compression failed");
+        }
+
+      g_byte_array_append (deflater->output,
+                           blocks[i].output, blocks[i].output_size);
+      g_free (blocks[i].output);
+
+      deflater->adler = adler32_combine (deflater->adler, blocks[i].adler,
+                                        blocks[i].input_size);
+    }
+
+  /*  remember the tail of the data as the next block's dictionary  */
+  if (size >= DEFLATE_DICT_SIZE)
+    {
+      memcpy (deflater->dict, deflater->input + size - DEFLATE_DICT_SIZE,
+              DEFLATE_DICT_SIZE);
+      deflater->dict_size = DEFLATE_DICT_SIZE;
+    }
+  else if (size > 0)
+    {
+      gsize keep = MIN (deflater->dict_size, DEFLATE_DICT_SIZE - size);
+
+      memmove (deflater->dict,
+               deflater->dict + deflater->dict_size - keep, keep);
+      memcpy (deflater->dict + keep, deflater->input, size);
+      deflater->dict_size = keep + size;
+    }
+
+  if (last)
+    {
+      guint8 adler[4];
+
+      adler[0] = deflater->adler >> 24;
+      adler[1] = deflater->adler >> 16;
+      adler[2] = deflater->adler >> 8;
+      adler[3] = deflater->adler;
+
+      g_byte_array_append (deflater->output, adler, 4);
+    }
+
+  if (deflater->output->len > 0)
+    {
+      png_write_chunk (deflater->pp, (png_const_bytep) "IDAT",
+                       deflater->output->data, deflater->output->len);
+
+      g_byte_array_set_size (deflater->output, 0);
+    }
+
+  deflater->input_size -= size;
+  memmove (deflater->input, deflater->input + size, deflater->input_size);
+}
+
+static void
+png_deflate_write_rows (PngDeflate  *deflater,
+                        guchar     **rows,
+                        gint         n_rows)
+{
+  gsize batch_size = (gsize) deflater->n_threads * DEFLATE_BLOCK_SIZE;
+  gint  i;
+
+  for (i = 0; i < n_rows; i++)
+    {
+      const guchar *row = rows[i];
+      const guchar *filtered;
+      guchar       *tmp;
+
+      if (deflater->swap)
+        {
+          const guint16 *src = (const guint16 *) row;
+          guint16       *dest = (guint16 *) deflater->row;
+          gsize          j;
+
+          for (j = 0; j < deflater->row_bytes / 2; j++)
+            dest[j] = GUINT16_TO_BE (src[j]);
+        }
+      else
+        {
+          memcpy (deflater->row, row, deflater->row_bytes);
+        }
+
+      filtered = png_filter_row (deflater, deflater->row);
+
+      memcpy (deflater->input + deflater->input_size,
+              filtered, deflater->row_bytes + 1);
+      deflater->input_size += deflater->row_bytes + 1;
+
+      /*  the unfiltered row is the next row's "prior" row  */
+      tmp               = deflater->prev_row;
+      deflater->prev_row = deflater->row;
+      deflater->row      = tmp;
+
+      if (deflater->input_size >= batch_size)
+        png_deflate_blocks (deflater, batch_size, FALSE);
+    }
+}
+
+static void
+png_deflate_finish (PngDeflate *deflater)
+{
+  png_deflate_blocks (deflater, deflater->input_size, TRUE);
+}
+
 static gboolean
 ia_has_transparent_pixels (GeglBuffer *buffer)
 {
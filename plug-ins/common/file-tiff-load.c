@@ -59,6 +59,10 @@
 #define PLUG_IN_BINARY "file-tiff-load"
 #define PLUG_IN_ROLE   "gimp-file-tiff-load"
 
+#define TIFF_MAX_THREADS      16
+#define TIFF_MIN_BAND_HEIGHT  64
+#define TIFF_MAX_STRIP_SIZE   (64 * 1024 * 1024)
+
 
 typedef struct
 {
@@ -83,6 +87,35 @@ typedef struct
   gint *pages;
 } TiffSelectedPages;
 
+typedef struct
+{
+  TIFF     *tifs[TIFF_MAX_THREADS];   /* one handle per thread       */
+  guchar   *units[TIFF_MAX_THREADS];  /* one strip or tile of memory */
+  gint      n_threads;
+  gboolean  tiled;
+  gboolean  by_scanline;
+  guint32   width;
+  guint32   height;
+  guint32   unit_width;
+  guint32   unit_height;
+  gsize     unit_row_size;
+  gsize     pixel_size;
+  gsize     stride;
+  guchar   *band;
+  guint32   band_y;
+  guint32   band_height;
+  guint32   n_units;
+  guint16   sample;
+} TiffReader;
+
+typedef struct
+{
+  TiffReader *reader;
+  gint        thread;
+  gint        n_jobs;
+  gboolean    success;
+} TiffReaderJob;
+
 
 /* Declare some local functions.
  */
@@ -105,12 +138,14 @@ static gint32    load_image       (const gchar        *filename,
 static void      load_rgba        (TIFF               *tif,
                                    ChannelData        *channel);
 static void      load_contiguous  (TIFF               *tif,
+                                   const gchar        *filename,
                                    ChannelData        *channel,
                                    const Babl         *type,
                                    gushort             bps,
                                    gushort             spp,
                                    gint                extra);
 static void      load_separate    (TIFF               *tif,
+                                   const gchar        *filename,
                                    ChannelData        *channel,
                                    const Babl         *type,
                                    gushort             bps,
@@ -129,6 +164,14 @@ static TIFF    * tiff_open        (const gchar        *filename,
                                    const gchar        *mode,
                                    GError            **error);
 
+static TiffReader * tiff_reader_new       (TIFF         *tif,
+                                           const gchar  *filename,
+                                           gsize         pixel_size);
+static void         tiff_reader_free      (TiffReader   *reader);
+static guint32      tiff_reader_read_band (TiffReader   *reader,
+                                           guint32       y,
+                                           guint16       sample);
+
 
 const GimpPlugInInfo PLUG_IN_INFO =
 {
@@ -146,6 +189,11 @@ static TiffSaveVals tsvals =
 
 static GimpPageSelectorTarget target = GIMP_PAGE_SELECTOR_TARGET_LAYERS;
 
+/*  libtiff's warning and error handlers are global, only the thread
+ *  in here gets its messages shown
+ */
+static GThread *tiff_message_thread = NULL;
+
 
 MAIN ()
 
@@ -207,6 +255,8 @@ run (const gchar      *name,
   values[0].type          = GIMP_PDB_STATUS;
   values[0].data.d_status = GIMP_PDB_EXECUTION_ERROR;
 
+  tiff_message_thread = g_thread_self ();
+
   TIFFSetWarningHandler (tiff_warning);
   TIFFSetErrorHandler (tiff_error);
 
@@ -343,6 +393,9 @@ tiff_warning (const gchar *module,
 {
   int tag = 0;
 
+  if (g_thread_self () != tiff_message_thread)
+    return;
+
   if (! strcmp (fmt, "%s: unknown field with tag %d (0x%x) encountered"))
     {
       va_list ap_test;
@@ -387,6 +440,9 @@ tiff_error (const gchar *module,
             const gchar *fmt,
             va_list      ap)
 {
+  if (g_thread_self () != tiff_message_thread)
+    return;
+
   /* Workaround for: http://bugzilla.gnome.org/show_bug.cgi?id=132297 */
   /* Ignore the errors related to random access and JPEG compression */
   if (! strcmp (fmt, "Compression algorithm does not support random access"))
@@ -418,6 +474,244 @@ tiff_open (const gchar  *filename,
 #endif
 }
 
+/*  Strips and tiles are independent, so they are decoded for a band of
+ *  rows at a time on several threads, each with its own TIFF handle on
+ *  the file, and the band is then written to the drawables in one go.
+ *  Files stored as one huge strip are read scanline by scanline.
+ */
+
+static TiffReader *
+tiff_reader_new (TIFF        *tif,
+                 const gchar *filename,
+                 gsize        pixel_size)
+{
+  TiffReader *reader = g_slice_new0 (TiffReader);
+  guint32     units_across;
+  guint32     band_units;
+  gsize       unit_size;
+  gint        i;
+
+  TIFFGetField (tif, TIFFTAG_IMAGEWIDTH, &reader->width);
+  TIFFGetField (tif, TIFFTAG_IMAGELENGTH, &reader->height);
+
+  reader->pixel_size = pixel_size;
+  reader->tiled      = TIFFIsTiled (tif);
+
+  if (reader->tiled)
+    {
+      TIFFGetField (tif, TIFFTAG_TILEWIDTH, &reader->unit_width);
+      TIFFGetField (tif, TIFFTAG_TILELENGTH, &reader->unit_height);
+
+      reader->unit_row_size = TIFFTileRowSize (tif);
+      unit_size             = TIFFTileSize (tif);
+    }
+  else
+    {
+      TIFFGetFieldDefaulted (tif, TIFFTAG_ROWSPERSTRIP, &reader->unit_height);
+
+      reader->unit_width    = reader->width;
+      reader->unit_height   = MIN (reader->unit_height, reader->height);
+      reader->unit_row_size = TIFFScanlineSize (tif);
+      unit_size             = TIFFStripSize (tif);
+
+      if (unit_size > TIFF_MAX_STRIP_SIZE)
+        {
+          reader->by_scanline = TRUE;
+          reader->unit_height = 1;
+          unit_size           = reader->unit_row_size;
+        }
+    }
+
+  units_across = (reader->width + reader->unit_width - 1) / reader->unit_width;
+
+  if (reader->by_scanline)
+    reader->n_threads = 1;
+  else
+    reader->n_threads = CLAMP (g_get_num_processors (), 1, TIFF_MAX_THREADS);
+
+  /*  give every thread a couple of units, but keep bands at least
+   *  TIFF_MIN_BAND_HEIGHT rows high so the drawables are written in
+   *  big chunks
+   */
+  band_units = MAX ((2 * reader->n_threads + units_across - 1) / units_across,
+                    (TIFF_MIN_BAND_HEIGHT + reader->unit_height - 1) /
+                    reader->unit_height);
+
+  reader->band_height = MIN (band_units * reader->unit_height,
+                             reader->height);
+  reader->stride      = MAX ((gsize) reader->width * pixel_size,
+                             reader->unit_row_size);
+  reader->band        = g_malloc0 (reader->stride * reader->band_height);
+
+  reader->tifs[0] = tif;
+
+  /*  don't repeat the first handle's warnings for every other one  */
+  tiff_message_thread = NULL;
+
+  for (i = 1; i < reader->n_threads; i++)
+    {
+      reader->tifs[i] = tiff_open (filename, "r", NULL);
+
+      if (! reader->tifs[i] ||
+          ! TIFFSetDirectory (reader->tifs[i], TIFFCurrentDirectory (tif)))
+        {
+          if (reader->tifs[i])
+            TIFFClose (reader->tifs[i]);
+
+          reader->tifs[i] = NULL;
+          break;
+        }
+    }
+
+  tiff_message_thread = g_thread_self ();
+
+  reader->n_threads = i;
+
+  for (i = 0; i < reader->n_threads; i++)
+    reader->units[i] = g_malloc (unit_size);
+
+  return reader;
+}
+
+static void
+tiff_reader_free (TiffReader *reader)
+{
+  gint i;
+
+  for (i = 0; i < reader->n_threads; i++)
+    {
+      if (i > 0)
+        TIFFClose (reader->tifs[i]);
+
+      g_free (reader->units[i]);
+    }
+
+  g_free (reader->band);
+
+  g_slice_free (TiffReader, reader);
+}
+
+static gboolean
+tiff_reader_decode (TiffReader *reader,
+                    gint        thread,
+                    guint32     unit)
+{
+  TIFF    *tif          = reader->tifs[thread];
+  guchar  *data         = reader->units[thread];
+  guint32  units_across = ((reader->width + reader->unit_width - 1) /
+                           reader->unit_width);
+  guint32  x            = (unit % units_across) * reader->unit_width;
+  guint32  y            = reader->band_y +
+                          (unit / units_across) * reader->unit_height;
+  guint32  cols         = MIN (reader->unit_width, reader->width - x);
+  guint32  rows         = MIN (reader->unit_height, reader->height - y);
+  gsize    row_size;
+  gboolean success;
+  guint32  r;
+
+  if (reader->tiled)
+    success = TIFFReadEncodedTile (tif,
+                                   TIFFComputeTile (tif, x, y, 0,
+                                                    reader->sample),
+                                   data, (tsize_t) -1) >= 0;
+  else if (reader->by_scanline)
+    success = TIFFReadScanline (tif, data, y, reader->sample) >= 0;
+  else
+    success = TIFFReadEncodedStrip (tif,
+                                    TIFFComputeStrip (tif, y,
+                                                      reader->sample),
+                                    data, (tsize_t) -1) >= 0;
+
+  row_size = MIN ((gsize) cols * reader->pixel_size, reader->unit_row_size);
+
+  for (r = 0; r < rows; r++)
+    {
+      memcpy (reader->band + (y - reader->band_y + r) * reader->stride +
+              x * reader->pixel_size,
+              data + r * reader->unit_row_size,
+              row_size);
+    }
+
+  return success;
+}
+
+static gpointer
+tiff_reader_thread (gpointer data)
+{
+  TiffReaderJob *job    = data;
+  TiffReader    *reader = job->reader;
+  guint32        unit;
+
+  job->success = TRUE;
+
+  for (unit = job->thread; unit < reader->n_units; unit += job->n_jobs)
+    {
+      if (! tiff_reader_decode (reader, job->thread, unit))
+        job->success = FALSE;
+    }
+
+  return NULL;
+}
+
+/*  decodes the rows starting at y of the given sample into
+ *  reader->band and returns how many rows that are
+ */
+static guint32
+tiff_reader_read_band (TiffReader *reader,
+                       guint32     y,
+                       guint16     sample)
+{
+  TiffReaderJob  jobs[TIFF_MAX_THREADS];
+  GThread       *threads[TIFF_MAX_THREADS];
+  guint32        units_across;
+  guint32        rows;
+  gint           n_threads;
+  gboolean       success = TRUE;
+  gint           i;
+
+  units_across = (reader->width + reader->unit_width - 1) / reader->unit_width;
+  rows         = MIN (reader->band_height, reader->height - y);
+
+  reader->band_y  = y;
+  reader->sample  = sample;
+  reader->n_units = units_across *
+                    ((rows + reader->unit_height - 1) / reader->unit_height);
+
+  n_threads = MIN (reader->n_threads, reader->n_units);
+
+  for (i = 0; i < n_threads; i++)
+    {
+      jobs[i].reader = reader;
+      jobs[i].thread = i;
+      jobs[i].n_jobs = n_threads;
+    }
+
+  for (i = 1; i < n_threads; i++)
+    threads[i] = g_thread_new ("tiff-load", tiff_reader_thread, &jobs[i]);
+
+  tiff_reader_thread (&jobs[0]);
+
+  for (i = 1; i < n_threads; i++)
+    {
+      g_thread_join (threads[i]);
+
+      success = success && jobs[i].success;
+    }
+
+  /*  libtiff's messages are only shown for the main thread, so decode
+   *  the band again on our own handle if another one ran into trouble
+   */
+  if (! success)
+    {
+      guint32 unit;
+
+      for (unit = 0; unit < reader->n_units; unit++)
+        tiff_reader_decode (reader, 0, unit);
+    }
+
+  return rows;
+}
+
 /* returns a pointer into the TIFF */
 static const gchar *
 tiff_get_page_name (TIFF *tif)
@@ -1142,11 +1436,11 @@ load_image (const gchar        *filename,
         }
       else if (planar == PLANARCONFIG_CONTIG)
         {
-          load_contiguous (tif, channel, type, bps, spp, extra);
+          load_contiguous (tif, filename, channel, type, bps, spp, extra);
         }
       else
         {
-          load_separate (tif, channel, type, bps, spp, extra);
+          load_separate (tif, filename, channel, type, bps, spp, extra);
         }
 
       if (TIFFGetField (tif, TIFFTAG_ORIENTATION, &orientation))
@@ -1501,22 +1795,21 @@ load_paths (TIFF *tif, gint image)
 
 static void
 load_contiguous (TIFF        *tif,
+                 const gchar *filename,
                  ChannelData *channel,
                  const Babl  *type,
                  gushort      bps,
                  gushort      spp,
                  gint         extra)
 {
+  TiffReader         *reader;
   uint32              imageWidth, imageLength;
-  uint32              tileWidth, tileLength;
-  uint32              x, y, rows, cols;
+  uint32              y, rows;
   gint                bytes_per_pixel;
+  gint                src_bpp;
   GeglBuffer         *src_buf;
   const Babl         *src_format;
   GeglBufferIterator *iter;
-  guchar             *buffer;
-  gdouble             progress = 0.0;
-  gdouble             one_row;
   gint                i;
 
   g_printerr ("%s\n", __func__);
@@ -1524,120 +1817,92 @@ load_contiguous (TIFF        *tif,
   TIFFGetField (tif, TIFFTAG_IMAGEWIDTH, &imageWidth);
   TIFFGetField (tif, TIFFTAG_IMAGELENGTH, &imageLength);
 
-  tileWidth = imageWidth;
-
-  if (TIFFIsTiled (tif))
-    {
-      TIFFGetField (tif, TIFFTAG_TILEWIDTH, &tileWidth);
-      TIFFGetField (tif, TIFFTAG_TILELENGTH, &tileLength);
-      buffer = g_malloc (TIFFTileSize (tif));
-    }
-  else
-    {
-      tileWidth = imageWidth;
-      tileLength = 1;
-      buffer = g_malloc (TIFFScanlineSize (tif));
-    }
-
-  one_row = (gdouble) tileLength / (gdouble) imageLength;
-
   src_format = babl_format_n (type, spp);
+  src_bpp    = babl_format_get_bytes_per_pixel (src_format);
 
   /* consistency check */
   bytes_per_pixel = 0;
   for (i = 0; i <= extra; i++)
     bytes_per_pixel += babl_format_get_bytes_per_pixel (channel[i].format);
 
-  g_printerr ("bytes_per_pixel: %d, format: %d\n", bytes_per_pixel,
-              babl_format_get_bytes_per_pixel (src_format));
+  g_printerr ("bytes_per_pixel: %d, format: %d\n", bytes_per_pixel, src_bpp);
+
+  reader = tiff_reader_new (tif, filename, src_bpp);
 
-  for (y = 0; y < imageLength; y += tileLength)
+  for (y = 0; y < imageLength; y += rows)
     {
-      for (x = 0; x < imageWidth; x += tileWidth)
-        {
-          int offset;
+      gint offset;
 
-          gimp_progress_update (progress + one_row *
-                                ( (gdouble) x / (gdouble) imageWidth));
+      rows = tiff_reader_read_band (reader, y, 0);
 
-          if (TIFFIsTiled (tif))
-            TIFFReadTile (tif, buffer, x, y, 0, 0);
-          else
-            TIFFReadScanline (tif, buffer, y, 0);
+      src_buf = gegl_buffer_linear_new_from_data (reader->band,
+                                                  src_format,
+                                                  GEGL_RECTANGLE (0, 0, imageWidth, rows),
+                                                  reader->stride,
+                                                  NULL, NULL);
 
-          cols = MIN (imageWidth - x, tileWidth);
-          rows = MIN (imageLength - y, tileLength);
+      offset = 0;
 
-          src_buf = gegl_buffer_linear_new_from_data (buffer,
-                                                      src_format,
-                                                      GEGL_RECTANGLE (0, 0, cols, rows),
-                                                      tileWidth * bytes_per_pixel,
-                                                      NULL, NULL);
+      for (i = 0; i <= extra; i++)
+        {
+          gint dest_bpp;
 
-          offset = 0;
+          dest_bpp = babl_format_get_bytes_per_pixel (channel[i].format);
 
-          for (i = 0; i <= extra; i++)
-            {
-              gint src_bpp, dest_bpp;
+          iter = gegl_buffer_iterator_new (src_buf,
+                                           GEGL_RECTANGLE (0, 0, imageWidth, rows),
+                                           0, NULL,
+                                           GEGL_ACCESS_READ,
+                                           GEGL_ABYSS_NONE);
+          gegl_buffer_iterator_add (iter, channel[i].buffer,
+                                    GEGL_RECTANGLE (0, y, imageWidth, rows),
+                                    0, channel[i].format,
+                                    GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
 
-              src_bpp = babl_format_get_bytes_per_pixel (src_format);
-              dest_bpp = babl_format_get_bytes_per_pixel (channel[i].format);
+          while (gegl_buffer_iterator_next (iter))
+            {
+              guchar *s      = iter->data[0];
+              guchar *d      = iter->data[1];
+              gint    length = iter->length;
 
-              iter = gegl_buffer_iterator_new (src_buf,
-                                               GEGL_RECTANGLE (0, 0, cols, rows),
-                                               0, NULL,
-                                               GEGL_ACCESS_READ,
-                                               GEGL_ABYSS_NONE);
-              gegl_buffer_iterator_add (iter, channel[i].buffer,
-                                        GEGL_RECTANGLE (x, y, cols, rows),
-                                        0, channel[i].format,
-                                        GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
+              s += offset;
 
-              while (gegl_buffer_iterator_next (iter))
+              while (length--)
                 {
-                  guchar *s      = iter->data[0];
-                  guchar *d      = iter->data[1];
-                  gint    length = iter->length;
-
-                  s += offset;
-
-                  while (length--)
-                    {
-                      memcpy (d, s, dest_bpp);
-                      d += dest_bpp;
-                      s += src_bpp;
-                    }
+                  memcpy (d, s, dest_bpp);
+                  d += dest_bpp;
+                  s += src_bpp;
                 }
-
-              offset += dest_bpp;
             }
 
-          g_object_unref (src_buf);
+          offset += dest_bpp;
         }
 
-      progress += one_row;
+      g_object_unref (src_buf);
+
+      gimp_progress_update ((gdouble) (y + rows) / (gdouble) imageLength);
     }
+
+  tiff_reader_free (reader);
 }
 
 
 static void
 load_separate (TIFF        *tif,
+               const gchar *filename,
                ChannelData *channel,
                const Babl  *type,
                gushort      bps,
                gushort      spp,
                gint         extra)
 {
+  TiffReader         *reader;
   guint32             imageWidth, imageLength;
-  guint32             tileWidth, tileLength;
-  guint32             rows, cols;
   gint                bytes_per_pixel;
+  gint                src_bpp;
   GeglBuffer         *src_buf;
   const Babl         *src_format;
   GeglBufferIterator *iter;
-  guchar             *buffer;
-  gdouble             progress = 0.0;
-  gdouble             one_row;
   gint                i, compindex;
 
   g_printerr ("%s\n", __func__);
@@ -1645,113 +1910,87 @@ load_separate (TIFF        *tif,
   TIFFGetField (tif, TIFFTAG_IMAGEWIDTH, &imageWidth);
   TIFFGetField (tif, TIFFTAG_IMAGELENGTH, &imageLength);
 
-  tileWidth = imageWidth;
-
-  if (TIFFIsTiled (tif))
-    {
-      TIFFGetField (tif, TIFFTAG_TILEWIDTH, &tileWidth);
-      TIFFGetField (tif, TIFFTAG_TILELENGTH, &tileLength);
-      buffer = g_malloc (TIFFTileSize (tif));
-    }
-  else
-    {
-      tileWidth = imageWidth;
-      tileLength = 1;
-      buffer = g_malloc (TIFFScanlineSize (tif));
-    }
-
-  one_row = (gdouble) tileLength / (gdouble) imageLength;
-
   src_format = babl_format_n (type, 1);
+  src_bpp    = babl_format_get_bytes_per_pixel (src_format);
 
   /* consistency check */
   bytes_per_pixel = 0;
   for (i = 0; i <= extra; i++)
     bytes_per_pixel += babl_format_get_bytes_per_pixel (channel[i].format);
 
-  g_printerr ("bytes_per_pixel: %d, format: %d\n", bytes_per_pixel,
-              babl_format_get_bytes_per_pixel (src_format));
+  g_printerr ("bytes_per_pixel: %d, format: %d\n", bytes_per_pixel, src_bpp);
+
+  reader = tiff_reader_new (tif, filename, src_bpp);
 
   compindex = 0;
 
   for (i = 0; i <= extra; i++)
     {
-      gint src_bpp, dest_bpp;
+      gint dest_bpp;
       gint n_comps, j, offset;
 
       n_comps  = babl_format_get_n_components (channel[i].format);
-      src_bpp  = babl_format_get_bytes_per_pixel (src_format);
       dest_bpp = babl_format_get_bytes_per_pixel (channel[i].format);
 
       offset = 0;
 
       for (j = 0; j < n_comps; j++)
         {
-          guint32 y, x;
+          guint32 y, rows;
 
-          for (y = 0; y < imageLength; y += tileLength)
+          for (y = 0; y < imageLength; y += rows)
             {
-              for (x = 0; x < imageWidth; x += tileWidth)
-                {
-                  gimp_progress_update (progress + one_row *
-                                        ( (gdouble) x / (gdouble) imageWidth));
+              rows = tiff_reader_read_band (reader, y, compindex);
 
-                  if (TIFFIsTiled (tif))
-                    TIFFReadTile (tif, buffer, x, y, 0, compindex);
-                  else
-                    TIFFReadScanline (tif, buffer, y, compindex);
-
-                  cols = MIN (imageWidth - x, tileWidth);
-                  rows = MIN (imageLength - y, tileLength);
-
-                  src_buf = gegl_buffer_linear_new_from_data (buffer,
-                                                              src_format,
-                                                              GEGL_RECTANGLE (0, 0, cols, rows),
-                                                              GEGL_AUTO_ROWSTRIDE,
-                                                              NULL, NULL);
-
-                  iter = gegl_buffer_iterator_new (src_buf,
-                                                   GEGL_RECTANGLE (0, 0, cols, rows),
-                                                   0, NULL,
-                                                   GEGL_ACCESS_READ,
-                                                   GEGL_ABYSS_NONE);
-                  gegl_buffer_iterator_add (iter, channel[i].buffer,
-                                            GEGL_RECTANGLE (x, y, cols, rows),
-                                            0, channel[i].format,
-                                            GEGL_ACCESS_READWRITE,
-                                            GEGL_ABYSS_NONE);
-
-                  while (gegl_buffer_iterator_next (iter))
-                    {
-                      guchar *s      = iter->data[0];
-                      guchar *d      = iter->data[1];
-                      gint    length = iter->length;
+              src_buf = gegl_buffer_linear_new_from_data (reader->band,
+                                                          src_format,
+                                                          GEGL_RECTANGLE (0, 0, imageWidth, rows),
+                                                          reader->stride,
+                                                          NULL, NULL);
+
+              iter = gegl_buffer_iterator_new (src_buf,
+                                               GEGL_RECTANGLE (0, 0, imageWidth, rows),
+                                               0, NULL,
+                                               GEGL_ACCESS_READ,
+                                               GEGL_ABYSS_NONE);
+              gegl_buffer_iterator_add (iter, channel[i].buffer,
+                                        GEGL_RECTANGLE (0, y, imageWidth, rows),
+                                        0, channel[i].format,
+                                        GEGL_ACCESS_READWRITE,
+                                        GEGL_ABYSS_NONE);
 
-                      d += offset;
+              while (gegl_buffer_iterator_next (iter))
+                {
+                  guchar *s      = iter->data[0];
+                  guchar *d      = iter->data[1];
+                  gint    length = iter->length;
 
-                      while (length--)
-                        {
-                          memcpy (d, s, src_bpp);
-                          d += dest_bpp;
-                          s += src_bpp;
-                        }
-                    }
+                  d += offset;
 
-                  g_object_unref (src_buf);
+                  while (length--)
+                    {
+                      memcpy (d, s, src_bpp);
+                      d += dest_bpp;
+                      s += src_bpp;
+                    }
                 }
+
+              g_object_unref (src_buf);
+
+              gimp_progress_update (((gdouble) compindex +
+                                     (gdouble) (y + rows) /
+                                     (gdouble) imageLength) /
+                                    (gdouble) spp);
             }
 
           offset += src_bpp;
           compindex ++;
         }
-
-      progress += one_row;
     }
 
-  g_free (buffer);
+  tiff_reader_free (reader);
 }
 
-
 #if 0
 static void
 fill_bit2byte(void)
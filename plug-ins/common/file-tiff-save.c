@@ -60,6 +60,9 @@
 #define PLUG_IN_BINARY "file-tiff-save"
 #define PLUG_IN_ROLE   "gimp-file-tiff-save"
 
+/* classic TIFF has 32 bit file offsets, leave some room for the tags */
+#define TIFF_MAX_CLASSIC_DATA (G_MAXUINT32 - G_MAXUINT32 / 16)
+
 
 typedef struct
 {
@@ -70,6 +73,7 @@ typedef struct
   gboolean  save_xmp;
   gboolean  save_iptc;
   gboolean  save_thumbnail;
+  gboolean  bigtiff;
 } TiffSaveVals;
 
 typedef struct
@@ -141,7 +145,8 @@ static TiffSaveVals tsvals =
   TRUE,                /*  save exif           */
   TRUE,                /*  save xmp            */
   TRUE,                /*  save iptc           */
-  TRUE                 /*  save thumbnail      */
+  TRUE,                /*  save thumbnail      */
+  FALSE                /*  save as BigTIFF     */
 };
 
 static gchar *image_comment = NULL;
@@ -717,6 +722,7 @@ save_image (const gchar  *filename,
   gushort        compression;
   gushort        extra_samples[1];
   gboolean       alpha;
+  const gchar   *mode = "w";
   gshort         predictor;
   gshort         photometric;
   const Babl    *format;
@@ -956,7 +962,13 @@ save_image (const gchar  *filename,
         }
     }
 
-  tif = tiff_open (filename, "w", error);
+#ifdef TIFF_BIGTIFF_VERSION
+  if (tsvals.bigtiff ||
+      (guint64) bytesperrow * rows > TIFF_MAX_CLASSIC_DATA)
+    mode = "w8";
+#endif
+
+  tif = tiff_open (filename, mode, error);
 
   if (! tif)
     {
@@ -1260,6 +1272,17 @@ save_dialog (gboolean has_alpha,
                     G_CALLBACK (gimp_toggle_button_update),
                     &tsvals.save_transp_pixels);
 
+  toggle = GTK_WIDGET (gtk_builder_get_object (builder, "sv_bigtiff"));
+#ifdef TIFF_BIGTIFF_VERSION
+  gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (toggle),
+                                tsvals.bigtiff);
+  g_signal_connect (toggle, "toggled",
+                    G_CALLBACK (gimp_toggle_button_update),
+                    &tsvals.bigtiff);
+#else
+  gtk_widget_set_sensitive (toggle, FALSE);
+#endif
+
   entry = GTK_WIDGET (gtk_builder_get_object (builder, "commentfield"));
   gtk_entry_set_text (GTK_ENTRY (entry), image_comment ? image_comment : "");
 
@@ -116,22 +116,6 @@ static gboolean     lcms_image_apply_profile     (gint32           image,
                                                   GFile           *file,
                                                   GimpColorRenderingIntent intent,
                                                   gboolean          bpc);
-static void         lcms_image_transform_rgb     (gint32           image,
-                                                  cmsHPROFILE      src_profile,
-                                                  cmsHPROFILE      dest_profile,
-                                                  GimpColorRenderingIntent intent,
-                                                  gboolean          bpc);
-static void         lcms_layers_transform_rgb    (gint            *layers,
-                                                  gint             num_layers,
-                                                  cmsHPROFILE      src_profile,
-                                                  cmsHPROFILE      dest_profile,
-                                                  GimpColorRenderingIntent intent,
-                                                  gboolean          bpc);
-static void         lcms_image_transform_indexed (gint32           image,
-                                                  cmsHPROFILE      src_profile,
-                                                  cmsHPROFILE      dest_profile,
-                                                  GimpColorRenderingIntent intent,
-                                                  gboolean          bpc);
 
 static gboolean     lcms_icc_apply_dialog        (gint32           image,
                                                   cmsHPROFILE      src_profile,
@@ -801,15 +785,29 @@ lcms_image_apply_profile (gint32                    image,
                           GimpColorRenderingIntent  intent,
                           gboolean                  bpc)
 {
-  gchar  *src_label;
-  gchar  *dest_label;
-  gint32  saved_selection = -1;
+  gchar    *src_label;
+  gchar    *dest_label;
+  guint8   *profile_data;
+  gsize     profile_length;
+  gboolean  success;
+  GError   *error = NULL;
+
+  if (gimp_image_base_type (image) == GIMP_GRAY)
+    {
+      g_warning ("colorspace conversion not implemented for "
+                 "grayscale images");
 
-  gimp_image_undo_group_start (image);
+      return FALSE;
+    }
 
-  if (! lcms_image_set_profile (image, dest_profile, file))
+  profile_data = gimp_lcms_profile_save_to_data (dest_profile,
+                                                 &profile_length,
+                                                 &error);
+
+  if (! profile_data)
     {
-      gimp_image_undo_group_end (image);
+      g_message ("%s", error->message);
+      g_clear_error (&error);
 
       return FALSE;
     }
@@ -825,286 +823,28 @@ lcms_image_apply_profile (gint32                    image,
   g_free (dest_label);
   g_free (src_label);
 
-  if (! gimp_selection_is_empty (image))
-    {
-      saved_selection = gimp_selection_save (image);
-      gimp_selection_none (image);
-    }
-
-  switch (gimp_image_base_type (image))
-    {
-    case GIMP_RGB:
-      lcms_image_transform_rgb (image,
-                                src_profile, dest_profile, intent, bpc);
-      break;
+  gimp_image_undo_group_start (image);
 
-    case GIMP_GRAY:
-      g_warning ("colorspace conversion not implemented for "
-                 "grayscale images");
-      break;
+  /*  the core converts all layers in parallel and attaches the
+   *  new profile to the image
+   */
+  success = gimp_image_convert_color_profile (image,
+                                              profile_length, profile_data,
+                                              intent, bpc);
 
-    case GIMP_INDEXED:
-      lcms_image_transform_indexed (image,
-                                    src_profile, dest_profile, intent, bpc);
-      break;
-    }
+  g_free (profile_data);
 
-  if (saved_selection != -1)
-    {
-      gimp_image_select_item (image, GIMP_CHANNEL_OP_REPLACE, saved_selection);
-      gimp_image_remove_channel (image, saved_selection);
-    }
+  /*  converting to the default RGB profile leaves the image without
+   *  an attached profile
+   */
+  if (success && ! file)
+    success = lcms_image_set_profile (image, NULL, NULL);
 
   gimp_progress_update (1.0);
 
   gimp_image_undo_group_end (image);
 
-  return TRUE;
-}
-
-static void
-lcms_image_transform_rgb (gint32                    image,
-                          cmsHPROFILE               src_profile,
-                          cmsHPROFILE               dest_profile,
-                          GimpColorRenderingIntent  intent,
-                          gboolean                  bpc)
-{
-  gint *layers;
-  gint  num_layers;
-
-  layers = gimp_image_get_layers (image, &num_layers);
-
-  lcms_layers_transform_rgb (layers, num_layers,
-                             src_profile, dest_profile,
-                             intent, bpc);
-
-  g_free (layers);
-}
-
-static void
-lcms_layers_transform_rgb (gint                     *layers,
-                           gint                      num_layers,
-                           cmsHPROFILE               src_profile,
-                           cmsHPROFILE               dest_profile,
-                           GimpColorRenderingIntent  intent,
-                           gboolean                  bpc)
-{
-  gint i;
-
-  for (i = 0; i < num_layers; i++)
-    {
-      gint32           layer_id = layers[i];
-      const Babl      *layer_format;
-      gboolean         has_alpha;
-      const Babl      *type;
-      const Babl      *iter_format = NULL;
-      cmsUInt32Number  lcms_format = 0;
-      cmsHTRANSFORM    transform   = NULL;
-      gint            *children;
-      gint             num_children;
-
-      children = gimp_item_get_children (layer_id, &num_children);
-
-      if (children)
-        {
-          lcms_layers_transform_rgb (children, num_children,
-                                     src_profile, dest_profile,
-                                     intent, bpc);
-
-          g_free (children);
-
-          continue;
-        }
-
-      layer_format = gimp_drawable_get_format (layer_id);
-      has_alpha    = babl_format_has_alpha (layer_format);
-      type         = babl_format_get_type (layer_format, 0);
-
-      if (type == babl_type ("u8"))
-        {
-          if (has_alpha)
-            {
-              lcms_format = TYPE_RGBA_8;
-              iter_format = babl_format ("R'G'B'A u8");
-            }
-          else
-            {
-              lcms_format = TYPE_RGB_8;
-              iter_format = babl_format ("R'G'B' u8");
-            }
-        }
-      else if (type == babl_type ("u16"))
-        {
-          if (has_alpha)
-            {
-              lcms_format = TYPE_RGBA_16;
-              iter_format = babl_format ("R'G'B'A u16");
-            }
-          else
-            {
-              lcms_format = TYPE_RGB_16;
-              iter_format = babl_format ("R'G'B' u16");
-            }
-        }
-      else if (type == babl_type ("half")) /* 16-bit floating point (half) */
-        {
-          if (has_alpha)
-            {
-              lcms_format = TYPE_RGBA_HALF_FLT;
-              iter_format = babl_format ("R'G'B'A half");
-            }
-          else
-            {
-              lcms_format = TYPE_RGB_HALF_FLT;
-              iter_format = babl_format ("R'G'B' half");
-            }
-        }
-      else if (type == babl_type ("float"))
-        {
-          if (has_alpha)
-            {
-              lcms_format = TYPE_RGBA_FLT;
-              iter_format = babl_format ("R'G'B'A float");
-            }
-          else
-            {
-              lcms_format = TYPE_RGB_FLT;
-              iter_format = babl_format ("R'G'B' float");
-            }
-        }
-      else if (type == babl_type ("double"))
-        {
-          if (has_alpha)
-            {
-#ifdef TYPE_RGBA_DBL
-              /* RGBA double not implemented in lcms */
-              lcms_format = TYPE_RGBA_DBL;
-              iter_format = babl_format ("R'G'B'A double");
-#endif /* TYPE_RGBA_DBL */
-            }
-          else
-            {
-              lcms_format = TYPE_RGB_DBL;
-              iter_format = babl_format ("R'G'B' double");
-            }
-        }
-
-      if (lcms_format == 0)
-        {
-          g_printerr ("lcms: layer format %s not supported, "
-                      "falling back to float\n",
-                      babl_get_name (layer_format));
-
-          if (has_alpha)
-            {
-              lcms_format = TYPE_RGBA_FLT;
-              iter_format = babl_format ("R'G'B'A float");
-            }
-          else
-            {
-              lcms_format = TYPE_RGB_FLT;
-              iter_format = babl_format ("R'G'B' float");
-            }
-        }
-
-      transform = cmsCreateTransform (src_profile,  lcms_format,
-                                      dest_profile, lcms_format,
-                                      intent,
-                                      cmsFLAGS_NOOPTIMIZE |
-                                      (bpc ? cmsFLAGS_BLACKPOINTCOMPENSATION : 0));
-
-      if (transform)
-        {
-          GeglBuffer         *src_buffer;
-          GeglBuffer         *dest_buffer;
-          GeglBufferIterator *iter;
-          gint                layer_width;
-          gint                layer_height;
-          gint                layer_bpp;
-          gboolean            layer_alpha;
-          gdouble             progress_start = (gdouble) i / num_layers;
-          gdouble             progress_end   = (gdouble) (i + 1) / num_layers;
-          gdouble             range          = progress_end - progress_start;
-          gint                count          = 0;
-          gint                done           = 0;
-
-          src_buffer   = gimp_drawable_get_buffer (layer_id);
-          dest_buffer  = gimp_drawable_get_shadow_buffer (layer_id);
-          layer_width  = gegl_buffer_get_width (src_buffer);
-          layer_height = gegl_buffer_get_height (src_buffer);
-          layer_bpp    = babl_format_get_bytes_per_pixel (iter_format);
-          layer_alpha  = babl_format_has_alpha (iter_format);
-
-          iter = gegl_buffer_iterator_new (src_buffer, NULL, 0,
-                                           iter_format,
-                                           GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
-
-          gegl_buffer_iterator_add (iter, dest_buffer, NULL, 0,
-                                    iter_format,
-                                    GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
-
-          while (gegl_buffer_iterator_next (iter))
-            {
-              /*  lcms doesn't touch the alpha channel, simply
-               *  copy everything to dest before the transform
-               */
-              if (layer_alpha)
-                memcpy (iter->data[1], iter->data[0],
-                        iter->length * layer_bpp);
-
-              cmsDoTransform (transform,
-                              iter->data[0], iter->data[1], iter->length);
-            }
-
-          g_object_unref (src_buffer);
-          g_object_unref (dest_buffer);
-
-          gimp_drawable_merge_shadow (layer_id, TRUE);
-          gimp_drawable_update (layer_id, 0, 0, layer_width, layer_height);
-
-          if (count++ % 32 == 0)
-            {
-              gimp_progress_update (progress_start +
-                                    (gdouble) done /
-                                    (layer_width * layer_height) * range);
-            }
-
-          cmsDeleteTransform (transform);
-        }
-    }
-}
-
-static void
-lcms_image_transform_indexed (gint32                    image,
-                              cmsHPROFILE               src_profile,
-                              cmsHPROFILE               dest_profile,
-                              GimpColorRenderingIntent  intent,
-                              gboolean                  bpc)
-{
-  cmsHTRANSFORM    transform;
-  guchar          *cmap;
-  gint             n_cmap_bytes;
-  cmsUInt32Number  format = TYPE_RGB_8;
-
-  cmap = gimp_image_get_colormap (image, &n_cmap_bytes);
-
-  transform = cmsCreateTransform (src_profile,  format,
-                                  dest_profile, format,
-                                  intent,
-                                  cmsFLAGS_NOOPTIMIZE |
-                                  (bpc ? cmsFLAGS_BLACKPOINTCOMPENSATION : 0));
-
-  if (transform)
-    {
-      cmsDoTransform (transform, cmap, cmap, n_cmap_bytes / 3);
-      cmsDeleteTransform (transform);
-    }
-  else
-    {
-      g_warning ("cmsCreateTransform() failed!");
-    }
-
-  gimp_image_set_colormap (image, cmap, n_cmap_bytes);
+  return success;
 }
 
 static GtkWidget *
@@ -1,10 +1,10 @@
 %plugins = (
     'align-layers' => { ui => 1 },
-    'animation-optimize' => {},
+    'animation-optimize' => { gegl => 1 },
     'animation-play' => { ui => 1, gegl => 1 },
     'blinds' => { ui => 1 },
     'blur' => {},
-    'blur-gauss-selective' => { ui => 1, cflags => 'MMX_EXTRA_CFLAGS' },
+    'blur-gauss-selective' => { ui => 1, gegl => 1, cflags => 'MMX_EXTRA_CFLAGS' },
     'border-average' => { ui => 1, gegl => 1 },
     'bump-map' => { ui => 1 },
     'cartoon' => { ui => 1 },
@@ -23,7 +23,7 @@
     'depth-merge' => { ui => 1 },
     'despeckle' => { ui => 1 },
     'destripe' => { ui => 1 },
-    'displace' => { ui => 1 },
+    'displace' => { ui => 1, gegl => 1 },
     'edge-dog' => { ui => 1 },
     'edge-neon' => { ui => 1 },
     'emboss' => { ui => 1 },
@@ -46,7 +46,7 @@
     'file-pat' => { ui => 1, gegl => 1 },
     'file-pcx' => { ui => 1, gegl => 1 },
     'file-pix' => { ui => 1, gegl => 1 },
-    'file-png' => { ui => 1, gegl => 1, libs => 'PNG_LIBS', cflags => 'PNG_CFLAGS' },
+    'file-png' => { ui => 1, gegl => 1, libs => 'PNG_LIBS', libdep => 'Z', cflags => 'PNG_CFLAGS' },
     'file-pnm' => { ui => 1, gegl => 1 },
     'file-pdf-load' => { ui => 1, optional => 1, libs => 'POPPLER_LIBS', cflags => 'POPPLER_CFLAGS' },
     'file-pdf-save' => { ui => 1, gegl => 1, optional => 1, libs => 'CAIRO_PDF_LIBS', cflags => 'CAIRO_PDF_CFLAGS' },
@@ -83,7 +83,7 @@
     'plugin-browser' => { ui => 1 },
     'procedure-browser' => { ui => 1 },
     'qbist' => { ui => 1 },
-    'ripple' => { ui => 1 },
+    'ripple' => { ui => 1, gegl => 1 },
     'sample-colorize' => { ui => 1 },
     'screenshot' => { ui => 1, optional => 1, libs => 'SCREENSHOT_LIBS', cflags => 'XFIXES_CFLAGS', gegl => 1 },
     'sharpen' => { ui => 1 },
@@ -95,7 +95,7 @@
     'tile-paper' => { ui => 1 },
     'tile-small' => { ui => 1 },
     'unit-editor' => { ui => 1 },
-    'unsharp-mask' => { ui => 1 },
+    'unsharp-mask' => { ui => 1, gegl => 1 },
     'van-gogh-lic' => { ui => 1 },
     'warp' => { ui => 1 },
     'web-browser' => { ui => 1 },
@@ -36,7 +36,9 @@
 #define PLUG_IN_ROLE    "gimp-ripple"
 
 #define SCALE_WIDTH     200
-#define TILE_CACHE_SIZE  16
+
+#define MAX_THREADS      16
+#define CHUNK_ROWS       16
 
 #define SMEAR 0
 #define WRAP  1
@@ -57,6 +59,23 @@ typedef struct
   gint                 phase_shift;
 } RippleValues;
 
+typedef struct
+{
+  const guchar *src;       /* the whole drawable             */
+  gint          width;
+  gint          height;
+  gint          bpp;
+  gboolean      has_alpha;
+
+  guchar       *dest;      /* the area being rendered        */
+  gint          dest_x;
+  gint          dest_y;
+  gint          dest_width;
+  gint          dest_height;
+
+  gint          next_row;
+} RippleParam_t;
+
 
 /* Declare local functions.
  */
@@ -69,6 +88,10 @@ static void      run                (const gchar      *name,
 
 static void      ripple             (GimpDrawable     *drawable,
                                      GimpPreview      *preview);
+static void      ripple_rows        (RippleParam_t    *param,
+                                     gint              first,
+                                     gint              last);
+static gpointer  ripple_thread      (RippleParam_t    *param);
 
 static gboolean  ripple_dialog      (GimpDrawable     *drawable);
 
@@ -152,13 +175,11 @@ run (const gchar      *name,
   run_mode = param[0].data.d_int32;
 
   INIT_I18N ();
+  gegl_init (NULL, NULL);
 
   /*  Get the specified drawable  */
   drawable = gimp_drawable_get (param[2].data.d_drawable);
 
-  /*  set the tile cache size  */
-  gimp_tile_cache_ntiles (TILE_CACHE_SIZE);
-
   *nreturn_vals = 1;
   *return_vals  = values;
 
@@ -223,8 +244,6 @@ run (const gchar      *name,
           /*  run the ripple effect  */
           ripple (drawable, NULL);
 
-          gimp_progress_update (1.0);
-
           if (run_mode != GIMP_RUN_NONINTERACTIVE)
             gimp_displays_flush ();
 
@@ -242,15 +261,20 @@ run (const gchar      *name,
   values[0].data.d_status = status;
 
   gimp_drawable_detach (drawable);
+
+  gegl_exit ();
 }
 
-typedef struct
+static inline void
+ripple_get_pixel (RippleParam_t *param,
+                  gint           x,
+                  gint           y,
+                  guchar        *pixel)
 {
-  GimpPixelFetcher *pft;
-  gint              width;
-  gint              height;
-  gboolean          has_alpha;
-} RippleParam_t;
+  memcpy (pixel,
+          param->src + ((gsize) y * param->width + x) * param->bpp,
+          param->bpp);
+}
 
 static void
 ripple_vertical (gint      x,
@@ -259,12 +283,11 @@ ripple_vertical (gint      x,
                  gint      bpp,
                  gpointer  data)
 {
-  RippleParam_t    *param  = data;
-  GimpPixelFetcher *pft    = param->pft;
-  const gint        height = param->height;
-  guchar            pixel[2][4];
-  gdouble           needy;
-  gint              yi, yi_a;
+  RippleParam_t *param  = data;
+  const gint     height = param->height;
+  guchar         pixel[2][4];
+  gdouble        needy;
+  gint           yi, yi_a;
 
   needy = y + displace_amount (x);
   yi = floor (needy);
@@ -298,12 +321,12 @@ ripple_vertical (gint      x,
   if (rvals.antialias)
     {
       if (yi >= 0 && yi < height)
-        gimp_pixel_fetcher_get_pixel (pft, x, yi  , pixel[0]);
+        ripple_get_pixel (param, x, yi  , pixel[0]);
       else
         memset (pixel[0], 0, 4);
 
       if (yi_a >= 0 && yi_a < height)
-        gimp_pixel_fetcher_get_pixel (pft, x, yi_a, pixel[1]);
+        ripple_get_pixel (param, x, yi_a, pixel[1]);
       else
         memset (pixel[1], 0, 4);
 
@@ -312,7 +335,7 @@ ripple_vertical (gint      x,
   else
     {
       if (yi >= 0 && yi < height)
-        gimp_pixel_fetcher_get_pixel (pft, x, yi, dest);
+        ripple_get_pixel (param, x, yi, dest);
       else
         memset (dest, 0, bpp);
     }
@@ -325,12 +348,11 @@ ripple_horizontal (gint      x,
                    gint      bpp,
                    gpointer  data)
 {
-  RippleParam_t    *param = data;
-  GimpPixelFetcher *pft   = param->pft;
-  const gint        width = param->width;
-  guchar            pixel[2][4];
-  gdouble           needx;
-  gint              xi, xi_a;
+  RippleParam_t *param = data;
+  const gint     width = param->width;
+  guchar         pixel[2][4];
+  gdouble        needx;
+  gint           xi, xi_a;
 
   needx = x + displace_amount (y);
   xi = floor (needx);
@@ -364,12 +386,12 @@ ripple_horizontal (gint      x,
   if (rvals.antialias)
     {
       if (xi >= 0 && xi < width)
-        gimp_pixel_fetcher_get_pixel (pft, xi,   y, pixel[0]);
+        ripple_get_pixel (param, xi,   y, pixel[0]);
       else
         memset (pixel[0], 0, 4);
 
       if (xi_a >= 0 && xi_a < width)
-        gimp_pixel_fetcher_get_pixel (pft, xi_a, y, pixel[1]);
+        ripple_get_pixel (param, xi_a, y, pixel[1]);
       else
         memset (pixel[1], 0, 4);
 
@@ -379,24 +401,117 @@ ripple_horizontal (gint      x,
   else
     {
       if (xi >= 0 && xi < width)
-        gimp_pixel_fetcher_get_pixel (pft, xi, y, dest);
+        ripple_get_pixel (param, xi, y, dest);
       else
         memset (dest, 0, bpp);
     }
 }
 
+static void
+ripple_rows (RippleParam_t *param,
+             gint           first,
+             gint           last)
+{
+  gint y;
+
+  for (y = first; y < last; y++)
+    {
+      guchar *d = param->dest + (gsize) y * param->dest_width * param->bpp;
+      gint    x;
+
+      for (x = 0; x < param->dest_width; x++)
+        {
+          if (rvals.orientation == GIMP_ORIENTATION_VERTICAL)
+            ripple_vertical (param->dest_x + x, param->dest_y + y,
+                             d, param->bpp, param);
+          else
+            ripple_horizontal (param->dest_x + x, param->dest_y + y,
+                               d, param->bpp, param);
+
+          d += param->bpp;
+        }
+    }
+}
+
+static gpointer
+ripple_thread (RippleParam_t *param)
+{
+  gint row;
+
+  while ((row = g_atomic_int_add (&param->next_row, CHUNK_ROWS)) <
+         param->dest_height)
+    {
+      ripple_rows (param, row, MIN (row + CHUNK_ROWS, param->dest_height));
+    }
+
+  return NULL;
+}
+
 static void
 ripple (GimpDrawable *drawable,
         GimpPreview  *preview)
 {
-  RippleParam_t param;
-  gint          edges;
-  gint          period;
+  RippleParam_t  param;
+  GeglBuffer    *src_buffer;
+  const Babl    *format;
+  GThread       *threads[MAX_THREADS];
+  gint           n_threads;
+  gint           edges;
+  gint           period;
+  gint           row;
+  gint           i;
+
+  if (preview)
+    {
+      gimp_preview_get_position (preview, &param.dest_x, &param.dest_y);
+      gimp_preview_get_size (preview,
+                             &param.dest_width, &param.dest_height);
+    }
+  else if (! gimp_drawable_mask_intersect (drawable->drawable_id,
+                                           &param.dest_x, &param.dest_y,
+                                           &param.dest_width,
+                                           &param.dest_height))
+    {
+      return;
+    }
+
+  if (gimp_drawable_is_rgb (drawable->drawable_id))
+    {
+      if (gimp_drawable_has_alpha (drawable->drawable_id))
+        format = babl_format ("R'G'B'A u8");
+      else
+        format = babl_format ("R'G'B' u8");
+    }
+  else
+    {
+      if (gimp_drawable_has_alpha (drawable->drawable_id))
+        format = babl_format ("Y'A u8");
+      else
+        format = babl_format ("Y' u8");
+    }
 
-  param.pft       = gimp_pixel_fetcher_new (drawable, FALSE);
   param.has_alpha = gimp_drawable_has_alpha (drawable->drawable_id);
   param.width     = drawable->width;
   param.height    = drawable->height;
+  param.bpp       = babl_format_get_bytes_per_pixel (format);
+  param.next_row  = 0;
+
+  /*  the displaced pixels can come from anywhere in the row or
+   *  column, so fetch the whole drawable once instead of going
+   *  through the tile cache pixel by pixel
+   */
+  src_buffer = gimp_drawable_get_buffer (drawable->drawable_id);
+
+  param.src  = g_new (guchar, (gsize) param.width * param.height * param.bpp);
+  param.dest = g_new (guchar, (gsize) param.dest_width * param.dest_height *
+                              param.bpp);
+
+  gegl_buffer_get (src_buffer,
+                   GEGL_RECTANGLE (0, 0, param.width, param.height), 1.0,
+                   format, (guchar *) param.src,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  g_object_unref (src_buffer);
 
   edges  = rvals.edges;
   period = rvals.period;
@@ -410,52 +525,60 @@ ripple (GimpDrawable *drawable,
                       (rvals.orientation == GIMP_ORIENTATION_VERTICAL));
     }
 
+  n_threads = CLAMP (g_get_num_processors (), 1, MAX_THREADS);
+  n_threads = MIN (n_threads,
+                   (param.dest_height + CHUNK_ROWS - 1) / CHUNK_ROWS);
+
+  for (i = 1; i < n_threads; i++)
+    threads[i] = g_thread_new ("ripple",
+                               (GThreadFunc) ripple_thread, &param);
+
+  while ((row = g_atomic_int_add (&param.next_row, CHUNK_ROWS)) <
+         param.dest_height)
+    {
+      gint last = MIN (row + CHUNK_ROWS, param.dest_height);
+
+      ripple_rows (&param, row, last);
+
+      if (! preview)
+        gimp_progress_update ((gdouble) last / param.dest_height);
+    }
+
+  for (i = 1; i < n_threads; i++)
+    g_thread_join (threads[i]);
+
+  rvals.edges  = edges;
+  rvals.period = period;
+
   if (preview)
     {
-      guchar *buffer, *d;
-      gint    bpp = gimp_drawable_bpp (drawable->drawable_id);
-      gint    width, height;
-      gint    x, y;
-      gint    x1, y1;
-
-      gimp_preview_get_position (preview, &x1, &y1);
-      gimp_preview_get_size (preview, &width, &height);
-
-      d = buffer = g_new (guchar, width * height * bpp);
-
-      for (y = 0; y < height ; y++)
-        for (x = 0; x < width ; x++)
-          {
-            if (rvals.orientation == GIMP_ORIENTATION_VERTICAL)
-              ripple_vertical (x1 + x, y1 + y, d, bpp, &param);
-            else
-              ripple_horizontal (x1 + x, y1 + y, d, bpp, &param);
-
-            d += bpp;
-          }
-
-      gimp_preview_draw_buffer (preview, buffer, width * bpp);
-      g_free (buffer);
+      gimp_preview_draw_buffer (preview, param.dest,
+                                param.dest_width * param.bpp);
     }
   else
     {
-      GimpRgnIterator *iter;
+      GeglBuffer *dest_buffer;
 
-      iter = gimp_rgn_iterator_new (drawable, 0);
+      dest_buffer = gimp_drawable_get_shadow_buffer (drawable->drawable_id);
 
-      gimp_rgn_iterator_dest (iter,
-                              rvals.orientation == GIMP_ORIENTATION_VERTICAL ?
-                              ripple_vertical :
-                              ripple_horizontal,
-                              &param);
+      gegl_buffer_set (dest_buffer,
+                       GEGL_RECTANGLE (param.dest_x, param.dest_y,
+                                       param.dest_width, param.dest_height), 0,
+                       format, param.dest,
+                       GEGL_AUTO_ROWSTRIDE);
 
-      gimp_rgn_iterator_free (iter);
-    }
+      g_object_unref (dest_buffer);
 
-  rvals.edges  = edges;
-  rvals.period = period;
+      gimp_progress_update (1.0);
+
+      gimp_drawable_merge_shadow (drawable->drawable_id, TRUE);
+      gimp_drawable_update (drawable->drawable_id,
+                            param.dest_x, param.dest_y,
+                            param.dest_width, param.dest_height);
+    }
 
-  gimp_pixel_fetcher_destroy (param.pft);
+  g_free (param.dest);
+  g_free ((guchar *) param.src);
 }
 
 static gboolean
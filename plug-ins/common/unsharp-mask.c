@@ -20,6 +20,7 @@
 #include "config.h"
 
 #include <stdlib.h>
+#include <string.h>
 
 #include <libgimp/gimp.h>
 #include <libgimp/gimpui.h>
@@ -34,6 +35,9 @@
 #define SCALE_WIDTH   120
 #define ENTRY_WIDTH     5
 
+#define MAX_THREADS    16
+#define CHUNK_LINES    32
+
 /* Uncomment this line to get a rough estimate of how long the plug-in
  * takes to run.
  */
@@ -53,6 +57,33 @@ typedef struct
   gboolean  run;
 } UnsharpMaskInterface;
 
+typedef struct
+{
+  const guchar *src;            /* the original pixels                  */
+  guchar       *dest;           /* the blurred, and then merged, pixels */
+  gint          width;
+  gint          height;
+  gint          bpp;
+  gdouble      *cmatrix;
+  gint          cmatrix_length;
+  gboolean      box_blur;
+  gint          box_width;
+  gdouble       amount;
+  gint          threshold;
+} UnsharpRegion;
+
+typedef void (* UnsharpLinesFunc) (UnsharpRegion *region,
+                                   gint           first,
+                                   gint           last);
+
+typedef struct
+{
+  UnsharpRegion    *region;
+  UnsharpLinesFunc  func;
+  gint              n_lines;
+  gint              next_line;
+} UnsharpJob;
+
 /* local function prototypes */
 static void      query (void);
 static void      run   (const gchar      *name,
@@ -75,18 +106,37 @@ static void      box_blur_line       (const gint      box_width,
                                       const gint      bpp);
 static gint      gen_convolve_matrix (gdouble         std_dev,
                                       gdouble       **cmatrix);
-static void      unsharp_region      (GimpPixelRgn   *srcPTR,
-                                      GimpPixelRgn   *dstPTR,
+static void      unsharp_blur_line   (UnsharpRegion  *region,
+                                      guchar         *src,
+                                      guchar         *dest,
+                                      gint            len);
+static void      unsharp_blur_rows   (UnsharpRegion  *region,
+                                      gint            first,
+                                      gint            last);
+static void      unsharp_blur_cols   (UnsharpRegion  *region,
+                                      gint            first,
+                                      gint            last);
+static void      unsharp_merge_rows  (UnsharpRegion  *region,
+                                      gint            first,
+                                      gint            last);
+static gpointer  unsharp_job_thread  (UnsharpJob     *job);
+static void      unsharp_run_lines   (UnsharpRegion  *region,
+                                      UnsharpLinesFunc func,
+                                      gint            n_lines,
+                                      gboolean        show_progress,
+                                      gdouble         progress_start);
+static void      unsharp_region      (const guchar   *src,
+                                      guchar         *dest,
+                                      gint            width,
+                                      gint            height,
                                       gint            bpp,
                                       gdouble         radius,
                                       gdouble         amount,
-                                      gint            x1,
-                                      gint            x2,
-                                      gint            y1,
-                                      gint            y2,
                                       gboolean        show_progress);
 
-static void      unsharp_mask        (GimpDrawable   *drawable,
+static const Babl *
+                 unsharp_get_format  (gint32          drawable_id);
+static void      unsharp_mask        (gint32          drawable_id,
                                       gdouble         radius,
                                       gdouble         amount);
 
@@ -170,13 +220,12 @@ run (const gchar      *name,
   values[0].data.d_status = status;
 
   INIT_I18N ();
+  gegl_init (NULL, NULL);
 
   /*
    * Get drawable information...
    */
   drawable = gimp_drawable_get (param[2].data.d_drawable);
-  gimp_tile_cache_ntiles (2 * MAX (drawable->width  / gimp_tile_width () + 1 ,
-                                   drawable->height / gimp_tile_height () + 1));
 
   switch (run_mode)
     {
@@ -221,7 +270,8 @@ run (const gchar      *name,
       drawable = gimp_drawable_get (param[2].data.d_drawable);
 
       /* here we go */
-      unsharp_mask (drawable, unsharp_params.radius, unsharp_params.amount);
+      unsharp_mask (drawable->drawable_id,
+                    unsharp_params.radius, unsharp_params.amount);
 
       gimp_displays_flush ();
 
@@ -238,6 +288,8 @@ run (const gchar      *name,
   g_printerr ("%f seconds\n", g_timer_elapsed (timer, NULL));
   g_timer_destroy (timer);
 #endif
+
+  gegl_exit ();
 }
 
 /* This function is written as if it is blurring a row of pixels,
@@ -529,64 +581,283 @@ gaussian_blur_line (const gdouble *cmatrix,
     }
 }
 
+/* Blurs one row or column, from @src into @dest.  The box blur uses
+ * @src as scratch space.
+ */
+static void
+unsharp_blur_line (UnsharpRegion *region,
+                   guchar        *src,
+                   guchar        *dest,
+                   gint           len)
+{
+  const gint box_width = region->box_width;
+  const gint bpp       = region->bpp;
+
+  if (region->box_blur)
+    {
+      /* Odd-width box blur: repeat 3 times, centered on output pixel.
+       * Swap back and forth between the buffers. */
+      if (box_width % 2)
+        {
+          box_blur_line (box_width, 0, src, dest, len, bpp);
+          box_blur_line (box_width, 0, dest, src, len, bpp);
+          box_blur_line (box_width, 0, src, dest, len, bpp);
+        }
+      /* Even-width box blur:
+       * This method is suggested by the specification for SVG.
+       * One pass with width n, centered between output and right pixel
+       * One pass with width n, centered between output and left pixel
+       * One pass with width n+1, centered on output pixel
+       * Swap back and forth between buffers.
+       */
+      else
+        {
+          box_blur_line (box_width,  -1, src, dest, len, bpp);
+          box_blur_line (box_width,   1, dest, src, len, bpp);
+          box_blur_line (box_width+1, 0, src, dest, len, bpp);
+        }
+    }
+  else
+    {
+      /* Gaussian blur */
+      gaussian_blur_line (region->cmatrix, region->cmatrix_length,
+                          src, dest, len, bpp);
+    }
+}
+
+static void
+unsharp_blur_rows (UnsharpRegion *region,
+                   gint           first,
+                   gint           last)
+{
+  const gsize  rowstride = region->width * region->bpp;
+  guchar      *src       = g_new (guchar, rowstride);
+  gint         row;
+
+  for (row = first; row < last; row++)
+    {
+      memcpy (src, region->src + row * rowstride, rowstride);
+
+      unsharp_blur_line (region, src, region->dest + row * rowstride,
+                         region->width);
+    }
+
+  g_free (src);
+}
+
+static void
+unsharp_blur_cols (UnsharpRegion *region,
+                   gint           first,
+                   gint           last)
+{
+  const gint   bpp       = region->bpp;
+  const gsize  rowstride = region->width * bpp;
+  guchar      *src       = g_new (guchar, region->height * bpp);
+  guchar      *dest      = g_new (guchar, region->height * bpp);
+  gint         col;
+  gint         row;
+
+  for (col = first; col < last; col++)
+    {
+      guchar *p = region->dest + col * bpp;
+
+      for (row = 0; row < region->height; row++)
+        memcpy (src + row * bpp, p + row * rowstride, bpp);
+
+      unsharp_blur_line (region, src, dest, region->height);
+
+      for (row = 0; row < region->height; row++)
+        memcpy (p + row * rowstride, dest + row * bpp, bpp);
+    }
+
+  g_free (dest);
+  g_free (src);
+}
+
+/* merge the source and destination (which currently contains
+ * the blurred version) images
+ */
+static void
+unsharp_merge_rows (UnsharpRegion *region,
+                    gint           first,
+                    gint           last)
+{
+  const gsize   rowstride = region->width * region->bpp;
+  const gint    threshold = region->threshold;
+  const gdouble amount    = region->amount;
+  const guchar *s         = region->src  + first * rowstride;
+  guchar       *d         = region->dest + first * rowstride;
+  gsize         n         = (last - first) * rowstride;
+
+  while (n--)
+    {
+      gint value;
+      gint diff = *s - *d;
+
+      /* do tresholding */
+      if (abs (2 * diff) < threshold)
+        diff = 0;
+
+      value = *s++ + amount * diff;
+      *d++ = CLAMP (value, 0, 255);
+    }
+}
+
+static gpointer
+unsharp_job_thread (UnsharpJob *job)
+{
+  gint line;
+
+  while ((line = g_atomic_int_add (&job->next_line, CHUNK_LINES)) <
+         job->n_lines)
+    {
+      job->func (job->region, line, MIN (line + CHUNK_LINES, job->n_lines));
+    }
+
+  return NULL;
+}
+
+/* Runs @func on all @n_lines lines, in chunks, which are picked up by
+ * as many threads as there are processors.  Progress is only reported
+ * from the main thread, for the chunks it does itself.
+ */
 static void
-unsharp_mask (GimpDrawable *drawable,
-              gdouble       radius,
-              gdouble       amount)
+unsharp_run_lines (UnsharpRegion    *region,
+                   UnsharpLinesFunc  func,
+                   gint              n_lines,
+                   gboolean          show_progress,
+                   gdouble           progress_start)
 {
-  GimpPixelRgn srcPR, destPR;
-  gint         x1, y1, x2, y2;
+  UnsharpJob  job;
+  GThread    *threads[MAX_THREADS];
+  gint        n_threads;
+  gint        line;
+  gint        i;
+
+  job.region    = region;
+  job.func      = func;
+  job.n_lines   = n_lines;
+  job.next_line = 0;
+
+  n_threads = CLAMP (g_get_num_processors (), 1, MAX_THREADS);
+  n_threads = MIN (n_threads, (n_lines + CHUNK_LINES - 1) / CHUNK_LINES);
 
-  /* initialize pixel regions */
-  gimp_pixel_rgn_init (&srcPR, drawable,
-                       0, 0, drawable->width, drawable->height, FALSE, FALSE);
-  gimp_pixel_rgn_init (&destPR, drawable,
-                       0, 0, drawable->width, drawable->height, TRUE, TRUE);
+  for (i = 1; i < n_threads; i++)
+    threads[i] = g_thread_new ("unsharp-mask",
+                               (GThreadFunc) unsharp_job_thread, &job);
+
+  while ((line = g_atomic_int_add (&job.next_line, CHUNK_LINES)) < n_lines)
+    {
+      gint last = MIN (line + CHUNK_LINES, n_lines);
+
+      func (region, line, last);
+
+      if (show_progress)
+        gimp_progress_update (progress_start + (gdouble) last / (3 * n_lines));
+    }
+
+  for (i = 1; i < n_threads; i++)
+    g_thread_join (threads[i]);
+}
+
+static const Babl *
+unsharp_get_format (gint32 drawable_id)
+{
+  if (gimp_drawable_is_rgb (drawable_id))
+    {
+      if (gimp_drawable_has_alpha (drawable_id))
+        return babl_format ("R'G'B'A u8");
+      else
+        return babl_format ("R'G'B' u8");
+    }
+  else
+    {
+      if (gimp_drawable_has_alpha (drawable_id))
+        return babl_format ("Y'A u8");
+      else
+        return babl_format ("Y' u8");
+    }
+}
+
+static void
+unsharp_mask (gint32  drawable_id,
+              gdouble radius,
+              gdouble amount)
+{
+  GeglBuffer *src_buffer;
+  GeglBuffer *dest_buffer;
+  const Babl *format;
+  guchar     *src;
+  guchar     *dest;
+  gint        bpp;
+  gint        x, y, width, height;
+
+  if (! gimp_drawable_mask_intersect (drawable_id, &x, &y, &width, &height))
+    return;
+
+  src_buffer  = gimp_drawable_get_buffer (drawable_id);
+  dest_buffer = gimp_drawable_get_shadow_buffer (drawable_id);
+
+  format = unsharp_get_format (drawable_id);
+  bpp    = babl_format_get_bytes_per_pixel (format);
+
+  src  = g_new (guchar, (gsize) width * height * bpp);
+  dest = g_new (guchar, (gsize) width * height * bpp);
 
   /* Get the input */
-  gimp_drawable_mask_bounds (drawable->drawable_id, &x1, &y1, &x2, &y2);
+  gegl_buffer_get (src_buffer, GEGL_RECTANGLE (x, y, width, height), 1.0,
+                   format, src,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
 
-  unsharp_region (&srcPR, &destPR, drawable->bpp,
+  unsharp_region (src, dest, width, height, bpp,
                   radius, amount,
-                  x1, x2, y1, y2,
                   TRUE);
 
-  gimp_drawable_flush (drawable);
-  gimp_drawable_merge_shadow (drawable->drawable_id, TRUE);
-  gimp_drawable_update (drawable->drawable_id, x1, y1, x2 - x1, y2 - y1);
+  gegl_buffer_set (dest_buffer, GEGL_RECTANGLE (x, y, width, height), 0,
+                   format, dest,
+                   GEGL_AUTO_ROWSTRIDE);
+
+  g_free (dest);
+  g_free (src);
+
+  g_object_unref (src_buffer);
+  g_object_unref (dest_buffer);
+
+  gimp_drawable_merge_shadow (drawable_id, TRUE);
+  gimp_drawable_update (drawable_id, x, y, width, height);
 }
 
-/* Perform an unsharp mask on the region, given a source region, dest.
- * region, width and height of the regions, and corner coordinates of
- * a subregion to act upon.  Everything outside the subregion is unaffected.
+/* Perform an unsharp mask on @width x @height pixels of @src, into
+ * @dest.  The rows, then the columns, and then the merge are each
+ * split over all processors; every line is processed exactly like
+ * before, so the result doesn't depend on the number of threads.
  */
 static void
-unsharp_region (GimpPixelRgn *srcPR,
-                GimpPixelRgn *destPR,
+unsharp_region (const guchar *src,
+                guchar       *dest,
+                gint          width,
+                gint          height,
                 gint          bpp,
                 gdouble       radius, /* Radius, AKA standard deviation */
                 gdouble       amount,
-                gint          x1,
-                gint          x2,
-                gint          y1,
-                gint          y2,
                 gboolean      show_progress)
 {
-  guchar     *src;                /* Temporary copy of source row/col      */
-  guchar     *dest;               /* Temporary copy of destination row/col */
-  const gint  width   = x2 - x1;
-  const gint  height  = y2 - y1;
-  gdouble    *cmatrix = NULL;     /* Convolution matrix (for gaussian)     */
-  gint        cmatrix_length = 0;
-  gint        row, col;           /* Row, column counters                  */
-  const gint  threshold = unsharp_params.threshold;
-  gboolean    box_blur;           /* If we want to use a three pass box
-                                     blur instead of a gaussian blur       */
-  gint        box_width = 0;
+  UnsharpRegion region;
 
   if (show_progress)
     gimp_progress_init (_("Blurring"));
 
+  region.src            = src;
+  region.dest           = dest;
+  region.width          = width;
+  region.height         = height;
+  region.bpp            = bpp;
+  region.cmatrix        = NULL;
+  region.cmatrix_length = 0;
+  region.box_width      = 0;
+  region.amount         = amount;
+  region.threshold      = unsharp_params.threshold;
+
   /* If the radius is less than 10, use a true gaussian kernel.  This
    * is slower, but more accurate and allows for finer adjustments.
    * Otherwise use a three-pass box blur; this is much faster but it
@@ -595,143 +866,36 @@ unsharp_region (GimpPixelRgn *srcPR,
    */
   if (radius < 10)
     {
-      box_blur = FALSE;
+      region.box_blur = FALSE;
       /* If true gaussian, generate convolution matrix
          and make sure it's smaller than each dimension */
-      cmatrix_length = gen_convolve_matrix (radius, &cmatrix);
+      region.cmatrix_length = gen_convolve_matrix (radius, &region.cmatrix);
     }
   else
     {
-      box_blur = TRUE;
+      region.box_blur = TRUE;
       /* Three box blurs of this width approximate a gaussian */
-      box_width = ROUND (radius * 3 * sqrt (2 * G_PI) / 4);
+      region.box_width = ROUND (radius * 3 * sqrt (2 * G_PI) / 4);
     }
 
-  /* Allocate buffers temporary copies of a row/column */
-  src  = g_new (guchar, MAX (width, height) * bpp);
-  dest = g_new (guchar, MAX (width, height) * bpp);
-
   /* Blur the rows */
-  for (row = 0; row < height; row++)
-    {
-      gimp_pixel_rgn_get_row (srcPR, src, x1, y1 + row, width);
-
-      if (box_blur)
-        {
-          /* Odd-width box blur: repeat 3 times, centered on output pixel.
-           * Swap back and forth between the buffers. */
-          if (box_width % 2)
-            {
-              box_blur_line (box_width, 0, src, dest, width, bpp);
-              box_blur_line (box_width, 0, dest, src, width, bpp);
-              box_blur_line (box_width, 0, src, dest, width, bpp);
-            }
-          /* Even-width box blur:
-           * This method is suggested by the specification for SVG.
-           * One pass with width n, centered between output and right pixel
-           * One pass with width n, centered between output and left pixel
-           * One pass with width n+1, centered on output pixel
-           * Swap back and forth between buffers.
-           */
-          else
-            {
-              box_blur_line (box_width,  -1, src, dest, width, bpp);
-              box_blur_line (box_width,   1, dest, src, width, bpp);
-              box_blur_line (box_width+1, 0, src, dest, width, bpp);
-            }
-        }
-      else
-        {
-          /* Gaussian blur */
-          gaussian_blur_line (cmatrix, cmatrix_length, src, dest, width, bpp);
-        }
-
-      gimp_pixel_rgn_set_row (destPR, dest, x1, y1 + row, width);
-
-      if (show_progress && row % 64 == 0)
-        gimp_progress_update ((gdouble) row / (3 * height));
-    }
+  unsharp_run_lines (&region, unsharp_blur_rows, height,
+                     show_progress, 0.0);
 
   /* Blur the cols. Essentially same as above. */
-  for (col = 0; col < width; col++)
-    {
-      gimp_pixel_rgn_get_col (destPR, src, x1 + col, y1, height);
-
-      if (box_blur)
-        {
-          /* Odd-width box blur */
-          if (box_width % 2)
-            {
-              box_blur_line (box_width, 0, src, dest, height, bpp);
-              box_blur_line (box_width, 0, dest, src, height, bpp);
-              box_blur_line (box_width, 0, src, dest, height, bpp);
-            }
-          /* Even-width box blur */
-          else
-            {
-              box_blur_line (box_width,  -1, src, dest, height, bpp);
-              box_blur_line (box_width,   1, dest, src, height, bpp);
-              box_blur_line (box_width+1, 0, src, dest, height, bpp);
-            }
-        }
-      else
-        {
-          /* Gaussian blur */
-          gaussian_blur_line (cmatrix, cmatrix_length, src, dest,height, bpp);
-        }
-
-      gimp_pixel_rgn_set_col (destPR, dest, x1 + col, y1, height);
-
-      if (show_progress && col % 64 == 0)
-        gimp_progress_update ((gdouble) col / (3 * width) + 0.33);
-    }
+  unsharp_run_lines (&region, unsharp_blur_cols, width,
+                     show_progress, 0.33);
 
   if (show_progress)
     gimp_progress_set_text (_("Merging"));
 
-  /* merge the source and destination (which currently contains
-     the blurred version) images */
-  for (row = 0; row < height; row++)
-    {
-      const guchar *s = src;
-      guchar       *d = dest;
-      gint          u, v;
-
-      /* get source row */
-      gimp_pixel_rgn_get_row (srcPR, src, x1, y1 + row, width);
-
-      /* get dest row */
-      gimp_pixel_rgn_get_row (destPR, dest, x1, y1 + row, width);
-
-      /* combine the two */
-      for (u = 0; u < width; u++)
-        {
-          for (v = 0; v < bpp; v++)
-            {
-              gint value;
-              gint diff = *s - *d;
-
-              /* do tresholding */
-              if (abs (2 * diff) < threshold)
-                diff = 0;
-
-              value = *s++ + amount * diff;
-              *d++ = CLAMP (value, 0, 255);
-            }
-        }
-
-      if (show_progress && row % 64 == 0)
-        gimp_progress_update ((gdouble) row / (3 * height) + 0.67);
-
-      gimp_pixel_rgn_set_row (destPR, dest, x1, y1 + row, width);
-    }
+  unsharp_run_lines (&region, unsharp_merge_rows, height,
+                     show_progress, 0.67);
 
   if (show_progress)
     gimp_progress_update (1.0);
 
-  g_free (dest);
-  g_free (src);
-  g_free (cmatrix);
+  g_free (region.cmatrix);
 }
 
 /* generates a 1-D convolution matrix to be used for each pass of
@@ -920,22 +1084,20 @@ static void
 preview_update (GimpPreview *preview)
 {
   GimpDrawable *drawable;
+  GeglBuffer   *buffer;
+  const Babl   *format;
+  guchar       *src;
+  guchar       *dest;
+  gint          bpp;
   gint          x1, x2;
   gint          y1, y2;
   gint          x, y;
   gint          width, height;
   gint          border;
-  GimpPixelRgn  srcPR;
-  GimpPixelRgn  destPR;
 
   drawable =
     gimp_drawable_preview_get_drawable (GIMP_DRAWABLE_PREVIEW (preview));
 
-  gimp_pixel_rgn_init (&srcPR, drawable,
-                       0, 0, drawable->width, drawable->height, FALSE, FALSE);
-  gimp_pixel_rgn_init (&destPR, drawable,
-                       0, 0, drawable->width, drawable->height, TRUE, TRUE);
-
   gimp_preview_get_position (preview, &x, &y);
   gimp_preview_get_size (preview, &width, &height);
 
@@ -946,11 +1108,27 @@ preview_update (GimpPreview *preview)
   x2 = MIN (x + width  + border, drawable->width);
   y2 = MIN (y + height + border, drawable->height);
 
-  unsharp_region (&srcPR, &destPR, drawable->bpp,
+  buffer = gimp_drawable_get_buffer (drawable->drawable_id);
+  format = unsharp_get_format (drawable->drawable_id);
+  bpp    = babl_format_get_bytes_per_pixel (format);
+
+  src  = g_new (guchar, (x2 - x1) * (y2 - y1) * bpp);
+  dest = g_new (guchar, (x2 - x1) * (y2 - y1) * bpp);
+
+  gegl_buffer_get (buffer, GEGL_RECTANGLE (x1, y1, x2 - x1, y2 - y1), 1.0,
+                   format, src,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  unsharp_region (src, dest, x2 - x1, y2 - y1, bpp,
                   unsharp_params.radius, unsharp_params.amount,
-                  x1, x2, y1, y2,
                   FALSE);
 
-  gimp_pixel_rgn_init (&destPR, drawable, x, y, width, height, FALSE, TRUE);
-  gimp_drawable_preview_draw_region (GIMP_DRAWABLE_PREVIEW (preview), &destPR);
+  gimp_preview_draw_buffer (preview,
+                            dest + ((y - y1) * (x2 - x1) + (x - x1)) * bpp,
+                            (x2 - x1) * bpp);
+
+  g_free (dest);
+  g_free (src);
+
+  g_object_unref (buffer);
 }
@@ -25,10 +25,14 @@
 #include "openexr-wrapper.h"
 
 #define LOAD_PROC          "file-exr-load"
+#define LOAD_THUMB_PROC    "file-exr-load-thumb"
 #define PLUG_IN_BINARY     "file-exr"
 #define PLUG_IN_ROLE       "gimp-file-exr"
 #define PLUG_IN_VERSION    "0.0.0"
 
+/* rows decoded at once, so OpenEXR has several chunks to work on */
+#define BAND_HEIGHT        256
+
 
 /*
  * Declare some local functions.
@@ -42,6 +46,9 @@ static void     run         (const gchar      *name,
 
 static gint32    load_image (const gchar      *filename,
                              gboolean          interactive,
+                             gint              thumb_size,
+                             gint             *image_width,
+                             gint             *image_height,
                              GError          **error);
 /*
  * Some global variables.
@@ -72,6 +79,18 @@ query (void)
     { GIMP_PDB_IMAGE, "image", "Output image" }
   };
 
+  static const GimpParamDef thumb_args[] =
+  {
+    { GIMP_PDB_STRING, "filename",     "The name of the file to load"  },
+    { GIMP_PDB_INT32,  "thumb-size",   "Preferred thumbnail size"      }
+  };
+  static const GimpParamDef thumb_return_vals[] =
+  {
+    { GIMP_PDB_IMAGE,  "image",        "Thumbnail image"               },
+    { GIMP_PDB_INT32,  "image-width",  "Width of full-sized image"     },
+    { GIMP_PDB_INT32,  "image-height", "Height of full-sized image"    }
+  };
+
   gimp_install_procedure (LOAD_PROC,
                           "Loads files in the OpenEXR file format",
                           "This plug-in loads OpenEXR files. ",
@@ -90,6 +109,25 @@ query (void)
   gimp_register_file_handler_mime (LOAD_PROC, "image/x-exr");
   gimp_register_magic_load_handler (LOAD_PROC,
                                     "exr", "", "0,lelong,20000630");
+
+  gimp_install_procedure (LOAD_THUMB_PROC,
+                          "Loads a thumbnail from an OpenEXR image",
+                          "Loads the smallest mip- or rip-map level of a "
+                          "tiled OpenEXR image that is at least thumb-size "
+                          "pixels large (only if the file has levels)",
+                          "Dominik Ernst <dernst@gmx.de>, "
+                          "Mukund Sivaraman <muks@banu.com>",
+                          "Dominik Ernst <dernst@gmx.de>, "
+                          "Mukund Sivaraman <muks@banu.com>",
+                          PLUG_IN_VERSION,
+                          NULL,
+                          NULL,
+                          GIMP_PLUGIN,
+                          G_N_ELEMENTS (thumb_args),
+                          G_N_ELEMENTS (thumb_return_vals),
+                          thumb_args, thumb_return_vals);
+
+  gimp_register_thumbnail_loader (LOAD_PROC, LOAD_THUMB_PROC);
 }
 
 static void
@@ -99,7 +137,7 @@ run (const gchar      *name,
      gint             *nreturn_vals,
      GimpParam       **return_vals)
 {
-  static GimpParam  values[2];
+  static GimpParam  values[4];
   GimpRunMode       run_mode;
   GimpPDBStatusType status = GIMP_PDB_SUCCESS;
   gint32            image_ID;
@@ -119,7 +157,8 @@ run (const gchar      *name,
       run_mode = param[0].data.d_int32;
 
       image_ID = load_image (param[1].data.d_string,
-                             run_mode == GIMP_RUN_INTERACTIVE, &error);
+                             run_mode == GIMP_RUN_INTERACTIVE,
+                             0, NULL, NULL, &error);
 
       if (image_ID != -1)
         {
@@ -132,6 +171,30 @@ run (const gchar      *name,
           status = GIMP_PDB_EXECUTION_ERROR;
         }
     }
+  else if (strcmp (name, LOAD_THUMB_PROC) == 0)
+    {
+      gint width  = 0;
+      gint height = 0;
+
+      image_ID = load_image (param[0].data.d_string, FALSE,
+                             MAX (param[1].data.d_int32, 1),
+                             &width, &height, &error);
+
+      if (image_ID != -1)
+        {
+          *nreturn_vals = 4;
+          values[1].type         = GIMP_PDB_IMAGE;
+          values[1].data.d_image = image_ID;
+          values[2].type         = GIMP_PDB_INT32;
+          values[2].data.d_int32 = width;
+          values[3].type         = GIMP_PDB_INT32;
+          values[3].data.d_int32 = height;
+        }
+      else
+        {
+          status = GIMP_PDB_EXECUTION_ERROR;
+        }
+    }
   else
     {
       status = GIMP_PDB_CALLING_ERROR;
@@ -150,6 +213,9 @@ run (const gchar      *name,
 static gint32
 load_image (const gchar  *filename,
             gboolean      interactive,
+            gint          thumb_size,
+            gint         *image_width,
+            gint         *image_height,
             GError      **error)
 {
   gint32 status = -1;
@@ -165,7 +231,7 @@ load_image (const gchar  *filename,
   const Babl *format;
   GeglBuffer *buffer = NULL;
   int bpp;
-  int tile_height;
+  int band_height;
   gchar *pixels = NULL;
   int begin;
   int end;
@@ -183,6 +249,20 @@ load_image (const gchar  *filename,
       goto out;
     }
 
+  if (thumb_size > 0 && exr_loader_select_level (loader, thumb_size) < 0)
+    {
+      g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
+                   _("'%s' has no mipmap levels to use as thumbnail"),
+                   gimp_filename_to_utf8 (filename));
+      goto out;
+    }
+
+  if (image_width)
+    *image_width = exr_loader_get_image_width (loader);
+
+  if (image_height)
+    *image_height = exr_loader_get_image_height (loader);
+
   width = exr_loader_get_width (loader);
   height = exr_loader_get_height (loader);
   if ((width < 1) || (height < 1))
@@ -250,34 +330,26 @@ load_image (const gchar  *filename,
   format = gimp_drawable_get_format (layer);
   bpp = babl_format_get_bytes_per_pixel (format);
 
-  tile_height = gimp_tile_height ();
-  pixels = g_new0 (gchar, tile_height * width * bpp);
+  band_height = MIN (BAND_HEIGHT, height);
+  pixels = g_new0 (gchar, band_height * width * bpp);
 
-  for (begin = 0; begin < height; begin += tile_height)
+  for (begin = 0; begin < height; begin += band_height)
     {
-      int retval;
-      int i;
-      end = MIN (begin + tile_height, height);
+      end = MIN (begin + band_height, height);
       num = end - begin;
 
-      for (i = 0; i < num; i++)
+      if (exr_loader_read_pixel_rows (loader, pixels, bpp, begin, num) < 0)
         {
-          retval = exr_loader_read_pixel_row (loader,
-                                              pixels + (i * width * bpp),
-                                              bpp, begin + i);
-          if (retval < 0)
-            {
-              g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
-                           _("Error reading pixel data from '%s'"),
-                           gimp_filename_to_utf8 (filename));
-              goto out;
-            }
+          g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
+                       _("Error reading pixel data from '%s'"),
+                       gimp_filename_to_utf8 (filename));
+          goto out;
         }
 
       gegl_buffer_set (buffer, GEGL_RECTANGLE (0, begin, width, num),
                        0, NULL, pixels, GEGL_AUTO_ROWSTRIDE);
 
-      gimp_progress_update ((gdouble) begin / (gdouble) height);
+      gimp_progress_update ((gdouble) end / (gdouble) height);
     }
 
   gimp_progress_update (1.0);
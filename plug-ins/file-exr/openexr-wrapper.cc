@@ -11,12 +11,16 @@
 #include "openexr-wrapper.h"
 
 #include <ImfInputFile.h>
+#include <ImfTiledInputFile.h>
 #include <ImfChannelList.h>
 #include <ImfRgbaFile.h>
 #include <ImfRgbaYca.h>
 #include <ImfStandardAttributes.h>
+#include <ImfThreading.h>
 
+#include <algorithm>
 #include <string>
+#include <vector>
 
 using namespace Imf;
 using namespace Imf::RgbaYca;
@@ -26,9 +30,14 @@ struct _EXRLoader
 {
   _EXRLoader(const char* filename) :
     refcount_(1),
+    filename_(filename),
     file_(filename),
     data_window_(file_.header().dataWindow()),
-    channels_(file_.header().channels())
+    read_window_(data_window_),
+    channels_(file_.header().channels()),
+    tiled_(NULL),
+    level_x_(0),
+    level_y_(0)
   {
     const Channel* chan;
 
@@ -97,49 +106,154 @@ struct _EXRLoader
       }
   }
 
-  int readPixelRow(char* pixels,
-                   int bpp,
-                   int row)
-  {
-    const int actual_row = data_window_.min.y + row;
-    FrameBuffer fb;
-    // This is necessary because OpenEXR expects the buffer to begin at
-    // (0, 0). Though it probably results in some unmapped address,
-    // hopefully OpenEXR will not make use of it. :/
-    char* base = pixels - (data_window_.min.x * bpp);
+  ~_EXRLoader() {
+    delete tiled_;
+  }
 
+  void insertSlices(FrameBuffer& fb,
+                    char* base,
+                    int bpp,
+                    size_t stride) {
     switch (image_type_)
       {
       case IMAGE_TYPE_GRAY:
-        fb.insert("Y", Slice(pt_, base, bpp, 0, 1, 1, 0.5));
+        fb.insert("Y", Slice(pt_, base, bpp, stride, 1, 1, 0.5));
         if (hasAlpha())
           {
-            fb.insert("A", Slice(pt_, base + bpc_, bpp, 0, 1, 1, 1.0));
+            fb.insert("A", Slice(pt_, base + bpc_, bpp, stride, 1, 1, 1.0));
           }
         break;
 
       case IMAGE_TYPE_RGB:
       default:
-        fb.insert("R", Slice(pt_, base + (bpc_ * 0), bpp, 0, 1, 1, 0.0));
-        fb.insert("G", Slice(pt_, base + (bpc_ * 1), bpp, 0, 1, 1, 0.0));
-        fb.insert("B", Slice(pt_, base + (bpc_ * 2), bpp, 0, 1, 1, 0.0));
+        fb.insert("R", Slice(pt_, base + (bpc_ * 0), bpp, stride, 1, 1, 0.0));
+        fb.insert("G", Slice(pt_, base + (bpc_ * 1), bpp, stride, 1, 1, 0.0));
+        fb.insert("B", Slice(pt_, base + (bpc_ * 2), bpp, stride, 1, 1, 0.0));
         if (hasAlpha())
           {
-            fb.insert("A", Slice(pt_, base + (bpc_ * 3), bpp, 0, 1, 1, 1.0));
+            fb.insert("A", Slice(pt_, base + (bpc_ * 3), bpp, stride, 1, 1, 1.0));
           }
       }
+  }
+
+  int readPixelRows(char* pixels,
+                    int bpp,
+                    int row,
+                    int n_rows) {
+    const size_t stride = (size_t) getWidth() * bpp;
+    const int first_row = read_window_.min.y + row;
+    const int last_row = first_row + n_rows - 1;
+    FrameBuffer fb;
+
+    if (tiled_)
+      return readLevelRows(pixels, bpp, first_row, last_row);
 
+    // This is necessary because OpenEXR expects the buffer to begin at
+    // (0, 0). Though it probably results in some unmapped address,
+    // hopefully OpenEXR will not make use of it. :/
+    char* base = pixels - (read_window_.min.x * bpp) - (first_row * stride);
+
+    insertSlices(fb, base, bpp, stride);
+
+    // Reading all rows in one go lets OpenEXR decode the line buffers
+    // or tiles they consist of on its thread pool.
     file_.setFrameBuffer(fb);
-    file_.readPixels(actual_row);
+    file_.readPixels(first_row, last_row);
+
+    return 0;
+  }
+
+  // Tiles always get decoded completely, so read the tile rows covering
+  // the requested rows of the selected level into a scratch buffer.
+  int readLevelRows(char* pixels,
+                    int bpp,
+                    int first_row,
+                    int last_row) {
+    const TileDescription& td = tiled_->tileDescription();
+    const size_t stride = (size_t) getWidth() * bpp;
+    const int first_tile = (first_row - read_window_.min.y) / td.ySize;
+    const int last_tile = (last_row - read_window_.min.y) / td.ySize;
+    const int tile_row = read_window_.min.y + first_tile * td.ySize;
+    const int n_rows = std::min ((last_tile + 1) * td.ySize,
+                                 read_window_.max.y - read_window_.min.y + 1) -
+                       first_tile * td.ySize;
+    std::vector<char> scratch ((size_t) n_rows * stride);
+    FrameBuffer fb;
+
+    char* base = &scratch[0] - (read_window_.min.x * bpp) - (tile_row * stride);
+
+    insertSlices(fb, base, bpp, stride);
+
+    tiled_->setFrameBuffer(fb);
+    tiled_->readTiles(0, tiled_->numXTiles(level_x_) - 1,
+                      first_tile, last_tile,
+                      level_x_, level_y_);
+
+    std::copy (scratch.begin() + (size_t) (first_row - tile_row) * stride,
+               scratch.begin() + (size_t) (last_row - tile_row + 1) * stride,
+               pixels);
+
+    return 0;
+  }
+
+  // Picks the smallest mip- or rip-map level that still is at least
+  // size pixels large, later reads return that level.
+  int selectLevel(int size) {
+    if (! file_.header().hasTileDescription())
+      return -1;
+
+    tiled_ = new TiledInputFile(filename_.c_str());
+
+    switch (tiled_->tileDescription().mode)
+      {
+      case MIPMAP_LEVELS:
+        for (level_x_ = tiled_->numLevels() - 1; level_x_ > 0; level_x_--)
+          {
+            if (std::max (tiled_->levelWidth(level_x_),
+                          tiled_->levelHeight(level_x_)) >= size)
+              break;
+          }
+        level_y_ = level_x_;
+        break;
+
+      case RIPMAP_LEVELS:
+        for (level_x_ = tiled_->numXLevels() - 1; level_x_ > 0; level_x_--)
+          {
+            if (tiled_->levelWidth(level_x_) >= size)
+              break;
+          }
+        for (level_y_ = tiled_->numYLevels() - 1; level_y_ > 0; level_y_--)
+          {
+            if (tiled_->levelHeight(level_y_) >= size)
+              break;
+          }
+        break;
+
+      case ONE_LEVEL:
+      default:
+        delete tiled_;
+        tiled_ = NULL;
+        return -1;
+      }
+
+    read_window_ = tiled_->dataWindowForLevel(level_x_, level_y_);
 
     return 0;
   }
 
   int getWidth() const {
-    return data_window_.max.x - data_window_.min.x + 1;
+    return read_window_.max.x - read_window_.min.x + 1;
   }
 
   int getHeight() const {
+    return read_window_.max.y - read_window_.min.y + 1;
+  }
+
+  int getImageWidth() const {
+    return data_window_.max.x - data_window_.min.x + 1;
+  }
+
+  int getImageHeight() const {
     return data_window_.max.y - data_window_.min.y + 1;
   }
 
@@ -171,9 +285,14 @@ struct _EXRLoader
   }
 
   size_t refcount_;
+  std::string filename_;
   InputFile file_;
   const Box2i data_window_;
+  Box2i read_window_;
   const ChannelList& channels_;
+  TiledInputFile* tiled_;
+  int level_x_;
+  int level_y_;
   PixelType pt_;
   int bpc_;
   EXRImageType image_type_;
@@ -186,6 +305,10 @@ exr_loader_new (const char *filename)
 {
   EXRLoader* file;
 
+  // Decode on all cores, the pool is shared by all files.
+  if (globalThreadCount() == 0)
+    setGlobalThreadCount(g_get_num_processors());
+
   // Don't let any exceptions propagate to the C layer.
   try
     {
@@ -271,16 +394,49 @@ exr_loader_has_alpha (EXRLoader *loader)
 }
 
 int
-exr_loader_read_pixel_row (EXRLoader *loader,
-                           char *pixels,
-                           int bpp,
-                           int row)
+exr_loader_get_image_width (EXRLoader *loader)
+{
+  // This does not throw.
+  return loader->getImageWidth();
+}
+
+int
+exr_loader_get_image_height (EXRLoader *loader)
+{
+  // This does not throw.
+  return loader->getImageHeight();
+}
+
+int
+exr_loader_select_level (EXRLoader *loader,
+                         int        size)
+{
+  int retval = -1;
+  // Don't let any exceptions propagate to the C layer.
+  try
+    {
+      retval = loader->selectLevel(size);
+    }
+  catch (...)
+    {
+      retval = -1;
+    }
+
+  return retval;
+}
+
+int
+exr_loader_read_pixel_rows (EXRLoader *loader,
+                            char *pixels,
+                            int bpp,
+                            int row,
+                            int n_rows)
 {
   int retval = -1;
   // Don't let any exceptions propagate to the C layer.
   try
     {
-      retval = loader->readPixelRow(pixels, bpp, row);
+      retval = loader->readPixelRows(pixels, bpp, row, n_rows);
     }
   catch (...)
     {
@@ -48,11 +48,28 @@ exr_loader_get_image_type (EXRLoader *loader);
 int
 exr_loader_has_alpha (EXRLoader *loader);
 
+/* The full size of the image, even if a smaller level is selected.
+ */
+int
+exr_loader_get_image_width (EXRLoader *loader);
+
+int
+exr_loader_get_image_height (EXRLoader *loader);
+
+/* Selects the smallest mip- or rip-map level at least size pixels
+ * large, for which exr_loader_get_width() and exr_loader_get_height()
+ * and reads are done from then on. Fails for files without levels.
+ */
+int
+exr_loader_select_level (EXRLoader *loader,
+                         int        size);
+
 int
-exr_loader_read_pixel_row (EXRLoader *loader,
-                           char *pixels,
-                           int bpp,
-                           int row);
+exr_loader_read_pixel_rows (EXRLoader *loader,
+                            char *pixels,
+                            int bpp,
+                            int row,
+                            int n_rows);
 
 #ifdef __cplusplus
 }
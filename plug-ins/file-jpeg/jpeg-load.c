@@ -59,6 +59,7 @@ gint32
 load_image (const gchar  *filename,
             GimpRunMode   runmode,
             gboolean      preview,
+            gint          thumb_size,
             gboolean     *resolution_loaded,
             GError      **error)
 {
@@ -159,7 +160,28 @@ load_image (const gchar  *filename,
    * method.
    */
 
-  cinfo.dct_method = JDCT_FLOAT;
+  if (thumb_size > 0)
+    {
+      gint  max_size = MAX (cinfo.image_width, cinfo.image_height);
+      gint  denom    = 8;
+
+      /* For thumbnails, let the IDCT scale the image down by up to 1/8,
+       * as far as it still gives at least thumb_size pixels, and use
+       * the fast methods since quality hardly matters at that size.
+       */
+      while (denom > 1 && max_size / denom < thumb_size)
+        denom /= 2;
+
+      cinfo.scale_num           = 1;
+      cinfo.scale_denom         = denom;
+      cinfo.dct_method          = JDCT_IFAST;
+      cinfo.do_fancy_upsampling = FALSE;
+      cinfo.do_block_smoothing  = FALSE;
+    }
+  else
+    {
+      cinfo.dct_method = JDCT_FLOAT;
+    }
 
   /* Step 5: Start decompressor */
 
@@ -486,6 +508,7 @@ jpeg_load_sanitize_comment (gchar *comment)
 
 gint32
 load_thumbnail_image (GFile         *file,
+                      gint           size,
                       gint          *width,
                       gint          *height,
                       GimpImageType *type,
@@ -500,8 +523,13 @@ load_thumbnail_image (GFile         *file,
                              g_file_get_parse_name (file));
 
   image_ID = gimp_image_metadata_load_thumbnail (file, error);
+
+  /* Without an Exif thumbnail, decode the image itself scaled down */
   if (image_ID < 1)
-    return -1;
+    {
+      g_clear_error (error);
+      image_ID = -1;
+    }
 
   cinfo.err = jpeg_std_error (&jerr.pub);
   jerr.pub.error_exit     = my_error_exit;
@@ -574,8 +602,11 @@ load_thumbnail_image (GFile         *file,
                  cinfo.output_components, cinfo.out_color_space,
                  cinfo.jpeg_color_space);
 
-      gimp_image_delete (image_ID);
+      if (image_ID != -1)
+        gimp_image_delete (image_ID);
+
       image_ID = -1;
+      *type    = -1;
       break;
     }
 
@@ -588,6 +619,16 @@ load_thumbnail_image (GFile         *file,
 
   fclose (infile);
 
+  if (image_ID == -1 && *type != -1)
+    {
+      gchar *filename = g_file_get_path (file);
+
+      image_ID = load_image (filename, GIMP_RUN_NONINTERACTIVE, FALSE,
+                             size, NULL, error);
+
+      g_free (filename);
+    }
+
   return image_ID;
 }
 
@@ -133,7 +133,9 @@ query (void)
 
   gimp_install_procedure (LOAD_THUMB_PROC,
                           "Loads a thumbnail from a JPEG image",
-                          "Loads a thumbnail from a JPEG image (only if it exists)",
+                          "Loads a thumbnail from a JPEG image, the embedded Exif "
+                          "thumbnail if there is one, otherwise the image "
+                          "itself, quickly scaled down while decoding",
                           "Mukund Sivaraman <muks@mukund.org>, Sven Neumann <sven@gimp.org>",
                           "Mukund Sivaraman <muks@mukund.org>, Sven Neumann <sven@gimp.org>",
                           "November 15, 2004",
@@ -210,7 +212,7 @@ run (const gchar      *name,
           break;
         }
 
-      image_ID = load_image (param[1].data.d_string, run_mode, FALSE,
+      image_ID = load_image (param[1].data.d_string, run_mode, FALSE, 0,
                              &resolution_loaded, &error);
 
       if (image_ID != -1)
@@ -259,7 +261,8 @@ run (const gchar      *name,
           gint          height = 0;
           GimpImageType type   = -1;
 
-          image_ID = load_thumbnail_image (file, &width, &height, &type,
+          image_ID = load_thumbnail_image (file, param[1].data.d_int32,
+                                           &width, &height, &type,
                                            &error);
 
           g_object_unref (file);
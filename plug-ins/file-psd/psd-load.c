@@ -102,6 +102,12 @@ static void             convert_1_bit              (const gchar *src,
                                                     guint32      rows,
                                                     guint32      columns);
 
+static void             draw_channels              (GeglBuffer    *buffer,
+                                                    const Babl    *format,
+                                                    gchar        **chn_data,
+                                                    guint16        n_channels,
+                                                    guint16        bps);
+
 static const Babl*      get_layer_format           (PSDimage    *img_a,
                                                     gboolean     alpha);
 static const Babl*      get_channel_format         (PSDimage    *img_a);
@@ -1053,6 +1059,7 @@ add_layers (gint32     image_id,
             GError   **error)
 {
   PSDchannel          **lyr_chn;
+  gchar                *chn_data[MAX_CHANNELS];
   GArray               *parent_group_stack;
   gint32                parent_group_id = -1;
   guchar               *pixels;
@@ -1381,20 +1388,9 @@ add_layers (gint32     image_id,
               IFDBG(3) g_debug ("Draw layer");
               image_type = get_gimp_image_type (img_a->base_type, alpha);
               IFDBG(3) g_debug ("Layer type %d", image_type);
-              layer_size = l_w * l_h;
               bps = img_a->bps / 8;
               if (bps == 0)
                 bps++;
-              pixels = g_malloc (layer_size * layer_channels * bps);
-              for (cidx = 0; cidx < layer_channels; ++cidx)
-                {
-                  IFDBG(3) g_debug ("Start channel %d", channel_idx[cidx]);
-                  for (i = 0; i < layer_size; ++i)
-                    memcpy (&pixels[((i * layer_channels) + cidx) * bps],
-                            &lyr_chn[channel_idx[cidx]]->data[i * bps], bps);
-                  g_free (lyr_chn[channel_idx[cidx]]->data);
-                }
-
               layer_mode = psd_to_gimp_blend_mode (lyr_a[lidx]->blend_mode);
               layer_id = gimp_layer_new (image_id, lyr_a[lidx]->name, l_w, l_h,
                                          image_type, lyr_a[lidx]->opacity * 100 / 255,
@@ -1404,18 +1400,21 @@ add_layers (gint32     image_id,
               gimp_image_insert_layer (image_id, layer_id, parent_group_id, -1);
               gimp_layer_set_offsets (layer_id, l_x, l_y);
               gimp_layer_set_lock_alpha  (layer_id, lyr_a[lidx]->layer_flags.trans_prot);
+
+              for (cidx = 0; cidx < layer_channels; ++cidx)
+                chn_data[cidx] = lyr_chn[channel_idx[cidx]]->data;
+
               buffer = gimp_drawable_get_buffer (layer_id);
-              gegl_buffer_set (buffer,
-                               GEGL_RECTANGLE (0, 0,
-                                               gegl_buffer_get_width (buffer),
-                                               gegl_buffer_get_height (buffer)),
-                               0, get_layer_format (img_a, alpha),
-                               pixels, GEGL_AUTO_ROWSTRIDE);
+              draw_channels (buffer, get_layer_format (img_a, alpha),
+                             chn_data, layer_channels, bps);
+
+              for (cidx = 0; cidx < layer_channels; ++cidx)
+                g_free (lyr_chn[channel_idx[cidx]]->data);
+
               gimp_item_set_visible (layer_id, lyr_a[lidx]->layer_flags.visible);
               if (lyr_a[lidx]->id)
                 gimp_item_set_tattoo (layer_id, lyr_a[lidx]->id);
               g_object_unref (buffer);
-              g_free (pixels);
             }
 
           /* Layer mask */
@@ -1553,8 +1552,8 @@ add_merged_image (gint32     image_id,
                   GError   **error)
 {
   PSDchannel            chn_a[MAX_CHANNELS];
+  gchar                *chn_data[MAX_CHANNELS];
   gchar                *alpha_name;
-  guchar               *pixels;
   guint16               comp_mode;
   guint16               base_channels;
   guint16               extra_channels;
@@ -1562,7 +1561,6 @@ add_merged_image (gint32     image_id,
   guint16               bps;
   guint16              *rle_pack_len[MAX_CHANNELS];
   guint32               alpha_id;
-  gint32                layer_size;
   gint32                layer_id = -1;
   gint32                channel_id = -1;
   gint32                active_layer;
@@ -1687,18 +1685,6 @@ add_merged_image (gint32     image_id,
     {
       image_type = get_gimp_image_type (img_a->base_type, img_a->transparency);
 
-      layer_size = img_a->columns * img_a->rows;
-      pixels = g_malloc (layer_size * base_channels * bps);
-      for (cidx = 0; cidx < base_channels; ++cidx)
-        {
-          for (i = 0; i < layer_size; ++i)
-            {
-              memcpy (&pixels[((i * base_channels) + cidx) * bps],
-                      &chn_a[cidx].data[i * bps], bps);
-            }
-          g_free (chn_a[cidx].data);
-        }
-
       /* Add background layer */
       IFDBG(2) g_debug ("Draw merged image");
       layer_id = gimp_layer_new (image_id, _("Background"),
@@ -1706,15 +1692,18 @@ add_merged_image (gint32     image_id,
                                  image_type,
                                  100, GIMP_NORMAL_MODE);
       gimp_image_insert_layer (image_id, layer_id, -1, 0);
+
+      for (cidx = 0; cidx < base_channels; ++cidx)
+        chn_data[cidx] = chn_a[cidx].data;
+
       buffer = gimp_drawable_get_buffer (layer_id);
-      gegl_buffer_set (buffer,
-                       GEGL_RECTANGLE (0, 0,
-                                       gegl_buffer_get_width (buffer),
-                                       gegl_buffer_get_height (buffer)),
-                       0, get_layer_format (img_a, img_a->transparency),
-                       pixels, GEGL_AUTO_ROWSTRIDE);
+      draw_channels (buffer, get_layer_format (img_a, img_a->transparency),
+                     chn_data, base_channels, bps);
+
+      for (cidx = 0; cidx < base_channels; ++cidx)
+        g_free (chn_a[cidx].data);
+
       g_object_unref (buffer);
-      g_free (pixels);
     }
   else
     {
@@ -1730,7 +1719,6 @@ add_merged_image (gint32     image_id,
       && image_id > -1)
     {
       IFDBG(2) g_debug ("Add extra channels");
-      pixels = g_malloc(0);
 
       /* Get channel resource data */
       if (img_a->transparency)
@@ -1791,8 +1779,6 @@ add_merged_image (gint32     image_id,
             }
 
           cidx = base_channels + i;
-          pixels = g_realloc (pixels, chn_a[cidx].columns * chn_a[cidx].rows);
-          memcpy (pixels, chn_a[cidx].data, chn_a[cidx].columns * chn_a[cidx].rows);
           channel_id = gimp_channel_new (image_id, alpha_name,
                                          chn_a[cidx].columns, chn_a[cidx].rows,
                                          alpha_opacity, &alpha_rgb);
@@ -1807,12 +1793,11 @@ add_merged_image (gint32     image_id,
                                            gegl_buffer_get_width (buffer),
                                            gegl_buffer_get_height (buffer)),
                            0, get_channel_format (img_a),
-                           pixels, GEGL_AUTO_ROWSTRIDE);
+                           chn_a[cidx].data, GEGL_AUTO_ROWSTRIDE);
           g_object_unref (buffer);
           g_free (chn_a[cidx].data);
         }
 
-      g_free (pixels);
       if (img_a->alpha_names)
         g_ptr_array_free (img_a->alpha_names, TRUE);
 
@@ -1956,15 +1941,17 @@ read_channel_data (PSDchannel     *channel,
         if (fread (raw_data, readline_len, channel->rows, f) < 1)
           {
             psd_set_error (feof (f), errno, error);
+            g_free (raw_data);
             return -1;
           }
         break;
 
       case PSD_COMP_RLE:
+        src = NULL;
         for (i = 0; i < channel->rows; ++i)
           {
-            src = g_malloc (rle_pack_len[i]);
-            dst = g_malloc (readline_len);
+            src = g_realloc (src, rle_pack_len[i]);
+            dst = raw_data + i * readline_len;
 /*      FIXME check for over-run
             if (ftell (f) + rle_pack_len[i] > block_end)
               {
@@ -1976,15 +1963,13 @@ read_channel_data (PSDchannel     *channel,
               {
                 psd_set_error (feof (f), errno, error);
                 g_free (src);
-                g_free (dst);
+                g_free (raw_data);
                 return -1;
               }
             /* FIXME check for errors returned from decode packbits */
             decode_packbits (src, dst, rle_pack_len[i], readline_len);
-            g_free (src);
-            memcpy (raw_data + i * readline_len, dst, readline_len);
-            g_free (dst);
           }
+        g_free (src);
         break;
     }
 
@@ -1994,22 +1979,22 @@ read_channel_data (PSDchannel     *channel,
       case 32:
       case 16:
       case 8:
-        channel->data = (gchar *) g_malloc (channel->rows * channel->columns * bps / 8 );
-        memcpy (channel->data, raw_data, (channel->rows * channel->columns * bps / 8));
+        /* The raw rows are already in GIMP layout, keep them as they are */
+        channel->data = raw_data;
         break;
 
       case 1:
         channel->data = (gchar *) g_malloc (channel->rows * channel->columns);
         convert_1_bit (raw_data, channel->data, channel->rows, channel->columns);
+        g_free (raw_data);
         break;
 
       default:
+        g_free (raw_data);
         return -1;
         break;
     }
 
-  g_free (raw_data);
-
   return 1;
 }
 
@@ -2046,6 +2031,58 @@ convert_1_bit (const gchar *src,
   IFDBG(3)  g_debug ("End 1 bit conversion");
 }
 
+static void
+draw_channels (GeglBuffer  *buffer,
+               const Babl  *format,
+               gchar      **chn_data,
+               guint16      n_channels,
+               guint16      bps)
+{
+/* Interleave the separate channel planes into the buffer one band of
+   tile rows at a time, so that only a band of pixels and not a second
+   copy of the whole layer is held in memory while drawing.
+*/
+  gint     width       = gegl_buffer_get_width (buffer);
+  gint     height      = gegl_buffer_get_height (buffer);
+  gint     band_height = MIN (gimp_tile_height (), height);
+  gsize    pixel_size  = (gsize) n_channels * bps;
+  guchar  *pixels;
+  gint     y;
+
+  pixels = g_malloc ((gsize) width * band_height * pixel_size);
+
+  for (y = 0; y < height; y += band_height)
+    {
+      gint   rows   = MIN (band_height, height - y);
+      gsize  n      = (gsize) width * rows;
+      gsize  offset = (gsize) width * y * bps;
+      gint   cidx;
+      gsize  i;
+
+      for (cidx = 0; cidx < n_channels; ++cidx)
+        {
+          const gchar *src = chn_data[cidx] + offset;
+          guchar      *dst = pixels + cidx * bps;
+
+          if (bps == 1)
+            {
+              for (i = 0; i < n; ++i, dst += pixel_size)
+                *dst = src[i];
+            }
+          else
+            {
+              for (i = 0; i < n; ++i, src += bps, dst += pixel_size)
+                memcpy (dst, src, bps);
+            }
+        }
+
+      gegl_buffer_set (buffer, GEGL_RECTANGLE (0, y, width, rows),
+                       0, format, pixels, GEGL_AUTO_ROWSTRIDE);
+    }
+
+  g_free (pixels);
+}
+
 static const Babl*
 get_layer_format (PSDimage *img_a,
                   gboolean  alpha)
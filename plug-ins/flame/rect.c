@@ -20,6 +20,8 @@
 
 #include <string.h>
 
+#include <glib.h>
+
 
 /* for batch
  *   interpolate
@@ -49,6 +51,22 @@ typedef long accum_t;
 
 typedef accum_t abucket[4];
 
+typedef struct
+{
+  const double  *filter;
+  int            filter_width;
+  const abucket *accumulate;
+  int            width;
+  int            oversample;
+  int            image_width;
+  int            image_height;
+  unsigned char *out;
+  int            out_width;
+  int            nchan;
+  double         g;
+  int            next_row;
+} filter_job;
+
 
 
 /* allow this many iterations for settling into attractor */
@@ -60,6 +78,10 @@ typedef accum_t abucket[4];
 /* should be MAXBUCKET / (OVERSAMPLE^2) */
 #define PREFILTER_WHITE (MAXBUCKET>>4)
 
+/* threads and rows per thread for filtering into the image */
+#define MAX_THREADS 16
+#define CHUNK_ROWS  16
+
 
 #define bump_no_overflow(dest, delta, type) { \
    type tt_ = dest + delta;            \
@@ -80,6 +102,76 @@ normalize_vector(double *v,
     v[i] *= t;
 }
 
+static void
+filter_rows (filter_job *job,
+             int         first,
+             int         last)
+{
+  int    i, j;
+  int    x, y;
+  double t[4];
+  double g = job->g;
+  int    filter_width = job->filter_width;
+
+  y = first * job->oversample;
+  for (j = first; j < last; j++)
+    {
+      x = 0;
+      for (i = 0; i < job->image_width; i++)
+        {
+          int            ii, jj, a;
+          unsigned char *p;
+          t[0] = t[1] = t[2] = t[3] = 0.0;
+          for (ii = 0; ii < filter_width; ii++)
+            for (jj = 0; jj < filter_width; jj++)
+              {
+                double k = job->filter[ii + jj * filter_width];
+                const abucket *a = job->accumulate + x + ii + (y + jj) * job->width;
+
+                t[0] += k * a[0][0];
+                t[1] += k * a[0][1];
+                t[2] += k * a[0][2];
+                t[3] += k * a[0][3];
+              }
+          /* FIXME: we should probably use glib facilities to make
+           * this code readable
+           */
+          p = job->out + job->nchan * (i + j * job->out_width);
+          a = 256.0 * pow((double) t[0] / PREFILTER_WHITE, g) + 0.5;
+          if (a < 0) a = 0; else if (a > 255) a = 255;
+          p[0] = a;
+          a = 256.0 * pow((double) t[1] / PREFILTER_WHITE, g) + 0.5;
+          if (a < 0) a = 0; else if (a > 255) a = 255;
+          p[1] = a;
+          a = 256.0 * pow((double) t[2] / PREFILTER_WHITE, g) + 0.5;
+          if (a < 0) a = 0; else if (a > 255) a = 255;
+          p[2] = a;
+          if (job->nchan > 3)
+            {
+              a = 256.0 * pow((double) t[3] / PREFILTER_WHITE, g) + 0.5;
+              if (a < 0) a = 0; else if (a > 255) a = 255;
+              p[3] = a;
+            }
+          x += job->oversample;
+        }
+      y += job->oversample;
+    }
+}
+
+static gpointer
+filter_thread (filter_job *job)
+{
+  int row;
+
+  while ((row = g_atomic_int_add (&job->next_row, CHUNK_ROWS)) <
+         job->image_height)
+    {
+      filter_rows (job, row, MIN (row + CHUNK_ROWS, job->image_height));
+    }
+
+  return NULL;
+}
+
 void
 render_rectangle (frame_spec    *spec,
                   unsigned char *out,
@@ -337,58 +429,48 @@ render_rectangle (frame_spec    *spec,
         }
     }
   /*
-   * filter the accumulation buffer down into the image
+   * filter the accumulation buffer down into the image, one band of
+   * rows per thread.  the main thread reports the progress.
    */
   if (1)
     {
-      int    x, y;
-      double t[4];
-      double g = 1.0 / spec->cps[0].gamma;
-      y = 0;
-      for (j = 0; j < image_height; j++)
+      filter_job job;
+      GThread   *threads[MAX_THREADS];
+      int        n_threads;
+      int        row;
+
+      job.filter       = filter;
+      job.filter_width = filter_width;
+      job.accumulate   = accumulate;
+      job.width        = width;
+      job.oversample   = oversample;
+      job.image_width  = image_width;
+      job.image_height = image_height;
+      job.out          = out;
+      job.out_width    = out_width;
+      job.nchan        = nchan;
+      job.g            = 1.0 / spec->cps[0].gamma;
+      job.next_row     = 0;
+
+      n_threads = CLAMP (g_get_num_processors (), 1, MAX_THREADS);
+      n_threads = MIN (n_threads,
+                       (image_height + CHUNK_ROWS - 1) / CHUNK_ROWS);
+
+      for (i = 1; i < n_threads; i++)
+        threads[i] = g_thread_new ("flame",
+                                   (GThreadFunc) filter_thread, &job);
+
+      while ((row = g_atomic_int_add (&job.next_row, CHUNK_ROWS)) <
+             image_height)
         {
-          if (progress && (j % 32) == 0)
-            (*progress)(0.5 + 0.5 * j / (double)image_height);
-          x = 0;
-          for (i = 0; i < image_width; i++)
-            {
-              int            ii, jj, a;
-              unsigned char *p;
-              t[0] = t[1] = t[2] = t[3] = 0.0;
-              for (ii = 0; ii < filter_width; ii++)
-                for (jj = 0; jj < filter_width; jj++)
-                  {
-                    double k = filter[ii + jj * filter_width];
-                    abucket *a = accumulate + x + ii + (y + jj) * width;
-
-                    t[0] += k * a[0][0];
-                    t[1] += k * a[0][1];
-                    t[2] += k * a[0][2];
-                    t[3] += k * a[0][3];
-                  }
-              /* FIXME: we should probably use glib facilities to make
-               * this code readable
-               */
-              p = out + nchan * (i + j * out_width);
-              a = 256.0 * pow((double) t[0] / PREFILTER_WHITE, g) + 0.5;
-              if (a < 0) a = 0; else if (a > 255) a = 255;
-              p[0] = a;
-              a = 256.0 * pow((double) t[1] / PREFILTER_WHITE, g) + 0.5;
-              if (a < 0) a = 0; else if (a > 255) a = 255;
-              p[1] = a;
-              a = 256.0 * pow((double) t[2] / PREFILTER_WHITE, g) + 0.5;
-              if (a < 0) a = 0; else if (a > 255) a = 255;
-              p[2] = a;
-              if (nchan > 3)
-                {
-                  a = 256.0 * pow((double) t[3] / PREFILTER_WHITE, g) + 0.5;
-                  if (a < 0) a = 0; else if (a > 255) a = 255;
-                  p[3] = a;
-                }
-              x += oversample;
-            }
-          y += oversample;
+          if (progress)
+            (*progress)(0.5 + 0.5 * row / (double)image_height);
+
+          filter_rows (&job, row, MIN (row + CHUNK_ROWS, image_height));
         }
+
+      for (i = 1; i < n_threads; i++)
+        g_thread_join (threads[i]);
     }
 
   free (filter);
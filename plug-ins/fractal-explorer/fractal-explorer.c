@@ -70,6 +70,20 @@
 #include "libgimp/stdplugins-intl.h"
 
 
+#define MAX_THREADS 16
+
+
+typedef struct
+{
+  guchar *band;
+  gint    band_y;
+  gint    band_height;
+  gint    row_width;
+  gint    bpp;
+  gint    next_row;
+} ExplorerBand;
+
+
 /**********************************************************************
   Global variables
  *********************************************************************/
@@ -142,6 +156,7 @@ static void run   (const gchar      *name,
                    GimpParam       **return_vals);
 
 static void explorer            (GimpDrawable *drawable);
+static gpointer explorer_render_band (ExplorerBand *band);
 
 /**********************************************************************
  Declare local functions
@@ -394,11 +409,30 @@ run (const gchar      *name,
  FUNCTION: explorer
  *********************************************************************/
 
+static gpointer
+explorer_render_band (ExplorerBand *band)
+{
+  gint row;
+
+  while ((row = g_atomic_int_add (&band->next_row, 1)) < band->band_height)
+    {
+      explorer_render_row (NULL,
+                           band->band + row * band->row_width * band->bpp,
+                           band->band_y + row,
+                           band->row_width,
+                           band->bpp);
+    }
+
+  return NULL;
+}
+
 static void
 explorer (GimpDrawable * drawable)
 {
-  GimpPixelRgn  srcPR;
   GimpPixelRgn  destPR;
+  ExplorerBand  band;
+  GThread      *threads[MAX_THREADS];
+  gint          n_threads;
   gint          width;
   gint          height;
   gint          bpp;
@@ -407,8 +441,7 @@ explorer (GimpDrawable * drawable)
   gint          y1;
   gint          x2;
   gint          y2;
-  guchar       *src_row;
-  guchar       *dest_row;
+  gint          i;
 
   /* Get the input area. This is the bounding box of the selection in
    *  the image (or the entire image if there is no selection). Only
@@ -425,12 +458,15 @@ explorer (GimpDrawable * drawable)
   height = drawable->height;
   bpp  = drawable->bpp;
 
-  /*  allocate row buffers  */
-  src_row  = g_new (guchar, bpp * (x2 - x1));
-  dest_row = g_new (guchar, bpp * (x2 - x1));
+  /*  the fractal doesn't depend on the source pixels, so only the
+   *  destination is needed; it is rendered in bands of tile rows,
+   *  whose rows are shared out among the threads
+   */
+  band.row_width = x2 - x1;
+  band.bpp       = bpp;
+  band.band      = g_new (guchar, bpp * band.row_width * gimp_tile_height ());
 
   /*  initialize the pixel regions  */
-  gimp_pixel_rgn_init (&srcPR, drawable, 0, 0, width, height, FALSE, FALSE);
   gimp_pixel_rgn_init (&destPR, drawable, 0, 0, width, height, TRUE, TRUE);
 
   xbild = width;
@@ -441,28 +477,35 @@ explorer (GimpDrawable * drawable)
   /* for grayscale drawables */
   if (bpp < 3)
     {
-      gint     i;
       for (i = 0; i < MAXNCOLORS; i++)
           valuemap[i] = GIMP_RGB_LUMINANCE (colormap[i].r,
                                             colormap[i].g,
                                             colormap[i].b);
     }
 
-  for (row = y1; row < y2; row++)
+  n_threads = CLAMP (g_get_num_processors (), 1, MAX_THREADS);
+
+  for (row = y1; row < y2; row += band.band_height)
     {
-      gimp_pixel_rgn_get_row (&srcPR, src_row, x1, row, (x2 - x1));
+      band.band_y      = row;
+      band.band_height = MIN (gimp_tile_height () - row % gimp_tile_height (),
+                              y2 - row);
+      band.next_row    = 0;
+
+      for (i = 1; i < n_threads; i++)
+        threads[i] = g_thread_new ("fractal-explorer",
+                                   (GThreadFunc) explorer_render_band, &band);
+
+      explorer_render_band (&band);
 
-      explorer_render_row (src_row,
-                           dest_row,
-                           row,
-                           (x2 - x1),
-                           bpp);
+      for (i = 1; i < n_threads; i++)
+        g_thread_join (threads[i]);
 
       /*  store the dest  */
-      gimp_pixel_rgn_set_row (&destPR, dest_row, x1, row, (x2 - x1));
+      gimp_pixel_rgn_set_rect (&destPR, band.band,
+                               x1, row, band.row_width, band.band_height);
 
-      if ((row % 10) == 0)
-        gimp_progress_update ((double) row / (double) (y2 - y1));
+      gimp_progress_update ((double) (row - y1) / (double) (y2 - y1));
     }
   gimp_progress_update (1.0);
 
@@ -471,8 +514,7 @@ explorer (GimpDrawable * drawable)
   gimp_drawable_merge_shadow (drawable->drawable_id, TRUE);
   gimp_drawable_update (drawable->drawable_id, x1, y1, (x2 - x1), (y2 - y1));
 
-  g_free (src_row);
-  g_free (dest_row);
+  g_free (band.band);
 }
 
 /**********************************************************************
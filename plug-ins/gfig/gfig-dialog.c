@@ -575,6 +575,9 @@ gfig_response (GtkWidget *widget,
       break;
     }
 
+  /* don't lose a pending repaint of the drawable */
+  gfig_paint_flush ();
+
   gtk_widget_destroy (widget);
   gtk_main_quit ();
 }
@@ -1978,8 +1981,14 @@ paint_layer_fill (gdouble x1, gdouble y1, gdouble x2, gdouble y2)
                          0.0);                /* y - ignored */
 }
 
-void
-gfig_paint_callback (void)
+/* Painting the objects onto the drawable goes through the PDB for
+ * every object, so a burst of changes (like dragging a spin button)
+ * is coalesced into one repaint when the main loop becomes idle.
+ */
+static guint paint_idle_id = 0;
+
+static void
+gfig_paint (void)
 {
   GList      *objs;
   gint        ccount = 0;
@@ -2024,6 +2033,33 @@ gfig_paint_callback (void)
   gtk_widget_queue_draw (gfig_context->preview);
 }
 
+static gboolean
+gfig_paint_idle (gpointer data)
+{
+  paint_idle_id = 0;
+
+  gfig_paint ();
+
+  return FALSE;
+}
+
+void
+gfig_paint_callback (void)
+{
+  if (! paint_idle_id)
+    paint_idle_id = g_idle_add (gfig_paint_idle, NULL);
+}
+
+void
+gfig_paint_flush (void)
+{
+  if (paint_idle_id)
+    {
+      g_source_remove (paint_idle_id);
+      gfig_paint_idle (NULL);
+    }
+}
+
 /* Draw the grid on the screen
  */
 
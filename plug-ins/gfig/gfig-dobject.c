@@ -25,6 +25,7 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
 
 #include <libgimp/gimp.h>
 #include <libgimp/gimpui.h>
@@ -630,9 +631,11 @@ do_move_obj (GfigObject *obj,
 
   if (xdiff || ydiff)
     {
+      gfig_object_queue_draw (obj);
+
       update_pnts (obj, xdiff, ydiff);
 
-      gtk_widget_queue_draw (gfig_context->preview);
+      gfig_object_queue_draw (obj);
     }
 }
 
@@ -651,11 +654,13 @@ do_move_obj_pnt (GfigObject *obj,
   if ((!xdiff && !ydiff) || !spnt)
     return;
 
+  gfig_object_queue_draw (obj);
+
   spnt->pnt.x = spnt->pnt.x - xdiff;
   spnt->pnt.y = spnt->pnt.y - ydiff;
 
   /* Draw in new pos */
-  gtk_widget_queue_draw (gfig_context->preview);
+  gfig_object_queue_draw (obj);
 }
 
 /* copy objs */
@@ -688,6 +693,78 @@ draw_one_obj (GfigObject *obj,
   obj->class->drawfunc (obj, cr);
 }
 
+/* Everything the preview outline of an object depends on, hashed.
+ * The object's cached bounds are valid as long as this doesn't change.
+ */
+static guint
+object_bounds_key (GfigObject *obj)
+{
+  DobjPoints *spnt;
+  guint       key;
+
+  key = obj->type * 31 + obj->type_data;
+
+  for (spnt = obj->points; spnt; spnt = spnt->next)
+    key = (key * 31 + spnt->pnt.x) * 31 + spnt->pnt.y;
+
+  key = key * 31 + gfig_scale_x (10000);
+  key = key * 31 + gfig_scale_y (10000);
+  key = key * 31 + selvals.opts.showcontrol;
+  key = key * 31 + (obj == obj_creating);
+  key = key * 31 + (tmp_bezier != NULL);
+
+  /* 0 means "no bounds yet" */
+  return key ? key : 1;
+}
+
+/* Returns the area of the preview the object draws to, drawing it
+ * into a recording surface only when it changed since the last time.
+ */
+static const GdkRectangle *
+object_get_bounds (GfigObject *obj)
+{
+  guint key = object_bounds_key (obj);
+
+  if (key != obj->bounds_key)
+    {
+      cairo_surface_t *surface;
+      cairo_t         *cr;
+      gdouble          x, y, width, height;
+
+      surface = cairo_recording_surface_create (CAIRO_CONTENT_COLOR_ALPHA,
+                                                NULL);
+      cr = cairo_create (surface);
+
+      draw_one_obj (obj, cr);
+
+      cairo_destroy (cr);
+
+      cairo_recording_surface_ink_extents (surface, &x, &y, &width, &height);
+      cairo_surface_destroy (surface);
+
+      obj->bounds.x      = floor (x) - 1;
+      obj->bounds.y      = floor (y) - 1;
+      obj->bounds.width  = ceil (x + width)  + 1 - obj->bounds.x;
+      obj->bounds.height = ceil (y + height) + 1 - obj->bounds.y;
+      obj->bounds_key    = key;
+    }
+
+  return &obj->bounds;
+}
+
+/* Queues a redraw of only the part of the preview the object covers.
+ * Call it before and after changing the object.
+ */
+void
+gfig_object_queue_draw (GfigObject *obj)
+{
+  const GdkRectangle *bounds = object_get_bounds (obj);
+
+  gtk_widget_queue_draw_area (gfig_context->preview,
+                              bounds->x,     bounds->y,
+                              bounds->width, bounds->height);
+}
+
 void
 draw_objects (GList    *objs,
               gboolean  show_single,
@@ -697,12 +774,27 @@ draw_objects (GList    *objs,
    * is down in which case show all.
    */
 
-  gint count = 0;
+  GdkRectangle clip;
+  gdouble      x1, y1, x2, y2;
+  gint         count = 0;
+
+  /* objects outside of the exposed area are skipped */
+  cairo_clip_extents (cr, &x1, &y1, &x2, &y2);
+
+  clip.x      = floor (x1);
+  clip.y      = floor (y1);
+  clip.width  = ceil (x2) - clip.x;
+  clip.height = ceil (y2) - clip.y;
 
   while (objs)
     {
       if (!show_single || count == obj_show_single || obj_show_single == -1)
-        draw_one_obj (objs->data, cr);
+        {
+          GfigObject *obj = objs->data;
+
+          if (gdk_rectangle_intersect (object_get_bounds (obj), &clip, NULL))
+            draw_one_obj (obj, cr);
+        }
 
       objs = g_list_next (objs);
       count++;
@@ -61,6 +61,8 @@ struct _GfigObject
   DobjPoints      *points;     /* List of points */
   Style            style;      /* this object's individual style settings */
   gint             style_no;   /* style index of this specific object */
+  guint            bounds_key; /* what the cached bounds were computed for */
+  GdkRectangle     bounds;     /* preview area covered by the object */
 };
 
 /* States of the object */
@@ -85,6 +87,7 @@ GList      *copy_all_objs            (GList      *objs);
 void        draw_objects             (GList      *objs,
                                       gboolean    show_single,
                                       cairo_t    *cr);
+void        gfig_object_queue_draw   (GfigObject *obj);
 
 GfigObject *d_load_object            (gchar      *desc,
                                       FILE       *fp);
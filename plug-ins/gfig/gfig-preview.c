@@ -166,6 +166,10 @@ gfig_preview_expose (GtkWidget *widget,
 {
   cairo_t *cr = gdk_cairo_create (event->expose.window);
 
+  /* only redraw the damaged part */
+  gdk_cairo_region (cr, event->expose.region);
+  cairo_clip (cr);
+
   if (gfig_context->show_background)
     draw_background (cr);
 
@@ -289,8 +293,9 @@ gfig_preview_events (GtkWidget *widget,
 
       if (obj_creating)
         {
+          gfig_object_queue_draw (obj_creating);
           obj_creating->class->update (&point);
-          gtk_widget_queue_draw (widget);
+          gfig_object_queue_draw (obj_creating);
         }
       gfig_pos_update (point.x, point.y);
       break;
@@ -213,6 +213,7 @@ void    gfig_draw_line          (gint x0,
                                  cairo_t *cr);
 
 void      gfig_paint_callback   (void);
+void      gfig_paint_flush      (void);
 GFigObj  *gfig_load             (const gchar *filename,
                                  const gchar *name);
 void   gfig_name_encode         (gchar *dest,
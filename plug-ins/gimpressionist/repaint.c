@@ -36,7 +36,49 @@
 
 #include <libgimp/stdplugins-intl.h>
 
+
+#define MAX_THREADS 16
+#define TILE_SIZE   64
+
+
+/* A brush stroke, as planned before anything is painted. */
+typedef struct
+{
+  int n;          /* index into the brush set */
+  int tx, ty;     /* top left corner of the brush */
+  int r, g, b;
+} stroke_t;
+
+/* The rotated and scaled brushes for one set of brush settings.  They
+ * are kept around, so that repainting the preview or the image with
+ * unchanged brush settings doesn't have to build them again.
+ */
+typedef struct
+{
+  ppm_t                  source;
+  gimpressionist_vals_t  vals;
+  ppm_t                 *brushes;
+  ppm_t                 *shadows;
+  double                *brushes_sum;
+  int                    num_brushes;
+  int                    maxbrushwidth;
+  int                    maxbrushheight;
+} brush_set_t;
+
+typedef struct
+{
+  ppm_t    *tmp;
+  ppm_t    *atmp;
+  stroke_t *strokes;
+  GArray  **tiles;        /* stroke indices per tile, in paint order */
+  int       tiles_x;
+  int       n_tiles;
+  int       next_tile;
+} paint_job_t;
+
+
 static gimpressionist_vals_t runningvals;
+static brush_set_t           brush_set = { { 0, 0, NULL }, };
 
 static double
 get_siz_from_pcvals (double x, double y)
@@ -224,16 +266,21 @@ choose_best_brush (ppm_t *p, ppm_t *a, int tx, int ty,
   return best;
 }
 
+/* Paints a brush stroke, only touching the pixels inside the
+ * (x1, y1) - (x2, y2) rectangle, which must lie inside the image.
+ */
 static void
 apply_brush (ppm_t *brush,
              ppm_t *shadow,
              ppm_t *p, ppm_t *a,
-             int tx, int ty, int r, int g, int b)
+             int tx, int ty, int r, int g, int b,
+             int x1, int y1, int x2, int y2)
 {
   ppm_t  tmp;
   ppm_t  atmp;
   double v, h;
   int    x, y;
+  int    xs, ys, xe, ye;
   double edgedarken = 1.0 - runningvals.general_dark_edge;
   double relief = runningvals.brush_relief / 100.0;
   int    shadowdepth = pcvals.general_shadow_depth;
@@ -251,28 +298,24 @@ apply_brush (ppm_t *brush,
       int sx = tx + shadowdepth - shadowblur * 2;
       int sy = ty + shadowdepth - shadowblur * 2;
 
-      for (y = 0; y < shadow->height; y++)
+      ys = MAX (0, y1 - sy);
+      ye = MIN (shadow->height, y2 - sy);
+      xs = MAX (0, x1 - sx);
+      xe = MIN (shadow->width, x2 - sx);
+
+      for (y = ys; y < ye; y++)
         {
           guchar *row, *arow = NULL;
 
-          if ((sy + y) < 0)
-            continue;
-          if ((sy + y) >= tmp.height)
-            break;
           row = tmp.col + (sy + y) * tmp.width * 3;
 
           if (img_has_alpha)
             arow = atmp.col + (sy + y) * atmp.width * 3;
 
-          for (x = 0; x < shadow->width; x++)
+          for (x = xs; x < xe; x++)
             {
               int k = (sx + x) * 3;
 
-              if ((sx + x) < 0)
-                continue;
-              if ((sx + x) >= tmp.width)
-                break;
-
               h = shadow->col[y * shadow->width * 3 + x * 3 + 2];
 
               if (!h)
@@ -288,7 +331,12 @@ apply_brush (ppm_t *brush,
         }
     }
 
-  for (y = 0; y < brush->height; y++)
+  ys = MAX (0, y1 - ty);
+  ye = MIN (brush->height, y2 - ty);
+  xs = MAX (0, x1 - tx);
+  xe = MIN (brush->width, x2 - tx);
+
+  for (y = ys; y < ye; y++)
     {
       guchar *row = tmp.col + (ty + y) * tmp.width * 3;
       guchar *arow = NULL;
@@ -296,7 +344,7 @@ apply_brush (ppm_t *brush,
       if (img_has_alpha)
         arow = atmp.col + (ty + y) * atmp.width * 3;
 
-      for (x = 0; x < brush->width; x++)
+      for (x = xs; x < xe; x++)
         {
           int k = (tx + x) * 3;
           h = brush->col[y * brush->width * 3 + x * 3];
@@ -327,11 +375,11 @@ apply_brush (ppm_t *brush,
 
   if (relief > 0.001)
     {
-      for (y = 1; y < brush->height; y++)
+      for (y = MAX (1, ys); y < ye; y++)
         {
           guchar *row = tmp.col + (ty + y) * tmp.width * 3;
 
-          for (x = 1; x < brush->width; x++)
+          for (x = MAX (1, xs); x < xe; x++)
             {
               int k = (tx + x) * 3;
               h = brush->col[y * brush->width * 3 + x * 3 + 1] * relief;
@@ -346,55 +394,84 @@ apply_brush (ppm_t *brush,
     }
 }
 
-void
-repaint (ppm_t *p, ppm_t *a)
+static void
+brush_set_free (void)
 {
-  int         x, y;
-  int         tx = 0, ty = 0;
-  ppm_t       tmp = {0, 0, NULL};
-  ppm_t       atmp = {0, 0, NULL};
-  int         r, g, b, h, i, j, on, sn;
-  int         num_brushes, maxbrushwidth, maxbrushheight;
-  guchar      back[3] = {0, 0, 0};
-  ppm_t      *brushes, *shadows;
-  ppm_t      *brush, *shadow = NULL;
-  double     *brushes_sum;
-  int         cx, cy, maxdist;
-  double      scale, relief, startangle, anglespan, density, bgamma;
-  int         max_progress;
-  ppm_t       paper_ppm = {0, 0, NULL};
-  ppm_t       dirmap = {0, 0, NULL};
-  ppm_t       sizmap = {0, 0, NULL};
-  int        *xpos = NULL, *ypos = NULL;
-  int         progstep;
-  static int  running = 0;
+  int i;
 
-  int dropshadow = pcvals.general_drop_shadow;
-  int shadowblur = pcvals.general_shadow_blur;
+  for (i = 0; i < brush_set.num_brushes; i++)
+    {
+      ppm_kill (&brush_set.brushes[i]);
+      if (brush_set.shadows)
+        ppm_kill (&brush_set.shadows[i]);
+    }
+  g_free (brush_set.brushes);
+  g_free (brush_set.shadows);
+  g_free (brush_set.brushes_sum);
 
-  if (running)
-    return;
-  running++;
+  ppm_kill (&brush_set.source);
 
-  runningvals = pcvals;
+  brush_set.brushes     = NULL;
+  brush_set.shadows     = NULL;
+  brush_set.brushes_sum = NULL;
+  brush_set.num_brushes = 0;
+}
 
-  /* Shouldn't be necessary, but... */
-  if (img_has_alpha)
-    if ((p->width != a->width) || (p->height != a->height))
-      {
-        g_printerr ("Huh? Image size != alpha size?\n");
-        return;
-      }
+static gboolean
+brush_set_is_valid (ppm_t *source)
+{
+  const gimpressionist_vals_t *vals = &brush_set.vals;
+
+  return (PPM_IS_INITED (&brush_set.source)                               &&
+          brush_set.source.width  == source->width                        &&
+          brush_set.source.height == source->height                       &&
+          ! memcmp (brush_set.source.col, source->col,
+                    source->width * source->height * 3)                   &&
+          vals->brush_aspect        == runningvals.brush_aspect           &&
+          vals->brushgamma          == runningvals.brushgamma             &&
+          vals->size_first          == runningvals.size_first             &&
+          vals->size_last           == runningvals.size_last              &&
+          vals->size_num            == runningvals.size_num               &&
+          vals->orient_first        == runningvals.orient_first           &&
+          vals->orient_last         == runningvals.orient_last            &&
+          vals->orient_num          == runningvals.orient_num             &&
+          vals->color_brushes       == runningvals.color_brushes          &&
+          vals->general_drop_shadow == runningvals.general_drop_shadow    &&
+          vals->general_shadow_blur == runningvals.general_shadow_blur);
+}
+
+/* Makes brush_set hold the brushes for the selected brush and the
+ * current settings, only building them if they changed since the
+ * last repaint.
+ */
+static void
+brush_set_update (void)
+{
+  ppm_t   source = {0, 0, NULL};
+  ppm_t  *brushes, *shadows;
+  double *brushes_sum;
+  int     num_brushes, maxbrushwidth, maxbrushheight;
+  guchar  back[3] = {0, 0, 0};
+  double  scale, startangle, anglespan, bgamma;
+  int     h, i, j;
+
+  int dropshadow = runningvals.general_drop_shadow;
+  int shadowblur = runningvals.general_shadow_blur;
+
+  brush_get_selected (&source);
+
+  if (brush_set_is_valid (&source))
+    {
+      ppm_kill (&source);
+      return;
+    }
+
+  brush_set_free ();
 
   num_brushes = runningvals.orient_num * runningvals.size_num;
   startangle = runningvals.orient_first;
   anglespan = runningvals.orient_last;
 
-  density = runningvals.brush_density;
-
-  if (runningvals.place_type == PLACEMENT_TYPE_EVEN_DIST)
-    density /= 3.0;
-
   bgamma = runningvals.brushgamma;
 
   brushes = g_malloc (num_brushes * sizeof (ppm_t));
@@ -406,7 +483,7 @@ repaint (ppm_t *p, ppm_t *a)
     shadows = NULL;
 
   brushes[0].col = NULL;
-  brush_get_selected (&brushes[0]);
+  ppm_copy (&source, &brushes[0]);
 
   resize (&brushes[0],
           brushes[0].width,
@@ -428,8 +505,8 @@ repaint (ppm_t *p, ppm_t *a)
       ppm_copy (&brushes[0], &brushes[i]);
     }
 
-    for (i = 0; i < runningvals.size_num; i++)
-      {
+  for (i = 0; i < runningvals.size_num; i++)
+    {
       double sv;
       if (runningvals.size_num > 1)
         sv = i / (runningvals.size_num - 1.0);
@@ -463,8 +540,6 @@ repaint (ppm_t *p, ppm_t *a)
       brushes_sum[i] = sum_brush (&brushes[i]);
     }
 
-  brush = &brushes[0];
-
   maxbrushwidth = maxbrushheight = 0;
   for (i = 0; i < num_brushes; i++)
     {
@@ -513,6 +588,231 @@ repaint (ppm_t *p, ppm_t *a)
   system ("xv /tmp/__brush.ppm & xv /tmp/__shadow.ppm & ");
 #endif
 
+  brush_set.source         = source;
+  brush_set.vals           = runningvals;
+  brush_set.brushes        = brushes;
+  brush_set.shadows        = shadows;
+  brush_set.brushes_sum    = brushes_sum;
+  brush_set.num_brushes    = num_brushes;
+  brush_set.maxbrushwidth  = maxbrushwidth;
+  brush_set.maxbrushheight = maxbrushheight;
+}
+
+static void
+show_progress (double fraction)
+{
+  if (runningvals.run)
+    {
+      gimp_progress_update (0.8 * fraction);
+    }
+  else
+    {
+      char tmps[40];
+
+      g_snprintf (tmps, sizeof (tmps), "%.1f %%", 100 * fraction);
+      preview_set_button_label (tmps);
+
+      while (gtk_events_pending ())
+        gtk_main_iteration ();
+    }
+}
+
+static void
+add_stroke (GArray *strokes,
+            int n, int tx, int ty, int r, int g, int b)
+{
+  stroke_t stroke = { n, tx, ty, r, g, b };
+
+  g_array_append_val (strokes, stroke);
+}
+
+static void
+paint_tile (paint_job_t *job,
+            int          tile)
+{
+  GArray *list = job->tiles[tile];
+  int     x1, y1, x2, y2;
+  int     i;
+
+  if (! list)
+    return;
+
+  x1 = (tile % job->tiles_x) * TILE_SIZE;
+  y1 = (tile / job->tiles_x) * TILE_SIZE;
+  x2 = MIN (x1 + TILE_SIZE, job->tmp->width);
+  y2 = MIN (y1 + TILE_SIZE, job->tmp->height);
+
+  for (i = 0; i < list->len; i++)
+    {
+      stroke_t *s = &job->strokes[g_array_index (list, int, i)];
+
+      apply_brush (&brush_set.brushes[s->n],
+                   brush_set.shadows ? &brush_set.shadows[s->n] : NULL,
+                   job->tmp, job->atmp, s->tx, s->ty, s->r, s->g, s->b,
+                   x1, y1, x2, y2);
+    }
+}
+
+static gpointer
+paint_tiles (paint_job_t *job)
+{
+  int tile;
+
+  while ((tile = g_atomic_int_add (&job->next_tile, 1)) < job->n_tiles)
+    paint_tile (job, tile);
+
+  return NULL;
+}
+
+/* Rasterizes the planned strokes.  Strokes only change the pixels under
+ * their brush and shadow, so the image is split into tiles, which are
+ * painted in parallel, each applying the strokes that touch it in the
+ * order they were planned.
+ */
+static void
+paint_strokes (ppm_t  *tmp,
+               ppm_t  *atmp,
+               GArray *strokes)
+{
+  paint_job_t  job;
+  GThread     *threads[MAX_THREADS];
+  int          shadowoff;
+  int          n_threads;
+  int          progstep, last;
+  int          tile, i;
+
+  shadowoff = pcvals.general_shadow_depth - pcvals.general_shadow_blur * 2;
+
+  job.tmp       = tmp;
+  job.atmp      = atmp;
+  job.strokes   = (stroke_t *) strokes->data;
+  job.tiles_x   = (tmp->width + TILE_SIZE - 1) / TILE_SIZE;
+  job.n_tiles   = job.tiles_x * ((tmp->height + TILE_SIZE - 1) / TILE_SIZE);
+  job.next_tile = 0;
+  job.tiles     = g_new0 (GArray *, job.n_tiles);
+
+  for (i = 0; i < strokes->len; i++)
+    {
+      stroke_t *s     = &job.strokes[i];
+      ppm_t    *brush = &brush_set.brushes[s->n];
+      int       x1    = s->tx;
+      int       y1    = s->ty;
+      int       x2    = s->tx + brush->width;
+      int       y2    = s->ty + brush->height;
+      int       tx, ty;
+
+      if (brush_set.shadows)
+        {
+          ppm_t *shadow = &brush_set.shadows[s->n];
+
+          x1 = MIN (x1, s->tx + shadowoff);
+          y1 = MIN (y1, s->ty + shadowoff);
+          x2 = MAX (x2, s->tx + shadowoff + shadow->width);
+          y2 = MAX (y2, s->ty + shadowoff + shadow->height);
+        }
+
+      x1 = CLAMP (x1, 0, tmp->width);
+      y1 = CLAMP (y1, 0, tmp->height);
+      x2 = CLAMP (x2, 0, tmp->width);
+      y2 = CLAMP (y2, 0, tmp->height);
+
+      if (x1 >= x2 || y1 >= y2)
+        continue;
+
+      for (ty = y1 / TILE_SIZE; ty <= (y2 - 1) / TILE_SIZE; ty++)
+        for (tx = x1 / TILE_SIZE; tx <= (x2 - 1) / TILE_SIZE; tx++)
+          {
+            GArray **list = &job.tiles[ty * job.tiles_x + tx];
+
+            if (! *list)
+              *list = g_array_new (FALSE, FALSE, sizeof (int));
+
+            g_array_append_val (*list, i);
+          }
+    }
+
+  n_threads = CLAMP (g_get_num_processors (), 1, MAX_THREADS);
+
+  for (i = 1; i < n_threads; i++)
+    threads[i] = g_thread_new ("gimpressionist",
+                               (GThreadFunc) paint_tiles, &job);
+
+  /* the main thread paints tiles too, and reports the progress */
+  progstep = MAX (job.n_tiles / 30, 1);
+  last     = 0;
+
+  while ((tile = g_atomic_int_add (&job.next_tile, 1)) < job.n_tiles)
+    {
+      paint_tile (&job, tile);
+
+      if (tile - last >= progstep)
+        {
+          show_progress (0.5 + 0.5 * tile / job.n_tiles);
+          last = tile;
+        }
+    }
+
+  for (i = 1; i < n_threads; i++)
+    g_thread_join (threads[i]);
+
+  for (i = 0; i < job.n_tiles; i++)
+    {
+      if (job.tiles[i])
+        g_array_free (job.tiles[i], TRUE);
+    }
+  g_free (job.tiles);
+}
+
+void
+repaint (ppm_t *p, ppm_t *a)
+{
+  int         x, y;
+  int         tx = 0, ty = 0;
+  ppm_t       tmp = {0, 0, NULL};
+  ppm_t       atmp = {0, 0, NULL};
+  int         r, g, b, h, i, on, sn;
+  int         num_brushes, maxbrushwidth, maxbrushheight;
+  ppm_t      *brushes;
+  ppm_t      *brush;
+  double     *brushes_sum;
+  GArray     *strokes;
+  int         cx, cy, maxdist;
+  double      scale, relief, density;
+  int         max_progress;
+  ppm_t       paper_ppm = {0, 0, NULL};
+  ppm_t       dirmap = {0, 0, NULL};
+  ppm_t       sizmap = {0, 0, NULL};
+  int        *xpos = NULL, *ypos = NULL;
+  int         progstep;
+  static int  running = 0;
+
+  if (running)
+    return;
+  running++;
+
+  runningvals = pcvals;
+
+  /* Shouldn't be necessary, but... */
+  if (img_has_alpha)
+    if ((p->width != a->width) || (p->height != a->height))
+      {
+        g_printerr ("Huh? Image size != alpha size?\n");
+        return;
+      }
+
+  density = runningvals.brush_density;
+
+  if (runningvals.place_type == PLACEMENT_TYPE_EVEN_DIST)
+    density /= 3.0;
+
+  brush_set_update ();
+
+  brushes        = brush_set.brushes;
+  brushes_sum    = brush_set.brushes_sum;
+  num_brushes    = brush_set.num_brushes;
+  maxbrushwidth  = brush_set.maxbrushwidth;
+  maxbrushheight = brush_set.maxbrushheight;
+
   if (runningvals.general_paint_edges)
     {
       edgepad (p, maxbrushwidth, maxbrushwidth,
@@ -839,29 +1139,19 @@ repaint (ppm_t *p, ppm_t *a)
         }
     }
 
+  /* Plan all strokes first.  This consumes the random numbers in the
+   * same order as painting them one by one did, and only reads the
+   * source image, so the strokes can be painted in parallel afterwards.
+   */
+  strokes = g_array_new (FALSE, FALSE, sizeof (stroke_t));
+
   for (; i; i--)
     {
       int n;
       double thissum;
 
       if (i % progstep == 0)
-        {
-          if(runningvals.run)
-            {
-              gimp_progress_update (0.8 - 0.8 * ((double)i / max_progress));
-            }
-          else
-            {
-              char tmps[40];
-
-              g_snprintf (tmps, sizeof (tmps),
-                          "%.1f %%", 100 * (1.0 - ((double)i / max_progress)));
-              preview_set_button_label (tmps);
-
-              while(gtk_events_pending())
-                gtk_main_iteration();
-            }
-        }
+        show_progress (0.5 - 0.5 * ((double)i / max_progress));
 
       if (runningvals.place_type == PLACEMENT_TYPE_RANDOM)
         {
@@ -986,8 +1276,6 @@ repaint (ppm_t *p, ppm_t *a)
       ty -= maxbrushheight/2;
 
       brush = &brushes[n];
-      if (dropshadow)
-        shadow = &shadows[n];
       thissum = brushes_sum[n];
 
       /* Calculate color - avg. of in-brush pixels */
@@ -1048,7 +1336,7 @@ repaint (ppm_t *p, ppm_t *a)
 #undef MYASSIGN
         }
 
-      apply_brush (brush, shadow, &tmp, &atmp, tx,ty, r,g,b);
+      add_stroke (strokes, n, tx, ty, r, g, b);
 
       if (runningvals.general_tileable && runningvals.general_paint_edges)
         {
@@ -1058,42 +1346,39 @@ repaint (ppm_t *p, ppm_t *a)
 
           if (tx < maxbrushwidth)
             {
-              apply_brush (brush, shadow, &tmp, &atmp, tx+orig_width,ty, r,g,b);
+              add_stroke (strokes, n, tx + orig_width, ty, r, g, b);
               dox = -1;
             }
           else if (tx > orig_width)
             {
-              apply_brush (brush, shadow, &tmp, &atmp, tx-orig_width,ty, r,g,b);
+              add_stroke (strokes, n, tx - orig_width, ty, r, g, b);
               dox = 1;
             }
           if (ty < maxbrushheight)
             {
-              apply_brush (brush, shadow, &tmp, &atmp, tx,ty+orig_height, r,g,b);
+              add_stroke (strokes, n, tx, ty + orig_height, r, g, b);
               doy = 1;
             }
           else if (ty > orig_height)
             {
-              apply_brush (brush, shadow, &tmp, &atmp, tx,ty-orig_height, r,g,b);
+              add_stroke (strokes, n, tx, ty - orig_height, r, g, b);
               doy = -1;
             }
           if (doy)
             {
               if (dox < 0)
-                apply_brush (brush, shadow, &tmp, &atmp,
-                             tx+orig_width, ty + doy * orig_height, r, g, b);
+                add_stroke (strokes, n,
+                            tx + orig_width, ty + doy * orig_height, r, g, b);
               if (dox > 0)
-                apply_brush (brush, shadow, &tmp, &atmp,
-                             tx-orig_width, ty + doy * orig_height, r, g, b);
+                add_stroke (strokes, n,
+                            tx - orig_width, ty + doy * orig_height, r, g, b);
             }
         }
     }
-  for (i = 0; i < num_brushes; i++)
-    {
-      ppm_kill (&brushes[i]);
-    }
-  g_free (brushes);
-  g_free (shadows);
-  g_free (brushes_sum);
+
+  paint_strokes (&tmp, &atmp, strokes);
+
+  g_array_free (strokes, TRUE);
 
   g_free (xpos);
   g_free (ypos);
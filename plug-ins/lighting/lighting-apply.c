@@ -16,6 +16,76 @@
 #include "libgimp/stdplugins-intl.h"
 
 
+#define MAX_THREADS 16
+#define CHUNK_ROWS  32
+
+
+typedef struct
+{
+  get_ray_func  ray_func;
+  guchar       *pixels;
+  gint          bpp;
+  gboolean      has_alpha;
+  gboolean      bump_mapped;
+  gint          next_row;
+} ComputeParam;
+
+
+/********************************************/
+/* Shade the rows y1 to y2 into the buffer, */
+/* starting the bump normals afresh         */
+/********************************************/
+
+static void
+compute_rows (ComputeParam *param,
+              ShadeRows    *rows,
+              gint          y1,
+              gint          y2)
+{
+  gint         xcount, ycount;
+  GimpRGB      color;
+  GimpVector3  p;
+  guchar      *row;
+
+  if (param->bump_mapped)
+    precompute_start (rows, 0, width, y1);
+
+  for (ycount = y1; ycount < y2; ycount++)
+    {
+      if (param->bump_mapped)
+	precompute_normals (rows, 0, width, ycount);
+
+      row = param->pixels + (gsize) ycount * width * param->bpp;
+
+      for (xcount = 0; xcount < width; xcount++)
+	{
+	  p = int_to_pos (xcount, ycount);
+	  color = (* param->ray_func) (rows, &p);
+
+	  *row++ = (guchar) (color.r * 255.0);
+	  *row++ = (guchar) (color.g * 255.0);
+	  *row++ = (guchar) (color.b * 255.0);
+
+	  if (param->has_alpha)
+	    *row++ = (guchar) (color.a * 255.0);
+	}
+    }
+}
+
+static gpointer
+compute_thread (ComputeParam *param)
+{
+  ShadeRows *rows = shade_rows_new ();
+  gint       ycount;
+
+  while ((ycount = g_atomic_int_add (&param->next_row, CHUNK_ROWS)) < height)
+    compute_rows (param, rows, ycount, MIN (ycount + CHUNK_ROWS, height));
+
+  shade_rows_free (rows);
+
+  return NULL;
+}
+
 /*************/
 /* Main loop */
 /*************/
@@ -23,19 +93,14 @@
 void
 compute_image (void)
 {
-  gint         xcount, ycount;
-  GimpRGB       color;
-  glong        progress_counter = 0;
-  GimpVector3  p;
+  ComputeParam param;
+  GThread     *threads[MAX_THREADS];
+  ShadeRows   *rows;
+  gint         n_threads;
+  gint         ycount;
+  gint         i;
   gint32       new_image_id = -1;
   gint32       new_layer_id = -1;
-  gint32       index;
-  guchar      *row = NULL;
-  guchar       obpp;
-  gboolean     has_alpha;
-  get_ray_func ray_func;
-
-
 
   if (mapvals.create_new_image == TRUE ||
       (mapvals.transparent_background == TRUE &&
@@ -73,71 +138,56 @@ compute_image (void)
       output_drawable = gimp_drawable_get (new_layer_id);
     }
 
-  if (mapvals.bump_mapped == TRUE && mapvals.bumpmap_id != -1)
-    {
-      gimp_pixel_rgn_init (&bump_region, gimp_drawable_get (mapvals.bumpmap_id),
-			   0, 0, width, height, FALSE, FALSE);
-    }
+  image_load_maps ();
 
   precompute_init (width, height);
 
   if (!mapvals.env_mapped || mapvals.envmap_id == -1)
-    {
-      ray_func = get_ray_color;
-    }
+    param.ray_func = get_ray_color;
   else
-    {
-      env_width = gimp_drawable_width (mapvals.envmap_id);
-      env_height = gimp_drawable_height (mapvals.envmap_id);
-      gimp_pixel_rgn_init (&env_region, gimp_drawable_get (mapvals.envmap_id),
-			   0, 0, env_width, env_height, FALSE, FALSE);
-      ray_func = get_ray_color_ref;
-    }
+    param.ray_func = get_ray_color_ref;
 
   gimp_pixel_rgn_init (&dest_region, output_drawable,
 		       0, 0, width, height, TRUE, TRUE);
 
-  obpp = gimp_drawable_bpp (output_drawable->drawable_id);
-  has_alpha = gimp_drawable_has_alpha (output_drawable->drawable_id);
-
-  row = g_new (guchar, obpp * width);
+  param.bpp         = gimp_drawable_bpp (output_drawable->drawable_id);
+  param.has_alpha   = gimp_drawable_has_alpha (output_drawable->drawable_id);
+  param.bump_mapped = (mapvals.bump_mapped == TRUE &&
+                       mapvals.bumpmap_id != -1);
+  param.pixels      = g_new (guchar, (gsize) width * height * param.bpp);
+  param.next_row    = 0;
 
   gimp_progress_init (_("Lighting Effects"));
 
-  /* Init the first row */
-  if (mapvals.bump_mapped == TRUE && mapvals.bumpmap_id != -1 && height >= 2)
-    interpol_row (0, width, 0);
+  /* All the images are in memory, so chunks of rows can be   */
+  /* shaded in parallel, each thread keeping its own normals  */
+  /* ======================================================== */
 
-  for (ycount = 0; ycount < height; ycount++)
-    {
-      if (mapvals.bump_mapped == TRUE && mapvals.bumpmap_id != -1)
-	precompute_normals (0, width, ycount);
+  n_threads = CLAMP (g_get_num_processors (), 1, MAX_THREADS);
 
-      index = 0;
+  for (i = 1; i < n_threads; i++)
+    threads[i] = g_thread_new ("lighting",
+                               (GThreadFunc) compute_thread, &param);
 
-      for (xcount = 0; xcount < width; xcount++)
-	{
-	  p = int_to_pos (xcount, ycount);
-	  color = (* ray_func) (&p);
+  rows = shade_rows_new ();
 
-	  row[index++] = (guchar) (color.r * 255.0);
-	  row[index++] = (guchar) (color.g * 255.0);
-	  row[index++] = (guchar) (color.b * 255.0);
+  while ((ycount = g_atomic_int_add (&param.next_row, CHUNK_ROWS)) < height)
+    {
+      gimp_progress_update ((gdouble) ycount / (gdouble) height);
 
-	  if (has_alpha)
-	    row[index++] = (guchar) (color.a * 255.0);
+      compute_rows (&param, rows, ycount, MIN (ycount + CHUNK_ROWS, height));
+    }
 
-	  if ((progress_counter++ % width) == 0)
-	    gimp_progress_update ((gdouble) progress_counter /
-				  (gdouble) maxcounter);
-	}
+  shade_rows_free (rows);
 
-      gimp_pixel_rgn_set_row (&dest_region, row, 0, ycount, width);
-    }
+  for (i = 1; i < n_threads; i++)
+    g_thread_join (threads[i]);
+
+  gimp_pixel_rgn_set_rect (&dest_region, param.pixels, 0, 0, width, height);
 
   gimp_progress_update (1.0);
 
-  g_free (row);
+  g_free (param.pixels);
 
   /* Update image */
   /* ============ */
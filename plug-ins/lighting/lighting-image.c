@@ -15,13 +15,21 @@
 
 
 GimpDrawable *input_drawable,*output_drawable;
-GimpPixelRgn  source_region, dest_region;
+GimpPixelRgn  dest_region;
 
-GimpDrawable *bump_drawable = NULL;
-GimpPixelRgn  bump_region;
+/* The source, bump and environment images are read into memory once,
+ * so they can be sampled without going through the tile cache, and
+ * from several threads at a time
+ */
+guchar *source_pixels = NULL;
 
-GimpDrawable *env_drawable = NULL;
-GimpPixelRgn  env_region;
+guchar *bump_pixels = NULL;
+gint    bump_bpp;
+static gint32 bump_pixels_id = -1;
+
+guchar *env_pixels = NULL;
+gint    env_bpp;
+static gint32 env_pixels_id = -1;
 
 guchar          *preview_rgb_data = NULL;
 gint             preview_rgb_stride;
@@ -39,18 +47,38 @@ guchar sinemap[256], spheremap[256], logmap[256];
 /* Implementation */
 /******************/
 
-guchar
-peek_map (GimpPixelRgn *region,
-	  gint       x,
-	  gint       y)
+static guchar *
+get_pixels (gint32  drawable_id,
+            gint   *bpp)
 {
-  guchar data[4];
-  guchar ret_val;
+  GimpDrawable *drawable = gimp_drawable_get (drawable_id);
+  GimpPixelRgn  region;
+  guchar       *pixels;
+
+  gimp_pixel_rgn_init (&region, drawable,
+                       0, 0, drawable->width, drawable->height, FALSE, FALSE);
+
+  pixels = g_new (guchar,
+                  (gsize) drawable->width * drawable->height * drawable->bpp);
+
+  gimp_pixel_rgn_get_rect (&region, pixels,
+                           0, 0, drawable->width, drawable->height);
 
+  *bpp = drawable->bpp;
 
-  gimp_pixel_rgn_get_pixel (region, data, x, y);
+  gimp_drawable_detach (drawable);
 
-  if (region->bpp == 1)
+  return pixels;
+}
+
+guchar
+peek_map (gint x,
+	  gint y)
+{
+  const guchar *data = bump_pixels + ((gsize) y * width + x) * bump_bpp;
+  guchar        ret_val;
+
+  if (bump_bpp == 1)
   {
     ret_val = data[0];
   } else
@@ -65,10 +93,10 @@ GimpRGB
 peek (gint x,
       gint y)
 {
-  guchar data[4];
-  GimpRGB color;
+  const guchar *data;
+  GimpRGB       color;
 
-  gimp_pixel_rgn_get_pixel (&source_region,data, x, y);
+  data = source_pixels + ((gsize) y * width + x) * input_drawable->bpp;
 
   color.r = (gdouble) (data[0]) / 255.0;
   color.g = (gdouble) (data[1]) / 255.0;
@@ -93,8 +121,8 @@ GimpRGB
 peek_env_map (gint x,
 	      gint y)
 {
-  guchar data[4];
-  GimpRGB color;
+  const guchar *data;
+  GimpRGB       color;
 
   if (x < 0)
     x = 0;
@@ -105,7 +133,7 @@ peek_env_map (gint x,
   else if (y >= env_height)
     y = env_height - 1;
 
-  gimp_pixel_rgn_get_pixel (&env_region, data, x, y);
+  data = env_pixels + ((gsize) y * env_width + x) * env_bpp;
 
   color.r = (gdouble) (data[0]) / 255.0;
   color.g = (gdouble) (data[1]) / 255.0;
@@ -149,6 +177,34 @@ check_bounds (gint x,
     return TRUE;
 }
 
+/**************************************************/
+/* Read the bump and environment maps into memory */
+/* unless they are already there                  */
+/**************************************************/
+
+void
+image_load_maps (void)
+{
+  if (mapvals.bump_mapped == TRUE && mapvals.bumpmap_id != -1 &&
+      mapvals.bumpmap_id != bump_pixels_id)
+    {
+      g_free (bump_pixels);
+      bump_pixels    = get_pixels (mapvals.bumpmap_id, &bump_bpp);
+      bump_pixels_id = mapvals.bumpmap_id;
+    }
+
+  if (mapvals.env_mapped == TRUE && mapvals.envmap_id != -1 &&
+      mapvals.envmap_id != env_pixels_id)
+    {
+      g_free (env_pixels);
+      env_pixels    = get_pixels (mapvals.envmap_id, &env_bpp);
+      env_pixels_id = mapvals.envmap_id;
+
+      env_width  = gimp_drawable_width (mapvals.envmap_id);
+      env_height = gimp_drawable_height (mapvals.envmap_id);
+    }
+}
+
 GimpVector3
 int_to_pos (gint x,
 	    gint y)
@@ -283,8 +339,7 @@ get_image_color (gdouble  u,
 }
 
 gdouble
-get_map_value (GimpPixelRgn *region,
-	       gdouble    u,
+get_map_value (gdouble    u,
 	       gdouble    v,
 	       gint      *inside)
 {
@@ -300,14 +355,14 @@ get_map_value (GimpPixelRgn *region,
   if (check_bounds (x2, y2) == FALSE)
     {
       *inside = TRUE;
-      return (gdouble) peek_map (region, x1, y1);
+      return (gdouble) peek_map (x1, y1);
     }
 
   *inside = TRUE;
-  p[0] = (gdouble) peek_map (region, x1, y1);
-  p[1] = (gdouble) peek_map (region, x2, y1);
-  p[2] = (gdouble) peek_map (region, x1, y2);
-  p[3] = (gdouble) peek_map (region, x2, y2);
+  p[0] = (gdouble) peek_map (x1, y1);
+  p[1] = (gdouble) peek_map (x2, y1);
+  p[2] = (gdouble) peek_map (x1, y2);
+  p[3] = (gdouble) peek_map (x2, y2);
 
   return gimp_bilinear (u, v, p);
 }
@@ -347,6 +402,8 @@ gint
 image_setup (GimpDrawable *drawable,
 	     gint          interactive)
 {
+  gint bpp;
+
   compute_maps ();
 
   /* Get some useful info on the input drawable */
@@ -361,8 +418,8 @@ image_setup (GimpDrawable *drawable,
   width  = input_drawable->width;
   height = input_drawable->height;
 
-  gimp_pixel_rgn_init (&source_region, input_drawable,
-		       0, 0, width, height, FALSE, FALSE);
+  g_free (source_pixels);
+  source_pixels = get_pixels (input_drawable->drawable_id, &bpp);
 
   maxcounter = (glong) width * (glong) height;
 
@@ -387,3 +444,31 @@ image_setup (GimpDrawable *drawable,
 
   return TRUE;
 }
+
+/**************************************************/
+/* Read the bump and environment maps into memory */
+/* unless they are already there                  */
+/**************************************************/
+
+void
+image_load_maps (void)
+{
+  if (mapvals.bump_mapped == TRUE && mapvals.bumpmap_id != -1 &&
+      mapvals.bumpmap_id != bump_pixels_id)
+    {
+      g_free (bump_pixels);
+      bump_pixels    = get_pixels (mapvals.bumpmap_id, &bump_bpp);
+      bump_pixels_id = mapvals.bumpmap_id;
+    }
+
+  if (mapvals.env_mapped == TRUE && mapvals.envmap_id != -1 &&
+      mapvals.envmap_id != env_pixels_id)
+    {
+      g_free (env_pixels);
+      env_pixels    = get_pixels (mapvals.envmap_id, &env_bpp);
+      env_pixels_id = mapvals.envmap_id;
+
+      env_width  = gimp_drawable_width (mapvals.envmap_id);
+      env_height = gimp_drawable_height (mapvals.envmap_id);
+    }
+}
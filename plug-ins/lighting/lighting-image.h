@@ -5,13 +5,15 @@
 #include <libgimp/gimpui.h>
 
 extern GimpDrawable *input_drawable,*output_drawable;
-extern GimpPixelRgn  source_region, dest_region;
+extern GimpPixelRgn  dest_region;
 
-extern GimpDrawable *bump_drawable;
-extern GimpPixelRgn  bump_region;
+extern guchar       *source_pixels;
 
-extern GimpDrawable *env_drawable;
-extern GimpPixelRgn  env_region;
+extern guchar       *bump_pixels;
+extern gint          bump_bpp;
+
+extern guchar       *env_pixels;
+extern gint          env_bpp;
 
 extern guchar          *preview_rgb_data;
 extern gint             preview_rgb_stride;
@@ -25,8 +27,7 @@ extern gint   border_x1,border_y1,border_x2,border_y2;
 
 extern guchar sinemap[256], spheremap[256], logmap[256];
 
-guchar         peek_map        (GimpPixelRgn *region,
-				gint          x,
+guchar         peek_map        (gint          x,
 				gint          y);
 GimpRGB         peek            (gint          x,
 				gint          y);
@@ -52,11 +53,11 @@ void           pos_to_float    (gdouble       x,
 GimpRGB         get_image_color (gdouble       u,
 				gdouble       v,
 				gint         *inside);
-gdouble        get_map_value   (GimpPixelRgn *region,
-				gdouble       u,
+gdouble        get_map_value   (gdouble       u,
 				gdouble       v,
 				gint         *inside);
 gint           image_setup     (GimpDrawable *drawable,
 				gint          interactive);
+void           image_load_maps (void);
 
 #endif  /* __LIGHTING_IMAGE_H__ */
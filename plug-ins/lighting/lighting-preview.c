@@ -4,6 +4,8 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include <gtk/gtk.h>
 
 #include <libgimp/gimp.h>
@@ -20,6 +22,20 @@
 
 #define LIGHT_SYMBOL_SIZE 8
 
+#define MAX_THREADS 16
+#define COARSE_STEP 4   /* pixel size of the first preview pass */
+
+
+typedef struct
+{
+  gint         startx, starty, w, h;
+  gint         step;
+  get_ray_func ray_func;
+  gboolean     bump_mapped;
+  GimpRGB      lightcheck, darkcheck;
+  gint         next_row;
+} PreviewParam;
+
 static gint handle_xpos = 0, handle_ypos = 0;
 
 /* g_free()'ed on exit */
@@ -39,17 +55,124 @@ static guint preview_update_timer = 0;
 static gboolean
 interactive_preview_timer_callback ( gpointer data );
 
+/* Render one preview row, or with step > 1 every step-th pixel of */
+/* it, filling a step x step block with each                       */
+
 static void
-compute_preview (gint startx, gint starty, gint w, gint h)
+compute_preview_row (PreviewParam *param,
+                     ShadeRows    *rows,
+                     gint          ycnt)
 {
-  gint xcnt, ycnt, f1, f2;
-  guchar r, g, b;
-  gdouble imagex, imagey;
-  gint32 index = 0;
-  GimpRGB color;
-  GimpRGB lightcheck, darkcheck;
+  gint        xcnt, x, y, x2, y2, f1, f2;
+  guchar      r, g, b;
+  gdouble     imagex, imagey;
+  GimpRGB     color;
   GimpVector3 pos;
-  get_ray_func ray_func;
+
+  imagey = ypostab[ycnt - param->starty];
+
+  if (param->bump_mapped)
+    {
+      gdouble xf, yf;
+
+      pos = int_to_posf (xpostab[0], imagey);
+      pos_to_float (pos.x, pos.y, &xf, &yf);
+
+      precompute_start (rows, 0, width, RINT (yf));
+      precompute_normals (rows, 0, width, RINT (yf));
+    }
+
+  y2 = MIN (ycnt + param->step, param->starty + param->h);
+
+  for (xcnt = param->startx;
+       xcnt < param->startx + param->w;
+       xcnt += param->step)
+    {
+      imagex = xpostab[xcnt - param->startx];
+      pos = int_to_posf (imagex, imagey);
+
+      color = (* param->ray_func) (rows, &pos);
+
+      if (color.a < 1.0)
+        {
+          f1 = ((xcnt % 32) < 16);
+          f2 = ((ycnt % 32) < 16);
+          f1 = f1 ^ f2;
+
+          if (f1)
+            {
+              if (color.a == 0.0)
+                color = param->lightcheck;
+              else
+                gimp_rgb_composite (&color,
+                                    &param->lightcheck,
+                                    GIMP_RGB_COMPOSITE_BEHIND);
+            }
+          else
+            {
+              if (color.a == 0.0)
+                color = param->darkcheck;
+              else
+                gimp_rgb_composite (&color,
+                                    &param->darkcheck,
+                                    GIMP_RGB_COMPOSITE_BEHIND);
+            }
+        }
+
+      gimp_rgb_get_uchar (&color, &r, &g, &b);
+
+      x2 = MIN (xcnt + param->step, param->startx + param->w);
+
+      for (y = ycnt; y < y2; y++)
+        for (x = xcnt; x < x2; x++)
+          GIMP_CAIRO_RGB24_SET_PIXEL ((preview_rgb_data +
+                                       y * preview_rgb_stride + x * 4),
+                                      r, g, b);
+    }
+}
+
+static gpointer
+compute_preview_thread (PreviewParam *param)
+{
+  ShadeRows *rows = shade_rows_new ();
+  gint       ycnt;
+
+  while ((ycnt = g_atomic_int_add (&param->next_row, param->step)) < param->h)
+    compute_preview_row (param, rows, param->starty + ycnt);
+
+  shade_rows_free (rows);
+
+  return NULL;
+}
+
+static void
+compute_preview_pass (PreviewParam *param,
+                      gint          step)
+{
+  GThread *threads[MAX_THREADS];
+  gint     n_threads;
+  gint     i;
+
+  param->step     = step;
+  param->next_row = 0;
+
+  n_threads = CLAMP (g_get_num_processors (), 1, MAX_THREADS);
+
+  for (i = 1; i < n_threads; i++)
+    threads[i] = g_thread_new ("lighting-preview",
+                               (GThreadFunc) compute_preview_thread, param);
+
+  compute_preview_thread (param);
+
+  for (i = 1; i < n_threads; i++)
+    g_thread_join (threads[i]);
+}
+
+static void
+compute_preview (gint startx, gint starty, gint w, gint h)
+{
+  gint         xcnt, ycnt;
+  PreviewParam param;
 
   if (xpostab_size != w)
     {
@@ -88,105 +211,51 @@ compute_preview (gint startx, gint starty, gint w, gint h)
 
   precompute_init (width, height);
 
-  gimp_rgba_set (&lightcheck,
+  gimp_rgba_set (&param.lightcheck,
                  GIMP_CHECK_LIGHT, GIMP_CHECK_LIGHT, GIMP_CHECK_LIGHT,
                  1.0);
-  gimp_rgba_set (&darkcheck, GIMP_CHECK_DARK, GIMP_CHECK_DARK,
+  gimp_rgba_set (&param.darkcheck, GIMP_CHECK_DARK, GIMP_CHECK_DARK,
                  GIMP_CHECK_DARK, 1.0);
 
-  if (mapvals.bump_mapped == TRUE && mapvals.bumpmap_id != -1)
-    {
-      gimp_pixel_rgn_init (&bump_region,
-                           gimp_drawable_get (mapvals.bumpmap_id),
-                           0, 0, width, height, FALSE, FALSE);
-    }
+  image_load_maps ();
 
-  imagey = 0;
+  param.startx      = startx;
+  param.starty      = starty;
+  param.w           = w;
+  param.h           = h;
+  param.bump_mapped = (mapvals.bump_mapped == TRUE &&
+                       mapvals.bumpmap_id != -1);
 
   if (mapvals.previewquality)
-    ray_func = get_ray_color;
+    param.ray_func = get_ray_color;
   else
-    ray_func = get_ray_color_no_bilinear;
+    param.ray_func = get_ray_color_no_bilinear;
 
   if (mapvals.env_mapped == TRUE && mapvals.envmap_id != -1)
     {
-      env_width = gimp_drawable_width (mapvals.envmap_id);
-      env_height = gimp_drawable_height (mapvals.envmap_id);
-
-      gimp_pixel_rgn_init (&env_region,
-                           gimp_drawable_get (mapvals.envmap_id), 0,
-                           0, env_width, env_height, FALSE, FALSE);
-
       if (mapvals.previewquality)
-        ray_func = get_ray_color_ref;
+        param.ray_func = get_ray_color_ref;
       else
-        ray_func = get_ray_color_no_bilinear_ref;
+        param.ray_func = get_ray_color_no_bilinear_ref;
     }
 
   cairo_surface_flush (preview_surface);
 
-  for (ycnt = 0; ycnt < PREVIEW_HEIGHT; ycnt++)
-    {
-      index = ycnt * preview_rgb_stride;
-      for (xcnt = 0; xcnt < PREVIEW_WIDTH; xcnt++)
-        {
-          if ((ycnt >= starty && ycnt < (starty + h)) &&
-              (xcnt >= startx && xcnt < (startx + w)))
-            {
-              imagex = xpostab[xcnt - startx];
-              imagey = ypostab[ycnt - starty];
-              pos = int_to_posf (imagex, imagey);
-
-              if (mapvals.bump_mapped == TRUE &&
-                  mapvals.bumpmap_id != -1 &&
-                  xcnt == startx)
-                {
-                  pos_to_float (pos.x, pos.y, &imagex, &imagey);
-                  precompute_normals (0, width, RINT (imagey));
-                }
-
-              color = (*ray_func) (&pos);
-
-              if (color.a < 1.0)
-                {
-                  f1 = ((xcnt % 32) < 16);
-                  f2 = ((ycnt % 32) < 16);
-                  f1 = f1 ^ f2;
-
-                  if (f1)
-                    {
-                      if (color.a == 0.0)
-                        color = lightcheck;
-                      else
-                        gimp_rgb_composite (&color,
-                                            &lightcheck,
-                                            GIMP_RGB_COMPOSITE_BEHIND);
-                    }
-                  else
-                    {
-                      if (color.a == 0.0)
-                        color = darkcheck;
-                      else
-                        gimp_rgb_composite (&color,
-                                            &darkcheck,
-                                            GIMP_RGB_COMPOSITE_BEHIND);
-                    }
-                }
-
-              gimp_rgb_get_uchar (&color, &r, &g, &b);
-              GIMP_CAIRO_RGB24_SET_PIXEL((preview_rgb_data + index), r, g, b);
-              index += 4;
-              imagex++;
-            }
-          else
-            {
-              preview_rgb_data[index++] = 200;
-              preview_rgb_data[index++] = 200;
-              preview_rgb_data[index++] = 200;
-              index++;
-            }
-        }
-    }
+  memset (preview_rgb_data, 200, preview_rgb_stride * PREVIEW_HEIGHT);
+
+  /* Show a coarse preview first, then refine it */
+  /* =========================================== */
+
+  compute_preview_pass (&param, COARSE_STEP);
+
+  cairo_surface_mark_dirty (preview_surface);
+  gtk_widget_queue_draw (previewarea);
+  gdk_window_process_updates (gtk_widget_get_window (previewarea), FALSE);
+
+  cairo_surface_flush (preview_surface);
+
+  compute_preview_pass (&param, 1);
+
   cairo_surface_mark_dirty (preview_surface);
 }
 
@@ -11,11 +11,7 @@
 #include "lighting-shade.h"
 
 
-static GimpVector3 *triangle_normals[2] = { NULL, NULL };
-static GimpVector3 *vertex_normals[3]   = { NULL, NULL, NULL };
-static gdouble     *heights[3] = { NULL, NULL, NULL };
 static gdouble      xstep, ystep;
-static guchar      *bumprow = NULL;
 
 static gint pre_w = -1;
 static gint pre_h = -1;
@@ -31,7 +27,8 @@ phong_shade (GimpVector3 *position,
              GimpVector3 *lightposition,
              GimpRGB      *diff_col,
              GimpRGB      *light_col,
-             LightType    light_type)
+             LightType    light_type,
+             gdouble      diffuse_int)
 {
   GimpRGB       diffuse_color, specular_color;
   gdouble      nl, rv, dist;
@@ -82,7 +79,7 @@ phong_shade (GimpVector3 *position,
       /* =================================================== */
 
       diffuse_color = *light_col;
-      gimp_rgb_multiply (&diffuse_color, mapvals.material.diffuse_int);
+      gimp_rgb_multiply (&diffuse_color, diffuse_int);
       diffuse_color.r *= diff_col->r;
       diffuse_color.g *= diff_col->g;
       diffuse_color.b *= diff_col->b;
@@ -111,60 +108,92 @@ void
 precompute_init (gint w,
                  gint h)
 {
-  gint n;
-  gint bpp=1;
-
   xstep = 1.0 / (gdouble) width;
   ystep = 1.0 / (gdouble) height;
 
   pre_w = w;
   pre_h = h;
+}
+
+/* Allocate the rows of heights and normals one renderer works on,
+ * must be called after precompute_init()
+ */
+ShadeRows *
+shade_rows_new (void)
+{
+  ShadeRows *rows = g_slice_new (ShadeRows);
+  gint       n;
 
   for (n = 0; n < 3; n++)
     {
-      if (vertex_normals[n] != NULL)
-        g_free (vertex_normals[n]);
-      if (heights[n] != NULL)
-        g_free (heights[n]);
-
-      heights[n] = g_new (gdouble, w);
-      vertex_normals[n] = g_new (GimpVector3, w);
+      rows->heights[n] = g_new (gdouble, pre_w);
+      rows->vertex_normals[n] = g_new (GimpVector3, pre_w);
     }
 
-  for (n = 0; n < 2; n++)
-    if (triangle_normals[n] != NULL)
-      g_free (triangle_normals[n]);
+  rows->triangle_normals[0] = g_new (GimpVector3, (pre_w << 1) + 2);
+  rows->triangle_normals[1] = g_new (GimpVector3, (pre_w << 1) + 2);
 
-  if (bumprow != NULL)
+  for (n = 0; n < (pre_w << 1) + 1; n++)
     {
-      g_free (bumprow);
-      bumprow = NULL;
+      gimp_vector3_set (&rows->triangle_normals[0][n], 0.0, 0.0, 1.0);
+      gimp_vector3_set (&rows->triangle_normals[1][n], 0.0, 0.0, 1.0);
     }
-  if (mapvals.bumpmap_id != -1)
+
+  for (n = 0; n < pre_w; n++)
     {
-      bpp = gimp_drawable_bpp(mapvals.bumpmap_id);
+      gimp_vector3_set (&rows->vertex_normals[0][n], 0.0, 0.0, 1.0);
+      gimp_vector3_set (&rows->vertex_normals[1][n], 0.0, 0.0, 1.0);
+      gimp_vector3_set (&rows->vertex_normals[2][n], 0.0, 0.0, 1.0);
+      rows->heights[0][n] = 0.0;
+      rows->heights[1][n] = 0.0;
+      rows->heights[2][n] = 0.0;
     }
 
-  bumprow = g_new (guchar, w * bpp);
+  return rows;
+}
 
-  triangle_normals[0] = g_new (GimpVector3, (w << 1) + 2);
-  triangle_normals[1] = g_new (GimpVector3, (w << 1) + 2);
+void
+shade_rows_free (ShadeRows *rows)
+{
+  gint n;
 
-  for (n = 0; n < (w << 1) + 1; n++)
+  for (n = 0; n < 3; n++)
     {
-      gimp_vector3_set (&triangle_normals[0][n], 0.0, 0.0, 1.0);
-      gimp_vector3_set (&triangle_normals[1][n], 0.0, 0.0, 1.0);
+      g_free (rows->heights[n]);
+      g_free (rows->vertex_normals[n]);
     }
 
-  for (n = 0; n < w; n++)
+  g_free (rows->triangle_normals[0]);
+  g_free (rows->triangle_normals[1]);
+
+  g_slice_free (ShadeRows, rows);
+}
+
+/* Bring rows into the state a top to bottom pass has before
+ * precompute_normals() is called for row y.  The normals of a row
+ * only depend on the two rows above it, so a renderer can start
+ * anywhere in the image.
+ */
+void
+precompute_start (ShadeRows *rows,
+                  gint       x1,
+                  gint       x2,
+                  gint       y)
+{
+  gint n = 0;
+
+  if (y < 2)
+    {
+      if (pre_h >= 2)
+        interpol_row (rows, x1, x2, 0);
+    }
+  else
     {
-      gimp_vector3_set (&vertex_normals[0][n], 0.0, 0.0, 1.0);
-      gimp_vector3_set (&vertex_normals[1][n], 0.0, 0.0, 1.0);
-      gimp_vector3_set (&vertex_normals[2][n], 0.0, 0.0, 1.0);
-      heights[0][n] = 0.0;
-      heights[1][n] = 0.0;
-      heights[2][n] = 0.0;
+      n = y - 2;
     }
+
+  for (; n < y; n++)
+    precompute_normals (rows, x1, x2, n);
 }
 
 
@@ -172,27 +201,22 @@ precompute_init (gint w,
  * using the next row
  */
 void
-interpol_row (gint x1,
-              gint x2,
-              gint y)
+interpol_row (ShadeRows *rows,
+              gint       x1,
+              gint       x2,
+              gint       y)
 {
   GimpVector3   p1, p2, p3;
   gint          n, i;
   guchar        *map = NULL;
-  gint          bpp = 1;
-  guchar* bumprow1 = NULL;
-  guchar* bumprow2 = NULL;
-
-  if (mapvals.bumpmap_id != -1)
-    {
-      bpp = gimp_drawable_bpp(mapvals.bumpmap_id);
-    }
+  gint          bpp = bump_bpp;
+  const guchar *bumprow1;
+  const guchar *bumprow2;
+  GimpVector3 **triangle_normals = rows->triangle_normals;
+  gdouble     **heights          = rows->heights;
 
-  bumprow1 = g_new (guchar, pre_w * bpp);
-  bumprow2 = g_new (guchar, pre_w * bpp);
-
-  gimp_pixel_rgn_get_row (&bump_region, bumprow1, x1, y, x2 - x1);
-  gimp_pixel_rgn_get_row (&bump_region, bumprow2, x1, y+1, x2 - x1);
+  bumprow1 = bump_pixels + ((gsize) y * width + x1) * bpp;
+  bumprow2 = bump_pixels + ((gsize) (y + 1) * width + x1) * bpp;
 
   if (mapvals.bumpmaptype > 0)
     {
@@ -266,9 +290,6 @@ interpol_row (gint x1,
 
       i += 2;
     }
-
-  g_free (bumprow1);
-  g_free (bumprow2);
 }
 
 /********************************************/
@@ -277,16 +298,21 @@ interpol_row (gint x1,
 
 
 void
-precompute_normals (gint x1,
-                    gint x2,
-                    gint y)
+precompute_normals (ShadeRows *rows,
+                    gint       x1,
+                    gint       x2,
+                    gint       y)
 {
-  GimpVector3 *tmpv, p1, p2, p3, normal;
-  gdouble     *tmpd;
-  gint         n, i, nv;
-  guchar      *map = NULL;
-  gint bpp = 1;
-  guchar mapval;
+  GimpVector3  *tmpv, p1, p2, p3, normal;
+  gdouble      *tmpd;
+  gint          n, i, nv;
+  guchar       *map = NULL;
+  gint          bpp = bump_bpp;
+  guchar        mapval;
+  const guchar *bumprow;
+  GimpVector3 **triangle_normals = rows->triangle_normals;
+  GimpVector3 **vertex_normals   = rows->vertex_normals;
+  gdouble     **heights          = rows->heights;
 
 
   /* First, compute the heights */
@@ -306,12 +332,7 @@ precompute_normals (gint x1,
   heights[1] = heights[2];
   heights[2] = tmpd;
 
-  if (mapvals.bumpmap_id != -1)
-    {
-      bpp = gimp_drawable_bpp(mapvals.bumpmap_id);
-    }
-
-  gimp_pixel_rgn_get_row (&bump_region, bumprow, x1, y, x2 - x1);
+  bumprow = bump_pixels + ((gsize) y * width + x1) * bpp;
 
   if (mapvals.bumpmaptype > 0)
     {
@@ -467,10 +488,10 @@ sphere_to_image (GimpVector3 *normal,
                  gdouble     *u,
                  gdouble     *v)
 {
-  static gdouble     alpha, fac;
-  static GimpVector3 cross_prod;
   static GimpVector3 firstaxis  = { 1.0, 0.0, 0.0 };
   static GimpVector3 secondaxis = { 0.0, 1.0, 0.0 };
+  gdouble            alpha, fac;
+  GimpVector3        cross_prod;
 
   alpha = acos (-gimp_vector3_inner_product (&secondaxis, normal));
 
@@ -506,7 +527,8 @@ sphere_to_image (GimpVector3 *normal,
 /*********************************************************************/
 
 GimpRGB
-get_ray_color (GimpVector3 *position)
+get_ray_color (ShadeRows   *rows,
+               GimpVector3 *position)
 {
   GimpRGB       color;
   GimpRGB       color_int;
@@ -521,7 +543,7 @@ get_ray_color (GimpVector3 *position)
 
   x = RINT (xf);
 
-  if (mapvals.transparent_background && heights[1][x] == 0)
+  if (mapvals.transparent_background && rows->heights[1][x] == 0)
     {
       gimp_rgb_set_alpha (&color_sum, 0.0);
     }
@@ -553,11 +575,12 @@ get_ray_color (GimpVector3 *position)
                                          p,
                                          &color,
                                          &color_int,
-                                         mapvals.lightsource[k].type);
+                                         mapvals.lightsource[k].type,
+                                         mapvals.material.diffuse_int);
             }
           else
             {
-              normal = vertex_normals[1][(gint) RINT (xf)];
+              normal = rows->vertex_normals[1][(gint) RINT (xf)];
 
               light_color = phong_shade (position,
                                          &mapvals.viewpoint,
@@ -565,7 +588,8 @@ get_ray_color (GimpVector3 *position)
                                          p,
                                          &color,
                                          &color_int,
-                                         mapvals.lightsource[k].type);
+                                         mapvals.lightsource[k].type,
+                                         mapvals.material.diffuse_int);
             }
 
           gimp_rgb_add (&color_sum, &light_color);
@@ -577,7 +601,8 @@ get_ray_color (GimpVector3 *position)
 }
 
 GimpRGB
-get_ray_color_ref (GimpVector3 *position)
+get_ray_color_ref (ShadeRows   *rows,
+                   GimpVector3 *position)
 {
   GimpRGB      color_sum;
   GimpRGB      color_int;
@@ -587,7 +612,6 @@ get_ray_color_ref (GimpVector3 *position)
   gdouble      xf, yf;
   GimpVector3  normal, *p, v, r;
   gint         k;
-  gdouble      tmpval;
 
   pos_to_float (position->x, position->y, &xf, &yf);
 
@@ -596,10 +620,10 @@ get_ray_color_ref (GimpVector3 *position)
   if (mapvals.bump_mapped == FALSE || mapvals.bumpmap_id == -1)
     normal = mapvals.planenormal;
   else
-    normal = vertex_normals[1][(gint) RINT (xf)];
+    normal = rows->vertex_normals[1][(gint) RINT (xf)];
   gimp_vector3_normalize (&normal);
 
-  if (mapvals.transparent_background && heights[1][x] == 0)
+  if (mapvals.transparent_background && rows->heights[1][x] == 0)
     {
       gimp_rgb_set_alpha (&color_sum, 0.0);
     }
@@ -628,7 +652,8 @@ get_ray_color_ref (GimpVector3 *position)
                                      p,
                                      &color,
                                      &color_int,
-                                     mapvals.lightsource[0].type);
+                                     mapvals.lightsource[0].type,
+                                     mapvals.material.diffuse_int);
         }
 
       gimp_vector3_sub (&v, &mapvals.viewpoint, position);
@@ -643,18 +668,14 @@ get_ray_color_ref (GimpVector3 *position)
       env_color = peek_env_map (RINT (env_width * xf),
                                 RINT (env_height * yf));
 
-      tmpval = mapvals.material.diffuse_int;
-      mapvals.material.diffuse_int = 0.;
-
       light_color = phong_shade (position,
                                  &mapvals.viewpoint,
                                  &normal,
                                  &r,
                                  &color,
                                  &env_color,
-                                 DIRECTIONAL_LIGHT);
-
-      mapvals.material.diffuse_int = tmpval;
+                                 DIRECTIONAL_LIGHT,
+                                 0.0);
 
       gimp_rgb_add (&color_sum, &light_color);
     }
@@ -664,7 +685,8 @@ get_ray_color_ref (GimpVector3 *position)
 }
 
 GimpRGB
-get_ray_color_no_bilinear (GimpVector3 *position)
+get_ray_color_no_bilinear (ShadeRows   *rows,
+                           GimpVector3 *position)
 {
   GimpRGB       color;
   GimpRGB       color_int;
@@ -680,7 +702,7 @@ get_ray_color_no_bilinear (GimpVector3 *position)
 
   x = RINT (xf);
 
-  if (mapvals.transparent_background && heights[1][x] == 0)
+  if (mapvals.transparent_background && rows->heights[1][x] == 0)
     {
       gimp_rgb_set_alpha (&color_sum, 0.0);
     }
@@ -712,11 +734,12 @@ get_ray_color_no_bilinear (GimpVector3 *position)
                                          p,
                                          &color,
                                          &color_int,
-                                         mapvals.lightsource[k].type);
+                                         mapvals.lightsource[k].type,
+                                         mapvals.material.diffuse_int);
             }
           else
             {
-              normal = vertex_normals[1][x];
+              normal = rows->vertex_normals[1][x];
 
               light_color = phong_shade (position,
                                          &mapvals.viewpoint,
@@ -724,7 +747,8 @@ get_ray_color_no_bilinear (GimpVector3 *position)
                                          p,
                                          &color,
                                          &color_int,
-                                         mapvals.lightsource[k].type);
+                                         mapvals.lightsource[k].type,
+                                         mapvals.material.diffuse_int);
             }
 
           gimp_rgb_add (&color_sum, &light_color);
@@ -736,7 +760,8 @@ get_ray_color_no_bilinear (GimpVector3 *position)
 }
 
 GimpRGB
-get_ray_color_no_bilinear_ref (GimpVector3 *position)
+get_ray_color_no_bilinear_ref (ShadeRows   *rows,
+                               GimpVector3 *position)
 {
   GimpRGB      color_sum;
   GimpRGB      color_int;
@@ -746,7 +771,6 @@ get_ray_color_no_bilinear_ref (GimpVector3 *position)
   gdouble      xf, yf;
   GimpVector3  normal, *p, v, r;
   gint         k;
-  gdouble      tmpval;
 
   pos_to_float (position->x, position->y, &xf, &yf);
 
@@ -755,10 +779,10 @@ get_ray_color_no_bilinear_ref (GimpVector3 *position)
   if (mapvals.bump_mapped == FALSE || mapvals.bumpmap_id == -1)
     normal = mapvals.planenormal;
   else
-    normal = vertex_normals[1][(gint) RINT (xf)];
+    normal = rows->vertex_normals[1][(gint) RINT (xf)];
   gimp_vector3_normalize (&normal);
 
-  if (mapvals.transparent_background && heights[1][x] == 0)
+  if (mapvals.transparent_background && rows->heights[1][x] == 0)
     {
       gimp_rgb_set_alpha (&color_sum, 0.0);
     }
@@ -787,7 +811,8 @@ get_ray_color_no_bilinear_ref (GimpVector3 *position)
                                          p,
                                          &color,
                                          &color_int,
-                                         mapvals.lightsource[0].type);
+                                         mapvals.lightsource[0].type,
+                                     mapvals.material.diffuse_int);
         }
 
       gimp_vector3_sub (&v, &mapvals.viewpoint, position);
@@ -802,18 +827,14 @@ get_ray_color_no_bilinear_ref (GimpVector3 *position)
       env_color = peek_env_map (RINT (env_width * xf),
                                 RINT (env_height * yf));
 
-      tmpval = mapvals.material.diffuse_int;
-      mapvals.material.diffuse_int = 0.;
-
       light_color = phong_shade (position,
                                  &mapvals.viewpoint,
                                  &normal,
                                  &r,
                                  &color,
                                  &env_color,
-                                 DIRECTIONAL_LIGHT);
-
-      mapvals.material.diffuse_int = tmpval;
+                                 DIRECTIONAL_LIGHT,
+                                 0.0);
 
       gimp_rgb_add (&color_sum, &light_color);
     }
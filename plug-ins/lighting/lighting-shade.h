@@ -1,20 +1,43 @@
 #ifndef __LIGHTING_SHADE_H__
 #define __LIGHTING_SHADE_H__
 
-typedef GimpRGB (* get_ray_func) (GimpVector3 *vector);
+/* The bump map heights and normals around the row being shaded,
+ * each rendering thread works on its own set
+ */
+typedef struct
+{
+  GimpVector3 *triangle_normals[2];
+  GimpVector3 *vertex_normals[3];
+  gdouble     *heights[3];
+} ShadeRows;
 
-GimpRGB get_ray_color                 (GimpVector3 *position);
-GimpRGB get_ray_color_no_bilinear     (GimpVector3 *position);
-GimpRGB get_ray_color_ref             (GimpVector3 *position);
-GimpRGB get_ray_color_no_bilinear_ref (GimpVector3 *position);
+typedef GimpRGB (* get_ray_func) (ShadeRows   *rows,
+                                  GimpVector3 *vector);
 
-void    precompute_init               (gint         w,
-				       gint         h);
-void    precompute_normals            (gint         x1,
-				       gint         x2,
-				       gint         y);
-void    interpol_row                  (gint         x1,
-                                       gint         x2,
-                                       gint         y);
+GimpRGB     get_ray_color                 (ShadeRows   *rows,
+                                           GimpVector3 *position);
+GimpRGB     get_ray_color_no_bilinear     (ShadeRows   *rows,
+                                           GimpVector3 *position);
+GimpRGB     get_ray_color_ref             (ShadeRows   *rows,
+                                           GimpVector3 *position);
+GimpRGB     get_ray_color_no_bilinear_ref (ShadeRows   *rows,
+                                           GimpVector3 *position);
+
+void        precompute_init               (gint         w,
+                                           gint         h);
+ShadeRows * shade_rows_new                (void);
+void        shade_rows_free               (ShadeRows   *rows);
+void        precompute_start              (ShadeRows   *rows,
+                                           gint         x1,
+                                           gint         x2,
+                                           gint         y);
+void        precompute_normals            (ShadeRows   *rows,
+                                           gint         x1,
+                                           gint         x2,
+                                           gint         y);
+void        interpol_row                  (ShadeRows   *rows,
+                                           gint         x1,
+                                           gint         x2,
+                                           gint         y);
 
 #endif  /* __LIGHTING_SHADE_H__ */
@@ -19,6 +19,18 @@
 #include "libgimp/stdplugins-intl.h"
 
 
+#define MAX_THREADS 16
+#define CHUNK_ROWS  16
+
+
+typedef struct
+{
+  guchar *pixels;
+  gint    bpp;
+  gint    next_row;
+} ComputeParam;
+
+
 /*************/
 /* Main loop */
 /*************/
@@ -30,8 +42,6 @@ static gfloat a[16], b[16];
 void
 init_compute (void)
 {
-  gint i;
-
   switch (mapvals.maptype)
     {
       case MAP_SPHERE:
@@ -128,20 +138,6 @@ init_compute (void)
 
         memcpy (rotmat, b, sizeof (gfloat) * 16);
 
-        /* Set up pixel regions for the box face images */
-        /* ============================================ */
-
-        for (i = 0; i < 6; i++)
-          {
-            box_drawables[i] = gimp_drawable_get (mapvals.boxmap_id[i]);
-
-            gimp_pixel_rgn_init (&box_regions[i], box_drawables[i],
-                                 0, 0,
-                                 box_drawables[i]->width,
-                                 box_drawables[i]->height,
-                                 FALSE, FALSE);
-          }
-
         break;
 
       case MAP_CYLINDER:
@@ -168,25 +164,14 @@ init_compute (void)
         matmul (a, rotmat, b);
 
         memcpy (rotmat, b, sizeof (gfloat) * 16);
-
-        /* Set up pixel regions for the cylinder cap images */
-        /* ================================================ */
-
-        for (i = 0; i < 2; i++)
-          {
-            cylinder_drawables[i] =
-              gimp_drawable_get (mapvals.cylindermap_id[i]);
-
-            gimp_pixel_rgn_init (&cylinder_regions[i], cylinder_drawables[i],
-                                 0, 0,
-                                 cylinder_drawables[i]->width,
-                                 cylinder_drawables[i]->height,
-                                 FALSE, FALSE);
-          }
-
         break;
     }
 
+  /* Read the box face or cylinder cap images */
+  /* ======================================== */
+
+  image_load_maps ();
+
   max_depth = (gint) mapvals.maxdepth;
 }
 
@@ -205,6 +190,44 @@ render (gdouble   x,
   *col = get_ray_color (&pos);
 }
 
+static void
+compute_rows (ComputeParam *param,
+              gint          y1,
+              gint          y2)
+{
+  gint         xcount, ycount;
+  GimpRGB      color;
+  GimpVector3  p;
+  guchar       col[4];
+  guchar      *row;
+
+  for (ycount = y1; ycount < y2; ycount++)
+    {
+      row = param->pixels + (gsize) ycount * width * param->bpp;
+
+      for (xcount = 0; xcount < width; xcount++)
+        {
+          p = int_to_pos (xcount, ycount);
+          color = (* get_ray_color) (&p);
+
+          gimp_rgba_get_uchar (&color, &col[0], &col[1], &col[2], &col[3]);
+          memcpy (row, col, param->bpp);
+          row += param->bpp;
+        }
+    }
+}
+
+static gpointer
+compute_thread (ComputeParam *param)
+{
+  gint ycount;
+
+  while ((ycount = g_atomic_int_add (&param->next_row, CHUNK_ROWS)) < height)
+    compute_rows (param, ycount, MIN (ycount + CHUNK_ROWS, height));
+
+  return NULL;
+}
+
 static void
 show_progress (gint     min,
                gint     max,
@@ -222,10 +245,6 @@ show_progress (gint     min,
 void
 compute_image (void)
 {
-  gint         xcount, ycount;
-  GimpRGB      color;
-  glong        progress_counter = 0;
-  GimpVector3  p;
   gint32       new_image_id = -1;
   gint32       new_layer_id = -1;
   gboolean     insert_layer = FALSE;
@@ -284,19 +303,40 @@ compute_image (void)
 
   if (mapvals.antialiasing == FALSE)
     {
-      for (ycount = 0; ycount < height; ycount++)
+      ComputeParam  param;
+      GThread      *threads[MAX_THREADS];
+      gint          n_threads;
+      gint          ycount;
+      gint          i;
+
+      /* The images are in memory, trace chunks of rows in parallel */
+      /* ========================================================== */
+
+      param.bpp      = output_drawable->bpp;
+      param.pixels   = g_new (guchar, (gsize) width * height * param.bpp);
+      param.next_row = 0;
+
+      n_threads = CLAMP (g_get_num_processors (), 1, MAX_THREADS);
+
+      for (i = 1; i < n_threads; i++)
+        threads[i] = g_thread_new ("map-object",
+                                   (GThreadFunc) compute_thread, &param);
+
+      while ((ycount = g_atomic_int_add (&param.next_row, CHUNK_ROWS)) <
+             height)
         {
-          for (xcount = 0; xcount < width; xcount++)
-            {
-              p = int_to_pos (xcount, ycount);
-              color = (* get_ray_color) (&p);
-              poke (xcount, ycount, &color, NULL);
-
-              if ((progress_counter++ % width) == 0)
-                gimp_progress_update ((gdouble) progress_counter /
-                                      (gdouble) maxcounter);
-            }
+          gimp_progress_update ((gdouble) ycount / (gdouble) height);
+
+          compute_rows (&param, ycount, MIN (ycount + CHUNK_ROWS, height));
         }
+
+      for (i = 1; i < n_threads; i++)
+        g_thread_join (threads[i]);
+
+      gimp_pixel_rgn_set_rect (&dest_region, param.pixels,
+                               0, 0, width, height);
+
+      g_free (param.pixels);
     }
   else
     {
@@ -24,13 +24,18 @@
 
 
 GimpDrawable *input_drawable, *output_drawable;
-GimpPixelRgn source_region,dest_region;
+GimpPixelRgn dest_region;
 
 GimpDrawable *box_drawables[6];
-GimpPixelRgn box_regions[6];
-
 GimpDrawable *cylinder_drawables[2];
-GimpPixelRgn cylinder_regions[2];
+
+/* The source image and the box and cylinder maps are read into */
+/* memory once, so rays can be traced without going through the */
+/* tile cache, and in several threads at a time                 */
+
+static guchar *source_pixels = NULL;
+static guchar *box_pixels[6];
+static guchar *cylinder_pixels[2];
 
 guchar          *preview_rgb_data = NULL;
 gint             preview_rgb_stride;
@@ -47,15 +52,50 @@ gint border_x1, border_y1, border_x2, border_y2;
 /* Implementation */
 /******************/
 
+static guchar *
+get_pixels (GimpDrawable *drawable)
+{
+  GimpPixelRgn  region;
+  guchar       *pixels;
+
+  gimp_pixel_rgn_init (&region, drawable,
+                       0, 0, drawable->width, drawable->height, FALSE, FALSE);
+
+  pixels = g_new (guchar,
+                  (gsize) drawable->width * drawable->height * drawable->bpp);
+
+  gimp_pixel_rgn_get_rect (&region, pixels,
+                           0, 0, drawable->width, drawable->height);
+
+  return pixels;
+}
+
+static void
+load_map (GimpDrawable **drawable,
+          guchar       **pixels,
+          gint32         drawable_id)
+{
+  if (*drawable && (*drawable)->drawable_id == drawable_id)
+    return;
+
+  if (*drawable)
+    {
+      gimp_drawable_detach (*drawable);
+      g_free (*pixels);
+    }
+
+  *drawable = gimp_drawable_get (drawable_id);
+  *pixels   = get_pixels (*drawable);
+}
+
 GimpRGB
 peek (gint x,
       gint y)
 {
-  static guchar data[4];
+  const guchar *data;
+  GimpRGB       color;
 
-  GimpRGB color;
-
-  gimp_pixel_rgn_get_pixel (&source_region, data, x, y);
+  data = source_pixels + ((gsize) y * width + x) * input_drawable->bpp;
 
   color.r = (gdouble) (data[0]) / 255.0;
   color.g = (gdouble) (data[1]) / 255.0;
@@ -81,27 +121,21 @@ peek_box_image (gint image,
                 gint x,
                 gint y)
 {
-  static guchar data[4];
-
-  GimpRGB color;
+  GimpDrawable *drawable = box_drawables[image];
+  const guchar *data;
+  GimpRGB       color;
 
-  gimp_pixel_rgn_get_pixel (&box_regions[image], data, x, y);
+  data = (box_pixels[image] +
+          ((gsize) y * drawable->width + x) * drawable->bpp);
 
   color.r = (gdouble) (data[0]) / 255.0;
   color.g = (gdouble) (data[1]) / 255.0;
   color.b = (gdouble) (data[2]) / 255.0;
 
-  if (box_drawables[image]->bpp == 4)
-    {
-      if (gimp_drawable_has_alpha (box_drawables[image]->drawable_id))
-        color.a = (gdouble) (data[3]) / 255.0;
-      else
-        color.a = 1.0;
-    }
+  if (drawable->bpp == 4)
+    color.a = (gdouble) (data[3]) / 255.0;
   else
-    {
-      color.a = 1.0;
-    }
+    color.a = 1.0;
 
   return color;
 }
@@ -111,27 +145,21 @@ peek_cylinder_image (gint image,
                      gint x,
                      gint y)
 {
-  static guchar data[4];
-
-  GimpRGB color;
+  GimpDrawable *drawable = cylinder_drawables[image];
+  const guchar *data;
+  GimpRGB       color;
 
-  gimp_pixel_rgn_get_pixel (&cylinder_regions[image],data, x, y);
+  data = (cylinder_pixels[image] +
+          ((gsize) y * drawable->width + x) * drawable->bpp);
 
   color.r = (gdouble) (data[0]) / 255.0;
   color.g = (gdouble) (data[1]) / 255.0;
   color.b = (gdouble) (data[2]) / 255.0;
 
-  if (cylinder_drawables[image]->bpp == 4)
-    {
-      if (gimp_drawable_has_alpha (cylinder_drawables[image]->drawable_id))
-        color.a = (gdouble) (data[3]) / 255.0;
-      else
-        color.a = 1.0;
-    }
+  if (drawable->bpp == 4)
+    color.a = (gdouble) (data[3]) / 255.0;
   else
-    {
-      color.a = 1.0;
-    }
+    color.a = 1.0;
 
   return color;
 }
@@ -367,8 +395,8 @@ image_setup (GimpDrawable *drawable,
   width  = input_drawable->width;
   height = input_drawable->height;
 
-  gimp_pixel_rgn_init (&source_region, input_drawable,
-                       0, 0, width, height, FALSE, FALSE);
+  g_free (source_pixels);
+  source_pixels = get_pixels (input_drawable);
 
   maxcounter = (glong) width * (glong) height;
 
@@ -403,3 +431,31 @@ image_setup (GimpDrawable *drawable,
 
   return TRUE;
 }
+
+/***********************************************/
+/* Read the box or cylinder maps into memory,  */
+/* unless they are already there               */
+/***********************************************/
+
+void
+image_load_maps (void)
+{
+  gint i;
+
+  switch (mapvals.maptype)
+    {
+    case MAP_BOX:
+      for (i = 0; i < 6; i++)
+        load_map (&box_drawables[i], &box_pixels[i], mapvals.boxmap_id[i]);
+      break;
+
+    case MAP_CYLINDER:
+      for (i = 0; i < 2; i++)
+        load_map (&cylinder_drawables[i], &cylinder_pixels[i],
+                  mapvals.cylindermap_id[i]);
+      break;
+
+    default:
+      break;
+    }
+}
@@ -5,13 +5,10 @@
 /* ============================ */
 
 extern GimpDrawable *input_drawable, *output_drawable;
-extern GimpPixelRgn  source_region,dest_region;
+extern GimpPixelRgn  dest_region;
 
 extern GimpDrawable *box_drawables[6];
-extern GimpPixelRgn  box_regions[6];
-
 extern GimpDrawable *cylinder_drawables[2];
-extern GimpPixelRgn  cylinder_regions[2];
 
 extern guchar          *preview_rgb_data;
 extern gint             preview_rgb_stride;
@@ -31,6 +28,7 @@ extern GimpTile *current_in_tile, *current_out_tile;
 
 extern gint        image_setup              (GimpDrawable *drawable,
                                              gint          interactive);
+extern void        image_load_maps          (void);
 extern glong       in_xy_to_index           (gint          x,
                                              gint          y);
 extern glong       out_xy_to_index          (gint          x,
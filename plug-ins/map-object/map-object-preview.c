@@ -17,6 +17,21 @@
 #include "map-object-preview.h"
 
 
+#define MAX_THREADS 16
+#define COARSE_STEP 4   /* pixel size of the first preview pass */
+
+
+typedef struct
+{
+  gdouble xpostab[PREVIEW_WIDTH];
+  gdouble ypostab[PREVIEW_HEIGHT];
+  gint    pw, ph;
+  gint    step;
+  GimpRGB lightcheck, darkcheck;
+  gint    next_row;
+} PreviewParam;
+
+
 gdouble mat[3][4];
 gint    lightx, lighty;
 
@@ -70,6 +85,103 @@ static void draw_wireframe_cylinder (cairo_t *cr,
                                      gint        pw,
                                      gint        ph);
 
+/**************************************************************/
+/* Render one preview row, or with step > 1 every step-th     */
+/* pixel of it, filling a step x step block with each.        */
+/**************************************************************/
+
+static void
+compute_preview_row (PreviewParam *param,
+                     gint          ycnt)
+{
+  GimpVector3  p1;
+  GimpRGB      color;
+  gint         xcnt, x, y, x2, y2, f1, f2;
+  guchar       r, g, b;
+
+  y2 = MIN (ycnt + param->step, param->ph);
+
+  for (xcnt = 0; xcnt < param->pw; xcnt += param->step)
+    {
+      p1.x = param->xpostab[xcnt];
+      p1.y = param->ypostab[ycnt];
+      p1.z = 0.0;
+
+      color = (* get_ray_color) (&p1);
+
+      if (color.a < 1.0)
+        {
+          f1 = ((xcnt % 32) < 16);
+          f2 = ((ycnt % 32) < 16);
+          f1 = f1 ^ f2;
+
+          if (f1)
+            {
+              if (color.a == 0.0)
+                color = param->lightcheck;
+              else
+                gimp_rgb_composite (&color, &param->lightcheck,
+                                    GIMP_RGB_COMPOSITE_BEHIND);
+             }
+          else
+            {
+              if (color.a == 0.0)
+                color = param->darkcheck;
+              else
+                gimp_rgb_composite (&color, &param->darkcheck,
+                                    GIMP_RGB_COMPOSITE_BEHIND);
+            }
+        }
+
+      gimp_rgb_get_uchar (&color, &r, &g, &b);
+
+      x2 = MIN (xcnt + param->step, param->pw);
+
+      for (y = ycnt; y < y2; y++)
+        for (x = xcnt; x < x2; x++)
+          GIMP_CAIRO_RGB24_SET_PIXEL ((preview_rgb_data +
+                                       y * preview_rgb_stride + x * 4),
+                                      r, g, b);
+    }
+}
+
+static gpointer
+compute_preview_thread (PreviewParam *param)
+{
+  gint ycnt;
+
+  while ((ycnt = g_atomic_int_add (&param->next_row, param->step)) <
+         param->ph)
+    {
+      compute_preview_row (param, ycnt);
+    }
+
+  return NULL;
+}
+
+static void
+compute_preview_pass (PreviewParam *param,
+                      gint          step)
+{
+  GThread *threads[MAX_THREADS];
+  gint     n_threads;
+  gint     i;
+
+  param->step     = step;
+  param->next_row = 0;
+
+  n_threads = CLAMP (g_get_num_processors (), 1, MAX_THREADS);
+
+  for (i = 1; i < n_threads; i++)
+    threads[i] = g_thread_new ("map-object-preview",
+                               (GThreadFunc) compute_preview_thread, param);
+
+  compute_preview_thread (param);
+
+  for (i = 1; i < n_threads; i++)
+    g_thread_join (threads[i]);
+}
+
 /**************************************************************/
 /* Computes a preview of the rectangle starting at (x,y) with */
 /* dimensions (w,h), placing the result in preview_RGB_data.  */
@@ -83,16 +195,11 @@ compute_preview (gint x,
                  gint pw,
                  gint ph)
 {
-  gdouble      xpostab[PREVIEW_WIDTH];
-  gdouble      ypostab[PREVIEW_HEIGHT];
+  PreviewParam param;
   gdouble      realw;
   gdouble      realh;
   GimpVector3  p1, p2;
-  GimpRGB      color;
-  GimpRGB      lightcheck, darkcheck;
-  gint         xcnt, ycnt, f1, f2;
-  guchar       r, g, b;
-  glong        index = 0;
+  gint         xcnt, ycnt;
 
   init_compute ();
 
@@ -106,10 +213,13 @@ compute_preview (gint x,
   realh = (p2.y - p1.y);
 
   for (xcnt = 0; xcnt < pw; xcnt++)
-    xpostab[xcnt] = p1.x + realw * ((gdouble) xcnt / (gdouble) pw);
+    param.xpostab[xcnt] = p1.x + realw * ((gdouble) xcnt / (gdouble) pw);
 
   for (ycnt = 0; ycnt < ph; ycnt++)
-    ypostab[ycnt] = p1.y + realh * ((gdouble) ycnt / (gdouble) ph);
+    param.ypostab[ycnt] = p1.y + realh * ((gdouble) ycnt / (gdouble) ph);
+
+  param.pw = pw;
+  param.ph = ph;
 
   /* Compute preview using the offset tables */
   /* ======================================= */
@@ -124,54 +234,26 @@ compute_preview (gint x,
       gimp_rgb_set_alpha (&background, 1.0);
     }
 
-  gimp_rgba_set (&lightcheck,
+  gimp_rgba_set (&param.lightcheck,
                  GIMP_CHECK_LIGHT, GIMP_CHECK_LIGHT, GIMP_CHECK_LIGHT, 1.0);
-  gimp_rgba_set (&darkcheck,
+  gimp_rgba_set (&param.darkcheck,
                  GIMP_CHECK_DARK, GIMP_CHECK_DARK, GIMP_CHECK_DARK, 1.0);
-  gimp_vector3_set (&p2, -1.0, -1.0, 0.0);
 
   cairo_surface_flush (preview_surface);
 
-  for (ycnt = 0; ycnt < ph; ycnt++)
-    {
-      index = ycnt * preview_rgb_stride;
-      for (xcnt = 0; xcnt < pw; xcnt++)
-        {
-          p1.x = xpostab[xcnt];
-          p1.y = ypostab[ycnt];
+  /* Show a coarse preview first, then refine it */
+  /* =========================================== */
 
-          p2 = p1;
-          color = (* get_ray_color) (&p1);
+  compute_preview_pass (&param, COARSE_STEP);
 
-          if (color.a < 1.0)
-            {
-              f1 = ((xcnt % 32) < 16);
-              f2 = ((ycnt % 32) < 16);
-              f1 = f1 ^ f2;
-
-              if (f1)
-                {
-                  if (color.a == 0.0)
-                    color = lightcheck;
-                  else
-                    gimp_rgb_composite (&color, &lightcheck,
-                                        GIMP_RGB_COMPOSITE_BEHIND);
-                 }
-              else
-                {
-                  if (color.a == 0.0)
-                    color = darkcheck;
-                  else
-                    gimp_rgb_composite (&color, &darkcheck,
-                                        GIMP_RGB_COMPOSITE_BEHIND);
-                }
-            }
+  cairo_surface_mark_dirty (preview_surface);
+  gtk_widget_queue_draw (previewarea);
+  gdk_window_process_updates (gtk_widget_get_window (previewarea), FALSE);
+
+  cairo_surface_flush (preview_surface);
+
+  compute_preview_pass (&param, 1);
 
-          gimp_rgb_get_uchar (&color, &r, &g, &b);
-          GIMP_CAIRO_RGB24_SET_PIXEL((preview_rgb_data + index), r, g, b);
-          index += 4;
-        }
-    }
   cairo_surface_mark_dirty (preview_surface);
 }
 
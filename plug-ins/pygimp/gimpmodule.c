@@ -1951,6 +1951,11 @@ initgimp(void)
     if (PyType_Ready(&PyGimpPixelRgn_Type) < 0)
         return;
 
+    PyGimpPixelBuffer_Type.ob_type = &PyType_Type;
+    PyGimpPixelBuffer_Type.tp_alloc = PyType_GenericAlloc;
+    if (PyType_Ready(&PyGimpPixelBuffer_Type) < 0)
+        return;
+
     PyGimpParasite_Type.ob_type = &PyType_Type;
     PyGimpParasite_Type.tp_alloc = PyType_GenericAlloc;
     PyGimpParasite_Type.tp_new = PyType_GenericNew;
@@ -2035,6 +2040,9 @@ initgimp(void)
     Py_INCREF(&PyGimpPixelRgn_Type);
     PyModule_AddObject(m, "PixelRgn", (PyObject *)&PyGimpPixelRgn_Type);
 
+    Py_INCREF(&PyGimpPixelBuffer_Type);
+    PyModule_AddObject(m, "PixelBuffer", (PyObject *)&PyGimpPixelBuffer_Type);
+
     Py_INCREF(&PyGimpParasite_Type);
     PyModule_AddObject(m, "Parasite", (PyObject *)&PyGimpParasite_Type);
 
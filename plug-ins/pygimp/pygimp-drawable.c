@@ -195,6 +195,25 @@ drw_get_pixel_rgn(PyGimpDrawable *self, PyObject *args, PyObject *kwargs)
     return pygimp_pixel_rgn_new(self, x, y, width, height, dirty, shadow);
 }
 
+static PyObject *
+drw_get_pixel_buffer(PyGimpDrawable *self, PyObject *args, PyObject *kwargs)
+{
+    int x = 0, y = 0, width = -1, height = -1, dirty = 1, shadow = 0;
+    char *format = NULL;
+
+    static char *kwlist[] = { "x", "y", "width", "height", "format",
+			      "dirty", "shadow", NULL };
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs,
+				     "|iiiiziii:get_pixel_buffer", kwlist,
+				     &x, &y, &width, &height, &format,
+				     &dirty, &shadow))
+	return NULL;
+
+    return pygimp_pixel_buffer_new(self, x, y, width, height, format,
+				   dirty, shadow);
+}
+
 static PyObject *
 drw_offset(PyGimpDrawable *self, PyObject *args, PyObject *kwargs)
 {
@@ -1079,6 +1098,8 @@ static PyMethodDef drw_methods[] = {
     {"get_tile",	(PyCFunction)drw_get_tile,	METH_VARARGS | METH_KEYWORDS},
     {"get_tile2",	(PyCFunction)drw_get_tile2,	METH_VARARGS | METH_KEYWORDS},
     {"get_pixel_rgn", (PyCFunction)drw_get_pixel_rgn, METH_VARARGS | METH_KEYWORDS},
+    {"get_pixel_buffer", (PyCFunction)drw_get_pixel_buffer, METH_VARARGS | METH_KEYWORDS,
+     "Returns a gimp.PixelBuffer of a rectangle, usable with numpy.asarray()"},
     {"get_data", (PyCFunction)drw_get_data, METH_VARARGS | METH_KEYWORDS,
      "Takes a BABL format string, returns a Python array.array object"},
     {"offset", (PyCFunction)drw_offset, METH_VARARGS | METH_KEYWORDS},
@@ -25,6 +25,8 @@
 #define NO_IMPORT_PYGIMPCOLOR
 #include "pygimpcolor-api.h"
 
+#include <string.h>
+
 #include <structmember.h>
 
 static PyObject *
@@ -1042,3 +1044,403 @@ PyTypeObject PyGimpPixelFetcher_Type = {
     (allocfunc)0,                       /* tp_alloc */
     (newfunc)0,                         /* tp_new */
 };
+
+/* End of code for PixelFetcher objects */
+/* -------------------------------------------------------- */
+
+
+/* A PixelBuffer is a linear copy of a drawable rectangle, read through
+ * the drawable's GeglBuffer in one go.  It exports its memory through
+ * the buffer protocol as a (height, width, components) array, so that
+ * numpy.asarray() can work on it without copying, and writes it back
+ * on flush().
+ */
+
+static gboolean
+pb_write_back(PyGimpPixelBuffer *self)
+{
+    if (!self->pending || !self->data)
+        return TRUE;
+
+    self->pending = FALSE;
+
+    gegl_buffer_set(self->buffer, &self->rect, 0, self->format,
+                    self->data, GEGL_AUTO_ROWSTRIDE);
+    gegl_buffer_flush(self->buffer);
+
+    if (self->shadow)
+        return TRUE;
+
+    return gimp_drawable_update(self->drawable->ID,
+                                self->rect.x, self->rect.y,
+                                self->rect.width, self->rect.height);
+}
+
+static PyObject *
+pb_flush(PyGimpPixelBuffer *self)
+{
+    if (!pb_write_back(self)) {
+        PyErr_Format(pygimp_error,
+                     "could not update drawable (ID %d)",
+                     self->drawable->ID);
+        return NULL;
+    }
+
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+static PyObject *
+pb_enter(PyGimpPixelBuffer *self)
+{
+    Py_INCREF(self);
+    return (PyObject *)self;
+}
+
+static PyObject *
+pb_exit(PyGimpPixelBuffer *self, PyObject *args)
+{
+    return pb_flush(self);
+}
+
+static PyMethodDef pb_methods[] = {
+    {"flush",	(PyCFunction)pb_flush,	METH_NOARGS},
+    {"__enter__",	(PyCFunction)pb_enter,	METH_NOARGS},
+    {"__exit__",	(PyCFunction)pb_exit,	METH_VARARGS},
+    {NULL,		NULL}		/* sentinel */
+};
+
+static const char *
+pb_type_code(const Babl *format)
+{
+    const Babl *type = babl_format_get_type(format, 0);
+
+    if (type == babl_type("u8"))
+        return "B";
+    else if (type == babl_type("u16"))
+        return "H";
+    else if (type == babl_type("u32"))
+        return "I";
+    else if (type == babl_type("half"))
+        return "e";
+    else if (type == babl_type("float"))
+        return "f";
+    else if (type == babl_type("double"))
+        return "d";
+
+    return NULL;
+}
+
+PyObject *
+pygimp_pixel_buffer_new(PyGimpDrawable *drawable, int x, int y,
+                        int width, int height,
+                        const char *format, int dirty, int shadow)
+{
+    PyGimpPixelBuffer *self;
+    const Babl *bbl_format;
+    const char *type_code;
+    int drw_width, drw_height;
+    int n_components;
+
+    if (format) {
+        if (!babl_format_exists(format)) {
+            PyErr_Format(pygimp_error, "unknown pixel format '%s'", format);
+            return NULL;
+        }
+
+        bbl_format = babl_format(format);
+    } else {
+        bbl_format = gimp_drawable_get_format(drawable->ID);
+    }
+
+    type_code = pb_type_code(bbl_format);
+
+    if (!type_code) {
+        PyErr_Format(pygimp_error, "unsupported pixel format '%s'",
+                     babl_get_name(bbl_format));
+        return NULL;
+    }
+
+    drw_width = gimp_drawable_width(drawable->ID);
+    drw_height = gimp_drawable_height(drawable->ID);
+
+    if (width < 0) width = drw_width - x;
+    if (height < 0) height = drw_height - y;
+
+    if (!gimp_rectangle_intersect(x, y, width, height,
+                                  0, 0, drw_width, drw_height,
+                                  &x, &y, &width, &height)) {
+        PyErr_SetString(PyExc_ValueError,
+                        "rectangle does not intersect the drawable");
+        return NULL;
+    }
+
+    n_components = babl_format_get_n_components(bbl_format);
+
+    self = PyObject_NEW(PyGimpPixelBuffer, &PyGimpPixelBuffer_Type);
+
+    if (self == NULL)
+        return NULL;
+
+    self->format = bbl_format;
+    self->bpp = babl_format_get_bytes_per_pixel(bbl_format);
+    self->rect.x = x;
+    self->rect.y = y;
+    self->rect.width = width;
+    self->rect.height = height;
+    self->dirty = dirty;
+    self->shadow = shadow;
+    self->pending = FALSE;
+
+    self->shape[0] = height;
+    self->shape[1] = width;
+    self->shape[2] = n_components;
+    self->strides[0] = (Py_ssize_t) width * self->bpp;
+    self->strides[1] = self->bpp;
+    self->strides[2] = self->bpp / n_components;
+
+    strcpy(self->type_code, type_code);
+
+    self->drawable = drawable;
+    Py_INCREF(drawable);
+
+    self->buffer = gimp_drawable_get_buffer(drawable->ID);
+    self->data = g_try_malloc((gsize) self->strides[0] * height);
+
+    if (!self->data) {
+        Py_DECREF(self);
+        return PyErr_NoMemory();
+    }
+
+    gegl_buffer_get(self->buffer, &self->rect, 1.0, bbl_format, self->data,
+                    GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+    /* read the drawable's pixels, but write to its shadow buffer */
+    if (shadow) {
+        g_object_unref(self->buffer);
+        self->buffer = gimp_drawable_get_shadow_buffer(drawable->ID);
+    }
+
+    return (PyObject *)self;
+}
+
+static void
+pb_dealloc(PyGimpPixelBuffer *self)
+{
+    if (self->data) {
+        pb_write_back(self);
+        g_free(self->data);
+    }
+
+    if (self->buffer)
+        g_object_unref(self->buffer);
+
+    Py_XDECREF(self->drawable);
+
+    PyObject_DEL(self);
+}
+
+/* Code to export pb objects through the buffer protocol */
+
+static Py_ssize_t
+pb_get_read_buffer(PyGimpPixelBuffer *self, Py_ssize_t segment, void **ptr)
+{
+    if (segment != 0) {
+        PyErr_SetString(PyExc_SystemError,
+                        "accessing non-existent pixel buffer segment");
+        return -1;
+    }
+
+    *ptr = self->data;
+
+    return self->strides[0] * self->rect.height;
+}
+
+static Py_ssize_t
+pb_get_write_buffer(PyGimpPixelBuffer *self, Py_ssize_t segment, void **ptr)
+{
+    if (!self->dirty) {
+        PyErr_SetString(PyExc_TypeError, "pixel buffer is not dirty");
+        return -1;
+    }
+
+    self->pending = TRUE;
+
+    return pb_get_read_buffer(self, segment, ptr);
+}
+
+static Py_ssize_t
+pb_get_seg_count(PyGimpPixelBuffer *self, Py_ssize_t *len)
+{
+    if (len)
+        *len = self->strides[0] * self->rect.height;
+
+    return 1;
+}
+
+#ifdef Py_TPFLAGS_HAVE_NEWBUFFER
+static int
+pb_get_buffer(PyGimpPixelBuffer *self, Py_buffer *view, int flags)
+{
+    if ((flags & PyBUF_WRITABLE) == PyBUF_WRITABLE && !self->dirty) {
+        PyErr_SetString(PyExc_BufferError, "pixel buffer is not dirty");
+        return -1;
+    }
+
+    /* the pixels are C-contiguous, any layout request can be served */
+    view->obj = (PyObject *)self;
+    Py_INCREF(self);
+
+    view->buf = self->data;
+    view->len = self->strides[0] * self->rect.height;
+    view->readonly = !self->dirty;
+    view->itemsize = self->strides[2];
+    view->format = (flags & PyBUF_FORMAT) ? self->type_code : NULL;
+    view->ndim = 3;
+    view->shape = (flags & PyBUF_ND) ? self->shape : NULL;
+    view->strides = ((flags & PyBUF_STRIDES) == PyBUF_STRIDES) ?
+                    self->strides : NULL;
+    view->suboffsets = NULL;
+    view->internal = NULL;
+
+    /* writes through a view may also come after a flush() */
+    if (!view->readonly)
+        self->pending = TRUE;
+
+    return 0;
+}
+
+static void
+pb_release_buffer(PyGimpPixelBuffer *self, Py_buffer *view)
+{
+    if (!view->readonly)
+        self->pending = TRUE;
+}
+#endif
+
+static PyBufferProcs pb_as_buffer = {
+    (readbufferproc)pb_get_read_buffer,
+    (writebufferproc)pb_get_write_buffer,
+    (segcountproc)pb_get_seg_count,
+    (charbufferproc)0,
+#ifdef Py_TPFLAGS_HAVE_NEWBUFFER
+    (getbufferproc)pb_get_buffer,
+    (releasebufferproc)pb_release_buffer,
+#endif
+};
+
+#define OFF(x) GINT_TO_POINTER(offsetof(GeglRectangle, x))
+
+static PyObject *
+pb_get_drawable(PyGimpPixelBuffer *self, void *closure)
+{
+    Py_INCREF(self->drawable);
+    return (PyObject *)self->drawable;
+}
+
+static PyObject *
+pb_get_rect_field(PyGimpPixelBuffer *self, void *closure)
+{
+    return PyInt_FromLong(G_STRUCT_MEMBER(gint, &self->rect,
+                                          GPOINTER_TO_INT(closure)));
+}
+
+static PyObject *
+pb_get_format(PyGimpPixelBuffer *self, void *closure)
+{
+    return PyString_FromString(babl_get_name(self->format));
+}
+
+static PyObject *
+pb_get_shape(PyGimpPixelBuffer *self, void *closure)
+{
+    return Py_BuildValue("(nnn)",
+                         self->shape[0], self->shape[1], self->shape[2]);
+}
+
+static PyObject *
+pb_get_dirty(PyGimpPixelBuffer *self, void *closure)
+{
+    return PyBool_FromLong(self->dirty);
+}
+
+static PyObject *
+pb_get_shadow(PyGimpPixelBuffer *self, void *closure)
+{
+    return PyBool_FromLong(self->shadow);
+}
+
+static PyGetSetDef pb_getsets[] = {
+    { "drawable", (getter)pb_get_drawable, 0, NULL },
+    { "x", (getter)pb_get_rect_field, 0, NULL, OFF(x) },
+    { "y", (getter)pb_get_rect_field, 0, NULL, OFF(y) },
+    { "w", (getter)pb_get_rect_field, 0, NULL, OFF(width) },
+    { "h", (getter)pb_get_rect_field, 0, NULL, OFF(height) },
+    { "format", (getter)pb_get_format, 0, NULL },
+    { "shape", (getter)pb_get_shape, 0, NULL },
+    { "dirty", (getter)pb_get_dirty, 0, NULL },
+    { "shadow", (getter)pb_get_shadow, 0, NULL },
+    { NULL, (getter)0, (setter)0 },
+};
+#undef OFF
+
+static PyObject *
+pb_repr(PyGimpPixelBuffer *self)
+{
+    PyObject *s;
+    gchar *name;
+
+    name = gimp_item_get_name(self->drawable->ID);
+    s = PyString_FromFormat("<gimp.PixelBuffer for drawable '%s' (%s)>",
+                            name, babl_get_name(self->format));
+    g_free(name);
+
+    return s;
+}
+
+PyTypeObject PyGimpPixelBuffer_Type = {
+    PyObject_HEAD_INIT(NULL)
+    0,                                  /* ob_size */
+    "gimp.PixelBuffer",                 /* tp_name */
+    sizeof(PyGimpPixelBuffer),          /* tp_basicsize */
+    0,                                  /* tp_itemsize */
+    /* methods */
+    (destructor)pb_dealloc,             /* tp_dealloc */
+    (printfunc)0,                       /* tp_print */
+    (getattrfunc)0,                     /* tp_getattr */
+    (setattrfunc)0,                     /* tp_setattr */
+    (cmpfunc)0,                         /* tp_compare */
+    (reprfunc)pb_repr,                  /* tp_repr */
+    0,                                  /* tp_as_number */
+    0,                                  /* tp_as_sequence */
+    0,                                  /* tp_as_mapping */
+    (hashfunc)0,                        /* tp_hash */
+    (ternaryfunc)0,                     /* tp_call */
+    (reprfunc)0,                        /* tp_str */
+    (getattrofunc)0,                    /* tp_getattro */
+    (setattrofunc)0,                    /* tp_setattro */
+    &pb_as_buffer,                      /* tp_as_buffer */
+#ifdef Py_TPFLAGS_HAVE_NEWBUFFER
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_NEWBUFFER, /* tp_flags */
+#else
+    Py_TPFLAGS_DEFAULT,                 /* tp_flags */
+#endif
+    NULL, /* Documentation string */
+    (traverseproc)0,                    /* tp_traverse */
+    (inquiry)0,                         /* tp_clear */
+    (richcmpfunc)0,                     /* tp_richcompare */
+    0,                                  /* tp_weaklistoffset */
+    (getiterfunc)0,                     /* tp_iter */
+    (iternextfunc)0,                    /* tp_iternext */
+    pb_methods,                         /* tp_methods */
+    0,                                  /* tp_members */
+    pb_getsets,                         /* tp_getset */
+    (PyTypeObject *)0,                  /* tp_base */
+    (PyObject *)0,                      /* tp_dict */
+    0,                                  /* tp_descr_get */
+    0,                                  /* tp_descr_set */
+    0,                                  /* tp_dictoffset */
+    (initproc)0,                        /* tp_init */
+    (allocfunc)0,                       /* tp_alloc */
+    (newfunc)0,                         /* tp_new */
+};
@@ -134,6 +134,28 @@ typedef struct {
 extern PyTypeObject PyGimpPixelFetcher_Type;
 #define pygimp_pixel_fetcher_check(v) (PyObject_TypeCheck(v, &PyGimpPixelFetcher_Type))
 
+typedef struct {
+    PyObject_HEAD
+    PyGimpDrawable *drawable; /* keep the drawable around */
+    GeglBuffer *buffer;
+    const Babl *format;
+    GeglRectangle rect;
+    guchar *data;
+    gboolean shadow;
+    gboolean dirty;
+    gboolean pending; /* unflushed writes may exist */
+    int bpp;
+    Py_ssize_t shape[3];
+    Py_ssize_t strides[3];
+    char type_code[2];
+} PyGimpPixelBuffer;
+
+extern PyTypeObject PyGimpPixelBuffer_Type;
+#define pygimp_pixel_buffer_check(v) (PyObject_TypeCheck(v, &PyGimpPixelBuffer_Type))
+PyObject *pygimp_pixel_buffer_new(PyGimpDrawable *drw, int x, int y,
+                                  int width, int height,
+                                  const char *format, int dirty, int shadow);
+
 G_END_DECLS
 
 #endif
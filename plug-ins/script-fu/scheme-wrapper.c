@@ -69,13 +69,33 @@ static pointer  script_fu_nil_call               (scheme    *sc,
 
 static gboolean ts_load_file                     (const gchar *dirname,
                                                   const gchar *basename);
-
 typedef struct
 {
   const gchar *name;
   gint         value;
 } NamedConstant;
 
+/*  The argument and return value types of a PDB procedure, the names
+ *  and descriptions are of no use to the marshaller.
+ */
+typedef struct
+{
+  gint          nparams;
+  gint          nreturn_vals;
+  GimpParamDef *params;
+  GimpParamDef *return_vals;
+  gboolean      cached;
+} ProcSignature;
+
+/*  Most procedure calls have no more arguments than this, their
+ *  arguments are marshalled on the stack.
+ */
+#define N_STACK_ARGS 16
+
+
+static ProcSignature * script_fu_lookup_signature (const gchar   *proc_name);
+static void            script_fu_signature_free   (ProcSignature *signature);
+
 static const NamedConstant const script_constants[] =
 {
   /* Useful values from libgimpbase/gimplimits.h */
@@ -173,7 +193,8 @@ static const NamedConstant const old_constants[] =
 };
 
 
-static scheme sc;
+static scheme      sc;
+static GHashTable *proc_signatures = NULL;
 
 
 void
@@ -579,24 +600,19 @@ static pointer
 script_fu_marshal_procedure_call (scheme  *sc,
                                   pointer  a)
 {
-  GimpParam       *args;
-  GimpParam       *values = NULL;
-  gint             nvalues;
-  gchar           *proc_name;
-  gchar           *proc_blurb;
-  gchar           *proc_help;
-  gchar           *proc_author;
-  gchar           *proc_copyright;
-  gchar           *proc_date;
-  GimpPDBProcType  proc_type;
-  gint             nparams;
-  gint             nreturn_vals;
-  GimpParamDef    *params;
-  GimpParamDef    *return_vals;
-  gchar            error_str[1024];
-  gint             i;
-  gint             success = TRUE;
-  pointer          return_val = sc->NIL;
+  ProcSignature       *signature;
+  GimpParam            stack_args[N_STACK_ARGS];
+  GimpParam           *args;
+  GimpParam           *values = NULL;
+  gint                 nvalues;
+  gchar               *proc_name;
+  gint                 nparams;
+  const GimpParamDef  *params;
+  const GimpParamDef  *return_vals;
+  gchar                error_str[1024];
+  gint                 i;
+  gint                 success = TRUE;
+  pointer              return_val = sc->NIL;
 
 #if DEBUG_MARSHALL
 /* These three #defines are from Tinyscheme (tinyscheme/scheme.c) */
@@ -638,15 +654,9 @@ script_fu_marshal_procedure_call (scheme  *sc,
   script_fu_interface_report_cc (proc_name);
 
   /*  Attempt to fetch the procedure from the database  */
-  if (! gimp_procedural_db_proc_info (proc_name,
-                                      &proc_blurb,
-                                      &proc_help,
-                                      &proc_author,
-                                      &proc_copyright,
-                                      &proc_date,
-                                      &proc_type,
-                                      &nparams, &nreturn_vals,
-                                      &params, &return_vals))
+  signature = script_fu_lookup_signature (proc_name);
+
+  if (! signature)
     {
 #ifdef DEBUG_MARSHALL
       g_printerr ("  Invalid procedure name\n");
@@ -656,17 +666,9 @@ script_fu_marshal_procedure_call (scheme  *sc,
       return foreign_error (sc, error_str, 0);
     }
 
-  /* Free the name and the description which are of no use here.  */
-  for (i = 0; i < nparams; i++)
-    {
-      g_free (params[i].name);
-      g_free (params[i].description);
-    }
-  for (i = 0; i < nreturn_vals; i++)
-    {
-      g_free (return_vals[i].name);
-      g_free (return_vals[i].description);
-    }
+  nparams     = signature->nparams;
+  params      = signature->params;
+  return_vals = signature->return_vals;
 
   /*  Check the supplied number of arguments  */
   if ((sc->vptr->list_length (sc, a) - 1) != nparams)
@@ -682,10 +684,10 @@ script_fu_marshal_procedure_call (scheme  *sc,
     }
 
   /*  Marshall the supplied arguments  */
-  if (nparams)
+  if (nparams > N_STACK_ARGS)
     args = g_new (GimpParam, nparams);
   else
-    args = NULL;
+    args = stack_args;
 
   for (i = 0; i < nparams; i++)
     {
@@ -1603,14 +1605,11 @@ script_fu_marshal_procedure_call (scheme  *sc,
   /*  free up arguments and values  */
   script_fu_marshal_destroy_args (args, nparams);
 
-  /*  free the query information  */
-  g_free (proc_blurb);
-  g_free (proc_help);
-  g_free (proc_author);
-  g_free (proc_copyright);
-  g_free (proc_date);
-  g_free (params);
-  g_free (return_vals);
+  if (args != stack_args)
+    g_free (args);
+
+  if (! signature->cached)
+    script_fu_signature_free (signature);
 
   /*  if we're in server mode, listen for additional commands for 10 ms  */
   if (script_fu_server_get_mode ())
@@ -1681,8 +1680,93 @@ script_fu_marshal_destroy_args (GimpParam *params,
           break;
         }
     }
+}
+
+/*  Returns the signature of @proc_name, asking the PDB only the first
+ *  time.  Temporary procedures are not cached, they can be installed
+ *  again with different arguments, for example when scripts are
+ *  refreshed; the caller frees their signature when done.
+ */
+static ProcSignature *
+script_fu_lookup_signature (const gchar *proc_name)
+{
+  ProcSignature   *signature;
+  gchar           *proc_blurb;
+  gchar           *proc_help;
+  gchar           *proc_author;
+  gchar           *proc_copyright;
+  gchar           *proc_date;
+  GimpPDBProcType  proc_type;
+  gint             i;
+
+  if (! proc_signatures)
+    proc_signatures =
+      g_hash_table_new_full (g_str_hash, g_str_equal,
+                             (GDestroyNotify) g_free,
+                             (GDestroyNotify) script_fu_signature_free);
+
+  signature = g_hash_table_lookup (proc_signatures, proc_name);
+
+  if (signature)
+    return signature;
+
+  signature = g_slice_new (ProcSignature);
+
+  if (! gimp_procedural_db_proc_info (proc_name,
+                                      &proc_blurb,
+                                      &proc_help,
+                                      &proc_author,
+                                      &proc_copyright,
+                                      &proc_date,
+                                      &proc_type,
+                                      &signature->nparams,
+                                      &signature->nreturn_vals,
+                                      &signature->params,
+                                      &signature->return_vals))
+    {
+      g_slice_free (ProcSignature, signature);
+      return NULL;
+    }
+
+  g_free (proc_blurb);
+  g_free (proc_help);
+  g_free (proc_author);
+  g_free (proc_copyright);
+  g_free (proc_date);
+
+  /* Free the name and the description which are of no use here.  */
+  for (i = 0; i < signature->nparams; i++)
+    {
+      g_free (signature->params[i].name);
+      g_free (signature->params[i].description);
+
+      signature->params[i].name        = NULL;
+      signature->params[i].description = NULL;
+    }
+  for (i = 0; i < signature->nreturn_vals; i++)
+    {
+      g_free (signature->return_vals[i].name);
+      g_free (signature->return_vals[i].description);
+
+      signature->return_vals[i].name        = NULL;
+      signature->return_vals[i].description = NULL;
+    }
+
+  signature->cached = (proc_type != GIMP_TEMPORARY);
+
+  if (signature->cached)
+    g_hash_table_insert (proc_signatures, g_strdup (proc_name), signature);
+
+  return signature;
+}
+
+static void
+script_fu_signature_free (ProcSignature *signature)
+{
+  g_free (signature->params);
+  g_free (signature->return_vals);
 
-  g_free (params);
+  g_slice_free (ProcSignature, signature);
 }
 
 static pointer
@@ -127,9 +127,10 @@ typedef short sa_family_t;	/* Not defined by winsock */
 
 typedef struct
 {
-  gchar *command;
-  gint   filedes;
-  gint   request_no;
+  gchar  *command;
+  gint    filedes;
+  gint    request_no;
+  gint64  queued;      /*  when the request was received  */
 } SFCommand;
 
 typedef struct
@@ -162,6 +163,9 @@ static void      server_start       (const gchar *listen_ip,
                                      gint         port,
                                      const gchar *logfile);
 static gboolean  execute_command    (SFCommand   *cmd);
+static gboolean  send_response      (SFCommand   *cmd,
+                                     gboolean     error,
+                                     GString     *response);
 static gint      read_from_client   (gint         filedes);
 static gint      make_socket        (const struct addrinfo
                                                  *ai);
@@ -184,6 +188,8 @@ static const gint   server_socks_len = sizeof (server_socks) /
                                        sizeof (server_socks[0]);
 static GList       *command_queue   = NULL;
 static gint         queue_length    = 0;
+static gint         max_queue_length = 0;
+static gint         queue_timeout   = 0;
 static gint         request_no      = 0;
 static FILE        *server_log_file = NULL;
 static GHashTable  *clients         = NULL;
@@ -513,6 +519,12 @@ server_start (const gchar *listen_ip,
   clients = g_hash_table_new_full (g_direct_hash, NULL,
                                    NULL, (GDestroyNotify) g_free);
 
+  /*  Requests which waited longer than this for their turn are refused,
+   *  the client likely gave up on them already
+   */
+  if (g_getenv ("SCRIPT_FU_SERVER_TIMEOUT"))
+    queue_timeout = MAX (atoi (g_getenv ("SCRIPT_FU_SERVER_TIMEOUT")), 0);
+
   progress = server_progress_install ();
 
   server_log ("Script-Fu server initialized and listening...\n");
@@ -524,10 +536,35 @@ server_start (const gchar *listen_ip,
 
       while (command_queue)
         {
-          SFCommand *cmd = (SFCommand *) command_queue->data;
+          SFCommand *cmd  = (SFCommand *) command_queue->data;
+          gdouble    wait = ((g_get_monotonic_time () - cmd->queued) /
+                             (gdouble) G_TIME_SPAN_SECOND);
 
           /*  Process the command  */
-          execute_command (cmd);
+          if (queue_timeout > 0 && wait > queue_timeout)
+            {
+              GString *response = g_string_new (NULL);
+
+              g_string_printf (response,
+                               "Request timed out after %.1f seconds "
+                               "in the queue", wait);
+
+              server_log ("Request #%d timed out after %f seconds "
+                          "[Request queue length: %d]\n",
+                          cmd->request_no, wait, queue_length - 1);
+
+              send_response (cmd, TRUE, response);
+
+              g_string_free (response, TRUE);
+            }
+          else
+            {
+              server_log ("Request #%d waited %f seconds "
+                          "[Request queue length: %d]\n",
+                          cmd->request_no, wait, queue_length - 1);
+
+              execute_command (cmd);
+            }
 
           /*  Remove the command from the list  */
           command_queue = g_list_remove (command_queue, cmd);
@@ -547,12 +584,10 @@ server_start (const gchar *listen_ip,
 static gboolean
 execute_command (SFCommand *cmd)
 {
-  guchar    buffer[RESPONSE_HEADER];
   GString  *response;
   time_t    clock1;
   time_t    clock2;
   gboolean  error;
-  gint      i;
 
   server_log ("Processing request #%d\n", cmd->request_no);
   time (&clock1);
@@ -579,6 +614,21 @@ execute_command (SFCommand *cmd)
                   cmd->request_no, difftime (clock2, clock1), ctime (&clock2));
     }
 
+  send_response (cmd, error, response);
+
+  g_string_free (response, TRUE);
+
+  return FALSE;
+}
+
+static gboolean
+send_response (SFCommand *cmd,
+               gboolean   error,
+               GString   *response)
+{
+  guchar buffer[RESPONSE_HEADER];
+  gint   i;
+
   buffer[MAGIC_BYTE]     = MAGIC;
   buffer[ERROR_BYTE]     = error ? TRUE : FALSE;
   buffer[RSP_LEN_H_BYTE] = (guchar) (response->len >> 8);
@@ -601,9 +651,7 @@ execute_command (SFCommand *cmd)
         return FALSE;
       }
 
-  g_string_free (response, TRUE);
-
-  return FALSE;
+  return TRUE;
 }
 
 static gint
@@ -672,11 +720,14 @@ read_from_client (gint filedes)
   cmd->filedes    = filedes;
   cmd->command    = command;
   cmd->request_no = request_no ++;
+  cmd->queued     = g_get_monotonic_time ();
 
   /*  Add the command to the queue  */
   command_queue = g_list_append (command_queue, cmd);
   queue_length ++;
 
+  max_queue_length = MAX (max_queue_length, queue_length);
+
   /*  Get the client address from the address/socket table  */
   clientaddr = g_hash_table_lookup (clients, GINT_TO_POINTER (cmd->filedes));
   time (&clock);
@@ -726,6 +777,14 @@ make_socket (const struct addrinfo *ai)
 
   setsockopt (sock, SOL_SOCKET, SO_REUSEADDR, &v, sizeof(v));
 
+#ifdef SO_REUSEPORT
+  /*  Let several servers listen on the same port, each of them is a
+   *  plug-in process with its own interpreter, and the kernel spreads
+   *  the connections among them.
+   */
+  setsockopt (sock, SOL_SOCKET, SO_REUSEPORT, &v, sizeof(v));
+#endif
+
 #ifdef IPV6_V6ONLY
   /* Only listen on IPv6 addresses, otherwise bind() will fail. */
   if (ai->ai_family == AF_INET6)
@@ -777,7 +836,8 @@ script_fu_server_shutdown_fd (gpointer key,
 static void
 server_quit (void)
 {
-  gint sockno;
+  GList *list;
+  gint   sockno;
 
   for (sockno = 0; sockno < server_socks_used; sockno++)
     {
@@ -791,9 +851,14 @@ server_quit (void)
       clients = NULL;
     }
 
-  while (command_queue)
+  if (request_no > 0)
+    server_log ("Script-Fu server served %d requests, "
+                "the longest queue was %d requests\n",
+                request_no, max_queue_length);
+
+  for (list = command_queue; list; list = g_list_next (list))
     {
-      SFCommand *cmd = command_queue->data;
+      SFCommand *cmd = list->data;
 
       g_free (cmd->command);
       g_free (cmd);
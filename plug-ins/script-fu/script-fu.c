@@ -144,7 +144,13 @@ script_fu_query (void)
                           "API was changed in an incompatible way since "
                           "GIMP 2.8.12. You now have to pass the IP to listen "
                           "on as first parameter. Calling this procedure with "
-                          "the old API will fail on purpose.",
+                          "the old API will fail on purpose. "
+                          "Several servers can be started on the same port "
+                          "where the system supports SO_REUSEPORT, "
+                          "connections are then spread among them. "
+                          "Requests which waited in the queue for longer "
+                          "than $SCRIPT_FU_SERVER_TIMEOUT seconds are "
+                          "answered with an error instead of being run.",
                           "Spencer Kimball & Peter Mattis",
                           "Spencer Kimball & Peter Mattis",
                           "1997",